@@ -9,13 +9,81 @@
 // Arguments:
 // - cchRowWidth - the length of the default text attribute
 // - attr - the default text attribute
+// - table - the attribute table shared with the other rows of the buffer.
+//           If none is given, the row gets a table of its own.
 // Return Value:
 // - constructed object
 // Note: will throw exception if unable to allocate memory for text attribute storage
-ATTR_ROW::ATTR_ROW(const UINT cchRowWidth, const TextAttribute attr)
+ATTR_ROW::ATTR_ROW(const UINT cchRowWidth,
+                   const TextAttribute attr,
+                   std::shared_ptr<TextAttributeTable> table) :
+    _cchRowWidth{ cchRowWidth },
+    _table{ table ? std::move(table) : std::make_shared<TextAttributeTable>() }
 {
-    _list.push_back(TextAttributeRun(cchRowWidth, attr));
-    _cchRowWidth = cchRowWidth;
+    _list.reserve(1);
+    _list.push_back({ cchRowWidth, _table->Acquire(attr) });
+}
+
+ATTR_ROW::ATTR_ROW(const ATTR_ROW& other) :
+    _list{ other._list },
+    _cchRowWidth{ other._cchRowWidth },
+    _table{ other._table }
+{
+    for (const auto& run : _list)
+    {
+        _table->AddRef(run.id);
+    }
+}
+
+ATTR_ROW::ATTR_ROW(ATTR_ROW&& other) noexcept :
+    _list{ std::move(other._list) },
+    _cchRowWidth{ other._cchRowWidth },
+    _table{ other._table }
+{
+    // the moved-from row no longer owns any references
+    other._list.clear();
+}
+
+ATTR_ROW& ATTR_ROW::operator=(const ATTR_ROW& other)
+{
+    if (this != &other)
+    {
+        ATTR_ROW copy{ other };
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+ATTR_ROW& ATTR_ROW::operator=(ATTR_ROW&& other) noexcept
+{
+    if (this != &other)
+    {
+        _ReleaseRuns();
+        _list = std::move(other._list);
+        other._list.clear();
+        _cchRowWidth = other._cchRowWidth;
+        _table = other._table;
+    }
+    return *this;
+}
+
+ATTR_ROW::~ATTR_ROW()
+{
+    _ReleaseRuns();
+}
+
+// Routine Description:
+// - Drops the references every run holds on its attribute
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void ATTR_ROW::_ReleaseRuns() noexcept
+{
+    for (const auto& run : _list)
+    {
+        _table->Release(run.id);
+    }
 }
 
 // Routine Description:
@@ -24,8 +92,11 @@ ATTR_ROW::ATTR_ROW(const UINT cchRowWidth, const TextAttribute attr)
 // - attr - The default text attributes to use on text in this row.
 void ATTR_ROW::Reset(const TextAttribute attr)
 {
+    _list.reserve(1);
+    const auto id = _table->Acquire(attr);
+    _ReleaseRuns();
     _list.clear();
-    _list.push_back(TextAttributeRun(_cchRowWidth, attr));
+    _list.push_back({ gsl::narrow_cast<UINT>(_cchRowWidth), id });
 }
 
 // Routine Description:
@@ -49,7 +120,7 @@ void ATTR_ROW::Resize(const size_t newWidth)
         auto& run = _list[runPos];
 
         // Extend its length by the additional columns we're adding.
-        run.SetLength(run.GetLength() + newWidth - _cchRowWidth);
+        run.length = gsl::narrow<UINT>(run.length + newWidth - _cchRowWidth);
 
         // Store that the new total width we represent is the new width.
         _cchRowWidth = newWidth;
@@ -67,12 +138,16 @@ void ATTR_ROW::Resize(const size_t newWidth)
         // then when we called FindAttrIndex, it returned the B5 as the pIndexedRun and a 2 for how many more segments it covers
         // after and including the 3rd column.
         // B5-2 = B3, which is what we desire to cover the new 3 size buffer.
-        run.SetLength(run.GetLength() - CountOfAttr + 1);
+        run.length = gsl::narrow_cast<UINT>(run.length - CountOfAttr + 1);
 
         // Store that the new total width we represent is the new width.
         _cchRowWidth = newWidth;
 
         // Erase segments after the one we just updated.
+        for (auto it = _list.cbegin() + runPos + 1; it < _list.cend(); ++it)
+        {
+            _table->Release(it->id);
+        }
         _list.erase(_list.cbegin() + runPos + 1, _list.cend());
 
         // NOTE: Under some circumstances here, we have leftover run segments in memory or blank run segments
@@ -81,6 +156,23 @@ void ATTR_ROW::Resize(const size_t newWidth)
     }
 }
 
+// Routine Description:
+// - Releases any run storage well beyond what's needed for the runs we currently hold.
+//   (e.g. left over from a row that used to have many colors)
+// - A little slack is kept so that a row with about as many colors as before doesn't
+//   reallocate its runs every time it's reused.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>, throws exceptions on failures.
+void ATTR_ROW::ShrinkToFit()
+{
+    if (_list.capacity() > _list.size() * 2)
+    {
+        _list.shrink_to_fit();
+    }
+}
+
 // Routine Description:
 // - returns a copy of the TextAttribute at the specified column
 // Arguments:
@@ -108,7 +200,7 @@ TextAttribute ATTR_ROW::GetAttrByColumn(const size_t column,
 {
     THROW_HR_IF(E_INVALIDARG, column >= _cchRowWidth);
     const auto runPos = FindAttrIndex(column, pApplies);
-    return _list[runPos].GetAttributes();
+    return _table->Get(_list[runPos].id);
 }
 
 // Routine Description:
@@ -120,6 +212,15 @@ size_t ATTR_ROW::GetNumberOfRuns() const noexcept
     return _list.size();
 }
 
+// Routine Description:
+// - gets how many bytes of heap storage are held for the runs
+// Return Value:
+// - the bytes held. a lone run is kept inline, so it holds none.
+size_t ATTR_ROW::GetMemoryUsage() const noexcept
+{
+    return _list.size() > 1 ? _list.capacity() * sizeof(Run) : 0;
+}
+
 // Routine Description:
 // - This routine finds the nth attribute in this ATTR_ROW.
 // Arguments:
@@ -137,11 +238,21 @@ size_t ATTR_ROW::FindAttrIndex(const size_t index, size_t* const pApplies) const
 
     FAIL_FAST_IF(!(_list.size() > 0)); // There should be a non-zero and positive number of items in the array.
 
+    // Most rows are a single color, and then there's nothing to scan for.
+    if (_list.size() == 1)
+    {
+        if (nullptr != pApplies)
+        {
+            *pApplies = _cchRowWidth - index;
+        }
+        return 0;
+    }
+
     // Scan through the internal array from position 0 adding up the lengths that each attribute applies to
     auto runPos = _list.cbegin();
     do
     {
-        cTotalLength += runPos->GetLength();
+        cTotalLength += runPos->length;
 
         if (cTotalLength > index)
         {
@@ -210,6 +321,36 @@ void ATTR_ROW::ReplaceLegacyAttrs(_In_ WORD wToBeReplacedAttr, _In_ WORD wReplac
     ReplaceAttrs(ToBeReplaced, ReplaceWith);
 }
 
+// Routine Description:
+// - Copies out the legacy attributes of a span of the row, one per column.
+//   Each run's attribute is converted once and filled across all of its columns.
+// Arguments:
+// - iStart - the first column to copy
+// - pAttrs - where to copy the attributes to
+// - cAttrs - how many columns to copy. They must all be within the row.
+// Return Value:
+// - <none>
+// Note:
+// - will throw on error
+void ATTR_ROW::CopyLegacyAttrs(const size_t iStart, WORD* const pAttrs, const size_t cAttrs) const
+{
+    THROW_HR_IF(E_INVALIDARG, iStart > _cchRowWidth || cAttrs > _cchRowWidth - iStart);
+
+    size_t column = 0;
+    size_t copied = 0;
+    for (auto run = _list.cbegin(); run < _list.cend() && copied < cAttrs; ++run)
+    {
+        const size_t runEnd = column + run->length;
+        if (runEnd > iStart)
+        {
+            const auto count = std::min(runEnd - std::max(column, iStart), cAttrs - copied);
+            std::fill_n(pAttrs + copied, count, _table->Get(run->id).GetLegacyAttributes());
+            copied += count;
+        }
+        column = runEnd;
+    }
+}
+
 // Method Description:
 // - Replaces all runs in the row with the given toBeReplacedAttr with the new
 //      attribute replaceWith.
@@ -218,13 +359,38 @@ void ATTR_ROW::ReplaceLegacyAttrs(_In_ WORD wToBeReplacedAttr, _In_ WORD wReplac
 // - replaceWith - the new value for the matching runs' attributes.
 // Return Value:
 // - <none>
+// Note:
+// - if the new attribute can't be added to the table, the row is left as it was.
 void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAttribute& replaceWith) noexcept
 {
+    // If no run anywhere in the buffer uses the attribute, there's nothing to replace.
+    const auto oldId = _table->Find(toBeReplacedAttr);
+    if (oldId == TextAttributeTable::InvalidId)
+    {
+        return;
+    }
+
+    auto newId = TextAttributeTable::InvalidId;
     for (auto& run : _list)
     {
-        if (run.GetAttributes() == toBeReplacedAttr)
+        if (run.id == oldId)
         {
-            run.SetAttributes(replaceWith);
+            // Only the first match can fail to get an id. The rest add references to it.
+            // Acquire before releasing so the old id can't be recycled while we're still looking for it.
+            if (newId == TextAttributeTable::InvalidId)
+            {
+                try
+                {
+                    newId = _table->Acquire(replaceWith);
+                }
+                CATCH_LOG_RETURN();
+            }
+            else
+            {
+                _table->AddRef(newId);
+            }
+            _table->Release(run.id);
+            run.id = newId;
         }
     }
 }
@@ -270,11 +436,11 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
     if (newAttrs.size() == 1)
     {
         // Get the new color attribute we're trying to apply
-        const TextAttribute NewAttr = newAttrs.at(0).GetAttributes();
+        const TextAttribute& NewAttr = newAttrs.at(0).GetAttributes();
 
         // If the existing run was only 1 element...
         // ...and the new color is the same as the old, we don't have to do anything and can exit quick.
-        if (_list.size() == 1 && _list.at(0).GetAttributes() == NewAttr)
+        if (_list.size() == 1 && _table->Get(_list.at(0).id) == NewAttr)
         {
             return S_OK;
         }
@@ -291,15 +457,16 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
         else if (_list.size() == 2 && newAttrs.at(0).GetLength() == 1)
         {
             auto left = _list.begin();
-            if (iStart == left->GetLength() && NewAttr == left->GetAttributes())
+            if (iStart == left->length && NewAttr == _table->Get(left->id))
             {
                 auto right = left + 1;
-                left->IncrementLength();
-                right->DecrementLength();
+                left->length++;
+                right->length--;
 
                 // If we just reduced the right half to zero, just erase it out of the list.
-                if (right->GetLength() == 0)
+                if (right->length == 0)
                 {
+                    _table->Release(right->id);
                     _list.erase(right);
                 }
                 return S_OK;
@@ -307,11 +474,61 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
         }
     }
 
+    // Intern the attributes we're inserting so the rest of the work can happen on ids alone.
+    // Adjacent insert runs with the same attribute are merged as we go.
+    RunList insertRun;
+    insertRun.reserve(newAttrs.size());
+    try
+    {
+        for (const auto& newAttr : newAttrs)
+        {
+            const auto id = _table->Acquire(newAttr.GetAttributes());
+            const auto length = gsl::narrow<UINT>(newAttr.GetLength());
+            if (!insertRun.empty() && insertRun.back().id == id)
+            {
+                insertRun.back().length += length;
+                _table->Release(id);
+            }
+            else
+            {
+                insertRun.push_back({ length, id });
+            }
+        }
+    }
+    catch (...)
+    {
+        for (const auto& run : insertRun)
+        {
+            _table->Release(run.id);
+        }
+        throw;
+    }
+
     // If we're about to cover the entire existing run with a new one, we can also make an optimization.
     if (iStart == 0 && iEnd == iLastBufferCol)
     {
         // Just dump what we're given over what we have and call it a day.
-        _list.assign(newAttrs.cbegin(), newAttrs.cend());
+        // Copy it over rather than swapping it in, so we keep our storage for when the row gets more colors again.
+        try
+        {
+            _list.reserve(insertRun.size());
+        }
+        catch (...)
+        {
+            for (const auto& run : insertRun)
+            {
+                _table->Release(run.id);
+            }
+            throw;
+        }
+
+        _ReleaseRuns();
+        _list.clear();
+        for (const auto& run : insertRun)
+        {
+            // This can't allocate: we just reserved room for all of them.
+            _list.push_back(run);
+        }
 
         return S_OK;
     }
@@ -323,202 +540,77 @@ void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAtt
     // becomes R3->B2->Y2->B1->G2.
     // The original run was 3 long. The insertion run was 1 long. We need 1 more for the
     // fact that an existing piece of the run was split in half (to hold the latter half).
-    const size_t cNewRun = _list.size() + newAttrs.size() + 1;
-    std::vector<TextAttributeRun> newRun;
-    newRun.resize(cNewRun);
-
-    // We will start analyzing from the beginning of our existing run.
-    // Use some pointers to keep track of where we are in walking through our runs.
-
-    // Get the existing run that we'll be updating/manipulating.
-    const auto existingRun = _list.begin();
-    auto pExistingRunPos = existingRun;
-    const auto pExistingRunEnd = existingRun + _list.size();
-    auto pInsertRunPos = newAttrs.begin();
-    size_t cInsertRunRemaining = newAttrs.size();
-    auto pNewRunPos = newRun.begin();
-    size_t iExistingRunCoverage = 0;
-
-    // Copy the existing run into the new buffer up to the "start index" where the new run will be injected.
-    // If the new run starts at 0, we have nothing to copy from the beginning.
-    if (iStart != 0)
-    {
-        // While we're less than the desired insertion position...
-        while (iExistingRunCoverage < iStart)
+    RunList newRun;
+    try
+    {
+        newRun.reserve(_list.size() + insertRun.size() + 1);
+    }
+    catch (...)
+    {
+        for (const auto& run : insertRun)
         {
-            // Add up how much length we can cover by copying an item from the existing run.
-            iExistingRunCoverage += pExistingRunPos->GetLength();
-
-            // Copy it to the new run buffer and advance both pointers.
-            *pNewRunPos++ = *pExistingRunPos++;
+            _table->Release(run.id);
         }
+        throw;
+    }
 
-        // When we get to this point, we've copied full segments from the original existing run
-        // into our new run buffer. We will have 1 or more full segments of color attributes and
-        // we MIGHT have to cut the last copied segment's length back depending on where the inserted
-        // attributes will fall in the final/new run.
-        // Some examples:
-        // - Starting with the original string R3 -> G5 -> B2
-        // - 1. If the insertion is Y5 at start index 3
-        //      We are trying to get a result/final/new run of R3 -> Y5 -> B2.
-        //      We just copied R3 to the new destination buffer and we cang skip down and start inserting the new attrs.
-        // - 2. If the insertion is Y3 at start index 5
-        //      We are trying to get a result/final/new run of R3 -> G2 -> Y3 -> B2.
-        //      We just copied R3 -> G5 to the new destination buffer with the code above.
-        //      But the insertion is going to cut out some of the length of the G5.
-        //      We need to fix this up below so it says G2 instead to leave room for the Y3 to fit in
-        //      the new/final run.
-
-        // Copying above advanced the pointer to an empty cell beyond what we copied.
-        // Back up one cell so we can manipulate the final item we copied from the existing run to the new run.
-        pNewRunPos--;
-
-        // Fetch out the length so we can fix it up based on the below conditions.
-        size_t length = pNewRunPos->GetLength();
-
-        // If we've covered more cells already than the start of the attributes to be inserted...
-        if (iExistingRunCoverage > iStart)
+    // Appends a piece of a run to the new run, merging it into the previous piece if the ids match.
+    // Every run pushed into the new run takes its own reference on its id.
+    // This can't allocate: the new run has been reserved for the worst case above.
+    const auto append = [&](const TextAttributeTable::id_type id, const size_t length) noexcept {
+        if (!newRun.empty() && newRun.back().id == id)
         {
-            // ..then subtract some of the length of the final cell we copied.
-            // We want to take remove the difference in distance between the cells we've covered in the new
-            // run and the insertion point.
-            // (This turns G5 into G2 from Example 2 just above)
-            length -= (iExistingRunCoverage - iStart);
+            newRun.back().length += gsl::narrow_cast<UINT>(length);
         }
-
-        // Now we're still on that "last cell copied" into the new run.
-        // If the color of that existing copied cell matches the color of the first segment
-        // of the run we're about to insert, we can just increment the length to extend the coverage.
-        if (pNewRunPos->GetAttributes() == pInsertRunPos->GetAttributes())
+        else
         {
-            length += pInsertRunPos->GetLength();
-
-            // Since the color matched, we have already "used up" part of the insert run
-            // and can skip it in our big "memcopy" step below that will copy the bulk of the insert run.
-            cInsertRunRemaining--;
-            pInsertRunPos++;
+            newRun.push_back({ gsl::narrow_cast<UINT>(length), id });
+            _table->AddRef(id);
         }
-
-        // We're done manipulating the length. Store it back.
-        pNewRunPos->SetLength(length);
-
-        // Now that we're done adjusting the last copied item, advance the pointer into a fresh/blank
-        // part of the new run array.
-        pNewRunPos++;
-    }
-
-    // Bulk copy the majority (or all, depending on circumstance) of the insert run into the final run buffer.
-    std::copy_n(pInsertRunPos, cInsertRunRemaining, pNewRunPos);
-
-    // Advance the new run pointer into the position just after everything we copied.
-    pNewRunPos += cInsertRunRemaining;
-
-    // We're technically done with the insert run now and have 0 remaining, but won't bother updating its pointers
-    // and counts any further because we won't use them.
-
-    // Now we need to move our pointer for the original existing run forward and update our counts
-    // on how many cells we could have copied from the source before finishing off the new run.
-    while (iExistingRunCoverage <= iEnd)
+    };
+
+    // Walk through the existing run and copy everything that falls before iStart and after iEnd,
+    // dropping the insert run in right where the existing run first reaches iStart.
+    // With the example above, R3 is copied as is, G5 is split into G2 -> Y1 -> N1 -> G1,
+    // and B2 is copied as is.
+    bool inserted = false;
+    size_t runStart = 0;
+    for (const auto& run : _list)
     {
-        FAIL_FAST_IF(!(pExistingRunPos != pExistingRunEnd));
-        iExistingRunCoverage += pExistingRunPos->GetLength();
-        pExistingRunPos++;
-    }
+        const size_t runEnd = runStart + run.length;
 
-    // If we still have original existing run cells remaining, copy them into the final new run.
-    if (pExistingRunPos != pExistingRunEnd || iExistingRunCoverage != (iEnd + 1))
-    {
-        // Back up one cell so we can inspect the most recent item copied into the new run for optimizations.
-        pNewRunPos--;
+        if (runStart < iStart)
+        {
+            append(run.id, std::min(runEnd, iStart) - runStart);
+        }
 
-        // We advanced the existing run pointer and its count to on or past the end of what the insertion run filled in.
-        // If this ended up being past the end of what the insertion run covers, we have to account for the cells after
-        // the insertion run but before the next piece of the original existing run.
-        // The example in this case is if we had...
-        // Existing Run = R3 -> G5 -> B2 -> X5
-        // Insert Run = Y2 @ iStart = 7 and iEnd = 8
-        // ... then at this point in time, our states would look like...
-        // New Run so far = R3 -> G4 -> Y2
-        // Existing Run Pointer is at X5
-        // Existing run coverage count at 3 + 5 + 2 = 10.
-        // However, in order to get the final desired New Run
-        //   (which is R3 -> G4 -> Y2 -> B1 -> X5)
-        //   we would need to grab a piece of that B2 we already skipped past.
-        // iExistingRunCoverage = 10. iEnd = 8. iEnd+1 = 9. 10 > 9. So we skipped something.
-        if (iExistingRunCoverage > (iEnd + 1))
+        if (!inserted && runEnd > iStart)
         {
-            // Back up the existing run pointer so we can grab the piece we skipped.
-            pExistingRunPos--;
-
-            // If the color matches what's already in our run, just increment the count value.
-            // This case is slightly off from the example above. This case is for if the B2 above was actually Y2.
-            // That Y2 from the existing run is the same color as the Y2 we just filled a few columns left in the final run
-            // so we can just adjust the final run's column count instead of adding another segment here.
-            if (pNewRunPos->GetAttributes() == pExistingRunPos->GetAttributes())
+            for (const auto& piece : insertRun)
             {
-                size_t length = pNewRunPos->GetLength();
-                length += (iExistingRunCoverage - (iEnd + 1));
-                pNewRunPos->SetLength(length);
-            }
-            else
-            {
-                // If the color didn't match, then we just need to copy the piece we skipped and adjust
-                // its length for the discrepency in columns not yet covered by the final/new run.
-
-                // Move forward to a blank spot in the new run
-                pNewRunPos++;
-
-                // Copy the existing run's color information to the new run
-                pNewRunPos->SetAttributes(pExistingRunPos->GetAttributes());
-
-                // Adjust the length of that copied color to cover only the reduced number of columns needed
-                // now that some have been replaced by the insert run.
-                pNewRunPos->SetLength(iExistingRunCoverage - (iEnd + 1));
+                append(piece.id, piece.length);
             }
-
-            // Now that we're done recovering a piece of the existing run we skipped, move the pointer forward again.
-            pExistingRunPos++;
+            inserted = true;
         }
 
-        // OK. In this case, we didn't skip anything. The end of the insert run fell right at a boundary
-        // in columns that was in the original existing run.
-        // However, the next piece of the original existing run might happen to have the same color attribute
-        // as the final piece of what we just copied.
-        // As an example...
-        // Existing Run = R3 -> G5 -> B2.
-        // Insert Run = B5 @ iStart = 3 and iEnd = 7
-        // New Run so far = R3 -> B5
-        // New Run desired when done = R3 -> B7
-        // Existing run pointer is on B2.
-        // We want to merge the 2 from the B2 into the B5 so we get B7.
-        else if (pNewRunPos->GetAttributes() == pExistingRunPos->GetAttributes())
+        if (runEnd > iEnd + 1)
         {
-            // Add the value from the existing run into the current new run position.
-            size_t length = pNewRunPos->GetLength();
-            length += pExistingRunPos->GetLength();
-            pNewRunPos->SetLength(length);
-
-            // Advance the existing run position since we consumed its value and merged it in.
-            pExistingRunPos++;
+            append(run.id, runEnd - std::max(runStart, iEnd + 1));
         }
 
-        // OK. We're done inspecting the most recently copied cell for optimizations.
-        pNewRunPos++;
-
-        // Now bulk copy any segments left in the original existing run
-        if (pExistingRunPos < pExistingRunEnd)
-        {
-            std::copy_n(pExistingRunPos, (pExistingRunEnd - pExistingRunPos), pNewRunPos);
-
-            // Fix up the end pointer so we know where we are for counting how much of the new run's memory space we used.
-            pNewRunPos += (pExistingRunEnd - pExistingRunPos);
-        }
+        runStart = runEnd;
     }
 
-    // OK, phew. We're done. Now we just need to free the existing run, store the new run in its place,
-    // and update the count for the correct length of the new run now that we've filled it up.
+    // if the insert run didn't land anywhere, then this ATTR_ROW wasn't filled with enough attributes for the entire row
+    FAIL_FAST_IF(!inserted);
 
-    newRun.erase(pNewRunPos, newRun.end());
+    // OK, phew. We're done. Now we just need to let go of the existing run and the insert run
+    // and store the new run in its place.
+    for (const auto& run : insertRun)
+    {
+        _table->Release(run.id);
+    }
+    _ReleaseRuns();
     _list.swap(newRun);
 
     return S_OK;
@@ -576,5 +668,231 @@ bool operator==(const ATTR_ROW& a, const ATTR_ROW& b) noexcept
 {
     return (a._list.size() == b._list.size() &&
             a._list.data() == b._list.data() &&
+            a._table == b._table &&
             a._cchRowWidth == b._cchRowWidth);
 }
+
+ATTR_ROW::RunList::RunList() noexcept :
+    _inline{ 0, TextAttributeTable::InvalidId },
+    _spill{},
+    _size{ 0 }
+{
+}
+
+ATTR_ROW::RunList::RunList(const RunList& other) :
+    _inline{ other._inline },
+    _spill{ other._spill },
+    _size{ other._size }
+{
+}
+
+ATTR_ROW::RunList::RunList(RunList&& other) noexcept :
+    _inline{ other._inline },
+    _spill{ std::move(other._spill) },
+    _size{ other._size }
+{
+    other.clear();
+}
+
+ATTR_ROW::RunList& ATTR_ROW::RunList::operator=(const RunList& other)
+{
+    if (this != &other)
+    {
+        RunList copy{ other };
+        swap(copy);
+    }
+    return *this;
+}
+
+ATTR_ROW::RunList& ATTR_ROW::RunList::operator=(RunList&& other) noexcept
+{
+    if (this != &other)
+    {
+        _inline = other._inline;
+        _spill = std::move(other._spill);
+        _size = other._size;
+        other.clear();
+    }
+    return *this;
+}
+
+size_t ATTR_ROW::RunList::size() const noexcept
+{
+    return _size;
+}
+
+bool ATTR_ROW::RunList::empty() const noexcept
+{
+    return _size == 0;
+}
+
+// Routine Description:
+// - reports how many runs can be held without allocating. one always fits inline.
+size_t ATTR_ROW::RunList::capacity() const noexcept
+{
+    return std::max<size_t>(1, _spill.capacity());
+}
+
+ATTR_ROW::Run* ATTR_ROW::RunList::begin() noexcept
+{
+    return _size <= 1 ? &_inline : _spill.data();
+}
+
+ATTR_ROW::Run* ATTR_ROW::RunList::end() noexcept
+{
+    return begin() + _size;
+}
+
+const ATTR_ROW::Run* ATTR_ROW::RunList::begin() const noexcept
+{
+    return _size <= 1 ? &_inline : _spill.data();
+}
+
+const ATTR_ROW::Run* ATTR_ROW::RunList::end() const noexcept
+{
+    return begin() + _size;
+}
+
+const ATTR_ROW::Run* ATTR_ROW::RunList::cbegin() const noexcept
+{
+    return begin();
+}
+
+const ATTR_ROW::Run* ATTR_ROW::RunList::cend() const noexcept
+{
+    return end();
+}
+
+const ATTR_ROW::Run* ATTR_ROW::RunList::data() const noexcept
+{
+    return begin();
+}
+
+ATTR_ROW::Run& ATTR_ROW::RunList::operator[](const size_t index) noexcept
+{
+    return begin()[index];
+}
+
+const ATTR_ROW::Run& ATTR_ROW::RunList::operator[](const size_t index) const noexcept
+{
+    return begin()[index];
+}
+
+// Note: will throw exception if index is out of bounds
+const ATTR_ROW::Run& ATTR_ROW::RunList::at(const size_t index) const
+{
+    THROW_HR_IF(E_INVALIDARG, index >= _size);
+    return begin()[index];
+}
+
+ATTR_ROW::Run& ATTR_ROW::RunList::back() noexcept
+{
+    return begin()[_size - 1];
+}
+
+// Routine Description:
+// - makes room for the given number of runs, so that adding that many won't allocate
+// Note: will throw exception if unable to allocate memory
+void ATTR_ROW::RunList::reserve(const size_t capacity)
+{
+    if (capacity > 1)
+    {
+        _spill.reserve(capacity);
+    }
+}
+
+// Routine Description:
+// - lets go of heap storage beyond what the runs need. a single run needs none.
+// Note: will throw exception if unable to allocate memory
+void ATTR_ROW::RunList::shrink_to_fit()
+{
+    if (_size <= 1)
+    {
+        std::vector<Run>().swap(_spill);
+    }
+    else
+    {
+        _spill.shrink_to_fit();
+    }
+}
+
+// Routine Description:
+// - adds a run to the end of the list. the first run to join a lone run moves both of them to the heap.
+// Arguments:
+// - run - the run to add
+// Note: will throw exception if unable to allocate memory. the list is left as it was.
+void ATTR_ROW::RunList::push_back(const Run run)
+{
+    if (_size == 0)
+    {
+        _inline = run;
+    }
+    else if (_size == 1)
+    {
+        _spill.reserve(2);
+        _spill.push_back(_inline);
+        _spill.push_back(run);
+    }
+    else
+    {
+        _spill.push_back(run);
+    }
+    ++_size;
+}
+
+// Routine Description:
+// - removes the runs [first, last). if only one run is left, it moves back inline.
+//   the heap storage is kept for when the row gets more colors again.
+// Arguments:
+// - first - the first run to remove
+// - last - one past the last run to remove
+void ATTR_ROW::RunList::erase(const Run* const first, const Run* const last) noexcept
+{
+    const auto firstIndex = gsl::narrow_cast<size_t>(first - begin());
+    const auto lastIndex = gsl::narrow_cast<size_t>(last - begin());
+    if (firstIndex >= lastIndex)
+    {
+        return;
+    }
+
+    if (_size <= 1)
+    {
+        _size = 0;
+        return;
+    }
+
+    _spill.erase(_spill.cbegin() + firstIndex, _spill.cbegin() + lastIndex);
+    _size = _spill.size();
+    if (_size <= 1)
+    {
+        if (_size == 1)
+        {
+            _inline = _spill.front();
+        }
+        _spill.clear();
+    }
+}
+
+// Routine Description:
+// - removes the given run. if only one run is left, it moves back inline.
+// Arguments:
+// - position - the run to remove
+void ATTR_ROW::RunList::erase(const Run* const position) noexcept
+{
+    erase(position, position + 1);
+}
+
+// Routine Description:
+// - removes every run. the heap storage is kept for reuse.
+void ATTR_ROW::RunList::clear() noexcept
+{
+    _spill.clear();
+    _size = 0;
+}
+
+void ATTR_ROW::RunList::swap(RunList& other) noexcept
+{
+    std::swap(_inline, other._inline);
+    _spill.swap(other._spill);
+    std::swap(_size, other._size);
+}
@@ -21,6 +21,7 @@ Revision History:
 #pragma once
 
 #include "TextAttributeRun.hpp"
+#include "TextAttributeTable.hpp"
 #include "AttrRowIterator.hpp"
 
 class ATTR_ROW final
@@ -28,7 +29,15 @@ class ATTR_ROW final
 public:
     using const_iterator = typename AttrRowIterator;
 
-    ATTR_ROW(const UINT cchRowWidth, const TextAttribute attr);
+    ATTR_ROW(const UINT cchRowWidth,
+             const TextAttribute attr,
+             std::shared_ptr<TextAttributeTable> table = nullptr);
+
+    ATTR_ROW(const ATTR_ROW& other);
+    ATTR_ROW(ATTR_ROW&& other) noexcept;
+    ATTR_ROW& operator=(const ATTR_ROW& other);
+    ATTR_ROW& operator=(ATTR_ROW&& other) noexcept;
+    ~ATTR_ROW();
 
     void Reset(const TextAttribute attr);
 
@@ -37,15 +46,18 @@ public:
                                   size_t* const pApplies) const;
 
     size_t GetNumberOfRuns() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
 
     size_t FindAttrIndex(const size_t index,
                          size_t* const pApplies) const;
 
     bool SetAttrToEnd(const UINT iStart, const TextAttribute attr);
     void ReplaceLegacyAttrs(const WORD wToBeReplacedAttr, const WORD wReplaceWith) noexcept;
+    void CopyLegacyAttrs(const size_t iStart, WORD* const pAttrs, const size_t cAttrs) const;
     void ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAttribute& replaceWith) noexcept;
 
     void Resize(const size_t newWidth);
+    void ShrinkToFit();
 
     [[nodiscard]] HRESULT InsertAttrRuns(const std::basic_string_view<TextAttributeRun> newAttrs,
                                          const size_t iStart,
@@ -64,8 +76,63 @@ public:
     friend class AttrRowIterator;
 
 private:
-    std::vector<TextAttributeRun> _list;
+    // Runs are stored with the id of their attribute in _table rather than the attribute itself.
+    // Each run holds one reference on its id.
+    struct Run
+    {
+        UINT length;
+        TextAttributeTable::id_type id;
+    };
+
+    // Most rows are a single color from end to end, so a lone run is kept inline
+    // and the runs only move out to the heap once a row has two or more of them.
+    class RunList final
+    {
+    public:
+        RunList() noexcept;
+        RunList(const RunList& other);
+        RunList(RunList&& other) noexcept;
+        RunList& operator=(const RunList& other);
+        RunList& operator=(RunList&& other) noexcept;
+        ~RunList() = default;
+
+        size_t size() const noexcept;
+        bool empty() const noexcept;
+        size_t capacity() const noexcept;
+
+        Run* begin() noexcept;
+        Run* end() noexcept;
+        const Run* begin() const noexcept;
+        const Run* end() const noexcept;
+        const Run* cbegin() const noexcept;
+        const Run* cend() const noexcept;
+        const Run* data() const noexcept;
+
+        Run& operator[](const size_t index) noexcept;
+        const Run& operator[](const size_t index) const noexcept;
+        const Run& at(const size_t index) const;
+        Run& back() noexcept;
+
+        void reserve(const size_t capacity);
+        void shrink_to_fit();
+        void push_back(const Run run);
+        void erase(const Run* const first, const Run* const last) noexcept;
+        void erase(const Run* const position) noexcept;
+        void clear() noexcept;
+        void swap(RunList& other) noexcept;
+
+    private:
+        // holds the run while there's at most one. once there are more, they all live in _spill.
+        Run _inline;
+        std::vector<Run> _spill;
+        size_t _size;
+    };
+
+    RunList _list;
     size_t _cchRowWidth;
+    std::shared_ptr<TextAttributeTable> _table;
+
+    void _ReleaseRuns() noexcept;
 
 #ifdef UNIT_TESTING
     friend class AttrRowTests;
@@ -15,20 +15,20 @@ AttrRowIterator AttrRowIterator::CreateEndIterator(const ATTR_ROW* const attrRow
 
 AttrRowIterator::AttrRowIterator(const ATTR_ROW* const attrRow) :
     _pAttrRow{ attrRow },
-    _run{ attrRow->_list.cbegin() },
+    _runIndex{ 0 },
     _currentAttributeIndex{ 0 }
 {
 }
 
 AttrRowIterator::operator bool() const noexcept
 {
-    return _run < _pAttrRow->_list.cend();
+    return _runIndex < _pAttrRow->_list.size();
 }
 
 bool AttrRowIterator::operator==(const AttrRowIterator& it) const
 {
     return (_pAttrRow == it._pAttrRow &&
-            _run == it._run &&
+            _runIndex == it._runIndex &&
             _currentAttributeIndex == it._currentAttributeIndex);
 }
 
@@ -82,14 +82,9 @@ AttrRowIterator AttrRowIterator::operator--(int)
     return copy;
 }
 
-const TextAttribute* AttrRowIterator::operator->() const
+TextAttribute AttrRowIterator::operator*() const
 {
-    return &_run->GetAttributes();
-}
-
-const TextAttribute& AttrRowIterator::operator*() const
-{
-    return _run->GetAttributes();
+    return _pAttrRow->_table->Get(_pAttrRow->_list[_runIndex].id);
 }
 
 // Routine Description:
@@ -98,9 +93,20 @@ const TextAttribute& AttrRowIterator::operator*() const
 // - count - the amount to increment by
 void AttrRowIterator::_increment(size_t count)
 {
+    // A row of one color has nothing to walk across.
+    if (_pAttrRow->_list.size() == 1 && _runIndex == 0)
+    {
+        _currentAttributeIndex += count;
+        if (_currentAttributeIndex >= _runLength())
+        {
+            _setToEnd();
+        }
+        return;
+    }
+
     while (count > 0)
     {
-        const size_t runLength = _run->GetLength();
+        const size_t runLength = _runLength();
         if (count + _currentAttributeIndex < runLength)
         {
             _currentAttributeIndex += count;
@@ -109,7 +115,7 @@ void AttrRowIterator::_increment(size_t count)
         else
         {
             count -= runLength - _currentAttributeIndex;
-            ++_run;
+            ++_runIndex;
             _currentAttributeIndex = 0;
         }
     }
@@ -131,8 +137,8 @@ void AttrRowIterator::_decrement(size_t count)
         else
         {
             count -= _currentAttributeIndex;
-            --_run;
-            _currentAttributeIndex = _run->GetLength() - 1;
+            --_runIndex;
+            _currentAttributeIndex = _runLength() - 1;
         }
     }
 }
@@ -141,6 +147,15 @@ void AttrRowIterator::_decrement(size_t count)
 // - sets fields on the iterator to describe the end() state of the ATTR_ROW
 void AttrRowIterator::_setToEnd()
 {
-    _run = _pAttrRow->_list.cend();
+    _runIndex = _pAttrRow->_list.size();
     _currentAttributeIndex = 0;
 }
+
+// Routine Description:
+// - gets the length of the run the iterator is currently in
+// Return Value:
+// - the number of cells the current run covers
+size_t AttrRowIterator::_runLength() const
+{
+    return _pAttrRow->_list[_runIndex].length;
+}
@@ -26,8 +26,10 @@ public:
     using iterator_category = std::bidirectional_iterator_tag;
     using value_type = TextAttribute;
     using difference_type = std::ptrdiff_t;
-    using pointer = TextAttribute*;
-    using reference = TextAttribute&;
+    using pointer = void;
+    // Attributes are handed out by value. The table entry a run refers to can be
+    // recycled for another attribute once the run lets go of it.
+    using reference = TextAttribute;
 
     static AttrRowIterator CreateEndIterator(const ATTR_ROW* const attrRow);
 
@@ -47,14 +49,15 @@ public:
     AttrRowIterator& operator--();
     AttrRowIterator operator--(int);
 
-    const TextAttribute* operator->() const;
-    const TextAttribute& operator*() const;
+    TextAttribute operator*() const;
 
 private:
-    std::vector<TextAttributeRun>::const_iterator _run;
     const ATTR_ROW* _pAttrRow;
+    size_t _runIndex; // index of the current run within the ATTR_ROW
     size_t _currentAttributeIndex; // index of TextAttribute within the current TextAttributeRun
 
+    size_t _runLength() const;
+
     void _increment(size_t count);
     void _decrement(size_t count);
     void _setToEnd();
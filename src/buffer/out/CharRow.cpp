@@ -6,6 +6,7 @@
 #include "CharRow.hpp"
 #include "unicode.hpp"
 #include "Row.hpp"
+#include "CompactCharRow.hpp"
 
 // Routine Description:
 // - constructor
@@ -19,10 +20,53 @@ CharRow::CharRow(size_t rowWidth, ROW* const pParent) :
     _wrapForced{ false },
     _doubleBytePadded{ false },
     _data(rowWidth, value_type()),
+    _measuredRight{ 0 },
     _pParent{ FAIL_FAST_IF_NULL(pParent) }
 {
 }
 
+CharRow::CharRow(const CharRow& other) :
+    _wrapForced{ other._wrapForced },
+    _doubleBytePadded{ other._doubleBytePadded },
+    _data{ other._data },
+    _measuredRight{ other._measuredRight.load(std::memory_order_relaxed) },
+    _wordBoundaries{ std::atomic_load(&other._wordBoundaries) },
+    _pParent{ other._pParent }
+{
+}
+
+CharRow::CharRow(CharRow&& other) noexcept :
+    _wrapForced{ other._wrapForced },
+    _doubleBytePadded{ other._doubleBytePadded },
+    _data{ std::move(other._data) },
+    _measuredRight{ other._measuredRight.load(std::memory_order_relaxed) },
+    _wordBoundaries{ std::atomic_load(&other._wordBoundaries) },
+    _pParent{ other._pParent }
+{
+}
+
+CharRow& CharRow::operator=(const CharRow& other)
+{
+    _data = other._data;
+    _wrapForced = other._wrapForced;
+    _doubleBytePadded = other._doubleBytePadded;
+    _measuredRight.store(other._measuredRight.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    std::atomic_store(&_wordBoundaries, std::atomic_load(&other._wordBoundaries));
+    _pParent = other._pParent;
+    return *this;
+}
+
+CharRow& CharRow::operator=(CharRow&& other) noexcept
+{
+    _data = std::move(other._data);
+    _wrapForced = other._wrapForced;
+    _doubleBytePadded = other._doubleBytePadded;
+    _measuredRight.store(other._measuredRight.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    std::atomic_store(&_wordBoundaries, std::atomic_load(&other._wordBoundaries));
+    _pParent = other._pParent;
+    return *this;
+}
+
 // Routine Description:
 // - Sets the wrap status for the current row
 // Arguments:
@@ -75,7 +119,26 @@ bool CharRow::WasDoubleBytePadded() const noexcept
 // - the size of the row
 size_t CharRow::size() const noexcept
 {
-    return _data.size();
+    const auto compacted = _GetCompacted();
+    return compacted ? compacted->size() : _data.size();
+}
+
+// Routine Description:
+// - gets how many bytes of heap storage are held for the cells
+// Arguments:
+// - <none>
+// Return Value:
+// - the bytes held
+size_t CharRow::GetMemoryUsage() const noexcept
+{
+    size_t usage = _data.capacity() * sizeof(value_type);
+    if (const auto wordBoundaries = std::atomic_load(&_wordBoundaries))
+    {
+        usage += sizeof(WordBoundaries) +
+                 wordBoundaries->delimiters.capacity() * sizeof(wchar_t) +
+                 wordBoundaries->bits.capacity() * sizeof(uint64_t);
+    }
+    return usage;
 }
 
 // Routine Description:
@@ -93,6 +156,8 @@ void CharRow::Reset()
 
     _wrapForced = false;
     _doubleBytePadded = false;
+    _measuredRight.store(0, std::memory_order_relaxed);
+    std::atomic_store(&_wordBoundaries, std::shared_ptr<const WordBoundaries>{});
 }
 
 // Routine Description:
@@ -110,11 +175,14 @@ void CharRow::Reset()
     }
     CATCH_RETURN();
 
+    _InvalidateMeasure();
+
     return S_OK;
 }
 
 typename CharRow::iterator CharRow::begin() noexcept
 {
+    _InvalidateMeasure();
     return _data.begin();
 }
 
@@ -125,6 +193,7 @@ typename CharRow::const_iterator CharRow::cbegin() const noexcept
 
 typename CharRow::iterator CharRow::end() noexcept
 {
+    _InvalidateMeasure();
     return _data.end();
 }
 
@@ -141,6 +210,11 @@ typename CharRow::const_iterator CharRow::cend() const noexcept
 // - The calculated left boundary of the internal string.
 size_t CharRow::MeasureLeft() const
 {
+    if (const auto compacted = _GetCompacted())
+    {
+        return compacted->MeasureLeft();
+    }
+
     std::vector<value_type>::const_iterator it = _data.cbegin();
     while (it != _data.cend() && it->IsSpace())
     {
@@ -157,16 +231,29 @@ size_t CharRow::MeasureLeft() const
 // - The calculated right boundary of the internal string.
 size_t CharRow::MeasureRight() const noexcept
 {
-    std::vector<value_type>::const_reverse_iterator it = _data.crbegin();
-    while (it != _data.crend() && it->IsSpace())
+    // Rows are usually measured many times (on resize, selection and when searching for the end of the text)
+    // for every time they're written to, so remember the answer until the cells are touched again.
+    if (const auto compacted = _GetCompacted())
     {
-        ++it;
+        return compacted->MeasureRight();
     }
-    return _data.crend() - it;
+    auto measured = _measuredRight.load(std::memory_order_relaxed);
+    if (measured == NotMeasured)
+    {
+        std::vector<value_type>::const_reverse_iterator it = _data.crbegin();
+        while (it != _data.crend() && it->IsSpace())
+        {
+            ++it;
+        }
+        measured = _data.crend() - it;
+        _measuredRight.store(measured, std::memory_order_relaxed);
+    }
+    return measured;
 }
 
 void CharRow::ClearCell(const size_t column)
 {
+    _InvalidateMeasure();
     _data.at(column).Reset();
 }
 
@@ -178,14 +265,8 @@ void CharRow::ClearCell(const size_t column)
 // - True if there is valid text in this row. False otherwise.
 bool CharRow::ContainsText() const noexcept
 {
-    for (const value_type& cell : _data)
-    {
-        if (!cell.IsSpace())
-        {
-            return true;
-        }
-    }
-    return false;
+    // Any cell that isn't a space puts the right boundary past it.
+    return MeasureRight() != 0;
 }
 
 // Routine Description:
@@ -197,7 +278,8 @@ bool CharRow::ContainsText() const noexcept
 // Note: will throw exception if column is out of bounds
 const DbcsAttribute& CharRow::DbcsAttrAt(const size_t column) const
 {
-    return _data.at(column).DbcsAttr();
+    THROW_HR_IF(E_INVALIDARG, column >= size());
+    return _DbcsAttrAt(column);
 }
 
 // Routine Description:
@@ -209,7 +291,8 @@ const DbcsAttribute& CharRow::DbcsAttrAt(const size_t column) const
 // Note: will throw exception if column is out of bounds
 DbcsAttribute& CharRow::DbcsAttrAt(const size_t column)
 {
-    return const_cast<DbcsAttribute&>(static_cast<const CharRow* const>(this)->DbcsAttrAt(column));
+    _InvalidateMeasure();
+    return _data.at(column).DbcsAttr();
 }
 
 // Routine Description:
@@ -221,9 +304,72 @@ DbcsAttribute& CharRow::DbcsAttrAt(const size_t column)
 // Note: will throw exception if column is out of bounds
 void CharRow::ClearGlyph(const size_t column)
 {
+    _InvalidateMeasure();
     _data.at(column).EraseChars();
 }
 
+// Routine Description:
+// - stores a run of single cell characters, one per column, starting at column.
+// - this is the same as assigning each character to GlyphAt with a single width
+//   DbcsAttribute, without building a reference for every cell.
+// Arguments:
+// - column - column index to start writing at
+// - chars - characters to write. each one must fill exactly one cell on its own.
+// Return Value:
+// - <none>
+// Note: will throw exception if the run doesn't fit in the row
+void CharRow::WriteNarrowChars(const size_t column, const std::wstring_view chars)
+{
+    THROW_HR_IF(E_INVALIDARG, column > _data.size() || chars.size() > _data.size() - column);
+    _InvalidateMeasure();
+    std::transform(chars.cbegin(), chars.cend(), _data.begin() + column, [](const wchar_t wch) {
+        return CharRowCell{ wch, DbcsAttribute{} };
+    });
+}
+
+// Routine Description:
+// - stores the same single cell character in count columns, starting at column.
+// Arguments:
+// - column - column index to start writing at
+// - count - number of columns to fill
+// - wch - character to fill with. it must fill exactly one cell on its own.
+// Return Value:
+// - <none>
+// Note: will throw exception if the run doesn't fit in the row
+void CharRow::FillNarrowChars(const size_t column, const size_t count, const wchar_t wch)
+{
+    THROW_HR_IF(E_INVALIDARG, column > _data.size() || count > _data.size() - column);
+    _InvalidateMeasure();
+    std::fill_n(_data.begin() + column, count, CharRowCell{ wch, DbcsAttribute{} });
+}
+
+// Routine Description:
+// - copies count cells of another char row, starting at sourceColumn, into this one starting at column.
+// - the source may be compacted. glyphs that don't fit in a cell are stored again under this row's key.
+// Arguments:
+// - source - char row to copy the cells of. it must not be this one.
+// - sourceColumn - first column of source to copy
+// - count - number of cells to copy
+// - column - column index to start writing at
+// Return Value:
+// - <none>
+// Note: will throw exception if the cells don't fit in either row or if out of memory
+void CharRow::CopyCells(const CharRow& source, const size_t sourceColumn, const size_t count, const size_t column)
+{
+    THROW_HR_IF(E_INVALIDARG, sourceColumn > source.size() || count > source.size() - sourceColumn);
+    THROW_HR_IF(E_INVALIDARG, column > _data.size() || count > _data.size() - column);
+    _InvalidateMeasure();
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto& cell = _data[column + i];
+        cell = CharRowCell{ source._CharAt(sourceColumn + i), source._DbcsAttrAt(sourceColumn + i) };
+        if (cell.DbcsAttr().IsGlyphStored())
+        {
+            GlyphAt(column + i) = static_cast<std::wstring_view>(source.GlyphAt(sourceColumn + i));
+        }
+    }
+}
+
 // Routine Description:
 // - returns text data at column as a const reference.
 // Arguments:
@@ -233,7 +379,7 @@ void CharRow::ClearGlyph(const size_t column)
 // - Note: will throw exception if column is out of bounds
 const CharRow::reference CharRow::GlyphAt(const size_t column) const
 {
-    THROW_HR_IF(E_INVALIDARG, column >= _data.size());
+    THROW_HR_IF(E_INVALIDARG, column >= size());
     return { const_cast<CharRow&>(*this), column };
 }
 
@@ -247,6 +393,7 @@ const CharRow::reference CharRow::GlyphAt(const size_t column) const
 CharRow::reference CharRow::GlyphAt(const size_t column)
 {
     THROW_HR_IF(E_INVALIDARG, column >= _data.size());
+    _InvalidateMeasure();
     return { *this, column };
 }
 
@@ -260,9 +407,10 @@ CharRow::reference CharRow::GlyphAt(const size_t column)
 // - Note: will throw exception if out of memory
 std::wstring CharRow::GetTextRaw() const
 {
+    const auto width = size();
     std::wstring wstr;
-    wstr.reserve(_data.size());
-    for (size_t i = 0; i < _data.size(); ++i)
+    wstr.reserve(width);
+    for (size_t i = 0; i < width; ++i)
     {
         auto glyph = GlyphAt(i);
         for (auto it = glyph.begin(); it != glyph.end(); ++it)
@@ -273,23 +421,254 @@ std::wstring CharRow::GetTextRaw() const
     return wstr;
 }
 
+// Routine Description:
+// - returns a copy of the text of the row as it would be shown on the screen.
+// - callers that only need to look at the text should walk Glyphs instead.
+// Return Value:
+// - text of the row
+// - Note: will throw exception if out of memory
 std::wstring CharRow::GetText() const
 {
     std::wstring wstr;
-    wstr.reserve(_data.size());
+    wstr.reserve(size());
 
-    for (size_t i = 0; i < _data.size(); ++i)
+    for (const auto glyph : Glyphs())
     {
-        auto glyph = GlyphAt(i);
-        if (!DbcsAttrAt(i).IsTrailing())
+        wstr.append(glyph);
+    }
+    return wstr;
+}
+
+// Routine Description:
+// - gets the glyphs of the row as they would be shown on the screen, without copying them.
+// Return Value:
+// - a range over the glyphs. it's only valid until the row is written to.
+CharRow::GlyphRange CharRow::Glyphs() const noexcept
+{
+    return GlyphRange{ *this };
+}
+
+CharRow::GlyphIterator::GlyphIterator(const CharRow& row, const size_t column) noexcept :
+    _row{ &row },
+    _column{ column }
+{
+    _SkipTrailing();
+}
+
+// Routine Description:
+// - gets the glyph the iterator is at. glyphs that don't fit in a cell are looked up in the
+//   row's UnicodeStorage only now, so walking past them costs nothing.
+// Return Value:
+// - view of the glyph's text
+std::wstring_view CharRow::GlyphIterator::operator*() const
+{
+    THROW_HR_IF(E_INVALIDARG, _column >= _row->size());
+    if (_row->_DbcsAttrAt(_column).IsGlyphStored())
+    {
+        return _row->GetUnicodeStorage().GetText(_row->GetStorageKey(_column));
+    }
+    return { &_row->_CharAt(_column), 1 };
+}
+
+CharRow::GlyphIterator& CharRow::GlyphIterator::operator++() noexcept
+{
+    ++_column;
+    _SkipTrailing();
+    return *this;
+}
+
+bool CharRow::GlyphIterator::operator==(const GlyphIterator& other) const noexcept
+{
+    return _row == other._row && _column == other._column;
+}
+
+bool CharRow::GlyphIterator::operator!=(const GlyphIterator& other) const noexcept
+{
+    return !(*this == other);
+}
+
+// Routine Description:
+// - moves the iterator past the trailing halves of wide glyphs, which were already
+//   shown with their leading half.
+void CharRow::GlyphIterator::_SkipTrailing() noexcept
+{
+    const auto width = _row->size();
+    while (_column < width && _row->_DbcsAttrAt(_column).IsTrailing())
+    {
+        ++_column;
+    }
+}
+
+CharRow::GlyphRange::GlyphRange(const CharRow& row) noexcept :
+    _row{ row }
+{
+}
+
+CharRow::GlyphIterator CharRow::GlyphRange::begin() const noexcept
+{
+    return { _row, 0 };
+}
+
+CharRow::GlyphIterator CharRow::GlyphRange::end() const noexcept
+{
+    return { _row, _row.size() };
+}
+
+// Routine Description:
+// - counts the characters that the glyphs add up to, e.g. to size a buffer to copy them into.
+// Return Value:
+// - the length the row's text would have
+size_t CharRow::GlyphRange::TextLength() const
+{
+    size_t length = 0;
+    for (const auto glyph : *this)
+    {
+        length += glyph.size();
+    }
+    return length;
+}
+
+// Routine Description:
+// - finds the run of word (or delimiter) cells that column is in.
+// - a cell is a delimiter if it holds a single character that's in delimiters.
+// - the run is found in the row's bitmap of delimiter cells, a whole word of bits at a time,
+//   so moving from word to word along a row doesn't look at the glyphs again each time.
+// Arguments:
+// - column - column to find the run of
+// - delimiters - the characters that separate words
+// Return Value:
+// - the run that column is in
+// - Note: will throw exception if column is out of bounds
+CharRow::WordRun CharRow::GetWordRunAt(const size_t column, const std::wstring_view delimiters) const
+{
+    const auto width = size();
+    THROW_HR_IF(E_INVALIDARG, column >= width);
+
+    const auto boundaries = _GetWordBoundaries(delimiters);
+    const bool delimiter = boundaries->IsDelimiter(column);
+    // a word of bits that's all the same as column's cell, which the run can skip in one step
+    const uint64_t same = delimiter ? ~uint64_t{ 0 } : uint64_t{ 0 };
+
+    size_t begin = column;
+    while (begin > 0)
+    {
+        if (begin % 64 == 0 && boundaries->bits[begin / 64 - 1] == same)
         {
-            for (auto it = glyph.begin(); it != glyph.end(); ++it)
-            {
-                wstr.push_back(*it);
-            }
+            begin -= 64;
+        }
+        else if (boundaries->IsDelimiter(begin - 1) == delimiter)
+        {
+            --begin;
+        }
+        else
+        {
+            break;
         }
     }
-    return wstr;
+
+    size_t end = column + 1;
+    while (end < width)
+    {
+        if (end % 64 == 0 && end + 64 <= width && boundaries->bits[end / 64] == same)
+        {
+            end += 64;
+        }
+        else if (boundaries->IsDelimiter(end) == delimiter)
+        {
+            ++end;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return { begin, end, delimiter };
+}
+
+// Routine Description:
+// - tells whether the given cell is a word delimiter
+// Arguments:
+// - column - the cell to look at. it must be inside the row the bitmap was built for.
+// Return Value:
+// - true if it's a delimiter
+bool CharRow::WordBoundaries::IsDelimiter(const size_t column) const noexcept
+{
+    return (bits[column / 64] >> (column % 64)) & 1;
+}
+
+// Routine Description:
+// - gets the bitmap of delimiter cells for the given delimiters, building it if the cells
+//   changed since it was last built or it was built for other delimiters
+// Arguments:
+// - delimiters - the characters that separate words
+// Return Value:
+// - the bitmap. it's never changed once built, so it can be read for as long as it's held.
+// Note: will throw exception if unable to allocate the bitmap
+std::shared_ptr<const CharRow::WordBoundaries> CharRow::_GetWordBoundaries(const std::wstring_view delimiters) const
+{
+    if (auto boundaries = std::atomic_load(&_wordBoundaries); boundaries && boundaries->delimiters == delimiters)
+    {
+        return boundaries;
+    }
+
+    const auto width = size();
+    auto boundaries = std::make_shared<WordBoundaries>();
+    boundaries->delimiters = delimiters;
+    boundaries->bits.resize((width + 63) / 64);
+    for (size_t i = 0; i < width; ++i)
+    {
+        const std::wstring_view glyph = GlyphAt(i);
+        if (glyph.size() == 1 && delimiters.find(glyph.front()) != std::wstring_view::npos)
+        {
+            boundaries->bits[i / 64] |= uint64_t{ 1 } << (i % 64);
+        }
+    }
+
+    // readers that built it at the same time all built the same bitmap, so whichever lands last is fine
+    std::shared_ptr<const WordBoundaries> built{ std::move(boundaries) };
+    std::atomic_store(&_wordBoundaries, built);
+    return built;
+}
+
+// Routine Description:
+// - forgets the cached right boundary and word bitmap because the cells are about to change
+void CharRow::_InvalidateMeasure() noexcept
+{
+    _measuredRight.store(NotMeasured, std::memory_order_relaxed);
+    std::atomic_store(&_wordBoundaries, std::shared_ptr<const WordBoundaries>{});
+}
+
+// Routine Description:
+// - gets the packed form of the cells, if the parent row is compacted
+// Return Value:
+// - the packed form, or nullptr if the cells are in _data
+const CompactCharRow* CharRow::_GetCompacted() const noexcept
+{
+    return _pParent->GetCompactCharRow();
+}
+
+// Routine Description:
+// - gets the code unit of a column from wherever the cells are kept
+// Arguments:
+// - column - the column to get the code unit of. the caller checks that it's within the row.
+// Return Value:
+// - the code unit
+const wchar_t& CharRow::_CharAt(const size_t column) const noexcept
+{
+    const auto compacted = _GetCompacted();
+    return compacted ? compacted->CharAt(column) : _data[column].Char();
+}
+
+// Routine Description:
+// - gets the dbcs attribute of a column from wherever the cells are kept
+// Arguments:
+// - column - the column to get the attribute of. the caller checks that it's within the row.
+// Return Value:
+// - the attribute
+const DbcsAttribute& CharRow::_DbcsAttrAt(const size_t column) const noexcept
+{
+    const auto compacted = _GetCompacted();
+    return compacted ? compacted->DbcsAttrAt(column) : _data[column].DbcsAttr();
 }
 
 UnicodeStorage& CharRow::GetUnicodeStorage()
@@ -307,10 +686,10 @@ const UnicodeStorage& CharRow::GetUnicodeStorage() const
 // Arguments:
 // - column - the column to generate the key for
 // Return Value:
-// - the COORD key for data access from UnicodeStorage for the column
-COORD CharRow::GetStorageKey(const size_t column) const
+// - the key for data access from UnicodeStorage for the column
+UnicodeStorage::key_type CharRow::GetStorageKey(const size_t column) const
 {
-    return { gsl::narrow<SHORT>(column), _pParent->GetId() };
+    return { gsl::narrow<SHORT>(column), _pParent->GetStorageKey() };
 }
 
 // Routine Description:
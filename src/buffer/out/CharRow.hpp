@@ -25,7 +25,10 @@ Revision History:
 #include "CharRowCell.hpp"
 #include "UnicodeStorage.hpp"
 
+#include <atomic>
+
 class ROW;
+class CompactCharRow;
 
 // the characters of one row of screen buffer
 // we keep the following values so that we don't write
@@ -46,13 +49,70 @@ public:
     using const_iterator = typename std::vector<value_type>::const_iterator;
     using reference = typename CharRowCellReference;
 
+    // a run of neighbouring cells that are either all word delimiters or all not, as [begin, end).
+    struct WordRun
+    {
+        size_t begin;
+        size_t end;
+        bool isDelimiter;
+    };
+
+    // walks the glyphs of a row as they'd be shown on the screen, skipping the trailing halves
+    // of wide glyphs. each glyph is a view of the row's own storage (or of its UnicodeStorage
+    // entry, looked up only when the glyph is dereferenced), so nothing is copied. it's only
+    // valid for as long as the row isn't written to.
+    class GlyphIterator final
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::wstring_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::wstring_view*;
+        using reference = std::wstring_view;
+
+        GlyphIterator(const CharRow& row, const size_t column) noexcept;
+
+        std::wstring_view operator*() const;
+        GlyphIterator& operator++() noexcept;
+
+        bool operator==(const GlyphIterator& other) const noexcept;
+        bool operator!=(const GlyphIterator& other) const noexcept;
+
+    private:
+        const CharRow* _row;
+        size_t _column;
+
+        void _SkipTrailing() noexcept;
+    };
+
+    // the glyphs of the whole row, as returned by Glyphs.
+    class GlyphRange final
+    {
+    public:
+        explicit GlyphRange(const CharRow& row) noexcept;
+
+        GlyphIterator begin() const noexcept;
+        GlyphIterator end() const noexcept;
+
+        size_t TextLength() const;
+
+    private:
+        const CharRow& _row;
+    };
+
     CharRow(size_t rowWidth, ROW* const pParent);
+    CharRow(const CharRow& other);
+    CharRow(CharRow&& other) noexcept;
+    CharRow& operator=(const CharRow& other);
+    CharRow& operator=(CharRow&& other) noexcept;
+    ~CharRow() = default;
 
     void SetWrapForced(const bool wrap) noexcept;
     bool WasWrapForced() const noexcept;
     void SetDoubleBytePadded(const bool doubleBytePadded) noexcept;
     bool WasDoubleBytePadded() const noexcept;
     size_t size() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
     void Reset();
     [[nodiscard]] HRESULT Resize(const size_t newSize) noexcept;
     size_t MeasureLeft() const;
@@ -62,7 +122,12 @@ public:
     const DbcsAttribute& DbcsAttrAt(const size_t column) const;
     DbcsAttribute& DbcsAttrAt(const size_t column);
     void ClearGlyph(const size_t column);
+    void WriteNarrowChars(const size_t column, const std::wstring_view chars);
+    void FillNarrowChars(const size_t column, const size_t count, const wchar_t wch);
+    void CopyCells(const CharRow& source, const size_t sourceColumn, const size_t count, const size_t column);
     std::wstring GetText() const;
+    GlyphRange Glyphs() const noexcept;
+    WordRun GetWordRunAt(const size_t column, const std::wstring_view delimiters) const;
 
     // other functions implemented at the template class level
     std::wstring GetTextRaw() const;
@@ -80,11 +145,12 @@ public:
 
     UnicodeStorage& GetUnicodeStorage();
     const UnicodeStorage& GetUnicodeStorage() const;
-    COORD GetStorageKey(const size_t column) const;
+    UnicodeStorage::key_type GetStorageKey(const size_t column) const;
 
     void UpdateParent(ROW* const pParent) noexcept;
 
     friend CharRowCellReference;
+    friend class CompactCharRow;
     friend constexpr bool operator==(const CharRow& a, const CharRow& b) noexcept;
 
 protected:
@@ -97,6 +163,34 @@ protected:
     // storage for glyph data and dbcs attributes
     std::vector<value_type> _data;
 
+    // the last result of MeasureRight, or NotMeasured if the cells may have changed since.
+    // every way of getting write access to the cells resets it. readers sharing the row may
+    // each measure it at once, and they all store the same answer, so it's atomic.
+    static constexpr size_t NotMeasured = std::numeric_limits<size_t>::max();
+    mutable std::atomic<size_t> _measuredRight;
+
+    // which cells of the row are word delimiters, one bit per cell, for the delimiters they
+    // were worked out against. it's built by the first reader to look for a word in the row
+    // and dropped along with _measuredRight whenever the cells may change. readers sharing
+    // the row swap in whole new bitmaps rather than touching the one they found.
+    struct WordBoundaries
+    {
+        std::wstring delimiters;
+        std::vector<uint64_t> bits;
+
+        bool IsDelimiter(const size_t column) const noexcept;
+    };
+    mutable std::shared_ptr<const WordBoundaries> _wordBoundaries;
+
+    std::shared_ptr<const WordBoundaries> _GetWordBoundaries(const std::wstring_view delimiters) const;
+    void _InvalidateMeasure() noexcept;
+
+    // while the parent row is compacted, _data is empty and the const members read the packed
+    // form instead, without unpacking it, so that any number of readers can share the row.
+    const CompactCharRow* _GetCompacted() const noexcept;
+    const wchar_t& _CharAt(const size_t column) const noexcept;
+    const DbcsAttribute& _DbcsAttrAt(const size_t column) const noexcept;
+
     // ROW that this CharRow belongs to
     ROW* _pParent;
 };
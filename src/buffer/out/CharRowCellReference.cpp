@@ -12,6 +12,7 @@
 void CharRowCellReference::operator=(const std::wstring_view chars)
 {
     THROW_HR_IF(E_INVALIDARG, chars.empty());
+    _parent._InvalidateMeasure();
     if (chars.size() == 1)
     {
         _cellData().Char() = chars.front();
@@ -21,7 +22,7 @@ void CharRowCellReference::operator=(const std::wstring_view chars)
     {
         auto& storage = _parent.GetUnicodeStorage();
         const auto key = _parent.GetStorageKey(_index);
-        storage.StoreGlyph(key, { chars.cbegin(), chars.cend() });
+        storage.StoreGlyph(key, chars);
         _cellData().DbcsAttr().SetGlyphStored(true);
     }
 }
@@ -45,12 +46,24 @@ CharRowCell& CharRowCellReference::_cellData()
 }
 
 // Routine Description:
-// - The CharRowCell this object "references"
+// - The code unit stored in the referenced cell. It's read from the packed form
+//   if the row is compacted, so that reading never changes the row.
 // Return Value:
-// - ref to the CharRowCell
-const CharRowCell& CharRowCellReference::_cellData() const
+// - ref to the code unit
+const wchar_t& CharRowCellReference::_charData() const
 {
-    return _parent._data.at(_index);
+    THROW_HR_IF(E_INVALIDARG, _index >= _parent.size());
+    return _parent._CharAt(_index);
+}
+
+// Routine Description:
+// - The dbcs attribute of the referenced cell, read the same way as _charData.
+// Return Value:
+// - ref to the dbcs attribute
+const DbcsAttribute& CharRowCellReference::_dbcsAttrData() const
+{
+    THROW_HR_IF(E_INVALIDARG, _index >= _parent.size());
+    return _parent._DbcsAttrAt(_index);
 }
 
 // Routine Description:
@@ -59,15 +72,13 @@ const CharRowCell& CharRowCellReference::_cellData() const
 // - the glyph data
 std::wstring_view CharRowCellReference::_glyphData() const
 {
-    if (_cellData().DbcsAttr().IsGlyphStored())
+    if (_dbcsAttrData().IsGlyphStored())
     {
-        const auto& text = _parent.GetUnicodeStorage().GetText(_parent.GetStorageKey(_index));
-
-        return { text.data(), text.size() };
+        return _parent.GetUnicodeStorage().GetText(_parent.GetStorageKey(_index));
     }
     else
     {
-        return { &_cellData().Char(), 1 };
+        return { &_charData(), 1 };
     }
 }
 
@@ -77,13 +88,13 @@ std::wstring_view CharRowCellReference::_glyphData() const
 // - iterator of the glyph data
 CharRowCellReference::const_iterator CharRowCellReference::begin() const
 {
-    if (_cellData().DbcsAttr().IsGlyphStored())
+    if (_dbcsAttrData().IsGlyphStored())
     {
         return _parent.GetUnicodeStorage().GetText(_parent.GetStorageKey(_index)).data();
     }
     else
     {
-        return &_cellData().Char();
+        return &_charData();
     }
 }
 
@@ -93,20 +104,20 @@ CharRowCellReference::const_iterator CharRowCellReference::begin() const
 // - end iterator of the glyph data
 CharRowCellReference::const_iterator CharRowCellReference::end() const
 {
-    if (_cellData().DbcsAttr().IsGlyphStored())
+    if (_dbcsAttrData().IsGlyphStored())
     {
-        const auto& chars = _parent.GetUnicodeStorage().GetText(_parent.GetStorageKey(_index));
+        const auto chars = _parent.GetUnicodeStorage().GetText(_parent.GetStorageKey(_index));
         return chars.data() + chars.size();
     }
     else
     {
-        return &_cellData().Char() + 1;
+        return &_charData() + 1;
     }
 }
 
 bool operator==(const CharRowCellReference& ref, const std::vector<wchar_t>& glyph)
 {
-    const DbcsAttribute& dbcsAttr = ref._cellData().DbcsAttr();
+    const DbcsAttribute& dbcsAttr = ref._dbcsAttrData();
     if (glyph.size() == 1 && dbcsAttr.IsGlyphStored())
     {
         return false;
@@ -117,12 +128,12 @@ bool operator==(const CharRowCellReference& ref, const std::vector<wchar_t>& gly
     }
     else if (glyph.size() == 1 && !dbcsAttr.IsGlyphStored())
     {
-        return ref._cellData().Char() == glyph.front();
+        return ref._charData() == glyph.front();
     }
     else
     {
-        const auto& chars = ref._parent.GetUnicodeStorage().GetText(ref._parent.GetStorageKey(ref._index));
-        return chars == glyph;
+        const auto chars = ref._parent.GetUnicodeStorage().GetText(ref._parent.GetStorageKey(ref._index));
+        return std::equal(chars.cbegin(), chars.cend(), glyph.cbegin(), glyph.cend());
     }
 }
 
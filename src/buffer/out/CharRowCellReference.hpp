@@ -54,7 +54,8 @@ private:
     const size_t _index;
 
     CharRowCell& _cellData();
-    const CharRowCell& _cellData() const;
+    const wchar_t& _charData() const;
+    const DbcsAttribute& _dbcsAttrData() const;
 
     std::wstring_view _glyphData() const;
 };
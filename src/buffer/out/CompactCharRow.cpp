@@ -0,0 +1,231 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "CompactCharRow.hpp"
+#include "unicode.hpp"
+
+// what the columns past the stored ones hold
+static constexpr wchar_t BlankChar = UNICODE_SPACE;
+static const DbcsAttribute BlankDbcsAttr{};
+
+// Routine Description:
+// - constructor. packs the given char row and releases its cell storage.
+// Arguments:
+// - charRow - the char row to pack. will be left with no cells until expanded again.
+// - pool - optional pool to take the packed storage from and hand the cell storage back to
+// Return Value:
+// - instantiated object
+// Note: will throw if unable to allocate the packed storage
+CompactCharRow::CompactCharRow(CharRow& charRow, RowStoragePool* const pool) :
+    _chars{},
+    _attrs{},
+    _rowWidth{ charRow._data.size() },
+    _wrapForced{ charRow.WasWrapForced() },
+    _doubleBytePadded{ charRow.WasDoubleBytePadded() }
+{
+    const CharRowCell defaultCell;
+
+    // Find the end of the cells that hold anything other than the default value.
+    auto last = charRow._data.crbegin();
+    while (last != charRow._data.crend() && *last == defaultCell && !last->DbcsAttr().IsGlyphStored())
+    {
+        ++last;
+    }
+    const size_t used = charRow._data.crend() - last;
+
+    if (pool)
+    {
+        _chars = pool->TakeChars(used);
+    }
+    else
+    {
+        _chars.reserve(used);
+    }
+    bool hasAttrs = false;
+    for (size_t i = 0; i < used; ++i)
+    {
+        const auto& cell = charRow._data[i];
+        _chars.push_back(cell.Char());
+        hasAttrs = hasAttrs || !cell.DbcsAttr().IsSingle() || cell.DbcsAttr().IsGlyphStored();
+    }
+
+    if (hasAttrs)
+    {
+        if (pool)
+        {
+            _attrs = pool->TakeAttrs(used);
+        }
+        else
+        {
+            _attrs.reserve(used);
+        }
+        for (size_t i = 0; i < used; ++i)
+        {
+            _attrs.push_back(charRow._data[i].DbcsAttr());
+        }
+    }
+
+    // Hand the cell memory back rather than just clearing it.
+    if (pool)
+    {
+        pool->ReturnCells(std::move(charRow._data));
+    }
+    else
+    {
+        std::vector<CharRow::value_type>().swap(charRow._data);
+    }
+    charRow._InvalidateMeasure();
+}
+
+// Routine Description:
+// - constructor. makes the packed form of a blank row that never had any cells.
+// Arguments:
+// - rowWidth - the width the row will have when expanded, in cells
+// Return Value:
+// - instantiated object
+CompactCharRow::CompactCharRow(const size_t rowWidth) noexcept :
+    _chars{},
+    _attrs{},
+    _rowWidth{ rowWidth },
+    _wrapForced{ false },
+    _doubleBytePadded{ false }
+{
+}
+
+// Routine Description:
+// - unpacks the stored cells back into the given char row at full width.
+// Arguments:
+// - charRow - the char row to fill. its previous contents are replaced.
+// - pool - optional pool to take the cell storage from
+// Note: will throw if unable to allocate the cell storage
+void CompactCharRow::Expand(CharRow& charRow, RowStoragePool* const pool) const
+{
+    auto data = pool ? pool->TakeCells(_rowWidth) : std::vector<CharRow::value_type>(_rowWidth);
+    for (size_t i = 0; i < _chars.size(); ++i)
+    {
+        data[i] = CharRow::value_type{ _chars[i], _attrs.empty() ? DbcsAttribute{} : _attrs[i] };
+    }
+
+    charRow._data.swap(data);
+    charRow._InvalidateMeasure();
+    charRow.SetWrapForced(_wrapForced);
+    charRow.SetDoubleBytePadded(_doubleBytePadded);
+}
+
+// Routine Description:
+// - gives the given char row blank cells at full width without unpacking anything,
+//   for when its contents are about to be cleared anyway.
+// - the packed storage is handed back to the pool, so this must not be used afterwards.
+// Arguments:
+// - charRow - the char row to fill. its previous contents are replaced.
+// - pool - optional pool to take the cell storage from and hand the packed storage back to
+// Note: will throw if unable to allocate the cell storage
+void CompactCharRow::Discard(CharRow& charRow, RowStoragePool* const pool)
+{
+    auto data = pool ? pool->TakeCells(_rowWidth) : std::vector<CharRow::value_type>(_rowWidth);
+    charRow._data.swap(data);
+    charRow._InvalidateMeasure();
+
+    if (pool)
+    {
+        Release(*pool);
+    }
+}
+
+// Routine Description:
+// - hands the packed storage back to the pool. this must not be used afterwards.
+// Arguments:
+// - pool - the pool to hand the storage back to
+void CompactCharRow::Release(RowStoragePool& pool) noexcept
+{
+    pool.ReturnChars(std::move(_chars));
+    pool.ReturnAttrs(std::move(_attrs));
+}
+
+// Routine Description:
+// - changes the width the row will have when expanded, dropping any stored cells beyond it.
+// Arguments:
+// - newWidth - the new width of the row, in cells
+void CompactCharRow::Resize(const size_t newWidth) noexcept
+{
+    if (newWidth < _chars.size())
+    {
+        _chars.resize(newWidth);
+        if (!_attrs.empty())
+        {
+            _attrs.resize(newWidth);
+        }
+    }
+    _rowWidth = newWidth;
+}
+
+// Routine Description:
+// - gets the width of the row this was packed from, in cells
+size_t CompactCharRow::size() const noexcept
+{
+    return _rowWidth;
+}
+
+// Routine Description:
+// - gets how many bytes of heap storage are held for the packed cells
+size_t CompactCharRow::GetMemoryUsage() const noexcept
+{
+    return _chars.capacity() * sizeof(wchar_t) + _attrs.capacity() * sizeof(DbcsAttribute);
+}
+
+// Routine Description:
+// - gets the code unit of the given column without unpacking anything, so that a
+//   packed row can be read while others are reading it too.
+// Arguments:
+// - column - the column to get the code unit of. it must be within the row.
+// Return Value:
+// - the code unit. it stays where it is until the packed form is changed or dropped.
+const wchar_t& CompactCharRow::CharAt(const size_t column) const noexcept
+{
+    return column < _chars.size() ? _chars[column] : BlankChar;
+}
+
+// Routine Description:
+// - gets the dbcs attribute of the given column without unpacking anything.
+// Arguments:
+// - column - the column to get the attribute of. it must be within the row.
+// Return Value:
+// - the attribute. it stays where it is until the packed form is changed or dropped.
+const DbcsAttribute& CompactCharRow::DbcsAttrAt(const size_t column) const noexcept
+{
+    return column < _attrs.size() ? _attrs[column] : BlankDbcsAttr;
+}
+
+// Routine Description:
+// - finds the first column that isn't a space, the same as CharRow::MeasureLeft would once unpacked.
+// Return Value:
+// - the left boundary of the text
+size_t CompactCharRow::MeasureLeft() const noexcept
+{
+    for (size_t column = 0; column < _chars.size(); ++column)
+    {
+        if (_chars[column] != UNICODE_SPACE || DbcsAttrAt(column).IsGlyphStored())
+        {
+            return column;
+        }
+    }
+    return _rowWidth;
+}
+
+// Routine Description:
+// - finds one past the last column that isn't a space, the same as CharRow::MeasureRight would once unpacked.
+// Return Value:
+// - the right boundary of the text
+size_t CompactCharRow::MeasureRight() const noexcept
+{
+    for (size_t column = _chars.size(); column > 0; --column)
+    {
+        if (_chars[column - 1] != UNICODE_SPACE || DbcsAttrAt(column - 1).IsGlyphStored())
+        {
+            return column;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- CompactCharRow.hpp
+
+Abstract:
+- Packed form of the character data of a CharRow, used for rows that have
+  scrolled far enough away from the cursor that they are unlikely to be
+  touched again soon.
+- Only the cells up to the last non-default cell are kept, as plain UTF-16
+  code units. DBCS attributes are only kept if the row actually has any.
+  Glyphs that live in UnicodeStorage stay there, keyed by the owning row.
+- New rows also start out in this form, holding nothing, so that a tall
+  buffer only gets full width cells for the rows that are written to.
+- CharRow reads its cells straight out of this form while its row is
+  compacted. Only writing to a row unpacks it.
+
+--*/
+
+#pragma once
+
+#include "CharRow.hpp"
+#include "RowStoragePool.hpp"
+
+class CompactCharRow final
+{
+public:
+    CompactCharRow(CharRow& charRow, RowStoragePool* const pool = nullptr);
+    explicit CompactCharRow(const size_t rowWidth) noexcept;
+
+    void Expand(CharRow& charRow, RowStoragePool* const pool = nullptr) const;
+    void Discard(CharRow& charRow, RowStoragePool* const pool = nullptr);
+    void Release(RowStoragePool& pool) noexcept;
+    void Resize(const size_t newWidth) noexcept;
+
+    size_t size() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
+
+    const wchar_t& CharAt(const size_t column) const noexcept;
+    const DbcsAttribute& DbcsAttrAt(const size_t column) const noexcept;
+    size_t MeasureLeft() const noexcept;
+    size_t MeasureRight() const noexcept;
+
+private:
+    // code units of the cells from column 0 through the last non-default cell
+    std::wstring _chars;
+
+    // dbcs attributes matching _chars. empty if every cell is a default single-width cell.
+    std::vector<DbcsAttribute> _attrs;
+
+    size_t _rowWidth;
+    bool _wrapForced;
+    bool _doubleBytePadded;
+};
@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "MarkIndex.hpp"
+
+// Routine Description:
+// - Adds a mark. A mark at the same position as one that's already there
+//   replaces it, since a shell that repaints its prompt marks it again.
+// Arguments:
+// - mark - the mark to add
+// Note:
+// - will throw on failure
+void MarkIndex::Add(const Mark mark)
+{
+    // Shells mark as they print, so the new mark almost always goes at the end.
+    auto it = _marks.end();
+    if (!_marks.empty() && !s_IsBefore(_marks.back(), mark.row, mark.column))
+    {
+        it = std::lower_bound(_marks.begin(), _marks.end(), mark, [](const Mark& a, const Mark& b) noexcept {
+            return s_IsBefore(a, b.row, b.column);
+        });
+    }
+
+    if (it != _marks.end() && it->row == mark.row && it->column == mark.column)
+    {
+        *it = mark;
+    }
+    else
+    {
+        _marks.insert(it, mark);
+    }
+}
+
+// Routine Description:
+// - Drops the marks on every row before the given one, e.g. when those rows circle off the top of the buffer.
+// Arguments:
+// - row - the first row whose marks are kept
+void MarkIndex::EraseBefore(const uint64_t row) noexcept
+{
+    while (!_marks.empty() && _marks.front().row < row)
+    {
+        _marks.pop_front();
+    }
+}
+
+// Routine Description:
+// - Drops the marks on the given row and every row after it, e.g. when those rows are cut off by a resize.
+// Arguments:
+// - row - the first row whose marks are dropped
+void MarkIndex::EraseFrom(const uint64_t row) noexcept
+{
+    while (!_marks.empty() && _marks.back().row >= row)
+    {
+        _marks.pop_back();
+    }
+}
+
+// Routine Description:
+// - Drops every mark.
+void MarkIndex::Clear() noexcept
+{
+    _marks.clear();
+}
+
+// Routine Description:
+// - Finds the last mark before the given position.
+// Arguments:
+// - row - the absolute row of the position
+// - column - the column of the position
+// - kind - if given, only marks of this kind are considered
+// Return Value:
+// - the mark, or nullptr if there's none before the position. It's valid until the index is next changed.
+const MarkIndex::Mark* MarkIndex::FindPrevious(const uint64_t row, const SHORT column, const std::optional<Kind> kind) const noexcept
+{
+    auto it = std::lower_bound(_marks.cbegin(), _marks.cend(), row, [column](const Mark& mark, const uint64_t r) noexcept {
+        return s_IsBefore(mark, r, column);
+    });
+
+    while (it != _marks.cbegin())
+    {
+        --it;
+        if (!kind || it->kind == *kind)
+        {
+            return &*it;
+        }
+    }
+
+    return nullptr;
+}
+
+// Routine Description:
+// - Finds the first mark after the given position.
+// Arguments:
+// - row - the absolute row of the position
+// - column - the column of the position
+// - kind - if given, only marks of this kind are considered
+// Return Value:
+// - the mark, or nullptr if there's none after the position. It's valid until the index is next changed.
+const MarkIndex::Mark* MarkIndex::FindNext(const uint64_t row, const SHORT column, const std::optional<Kind> kind) const noexcept
+{
+    // The first mark that isn't before or at the position is the first one after it.
+    auto it = std::upper_bound(_marks.cbegin(), _marks.cend(), row, [column](const uint64_t r, const Mark& mark) noexcept {
+        return r < mark.row || (r == mark.row && column < mark.column);
+    });
+
+    for (; it != _marks.cend(); ++it)
+    {
+        if (!kind || it->kind == *kind)
+        {
+            return &*it;
+        }
+    }
+
+    return nullptr;
+}
+
+std::deque<MarkIndex::Mark>::const_iterator MarkIndex::begin() const noexcept
+{
+    return _marks.cbegin();
+}
+
+std::deque<MarkIndex::Mark>::const_iterator MarkIndex::end() const noexcept
+{
+    return _marks.cend();
+}
+
+size_t MarkIndex::size() const noexcept
+{
+    return _marks.size();
+}
+
+// Routine Description:
+// - Tells whether a mark is before the given position.
+bool MarkIndex::s_IsBefore(const Mark& mark, const uint64_t row, const SHORT column) noexcept
+{
+    return mark.row < row || (mark.row == row && mark.column < column);
+}
@@ -0,0 +1,60 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- MarkIndex.hpp
+
+Abstract:
+- keeps where a shell's prompts, commands and their output begin, as marked by
+  shell integration sequences (OSC 133), so that they can be jumped to without
+  scanning the text of the buffer.
+- marks are keyed by the absolute number of the row they're on, counting every
+  row that ever circled off the top of the buffer, so they don't move when the
+  buffer circles. they're kept sorted by position, which makes finding the mark
+  nearest to a position a binary search.
+--*/
+
+#pragma once
+
+class MarkIndex final
+{
+public:
+    enum class Kind : uint8_t
+    {
+        Prompt, // where the prompt starts
+        Command, // where the prompt ends and the command the user types starts
+        Output, // where the command was run and its output starts
+        CommandEnd // where the command finished
+    };
+
+    struct Mark
+    {
+        uint64_t row;
+        SHORT column;
+        Kind kind;
+    };
+
+    MarkIndex() = default;
+
+    MarkIndex(const MarkIndex&) = delete;
+    MarkIndex& operator=(const MarkIndex&) = delete;
+
+    void Add(const Mark mark);
+    void EraseBefore(const uint64_t row) noexcept;
+    void EraseFrom(const uint64_t row) noexcept;
+    void Clear() noexcept;
+
+    const Mark* FindPrevious(const uint64_t row, const SHORT column, const std::optional<Kind> kind) const noexcept;
+    const Mark* FindNext(const uint64_t row, const SHORT column, const std::optional<Kind> kind) const noexcept;
+
+    std::deque<Mark>::const_iterator begin() const noexcept;
+    std::deque<Mark>::const_iterator end() const noexcept;
+    size_t size() const noexcept;
+
+private:
+    // every mark, in the order of where it is in the buffer
+    std::deque<Mark> _marks;
+
+    static bool s_IsBefore(const Mark& mark, const uint64_t row, const SHORT column) noexcept;
+};
@@ -221,7 +221,7 @@ OutputCellIterator& OutputCellIterator::operator++()
             _pos += _currentView.Chars().size();
             if (operator bool())
             {
-                _currentView = s_GenerateView(std::get<std::wstring_view>(_run).substr(_pos), _attr);
+                _currentView = _GenerateTextView(_attr, TextAttributeBehavior::Stored);
             }
         }
         break;
@@ -235,7 +235,7 @@ OutputCellIterator& OutputCellIterator::operator++()
             _pos += _currentView.Chars().size();
             if (operator bool())
             {
-                _currentView = s_GenerateView(std::get<std::wstring_view>(_run).substr(_pos));
+                _currentView = _GenerateTextView(InvalidTextAttribute, TextAttributeBehavior::Current);
             }
         }
         break;
@@ -329,6 +329,93 @@ const OutputCellView* OutputCellIterator::operator->() const
     return &_currentView;
 }
 
+// Routine Description:
+// - Gets the plain 7-bit text coming up next in the underlying text, if any.
+// - Each of these characters is a whole glyph that fills exactly one narrow cell,
+//   so callers can copy them straight into the buffer instead of walking the iterator
+//   one view at a time. Use AdvanceAsciiText to step over what was consumed.
+// Arguments:
+// - limit - maximum number of characters (cells) to return
+// Return Value:
+// - The run of ASCII text starting at the current position. Empty if the iterator
+//   isn't walking over text or if the current glyph isn't ASCII.
+std::wstring_view OutputCellIterator::PeekAsciiText(const size_t limit) const noexcept
+{
+    if ((_mode != Mode::Loose && _mode != Mode::LooseTextOnly) ||
+        _currentView.DbcsAttr().IsTrailing() ||
+        !operator bool())
+    {
+        return {};
+    }
+
+    const auto text = std::get<std::wstring_view>(_run).substr(_pos, limit);
+    const auto firstNonAscii = std::find_if(text.cbegin(), text.cend(), [](const wchar_t wch) noexcept {
+        return wch > 0x7F;
+    });
+    return text.substr(0, firstNonAscii - text.cbegin());
+}
+
+// Routine Description:
+// - Advances the iterator over ASCII text previously returned from PeekAsciiText.
+// Arguments:
+// - count - number of characters (cells) to skip. Must not be more than was peeked.
+void OutputCellIterator::AdvanceAsciiText(const size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    _distance += count;
+    _pos += count;
+    if (operator bool())
+    {
+        const auto text = std::get<std::wstring_view>(_run).substr(_pos);
+        _currentView = _mode == Mode::Loose ? s_GenerateView(text, _attr) : s_GenerateView(text);
+    }
+}
+
+// Routine Description:
+// - Gets how many more times a fill of a single narrow cell will give back that same cell.
+// - The current view stays the same for all of them, so callers can write them with one
+//   fill instead of walking the iterator one view at a time. Use AdvanceNarrowFill to
+//   step over what was consumed.
+// Arguments:
+// - limit - maximum number of cells to count
+// Return Value:
+// - The number of identical cells coming up. 0 if the iterator isn't a fill or
+//   the cell it's filling with isn't one narrow character (or color only).
+size_t OutputCellIterator::PeekNarrowFill(const size_t limit) const noexcept
+{
+    if (_mode != Mode::Fill ||
+        !_currentView.DbcsAttr().IsSingle() ||
+        !operator bool())
+    {
+        return 0;
+    }
+
+    if (_currentView.TextAttrBehavior() != TextAttributeBehavior::StoredOnly &&
+        _currentView.Chars().size() != 1)
+    {
+        return 0;
+    }
+
+    return _fillLimit > 0 ? std::min(limit, _fillLimit - _pos) : limit;
+}
+
+// Routine Description:
+// - Advances the iterator over fill cells previously counted by PeekNarrowFill.
+// Arguments:
+// - count - number of cells to skip. Must not be more than was peeked.
+void OutputCellIterator::AdvanceNarrowFill(const size_t count) noexcept
+{
+    _distance += count;
+    if (_fillLimit > 0)
+    {
+        _pos += count;
+    }
+}
+
 // Routine Description:
 // - Checks the current view. If it is a leading half, it updates the current
 //   view to the trailing half of the same glyph.
@@ -357,6 +444,32 @@ bool OutputCellIterator::_TryMoveTrailing()
     }
 }
 
+// Routine Description:
+// - Creates the view for the glyph at the current position in a run of text.
+// - Text that's known to be narrow is handed out a unit at a time without asking about the width
+//   of each glyph. The run is measured again whenever the position moves past the end of it.
+// Arguments:
+// - attr - Color attributes to apply to the text
+// - behavior - Behavior of the given text attribute (used when writing)
+// Return Value:
+// - Object representing the view into this cell
+OutputCellView OutputCellIterator::_GenerateTextView(const TextAttribute attr,
+                                                     const TextAttributeBehavior behavior)
+{
+    const auto text = std::get<std::wstring_view>(_run).substr(_pos);
+    if (_pos >= _narrowRunEnd)
+    {
+        _narrowRunEnd = _pos + GetNarrowGlyphRunLength(text);
+    }
+
+    if (_pos < _narrowRunEnd)
+    {
+        return OutputCellView(text.substr(0, 1), {}, attr, behavior);
+    }
+
+    return s_GenerateView(text, attr, behavior);
+}
+
 // Routine Description:
 // - Static function to create a view.
 // - It's pulled out statically so it can be used during construction with just the given
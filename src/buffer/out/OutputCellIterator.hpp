@@ -58,6 +58,12 @@ public:
     const OutputCellView& operator*() const;
     const OutputCellView* operator->() const;
 
+    std::wstring_view PeekAsciiText(const size_t limit) const noexcept;
+    void AdvanceAsciiText(const size_t count);
+
+    size_t PeekNarrowFill(const size_t limit) const noexcept;
+    void AdvanceNarrowFill(const size_t count) noexcept;
+
 private:
     enum class Mode
     {
@@ -99,6 +105,9 @@ private:
 
     bool _TryMoveTrailing();
 
+    OutputCellView _GenerateTextView(const TextAttribute attr,
+                                     const TextAttributeBehavior behavior);
+
     static OutputCellView s_GenerateView(const std::wstring_view view);
 
     static OutputCellView s_GenerateView(const std::wstring_view view,
@@ -121,4 +130,7 @@ private:
     size_t _pos;
     size_t _distance;
     size_t _fillLimit;
+
+    // Text before this position in a run is known to be one narrow glyph per unit.
+    size_t _narrowRunEnd{ 0 };
 };
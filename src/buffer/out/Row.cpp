@@ -6,6 +6,10 @@
 #include "CharRow.hpp"
 #include "textBuffer.hpp"
 #include "../types/inc/convert.hpp"
+#include "../types/inc/AllocationTracking.hpp"
+
+using Microsoft::Console::Types::AllocationScope;
+using Microsoft::Console::Types::AllocationTag;
 
 // Routine Description:
 // - constructor
@@ -14,15 +18,68 @@
 // - rowWidth - the width of the row, cell elements
 // - fillAttribute - the default text attribute
 // - pParent - the text buffer that this row belongs to
+// - compacted - if true, the row starts out packed, without any cells until it's first expanded
 // Return Value:
 // - constructed object
-ROW::ROW(const SHORT rowId, const short rowWidth, const TextAttribute fillAttribute, TextBuffer* const pParent) :
+ROW::ROW(const SHORT rowId, const short rowWidth, const TextAttribute fillAttribute, TextBuffer* const pParent, const bool compacted) :
     _id{ rowId },
+    _storageKey{ pParent ? pParent->GetUnicodeStorage().CreateRowKey() : 0 },
+    _generation{ 0 },
     _rowWidth{ gsl::narrow<size_t>(rowWidth) },
-    _charRow{ gsl::narrow<size_t>(rowWidth), this },
-    _attrRow{ gsl::narrow<UINT>(rowWidth), fillAttribute },
+    _charRow{ compacted ? 0 : gsl::narrow<size_t>(rowWidth), this },
+    _attrRow{ gsl::narrow<UINT>(rowWidth), fillAttribute, pParent ? pParent->GetAttributeTable() : nullptr },
+    _compactCharRow{},
     _pParent{ pParent }
 {
+    if (compacted)
+    {
+        _compactCharRow.emplace(_rowWidth);
+    }
+}
+
+// Routine Description:
+// - copy constructor. the copy gets a storage key of its own and its own copy of
+//   the glyphs in UnicodeStorage, so that changing one row leaves the other alone.
+// Arguments:
+// - other - the row to copy
+// Return Value:
+// - instantiated object
+// Note: will throw if unable to allocate the copy
+ROW::ROW(const ROW& other) :
+    _charRow{ other._charRow },
+    _attrRow{ other._attrRow },
+    _compactCharRow{ other._compactCharRow },
+    _id{ other._id },
+    _storageKey{ other._pParent ? other._pParent->GetUnicodeStorage().CreateRowKey() : other._storageKey },
+    _generation{ other._generation },
+    _rowWidth{ other._rowWidth },
+    _pParent{ other._pParent }
+{
+    _charRow.UpdateParent(this);
+    _CopyGlyphs(other);
+}
+
+// Routine Description:
+// - copy assignment. the glyphs this row had are erased, and it gets a new storage key
+//   and its own copy of the other row's glyphs, as with the copy constructor.
+// Arguments:
+// - other - the row to copy
+// Return Value:
+// - this row
+// Note: will throw if unable to allocate the copy, leaving this row as it was
+ROW& ROW::operator=(const ROW& other)
+{
+    if (this != &other)
+    {
+        ROW copy{ other };
+        if (_pParent)
+        {
+            _pParent->GetUnicodeStorage().EraseRows({ _storageKey });
+        }
+        *this = std::move(copy);
+        _charRow.UpdateParent(this);
+    }
+    return *this;
 }
 
 size_t ROW::size() const noexcept
@@ -60,6 +117,33 @@ void ROW::SetId(const SHORT id) noexcept
     _id = id;
 }
 
+// Routine Description:
+// - gets the generation of the text buffer at which the contents of this row last changed
+// Return Value:
+// - the generation. 0 if the row hasn't changed since the buffer was created.
+uint64_t ROW::GetGeneration() const noexcept
+{
+    return _generation;
+}
+
+// Routine Description:
+// - records the generation of the text buffer at which the contents of this row changed
+// Arguments:
+// - generation - the generation to record
+void ROW::SetGeneration(const uint64_t generation) noexcept
+{
+    _generation = generation;
+}
+
+// Routine Description:
+// - gets the key this row's glyphs are stored under in UnicodeStorage
+// Return Value:
+// - the row's storage key
+UnicodeStorage::row_key_type ROW::GetStorageKey() const noexcept
+{
+    return _storageKey;
+}
+
 // Routine Description:
 // - Sets all properties of the ROW to default values
 // Arguments:
@@ -68,6 +152,21 @@ void ROW::SetId(const SHORT id) noexcept
 // - <none>
 bool ROW::Reset(const TextAttribute Attr)
 {
+    if (_compactCharRow.has_value())
+    {
+        // Everything is about to be cleared anyway, so just get the cells back instead of unpacking them.
+        try
+        {
+            _compactCharRow->Discard(_charRow, _GetStoragePool());
+        }
+        catch (...)
+        {
+            LOG_CAUGHT_EXCEPTION();
+            return false;
+        }
+        _compactCharRow.reset();
+    }
+
     _charRow.Reset();
     try
     {
@@ -89,7 +188,15 @@ bool ROW::Reset(const TextAttribute Attr)
 // - S_OK if successful, otherwise relevant error
 [[nodiscard]] HRESULT ROW::Resize(const size_t width)
 {
-    RETURN_IF_FAILED(_charRow.Resize(width));
+    // A compacted row doesn't need to be unpacked just to change its width.
+    if (_compactCharRow.has_value())
+    {
+        _compactCharRow->Resize(width);
+    }
+    else
+    {
+        RETURN_IF_FAILED(_charRow.Resize(width));
+    }
     try
     {
         _attrRow.Resize(width);
@@ -101,6 +208,109 @@ bool ROW::Reset(const TextAttribute Attr)
     return S_OK;
 }
 
+// Routine Description:
+// - Reports whether the char data of this row is currently packed away.
+// Return Value:
+// - True if the row has to be expanded before its char data can be written. It can be read either way.
+bool ROW::IsCompacted() const noexcept
+{
+    return _compactCharRow.has_value();
+}
+
+// Routine Description:
+// - gets the packed form of the row's chars, for reading them without unpacking them
+// Return Value:
+// - the packed form, or nullptr if the row isn't compacted
+const CompactCharRow* ROW::GetCompactCharRow() const noexcept
+{
+    return _compactCharRow.has_value() ? &*_compactCharRow : nullptr;
+}
+
+// Routine Description:
+// - Gets how many bytes this row takes up, itself and the heap storage it holds.
+// Return Value:
+// - The bytes held by the row. Glyphs kept in the UnicodeStorage aren't counted.
+size_t ROW::GetMemoryUsage() const noexcept
+{
+    return sizeof(ROW) +
+           _charRow.GetMemoryUsage() +
+           _attrRow.GetMemoryUsage() +
+           GetCompactedMemoryUsage();
+}
+
+// Routine Description:
+// - Gets how many bytes the packed form of the row's char data holds.
+// Return Value:
+// - The bytes held, or 0 if the row isn't compacted.
+size_t ROW::GetCompactedMemoryUsage() const noexcept
+{
+    return _compactCharRow.has_value() ? _compactCharRow->GetMemoryUsage() : 0;
+}
+
+// Routine Description:
+// - Packs the char data of this row into a compact form and frees the full width cell storage.
+// - The attribute runs are already run length encoded, so they are only trimmed to size.
+// - The row must be expanded again before its char data is accessed.
+// Note: will throw exception if unable to allocate the packed storage
+void ROW::Compact()
+{
+    if (!_compactCharRow.has_value())
+    {
+        _compactCharRow.emplace(_charRow, _GetStoragePool());
+        _attrRow.ShrinkToFit();
+    }
+}
+
+// Routine Description:
+// - Unpacks the char data of a compacted row back into full width cell storage.
+// Note: will throw exception if unable to allocate the cell storage
+void ROW::Expand()
+{
+    if (_compactCharRow.has_value())
+    {
+        const auto pool = _GetStoragePool();
+        _compactCharRow->Expand(_charRow, pool);
+        if (pool)
+        {
+            _compactCharRow->Release(*pool);
+        }
+        _compactCharRow.reset();
+    }
+}
+
+// Routine Description:
+// - gets the pool of the text buffer this row belongs to, for reusing cell storage as the row is packed and unpacked
+// Return Value:
+// - the pool, or nullptr if this row doesn't belong to a text buffer
+// Routine Description:
+// - stores a copy of each of the glyphs the other row keeps in UnicodeStorage under this row's key.
+// Arguments:
+// - other - the row this one was copied from
+// Note: will throw if unable to allocate the glyphs
+void ROW::_CopyGlyphs(const ROW& other)
+{
+    if (!_pParent || _storageKey == other._storageKey)
+    {
+        return;
+    }
+
+    // The glyphs are read out of the same storage they're stored into, which doesn't move them.
+    auto& storage = _pParent->GetUnicodeStorage();
+    const auto& charRow = other.GetCharRow();
+    for (size_t column = 0; column < charRow.size(); ++column)
+    {
+        if (charRow.DbcsAttrAt(column).IsGlyphStored())
+        {
+            storage.StoreGlyph(_charRow.GetStorageKey(column), storage.GetText(charRow.GetStorageKey(column)));
+        }
+    }
+}
+
+RowStoragePool* ROW::_GetStoragePool() const noexcept
+{
+    return _pParent ? &_pParent->GetRowStoragePool() : nullptr;
+}
+
 // Routine Description:
 // - clears char data in column in row
 // Arguments:
@@ -119,9 +329,20 @@ void ROW::ClearColumn(const size_t column)
 // - wstring containing text for the row
 std::wstring ROW::GetText() const
 {
+    const AllocationScope allocationScope{ AllocationTag::BufferOut };
+
     return _charRow.GetText();
 }
 
+// Routine Description:
+// - gets the glyphs of the row as they would be shown on the screen, without copying them
+// Return Value:
+// - a range over the glyphs. it's only valid until the row is written to.
+CharRow::GlyphRange ROW::Glyphs() const noexcept
+{
+    return _charRow.Glyphs();
+}
+
 RowCellIterator ROW::AsCellIter(const size_t startIndex) const
 {
     return AsCellIter(startIndex, size() - startIndex);
@@ -162,6 +383,62 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const size_t index, co
 
     while (it && currentIndex <= finalColumnInRow)
     {
+        // Plain 7-bit text is one narrow cell per character and needs none of the DBCS handling below,
+        // so copy as much of it as will fit in one go and fill its color with a single run.
+        const auto asciiText = it.PeekAsciiText(finalColumnInRow - currentIndex + 1);
+        if (asciiText.size() > 1)
+        {
+            if (it->TextAttrBehavior() != TextAttributeBehavior::Current)
+            {
+                const TextAttributeRun attrRun{ asciiText.size(), it->TextAttr() };
+                LOG_IF_FAILED(_attrRow.InsertAttrRuns({ &attrRun, 1 },
+                                                      currentIndex,
+                                                      currentIndex + asciiText.size() - 1,
+                                                      _charRow.size()));
+            }
+
+            _charRow.WriteNarrowChars(currentIndex, asciiText);
+            currentIndex += asciiText.size();
+
+            // If we're asked to set the wrap status and we just filled the last column with some text, set wrap status on the row.
+            if (setWrap && currentIndex > finalColumnInRow)
+            {
+                _charRow.SetWrapForced(true);
+            }
+
+            it.AdvanceAsciiText(asciiText.size());
+            continue;
+        }
+
+        // Likewise a fill of one narrow cell (or of only a color) is the same cell over and over,
+        // so write all of it that fits at once.
+        const auto fillCount = it.PeekNarrowFill(finalColumnInRow - currentIndex + 1);
+        if (fillCount > 1)
+        {
+            if (it->TextAttrBehavior() != TextAttributeBehavior::Current)
+            {
+                const TextAttributeRun attrRun{ fillCount, it->TextAttr() };
+                LOG_IF_FAILED(_attrRow.InsertAttrRuns({ &attrRun, 1 },
+                                                      currentIndex,
+                                                      currentIndex + fillCount - 1,
+                                                      _charRow.size()));
+            }
+
+            if (it->TextAttrBehavior() != TextAttributeBehavior::StoredOnly)
+            {
+                _charRow.FillNarrowChars(currentIndex, fillCount, it->Chars().front());
+
+                if (setWrap && currentIndex + fillCount > finalColumnInRow)
+                {
+                    _charRow.SetWrapForced(true);
+                }
+            }
+
+            currentIndex += fillCount;
+            it.AdvanceNarrowFill(fillCount);
+            continue;
+        }
+
         // Fill the color if the behavior isn't set to keeping the current color.
         if (it->TextAttrBehavior() != TextAttributeBehavior::Current)
         {
@@ -24,6 +24,7 @@ Revision History:
 #include "OutputCell.hpp"
 #include "OutputCellIterator.hpp"
 #include "CharRow.hpp"
+#include "CompactCharRow.hpp"
 #include "RowCellIterator.hpp"
 #include "UnicodeStorage.hpp"
 
@@ -32,7 +33,12 @@ class TextBuffer;
 class ROW final
 {
 public:
-    ROW(const SHORT rowId, const short rowWidth, const TextAttribute fillAttribute, TextBuffer* const pParent);
+    ROW(const SHORT rowId, const short rowWidth, const TextAttribute fillAttribute, TextBuffer* const pParent, const bool compacted = false);
+    ROW(const ROW& other);
+    ROW(ROW&&) = default;
+    ROW& operator=(const ROW& other);
+    ROW& operator=(ROW&&) = default;
+    ~ROW() = default;
 
     size_t size() const noexcept;
 
@@ -45,11 +51,24 @@ public:
     SHORT GetId() const noexcept;
     void SetId(const SHORT id) noexcept;
 
+    uint64_t GetGeneration() const noexcept;
+    void SetGeneration(const uint64_t generation) noexcept;
+
+    UnicodeStorage::row_key_type GetStorageKey() const noexcept;
+
     bool Reset(const TextAttribute Attr);
     [[nodiscard]] HRESULT Resize(const size_t width);
 
+    bool IsCompacted() const noexcept;
+    const CompactCharRow* GetCompactCharRow() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
+    size_t GetCompactedMemoryUsage() const noexcept;
+    void Compact();
+    void Expand();
+
     void ClearColumn(const size_t column);
     std::wstring GetText() const;
+    CharRow::GlyphRange Glyphs() const noexcept;
 
     RowCellIterator AsCellIter(const size_t startIndex) const;
     RowCellIterator AsCellIter(const size_t startIndex, const size_t count) const;
@@ -68,9 +87,18 @@ public:
 private:
     CharRow _charRow;
     ATTR_ROW _attrRow;
+    // holds the packed char data while this row is compacted. _charRow has no cells while this is set.
+    std::optional<CompactCharRow> _compactCharRow;
     SHORT _id;
+    // key of this row's glyphs in UnicodeStorage. unlike the id, it stays the same as the row moves around the buffer.
+    UnicodeStorage::row_key_type _storageKey;
+    // generation of the text buffer when the contents of this row last changed. it also stays with the row as it moves.
+    uint64_t _generation;
     size_t _rowWidth;
     TextBuffer* _pParent; // non ownership pointer
+
+    RowStoragePool* _GetStoragePool() const noexcept;
+    void _CopyGlyphs(const ROW& other);
 };
 
 inline bool operator==(const ROW& a, const ROW& b) noexcept
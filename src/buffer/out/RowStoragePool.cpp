@@ -0,0 +1,199 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "RowStoragePool.hpp"
+
+// Routine Description:
+// - constructor. reserves room for the spares up front so that handing storage back never allocates.
+// Return Value:
+// - instantiated object
+// Note: will throw exception if unable to allocate memory
+RowStoragePool::RowStoragePool() :
+    _cells{},
+    _chars{},
+    _attrs{},
+    _allocations{ 0 },
+    _reuses{ 0 }
+{
+    _cells.reserve(MaximumSpares);
+    _chars.reserve(MaximumSpares);
+    _attrs.reserve(MaximumSpares);
+}
+
+// Routine Description:
+// - gets storage for the cells of a full width row
+// Arguments:
+// - width - the number of cells the row needs
+// Return Value:
+// - width default cells
+// Note: will throw exception if unable to allocate memory
+RowStoragePool::cells_type RowStoragePool::TakeCells(const size_t width)
+{
+    auto cells = _Take(_cells, width);
+    cells.assign(width, CharRowCell{});
+    return cells;
+}
+
+// Routine Description:
+// - gets storage for the code units of a packed row
+// Arguments:
+// - capacity - the number of code units the row needs
+// Return Value:
+// - an empty string with room for at least capacity code units
+// Note: will throw exception if unable to allocate memory
+std::wstring RowStoragePool::TakeChars(const size_t capacity)
+{
+    auto chars = _Take(_chars, capacity);
+    chars.clear();
+    chars.reserve(capacity);
+    return chars;
+}
+
+// Routine Description:
+// - gets storage for the dbcs attributes of a packed row
+// Arguments:
+// - capacity - the number of attributes the row needs
+// Return Value:
+// - an empty vector with room for at least capacity attributes
+// Note: will throw exception if unable to allocate memory
+std::vector<DbcsAttribute> RowStoragePool::TakeAttrs(const size_t capacity)
+{
+    auto attrs = _Take(_attrs, capacity);
+    attrs.clear();
+    attrs.reserve(capacity);
+    return attrs;
+}
+
+// Routine Description:
+// - hands back the cells of a row that doesn't need them anymore
+// Arguments:
+// - cells - the storage to reuse. it's left empty.
+void RowStoragePool::ReturnCells(cells_type&& cells) noexcept
+{
+    _Return(_cells, std::move(cells));
+}
+
+// Routine Description:
+// - hands back the code units of a packed row that doesn't need them anymore
+// Arguments:
+// - chars - the storage to reuse. it's left empty.
+void RowStoragePool::ReturnChars(std::wstring&& chars) noexcept
+{
+    _Return(_chars, std::move(chars));
+}
+
+// Routine Description:
+// - hands back the dbcs attributes of a packed row that doesn't need them anymore
+// Arguments:
+// - attrs - the storage to reuse. it's left empty.
+void RowStoragePool::ReturnAttrs(std::vector<DbcsAttribute>&& attrs) noexcept
+{
+    _Return(_attrs, std::move(attrs));
+}
+
+// Routine Description:
+// - lets go of all of the spares, for when the buffer is going to sit idle.
+//   the next rows to need storage allocate it again.
+// Note: the room reserved for MaximumSpares is kept, so handing storage back still never allocates.
+void RowStoragePool::Clear() noexcept
+{
+    _cells.clear();
+    _chars.clear();
+    _attrs.clear();
+}
+
+// Routine Description:
+// - gets how many times storage was asked for that no spare could cover
+// Return Value:
+// - count of allocations
+size_t RowStoragePool::GetAllocationCount() const noexcept
+{
+    return _allocations;
+}
+
+// Routine Description:
+// - gets how many times storage was asked for and a spare was reused
+// Return Value:
+// - count of reuses
+size_t RowStoragePool::GetReuseCount() const noexcept
+{
+    return _reuses;
+}
+
+// Routine Description:
+// - gets how many bytes of heap storage the spares hold
+// Return Value:
+// - the bytes held
+size_t RowStoragePool::GetMemoryUsage() const noexcept
+{
+    size_t bytes = 0;
+    for (const auto& cells : _cells)
+    {
+        bytes += cells.capacity() * sizeof(CharRowCell);
+    }
+    for (const auto& chars : _chars)
+    {
+        bytes += chars.capacity() * sizeof(wchar_t);
+    }
+    for (const auto& attrs : _attrs)
+    {
+        bytes += attrs.capacity() * sizeof(DbcsAttribute);
+    }
+    return bytes;
+}
+
+// Routine Description:
+// - picks the spare best suited to hold capacity elements.
+// - spares that are more than twice as large as needed are passed over, so that
+//   packed rows don't end up holding on to far more memory than they use.
+// Arguments:
+// - spares - the spares of the kind of storage needed
+// - capacity - the number of elements that will be stored
+// Return Value:
+// - a spare if one fits, otherwise empty storage that will have to allocate
+template<typename T>
+T RowStoragePool::_Take(std::vector<T>& spares, const size_t capacity)
+{
+    const auto fits = std::find_if(spares.begin(), spares.end(), [=](const T& spare) {
+        return spare.capacity() >= capacity && spare.capacity() <= capacity * 2;
+    });
+
+    if (fits == spares.end())
+    {
+        if (capacity != 0)
+        {
+            ++_allocations;
+        }
+        return T{};
+    }
+
+    ++_reuses;
+    T storage{ std::move(*fits) };
+    spares.erase(fits);
+    return storage;
+}
+
+// Routine Description:
+// - keeps hold of storage for later. if there are enough spares of its kind
+//   already, the oldest one is let go so that spares that never fit don't stick around.
+// Arguments:
+// - spares - the spares of the kind of storage being returned
+// - storage - the storage. it's left empty.
+template<typename T>
+void RowStoragePool::_Return(std::vector<T>& spares, T&& storage) noexcept
+{
+    if (storage.capacity() != 0)
+    {
+        if (spares.size() == MaximumSpares)
+        {
+            spares.erase(spares.begin());
+        }
+
+        // There's room reserved for MaximumSpares, so this can't allocate.
+        spares.push_back(std::move(storage));
+    }
+
+    T{}.swap(storage);
+}
@@ -0,0 +1,61 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- RowStoragePool.hpp
+
+Abstract:
+- keeps the storage of rows that were just packed down or cleared so that the
+  next row to need storage of the same kind can reuse it.
+- while output scrolls, every circle of the buffer clears one packed row and
+  packs another. with the spares handed back and forth through here, that
+  doesn't touch the heap once the pool has warmed up.
+- counts how often storage had to be allocated anyway, so that can be checked.
+--*/
+
+#pragma once
+
+#include "CharRowCell.hpp"
+#include "DbcsAttribute.hpp"
+
+class RowStoragePool final
+{
+public:
+    using cells_type = std::vector<CharRowCell>;
+
+    RowStoragePool();
+
+    RowStoragePool(const RowStoragePool&) = delete;
+    RowStoragePool& operator=(const RowStoragePool&) = delete;
+
+    cells_type TakeCells(const size_t width);
+    std::wstring TakeChars(const size_t capacity);
+    std::vector<DbcsAttribute> TakeAttrs(const size_t capacity);
+
+    void ReturnCells(cells_type&& cells) noexcept;
+    void ReturnChars(std::wstring&& chars) noexcept;
+    void ReturnAttrs(std::vector<DbcsAttribute>&& attrs) noexcept;
+    void Clear() noexcept;
+
+    size_t GetAllocationCount() const noexcept;
+    size_t GetReuseCount() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
+
+private:
+    // a couple of spares of each kind is enough to cover one circle of the buffer.
+    static constexpr size_t MaximumSpares = 4;
+
+    std::vector<cells_type> _cells;
+    std::vector<std::wstring> _chars;
+    std::vector<std::vector<DbcsAttribute>> _attrs;
+
+    size_t _allocations;
+    size_t _reuses;
+
+    template<typename T>
+    T _Take(std::vector<T>& spares, const size_t capacity);
+
+    template<typename T>
+    static void _Return(std::vector<T>& spares, T&& storage) noexcept;
+};
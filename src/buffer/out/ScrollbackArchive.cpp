@@ -0,0 +1,322 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "ScrollbackArchive.hpp"
+#include "Row.hpp"
+
+// Routine Description:
+// - constructor. opens the archive file, creating it if it doesn't exist yet, and
+//   indexes the rows that an earlier session already wrote to it.
+// Arguments:
+// - path - the path of the file to keep the archived rows in
+// Return Value:
+// - instantiated object
+// Note: will throw exception if the file can't be opened or read, or if it's there
+//   already and isn't an archive of this version of the format
+ScrollbackArchive::ScrollbackArchive(const std::wstring_view path) :
+    _file{},
+    _fileSize{ 0 },
+    _offsets{},
+    _viewLock{},
+    _mapping{},
+    _mappingSize{ 0 },
+    _view{},
+    _viewOffset{ 0 },
+    _viewSize{ 0 }
+{
+    // CreateFileW needs the path to be null terminated.
+    const std::wstring filePath{ path };
+    _file.reset(CreateFileW(filePath.c_str(),
+                            GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ,
+                            nullptr,
+                            OPEN_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL,
+                            nullptr));
+    THROW_LAST_ERROR_IF(!_file);
+
+    _LoadIndex();
+}
+
+// Routine Description:
+// - appends a row to the end of the archive
+// - it mustn't be called while another thread is reading the archive. the lock of the
+//   buffer the archive belongs to sees to that.
+// Arguments:
+// - row - the row to archive. packed rows are read in place.
+// Note: will throw exception if the row can't be written. the archive is left as it was.
+void ScrollbackArchive::Append(const ROW& row)
+{
+    std::vector<TextAttributeRun> runs;
+    const auto& attrRow = row.GetAttrRow();
+    for (size_t column = 0; column < row.size();)
+    {
+        size_t applies = 0;
+        const auto attr = attrRow.GetAttrByColumn(column, &applies);
+        applies = std::clamp<size_t>(applies, 1, row.size() - column);
+        runs.emplace_back(applies, attr);
+        column += applies;
+    }
+
+    // Build the whole record first so that it goes to the file in a single write. The glyphs
+    // are copied straight into it. Cells past the end of the text are blank once they're paged
+    // back in anyway, so the trailing spaces are left off.
+    const auto glyphs = row.Glyphs();
+    std::vector<BYTE> record;
+    record.reserve(sizeof(RecordHeader) + glyphs.TextLength() * sizeof(wchar_t) + runs.size() * RunSize);
+    record.resize(sizeof(RecordHeader));
+    size_t textEnd = record.size();
+    for (const auto glyph : glyphs)
+    {
+        const auto bytes = reinterpret_cast<const BYTE*>(glyph.data());
+        record.insert(record.end(), bytes, bytes + glyph.size() * sizeof(wchar_t));
+        if (glyph != std::wstring_view{ L" " })
+        {
+            textEnd = record.size();
+        }
+    }
+    record.resize(textEnd + runs.size() * RunSize);
+
+    RecordHeader header{};
+    header.magic = RecordMagic;
+    header.textLength = gsl::narrow<uint32_t>((textEnd - sizeof(header)) / sizeof(wchar_t));
+    header.runCount = gsl::narrow<uint32_t>(runs.size());
+    header.width = gsl::narrow<uint16_t>(row.size());
+    header.flags = row.GetCharRow().WasWrapForced() ? WrapForcedFlag : 0;
+    memcpy(record.data(), &header, sizeof(header));
+
+    auto out = record.data() + textEnd;
+    for (const auto& run : runs)
+    {
+        const auto length = gsl::narrow<uint32_t>(run.GetLength());
+        const auto attr = TextAttributeRecord::Write(run.GetAttributes());
+        memcpy(out, &length, sizeof(length));
+        memcpy(out + sizeof(length), attr.data(), attr.size());
+        out += RunSize;
+    }
+
+    DWORD written = 0;
+    const BOOL succeeded = WriteFile(_file.get(), record.data(), gsl::narrow<DWORD>(record.size()), &written, nullptr);
+    if (!succeeded || written != record.size())
+    {
+        const HRESULT hr = succeeded ? HRESULT_FROM_WIN32(ERROR_WRITE_FAULT) : HRESULT_FROM_WIN32(GetLastError());
+
+        // Don't leave part of a record behind for the next one to be appended after.
+        LARGE_INTEGER end;
+        end.QuadPart = gsl::narrow<LONGLONG>(_fileSize);
+        LOG_IF_WIN32_BOOL_FALSE(SetFilePointerEx(_file.get(), end, nullptr, FILE_BEGIN));
+        THROW_HR(hr);
+    }
+
+    _offsets.push_back(_fileSize);
+    _fileSize += record.size();
+}
+
+// Routine Description:
+// - reads a row back out of the archive, checking the record as it goes
+// Arguments:
+// - index - the index of the row, counting from the first row ever archived
+// Return Value:
+// - the text, attributes and wrap state of the row
+// Note: will throw exception if index is out of bounds, the file can't be read
+//   or the record is damaged
+ScrollbackArchive::ArchivedRow ScrollbackArchive::Read(const size_t index) const
+{
+    THROW_HR_IF(E_INVALIDARG, index >= _offsets.size());
+    const auto offset = _offsets.at(index);
+
+    std::lock_guard<std::mutex> lock{ _viewLock };
+
+    RecordHeader header;
+    memcpy(&header, _MapRange(offset, sizeof(header)), sizeof(header));
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), header.magic != RecordMagic || header.width == 0);
+
+    // _LoadIndex already made sure the whole record is in the file.
+    const size_t textSize = header.textLength * sizeof(wchar_t);
+    auto data = _MapRange(offset, sizeof(header) + textSize + header.runCount * RunSize) + sizeof(header);
+
+    ArchivedRow row;
+    row.width = header.width;
+    row.wrapForced = WI_IsFlagSet(header.flags, WrapForcedFlag);
+
+    row.text.resize(header.textLength);
+    memcpy(row.text.data(), data, textSize);
+    data += textSize;
+
+    row.attrs.reserve(header.runCount);
+    size_t covered = 0;
+    for (uint32_t i = 0; i < header.runCount; ++i)
+    {
+        uint32_t length;
+        memcpy(&length, data, sizeof(length));
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), length == 0 || length > row.width - covered);
+        row.attrs.emplace_back(length, TextAttributeRecord::Read(data + sizeof(length)));
+        covered += length;
+        data += RunSize;
+    }
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), covered != row.width);
+
+    return row;
+}
+
+// Routine Description:
+// - brings an archived row back into a row of a buffer
+// - if the row isn't as wide as it was archived, the text and the attributes are cut
+//   off at its right edge or leave the rest of it as it is, and the row doesn't wrap.
+// Arguments:
+// - index - the index of the row, counting from the first row ever archived
+// - row - the row to fill. it should be blank.
+// Note: will throw exception if the row can't be read or written
+void ScrollbackArchive::PageIn(const size_t index, ROW& row) const
+{
+    const auto archived = Read(index);
+
+    std::vector<TextAttributeRun> runs;
+    runs.reserve(archived.attrs.size());
+    size_t covered = 0;
+    for (const auto& run : archived.attrs)
+    {
+        if (covered >= row.size())
+        {
+            break;
+        }
+        const auto length = std::min(run.GetLength(), row.size() - covered);
+        runs.emplace_back(length, run.GetAttributes());
+        covered += length;
+    }
+
+    if (!archived.text.empty())
+    {
+        row.WriteCells(OutputCellIterator{ archived.text }, 0, false);
+    }
+    THROW_IF_FAILED(row.GetAttrRow().InsertAttrRuns({ runs.data(), runs.size() }, 0, covered - 1, row.size()));
+    row.GetCharRow().SetWrapForced(archived.wrapForced && archived.width == row.size());
+}
+
+// Routine Description:
+// - gets the number of rows in the archive
+// Return Value:
+// - count of archived rows
+size_t ScrollbackArchive::size() const noexcept
+{
+    return _offsets.size();
+}
+
+// Routine Description:
+// - gets how many bytes of heap storage the index of the records holds. the rows
+//   themselves are in the file, and the view of it is backed by the file too.
+// Return Value:
+// - the bytes held
+size_t ScrollbackArchive::GetMemoryUsage() const noexcept
+{
+    return _offsets.capacity() * sizeof(uint64_t);
+}
+
+// Routine Description:
+// - checks the header of the file, writing it first if the file is new, then walks the
+//   records already in it to find where each of them starts.
+// - anything after the last complete record (e.g. from a write that was cut short) is cut off
+//   so that new rows are appended right after it.
+// Note: will throw exception if the file can't be read, or if it isn't an archive of this
+//   version of the format. such a file is left as it is.
+void ScrollbackArchive::_LoadIndex()
+{
+    LARGE_INTEGER size;
+    THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(_file.get(), &size));
+    _fileSize = gsl::narrow<uint64_t>(size.QuadPart);
+
+    if (_fileSize == 0)
+    {
+        FileHeader fileHeader{};
+        fileHeader.magic = FileMagic;
+        fileHeader.version = FileVersion;
+
+        DWORD written = 0;
+        THROW_IF_WIN32_BOOL_FALSE(WriteFile(_file.get(), &fileHeader, sizeof(fileHeader), &written, nullptr));
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_WRITE_FAULT), written != sizeof(fileHeader));
+        _fileSize = sizeof(fileHeader);
+        return;
+    }
+
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), _fileSize < sizeof(FileHeader));
+    FileHeader fileHeader;
+    memcpy(&fileHeader, _MapRange(0, sizeof(fileHeader)), sizeof(fileHeader));
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), fileHeader.magic != FileMagic || fileHeader.version != FileVersion);
+
+    uint64_t offset = sizeof(fileHeader);
+    while (_fileSize - offset >= sizeof(RecordHeader))
+    {
+        RecordHeader header;
+        memcpy(&header, _MapRange(offset, sizeof(header)), sizeof(header));
+        const uint64_t recordSize = sizeof(header) + static_cast<uint64_t>(header.textLength) * sizeof(wchar_t) + static_cast<uint64_t>(header.runCount) * RunSize;
+        if (header.magic != RecordMagic || recordSize > _fileSize - offset)
+        {
+            break;
+        }
+
+        _offsets.push_back(offset);
+        offset += recordSize;
+    }
+
+    // The file can't be shortened while it's mapped, and there's no telling
+    // which rows will be read first anyway, so let go of the view.
+    _view.reset();
+    _mapping.reset();
+    _mappingSize = 0;
+
+    LARGE_INTEGER end;
+    end.QuadPart = gsl::narrow<LONGLONG>(offset);
+    THROW_IF_WIN32_BOOL_FALSE(SetFilePointerEx(_file.get(), end, nullptr, FILE_BEGIN));
+    if (offset != _fileSize)
+    {
+        THROW_IF_WIN32_BOOL_FALSE(SetEndOfFile(_file.get()));
+        _fileSize = offset;
+    }
+}
+
+// Routine Description:
+// - makes a range of the file readable, reusing the current view if it already covers it
+// - once the archive is made, the caller has to hold the view lock.
+// Arguments:
+// - offset - where the range starts in the file
+// - length - the number of bytes in the range. the range must lie within the file.
+// Return Value:
+// - pointer to the start of the range. it's valid until the next call.
+// Note: will throw exception if the file can't be mapped
+const BYTE* ScrollbackArchive::_MapRange(const uint64_t offset, const size_t length) const
+{
+    if (_view && offset >= _viewOffset && offset + length <= _viewOffset + _viewSize)
+    {
+        return _view.get() + (offset - _viewOffset);
+    }
+
+    // A mapping only covers the size the file had when it was made,
+    // so make a new one if rows have been appended past it since.
+    if (!_mapping || offset + length > _mappingSize)
+    {
+        _view.reset();
+        _mapping.reset(CreateFileMappingW(_file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+        THROW_LAST_ERROR_IF_NULL(_mapping.get());
+        _mappingSize = _fileSize;
+    }
+
+    // Views have to start on an allocation granularity boundary.
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const uint64_t viewOffset = offset - offset % info.dwAllocationGranularity;
+    const uint64_t viewEnd = std::min(_mappingSize, std::max(offset + length, viewOffset + MinimumViewSize));
+    const auto viewSize = gsl::narrow<size_t>(viewEnd - viewOffset);
+
+    _view.reset(static_cast<BYTE*>(MapViewOfFile(_mapping.get(),
+                                                 FILE_MAP_READ,
+                                                 static_cast<DWORD>(viewOffset >> 32),
+                                                 static_cast<DWORD>(viewOffset),
+                                                 viewSize)));
+    THROW_LAST_ERROR_IF_NULL(_view.get());
+    _viewOffset = viewOffset;
+    _viewSize = viewSize;
+
+    return _view.get() + (offset - _viewOffset);
+}
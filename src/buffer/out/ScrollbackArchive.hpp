@@ -0,0 +1,100 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ScrollbackArchive.hpp
+
+Abstract:
+- optional spill tier for rows that scroll off the top of a text buffer.
+- rows are appended to a file as self describing records holding the row's
+  text, its attribute runs and its wrap state. the file is append only, so the
+  rows written by an earlier session are found again when it's reopened.
+- the file starts with a header carrying the version of the format. attributes
+  are stored field by field as TextAttributeRecords, and every record is checked
+  as it's read back, so a damaged or foreign file is refused rather than trusted.
+- records are read back through a small mapped view of the file, so the working
+  set stays bounded no matter how long the file grows. only the offset of each
+  record is kept in memory.
+--*/
+
+#pragma once
+
+#include "TextAttributeRun.hpp"
+#include "TextAttributeRecord.hpp"
+
+#include <mutex>
+
+class ROW;
+
+class ScrollbackArchive final
+{
+public:
+    struct ArchivedRow
+    {
+        std::wstring text; // the text of the row, as given by ROW::GetText
+        std::vector<TextAttributeRun> attrs; // attribute runs covering every cell of the row
+        size_t width; // the cells the row had
+        bool wrapForced;
+    };
+
+    ScrollbackArchive(const std::wstring_view path);
+
+    ScrollbackArchive(const ScrollbackArchive&) = delete;
+    ScrollbackArchive& operator=(const ScrollbackArchive&) = delete;
+
+    void Append(const ROW& row);
+    ArchivedRow Read(const size_t index) const;
+    void PageIn(const size_t index, ROW& row) const;
+
+    size_t size() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
+
+private:
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t reserved;
+    };
+
+    struct RecordHeader
+    {
+        uint32_t magic;
+        uint32_t textLength; // wchar_ts of text following the header
+        uint32_t runCount; // runs following the text
+        uint16_t width;
+        uint8_t flags;
+        uint8_t reserved;
+    };
+
+    static constexpr uint32_t FileMagic = 0x52414253; // 'SBAR'
+    static constexpr uint16_t FileVersion = 1;
+    static constexpr uint32_t RecordMagic = 0x57524253; // 'SBRW'
+    static constexpr uint8_t WrapForcedFlag = 0x1;
+
+    // each run is stored as its length followed by the record of its attribute
+    static constexpr size_t RunSize = sizeof(uint32_t) + TextAttributeRecord::Size;
+
+    // views are mapped at least this large so that reading consecutive rows doesn't remap every time
+    static constexpr size_t MinimumViewSize = 1024 * 1024;
+
+    wil::unique_hfile _file;
+    uint64_t _fileSize;
+
+    // offset of every record in the file, in order
+    std::vector<uint64_t> _offsets;
+
+    // the mapping and the part of the file that's currently in view. they're
+    // replaced whenever a read falls outside of them. readers can come from
+    // more than one thread at once, so they take turns with the view.
+    mutable std::mutex _viewLock;
+    mutable wil::unique_handle _mapping;
+    mutable uint64_t _mappingSize;
+    mutable wil::unique_mapview_ptr<BYTE> _view;
+    mutable uint64_t _viewOffset;
+    mutable size_t _viewSize;
+
+    void _LoadIndex();
+    const BYTE* _MapRange(const uint64_t offset, const size_t length) const;
+};
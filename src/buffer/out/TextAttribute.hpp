@@ -161,6 +161,9 @@ private:
     TextColor _background;
     bool _isBold;
 
+    friend struct std::hash<TextAttribute>;
+    friend class TextAttributeRecord;
+
 #ifdef UNIT_TESTING
     friend class TextBufferTests;
     friend class TextAttributeTests;
@@ -209,6 +212,29 @@ constexpr bool operator!=(const WORD& legacyAttr, const TextAttribute& attr) noe
     return !(attr == legacyAttr);
 }
 
+namespace std
+{
+    template<>
+    struct hash<TextAttribute>
+    {
+        // Routine Description:
+        // - hashes a TextAttribute by combining the hashes of its colors with its flags.
+        // Arguments:
+        // - attr - the attribute to hash
+        // Return Value:
+        // - the hashed attribute
+        size_t operator()(const TextAttribute& attr) const noexcept
+        {
+            constexpr size_t prime = 16777619;
+            const hash<TextColor> colorHash;
+            size_t retVal = colorHash(attr._foreground);
+            retVal = retVal * prime ^ colorHash(attr._background);
+            retVal = retVal * prime ^ (static_cast<size_t>(attr._wAttrLegacy) | static_cast<size_t>(attr._isBold) << 16);
+            return retVal;
+        }
+    };
+}
+
 #ifdef UNIT_TESTING
 
 #define LOG_ATTR(attr) (Log::Comment(NoThrowString().Format( \
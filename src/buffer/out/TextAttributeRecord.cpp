@@ -0,0 +1,100 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "TextAttributeRecord.hpp"
+
+// the meta attributes a TextAttribute can hold. it never keeps the lead/trailing byte flags.
+static constexpr WORD StoredMetaAttrs = META_ATTRS & ~COMMON_LVB_SBCSDBCS;
+
+// Routine Description:
+// - lays an attribute out the way it's stored in a file
+// Arguments:
+// - attr - the attribute to store
+// Return Value:
+// - the bytes of the record
+TextAttributeRecord::Bytes TextAttributeRecord::Write(const TextAttribute& attr) noexcept
+{
+    Bytes record{};
+    record[0] = LOBYTE(attr._wAttrLegacy);
+    record[1] = HIBYTE(attr._wAttrLegacy);
+    _WriteColor(attr._foreground, &record[2]);
+    _WriteColor(attr._background, &record[6]);
+    record[10] = attr._isBold ? 1 : 0;
+    return record;
+}
+
+// Routine Description:
+// - reads an attribute back out of a file, checking every field of it
+// Arguments:
+// - data - the record. it must be Size bytes long.
+// Return Value:
+// - the attribute the record was written from
+// Note: will throw exception if the record doesn't hold a valid attribute
+TextAttribute TextAttributeRecord::Read(const BYTE* const data)
+{
+    const WORD meta = MAKEWORD(data[0], data[1]);
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), (meta & ~StoredMetaAttrs) != 0);
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), data[10] > 1);
+
+    TextAttribute attr;
+    attr._wAttrLegacy = meta;
+    attr._foreground = _ReadColor(&data[2]);
+    attr._background = _ReadColor(&data[6]);
+    attr._isBold = data[10] != 0;
+    return attr;
+}
+
+// Routine Description:
+// - lays a color out as its kind followed by its three value bytes: the index and two
+//   zeros for an indexed color, red, green and blue for an RGB one, and zeros for the default
+// Arguments:
+// - color - the color to store
+// - out - where the four bytes go
+void TextAttributeRecord::_WriteColor(const TextColor& color, BYTE* const out) noexcept
+{
+    out[0] = static_cast<BYTE>(color._meta);
+    if (color.IsRgb())
+    {
+        out[1] = color._red;
+        out[2] = color._green;
+        out[3] = color._blue;
+    }
+    else if (color.IsLegacy())
+    {
+        out[1] = color._index;
+        out[2] = 0;
+        out[3] = 0;
+    }
+    else
+    {
+        out[1] = 0;
+        out[2] = 0;
+        out[3] = 0;
+    }
+}
+
+// Routine Description:
+// - reads a color written by _WriteColor
+// Arguments:
+// - data - the four bytes of the color
+// Return Value:
+// - the color
+// Note: will throw exception if the kind is unknown or the value doesn't fit it
+TextColor TextAttributeRecord::_ReadColor(const BYTE* const data)
+{
+    switch (static_cast<ColorType>(data[0]))
+    {
+    case ColorType::IsDefault:
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), data[1] != 0 || data[2] != 0 || data[3] != 0);
+        return TextColor{};
+    case ColorType::IsIndex:
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), data[2] != 0 || data[3] != 0);
+        return TextColor{ data[1] };
+    case ColorType::IsRgb:
+        return TextColor{ RGB(data[1], data[2], data[3]) };
+    default:
+        THROW_HR(HRESULT_FROM_WIN32(ERROR_INVALID_DATA));
+    }
+}
@@ -0,0 +1,34 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TextAttributeRecord.hpp
+
+Abstract:
+- the form a TextAttribute takes in the files text buffers are saved to.
+- every field is written on its own, at a fixed place and in a fixed byte order:
+  the legacy meta attributes, then the kind and value of each color, then the
+  bold flag. so the files don't depend on how TextAttribute is laid out in
+  memory, and every field is checked as it's read back in.
+--*/
+
+#pragma once
+
+#include "TextAttribute.hpp"
+
+class TextAttributeRecord final
+{
+public:
+    // bytes a record takes up
+    static constexpr size_t Size = 11;
+
+    using Bytes = std::array<BYTE, Size>;
+
+    static Bytes Write(const TextAttribute& attr) noexcept;
+    static TextAttribute Read(const BYTE* const data);
+
+private:
+    static void _WriteColor(const TextColor& color, BYTE* const out) noexcept;
+    static TextColor _ReadColor(const BYTE* const data);
+};
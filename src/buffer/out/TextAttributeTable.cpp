@@ -0,0 +1,135 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "TextAttributeTable.hpp"
+
+// Routine Description:
+// - finds or creates the entry for the given attribute and adds a reference to it
+// Arguments:
+// - attr - the attribute to intern
+// Return Value:
+// - the id of the attribute. The caller owns one reference and must Release it.
+// Note:
+// - will throw exception if unable to allocate memory for the new entry
+[[nodiscard]] TextAttributeTable::id_type TextAttributeTable::Acquire(const TextAttribute& attr)
+{
+    if (_lastId != InvalidId && _entries[_lastId].attr == attr)
+    {
+        ++_entries[_lastId].refCount;
+        return _lastId;
+    }
+
+    const auto it = _ids.find(attr);
+    if (it != _ids.end())
+    {
+        ++_entries[it->second].refCount;
+        _lastId = it->second;
+        return it->second;
+    }
+
+    const bool reuseId = !_freeIds.empty();
+    THROW_HR_IF(E_OUTOFMEMORY, !reuseId && _entries.size() >= InvalidId);
+    const id_type id = reuseId ? _freeIds.back() : gsl::narrow_cast<id_type>(_entries.size());
+
+    _ids.emplace(attr, id);
+    if (reuseId)
+    {
+        _entries[id] = { attr, 1 };
+        _freeIds.pop_back();
+    }
+    else
+    {
+        try
+        {
+            _entries.push_back({ attr, 1 });
+        }
+        catch (...)
+        {
+            _ids.erase(attr);
+            throw;
+        }
+    }
+
+    _lastId = id;
+    return id;
+}
+
+// Routine Description:
+// - adds another reference to an id that is already held
+// Arguments:
+// - id - the id to reference
+void TextAttributeTable::AddRef(const id_type id) noexcept
+{
+    ++_entries[id].refCount;
+}
+
+// Routine Description:
+// - drops a reference to an id. When the last reference is gone, the entry is
+//   removed from the table and its id becomes available for reuse.
+// Arguments:
+// - id - the id to release
+void TextAttributeTable::Release(const id_type id) noexcept
+{
+    auto& entry = _entries[id];
+    FAIL_FAST_IF(entry.refCount == 0);
+    if (--entry.refCount == 0)
+    {
+        _ids.erase(entry.attr);
+        if (_lastId == id)
+        {
+            _lastId = InvalidId;
+        }
+
+        try
+        {
+            _freeIds.push_back(id);
+        }
+        CATCH_LOG();
+    }
+}
+
+// Routine Description:
+// - looks up the id of an attribute without adding a reference to it
+// Arguments:
+// - attr - the attribute to find
+// Return Value:
+// - the id of the attribute or InvalidId if no run is using it
+TextAttributeTable::id_type TextAttributeTable::Find(const TextAttribute& attr) const noexcept
+{
+    const auto it = _ids.find(attr);
+    return it != _ids.end() ? it->second : InvalidId;
+}
+
+// Routine Description:
+// - gets the attribute for an id
+// Arguments:
+// - id - the id to look up
+// Return Value:
+// - the attribute that the id stands for
+const TextAttribute& TextAttributeTable::Get(const id_type id) const noexcept
+{
+    return _entries[id].attr;
+}
+
+// Routine Description:
+// - reports how many distinct attributes are currently in use
+// Return Value:
+// - count of live entries
+size_t TextAttributeTable::size() const noexcept
+{
+    return _ids.size();
+}
+
+// Routine Description:
+// - estimates how many bytes of heap storage the table holds. the hash map's nodes
+//   are counted as their value and two pointers, which is what they cost in practice.
+// Return Value:
+// - approximate bytes held
+size_t TextAttributeTable::GetMemoryUsage() const noexcept
+{
+    return _entries.size() * sizeof(Entry) +
+           _freeIds.capacity() * sizeof(id_type) +
+           _ids.size() * (sizeof(std::pair<const TextAttribute, id_type>) + 2 * sizeof(void*)) +
+           _ids.bucket_count() * sizeof(void*);
+}
@@ -0,0 +1,60 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TextAttributeTable.hpp
+
+Abstract:
+- interning table for the TextAttributes used by a text buffer. Every distinct
+  attribute is stored once and handed out as a small integer id, so attribute
+  runs only need to carry the id and can compare attributes by comparing ids.
+- entries are reference counted by the runs that use them and are recycled
+  when the last run lets go of them.
+--*/
+
+#pragma once
+
+#include <deque>
+#include <unordered_map>
+
+#include "TextAttribute.hpp"
+
+class TextAttributeTable final
+{
+public:
+    using id_type = uint32_t;
+
+    static constexpr id_type InvalidId = std::numeric_limits<id_type>::max();
+
+    TextAttributeTable() = default;
+
+    TextAttributeTable(const TextAttributeTable&) = delete;
+    TextAttributeTable& operator=(const TextAttributeTable&) = delete;
+
+    [[nodiscard]] id_type Acquire(const TextAttribute& attr);
+    void AddRef(const id_type id) noexcept;
+    void Release(const id_type id) noexcept;
+
+    id_type Find(const TextAttribute& attr) const noexcept;
+    const TextAttribute& Get(const id_type id) const noexcept;
+
+    size_t size() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
+
+private:
+    struct Entry
+    {
+        TextAttribute attr;
+        size_t refCount;
+    };
+
+    // A deque is used so that references returned from Get stay valid as the table grows.
+    std::deque<Entry> _entries;
+    std::vector<id_type> _freeIds;
+    std::unordered_map<TextAttribute, id_type> _ids;
+
+    // Writes tend to repeat the same attribute cell after cell,
+    // so remember the last one we handed out to skip the hash lookup.
+    id_type _lastId = InvalidId;
+};
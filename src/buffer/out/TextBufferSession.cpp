@@ -0,0 +1,283 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "TextBufferSession.hpp"
+#include "TextAttributeRecord.hpp"
+#include "textBuffer.hpp"
+
+// Routine Description:
+// - saves the rows of a snapshot to a file, along with where the cursor and the viewport were.
+// - the rows go to a file next to the given one, which only replaces it once it's complete,
+//   so a save that's cut short leaves the session saved before it as it was.
+// Arguments:
+// - path - the path of the file to save the session to
+// - snapshot - the rows to save, usually the whole buffer
+// - state - where the cursor and the top of the viewport were, in the rows of the snapshot
+// Note: will throw exception if the file can't be written
+void TextBufferSession::Save(const std::wstring_view path, const TextBufferSnapshot& snapshot, const State state)
+{
+    const std::wstring filePath{ path };
+    const auto tempPath = filePath + L".tmp";
+
+    wil::unique_hfile file{ CreateFileW(tempPath.c_str(),
+                                        GENERIC_WRITE,
+                                        0,
+                                        nullptr,
+                                        CREATE_ALWAYS,
+                                        FILE_ATTRIBUTE_NORMAL,
+                                        nullptr) };
+    THROW_LAST_ERROR_IF(!file);
+    auto removeTempFile = wil::scope_exit([&]() {
+        file.reset();
+        DeleteFileW(tempPath.c_str());
+    });
+
+    std::vector<BYTE> chunk;
+    chunk.reserve(WriteChunkSize);
+    uint64_t fileSize = 0;
+
+    const auto flush = [&]() {
+        DWORD written = 0;
+        THROW_IF_WIN32_BOOL_FALSE(WriteFile(file.get(), chunk.data(), gsl::narrow<DWORD>(chunk.size()), &written, nullptr));
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_WRITE_FAULT), written != chunk.size());
+        fileSize += chunk.size();
+        chunk.clear();
+    };
+    const auto append = [&](const void* const data, const size_t size) {
+        const auto bytes = static_cast<const BYTE*>(data);
+        chunk.insert(chunk.end(), bytes, bytes + size);
+        if (chunk.size() >= WriteChunkSize)
+        {
+            flush();
+        }
+    };
+
+    const auto& rows = snapshot.GetRows();
+
+    // The header is written again at the end, once the attributes have all been seen.
+    FileHeader header{};
+    header.magic = FileMagic;
+    header.version = FileVersion;
+    header.width = gsl::narrow<uint16_t>(rows.Width());
+    header.rowCount = gsl::narrow<uint32_t>(rows.Height());
+    header.cursorX = state.cursorPosition.X;
+    header.cursorY = state.cursorPosition.Y;
+    header.viewportTop = state.viewportTop;
+    append(&header, sizeof(header));
+
+    std::unordered_map<TextAttribute, uint32_t> attrIndices;
+    std::vector<TextAttribute> attrs;
+    std::vector<Run> runs;
+    for (SHORT y = rows.Top(); y <= rows.BottomInclusive(); ++y)
+    {
+        const auto& row = snapshot.GetRow(y);
+
+        // Cells past the end of the text are blank once they're restored anyway.
+        auto text = row.GetText();
+        text.erase(text.find_last_not_of(L' ') + 1);
+
+        runs.clear();
+        for (size_t column = 0; column < row.size();)
+        {
+            size_t applies = 0;
+            const auto attr = row.GetAttrByColumn(column, &applies);
+            applies = std::clamp<size_t>(applies, 1, row.size() - column);
+
+            const auto [it, inserted] = attrIndices.emplace(attr, gsl::narrow<uint32_t>(attrs.size()));
+            if (inserted)
+            {
+                attrs.push_back(attr);
+            }
+            runs.push_back({ gsl::narrow<uint32_t>(applies), it->second });
+            column += applies;
+        }
+
+        RowHeader rowHeader{};
+        rowHeader.textLength = gsl::narrow<uint32_t>(text.size());
+        rowHeader.runCount = gsl::narrow<uint16_t>(runs.size());
+        rowHeader.flags = row.WasWrapForced() ? WrapForcedFlag : 0;
+        append(&rowHeader, sizeof(rowHeader));
+        append(text.data(), text.size() * sizeof(wchar_t));
+        append(runs.data(), runs.size() * sizeof(Run));
+    }
+
+    header.attrCount = gsl::narrow<uint32_t>(attrs.size());
+    header.attrTableOffset = fileSize + chunk.size();
+    for (const auto& attr : attrs)
+    {
+        const auto record = TextAttributeRecord::Write(attr);
+        append(record.data(), record.size());
+    }
+    flush();
+
+    LARGE_INTEGER start{};
+    THROW_IF_WIN32_BOOL_FALSE(SetFilePointerEx(file.get(), start, nullptr, FILE_BEGIN));
+    DWORD written = 0;
+    THROW_IF_WIN32_BOOL_FALSE(WriteFile(file.get(), &header, sizeof(header), &written, nullptr));
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_WRITE_FAULT), written != sizeof(header));
+
+    file.reset();
+    THROW_IF_WIN32_BOOL_FALSE(MoveFileExW(tempPath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING));
+    removeTempFile.release();
+}
+
+// Routine Description:
+// - restores a session saved by Save into a buffer, replacing everything that was in it.
+// - the rows are copied straight out of a view of the file. if they were saved at the width
+//   of the buffer, they go right into its rows. otherwise they're restored at the width they
+//   had and reflowed into the buffer, just like a resize would.
+// - if there are more rows than the buffer holds, the ones at the top are left out, as though
+//   they had scrolled off.
+// Arguments:
+// - path - the path of the file the session was saved to
+// - buffer - the buffer to restore the session into
+// Return Value:
+// - where the cursor (which is moved there) and the top of the viewport are in the buffer now
+// Note: will throw exception if the file can't be read or isn't a saved session
+TextBufferSession::State TextBufferSession::Restore(const std::wstring_view path, TextBuffer& buffer)
+{
+    const std::wstring filePath{ path };
+    wil::unique_hfile file{ CreateFileW(filePath.c_str(),
+                                        GENERIC_READ,
+                                        FILE_SHARE_READ,
+                                        nullptr,
+                                        OPEN_EXISTING,
+                                        FILE_ATTRIBUTE_NORMAL,
+                                        nullptr) };
+    THROW_LAST_ERROR_IF(!file);
+
+    LARGE_INTEGER size;
+    THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(file.get(), &size));
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), size.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader)));
+
+    wil::unique_handle mapping{ CreateFileMappingW(file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr) };
+    THROW_LAST_ERROR_IF_NULL(mapping.get());
+    wil::unique_mapview_ptr<BYTE> view{ static_cast<BYTE*>(MapViewOfFile(mapping.get(), FILE_MAP_READ, 0, 0, 0)) };
+    THROW_LAST_ERROR_IF_NULL(view.get());
+
+    const BYTE* const begin = view.get();
+    const BYTE* const end = begin + gsl::narrow<size_t>(size.QuadPart);
+    const BYTE* data = begin;
+
+    FileHeader header;
+    memcpy(&header, _Take(data, end, sizeof(header)), sizeof(header));
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA),
+                header.magic != FileMagic ||
+                    header.version != FileVersion ||
+                    header.width == 0 ||
+                    header.width > SHRT_MAX ||
+                    header.attrTableOffset < sizeof(header) ||
+                    header.attrTableOffset > static_cast<uint64_t>(end - begin));
+
+    const BYTE* const rowsEnd = begin + header.attrTableOffset;
+    const BYTE* table = rowsEnd;
+    const auto tableSize = static_cast<size_t>(end - rowsEnd);
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), header.attrCount > tableSize / TextAttributeRecord::Size);
+    std::vector<TextAttribute> attrs;
+    attrs.reserve(header.attrCount);
+    for (uint32_t i = 0; i < header.attrCount; ++i)
+    {
+        attrs.push_back(TextAttributeRecord::Read(_Take(table, end, TextAttributeRecord::Size)));
+    }
+
+    std::vector<SavedRow> savedRows;
+    savedRows.reserve(std::min<size_t>(header.rowCount, (rowsEnd - data) / sizeof(RowHeader)));
+    for (uint32_t i = 0; i < header.rowCount; ++i)
+    {
+        RowHeader rowHeader;
+        memcpy(&rowHeader, _Take(data, rowsEnd, sizeof(rowHeader)), sizeof(rowHeader));
+        const auto text = _Take(data, rowsEnd, static_cast<size_t>(rowHeader.textLength) * sizeof(wchar_t));
+        const auto runs = _Take(data, rowsEnd, static_cast<size_t>(rowHeader.runCount) * sizeof(Run));
+        savedRows.push_back({ { reinterpret_cast<const wchar_t*>(text), rowHeader.textLength }, runs, rowHeader.runCount, rowHeader.flags });
+    }
+
+    const auto bufferSize = buffer.GetSize();
+    const SHORT savedWidth = gsl::narrow_cast<SHORT>(header.width);
+    const size_t capacity = savedWidth == bufferSize.Width() ? bufferSize.Height() : SHRT_MAX;
+    const size_t dropped = savedRows.size() > capacity ? savedRows.size() - capacity : 0;
+    const size_t kept = std::max<size_t>(savedRows.size() - dropped, 1);
+
+    const COORD savedCursor{ std::clamp<SHORT>(header.cursorX, 0, savedWidth - 1),
+                             gsl::narrow_cast<SHORT>(std::clamp<ptrdiff_t>(header.cursorY - static_cast<ptrdiff_t>(dropped), 0, kept - 1)) };
+    const SHORT savedViewportTop = gsl::narrow_cast<SHORT>(std::clamp<ptrdiff_t>(header.viewportTop - static_cast<ptrdiff_t>(dropped), 0, savedCursor.Y));
+
+    buffer.Reset();
+
+    if (savedWidth == bufferSize.Width())
+    {
+        for (size_t i = dropped; i < savedRows.size(); ++i)
+        {
+            _RestoreRow(savedRows.at(i), attrs, buffer.GetRowByOffset(i - dropped));
+        }
+        buffer.MarkRowsChanged(0, bufferSize.Height());
+        buffer.GetCursor().SetPosition(savedCursor);
+        return { savedCursor, savedViewportTop };
+    }
+
+    TextBuffer saved({ savedWidth, gsl::narrow<SHORT>(kept) },
+                     buffer.GetCurrentAttributes(),
+                     buffer.GetCursor().GetSize(),
+                     buffer.GetRenderTarget());
+    for (size_t i = dropped; i < savedRows.size(); ++i)
+    {
+        _RestoreRow(savedRows.at(i), attrs, saved.GetRowByOffset(i - dropped));
+    }
+    saved.GetCursor().SetPosition(savedCursor);
+
+    buffer.GetCursor().SetPosition({ 0, 0 });
+    THROW_IF_FAILED(TextBuffer::Reflow(saved, buffer));
+
+    // The viewport stays as far above the cursor as it was.
+    const auto cursorPosition = buffer.GetCursor().GetPosition();
+    const SHORT viewportTop = std::max<SHORT>(0, cursorPosition.Y - (savedCursor.Y - savedViewportTop));
+    return { cursorPosition, viewportTop };
+}
+
+// Routine Description:
+// - fills a row with the text, attributes and wrap state it was saved with
+// Arguments:
+// - saved - the row as it was found in the file
+// - attrs - the table of attributes the runs of the row point into
+// - row - the row to restore. it must be as wide as the saved row, and blank.
+// Note: will throw exception if the saved row doesn't fit the row
+void TextBufferSession::_RestoreRow(const SavedRow& saved, const std::vector<TextAttribute>& attrs, ROW& row)
+{
+    std::vector<TextAttributeRun> runs;
+    runs.reserve(saved.runCount);
+    size_t covered = 0;
+    for (uint16_t i = 0; i < saved.runCount; ++i)
+    {
+        Run run;
+        memcpy(&run, saved.runs + i * sizeof(Run), sizeof(run));
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), run.length == 0 || run.attrIndex >= attrs.size());
+        runs.emplace_back(run.length, attrs.at(run.attrIndex));
+        covered += run.length;
+    }
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), covered != row.size());
+
+    if (!saved.text.empty())
+    {
+        row.WriteCells(OutputCellIterator{ saved.text }, 0, false);
+    }
+    THROW_IF_FAILED(row.GetAttrRow().InsertAttrRuns({ runs.data(), runs.size() }, 0, row.size() - 1, row.size()));
+    row.GetCharRow().SetWrapForced(WI_IsFlagSet(saved.flags, WrapForcedFlag));
+}
+
+// Routine Description:
+// - steps over the given number of bytes of the mapped file
+// Arguments:
+// - data - where to take the bytes from. it's moved past them.
+// - end - the end of the part of the file they have to be in
+// - size - how many bytes to take
+// Return Value:
+// - pointer to the bytes taken
+// Note: will throw exception if there aren't that many bytes left
+const BYTE* TextBufferSession::_Take(const BYTE*& data, const BYTE* const end, const size_t size)
+{
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), static_cast<size_t>(end - data) < size);
+    const auto taken = data;
+    data += size;
+    return taken;
+}
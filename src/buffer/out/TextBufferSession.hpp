@@ -0,0 +1,88 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TextBufferSession.hpp
+
+Abstract:
+- saves the contents of a text buffer to a file and restores them later, e.g.
+  when a window comes back after a restart, without replaying any VT.
+- the file holds every row as its UTF-16 text (without trailing spaces) and its
+  attribute runs, the runs pointing into a table of the distinct attributes in
+  the buffer, followed by the cursor position and the top of the viewport.
+- the attributes in the table are TextAttributeRecords, which are checked field
+  by field as they're read, so a damaged file can't restore made up attributes.
+- rows are saved from a TextBufferSnapshot, so only the snapshot has to be taken
+  under the lock and the file can be written from any thread. they're restored
+  straight out of a mapped view of the file.
+--*/
+
+#pragma once
+
+#include "TextAttribute.hpp"
+
+class TextBuffer;
+class TextBufferSnapshot;
+class ROW;
+
+class TextBufferSession final
+{
+public:
+    struct State
+    {
+        COORD cursorPosition;
+        SHORT viewportTop;
+    };
+
+    static void Save(const std::wstring_view path, const TextBufferSnapshot& snapshot, const State state);
+    static State Restore(const std::wstring_view path, TextBuffer& buffer);
+
+private:
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t width;
+        uint32_t rowCount;
+        uint32_t attrCount;
+        uint64_t attrTableOffset; // where the table of attributes starts, after the rows
+        int16_t cursorX;
+        int16_t cursorY;
+        int16_t viewportTop;
+        uint16_t reserved;
+    };
+
+    struct RowHeader
+    {
+        uint32_t textLength; // wchar_ts of text following the header
+        uint16_t runCount; // runs following the text
+        uint8_t flags;
+        uint8_t reserved;
+    };
+
+    struct Run
+    {
+        uint32_t length;
+        uint32_t attrIndex; // index into the table of attributes
+    };
+
+    // A row as it's found in the mapped file.
+    struct SavedRow
+    {
+        std::wstring_view text;
+        const BYTE* runs;
+        uint16_t runCount;
+        uint8_t flags;
+    };
+
+    static constexpr uint32_t FileMagic = 0x53534254; // 'TBSS'
+    static constexpr uint16_t FileVersion = 2; // 1 stored the attributes as their raw bytes
+    static constexpr uint8_t WrapForcedFlag = 0x1;
+
+    // the rows are written out in pieces about this large, rather than all at once
+    static constexpr size_t WriteChunkSize = 1024 * 1024;
+
+    static void _RestoreRow(const SavedRow& saved, const std::vector<TextAttribute>& attrs, ROW& row);
+    static const BYTE* _Take(const BYTE*& data, const BYTE* const end, const size_t size);
+};
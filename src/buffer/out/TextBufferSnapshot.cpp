@@ -0,0 +1,236 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "TextBufferSnapshot.hpp"
+#include "Row.hpp"
+
+using namespace Microsoft::Console::Types;
+
+// Routine Description:
+// - constructor. copies everything needed to draw the given row.
+// Arguments:
+// - row - the row to copy. a compacted row is copied straight out of its packed form,
+//   without unpacking it, so any number of readers can copy rows at once.
+// Return Value:
+// - instantiated object
+// Note: will throw exception if unable to allocate memory
+TextBufferSnapshot::Row::Row(const ROW& row) :
+    _text{},
+    _offsets{},
+    _dbcsAttrs{},
+    _attrs{},
+    _wrapForced{ row.GetCharRow().WasWrapForced() },
+    _generation{ row.GetGeneration() },
+    _storageKey{ row.GetStorageKey() }
+{
+    const auto& charRow = row.GetCharRow();
+    const auto width = charRow.size();
+
+    _text.reserve(width);
+    _offsets.reserve(width + 1);
+    _dbcsAttrs.reserve(width);
+    for (size_t column = 0; column < width; ++column)
+    {
+        const std::wstring_view glyph = charRow.GlyphAt(column);
+        _offsets.push_back(_text.size());
+        _text.append(glyph);
+        _dbcsAttrs.push_back(charRow.DbcsAttrAt(column));
+    }
+    _offsets.push_back(_text.size());
+
+    const auto& attrRow = row.GetAttrRow();
+    for (size_t column = 0; column < width;)
+    {
+        size_t applies = 0;
+        const auto attr = attrRow.GetAttrByColumn(column, &applies);
+        applies = std::min(applies, width - column);
+        _attrs.emplace_back(applies, attr);
+        column += applies;
+    }
+}
+
+// Routine Description:
+// - gets the width of the row, in cells
+size_t TextBufferSnapshot::Row::size() const noexcept
+{
+    return _dbcsAttrs.size();
+}
+
+// Routine Description:
+// - gets the glyph of a cell
+// Arguments:
+// - column - the column of the cell
+// Return Value:
+// - the glyph. it's valid for as long as the row is.
+// Note: will throw exception if column is out of bounds
+std::wstring_view TextBufferSnapshot::Row::GlyphAt(const size_t column) const
+{
+    THROW_HR_IF(E_INVALIDARG, column >= size());
+    return std::wstring_view{ _text }.substr(_offsets[column], _offsets[column + 1] - _offsets[column]);
+}
+
+// Routine Description:
+// - gets the dbcs attribute of a cell
+// Arguments:
+// - column - the column of the cell
+// Return Value:
+// - the dbcs attribute
+// Note: will throw exception if column is out of bounds
+DbcsAttribute TextBufferSnapshot::Row::DbcsAttrAt(const size_t column) const
+{
+    return _dbcsAttrs.at(column);
+}
+
+// Routine Description:
+// - gets the text attribute of a cell
+// Arguments:
+// - column - the column of the cell
+// - pApplies - if given, receives how many cells from column on (including it) share the attribute
+// Return Value:
+// - the text attribute
+// Note: will throw exception if column is out of bounds
+TextAttribute TextBufferSnapshot::Row::GetAttrByColumn(const size_t column, size_t* const pApplies) const
+{
+    THROW_HR_IF(E_INVALIDARG, column >= size());
+
+    size_t runStart = 0;
+    for (const auto& run : _attrs)
+    {
+        if (column < runStart + run.GetLength())
+        {
+            if (pApplies)
+            {
+                *pApplies = runStart + run.GetLength() - column;
+            }
+            return run.GetAttributes();
+        }
+        runStart += run.GetLength();
+    }
+
+    // The runs always cover the whole row.
+    THROW_HR(E_UNEXPECTED);
+}
+
+// Routine Description:
+// - gets whether the row was wrapped onto the next one because it ran out of space
+bool TextBufferSnapshot::Row::WasWrapForced() const noexcept
+{
+    return _wrapForced;
+}
+
+// Routine Description:
+// - gets the text of the row as it would be shown on the screen. matches ROW::GetText.
+// Return Value:
+// - the text
+std::wstring TextBufferSnapshot::Row::GetText() const
+{
+    std::wstring text;
+    text.reserve(_text.size());
+    for (size_t column = 0; column < size(); ++column)
+    {
+        if (!_dbcsAttrs[column].IsTrailing())
+        {
+            text.append(GlyphAt(column));
+        }
+    }
+    return text;
+}
+
+// Routine Description:
+// - gets the generation the buffer row had when it was copied
+uint64_t TextBufferSnapshot::Row::GetGeneration() const noexcept
+{
+    return _generation;
+}
+
+// Routine Description:
+// - gets the storage key of the buffer row this was copied from, which identifies it as it moves around the buffer
+UnicodeStorage::row_key_type TextBufferSnapshot::Row::GetStorageKey() const noexcept
+{
+    return _storageKey;
+}
+
+// Routine Description:
+// - constructor
+// Arguments:
+// - rows - the rows of the buffer the snapshot covers
+// - generation - the generation of the buffer when the snapshot was taken
+// - snapshotRows - the copied rows, one for each row in rows
+// Return Value:
+// - instantiated object
+TextBufferSnapshot::TextBufferSnapshot(const Viewport& rows,
+                                       const uint64_t generation,
+                                       std::vector<std::shared_ptr<const Row>> snapshotRows) noexcept :
+    _rows{ rows },
+    _generation{ generation },
+    _snapshotRows{ std::move(snapshotRows) }
+{
+}
+
+// Routine Description:
+// - gets the rows of the buffer the snapshot covers
+// Return Value:
+// - the rows, in buffer coordinates, at the full width of the buffer
+const Viewport& TextBufferSnapshot::GetRows() const noexcept
+{
+    return _rows;
+}
+
+// Routine Description:
+// - gets one of the copied rows
+// Arguments:
+// - y - the row, in buffer coordinates
+// Return Value:
+// - the copy of the row
+// Note: will throw exception if y isn't one of the rows covered by the snapshot
+const TextBufferSnapshot::Row& TextBufferSnapshot::GetRow(const SHORT y) const
+{
+    return *ShareRow(y);
+}
+
+// Routine Description:
+// - gets one of the copied rows, to keep beyond the lifetime of the snapshot
+// Arguments:
+// - y - the row, in buffer coordinates
+// Return Value:
+// - the copy of the row
+// Note: will throw exception if y isn't one of the rows covered by the snapshot
+std::shared_ptr<const TextBufferSnapshot::Row> TextBufferSnapshot::ShareRow(const SHORT y) const
+{
+    THROW_HR_IF(E_INVALIDARG, y < _rows.Top() || y > _rows.BottomInclusive());
+    return _snapshotRows.at(static_cast<size_t>(y - _rows.Top()));
+}
+
+// Routine Description:
+// - looks for a copy of the given buffer row that's still up to date, so that it can be shared
+//   instead of copied again. the row may have moved to a different position since the copy was made.
+// Arguments:
+// - row - the buffer row
+// - hint - index of the copied row to start looking at. updated to the index after the match.
+//          rows move together as output scrolls, so the next match is usually right there.
+// Return Value:
+// - the copy of the row, or nullptr if none of the copies matches it anymore
+std::shared_ptr<const TextBufferSnapshot::Row> TextBufferSnapshot::FindUnchangedRow(const ROW& row, size_t& hint) const noexcept
+{
+    const auto count = _snapshotRows.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto index = (hint + i) % count;
+        const auto& copy = _snapshotRows[index];
+        if (copy->GetStorageKey() == row.GetStorageKey() && copy->GetGeneration() == row.GetGeneration())
+        {
+            hint = index + 1;
+            return copy;
+        }
+    }
+    return nullptr;
+}
+
+// Routine Description:
+// - gets the generation of the buffer when the snapshot was taken
+uint64_t TextBufferSnapshot::GetGeneration() const noexcept
+{
+    return _generation;
+}
@@ -0,0 +1,76 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TextBufferSnapshot.hpp
+
+Abstract:
+- read only copy of a range of rows of a text buffer, for painting or reading
+  the buffer without holding the console lock the whole time.
+- a snapshot only has to be taken under the lock. after that it can be read
+  from any thread while the buffer keeps changing.
+- each row of a snapshot is reference counted and remembers the generation the
+  buffer row had when it was copied. taking a snapshot with the previous one at
+  hand shares the rows that haven't changed since, so only changed rows are copied.
+--*/
+
+#pragma once
+
+#include "DbcsAttribute.hpp"
+#include "TextAttributeRun.hpp"
+#include "UnicodeStorage.hpp"
+#include "../types/inc/Viewport.hpp"
+
+class ROW;
+
+class TextBufferSnapshot final
+{
+public:
+    class Row final
+    {
+    public:
+        Row(const ROW& row);
+
+        size_t size() const noexcept;
+
+        std::wstring_view GlyphAt(const size_t column) const;
+        DbcsAttribute DbcsAttrAt(const size_t column) const;
+        TextAttribute GetAttrByColumn(const size_t column, size_t* const pApplies = nullptr) const;
+        bool WasWrapForced() const noexcept;
+
+        std::wstring GetText() const;
+
+        uint64_t GetGeneration() const noexcept;
+        UnicodeStorage::row_key_type GetStorageKey() const noexcept;
+
+    private:
+        // the glyphs of all of the cells, back to back.
+        // cell i spans _text[_offsets[i]] up to _text[_offsets[i + 1]].
+        std::wstring _text;
+        std::vector<size_t> _offsets;
+        std::vector<DbcsAttribute> _dbcsAttrs;
+        std::vector<TextAttributeRun> _attrs;
+        bool _wrapForced;
+
+        uint64_t _generation;
+        UnicodeStorage::row_key_type _storageKey;
+    };
+
+    TextBufferSnapshot(const Microsoft::Console::Types::Viewport& rows,
+                       const uint64_t generation,
+                       std::vector<std::shared_ptr<const Row>> snapshotRows) noexcept;
+
+    const Microsoft::Console::Types::Viewport& GetRows() const noexcept;
+    const Row& GetRow(const SHORT y) const;
+    std::shared_ptr<const Row> ShareRow(const SHORT y) const;
+    std::shared_ptr<const Row> FindUnchangedRow(const ROW& row, size_t& hint) const noexcept;
+
+    uint64_t GetGeneration() const noexcept;
+
+private:
+    // the rows this is a copy of, in buffer coordinates. every row is copied at its full width.
+    Microsoft::Console::Types::Viewport _rows;
+    uint64_t _generation;
+    std::vector<std::shared_ptr<const Row>> _snapshotRows;
+};
@@ -115,6 +115,9 @@ private:
 
     COLORREF _GetRGB() const;
 
+    friend struct std::hash<TextColor>;
+    friend class TextAttributeRecord;
+
 #ifdef UNIT_TESTING
     friend class TextBufferTests;
     template<typename TextColor>
@@ -137,6 +140,27 @@ bool constexpr operator!=(const TextColor& a, const TextColor& b) noexcept
     return !(a == b);
 }
 
+namespace std
+{
+    template<>
+    struct hash<TextColor>
+    {
+        // Routine Description:
+        // - hashes a TextColor by packing its type and color bytes into a size_t.
+        // Arguments:
+        // - color - the color to hash
+        // Return Value:
+        // - the hashed color
+        constexpr size_t operator()(const TextColor& color) const noexcept
+        {
+            return static_cast<size_t>(color._meta) << 24 |
+                   static_cast<size_t>(color._red) << 16 |
+                   static_cast<size_t>(color._green) << 8 |
+                   static_cast<size_t>(color._blue);
+        }
+    };
+}
+
 #ifdef UNIT_TESTING
 
 namespace WEX
@@ -4,9 +4,26 @@
 #include "precomp.h"
 #include "UnicodeStorage.hpp"
 
+static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
 UnicodeStorage::UnicodeStorage() :
-    _map{}
+    _slots{},
+    _count{ 0 },
+    _chunks{},
+    _freeChunks{},
+    _currentChunk{ NoChunk },
+    _nextRowKey{ 0 }
+{
+}
+
+// Routine Description:
+// - hands out a new key for a row to store its glyphs under.
+// - the key belongs to the row for as long as it lives, no matter where in the buffer it moves.
+// Return Value:
+// - a row key that isn't used by any other row
+UnicodeStorage::row_key_type UnicodeStorage::CreateRowKey() noexcept
 {
+    return _nextRowKey++;
 }
 
 // Routine Description:
@@ -14,21 +31,69 @@ UnicodeStorage::UnicodeStorage() :
 // Arguments:
 // - key - the key into the storage
 // Return Value:
-// - the glyph data associated with key
+// - the glyph data associated with key. It's valid until the glyph for key is replaced or erased.
+//   Storing or erasing other glyphs doesn't move it.
 // Note: will throw exception if key is not stored yet
-const UnicodeStorage::mapped_type& UnicodeStorage::GetText(const key_type key) const
+std::wstring_view UnicodeStorage::GetText(const key_type key) const
 {
-    return _map.at(key);
+    const auto index = _Find(_Pack(key));
+    THROW_HR_IF(E_INVALIDARG, index == npos);
+
+    const auto& slot = _slots[index];
+    return { _chunks[slot.chunk].text.get() + slot.offset, slot.length };
 }
 
 // Routine Description:
 // - stores glyph data associated with key.
 // Arguments:
 // - key - the key into the storage
-// - glyph - the glyph data to store
-void UnicodeStorage::StoreGlyph(const key_type key, const mapped_type& glyph)
+// - glyph - the glyph data to store. it may be a view of a glyph stored here, even the one being replaced.
+void UnicodeStorage::StoreGlyph(const key_type key, const std::wstring_view glyph)
 {
-    _map.insert_or_assign(key, glyph);
+    THROW_HR_IF(E_INVALIDARG, glyph.empty());
+    THROW_HR_IF(E_OUTOFMEMORY, glyph.size() > std::numeric_limits<uint32_t>::max());
+
+    const auto packedKey = _Pack(key);
+    auto index = _Find(packedKey);
+
+    // If we're replacing a glyph with one that fits where it was, just overwrite it.
+    // The new glyph may be part of the old one, so the text is moved rather than copied.
+    if (index != npos && glyph.size() <= _slots[index].length)
+    {
+        auto& slot = _slots[index];
+        std::char_traits<wchar_t>::move(_chunks[slot.chunk].text.get() + slot.offset, glyph.data(), glyph.size());
+        _chunks[slot.chunk].live -= slot.length - glyph.size();
+        slot.length = gsl::narrow_cast<uint32_t>(glyph.size());
+        return;
+    }
+
+    if (index == npos && (_count + 1) * 2 > _slots.size())
+    {
+        _Grow();
+    }
+
+    // The glyph is added before the one it replaces is let go of, in case it's a view of that one.
+    const auto [chunk, offset] = _Append(glyph);
+
+    if (index != npos)
+    {
+        _Release(_slots[index].chunk, _slots[index].length);
+    }
+    else
+    {
+        const auto mask = _slots.size() - 1;
+        index = _Home(packedKey);
+        while (_slots[index].key != EmptySlot)
+        {
+            index = (index + 1) & mask;
+        }
+        _slots[index].key = packedKey;
+        ++_count;
+    }
+
+    _slots[index].chunk = chunk;
+    _slots[index].offset = offset;
+    _slots[index].length = gsl::narrow_cast<uint32_t>(glyph.size());
 }
 
 // Routine Description:
@@ -37,62 +102,266 @@ void UnicodeStorage::StoreGlyph(const key_type key, const mapped_type& glyph)
 // - key - the key to remove
 void UnicodeStorage::Erase(const key_type key) noexcept
 {
-    _map.erase(key);
+    const auto index = _Find(_Pack(key));
+    if (index != npos)
+    {
+        _EraseSlot(index);
+    }
+}
+
+// Routine Description:
+// - erases all of the glyphs stored by the given rows (e.g. because the rows were removed from the buffer)
+// Arguments:
+// - rows - the keys of the rows to remove
+void UnicodeStorage::EraseRows(std::vector<row_key_type> rows) noexcept
+{
+    if (rows.empty() || _count == 0)
+    {
+        return;
+    }
+
+    std::sort(rows.begin(), rows.end());
+
+    // Erasing shifts later entries of a probe sequence back into the erased slot,
+    // so look at the same slot again after erasing from it.
+    for (size_t index = 0; index < _slots.size();)
+    {
+        const auto packedKey = _slots[index].key;
+        if (packedKey != EmptySlot &&
+            std::binary_search(rows.cbegin(), rows.cend(), gsl::narrow_cast<row_key_type>(packedKey >> 16)))
+        {
+            _EraseSlot(index);
+        }
+        else
+        {
+            ++index;
+        }
+    }
+}
+
+// Routine Description:
+// - erases all of the glyphs stored at or beyond the given column (e.g. because the buffer got narrower)
+// Arguments:
+// - firstColumn - the first column to remove glyphs from
+void UnicodeStorage::EraseColumns(const SHORT firstColumn) noexcept
+{
+    for (size_t index = 0; index < _slots.size() && _count > 0;)
+    {
+        const auto packedKey = _slots[index].key;
+        if (packedKey != EmptySlot && static_cast<SHORT>(packedKey & 0xFFFF) >= firstColumn)
+        {
+            _EraseSlot(index);
+        }
+        else
+        {
+            ++index;
+        }
+    }
+}
+
+// Routine Description:
+// - reports how many glyphs are stored
+// Return Value:
+// - count of stored glyphs
+size_t UnicodeStorage::size() const noexcept
+{
+    return _count;
+}
+
+// Routine Description:
+// - reports how many bytes of heap storage are held for the slots and the glyphs
+// Return Value:
+// - the bytes held, including the space of replaced or erased glyphs in chunks that are still in use
+size_t UnicodeStorage::GetMemoryUsage() const noexcept
+{
+    size_t usage = _slots.capacity() * sizeof(Slot) +
+                   _chunks.capacity() * sizeof(Chunk) +
+                   _freeChunks.capacity() * sizeof(uint32_t);
+    for (const auto& chunk : _chunks)
+    {
+        usage += chunk.capacity * sizeof(wchar_t);
+    }
+    return usage;
+}
+
+// Routine Description:
+// - reports whether there are any glyphs stored
+// Return Value:
+// - true if nothing is stored
+bool UnicodeStorage::empty() const noexcept
+{
+    return _count == 0;
+}
+
+// Routine Description:
+// - packs a key into the single integer stored in a slot
+// Arguments:
+// - key - the key to pack
+// Return Value:
+// - the row key in the upper bits and the column in the lower 16 bits
+constexpr uint64_t UnicodeStorage::_Pack(const key_type key) noexcept
+{
+    return static_cast<uint64_t>(key.row) << 16 | static_cast<uint16_t>(key.column);
 }
 
 // Routine Description:
-// - Remaps all of the stored items to new coordinate positions
-//   based on a bulk rearrangement of row IDs and potential row width resize.
+// - finds the slot the search for a key starts at
 // Arguments:
-// - rowMap - A map of the old row IDs to the new row IDs.
-// - width - The width of the new row. Remove any items that are beyond the row width.
-//         - Use nullopt if we're not resizing the width of the row, just renumbering the rows.
-void UnicodeStorage::Remap(const std::map<SHORT, SHORT>& rowMap, const std::optional<SHORT> width)
+// - packedKey - the packed key
+// Return Value:
+// - the index of the first slot to probe
+size_t UnicodeStorage::_Home(const uint64_t packedKey) const noexcept
 {
-    // Make a temporary map to hold all the new row positioning
-    std::unordered_map<key_type, mapped_type> newMap;
+    // Fibonacci hashing spreads out the keys of neighboring cells and rows.
+    return static_cast<size_t>((packedKey * 0x9E3779B97F4A7C15ull) >> 32) & (_slots.size() - 1);
+}
 
-    // Walk through every stored item.
-    for (const auto& pair : _map)
+// Routine Description:
+// - finds the slot holding a key
+// Arguments:
+// - packedKey - the packed key to look for
+// Return Value:
+// - the index of the slot or npos if the key isn't stored
+size_t UnicodeStorage::_Find(const uint64_t packedKey) const noexcept
+{
+    if (_count == 0)
+    {
+        return npos;
+    }
+
+    const auto mask = _slots.size() - 1;
+    for (auto index = _Home(packedKey);; index = (index + 1) & mask)
     {
-        // Extract the old coordinate position
-        const auto oldCoord = pair.first;
+        const auto key = _slots[index].key;
+        if (key == packedKey)
+        {
+            return index;
+        }
+        if (key == EmptySlot)
+        {
+            return npos;
+        }
+    }
+}
+
+// Routine Description:
+// - empties a slot and shifts back any later entries of the same probe sequence
+//   so that lookups never stop early at the hole we just left.
+// Arguments:
+// - index - the slot to empty
+void UnicodeStorage::_EraseSlot(size_t index) noexcept
+{
+    const auto mask = _slots.size() - 1;
 
-        // Only try to short-circuit based on width if we were told it changed
-        // by being given a new width value.
-        if (width.has_value())
+    _Release(_slots[index].chunk, _slots[index].length);
+    _slots[index].key = EmptySlot;
+    --_count;
+
+    for (auto next = (index + 1) & mask; _slots[next].key != EmptySlot; next = (next + 1) & mask)
+    {
+        // An entry can fill the hole only if its home slot isn't (cyclically) between the hole and itself.
+        const auto home = _Home(_slots[next].key);
+        const bool homeBetween = index <= next ? (index < home && home <= next) : (index < home || home <= next);
+        if (!homeBetween)
         {
-            // Get the column ID
-            const auto oldColId = oldCoord.X;
+            _slots[index] = _slots[next];
+            _slots[next].key = EmptySlot;
+            index = next;
+        }
+    }
+}
+
+// Routine Description:
+// - doubles the number of slots and rehashes every stored key into them
+void UnicodeStorage::_Grow()
+{
+    std::vector<Slot> slots(std::max(MinimumCapacity, _slots.size() * 2), Slot{ EmptySlot, NoChunk, 0, 0 });
+    _slots.swap(slots);
 
-            // If the column index is at/beyond the row width, don't bother copying it to the new map.
-            if (oldColId >= width.value())
+    const auto mask = _slots.size() - 1;
+    for (const auto& slot : slots)
+    {
+        if (slot.key != EmptySlot)
+        {
+            auto index = _Home(slot.key);
+            while (_slots[index].key != EmptySlot)
             {
-                continue;
+                index = (index + 1) & mask;
             }
+            _slots[index] = slot;
         }
+    }
+}
 
-        // Get the row ID from the position as that's what we need to remap
-        const auto oldRowId = oldCoord.Y;
-
-        // Use the mapping given to convert the old row ID to the new row ID
-        const auto mapIter = rowMap.find(oldRowId);
+// Routine Description:
+// - adds the text of a glyph to the end of the current chunk, starting a new chunk if it doesn't fit.
+// - nothing that's already stored moves, so the glyph may be a view of stored text.
+// Arguments:
+// - glyph - the text to add
+// Return Value:
+// - the chunk the text went in and where in it it starts
+std::pair<uint32_t, uint32_t> UnicodeStorage::_Append(const std::wstring_view glyph)
+{
+    if (_currentChunk == NoChunk || _chunks[_currentChunk].capacity - _chunks[_currentChunk].used < glyph.size())
+    {
+        // Make sure there's somewhere to note the chunk down before taking it, so that nothing leaks if that throws.
+        _freeChunks.reserve(_chunks.size() + 1);
 
-        // If there's no mapping to a new row, don't bother copying it to the new map. The row is gone.
-        if (mapIter == rowMap.end())
+        auto index = NoChunk;
+        if (!_freeChunks.empty())
+        {
+            index = _freeChunks.back();
+        }
+        else
         {
-            continue;
+            _chunks.push_back({ nullptr, 0, 0, 0 });
+            index = gsl::narrow<uint32_t>(_chunks.size() - 1);
+            _freeChunks.push_back(index);
         }
 
-        const auto newRowId = mapIter->second;
+        const auto capacity = std::max(ChunkSize, glyph.size());
+        _chunks[index].text = std::make_unique<wchar_t[]>(capacity);
+        _chunks[index].capacity = capacity;
+        _freeChunks.pop_back();
 
-        // Generate a new coordinate with the same X as the old one, but a new Y value.
-        const auto newCoord = COORD{ oldCoord.X, newRowId };
+        // The chunk we were adding to stays until the last of its glyphs goes away.
+        const auto previous = _currentChunk;
+        _currentChunk = index;
+        if (previous != NoChunk && _chunks[previous].live == 0)
+        {
+            _Release(previous, 0);
+        }
+    }
 
-        // Put the adjusted coordinate into the map with the original value.
-        newMap.emplace(newCoord, pair.second);
+    auto& chunk = _chunks[_currentChunk];
+    const auto offset = gsl::narrow_cast<uint32_t>(chunk.used);
+    std::copy(glyph.cbegin(), glyph.cend(), chunk.text.get() + chunk.used);
+    chunk.used += glyph.size();
+    chunk.live += glyph.size();
+    return { _currentChunk, offset };
+}
+
+// Routine Description:
+// - notes that a glyph in a chunk isn't used anymore, and lets go of the chunk if it was the last one in it.
+//   the chunk that's being added to is kept and just starts over from its beginning.
+// Arguments:
+// - chunk - the chunk the glyph was in
+// - length - the length of the glyph
+void UnicodeStorage::_Release(const uint32_t chunk, const size_t length) noexcept
+{
+    auto& entry = _chunks[chunk];
+    entry.live -= length;
+    if (entry.live != 0)
+    {
+        return;
     }
 
-    // Swap into the stored map, free the temporary when we exit.
-    _map.swap(newMap);
+    entry.used = 0;
+    if (chunk != _currentChunk)
+    {
+        entry.text.reset();
+        entry.capacity = 0;
+        // _Append reserved room for every chunk, so this can't throw.
+        _freeChunks.push_back(chunk);
+    }
 }
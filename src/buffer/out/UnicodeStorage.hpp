@@ -7,6 +7,13 @@ Module Name:
 
 Abstract:
 - dynamic storage location for glyphs that can't normally fit in the output buffer
+- glyphs are keyed by the storage key of the row that owns them (which stays with the row
+  no matter where it moves within the buffer) and their column.
+- the keys live in a flat open addressing table and the glyph text is packed into fixed size
+  chunks, so storing a glyph doesn't allocate once the table and chunks have grown to fit.
+- glyph text never moves once it's stored. a chunk is only let go of once none of the glyphs
+  in it are stored anymore, so the view GetText returns for a glyph stays valid until that
+  glyph is replaced or erased, no matter what else is stored (even a glyph read out of here).
 
 Author(s):
 - Austin Diviness (AustDi) 02-May-2018
@@ -15,50 +22,76 @@ Author(s):
 #pragma once
 
 #include <vector>
-#include <unordered_map>
 #include <climits>
-
-// std::unordered_map needs help to know how to hash a COORD
-namespace std
-{
-    template<>
-    struct hash<COORD>
-    {
-        // Routine Description:
-        // - hashes a coord. coord will be hashed by storing the x and y values consecutively in the lower
-        // bits of a size_t.
-        // Arguments:
-        // - coord - the coord to hash
-        // Return Value:
-        // - the hashed coord
-        constexpr size_t operator()(const COORD& coord) const noexcept
-        {
-            size_t retVal = coord.Y;
-            const size_t xCoord = coord.X;
-            retVal |= xCoord << (sizeof(coord.Y) * CHAR_BIT);
-            return retVal;
-        }
-    };
-}
+#include <memory>
 
 class UnicodeStorage final
 {
 public:
-    using key_type = typename COORD;
-    using mapped_type = typename std::vector<wchar_t>;
+    using row_key_type = uint32_t;
+
+    struct key_type
+    {
+        SHORT column;
+        row_key_type row;
+    };
 
     UnicodeStorage();
 
-    const mapped_type& GetText(const key_type key) const;
+    row_key_type CreateRowKey() noexcept;
+
+    std::wstring_view GetText(const key_type key) const;
 
-    void StoreGlyph(const key_type key, const mapped_type& glyph);
+    void StoreGlyph(const key_type key, const std::wstring_view glyph);
 
     void Erase(const key_type key) noexcept;
 
-    void Remap(const std::map<SHORT, SHORT>& rowMap, const std::optional<SHORT> width);
+    void EraseRows(std::vector<row_key_type> rows) noexcept;
+    void EraseColumns(const SHORT firstColumn) noexcept;
+
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
 
 private:
-    std::unordered_map<key_type, mapped_type> _map;
+    static constexpr uint64_t EmptySlot = std::numeric_limits<uint64_t>::max();
+    static constexpr size_t MinimumCapacity = 16;
+    static constexpr size_t ChunkSize = 4096; // in wchar_ts. a longer glyph gets a chunk of its own.
+    static constexpr uint32_t NoChunk = std::numeric_limits<uint32_t>::max();
+
+    struct Slot
+    {
+        uint64_t key;
+        uint32_t chunk; // which of _chunks the glyph is in
+        uint32_t offset; // where the glyph starts in its chunk
+        uint32_t length; // how many wchar_ts the glyph spans
+    };
+
+    struct Chunk
+    {
+        std::unique_ptr<wchar_t[]> text;
+        size_t capacity;
+        size_t used; // glyphs are only ever added at the end
+        size_t live; // wchar_ts still used by a slot. the chunk is let go of when it gets to 0.
+    };
+
+    // capacity of _slots is always a power of two so we can mask instead of mod
+    std::vector<Slot> _slots;
+    size_t _count;
+
+    std::vector<Chunk> _chunks;
+    std::vector<uint32_t> _freeChunks; // chunks that were let go of, to be used again
+    uint32_t _currentChunk; // the chunk new glyphs are added to, or NoChunk
+
+    row_key_type _nextRowKey;
+
+    static constexpr uint64_t _Pack(const key_type key) noexcept;
+    size_t _Home(const uint64_t packedKey) const noexcept;
+    size_t _Find(const uint64_t packedKey) const noexcept;
+    void _EraseSlot(size_t index) noexcept;
+    void _Grow();
+    std::pair<uint32_t, uint32_t> _Append(const std::wstring_view glyph);
+    void _Release(const uint32_t chunk, const size_t length) noexcept;
 
 #ifdef UNIT_TESTING
     friend class UnicodeStorageTests;
@@ -168,7 +168,13 @@ void Cursor::_RedrawCursor() noexcept
     {
         if (_fDeferCursorRedraw)
         {
-            _fHaveDeferredCursorRedraw = true;
+            // The cell the cursor was drawn in when deferring started still needs
+            //      to be cleared. Of the ones after it, only the last one is drawn.
+            if (!_fHaveDeferredCursorRedraw)
+            {
+                _fHaveDeferredCursorRedraw = true;
+                _RedrawCursorAlways();
+            }
         }
         else
         {
@@ -310,19 +316,20 @@ bool Cursor::IsDelayedEOLWrap() const
     return _fDelayedEolWrap;
 }
 
-void Cursor::StartDeferDrawing()
+void Cursor::StartDeferDrawing() noexcept
 {
     _fDeferCursorRedraw = true;
 }
 
-void Cursor::EndDeferDrawing()
+void Cursor::EndDeferDrawing() noexcept
 {
     if (_fHaveDeferredCursorRedraw)
     {
         _RedrawCursorAlways();
     }
 
-    _fDeferCursorRedraw = FALSE;
+    _fDeferCursorRedraw = false;
+    _fHaveDeferredCursorRedraw = false;
 }
 
 const CursorType Cursor::GetType() const
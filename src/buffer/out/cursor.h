@@ -54,8 +54,8 @@ public:
     const bool IsUsingColor() const;
     const COLORREF GetColor() const;
 
-    void StartDeferDrawing();
-    void EndDeferDrawing();
+    void StartDeferDrawing() noexcept;
+    void EndDeferDrawing() noexcept;
 
     void SetHasMoved(const bool fHasMoved);
     void SetIsVisible(const bool fIsVisible);
@@ -7,11 +7,15 @@
 #include "CharRow.hpp"
 
 #include "../types/inc/convert.hpp"
+#include "../types/inc/AllocationTracking.hpp"
 
 #pragma hdrstop
 
 using namespace Microsoft::Console::Types;
 
+// The id of the next buffer to be made. 0 is never handed out.
+static std::atomic<uint64_t> s_nextId{ 1 };
+
 // Routine Description:
 // - Creates a new instance of TextBuffer
 // Arguments:
@@ -31,12 +35,26 @@ TextBuffer::TextBuffer(const COORD screenBufferSize,
     _cursor{ cursorSize, *this },
     _storage{},
     _unicodeStorage{},
+    _attributeTable{ std::make_shared<TextAttributeTable>() },
+    _rowStoragePool{},
+    _generation{ 0 },
+    _scrollbackArchive{},
+    _pagedInRows{ 0 },
+    _pagedInGeneration{ 0 },
+    _circledRowCount{ 0 },
+    _marks{},
+    _id{ s_nextId.fetch_add(1, std::memory_order_relaxed) },
     _renderTarget{ renderTarget }
 {
-    // initialize ROWs
+    // Reserve the full height up front. ROWs hand out pointers to themselves to their CharRows,
+    // so the storage must not reallocate while we're building it.
+    _storage.reserve(static_cast<size_t>(screenBufferSize.Y));
+
+    // initialize ROWs. They start out packed, so that only the rows that get looked at or written to
+    // are given full width cells. The rest of a tall buffer costs little more than the ROWs themselves.
     for (size_t i = 0; i < static_cast<size_t>(screenBufferSize.Y); ++i)
     {
-        _storage.emplace_back(static_cast<SHORT>(i), screenBufferSize.X, _currentAttributes, this);
+        _storage.emplace_back(static_cast<SHORT>(i), screenBufferSize.X, _currentAttributes, this, true);
     }
 }
 
@@ -70,13 +88,12 @@ UINT TextBuffer::TotalRowCount() const
 // - Number of rows down from the first row of the buffer.
 // Return Value:
 // - const reference to the requested row. Asserts if out of bounds.
+// Note:
+// - A row that was packed down stays packed: its cells are read from the packed form, so
+//   that any number of readers holding a shared lock can look at the buffer at once.
 const ROW& TextBuffer::GetRowByOffset(const size_t index) const
 {
-    const size_t totalRows = TotalRowCount();
-
-    // Rows are stored circularly, so the index you ask for is offset by the start position and mod the total of rows.
-    const size_t offsetIndex = (_firstRow + index) % totalRows;
-    return _storage[offsetIndex];
+    return _storage[_GetStorageIndex(index)];
 }
 
 // Routine Description:
@@ -86,9 +103,18 @@ const ROW& TextBuffer::GetRowByOffset(const size_t index) const
 // - Number of rows down from the first row of the buffer.
 // Return Value:
 // - reference to the requested row. Asserts if out of bounds.
+// Note:
+// - Rows that scrolled far away from the cursor may have been packed down. Since the caller
+//   may write to the row, it's unpacked here. Only callers that own the buffer exclusively
+//   (holding the write lock) can get here; readers get the const row above.
 ROW& TextBuffer::GetRowByOffset(const size_t index)
 {
-    return const_cast<ROW&>(static_cast<const TextBuffer*>(this)->GetRowByOffset(index));
+    ROW& row = _storage[_GetStorageIndex(index)];
+    if (row.IsCompacted())
+    {
+        row.Expand();
+    }
+    return row;
 }
 
 // Routine Description:
@@ -246,6 +272,8 @@ bool TextBuffer::_AssertValidDoubleByteSequence(const DbcsAttribute dbcsAttribut
             LOG_HR(wil::ResultFromCaughtException());
             return false;
         }
+        // The cell can be on the row above the one being written to, which won't be marked otherwise.
+        MarkRowsChanged(coordPrevPosition.Y, 1);
 
         // Sequence is now N N or N L, which are both okay. Set sequence back to valid.
         fValidSequence = true;
@@ -283,6 +311,7 @@ bool TextBuffer::_PrepareForDoubleByteSequence(const DbcsAttribute dbcsAttribute
             // set that we're wrapping for double byte reasons
             CharRow& charRow = GetRowByOffset(GetCursor().GetPosition().Y).GetCharRow();
             charRow.SetDoubleBytePadded(true);
+            MarkRowsChanged(GetCursor().GetPosition().Y, 1);
 
             // then move the cursor forward and onto the next row
             fSuccess = IncrementCursor();
@@ -317,6 +346,8 @@ OutputCellIterator TextBuffer::Write(const OutputCellIterator givenIt)
 OutputCellIterator TextBuffer::Write(const OutputCellIterator givenIt,
                                      const COORD target)
 {
+    const AllocationScope allocationScope{ AllocationTag::BufferOut };
+
     // Make mutable copy so we can walk.
     auto it = givenIt;
 
@@ -354,6 +385,8 @@ OutputCellIterator TextBuffer::WriteLine(const OutputCellIterator givenIt,
                                          const bool setWrap,
                                          std::optional<size_t> limitRight)
 {
+    const AllocationScope allocationScope{ AllocationTag::BufferOut };
+
     // If we're not in bounds, exit early.
     if (!GetSize().IsInBounds(target))
     {
@@ -385,6 +418,8 @@ bool TextBuffer::InsertCharacter(const std::wstring_view chars,
                                  const DbcsAttribute dbcsAttribute,
                                  const TextAttribute attr)
 {
+    const AllocationScope allocationScope{ AllocationTag::BufferOut };
+
     // Ensure consistent buffer state for double byte characters based on the character type we're about to insert
     bool fSuccess = _PrepareForDoubleByteSequence(dbcsAttribute);
 
@@ -416,6 +451,8 @@ bool TextBuffer::InsertCharacter(const std::wstring_view chars,
         fSuccess = Row.GetAttrRow().SetAttrToEnd(iCol, attr);
         if (fSuccess)
         {
+            MarkRowsChanged(iRow, 1);
+
             // Advance the cursor
             fSuccess = IncrementCursor();
         }
@@ -437,6 +474,227 @@ bool TextBuffer::InsertCharacter(const wchar_t wch, const DbcsAttribute dbcsAttr
     return InsertCharacter({ &wch, 1 }, dbcsAttribute, attr);
 }
 
+//Routine Description:
+// - Inserts a run of text that shares one attribute at the current cursor position and advances the cursor past it,
+//   wrapping onto new rows (and circling the buffer) as needed.
+// - The result is the same as inserting each glyph with InsertCharacter, but each row the run touches
+//   is written, colored and repainted once rather than once per cell.
+// - A cell left blank because a wide glyph didn't fit at the end of a row takes the color of the run.
+//Arguments:
+// - text - The UTF-16 text to insert. The width of each glyph is measured as it's written.
+// - attr - Color data associated with the text
+//Return Value:
+// - true if we successfully inserted the text
+// - false otherwise (out of memory)
+bool TextBuffer::InsertRun(const std::wstring_view text, const TextAttribute attr)
+{
+    const auto finalColumn = GetSize().RightInclusive();
+
+    try
+    {
+        OutputCellIterator it{ text };
+        while (it)
+        {
+            const auto target = GetCursor().GetPosition();
+            ROW& row = GetRowByOffset(target.Y);
+
+            // Write as much as fits on the cursor's row. A wide glyph that would only get
+            // its leading half onto the row is left for the next one, and the last cell padded.
+            auto newIt = row.WriteCells(it, target.X, true);
+            const auto written = gsl::narrow<SHORT>(newIt.GetCellDistance(it));
+            if (!row.GetAttrRow().SetAttrToEnd(target.X, attr))
+            {
+                return false;
+            }
+            _NotifyPaint(Viewport::FromDimensions(target, { gsl::narrow<SHORT>(finalColumn - target.X + 1), 1 }));
+
+            // A row only one cell wide can never hold a wide glyph. Drop it rather than padding forever.
+            it = written == 0 && target.X == 0 ? ++newIt : newIt;
+
+            // If there's text left over, this row is done. Otherwise the cursor stops right after the run.
+            const auto column = it ? finalColumn + 1 : target.X + written;
+            if (column > finalColumn)
+            {
+                if (!NewlineCursor())
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                GetCursor().SetXPosition(column);
+            }
+        }
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return false;
+    }
+
+    return true;
+}
+
+// Routine Description:
+// - Fills a rectangle of the buffer with one character and color, like erasing does.
+// - Each row is filled in one go instead of cell by cell. Rows that are blanked from edge
+//   to edge are reset outright, and the whole rectangle is repainted with one notification.
+// Arguments:
+// - rect - The area to fill. Anything outside of the buffer is ignored.
+// - wch - The character to fill with
+// - attr - Color data to fill with
+// Return Value:
+// - <none>
+// Note: will throw exception if a row can't be filled
+void TextBuffer::FillRect(const Viewport& rect, const wchar_t wch, const TextAttribute attr)
+{
+    const auto fill = Viewport::Intersect(GetSize(), rect);
+    if (!fill.IsValid())
+    {
+        return;
+    }
+
+    const auto width = gsl::narrow<size_t>(fill.Width());
+    const bool fullRows = width == gsl::narrow<size_t>(GetSize().Width());
+    const bool narrow = wch <= 0x7F;
+    for (auto y = fill.Top(); y < fill.BottomExclusive(); ++y)
+    {
+        if (fullRows && wch == UNICODE_SPACE)
+        {
+            // Go straight to the storage so that a packed row is dropped instead of unpacked first.
+            THROW_HR_IF(E_OUTOFMEMORY, !_storage[_GetStorageIndex(y)].Reset(attr));
+        }
+        else if (narrow)
+        {
+            ROW& row = GetRowByOffset(y);
+            row.GetCharRow().FillNarrowChars(fill.Left(), width, wch);
+
+            const TextAttributeRun attrRun{ width, attr };
+            THROW_IF_FAILED(row.GetAttrRow().InsertAttrRuns({ &attrRun, 1 },
+                                                            fill.Left(),
+                                                            fill.RightInclusive(),
+                                                            row.size()));
+        }
+        else
+        {
+            // A glyph that might take up two cells needs the full treatment.
+            GetRowByOffset(y).WriteCells(OutputCellIterator(wch, attr, width), fill.Left(), false, fill.RightInclusive());
+        }
+    }
+
+    _NotifyPaint(fill);
+}
+
+// Routine Description:
+// - Writes a rectangle of cells into the buffer, like WriteConsoleOutput does.
+// - Each row is written straight from its part of the given cells, and the whole
+//   rectangle is repainted with one notification instead of one for every row.
+// Arguments:
+// - charInfos - The cells to write, row after row
+// - stride - How many cells apart the rows start in charInfos
+// - rect - The area to write to. It must be inside the buffer, and charInfos must hold all of it.
+// Return Value:
+// - <none>
+// Note: will throw exception if a row can't be written
+void TextBuffer::WriteRect(const std::basic_string_view<CHAR_INFO> charInfos, const size_t stride, const Viewport& rect)
+{
+    THROW_HR_IF(E_INVALIDARG, !GetSize().IsInBounds(rect));
+
+    const auto width = gsl::narrow<size_t>(rect.Width());
+    for (SHORT y = 0; y < rect.Height(); ++y)
+    {
+        const auto rowCells = charInfos.substr(y * stride, width);
+        THROW_HR_IF(E_INVALIDARG, rowCells.size() != width);
+
+        GetRowByOffset(rect.Top() + y).WriteCells(OutputCellIterator(rowCells), rect.Left(), true, rect.RightInclusive());
+    }
+
+    _NotifyPaint(rect);
+}
+
+// Routine Description:
+// - Colors cells without touching their text, like FillConsoleOutputAttribute does,
+//   starting at target and carrying on along the rows below it.
+// - Each row gets its part as a single run, instead of one cell at a time.
+// Arguments:
+// - attr - The attribute to color the cells with
+// - target - The first cell to color
+// - count - How many cells to color
+// Return Value:
+// - How many cells were colored before the end of the buffer
+// Note: will throw exception if a row can't be colored
+size_t TextBuffer::FillAttributes(const TextAttribute attr, const COORD target, const size_t count)
+{
+    const auto size = GetSize();
+    const auto width = gsl::narrow<size_t>(size.Width());
+
+    size_t filled = 0;
+    for (auto lineTarget = target; filled < count && size.IsInBounds(lineTarget); lineTarget.X = 0, ++lineTarget.Y)
+    {
+        const auto rowCount = std::min(count - filled, width - lineTarget.X);
+
+        const TextAttributeRun attrRun{ rowCount, attr };
+        THROW_IF_FAILED(GetRowByOffset(lineTarget.Y).GetAttrRow().InsertAttrRuns({ &attrRun, 1 },
+                                                                                  lineTarget.X,
+                                                                                  lineTarget.X + rowCount - 1,
+                                                                                  width));
+        _NotifyPaint(Viewport::FromDimensions(lineTarget, { gsl::narrow<SHORT>(rowCount), 1 }));
+        filled += rowCount;
+    }
+
+    return filled;
+}
+
+// Routine Description:
+// - Colors cells with a legacy attribute each, like WriteConsoleOutputAttribute does,
+//   starting at target and carrying on along the rows below it.
+// - Neighboring cells of the same color are merged into runs first, so each row's part
+//   goes in with one insertion instead of one per cell. The lead and trailing byte flags
+//   of the attributes are ignored, just like they are for a single cell.
+// Arguments:
+// - attrs - The attributes, one for each cell
+// - target - The first cell to color
+// Return Value:
+// - How many cells were colored before the end of the buffer
+// Note: will throw exception if a row can't be colored
+size_t TextBuffer::WriteLegacyAttributes(const std::basic_string_view<WORD> attrs, const COORD target)
+{
+    const auto size = GetSize();
+    const auto width = gsl::narrow<size_t>(size.Width());
+
+    std::vector<TextAttributeRun> runs;
+    size_t written = 0;
+    for (auto lineTarget = target; written < attrs.size() && size.IsInBounds(lineTarget); lineTarget.X = 0, ++lineTarget.Y)
+    {
+        const auto rowAttrs = attrs.substr(written, width - lineTarget.X);
+
+        runs.clear();
+        WORD runAttr = 0;
+        for (auto attr : rowAttrs)
+        {
+            WI_ClearAllFlags(attr, COMMON_LVB_SBCSDBCS);
+            if (!runs.empty() && attr == runAttr)
+            {
+                runs.back().SetLength(runs.back().GetLength() + 1);
+            }
+            else
+            {
+                runs.emplace_back(1, TextAttribute{ attr });
+                runAttr = attr;
+            }
+        }
+
+        THROW_IF_FAILED(GetRowByOffset(lineTarget.Y).GetAttrRow().InsertAttrRuns({ runs.data(), runs.size() },
+                                                                                  lineTarget.X,
+                                                                                  lineTarget.X + rowAttrs.size() - 1,
+                                                                                  width));
+        _NotifyPaint(Viewport::FromDimensions(lineTarget, { gsl::narrow<SHORT>(rowAttrs.size()), 1 }));
+        written += rowAttrs.size();
+    }
+
+    return written;
+}
+
 //Routine Description:
 // - Finds the current row in the buffer (as indicated by the cursor position)
 //   and specifies that we have forced a line wrap on that row
@@ -463,6 +721,7 @@ void TextBuffer::_AdjustWrapOnCurrentRow(const bool fSet)
 
     // Set the wrap status as appropriate
     GetRowByOffset(uiCurrentRowOffset).GetCharRow().SetWrapForced(fSet);
+    MarkRowsChanged(uiCurrentRowOffset, 1);
 }
 
 //Routine Description:
@@ -522,6 +781,8 @@ bool TextBuffer::NewlineCursor()
     }
     else
     {
+        // The row that just fell out of the hot area above the cursor can be packed away.
+        _CompactColdRow(GetCursor().GetPosition().Y);
         fSuccess = true;
     }
     return fSuccess;
@@ -539,10 +800,35 @@ bool TextBuffer::IncrementCircularBuffer()
     // to the logical position 0 in the window (cursor coordinates and all other coordinates).
     _renderTarget.TriggerCircling();
 
+    // Hand the old "first row" to the archive, if there is one, before it's lost.
+    if (_scrollbackArchive)
+    {
+        const auto& firstRow = _storage.at(_firstRow);
+        const bool alreadyArchived = _pagedInRows > 0 && firstRow.GetGeneration() <= _pagedInGeneration;
+        _pagedInRows -= _pagedInRows > 0 ? 1 : 0;
+        if (!alreadyArchived)
+        {
+            try
+            {
+                _scrollbackArchive->Append(firstRow);
+            }
+            catch (...)
+            {
+                // Not being able to archive the row shouldn't stop output from scrolling. The next
+                // rows wouldn't fare any better (the disk is full, say), so stop archiving them.
+                LOG_CAUGHT_EXCEPTION();
+                _scrollbackArchive.reset();
+                _pagedInRows = 0;
+            }
+        }
+    }
+
     // First, clean out the old "first row" as it will become the "last row" of the buffer after the circle is performed.
     bool fSuccess = _storage.at(_firstRow).Reset(_currentAttributes);
     if (fSuccess)
     {
+        MarkRowsChanged(0, 1);
+
         // Now proceed to increment.
         // Incrementing it will cause the next line down to become the new "top" of the window (the new "0" in logical coordinates)
         _firstRow++;
@@ -552,10 +838,35 @@ bool TextBuffer::IncrementCircularBuffer()
         {
             _firstRow = 0;
         }
+
+        // The marks of the row that circled away go with it.
+        ++_circledRowCount;
+        _marks.EraseBefore(_circledRowCount);
+
+        // Circling only happens once output reaches the bottom of the buffer,
+        // so one more row just moved out of the hot area above the bottom.
+        _CompactColdRow(GetSize().BottomInclusive());
     }
     return fSuccess;
 }
 
+// Routine Description:
+// - Packs the row that is HotRowCount rows above the given row into its compact form.
+// - Called whenever the cursor moves onto a new line, so rows are compacted one at a time as they age.
+// Arguments:
+// - cursorRow - The row the cursor is on, in offset coordinates.
+void TextBuffer::_CompactColdRow(const SHORT cursorRow) noexcept
+{
+    if (cursorRow >= HotRowCount)
+    {
+        try
+        {
+            _storage[_GetStorageIndex(cursorRow - HotRowCount)].Compact();
+        }
+        CATCH_LOG();
+    }
+}
+
 //Routine Description:
 // - Retrieves the position of the last non-space character on the final line of the text buffer.
 //Arguments:
@@ -637,6 +948,14 @@ void TextBuffer::_SetFirstRowIndex(const SHORT FirstRowIndex)
     _firstRow = FirstRowIndex;
 }
 
+// Routine Description:
+// - Moves a block of whole rows up or down within the buffer.
+// - The rows between the block and its destination are rotated around the other side of the block
+//   so no row storage is allocated or copied. Only the rows in the affected span are touched.
+// Arguments:
+// - firstRow - The first row of the block to move, in offset (screen) coordinates.
+// - size - The number of rows in the block.
+// - delta - How many rows to move the block. Negative moves up, positive moves down.
 void TextBuffer::ScrollRows(const SHORT firstRow, const SHORT size, const SHORT delta)
 {
     // If we don't have to move anything, leave early.
@@ -645,97 +964,117 @@ void TextBuffer::ScrollRows(const SHORT firstRow, const SHORT size, const SHORT
         return;
     }
 
-    // OK. We're about to play games by moving rows around within the deque to
-    // scroll a massive region in a faster way than copying things.
-    // To make this easier, first correct the circular buffer to have the first row be 0 again.
-    if (_firstRow != 0)
+    // The layout is like this:
+    // delta is -2, size is 3, firstRow is 5
+    // We want 3 rows from 5 (5, 6, and 7) to move up 2 spots.
+    // --- (offsets) ----
+    // | 3 A. firstRow + delta (because delta is negative)
+    // | 4
+    // | 5 B. firstRow
+    // | 6
+    // | 7
+    // | 8 C. firstRow + size
+    // We want B to slide up to A and everything from [B,C) to slide up with it.
+    // So the final layout will be 5, 6, 7, 3, 4.
+    //
+    // Going down is the mirror image:
+    // delta is 2, size is 3, firstRow is 5
+    // --- (offsets) ----
+    // | 5 A. firstRow
+    // | 6
+    // | 7
+    // | 8 B. firstRow + size
+    // | 9
+    // | 10 C. firstRow + size + delta
+    // So the final layout will be 8, 9, 5, 6, 7.
+    //
+    // Both of these are rotations that we perform in offset coordinates, so the
+    // circular buffer never has to be straightened out to start at index 0 first.
+    size_t first;
+    size_t last;
+    if (delta < 0)
     {
-        // Rotate the buffer to put the first row at the front.
-        std::rotate(_storage.begin(), _storage.begin() + _firstRow, _storage.end());
-
-        // The first row is now at the top.
-        _firstRow = 0;
+        first = static_cast<size_t>(firstRow + delta);
+        last = static_cast<size_t>(firstRow + size);
+        _RotateRows(first, firstRow, last);
+    }
+    else
+    {
+        first = static_cast<size_t>(firstRow);
+        last = static_cast<size_t>(firstRow + size + delta);
+        _RotateRows(first, firstRow + size, last);
     }
 
-    // Rotate just the subsection specified
-    if (delta < 0)
+    // Renumber the IDs of only the rows that moved now that we've rearranged where they sit within the buffer.
+    // UnicodeStorage is keyed by each row's own storage key, so nothing stored there has to move.
+    _RefreshRowIDs(first, last - first);
+
+    // Every row in the span now shows something different than before.
+    MarkRowsChanged(first, last - first);
+}
+
+// Routine Description:
+// - Exchanges two blocks of whole rows that don't overlap, like when a block moves
+//   farther than its own height. Like ScrollRows, no row storage is allocated or copied.
+// Arguments:
+// - firstRow - The first row of one block, in offset (screen) coordinates.
+// - otherFirstRow - The first row of the other block, in offset (screen) coordinates.
+// - size - The number of rows in each block.
+void TextBuffer::SwapRows(const SHORT firstRow, const SHORT otherFirstRow, const SHORT size)
+{
+    FAIL_FAST_IF(std::abs(otherFirstRow - firstRow) < size);
+
+    for (SHORT i = 0; i < size; ++i)
     {
-        // The layout is like this:
-        // delta is -2, size is 3, firstRow is 5
-        // We want 3 rows from 5 (5, 6, and 7) to move up 2 spots.
-        // --- (storage) ----
-        // | 0 begin
-        // | 1
-        // | 2
-        // | 3 A. begin + firstRow + delta (because delta is negative)
-        // | 4
-        // | 5 B. begin + firstRow
-        // | 6
-        // | 7
-        // | 8 C. begin + firstRow + size
-        // | 9
-        // | 10
-        // | 11
-        // - end
-        // We want B to slide up to A (the negative delta) and everything from [B,C) to slide up with it.
-        // So the final layout will be
-        // --- (storage) ----
-        // | 0 begin
-        // | 1
-        // | 2
-        // | 5
-        // | 6
-        // | 7
-        // | 3
-        // | 4
-        // | 8
-        // | 9
-        // | 10
-        // | 11
-        // - end
-        std::rotate(_storage.begin() + firstRow + delta, _storage.begin() + firstRow, _storage.begin() + firstRow + size);
+        std::swap(_storage[_GetStorageIndex(static_cast<size_t>(firstRow + i))],
+                  _storage[_GetStorageIndex(static_cast<size_t>(otherFirstRow + i))]);
     }
-    else
+
+    _RefreshRowIDs(firstRow, size);
+    _RefreshRowIDs(otherFirstRow, size);
+
+    MarkRowsChanged(firstRow, size);
+    MarkRowsChanged(otherFirstRow, size);
+}
+
+// Routine Description:
+// - Converts a row offset (from the first row of the buffer) into an index within the circular storage.
+// Arguments:
+// - rowOffset - Number of rows down from the first row of the buffer.
+// Return Value:
+// - Index into the row storage.
+size_t TextBuffer::_GetStorageIndex(const size_t rowOffset) const noexcept
+{
+    // Rows are stored circularly, so the index you ask for is offset by the start position and mod the total of rows.
+    return (_firstRow + rowOffset) % _storage.size();
+}
+
+// Routine Description:
+// - Reverses the order of the rows in the given range of offsets by swapping them in place.
+// Arguments:
+// - first - The first row offset of the range.
+// - last - One past the final row offset of the range.
+void TextBuffer::_ReverseRows(size_t first, size_t last) noexcept
+{
+    while (first != last && first != --last)
     {
-        // The layout is like this:
-        // delta is 2, size is 3, firstRow is 5
-        // We want 3 rows from 5 (5, 6, and 7) to move down 2 spots.
-        // --- (storage) ----
-        // | 0 begin
-        // | 1
-        // | 2
-        // | 3
-        // | 4
-        // | 5 A. begin + firstRow
-        // | 6
-        // | 7
-        // | 8 B. begin + firstRow + size
-        // | 9
-        // | 10 C. begin + firstRow + size + delta
-        // | 11
-        // - end
-        // We want B-1 to slide down to C-1 (the positive delta) and everything from [A, B) to slide down with it.
-        // So the final layout will be
-        // --- (storage) ----
-        // | 0 begin
-        // | 1
-        // | 2
-        // | 3
-        // | 4
-        // | 8
-        // | 9
-        // | 5
-        // | 6
-        // | 7
-        // | 10
-        // | 11
-        // - end
-        std::rotate(_storage.begin() + firstRow, _storage.begin() + firstRow + size, _storage.begin() + firstRow + size + delta);
-    }
-
-    // Renumber the IDs now that we've rearranged where the rows sit within the buffer.
-    // Refreshing should also delegate to the UnicodeStorage to re-key all the stored unicode sequences (where applicable).
-    _RefreshRowIDs(std::nullopt);
+        std::swap(_storage[_GetStorageIndex(first)], _storage[_GetStorageIndex(last)]);
+        ++first;
+    }
+}
+
+// Routine Description:
+// - Rotates the rows in [first, last) such that the row at middle becomes the row at first.
+// - Works on row offsets, so the range may wrap around the end of the circular storage.
+// Arguments:
+// - first - The first row offset of the range.
+// - middle - The row offset that should become the first row of the range.
+// - last - One past the final row offset of the range.
+void TextBuffer::_RotateRows(const size_t first, const size_t middle, const size_t last) noexcept
+{
+    _ReverseRows(first, middle);
+    _ReverseRows(middle, last);
+    _ReverseRows(first, last);
 }
 
 Cursor& TextBuffer::GetCursor()
@@ -761,15 +1100,21 @@ void TextBuffer::SetCurrentAttributes(const TextAttribute currentAttributes) noe
 // Routine Description:
 // - Resets the text contents of this buffer with the default character
 //   and the default current color attributes
+// - packed rows are cleared without being unpacked first.
+// Note: will throw exception if unable to clear a row
 void TextBuffer::Reset()
 {
     const auto attr = GetCurrentAttributes();
 
     for (auto& row : _storage)
     {
-        row.GetCharRow().Reset();
-        row.GetAttrRow().Reset(attr);
+        THROW_HR_IF(E_OUTOFMEMORY, !row.Reset(attr));
     }
+
+    _marks.Clear();
+    _pagedInRows = 0;
+
+    MarkRowsChanged(0, _storage.size());
 }
 
 // Routine Description:
@@ -795,36 +1140,570 @@ void TextBuffer::Reset()
     // rotate rows until the top row is at index 0
     try
     {
-        const ROW& newTopRow = _storage[TopRowIndex];
-        while (&newTopRow != &_storage.front())
-        {
-            _storage.push_back(std::move(_storage.front()));
-            _storage.pop_front();
-        }
+        std::rotate(_storage.begin(), _storage.begin() + TopRowIndex, _storage.end());
 
         _SetFirstRowIndex(0);
 
         // realloc in the Y direction
         // remove rows if we're shrinking
-        while (_storage.size() > static_cast<size_t>(newSize.Y))
+        if (_storage.size() > static_cast<size_t>(newSize.Y))
         {
-            _storage.pop_back();
+            // drop the glyphs of the rows we're about to remove along with them
+            std::vector<UnicodeStorage::row_key_type> removedRows;
+            removedRows.reserve(_storage.size() - newSize.Y);
+            std::transform(_storage.cbegin() + newSize.Y, _storage.cend(), std::back_inserter(removedRows), [](const ROW& row) noexcept {
+                return row.GetStorageKey();
+            });
+            _unicodeStorage.EraseRows(std::move(removedRows));
+
+            _storage.erase(_storage.begin() + newSize.Y, _storage.end());
         }
-        // add rows if we're growing
+        // add rows if we're growing. Like the ones made by the constructor, they start out packed.
+        _storage.reserve(newSize.Y);
         while (_storage.size() < static_cast<size_t>(newSize.Y))
         {
-            _storage.emplace_back(static_cast<short>(_storage.size()), newSize.X, attributes, this);
+            _storage.emplace_back(static_cast<short>(_storage.size()), newSize.X, attributes, this, true);
         }
 
         // Now that we've tampered with the row placement, refresh all the row IDs.
         // Also take advantage of the row ID refresh loop to resize the rows in the X dimension
         // and cleanup the UnicodeStorage characters that might fall outside the resized buffer.
         _RefreshRowIDs(newSize.X);
+
+        // The rows above the new top row are gone as though they had circled off the top.
+        // Their marks go with them, and so do the marks of any rows cut off the bottom.
+        _circledRowCount += TopRow;
+        _marks.EraseBefore(_circledRowCount);
+        _marks.EraseFrom(_circledRowCount + newSize.Y);
     }
     CATCH_RETURN();
 
+    MarkRowsChanged(0, _storage.size());
+
+    return S_OK;
+}
+
+// Routine Description:
+// - This is a screen resize algorithm which will reflow the ends of lines based on the
+//   line wrap state used for clipboard line-based copy.
+// - Each old row is copied over in as few pieces as the new width allows, rather than
+//   one character at a time, and each piece is copied as whole cells, so the cost is
+//   dominated by the cell copies themselves.
+// - Only the rows up to the last one with text on it are copied.
+// Arguments:
+// - oldBuffer - the text buffer to copy the contents FROM
+// - newBuffer - the text buffer to copy the contents TO
+// Return Value:
+// - S_OK if we successfully copied the contents to the new buffer, otherwise an appropriate HRESULT.
+[[nodiscard]] HRESULT TextBuffer::Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer) noexcept
+try
+{
+    Cursor& oldCursor = oldBuffer.GetCursor();
+    Cursor& newCursor = newBuffer.GetCursor();
+
+    // We need to save the old cursor position so that we can
+    // place the new cursor back on the equivalent character in
+    // the new buffer.
+    const COORD cOldCursorPos = oldCursor.GetPosition();
+    const COORD cOldLastChar = oldBuffer.GetLastNonSpaceCharacter();
+
+    const short cOldRowsTotal = cOldLastChar.Y + 1;
+    const short cOldColsTotal = oldBuffer.GetSize().Width();
+
+    COORD cNewCursorPos = { 0 };
+    bool fFoundCursorPos = false;
+
+    // Marks are carried over along with the cells they're on. They're sorted, so
+    // they come up in the same order the rows are copied in.
+    auto nextMark = oldBuffer._marks.begin();
+    const auto isMarkOnRow = [&](const short iOldRow) noexcept {
+        return nextMark != oldBuffer._marks.end() && nextMark->row == oldBuffer._circledRowCount + iOldRow;
+    };
+
+    // Loop through all the rows of the old buffer and reprint them into the new buffer
+    for (short iOldRow = 0; iOldRow < cOldRowsTotal; iOldRow++)
+    {
+        // Fetch the row and its "right" which is the last printable character.
+        const ROW& row = oldBuffer.GetRowByOffset(iOldRow);
+        const CharRow& charRow = row.GetCharRow();
+        short iRight = static_cast<short>(charRow.MeasureRight());
+
+        // There is a special case here. If the row has a "wrap"
+        // flag on it, but the right isn't equal to the width (one
+        // index past the final valid index in the row) then there
+        // were a bunch trailing of spaces in the row.
+        // (But the measuring functions for each row Left/Right do
+        // not count spaces as "displayable" so they're not
+        // included.)
+        // As such, adjust the "right" to be the width of the row
+        // to capture all these spaces
+        if (charRow.WasWrapForced())
+        {
+            iRight = cOldColsTotal;
+
+            // And a combined special case.
+            // If we wrapped off the end of the row by adding a
+            // piece of padding because of a double byte LEADING
+            // character, then remove one from the "right" to
+            // leave this padding out of the copy process.
+            if (charRow.WasDoubleBytePadded())
+            {
+                iRight--;
+            }
+        }
+
+        // Copy everything up to the "right" boundary (which is one past
+        // the final valid character) over to the new buffer's cursor.
+        short iOldCol = 0;
+        while (iOldCol < iRight)
+        {
+            const COORD target = newCursor.GetPosition();
+            // Copying can circle the new buffer, so hold on to the absolute row the cells go to.
+            const auto targetRow = newBuffer._circledRowCount + target.Y;
+            const auto copied = gsl::narrow_cast<short>(newBuffer._ReflowCells(row, iOldCol, iRight));
+
+            while (isMarkOnRow(iOldRow) && nextMark->column < iOldCol + copied)
+            {
+                newBuffer._AddMark({ targetRow, gsl::narrow_cast<SHORT>(target.X + nextMark->column - iOldCol), nextMark->kind });
+                ++nextMark;
+            }
+
+            if (iOldRow == cOldCursorPos.Y && cOldCursorPos.X >= iOldCol && cOldCursorPos.X < iOldCol + copied)
+            {
+                cNewCursorPos = { gsl::narrow_cast<short>(target.X + cOldCursorPos.X - iOldCol), target.Y };
+                fFoundCursorPos = true;
+            }
+
+            iOldCol += copied;
+        }
+
+        // Marks past the end of the row's text stay just after it.
+        while (isMarkOnRow(iOldRow))
+        {
+            newBuffer.AddMark(nextMark->kind, newCursor.GetPosition());
+            ++nextMark;
+        }
+
+        // If we didn't have a full row to copy, insert a new
+        // line into the new buffer.
+        // Only do so if we were not forced to wrap. If we did
+        // force a word wrap, then the existing line break was
+        // only because we ran out of space.
+        if (iRight < cOldColsTotal && !charRow.WasWrapForced())
+        {
+            if (iRight == cOldCursorPos.X && iOldRow == cOldCursorPos.Y)
+            {
+                cNewCursorPos = newCursor.GetPosition();
+                fFoundCursorPos = true;
+            }
+            // Only do this if it's not the final line in the buffer.
+            // On the final line, we want the cursor to sit
+            // where it is done printing for the cursor
+            // adjustment to follow.
+            if (iOldRow < cOldRowsTotal - 1)
+            {
+                RETURN_HR_IF(E_OUTOFMEMORY, !newBuffer.NewlineCursor());
+            }
+            else
+            {
+                // If we are on the final line of the buffer, we have one more check.
+                // We got into this code path because we are at the right most column of a row in the old buffer
+                // that had a hard return (no wrap was forced).
+                // However, as we're inserting, the old row might have just barely fit into the new buffer and
+                // caused a new soft return (wrap was forced) putting the cursor at x=0 on the line just below.
+                // We need to preserve the memory of the hard return at this point by inserting one additional
+                // hard newline, otherwise we've lost that information.
+                // We only do this when the cursor has just barely poured over onto the next line so the hard return
+                // isn't covered by the soft one.
+                // e.g.
+                // The old line was:
+                // |aaaaaaaaaaaaaaaaaaa | with no wrap which means there was a newline after that final a.
+                // The cursor was here ^
+                // And the new line will be:
+                // |aaaaaaaaaaaaaaaaaaa| and show a wrap at the end
+                // |                   |
+                //  ^ and the cursor is now there.
+                // If we leave it like this, we've lost the newline information.
+                // So we insert one more newline so a continued reflow of this buffer by resizing larger will
+                // continue to look as the original output intended with the newline data.
+                // After this fix, it looks like this:
+                // |aaaaaaaaaaaaaaaaaaa| no wrap at the end (preserved hard newline)
+                // |                   |
+                //  ^ and the cursor is now here.
+                const COORD coordNewCursor = newCursor.GetPosition();
+                if (coordNewCursor.X == 0 && coordNewCursor.Y > 0)
+                {
+                    if (newBuffer.GetRowByOffset(coordNewCursor.Y - 1).GetCharRow().WasWrapForced())
+                    {
+                        RETURN_HR_IF(E_OUTOFMEMORY, !newBuffer.NewlineCursor());
+                    }
+                }
+            }
+        }
+    }
+
+    // Finish copying remaining parameters from the old text buffer to the new one
+    newBuffer.CopyProperties(oldBuffer);
+
+    // If we found where to put the cursor while placing characters into the buffer,
+    //   just put the cursor there. Otherwise we have to advance manually.
+    if (fFoundCursorPos)
+    {
+        newCursor.SetPosition(cNewCursorPos);
+    }
+    else
+    {
+        // Advance the cursor to the same offset as before
+        // get the number of newlines and spaces between the old end of text and the old cursor,
+        //   then advance that many newlines and chars
+        int iNewlines = cOldCursorPos.Y - cOldLastChar.Y;
+        const int iIncrements = cOldCursorPos.X - cOldLastChar.X;
+        const COORD cNewLastChar = newBuffer.GetLastNonSpaceCharacter();
+
+        // If the last row of the new buffer wrapped, there's going to be one less newline needed,
+        //   because the cursor is already on the next line
+        if (newBuffer.GetRowByOffset(cNewLastChar.Y).GetCharRow().WasWrapForced())
+        {
+            iNewlines = std::max(iNewlines - 1, 0);
+        }
+        else
+        {
+            // if this buffer didn't wrap, but the old one DID, then the d(columns) of the
+            //   old buffer will be one more than in this buffer, so new need one LESS.
+            if (oldBuffer.GetRowByOffset(cOldLastChar.Y).GetCharRow().WasWrapForced())
+            {
+                iNewlines = std::max(iNewlines - 1, 0);
+            }
+        }
+
+        for (int r = 0; r < iNewlines; r++)
+        {
+            RETURN_HR_IF(E_OUTOFMEMORY, !newBuffer.NewlineCursor());
+        }
+        for (int c = 0; c < iIncrements - 1; c++)
+        {
+            RETURN_HR_IF(E_OUTOFMEMORY, !newBuffer.IncrementCursor());
+        }
+    }
+
+    // Marks below the last of the text, like one on an empty prompt line, keep
+    // their distance from the cursor.
+    for (; nextMark != oldBuffer._marks.end(); ++nextMark)
+    {
+        const auto oldRow = gsl::narrow_cast<int>(nextMark->row - oldBuffer._circledRowCount);
+        const auto newRow = newCursor.GetPosition().Y + oldRow - cOldCursorPos.Y;
+        if (newRow >= 0)
+        {
+            newBuffer.AddMark(nextMark->kind, { nextMark->column, gsl::narrow_cast<SHORT>(newRow) });
+        }
+    }
+
     return S_OK;
 }
+CATCH_RETURN();
+
+// Routine Description:
+// - Copies as many of the cells [start, end) of a row from another buffer as fit on the cursor's row
+//   of this one, then advances the cursor past them, wrapping onto the next row if we filled this one.
+// - The attributes end up as though each cell had been inserted with InsertCharacter: the attribute
+//   of the final cell copied carries on to the end of the row.
+// Arguments:
+// - source - the row to copy cells from
+// - start - the first column of the source row to copy
+// - end - one past the last column of the source row to copy
+// Return Value:
+// - The number of source cells that were copied. This can be 0 when the cursor was
+//   on the final column and the first cell is a leading half that had to go to the next row.
+// Note:
+// - will throw on failure
+size_t TextBuffer::_ReflowCells(const ROW& source, const size_t start, const size_t end)
+{
+    const COORD target = GetCursor().GetPosition();
+    const size_t width = GetSize().Width();
+    const size_t space = width - target.X;
+    const auto& sourceCharRow = source.GetCharRow();
+
+    size_t count = std::min(end - start, space);
+    // A leading half can't go in the final column since its trailing half wouldn't fit.
+    // Leave it (and its trailing half) for the next row, unless the row is too narrow to ever hold it.
+    const bool needsPadding = count == space && width > 1 && sourceCharRow.DbcsAttrAt(start + count - 1).IsLeading();
+    if (needsPadding)
+    {
+        --count;
+    }
+
+    ROW& row = GetRowByOffset(target.Y);
+    if (count > 0)
+    {
+        // The cells are copied over whole. Only the glyphs that don't fit in a cell have to be
+        // looked up and stored again, since the new row keeps them under its own key.
+        // The source row may still be packed, since the old buffer is only read.
+        row.GetCharRow().CopyCells(sourceCharRow, start, count, target.X);
+
+        std::vector<TextAttributeRun> runs;
+        for (size_t column = start; column < start + count;)
+        {
+            size_t applies = 0;
+            const auto attr = source.GetAttrRow().GetAttrByColumn(column, &applies);
+            const auto length = std::min(applies, start + count - column);
+            runs.emplace_back(length, attr);
+            column += length;
+        }
+        runs.back().SetLength(runs.back().GetLength() + space - count);
+        THROW_IF_FAILED(row.GetAttrRow().InsertAttrRuns({ runs.data(), runs.size() }, target.X, width - 1, width));
+    }
+
+    if (count < space && !needsPadding)
+    {
+        GetCursor().SetXPosition(gsl::narrow_cast<int>(target.X + count));
+    }
+    else
+    {
+        // We filled the row (possibly with a padding cell for a leading half), so wrap onto the next one.
+        if (needsPadding)
+        {
+            row.GetCharRow().SetDoubleBytePadded(true);
+        }
+        GetCursor().SetXPosition(gsl::narrow_cast<int>(width - 1));
+        THROW_HR_IF(E_OUTOFMEMORY, !IncrementCursor());
+    }
+
+    return count;
+}
+
+// Routine Description:
+// - Gets the current generation of the buffer. Holding on to it and later passing it to
+//   GetChangedRows reports every row that changed in between.
+// Return Value:
+// - The generation that the most recent change to the buffer was recorded in.
+uint64_t TextBuffer::GetGeneration() const noexcept
+{
+    return _generation;
+}
+
+// Routine Description:
+// - Gets how many rows have circled off the top of the buffer since it was made.
+//   Added to a row's offset, it gives a number for the row that stays the same as
+//   the buffer circles, the same one that marks are kept by.
+// Return Value:
+// - The number of rows that have circled off the top.
+uint64_t TextBuffer::GetCircledRowCount() const noexcept
+{
+    return _circledRowCount;
+}
+
+// Routine Description:
+// - Gets a number that tells this buffer apart from every other one made by the process.
+//   Unlike the buffer's address, it isn't handed out again once the buffer is gone.
+// Return Value:
+// - The id of the buffer. It's never 0.
+uint64_t TextBuffer::GetId() const noexcept
+{
+    return _id;
+}
+
+// Routine Description:
+// - Adds up all the parts of a MemoryUsage.
+// Return Value:
+// - The bytes held by the buffer.
+size_t TextBuffer::MemoryUsage::Total() const noexcept
+{
+    return rows + cells + compactedCells + attributes + unicodeStorage + spareStorage + archiveIndex;
+}
+
+// Routine Description:
+// - Gets how many bytes the buffer holds, scrollback included, and what for. It walks
+//   every row, so it's meant for diagnostics and budgets rather than every write.
+// - The attribute table may be shared with other buffers, whose usage counts it as well.
+// Return Value:
+// - The bytes held by the buffer.
+TextBuffer::MemoryUsage TextBuffer::GetMemoryUsage() const noexcept
+{
+    MemoryUsage usage;
+    usage.rows = _storage.capacity() * sizeof(ROW);
+    for (const auto& row : _storage)
+    {
+        usage.cells += row.GetCharRow().GetMemoryUsage();
+        usage.compactedCells += row.GetCompactedMemoryUsage();
+        usage.attributes += row.GetAttrRow().GetMemoryUsage();
+    }
+
+    if (_attributeTable)
+    {
+        usage.attributes += _attributeTable->GetMemoryUsage();
+    }
+    usage.unicodeStorage = _unicodeStorage.GetMemoryUsage();
+    usage.spareStorage = _rowStoragePool.GetMemoryUsage();
+    if (_scrollbackArchive)
+    {
+        usage.archiveIndex = _scrollbackArchive->GetMemoryUsage();
+    }
+    return usage;
+}
+
+// Routine Description:
+// - Brings the memory the buffer holds down under the given budget, as far as it can,
+//   by giving up the scrollback above firstKeptRow, oldest row first:
+//   1. rows that are still expanded are packed away, then if that isn't enough
+//   2. rows are cleared, and their glyphs erased, which packs them down to nothing.
+// - Clearing rows loses their text, so it's only done once packing everything didn't do.
+// Arguments:
+// - budget - The most bytes the buffer should hold.
+// - firstKeptRow - The first row that mustn't be touched, in offset coordinates.
+//   The rows from it on (the viewport, say) are left as they are.
+// Return Value:
+// - The number of rows that were cleared.
+size_t TextBuffer::TrimToMemoryBudget(const size_t budget, const SHORT firstKeptRow)
+{
+    auto usage = GetMemoryUsage().Total();
+    if (usage <= budget)
+    {
+        return 0;
+    }
+
+    const auto limit = std::clamp<SHORT>(firstKeptRow, 0, GetSize().Height());
+
+    // The usage is kept up to date from what each row held before and after, which leaves out what
+    // the storage pool kept of it. That's a few rows' worth at most, so it's measured again after
+    // and packing goes on if it turns out not to have been enough.
+    // The rows are reached through _storage, since GetRowByOffset would unpack the ones already packed.
+    SHORT y = 0;
+    while (y < limit && usage > budget)
+    {
+        for (; y < limit && usage > budget; ++y)
+        {
+            auto& row = _storage[_GetStorageIndex(y)];
+            if (!row.IsCompacted())
+            {
+                const auto before = row.GetMemoryUsage();
+                row.Compact();
+                usage = usage - before + row.GetMemoryUsage();
+            }
+        }
+        usage = GetMemoryUsage().Total();
+    }
+
+    SHORT cleared = 0;
+    std::vector<UnicodeStorage::row_key_type> clearedRows;
+    for (; cleared < limit && usage > budget; ++cleared)
+    {
+        auto& row = _storage[_GetStorageIndex(cleared)];
+        const auto before = row.GetMemoryUsage();
+        THROW_HR_IF(E_UNEXPECTED, !row.Reset(_currentAttributes));
+        row.Compact();
+        usage = usage - before + row.GetMemoryUsage();
+        clearedRows.push_back(row.GetStorageKey());
+    }
+
+    if (cleared > 0)
+    {
+        _unicodeStorage.EraseRows(std::move(clearedRows));
+        _NotifyPaint(Viewport::FromDimensions({ 0, 0 }, { GetSize().Width(), cleared }));
+    }
+    return cleared;
+}
+
+// Routine Description:
+// - Records that the contents of a span of rows changed by stamping them with a new generation.
+// - Writes through TextBuffer mark their rows themselves. Callers that edit a row's char or attribute
+//   data directly should mark it so that consumers of GetChangedRows see the change.
+// Arguments:
+// - firstRow - The first row that changed, in offset (screen) coordinates.
+// - count - The number of rows that changed.
+void TextBuffer::MarkRowsChanged(const size_t firstRow, const size_t count) noexcept
+{
+    const auto last = std::min(firstRow + count, _storage.size());
+    if (firstRow >= last)
+    {
+        return;
+    }
+
+    ++_generation;
+    for (auto row = firstRow; row < last; ++row)
+    {
+        _storage[_GetStorageIndex(row)].SetGeneration(_generation);
+    }
+}
+
+// Routine Description:
+// - Finds the rows whose contents changed after the given generation.
+// - Adjacent changed rows are merged, so scattered changes at opposite ends of the buffer come back
+//   as separate regions instead of one region spanning everything between them.
+// Arguments:
+// - generation - A generation previously returned from GetGeneration.
+// Return Value:
+// - Full width regions covering the changed rows, from top to bottom, in offset (screen) coordinates.
+// Note:
+// - will throw exception if unable to allocate memory for the regions
+std::vector<Viewport> TextBuffer::GetChangedRows(const uint64_t generation) const
+{
+    std::vector<Viewport> regions;
+    if (generation >= _generation)
+    {
+        return regions;
+    }
+
+    const auto width = GetSize().Width();
+    std::optional<SHORT> top;
+    for (SHORT row = 0; row < gsl::narrow<SHORT>(_storage.size()); ++row)
+    {
+        const bool changed = _storage[_GetStorageIndex(row)].GetGeneration() > generation;
+        if (changed && !top.has_value())
+        {
+            top = row;
+        }
+        else if (!changed && top.has_value())
+        {
+            regions.push_back(Viewport::FromDimensions({ 0, top.value() }, width, gsl::narrow_cast<SHORT>(row - top.value())));
+            top.reset();
+        }
+    }
+
+    if (top.has_value())
+    {
+        regions.push_back(Viewport::FromDimensions({ 0, top.value() }, width, gsl::narrow_cast<SHORT>(_storage.size() - top.value())));
+    }
+
+    return regions;
+}
+
+// Routine Description:
+// - copies rows of the buffer into a snapshot that can be read without holding the lock,
+//   while the buffer itself carries on changing.
+// - rows that haven't changed since the previous snapshot was taken are shared with it instead of copied again,
+//   so taking a snapshot of a viewport that's mostly unchanged costs little more than the pointers.
+// - rows that were packed down are copied straight out of their packed form. nothing about the buffer
+//   changes, so this only needs the lock held for reading.
+// Arguments:
+// - rows - the rows to copy, in buffer coordinates. they're always copied at the full width of the buffer.
+// - previous - optional earlier snapshot to share unchanged rows with
+// Return Value:
+// - the snapshot
+// Note: will throw exception if rows aren't within the buffer or unable to allocate memory
+std::shared_ptr<const TextBufferSnapshot> TextBuffer::TakeSnapshot(const Viewport& rows,
+                                                                   const TextBufferSnapshot* const previous) const
+{
+    THROW_HR_IF(E_INVALIDARG, rows.Top() < 0 || rows.BottomExclusive() > GetSize().BottomExclusive());
+
+    std::vector<std::shared_ptr<const TextBufferSnapshot::Row>> snapshotRows;
+    snapshotRows.reserve(rows.Height());
+
+    size_t hint = 0;
+    for (SHORT y = rows.Top(); y < rows.BottomExclusive(); ++y)
+    {
+        const auto& row = GetRowByOffset(y);
+        auto copy = previous ? previous->FindUnchangedRow(row, hint) : nullptr;
+        if (!copy)
+        {
+            copy = std::make_shared<const TextBufferSnapshot::Row>(row);
+        }
+        snapshotRows.push_back(std::move(copy));
+    }
+
+    return std::make_shared<const TextBufferSnapshot>(Viewport::FromDimensions({ 0, rows.Top() }, GetSize().Width(), rows.Height()),
+                                                      _generation,
+                                                      std::move(snapshotRows));
+}
 
 const UnicodeStorage& TextBuffer::GetUnicodeStorage() const
 {
@@ -836,6 +1715,132 @@ UnicodeStorage& TextBuffer::GetUnicodeStorage()
     return _unicodeStorage;
 }
 
+// Routine Description:
+// - Gets the table that interns the attributes used by the rows of this buffer
+// Return Value:
+// - the shared attribute table
+const std::shared_ptr<TextAttributeTable>& TextBuffer::GetAttributeTable() const noexcept
+{
+    return _attributeTable;
+}
+
+// Routine Description:
+// - Packs away every row above firstKeptRow that's still expanded, and lets go of the
+//   spare row storage, for a buffer that's about to sit idle. Unlike TrimToMemoryBudget,
+//   nothing is cleared: the rows unpack again whenever they're next looked at.
+// Arguments:
+// - firstKeptRow - The first row to leave expanded (the top of the viewport, say), in offset coordinates.
+// Return Value:
+// - The number of rows that were packed.
+size_t TextBuffer::CompactColdRows(const SHORT firstKeptRow)
+{
+    const auto limit = std::clamp<SHORT>(firstKeptRow, 0, GetSize().Height());
+
+    // The rows are reached through _storage, since GetRowByOffset would unpack the ones already packed.
+    size_t compacted = 0;
+    for (SHORT y = 0; y < limit; ++y)
+    {
+        auto& row = _storage[_GetStorageIndex(y)];
+        if (!row.IsCompacted())
+        {
+            row.Compact();
+            compacted++;
+        }
+    }
+
+    _rowStoragePool.Clear();
+    return compacted;
+}
+
+RowStoragePool& TextBuffer::GetRowStoragePool() noexcept
+{
+    return _rowStoragePool;
+}
+
+const RowStoragePool& TextBuffer::GetRowStoragePool() const noexcept
+{
+    return _rowStoragePool;
+}
+
+// Routine Description:
+// - sets the archive that rows are appended to as they circle off the top of the buffer
+// Arguments:
+// - archive - the archive to use, or nullptr to stop archiving rows
+void TextBuffer::SetScrollbackArchive(std::shared_ptr<ScrollbackArchive> archive) noexcept
+{
+    _scrollbackArchive = std::move(archive);
+    _pagedInRows = 0;
+}
+
+// Routine Description:
+// - gets the archive that rows are appended to as they circle off the top of the buffer
+// Return Value:
+// - the archive, or nullptr if rows aren't being archived
+const std::shared_ptr<ScrollbackArchive>& TextBuffer::GetScrollbackArchive() const noexcept
+{
+    return _scrollbackArchive;
+}
+
+// Routine Description:
+// - gets how many rows of the archive came before the first row of the buffer. the rows
+//   that were paged back into the buffer are left out, since they can be read from it.
+// Return Value:
+// - the number of rows that can only be read from the archive, or 0 if there's no archive
+size_t TextBuffer::GetArchivedRowCount() const noexcept
+{
+    return _scrollbackArchive ? _scrollbackArchive->size() - _pagedInRows : 0;
+}
+
+// Routine Description:
+// - reads one of the rows that came before the first row of the buffer out of the archive
+// Arguments:
+// - index - the index of the row, from 0 for the oldest to GetArchivedRowCount() - 1 for
+//   the one right above the first row of the buffer
+// Return Value:
+// - the text, attributes and wrap state of the row
+// Note: will throw exception if there's no such row or it can't be read
+ScrollbackArchive::ArchivedRow TextBuffer::ReadArchivedRow(const size_t index) const
+{
+    THROW_HR_IF(E_INVALIDARG, index >= GetArchivedRowCount());
+    return _scrollbackArchive->Read(index);
+}
+
+// Routine Description:
+// - brings the newest rows of the archive back into the top of the buffer, e.g. when a
+//   terminal is made again with the archive an earlier one left behind. from then on
+//   they're rows like any other, which GetRowByOffset, searching and selecting all see.
+// - the rows are still in the archive, so they aren't appended to it again when they
+//   circle off, unless they're written to first.
+// - it's meant for a buffer that was just made. whatever was in the rows is replaced, and
+//   rows paged in before are paged in again.
+// Arguments:
+// - count - the most rows to bring back
+// Return Value:
+// - the number of rows brought back. it's never more than the height of the buffer.
+// Note: will throw exception if the archive can't be read. the rows brought back until
+//   then stay in the buffer.
+SHORT TextBuffer::PageInArchivedRows(const SHORT count)
+{
+    _pagedInRows = 0;
+    const auto available = GetArchivedRowCount();
+    const auto paging = gsl::narrow_cast<SHORT>(std::min<size_t>({ available,
+                                                                   static_cast<size_t>(std::max<SHORT>(count, 0)),
+                                                                   _storage.size() }));
+    auto markPagedIn = wil::scope_exit([&]() {
+        MarkRowsChanged(0, _pagedInRows);
+        _pagedInGeneration = _generation;
+    });
+
+    for (SHORT y = 0; y < paging; ++y)
+    {
+        auto& row = GetRowByOffset(y);
+        THROW_HR_IF(E_FAIL, !row.Reset(_currentAttributes));
+        _scrollbackArchive->PageIn(available - paging + y, row);
+        ++_pagedInRows;
+    }
+    return paging;
+}
+
 // Routine Description:
 // - Method to help refresh all the Row IDs after manipulating the row
 //   by shuffling pointers around.
@@ -847,13 +1852,9 @@ UnicodeStorage& TextBuffer::GetUnicodeStorage()
 // - newRowWidth - Optional new value for the row width.
 void TextBuffer::_RefreshRowIDs(std::optional<SHORT> newRowWidth)
 {
-    std::map<SHORT, SHORT> rowMap;
     SHORT i = 0;
     for (auto& it : _storage)
     {
-        // Build a map so we can update Unicode Storage
-        rowMap.emplace(it.GetId(), i);
-
         // Update the IDs
         it.SetId(i++);
 
@@ -868,12 +1869,38 @@ void TextBuffer::_RefreshRowIDs(std::optional<SHORT> newRowWidth)
         }
     }
 
-    // Give the new mapping to Unicode Storage
-    _unicodeStorage.Remap(rowMap, newRowWidth);
+    // Unicode Storage is keyed by the rows' own storage keys, so it doesn't care that they moved.
+    // If we got narrower, drop anything that fell off the right edge.
+    if (newRowWidth.has_value())
+    {
+        _unicodeStorage.EraseColumns(newRowWidth.value());
+    }
+}
+
+// Routine Description:
+// - Refreshes the Row IDs of only a span of rows after they were shuffled around
+//   by a scroll operation. Rows outside the span keep their IDs.
+// Arguments:
+// - firstRow - The first row offset (from the first row of the buffer) of the span.
+// - count - The number of rows in the span.
+void TextBuffer::_RefreshRowIDs(const size_t firstRow, const size_t count)
+{
+    for (size_t i = firstRow; i < firstRow + count; ++i)
+    {
+        const auto index = _GetStorageIndex(i);
+        auto& row = _storage[index];
+
+        // A row's ID is its index within the storage.
+        row.SetId(gsl::narrow_cast<SHORT>(index));
+
+        // Also update the char row parent pointers as they got swapped around with the rows.
+        row.GetCharRow().UpdateParent(&row);
+    }
 }
 
-void TextBuffer::_NotifyPaint(const Viewport& viewport) const
+void TextBuffer::_NotifyPaint(const Viewport& viewport)
 {
+    MarkRowsChanged(viewport.Top(), viewport.Height());
     _renderTarget.TriggerRedraw(viewport);
 }
 
@@ -906,7 +1933,9 @@ ROW& TextBuffer::_GetPrevRowNoWrap(const ROW& Row)
     }
 
     THROW_HR_IF(E_FAIL, Row.GetId() == _firstRow);
-    return _storage[prevRowIndex];
+    auto& prevRow = _storage[prevRowIndex];
+    prevRow.Expand();
+    return prevRow;
 }
 
 // Method Description:
@@ -920,6 +1949,78 @@ Microsoft::Console::Render::IRenderTarget& TextBuffer::GetRenderTarget()
     return _renderTarget;
 }
 
+// Routine Description:
+// - Marks where part of a shell's prompt cycle begins, as told by shell integration.
+// Arguments:
+// - kind - which part of the cycle begins here
+// - position - where it begins, usually the cursor position
+// Note:
+// - will throw on failure
+void TextBuffer::AddMark(const MarkIndex::Kind kind, const COORD position)
+{
+    _AddMark({ _circledRowCount + position.Y, position.X, kind });
+}
+
+// Routine Description:
+// - Finds the nearest mark before the given position.
+// Arguments:
+// - before - the position to look before
+// - kind - if given, only marks of this kind are considered
+// Return Value:
+// - where the mark is, if there is one before the position
+std::optional<COORD> TextBuffer::FindPreviousMark(const COORD before, const std::optional<MarkIndex::Kind> kind) const noexcept
+{
+    if (const auto mark = _marks.FindPrevious(_circledRowCount + before.Y, before.X, kind))
+    {
+        return _GetMarkPosition(*mark);
+    }
+    return std::nullopt;
+}
+
+// Routine Description:
+// - Finds the nearest mark after the given position.
+// Arguments:
+// - after - the position to look after
+// - kind - if given, only marks of this kind are considered
+// Return Value:
+// - where the mark is, if there is one after the position
+std::optional<COORD> TextBuffer::FindNextMark(const COORD after, const std::optional<MarkIndex::Kind> kind) const noexcept
+{
+    if (const auto mark = _marks.FindNext(_circledRowCount + after.Y, after.X, kind))
+    {
+        return _GetMarkPosition(*mark);
+    }
+    return std::nullopt;
+}
+
+// Routine Description:
+// - Adds a mark by its absolute row, as long as that row is still in the buffer.
+// Arguments:
+// - mark - the mark to add
+// Note:
+// - will throw on failure
+void TextBuffer::_AddMark(const MarkIndex::Mark mark)
+{
+    const auto size = GetSize();
+    if (mark.row >= _circledRowCount &&
+        mark.row < _circledRowCount + size.Height() &&
+        mark.column >= 0)
+    {
+        _marks.Add({ mark.row, std::min(mark.column, size.RightInclusive()), mark.kind });
+    }
+}
+
+// Routine Description:
+// - Gives the position of a mark within the buffer as it is now.
+// Arguments:
+// - mark - the mark, which must be on a row that's still in the buffer
+// Return Value:
+// - the position of the mark
+COORD TextBuffer::_GetMarkPosition(const MarkIndex::Mark& mark) const noexcept
+{
+    return { std::min(mark.column, GetSize().RightInclusive()), gsl::narrow_cast<SHORT>(mark.row - _circledRowCount) };
+}
+
 // Routine Description:
 // - Retrieves the text data from the selected region and presents it in a clipboard-ready format (given little post-processing).
 // Arguments:
@@ -936,95 +2037,142 @@ const TextBuffer::TextAndColor TextBuffer::GetTextForClipboard(const bool lineSe
                                                                std::function<COLORREF(TextAttribute&)> GetForegroundColor,
                                                                std::function<COLORREF(TextAttribute&)> GetBackgroundColor) const
 {
-    TextAndColor data;
-
-    // preallocate our vectors to reduce reallocs
-    size_t const rows = selectionRects.size();
-    data.text.reserve(rows);
-    data.FgAttr.reserve(rows);
-    data.BkAttr.reserve(rows);
-
-    // for each row in the selection
-    for (UINT i = 0; i < rows; i++)
+    // Collects the runs into one string and color vector pair per selection rect.
+    class TextAndColorSink final : public ITextRunSink
     {
-        const UINT iRow = selectionRects.at(i).Top;
+    public:
+        TextAndColorSink(const size_t rows,
+                         std::function<COLORREF(TextAttribute&)>& getForegroundColor,
+                         std::function<COLORREF(TextAttribute&)>& getBackgroundColor) :
+            _getForegroundColor{ getForegroundColor },
+            _getBackgroundColor{ getBackgroundColor }
+        {
+            // preallocate our vectors to reduce reallocs
+            data.text.reserve(rows);
+            data.FgAttr.reserve(rows);
+            data.BkAttr.reserve(rows);
+        }
 
-        const Viewport highlight = Viewport::FromInclusive(selectionRects.at(i));
+        void OnTextRun(const std::wstring_view text, const TextAttribute& attr) override
+        {
+            // The colors only have to be looked up once for the whole run.
+            auto runAttr = attr;
+            _Append(text, _getForegroundColor(runAttr), _getBackgroundColor(runAttr));
+        }
+
+        void OnRowEnd(const bool lineBreak) override
+        {
+            if (lineBreak)
+            {
+                COLORREF const Blackness = RGB(0x00, 0x00, 0x00); // cant see CR/LF so just use black FG & BK
+                _Append(L"\r\n", Blackness, Blackness);
+            }
 
-        // retrieve the data from the screen buffer
-        auto it = GetCellDataAt(highlight.Origin(), highlight);
+            data.text.emplace_back(std::move(_text));
+            data.FgAttr.emplace_back(std::move(_fgAttr));
+            data.BkAttr.emplace_back(std::move(_bkAttr));
 
-        // allocate a string buffer
-        std::wstring selectionText;
-        std::vector<COLORREF> selectionFgAttr;
-        std::vector<COLORREF> selectionBkAttr;
+            _text = {};
+            _fgAttr = {};
+            _bkAttr = {};
+        }
 
-        // preallocate to avoid reallocs
-        selectionText.reserve(highlight.Width() + 2); // + 2 for \r\n if we munged it
-        selectionFgAttr.reserve(highlight.Width() + 2);
-        selectionBkAttr.reserve(highlight.Width() + 2);
+        TextAndColor data;
 
-        // copy char data into the string buffer, skipping trailing bytes
-        while (it)
+    private:
+        void _Append(const std::wstring_view text, const COLORREF fg, const COLORREF bk)
         {
-            const auto& cell = *it;
-            auto cellData = cell.TextAttr();
-            COLORREF const CellFgAttr = GetForegroundColor(cellData);
-            COLORREF const CellBkAttr = GetBackgroundColor(cellData);
+            _text.append(text);
+            _fgAttr.insert(_fgAttr.end(), text.size(), fg);
+            _bkAttr.insert(_bkAttr.end(), text.size(), bk);
+        }
+
+        std::function<COLORREF(TextAttribute&)>& _getForegroundColor;
+        std::function<COLORREF(TextAttribute&)>& _getBackgroundColor;
+
+        std::wstring _text;
+        std::vector<COLORREF> _fgAttr;
+        std::vector<COLORREF> _bkAttr;
+    };
+
+    TextAndColorSink sink{ selectionRects.size(), GetForegroundColor, GetBackgroundColor };
+    ForEachSelectedTextRun(lineSelection, trimTrailingWhitespace, selectionRects, sink);
+    return std::move(sink.data);
+}
+
+// Routine Description:
+// - Hands the text of the selected region to the sink one run of identically attributed text at a time,
+//   the same way GetTextForClipboard would present it, but without collecting it anywhere first.
+// - Runs follow the attribute runs of each row, so the sink only has to resolve colors once per run.
+// Arguments:
+// - lineSelection - true if entire line is being selected. False otherwise (box selection)
+// - trimTrailingWhitespace - setting flag removes trailing whitespace at the end of each row in selection
+// - selectionRects - the selection regions from which the data will be extracted from the buffer
+// - sink - receives the runs of each selection rect in order, followed by the end of its row
+// Note:
+// - will throw exception if unable to allocate memory for the working buffer or if the sink throws
+void TextBuffer::ForEachSelectedTextRun(const bool lineSelection,
+                                        const bool trimTrailingWhitespace,
+                                        const std::vector<SMALL_RECT>& selectionRects,
+                                        ITextRunSink& sink) const
+{
+    // Cells keep their characters interleaved with their other data, so each run is gathered here
+    // before it goes to the sink. The same buffer is reused by every run.
+    std::wstring runText;
+
+    for (size_t i = 0; i < selectionRects.size(); i++)
+    {
+        const auto& rect = selectionRects.at(i);
+        const ROW& row = GetRowByOffset(rect.Top);
+        const CharRow& charRow = row.GetCharRow();
+        const ATTR_ROW& attrRow = row.GetAttrRow();
+        const bool wrapped = charRow.WasWrapForced();
 
-            if (!cell.DbcsAttr().IsTrailing())
+        size_t end = static_cast<size_t>(rect.Right) + 1;
+
+        // trim trailing spaces if SHIFT key not held
+        // FOR LINE SELECTION ONLY: if the row was wrapped, don't remove the spaces at the end.
+        if (trimTrailingWhitespace && (!lineSelection || !wrapped))
+        {
+            while (end > static_cast<size_t>(rect.Left))
             {
-                selectionText.append(cell.Chars());
-                for (const wchar_t wch : cell.Chars())
+                const std::wstring_view glyph = charRow.GlyphAt(end - 1);
+                if (glyph.size() != 1 || glyph.front() != UNICODE_SPACE)
                 {
-                    selectionFgAttr.push_back(CellFgAttr);
-                    selectionBkAttr.push_back(CellBkAttr);
+                    break;
                 }
+                --end;
             }
-            it++;
         }
 
-        // trim trailing spaces if SHIFT key not held
-        if (trimTrailingWhitespace)
+        for (size_t column = rect.Left; column < end;)
         {
-            const ROW& Row = GetRowByOffset(iRow);
+            size_t applies = 0;
+            const auto attr = attrRow.GetAttrByColumn(column, &applies);
+            const size_t runEnd = std::min(column + applies, end);
 
-            // FOR LINE SELECTION ONLY: if the row was wrapped, don't remove the spaces at the end.
-            if (!lineSelection || !Row.GetCharRow().WasWrapForced())
+            // copy char data into the run, skipping trailing bytes
+            runText.clear();
+            for (; column < runEnd; ++column)
             {
-                while (!selectionText.empty() && selectionText.back() == UNICODE_SPACE)
+                if (!charRow.DbcsAttrAt(column).IsTrailing())
                 {
-                    selectionText.pop_back();
-                    selectionFgAttr.pop_back();
-                    selectionBkAttr.pop_back();
+                    runText.append(static_cast<std::wstring_view>(charRow.GlyphAt(column)));
                 }
             }
 
-            // apply CR/LF to the end of the final string, unless we're the last line.
-            // a.k.a if we're earlier than the bottom, then apply CR/LF.
-            if (i < selectionRects.size() - 1)
+            if (!runText.empty())
             {
-                // FOR LINE SELECTION ONLY: if the row was wrapped, do not apply CR/LF.
-                // a.k.a. if the row was NOT wrapped, then we can assume a CR/LF is proper
-                // always apply \r\n for box selection
-                if (!lineSelection || !GetRowByOffset(iRow).GetCharRow().WasWrapForced())
-                {
-                    COLORREF const Blackness = RGB(0x00, 0x00, 0x00); // cant see CR/LF so just use black FG & BK
-
-                    selectionText.push_back(UNICODE_CARRIAGERETURN);
-                    selectionText.push_back(UNICODE_LINEFEED);
-                    selectionFgAttr.push_back(Blackness);
-                    selectionFgAttr.push_back(Blackness);
-                    selectionBkAttr.push_back(Blackness);
-                    selectionBkAttr.push_back(Blackness);
-                }
+                sink.OnTextRun(runText, attr);
             }
         }
 
-        data.text.emplace_back(std::move(selectionText));
-        data.FgAttr.emplace_back(std::move(selectionFgAttr));
-        data.BkAttr.emplace_back(std::move(selectionBkAttr));
+        // apply CR/LF to the end of the final string, unless we're the last line.
+        // a.k.a if we're earlier than the bottom, then apply CR/LF.
+        // FOR LINE SELECTION ONLY: if the row was wrapped, do not apply CR/LF.
+        // a.k.a. if the row was NOT wrapped, then we can assume a CR/LF is proper
+        // always apply \r\n for box selection
+        const bool lineBreak = trimTrailingWhitespace && i < selectionRects.size() - 1 && (!lineSelection || !wrapped);
+        sink.OnRowEnd(lineBreak);
     }
-
-    return data;
 }
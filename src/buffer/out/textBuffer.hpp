@@ -50,8 +50,13 @@ filling in the last row, and updating the screen.
 #pragma once
 
 #include "cursor.h"
+#include "MarkIndex.hpp"
 #include "Row.hpp"
+#include "RowStoragePool.hpp"
 #include "TextAttribute.hpp"
+#include "TextAttributeTable.hpp"
+#include "TextBufferSnapshot.hpp"
+#include "ScrollbackArchive.hpp"
 #include "UnicodeStorage.hpp"
 #include "../types/inc/Viewport.hpp"
 
@@ -98,12 +103,20 @@ public:
 
     bool InsertCharacter(const wchar_t wch, const DbcsAttribute dbcsAttribute, const TextAttribute attr);
     bool InsertCharacter(const std::wstring_view chars, const DbcsAttribute dbcsAttribute, const TextAttribute attr);
+    bool InsertRun(const std::wstring_view text, const TextAttribute attr);
+    void FillRect(const Microsoft::Console::Types::Viewport& rect, const wchar_t wch, const TextAttribute attr);
+    void WriteRect(const std::basic_string_view<CHAR_INFO> charInfos, const size_t stride, const Microsoft::Console::Types::Viewport& rect);
+    size_t FillAttributes(const TextAttribute attr, const COORD target, const size_t count);
+    size_t WriteLegacyAttributes(const std::basic_string_view<WORD> attrs, const COORD target);
     bool IncrementCursor();
     bool NewlineCursor();
 
     // Scroll needs access to this to quickly rotate around the buffer.
     bool IncrementCircularBuffer();
 
+    // Rows this far above the cursor are packed into a compact form until they're touched again.
+    static constexpr SHORT HotRowCount = 256;
+
     COORD GetLastNonSpaceCharacter() const;
 
     Cursor& GetCursor();
@@ -114,6 +127,7 @@ public:
     const Microsoft::Console::Types::Viewport GetSize() const;
 
     void ScrollRows(const SHORT firstRow, const SHORT size, const SHORT delta);
+    void SwapRows(const SHORT firstRow, const SHORT otherFirstRow, const SHORT size);
 
     UINT TotalRowCount() const;
 
@@ -125,11 +139,55 @@ public:
 
     [[nodiscard]] HRESULT ResizeTraditional(const COORD newSize) noexcept;
 
+    [[nodiscard]] static HRESULT Reflow(TextBuffer& oldBuffer, TextBuffer& newBuffer) noexcept;
+
     const UnicodeStorage& GetUnicodeStorage() const;
     UnicodeStorage& GetUnicodeStorage();
 
+    const std::shared_ptr<TextAttributeTable>& GetAttributeTable() const noexcept;
+
+    RowStoragePool& GetRowStoragePool() noexcept;
+    const RowStoragePool& GetRowStoragePool() const noexcept;
+
+    void SetScrollbackArchive(std::shared_ptr<ScrollbackArchive> archive) noexcept;
+    const std::shared_ptr<ScrollbackArchive>& GetScrollbackArchive() const noexcept;
+    size_t GetArchivedRowCount() const noexcept;
+    ScrollbackArchive::ArchivedRow ReadArchivedRow(const size_t index) const;
+    SHORT PageInArchivedRows(const SHORT count);
+
     Microsoft::Console::Render::IRenderTarget& GetRenderTarget();
 
+    // Shell integration marks, so that prompts and commands can be found without scanning the text.
+    void AddMark(const MarkIndex::Kind kind, const COORD position);
+    std::optional<COORD> FindPreviousMark(const COORD before, const std::optional<MarkIndex::Kind> kind = std::nullopt) const noexcept;
+    std::optional<COORD> FindNextMark(const COORD after, const std::optional<MarkIndex::Kind> kind = std::nullopt) const noexcept;
+
+    uint64_t GetGeneration() const noexcept;
+    uint64_t GetCircledRowCount() const noexcept;
+    uint64_t GetId() const noexcept;
+
+    // How many bytes the buffer holds, by what they hold.
+    struct MemoryUsage
+    {
+        size_t rows = 0; // the ROW objects themselves
+        size_t cells = 0; // the cells of rows that are expanded, and what's cached about them
+        size_t compactedCells = 0; // the char data of rows that are packed away
+        size_t attributes = 0; // the attribute runs of every row and the table of attributes they use
+        size_t unicodeStorage = 0; // glyphs that don't fit in a cell
+        size_t spareStorage = 0; // storage the RowStoragePool keeps for the next rows that need it
+        size_t archiveIndex = 0; // the index of the ScrollbackArchive, if there is one
+
+        size_t Total() const noexcept;
+    };
+    MemoryUsage GetMemoryUsage() const noexcept;
+    size_t TrimToMemoryBudget(const size_t budget, const SHORT firstKeptRow);
+    size_t CompactColdRows(const SHORT firstKeptRow);
+    void MarkRowsChanged(const size_t firstRow, const size_t count) noexcept;
+    std::vector<Microsoft::Console::Types::Viewport> GetChangedRows(const uint64_t generation) const;
+
+    std::shared_ptr<const TextBufferSnapshot> TakeSnapshot(const Microsoft::Console::Types::Viewport& rows,
+                                                           const TextBufferSnapshot* const previous = nullptr) const;
+
     class TextAndColor
     {
     public:
@@ -144,8 +202,31 @@ public:
                                            std::function<COLORREF(TextAttribute&)> GetForegroundColor,
                                            std::function<COLORREF(TextAttribute&)> GetBackgroundColor) const;
 
+    // Receives the selected text from ForEachSelectedTextRun, so that writers for the various
+    // clipboard formats can produce their output directly from the buffer.
+    class ITextRunSink
+    {
+    public:
+        virtual ~ITextRunSink() = default;
+
+        // Every character of the text shares the one attribute. The text is only valid during the call.
+        virtual void OnTextRun(const std::wstring_view text, const TextAttribute& attr) = 0;
+
+        // All of the text from one of the selection rects has been handed over.
+        // lineBreak is set when a CR/LF belongs after it.
+        virtual void OnRowEnd(const bool lineBreak) = 0;
+    };
+
+    void ForEachSelectedTextRun(const bool lineSelection,
+                                const bool trimTrailingWhitespace,
+                                const std::vector<SMALL_RECT>& selectionRects,
+                                ITextRunSink& sink) const;
+
 private:
-    std::deque<ROW> _storage;
+    // Rows are kept contiguously and addressed circularly from _firstRow.
+    // The vector is never grown after construction except through ResizeTraditional,
+    // which refreshes every row's parent pointers afterwards.
+    std::vector<ROW> _storage;
     Cursor _cursor;
 
     SHORT _firstRow; // indexes top row (not necessarily 0)
@@ -155,7 +236,41 @@ private:
     // storage location for glyphs that can't fit into the buffer normally
     UnicodeStorage _unicodeStorage;
 
+    // every distinct attribute in the buffer, shared by the ATTR_ROWs of all of our rows
+    std::shared_ptr<TextAttributeTable> _attributeTable;
+
+    // spare storage handed between rows as they're packed, unpacked and cleared
+    RowStoragePool _rowStoragePool;
+
+    // bumped every time rows are marked as changed. each row remembers the generation it last changed in.
+    uint64_t _generation;
+
+    // optional place to keep the rows that circle off the top of the buffer
+    std::shared_ptr<ScrollbackArchive> _scrollbackArchive;
+
+    // the first rows of the buffer that were paged in from the archive, and the generation
+    // they were paged in at. they're the last rows of the archive, so unless they were
+    // written to since, they aren't appended to it again when they circle off.
+    size_t _pagedInRows;
+    uint64_t _pagedInGeneration;
+
+    // rows that have circled off the top since the buffer was made. added to a row's
+    // offset, it gives the absolute row number that marks are kept by.
+    uint64_t _circledRowCount;
+    MarkIndex _marks;
+
+    // tells this buffer apart from every other one the process makes, even one made at the same address
+    const uint64_t _id;
+
+    void _AddMark(const MarkIndex::Mark mark);
+    COORD _GetMarkPosition(const MarkIndex::Mark& mark) const noexcept;
+
     void _RefreshRowIDs(std::optional<SHORT> newRowWidth);
+    void _RefreshRowIDs(const size_t firstRow, const size_t count);
+
+    size_t _GetStorageIndex(const size_t rowOffset) const noexcept;
+    void _ReverseRows(size_t first, size_t last) noexcept;
+    void _RotateRows(const size_t first, const size_t middle, const size_t last) noexcept;
 
     Microsoft::Console::Render::IRenderTarget& _renderTarget;
 
@@ -163,10 +278,14 @@ private:
 
     COORD _GetPreviousFromCursor() const;
 
+    void _CompactColdRow(const SHORT cursorRow) noexcept;
+
+    size_t _ReflowCells(const ROW& source, const size_t start, const size_t end);
+
     void _SetWrapOnCurrentRow();
     void _AdjustWrapOnCurrentRow(const bool fSet);
 
-    void _NotifyPaint(const Microsoft::Console::Types::Viewport& viewport) const;
+    void _NotifyPaint(const Microsoft::Console::Types::Viewport& viewport);
 
     // Assist with maintaining proper buffer state for Double Byte character sequences
     bool _PrepareForDoubleByteSequence(const DbcsAttribute dbcsAttribute);
@@ -18,34 +18,124 @@ class UnicodeStorageTests
     TEST_METHOD(CanOverwriteEmoji)
     {
         UnicodeStorage storage;
-        const COORD coord{ 1, 3 };
-        const std::vector<wchar_t> newMoon{ 0xD83C, 0xDF11 };
-        const std::vector<wchar_t> fullMoon{ 0xD83C, 0xDF15 };
+        const UnicodeStorage::key_type key{ 1, storage.CreateRowKey() };
+        const std::wstring_view newMoon{ L"\xD83C\xDF11" };
+        const std::wstring_view fullMoon{ L"\xD83C\xDF15" };
 
         // store initial glyph
-        storage.StoreGlyph(coord, newMoon);
+        storage.StoreGlyph(key, newMoon);
 
         // verify it was stored
-        auto findIt = storage._map.find(coord);
-        VERIFY_ARE_NOT_EQUAL(findIt, storage._map.end());
-        const std::vector<wchar_t>& newMoonGlyph = findIt->second;
-        VERIFY_ARE_EQUAL(newMoonGlyph.size(), newMoon.size());
-        for (size_t i = 0; i < newMoon.size(); ++i)
-        {
-            VERIFY_ARE_EQUAL(newMoonGlyph.at(i), newMoon.at(i));
-        }
+        VERIFY_ARE_EQUAL(1u, storage.size());
+        VERIFY_ARE_EQUAL(String(newMoon.data(), gsl::narrow<int>(newMoon.size())),
+                         String(storage.GetText(key).data(), gsl::narrow<int>(storage.GetText(key).size())));
 
         // overwrite it
-        storage.StoreGlyph(coord, fullMoon);
+        storage.StoreGlyph(key, fullMoon);
 
         // verify the glyph was overwritten
-        findIt = storage._map.find(coord);
-        VERIFY_ARE_NOT_EQUAL(findIt, storage._map.end());
-        const std::vector<wchar_t>& fullMoonGlyph = findIt->second;
-        VERIFY_ARE_EQUAL(fullMoonGlyph.size(), fullMoon.size());
-        for (size_t i = 0; i < fullMoon.size(); ++i)
+        VERIFY_ARE_EQUAL(1u, storage.size());
+        VERIFY_ARE_EQUAL(String(fullMoon.data(), gsl::narrow<int>(fullMoon.size())),
+                         String(storage.GetText(key).data(), gsl::narrow<int>(storage.GetText(key).size())));
+    }
+
+    TEST_METHOD(ErasingKeepsOtherGlyphsReachable)
+    {
+        UnicodeStorage storage;
+        const auto firstRow = storage.CreateRowKey();
+        const auto secondRow = storage.CreateRowKey();
+        VERIFY_ARE_NOT_EQUAL(firstRow, secondRow);
+
+        // Store enough glyphs that the table has to grow and probe sequences collide.
+        for (SHORT column = 0; column < 100; ++column)
         {
-            VERIFY_ARE_EQUAL(fullMoonGlyph.at(i), fullMoon.at(i));
+            const std::wstring glyph{ L'a', static_cast<wchar_t>(L'0' + column % 10) };
+            storage.StoreGlyph({ column, firstRow }, glyph);
+            storage.StoreGlyph({ column, secondRow }, glyph);
         }
+        VERIFY_ARE_EQUAL(200u, storage.size());
+
+        Log::Comment(L"Erase every other glyph of the first row.");
+        for (SHORT column = 0; column < 100; column += 2)
+        {
+            storage.Erase({ column, firstRow });
+        }
+        VERIFY_ARE_EQUAL(150u, storage.size());
+
+        for (SHORT column = 0; column < 100; ++column)
+        {
+            VERIFY_ARE_EQUAL(static_cast<wchar_t>(L'0' + column % 10), storage.GetText({ column, secondRow }).back());
+            if (column % 2)
+            {
+                VERIFY_ARE_EQUAL(static_cast<wchar_t>(L'0' + column % 10), storage.GetText({ column, firstRow }).back());
+            }
+            else
+            {
+                VERIFY_THROWS(storage.GetText({ column, firstRow }), wil::ResultException);
+            }
+        }
+
+        Log::Comment(L"Erase everything at or beyond column 50.");
+        storage.EraseColumns(50);
+        VERIFY_ARE_EQUAL(75u, storage.size());
+        VERIFY_THROWS(storage.GetText({ 51, firstRow }), wil::ResultException);
+        VERIFY_ARE_EQUAL(L'9', storage.GetText({ 49, firstRow }).back());
+
+        Log::Comment(L"Erase the whole second row.");
+        storage.EraseRows({ secondRow });
+        VERIFY_ARE_EQUAL(25u, storage.size());
+        VERIFY_THROWS(storage.GetText({ 1, secondRow }), wil::ResultException);
+        VERIFY_ARE_EQUAL(L'1', storage.GetText({ 1, firstRow }).back());
+    }
+
+    TEST_METHOD(OverwritingGlyphsLetsGoOfChunks)
+    {
+        UnicodeStorage storage;
+        const UnicodeStorage::key_type key{ 0, storage.CreateRowKey() };
+
+        // Each longer glyph has to go to the end of the current chunk, leaving the old one behind,
+        // so this goes through several chunks' worth of text.
+        std::wstring glyph{ L"\xD83D\xDC68" };
+        for (size_t i = 0; i < 10000; ++i)
+        {
+            storage.StoreGlyph(key, glyph + std::wstring(i % 4, L'\x200D'));
+        }
+
+        VERIFY_ARE_EQUAL(1u, storage.size());
+        const auto held = gsl::narrow_cast<size_t>(std::count_if(storage._chunks.cbegin(), storage._chunks.cend(), [](const auto& chunk) {
+            return chunk.text != nullptr;
+        }));
+        VERIFY_IS_LESS_THAN_OR_EQUAL(held, 2u);
+        VERIFY_ARE_EQUAL(glyph.size() + 3, storage.GetText(key).size());
+    }
+
+    TEST_METHOD(StoredTextDoesntMove)
+    {
+        UnicodeStorage storage;
+        const auto row = storage.CreateRowKey();
+        const std::wstring_view fire{ L"\xD83D\xDD25" };
+
+        storage.StoreGlyph({ 0, row }, fire);
+        const auto view = storage.GetText({ 0, row });
+
+        Log::Comment(L"Storing and replacing plenty of other glyphs leaves the first one where it was.");
+        for (SHORT column = 1; column < 2000; ++column)
+        {
+            storage.StoreGlyph({ column, row }, std::wstring(column % 7 + 2, L'x'));
+            storage.StoreGlyph({ column, row }, std::wstring(column % 7 + 9, L'y'));
+        }
+        VERIFY_ARE_EQUAL(view.data(), storage.GetText({ 0, row }).data());
+        VERIFY_ARE_EQUAL(String(fire.data(), 2), String(view.data(), 2));
+
+        Log::Comment(L"A glyph can be stored from a view of a stored glyph, including its own.");
+        storage.StoreGlyph({ 1, row }, view);
+        VERIFY_ARE_EQUAL(String(fire.data(), 2), String(storage.GetText({ 1, row }).data(), 2));
+
+        const std::wstring longer(5000, L'z');
+        storage.StoreGlyph({ 2, row }, longer);
+        storage.StoreGlyph({ 3, row }, storage.GetText({ 2, row }));
+        storage.StoreGlyph({ 2, row }, storage.GetText({ 2, row }).substr(1, 3));
+        VERIFY_ARE_EQUAL(longer.size(), storage.GetText({ 3, row }).size());
+        VERIFY_ARE_EQUAL(String(L"zzz"), String(storage.GetText({ 2, row }).data(), 3));
     }
 };
@@ -40,8 +40,14 @@ namespace winrt::TerminalApp::implementation
         _tabs{},
         _loadedInitialSettings{ false },
         _settingsLoadedResult{ S_OK },
-        _dialogLock{}
+        _dialogLock{},
+        _startupBegin{ std::chrono::steady_clock::now() }
     {
+        // The provider is registered this early so that the settings, which are
+        // loaded before we're Create()'d, get their startup phase logged too.
+        TraceLoggingRegister(g_hTerminalAppProvider);
+        _startupTraceRequested = _IsStartupTraceRequested();
+
         // For your own sanity, it's better to do setup outside the ctor.
         // If you do any setup in the ctor that ends up throwing an exception,
         // then it might look like App just failed to activate, which will
@@ -66,7 +72,7 @@ namespace winrt::TerminalApp::implementation
         // Assert that we've already loaded our settings. We have to do
         // this as a MTA, before the app is Create()'d
         WINRT_ASSERT(_loadedInitialSettings);
-        TraceLoggingRegister(g_hTerminalAppProvider);
+        const auto createStart = _StartStartupPhase(L"CreateUI");
 
         /* !!! TODO
            This is not the correct way to host a XAML page. This exists today because we valued
@@ -106,9 +112,113 @@ namespace winrt::TerminalApp::implementation
         _root.Loaded({ this, &App::_OnLoaded });
 
         _CreateNewTabFlyout();
+
+        const auto firstTabStart = _StartStartupPhase(L"FirstTab");
         _OpenNewTab(std::nullopt);
+        _StopStartupPhase(L"FirstTab", firstTabStart);
 
         _tabContent.SizeChanged({ this, &App::_OnContentSizeChanged });
+
+        _StopStartupPhase(L"CreateUI", createStart);
+    }
+
+    // Method Description:
+    // - Checks whether we were launched with --startup-trace, which asks for a
+    //   summary of how long each phase of startup took once the first frame is up.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - true if --startup-trace is on our commandline
+    bool App::_IsStartupTraceRequested() noexcept
+    {
+        int argc = 0;
+        wil::unique_hlocal_ptr<LPWSTR> argv{ CommandLineToArgvW(GetCommandLineW(), &argc) };
+        if (!argv)
+        {
+            return false;
+        }
+
+        for (int i = 1; i < argc; i++)
+        {
+            if (std::wstring_view{ argv.get()[i] } == L"--startup-trace")
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Method Description:
+    // - Marks the start of a phase of startup in our trace.
+    // Arguments:
+    // - phase: the name of the phase
+    // Return Value:
+    // - the time the phase started, to hand to _StopStartupPhase
+    std::chrono::steady_clock::time_point App::_StartStartupPhase(const std::wstring_view phase) noexcept
+    {
+        TraceLoggingWrite(
+            g_hTerminalAppProvider,
+            "StartupPhase",
+            TraceLoggingDescription("Event emitted when a phase of TerminalApp startup starts and stops"),
+            TraceLoggingOpcode(WINEVENT_OPCODE_START),
+            TraceLoggingCountedWideString(phase.data(), gsl::narrow_cast<USHORT>(phase.size()), "Phase"));
+        return std::chrono::steady_clock::now();
+    }
+
+    // Method Description:
+    // - Marks the end of a phase of startup in our trace, and adds how long it
+    //   took to the startup summary.
+    // Arguments:
+    // - phase: the name of the phase
+    // - start: when the phase started, from _StartStartupPhase
+    void App::_StopStartupPhase(const std::wstring_view phase, const std::chrono::steady_clock::time_point start)
+    {
+        const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        TraceLoggingWrite(
+            g_hTerminalAppProvider,
+            "StartupPhase",
+            TraceLoggingDescription("Event emitted when a phase of TerminalApp startup starts and stops"),
+            TraceLoggingOpcode(WINEVENT_OPCODE_STOP),
+            TraceLoggingCountedWideString(phase.data(), gsl::narrow_cast<USHORT>(phase.size()), "Phase"),
+            TraceLoggingInt64(duration.count(), "DurationUs"));
+
+        _startupSummary.append(L" ");
+        _startupSummary.append(phase);
+        _startupSummary.append(L"=");
+        _startupSummary.append(std::to_wstring(duration.count()));
+        _startupSummary.append(L"us");
+    }
+
+    // Method Description:
+    // - Called on the first frame that's rendered. Logs how long startup took in
+    //   all, along with the phases that went into it. If we were asked for a
+    //   --startup-trace, that's also written out as one line, to stderr if it's
+    //   been redirected somewhere, or to the debugger otherwise.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void App::_FinishStartupTrace()
+    {
+        _StopStartupPhase(L"FirstFrame", _startupBegin);
+
+        TraceLoggingWrite(
+            g_hTerminalAppProvider,
+            "StartupSummary",
+            TraceLoggingDescription("Event emitted once TerminalApp has rendered its first frame, with how long each phase of startup took"),
+            TraceLoggingWideString(_startupSummary.c_str(), "Phases"));
+
+        if (_startupTraceRequested)
+        {
+            const auto line = winrt::to_string(L"WindowsTerminal startup:" + _startupSummary + L"\r\n");
+            const auto hStdErr = GetStdHandle(STD_ERROR_HANDLE);
+            DWORD written = 0;
+            if (hStdErr == nullptr || hStdErr == INVALID_HANDLE_VALUE ||
+                !WriteFile(hStdErr, line.data(), gsl::narrow_cast<DWORD>(line.size()), &written, nullptr))
+            {
+                OutputDebugStringA(line.c_str());
+            }
+        }
     }
 
     App::~App()
@@ -270,6 +380,12 @@ namespace winrt::TerminalApp::implementation
             const winrt::hstring textKey = L"InitialJsonParseErrorText";
             _ShowOkDialog(titleKey, textKey);
         }
+
+        // The first time XAML renders after we're loaded is the end of startup.
+        _firstFrameToken = Media::CompositionTarget::Rendering([this](auto&&, auto&&) {
+            Media::CompositionTarget::Rendering(_firstFrameToken);
+            _FinishStartupTrace();
+        });
     }
 
     // Method Description:
@@ -500,6 +616,7 @@ namespace winrt::TerminalApp::implementation
         bindings.MoveFocus([this](const auto direction) { _MoveFocus(direction); });
         bindings.CopyText([this](const auto trimWhitespace) { _CopyText(trimWhitespace); });
         bindings.PasteText([this]() { _PasteText(); });
+        bindings.TogglePerformanceOverlay([this]() { _TogglePerformanceOverlay(); });
     }
 
     // Method Description:
@@ -550,7 +667,9 @@ namespace winrt::TerminalApp::implementation
         //    we should display the loading error.
         //    * We can't display the error now, because we might not have a
         //      UI yet. We'll display the error in _OnLoaded.
+        const auto loadStart = _StartStartupPhase(L"LoadSettings");
         _settingsLoadedResult = _TryLoadSettings(true);
+        _StopStartupPhase(L"LoadSettings", loadStart);
 
         if (FAILED(_settingsLoadedResult))
         {
@@ -630,6 +749,9 @@ namespace winrt::TerminalApp::implementation
         //  - don't change the settings (and don't actually apply the new settings)
         //  - don't persist them.
         //  - display a loading error
+        // Keep what the panes were last given, so only the profiles that changed
+        // get pushed to them again.
+        const auto previousJson = _settings->ToJson();
         _settingsLoadedResult = _TryLoadSettings(false);
 
         if (FAILED(_settingsLoadedResult))
@@ -652,10 +774,8 @@ namespace winrt::TerminalApp::implementation
 
         // Refresh UI elements
 
-        auto profiles = _settings->GetProfiles();
-        for (auto& profile : profiles)
+        for (const auto& profileGuid : _settings->GetProfilesChangedSince(previousJson))
         {
-            const GUID profileGuid = profile.GetGuid();
             TerminalSettings settings = _settings->MakeSettings(profileGuid);
 
             for (auto& tab : _tabs)
@@ -673,6 +793,14 @@ namespace winrt::TerminalApp::implementation
         }
 
         _root.Dispatcher().RunAsync(CoreDispatcherPriority::Normal, [this]() {
+            // The spare control was made with the old settings. Make a new one.
+            if (_spareControl)
+            {
+                _spareControl.Close();
+                _spareControl = nullptr;
+                _QueueSpareControl();
+            }
+
             // Refresh the UI theme
             _ApplyTheme(_settings->GlobalSettings().GetRequestedTheme());
 
@@ -911,14 +1039,18 @@ namespace winrt::TerminalApp::implementation
     {
         // Initialize the new tab
 
-        // Create a Conhost connection based on the values in our settings object.
-        auto connection = TerminalConnection::ConhostConnection(settings.Commandline(),
-                                                                settings.StartingDirectory(),
-                                                                30,
-                                                                80,
-                                                                winrt::guid());
-
-        TermControl term{ settings, connection };
+        // Use the control that was made ahead of time if it's for this profile,
+        // and start making the next one once this tab is up.
+        TermControl term{ nullptr };
+        if (_spareControl && _spareControlProfile == profileGuid)
+        {
+            term = std::exchange(_spareControl, nullptr);
+        }
+        else
+        {
+            term = _CreateControl(settings);
+        }
+        _QueueSpareControl();
 
         // Add the new tab to the list of our tabs.
         auto newTab = _tabs.emplace_back(std::make_shared<Tab>(profileGuid, term));
@@ -954,6 +1086,51 @@ namespace winrt::TerminalApp::implementation
         _tabView.SelectedItem(tabViewItem);
     }
 
+    // Method Description:
+    // - Creates a TermControl for the given settings, along with its connection.
+    //   The connection doesn't start its client until the control is loaded.
+    // Arguments:
+    // - settings: the TerminalSettings object to use to create the TerminalControl with.
+    // Return Value:
+    // - the new TermControl
+    TermControl App::_CreateControl(TerminalSettings settings)
+    {
+        // Create a Conhost connection based on the values in our settings object.
+        auto connection = TerminalConnection::ConhostConnection(settings.Commandline(),
+                                                                settings.StartingDirectory(),
+                                                                30,
+                                                                80,
+                                                                winrt::guid());
+
+        return TermControl{ settings, connection };
+    }
+
+    // Method Description:
+    // - Makes a control for the default profile ahead of time, once the UI thread
+    //   has nothing more pressing to do, if there isn't one already. The next new
+    //   tab with that profile takes it instead of building its own.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void App::_QueueSpareControl()
+    {
+        _root.Dispatcher().RunAsync(CoreDispatcherPriority::Low, [this]() {
+            if (_spareControl)
+            {
+                return;
+            }
+
+            try
+            {
+                const auto profileGuid = _settings->GlobalSettings().GetDefaultProfile();
+                _spareControl = _CreateControl(_settings->MakeSettings(profileGuid));
+                _spareControlProfile = profileGuid;
+            }
+            CATCH_LOG();
+        });
+    }
+
     // Method Description:
     // - Returns the index in our list of tabs of the currently focused tab. If
     //      no tab is currently selected, returns -1.
@@ -1072,6 +1249,14 @@ namespace winrt::TerminalApp::implementation
         control.PasteTextFromClipboard();
     }
 
+    // Method Description:
+    // - Shows or hides the performance counters of the focused terminal
+    void App::_TogglePerformanceOverlay()
+    {
+        const auto control = _GetFocusedControl();
+        control.TogglePerformanceOverlay();
+    }
+
     // Method Description:
     // - Sets focus to the tab to the right or left the currently selected tab.
     void App::_SelectNextTab(const bool bMoveRight)
@@ -1106,10 +1291,16 @@ namespace winrt::TerminalApp::implementation
         auto tabView = sender.as<MUX::Controls::TabView>();
         auto selectedIndex = tabView.SelectedIndex();
 
-        // Unfocus all the tabs.
-        for (auto tab : _tabs)
+        // Unfocus the other tabs that are focused. Leaving the selected one alone
+        // spares its controls from stopping and restarting their painting, and
+        // leaving the ones that are already unfocused alone keeps a switch from
+        // costing more with every tab that's open.
+        for (size_t i = 0; i < _tabs.size(); i++)
         {
-            tab->SetFocused(false);
+            if (static_cast<int>(i) != selectedIndex && _tabs[i]->IsFocused())
+            {
+                _tabs[i]->SetFocused(false);
+            }
         }
 
         if (selectedIndex >= 0)
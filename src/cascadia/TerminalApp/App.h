@@ -69,6 +69,22 @@ namespace winrt::TerminalApp::implementation
 
         std::atomic<bool> _settingsReloadQueued{ false };
 
+        // Startup is timed from when we're constructed until our first frame is rendered.
+        std::chrono::steady_clock::time_point _startupBegin;
+        std::wstring _startupSummary;
+        bool _startupTraceRequested{ false };
+        winrt::event_token _firstFrameToken{};
+
+        static bool _IsStartupTraceRequested() noexcept;
+        std::chrono::steady_clock::time_point _StartStartupPhase(const std::wstring_view phase) noexcept;
+        void _StopStartupPhase(const std::wstring_view phase, const std::chrono::steady_clock::time_point start);
+        void _FinishStartupTrace();
+
+        // A control made ahead of time, so that a new tab with the default
+        // profile doesn't have to wait for one to be built.
+        winrt::Microsoft::Terminal::TerminalControl::TermControl _spareControl{ nullptr };
+        GUID _spareControlProfile{};
+
         void _CreateNewTabFlyout();
 
         fire_and_forget _ShowDialog(const winrt::Windows::Foundation::IInspectable& titleElement,
@@ -98,6 +114,8 @@ namespace winrt::TerminalApp::implementation
         void _RegisterTerminalEvents(Microsoft::Terminal::TerminalControl::TermControl term, std::shared_ptr<Tab> hostingTab);
 
         void _CreateNewTabFromSettings(GUID profileGuid, winrt::Microsoft::Terminal::Settings::TerminalSettings settings);
+        winrt::Microsoft::Terminal::TerminalControl::TermControl _CreateControl(winrt::Microsoft::Terminal::Settings::TerminalSettings settings);
+        void _QueueSpareControl();
 
         void _OpenNewTab(std::optional<int> profileIndex);
         void _DuplicateTabViewItem();
@@ -112,6 +130,7 @@ namespace winrt::TerminalApp::implementation
         void _Scroll(int delta);
         void _CopyText(const bool trimTrailingWhitespace);
         void _PasteText();
+        void _TogglePerformanceOverlay();
         void _SplitVertical(const std::optional<GUID>& profileGuid);
         void _SplitHorizontal(const std::optional<GUID>& profileGuid);
         void _SplitPane(const Pane::SplitState splitType, const std::optional<GUID>& profileGuid);
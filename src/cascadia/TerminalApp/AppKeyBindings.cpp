@@ -17,6 +17,11 @@ namespace winrt::TerminalApp::implementation
                                        const Settings::KeyChord& chord)
     {
         _keyShortcuts[chord] = action;
+
+        if (const auto index = _DispatchTableIndex(chord.Vkey(), chord.Modifiers()))
+        {
+            _dispatchTable.at(index.value()) = action;
+        }
     }
 
     Microsoft::Terminal::Settings::KeyChord AppKeyBindings::GetKeyBinding(TerminalApp::ShortcutAction const& action)
@@ -33,15 +38,39 @@ namespace winrt::TerminalApp::implementation
 
     bool AppKeyBindings::TryKeyChord(const Settings::KeyChord& kc)
     {
-        const auto keyIter = _keyShortcuts.find(kc);
-        if (keyIter != _keyShortcuts.end())
+        // This runs for every key that's pressed, so it looks in the dispatch
+        // table rather than hashing the chord into _keyShortcuts.
+        const auto index = _DispatchTableIndex(kc.Vkey(), kc.Modifiers());
+        if (!index)
+        {
+            return false;
+        }
+
+        const auto action = _dispatchTable.at(index.value());
+        if (action)
         {
-            const auto action = keyIter->second;
-            return _DoAction(action);
+            return _DoAction(action.value());
         }
         return false;
     }
 
+    // Method Description:
+    // - Finds where the binding for the given key and modifiers lives in the dispatch table.
+    // Arguments:
+    // - vkey: the virtual key of the chord
+    // - modifiers: the modifier keys of the chord
+    // Return Value:
+    // - the index into _dispatchTable, or nullopt if there's no room for the chord in it
+    std::optional<size_t> AppKeyBindings::_DispatchTableIndex(const int32_t vkey, const Settings::KeyModifiers modifiers) noexcept
+    {
+        const auto modifierBits = static_cast<size_t>(modifiers);
+        if (vkey < 0 || static_cast<size_t>(vkey) >= DispatchTableKeys || modifierBits >= DispatchTableModifiers)
+        {
+            return std::nullopt;
+        }
+        return modifierBits * DispatchTableKeys + static_cast<size_t>(vkey);
+    }
+
     bool AppKeyBindings::_DoAction(ShortcutAction action)
     {
         switch (action)
@@ -64,6 +93,9 @@ namespace winrt::TerminalApp::implementation
         case ShortcutAction::OpenSettings:
             _OpenSettingsHandlers();
             return true;
+        case ShortcutAction::TogglePerformanceOverlay:
+            _TogglePerformanceOverlayHandlers();
+            return true;
 
         case ShortcutAction::NewTabProfile0:
             _NewTabWithProfileHandlers(0);
@@ -267,5 +299,6 @@ namespace winrt::TerminalApp::implementation
     DEFINE_EVENT(AppKeyBindings, OpenSettings,      _OpenSettingsHandlers,      TerminalApp::OpenSettingsEventArgs);
     DEFINE_EVENT(AppKeyBindings, ResizePane,        _ResizePaneHandlers,        TerminalApp::ResizePaneEventArgs);
     DEFINE_EVENT(AppKeyBindings, MoveFocus,         _MoveFocusHandlers,         TerminalApp::MoveFocusEventArgs);
+    DEFINE_EVENT(AppKeyBindings, TogglePerformanceOverlay, _TogglePerformanceOverlayHandlers, TerminalApp::TogglePerformanceOverlayEventArgs);
     // clang-format on
 }
@@ -63,10 +63,20 @@ namespace winrt::TerminalApp::implementation
         DECLARE_EVENT(OpenSettings,      _OpenSettingsHandlers,      TerminalApp::OpenSettingsEventArgs);
         DECLARE_EVENT(ResizePane,        _ResizePaneHandlers,        TerminalApp::ResizePaneEventArgs);
         DECLARE_EVENT(MoveFocus,         _MoveFocusHandlers,         TerminalApp::MoveFocusEventArgs);
+        DECLARE_EVENT(TogglePerformanceOverlay, _TogglePerformanceOverlayHandlers, TerminalApp::TogglePerformanceOverlayEventArgs);
         // clang-format on
 
     private:
         std::unordered_map<winrt::Microsoft::Terminal::Settings::KeyChord, TerminalApp::ShortcutAction, KeyChordHash, KeyChordEquality> _keyShortcuts;
+
+        // The same bindings as _keyShortcuts, laid out by (modifiers, vkey) so that
+        // looking up a keystroke is a single index. Every modifier combination gets
+        // a row of all 256 virtual keys.
+        static constexpr size_t DispatchTableKeys = 256;
+        static constexpr size_t DispatchTableModifiers = 8;
+        std::array<std::optional<TerminalApp::ShortcutAction>, DispatchTableKeys * DispatchTableModifiers> _dispatchTable{};
+        static std::optional<size_t> _DispatchTableIndex(const int32_t vkey, const winrt::Microsoft::Terminal::Settings::KeyModifiers modifiers) noexcept;
+
         bool _DoAction(ShortcutAction action);
     };
 }
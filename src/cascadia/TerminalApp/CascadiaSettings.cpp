@@ -421,6 +421,8 @@ const Profile* CascadiaSettings::FindProfile(GUID profileGuid) const noexcept
 //      profile.
 //   The TerminalSettings object that is created can be used to initialize both
 //      the Control's settings, and the Core settings of the terminal.
+//   It's only made once per profile, and everyone asking for that profile
+//      gets the same one. Anyone who wants to change it should Clone it first.
 // Arguments:
 // - profileGuidArg: an optional GUID to use to lookup the profile to create the
 //      settings from. If this arg is not provided, or the GUID does not match a
@@ -430,6 +432,16 @@ const Profile* CascadiaSettings::FindProfile(GUID profileGuid) const noexcept
 TerminalSettings CascadiaSettings::MakeSettings(std::optional<GUID> profileGuidArg) const
 {
     GUID profileGuid = profileGuidArg ? profileGuidArg.value() : _globals.GetDefaultProfile();
+
+    std::lock_guard<std::mutex> guard{ _terminalSettingsLock };
+    for (const auto& [guid, settings] : _terminalSettings)
+    {
+        if (guid == profileGuid)
+        {
+            return settings;
+        }
+    }
+
     const Profile* const profile = FindProfile(profileGuid);
     if (profile == nullptr)
     {
@@ -441,6 +453,7 @@ TerminalSettings CascadiaSettings::MakeSettings(std::optional<GUID> profileGuidA
     // Place our appropriate global settings into the Terminal Settings
     _globals.ApplyToSettings(result);
 
+    _terminalSettings.emplace_back(profileGuid, result);
     return result;
 }
 
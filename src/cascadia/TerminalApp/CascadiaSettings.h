@@ -45,6 +45,8 @@ public:
     Json::Value ToJson() const;
     static std::unique_ptr<CascadiaSettings> FromJson(const Json::Value& json);
 
+    std::vector<GUID> GetProfilesChangedSince(const Json::Value& previousJson) const;
+
     static std::wstring GetSettingsPath();
 
     const Profile* FindProfile(GUID profileGuid) const noexcept;
@@ -55,6 +57,11 @@ private:
     GlobalAppSettings _globals;
     std::vector<Profile> _profiles;
 
+    // The TerminalSettings made for each profile so far. Every tab and pane with
+    // a profile shares its settings; a control that changes them makes a copy.
+    mutable std::mutex _terminalSettingsLock;
+    mutable std::vector<std::pair<GUID, winrt::Microsoft::Terminal::Settings::TerminalSettings>> _terminalSettings;
+
     void _CreateDefaultKeybindings();
     void _CreateDefaultSchemes();
     void _CreateDefaultProfiles();
@@ -62,6 +69,10 @@ private:
     static bool _IsPackaged();
     static void _WriteSettings(const std::string_view content);
     static std::optional<std::string> _ReadSettings();
+    static void _WriteFile(const std::wstring& path, const std::string_view content);
+    static std::optional<std::string> _ReadFile(const std::wstring& path);
+    static std::wstring _GetUpToDateStampPath();
+    static std::string _MakeUpToDateStamp(const std::string_view fileData);
 
     static bool _isPowerShellCoreInstalledInPath(const std::wstring_view programFileEnv, std::filesystem::path& cmdline);
     static bool _isPowerShellCoreInstalled(std::filesystem::path& cmdline);
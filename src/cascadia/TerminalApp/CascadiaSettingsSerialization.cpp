@@ -15,6 +15,7 @@ using namespace winrt::TerminalApp;
 using namespace ::Microsoft::Console;
 
 static constexpr std::wstring_view SettingsFilename{ L"profiles.json" };
+static constexpr std::wstring_view UpToDateStampFilename{ L"profiles.json.uptodate" };
 static constexpr std::wstring_view UnpackagedSettingsFolderName{ L"Microsoft\\Windows Terminal\\" };
 
 static constexpr std::string_view ProfilesKey{ "profiles" };
@@ -24,6 +25,10 @@ static constexpr std::string_view SchemesKey{ "schemes" };
 
 static constexpr std::string_view Utf8Bom{ u8"\uFEFF" };
 
+// Bump this whenever what we serialize changes, so that settings files that were
+// up to date with the old schema get compared (and rewritten) again.
+static constexpr int SettingsSchemaVersion = 1;
+
 // Method Description:
 // - Creates a CascadiaSettings from whatever's saved on disk, or instantiates
 //      a new one with the default values. If we're running as a packaged app,
@@ -70,16 +75,28 @@ std::unique_ptr<CascadiaSettings> CascadiaSettings::LoadAll(const bool saveOnLoa
             throw winrt::hresult_invalid_argument();
         }
 
-        if (saveOnLoad)
+        // Reserializing everything just to compare it is only worth it if the
+        // file changed since the last time we found it to be up to date.
+        const auto stamp = _MakeUpToDateStamp(actualData);
+        if (saveOnLoad && _ReadFile(_GetUpToDateStampPath()) != stamp)
         {
             // Logically compare the json we've parsed from the file to what
             // we'd serialize at runtime. If the values are different, then
-            // write the updated schema back out.
+            // write the updated schema back out. It's stamped on the next load.
             const Json::Value reserialized = resultPtr->ToJson();
             if (reserialized != root)
             {
                 resultPtr->SaveAll();
             }
+            else
+            {
+                // Not being able to stamp the file only costs us the comparison next time.
+                try
+                {
+                    _WriteFile(_GetUpToDateStampPath(), stamp);
+                }
+                CATCH_LOG();
+            }
         }
     }
     else
@@ -143,6 +160,45 @@ Json::Value CascadiaSettings::ToJson() const
     return root;
 }
 
+// Method Description:
+// - Finds the profiles whose terminal settings could have changed since the
+//   given settings. A profile has changed if its own values did, or if the
+//   globals or color schemes that every profile's settings draw from did.
+//   Keybindings don't go into a profile's settings, so they don't count.
+// Arguments:
+// - previousJson: the earlier settings, as serialized by ToJson
+// Return Value:
+// - the GUIDs of the profiles that are new or have changed
+std::vector<GUID> CascadiaSettings::GetProfilesChangedSince(const Json::Value& previousJson) const
+{
+    const auto json = ToJson();
+
+    auto globals = json[GlobalsKey.data()];
+    auto previousGlobals = previousJson[GlobalsKey.data()];
+    globals.removeMember(KeybindingsKey.data());
+    previousGlobals.removeMember(KeybindingsKey.data());
+
+    const bool allChanged = globals != previousGlobals ||
+                            json[SchemesKey.data()] != previousJson[SchemesKey.data()];
+
+    std::vector<GUID> changed;
+    const auto& previousProfiles = previousJson[ProfilesKey.data()];
+    for (const auto& profile : _profiles)
+    {
+        const auto profileJson = profile.ToJson();
+        const bool unchanged = !allChanged &&
+                               std::any_of(previousProfiles.begin(), previousProfiles.end(), [&](const auto& previous) {
+                                   return previous == profileJson;
+                               });
+        if (!unchanged)
+        {
+            changed.push_back(profile.GetGuid());
+        }
+    }
+
+    return changed;
+}
+
 // Method Description:
 // - Create a new instance of this class from a serialized JsonObject.
 // Arguments:
@@ -239,9 +295,36 @@ bool CascadiaSettings::_IsPackaged()
 //      fail to write the file
 void CascadiaSettings::_WriteSettings(const std::string_view content)
 {
-    auto pathToSettingsFile{ CascadiaSettings::GetSettingsPath() };
+    _WriteFile(CascadiaSettings::GetSettingsPath(), content);
+}
+
+// Method Description:
+// - Reads the content in UTF-8 encoding of our settings file using the Win32 APIs
+// Arguments:
+// - <none>
+// Return Value:
+// - an optional with the content of the file if we were able to open it,
+//      otherwise the optional will be empty.
+//   If the file exists, but we fail to read it, this can throw an exception
+//      from reading the file
+std::optional<std::string> CascadiaSettings::_ReadSettings()
+{
+    return _ReadFile(CascadiaSettings::GetSettingsPath());
+}
 
-    auto hOut = CreateFileW(pathToSettingsFile.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+// Method Description:
+// - Writes the given content to the given file using the Win32 APIs.
+//   Will overwrite any existing content in the file.
+// Arguments:
+// - path: the file to write
+// - content: the given string of content to write to the file.
+// Return Value:
+// - <none>
+//   This can throw an exception if we fail to open the file for writing, or we
+//      fail to write the file
+void CascadiaSettings::_WriteFile(const std::wstring& path, const std::string_view content)
+{
+    auto hOut = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
     if (hOut == INVALID_HANDLE_VALUE)
     {
         THROW_LAST_ERROR();
@@ -251,22 +334,21 @@ void CascadiaSettings::_WriteSettings(const std::string_view content)
 }
 
 // Method Description:
-// - Reads the content in UTF-8 encoding of our settings file using the Win32 APIs
+// - Reads the content of the given file using the Win32 APIs
 // Arguments:
-// - <none>
+// - path: the file to read
 // Return Value:
 // - an optional with the content of the file if we were able to open it,
 //      otherwise the optional will be empty.
 //   If the file exists, but we fail to read it, this can throw an exception
 //      from reading the file
-std::optional<std::string> CascadiaSettings::_ReadSettings()
+std::optional<std::string> CascadiaSettings::_ReadFile(const std::wstring& path)
 {
-    auto pathToSettingsFile{ CascadiaSettings::GetSettingsPath() };
-    const auto hFile = CreateFileW(pathToSettingsFile.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    const auto hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
     if (hFile == INVALID_HANDLE_VALUE)
     {
         // If the file doesn't exist, that's fine. Just log the error and return
-        //      nullopt - we'll create the defaults.
+        //      nullopt - the caller decides what to do without it.
         LOG_LAST_ERROR();
         return std::nullopt;
     }
@@ -287,6 +369,32 @@ std::optional<std::string> CascadiaSettings::_ReadSettings()
     return { utf8string };
 }
 
+// function Description:
+// - Returns the full path to the file that remembers the last settings file we
+//   found to be up to date, next to the settings file itself.
+// Arguments:
+// - <none>
+// Return Value:
+// - the full path to the stamp file
+std::wstring CascadiaSettings::_GetUpToDateStampPath()
+{
+    std::filesystem::path path{ CascadiaSettings::GetSettingsPath() };
+    path.replace_filename(UpToDateStampFilename);
+    return path;
+}
+
+// function Description:
+// - Makes the stamp we keep for a settings file that doesn't need rewriting.
+//   It changes when the file does, or when the schema we write does.
+// Arguments:
+// - fileData: the content of the settings file
+// Return Value:
+// - the stamp for that content
+std::string CascadiaSettings::_MakeUpToDateStamp(const std::string_view fileData)
+{
+    return std::to_string(SettingsSchemaVersion) + ":" + std::to_string(std::hash<std::string_view>{}(fileData));
+}
+
 // function Description:
 // - Returns the full path to the settings file, either within the application
 //   package, or in its unpackaged location.
@@ -457,6 +457,29 @@ void Pane::UpdateFocus()
     }
 }
 
+// Method Description:
+// - Stops or resumes painting in the controls of this pane and all its
+//   descendants, for when the tab they're in is hidden or shown.
+// Arguments:
+// - enabled: false to stop painting, true to resume it
+// Return Value:
+// - <none>
+void Pane::SetPaintingEnabled(const bool enabled)
+{
+    if (_IsLeaf())
+    {
+        if (_control)
+        {
+            _control.SetPaintingEnabled(enabled);
+        }
+    }
+    else
+    {
+        _firstChild->SetPaintingEnabled(enabled);
+        _secondChild->SetPaintingEnabled(enabled);
+    }
+}
+
 // Method Description:
 // - Focuses this control if we're a leaf, or attempts to focus the first leaf
 //   of our first child, recursively.
@@ -673,6 +696,8 @@ void Pane::_SetupChildCloseHandlers()
 //   each of the child panes, and are given a size in pixels, based off the
 //   availiable space, and the percent of the space they respectively consume,
 //   which is stored in _firstPercent and _secondPercent.
+// - If the row/cols are already there, only their sizes are changed, so that
+//   the grid's layout isn't thrown away every time we're resized.
 // - Does nothing if our split state is currently set to SplitState::None
 // Arguments:
 // - rootSize: The dimensions in pixels that this pane (and its children should consume.)
@@ -682,7 +707,16 @@ void Pane::_CreateRowColDefinitions(const Size& rootSize)
 {
     if (_splitState == SplitState::Vertical)
     {
-        _root.ColumnDefinitions().Clear();
+        auto columns = _root.ColumnDefinitions();
+        if (columns.Size() == 3)
+        {
+            const auto paneSizes = _GetPaneSizes(rootSize.Width);
+            columns.GetAt(0).Width(GridLengthHelper::FromPixels(paneSizes.first));
+            columns.GetAt(2).Width(GridLengthHelper::FromPixels(paneSizes.second));
+            return;
+        }
+
+        columns.Clear();
 
         // Create three columns in this grid: one for each pane, and one for the separator.
         auto separatorColDef = Controls::ColumnDefinition();
@@ -702,7 +736,16 @@ void Pane::_CreateRowColDefinitions(const Size& rootSize)
     }
     else if (_splitState == SplitState::Horizontal)
     {
-        _root.RowDefinitions().Clear();
+        auto rows = _root.RowDefinitions();
+        if (rows.Size() == 3)
+        {
+            const auto paneSizes = _GetPaneSizes(rootSize.Height);
+            rows.GetAt(0).Height(GridLengthHelper::FromPixels(paneSizes.first));
+            rows.GetAt(2).Height(GridLengthHelper::FromPixels(paneSizes.second));
+            return;
+        }
+
+        rows.Clear();
 
         // Create three rows in this grid: one for each pane, and one for the separator.
         auto separatorRowDef = Controls::RowDefinition();
@@ -43,6 +43,7 @@ public:
 
     bool WasLastFocused() const noexcept;
     void UpdateFocus();
+    void SetPaintingEnabled(const bool enabled);
 
     void UpdateSettings(const winrt::Microsoft::Terminal::Settings::TerminalSettings& settings, const GUID& profile);
     void ResizeContent(const winrt::Windows::Foundation::Size& newSize);
@@ -21,6 +21,8 @@ static constexpr std::string_view BackgroundKey{ "background" };
 static constexpr std::string_view ColorTableKey{ "colorTable" };
 static constexpr std::string_view TabTitleKey{ "tabTitle" };
 static constexpr std::string_view HistorySizeKey{ "historySize" };
+static constexpr std::string_view ScrollbackMemoryBudgetKey{ "scrollbackMemoryBudget" };
+static constexpr std::string_view ScrollbackArchiveKey{ "scrollbackArchive" };
 static constexpr std::string_view SnapOnInputKey{ "snapOnInput" };
 static constexpr std::string_view CursorColorKey{ "cursorColor" };
 static constexpr std::string_view CursorShapeKey{ "cursorShape" };
@@ -72,6 +74,8 @@ Profile::Profile(const winrt::guid& guid) :
     _colorTable{},
     _tabTitle{},
     _historySize{ DEFAULT_HISTORY_SIZE },
+    _scrollbackMemoryBudget{},
+    _scrollbackArchive{},
     _snapOnInput{ true },
     _cursorColor{ DEFAULT_CURSOR_COLOR },
     _cursorShape{ CursorStyle::Bar },
@@ -140,6 +144,12 @@ TerminalSettings Profile::CreateTerminalSettings(const std::vector<ColorScheme>&
         terminalSettings.SetColorTableEntry(i, _colorTable[i]);
     }
     terminalSettings.HistorySize(_historySize);
+    terminalSettings.ScrollbackMemoryBudget(_scrollbackMemoryBudget.value_or(0));
+    if (_scrollbackArchive)
+    {
+        const auto evaluatedPath = Profile::EvaluateScrollbackArchivePath(_scrollbackArchive.value());
+        terminalSettings.ScrollbackArchivePath(winrt::to_hstring(evaluatedPath.c_str()));
+    }
     terminalSettings.SnapOnInput(_snapOnInput);
     terminalSettings.CursorColor(_cursorColor);
     terminalSettings.CursorHeight(_cursorHeight);
@@ -276,6 +286,16 @@ Json::Value Profile::ToJson() const
         root[JsonKey(TabTitleKey)] = winrt::to_string(_tabTitle.value());
     }
 
+    if (_scrollbackMemoryBudget)
+    {
+        root[JsonKey(ScrollbackMemoryBudgetKey)] = _scrollbackMemoryBudget.value();
+    }
+
+    if (_scrollbackArchive)
+    {
+        root[JsonKey(ScrollbackArchiveKey)] = winrt::to_string(_scrollbackArchive.value());
+    }
+
     if (_startingDirectory)
     {
         root[JsonKey(StartingDirectoryKey)] = winrt::to_string(_startingDirectory.value());
@@ -357,6 +377,15 @@ Profile Profile::FromJson(const Json::Value& json)
         // TODO:MSFT:20642297 - Use a sentinel value (-1) for "Infinite scrollback"
         result._historySize = historySize.asInt();
     }
+    if (auto scrollbackMemoryBudget{ json[JsonKey(ScrollbackMemoryBudgetKey)] })
+    {
+        // In MB. The rows on the screen are always kept, even if they alone don't fit.
+        result._scrollbackMemoryBudget = scrollbackMemoryBudget.asUInt();
+    }
+    if (auto scrollbackArchive{ json[JsonKey(ScrollbackArchiveKey)] })
+    {
+        result._scrollbackArchive = GetWstringFromJson(scrollbackArchive);
+    }
     if (auto snapOnInput{ json[JsonKey(SnapOnInputKey)] })
     {
         result._snapOnInput = snapOnInput.asBool();
@@ -582,6 +611,22 @@ std::wstring Profile::EvaluateStartingDirectory(const std::wstring& directory)
     }
 }
 
+// Method Description:
+// - Helper function for expanding any environment variables in a user-supplied scrollback archive path
+// Arguments:
+// - The value from the profiles.json file
+// Return Value:
+// - The path with any environment variables expanded. The file doesn't have to exist yet.
+std::wstring Profile::EvaluateScrollbackArchivePath(const std::wstring& path)
+{
+    const DWORD numCharsInput = ExpandEnvironmentStrings(path.c_str(), nullptr, 0);
+    std::unique_ptr<wchar_t[]> evaluatedPath = std::make_unique<wchar_t[]>(numCharsInput);
+    THROW_LAST_ERROR_IF(0 == ExpandEnvironmentStrings(path.c_str(), evaluatedPath.get(), numCharsInput));
+
+    // The count includes the null terminator.
+    return std::wstring(evaluatedPath.get(), numCharsInput - 1);
+}
+
 // Method Description:
 // - Helper function for converting a user-specified scrollbar state to its corresponding enum
 // Arguments:
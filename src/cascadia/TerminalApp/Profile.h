@@ -58,6 +58,7 @@ public:
 
 private:
     static std::wstring EvaluateStartingDirectory(const std::wstring& directory);
+    static std::wstring EvaluateScrollbackArchivePath(const std::wstring& path);
 
     static winrt::Microsoft::Terminal::Settings::ScrollbarState ParseScrollbarState(const std::wstring& scrollbarState);
     static winrt::Windows::UI::Xaml::Media::Stretch ParseImageStretchMode(const std::string_view imageStretchMode);
@@ -76,6 +77,8 @@ private:
     std::array<uint32_t, COLOR_TABLE_SIZE> _colorTable;
     std::optional<std::wstring> _tabTitle;
     int32_t _historySize;
+    std::optional<uint32_t> _scrollbackMemoryBudget;
+    std::optional<std::wstring> _scrollbackArchive;
     bool _snapOnInput;
     uint32_t _cursorColor;
     uint32_t _cursorHeight;
@@ -70,6 +70,7 @@ bool Tab::IsFocused() const noexcept
 // Method Description:
 // - Updates our focus state. If we're gaining focus, make sure to transfer
 //   focus to the last focused terminal control in our tree of controls.
+//   Our controls only paint while we're focused, since we can't be seen otherwise.
 // Arguments:
 // - focused: our new focus state. If true, we should be focused. If false, we
 //   should be unfocused.
@@ -78,6 +79,7 @@ bool Tab::IsFocused() const noexcept
 void Tab::SetFocused(const bool focused)
 {
     _focused = focused;
+    _rootPane->SetPaintingEnabled(_focused);
 
     if (_focused)
     {
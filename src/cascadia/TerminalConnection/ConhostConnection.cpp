@@ -16,6 +16,7 @@
 #include <conpty-universal.h>
 #include "../../types/inc/Utils.hpp"
 #include "../../types/inc/UTF8OutPipeReader.hpp"
+#include "../../types/inc/convert.hpp"
 
 using namespace ::Microsoft::Console;
 
@@ -122,6 +123,11 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
                                           0,
                                           nullptr));
 
+        // Input is written from the thread pool, so that a client that isn't reading its
+        // input can't hold up whoever hands it to us, without a thread of our own for it.
+        _inputWork.reset(CreateThreadpoolWork(s_WriteInputCallback, this, nullptr));
+        THROW_LAST_ERROR_IF_NULL(_inputWork);
+
         // Wind up the conhost! We only do this after we've got everything in place.
         THROW_LAST_ERROR_IF(-1 == ResumeThread(_piConhost.hThread));
 
@@ -136,9 +142,18 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         }
 
         // convert from UTF-16LE to UTF-8 as ConPty expects UTF-8
-        std::string str = winrt::to_string(data);
-        bool fSuccess = !!WriteFile(_inPipe.get(), str.c_str(), (DWORD)str.length(), nullptr, nullptr);
-        fSuccess;
+        // The input work writes it to the pipe, along with anything else that's queued by then.
+        bool submit = false;
+        {
+            std::lock_guard<std::mutex> guard{ _pendingInputLock };
+            _pendingInput.append(winrt::to_string(data));
+            submit = !std::exchange(_inputWriteQueued, true);
+        }
+
+        if (submit)
+        {
+            SubmitThreadpoolWork(_inputWork.get());
+        }
     }
 
     void ConhostConnection::Resize(uint32_t rows, uint32_t columns)
@@ -166,6 +181,25 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
             // It is imperative that the signal pipe be closed first; this triggers the
             // pseudoconsole host's teardown. See PtySignalInputThread.cpp.
             _signalPipe.reset();
+
+            // Let any input that's being written finish before its pipe goes away. A write
+            // to a client that stopped reading would block for good, so it's cancelled. The
+            // writer may not have reached WriteFile yet, so keep at it until it's done.
+            for (;;)
+            {
+                {
+                    std::lock_guard<std::mutex> guard{ _inputWriterLock };
+                    if (!_inputWriter)
+                    {
+                        break;
+                    }
+                    CancelSynchronousIo(_inputWriter.get());
+                }
+                Sleep(1);
+            }
+            WaitForThreadpoolWorkCallbacks(_inputWork.get(), TRUE);
+            _inputWork.reset();
+
             _inPipe.reset();
             _outPipe.reset();
 
@@ -182,6 +216,51 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         }
     }
 
+    void CALLBACK ConhostConnection::s_WriteInputCallback(PTP_CALLBACK_INSTANCE /*instance*/, PVOID context, PTP_WORK /*work*/) noexcept
+    {
+        ConhostConnection* const pInstance = (ConhostConnection*)context;
+        pInstance->_WriteQueuedInput();
+    }
+
+    // Method Description:
+    // - Writes whatever input has been queued in one go, and keeps going until there's
+    //   none left. Only one of these runs at a time, so the input stays in order.
+    void ConhostConnection::_WriteQueuedInput() noexcept
+    {
+        // Let Close find this thread to cancel a write that's stuck.
+        {
+            std::lock_guard<std::mutex> guard{ _inputWriterLock };
+            if (_closing.load())
+            {
+                return;
+            }
+            _inputWriter.reset(OpenThread(THREAD_TERMINATE, FALSE, GetCurrentThreadId()));
+            LOG_LAST_ERROR_IF(!_inputWriter);
+        }
+        auto forgetWriter = wil::scope_exit([&]() noexcept {
+            std::lock_guard<std::mutex> guard{ _inputWriterLock };
+            _inputWriter.reset();
+        });
+
+        std::string input;
+        while (!_closing.load())
+        {
+            {
+                std::lock_guard<std::mutex> guard{ _pendingInputLock };
+                if (_pendingInput.empty())
+                {
+                    _inputWriteQueued = false;
+                    return;
+                }
+                input.swap(_pendingInput);
+            }
+
+            DWORD written = 0;
+            LOG_IF_WIN32_BOOL_FALSE(WriteFile(_inPipe.get(), input.data(), gsl::narrow_cast<DWORD>(input.size()), &written, nullptr));
+            input.clear();
+        }
+    }
+
     DWORD WINAPI ConhostConnection::StaticOutputThreadProc(LPVOID lpParameter)
     {
         ConhostConnection* const pInstance = (ConhostConnection*)lpParameter;
@@ -192,6 +271,9 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
     {
         UTF8OutPipeReader pipeReader{ _outPipe.get() };
         std::string_view strView{};
+        // UTF-8 never needs more UTF-16 units than it has bytes, so once this is as long as
+        // the longest chunk read, every chunk can be decoded straight into it in one pass.
+        std::wstring wstr;
 
         // process the data of the output pipe in a loop
         while (true)
@@ -215,7 +297,13 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
             }
 
             // Convert buffer to hstring
-            auto hstr{ winrt::to_hstring(strView) };
+            if (wstr.size() < strView.size())
+            {
+                wstr.resize(strView.size());
+            }
+            size_t written;
+            THROW_IF_FAILED(ConvertUtf8ToW(strView, { wstr.data(), gsl::narrow_cast<ptrdiff_t>(wstr.size()) }, false, written));
+            const winrt::hstring hstr{ wstr.data(), gsl::narrow_cast<winrt::hstring::size_type>(written) };
 
             // Pass the output to our registered event handlers
             _outputHandlers(hstr);
@@ -39,11 +39,24 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         wil::unique_hfile _outPipe; // The pipe for reading output from
         wil::unique_hfile _signalPipe;
         wil::unique_handle _hOutputThread;
+
+        // Input waiting to be written by _inputWork. It's only locked to add to it or to take all of it.
+        std::mutex _pendingInputLock;
+        std::string _pendingInput;
+        bool _inputWriteQueued{ false };
+        wil::unique_threadpool_work _inputWork;
+
+        // The thread running _inputWork, while it runs. Close cancels its writes.
+        std::mutex _inputWriterLock;
+        wil::unique_handle _inputWriter;
         wil::unique_process_information _piConhost;
         wil::unique_handle _hJob;
 
         static DWORD WINAPI StaticOutputThreadProc(LPVOID lpParameter);
         DWORD _OutputThread();
+
+        static void CALLBACK s_WriteInputCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work) noexcept;
+        void _WriteQueuedInput() noexcept;
     };
 }
 
@@ -6,6 +6,9 @@
 
 #include <Windows.h>
 
+#include "../../types/inc/UTF8OutPipeReader.hpp"
+#include "../../types/inc/convert.hpp"
+
 namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 {
     ConptyConnection::ConptyConnection(hstring const& commandline,
@@ -96,6 +99,9 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         throw hresult_not_implemented();
     }
 
+    // How much the output pipe holds before the pseudoconsole has to wait for us to read it.
+    static constexpr DWORD OutputPipeSize = 64 * 1024;
+
     // Function Description:
     // - Sample function which combines the creation of some basic anonymous pipes
     //      and passes them to CreatePseudoConsole.
@@ -127,7 +133,9 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         }
         if (SUCCEEDED(hr))
         {
-            if (!CreatePipe(&outPipeOurSide, &outPipePseudoConsoleSide, NULL, 0))
+            // Give the output pipe room for a whole read of ours, so the pseudoconsole
+            // doesn't have to wait for us after every few KB it writes.
+            if (!CreatePipe(&outPipeOurSide, &outPipePseudoConsoleSide, NULL, OutputPipeSize))
             {
                 hr = HRESULT_FROM_WIN32(GetLastError());
             }
@@ -228,21 +236,32 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
     DWORD ConptyConnection::_OutputThread()
     {
-        BYTE buffer[256];
-        DWORD dwRead;
+        // The reader keeps UTF-8 sequences that a read cuts in half for the next read,
+        // so each chunk can be converted on its own, straight from the read buffer.
+        UTF8OutPipeReader pipeReader{ _outPipe };
+        std::string_view strView{};
+        // UTF-8 never needs more UTF-16 units than it has bytes, so once this is as long as
+        // the longest chunk read, every chunk can be decoded straight into it in one pass.
+        std::wstring wstr;
+
         while (true)
         {
-            dwRead = 0;
-            bool fSuccess = false;
-
-            fSuccess = !!ReadFile(_outPipe, buffer, ARRAYSIZE(buffer), &dwRead, nullptr);
+            const HRESULT result = pipeReader.Read(strView);
+            THROW_IF_FAILED(result);
 
-            THROW_LAST_ERROR_IF(!fSuccess);
+            if (result == S_FALSE || strView.empty())
+            {
+                return 0;
+            }
 
             // Convert buffer to hstring
-            char* pchStr = (char*)(buffer);
-            std::string str{ pchStr, dwRead };
-            auto hstr = winrt::to_hstring(str);
+            if (wstr.size() < strView.size())
+            {
+                wstr.resize(strView.size());
+            }
+            size_t written;
+            THROW_IF_FAILED(ConvertUtf8ToW(strView, { wstr.data(), gsl::narrow_cast<ptrdiff_t>(wstr.size()) }, false, written));
+            const winrt::hstring hstr{ wstr.data(), gsl::narrow_cast<winrt::hstring::size_type>(written) };
 
             // Pass the output to our registered event handlers
             _outputHandlers(hstr);
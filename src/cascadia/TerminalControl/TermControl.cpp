@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "TermControl.h"
+#include "TermControlAutomationPeer.h"
 #include <argb.h>
 #include <DefaultSettings.h>
 #include <unicode.hpp>
@@ -19,6 +20,12 @@ using namespace winrt::Windows::UI::Core;
 using namespace winrt::Windows::System;
 using namespace winrt::Microsoft::Terminal::Settings;
 
+// How long the size has to stay put before the connection is told about it.
+static constexpr std::chrono::milliseconds ConnectionResizeDelay{ 100 };
+
+// How often the performance overlay is brought up to date while it's shown.
+static constexpr std::chrono::milliseconds PerformanceOverlayInterval{ 1000 };
+
 namespace winrt::Microsoft::Terminal::TerminalControl::implementation
 {
     TermControl::TermControl() :
@@ -48,10 +55,11 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
 
     void TermControl::_Create()
     {
-        // Create a dummy UserControl to use as the "root" of our control we'll
-        //      build manually.
-        Controls::UserControl myControl;
-        _controlRoot = myControl;
+        // Create a UserControl to use as the "root" of our control we'll
+        //      build manually. It's what UIA clients see of us.
+        _controlRoot = winrt::make<TermControlRoot>([this]() {
+            return winrt::make<TermControlAutomationPeer>(_controlRoot, get_weak()).as<Automation::Peers::AutomationPeer>();
+        }).as<Controls::UserControl>();
 
         Controls::Grid container;
 
@@ -107,6 +115,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         _controlRoot.Content(_root);
 
         _ApplyUISettings();
+        _InitializeFontFromSettings();
 
         // These are important:
         // 1. When we get tapped, focus us
@@ -135,17 +144,32 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
     // - <none>
     void TermControl::UpdateSettings(Settings::IControlSettings newSettings)
     {
+        // These are shared with the other controls of the profile, like the first ones were.
+        _ownsSettings = false;
+
+        // Creating the font again and laying the buffer out anew is only worth it
+        // when the font is what changed.
+        const bool fontChanged = newSettings.FontFace() != _settings.FontFace() ||
+                                 newSettings.FontSize() != _settings.FontSize();
         _settings = newSettings;
 
         // Dispatch a call to the UI thread to apply the new settings to the
         // terminal.
-        _root.Dispatcher().RunAsync(CoreDispatcherPriority::Normal, [this]() {
+        _root.Dispatcher().RunAsync(CoreDispatcherPriority::Normal, [this, fontChanged]() {
             // Update our control settings
             _ApplyUISettings();
             // Update the terminal core with its new Core settings
             _terminal->UpdateSettings(_settings);
 
+            if (!fontChanged)
+            {
+                // Colors and the like are all that changed, and nothing has to move.
+                _renderer->TriggerRedrawAll();
+                return;
+            }
+
             // Refresh our font with the renderer
+            _InitializeFontFromSettings();
             _UpdateFont();
 
             const auto width = _swapChainPanel.ActualWidth();
@@ -161,6 +185,28 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         });
     }
 
+    // Method Description:
+    // - Makes sure our _settings are ours alone before we change them. The
+    //   settings we're given are shared with every other control made from the
+    //   same profile, so the first change is made to a copy of them.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void TermControl::_EnsureOwnSettings()
+    {
+        if (_ownsSettings)
+        {
+            return;
+        }
+
+        if (const auto shared = _settings.try_as<Settings::TerminalSettings>())
+        {
+            _settings = shared.Clone();
+        }
+        _ownsSettings = true;
+    }
+
     // Method Description:
     // - Style our UI elements based on the values in our _settings, and set up
     //   other control-specific settings. This method will be called whenever
@@ -169,6 +215,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
     //     for the control's background
     //   * Calls _BackgroundColorChanged to style the background of the control
     // - Core settings will be passed to the terminal in _InitializeTerminal
+    // - The font is set up separately, in _InitializeFontFromSettings
     // Arguments:
     // - <none>
     // Return Value:
@@ -180,10 +227,21 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         uint32_t bg = _settings.DefaultBackground();
         _BackgroundColorChanged(bg);
 
-        // Apply padding as swapChainPanel's margin
+        // Apply padding as swapChainPanel's margin. If it changes, the panel
+        // changes size, and the buffer is resized along with it.
         auto thickness = _ParseThicknessFromPadding(_settings.Padding());
         _swapChainPanel.Margin(thickness);
+    }
 
+    // Method Description:
+    // - Sets up the font we'd like from the one in _settings. Which font we
+    //   actually get is only known once it's been given to the renderer.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void TermControl::_InitializeFontFromSettings()
+    {
         // Initialize our font information.
         const auto* fontFace = _settings.FontFace().c_str();
         const short fontHeight = gsl::narrow<short>(_settings.FontSize());
@@ -317,6 +375,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
 
             // Set the default background as transparent to prevent the
             // DX layer from overwriting the background image or acrylic effect
+            _EnsureOwnSettings();
             _settings.DefaultBackground(ARGB(0, R, G, B));
         });
     }
@@ -403,11 +462,9 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         const auto height = vp.Height();
         _connection.Resize(height, width);
 
-        // Override the default width and height to match the size of the swapChainPanel
-        _settings.InitialCols(width);
-        _settings.InitialRows(height);
-
-        _terminal->CreateFromSettings(_settings, renderTarget);
+        // Override the default width and height to match the size of the swapChainPanel.
+        // The size goes to the terminal directly, as our settings may be shared.
+        _terminal->CreateFromSettings(_settings, { width, height }, renderTarget);
 
         // Tell the DX Engine to notify us when the swap chain changes.
         dxEngine->SetCallback(std::bind(&TermControl::SwapChainChanged, this));
@@ -415,8 +472,14 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         THROW_IF_FAILED(dxEngine->Enable());
         _renderEngine = std::move(dxEngine);
 
+        // The connection's reader thread only queues its output. The parser work writes
+        // it to the terminal from the thread pool, so reading the pipe and parsing can
+        // overlap without every tab keeping a parser thread of its own.
+        _outputWork.reset(CreateThreadpoolWork(s_ParseOutputCallback, this, nullptr));
+        THROW_LAST_ERROR_IF_NULL(_outputWork);
+
         auto onRecieveOutputFn = [this](const hstring str) {
-            _terminal->Write(str.c_str());
+            _QueueOutput(str);
         };
         _connectionOutputEventToken = _connection.TerminalOutput(onRecieveOutputFn);
 
@@ -500,6 +563,12 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         auto pfnScrollPositionChanged = std::bind(&TermControl::_TerminalScrollPositionChanged, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
         _terminal->SetScrollPositionChangedCallback(pfnScrollPositionChanged);
 
+        // Every resize of the connection makes the client lay its screen out again
+        // and send all of it back, so only the size we end up at is passed on.
+        _connectionResizeTimer = std::make_optional(DispatcherTimer());
+        _connectionResizeTimer.value().Interval(ConnectionResizeDelay);
+        _connectionResizeTimer.value().Tick({ this, &TermControl::_ResizeConnection });
+
         // Set up blinking cursor
         int blinkTime = GetCaretBlinkTime();
         if (blinkTime != INFINITE)
@@ -1044,6 +1113,9 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
     // Method Description:
     // - Triggered when the swapchain changes size. We use this to resize the
     //      terminal buffers to match the new visible size.
+    // - A split or a close can change our size several times while the layout
+    //      settles, so the resize waits until the UI thread is done with that,
+    //      and only the last size is used.
     // Arguments:
     // - e: a SizeChangedEventArgs with the new dimensions of the SwapChainPanel
     void TermControl::_SwapChainSizeChanged(winrt::Windows::Foundation::IInspectable const& /*sender*/,
@@ -1054,11 +1126,22 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
             return;
         }
 
-        auto lock = _terminal->LockForWriting();
+        _pendingResize = e.NewSize();
+        if (std::exchange(_resizeQueued, true))
+        {
+            return;
+        }
 
-        const auto foundationSize = e.NewSize();
+        _root.Dispatcher().RunAsync(CoreDispatcherPriority::Low, [this]() {
+            _resizeQueued = false;
+            if (_closing)
+            {
+                return;
+            }
 
-        _DoResize(foundationSize.Width, foundationSize.Height);
+            auto lock = _terminal->LockForWriting();
+            _DoResize(_pendingResize.Width, _pendingResize.Height);
+        });
     }
 
     void TermControl::_SwapChainScaleChanged(Windows::UI::Xaml::Controls::SwapChainPanel const& sender,
@@ -1080,11 +1163,17 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
     void TermControl::_BlinkCursor(Windows::Foundation::IInspectable const& /* sender */,
                                    Windows::Foundation::IInspectable const& /* e */)
     {
-        if ((_closing) || (!_terminal->IsCursorBlinkingAllowed() && _terminal->IsCursorVisible()))
+        if (_closing)
+        {
+            return;
+        }
+
+        const auto state = _terminal->GetRenderState();
+        if (!state || (!state->cursorBlinkingAllowed && state->cursorVisible))
         {
             return;
         }
-        _terminal->SetCursorVisible(!_terminal->IsCursorVisible());
+        _terminal->SetCursorVisible(!state->cursorVisible);
     }
 
     // Method Description:
@@ -1128,13 +1217,58 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         const HRESULT hr = _terminal->UserResize({ vp.Width(), vp.Height() });
         if (SUCCEEDED(hr) && hr != S_FALSE)
         {
-            _connection.Resize(vp.Height(), vp.Width());
+            // Our buffer is the new size already. The connection hears about it
+            // once the size stops changing; restarting the timer puts it off.
+            _pendingConnectionSize = { vp.Width(), vp.Height() };
+            _connectionResizeTimer.value().Stop();
+            _connectionResizeTimer.value().Start();
         }
     }
 
-    void TermControl::_TerminalTitleChanged(const std::wstring_view& wstr)
+    // Method Description:
+    // - Tells the connection the size the terminal was last resized to, once it
+    //   has stayed that size for a moment.
+    // Arguments:
+    // - <none>
+    // Return Value:
+    // - <none>
+    void TermControl::_ResizeConnection(Windows::Foundation::IInspectable const& /* sender */,
+                                        Windows::Foundation::IInspectable const& /* e */)
     {
-        _titleChangedHandlers(winrt::hstring{ wstr });
+        _connectionResizeTimer.value().Stop();
+        if (_closing)
+        {
+            return;
+        }
+
+        _connection.Resize(_pendingConnectionSize.Y, _pendingConnectionSize.X);
+    }
+
+    // Method Description:
+    // - Called by the terminal, on the output path, whenever an app sets the title.
+    //   The title is passed on from the UI thread, once it's done with more pressing
+    //   work. Titles that are set before then replace the one it'll pass on, and one
+    //   that's the same as the last one passed on isn't passed on again.
+    // Arguments:
+    // - <unused> the new title. The latest one is read from the terminal instead.
+    void TermControl::_TerminalTitleChanged(const std::wstring_view& /*wstr*/)
+    {
+        if (_titleUpdatePending.exchange(true))
+        {
+            return;
+        }
+
+        _root.Dispatcher().RunAsync(CoreDispatcherPriority::Low, [this]() {
+            _titleUpdatePending.store(false);
+
+            auto title = Title();
+            if (title == _lastTitle)
+            {
+                return;
+            }
+            _lastTitle = title;
+            _titleChangedHandlers(title);
+        });
     }
 
     // Method Description:
@@ -1176,9 +1310,27 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
                                                      const int bufferSize)
     {
         // Update our scrollbar
-        _scrollBar.Dispatcher().RunAsync(CoreDispatcherPriority::Low, [=]() {
-            _ScrollbarUpdater(_scrollBar, viewTop, viewHeight, bufferSize);
-        });
+        // Only the latest position matters, so there's only ever one update waiting on the
+        // UI thread. Positions that come in before it runs replace the one it will apply.
+        {
+            std::lock_guard<std::mutex> guard{ _pendingScrollLock };
+            _pendingScroll = { viewTop, viewHeight, bufferSize };
+        }
+
+        if (!_scrollUpdatePending.exchange(true))
+        {
+            _scrollBar.Dispatcher().RunAsync(CoreDispatcherPriority::Low, [this]() {
+                _scrollUpdatePending.store(false);
+
+                ScrollState scroll;
+                {
+                    std::lock_guard<std::mutex> guard{ _pendingScrollLock };
+                    scroll = _pendingScroll;
+                }
+
+                _ScrollbarUpdater(_scrollBar, scroll.viewTop, scroll.viewHeight, scroll.bufferSize);
+            });
+        }
 
         // Set this value as our next expected scroll position.
         _lastScrollOffset = { viewTop };
@@ -1190,7 +1342,11 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         if (!_initializedTerminal)
             return L"";
 
-        hstring hstr(_terminal->GetConsoleTitle());
+        const auto state = _terminal->GetRenderState();
+        if (!state)
+            return L"";
+
+        hstring hstr(state->title);
         return hstr;
     }
 
@@ -1237,12 +1393,24 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
                 // cursorTimer timer, now stopped, is destroyed.
             }
 
+            if (auto localOverlayTimer{ std::exchange(_performanceOverlayTimer, std::nullopt) })
+            {
+                localOverlayTimer->Stop();
+            }
+
             if (auto localConnection{ std::exchange(_connection, nullptr) })
             {
                 localConnection.Close();
                 // connection is destroyed.
             }
 
+            // No more output can arrive now, so wait out any parsing that's still going.
+            if (_outputWork)
+            {
+                WaitForThreadpoolWorkCallbacks(_outputWork.get(), TRUE);
+                _outputWork.reset();
+            }
+
             if (auto localRenderEngine{ std::exchange(_renderEngine, nullptr) })
             {
                 if (auto localRenderer{ std::exchange(_renderer, nullptr) })
@@ -1261,6 +1429,88 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         }
     }
 
+    // Method Description:
+    // - Called on the connection's reader thread with each chunk of output. Adds it to the
+    //   output waiting for the parser thread and wakes that thread up.
+    // Arguments:
+    // - str: the output from the connection
+    void TermControl::_QueueOutput(const hstring& str)
+    {
+        bool submit = false;
+        {
+            std::lock_guard<std::mutex> guard{ _pendingOutputLock };
+            _pendingOutput.append(str);
+            submit = !std::exchange(_outputParseQueued, true);
+        }
+        _outputReceived.fetch_add(str.size(), std::memory_order_relaxed);
+
+        if (submit)
+        {
+            SubmitThreadpoolWork(_outputWork.get());
+        }
+    }
+
+    void CALLBACK TermControl::s_ParseOutputCallback(PTP_CALLBACK_INSTANCE /*instance*/, PVOID context, PTP_WORK /*work*/) noexcept
+    {
+        TermControl* const pInstance = static_cast<TermControl*>(context);
+        pInstance->_ParseQueuedOutput();
+    }
+
+    // Method Description:
+    // - Writes the queued output to the terminal until there's none left. Everything that
+    //   was queued while the last write was being parsed goes to the terminal in one go.
+    //   Only one of these runs at a time, so the output stays in order.
+    // - It only returns once it's found the queue empty (and so let the next chunk of output
+    //   submit it again) or the control is closing. A chunk that fails to be written is dropped.
+    void TermControl::_ParseQueuedOutput() noexcept
+    {
+        std::wstring output;
+        while (!_closing.load())
+        {
+            {
+                std::lock_guard<std::mutex> guard{ _pendingOutputLock };
+                if (_pendingOutput.empty())
+                {
+                    _outputParseQueued = false;
+                    return;
+                }
+                output.swap(_pendingOutput);
+            }
+
+            try
+            {
+                _terminal->Write(output);
+            }
+            CATCH_LOG();
+            output.clear();
+        }
+    }
+
+    // Method Description:
+    // - Stops painting while the control can't be seen, like when its tab is in the
+    //   background, and starts again when it can. Output keeps being written to the
+    //   terminal in the meantime, and all of it is painted in one go when painting resumes.
+    // Arguments:
+    // - enabled: false to stop painting, true to resume it
+    void TermControl::SetPaintingEnabled(bool enabled)
+    {
+        if (!_renderer || _closing || enabled == _paintingEnabled)
+        {
+            return;
+        }
+
+        _paintingEnabled = enabled;
+        if (enabled)
+        {
+            _renderer->TriggerRedrawAll();
+            _renderer->EnablePainting();
+        }
+        else
+        {
+            _renderer->WaitForPaintCompletionAndDisable(INFINITE);
+        }
+    }
+
     void TermControl::ScrollViewport(int viewTop)
     {
         _terminal->UserScrollViewport(viewTop);
@@ -1285,6 +1535,136 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         return _terminal->GetScrollOffset();
     }
 
+    // Method Description:
+    // - Copies the buffer for the automation peer to answer UIA clients from, so
+    //   that the terminal isn't locked while they read it.
+    // Return Value:
+    // - the copy, or nullptr once the control is closed
+    std::shared_ptr<const TextBufferSnapshot> TermControl::TakeSnapshot()
+    {
+        return _terminal ? _terminal->TakeSnapshot() : nullptr;
+    }
+
+    // Method Description:
+    // - Gets the rows of the buffer that are on the screen, without taking the terminal's lock.
+    // Return Value:
+    // - the rows, or an empty viewport once the control is closed
+    Viewport TermControl::GetVisibleRows() const
+    {
+        const auto state = _terminal ? _terminal->GetRenderState() : nullptr;
+        return state ? state->viewport : Viewport::Empty();
+    }
+
+    // Method Description:
+    // - Shows or hides a box in the top right corner with what the terminal is costing:
+    //   the output coming in, how fast it's parsed, how long writes wait for the lock,
+    //   what frames cost, and how much memory the buffer takes up.
+    // - The numbers are rates over the last second. While the overlay is hidden, nothing
+    //   is timed, and only the characters written and frames painted are counted.
+    void TermControl::TogglePerformanceOverlay()
+    {
+        if (!_terminal || !_renderer || _closing)
+        {
+            return;
+        }
+
+        if (!_performanceOverlay)
+        {
+            _performanceOverlayText = Controls::TextBlock{};
+            _performanceOverlayText.FontFamily(Media::FontFamily{ L"Consolas" });
+            _performanceOverlayText.FontSize(12);
+            _performanceOverlayText.Foreground(Media::SolidColorBrush{ winrt::Windows::UI::Color{ 255, 255, 255, 255 } });
+
+            _performanceOverlay = Controls::Border{};
+            _performanceOverlay.Background(Media::SolidColorBrush{ winrt::Windows::UI::Color{ 0xC0, 0, 0, 0 } });
+            _performanceOverlay.Padding(ThicknessHelper::FromUniformLength(6));
+            _performanceOverlay.HorizontalAlignment(HorizontalAlignment::Right);
+            _performanceOverlay.VerticalAlignment(VerticalAlignment::Top);
+            _performanceOverlay.IsHitTestVisible(false);
+            _performanceOverlay.Visibility(Visibility::Collapsed);
+            _performanceOverlay.Child(_performanceOverlayText);
+            _root.Children().Append(_performanceOverlay);
+
+            _performanceOverlayTimer = std::make_optional(DispatcherTimer());
+            _performanceOverlayTimer.value().Interval(PerformanceOverlayInterval);
+            _performanceOverlayTimer.value().Tick({ this, &TermControl::_UpdatePerformanceOverlay });
+        }
+
+        const bool show = _performanceOverlay.Visibility() != Visibility::Visible;
+        _terminal->EnablePerformanceCounters(show);
+        if (show)
+        {
+            _lastPerformanceSample = _TakePerformanceSample();
+            _performanceOverlayText.Text(L"Measuring...");
+            _performanceOverlay.Visibility(Visibility::Visible);
+            _performanceOverlayTimer.value().Start();
+        }
+        else
+        {
+            _performanceOverlayTimer.value().Stop();
+            _performanceOverlay.Visibility(Visibility::Collapsed);
+        }
+    }
+
+    // Method Description:
+    // - Reads all the counters the performance overlay shows, as of now.
+    TermControl::PerformanceSample TermControl::_TakePerformanceSample()
+    {
+        PerformanceSample sample{};
+        sample.time = std::chrono::steady_clock::now();
+        sample.outputReceived = _outputReceived.load(std::memory_order_relaxed);
+        sample.terminal = _terminal->GetPerformanceCounters();
+        sample.frames = _renderer->GetFrameCounters();
+        return sample;
+    }
+
+    // Method Description:
+    // - Called by the overlay's timer every second it's shown. Works out what the terminal
+    //   did since the last tick and shows it.
+    void TermControl::_UpdatePerformanceOverlay(Windows::Foundation::IInspectable const& /* sender */,
+                                                Windows::Foundation::IInspectable const& /* e */)
+    {
+        if (!_terminal || !_renderer || _closing)
+        {
+            return;
+        }
+
+        const auto sample = _TakePerformanceSample();
+        const auto& last = _lastPerformanceSample;
+
+        const auto seconds = std::chrono::duration<double>(sample.time - last.time).count();
+        const auto frames = sample.frames.frames - last.frames.frames;
+        const auto written = sample.terminal.charsWritten - last.terminal.charsWritten;
+        const auto parseMs = sample.terminal.parseMilliseconds - last.terminal.parseMilliseconds;
+        constexpr double MB = 1024.0 * 1024.0;
+
+        wchar_t text[512];
+        swprintf_s(text,
+                   L"input   %10.1f KB/s\n"
+                   L"parser  %10.2f MB/s\n"
+                   L"lock    %10.2f ms/s\n"
+                   L"held    %10.2f ms/s\n"
+                   L"waits   %10.1f /s\n"
+                   L"long    %10.1f holds/s\n"
+                   L"frames  %10.1f /s\n"
+                   L"dirty   %10.0f cells/frame\n"
+                   L"paint   %10.2f ms/frame\n"
+                   L"buffer  %10.2f MB",
+                   seconds > 0 ? (sample.outputReceived - last.outputReceived) * sizeof(wchar_t) / 1024.0 / seconds : 0.0,
+                   parseMs > 0 ? written * sizeof(wchar_t) / MB / (parseMs / 1000) : 0.0,
+                   seconds > 0 ? (sample.terminal.lockWaitMilliseconds - last.terminal.lockWaitMilliseconds) / seconds : 0.0,
+                   seconds > 0 ? (sample.terminal.lockHoldMilliseconds - last.terminal.lockHoldMilliseconds) / seconds : 0.0,
+                   seconds > 0 ? (sample.terminal.lockContentions - last.terminal.lockContentions) / seconds : 0.0,
+                   seconds > 0 ? (sample.terminal.longLockHolds - last.terminal.longLockHolds) / seconds : 0.0,
+                   seconds > 0 ? frames / seconds : 0.0,
+                   frames > 0 ? static_cast<double>(sample.frames.dirtyCells - last.frames.dirtyCells) / frames : 0.0,
+                   frames > 0 ? (sample.frames.paintMilliseconds - last.frames.paintMilliseconds) / frames : 0.0,
+                   sample.terminal.bufferBytes / MB);
+        _performanceOverlayText.Text(text);
+
+        _lastPerformanceSample = sample;
+    }
+
     // Function Description:
     // - Gets the height of the terminal in lines of text
     // Return Value:
@@ -52,11 +52,18 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         int GetScrollOffset();
         int GetViewHeight() const;
 
+        void SetPaintingEnabled(bool enabled);
+        void TogglePerformanceOverlay();
+
         void SwapChainChanged();
         ~TermControl();
 
         static Windows::Foundation::Point GetProposedDimensions(Microsoft::Terminal::Settings::IControlSettings const& settings, const uint32_t dpi);
 
+        // For the automation peer. They aren't part of the projection.
+        std::shared_ptr<const TextBufferSnapshot> TakeSnapshot();
+        ::Microsoft::Console::Types::Viewport GetVisibleRows() const;
+
         // clang-format off
         // -------------------------------- WinRT Events ---------------------------------
         DECLARE_EVENT(TitleChanged,             _titleChangedHandlers,              TerminalControl::TitleChangedEventArgs);
@@ -78,13 +85,37 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         Windows::UI::Xaml::Controls::Primitives::ScrollBar _scrollBar;
         event_token _connectionOutputEventToken;
 
+        // Output from the connection waits here for _outputWork to parse it.
+        // The lock is only held to append to it or take it all, never while parsing.
+        std::mutex _pendingOutputLock;
+        std::wstring _pendingOutput;
+        bool _outputParseQueued{ false };
+        wil::unique_threadpool_work _outputWork;
+        std::atomic<uint64_t> _outputReceived{ 0 }; // characters, for the performance overlay
+
+        // The performance overlay. It's only made the first time it's shown, and the
+        // terminal only times its writes while it's up.
+        struct PerformanceSample
+        {
+            std::chrono::steady_clock::time_point time;
+            uint64_t outputReceived;
+            ::Microsoft::Terminal::Core::Terminal::PerformanceCounters terminal;
+            ::Microsoft::Console::Render::Renderer::FrameCounters frames;
+        };
+        Windows::UI::Xaml::Controls::Border _performanceOverlay{ nullptr };
+        Windows::UI::Xaml::Controls::TextBlock _performanceOverlayText{ nullptr };
+        std::optional<Windows::UI::Xaml::DispatcherTimer> _performanceOverlayTimer;
+        PerformanceSample _lastPerformanceSample{};
+
         std::unique_ptr<::Microsoft::Terminal::Core::Terminal> _terminal;
 
         std::unique_ptr<::Microsoft::Console::Render::Renderer> _renderer;
         std::unique_ptr<::Microsoft::Console::Render::DxEngine> _renderEngine;
 
         Settings::IControlSettings _settings;
+        bool _ownsSettings{ false };
         bool _focused;
+        bool _paintingEnabled{ true };
         std::atomic<bool> _closing;
 
         FontInfoDesired _desiredFont;
@@ -92,11 +123,30 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
 
         std::optional<int> _lastScrollOffset;
 
+        // The newest scroll position from the terminal, waiting for the UI thread to show it.
+        struct ScrollState
+        {
+            int viewTop;
+            int viewHeight;
+            int bufferSize;
+        };
+        std::mutex _pendingScrollLock;
+        ScrollState _pendingScroll{};
+        std::atomic<bool> _scrollUpdatePending{ false };
+
+        // The last title passed on to TitleChanged. Only touched on the UI thread.
+        hstring _lastTitle;
+        std::atomic<bool> _titleUpdatePending{ false };
+
         // storage location for the leading surrogate of a utf-16 surrogate pair
         std::optional<wchar_t> _leadingSurrogate;
 
         std::optional<Windows::UI::Xaml::DispatcherTimer> _cursorTimer;
 
+        // Puts off resizing the connection until the size stops changing.
+        std::optional<Windows::UI::Xaml::DispatcherTimer> _connectionResizeTimer;
+        COORD _pendingConnectionSize{};
+
         // If this is set, then we assume we are in the middle of panning the
         //      viewport via touch input.
         std::optional<winrt::Windows::Foundation::Point> _touchAnchor;
@@ -110,6 +160,11 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         unsigned int _multiClickCounter;
         std::optional<winrt::Windows::Foundation::Point> _lastMouseClickPos;
 
+        // The last size the swap chain panel was given, waiting to be resized to.
+        // Only touched on the UI thread.
+        winrt::Windows::Foundation::Size _pendingResize{};
+        bool _resizeQueued{ false };
+
         // Event revokers -- we need to deregister ourselves before we die,
         // lest we get callbacks afterwards.
         winrt::Windows::UI::Xaml::Controls::Control::SizeChanged_revoker _sizeChangedRevoker;
@@ -119,7 +174,9 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         winrt::Windows::UI::Xaml::UIElement::GotFocus_revoker _gotFocusRevoker;
 
         void _Create();
+        void _EnsureOwnSettings();
         void _ApplyUISettings();
+        void _InitializeFontFromSettings();
         void _InitializeBackgroundBrush();
         void _BackgroundColorChanged(const uint32_t color);
         void _InitializeTerminal();
@@ -135,6 +192,12 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         void _LostFocusHandler(Windows::Foundation::IInspectable const& sender, Windows::UI::Xaml::RoutedEventArgs const& e);
 
         void _BlinkCursor(Windows::Foundation::IInspectable const& sender, Windows::Foundation::IInspectable const& e);
+        void _ResizeConnection(Windows::Foundation::IInspectable const& sender, Windows::Foundation::IInspectable const& e);
+        void _UpdatePerformanceOverlay(Windows::Foundation::IInspectable const& sender, Windows::Foundation::IInspectable const& e);
+        PerformanceSample _TakePerformanceSample();
+        void _QueueOutput(const hstring& str);
+        static void CALLBACK s_ParseOutputCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work) noexcept;
+        void _ParseQueuedOutput() noexcept;
         void _SendInputToConnection(const std::wstring& wstr);
         void _SwapChainSizeChanged(Windows::Foundation::IInspectable const& sender, Windows::UI::Xaml::SizeChangedEventArgs const& e);
         void _SwapChainScaleChanged(Windows::UI::Xaml::Controls::SwapChainPanel const& sender, Windows::Foundation::IInspectable const& args);
@@ -0,0 +1,147 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "TermControlAutomationPeer.h"
+#include "TermControl.h"
+#include "XamlUiaTextRange.h"
+
+using namespace ::Microsoft::Console::Types;
+using namespace winrt::Windows::UI::Xaml::Automation;
+using namespace winrt::Windows::UI::Xaml::Automation::Peers;
+using namespace winrt::Windows::UI::Xaml::Automation::Provider;
+
+namespace winrt::Microsoft::Terminal::TerminalControl::implementation
+{
+    TermControlAutomationPeer::TermControlAutomationPeer(const Windows::UI::Xaml::Controls::UserControl& owner,
+                                                         const winrt::weak_ref<TermControl>& control) :
+        FrameworkElementAutomationPeerT<TermControlAutomationPeer, ITextProvider>(owner),
+        _control{ control }
+    {
+    }
+
+#pragma region IAutomationPeerOverrides
+    hstring TermControlAutomationPeer::GetClassNameCore() const
+    {
+        return L"TermControl";
+    }
+
+    AutomationControlType TermControlAutomationPeer::GetAutomationControlTypeCore() const
+    {
+        return AutomationControlType::Text;
+    }
+
+    Windows::Foundation::IInspectable TermControlAutomationPeer::GetPatternCore(PatternInterface patternInterface) const
+    {
+        switch (patternInterface)
+        {
+        case PatternInterface::Text:
+            return *this;
+        default:
+            return nullptr;
+        }
+    }
+#pragma endregion
+
+#pragma region ITextProvider
+    // Method Description:
+    // - Gets the selected text. The selection isn't part of what's copied out of the
+    //   terminal, so there never is any as far as UIA clients are concerned.
+    com_array<ITextRangeProvider> TermControlAutomationPeer::GetSelection()
+    {
+        return {};
+    }
+
+    // Method Description:
+    // - Gets the text that's on the screen, as one range covering the rows of the viewport.
+    com_array<ITextRangeProvider> TermControlAutomationPeer::GetVisibleRanges()
+    {
+        const auto control = _control.get();
+        auto snapshot = _TakeSnapshot();
+        if (!control || !snapshot)
+        {
+            return {};
+        }
+
+        const auto rows = snapshot->GetRows();
+        const auto visible = Viewport::Intersect(control->GetVisibleRows(), rows);
+        if (!visible.IsValid())
+        {
+            return {};
+        }
+
+        const size_t width = rows.Width();
+        const size_t start = (visible.Top() - rows.Top()) * width;
+        const size_t end = (visible.BottomExclusive() - rows.Top()) * width;
+        return { _MakeRange(std::move(snapshot), start, end) };
+    }
+
+    // Method Description:
+    // - Gets the text of a child element. There are no children, so this is an empty range
+    //   at the start of the buffer.
+    ITextRangeProvider TermControlAutomationPeer::RangeFromChild(IRawElementProviderSimple /*childElement*/)
+    {
+        return _MakeRange(_TakeSnapshot(), 0, 0);
+    }
+
+    // Method Description:
+    // - Gets an empty range at the given point on the screen. Ranges only know about the
+    //   cells of the buffer, not where they're drawn, so this is always the start of the
+    //   first row of the viewport.
+    ITextRangeProvider TermControlAutomationPeer::RangeFromPoint(Windows::Foundation::Point /*screenLocation*/)
+    {
+        const auto control = _control.get();
+        auto snapshot = _TakeSnapshot();
+        if (!control || !snapshot)
+        {
+            return _MakeRange(nullptr, 0, 0);
+        }
+
+        const auto rows = snapshot->GetRows();
+        const auto visible = Viewport::Intersect(control->GetVisibleRows(), rows);
+        const size_t start = visible.IsValid() ? (visible.Top() - rows.Top()) * rows.Width() : 0;
+        return _MakeRange(std::move(snapshot), start, start);
+    }
+
+    // Method Description:
+    // - Gets all of the text in the buffer, scrollback included.
+    ITextRangeProvider TermControlAutomationPeer::DocumentRange()
+    {
+        auto snapshot = _TakeSnapshot();
+        const size_t end = snapshot ? snapshot->GetRows().Width() * snapshot->GetRows().Height() : 0;
+        return _MakeRange(std::move(snapshot), 0, end);
+    }
+
+    Windows::UI::Xaml::Automation::SupportedTextSelection TermControlAutomationPeer::SupportedTextSelection()
+    {
+        return Windows::UI::Xaml::Automation::SupportedTextSelection::None;
+    }
+#pragma endregion
+
+    // Method Description:
+    // - Gets a copy of the buffer to answer a query from.
+    // Return Value:
+    // - the copy, or nullptr if the control was closed
+    std::shared_ptr<const TextBufferSnapshot> TermControlAutomationPeer::_TakeSnapshot() const
+    {
+        const auto control = _control.get();
+        return control ? control->TakeSnapshot() : nullptr;
+    }
+
+    ITextRangeProvider TermControlAutomationPeer::_MakeRange(std::shared_ptr<const TextBufferSnapshot> snapshot,
+                                                              const size_t start,
+                                                              const size_t end)
+    {
+        return winrt::make<XamlUiaTextRange>(std::move(snapshot), ProviderFromPeer(*this), _control, start, end);
+    }
+
+    TermControlRoot::TermControlRoot(std::function<AutomationPeer()> pfnCreateAutomationPeer) :
+        _pfnCreateAutomationPeer{ std::move(pfnCreateAutomationPeer) }
+    {
+    }
+
+    AutomationPeer TermControlRoot::OnCreateAutomationPeer()
+    {
+        return _pfnCreateAutomationPeer ? _pfnCreateAutomationPeer() : nullptr;
+    }
+}
@@ -0,0 +1,65 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+//
+// Module Name:
+// - TermControlAutomationPeer.h
+//
+// Abstract:
+// - The UIA provider of a TermControl. It implements the text pattern, and answers
+//   every query from a copy of the buffer (a TextBufferSnapshot) instead of the buffer
+//   itself. A copy is only taken under the terminal's lock, and the lock isn't held
+//   while UIA clients read it, so they don't hold up the output.
+// - TermControlRoot is the UserControl at the root of a TermControl. It's only there
+//   so that XAML has something to ask for the automation peer.
+
+#pragma once
+
+#include "../../buffer/out/TextBufferSnapshot.hpp"
+
+namespace winrt::Microsoft::Terminal::TerminalControl::implementation
+{
+    struct TermControl;
+
+    struct TermControlAutomationPeer :
+        public Windows::UI::Xaml::Automation::Peers::FrameworkElementAutomationPeerT<TermControlAutomationPeer, Windows::UI::Xaml::Automation::Provider::ITextProvider>
+    {
+    public:
+        TermControlAutomationPeer(const Windows::UI::Xaml::Controls::UserControl& owner, const winrt::weak_ref<TermControl>& control);
+
+#pragma region IAutomationPeerOverrides
+        hstring GetClassNameCore() const;
+        Windows::UI::Xaml::Automation::Peers::AutomationControlType GetAutomationControlTypeCore() const;
+        Windows::Foundation::IInspectable GetPatternCore(Windows::UI::Xaml::Automation::Peers::PatternInterface patternInterface) const;
+#pragma endregion
+
+#pragma region ITextProvider
+        com_array<Windows::UI::Xaml::Automation::Provider::ITextRangeProvider> GetSelection();
+        com_array<Windows::UI::Xaml::Automation::Provider::ITextRangeProvider> GetVisibleRanges();
+        Windows::UI::Xaml::Automation::Provider::ITextRangeProvider RangeFromChild(Windows::UI::Xaml::Automation::Provider::IRawElementProviderSimple childElement);
+        Windows::UI::Xaml::Automation::Provider::ITextRangeProvider RangeFromPoint(Windows::Foundation::Point screenLocation);
+        Windows::UI::Xaml::Automation::Provider::ITextRangeProvider DocumentRange();
+        Windows::UI::Xaml::Automation::SupportedTextSelection SupportedTextSelection();
+#pragma endregion
+
+    private:
+        // The control goes away when its pane closes, but UIA clients can hold on to the peer for as long as they like.
+        winrt::weak_ref<TermControl> _control;
+
+        std::shared_ptr<const TextBufferSnapshot> _TakeSnapshot() const;
+        Windows::UI::Xaml::Automation::Provider::ITextRangeProvider _MakeRange(std::shared_ptr<const TextBufferSnapshot> snapshot,
+                                                                               const size_t start,
+                                                                               const size_t end);
+    };
+
+    struct TermControlRoot :
+        public Windows::UI::Xaml::Controls::UserControlT<TermControlRoot>
+    {
+    public:
+        TermControlRoot(std::function<Windows::UI::Xaml::Automation::Peers::AutomationPeer()> pfnCreateAutomationPeer);
+
+        Windows::UI::Xaml::Automation::Peers::AutomationPeer OnCreateAutomationPeer();
+
+    private:
+        std::function<Windows::UI::Xaml::Automation::Peers::AutomationPeer()> _pfnCreateAutomationPeer;
+    };
+}
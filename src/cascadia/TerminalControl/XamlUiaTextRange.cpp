@@ -0,0 +1,442 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "XamlUiaTextRange.h"
+#include "TermControl.h"
+#include <UIAutomationClient.h>
+
+using namespace ::Microsoft::Console::Types;
+using namespace winrt::Windows::UI::Xaml::Automation::Provider;
+using namespace winrt::Windows::UI::Xaml::Automation::Text;
+
+// UIA clients only take an attribute to be unsupported when they get this error back.
+// With anything else, they won't read across places where the attribute changes.
+static constexpr HRESULT XAML_E_NOT_SUPPORTED = static_cast<HRESULT>(0x80131515L);
+
+namespace winrt::Microsoft::Terminal::TerminalControl::implementation
+{
+    XamlUiaTextRange::XamlUiaTextRange(std::shared_ptr<const TextBufferSnapshot> snapshot,
+                                       IRawElementProviderSimple parentProvider,
+                                       winrt::weak_ref<TermControl> control,
+                                       const size_t start,
+                                       const size_t end) :
+        _snapshot{ std::move(snapshot) },
+        _parentProvider{ parentProvider },
+        _control{ control },
+        _start{ start },
+        _end{ end }
+    {
+        _end = std::min(_end, _Size());
+        _start = std::min(_start, _end);
+    }
+
+#pragma region ITextRangeProvider
+    ITextRangeProvider XamlUiaTextRange::Clone() const
+    {
+        return winrt::make<XamlUiaTextRange>(_snapshot, _parentProvider, _control, _start, _end);
+    }
+
+    bool XamlUiaTextRange::Compare(ITextRangeProvider pRange) const
+    {
+        if (!pRange)
+        {
+            return false;
+        }
+
+        const auto other = winrt::get_self<XamlUiaTextRange>(pRange);
+        return _start == other->_start && _end == other->_end;
+    }
+
+    int32_t XamlUiaTextRange::CompareEndpoints(TextPatternRangeEndpoint endpoint,
+                                               ITextRangeProvider pTargetRange,
+                                               TextPatternRangeEndpoint targetEndpoint) const
+    {
+        const auto other = winrt::get_self<XamlUiaTextRange>(pTargetRange);
+        const auto mine = _GetEndpoint(endpoint);
+        const auto theirs = other->_GetEndpoint(targetEndpoint);
+        return mine < theirs ? -1 : (mine > theirs ? 1 : 0);
+    }
+
+    void XamlUiaTextRange::ExpandToEnclosingUnit(TextUnit unit)
+    {
+        const auto size = _Size();
+        if (size == 0)
+        {
+            return;
+        }
+
+        const auto width = _Width();
+        _start = std::min(_start, size - 1);
+        if (unit == TextUnit::Character)
+        {
+            // The second half of a wide character belongs to the first.
+            if (_start % width != 0 && _RowAt(_start).DbcsAttrAt(_start % width).IsTrailing())
+            {
+                --_start;
+            }
+            _end = _start;
+            _MovePosition(_end, TextUnit::Character, 1, size);
+        }
+        else if (unit <= TextUnit::Line)
+        {
+            _start -= _start % width;
+            _end = _start + width;
+        }
+        else
+        {
+            _start = 0;
+            _end = size;
+        }
+    }
+
+    ITextRangeProvider XamlUiaTextRange::FindAttribute(int32_t /*textAttributeId*/,
+                                                       Windows::Foundation::IInspectable /*val*/,
+                                                       bool /*searchBackward*/) const
+    {
+        throw winrt::hresult_not_implemented();
+    }
+
+    // Method Description:
+    // - Looks for the given text within this range. Like the search of the terminal
+    //   itself, matches don't span more than one row.
+    // Arguments:
+    // - text: the text to look for
+    // - searchBackward: true to find the last match instead of the first
+    // - ignoreCase: true if the case of letters doesn't have to match
+    // Return Value:
+    // - a range covering the cells of the match, or nullptr if there isn't one
+    ITextRangeProvider XamlUiaTextRange::FindText(hstring text,
+                                                  bool searchBackward,
+                                                  bool ignoreCase) const
+    {
+        std::wstring needle{ text };
+        if (needle.empty() || _start >= _end)
+        {
+            return nullptr;
+        }
+
+        if (ignoreCase)
+        {
+            std::transform(needle.begin(), needle.end(), needle.begin(), ::towlower);
+        }
+
+        const auto width = _Width();
+        const auto firstRow = _start / width;
+        const auto lastRow = (_end - 1) / width;
+
+        std::wstring rowText;
+        std::vector<size_t> columns;
+        for (size_t i = 0; i <= lastRow - firstRow; ++i)
+        {
+            const auto y = searchBackward ? lastRow - i : firstRow + i;
+            const auto rowStart = y * width;
+            const auto left = std::max(_start, rowStart) - rowStart;
+            const auto right = std::min(_end, rowStart + width) - rowStart;
+            const auto& row = _RowAt(rowStart);
+
+            // Lay the row out as text, remembering which column each code unit comes from.
+            rowText.clear();
+            columns.clear();
+            for (auto column = left; column < right; ++column)
+            {
+                if (!row.DbcsAttrAt(column).IsTrailing())
+                {
+                    for (const auto wch : row.GlyphAt(column))
+                    {
+                        rowText.push_back(ignoreCase ? ::towlower(wch) : wch);
+                        columns.push_back(column);
+                    }
+                }
+            }
+
+            const auto pos = searchBackward ? rowText.rfind(needle) : rowText.find(needle);
+            if (pos != std::wstring::npos)
+            {
+                const auto matchLeft = columns.at(pos);
+                auto matchRight = columns.at(pos + needle.size() - 1);
+                if (row.DbcsAttrAt(matchRight).IsLeading())
+                {
+                    ++matchRight;
+                }
+                return winrt::make<XamlUiaTextRange>(_snapshot, _parentProvider, _control, rowStart + matchLeft, rowStart + matchRight + 1);
+            }
+        }
+        return nullptr;
+    }
+
+    Windows::Foundation::IInspectable XamlUiaTextRange::GetAttributeValue(int32_t textAttributeId) const
+    {
+        if (textAttributeId == UIA_IsReadOnlyAttributeId)
+        {
+            return winrt::box_value(false);
+        }
+        winrt::throw_hresult(XAML_E_NOT_SUPPORTED);
+    }
+
+    // Method Description:
+    // - Gets where the text of the range is drawn on the screen. The copy of the buffer
+    //   doesn't know that, so there aren't any rectangles.
+    void XamlUiaTextRange::GetBoundingRectangles(com_array<double>& returnValue) const
+    {
+        returnValue = {};
+    }
+
+    IRawElementProviderSimple XamlUiaTextRange::GetEnclosingElement() const
+    {
+        return _parentProvider;
+    }
+
+    // Method Description:
+    // - Gets the text of the range. Rows end in CRLF unless they wrapped onto the next one,
+    //   and the blank space at the end of a row that didn't wrap is left out.
+    // Arguments:
+    // - maxLength: the most characters to get, or -1 to get all of them
+    // Return Value:
+    // - the text
+    hstring XamlUiaTextRange::GetText(int32_t maxLength) const
+    {
+        if (maxLength < -1)
+        {
+            throw winrt::hresult_invalid_argument();
+        }
+        const size_t limit = maxLength == -1 ? std::numeric_limits<size_t>::max() : static_cast<size_t>(maxLength);
+
+        std::wstring text;
+        const auto width = _Width();
+        for (auto rowStart = _start - (width ? _start % width : 0); rowStart < _end && text.size() < limit; rowStart += width)
+        {
+            const auto& row = _RowAt(rowStart);
+            const auto left = std::max(_start, rowStart) - rowStart;
+            auto right = std::min(_end, rowStart + width) - rowStart;
+            if (!row.WasWrapForced())
+            {
+                right = std::min(right, _MeasureRight(row));
+            }
+
+            for (auto column = left; column < right && text.size() < limit; ++column)
+            {
+                if (!row.DbcsAttrAt(column).IsTrailing())
+                {
+                    text.append(row.GlyphAt(column));
+                }
+            }
+
+            // The range goes on past the end of this row.
+            if (_end > rowStart + width && !row.WasWrapForced())
+            {
+                text.append(L"\r\n");
+            }
+        }
+
+        if (text.size() > limit)
+        {
+            text.resize(limit);
+        }
+        return hstring{ text };
+    }
+
+    int32_t XamlUiaTextRange::Move(TextUnit unit, int32_t count)
+    {
+        const auto size = _Size();
+        if (count == 0 || size == 0)
+        {
+            return 0;
+        }
+
+        // Move from the start of the unit the range starts in, and only ever to the start
+        // of another one, so that the range spans a whole unit again afterwards.
+        ExpandToEnclosingUnit(unit);
+        const auto moved = _MovePosition(_start, unit, count, size - 1);
+        ExpandToEnclosingUnit(unit);
+        return moved;
+    }
+
+    int32_t XamlUiaTextRange::MoveEndpointByUnit(TextPatternRangeEndpoint endpoint, TextUnit unit, int32_t count)
+    {
+        auto position = _GetEndpoint(endpoint);
+        const auto moved = _MovePosition(position, unit, count, _Size());
+        _SetEndpoint(endpoint, position);
+        return moved;
+    }
+
+    void XamlUiaTextRange::MoveEndpointByRange(TextPatternRangeEndpoint endpoint,
+                                               ITextRangeProvider pTargetRange,
+                                               TextPatternRangeEndpoint targetEndpoint)
+    {
+        const auto other = winrt::get_self<XamlUiaTextRange>(pTargetRange);
+        _SetEndpoint(endpoint, std::min(other->_GetEndpoint(targetEndpoint), _Size()));
+    }
+
+    // Method Description:
+    // - Selects the text of the range. The provider doesn't support selecting text (see
+    //   TermControlAutomationPeer::SupportedTextSelection), so this always fails.
+    void XamlUiaTextRange::Select() const
+    {
+        throw winrt::hresult_not_implemented();
+    }
+
+    void XamlUiaTextRange::AddToSelection() const
+    {
+        throw winrt::hresult_not_implemented();
+    }
+
+    void XamlUiaTextRange::RemoveFromSelection() const
+    {
+        throw winrt::hresult_not_implemented();
+    }
+
+    // Method Description:
+    // - Scrolls the control so that the range is on the screen.
+    // Arguments:
+    // - alignToTop: true to put the start of the range on the top row of the viewport,
+    //               false to put the end of the range on the bottom row
+    void XamlUiaTextRange::ScrollIntoView(bool alignToTop) const
+    {
+        const auto control = _control.get();
+        if (!control || _Size() == 0)
+        {
+            return;
+        }
+
+        const auto visible = control->GetVisibleRows();
+        if (!visible.IsValid())
+        {
+            return;
+        }
+
+        const auto position = alignToTop || _start == _end ? _start : _end - 1;
+        const int row = _snapshot->GetRows().Top() + gsl::narrow_cast<int>(position / _Width());
+        const int viewTop = alignToTop ? row : row - visible.Height() + 1;
+        control->KeyboardScrollViewport(std::max(viewTop, 0));
+    }
+
+    com_array<IRawElementProviderSimple> XamlUiaTextRange::GetChildren() const
+    {
+        return {};
+    }
+#pragma endregion
+
+    size_t XamlUiaTextRange::_Width() const noexcept
+    {
+        return _snapshot ? gsl::narrow_cast<size_t>(_snapshot->GetRows().Width()) : 0;
+    }
+
+    size_t XamlUiaTextRange::_Size() const noexcept
+    {
+        return _snapshot ? _Width() * gsl::narrow_cast<size_t>(_snapshot->GetRows().Height()) : 0;
+    }
+
+    // Method Description:
+    // - Gets the copied row that a cell is in.
+    // Arguments:
+    // - position: the cell. It has to be before the end of the copy.
+    const TextBufferSnapshot::Row& XamlUiaTextRange::_RowAt(const size_t position) const
+    {
+        return _snapshot->GetRow(gsl::narrow_cast<SHORT>(_snapshot->GetRows().Top() + position / _Width()));
+    }
+
+    size_t XamlUiaTextRange::_GetEndpoint(const TextPatternRangeEndpoint endpoint) const noexcept
+    {
+        return endpoint == TextPatternRangeEndpoint::Start ? _start : _end;
+    }
+
+    // Method Description:
+    // - Moves one end of the range. If that puts it past the other end, the other end
+    //   is moved along with it.
+    void XamlUiaTextRange::_SetEndpoint(const TextPatternRangeEndpoint endpoint, const size_t position) noexcept
+    {
+        if (endpoint == TextPatternRangeEndpoint::Start)
+        {
+            _start = position;
+            _end = std::max(_start, _end);
+        }
+        else
+        {
+            _end = position;
+            _start = std::min(_start, _end);
+        }
+    }
+
+    // Method Description:
+    // - Moves a cell position by whole units.
+    // Arguments:
+    // - position: the position to move. It's left at the last unit it could get to.
+    // - unit: what to count. Characters and lines are counted from the position,
+    //         the document goes straight to the start or the end.
+    // - count: how many units to move. Negative to move backward.
+    // - limit: the furthest position it may be moved forward to
+    // Return Value:
+    // - how many units it was moved, negative when moving backward
+    int32_t XamlUiaTextRange::_MovePosition(size_t& position, const TextUnit unit, const int32_t count, const size_t limit) const
+    {
+        const auto width = _Width();
+        const auto size = _Size();
+        int32_t moved = 0;
+        if (width == 0)
+        {
+            return moved;
+        }
+
+        while (moved < count)
+        {
+            auto next = size;
+            if (unit == TextUnit::Character)
+            {
+                next = position + 1;
+                // A wide character takes up two cells, but it's only one character.
+                if (position < size && position % width + 1 < width && _RowAt(position).DbcsAttrAt(position % width).IsLeading())
+                {
+                    ++next;
+                }
+            }
+            else if (unit <= TextUnit::Line)
+            {
+                next = (position / width + 1) * width;
+            }
+
+            if (next > limit || next == position)
+            {
+                break;
+            }
+            position = next;
+            ++moved;
+        }
+
+        while (moved > count && position > 0)
+        {
+            size_t next = 0;
+            if (unit == TextUnit::Character)
+            {
+                next = position - 1;
+                if (next < size && next % width != 0 && _RowAt(next).DbcsAttrAt(next % width).IsTrailing())
+                {
+                    --next;
+                }
+            }
+            else if (unit <= TextUnit::Line)
+            {
+                next = position % width == 0 ? position - width : position - position % width;
+            }
+
+            position = next;
+            --moved;
+        }
+
+        return moved;
+    }
+
+    // Method Description:
+    // - Gets the column after the last one in the row that isn't blank.
+    size_t XamlUiaTextRange::_MeasureRight(const TextBufferSnapshot::Row& row)
+    {
+        for (auto column = row.size(); column > 0; --column)
+        {
+            if (row.GlyphAt(column - 1) != L" ")
+            {
+                return column;
+            }
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+//
+// Module Name:
+// - XamlUiaTextRange.h
+//
+// Abstract:
+// - A range of text handed out by TermControlAutomationPeer. It reads the text out of
+//   the copy of the buffer it was made from, so it never needs the terminal's lock.
+// - The ends of a range are cells of the copy, counted left to right, top to bottom.
+//   The start is inclusive and the end is exclusive.
+// - Like the ranges of conhost's UIA provider, it moves by characters, lines and the
+//   whole document. The units in between lines and the document are treated as lines,
+//   and the ones above lines as the document.
+
+#pragma once
+
+#include "../../buffer/out/TextBufferSnapshot.hpp"
+
+namespace winrt::Microsoft::Terminal::TerminalControl::implementation
+{
+    struct TermControl;
+
+    struct XamlUiaTextRange :
+        winrt::implements<XamlUiaTextRange, Windows::UI::Xaml::Automation::Provider::ITextRangeProvider>
+    {
+    public:
+        XamlUiaTextRange(std::shared_ptr<const TextBufferSnapshot> snapshot,
+                         Windows::UI::Xaml::Automation::Provider::IRawElementProviderSimple parentProvider,
+                         winrt::weak_ref<TermControl> control,
+                         const size_t start,
+                         const size_t end);
+
+#pragma region ITextRangeProvider
+        Windows::UI::Xaml::Automation::Provider::ITextRangeProvider Clone() const;
+        bool Compare(Windows::UI::Xaml::Automation::Provider::ITextRangeProvider pRange) const;
+        int32_t CompareEndpoints(Windows::UI::Xaml::Automation::Text::TextPatternRangeEndpoint endpoint,
+                                 Windows::UI::Xaml::Automation::Provider::ITextRangeProvider pTargetRange,
+                                 Windows::UI::Xaml::Automation::Text::TextPatternRangeEndpoint targetEndpoint) const;
+        void ExpandToEnclosingUnit(Windows::UI::Xaml::Automation::Text::TextUnit unit);
+        Windows::UI::Xaml::Automation::Provider::ITextRangeProvider FindAttribute(int32_t textAttributeId,
+                                                                                  Windows::Foundation::IInspectable val,
+                                                                                  bool searchBackward) const;
+        Windows::UI::Xaml::Automation::Provider::ITextRangeProvider FindText(hstring text,
+                                                                             bool searchBackward,
+                                                                             bool ignoreCase) const;
+        Windows::Foundation::IInspectable GetAttributeValue(int32_t textAttributeId) const;
+        void GetBoundingRectangles(com_array<double>& returnValue) const;
+        Windows::UI::Xaml::Automation::Provider::IRawElementProviderSimple GetEnclosingElement() const;
+        hstring GetText(int32_t maxLength) const;
+        int32_t Move(Windows::UI::Xaml::Automation::Text::TextUnit unit, int32_t count);
+        int32_t MoveEndpointByUnit(Windows::UI::Xaml::Automation::Text::TextPatternRangeEndpoint endpoint,
+                                   Windows::UI::Xaml::Automation::Text::TextUnit unit,
+                                   int32_t count);
+        void MoveEndpointByRange(Windows::UI::Xaml::Automation::Text::TextPatternRangeEndpoint endpoint,
+                                 Windows::UI::Xaml::Automation::Provider::ITextRangeProvider pTargetRange,
+                                 Windows::UI::Xaml::Automation::Text::TextPatternRangeEndpoint targetEndpoint);
+        void Select() const;
+        void AddToSelection() const;
+        void RemoveFromSelection() const;
+        void ScrollIntoView(bool alignToTop) const;
+        com_array<Windows::UI::Xaml::Automation::Provider::IRawElementProviderSimple> GetChildren() const;
+#pragma endregion
+
+    private:
+        std::shared_ptr<const TextBufferSnapshot> _snapshot;
+        Windows::UI::Xaml::Automation::Provider::IRawElementProviderSimple _parentProvider;
+        winrt::weak_ref<TermControl> _control;
+        size_t _start;
+        size_t _end;
+
+        size_t _Width() const noexcept;
+        size_t _Size() const noexcept;
+        const TextBufferSnapshot::Row& _RowAt(const size_t position) const;
+        size_t _GetEndpoint(const Windows::UI::Xaml::Automation::Text::TextPatternRangeEndpoint endpoint) const noexcept;
+        void _SetEndpoint(const Windows::UI::Xaml::Automation::Text::TextPatternRangeEndpoint endpoint, const size_t position) noexcept;
+        int32_t _MovePosition(size_t& position,
+                              const Windows::UI::Xaml::Automation::Text::TextUnit unit,
+                              const int32_t count,
+                              const size_t limit) const;
+
+        static size_t _MeasureRight(const TextBufferSnapshot::Row& row);
+    };
+}
@@ -25,6 +25,15 @@ namespace Microsoft::Terminal::Core
         virtual COORD GetCursorPosition() = 0;
 
         virtual bool EraseCharacters(const unsigned int numChars) = 0;
+        virtual bool EraseInLine(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::EraseType eraseType) = 0;
+        virtual bool EraseInDisplay(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::EraseType eraseType) = 0;
+
+        virtual bool SetScrollingMargins(const short topMargin, const short bottomMargin) = 0;
+        virtual bool InsertLines(const unsigned int count) = 0;
+        virtual bool DeleteLines(const unsigned int count) = 0;
+        virtual bool ScrollUp(const unsigned int distance) = 0;
+        virtual bool ScrollDown(const unsigned int distance) = 0;
+        virtual bool ReverseLineFeed() = 0;
 
         virtual bool SetWindowTitle(std::wstring_view title) = 0;
 
@@ -34,5 +43,9 @@ namespace Microsoft::Terminal::Core
 
         virtual bool SetDefaultForeground(const DWORD dwColor) = 0;
         virtual bool SetDefaultBackground(const DWORD dwColor) = 0;
+
+        virtual bool EnableSynchronizedUpdate(const bool enabled) = 0;
+
+        virtual bool AddShellMark(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::ShellMarkType markType) = 0;
     };
 }
@@ -9,9 +9,13 @@
 #include "../../inc/DefaultSettings.h"
 #include "../../inc/argb.h"
 #include "../../types/inc/utils.hpp"
+#include "../../types/inc/OutputTracing.hpp"
+#include "../../buffer/out/TextBufferSession.hpp"
 
 #include "winrt/Microsoft.Terminal.Settings.h"
 
+#include <intrin.h>
+
 using namespace winrt::Microsoft::Terminal::Settings;
 using namespace Microsoft::Terminal::Core;
 using namespace Microsoft::Console;
@@ -42,9 +46,11 @@ Terminal::Terminal() :
     _defaultBg{ ARGB(0, 0, 0, 0) },
     _pfnWriteInput{ nullptr },
     _scrollOffset{ 0 },
+    _scrollMargins{ 0, 0, 0, 0 },
     _snapOnInput{ true },
     _boxSelection{ false },
     _selectionActive{ false },
+    _selectionGeneration{ 0 },
     _selectionAnchor{ 0, 0 },
     _endSelectionPosition{ 0, 0 }
 {
@@ -73,6 +79,7 @@ void Terminal::Create(COORD viewportSize, SHORT scrollbackLines, IRenderTarget&
     const TextAttribute attr{};
     const UINT cursorSize = 12;
     _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, renderTarget);
+    _PublishRenderState();
 }
 
 // Method Description:
@@ -85,10 +92,32 @@ void Terminal::CreateFromSettings(winrt::Microsoft::Terminal::Settings::ICoreSet
 {
     const COORD viewportSize{ Utils::ClampToShortMax(settings.InitialCols(), 1),
                               Utils::ClampToShortMax(settings.InitialRows(), 1) };
+    CreateFromSettings(settings, viewportSize, renderTarget);
+}
+
+// Method Description:
+// - Initializes the Terminal from the given settings, at the given size rather
+//   than the initial size in the settings.
+// Arguments:
+// - settings: an ICoreSettings with the settings values for us to use.
+// - viewportSize: the size of the viewport, in characters
+// - renderTarget: the target to tell about the changes we make
+void Terminal::CreateFromSettings(winrt::Microsoft::Terminal::Settings::ICoreSettings settings,
+                                  const COORD viewportSize,
+                                  Microsoft::Console::Render::IRenderTarget& renderTarget)
+{
     // TODO:MSFT:20642297 - Support infinite scrollback here, if HistorySize is -1
     Create(viewportSize, Utils::ClampToShortMax(settings.HistorySize(), 0), renderTarget);
 
     UpdateSettings(settings);
+
+    // Unlike the other settings, the archive is only picked up by a new terminal. The
+    // terminal still works without it, so not being able to open it is only logged.
+    const auto archivePath = settings.ScrollbackArchivePath();
+    if (!archivePath.empty())
+    {
+        LOG_IF_FAILED(AttachScrollbackArchive(archivePath));
+    }
 }
 
 // Method Description:
@@ -135,11 +164,15 @@ void Terminal::UpdateSettings(winrt::Microsoft::Terminal::Settings::ICoreSetting
 
     _wordDelimiters = settings.WordDelimiters();
 
+    _scrollbackMemoryBudget = static_cast<size_t>(settings.ScrollbackMemoryBudget()) * 1024 * 1024;
+
     // TODO:MSFT:21327402 - if HistorySize has changed, resize the buffer so we
     // have a smaller scrollback. We should do this carefully - if the new buffer
     // size is smaller than where the mutable viewport currently is, we'll want
     // to make sure to rotate the buffer contents upwards, so the mutable viewport
     // remains at the bottom of the buffer.
+
+    _PublishRenderState();
 }
 
 // Method Description:
@@ -162,9 +195,42 @@ void Terminal::UpdateSettings(winrt::Microsoft::Terminal::Settings::ICoreSetting
 
     const short newBufferHeight = viewportSize.Y + _scrollbackLines;
     COORD bufferSize{ viewportSize.X, newBufferHeight };
-    RETURN_IF_FAILED(_buffer->ResizeTraditional(bufferSize));
 
     auto proposedTop = oldTop;
+    if (viewportSize.X != oldDimensions.X)
+    {
+        // The width changed, so rewrap the contents of the buffer into a new one
+        // rather than cutting off (or padding out) every row.
+        const auto oldCursorHeightInViewport = _buffer->GetCursor().GetPosition().Y - oldTop;
+        const auto cursorSize = _buffer->GetCursor().GetSize();
+
+        std::unique_ptr<TextBuffer> newTextBuffer;
+        try
+        {
+            newTextBuffer = std::make_unique<TextBuffer>(bufferSize,
+                                                         _buffer->GetCurrentAttributes(),
+                                                         0, // temporarily set size to 0 so it won't render.
+                                                         _buffer->GetRenderTarget());
+        }
+        CATCH_RETURN();
+
+        // The archive goes on with the new buffer. Rows the old one paged in from it may be
+        // rewrapped, so the new buffer archives them again when they circle off.
+        newTextBuffer->SetScrollbackArchive(_buffer->GetScrollbackArchive());
+
+        RETURN_IF_FAILED(TextBuffer::Reflow(*_buffer, *newTextBuffer));
+
+        _buffer.swap(newTextBuffer);
+        _buffer->GetCursor().SetSize(cursorSize);
+
+        // Keep the cursor at the same height within the viewport as it was before.
+        proposedTop = gsl::narrow_cast<short>(std::max(0, _buffer->GetCursor().GetPosition().Y - oldCursorHeightInViewport));
+    }
+    else
+    {
+        RETURN_IF_FAILED(_buffer->ResizeTraditional(bufferSize));
+    }
+
     const auto newView = Viewport::FromDimensions({ 0, proposedTop }, viewportSize);
     const auto proposedBottom = newView.BottomExclusive();
     // If the new bottom would be below the bottom of the buffer, then slide the
@@ -176,6 +242,9 @@ void Terminal::UpdateSettings(winrt::Microsoft::Terminal::Settings::ICoreSetting
 
     _mutableViewport = Viewport::FromDimensions({ 0, proposedTop }, viewportSize);
     _scrollOffset = 0;
+
+    // The margins might not fit within the new viewport, so go back to scrolling all of it.
+    _scrollMargins = { 0, 0, 0, 0 };
     _NotifyScrollEvent();
 
     return S_OK;
@@ -183,9 +252,87 @@ void Terminal::UpdateSettings(winrt::Microsoft::Terminal::Settings::ICoreSetting
 
 void Terminal::Write(std::wstring_view stringView)
 {
-    auto lock = LockForWriting();
+    const OutputTracing::WriteActivity writeTracing{ stringView.size() };
+    _charsWritten.fetch_add(stringView.size(), std::memory_order_relaxed);
+    const bool timed = _performanceCountersEnabled.load(std::memory_order_relaxed);
+
+    // Feed the parser a slice at a time and let go of the lock in between, so that
+    // a flood of output doesn't keep the renderer and input waiting for all of it.
+    // The state machine carries any half-finished sequence over to the next slice.
+    while (!stringView.empty())
+    {
+        auto sliceSize = std::min(stringView.size(), WriteSliceSize);
+
+        // Don't split a surrogate pair across slices.
+        if (sliceSize < stringView.size() && IS_HIGH_SURROGATE(stringView.at(sliceSize - 1)))
+        {
+            sliceSize++;
+        }
+
+        if (timed)
+        {
+            using clock = std::chrono::steady_clock;
+            const auto waitStart = clock::now();
+            auto lock = LockForWriting();
+            const auto parseStart = clock::now();
+            _ProcessSlice(stringView.substr(0, sliceSize));
+            const auto parseEnd = clock::now();
+            _PublishRenderState();
+            lock.unlock();
 
-    _stateMachine->ProcessString(stringView.data(), stringView.size());
+            _lockWaitTime.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(parseStart - waitStart).count(), std::memory_order_relaxed);
+            _parseTime.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(parseEnd - parseStart).count(), std::memory_order_relaxed);
+        }
+        else
+        {
+            auto lock = LockForWriting();
+            _ProcessSlice(stringView.substr(0, sliceSize));
+            _PublishRenderState();
+        }
+
+        stringView = stringView.substr(sliceSize);
+    }
+
+    _EnforceMemoryBudget();
+}
+
+// Method Description:
+// - Feeds one slice of output to the parser. The cursor is only redrawn where it
+//   was before and where it ends up, not in every cell the slice moves it through.
+// - The write lock must be held.
+void Terminal::_ProcessSlice(const std::wstring_view slice)
+{
+    _buffer->GetCursor().StartDeferDrawing();
+    auto endDefer = wil::scope_exit([&]() noexcept { _buffer->GetCursor().EndDeferDrawing(); });
+
+    _stateMachine->ProcessString(slice.data(), slice.size());
+}
+
+// Method Description:
+// - If there's a memory budget for the buffer, and it's been a while since it was last
+//   checked, gives up as much of the scrollback as it takes to fit the buffer back in it.
+//   The rows on the screen, and the ones the user scrolled up to, are always kept.
+void Terminal::_EnforceMemoryBudget()
+{
+    if (_scrollbackMemoryBudget == 0)
+    {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - _lastMemoryBudgetCheck < MemoryBudgetCheckInterval)
+    {
+        return;
+    }
+    _lastMemoryBudgetCheck = now;
+
+    try
+    {
+        auto lock = LockForWriting();
+        const auto firstKeptRow = std::min(_mutableViewport.Top(), _GetVisibleViewport().Top());
+        _buffer->TrimToMemoryBudget(_scrollbackMemoryBudget, gsl::narrow_cast<SHORT>(firstKeptRow));
+    }
+    CATCH_LOG();
 }
 
 // Method Description:
@@ -279,9 +426,11 @@ bool Terminal::SendKeyEvent(const WORD vkey, const ControlKeyStates states)
 // Return Value:
 // - a shared_lock which can be used to unlock the terminal. The shared_lock
 //      will release this lock when it's destructed.
-[[nodiscard]] std::shared_lock<std::shared_mutex> Terminal::LockForReading()
+[[nodiscard]] std::shared_lock<ProfiledSharedMutex> Terminal::LockForReading()
 {
-    return std::shared_lock<std::shared_mutex>(_readWriteLock);
+    // Count the lock as taken by whoever asked for it, rather than from here every time.
+    _readWriteLock.lock_shared(_ReturnAddress());
+    return std::shared_lock<ProfiledSharedMutex>(_readWriteLock, std::adopt_lock);
 }
 
 // Method Description:
@@ -289,9 +438,10 @@ bool Terminal::SendKeyEvent(const WORD vkey, const ControlKeyStates states)
 // Return Value:
 // - a unique_lock which can be used to unlock the terminal. The unique_lock
 //      will release this lock when it's destructed.
-[[nodiscard]] std::unique_lock<std::shared_mutex> Terminal::LockForWriting()
+[[nodiscard]] std::unique_lock<ProfiledSharedMutex> Terminal::LockForWriting()
 {
-    return std::unique_lock<std::shared_mutex>(_readWriteLock);
+    _readWriteLock.lock(_ReturnAddress());
+    return std::unique_lock<ProfiledSharedMutex>(_readWriteLock, std::adopt_lock);
 }
 
 Viewport Terminal::_GetMutableViewport() const noexcept
@@ -323,29 +473,91 @@ Viewport Terminal::_GetVisibleViewport() const noexcept
                                     _mutableViewport.Dimensions());
 }
 
+// Method Description:
+// - Gets the rows of the buffer that scroll when the cursor runs off the
+//   bottom (or top) of them. That's the rows between the scrolling margins
+//   when they're set, or the whole mutable viewport otherwise.
+// Return Value:
+// - the scrolling region, in buffer coordinates
+Viewport Terminal::_GetScrollRegion() const noexcept
+{
+    const auto viewport = _GetMutableViewport();
+    if (_scrollMargins.Top == 0 && _scrollMargins.Bottom == 0)
+    {
+        return viewport;
+    }
+
+    return Viewport::FromInclusive({ viewport.Left(),
+                                     gsl::narrow_cast<SHORT>(viewport.Top() + _scrollMargins.Top),
+                                     viewport.RightInclusive(),
+                                     gsl::narrow_cast<SHORT>(viewport.Top() + _scrollMargins.Bottom) });
+}
+
+// Method Description:
+// - Moves the rows of the region up or down in place, blanking out the rows
+//   that are uncovered with the current attributes. The rows are rotated
+//   within the buffer, so no text is copied.
+// Arguments:
+// - region: the full width rows to scroll, in buffer coordinates
+// - delta: how many rows to move the contents. Negative moves them up.
+void Terminal::_ScrollRegion(const Viewport& region, const int delta)
+{
+    const int height = region.Height();
+    const auto distance = std::min(std::abs(delta), height);
+    if (distance == 0)
+    {
+        return;
+    }
+
+    if (distance < height)
+    {
+        const auto moved = gsl::narrow_cast<short>(height - distance);
+        if (delta < 0)
+        {
+            _buffer->ScrollRows(gsl::narrow_cast<short>(region.Top() + distance), moved, gsl::narrow_cast<short>(-distance));
+        }
+        else
+        {
+            _buffer->ScrollRows(region.Top(), moved, gsl::narrow_cast<short>(distance));
+        }
+    }
+
+    const auto blankTop = delta < 0 ? region.BottomExclusive() - distance : region.Top();
+    const auto blank = Viewport::FromDimensions({ region.Left(), gsl::narrow_cast<short>(blankTop) },
+                                                region.Width(),
+                                                gsl::narrow_cast<short>(distance));
+    _buffer->FillRect(blank, UNICODE_SPACE, _buffer->GetCurrentAttributes());
+
+    // FillRect only repaints the rows it blanked, but all of them moved.
+    _buffer->GetRenderTarget().TriggerRedraw(region);
+}
+
 // Writes a string of text to the buffer, then moves the cursor (and viewport)
 //      in accordance with the written text.
 // This method is our proverbial `WriteCharsLegacy`, and great care should be made to
 //      keep it minimal and orderly, lest it become WriteCharsLegacy2ElectricBoogaloo
-// TODO: MSFT 21006766
-//       This needs to become stream logic on the buffer itself sooner rather than later
-//       because it's otherwise impossible to avoid the Electric Boogaloo-ness here.
-//       I had to make a bunch of hacks to get Japanese and emoji to work-ish.
+// Printable text is handed to _WritePrintableRun a run at a time, so only the
+//      controls that move the cursor are dealt with one character at a time here.
+//      However many lines the string scrolls, the scroll is announced once at the end.
 void Terminal::_WriteBuffer(const std::wstring_view& stringView)
 {
+    static constexpr std::wstring_view cursorControls{ L"\n\r\b" };
+
     auto& cursor = _buffer->GetCursor();
     const Viewport bufferSize = _buffer->GetSize();
+    bool notifyScroll = false;
 
-    for (size_t i = 0; i < stringView.size(); i++)
+    for (size_t i = 0; i < stringView.size();)
     {
-        wchar_t wch = stringView[i];
+        const wchar_t wch = stringView[i];
         const COORD cursorPosBefore = cursor.GetPosition();
         COORD proposedCursorPosition = cursorPosBefore;
-        bool notifyScroll = false;
 
         if (wch == UNICODE_LINEFEED)
         {
-            proposedCursorPosition.Y++;
+            notifyScroll |= _LineFeed(cursorPosBefore);
+            ++i;
+            continue;
         }
         else if (wch == UNICODE_CARRIAGERETURN)
         {
@@ -365,73 +577,189 @@ void Terminal::_WriteBuffer(const std::wstring_view& stringView)
         }
         else
         {
-            // TODO: MSFT 21006766
-            // This is not great but I need it demoable. Fix by making a buffer stream writer.
-            if (wch >= 0xD800 && wch <= 0xDFFF)
-            {
-                OutputCellIterator it{ stringView.substr(i, 2), _buffer->GetCurrentAttributes() };
-                const auto end = _buffer->Write(it);
-                const auto cellDistance = end.GetCellDistance(it);
-                i += cellDistance - 1;
-                proposedCursorPosition.X += gsl::narrow<SHORT>(cellDistance);
-            }
-            else
-            {
-                OutputCellIterator it{ stringView.substr(i, 1), _buffer->GetCurrentAttributes() };
-                const auto end = _buffer->Write(it);
-                const auto cellDistance = end.GetCellDistance(it);
-                proposedCursorPosition.X += gsl::narrow<SHORT>(cellDistance);
-            }
+            // Everything up to the next cursor control is printed in one go.
+            const auto runEnd = std::min(stringView.find_first_of(cursorControls, i), stringView.size());
+            notifyScroll |= _WritePrintableRun(stringView.substr(i, runEnd - i));
+            i = runEnd;
+            continue;
         }
 
-        // If we're about to scroll past the bottom of the buffer, instead cycle the buffer.
-        const auto newRows = proposedCursorPosition.Y - bufferSize.Height() + 1;
-        if (newRows > 0)
+        notifyScroll |= _AdjustCursorPosition(proposedCursorPosition);
+        ++i;
+    }
+
+    if (notifyScroll)
+    {
+        _buffer->GetRenderTarget().TriggerRedrawAll();
+        _NotifyScrollEvent();
+    }
+}
+
+// Method Description:
+// - Writes a run of printable text at the cursor, filling as much of each row as
+//   will fit with a single write. Text that doesn't fit on a row continues at the
+//   start of the next one, and the cursor is moved (and the buffer circled) once
+//   per row rather than once per character.
+// Arguments:
+// - run: the text to write. It mustn't hold any of the controls _WriteBuffer
+//   moves the cursor for.
+// Return Value:
+// - true if the viewport scrolled while writing.
+bool Terminal::_WritePrintableRun(const std::wstring_view run)
+{
+    auto& cursor = _buffer->GetCursor();
+    const auto width = _buffer->GetSize().Width();
+    bool notifyScroll = false;
+
+    OutputCellIterator it{ run, _buffer->GetCurrentAttributes() };
+    while (it)
+    {
+        COORD position = cursor.GetPosition();
+
+        // An earlier run filled this row up to the right edge, so this one starts
+        // on the next line.
+        if (position.X >= width)
         {
-            for (auto dy = 0; dy < newRows; dy++)
-            {
-                _buffer->IncrementCircularBuffer();
-                proposedCursorPosition.Y--;
-            }
-            notifyScroll = true;
+            position.X = 0;
+            notifyScroll |= _LineFeed(position);
+            position = cursor.GetPosition();
         }
 
-        // This section is essentially equivalent to `AdjustCursorPosition`
-        // Update Cursor Position
-        cursor.SetPosition(proposedCursorPosition);
+        const auto end = _buffer->WriteLine(it, position, true);
+        const auto cellDistance = end.GetCellDistance(it);
 
-        const COORD cursorPosAfter = cursor.GetPosition();
+        // A glyph too wide for even a whole row can't be written anywhere, so drop
+        // what's left rather than wrapping onto row after row.
+        if (cellDistance == 0 && position.X == 0)
+        {
+            break;
+        }
 
-        // Move the viewport down if the cursor moved below the viewport.
-        if (cursorPosAfter.Y > _mutableViewport.BottomInclusive())
+        it = end;
+        if (end)
         {
-            const auto newViewTop = std::max(0, cursorPosAfter.Y - (_mutableViewport.Height() - 1));
-            if (newViewTop != _mutableViewport.Top())
-            {
-                _mutableViewport = Viewport::FromDimensions({ 0, gsl::narrow<short>(newViewTop) }, _mutableViewport.Dimensions());
-                notifyScroll = true;
-            }
+            // Whatever didn't fit goes on the next line.
+            position.X = 0;
+            notifyScroll |= _LineFeed(position);
+        }
+        else
+        {
+            position.X += gsl::narrow<SHORT>(cellDistance);
+            notifyScroll |= _AdjustCursorPosition(position);
+        }
+    }
+
+    return notifyScroll;
+}
+
+// Method Description:
+// - Moves the cursor down a line, the way a linefeed does. On the bottom margin,
+//   the contents of the margins scroll up instead of the cursor moving. Wrapping
+//   at the right edge goes through here too, so it honors the margins the same way.
+// Arguments:
+// - position: where the cursor is to move down from. Its column is kept.
+// Return Value:
+// - true if the viewport scrolled.
+bool Terminal::_LineFeed(COORD position)
+{
+    const auto scrollRegion = _GetScrollRegion();
+    if (position.Y == scrollRegion.BottomInclusive() && scrollRegion != _mutableViewport)
+    {
+        _ScrollRegion(scrollRegion, -1);
+    }
+    else
+    {
+        position.Y++;
+    }
+    return _AdjustCursorPosition(position);
+}
+
+// Method Description:
+// - Moves the cursor to the given position, circling the buffer if that's past its
+//   bottom and moving the viewport down if it's below the viewport.
+//   This is essentially equivalent to conhost's `AdjustCursorPosition`.
+// Arguments:
+// - proposedCursorPosition: where the cursor is to go.
+// Return Value:
+// - true if the buffer circled or the viewport moved, so the scroll needs announcing.
+bool Terminal::_AdjustCursorPosition(COORD proposedCursorPosition)
+{
+    auto& cursor = _buffer->GetCursor();
+    const Viewport bufferSize = _buffer->GetSize();
+    bool notifyScroll = false;
+
+    // If we're about to scroll past the bottom of the buffer, instead cycle the buffer.
+    const auto newRows = proposedCursorPosition.Y - bufferSize.Height() + 1;
+    if (newRows > 0)
+    {
+        for (auto dy = 0; dy < newRows; dy++)
+        {
+            _buffer->IncrementCircularBuffer();
+            proposedCursorPosition.Y--;
         }
+        notifyScroll = true;
+    }
+
+    // Update Cursor Position
+    cursor.SetPosition(proposedCursorPosition);
+
+    const COORD cursorPosAfter = cursor.GetPosition();
 
-        if (notifyScroll)
+    // Move the viewport down if the cursor moved below the viewport.
+    if (cursorPosAfter.Y > _mutableViewport.BottomInclusive())
+    {
+        const auto newViewTop = std::max(0, cursorPosAfter.Y - (_mutableViewport.Height() - 1));
+        if (newViewTop != _mutableViewport.Top())
         {
-            _buffer->GetRenderTarget().TriggerRedrawAll();
-            _NotifyScrollEvent();
+            _mutableViewport = Viewport::FromDimensions({ 0, gsl::narrow<short>(newViewTop) }, _mutableViewport.Dimensions());
+            notifyScroll = true;
         }
     }
+
+    return notifyScroll;
 }
 
 void Terminal::UserScrollViewport(const int viewTop)
 {
+    auto lock = LockForWriting();
+
     const auto clampedNewTop = std::max(0, viewTop);
     const auto realTop = _ViewStartIndex();
     const auto newDelta = realTop - clampedNewTop;
     // if viewTop > realTop, we want the offset to be 0.
 
     _scrollOffset = std::max(0, newDelta);
+    _PublishRenderState();
     _buffer->GetRenderTarget().TriggerRedrawAll();
 }
 
+// Method Description:
+// - Scrolls the viewport so that the nearest prompt above (or below) its top row
+//   is at the top. Prompts are found by the marks shell integration left on them,
+//   so nothing is found for shells that don't send them.
+// Arguments:
+// - previous: true for the prompt above the viewport, false for the one below.
+// Return Value:
+// - true if there was a prompt to scroll to.
+bool Terminal::ScrollToPrompt(const bool previous)
+{
+    std::optional<COORD> prompt;
+    {
+        auto lock = LockForReading();
+        const auto top = gsl::narrow<SHORT>(_VisibleStartIndex());
+        prompt = previous ? _buffer->FindPreviousMark({ 0, top }, MarkIndex::Kind::Prompt) :
+                            _buffer->FindNextMark({ _buffer->GetSize().RightInclusive(), top }, MarkIndex::Kind::Prompt);
+    }
+
+    if (!prompt)
+    {
+        return false;
+    }
+
+    UserScrollViewport(prompt->Y);
+    return true;
+}
+
 int Terminal::GetScrollOffset()
 {
     return _VisibleStartIndex();
@@ -439,6 +767,8 @@ int Terminal::GetScrollOffset()
 
 void Terminal::_NotifyScrollEvent()
 {
+    _PublishRenderState();
+
     if (_pfnScrollPositionChanged)
     {
         const auto visible = _GetVisibleViewport();
@@ -490,8 +820,15 @@ void Terminal::_InitializeColorTable()
 // - isVisible: whether the cursor should be visible
 void Terminal::SetCursorVisible(const bool isVisible) noexcept
 {
-    auto& cursor = _buffer->GetCursor();
-    cursor.SetIsVisible(isVisible);
+    try
+    {
+        auto lock = LockForWriting();
+
+        auto& cursor = _buffer->GetCursor();
+        cursor.SetIsVisible(isVisible);
+        _PublishRenderState();
+    }
+    CATCH_LOG();
 }
 
 bool Terminal::IsCursorBlinkingAllowed() const noexcept
@@ -499,3 +836,221 @@ bool Terminal::IsCursorBlinkingAllowed() const noexcept
     const auto& cursor = _buffer->GetCursor();
     return cursor.IsBlinkingAllowed();
 }
+
+// Method Description:
+// - Gets the viewport, cursor and title as they were the last time the terminal changed.
+//   Unlike the IRenderData methods, this is safe to call without holding the lock, from
+//   any thread, while output is being written.
+// Return Value:
+// - the published state, or nullptr before the terminal has been created
+std::shared_ptr<const Terminal::RenderState> Terminal::GetRenderState() const noexcept
+{
+    return std::atomic_load(&_renderState);
+}
+
+// Method Description:
+// - Copies the whole buffer, scrollback included, so that it can be read without the lock from
+//   then on, e.g. while answering accessibility clients.
+// - Rows that haven't changed since the last snapshot are shared with it, and if nothing in the
+//   buffer changed at all, the last snapshot is handed out again.
+// - Takes the lock for as long as the copy takes. It's the write lock because the snapshot is kept
+//   to share rows with the next one. The buffer itself is only read.
+// Return Value:
+// - the snapshot. The rows of the buffer are its rows, so they line up with the viewport.
+std::shared_ptr<const TextBufferSnapshot> Terminal::TakeSnapshot()
+{
+    auto lock = LockForWriting();
+    return _TakeSnapshot();
+}
+
+// Method Description:
+// - Does the work of TakeSnapshot. The caller must hold the write lock.
+std::shared_ptr<const TextBufferSnapshot> Terminal::_TakeSnapshot()
+{
+    // A resize makes a new buffer, and the rows of the old one have nothing to do with it.
+    if (_buffer.get() != _snapshotBuffer)
+    {
+        _lastSnapshot = nullptr;
+        _snapshotBuffer = _buffer.get();
+    }
+
+    if (!_lastSnapshot || _lastSnapshot->GetGeneration() != _buffer->GetGeneration())
+    {
+        _lastSnapshot = _buffer->TakeSnapshot(_buffer->GetSize(), _lastSnapshot.get());
+    }
+    return _lastSnapshot;
+}
+
+// Method Description:
+// - Saves the whole buffer, scrollback included, and where the cursor and the viewport are,
+//   so that RestoreSession can bring them back after a restart without replaying any output.
+// - Only the snapshot is taken under the lock, and it shares the rows that haven't changed
+//   since the last one. The file is written on a thread of its own, after the save before
+//   it has finished.
+// Arguments:
+// - path: the file to save the session to. It's only replaced once the save is complete.
+void Terminal::SaveSession(const std::wstring_view path)
+{
+    _WaitForSessionSave();
+
+    std::shared_ptr<const TextBufferSnapshot> snapshot;
+    TextBufferSession::State state;
+    {
+        auto lock = LockForWriting();
+        snapshot = _TakeSnapshot();
+        state = { _buffer->GetCursor().GetPosition(), _mutableViewport.Top() };
+    }
+
+    _sessionSaveThread = std::thread([snapshot, state, path = std::wstring{ path }]() {
+        try
+        {
+            TextBufferSession::Save(path, *snapshot, state);
+        }
+        CATCH_LOG();
+    });
+}
+
+// Method Description:
+// - Replaces the contents of the buffer with a session saved by SaveSession, and
+//   scrolls to the bottom of it, with the viewport where it was when it was saved.
+// - If the terminal isn't as wide as it was then, the rows are reflowed to fit.
+// Arguments:
+// - path: the file the session was saved to
+// Return Value:
+// - S_OK, or the failure if the file couldn't be read. The buffer is left blank
+//   if the file turns out not to be a saved session partway through.
+[[nodiscard]] HRESULT Terminal::RestoreSession(const std::wstring_view path) noexcept
+try
+{
+    auto lock = LockForWriting();
+
+    const auto state = TextBufferSession::Restore(path, *_buffer);
+
+    // The whole viewport has to fit in the buffer, and the cursor in the viewport.
+    const auto height = _mutableViewport.Height();
+    const auto cursorY = state.cursorPosition.Y;
+    const auto lowest = std::max(0, cursorY - height + 1);
+    const auto highest = std::min<int>(cursorY, _buffer->GetSize().Height() - height);
+    const auto top = std::clamp<int>(state.viewportTop, lowest, std::max(lowest, highest));
+
+    _mutableViewport = Viewport::FromDimensions({ 0, gsl::narrow<short>(top) }, _mutableViewport.Dimensions());
+    _scrollOffset = 0;
+    _buffer->GetRenderTarget().TriggerRedrawAll();
+    _NotifyScrollEvent();
+    return S_OK;
+}
+CATCH_RETURN();
+
+// Method Description:
+// - Starts appending the rows that scroll off the top of the buffer to the given file, and
+//   pages back in the newest rows an earlier terminal left in it. They fill the buffer down to
+//   the row above the cursor, and the viewport is scrolled to the bottom of them.
+// - The rest of the rows in the file are still found by a search.
+// Arguments:
+// - path: the file to keep the rows in. It's made if it isn't there yet.
+// Return Value:
+// - S_OK, or the failure if the file couldn't be opened or isn't an archive.
+//   The terminal goes on without an archive then.
+[[nodiscard]] HRESULT Terminal::AttachScrollbackArchive(const std::wstring_view path) noexcept
+try
+{
+    auto archive = std::make_shared<ScrollbackArchive>(path);
+
+    auto lock = LockForWriting();
+    _buffer->SetScrollbackArchive(std::move(archive));
+
+    const auto paged = _buffer->PageInArchivedRows(_buffer->GetSize().Height() - 1);
+    if (paged > 0)
+    {
+        _buffer->GetCursor().SetPosition({ 0, paged });
+        const auto top = std::max(0, paged - _mutableViewport.Height() + 1);
+        _mutableViewport = Viewport::FromDimensions({ 0, gsl::narrow<short>(top) }, _mutableViewport.Dimensions());
+        _scrollOffset = 0;
+        _buffer->GetRenderTarget().TriggerRedrawAll();
+        _NotifyScrollEvent();
+    }
+    return S_OK;
+}
+CATCH_RETURN();
+
+// Method Description:
+// - Waits for the file of the last SaveSession to be written, if it hasn't been yet.
+void Terminal::_WaitForSessionSave() noexcept
+{
+    if (_sessionSaveThread.joinable())
+    {
+        _sessionSaveThread.join();
+    }
+}
+
+// Method Description:
+// - Starts or stops timing how long Write waits for the lock and spends parsing,
+//   and has the LockProfiler measure the lock while the times are kept.
+//   The characters written are always counted.
+// Arguments:
+// - enabled: true to keep the times, false to stop
+void Terminal::EnablePerformanceCounters(const bool enabled) noexcept
+{
+    if (_performanceCountersEnabled.exchange(enabled, std::memory_order_relaxed) != enabled)
+    {
+        LockProfiler::Instance().SetEnabled(enabled);
+    }
+}
+
+// Method Description:
+// - Gets what Write has done since the terminal was created. The counts only ever go
+//   up, so the caller works out rates from the difference between two calls.
+// - Takes the read lock to measure the buffer, so it shouldn't be called often.
+// Return Value:
+// - the counters, and how many bytes the rows of the buffer take up right now
+Terminal::PerformanceCounters Terminal::GetPerformanceCounters()
+{
+    PerformanceCounters counters{};
+    counters.charsWritten = _charsWritten.load(std::memory_order_relaxed);
+    counters.parseMilliseconds = _parseTime.load(std::memory_order_relaxed) / 1e6;
+    counters.lockWaitMilliseconds = _lockWaitTime.load(std::memory_order_relaxed) / 1e6;
+
+    const auto lockTotals = LockProfiler::Instance().GetTotals(LockProfiler::Lock::Terminal);
+    counters.lockHoldMilliseconds = lockTotals.holdMilliseconds;
+    counters.lockContentions = lockTotals.contended;
+    counters.longLockHolds = lockTotals.longHolds;
+
+    auto lock = LockForReading();
+    if (_buffer)
+    {
+        counters.bufferBytes = _buffer->GetMemoryUsage().Total();
+    }
+    return counters;
+}
+
+// Method Description:
+// - Gets how many bytes the buffer holds, scrollback included, and what for.
+// - Takes the read lock while it walks every row, so it shouldn't be called often.
+// Return Value:
+// - the buffer's memory usage, or all zeroes before the terminal has been created
+TextBuffer::MemoryUsage Terminal::GetMemoryUsage()
+{
+    auto lock = LockForReading();
+    return _buffer ? _buffer->GetMemoryUsage() : TextBuffer::MemoryUsage{};
+}
+
+// Method Description:
+// - Makes a copy of the state that's read without the lock and swaps it in for the old one.
+//   Readers holding on to the old copy keep it until they let go.
+// - Called by whoever changes that state, after the change.
+void Terminal::_PublishRenderState() noexcept
+{
+    try
+    {
+        const auto& cursor = _buffer->GetCursor();
+        auto state = std::make_shared<RenderState>();
+        state->viewport = _GetVisibleViewport();
+        state->cursorPosition = cursor.GetPosition();
+        state->cursorVisible = cursor.IsVisible() && !cursor.IsPopupShown();
+        state->cursorBlinkingAllowed = cursor.IsBlinkingAllowed();
+        state->title = _title;
+
+        std::atomic_store(&_renderState, std::shared_ptr<const RenderState>{ std::move(state) });
+    }
+    CATCH_LOG();
+}
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <conattrs.hpp>
+#include <chrono>
 
 #include "../../buffer/out/textBuffer.hpp"
 #include "../../renderer/inc/IRenderData.hpp"
@@ -11,6 +12,7 @@
 #include "../../terminal/input/terminalInput.hpp"
 
 #include "../../types/inc/Viewport.hpp"
+#include "../../types/inc/LockProfiler.hpp"
 #include "../../cascadia/terminalcore/ITerminalApi.hpp"
 #include "../../cascadia/terminalcore/ITerminalInput.hpp"
 
@@ -34,7 +36,12 @@ class Microsoft::Terminal::Core::Terminal final :
 {
 public:
     Terminal();
-    virtual ~Terminal(){};
+    virtual ~Terminal()
+    {
+        _CancelSearch();
+        _WaitForSessionSave();
+        EnablePerformanceCounters(false);
+    };
 
     void Create(COORD viewportSize,
                 SHORT scrollbackLines,
@@ -42,17 +49,23 @@ public:
 
     void CreateFromSettings(winrt::Microsoft::Terminal::Settings::ICoreSettings settings,
                             Microsoft::Console::Render::IRenderTarget& renderTarget);
+    void CreateFromSettings(winrt::Microsoft::Terminal::Settings::ICoreSettings settings,
+                            const COORD viewportSize,
+                            Microsoft::Console::Render::IRenderTarget& renderTarget);
 
     void UpdateSettings(winrt::Microsoft::Terminal::Settings::ICoreSettings settings);
 
     // Write goes through the parser
     void Write(std::wstring_view stringView);
 
-    [[nodiscard]] std::shared_lock<std::shared_mutex> LockForReading();
-    [[nodiscard]] std::unique_lock<std::shared_mutex> LockForWriting();
+    [[nodiscard]] std::shared_lock<Microsoft::Console::Types::ProfiledSharedMutex> LockForReading();
+    [[nodiscard]] std::unique_lock<Microsoft::Console::Types::ProfiledSharedMutex> LockForWriting();
 
     short GetBufferHeight() const noexcept;
 
+    // Scrolls to a prompt the shell marked, without searching the text for it.
+    bool ScrollToPrompt(const bool previous);
+
 #pragma region ITerminalApi
     // These methods are defined in TerminalApi.cpp
     bool PrintString(std::wstring_view stringView) override;
@@ -67,11 +80,21 @@ public:
     bool SetCursorPosition(short x, short y) override;
     COORD GetCursorPosition() override;
     bool EraseCharacters(const unsigned int numChars) override;
+    bool EraseInLine(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::EraseType eraseType) override;
+    bool EraseInDisplay(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::EraseType eraseType) override;
+    bool SetScrollingMargins(const short topMargin, const short bottomMargin) override;
+    bool InsertLines(const unsigned int count) override;
+    bool DeleteLines(const unsigned int count) override;
+    bool ScrollUp(const unsigned int distance) override;
+    bool ScrollDown(const unsigned int distance) override;
+    bool ReverseLineFeed() override;
     bool SetWindowTitle(std::wstring_view title) override;
     bool SetColorTableEntry(const size_t tableIndex, const COLORREF dwColor) override;
     bool SetCursorStyle(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::CursorStyle cursorStyle) override;
     bool SetDefaultForeground(const COLORREF dwColor) override;
     bool SetDefaultBackground(const COLORREF dwColor) override;
+    bool EnableSynchronizedUpdate(const bool enabled) override;
+    bool AddShellMark(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::ShellMarkType markType) override;
 #pragma endregion
 
 #pragma region ITerminalInput
@@ -114,6 +137,47 @@ public:
     void SetCursorVisible(const bool isVisible) noexcept;
     bool IsCursorBlinkingAllowed() const noexcept;
 
+    // What the UI thread needs to know about the terminal, published by the writer
+    // every time it changes so that it can be read without taking the lock.
+    struct RenderState
+    {
+        Microsoft::Console::Types::Viewport viewport{ Microsoft::Console::Types::Viewport::Empty() };
+        COORD cursorPosition{ 0, 0 };
+        bool cursorVisible{ false };
+        bool cursorBlinkingAllowed{ false };
+        std::wstring title;
+    };
+    std::shared_ptr<const RenderState> GetRenderState() const noexcept;
+
+    std::shared_ptr<const TextBufferSnapshot> TakeSnapshot();
+
+    // Saves the buffer to a file in the background, to be restored after a restart.
+    void SaveSession(const std::wstring_view path);
+    [[nodiscard]] HRESULT RestoreSession(const std::wstring_view path) noexcept;
+
+    // Keeps the rows that scroll off the top of the buffer in a file, from which a terminal
+    // made later with the same file gets them back.
+    [[nodiscard]] HRESULT AttachScrollbackArchive(const std::wstring_view path) noexcept;
+
+    // What Write has done so far, for the performance overlay. The times are only kept
+    // while the counters are enabled, since they cost a few reads of the clock per slice.
+    // The lock's holds and contention are those of every terminal in the process together,
+    // as the LockProfiler measured them.
+    struct PerformanceCounters
+    {
+        uint64_t charsWritten;
+        double parseMilliseconds;
+        double lockWaitMilliseconds;
+        double lockHoldMilliseconds;
+        uint64_t lockContentions;
+        uint64_t longLockHolds;
+        size_t bufferBytes;
+    };
+    void EnablePerformanceCounters(const bool enabled) noexcept;
+    PerformanceCounters GetPerformanceCounters();
+
+    TextBuffer::MemoryUsage GetMemoryUsage();
+
 #pragma region TextSelection
     // These methods are defined in TerminalSelection.cpp
     const bool IsSelectionActive() const noexcept;
@@ -127,6 +191,14 @@ public:
     const std::wstring RetrieveSelectedTextFromBuffer(bool trimTrailingWhitespace) const;
 #pragma endregion
 
+#pragma region TextSearch
+    // These methods are defined in TerminalSearch.cpp
+    void StartSearch(const std::wstring_view needle,
+                     const bool caseSensitive,
+                     std::function<void(const std::vector<SMALL_RECT>&)> pfnMatchesFound);
+    void StopSearch();
+#pragma endregion
+
 private:
     std::function<void(std::wstring&)> _pfnWriteInput;
     std::function<void(const std::wstring_view&)> _pfnTitleChanged;
@@ -138,6 +210,15 @@ private:
 
     std::wstring _title;
 
+    std::shared_ptr<const RenderState> _renderState;
+
+    // The last copy of the buffer handed out by TakeSnapshot, to share unchanged rows with the next one.
+    const TextBuffer* _snapshotBuffer{ nullptr };
+    std::shared_ptr<const TextBufferSnapshot> _lastSnapshot;
+
+    // Writes the file for SaveSession, so that only the snapshot is taken under the lock.
+    std::thread _sessionSaveThread;
+
     std::array<COLORREF, XTERM_COLOR_TABLE_SIZE> _colorTable;
     COLORREF _defaultFg;
     COLORREF _defaultBg;
@@ -151,9 +232,82 @@ private:
     bool _selectionActive;
     SHORT _selectionAnchor_YOffset;
     SHORT _endSelectionPosition_YOffset;
+
+    // Bumped whenever the selection changes. The rectangles made from the selection are
+    // kept until it, the buffer or the mutable viewport changes, since the renderer asks
+    // for them more than once per frame.
+    uint64_t _selectionGeneration;
+    struct SelectionRectsCache
+    {
+        uint64_t selectionGeneration;
+        const TextBuffer* buffer;
+        uint64_t bufferGeneration;
+        Microsoft::Console::Types::Viewport mutableViewport;
+        std::vector<SMALL_RECT> rects;
+    };
+    mutable std::optional<SelectionRectsCache> _selectionRectsCache;
     std::wstring _wordDelimiters;
 
-    std::shared_mutex _readWriteLock;
+    // Text Search
+    // The matches are rows of the buffer that was searched, top to bottom. They're painted
+    // like the selection, and only as long as that buffer is still the one in use.
+    // A match's row counts the rows that have circled off the top of the buffer too
+    // (see TextBuffer::GetCircledRowCount), so it stays put as the buffer circles.
+    struct SearchMatch
+    {
+        uint64_t row;
+        SHORT left;
+        SHORT right;
+    };
+
+    std::thread _searchThread;
+    std::atomic<bool> _searchCanceled{ false };
+    const TextBuffer* _searchBuffer{ nullptr };
+    std::vector<SearchMatch> _searchMatches;
+
+    // How many rows the search reads each time it takes the lock.
+    static constexpr SHORT SearchBatchRows = 512;
+
+    // One row of a search batch. It's laid out as text while the lock is held and matched once it's let go.
+    struct SearchRow
+    {
+        uint64_t row; // counting the rows that have circled off, like SearchMatch::row, or its index in the scrollback archive
+        std::wstring text;
+        std::vector<std::pair<SHORT, SHORT>> columns; // the first and last column of the glyph each code unit of text comes from
+        std::vector<SearchMatch> found;
+    };
+
+    // The rows of a search batch, matched by the search thread and SearchMatchHelpers thread pool
+    // callbacks at the same time, each taking the next row in line. Every row's matches stay with
+    // the row, so they're put back together top to bottom without any sorting.
+    struct SearchBatch
+    {
+        std::wstring_view needle;
+        const std::atomic<bool>* canceled;
+        std::vector<SearchRow> rows; // only the first used are part of the batch; the rest are kept for their storage
+        size_t used = 0;
+        std::atomic<size_t> next{ 0 };
+    };
+    static constexpr size_t SearchMatchHelpers = 3;
+
+    Microsoft::Console::Types::ProfiledSharedMutex _readWriteLock{ Microsoft::Console::Types::LockProfiler::Lock::Terminal };
+
+    // How many characters Write hands to the parser before it lets go of the lock for a moment.
+    static constexpr size_t WriteSliceSize = 16 * 1024;
+
+    // The most bytes the buffer may hold before Write gives up scrollback (0 for no limit),
+    // and when it last checked.
+    size_t _scrollbackMemoryBudget{ 0 };
+    std::chrono::steady_clock::time_point _lastMemoryBudgetCheck{};
+
+    // How often Write checks the buffer against the budget. Measuring it walks every row.
+    static constexpr std::chrono::seconds MemoryBudgetCheckInterval{ 1 };
+
+    // The performance counters. The times are in nanoseconds.
+    std::atomic<bool> _performanceCountersEnabled{ false };
+    std::atomic<uint64_t> _charsWritten{ 0 };
+    std::atomic<uint64_t> _parseTime{ 0 };
+    std::atomic<uint64_t> _lockWaitTime{ 0 };
 
     // TODO: These members are not shared by an alt-buffer. They should be
     //      encapsulated, such that a Terminal can have both a main and alt buffer.
@@ -161,6 +315,10 @@ private:
     Microsoft::Console::Types::Viewport _mutableViewport;
     SHORT _scrollbackLines;
 
+    // The top and bottom scrolling margins (DECSTBM), as rows within the mutable viewport.
+    // When both are 0 there are no margins, and the whole viewport scrolls.
+    SMALL_RECT _scrollMargins;
+
     // _scrollOffset is the number of lines above the viewport that are currently visible
     // If _scrollOffset is 0, then the visible region of the buffer is the viewport.
     int _scrollOffset;
@@ -182,16 +340,30 @@ private:
 
     Microsoft::Console::Types::Viewport _GetMutableViewport() const noexcept;
     Microsoft::Console::Types::Viewport _GetVisibleViewport() const noexcept;
+    Microsoft::Console::Types::Viewport _GetScrollRegion() const noexcept;
+
+    void _ScrollRegion(const Microsoft::Console::Types::Viewport& region, const int delta);
 
     void _InitializeColorTable();
 
     void _WriteBuffer(const std::wstring_view& stringView);
+    bool _WritePrintableRun(const std::wstring_view run);
+    bool _LineFeed(COORD position);
+    bool _AdjustCursorPosition(COORD proposedCursorPosition);
+    void _ProcessSlice(const std::wstring_view slice);
+    void _EnforceMemoryBudget();
 
     void _NotifyScrollEvent();
 
+    void _PublishRenderState() noexcept;
+
+    std::shared_ptr<const TextBufferSnapshot> _TakeSnapshot();
+    void _WaitForSessionSave() noexcept;
+
 #pragma region TextSelection
     // These methods are defined in TerminalSelection.cpp
     std::vector<SMALL_RECT> _GetSelectionRects() const;
+    std::vector<SMALL_RECT> _CalculateSelectionRects() const;
     const SHORT _ExpandWideGlyphSelectionLeft(const SHORT xPos, const SHORT yPos) const;
     const SHORT _ExpandWideGlyphSelectionRight(const SHORT xPos, const SHORT yPos) const;
     void _ExpandDoubleClickSelectionLeft(const COORD position);
@@ -199,4 +371,15 @@ private:
     const bool _isWordDelimiter(std::wstring_view cellChar) const;
     const COORD _ConvertToBufferCell(const COORD viewportPos) const;
 #pragma endregion
+
+#pragma region TextSearch
+    // These methods are defined in TerminalSearch.cpp
+    void _CancelSearch() noexcept;
+    void _SearchBuffer(const std::wstring needle,
+                       const bool caseSensitive,
+                       const std::function<void(const std::vector<SMALL_RECT>&)> pfnMatchesFound);
+    std::vector<SMALL_RECT> _GetSearchMatchRects(const Microsoft::Console::Types::Viewport& rows) const;
+    static void s_MatchSearchRows(SearchBatch& batch) noexcept;
+    static void CALLBACK s_MatchSearchRowsCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work) noexcept;
+#pragma endregion
 };
@@ -137,9 +137,222 @@ bool Terminal::EraseCharacters(const unsigned int numChars)
     return true;
 }
 
+// Method Description:
+// - Erases part or all of the cursor's line with the current attributes.
+// Arguments:
+// - eraseType: whether to erase up to the cursor, from it, or the whole line.
+// Return Value:
+// - true iff the erase type is one that applies to a line.
+bool Terminal::EraseInLine(const DispatchTypes::EraseType eraseType)
+{
+    const auto cursorPos = _buffer->GetCursor().GetPosition();
+    const auto viewport = _GetMutableViewport();
+    SHORT left = viewport.Left();
+    SHORT right = viewport.RightExclusive();
+
+    switch (eraseType)
+    {
+    case DispatchTypes::EraseType::ToEnd:
+        left = cursorPos.X;
+        break;
+    case DispatchTypes::EraseType::FromBeginning:
+        right = gsl::narrow_cast<SHORT>(cursorPos.X + 1);
+        break;
+    case DispatchTypes::EraseType::All:
+        break;
+    default:
+        return false;
+    }
+
+    const auto erase = Viewport::FromDimensions({ left, cursorPos.Y }, gsl::narrow_cast<SHORT>(right - left), 1);
+    _buffer->FillRect(erase, UNICODE_SPACE, _buffer->GetCurrentAttributes());
+    return true;
+}
+
+// Method Description:
+// - Erases part or all of the viewport with the current attributes, or
+//   clears the scrollback above it.
+// Arguments:
+// - eraseType: which part of the display to erase.
+// Return Value:
+// - true iff the erase type is one we know.
+bool Terminal::EraseInDisplay(const DispatchTypes::EraseType eraseType)
+{
+    const auto cursorPos = _buffer->GetCursor().GetPosition();
+    const auto viewport = _GetMutableViewport();
+    const auto attrs = _buffer->GetCurrentAttributes();
+
+    switch (eraseType)
+    {
+    case DispatchTypes::EraseType::ToEnd:
+        // The rest of the cursor's line, then every line below it, each one a single fill.
+        _buffer->FillRect(Viewport::FromDimensions(cursorPos, gsl::narrow_cast<SHORT>(viewport.RightExclusive() - cursorPos.X), 1), UNICODE_SPACE, attrs);
+        _buffer->FillRect(Viewport::FromInclusive({ viewport.Left(), gsl::narrow_cast<SHORT>(cursorPos.Y + 1), viewport.RightInclusive(), viewport.BottomInclusive() }), UNICODE_SPACE, attrs);
+        return true;
+    case DispatchTypes::EraseType::FromBeginning:
+        _buffer->FillRect(Viewport::FromExclusive({ viewport.Left(), viewport.Top(), viewport.RightExclusive(), cursorPos.Y }), UNICODE_SPACE, attrs);
+        _buffer->FillRect(Viewport::FromDimensions({ viewport.Left(), cursorPos.Y }, gsl::narrow_cast<SHORT>(cursorPos.X - viewport.Left() + 1), 1), UNICODE_SPACE, attrs);
+        return true;
+    case DispatchTypes::EraseType::All:
+        _buffer->FillRect(viewport, UNICODE_SPACE, attrs);
+        return true;
+    case DispatchTypes::EraseType::Scrollback:
+        break;
+    default:
+        return false;
+    }
+
+    // To clear the scrollback, rotate the viewport up to the top of the buffer and
+    // blank out the rows that were above it, which now sit right below it.
+    const auto viewTop = viewport.Top();
+    if (viewTop > 0)
+    {
+        _buffer->ScrollRows(viewTop, viewport.Height(), gsl::narrow_cast<SHORT>(-viewTop));
+        _buffer->FillRect(Viewport::FromDimensions({ viewport.Left(), viewport.Height() }, viewport.Width(), viewTop), UNICODE_SPACE, attrs);
+        _buffer->GetCursor().SetYPosition(cursorPos.Y - viewTop);
+
+        _mutableViewport = Viewport::FromDimensions({ 0, 0 }, _mutableViewport.Dimensions());
+        _scrollOffset = 0;
+        _buffer->GetRenderTarget().TriggerRedrawAll();
+        _NotifyScrollEvent();
+    }
+    return true;
+}
+
+// Method Description:
+// - Sets the top and bottom scrolling margins (DECSTBM). Margins that cover
+//   the whole viewport are cleared instead, and an illegal pair is ignored.
+// Arguments:
+// - topMargin: the line of the top margin, counting from 1. 0 for the default, the first line.
+// - bottomMargin: the line of the bottom margin, counting from 1. 0 for the default, the last line.
+// Return Value:
+// - true iff the margins were legal.
+bool Terminal::SetScrollingMargins(const short topMargin, const short bottomMargin)
+{
+    const auto viewHeight = _mutableViewport.Height();
+    const short top = topMargin == 0 ? 1 : topMargin;
+    const short bottom = bottomMargin == 0 ? viewHeight : bottomMargin;
+
+    // The top margin must be above the bottom one, and both must be on screen.
+    if (top < 1 || top >= bottom || bottom > viewHeight)
+    {
+        return false;
+    }
+
+    if (top == 1 && bottom == viewHeight)
+    {
+        _scrollMargins = { 0, 0, 0, 0 };
+    }
+    else
+    {
+        // In VT, the first line is 1. Within the viewport, it's 0.
+        _scrollMargins.Top = gsl::narrow_cast<SHORT>(top - 1);
+        _scrollMargins.Bottom = gsl::narrow_cast<SHORT>(bottom - 1);
+    }
+    return true;
+}
+
+// Method Description:
+// - Inserts blank lines at the cursor, pushing the lines below it down
+//   towards the bottom margin. The lines pushed past the margin are lost.
+//   The cursor moves to the start of its line.
+// Arguments:
+// - count: the number of lines to insert.
+// Return Value:
+// - true
+bool Terminal::InsertLines(const unsigned int count)
+{
+    auto& cursor = _buffer->GetCursor();
+    const auto cursorPos = cursor.GetPosition();
+    const auto region = _GetScrollRegion();
+
+    // Lines outside of the margins are never moved.
+    if (region.IsInBounds(cursorPos))
+    {
+        const auto below = Viewport::FromInclusive({ region.Left(), cursorPos.Y, region.RightInclusive(), region.BottomInclusive() });
+        _ScrollRegion(below, gsl::narrow_cast<int>(std::min(count, static_cast<unsigned int>(below.Height()))));
+        cursor.SetXPosition(0);
+    }
+    return true;
+}
+
+// Method Description:
+// - Deletes lines at the cursor, pulling the lines below it up and filling
+//   in blank lines at the bottom margin. The cursor moves to the start of its line.
+// Arguments:
+// - count: the number of lines to delete.
+// Return Value:
+// - true
+bool Terminal::DeleteLines(const unsigned int count)
+{
+    auto& cursor = _buffer->GetCursor();
+    const auto cursorPos = cursor.GetPosition();
+    const auto region = _GetScrollRegion();
+
+    // Lines outside of the margins are never moved.
+    if (region.IsInBounds(cursorPos))
+    {
+        const auto below = Viewport::FromInclusive({ region.Left(), cursorPos.Y, region.RightInclusive(), region.BottomInclusive() });
+        _ScrollRegion(below, -gsl::narrow_cast<int>(std::min(count, static_cast<unsigned int>(below.Height()))));
+        cursor.SetXPosition(0);
+    }
+    return true;
+}
+
+// Method Description:
+// - Scrolls the contents of the scrolling region up, filling in blank lines
+//   at the bottom. The cursor doesn't move.
+// Arguments:
+// - distance: the number of lines to scroll.
+// Return Value:
+// - true
+bool Terminal::ScrollUp(const unsigned int distance)
+{
+    const auto region = _GetScrollRegion();
+    _ScrollRegion(region, -gsl::narrow_cast<int>(std::min(distance, static_cast<unsigned int>(region.Height()))));
+    return true;
+}
+
+// Method Description:
+// - Scrolls the contents of the scrolling region down, filling in blank lines
+//   at the top. The cursor doesn't move.
+// Arguments:
+// - distance: the number of lines to scroll.
+// Return Value:
+// - true
+bool Terminal::ScrollDown(const unsigned int distance)
+{
+    const auto region = _GetScrollRegion();
+    _ScrollRegion(region, gsl::narrow_cast<int>(std::min(distance, static_cast<unsigned int>(region.Height()))));
+    return true;
+}
+
+// Method Description:
+// - Moves the cursor up a line. At the top margin, the contents of the
+//   scrolling region are scrolled down a line instead.
+// Return Value:
+// - true
+bool Terminal::ReverseLineFeed()
+{
+    auto& cursor = _buffer->GetCursor();
+    const auto cursorPos = cursor.GetPosition();
+    const auto region = _GetScrollRegion();
+
+    if (cursorPos.Y == region.Top())
+    {
+        _ScrollRegion(region, 1);
+    }
+    else if (cursorPos.Y > _mutableViewport.Top())
+    {
+        cursor.SetYPosition(cursorPos.Y - 1);
+    }
+    return true;
+}
+
 bool Terminal::SetWindowTitle(std::wstring_view title)
 {
     _title = title;
+    _PublishRenderState();
 
     if (_pfnTitleChanged)
     {
@@ -250,3 +463,57 @@ bool Terminal::SetDefaultBackground(const COLORREF dwColor)
     _buffer->GetRenderTarget().TriggerRedrawAll();
     return true;
 }
+
+// Method Description:
+// - Begins or ends a synchronized update. While one is underway, the renderer
+//   holds back frames so that everything drawn in the meantime shows up at once.
+// Arguments:
+// - enabled: true to begin the update, false to end it.
+// Return Value:
+// - true
+bool Terminal::EnableSynchronizedUpdate(const bool enabled)
+{
+    if (enabled)
+    {
+        _buffer->GetRenderTarget().BeginSynchronizedUpdate();
+    }
+    else
+    {
+        _buffer->GetRenderTarget().EndSynchronizedUpdate();
+    }
+    return true;
+}
+
+// Method Description:
+// - Marks where part of a shell's prompt cycle begins, at the cursor. The buffer
+//   keeps the marks, so they move along with the text as it scrolls and reflows.
+// Arguments:
+// - markType: which part of the cycle begins
+// Return Value:
+// - true iff the mark was added
+bool Terminal::AddShellMark(const DispatchTypes::ShellMarkType markType)
+try
+{
+    MarkIndex::Kind kind = MarkIndex::Kind::Prompt;
+    switch (markType)
+    {
+    case DispatchTypes::ShellMarkType::PromptStart:
+        kind = MarkIndex::Kind::Prompt;
+        break;
+    case DispatchTypes::ShellMarkType::CommandStart:
+        kind = MarkIndex::Kind::Command;
+        break;
+    case DispatchTypes::ShellMarkType::CommandExecuted:
+        kind = MarkIndex::Kind::Output;
+        break;
+    case DispatchTypes::ShellMarkType::CommandFinished:
+        kind = MarkIndex::Kind::CommandEnd;
+        break;
+    default:
+        return false;
+    }
+
+    _buffer->AddMark(kind, _buffer->GetCursor().GetPosition());
+    return true;
+}
+CATCH_LOG_RETURN_FALSE()
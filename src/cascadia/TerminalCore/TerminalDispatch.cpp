@@ -52,6 +52,67 @@ bool TerminalDispatch::EraseCharacters(const unsigned int uiNumChars)
     return _terminalApi.EraseCharacters(uiNumChars);
 }
 
+// Method Description:
+// - EL - Erases part or all of the cursor's line.
+// Arguments:
+// - eraseType: which part of the line to erase
+// Return Value:
+// True if handled successfully. False otherwise.
+bool TerminalDispatch::EraseInLine(const DispatchTypes::EraseType eraseType)
+{
+    return _terminalApi.EraseInLine(eraseType);
+}
+
+// Method Description:
+// - ED - Erases part or all of the display, or the scrollback above it.
+// Arguments:
+// - eraseType: which part of the display to erase
+// Return Value:
+// True if handled successfully. False otherwise.
+bool TerminalDispatch::EraseInDisplay(const DispatchTypes::EraseType eraseType)
+{
+    return _terminalApi.EraseInDisplay(eraseType);
+}
+
+// Method Description:
+// - DECSTBM - Sets the top and bottom scrolling margins, then moves the
+//   cursor home like AdaptDispatch does.
+// Arguments:
+// - sTopMargin: the line number of the top margin, or 0 for the default.
+// - sBottomMargin: the line number of the bottom margin, or 0 for the default.
+// Return Value:
+// True if handled successfully. False otherwise.
+bool TerminalDispatch::SetTopBottomScrollingMargins(const SHORT sTopMargin,
+                                                    const SHORT sBottomMargin)
+{
+    return _terminalApi.SetScrollingMargins(sTopMargin, sBottomMargin) && CursorPosition(1, 1);
+}
+
+bool TerminalDispatch::InsertLine(const unsigned int uiDistance)
+{
+    return _terminalApi.InsertLines(uiDistance);
+}
+
+bool TerminalDispatch::DeleteLine(const unsigned int uiDistance)
+{
+    return _terminalApi.DeleteLines(uiDistance);
+}
+
+bool TerminalDispatch::ScrollUp(const unsigned int uiDistance)
+{
+    return _terminalApi.ScrollUp(uiDistance);
+}
+
+bool TerminalDispatch::ScrollDown(const unsigned int uiDistance)
+{
+    return _terminalApi.ScrollDown(uiDistance);
+}
+
+bool TerminalDispatch::ReverseLineFeed()
+{
+    return _terminalApi.ReverseLineFeed();
+}
+
 bool TerminalDispatch::SetWindowTitle(std::wstring_view title)
 {
     return _terminalApi.SetWindowTitle(title);
@@ -96,3 +157,90 @@ bool TerminalDispatch::SetDefaultBackground(const DWORD dwColor)
 {
     return _terminalApi.SetDefaultBackground(dwColor);
 }
+
+// Method Description:
+// - DECSET - Enables the given DEC private mode params.
+// Arguments:
+// - rgParams - array of params to set
+// - cParams - length of rgParams
+// Return Value:
+// True if handled successfully. False otherwise.
+bool TerminalDispatch::SetPrivateModes(_In_reads_(cParams) const DispatchTypes::PrivateModeParams* const rgParams,
+                                       const size_t cParams)
+{
+    return _SetResetPrivateModes(rgParams, cParams, true);
+}
+
+// Method Description:
+// - DECRST - Disables the given DEC private mode params.
+// Arguments:
+// - rgParams - array of params to reset
+// - cParams - length of rgParams
+// Return Value:
+// True if handled successfully. False otherwise.
+bool TerminalDispatch::ResetPrivateModes(_In_reads_(cParams) const DispatchTypes::PrivateModeParams* const rgParams,
+                                         const size_t cParams)
+{
+    return _SetResetPrivateModes(rgParams, cParams, false);
+}
+
+// Method Description:
+// - Begins or ends a synchronized update, during which frames are held back
+//   until the app has finished drawing.
+// Arguments:
+// - fEnabled - true to begin the update, false to end it.
+// Return Value:
+// True if handled successfully. False otherwise.
+bool TerminalDispatch::EnableSynchronizedUpdate(const bool fEnabled)
+{
+    return _terminalApi.EnableSynchronizedUpdate(fEnabled);
+}
+
+// Method Description:
+// - Marks where part of a shell's prompt cycle begins, at the cursor.
+// Arguments:
+// - markType - which part of the cycle begins
+// Return Value:
+// True if handled successfully. False otherwise.
+bool TerminalDispatch::AddShellMark(const DispatchTypes::ShellMarkType markType)
+{
+    return _terminalApi.AddShellMark(markType);
+}
+
+// Method Description:
+// - Sets or resets each of the given params. All of them are attempted, even if
+//   one fails, so that params we support still take effect when they're chained
+//   with ones we don't.
+// Arguments:
+// - rgParams - array of params to set or reset
+// - cParams - length of rgParams
+// - fEnable - true to set the params, false to reset them
+// Return Value:
+// True if ALL params were handled successfully. False otherwise.
+bool TerminalDispatch::_SetResetPrivateModes(_In_reads_(cParams) const DispatchTypes::PrivateModeParams* const rgParams,
+                                             const size_t cParams,
+                                             const bool fEnable)
+{
+    size_t cFailures = 0;
+    for (size_t i = 0; i < cParams; i++)
+    {
+        cFailures += _PrivateModeParamsHelper(rgParams[i], fEnable) ? 0 : 1; // increment the number of failures if we fail.
+    }
+    return cFailures == 0;
+}
+
+bool TerminalDispatch::_PrivateModeParamsHelper(const DispatchTypes::PrivateModeParams param, const bool fEnable)
+{
+    bool fSuccess = false;
+    switch (param)
+    {
+    case DispatchTypes::PrivateModeParams::SYNCHRONIZED_UPDATE:
+        fSuccess = EnableSynchronizedUpdate(fEnable);
+        break;
+    default:
+        // If no functions to call, overall dispatch was a failure.
+        fSuccess = false;
+        break;
+    }
+    return fSuccess;
+}
@@ -4,7 +4,7 @@
 #include "../../terminal/adapter/termDispatch.hpp"
 #include "ITerminalApi.hpp"
 
-class TerminalDispatch : public Microsoft::Console::VirtualTerminal::TermDispatch
+class TerminalDispatch final : public Microsoft::Console::VirtualTerminal::TermDispatch
 {
 public:
     TerminalDispatch(::Microsoft::Terminal::Core::ITerminalApi& terminalApi);
@@ -13,8 +13,7 @@ public:
     virtual void Print(const wchar_t wchPrintable) override;
     virtual void PrintString(const wchar_t* const rgwch, const size_t cch) override;
 
-    bool SetGraphicsRendition(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::GraphicsOptions* const rgOptions,
-                              const size_t cOptions) override;
+    bool SetGraphicsRendition(const gsl::span<const ::Microsoft::Console::VirtualTerminal::DispatchTypes::GraphicsOptions> options) override;
 
     virtual bool CursorPosition(const unsigned int uiLine,
                                 const unsigned int uiColumn) override; // CUP
@@ -22,6 +21,16 @@ public:
     bool CursorForward(const unsigned int uiDistance) override;
 
     bool EraseCharacters(const unsigned int uiNumChars) override;
+    bool EraseInLine(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::EraseType eraseType) override; // EL
+    bool EraseInDisplay(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::EraseType eraseType) override; // ED
+
+    bool SetTopBottomScrollingMargins(const SHORT sTopMargin, const SHORT sBottomMargin) override; // DECSTBM
+    bool InsertLine(const unsigned int uiDistance) override; // IL
+    bool DeleteLine(const unsigned int uiDistance) override; // DL
+    bool ScrollUp(const unsigned int uiDistance) override; // SU
+    bool ScrollDown(const unsigned int uiDistance) override; // SD
+    bool ReverseLineFeed() override; // RI
+
     bool SetWindowTitle(std::wstring_view title) override;
 
     bool SetColorTableEntry(const size_t tableIndex, const DWORD dwColor) override;
@@ -30,6 +39,13 @@ public:
     bool SetDefaultForeground(const DWORD dwColor) override;
     bool SetDefaultBackground(const DWORD dwColor) override;
 
+    bool SetPrivateModes(_In_reads_(cParams) const ::Microsoft::Console::VirtualTerminal::DispatchTypes::PrivateModeParams* const rgParams,
+                         const size_t cParams) override; // DECSET
+    bool ResetPrivateModes(_In_reads_(cParams) const ::Microsoft::Console::VirtualTerminal::DispatchTypes::PrivateModeParams* const rgParams,
+                           const size_t cParams) override; // DECRST
+    bool EnableSynchronizedUpdate(const bool fEnabled) override; // ?2026
+    bool AddShellMark(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::ShellMarkType markType) override; // OSCShellMark
+
 private:
     ::Microsoft::Terminal::Core::ITerminalApi& _terminalApi;
 
@@ -43,4 +59,9 @@ private:
     bool _SetBoldColorHelper(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::GraphicsOptions option);
     bool _SetDefaultColorHelper(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::GraphicsOptions option);
     void _SetGraphicsOptionHelper(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::GraphicsOptions opt);
+
+    bool _SetResetPrivateModes(_In_reads_(cParams) const ::Microsoft::Console::VirtualTerminal::DispatchTypes::PrivateModeParams* const rgParams,
+                               const size_t cParams,
+                               const bool fEnable);
+    bool _PrivateModeParamsHelper(const ::Microsoft::Console::VirtualTerminal::DispatchTypes::PrivateModeParams param, const bool fEnable);
 };
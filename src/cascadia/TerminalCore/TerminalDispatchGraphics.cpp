@@ -288,28 +288,28 @@ void TerminalDispatch::_SetGraphicsOptionHelper(const DispatchTypes::GraphicsOpt
     }
 }
 
-bool TerminalDispatch::SetGraphicsRendition(const DispatchTypes::GraphicsOptions* const rgOptions,
-                                            const size_t cOptions)
+bool TerminalDispatch::SetGraphicsRendition(const gsl::span<const DispatchTypes::GraphicsOptions> options)
 {
     bool fSuccess = false;
+    const size_t cOptions = gsl::narrow_cast<size_t>(options.size());
     // Run through the graphics options and apply them
     for (size_t i = 0; i < cOptions; i++)
     {
-        DispatchTypes::GraphicsOptions opt = rgOptions[i];
+        DispatchTypes::GraphicsOptions opt = options[i];
         if (s_IsDefaultColorOption(opt))
         {
             fSuccess = _SetDefaultColorHelper(opt);
         }
         else if (s_IsBoldColorOption(opt))
         {
-            fSuccess = _SetBoldColorHelper(rgOptions[i]);
+            fSuccess = _SetBoldColorHelper(opt);
         }
         else if (s_IsRgbColorOption(opt))
         {
             size_t cOptionsConsumed = 0;
 
             // _SetRgbColorsHelper will call the appropriate ConApi function
-            fSuccess = _SetRgbColorsHelper(&(rgOptions[i]), cOptions - i, &cOptionsConsumed);
+            fSuccess = _SetRgbColorsHelper(&(options[i]), cOptions - i, &cOptionsConsumed);
 
             i += (cOptionsConsumed - 1); // cOptionsConsumed includes the opt we're currently on.
         }
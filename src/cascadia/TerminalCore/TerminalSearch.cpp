@@ -0,0 +1,379 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "Terminal.hpp"
+
+using namespace Microsoft::Terminal::Core;
+using namespace Microsoft::Console::Types;
+
+// Method Description:
+// - Starts looking for the given text through the whole buffer, scrollback included.
+//   The search runs on a worker thread. Matches are highlighted as they're found,
+//   and each batch of them is also handed to the callback, on the worker thread.
+// - If there's a scrollback archive, the rows that are only in it are searched first.
+//   Their matches go to the callback with a negative Y, counting up from -1 for the row
+//   right above the top of the buffer as it was when the search started. Only the newest
+//   SHRT_MAX of those rows are searched, and their matches can't be highlighted.
+// - Any search that was already running is stopped first.
+// - Must not be called with the terminal locked, since it waits for the previous search to stop.
+// Arguments:
+// - needle: the text to look for. Matches don't span more than one row.
+// - caseSensitive: true if the case of letters has to match too
+// - pfnMatchesFound: optional callback for each batch of matches, in buffer coordinates
+void Terminal::StartSearch(const std::wstring_view needle,
+                           const bool caseSensitive,
+                           std::function<void(const std::vector<SMALL_RECT>&)> pfnMatchesFound)
+{
+    StopSearch();
+
+    if (needle.empty())
+    {
+        return;
+    }
+
+    std::wstring folded{ needle };
+    if (!caseSensitive)
+    {
+        std::transform(folded.begin(), folded.end(), folded.begin(), ::towlower);
+    }
+
+    {
+        auto lock = LockForWriting();
+        _searchBuffer = _buffer.get();
+    }
+
+    _searchCanceled.store(false);
+    _searchThread = std::thread([this, folded, caseSensitive, pfnMatchesFound]() {
+        _SearchBuffer(folded, caseSensitive, pfnMatchesFound);
+    });
+}
+
+// Method Description:
+// - Stops the current search, if there is one, and takes its highlights off the screen.
+// - Must not be called with the terminal locked, since it waits for the search to stop.
+void Terminal::StopSearch()
+{
+    _CancelSearch();
+
+    auto lock = LockForWriting();
+    if (!_searchMatches.empty())
+    {
+        _searchMatches.clear();
+        _buffer->GetRenderTarget().TriggerSelection();
+    }
+    _searchBuffer = nullptr;
+}
+
+// Method Description:
+// - Tells the search thread to stop and waits for it to finish. The matches it found so far stay.
+void Terminal::_CancelSearch() noexcept
+{
+    _searchCanceled.store(true);
+    if (_searchThread.joinable())
+    {
+        _searchThread.join();
+    }
+}
+
+// Method Description:
+// - Body of the search thread. Walks the buffer a batch of rows at a time, only holding the lock
+//   while it reads a batch and while it adds what it found to the highlights. Rows are read in
+//   place, packed or not, so reading only takes the read lock.
+// - Rows are counted from the first one the buffer ever had, so the search carries on from the
+//   same row when output has circled the buffer in between batches. Rows that circled off the
+//   top before the search got to them are skipped.
+// - Each batch is matched without the lock, spread over the thread pool.
+// - Rows that are only in the archive are paged into a buffer of the search's own, one at a
+//   time, so that they're laid out just like the rows of the buffer.
+// Arguments:
+// - needle: the text to look for, already lowercase if the search isn't case sensitive
+// - caseSensitive: true if the case of letters has to match too
+// - pfnMatchesFound: optional callback for each batch of matches
+void Terminal::_SearchBuffer(const std::wstring needle,
+                             const bool caseSensitive,
+                             const std::function<void(const std::vector<SMALL_RECT>&)> pfnMatchesFound)
+{
+    SearchBatch batch;
+    batch.needle = needle;
+    batch.canceled = &_searchCanceled;
+    batch.rows.resize(SearchBatchRows);
+
+    // Without the thread pool, this thread matches every row by itself.
+    wil::unique_threadpool_work work{ CreateThreadpoolWork(s_MatchSearchRowsCallback, &batch, nullptr) };
+    LOG_LAST_ERROR_IF(!work);
+
+    std::vector<SearchMatch> found;
+    std::vector<SMALL_RECT> foundRects;
+
+    // Lays a row out as text in the next row of the batch, remembering which columns each code unit comes from.
+    const auto layOutRow = [&](const ROW& row, const uint64_t number) {
+        auto& searchRow = batch.rows.at(batch.used++);
+        searchRow.row = number;
+        searchRow.text.clear();
+        searchRow.columns.clear();
+        const auto& charRow = row.GetCharRow();
+        for (size_t column = 0; column < charRow.size(); column++)
+        {
+            const auto dbcsAttr = charRow.DbcsAttrAt(column);
+            if (!dbcsAttr.IsTrailing())
+            {
+                const auto left = gsl::narrow_cast<SHORT>(column);
+                const auto right = gsl::narrow_cast<SHORT>(dbcsAttr.IsLeading() ? column + 1 : column);
+                for (const auto wch : charRow.GlyphAt(column))
+                {
+                    searchRow.text.push_back(caseSensitive ? wch : ::towlower(wch));
+                    searchRow.columns.emplace_back(left, right);
+                }
+            }
+        }
+    };
+
+    // Matches the rows of the batch and gathers what they found. Returns false if the search was canceled.
+    const auto matchBatch = [&]() {
+        batch.next = 0;
+        if (work)
+        {
+            for (size_t i = 0; i < SearchMatchHelpers; i++)
+            {
+                SubmitThreadpoolWork(work.get());
+            }
+        }
+        s_MatchSearchRows(batch);
+        if (work)
+        {
+            WaitForThreadpoolWorkCallbacks(work.get(), FALSE);
+        }
+
+        // A canceled batch may have rows that weren't matched.
+        if (_searchCanceled.load())
+        {
+            return false;
+        }
+
+        found.clear();
+        for (size_t i = 0; i < batch.used; i++)
+        {
+            const auto& rowFound = batch.rows.at(i).found;
+            found.insert(found.end(), rowFound.cbegin(), rowFound.cend());
+        }
+        return true;
+    };
+
+    // The rows that are only in the archive come first. Their numbers are their indices in the archive.
+    size_t archived = 0;
+    size_t nextArchived = 0;
+    size_t archivedEnd = 0;
+    std::unique_ptr<TextBuffer> pageInBuffer;
+    {
+        auto lock = LockForReading();
+        if (_buffer.get() != _searchBuffer)
+        {
+            return;
+        }
+
+        archived = std::as_const(*_buffer).GetArchivedRowCount();
+        nextArchived = archived > SHRT_MAX ? archived - SHRT_MAX : 0;
+        archivedEnd = archived;
+        if (nextArchived < archivedEnd)
+        {
+            try
+            {
+                pageInBuffer = std::make_unique<TextBuffer>(COORD{ _buffer->GetSize().Width(), 1 },
+                                                            TextAttribute{},
+                                                            0,
+                                                            _buffer->GetRenderTarget());
+            }
+            catch (...)
+            {
+                // The rows of the buffer can still be searched.
+                LOG_CAUGHT_EXCEPTION();
+                archivedEnd = nextArchived;
+            }
+        }
+    }
+
+    while (nextArchived < archivedEnd && !_searchCanceled.load())
+    {
+        {
+            auto lock = LockForReading();
+            if (_buffer.get() != _searchBuffer)
+            {
+                return;
+            }
+
+            // The archive is let go of if a row can't be written to it.
+            const auto& archive = std::as_const(*_buffer).GetScrollbackArchive();
+            if (!archive)
+            {
+                break;
+            }
+
+            batch.used = 0;
+            const auto end = std::min<size_t>(archivedEnd, nextArchived + SearchBatchRows);
+            for (; nextArchived < end; nextArchived++)
+            {
+                auto& row = pageInBuffer->GetRowByOffset(0);
+                try
+                {
+                    row.Reset(pageInBuffer->GetCurrentAttributes());
+                    archive->PageIn(nextArchived, row);
+                }
+                catch (...)
+                {
+                    // A damaged archive ends the search of it, but not of the buffer.
+                    LOG_CAUGHT_EXCEPTION();
+                    archivedEnd = nextArchived;
+                    break;
+                }
+                layOutRow(std::as_const(row), nextArchived);
+            }
+        }
+
+        if (!matchBatch())
+        {
+            return;
+        }
+
+        foundRects.clear();
+        for (const auto& match : found)
+        {
+            const auto y = gsl::narrow_cast<SHORT>(static_cast<ptrdiff_t>(match.row) - static_cast<ptrdiff_t>(archived));
+            foundRects.push_back({ match.left, y, match.right, y });
+        }
+
+        if (!foundRects.empty() && pfnMatchesFound)
+        {
+            pfnMatchesFound(foundRects);
+        }
+    }
+    pageInBuffer.reset();
+
+    for (uint64_t nextRow = 0; !_searchCanceled.load();)
+    {
+        {
+            auto lock = LockForReading();
+
+            // A resize makes a new buffer. What we'd find in it wouldn't line up with what we already found.
+            if (_buffer.get() != _searchBuffer)
+            {
+                return;
+            }
+
+            const auto& buffer = std::as_const(*_buffer);
+            const auto circled = buffer.GetCircledRowCount();
+            const auto height = buffer.GetSize().Height();
+            const auto top = gsl::narrow_cast<SHORT>(nextRow > circled ? nextRow - circled : 0);
+            if (top >= height)
+            {
+                return;
+            }
+
+            const SHORT bottom = gsl::narrow_cast<SHORT>(std::min<int>(top + SearchBatchRows, height));
+            batch.used = 0;
+            for (SHORT y = top; y < bottom; y++)
+            {
+                layOutRow(buffer.GetRowByOffset(y), circled + y);
+            }
+            nextRow = circled + bottom;
+        }
+
+        if (!matchBatch())
+        {
+            return;
+        }
+
+        foundRects.clear();
+        if (!found.empty())
+        {
+            auto lock = LockForWriting();
+            if (_buffer.get() != _searchBuffer)
+            {
+                return;
+            }
+
+            // Matches on rows that have circled off the top since can't be shown anymore.
+            const auto circled = _buffer->GetCircledRowCount();
+            const auto kept = std::lower_bound(_searchMatches.begin(), _searchMatches.end(), circled, [](const SearchMatch& match, const uint64_t row) {
+                return match.row < row;
+            });
+            _searchMatches.erase(_searchMatches.begin(), kept);
+            _searchMatches.insert(_searchMatches.end(), found.cbegin(), found.cend());
+            _buffer->GetRenderTarget().TriggerSelection();
+
+            for (const auto& match : found)
+            {
+                if (match.row >= circled)
+                {
+                    const auto y = gsl::narrow_cast<SHORT>(match.row - circled);
+                    foundRects.push_back({ match.left, y, match.right, y });
+                }
+            }
+        }
+
+        if (!foundRects.empty() && pfnMatchesFound)
+        {
+            pfnMatchesFound(foundRects);
+        }
+    }
+}
+
+// Method Description:
+// - Finds the matches in the rows of a search batch, taking the next row in line until there are
+//   none left or the search is canceled. It runs on the search thread and on the thread pool at once.
+// Arguments:
+// - batch: the rows to match. Each one's matches go in its found.
+void Terminal::s_MatchSearchRows(SearchBatch& batch) noexcept
+{
+    const auto needle = batch.needle;
+    for (auto i = batch.next.fetch_add(1); i < batch.used && !batch.canceled->load(); i = batch.next.fetch_add(1))
+    {
+        auto& searchRow = batch.rows.at(i);
+        searchRow.found.clear();
+        try
+        {
+            const std::wstring_view text{ searchRow.text };
+            for (auto pos = text.find(needle); pos != std::wstring_view::npos; pos = text.find(needle, pos + needle.size()))
+            {
+                const auto left = searchRow.columns.at(pos).first;
+                const auto right = searchRow.columns.at(pos + needle.size() - 1).second;
+                searchRow.found.push_back({ searchRow.row, left, right });
+            }
+        }
+        CATCH_LOG();
+    }
+}
+
+void CALLBACK Terminal::s_MatchSearchRowsCallback(PTP_CALLBACK_INSTANCE /*instance*/, PVOID context, PTP_WORK /*work*/) noexcept
+{
+    s_MatchSearchRows(*static_cast<SearchBatch*>(context));
+}
+
+// Method Description:
+// - Gets the search matches that fall within the given rows, for painting.
+// Arguments:
+// - rows: the part of the buffer being painted
+// Return Value:
+// - the matches on those rows, in buffer coordinates
+std::vector<SMALL_RECT> Terminal::_GetSearchMatchRects(const Viewport& rows) const
+{
+    std::vector<SMALL_RECT> result;
+    if (_searchBuffer != _buffer.get())
+    {
+        return result;
+    }
+
+    // The matches were found top to bottom, so only the ones on the painted rows need looking at.
+    const auto circled = _buffer->GetCircledRowCount();
+    const auto top = circled + std::max<SHORT>(rows.Top(), 0);
+    const auto bottom = circled + std::max<SHORT>(rows.BottomExclusive(), 0);
+    auto it = std::lower_bound(_searchMatches.cbegin(), _searchMatches.cend(), top, [](const SearchMatch& match, const uint64_t row) {
+        return match.row < row;
+    });
+    for (; it != _searchMatches.cend() && it->row < bottom; ++it)
+    {
+        const auto y = gsl::narrow_cast<SHORT>(it->row - circled);
+        result.push_back({ it->left, y, it->right, y });
+    }
+    return result;
+}
@@ -8,9 +8,32 @@ using namespace Microsoft::Terminal::Core;
 
 // Method Description:
 // - Helper to determine the selected region of the buffer. Used for rendering.
+// - The rectangles are only worked out again when the selection, the buffer or the
+//   mutable viewport has changed since the last time they were asked for.
 // Return Value:
 // - A vector of rectangles representing the regions to select, line by line. They are absolute coordinates relative to the buffer origin.
 std::vector<SMALL_RECT> Terminal::_GetSelectionRects() const
+{
+    if (!_selectionRectsCache.has_value() ||
+        _selectionRectsCache->selectionGeneration != _selectionGeneration ||
+        _selectionRectsCache->buffer != _buffer.get() ||
+        _selectionRectsCache->bufferGeneration != _buffer->GetGeneration() ||
+        _selectionRectsCache->mutableViewport != _mutableViewport)
+    {
+        _selectionRectsCache.emplace(SelectionRectsCache{ _selectionGeneration,
+                                                          _buffer.get(),
+                                                          _buffer->GetGeneration(),
+                                                          _mutableViewport,
+                                                          _CalculateSelectionRects() });
+    }
+    return _selectionRectsCache->rects;
+}
+
+// Method Description:
+// - Works out the selected region of the buffer from the selection anchors.
+// Return Value:
+// - A vector of rectangles representing the regions to select, line by line. They are absolute coordinates relative to the buffer origin.
+std::vector<SMALL_RECT> Terminal::_CalculateSelectionRects() const
 {
     std::vector<SMALL_RECT> selectionArea;
 
@@ -180,6 +203,7 @@ void Terminal::SetSelectionAnchor(const COORD position)
     _selectionAnchor_YOffset = gsl::narrow<SHORT>(_ViewStartIndex());
 
     _selectionActive = true;
+    ++_selectionGeneration;
     SetEndSelectionPosition(position);
 }
 
@@ -197,6 +221,7 @@ void Terminal::SetEndSelectionPosition(const COORD position)
     // copy value of ViewStartIndex to support scrolling
     // and update on new buffer output (used in _GetSelectionRects())
     _endSelectionPosition_YOffset = gsl::narrow<SHORT>(_ViewStartIndex());
+    ++_selectionGeneration;
 }
 
 // Method Description:
@@ -206,6 +231,7 @@ void Terminal::SetEndSelectionPosition(const COORD position)
 void Terminal::SetBoxSelection(const bool isEnabled) noexcept
 {
     _boxSelection = isEnabled;
+    ++_selectionGeneration;
 }
 
 // Method Description:
@@ -217,6 +243,7 @@ void Terminal::ClearSelection() noexcept
     _endSelectionPosition = { 0, 0 };
     _selectionAnchor_YOffset = 0;
     _endSelectionPosition_YOffset = 0;
+    ++_selectionGeneration;
 
     _buffer->GetRenderTarget().TriggerSelection();
 }
@@ -230,22 +257,33 @@ void Terminal::ClearSelection() noexcept
 // - wstring text from buffer. If extended to multiple lines, each line is separated by \r\n
 const std::wstring Terminal::RetrieveSelectedTextFromBuffer(bool trimTrailingWhitespace) const
 {
-    std::function<COLORREF(TextAttribute&)> GetForegroundColor = std::bind(&Terminal::GetForegroundColor, this, std::placeholders::_1);
-    std::function<COLORREF(TextAttribute&)> GetBackgroundColor = std::bind(&Terminal::GetBackgroundColor, this, std::placeholders::_1);
+    // Only the text is wanted here, so the colors of the runs are never looked up.
+    class PlainTextSink final : public TextBuffer::ITextRunSink
+    {
+    public:
+        void OnTextRun(const std::wstring_view text, const TextAttribute& /*attr*/) override
+        {
+            result.append(text);
+        }
+
+        void OnRowEnd(const bool lineBreak) override
+        {
+            if (lineBreak)
+            {
+                result.append(L"\r\n");
+            }
+        }
 
-    auto data = _buffer->GetTextForClipboard(!_boxSelection,
-                                             trimTrailingWhitespace,
-                                             _GetSelectionRects(),
-                                             GetForegroundColor,
-                                             GetBackgroundColor);
+        std::wstring result;
+    };
 
-    std::wstring result;
-    for (const auto& text : data.text)
-    {
-        result += text;
-    }
+    PlainTextSink sink;
+    _buffer->ForEachSelectedTextRun(!_boxSelection,
+                                    trimTrailingWhitespace,
+                                    _GetSelectionRects(),
+                                    sink);
 
-    return result;
+    return sink.result;
 }
 
 // Method Description:
@@ -262,25 +300,16 @@ void Terminal::_ExpandDoubleClickSelectionLeft(const COORD position)
         return;
     }
 
+    // the word starts where the row's run of non-delimiters around the position does
     COORD positionWithOffsets = _ConvertToBufferCell(position);
-    const auto bufferViewport = _buffer->GetSize();
-    auto cellChar = _buffer->GetCellDataAt(positionWithOffsets)->Chars();
-    while (positionWithOffsets.X != 0 && !_isWordDelimiter(cellChar))
-    {
-        bufferViewport.DecrementInBounds(positionWithOffsets);
-        cellChar = _buffer->GetCellDataAt(positionWithOffsets)->Chars();
-    }
-
-    if (positionWithOffsets.X != 0 || _isWordDelimiter(cellChar))
-    {
-        // move off of delimiter to highlight properly
-        bufferViewport.IncrementInBounds(positionWithOffsets);
-    }
+    const auto& charRow = std::as_const(*_buffer).GetRowByOffset(positionWithOffsets.Y).GetCharRow();
+    positionWithOffsets.X = gsl::narrow<SHORT>(charRow.GetWordRunAt(positionWithOffsets.X, _wordDelimiters).begin);
 
     THROW_IF_FAILED(ShortSub(positionWithOffsets.Y, gsl::narrow<SHORT>(_ViewStartIndex()), &positionWithOffsets.Y));
     _selectionAnchor = positionWithOffsets;
     _selectionAnchor_YOffset = gsl::narrow<SHORT>(_ViewStartIndex());
     _selectionActive = true;
+    ++_selectionGeneration;
 }
 
 // Method Description:
@@ -297,24 +326,15 @@ void Terminal::_ExpandDoubleClickSelectionRight(const COORD position)
         return;
     }
 
+    // the word ends where the row's run of non-delimiters around the position does
     COORD positionWithOffsets = _ConvertToBufferCell(position);
-    const auto bufferViewport = _buffer->GetSize();
-    auto cellChar = _buffer->GetCellDataAt(positionWithOffsets)->Chars();
-    while (positionWithOffsets.X != _buffer->GetSize().RightInclusive() && !_isWordDelimiter(cellChar))
-    {
-        bufferViewport.IncrementInBounds(positionWithOffsets);
-        cellChar = _buffer->GetCellDataAt(positionWithOffsets)->Chars();
-    }
-
-    if (positionWithOffsets.X != bufferViewport.RightInclusive() || _isWordDelimiter(cellChar))
-    {
-        // move off of delimiter to highlight properly
-        bufferViewport.DecrementInBounds(positionWithOffsets);
-    }
+    const auto& charRow = std::as_const(*_buffer).GetRowByOffset(positionWithOffsets.Y).GetCharRow();
+    positionWithOffsets.X = gsl::narrow<SHORT>(charRow.GetWordRunAt(positionWithOffsets.X, _wordDelimiters).end - 1);
 
     THROW_IF_FAILED(ShortSub(positionWithOffsets.Y, gsl::narrow<SHORT>(_ViewStartIndex()), &positionWithOffsets.Y));
     _endSelectionPosition = positionWithOffsets;
     _endSelectionPosition_YOffset = gsl::narrow<SHORT>(_ViewStartIndex());
+    ++_selectionGeneration;
 }
 
 // Method Description:
@@ -4,6 +4,8 @@
 #include "pch.h"
 #include "Terminal.hpp"
 #include <DefaultSettings.h>
+
+#include <intrin.h>
 using namespace Microsoft::Terminal::Core;
 using namespace Microsoft::Console::Types;
 using namespace Microsoft::Console::Render;
@@ -114,6 +116,12 @@ std::vector<Microsoft::Console::Types::Viewport> Terminal::GetSelectionRects() n
         result.emplace_back(Viewport::FromInclusive(lineRect));
     }
 
+    // Search matches on the screen are highlighted the same way.
+    for (const auto& matchRect : _GetSearchMatchRects(_GetVisibleViewport()))
+    {
+        result.emplace_back(Viewport::FromInclusive(matchRect));
+    }
+
     return result;
 }
 
@@ -130,7 +138,7 @@ const std::wstring Terminal::GetConsoleTitle() const noexcept
 //      they're done with any querying they need to do.
 void Terminal::LockConsole() noexcept
 {
-    _readWriteLock.lock_shared();
+    _readWriteLock.lock_shared(_ReturnAddress());
 }
 
 // Method Description:
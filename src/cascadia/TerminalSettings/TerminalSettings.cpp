@@ -21,6 +21,8 @@ namespace winrt::Microsoft::Terminal::Settings::implementation
         _cursorShape{ CursorStyle::Vintage },
         _cursorHeight{ DEFAULT_CURSOR_HEIGHT },
         _wordDelimiters{ DEFAULT_WORD_DELIMITERS },
+        _scrollbackMemoryBudget{ 0 },
+        _scrollbackArchivePath{},
         _useAcrylic{ false },
         _closeOnExit{ true },
         _tintOpacity{ 0.5 },
@@ -35,6 +37,44 @@ namespace winrt::Microsoft::Terminal::Settings::implementation
     {
     }
 
+    // Method Description:
+    // - Makes a copy of these settings. Settings are shared between everything
+    //   made from the same profile, so whoever wants to change theirs changes a copy.
+    // Return Value:
+    // - a new TerminalSettings with the same values as this one
+    Settings::TerminalSettings TerminalSettings::Clone()
+    {
+        auto clone = winrt::make_self<TerminalSettings>();
+        clone->_defaultForeground = _defaultForeground;
+        clone->_defaultBackground = _defaultBackground;
+        clone->_colorTable = _colorTable;
+        clone->_historySize = _historySize;
+        clone->_initialRows = _initialRows;
+        clone->_initialCols = _initialCols;
+        clone->_snapOnInput = _snapOnInput;
+        clone->_cursorColor = _cursorColor;
+        clone->_cursorShape = _cursorShape;
+        clone->_cursorHeight = _cursorHeight;
+        clone->_wordDelimiters = _wordDelimiters;
+        clone->_scrollbackMemoryBudget = _scrollbackMemoryBudget;
+        clone->_scrollbackArchivePath = _scrollbackArchivePath;
+        clone->_useAcrylic = _useAcrylic;
+        clone->_closeOnExit = _closeOnExit;
+        clone->_tintOpacity = _tintOpacity;
+        clone->_fontFace = _fontFace;
+        clone->_fontSize = _fontSize;
+        clone->_padding = _padding;
+        clone->_backgroundImage = _backgroundImage;
+        clone->_backgroundImageOpacity = _backgroundImageOpacity;
+        clone->_backgroundImageStretchMode = _backgroundImageStretchMode;
+        clone->_commandline = _commandline;
+        clone->_startingDir = _startingDir;
+        clone->_envVars = _envVars;
+        clone->_keyBindings = _keyBindings;
+        clone->_scrollbarState = _scrollbarState;
+        return *clone;
+    }
+
     uint32_t TerminalSettings::DefaultForeground()
     {
         return _defaultForeground;
@@ -146,6 +186,26 @@ namespace winrt::Microsoft::Terminal::Settings::implementation
         _wordDelimiters = value;
     }
 
+    uint32_t TerminalSettings::ScrollbackMemoryBudget()
+    {
+        return _scrollbackMemoryBudget;
+    }
+
+    void TerminalSettings::ScrollbackMemoryBudget(uint32_t value)
+    {
+        _scrollbackMemoryBudget = value;
+    }
+
+    hstring TerminalSettings::ScrollbackArchivePath()
+    {
+        return _scrollbackArchivePath;
+    }
+
+    void TerminalSettings::ScrollbackArchivePath(hstring const& value)
+    {
+        _scrollbackArchivePath = value;
+    }
+
     bool TerminalSettings::UseAcrylic()
     {
         return _useAcrylic;
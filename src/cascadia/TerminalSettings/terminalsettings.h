@@ -23,6 +23,8 @@ namespace winrt::Microsoft::Terminal::Settings::implementation
     {
         TerminalSettings();
 
+        Settings::TerminalSettings Clone();
+
         // --------------------------- Core Settings ---------------------------
         //  All of these settings are defined in ICoreSettings.
         uint32_t DefaultForeground();
@@ -47,6 +49,10 @@ namespace winrt::Microsoft::Terminal::Settings::implementation
         void CursorHeight(uint32_t value);
         hstring WordDelimiters();
         void WordDelimiters(hstring const& value);
+        uint32_t ScrollbackMemoryBudget();
+        void ScrollbackMemoryBudget(uint32_t value);
+        hstring ScrollbackArchivePath();
+        void ScrollbackArchivePath(hstring const& value);
         // ------------------------ End of Core Settings -----------------------
 
         bool UseAcrylic();
@@ -97,6 +103,8 @@ namespace winrt::Microsoft::Terminal::Settings::implementation
         Settings::CursorStyle _cursorShape;
         uint32_t _cursorHeight;
         hstring _wordDelimiters;
+        uint32_t _scrollbackMemoryBudget;
+        hstring _scrollbackArchivePath;
 
         bool _useAcrylic;
         bool _closeOnExit;
@@ -37,6 +37,8 @@ namespace TerminalCoreUnitTests
         CursorStyle CursorShape() const noexcept { return CursorStyle::Vintage; }
         uint32_t CursorHeight() { return 42UL; }
         winrt::hstring WordDelimiters() { return winrt::to_hstring(DEFAULT_WORD_DELIMITERS.c_str()); }
+        uint32_t ScrollbackMemoryBudget() { return 0; }
+        winrt::hstring ScrollbackArchivePath() { return {}; }
 
         // other implemented methods
         uint32_t GetColorTableEntry(int32_t) const { return 123; }
@@ -52,6 +54,8 @@ namespace TerminalCoreUnitTests
         void CursorShape(CursorStyle const&) noexcept {}
         void CursorHeight(uint32_t) {}
         void WordDelimiters(winrt::hstring) {}
+        void ScrollbackMemoryBudget(uint32_t) {}
+        void ScrollbackArchivePath(winrt::hstring) {}
 
         // other unimplemented methods
         void SetColorTableEntry(int32_t /* index */, uint32_t /* value */) {}
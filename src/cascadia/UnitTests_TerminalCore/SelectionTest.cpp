@@ -93,6 +93,41 @@ namespace TerminalCoreUnitTests
             }
         }
 
+        TEST_METHOD(SelectAreaAfterMovingEnd)
+        {
+            Terminal term;
+            DummyRenderTarget emptyRT;
+            term.Create({ 100, 100 }, 0, emptyRT);
+
+            // Simulate click at (x,y) = (5,10) and a drag to (15,10)
+            term.SetSelectionAnchor({ 5, 10 });
+            term.SetEndSelectionPosition({ 15, 10 });
+
+            // Simulate renderer calling TriggerSelection and acquiring selection area
+            auto selectionRects = term.GetSelectionRects();
+            VERIFY_ARE_EQUAL(selectionRects.size(), static_cast<size_t>(1));
+            auto selection = term.GetViewport().ConvertToOrigin(selectionRects.at(0)).ToInclusive();
+            VERIFY_ARE_EQUAL(selection, SMALL_RECT({ 5, 10, 15, 10 }));
+
+            // Asking again without changing anything gives the same area
+            selectionRects = term.GetSelectionRects();
+            VERIFY_ARE_EQUAL(selectionRects.size(), static_cast<size_t>(1));
+            selection = term.GetViewport().ConvertToOrigin(selectionRects.at(0)).ToInclusive();
+            VERIFY_ARE_EQUAL(selection, SMALL_RECT({ 5, 10, 15, 10 }));
+
+            // Simulate the drag carrying on to (20,12)
+            term.SetEndSelectionPosition({ 20, 12 });
+
+            selectionRects = term.GetSelectionRects();
+            VERIFY_ARE_EQUAL(selectionRects.size(), static_cast<size_t>(3));
+            selection = term.GetViewport().ConvertToOrigin(selectionRects.at(2)).ToInclusive();
+            VERIFY_ARE_EQUAL(selection, SMALL_RECT({ 0, 12, 20, 12 }));
+
+            // Clearing the selection leaves nothing selected
+            term.ClearSelection();
+            VERIFY_ARE_EQUAL(term.GetSelectionRects().size(), static_cast<size_t>(0));
+        }
+
         TEST_METHOD(SelectBoxArea)
         {
             Terminal term;
@@ -0,0 +1,199 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include <WexTestClass.h>
+
+#include "../cascadia/TerminalCore/Terminal.hpp"
+#include "../renderer/inc/DummyRenderTarget.hpp"
+#include "consoletaeftemplates.hpp"
+
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+using namespace Microsoft::Terminal::Core;
+using namespace Microsoft::Console::Render;
+
+namespace TerminalCoreUnitTests
+{
+    class TerminalApiTest
+    {
+        TEST_CLASS(TerminalApiTest);
+
+        TEST_METHOD(DeleteLineWithinMargins);
+        TEST_METHOD(LinefeedAtBottomMarginScrollsMargins);
+        TEST_METHOD(EraseInLineAndDisplay);
+        TEST_METHOD(PrintingWrapsAtRightEdge);
+        TEST_METHOD(PrintingWrapsWithinMargins);
+        TEST_METHOD(PrintingPastBottomCirclesBuffer);
+        TEST_METHOD(ScrollToPromptFollowsShellMarks);
+
+        // Fills each line of a 10x10 terminal with its own letter, A through J.
+        void _FillLines(Terminal& term)
+        {
+            term.Write(L"A\r\nB\r\nC\r\nD\r\nE\r\nF\r\nG\r\nH\r\nI\r\nJ");
+        }
+
+        wchar_t _FirstCharOfRow(Terminal& term, const size_t row)
+        {
+            return term.GetTextBuffer().GetRowByOffset(row).GetText().front();
+        }
+    };
+
+    void TerminalApiTest::DeleteLineWithinMargins()
+    {
+        Terminal term;
+        DummyRenderTarget emptyRT;
+        term.Create({ 10, 10 }, 0, emptyRT);
+        _FillLines(term);
+
+        // Set the margins to lines 3 through 6, then delete line 3.
+        term.Write(L"\x1b[3;6r\x1b[3;1H\x1b[M");
+
+        VERIFY_ARE_EQUAL(L'B', _FirstCharOfRow(term, 1));
+        VERIFY_ARE_EQUAL(L'D', _FirstCharOfRow(term, 2));
+        VERIFY_ARE_EQUAL(L'E', _FirstCharOfRow(term, 3));
+        VERIFY_ARE_EQUAL(L'F', _FirstCharOfRow(term, 4));
+        VERIFY_ARE_EQUAL(L' ', _FirstCharOfRow(term, 5), L"The line at the bottom margin is blanked.");
+        VERIFY_ARE_EQUAL(L'G', _FirstCharOfRow(term, 6), L"Lines below the bottom margin don't move.");
+
+        // Inserting the line back pushes the others back down.
+        term.Write(L"\x1b[L");
+        VERIFY_ARE_EQUAL(L' ', _FirstCharOfRow(term, 2));
+        VERIFY_ARE_EQUAL(L'D', _FirstCharOfRow(term, 3));
+        VERIFY_ARE_EQUAL(L'F', _FirstCharOfRow(term, 5));
+        VERIFY_ARE_EQUAL(L'G', _FirstCharOfRow(term, 6));
+    }
+
+    void TerminalApiTest::LinefeedAtBottomMarginScrollsMargins()
+    {
+        Terminal term;
+        DummyRenderTarget emptyRT;
+        term.Create({ 10, 10 }, 0, emptyRT);
+        _FillLines(term);
+
+        // With the cursor on the bottom margin, a linefeed scrolls the lines within the margins.
+        term.Write(L"\x1b[3;6r\x1b[6;1H\n");
+
+        VERIFY_ARE_EQUAL(COORD({ 0, 5 }), term.GetCursorPosition());
+        VERIFY_ARE_EQUAL(L'A', _FirstCharOfRow(term, 0));
+        VERIFY_ARE_EQUAL(L'D', _FirstCharOfRow(term, 2));
+        VERIFY_ARE_EQUAL(L' ', _FirstCharOfRow(term, 5));
+        VERIFY_ARE_EQUAL(L'G', _FirstCharOfRow(term, 6));
+
+        // A reverse linefeed at the top margin scrolls them back down.
+        term.Write(L"\x1b[3;1H\x1bM");
+
+        VERIFY_ARE_EQUAL(COORD({ 0, 2 }), term.GetCursorPosition());
+        VERIFY_ARE_EQUAL(L' ', _FirstCharOfRow(term, 2));
+        VERIFY_ARE_EQUAL(L'D', _FirstCharOfRow(term, 3));
+        VERIFY_ARE_EQUAL(L'F', _FirstCharOfRow(term, 5));
+        VERIFY_ARE_EQUAL(L'G', _FirstCharOfRow(term, 6));
+    }
+
+    void TerminalApiTest::EraseInLineAndDisplay()
+    {
+        Terminal term;
+        DummyRenderTarget emptyRT;
+        term.Create({ 10, 10 }, 0, emptyRT);
+        term.Write(L"ABCDEFGHI\r\nABCDEFGHI\r\nABCDEFGHI");
+
+        // Erase the second line from its 4th column on.
+        term.Write(L"\x1b[2;4H\x1b[K");
+        VERIFY_ARE_EQUAL(std::wstring(L"ABC       "), term.GetTextBuffer().GetRowByOffset(1).GetText());
+        VERIFY_ARE_EQUAL(std::wstring(L"ABCDEFGHI "), term.GetTextBuffer().GetRowByOffset(0).GetText());
+
+        // Erase the display up to and including the cursor.
+        term.Write(L"\x1b[1J");
+        VERIFY_ARE_EQUAL(std::wstring(L"          "), term.GetTextBuffer().GetRowByOffset(0).GetText());
+        VERIFY_ARE_EQUAL(std::wstring(L"          "), term.GetTextBuffer().GetRowByOffset(1).GetText());
+        VERIFY_ARE_EQUAL(std::wstring(L"ABCDEFGHI "), term.GetTextBuffer().GetRowByOffset(2).GetText());
+    }
+
+    void TerminalApiTest::PrintingWrapsAtRightEdge()
+    {
+        Terminal term;
+        DummyRenderTarget emptyRT;
+        term.Create({ 10, 10 }, 0, emptyRT);
+        term.Write(L"ABCDEFGHIJKLMNOPQRSTUVWXY");
+
+        const auto& buffer = term.GetTextBuffer();
+        VERIFY_ARE_EQUAL(std::wstring(L"ABCDEFGHIJ"), buffer.GetRowByOffset(0).GetText());
+        VERIFY_IS_TRUE(buffer.GetRowByOffset(0).GetCharRow().WasWrapForced());
+        VERIFY_ARE_EQUAL(std::wstring(L"KLMNOPQRST"), buffer.GetRowByOffset(1).GetText());
+        VERIFY_ARE_EQUAL(std::wstring(L"UVWXY     "), buffer.GetRowByOffset(2).GetText());
+        VERIFY_ARE_EQUAL(COORD({ 5, 2 }), buffer.GetCursor().GetPosition());
+
+        // A run that ends at the right edge leaves the cursor there, and the next one
+        // starts on the line below.
+        term.Write(L"\r\n0123456789");
+        VERIFY_ARE_EQUAL(COORD({ 10, 3 }), buffer.GetCursor().GetPosition());
+        term.Write(L"Z");
+        VERIFY_ARE_EQUAL(std::wstring(L"Z         "), buffer.GetRowByOffset(4).GetText());
+        VERIFY_ARE_EQUAL(COORD({ 1, 4 }), buffer.GetCursor().GetPosition());
+    }
+
+    void TerminalApiTest::PrintingWrapsWithinMargins()
+    {
+        Terminal term;
+        DummyRenderTarget emptyRT;
+        term.Create({ 10, 10 }, 0, emptyRT);
+        _FillLines(term);
+
+        // A full row written on the bottom margin wraps by scrolling the lines within the margins.
+        term.Write(L"\x1b[3;6r\x1b[6;1H0123456789XY");
+
+        const auto& buffer = term.GetTextBuffer();
+        VERIFY_ARE_EQUAL(COORD({ 2, 5 }), buffer.GetCursor().GetPosition());
+        VERIFY_ARE_EQUAL(L'B', _FirstCharOfRow(term, 1), L"Lines above the top margin don't move.");
+        VERIFY_ARE_EQUAL(L'D', _FirstCharOfRow(term, 2));
+        VERIFY_ARE_EQUAL(L'E', _FirstCharOfRow(term, 3));
+        VERIFY_ARE_EQUAL(std::wstring(L"0123456789"), buffer.GetRowByOffset(4).GetText());
+        VERIFY_ARE_EQUAL(std::wstring(L"XY        "), buffer.GetRowByOffset(5).GetText());
+        VERIFY_ARE_EQUAL(L'G', _FirstCharOfRow(term, 6), L"Lines below the bottom margin don't move.");
+
+        // A run that ends at the right edge of the bottom margin wraps the same way
+        // when the next one starts.
+        term.Write(L"\rabcdefghij");
+        VERIFY_ARE_EQUAL(COORD({ 10, 5 }), buffer.GetCursor().GetPosition());
+        term.Write(L"Z");
+        VERIFY_ARE_EQUAL(COORD({ 1, 5 }), buffer.GetCursor().GetPosition());
+        VERIFY_ARE_EQUAL(L'E', _FirstCharOfRow(term, 2));
+        VERIFY_ARE_EQUAL(std::wstring(L"abcdefghij"), buffer.GetRowByOffset(4).GetText());
+        VERIFY_ARE_EQUAL(std::wstring(L"Z         "), buffer.GetRowByOffset(5).GetText());
+        VERIFY_ARE_EQUAL(L'G', _FirstCharOfRow(term, 6));
+    }
+
+    void TerminalApiTest::PrintingPastBottomCirclesBuffer()
+    {
+        Terminal term;
+        DummyRenderTarget emptyRT;
+        term.Create({ 10, 3 }, 0, emptyRT);
+        term.Write(L"0123456789ABCDEFGHIJabcdefghijXY");
+
+        const auto& buffer = term.GetTextBuffer();
+        VERIFY_ARE_EQUAL(std::wstring(L"ABCDEFGHIJ"), buffer.GetRowByOffset(0).GetText());
+        VERIFY_ARE_EQUAL(std::wstring(L"abcdefghij"), buffer.GetRowByOffset(1).GetText());
+        VERIFY_ARE_EQUAL(std::wstring(L"XY        "), buffer.GetRowByOffset(2).GetText());
+        VERIFY_ARE_EQUAL(COORD({ 2, 2 }), buffer.GetCursor().GetPosition());
+    }
+
+    void TerminalApiTest::ScrollToPromptFollowsShellMarks()
+    {
+        Terminal term;
+        DummyRenderTarget emptyRT;
+        term.Create({ 10, 3 }, 5, emptyRT);
+        term.Write(L"\x1b]133;A\x07$ one\r\nout\r\n\x1b]133;A\x07$ two\r\na\r\nb\r\nc\r\nd\r\ne");
+        VERIFY_ARE_EQUAL(5, term.GetScrollOffset());
+
+        VERIFY_IS_TRUE(term.ScrollToPrompt(true));
+        VERIFY_ARE_EQUAL(2, term.GetScrollOffset());
+        VERIFY_IS_TRUE(term.ScrollToPrompt(true));
+        VERIFY_ARE_EQUAL(0, term.GetScrollOffset());
+        VERIFY_IS_FALSE(term.ScrollToPrompt(true), L"There's no prompt above the first one.");
+
+        VERIFY_IS_TRUE(term.ScrollToPrompt(false));
+        VERIFY_ARE_EQUAL(2, term.GetScrollOffset());
+        VERIFY_IS_FALSE(term.ScrollToPrompt(false), L"There's no prompt below the last one.");
+    }
+}
@@ -18,6 +18,8 @@ const std::wstring_view ConsoleArguments::FILEPATH_LEADER_PREFIX = L"\\??\\";
 const std::wstring_view ConsoleArguments::WIDTH_ARG = L"--width";
 const std::wstring_view ConsoleArguments::HEIGHT_ARG = L"--height";
 const std::wstring_view ConsoleArguments::INHERIT_CURSOR_ARG = L"--inheritcursor";
+const std::wstring_view ConsoleArguments::PASSTHROUGH_ARG = L"--passthrough";
+const std::wstring_view ConsoleArguments::RENDER_ON_DEMAND_ARG = L"--renderondemand";
 const std::wstring_view ConsoleArguments::FEATURE_ARG = L"--feature";
 const std::wstring_view ConsoleArguments::FEATURE_PTY_ARG = L"pty";
 
@@ -114,6 +116,8 @@ ConsoleArguments::ConsoleArguments(const std::wstring& commandline,
     _width = 0;
     _height = 0;
     _inheritCursor = false;
+    _passthrough = false;
+    _renderOnDemand = false;
 }
 
 ConsoleArguments::ConsoleArguments() :
@@ -138,6 +142,8 @@ ConsoleArguments& ConsoleArguments::operator=(const ConsoleArguments& other)
         _width = other._width;
         _height = other._height;
         _inheritCursor = other._inheritCursor;
+        _passthrough = other._passthrough;
+        _renderOnDemand = other._renderOnDemand;
         _recievedEarlySizeChange = other._recievedEarlySizeChange;
     }
 
@@ -479,6 +485,18 @@ void ConsoleArguments::s_ConsumeArg(_Inout_ std::vector<std::wstring>& args, _In
             s_ConsumeArg(args, i);
             hr = S_OK;
         }
+        else if (arg == PASSTHROUGH_ARG)
+        {
+            _passthrough = true;
+            s_ConsumeArg(args, i);
+            hr = S_OK;
+        }
+        else if (arg == RENDER_ON_DEMAND_ARG)
+        {
+            _renderOnDemand = true;
+            s_ConsumeArg(args, i);
+            hr = S_OK;
+        }
         else if (arg == CLIENT_COMMANDLINE_ARG)
         {
             // Everything after this is the explicit commandline
@@ -612,6 +630,16 @@ bool ConsoleArguments::GetInheritCursor() const
     return _inheritCursor;
 }
 
+bool ConsoleArguments::GetPassthrough() const
+{
+    return _passthrough;
+}
+
+bool ConsoleArguments::GetRenderOnDemand() const
+{
+    return _renderOnDemand;
+}
+
 // Method Description:
 // - Tell us to use a different size than the one parsed as the size of the
 //      console. This is called by the PtySignalInputThread when it receives a
@@ -50,6 +50,8 @@ public:
     short GetWidth() const;
     short GetHeight() const;
     bool GetInheritCursor() const;
+    bool GetPassthrough() const;
+    bool GetRenderOnDemand() const;
 
     void SetExpectedSize(COORD dimensions) noexcept;
 
@@ -64,6 +66,8 @@ public:
     static const std::wstring_view WIDTH_ARG;
     static const std::wstring_view HEIGHT_ARG;
     static const std::wstring_view INHERIT_CURSOR_ARG;
+    static const std::wstring_view PASSTHROUGH_ARG;
+    static const std::wstring_view RENDER_ON_DEMAND_ARG;
     static const std::wstring_view FEATURE_ARG;
     static const std::wstring_view FEATURE_PTY_ARG;
 
@@ -96,6 +100,8 @@ private:
         _serverHandle(serverHandle),
         _signalHandle(signalHandle),
         _inheritCursor(inheritCursor),
+        _passthrough{ false },
+        _renderOnDemand{ false },
         _recievedEarlySizeChange{ false },
         _originalWidth{ -1 },
         _originalHeight{ -1 }
@@ -123,6 +129,8 @@ private:
     DWORD _serverHandle;
     DWORD _signalHandle;
     bool _inheritCursor;
+    bool _passthrough;
+    bool _renderOnDemand;
 
     bool _recievedEarlySizeChange;
     short _originalWidth;
@@ -10,18 +10,15 @@ using namespace Microsoft::Console;
 using namespace Microsoft::Console::Interactivity;
 
 CursorBlinker::CursorBlinker() :
-    _hCaretBlinkTimer(INVALID_HANDLE_VALUE),
-    _hCaretBlinkTimerQueue(THROW_LAST_ERROR_IF_NULL(CreateTimerQueue())),
+    _fCaretBlinkTimerRunning(false),
+    _fMinimized(false),
     _uCaretBlinkTime(INFINITE) // default to no blink
 {
 }
 
 CursorBlinker::~CursorBlinker()
 {
-    if (_hCaretBlinkTimerQueue)
-    {
-        DeleteTimerQueueEx(_hCaretBlinkTimerQueue, INVALID_HANDLE_VALUE);
-    }
+    // The blink timer goes away with the window it belongs to.
 }
 
 void CursorBlinker::UpdateSystemMetrics()
@@ -52,6 +49,33 @@ void CursorBlinker::FocusStart()
     SetCaretTimer();
 }
 
+// Routine Description:
+// - Stops blinking while the window is minimized and picks it back up when the window
+//   is restored, if it still has the focus.
+// Arguments:
+// - isMinimized - Whether the window was just minimized or just shown again.
+// Return Value:
+// - <none>
+void CursorBlinker::MinimizedChanged(const bool isMinimized)
+{
+    if (isMinimized == _fMinimized)
+    {
+        return;
+    }
+
+    _fMinimized = isMinimized;
+
+    const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    if (_fMinimized)
+    {
+        KillCaretTimer();
+    }
+    else if (WI_IsFlagSet(gci.Flags, CONSOLE_HAS_FOCUS))
+    {
+        SetCaretTimer();
+    }
+}
+
 // Routine Description:
 // - This routine is called when the timer in the console with the focus goes off.  It blinks the cursor.
 // Arguments:
@@ -131,55 +155,10 @@ DoScroll:
     Scrolling::s_ScrollIfNecessary(ScreenInfo);
 }
 
-void CALLBACK CursorTimerRoutineWrapper(_In_ PVOID /* lpParam */, _In_ BOOLEAN /* TimerOrWaitFired */)
-{
-    // Suppose the following sequence of events takes place:
-    //
-    // 1. The user resizes the console;
-    // 2. The console acquires the console lock;
-    // 3. The current SCREEN_INFORMATION instance is deleted;
-    // 4. This causes the current Cursor instance to be deleted, too;
-    // 5. The Cursor's destructor is called;
-    // => Somewhere between 1 and 5, the timer fires:
-    //    Timer queue timer callbacks execute asynchronously with respect to
-    //    the UI thread under which the numbered steps are taking place.
-    //    Because the callback touches console state, it needs to acquire the
-    //    console lock. But what if the timer callback fires at just the right
-    //    time such that 2 has already acquired the lock?
-    // 6. The Cursor's destructor deletes the timer queue and thereby destroys
-    //    the timer queue timer used for blinking. However, because this
-    //    timer's callback modifies console state, it is prudent to not
-    //    continue the destruction if the callback has already started but has
-    //    not yet finished. Therefore, the destructor waits for the callback to
-    //    finish executing.
-    // => Meanwhile, the callback just happens to be stuck waiting for the
-    //    console lock acquired in step 2. Since the destructor is waiting on
-    //    the callback to complete, and the callback is waiting on the lock,
-    //    which will only be released way after the Cursor instance is deleted,
-    //    the console has now deadlocked.
-    //
-    // As a solution, skip the blink if the console lock is already being held.
-    // Note that critical sections to not have a waitable synchronization
-    // object unless there readily is contention on it. As a result, if we
-    // wanted to wait until the lock became available under the condition of
-    // not being destroyed, things get too complicated.
-    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-
-    if (gci.TryLockConsole() != false)
-    {
-        // Cursor& cursor = gci.GetActiveOutputBuffer().GetTextBuffer().GetCursor();
-        gci.GetCursorBlinker().TimerRoutine(gci.GetActiveOutputBuffer());
-
-        // This was originally just UnlockConsole, not CONSOLE_INFORMATION::UnlockConsole
-        // Is there a reason it would need to be the global version?
-        gci.UnlockConsole();
-    }
-}
-
 // Routine Description:
 // - If guCaretBlinkTime is -1, we don't want to blink the caret. However, we
 //   need to make sure it gets drawn, so we'll set a short timer. When that
-//   goes off, we'll hit CursorTimerRoutine, and it'll do the right thing if
+//   goes off, we'll hit TimerRoutine, and it'll do the right thing if
 //   guCaretBlinkTime is -1.
 void CursorBlinker::SetCaretTimer()
 {
@@ -187,44 +166,26 @@ void CursorBlinker::SetCaretTimer()
 
     KillCaretTimer();
 
-    if (_hCaretBlinkTimer == INVALID_HANDLE_VALUE)
+    // A headless console has no window to blink a cursor in and never gets the focus,
+    // so the timer only ever runs for a real window.
+    IConsoleWindow* const pWindow = ServiceLocator::LocateConsoleWindow();
+    if (pWindow != nullptr && !_fCaretBlinkTimerRunning && !_fMinimized)
     {
-        bool bRet = true;
         DWORD dwEffectivePeriod = _uCaretBlinkTime == -1 ? dwDefTimeout : _uCaretBlinkTime;
 
-        bRet = CreateTimerQueueTimer(&_hCaretBlinkTimer,
-                                     _hCaretBlinkTimerQueue,
-                                     CursorTimerRoutineWrapper,
-                                     this,
-                                     dwEffectivePeriod,
-                                     dwEffectivePeriod,
-                                     0);
+        _fCaretBlinkTimerRunning = !!pWindow->SetCursorBlinkTimer(dwEffectivePeriod);
 
-        LOG_LAST_ERROR_IF(!bRet);
+        LOG_LAST_ERROR_IF(!_fCaretBlinkTimerRunning);
     }
 }
 
 void CursorBlinker::KillCaretTimer()
 {
-    if (_hCaretBlinkTimer != INVALID_HANDLE_VALUE)
+    IConsoleWindow* const pWindow = ServiceLocator::LocateConsoleWindow();
+    if (pWindow != nullptr && _fCaretBlinkTimerRunning)
     {
-        bool bRet = true;
+        LOG_IF_WIN32_BOOL_FALSE(pWindow->KillCursorBlinkTimer());
 
-        bRet = DeleteTimerQueueTimer(_hCaretBlinkTimerQueue,
-                                     _hCaretBlinkTimer,
-                                     NULL);
-
-        // According to https://msdn.microsoft.com/en-us/library/windows/desktop/ms682569(v=vs.85).aspx
-        // A failure to delete the timer with the LastError being ERROR_IO_PENDING means that the timer is
-        // currently in use and will get cleaned up when released. Delete should not be called again.
-        // We treat that case as a success.
-        if (bRet == false && GetLastError() != ERROR_IO_PENDING)
-        {
-            LOG_LAST_ERROR();
-        }
-        else
-        {
-            _hCaretBlinkTimer = INVALID_HANDLE_VALUE;
-        }
+        _fCaretBlinkTimerRunning = false;
     }
 }
@@ -22,16 +22,17 @@ namespace Microsoft::Console
 
         void FocusStart();
         void FocusEnd();
+        void MinimizedChanged(const bool isMinimized);
 
         void UpdateSystemMetrics();
         void SettingsChanged();
         void TimerRoutine(SCREEN_INFORMATION& ScreenInfo);
 
     private:
-        // These use Timer Queues:
-        // https://msdn.microsoft.com/en-us/library/windows/desktop/ms687003(v=vs.85).aspx
-        HANDLE _hCaretBlinkTimer; // timer used to periodically blink the cursor
-        HANDLE _hCaretBlinkTimerQueue; // timer queue where the blink timer lives
+        // The blink timer belongs to the console window, so it fires on the window's own
+        // thread along with the rest of its messages instead of waking up a pool thread.
+        bool _fCaretBlinkTimerRunning; // whether the window is periodically blinking the cursor
+        bool _fMinimized; // nobody can see the cursor blink while the window is minimized
         UINT _uCaretBlinkTime;
         void SetCaretTimer();
         void KillCaretTimer();
@@ -9,18 +9,14 @@
 #include "handle.h"
 #include "..\interactivity\inc\ServiceLocator.hpp"
 #include "..\terminal\adapter\DispatchCommon.hpp"
+#include "..\types\inc\Viewport.hpp"
 
 #define PTY_SIGNAL_RESIZE_WINDOW 8u
 
-struct PTY_SIGNAL_RESIZE
-{
-    unsigned short sx;
-    unsigned short sy;
-};
-
 using namespace Microsoft::Console;
 using namespace Microsoft::Console::Interactivity;
 using namespace Microsoft::Console::VirtualTerminal;
+using namespace Microsoft::Console::Types;
 
 // Constructor Description:
 // - Creates the PTY Signal Input Thread.
@@ -89,6 +85,12 @@ void PtySignalInputThread::ConnectConsole() noexcept
             PTY_SIGNAL_RESIZE resizeMsg = { 0 };
             _GetData(&resizeMsg, sizeof(resizeMsg));
 
+            // While a terminal is being resized it sends a signal for every step of the drag.
+            // Only the last of the ones that have already arrived is worth resizing to.
+            while (_TryGetQueuedResize(resizeMsg))
+            {
+            }
+
             LockConsole();
             auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
             // If the client app hasn't yet connected, stash the new size in the launchArgs.
@@ -105,7 +107,7 @@ void PtySignalInputThread::ConnectConsole() noexcept
                 }
                 break;
             }
-            else
+            else if (!_IsCurrentSize(resizeMsg))
             {
                 if (DispatchCommon::s_ResizeWindow(*_pConApi, resizeMsg.sx, resizeMsg.sy))
                 {
@@ -124,6 +126,51 @@ void PtySignalInputThread::ConnectConsole() noexcept
     return S_OK;
 }
 
+// Method Description:
+// - If the next signal in the pipe is another resize, and all of it has already arrived,
+//      reads it in place of the one we have. Never waits for more data to arrive.
+// Arguments:
+// - resizeMsg - The resize to replace with the next one.
+// Return Value:
+// - True if a resize was read into resizeMsg. False if the next signal isn't a resize,
+//      or there isn't a whole one in the pipe yet.
+bool PtySignalInputThread::_TryGetQueuedResize(PTY_SIGNAL_RESIZE& resizeMsg)
+{
+    unsigned short next[1 + sizeof(PTY_SIGNAL_RESIZE) / sizeof(unsigned short)];
+    DWORD dwRead = 0;
+    if (!PeekNamedPipe(_hFile.get(), next, sizeof(next), &dwRead, nullptr, nullptr) ||
+        dwRead != sizeof(next) ||
+        next[0] != PTY_SIGNAL_RESIZE_WINDOW)
+    {
+        return false;
+    }
+
+    unsigned short signalId;
+    return _GetData(&signalId, sizeof(signalId)) && _GetData(&resizeMsg, sizeof(resizeMsg));
+}
+
+// Method Description:
+// - Checks whether the active screen buffer's viewport already has the given size, in
+//      which case a resize would only reflow and repaint the same content again.
+// Arguments:
+// - resizeMsg - The size to check for.
+// Return Value:
+// - True if the viewport already has that size.
+bool PtySignalInputThread::_IsCurrentSize(const PTY_SIGNAL_RESIZE& resizeMsg) const
+{
+    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
+    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+    if (!_pConApi->GetConsoleScreenBufferInfoEx(&csbiex))
+    {
+        return false;
+    }
+
+    const auto viewport = Viewport::FromInclusive(csbiex.srWindow);
+    return viewport.Width() == resizeMsg.sx &&
+           viewport.Height() == resizeMsg.sy &&
+           csbiex.dwSize.X == resizeMsg.sx;
+}
+
 // Method Description:
 // - Retrieves bytes from the file stream and exits or throws errors should the pipe state
 //   be compromised.
@@ -15,6 +15,12 @@ Author(s):
 --*/
 #pragma once
 
+struct PTY_SIGNAL_RESIZE
+{
+    unsigned short sx;
+    unsigned short sy;
+};
+
 namespace Microsoft::Console
 {
     class PtySignalInputThread final
@@ -35,6 +41,8 @@ namespace Microsoft::Console
     private:
         [[nodiscard]] HRESULT _InputThread();
         bool _GetData(_Out_writes_bytes_(cbBuffer) void* const pBuffer, const DWORD cbBuffer);
+        bool _TryGetQueuedResize(PTY_SIGNAL_RESIZE& resizeMsg);
+        bool _IsCurrentSize(const PTY_SIGNAL_RESIZE& resizeMsg) const;
         void _Shutdown();
 
         wil::unique_hfile _hFile;
@@ -6,12 +6,194 @@
 #include "../interactivity/inc/ServiceLocator.hpp"
 
 using Microsoft::Console::Interactivity::ServiceLocator;
+using Microsoft::Console::Types::Viewport;
+
+// A row where nothing's been noted yet.
+static constexpr std::pair<SHORT, SHORT> s_unchangedColumns{ SHRT_MAX, SHRT_MIN };
+
+size_t ScreenBufferRenderTarget::s_batchDepth = 0;
+ScreenBufferRenderTarget* ScreenBufferRenderTarget::s_pBatchTarget = nullptr;
+std::vector<std::pair<SHORT, SHORT>> ScreenBufferRenderTarget::s_batchColumns;
+SHORT ScreenBufferRenderTarget::s_batchTop = SHRT_MAX;
+SHORT ScreenBufferRenderTarget::s_batchBottom = SHRT_MIN;
+std::optional<COORD> ScreenBufferRenderTarget::s_batchCursorFrom;
+std::optional<COORD> ScreenBufferRenderTarget::s_batchCursorTo;
+
 ScreenBufferRenderTarget::ScreenBufferRenderTarget(SCREEN_INFORMATION& owner) :
     _owner{ owner }
 {
 }
 
-void ScreenBufferRenderTarget::TriggerRedraw(const Microsoft::Console::Types::Viewport& region)
+ScreenBufferRenderTarget::~ScreenBufferRenderTarget()
+{
+    // Whatever was noted for a buffer that's going away doesn't need drawing anymore.
+    if (s_pBatchTarget == this)
+    {
+        std::fill(s_batchColumns.begin(), s_batchColumns.end(), s_unchangedColumns);
+        s_batchTop = SHRT_MAX;
+        s_batchBottom = SHRT_MIN;
+        s_batchCursorFrom.reset();
+        s_batchCursorTo.reset();
+        s_pBatchTarget = nullptr;
+    }
+}
+
+// Routine Description:
+// - Starts holding back redraws until the matching s_EndBatch. Batches can be nested.
+// Note:
+// - Console lock must be held when calling this routine
+void ScreenBufferRenderTarget::s_BeginBatch() noexcept
+{
+    s_batchDepth++;
+}
+
+// Routine Description:
+// - Ends a batch. Once the outermost one ends, everything noted in it is redrawn.
+// Note:
+// - Console lock must be held when calling this routine
+void ScreenBufferRenderTarget::s_EndBatch() noexcept
+{
+    if (--s_batchDepth == 0)
+    {
+        s_FlushBatch();
+    }
+}
+
+// Routine Description:
+// - Notes that a region changed, to be redrawn when the batch is flushed.
+// Arguments:
+// - region - The region of the buffer that changed
+// Return Value:
+// - <none>
+void ScreenBufferRenderTarget::_NoteRedraw(const Viewport& region)
+{
+    if (s_pBatchTarget != this)
+    {
+        s_FlushBatch();
+        s_pBatchTarget = this;
+    }
+
+    if (!region.IsValid())
+    {
+        return;
+    }
+
+    if (s_batchColumns.size() < gsl::narrow_cast<size_t>(region.BottomExclusive()))
+    {
+        s_batchColumns.resize(region.BottomExclusive(), s_unchangedColumns);
+    }
+
+    for (auto row = std::max<SHORT>(region.Top(), 0); row < region.BottomExclusive(); row++)
+    {
+        auto& [left, right] = s_batchColumns.at(row);
+        left = std::min(left, region.Left());
+        right = std::max(right, region.RightExclusive());
+    }
+
+    s_batchTop = std::min(s_batchTop, std::max<SHORT>(region.Top(), 0));
+    s_batchBottom = std::max(s_batchBottom, region.BottomExclusive());
+}
+
+// Routine Description:
+// - Redraws everything that was noted in the batch so far. Rows next to each other that
+//   changed the same columns are redrawn together, and if that still leaves too many
+//   regions, one region around all of them is redrawn instead.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void ScreenBufferRenderTarget::s_FlushBatch() noexcept
+{
+    auto* const pTarget = std::exchange(s_pBatchTarget, nullptr);
+
+    const auto cursorFrom = std::exchange(s_batchCursorFrom, std::nullopt);
+    const auto cursorTo = std::exchange(s_batchCursorTo, std::nullopt);
+    if (pTarget != nullptr && cursorFrom.has_value() && cursorTo.has_value())
+    {
+        try
+        {
+            pTarget->_ForwardRedrawCursor(&cursorFrom.value());
+            if (cursorTo->X != cursorFrom->X || cursorTo->Y != cursorFrom->Y)
+            {
+                pTarget->_ForwardRedrawCursor(&cursorTo.value());
+            }
+        }
+        CATCH_LOG();
+    }
+
+    if (pTarget == nullptr || s_batchTop >= s_batchBottom)
+    {
+        s_batchTop = SHRT_MAX;
+        s_batchBottom = SHRT_MIN;
+        return;
+    }
+
+    try
+    {
+        std::vector<SMALL_RECT> regions;
+        SMALL_RECT bounds{ SHRT_MAX, s_batchTop, SHRT_MIN, s_batchBottom };
+        for (auto row = s_batchTop; row < s_batchBottom; row++)
+        {
+            const auto [left, right] = s_batchColumns.at(row);
+            if (left >= right)
+            {
+                continue;
+            }
+
+            bounds.Left = std::min(bounds.Left, left);
+            bounds.Right = std::max(bounds.Right, right);
+
+            if (!regions.empty() &&
+                regions.back().Bottom == row &&
+                regions.back().Left == left &&
+                regions.back().Right == right)
+            {
+                regions.back().Bottom++;
+            }
+            else
+            {
+                regions.push_back({ left, row, right, gsl::narrow_cast<SHORT>(row + 1) });
+            }
+        }
+
+        if (regions.size() > s_MaxBatchRegions)
+        {
+            pTarget->_ForwardRedraw(Viewport::FromExclusive(bounds));
+        }
+        else
+        {
+            for (const auto& region : regions)
+            {
+                pTarget->_ForwardRedraw(Viewport::FromExclusive(region));
+            }
+        }
+    }
+    CATCH_LOG();
+
+    std::fill(s_batchColumns.begin() + s_batchTop, s_batchColumns.begin() + s_batchBottom, s_unchangedColumns);
+    s_batchTop = SHRT_MAX;
+    s_batchBottom = SHRT_MIN;
+}
+
+void ScreenBufferRenderTarget::TriggerRedraw(const Viewport& region)
+{
+    if (s_batchDepth != 0)
+    {
+        try
+        {
+            _NoteRedraw(region);
+            return;
+        }
+        CATCH_LOG();
+
+        // If it can't be noted, it's redrawn right away, after the ones that were.
+        s_FlushBatch();
+    }
+
+    _ForwardRedraw(region);
+}
+
+void ScreenBufferRenderTarget::_ForwardRedraw(const Viewport& region)
 {
     auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
     const auto* pActive = &ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetActiveBuffer();
@@ -23,15 +205,31 @@ void ScreenBufferRenderTarget::TriggerRedraw(const Microsoft::Console::Types::Vi
 
 void ScreenBufferRenderTarget::TriggerRedraw(const COORD* const pcoord)
 {
-    auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
-    const auto* pActive = &ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetActiveBuffer();
-    if (pRenderer != nullptr && pActive == &_owner)
+    TriggerRedraw(Viewport::FromCoord(*pcoord));
+}
+
+void ScreenBufferRenderTarget::TriggerRedrawCursor(const COORD* const pcoord)
+{
+    if (s_batchDepth != 0)
     {
-        pRenderer->TriggerRedraw(pcoord);
+        if (s_pBatchTarget != this)
+        {
+            s_FlushBatch();
+            s_pBatchTarget = this;
+        }
+
+        if (!s_batchCursorFrom.has_value())
+        {
+            s_batchCursorFrom = *pcoord;
+        }
+        s_batchCursorTo = *pcoord;
+        return;
     }
+
+    _ForwardRedrawCursor(pcoord);
 }
 
-void ScreenBufferRenderTarget::TriggerRedrawCursor(const COORD* const pcoord)
+void ScreenBufferRenderTarget::_ForwardRedrawCursor(const COORD* const pcoord)
 {
     auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
     const auto* pActive = &ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetActiveBuffer();
@@ -43,6 +241,8 @@ void ScreenBufferRenderTarget::TriggerRedrawCursor(const COORD* const pcoord)
 
 void ScreenBufferRenderTarget::TriggerRedrawAll()
 {
+    s_FlushBatch();
+
     auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
     const auto* pActive = &ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetActiveBuffer();
     if (pRenderer != nullptr && pActive == &_owner)
@@ -53,6 +253,8 @@ void ScreenBufferRenderTarget::TriggerRedrawAll()
 
 void ScreenBufferRenderTarget::TriggerTeardown()
 {
+    s_FlushBatch();
+
     auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
     const auto* pActive = &ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetActiveBuffer();
     if (pRenderer != nullptr && pActive == &_owner)
@@ -63,6 +265,8 @@ void ScreenBufferRenderTarget::TriggerTeardown()
 
 void ScreenBufferRenderTarget::TriggerSelection()
 {
+    s_FlushBatch();
+
     auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
     const auto* pActive = &ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetActiveBuffer();
     if (pRenderer != nullptr && pActive == &_owner)
@@ -73,6 +277,8 @@ void ScreenBufferRenderTarget::TriggerSelection()
 
 void ScreenBufferRenderTarget::TriggerScroll()
 {
+    s_FlushBatch();
+
     auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
     const auto* pActive = &ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetActiveBuffer();
     if (pRenderer != nullptr && pActive == &_owner)
@@ -83,6 +289,8 @@ void ScreenBufferRenderTarget::TriggerScroll()
 
 void ScreenBufferRenderTarget::TriggerScroll(const COORD* const pcoordDelta)
 {
+    s_FlushBatch();
+
     auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
     const auto* pActive = &ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetActiveBuffer();
     if (pRenderer != nullptr && pActive == &_owner)
@@ -91,8 +299,22 @@ void ScreenBufferRenderTarget::TriggerScroll(const COORD* const pcoordDelta)
     }
 }
 
+void ScreenBufferRenderTarget::TriggerScrollRows(const Viewport& rows, const SHORT delta)
+{
+    s_FlushBatch();
+
+    auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
+    const auto* pActive = &ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetActiveBuffer();
+    if (pRenderer != nullptr && pActive == &_owner)
+    {
+        pRenderer->TriggerScrollRows(rows, delta);
+    }
+}
+
 void ScreenBufferRenderTarget::TriggerCircling()
 {
+    s_FlushBatch();
+
     auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
     const auto* pActive = &ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetActiveBuffer();
     if (pRenderer != nullptr && pActive == &_owner)
@@ -103,6 +325,8 @@ void ScreenBufferRenderTarget::TriggerCircling()
 
 void ScreenBufferRenderTarget::TriggerTitleChange()
 {
+    s_FlushBatch();
+
     auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
     const auto* pActive = &ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetActiveBuffer();
     if (pRenderer != nullptr && pActive == &_owner)
@@ -110,3 +334,27 @@ void ScreenBufferRenderTarget::TriggerTitleChange()
         pRenderer->TriggerTitleChange();
     }
 }
+
+void ScreenBufferRenderTarget::BeginSynchronizedUpdate()
+{
+    s_FlushBatch();
+
+    auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
+    const auto* pActive = &ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetActiveBuffer();
+    if (pRenderer != nullptr && pActive == &_owner)
+    {
+        pRenderer->BeginSynchronizedUpdate();
+    }
+}
+
+void ScreenBufferRenderTarget::EndSynchronizedUpdate()
+{
+    s_FlushBatch();
+
+    auto* pRenderer = ServiceLocator::LocateGlobals().pRender;
+    const auto* pActive = &ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetActiveBuffer();
+    if (pRenderer != nullptr && pActive == &_owner)
+    {
+        pRenderer->EndSynchronizedUpdate();
+    }
+}
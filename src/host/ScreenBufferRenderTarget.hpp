@@ -28,6 +28,15 @@ class ScreenBufferRenderTarget final : public Microsoft::Console::Render::IRende
 {
 public:
     ScreenBufferRenderTarget(SCREEN_INFORMATION& owner);
+    ~ScreenBufferRenderTarget();
+
+    // A write can change the same rows over and over. While a batch is open,
+    // redraws are only noted per row. They're handed to the renderer together
+    // when it closes, or right before the renderer is told anything else.
+    // The cursor is only redrawn where it was when the batch opened and where
+    // it is when it closes, not in every cell it passed through.
+    static void s_BeginBatch() noexcept;
+    static void s_EndBatch() noexcept;
 
     void TriggerRedraw(const Microsoft::Console::Types::Viewport& region) override;
     void TriggerRedraw(const COORD* const pcoord) override;
@@ -37,9 +46,28 @@ public:
     void TriggerSelection() override;
     void TriggerScroll() override;
     void TriggerScroll(const COORD* const pcoordDelta) override;
+    void TriggerScrollRows(const Microsoft::Console::Types::Viewport& rows, const SHORT delta) override;
     void TriggerCircling() override;
     void TriggerTitleChange() override;
+    void BeginSynchronizedUpdate() override;
+    void EndSynchronizedUpdate() override;
 
 private:
     SCREEN_INFORMATION& _owner;
+
+    void _ForwardRedraw(const Microsoft::Console::Types::Viewport& region);
+    void _ForwardRedrawCursor(const COORD* const pcoord);
+    void _NoteRedraw(const Microsoft::Console::Types::Viewport& region);
+    static void s_FlushBatch() noexcept;
+
+    // Past this many separate regions, the noted rows are redrawn as one region around all of them.
+    static constexpr size_t s_MaxBatchRegions = 8;
+
+    static size_t s_batchDepth;
+    static ScreenBufferRenderTarget* s_pBatchTarget; // the target the noted rows belong to, if any
+    static std::vector<std::pair<SHORT, SHORT>> s_batchColumns; // left and exclusive right changed in each buffer row
+    static SHORT s_batchTop;
+    static SHORT s_batchBottom; // exclusive
+    static std::optional<COORD> s_batchCursorFrom; // where the cursor was drawn before the batch
+    static std::optional<COORD> s_batchCursorTo; // where it's been moved to since
 };
@@ -66,6 +66,12 @@ VtInputThread::VtInputThread(_In_ wil::unique_hfile hPipe,
     LockConsole();
     auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
 
+    // Everything decoded from this read is written to the input buffer before
+    // any reader is woken up, instead of waking them for each key.
+    InputBuffer* const pInputBuffer = ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveInputBuffer();
+    pInputBuffer->DeferWakeUps();
+    auto ResumeWakeUps = wil::scope_exit([&] { pInputBuffer->ResumeWakeUps(); });
+
     try
     {
         std::unique_ptr<wchar_t[]> pwsSequence;
@@ -106,7 +112,9 @@ DWORD WINAPI VtInputThread::StaticVtInputThreadProc(_In_ LPVOID lpParameter)
 // - <none>
 void VtInputThread::DoReadInput(const bool throwOnFail)
 {
-    byte buffer[256];
+    // Large enough that a paste or a burst of programmatic input over the pipe
+    //      arrives in a few reads, rather than being split into many small ones.
+    byte buffer[4096];
     DWORD dwRead = 0;
     bool fSuccess = !!ReadFile(_hFile.get(), buffer, ARRAYSIZE(buffer), &dwRead, nullptr);
 
@@ -25,6 +25,11 @@ VtIo::VtIo() :
     _initialized(false),
     _objectsCreated(false),
     _lookingForCursorPosition(false),
+    _waitingForCursorPosition(false),
+    _ignoreLateCursorPosition(false),
+    _passthrough(false),
+    _passthroughOrigin{ 0 },
+    _renderOnDemand(false),
     _IoMode(VtIoMode::INVALID)
 {
 }
@@ -73,6 +78,8 @@ VtIo::VtIo() :
 [[nodiscard]] HRESULT VtIo::Initialize(const ConsoleArguments* const pArgs)
 {
     _lookingForCursorPosition = pArgs->GetInheritCursor();
+    _passthrough = pArgs->GetPassthrough();
+    _renderOnDemand = pArgs->GetRenderOnDemand();
 
     // If we were already given VT handles, set up the VT IO engine to use those.
     if (pArgs->InConptyMode())
@@ -192,6 +199,7 @@ VtIo::VtIo() :
             if (_pVtRenderEngine)
             {
                 _pVtRenderEngine->SetTerminalOwner(this);
+                _pVtRenderEngine->SetRenderOnDemand(_renderOnDemand);
             }
         }
     }
@@ -229,7 +237,9 @@ bool VtIo::IsUsingVt() const
     {
         try
         {
-            g.pRender->AddRenderEngine(_pVtRenderEngine.get());
+            // The pipe's reader might not keep up with us, so let the VT engine
+            //      paint on its own thread. That way it never holds up the window.
+            g.pRender->AddRenderEngineOnOwnThread(_pVtRenderEngine.get());
             g.getConsoleInformation().GetActiveOutputBuffer().SetTerminalConnection(_pVtRenderEngine.get());
         }
         CATCH_RETURN();
@@ -237,20 +247,26 @@ bool VtIo::IsUsingVt() const
 
     // MSFT: 15813316
     // If the terminal application wants us to inherit the cursor position,
-    //  we're going to emit a VT sequence to ask for the cursor position, then
-    //  read input until we get a response. Terminals who request this behavior
-    //  but don't respond will hang.
-    // If we get a response, the InteractDispatch will call SetCursorPosition,
-    //      which will call to our VtIo::SetCursorPosition method.
+    //  we're going to emit a VT sequence to ask for the cursor position. The
+    //  input thread reads the response like any other input, and the
+    //  InteractDispatch will call SetCursorPosition, which will call to our
+    //  VtIo::SetCursorPosition method.
+    // We don't wait for it here, so that the client can get going during the
+    //      round trip. Instead, the client's first API call waits for it, in
+    //      WaitForCursorPosition, before it can change what's in the buffer.
     // We need both handles for this initialization to work. If we don't have
     //      both, we'll skip it. They either aren't going to be reading output
     //      (so they can't get the DSR) or they can't write the response to us.
     if (_lookingForCursorPosition && _pVtRenderEngine && _pVtInputThread)
     {
-        LOG_IF_FAILED(_pVtRenderEngine->RequestCursor());
-        while (_lookingForCursorPosition)
+        if (SUCCEEDED_LOG(_cursorPositionEvent.create(wil::EventOptions::ManualReset)))
         {
-            _pVtInputThread->DoReadInput(false);
+            LOG_IF_FAILED(_pVtRenderEngine->RequestCursor());
+            _waitingForCursorPosition = true;
+        }
+        else
+        {
+            _lookingForCursorPosition = false;
         }
     }
 
@@ -325,11 +341,15 @@ bool VtIo::IsUsingVt() const
 // Method Description:
 // - Attempts to set the initial cursor position, if we're looking for it.
 //      If we're not trying to inherit the cursor, does nothing.
+//   If we gave up on the terminal's answer before it came, the answer is too
+//      late to be used: the client has written to the buffer since.
+// - Must be called with the console lock held.
 // Arguments:
 // - coordCursor: The initial position of the cursor.
 // Return Value:
-// - S_OK if we successfully inherited the cursor or did nothing, else an
-//      appropriate HRESULT
+// - S_OK if we successfully inherited the cursor or did nothing, S_FALSE if
+//      the position came too late and the cursor shouldn't be moved to it, else
+//      an appropriate HRESULT
 [[nodiscard]] HRESULT VtIo::SetCursorPosition(const COORD coordCursor)
 {
     HRESULT hr = S_OK;
@@ -341,10 +361,198 @@ bool VtIo::IsUsingVt() const
         }
 
         _lookingForCursorPosition = false;
+        if (_cursorPositionEvent)
+        {
+            _cursorPositionEvent.SetEvent();
+        }
+    }
+    else if (_ignoreLateCursorPosition)
+    {
+        _ignoreLateCursorPosition = false;
+        hr = S_FALSE;
     }
     return hr;
 }
 
+// Method Description:
+// - If we've asked the terminal where its cursor is, waits until it has told
+//      us, so that the client doesn't write anything before the cursor is where
+//      the terminal has it. Called by the IO thread before it services anything
+//      for the client, so this only waits on the client's first API call.
+//   A terminal that doesn't answer in time is given up on, and its answer is
+//      ignored if it comes after all.
+// - Must be called without the console lock held, since the answer is handled
+//      under it.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtIo::WaitForCursorPosition() noexcept
+{
+    if (!_waitingForCursorPosition)
+    {
+        return;
+    }
+    _waitingForCursorPosition = false;
+
+    if (!_cursorPositionEvent.wait(s_CursorPositionTimeoutMilliseconds))
+    {
+        LockConsole();
+        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        if (_lookingForCursorPosition)
+        {
+            _lookingForCursorPosition = false;
+            _ignoreLateCursorPosition = true;
+        }
+    }
+}
+
+// Method Description:
+// - Checks whether the text a client is about to write with VT processing on can
+//      be passed through to the terminal as it is, instead of being painted from
+//      the buffer once it's been written there. If so, makes sure the terminal
+//      is using the colors the text is about to be written with.
+//   Only text written to the active buffer of a terminal that gets full utf-8 is
+//      passed through, and only if it wraps at the end of lines like the terminal does.
+// Arguments:
+// - screenInfo: The buffer the text is being written to.
+// - text: The text that's being written.
+// Return Value:
+// - true if the text should be given to EndPassthrough once it's in the buffer.
+bool VtIo::BeginPassthrough(const SCREEN_INFORMATION& screenInfo, const std::wstring_view text) noexcept
+{
+    if (!_passthrough ||
+        !_pVtRenderEngine ||
+        (_IoMode != VtIoMode::XTERM && _IoMode != VtIoMode::XTERM_256) ||
+        !screenInfo.IsActiveScreenBuffer() ||
+        WI_IsFlagClear(screenInfo.OutputMode, ENABLE_WRAP_AT_EOL_OUTPUT) ||
+        screenInfo.AreMarginsSet() ||
+        !_pVtRenderEngine->CanPassthrough() ||
+        !s_IsPassthroughText(text))
+    {
+        return false;
+    }
+
+    _passthroughOrigin = screenInfo.GetViewport().Origin();
+    return SUCCEEDED(_UpdatePassthroughBrushes(screenInfo));
+}
+
+// Method Description:
+// - Passes text through to the terminal, now that it's been written to the
+//      buffer. If writing it moved the viewport, the terminal wouldn't follow
+//      along, so it's left for the renderer to paint instead.
+// Arguments:
+// - screenInfo: The buffer the text was written to.
+// - text: The text that was written. It must have been given to BeginPassthrough.
+// Return Value:
+// - S_OK if the text was passed through, S_FALSE if it's left for the renderer,
+//      else an appropriate HRESULT for failing to allocate or write.
+[[nodiscard]] HRESULT VtIo::EndPassthrough(const SCREEN_INFORMATION& screenInfo, const std::wstring_view text) noexcept
+{
+    if (!_pVtRenderEngine ||
+        !screenInfo.IsActiveScreenBuffer() ||
+        screenInfo.GetViewport().Origin() != _passthroughOrigin)
+    {
+        return S_FALSE;
+    }
+
+    try
+    {
+        // A newline also returns the cursor to the start of the line in the
+        //      buffer, unless the client asked for it not to. It doesn't in the terminal.
+        std::wstring wstr;
+        if (WI_IsFlagSet(screenInfo.OutputMode, DISABLE_NEWLINE_AUTO_RETURN))
+        {
+            wstr = text;
+        }
+        else
+        {
+            wstr.reserve(text.size());
+            for (const auto wch : text)
+            {
+                if (wch == L'\n')
+                {
+                    wstr.push_back(L'\r');
+                }
+                wstr.push_back(wch);
+            }
+        }
+
+        auto coordCursor = screenInfo.GetTextBuffer().GetCursor().GetPosition();
+        screenInfo.GetViewport().ConvertToOrigin(&coordCursor);
+
+        const HRESULT hr = _pVtRenderEngine->PassthroughString(wstr, coordCursor);
+        RETURN_IF_FAILED(hr);
+        if (hr == S_FALSE)
+        {
+            return hr;
+        }
+    }
+    CATCH_RETURN();
+
+    // The text may have changed the colors, so bring the renderer up to date
+    //      with the ones the terminal is using now.
+    return _UpdatePassthroughBrushes(screenInfo);
+}
+
+// Method Description:
+// - Sets the colors of the terminal to the ones the given buffer writes text with.
+// Arguments:
+// - screenInfo: The buffer to get the colors from.
+// Return Value:
+// - S_OK, else an appropriate HRESULT for failing to allocate or write.
+[[nodiscard]] HRESULT VtIo::_UpdatePassthroughBrushes(const SCREEN_INFORMATION& screenInfo) noexcept
+{
+    const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    const TextAttribute attributes = screenInfo.GetAttributes();
+    return _pVtRenderEngine->UpdateDrawingBrushes(gci.LookupForegroundColor(attributes),
+                                                  gci.LookupBackgroundColor(attributes),
+                                                  attributes.GetLegacyAttributes(),
+                                                  attributes.IsBold(),
+                                                  false);
+}
+
+// Method Description:
+// - Checks that the text only prints, moves the cursor, erases, and changes
+//      colors, which the terminal does just as we do in the buffer. Anything else
+//      is left to the renderer, which knows how to show it.
+// Arguments:
+// - text: The text to check.
+// Return Value:
+// - true if the text can be passed through to the terminal.
+bool VtIo::s_IsPassthroughText(const std::wstring_view text) noexcept
+{
+    static constexpr std::wstring_view passthroughFinals{ L"ABCDHJKm" };
+
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        const wchar_t wch = text.at(i);
+        if (wch == L'\x1b')
+        {
+            // Only CSIs with nothing but numeric parameters.
+            if (i + 1 >= text.size() || text.at(i + 1) != L'[')
+            {
+                return false;
+            }
+            i += 2;
+            while (i < text.size() && ((text.at(i) >= L'0' && text.at(i) <= L'9') || text.at(i) == L';'))
+            {
+                i++;
+            }
+            if (i >= text.size() || passthroughFinals.find(text.at(i)) == std::wstring_view::npos)
+            {
+                return false;
+            }
+        }
+        else if ((wch < L' ' && wch != L'\r' && wch != L'\n' && wch != L'\b') ||
+                 (wch >= L'\x7f' && wch <= L'\x9f'))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 void VtIo::CloseInput()
 {
     // This will release the lock when it goes out of scope
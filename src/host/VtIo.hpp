@@ -10,6 +10,7 @@
 #include "PtySignalInputThread.hpp"
 
 class ConsoleArguments;
+class SCREEN_INFORMATION;
 
 namespace Microsoft::Console::VirtualTerminal
 {
@@ -32,6 +33,10 @@ namespace Microsoft::Console::VirtualTerminal
 
         [[nodiscard]] HRESULT SuppressResizeRepaint();
         [[nodiscard]] HRESULT SetCursorPosition(const COORD coordCursor);
+        void WaitForCursorPosition() noexcept;
+
+        bool BeginPassthrough(const SCREEN_INFORMATION& screenInfo, const std::wstring_view text) noexcept;
+        [[nodiscard]] HRESULT EndPassthrough(const SCREEN_INFORMATION& screenInfo, const std::wstring_view text) noexcept;
 
         void CloseInput() override;
         void CloseOutput() override;
@@ -48,6 +53,21 @@ namespace Microsoft::Console::VirtualTerminal
         bool _objectsCreated;
 
         bool _lookingForCursorPosition;
+
+        // Set once the terminal has told us where its cursor is. Only the IO thread
+        //      waits on it, and only while _waitingForCursorPosition is set.
+        wil::unique_event_nothrow _cursorPositionEvent;
+        bool _waitingForCursorPosition;
+        bool _ignoreLateCursorPosition;
+        static constexpr DWORD s_CursorPositionTimeoutMilliseconds = 500;
+
+        // Whether client text that the terminal can show just as we do is written
+        //      straight to it, and where the viewport was when the write began.
+        bool _passthrough;
+        COORD _passthroughOrigin;
+
+        // Whether frames are only painted once the terminal has read the last one.
+        bool _renderOnDemand;
         std::mutex _shutdownLock;
 
         std::unique_ptr<Microsoft::Console::Render::VtEngine> _pVtRenderEngine;
@@ -58,6 +78,9 @@ namespace Microsoft::Console::VirtualTerminal
 
         void _ShutdownIfNeeded();
 
+        [[nodiscard]] HRESULT _UpdatePassthroughBrushes(const SCREEN_INFORMATION& screenInfo) noexcept;
+        static bool s_IsPassthroughText(const std::wstring_view text) noexcept;
+
 #ifdef UNIT_TESTING
         friend class VtIoTests;
 #endif
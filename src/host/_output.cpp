@@ -4,6 +4,7 @@
 #include "precomp.h"
 
 #include "_output.h"
+#include "_stream.h"
 
 #include "dbcs.h"
 #include "handle.h"
@@ -83,6 +84,7 @@ void WriteToScreen(SCREEN_INFORMATION& screenInfo, const Viewport& region)
 
     LockConsole();
     auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+    FlushPendingWrites();
 
     auto& screenInfo = OutContext.GetActiveBuffer();
     const auto bufferSize = screenInfo.GetBufferSize();
@@ -91,10 +93,11 @@ void WriteToScreen(SCREEN_INFORMATION& screenInfo, const Viewport& region)
         return E_INVALIDARG;
     }
 
-    const OutputCellIterator it(attrs, true);
-    const auto done = screenInfo.Write(it, target);
-
-    used = done.GetCellDistance(it);
+    try
+    {
+        used = screenInfo.GetTextBuffer().WriteLegacyAttributes(attrs, target);
+    }
+    CATCH_RETURN();
 
     return S_OK;
 }
@@ -123,6 +126,7 @@ void WriteToScreen(SCREEN_INFORMATION& screenInfo, const Viewport& region)
 
     LockConsole();
     auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+    FlushPendingWrites();
 
     auto& screenInfo = OutContext.GetActiveBuffer();
     const auto bufferSize = screenInfo.GetBufferSize();
@@ -208,6 +212,7 @@ void WriteToScreen(SCREEN_INFORMATION& screenInfo, const Viewport& region)
 
     LockConsole();
     auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+    FlushPendingWrites();
 
     auto& screenBuffer = OutContext.GetActiveBuffer();
     const auto bufferSize = screenBuffer.GetBufferSize();
@@ -237,10 +242,7 @@ void WriteToScreen(SCREEN_INFORMATION& screenInfo, const Viewport& region)
             }
         }
 
-        const OutputCellIterator it(useThisAttr, lengthToWrite);
-        const auto done = screenBuffer.Write(it, startingCoordinate);
-
-        cellsModified = done.GetCellDistance(it);
+        cellsModified = screenBuffer.GetTextBuffer().FillAttributes(useThisAttr, startingCoordinate, lengthToWrite);
 
         // Notify accessibility
         auto endingCoordinate = startingCoordinate;
@@ -278,6 +280,7 @@ void WriteToScreen(SCREEN_INFORMATION& screenInfo, const Viewport& region)
 
     LockConsole();
     auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+    FlushPendingWrites();
 
     // TODO: does this even need to be here or will it exit quickly?
     auto& screenInfo = OutContext.GetActiveBuffer();
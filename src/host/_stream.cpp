@@ -18,6 +18,7 @@
 
 #include "../types/inc/convert.hpp"
 #include "../types/inc/GlyphWidth.hpp"
+#include "../types/inc/OutputTracing.hpp"
 #include "../types/inc/Viewport.hpp"
 
 #include "..\interactivity\inc\ServiceLocator.hpp"
@@ -26,6 +27,7 @@
 using namespace Microsoft::Console::Types;
 using Microsoft::Console::Interactivity::ServiceLocator;
 using Microsoft::Console::VirtualTerminal::StateMachine;
+using Microsoft::Console::VirtualTerminal::VtIo;
 // Used by WriteCharsLegacy.
 #define IS_GLYPH_CHAR(wch) (((wch) < L' ') || ((wch) == 0x007F))
 
@@ -400,6 +402,33 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
         XPosition = cursor.GetPosition().X;
         size_t i = 0;
         wchar_t* LocalBufPtr = LocalBuffer;
+        const wchar_t* pwchText = LocalBuffer;
+
+        // Plain 7-bit printable text needs none of the handling below in either output mode: every
+        // character takes one cell and is written as it is. So when the text starts with some, take
+        // as much of it as fits on the row and write it straight from the string instead of copying
+        // it into LocalBuffer one character at a time.
+        if (XPosition < coordScreenBufferSize.X)
+        {
+            const size_t cchRemaining = (BufferSize - *pcb) / sizeof(wchar_t);
+            const size_t cchLimit = std::min(cchRemaining, gsl::narrow_cast<size_t>(coordScreenBufferSize.X - XPosition));
+            const auto runEnd = std::find_if(lpString, lpString + cchLimit, [](const wchar_t wch) noexcept {
+                return wch < UNICODE_SPACE || wch >= 0x007F;
+            });
+            const size_t cchRun = runEnd - lpString;
+            if (cchRun > 1)
+            {
+                pwchText = lpString;
+                i = cchRun;
+                XPosition = gsl::narrow_cast<SHORT>(XPosition + cchRun);
+                lpString += cchRun;
+                pwchRealUnicode += cchRun;
+                pwchBuffer += cchRun;
+                *pcb += cchRun * sizeof(wchar_t);
+                goto EndWhile;
+            }
+        }
+
         while (*pcb < BufferSize && i < LOCAL_BUFFER_SIZE && XPosition < coordScreenBufferSize.X)
         {
 #pragma prefast(suppress : 26019, "Buffer is taken in multiples of 2. Validation is ok.")
@@ -556,7 +585,7 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
             }
 
             // line was wrapped if we're writing up to the end of the current row
-            OutputCellIterator it(std::wstring_view(LocalBuffer, i), Attributes);
+            OutputCellIterator it(std::wstring_view(pwchText, i), Attributes);
             const auto itEnd = screenInfo.Write(it);
 
             // Notify accessibility
@@ -681,6 +710,7 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
                         // since you just backspaced yourself back up into the previous row, unset the wrap
                         // flag on the prev row if it was set
                         textBuffer.GetRowByOffset(CursorPosition.Y).GetCharRow().SetWrapForced(false);
+                        textBuffer.MarkRowsChanged(CursorPosition.Y, 1);
                     }
                 }
                 else if (IS_CONTROL_CHAR(LastChar))
@@ -752,6 +782,7 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
                     // since you just backspaced yourself back up into the previous row, unset the wrap flag
                     // on the prev row if it was set
                     textBuffer.GetRowByOffset(CursorPosition.Y).GetCharRow().SetWrapForced(false);
+                    textBuffer.MarkRowsChanged(CursorPosition.Y, 1);
 
                     Status = AdjustCursorPosition(screenInfo, CursorPosition, dwFlags & WC_KEEP_CURSOR_VISIBLE, psScrollY);
                 }
@@ -789,6 +820,7 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
 
                     // since you just tabbed yourself past the end of the row, set the wrap
                     textBuffer.GetRowByOffset(cursor.GetPosition().Y).GetCharRow().SetWrapForced(true);
+                    textBuffer.MarkRowsChanged(cursor.GetPosition().Y, 1);
                 }
                 else
                 {
@@ -839,6 +871,7 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
             {
                 // since we explicitly just moved down a row, clear the wrap status on the row we just came from
                 textBuffer.GetRowByOffset(cursor.GetPosition().Y).GetCharRow().SetWrapForced(false);
+                textBuffer.MarkRowsChanged(cursor.GetPosition().Y, 1);
             }
 
             Status = AdjustCursorPosition(screenInfo, CursorPosition, (dwFlags & WC_KEEP_CURSOR_VISIBLE) != 0, psScrollY);
@@ -887,6 +920,7 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
                 // Additionally, this padding is only called for IsConsoleFullWidth (a.k.a. when a character
                 // is too wide to fit on the current line).
                 charRow.SetDoubleBytePadded(true);
+                textBuffer.MarkRowsChanged(TargetPoint.Y, 1);
 
                 Status = AdjustCursorPosition(screenInfo, CursorPosition, dwFlags & WC_KEEP_CURSOR_VISIBLE, psScrollY);
                 continue;
@@ -944,6 +978,10 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
     if (!WI_IsFlagSet(screenInfo.OutputMode, ENABLE_VIRTUAL_TERMINAL_PROCESSING) ||
         !WI_IsFlagSet(screenInfo.OutputMode, ENABLE_PROCESSED_OUTPUT))
     {
+        // Everything the write changes is handed to the renderer at once when it's done.
+        ScreenBufferRenderTarget::s_BeginBatch();
+        auto endBatch = wil::scope_exit([]() noexcept { ScreenBufferRenderTarget::s_EndBatch(); });
+
         return WriteCharsLegacy(screenInfo,
                                 pwchBufferBackupLimit,
                                 pwchBuffer,
@@ -976,7 +1014,25 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
                 StateMachine& machine = screenInfo.GetStateMachine();
                 size_t const cch = BufferSize / sizeof(WCHAR);
 
-                machine.ProcessString(pwchRealUnicode, cch);
+                // In passthrough mode, text the terminal shows just as we would goes straight to it,
+                //      rather than being painted from the buffer on the next frame.
+                VtIo* const pVtIo = ServiceLocator::LocateGlobals().getConsoleInformation().GetVtIo();
+                const std::wstring_view text{ pwchRealUnicode, cch };
+                const bool passthrough = pVtIo->BeginPassthrough(screenInfo, text);
+
+                // Everything the sequences change is handed to the renderer at once when they're done.
+                // That has to happen before passing the text through, which takes it as painted.
+                {
+                    ScreenBufferRenderTarget::s_BeginBatch();
+                    auto endBatch = wil::scope_exit([]() noexcept { ScreenBufferRenderTarget::s_EndBatch(); });
+
+                    machine.ProcessString(pwchRealUnicode, cch);
+                }
+
+                if (passthrough)
+                {
+                    LOG_IF_FAILED(pVtIo->EndPassthrough(screenInfo, text));
+                }
                 *pcb += BufferSize;
             }
         }
@@ -990,8 +1046,18 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
     return Status;
 }
 
+// The most text that's held for writing later while output is blocked, in wchar_ts.
+// Once it's full, writes wait for output to be unblocked instead.
+static constexpr size_t MaxPendingWritesLength = 64 * 1024;
+
 // Routine Description:
 // - Takes the given text and inserts it into the given screen buffer.
+// - While output is blocked by a selection or by dragging the scroll bar, the text is copied aside to be
+//   written once it's unblocked, and the write completes right away. The client only waits when there's
+//   no room left to copy it, or when output was paused (Pause or Ctrl+S), which has to stop the client.
+// - Any other call that changes the output or how it's written flushes the held text first (see
+//   FlushPendingWrites), so that the held text is written with the attributes, cursor position and
+//   mode it was written with.
 // Note:
 // - Console lock must be held when calling this routine
 // - String has been translated to unicode at this point.
@@ -1010,9 +1076,39 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
                                       SCREEN_INFORMATION& screenInfo,
                                       std::unique_ptr<WriteData>& waiter)
 {
-    const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    const OutputTracing::WriteActivity writeTracing{ *pcbBuffer / sizeof(wchar_t) };
+
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
     if (WI_IsAnyFlagSet(gci.Flags, (CONSOLE_SUSPENDED | CONSOLE_SELECTING | CONSOLE_SCROLLBAR_TRACKING)))
     {
+        const std::wstring_view text{ pwchBuffer, *pcbBuffer / sizeof(wchar_t) };
+
+        // Once one write has had to wait, the ones after it wait too so that they stay in order.
+        if (WI_IsFlagClear(gci.Flags, CONSOLE_SUSPENDED) &&
+            !gci.PendingWritesOverflowed &&
+            text.size() <= MaxPendingWritesLength - gci.PendingWritesLength)
+        {
+            try
+            {
+                // Consecutive writes to the same buffer are kept together so they're written in one go.
+                if (!gci.PendingWrites.empty() && gci.PendingWrites.back().first == &screenInfo)
+                {
+                    gci.PendingWrites.back().second.append(text);
+                }
+                else
+                {
+                    gci.PendingWrites.emplace_back(&screenInfo, text);
+                }
+                gci.PendingWritesLength += text.size();
+                return STATUS_SUCCESS;
+            }
+            catch (...)
+            {
+                return NTSTATUS_FROM_HRESULT(wil::ResultFromCaughtException());
+            }
+        }
+
+        gci.PendingWritesOverflowed = true;
         try
         {
             waiter = std::make_unique<WriteData>(screenInfo,
@@ -1028,6 +1124,12 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
         return CONSOLE_STATUS_WAIT;
     }
 
+    // Output was unblocked without anything writing what was held back, so do it now to keep it in order.
+    if (!gci.PendingWrites.empty() || gci.PendingWritesOverflowed)
+    {
+        FlushPendingWrites();
+    }
+
     const auto& textBuffer = screenInfo.GetTextBuffer();
     return WriteChars(screenInfo,
                       pwchBuffer,
@@ -1040,6 +1142,76 @@ using Microsoft::Console::VirtualTerminal::StateMachine;
                       nullptr);
 }
 
+// Routine Description:
+// - Writes the text that was held back while output was blocked to the screen buffers it was written to.
+// - Besides when output is unblocked, this is called by every API that changes the contents of a screen
+//   buffer or the state that text is written with (attributes, cursor position, mode, size, the active
+//   buffer) before it makes its change, even while output is still blocked. That keeps the held text
+//   in order with the calls that came after it.
+// Note:
+// - Console lock must be held when calling this routine
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void FlushPendingWrites() noexcept
+{
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    while (!gci.PendingWrites.empty())
+    {
+        auto& [pScreenInfo, text] = gci.PendingWrites.front();
+        try
+        {
+            size_t cbText = text.size() * sizeof(wchar_t);
+            LOG_IF_NTSTATUS_FAILED(WriteChars(*pScreenInfo,
+                                              text.data(),
+                                              text.data(),
+                                              text.data(),
+                                              &cbText,
+                                              nullptr,
+                                              pScreenInfo->GetTextBuffer().GetCursor().GetPosition().X,
+                                              WC_LIMIT_BACKSPACE,
+                                              nullptr));
+        }
+        CATCH_LOG();
+
+        gci.PendingWritesLength -= text.size();
+        gci.PendingWrites.pop_front();
+    }
+
+    // Writes that had to wait are still waiting while output is blocked, and the ones after them have to wait too.
+    if (WI_AreAllFlagsClear(gci.Flags, (CONSOLE_SUSPENDED | CONSOLE_SELECTING | CONSOLE_SCROLLBAR_TRACKING)))
+    {
+        gci.PendingWritesOverflowed = false;
+    }
+}
+
+// Routine Description:
+// - Drops the text that was held back for a screen buffer that's going away.
+// Note:
+// - Console lock must be held when calling this routine
+// Arguments:
+// - screenInfo - The screen buffer being deleted
+// Return Value:
+// - <none>
+void DiscardPendingWrites(const SCREEN_INFORMATION& screenInfo) noexcept
+{
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    auto& pending = gci.PendingWrites;
+    for (auto it = pending.begin(); it != pending.end();)
+    {
+        if (it->first == &screenInfo)
+        {
+            gci.PendingWritesLength -= it->second.size();
+            it = pending.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
 // Routine Description:
 // - This method performs the actual work of attempting to write to the console, converting data types as necessary
 //   to adapt from the server types to the legacy internal host types.
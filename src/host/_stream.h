@@ -96,3 +96,7 @@ Note:
                                       _In_ size_t* const pcbBuffer,
                                       SCREEN_INFORMATION& screenInfo,
                                       std::unique_ptr<WriteData>& waiter);
+
+// NOTE: console lock must be held when calling these routines
+void FlushPendingWrites() noexcept;
+void DiscardPendingWrites(const SCREEN_INFORMATION& screenInfo) noexcept;
@@ -26,12 +26,23 @@ using Microsoft::Console::Interactivity::ServiceLocator;
 
 struct case_insensitive_hash
 {
-    std::size_t operator()(const std::wstring& key) const
+    // FNV-1a over the lowercased characters, so that hashing a key doesn't
+    // need a lowercased copy of it.
+    std::size_t operator()(const std::wstring& key) const noexcept
     {
-        std::wstring lower(key);
-        std::transform(lower.begin(), lower.end(), lower.begin(), ::towlower);
-        std::hash<std::wstring> hash;
-        return hash(lower);
+#if defined(_WIN64)
+        std::size_t hash = 14695981039346656037ull;
+        constexpr std::size_t prime = 1099511628211ull;
+#else
+        std::size_t hash = 2166136261u;
+        constexpr std::size_t prime = 16777619u;
+#endif
+        for (const auto ch : key)
+        {
+            hash ^= static_cast<std::size_t>(::towlower(ch));
+            hash *= prime;
+        }
+        return hash;
     }
 };
 
@@ -52,6 +63,18 @@ std::unordered_map<std::wstring,
                    case_insensitive_equality>
     g_aliasData;
 
+// Routine Description:
+// - Finds the aliases of an exe.
+// Arguments:
+// - exeName - The name of the EXE to find the aliases of
+// Return Value:
+// - The aliases, or nullptr if the exe has none.
+static const auto* _FindExeAliases(const std::wstring& exeName)
+{
+    const auto exeIter = g_aliasData.find(exeName);
+    return (exeIter == g_aliasData.end() || exeIter->second.empty()) ? nullptr : &exeIter->second;
+}
+
 // Routine Description:
 // - Adds a command line alias to the global set.
 // - Converts and calls the W version of this function.
@@ -1145,54 +1168,42 @@ std::wstring Alias::s_MatchAndCopyAlias(const std::wstring& sourceText,
                                         const std::wstring& exeName,
                                         size_t& lineCount)
 {
-    // Copy source text into a local for manipulation.
-    std::wstring sourceCopy(sourceText);
-
-    // Trim trailing \r\n off of sourceCopy if it has one.
-    s_TrimTrailingCrLf(sourceCopy);
-
-    // Trim leading spaces off of sourceCopy if it has any.
-    s_TrimLeadingSpaces(sourceCopy);
-
     // Check if we have an EXE in the list that matches the request first.
-    auto exeIter = g_aliasData.find(exeName);
-    if (exeIter == g_aliasData.end())
+    // Most exes have no aliases, so this is done before anything is copied.
+    const auto exeList = _FindExeAliases(exeName);
+    if (exeList == nullptr)
     {
         // We found no data for this exe. Give back an empty string.
         return std::wstring();
     }
 
-    auto exeList = exeIter->second;
-    if (exeList.size() == 0)
-    {
-        // If there's no match, give back an empty string.
-        return std::wstring();
-    }
+    // Copy source text into a local for manipulation.
+    std::wstring sourceCopy(sourceText);
 
-    // Tokenize the text by spaces
-    const auto tokens = s_Tokenize(sourceCopy);
+    // Trim trailing \r\n off of sourceCopy if it has one.
+    s_TrimTrailingCrLf(sourceCopy);
 
-    // If there are no tokens, return an empty string
-    if (tokens.size() == 0)
-    {
-        return std::wstring();
-    }
+    // Trim leading spaces off of sourceCopy if it has any.
+    s_TrimLeadingSpaces(sourceCopy);
 
-    // Find alias. If there isn't one, return an empty string
-    const auto alias = tokens.front();
-    const auto aliasIter = exeList.find(alias);
-    if (aliasIter == exeList.end())
+    // Find alias, which is the first token. If there isn't one, return an empty string
+    const auto alias = sourceCopy.substr(0, sourceCopy.find(L' '));
+    const auto aliasIter = exeList->find(alias);
+    if (aliasIter == exeList->end())
     {
         // We found no alias pair with this name. Give back an empty string.
         return std::wstring();
     }
 
-    const auto target = aliasIter->second;
+    const auto& target = aliasIter->second;
     if (target.size() == 0)
     {
         return std::wstring();
     }
 
+    // Tokenize the text by spaces, now that we know there's an alias to expand.
+    const auto tokens = s_Tokenize(sourceCopy);
+
     // Get the string of all parameters as a shorthand for $* later.
     const auto allParams = s_GetArgString(sourceCopy);
 
@@ -1226,6 +1237,12 @@ void Alias::s_MatchAndCopyAliasLegacy(_In_reads_bytes_(cbSource) PWCHAR pwchSour
 {
     try
     {
+        // Don't bother copying the source when there's nothing to match it against.
+        if (_FindExeAliases(exeName) == nullptr)
+        {
+            return;
+        }
+
         std::wstring sourceText(pwchSource, cbSource / sizeof(WCHAR));
         size_t lineCount = lines;
 
@@ -112,6 +112,18 @@ bool IsWordDelim(const std::wstring_view charData)
     return IsWordDelim(charData.front());
 }
 
+// Routine Description:
+// - Gets every character that IsWordDelim detects, the space character included.
+// Return Value:
+// - The word delimiters, in a form that CharRow::GetWordRunAt can use.
+std::wstring GetWordDelims()
+{
+    const auto& delimiters = ServiceLocator::LocateGlobals().WordDelimiters;
+    std::wstring wordDelims{ UNICODE_SPACE };
+    wordDelims.append(delimiters.cbegin(), delimiters.cend());
+    return wordDelims;
+}
+
 CommandLine::CommandLine() :
     _isVisible{ true }
 {
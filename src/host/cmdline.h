@@ -152,6 +152,7 @@ void RedrawCommandLine(COOKED_READ_DATA& cookedReadData);
 // Word delimiters
 bool IsWordDelim(const wchar_t wch);
 bool IsWordDelim(const std::wstring_view charData);
+std::wstring GetWordDelims();
 
 [[nodiscard]] HRESULT DoSrvSetConsoleTitleW(const std::wstring_view title) noexcept;
 
@@ -0,0 +1,138 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "codepageTable.hpp"
+#include "misc.h"
+
+#pragma hdrstop
+
+CodepageTable::CodepageTable() noexcept :
+    _codepage{ 0 },
+    _leadBytes{},
+    _singleBytes{},
+    _doubleBytes{},
+    _wideToBytes{},
+    _wideToBytesKnown{}
+{
+}
+
+// Routine Description:
+// - Switches the table to the given codepage, dropping everything looked up for the last one.
+// - Every single byte is translated right away, since there are few of them and nearly every
+//   cell is one.
+// Arguments:
+// - codepage - the codepage to translate to and from
+// Return Value:
+// - <none>
+void CodepageTable::Reset(const UINT codepage)
+{
+    _codepage = codepage;
+
+    CPINFO info;
+    if (!GetCPInfo(codepage, &info))
+    {
+        info.LeadByte[0] = 0;
+    }
+
+    _leadBytes.fill(false);
+    // The ranges of lead bytes come in pairs and end with a pair of zeroes.
+    for (size_t i = 0; i + 1 < ARRAYSIZE(info.LeadByte) && info.LeadByte[i]; i += 2)
+    {
+        for (size_t b = info.LeadByte[i]; b <= info.LeadByte[i + 1]; ++b)
+        {
+            _leadBytes.at(b) = true;
+        }
+    }
+
+    for (size_t b = 0; b < _singleBytes.size(); ++b)
+    {
+        const auto ch = static_cast<CHAR>(b);
+        ConvertOutputToUnicode(codepage, &ch, 1, &_singleBytes.at(b), 1);
+    }
+
+    _doubleBytes.clear();
+    _wideToBytes.clear();
+    _wideToBytesKnown.clear();
+}
+
+// Routine Description:
+// - Gets the codepage the table translates to and from.
+UINT CodepageTable::GetCodepage() const noexcept
+{
+    return _codepage;
+}
+
+// Routine Description:
+// - Checks if a byte leads a double byte character in the codepage.
+// Arguments:
+// - ch - the byte to check
+// Return Value:
+// - true if ch is a lead byte, false otherwise.
+bool CodepageTable::IsLeadByte(const CHAR ch) const noexcept
+{
+    return _leadBytes[static_cast<unsigned char>(ch)];
+}
+
+// Routine Description:
+// - Translates a single byte of the codepage to UTF-16, the way ConvertOutputToUnicode does.
+// Arguments:
+// - ch - the byte to translate
+// Return Value:
+// - the character, or 0 if there isn't one
+wchar_t CodepageTable::ToWide(const CHAR ch) const noexcept
+{
+    return _singleBytes[static_cast<unsigned char>(ch)];
+}
+
+// Routine Description:
+// - Translates a double byte character of the codepage to UTF-16, the way ConvertOutputToUnicode does.
+// Arguments:
+// - lead - the first byte of the character
+// - trail - the second byte of the character
+// Return Value:
+// - the first UTF-16 unit of the translation, or 0 if there isn't one
+wchar_t CodepageTable::ToWide(const CHAR lead, const CHAR trail)
+{
+    if (_doubleBytes.empty())
+    {
+        _doubleBytes.resize(0x10000);
+    }
+
+    auto& entry = _doubleBytes.at(static_cast<unsigned char>(lead) << 8 | static_cast<unsigned char>(trail));
+    if (entry == 0)
+    {
+        const CHAR bytes[2]{ lead, trail };
+        WCHAR wide[2];
+        ConvertOutputToUnicode(_codepage, &bytes[0], 2, &wide[0], 2);
+        entry = wide[0] | KnownFlag;
+    }
+
+    return static_cast<wchar_t>(entry & ~KnownFlag);
+}
+
+// Routine Description:
+// - Translates a UTF-16 character to the codepage, the way ConvertToOem does.
+// Arguments:
+// - wch - the character to translate
+// Return Value:
+// - the bytes it turned into. the second one is 0 if there's only one.
+const CodepageTable::Bytes& CodepageTable::ToBytes(const wchar_t wch)
+{
+    if (_wideToBytes.empty())
+    {
+        _wideToBytes.resize(0x10000);
+        _wideToBytesKnown.resize(0x10000);
+    }
+
+    auto& entry = _wideToBytes.at(wch);
+    if (!_wideToBytesKnown.at(wch))
+    {
+        entry = {};
+        entry.length = gsl::narrow_cast<BYTE>(ConvertToOem(_codepage, &wch, 1, &entry.bytes[0], ARRAYSIZE(entry.bytes)));
+        _wideToBytesKnown.at(wch) = true;
+    }
+
+    return entry;
+}
@@ -0,0 +1,55 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- codepageTable.hpp
+
+Abstract:
+- tables for translating the cells of the screen buffer to and from the output codepage,
+  for the A versions of the cell APIs.
+- every single byte and whether it leads a double byte character is looked up when the
+  codepage is set. the double byte characters, and the bytes each UTF-16 character turns
+  into, are looked up the first time they're seen and kept from then on, so translating a
+  rectangle of cells doesn't call into the system for each cell.
+--*/
+
+#pragma once
+
+class CodepageTable final
+{
+public:
+    // the bytes a UTF-16 character turns into in the codepage.
+    // length is 0 if it can't be translated at all.
+    struct Bytes
+    {
+        CHAR bytes[2];
+        BYTE length;
+    };
+
+    CodepageTable() noexcept;
+
+    void Reset(const UINT codepage);
+
+    UINT GetCodepage() const noexcept;
+
+    bool IsLeadByte(const CHAR ch) const noexcept;
+    wchar_t ToWide(const CHAR ch) const noexcept;
+    wchar_t ToWide(const CHAR lead, const CHAR trail);
+    const Bytes& ToBytes(const wchar_t wch);
+
+private:
+    UINT _codepage;
+    std::array<bool, 256> _leadBytes;
+    std::array<wchar_t, 256> _singleBytes;
+
+    // indexed by the lead byte and the trail byte together. an entry is 0 until it's looked up,
+    // after which it holds the character with KnownFlag set.
+    std::vector<uint32_t> _doubleBytes;
+
+    // indexed by UTF-16 character, and likewise looked up as they're needed.
+    std::vector<Bytes> _wideToBytes;
+    std::vector<bool> _wideToBytesKnown;
+
+    static constexpr uint32_t KnownFlag = 0x10000;
+};
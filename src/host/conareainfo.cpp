@@ -116,6 +116,87 @@ void ConversionAreaInfo::WriteText(const std::vector<OutputCell>& text,
     _screenBuffer->Write(view, { column, 0 });
 }
 
+// Routine Description:
+// - Shows new text in the conversion area at the given place. If the area is already showing
+//   on the same line, only the columns that look different than before are repainted.
+// Arguments:
+// - text - Text to show in the conversion area, starting at the left edge of the window
+// - window - The part of the conversion area buffer to show. Conversion areas are only one line.
+// - viewPos - Where the conversion area buffer sits relative to the viewport
+void ConversionAreaInfo::Update(const std::vector<OutputCell>& text, const SMALL_RECT window, const COORD viewPos)
+{
+    // Showing up or moving to another place needs the old and the new place painted in full.
+    if (IsHidden() || viewPos.X != _caInfo.coordConView.X || viewPos.Y != _caInfo.coordConView.Y)
+    {
+        if (!IsHidden())
+        {
+            SetHidden(true);
+            Paint();
+        }
+
+        WriteText(text, window.Left);
+        SetWindowInfo(window);
+        SetViewPos(viewPos);
+        SetHidden(false);
+        Paint();
+        return;
+    }
+
+    // Find the leftmost and rightmost columns that change. Columns that only the old
+    // or only the new window covers always change.
+    const SMALL_RECT old = _caInfo.rcViewCaWindow;
+    const SHORT from = std::min(old.Left, window.Left);
+    const SHORT to = std::max(old.Right, window.Right);
+    SHORT first = gsl::narrow_cast<SHORT>(to + 1);
+    SHORT last = gsl::narrow_cast<SHORT>(from - 1);
+
+    auto it = GetTextBuffer().GetCellDataAt({ from, 0 });
+    for (SHORT col = from; col <= to; col++)
+    {
+        const bool inOld = col >= old.Left && col <= old.Right;
+        const bool inNew = col >= window.Left && col <= window.Right;
+
+        bool changed = inOld != inNew;
+        if (inOld && inNew && it)
+        {
+            const auto& cell = text.at(col - window.Left);
+            changed = it->Chars() != cell.Chars() ||
+                      !(it->DbcsAttr() == cell.DbcsAttr()) ||
+                      it->TextAttr() != cell.TextAttr();
+        }
+
+        if (changed)
+        {
+            first = std::min(first, col);
+            last = std::max(last, col);
+        }
+
+        if (it)
+        {
+            it++;
+        }
+    }
+
+    WriteText(text, window.Left);
+    _caInfo.rcViewCaWindow = window;
+
+    if (first <= last)
+    {
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& ScreenInfo = gci.GetActiveOutputBuffer();
+        const auto viewport = ScreenInfo.GetViewport();
+
+        SMALL_RECT ChangedRegion;
+        ChangedRegion.Left = viewport.Left() + _caInfo.coordConView.X + first;
+        ChangedRegion.Right = viewport.Left() + _caInfo.coordConView.X + last;
+        ChangedRegion.Top = viewport.Top() + _caInfo.coordConView.Y + window.Top;
+        ChangedRegion.Bottom = ChangedRegion.Top;
+
+        // This repaints the main buffer underneath along with the conversion areas on top of it.
+        WriteToScreen(ScreenInfo, Viewport::FromInclusive(ChangedRegion));
+    }
+}
+
 // Routine Description:
 // - Clears out a conversion area
 void ConversionAreaInfo::ClearArea() noexcept
@@ -62,6 +62,7 @@ public:
     void Paint() const noexcept;
 
     void WriteText(const std::vector<OutputCell>& text, const SHORT column);
+    void Update(const std::vector<OutputCell>& text, const SMALL_RECT window, const COORD viewPos);
     void SetAttributes(const TextAttribute& attr);
 
     const TextBuffer& GetTextBuffer() const noexcept;
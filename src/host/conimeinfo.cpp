@@ -63,7 +63,8 @@ void ConsoleImeInfo::WriteCompMessage(const std::wstring_view text,
     // Backup the cursor visibility state and turn it off for drawing.
     _SaveCursorVisibility();
 
-    ClearAllAreas();
+    // The conversion areas aren't cleared first. They're updated in place below so that
+    // only the cells that changed since the last composition message get painted again.
 
     // Save copies of the composition message in case we need to redraw it as things scroll/resize
     _text = text;
@@ -226,14 +227,10 @@ std::vector<OutputCell> ConsoleImeInfo::s_ConvertToCells(const std::wstring_view
 {
     std::vector<OutputCell> cells;
 
-    // - Convert incoming wchar_t stream into UTF-16 units.
-    const auto glyphs = Utf16Parser::Parse(text);
-
-    // - Walk through all of the grouped up text, match up the correct attribute to it, and make a new cell.
+    // - Walk through the incoming wchar_t stream a glyph at a time, match up the correct attribute to it, and make a new cell.
     size_t attributesUsed = 0;
-    for (const auto& parsedGlyph : glyphs)
+    for (const auto glyph : Utf16Parser::Glyphs(text))
     {
-        const std::wstring_view glyph{ parsedGlyph.data(), parsedGlyph.size() };
         // Collect up attributes that apply to this glyph range.
         auto drawingAttr = s_RetrieveAttributeAt(attributesUsed, attributes, colorArray);
         attributesUsed++;
@@ -301,6 +298,7 @@ std::vector<OutputCell> ConsoleImeInfo::s_ConvertToCells(const std::wstring_view
 //       - Updated to set up the next conversion area down a line (and to the left viewport edge)
 // - view - The rectangle representing the viewable area of the screen right now to let us know how many cells can fit.
 // - screenInfo - A reference to the screen information we will use for accessibility notifications
+// - index - Which conversion area holds this line. Areas left over from the last composition are reused.
 // Return Value:
 // - Updated begin position for the next call. It will normally be >begin and <= end.
 //   However, if text couldn't fit in our line (full-width character starting at the very last cell)
@@ -310,7 +308,8 @@ std::vector<OutputCell>::const_iterator ConsoleImeInfo::_WriteConversionArea(con
                                                                              const std::vector<OutputCell>::const_iterator end,
                                                                              COORD& pos,
                                                                              const Microsoft::Console::Types::Viewport view,
-                                                                             SCREEN_INFORMATION& screenInfo)
+                                                                             SCREEN_INFORMATION& screenInfo,
+                                                                             const size_t index)
 {
     // The position in the viewport where we will start inserting cells for this conversion area
     // NOTE: We might exit early if there's not enough space to fit here, so we take a copy of
@@ -354,24 +353,19 @@ std::vector<OutputCell>::const_iterator ConsoleImeInfo::_WriteConversionArea(con
     // Copy out the substring into a vector.
     const std::vector<OutputCell> lineVec(lineBegin, lineEnd);
 
-    // Add a conversion area to the internal state to hold this line.
-    THROW_IF_FAILED(_AddConversionArea());
-
-    // Get the added conversion area.
-    auto& area = ConvAreaCompStr.back();
+    // Add a conversion area to the internal state to hold this line if there isn't one to reuse.
+    if (index >= ConvAreaCompStr.size())
+    {
+        THROW_IF_FAILED(_AddConversionArea());
+    }
 
-    // Write our text into the conversion area.
-    area.WriteText(lineVec, insertionPos.X);
+    auto& area = ConvAreaCompStr.at(index);
 
     // Set the viewport and positioning parameters for the conversion area to describe to the renderer
     // the appropriate location to overlay this conversion area on top of the main screen buffer inside the viewport.
+    // Then write our text into the conversion area, make it visible and paint what changed.
     const SMALL_RECT region{ insertionPos.X, 0, gsl::narrow<SHORT>(insertionPos.X + lineVec.size() - 1), 0 };
-    area.SetWindowInfo(region);
-    area.SetViewPos({ 0 - view.Left(), insertionPos.Y - view.Top() });
-
-    // Make it visible and paint it.
-    area.SetHidden(false);
-    area.Paint();
+    area.Update(lineVec, region, { 0 - view.Left(), insertionPos.Y - view.Top() });
 
     // Notify accessibility that we have updated the text in this display region within the viewport.
     screenInfo.NotifyAccessibilityEventing(insertionPos.X, insertionPos.Y, gsl::narrow<SHORT>(insertionPos.X + lineVec.size() - 1), insertionPos.Y);
@@ -400,14 +394,24 @@ void ConsoleImeInfo::_WriteUndeterminedChars(const std::wstring_view text,
     // Ensure cursor is visible for prompt line
     screenInfo.MakeCurrentCursorVisible();
 
-    // Clear out existing conversion areas.
-    ConvAreaCompStr.clear();
-
     // If the text length and attribute length don't match,
     // it's a programming error on our part. We control the sizes here.
     FAIL_FAST_IF(text.size() != attributes.size());
 
-    // If we have no text, return. We've already cleared above.
+    // Whichever conversion areas the text doesn't need this time get hidden at the end.
+    size_t areasUsed = 0;
+    auto hideUnused = wil::scope_exit([&] {
+        for (size_t i = areasUsed; i < ConvAreaCompStr.size(); i++)
+        {
+            auto& area = ConvAreaCompStr.at(i);
+            if (!area.IsHidden())
+            {
+                area.ClearArea();
+            }
+        }
+    });
+
+    // If we have no text, return. The existing conversion areas are hidden on the way out.
     if (text.empty())
     {
         return;
@@ -432,7 +436,8 @@ void ConsoleImeInfo::_WriteUndeterminedChars(const std::wstring_view text,
     // Write over and over updating the beginning iterator until we reach the end.
     do
     {
-        begin = _WriteConversionArea(begin, end, pos, view, screenInfo);
+        begin = _WriteConversionArea(begin, end, pos, view, screenInfo, areasUsed);
+        areasUsed++;
     } while (begin < end);
 }
 
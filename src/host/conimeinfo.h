@@ -78,7 +78,8 @@ private:
                                                                  const std::vector<OutputCell>::const_iterator end,
                                                                  COORD& pos,
                                                                  const Microsoft::Console::Types::Viewport view,
-                                                                 SCREEN_INFORMATION& screenInfo);
+                                                                 SCREEN_INFORMATION& screenInfo,
+                                                                 const size_t index);
 
     void _SaveCursorVisibility();
     void _RestoreCursorVisibility();
@@ -9,9 +9,14 @@
 #include "srvinit.h"
 
 #include "..\interactivity\inc\ServiceLocator.hpp"
+#include "..\server\ApiStatistics.h"
 #include "..\types\inc\convert.hpp"
+#include "..\types\inc\LockProfiler.hpp"
+
+#include <intrin.h>
 
 using Microsoft::Console::Interactivity::ServiceLocator;
+using Microsoft::Console::Types::LockProfiler;
 using Microsoft::Console::VirtualTerminal::VtIo;
 
 CONSOLE_INFORMATION::CONSOLE_INFORMATION() :
@@ -20,6 +25,9 @@ CONSOLE_INFORMATION::CONSOLE_INFORMATION() :
     pCurrentScreenBuffer(nullptr),
     ScreenBuffers(nullptr),
     OutputQueue(),
+    PendingWrites(),
+    PendingWritesLength(0),
+    PendingWritesOverflowed(false),
     // ExeAliasList initialized below
     _OriginalTitle(),
     _Title(),
@@ -34,8 +42,10 @@ CONSOLE_INFORMATION::CONSOLE_INFORMATION() :
     // CPInfo initialized below
     // OutputCPInfo initialized below
     _cookedReadData(nullptr),
+    _lockCallSite(nullptr),
+    _lockAcquired(0),
     ConsoleIme{},
-    terminalMouseInput(HandleTerminalKeyEventCallback),
+    terminalMouseInput(HandleTerminalMouseEventCallback),
     _vtIo(),
     _blinker{},
     renderData{}
@@ -57,24 +67,84 @@ bool CONSOLE_INFORMATION::IsConsoleLocked() const
     return _csConsoleLock.OwningThread == (HANDLE)GetCurrentThreadId();
 }
 
+// Routine Description:
+// - Takes the console lock, waiting for it if another thread has it.
+// - While the LockProfiler is measuring, the outermost hold is timed and counted
+//   as taken from the given place. The lock is recursive, so inner holds aren't.
+// Arguments:
+// - callSite - Where the lock was taken from, or nullptr for the caller of this.
+// Return Value:
+// - <none>
 #pragma prefast(suppress : 26135, "Adding lock annotation spills into entire project. Future work.")
-void CONSOLE_INFORMATION::LockConsole()
+void CONSOLE_INFORMATION::LockConsole(const void* const callSite)
 {
-    EnterCriticalSection(&_csConsoleLock);
+    // Only time the wait when there is one, so that taking a free lock stays cheap.
+    LONGLONG waitTicks = 0;
+    const bool contended = !TryEnterCriticalSection(&_csConsoleLock);
+    if (contended)
+    {
+        const auto start = ApiStatistics::s_Now();
+        EnterCriticalSection(&_csConsoleLock);
+        waitTicks = ApiStatistics::s_Now() - start;
+        ApiStatistics::s_AddLockWait(waitTicks);
+    }
+
+    if (_csConsoleLock.RecursionCount == 1)
+    {
+        _BeginProfiledHold(callSite ? callSite : _ReturnAddress(), waitTicks, contended);
+    }
 }
 
 #pragma prefast(suppress : 26135, "Adding lock annotation spills into entire project. Future work.")
 bool CONSOLE_INFORMATION::TryLockConsole()
 {
-    return !!TryEnterCriticalSection(&_csConsoleLock);
+    if (!TryEnterCriticalSection(&_csConsoleLock))
+    {
+        return false;
+    }
+
+    if (_csConsoleLock.RecursionCount == 1)
+    {
+        _BeginProfiledHold(_ReturnAddress(), 0, false);
+    }
+    return true;
 }
 
 #pragma prefast(suppress : 26135, "Adding lock annotation spills into entire project. Future work.")
 void CONSOLE_INFORMATION::UnlockConsole()
 {
+    // The hold is over once the outermost one lets go. It's recorded while the lock is
+    // still held, since only the owner may touch what was kept about it.
+    if (_lockAcquired != 0 && _csConsoleLock.RecursionCount == 1)
+    {
+        const auto holdTicks = LockProfiler::s_Now() - _lockAcquired;
+        _lockAcquired = 0;
+        LockProfiler::Instance().RecordRelease(LockProfiler::Lock::Console, _lockCallSite, holdTicks);
+    }
+
     LeaveCriticalSection(&_csConsoleLock);
 }
 
+// Routine Description:
+// - Starts timing the outermost hold of the console lock if the LockProfiler is measuring.
+// - Called by the thread that just took the lock.
+// Arguments:
+// - callSite - Where the lock was taken from.
+// - waitTicks - How long it was waited for, in performance counter ticks.
+// - contended - Whether another thread had it, so that it had to be waited for.
+// Return Value:
+// - <none>
+void CONSOLE_INFORMATION::_BeginProfiledHold(const void* const callSite, const LONGLONG waitTicks, const bool contended) noexcept
+{
+    auto& profiler = LockProfiler::Instance();
+    if (profiler.IsEnabled())
+    {
+        _lockCallSite = callSite;
+        _lockAcquired = LockProfiler::s_Now();
+        profiler.RecordAcquire(LockProfiler::Lock::Console, callSite, waitTicks, contended);
+    }
+}
+
 ULONG CONSOLE_INFORMATION::GetCSRecursionCount()
 {
     return _csConsoleLock.RecursionCount;
@@ -181,15 +251,16 @@ void CONSOLE_INFORMATION::SetCookedReadData(COOKED_READ_DATA* readData) noexcept
 }
 
 // Routine Description:
-// - Handler for inserting key sequences into the buffer when the terminal emulation layer
-//   has determined a key can be converted appropriately into a sequence of inputs
+// - Handler for inserting mouse sequences into the buffer when the terminal emulation layer
+//   has converted a mouse event into one. Mouse sequences are only sent in VT input mode,
+//   so the sequence is written as text, a key down for each character.
 // Arguments:
-// - events - the input events to write to the input buffer
+// - text - the sequence to write to the input buffer
 // Return Value:
 // - <none>
-void CONSOLE_INFORMATION::HandleTerminalKeyEventCallback(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& events)
+void CONSOLE_INFORMATION::HandleTerminalMouseEventCallback(const std::wstring_view text)
 {
-    ServiceLocator::LocateGlobals().getConsoleInformation().pInputBuffer->Write(events);
+    ServiceLocator::LocateGlobals().getConsoleInformation().pInputBuffer->WriteText(text);
 }
 
 // Method Description:
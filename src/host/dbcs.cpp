@@ -59,40 +59,28 @@ DWORD UnicodeRasterFontCellMungeOnRead(const gsl::span<CHAR_INFO> buffer)
 {
     // Walk through the source CHAR_INFO and copy each to the destination.
     // EXCEPT for trailing bytes (this will de-duplicate the leading/trailing byte double copies of the CHAR_INFOs as stored in the buffer).
+    // The whole rectangle is walked in one pass over plain pointers; most of it is copied onto itself.
+    CHAR_INFO* const begin = buffer.data();
+    CHAR_INFO* const end = begin + buffer.size();
+    CHAR_INFO* dst = begin;
 
-    // Set up indices used for arrays.
-    DWORD iDst = 0;
-
-    // Walk through every CHAR_INFO
-    for (DWORD iSrc = 0; iSrc < gsl::narrow<size_t>(buffer.size()); iSrc++)
+    for (const CHAR_INFO* src = begin; src < end; ++src)
     {
         // If it's not a trailing byte, copy it straight over, stripping out the Leading/Trailing flags from the attributes field.
-        if (!WI_IsFlagSet(buffer.at(iSrc).Attributes, COMMON_LVB_TRAILING_BYTE))
+        // If it was a trailing byte, we'll just walk past it and keep going.
+        if (WI_IsFlagClear(src->Attributes, COMMON_LVB_TRAILING_BYTE))
         {
-            buffer.at(iDst) = buffer.at(iSrc);
-            WI_ClearAllFlags(buffer.at(iDst).Attributes, COMMON_LVB_SBCSDBCS);
-            iDst++;
+            *dst = *src;
+            WI_ClearAllFlags(dst->Attributes, COMMON_LVB_SBCSDBCS);
+            ++dst;
         }
-
-        // If it was a trailing byte, we'll just walk past it and keep going.
     }
 
     // Zero out the remaining part of the destination buffer that we didn't use.
-    DWORD const cchDstToClear = gsl::narrow<DWORD>(buffer.size()) - iDst;
-
-    if (cchDstToClear > 0)
-    {
-        CHAR_INFO* const pciDstClearStart = buffer.data() + iDst;
-        ZeroMemory(pciDstClearStart, cchDstToClear * sizeof(CHAR_INFO));
-    }
-
-    // Add the additional length we just modified.
-    iDst += cchDstToClear;
-
-    // now that we're done, we should have copied, left alone, or cleared the entire length.
-    FAIL_FAST_IF(!(iDst == gsl::narrow<size_t>(buffer.size())));
+    std::fill(dst, end, CHAR_INFO{});
 
-    return iDst;
+    // now that we're done, we've copied, left alone, or cleared the entire length.
+    return gsl::narrow<DWORD>(buffer.size());
 }
 
 // Routine Description:
@@ -6,6 +6,7 @@
 #include "directio.h"
 
 #include "_output.h"
+#include "_stream.h"
 #include "output.h"
 #include "input.h"
 #include "dbcs.h"
@@ -507,9 +508,17 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 
     try
     {
-        auto events = IInputEvent::Create(buffer);
+        // The records are stored as they are, so there's no need to make an event of each one first.
+        if (append)
+        {
+            written = context.Write(buffer);
+        }
+        else
+        {
+            written = context.Prepend(buffer);
+        }
 
-        return _WriteConsoleInputWImplHelper(context, events, written, append);
+        return S_OK;
     }
     CATCH_RETURN();
 }
@@ -579,21 +588,21 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 // - This is used when the app is reading output as cells and needs them converted
 //   into a particular codepage on the way out.
 // Arguments:
-// - codepage - The relevant codepage for translation
+// - table - The translation table of the relevant codepage
 // - buffer - This is the buffer containing all of the character data to be converted
 // - rectangle - This is the rectangle describing the region that the buffer covers.
 // Return Value:
 // - Generally S_OK. Could be a memory or math error code.
-[[nodiscard]] static HRESULT _ConvertCellsToAInplace(const UINT codepage,
+[[nodiscard]] static HRESULT _ConvertCellsToAInplace(CodepageTable& table,
                                                      const gsl::span<CHAR_INFO> buffer,
                                                      const Viewport rectangle) noexcept
 {
     try
     {
-        std::vector<CHAR_INFO> tempBuffer(buffer.cbegin(), buffer.cend());
-
+        // Each cell is read before anything is written to it, and it's written no further
+        // along than it's read, so the cells can be converted right where they are.
         const auto size = rectangle.Dimensions();
-        auto tempIter = tempBuffer.cbegin();
+        auto tempIter = buffer.begin();
         auto outIter = buffer.begin();
 
         for (int i = 0; i < size.Y; i++)
@@ -612,17 +621,14 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
                         j++;
 
                         // Try to convert the unicode character (2 bytes) in the leading cell to the codepage.
-                        CHAR AsciiDbcs[2] = { 0 };
-                        UINT NumBytes = gsl::narrow<UINT>(sizeof(AsciiDbcs));
-                        NumBytes = ConvertToOem(codepage, &tempIter->Char.UnicodeChar, 1, &AsciiDbcs[0], NumBytes);
+                        const auto& AsciiDbcs = table.ToBytes(tempIter->Char.UnicodeChar);
 
                         // Fill the 1 byte (AsciiChar) portion of the leading and trailing cells with each of the bytes returned.
-                        outIter->Char.AsciiChar = AsciiDbcs[0];
-                        outIter->Attributes = tempIter->Attributes;
+                        // The cells are the same ones, so their attributes are already in place.
+                        outIter->Char.AsciiChar = AsciiDbcs.bytes[0];
                         outIter++;
                         tempIter++;
-                        outIter->Char.AsciiChar = AsciiDbcs[1];
-                        outIter->Attributes = tempIter->Attributes;
+                        outIter->Char.AsciiChar = AsciiDbcs.bytes[1];
                         outIter++;
                         tempIter++;
                     }
@@ -631,7 +637,6 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
                         // When we're in the last column with only a leading byte, we can't return that without a trailing.
                         // Instead, replace the output data with just a space and clear all flags.
                         outIter->Char.AsciiChar = UNICODE_SPACE;
-                        outIter->Attributes = tempIter->Attributes;
                         WI_ClearAllFlags(outIter->Attributes, COMMON_LVB_SBCSDBCS);
                         outIter++;
                         tempIter++;
@@ -640,9 +645,12 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
                 else if (WI_AreAllFlagsClear(tempIter->Attributes, COMMON_LVB_SBCSDBCS))
                 {
                     // If there are no leading/trailing pair flags, then we only have 1 ascii byte to try to fit the
-                    // 2 byte UTF-16 character into. Give it a go.
-                    ConvertToOem(codepage, &tempIter->Char.UnicodeChar, 1, &outIter->Char.AsciiChar, 1);
-                    outIter->Attributes = tempIter->Attributes;
+                    // 2 byte UTF-16 character into. Give it a go: anything that takes more than that is left as it was.
+                    const auto& bytes = table.ToBytes(tempIter->Char.UnicodeChar);
+                    if (bytes.length == 1)
+                    {
+                        outIter->Char.AsciiChar = bytes.bytes[0];
+                    }
                     outIter++;
                     tempIter++;
                 }
@@ -658,19 +666,17 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 // - This is used when the app writes oem to the output buffer we want
 //   UnicodeOem or Unicode in the buffer, depending on font
 // Arguments:
-// - codepage - The relevant codepage for translation
+// - table - The translation table of the relevant codepage
 // - buffer - This is the buffer containing all of the character data to be converted
 // - rectangle - This is the rectangle describing the region that the buffer covers.
 // Return Value:
 // - Generally S_OK. Could be a memory or math error code.
-[[nodiscard]] static HRESULT _ConvertCellsToWInplace(const UINT codepage,
+[[nodiscard]] static HRESULT _ConvertCellsToWInplace(CodepageTable& table,
                                                      gsl::span<CHAR_INFO> buffer,
                                                      const Viewport& rectangle) noexcept
 {
     try
     {
-        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-
         const auto size = rectangle.Dimensions();
         auto outIter = buffer.begin();
 
@@ -682,7 +688,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
                 WI_ClearAllFlags(outIter->Attributes, COMMON_LVB_SBCSDBCS);
 
                 // If the 1 byte given is a lead in this codepage, we likely need two cells for the width.
-                if (IsDBCSLeadByteConsole(outIter->Char.AsciiChar, &gci.OutputCPInfo))
+                if (table.IsLeadByte(outIter->Char.AsciiChar))
                 {
                     // If we're not on the last column, we have two cells to use.
                     if (j < size.X - 1)
@@ -690,17 +696,9 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
                         // Mark we're consuming two cells.
                         j++;
 
-                        // Grab the lead/trailing byte pair from this cell and the next one forward.
-                        CHAR AsciiDbcs[2];
-                        AsciiDbcs[0] = outIter->Char.AsciiChar;
-                        AsciiDbcs[1] = (outIter + 1)->Char.AsciiChar;
-
-                        // Convert it to UTF-16.
-                        WCHAR UnicodeDbcs[2];
-                        ConvertOutputToUnicode(codepage, &AsciiDbcs[0], 2, &UnicodeDbcs[0], 2);
-
-                        // Store the actual character in the first available position.
-                        outIter->Char.UnicodeChar = UnicodeDbcs[0];
+                        // Convert the lead/trailing byte pair from this cell and the next one forward to UTF-16,
+                        // and store the actual character in the first available position.
+                        outIter->Char.UnicodeChar = table.ToWide(outIter->Char.AsciiChar, (outIter + 1)->Char.AsciiChar);
                         WI_ClearAllFlags(outIter->Attributes, COMMON_LVB_SBCSDBCS);
                         WI_SetFlag(outIter->Attributes, COMMON_LVB_LEADING_BYTE);
                         outIter++;
@@ -722,9 +720,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
                 else
                 {
                     // If it's not detected as a lead byte of a pair, then just convert it in place and move on.
-                    CHAR c = outIter->Char.AsciiChar;
-
-                    ConvertOutputToUnicode(codepage, &c, 1, &outIter->Char.UnicodeChar, 1);
+                    outIter->Char.UnicodeChar = table.ToWide(outIter->Char.AsciiChar);
                     outIter++;
                 }
             }
@@ -841,40 +837,29 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
         // We will start reading the buffer at the point of the top left corner (origin) of the (potentially adjusted) request
         const auto sourcePoint = clippedRequestRectangle.Origin();
 
-        // Get an iterator to the beginning of the return buffer
-        // We might have to seek this forward or skip around if we clipped the request.
-        auto targetIter = targetBuffer.begin();
-        COORD targetPos = { 0 };
-        const auto targetLimit = Viewport::FromDimensions(targetPoint, clippedRequestRectangle.Dimensions());
-
-        // Get an iterator to the beginning of the request inside the screen buffer
-        // This should walk exactly along every cell of the clipped request.
-        auto sourceIter = storageBuffer.GetCellDataAt(sourcePoint, clippedRequestRectangle);
-
-        // Walk through every cell of the target, advancing the buffer.
-        // Validate that we always still have a valid iterator to the backing store,
-        // that we always are writing inside the user's buffer (before the end)
-        // and we're always targeting the user's buffer inside its original bounds.
-        while (sourceIter && targetIter < targetBuffer.end())
+        // Copy the clipped request a row at a time, straight into the part of the user's buffer each row goes to.
+        // Cells of the user's buffer outside the clipped request are left alone.
+        for (SHORT row = 0; row < clippedRequestRectangle.Height(); row++)
         {
-            // If the point we're trying to write is inside the limited buffer write zone...
-            if (targetLimit.IsInBounds(targetPos))
+            // Find where this row starts in the user's buffer, and stop once it's past the end.
+            ptrdiff_t targetIndex = 0;
+            RETURN_IF_FAILED(PtrdiffTMult(targetPoint.Y + row, targetSize.X, &targetIndex));
+            RETURN_IF_FAILED(PtrdiffTAdd(targetIndex, targetPoint.X, &targetIndex));
+            if (targetIndex >= targetBuffer.size())
             {
-                // Copy the data into position...
-                *targetIter = gci.AsCharInfo(*sourceIter);
-                // ... and advance the read iterator.
-                sourceIter++;
+                break;
             }
 
-            // Always advance the write iterator, we might have skipped it due to clipping.
-            targetIter++;
+            const auto targetRow = targetBuffer.subspan(targetIndex, std::min<ptrdiff_t>(clippedRequestRectangle.Width(), targetBuffer.size() - targetIndex));
+
+            // Get an iterator that walks exactly along the cells of this row of the clipped request.
+            const COORD sourceRowPoint = { sourcePoint.X, gsl::narrow_cast<SHORT>(sourcePoint.Y + row) };
+            const auto sourceRow = Viewport::FromDimensions(sourceRowPoint, { clippedRequestRectangle.Width(), 1 });
+            auto sourceIter = storageBuffer.GetCellDataAt(sourceRowPoint, sourceRow);
 
-            // Increment the target
-            targetPos.X++;
-            if (targetPos.X >= targetSize.X)
+            for (auto targetIter = targetRow.begin(); sourceIter && targetIter < targetRow.end(); ++targetIter, ++sourceIter)
             {
-                targetPos.X = 0;
-                targetPos.Y++;
+                *targetIter = gci.AsCharInfo(*sourceIter);
             }
         }
 
@@ -896,12 +881,11 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 
     try
     {
-        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-        const auto codepage = gci.OutputCP;
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
 
         RETURN_IF_FAILED(_ReadConsoleOutputWImplHelper(context, buffer, sourceRectangle, readRectangle));
 
-        LOG_IF_FAILED(_ConvertCellsToAInplace(codepage, buffer, readRectangle));
+        LOG_IF_FAILED(_ConvertCellsToAInplace(gci.OutputCPTable, buffer, readRectangle));
 
         return S_OK;
     }
@@ -1001,34 +985,26 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 
         const auto writeRectangle = Viewport::FromInclusive(writeRegion);
 
-        auto target = writeRectangle.Origin();
-
-        // For every row in the request, create a view into the clamped portion of just the one line to write.
+        // Find where the clamped portion starts in the original buffer, by the dimensions of the original request rectangle.
+        // Every row of it after that is one request row further along.
         // This allows us to restrict the width of the call without allocating/copying any memory by just making
         // a smaller view over the existing big blob of data from the original call.
-        for (; target.Y < writeRectangle.BottomExclusive(); target.Y++)
-        {
-            // We find the offset into the original buffer by the dimensions of the original request rectangle.
-            ptrdiff_t rowOffset = 0;
-            RETURN_IF_FAILED(PtrdiffTSub(target.Y, requestRectangle.Top(), &rowOffset));
-            RETURN_IF_FAILED(PtrdiffTMult(rowOffset, requestRectangle.Width(), &rowOffset));
-
-            ptrdiff_t colOffset = 0;
-            RETURN_IF_FAILED(PtrdiffTSub(target.X, requestRectangle.Left(), &colOffset));
+        ptrdiff_t rowOffset = 0;
+        RETURN_IF_FAILED(PtrdiffTMult(sourceRect.Top, requestRectangle.Width(), &rowOffset));
 
-            ptrdiff_t totalOffset = 0;
-            RETURN_IF_FAILED(PtrdiffTAdd(rowOffset, colOffset, &totalOffset));
+        ptrdiff_t totalOffset = 0;
+        RETURN_IF_FAILED(PtrdiffTAdd(rowOffset, sourceRect.Left, &totalOffset));
 
-            // Now we make a subspan starting from that offset for as much of the original request as would fit
-            const auto subspan = buffer.subspan(totalOffset, writeRectangle.Width());
+        const ptrdiff_t stride = requestRectangle.Width();
+        ptrdiff_t length = 0;
+        RETURN_IF_FAILED(PtrdiffTMult(writeRectangle.Height() - 1, stride, &length));
+        RETURN_IF_FAILED(PtrdiffTAdd(length, writeRectangle.Width(), &length));
 
-            // Convert to a CHAR_INFO view to fit into the iterator
-            const auto charInfos = std::basic_string_view<CHAR_INFO>(subspan.data(), subspan.size());
+        const auto subspan = buffer.subspan(totalOffset, length);
+        const auto charInfos = std::basic_string_view<CHAR_INFO>(subspan.data(), subspan.size());
 
-            // Make the iterator and write to the target position.
-            OutputCellIterator it(charInfos);
-            storageBuffer.Write(it, target);
-        }
+        // Write all of the rows at once, so that they're repainted together.
+        storageBuffer.GetTextBuffer().WriteRect(charInfos, gsl::narrow<size_t>(stride), writeRectangle);
 
         // Since we've managed to write part of the request, return the clamped part that we actually used.
         writtenRectangle = writeRectangle;
@@ -1045,12 +1021,12 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 {
     LockConsole();
     auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+    FlushPendingWrites();
 
     try
     {
-        const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-        const auto codepage = gci.OutputCP;
-        LOG_IF_FAILED(_ConvertCellsToWInplace(codepage, buffer, requestRectangle));
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        LOG_IF_FAILED(_ConvertCellsToWInplace(gci.OutputCPTable, buffer, requestRectangle));
 
         RETURN_IF_FAILED(_WriteConsoleOutputWImplHelper(context, buffer, requestRectangle, writtenRectangle));
 
@@ -1066,6 +1042,7 @@ void EventsToUnicode(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
 {
     LockConsole();
     auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+    FlushPendingWrites();
 
     try
     {
@@ -87,10 +87,9 @@ void ApiRoutines::GetConsoleOutputModeImpl(SCREEN_INFORMATION& context, ULONG& m
 {
     try
     {
-        LockConsole();
-        auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
-
-        const auto readyEventCount = context.GetNumberOfReadyEvents();
+        // This is polled constantly by some clients, so it's answered from
+        // the count the input buffer publishes instead of taking the lock.
+        const auto readyEventCount = context.PeekNumberOfReadyEvents();
         RETURN_IF_FAILED(SizeTToULong(readyEventCount, &events));
 
         return S_OK;
@@ -388,6 +387,7 @@ void ApiRoutines::GetNumberOfConsoleMouseButtonsImpl(ULONG& buttons) noexcept
         CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
         LockConsole();
         auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        FlushPendingWrites();
 
         // Flags we don't understand are invalid.
         RETURN_HR_IF(E_INVALIDARG, WI_IsAnyFlagSet(mode, ~OUTPUT_MODES));
@@ -445,6 +445,7 @@ void ApiRoutines::SetConsoleActiveScreenBufferImpl(SCREEN_INFORMATION& newContex
     {
         LockConsole();
         auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        FlushPendingWrites();
 
         SetActiveScreenBuffer(newContext.GetActiveBuffer());
     }
@@ -501,6 +502,7 @@ void ApiRoutines::GetLargestConsoleWindowSizeImpl(const SCREEN_INFORMATION& cont
     {
         LockConsole();
         auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        FlushPendingWrites();
 
         SCREEN_INFORMATION& screenInfo = context.GetActiveBuffer();
 
@@ -554,6 +556,7 @@ void ApiRoutines::GetLargestConsoleWindowSizeImpl(const SCREEN_INFORMATION& cont
 
         LockConsole();
         auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        FlushPendingWrites();
 
         Globals& g = ServiceLocator::LocateGlobals();
         CONSOLE_INFORMATION& gci = g.getConsoleInformation();
@@ -629,6 +632,7 @@ void ApiRoutines::GetLargestConsoleWindowSizeImpl(const SCREEN_INFORMATION& cont
     {
         LockConsole();
         auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        FlushPendingWrites();
 
         CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
 
@@ -641,7 +645,13 @@ void ApiRoutines::GetLargestConsoleWindowSizeImpl(const SCREEN_INFORMATION& cont
         // clang-format on
 
         // MSFT: 15813316 - Try to use this SetCursorPosition call to inherit the cursor position.
-        RETURN_IF_FAILED(gci.GetVtIo()->SetCursorPosition(position));
+        // If the position came too late to be inherited, leave the cursor where the client has put it since.
+        const HRESULT hrInherit = gci.GetVtIo()->SetCursorPosition(position);
+        RETURN_IF_FAILED(hrInherit);
+        if (hrInherit == S_FALSE)
+        {
+            return S_OK;
+        }
 
         RETURN_IF_NTSTATUS_FAILED(context.SetCursorPosition(position, true));
 
@@ -819,6 +829,7 @@ void ApiRoutines::GetLargestConsoleWindowSizeImpl(const SCREEN_INFORMATION& cont
     {
         LockConsole();
         auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        FlushPendingWrites();
 
         TextAttribute useThisAttr(fillAttribute);
 
@@ -868,6 +879,7 @@ void ApiRoutines::GetLargestConsoleWindowSizeImpl(const SCREEN_INFORMATION& cont
     {
         LockConsole();
         auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
+        FlushPendingWrites();
 
         RETURN_HR_IF(E_INVALIDARG, WI_IsAnyFlagSet(attribute, ~VALID_TEXT_ATTRIBUTES));
 
@@ -1611,6 +1623,29 @@ void DoSrvPrivateEnableAlternateScroll(const bool fEnable)
     gci.terminalMouseInput.EnableAlternateScroll(fEnable);
 }
 
+// Routine Description:
+// - A private API call for beginning or ending a synchronized update, during
+//      which the renderer holds back frames until the app has finished drawing.
+// Parameters:
+// - fEnable - true to begin the update, false to end it.
+// Return value:
+// None
+void DoSrvPrivateEnableSynchronizedUpdate(const bool fEnable)
+{
+    auto* pRender = ServiceLocator::LocateGlobals().pRender;
+    if (pRender)
+    {
+        if (fEnable)
+        {
+            pRender->BeginSynchronizedUpdate();
+        }
+        else
+        {
+            pRender->EndSynchronizedUpdate();
+        }
+    }
+}
+
 // Routine Description:
 // - A private API call for performing a VT-style erase all operation on the buffer.
 //      See SCREEN_INFORMATION::VtEraseAll's description for details.
@@ -1623,6 +1658,52 @@ void DoSrvPrivateEnableAlternateScroll(const bool fEnable)
     return NTSTATUS_FROM_HRESULT(screenInfo.GetActiveBuffer().VtEraseAll());
 }
 
+// Routine Description:
+// - A private API call for filling a rectangle of the buffer with one character and attribute,
+//   as the VT erase operations do, without going through the buffer a line at a time.
+// Parameters:
+// - screenInfo - The screen buffer to fill.
+// - fill - The rectangle to fill, inclusive. It's clipped to the buffer.
+// - wch - The character to fill with.
+// - attribute - The legacy attributes to fill with.
+// Return Value:
+// - S_OK or a suitable HRESULT if the buffer couldn't be filled.
+[[nodiscard]] HRESULT DoSrvPrivateFillRect(SCREEN_INFORMATION& screenInfo,
+                                           const SMALL_RECT& fill,
+                                           const wchar_t wch,
+                                           const WORD attribute)
+{
+    try
+    {
+        auto& buffer = screenInfo.GetActiveBuffer();
+        const auto area = Viewport::Intersect(buffer.GetBufferSize(), Viewport::FromInclusive(fill));
+        if (!area.IsValid())
+        {
+            return S_OK;
+        }
+
+        // Like FillConsoleOutputAttribute, if we're given the legacy version
+        //      of our current attributes, assume that the full version
+        //      (RGB or default colored) was meant.
+        TextAttribute useThisAttr(attribute);
+        if (buffer.InVTMode())
+        {
+            const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+            const auto currentAttributes = buffer.GetAttributes();
+            if (gci.GenerateLegacyAttributes(currentAttributes) == attribute)
+            {
+                useThisAttr = currentAttributes;
+            }
+        }
+
+        buffer.GetTextBuffer().FillRect(area, wch, useThisAttr);
+        buffer.NotifyAccessibilityEventing(area.Left(), area.Top(), area.RightInclusive(), area.BottomInclusive());
+    }
+    CATCH_RETURN();
+
+    return S_OK;
+}
+
 void DoSrvSetCursorStyle(SCREEN_INFORMATION& screenInfo,
                          const CursorType cursorType)
 {
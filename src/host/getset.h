@@ -50,6 +50,7 @@ void DoSrvPrivateEnableSGRExtendedMouseMode(const bool fEnable);
 void DoSrvPrivateEnableButtonEventMouseMode(const bool fEnable);
 void DoSrvPrivateEnableAnyEventMouseMode(const bool fEnable);
 void DoSrvPrivateEnableAlternateScroll(const bool fEnable);
+void DoSrvPrivateEnableSynchronizedUpdate(const bool fEnable);
 
 void DoSrvPrivateSetConsoleXtermTextAttribute(SCREEN_INFORMATION& screenInfo,
                                               const int iXtermTableEntry,
@@ -61,6 +62,10 @@ void DoSrvPrivateSetConsoleRGBTextAttribute(SCREEN_INFORMATION& screenInfo,
 void DoSrvPrivateBoldText(SCREEN_INFORMATION& screenInfo, const bool bolded);
 
 [[nodiscard]] NTSTATUS DoSrvPrivateEraseAll(SCREEN_INFORMATION& screenInfo);
+[[nodiscard]] HRESULT DoSrvPrivateFillRect(SCREEN_INFORMATION& screenInfo,
+                                           const SMALL_RECT& fill,
+                                           const wchar_t wch,
+                                           const WORD attribute);
 
 void DoSrvSetCursorStyle(SCREEN_INFORMATION& screenInfo,
                          const CursorType cursorType);
@@ -6,6 +6,8 @@
 #include "handle.h"
 #include "..\interactivity\inc\ServiceLocator.hpp"
 
+#include <intrin.h>
+
 #pragma hdrstop
 
 using Microsoft::Console::Interactivity::ServiceLocator;
@@ -13,7 +15,8 @@ using Microsoft::Console::Interactivity::ServiceLocator;
 void LockConsole()
 {
     CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-    gci.LockConsole();
+    // Count the lock as taken by whoever called this, rather than from here every time.
+    gci.LockConsole(_ReturnAddress());
 }
 
 void UnlockConsole()
@@ -112,7 +112,7 @@ void CommandHistory::_Reset()
         {
             std::wstring reuse{};
 
-            if (suppressDuplicates)
+            if (suppressDuplicates && _HasCommand(newCommand))
             {
                 SHORT index;
                 if (FindMatchingCommand(newCommand, LastDisplayed, index, CommandHistory::MatchOptions::ExactMatch))
@@ -124,6 +124,7 @@ void CommandHistory::_Reset()
             // find free record.  if all records are used, free the lru one.
             if ((SHORT)_commands.size() == _maxCommands)
             {
+                _UncountCommand(_commands.front());
                 _commands.erase(_commands.cbegin());
                 // move LastDisplayed back one in order to stay synced with the
                 // command it referred to before erasing the lru one
@@ -139,6 +140,7 @@ void CommandHistory::_Reset()
             {
                 _commands.emplace_back(newCommand);
             }
+            _CountCommand(_commands.back());
 
             if (LastDisplayed == -1 ||
                 _commands.at(LastDisplayed).size() != newCommand.size() ||
@@ -249,6 +251,7 @@ std::wstring_view CommandHistory::GetLastCommand() const
 void CommandHistory::Empty()
 {
     _commands.clear();
+    _foldedCommandCounts.clear();
     LastDisplayed = -1;
     Flags = CLE_RESET;
 }
@@ -290,6 +293,7 @@ void CommandHistory::Realloc(const size_t commands)
     {
         _commands.emplace_back(oldCommands[i]);
     }
+    _RecountCommands();
 
     WI_SetFlag(Flags, CLE_RESET);
     LastDisplayed = gsl::narrow<SHORT>(_commands.size()) - 1;
@@ -330,6 +334,20 @@ size_t CommandHistory::s_CountOfHistories()
     return s_historyLists.size();
 }
 
+// Routine Description:
+// - Adds up the memory held by every command history there is.
+// Return Value:
+// - The bytes held, approximately. See GetMemoryUsage.
+size_t CommandHistory::s_GetMemoryUsageOfAll()
+{
+    size_t bytes = 0;
+    for (const auto& historyList : s_historyLists)
+    {
+        bytes += sizeof(CommandHistory) + historyList.GetMemoryUsage();
+    }
+    return bytes;
+}
+
 // Routine Description:
 // - This routine returns the LRU command history buffer, or the command history buffer that corresponds to the app name.
 // Arguments:
@@ -392,6 +410,7 @@ CommandHistory* CommandHistory::s_Allocate(const std::wstring_view appName, cons
         if (!SameApp)
         {
             BestCandidate->_commands.clear();
+            BestCandidate->_foldedCommandCounts.clear();
             BestCandidate->LastDisplayed = -1;
             BestCandidate->_appName = appName;
         }
@@ -410,6 +429,95 @@ size_t CommandHistory::GetNumberOfCommands() const
     return _commands.size();
 }
 
+// Routine Description:
+// - Estimates how many bytes of heap storage this history holds: the commands, the
+//   folded copies counted to find duplicates, and the name of the app.
+// - Strings short enough to be kept inline hold none. The hash map's nodes are counted
+//   as their value and two pointers, which is what they cost in practice.
+// Return Value:
+// - The bytes held, approximately.
+size_t CommandHistory::GetMemoryUsage() const noexcept
+{
+    const auto heapOf = [](const std::wstring& text) noexcept -> size_t {
+        constexpr size_t InlineCapacity = (16 / sizeof(wchar_t)) - 1;
+        return text.capacity() > InlineCapacity ? (text.capacity() + 1) * sizeof(wchar_t) : 0;
+    };
+
+    size_t bytes = _commands.capacity() * sizeof(std::wstring) + heapOf(_appName);
+    for (const auto& command : _commands)
+    {
+        bytes += heapOf(command);
+    }
+
+    bytes += _foldedCommandCounts.bucket_count() * sizeof(void*);
+    for (const auto& [folded, count] : _foldedCommandCounts)
+    {
+        bytes += sizeof(std::pair<const std::wstring, size_t>) + 2 * sizeof(void*) + heapOf(folded);
+    }
+    return bytes;
+}
+
+// Routine Description:
+// - Folds a command to lowercase, so that two commands that only differ in case fold the same.
+// Arguments:
+// - command - the command to fold
+// Return Value:
+// - the folded command
+std::wstring CommandHistory::_Fold(const std::wstring_view command)
+{
+    std::wstring folded{ command };
+    std::transform(folded.begin(), folded.end(), folded.begin(), ::towlower);
+    return folded;
+}
+
+// Routine Description:
+// - Checks if a command is in the history, ignoring case.
+// Arguments:
+// - command - the command to look for
+// Return Value:
+// - true if there's a command that matches it exactly, other than in case.
+bool CommandHistory::_HasCommand(const std::wstring_view command) const
+{
+    return _foldedCommandCounts.find(_Fold(command)) != _foldedCommandCounts.end();
+}
+
+// Routine Description:
+// - Counts a command that has just been stored in _commands.
+// Arguments:
+// - command - the command that was stored
+void CommandHistory::_CountCommand(const std::wstring_view command)
+{
+    ++_foldedCommandCounts[_Fold(command)];
+}
+
+// Routine Description:
+// - Stops counting a command that has been, or is about to be, removed from _commands.
+// Arguments:
+// - command - the command that's removed
+void CommandHistory::_UncountCommand(const std::wstring_view command) noexcept
+{
+    try
+    {
+        const auto found = _foldedCommandCounts.find(_Fold(command));
+        if (found != _foldedCommandCounts.end() && --found->second == 0)
+        {
+            _foldedCommandCounts.erase(found);
+        }
+    }
+    CATCH_LOG();
+}
+
+// Routine Description:
+// - Counts every command in _commands again, from scratch.
+void CommandHistory::_RecountCommands()
+{
+    _foldedCommandCounts.clear();
+    for (const auto& command : _commands)
+    {
+        _CountCommand(command);
+    }
+}
+
 void CommandHistory::_Prev(SHORT& ind) const
 {
     if (ind <= 0)
@@ -490,6 +598,7 @@ std::wstring CommandHistory::Remove(const SHORT iDel)
             }
             _Inc(iFirst);
         }
+        _UncountCommand(str);
 
         LastDisplayed = iDisp;
         return str;
@@ -529,6 +638,11 @@ std::wstring CommandHistory::Remove(const SHORT iDel)
 
     try
     {
+        if (WI_IsFlagSet(options, MatchOptions::ExactMatch) && !_HasCommand(givenCommand))
+        {
+            return false;
+        }
+
         for (size_t i = 0; i < _commands.size(); i++)
         {
             const auto& storedCommand = _commands.at(indexFound);
@@ -26,6 +26,7 @@ public:
     static void s_Free(const HANDLE processHandle);
     static void s_ResizeAll(const size_t commands);
     static size_t s_CountOfHistories();
+    static size_t s_GetMemoryUsageOfAll();
 
     enum class MatchOptions
     {
@@ -58,6 +59,7 @@ public:
                                       size_t& commandSize);
 
     size_t GetNumberOfCommands() const;
+    size_t GetMemoryUsage() const noexcept;
     std::wstring_view GetNth(const SHORT index) const;
 
     void Realloc(const size_t commands);
@@ -83,9 +85,19 @@ private:
     void _Dec(SHORT& ind) const;
     void _Inc(SHORT& ind) const;
 
+    static std::wstring _Fold(const std::wstring_view command);
+    bool _HasCommand(const std::wstring_view command) const;
+    void _CountCommand(const std::wstring_view command);
+    void _UncountCommand(const std::wstring_view command) noexcept;
+    void _RecountCommands();
+
     std::vector<std::wstring> _commands;
     SHORT _maxCommands;
 
+    // How many of _commands there are of each command, ignoring case. This lets
+    // an exact match be ruled out without comparing against every command.
+    std::unordered_map<std::wstring, size_t> _foldedCommandCounts;
+
     std::wstring _appName;
     HANDLE _processHandle;
 
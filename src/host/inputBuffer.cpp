@@ -5,7 +5,9 @@
 #include "inputBuffer.hpp"
 #include "dbcs.h"
 #include "stream.h"
+#include "_stream.h"
 #include "../types/inc/GlyphWidth.hpp"
+#include "../types/inc/AllocationTracking.hpp"
 
 #include <functional>
 
@@ -15,6 +17,8 @@
 
 using Microsoft::Console::Interactivity::ServiceLocator;
 using Microsoft::Console::VirtualTerminal::TerminalInput;
+using Microsoft::Console::Types::AllocationScope;
+using Microsoft::Console::Types::AllocationTag;
 
 // Routine Description:
 // - This method creates an input buffer.
@@ -25,6 +29,11 @@ using Microsoft::Console::VirtualTerminal::TerminalInput;
 InputBuffer::InputBuffer() :
     InputMode{ INPUT_BUFFER_DEFAULT_INPUT_MODE },
     WaitQueue{},
+    _storage{},
+    _readScratch{},
+    _readyEventCount{ 0 },
+    _wakeUpDeferrals{ 0 },
+    _wakeUpPending{ false },
     _termInput(std::bind(&InputBuffer::_HandleTerminalInputCallback, this, std::placeholders::_1))
 {
     // The _termInput's constructor takes a reference to this object's _HandleTerminalInputCallback.
@@ -151,6 +160,7 @@ void InputBuffer::ReinitializeInputBuffer()
     ServiceLocator::LocateGlobals().hInputEvent.ResetEvent();
     InputMode = INPUT_BUFFER_DEFAULT_INPUT_MODE;
     _storage.clear();
+    _PublishReadyEventCount();
 }
 
 // Routine Description:
@@ -159,9 +169,50 @@ void InputBuffer::ReinitializeInputBuffer()
 // - None
 // Return Value:
 // - None
+// Note:
+// - While wake ups are deferred, this only remembers that readers need waking.
 void InputBuffer::WakeUpReadersWaitingForData()
 {
-    WaitQueue.NotifyWaiters(false);
+    if (_wakeUpDeferrals != 0)
+    {
+        _wakeUpPending = true;
+        return;
+    }
+
+    WaitQueue.NotifyWaiters(false, ReplyDataType::Read);
+}
+
+// Routine Description:
+// - Holds off waking up readers until the matching call to ResumeWakeUps,
+//   so that many writes in a row wake them up once instead of once each.
+// Arguments:
+// - None
+// Return Value:
+// - None
+// Note:
+// - The console lock must be held when calling this routine.
+void InputBuffer::DeferWakeUps() noexcept
+{
+    ++_wakeUpDeferrals;
+}
+
+// Routine Description:
+// - Ends a call to DeferWakeUps. Once the last one has ended, wakes up readers
+//   if anything was written in the meantime.
+// Arguments:
+// - None
+// Return Value:
+// - None
+// Note:
+// - The console lock must be held when calling this routine.
+void InputBuffer::ResumeWakeUps()
+{
+    FAIL_FAST_IF(_wakeUpDeferrals == 0);
+    if (--_wakeUpDeferrals == 0 && _wakeUpPending)
+    {
+        _wakeUpPending = false;
+        WakeUpReadersWaitingForData();
+    }
 }
 
 // Routine Description:
@@ -188,6 +239,20 @@ size_t InputBuffer::GetNumberOfReadyEvents() const noexcept
     return _storage.size();
 }
 
+// Routine Description:
+// - Returns the number of events in the input buffer as of the last time it was changed.
+// Arguments:
+// - None
+// Return Value:
+// - The number of events in the input buffer.
+// Note:
+// - The console lock doesn't need to be held. The count can be stale
+//   by the time it's returned if another thread is changing the buffer.
+size_t InputBuffer::PeekNumberOfReadyEvents() const noexcept
+{
+    return _readyEventCount.load(std::memory_order_acquire);
+}
+
 // Routine Description:
 // - This routine empties the input buffer
 // Arguments:
@@ -199,6 +264,7 @@ size_t InputBuffer::GetNumberOfReadyEvents() const noexcept
 void InputBuffer::Flush()
 {
     _storage.clear();
+    _PublishReadyEventCount();
     ServiceLocator::LocateGlobals().hInputEvent.ResetEvent();
 }
 
@@ -212,10 +278,10 @@ void InputBuffer::Flush()
 // - The console lock must be held when calling this routine.
 void InputBuffer::FlushAllButKeys()
 {
-    auto newEnd = std::remove_if(_storage.begin(), _storage.end(), [](const std::unique_ptr<IInputEvent>& event) {
-        return event->EventType() != InputEventType::KeyEvent;
+    _storage.remove_if([](const INPUT_RECORD& record) noexcept {
+        return record.EventType != KEY_EVENT;
     });
-    _storage.erase(newEnd, _storage.end());
+    _PublishReadyEventCount();
 }
 
 // Routine Description:
@@ -225,23 +291,25 @@ void InputBuffer::FlushAllButKeys()
 // Note:
 // - The console lock must be held when calling this routine.
 // Arguments:
-// - OutEvents - deque to store the read events
+// - OutRecords - where the read records are appended
 // - AmountToRead - the amount of events to try to read
 // - Peek - If true, copy events to pInputRecord but don't remove them from the input buffer.
 // - WaitForData - if true, wait until an event is input (if there aren't enough to fill client buffer). if false, return immediately
 // - Unicode - true if the data in key events should be treated as unicode. false if they should be converted by the current input CP.
-// - Stream - true if read should unpack KeyEvents that have a >1 repeat count. AmountToRead must be 1 if Stream is true.
+// - Stream - true if read should unpack KeyEvents that have a >1 repeat count. AmountToRead must be 1 if Stream and Peek are both true.
 // Return Value:
 // - STATUS_SUCCESS if records were read into the client buffer and everything is OK.
 // - CONSOLE_STATUS_WAIT if there weren't enough records to satisfy the request (and waits are allowed)
 // - otherwise a suitable memory/math/string error in NTSTATUS form.
-[[nodiscard]] NTSTATUS InputBuffer::Read(_Out_ std::deque<std::unique_ptr<IInputEvent>>& OutEvents,
+[[nodiscard]] NTSTATUS InputBuffer::Read(_Inout_ std::vector<INPUT_RECORD>& OutRecords,
                                          const size_t AmountToRead,
                                          const bool Peek,
                                          const bool WaitForData,
                                          const bool Unicode,
                                          const bool Stream)
 {
+    const AllocationScope allocationScope{ AllocationTag::HostInput };
+
     try
     {
         if (_storage.empty())
@@ -254,10 +322,9 @@ void InputBuffer::FlushAllButKeys()
         }
 
         // read from buffer
-        std::deque<std::unique_ptr<IInputEvent>> events;
         size_t eventsRead;
         bool resetWaitEvent;
-        _ReadBuffer(events,
+        _ReadBuffer(OutRecords,
                     AmountToRead,
                     eventsRead,
                     Peek,
@@ -265,13 +332,6 @@ void InputBuffer::FlushAllButKeys()
                     Unicode,
                     Stream);
 
-        // copy events to outEvents
-        while (!events.empty())
-        {
-            OutEvents.push_back(std::move(events.front()));
-            events.pop_front();
-        }
-
         if (resetWaitEvent)
         {
             ServiceLocator::LocateGlobals().hInputEvent.ResetEvent();
@@ -284,6 +344,98 @@ void InputBuffer::FlushAllButKeys()
     }
 }
 
+// Routine Description:
+// - This routine reads from the input buffer.
+// - It can convert returned data to through the currently set Input CP, it can optionally return a wait condition
+//   if there isn't enough data in the buffer, and it can be set to not remove records as it reads them out.
+// Note:
+// - The console lock must be held when calling this routine.
+// Arguments:
+// - OutEvents - deque to store the read events
+// - AmountToRead - the amount of events to try to read
+// - Peek - If true, copy events to pInputRecord but don't remove them from the input buffer.
+// - WaitForData - if true, wait until an event is input (if there aren't enough to fill client buffer). if false, return immediately
+// - Unicode - true if the data in key events should be treated as unicode. false if they should be converted by the current input CP.
+// - Stream - true if read should unpack KeyEvents that have a >1 repeat count. AmountToRead must be 1 if Stream and Peek are both true.
+// Return Value:
+// - STATUS_SUCCESS if records were read into the client buffer and everything is OK.
+// - CONSOLE_STATUS_WAIT if there weren't enough records to satisfy the request (and waits are allowed)
+// - otherwise a suitable memory/math/string error in NTSTATUS form.
+[[nodiscard]] NTSTATUS InputBuffer::Read(_Out_ std::deque<std::unique_ptr<IInputEvent>>& OutEvents,
+                                         const size_t AmountToRead,
+                                         const bool Peek,
+                                         const bool WaitForData,
+                                         const bool Unicode,
+                                         const bool Stream)
+{
+    const AllocationScope allocationScope{ AllocationTag::HostInput };
+
+    try
+    {
+        _readScratch.clear();
+        const NTSTATUS Status = Read(_readScratch,
+                                     AmountToRead,
+                                     Peek,
+                                     WaitForData,
+                                     Unicode,
+                                     Stream);
+
+        for (const auto& record : _readScratch)
+        {
+            OutEvents.push_back(IInputEvent::Create(record));
+        }
+        return Status;
+    }
+    catch (...)
+    {
+        return NTSTATUS_FROM_HRESULT(wil::ResultFromCaughtException());
+    }
+}
+
+// Routine Description:
+// - This routine reads a single record from the input buffer.
+// - It can convert returned data to through the currently set Input CP, it can optionally return a wait condition
+//   if there isn't enough data in the buffer, and it can be set to not remove records as it reads them out.
+// Note:
+// - The console lock must be held when calling this routine.
+// Arguments:
+// - outRecord - where the read record is stored
+// - recordRead - on exit, true if a record was stored in outRecord
+// - Peek - If true, copy events to pInputRecord but don't remove them from the input buffer.
+// - WaitForData - if true, wait until an event is input (if there aren't enough to fill client buffer). if false, return immediately
+// - Unicode - true if the data in key events should be treated as unicode. false if they should be converted by the current input CP.
+// - Stream - true if read should unpack KeyEvents that have a >1 repeat count.
+// Return Value:
+// - STATUS_SUCCESS if records were read into the client buffer and everything is OK.
+// - CONSOLE_STATUS_WAIT if there weren't enough records to satisfy the request (and waits are allowed)
+// - otherwise a suitable memory/math/string error in NTSTATUS form.
+[[nodiscard]] NTSTATUS InputBuffer::Read(_Out_ INPUT_RECORD& outRecord,
+                                         _Out_ bool& recordRead,
+                                         const bool Peek,
+                                         const bool WaitForData,
+                                         const bool Unicode,
+                                         const bool Stream)
+{
+    outRecord = {};
+    recordRead = false;
+
+    // The scratch vector keeps its capacity between reads, so reading one
+    // record at a time doesn't allocate.
+    _readScratch.clear();
+    const NTSTATUS Status = Read(_readScratch,
+                                 1,
+                                 Peek,
+                                 WaitForData,
+                                 Unicode,
+                                 Stream);
+    if (!_readScratch.empty())
+    {
+        outRecord = _readScratch.front();
+        recordRead = true;
+    }
+    return Status;
+}
+
 // Routine Description:
 // - This routine reads a single event from the input buffer.
 // - It can convert returned data to through the currently set Input CP, it can optionally return a wait condition
@@ -309,16 +461,17 @@ void InputBuffer::FlushAllButKeys()
     NTSTATUS Status;
     try
     {
-        std::deque<std::unique_ptr<IInputEvent>> outEvents;
-        Status = Read(outEvents,
-                      1,
+        INPUT_RECORD record;
+        bool recordRead;
+        Status = Read(record,
+                      recordRead,
                       Peek,
                       WaitForData,
                       Unicode,
                       Stream);
-        if (!outEvents.empty())
+        if (recordRead)
         {
-            outEvent.swap(outEvents.front());
+            outEvent = IInputEvent::Create(record);
         }
     }
     catch (...)
@@ -332,18 +485,18 @@ void InputBuffer::FlushAllButKeys()
 // Routine Description:
 // - This routine reads from a buffer. It does the buffer manipulation.
 // Arguments:
-// - outEvents - where read events are placed
+// - outRecords - where read records are appended
 // - readCount - amount of events to read
 // - eventsRead - where to store number of events read
 // - peek - if true , don't remove data from buffer, just copy it.
 // - resetWaitEvent - on exit, true if buffer became empty.
 // - unicode - true if read should be done in unicode mode
-// - streamRead - true if read should unpack KeyEvents that have a >1 repeat count. readCount must be 1 if streamRead is true.
+// - streamRead - true if read should unpack KeyEvents that have a >1 repeat count. readCount must be 1 if streamRead and peek are both true.
 // Return Value:
 // - <none>
 // Note:
 // - The console lock must be held when calling this routine.
-void InputBuffer::_ReadBuffer(_Out_ std::deque<std::unique_ptr<IInputEvent>>& outEvents,
+void InputBuffer::_ReadBuffer(_Inout_ std::vector<INPUT_RECORD>& outRecords,
                               const size_t readCount,
                               _Out_ size_t& eventsRead,
                               const bool peek,
@@ -352,12 +505,14 @@ void InputBuffer::_ReadBuffer(_Out_ std::deque<std::unique_ptr<IInputEvent>>& ou
                               const bool streamRead)
 {
     // when stream reading, the previous behavior was to only allow reading of a single
-    // event at a time.
-    FAIL_FAST_IF(streamRead && readCount != 1);
+    // event at a time. That's still the case when peeking, because only the last split
+    // record can be handed back to storage, but a stream read that takes the records
+    // out can unpack as many as it likes in one go.
+    FAIL_FAST_IF(streamRead && peek && readCount != 1);
 
     resetWaitEvent = false;
 
-    std::deque<std::unique_ptr<IInputEvent>> readEvents;
+    const size_t firstRead = outRecords.size();
     // we need another var to keep track of how many we've read
     // because dbcs records count for two when we aren't doing a
     // unicode read but the eventsRead count should return the number
@@ -366,85 +521,68 @@ void InputBuffer::_ReadBuffer(_Out_ std::deque<std::unique_ptr<IInputEvent>>& ou
 
     while (!_storage.empty() && virtualReadCount < readCount)
     {
-        bool performNormalRead = true;
+        INPUT_RECORD& stored = _storage.front();
         // for stream reads we need to split any key events that have been coalesced
-        if (streamRead)
+        if (streamRead &&
+            stored.EventType == KEY_EVENT &&
+            stored.Event.KeyEvent.wRepeatCount > 1)
         {
-            if (_storage.front()->EventType() == InputEventType::KeyEvent)
-            {
-                KeyEvent* const pKeyEvent = static_cast<KeyEvent* const>(_storage.front().get());
-                if (pKeyEvent->GetRepeatCount() > 1)
-                {
-                    // split the key event
-                    std::unique_ptr<KeyEvent> streamKeyEvent = std::make_unique<KeyEvent>(*pKeyEvent);
-                    streamKeyEvent->SetRepeatCount(1);
-                    readEvents.push_back(std::move(streamKeyEvent));
-                    pKeyEvent->SetRepeatCount(pKeyEvent->GetRepeatCount() - 1);
-                    performNormalRead = false;
-                }
-            }
+            // split the key event
+            outRecords.push_back(stored);
+            outRecords.back().Event.KeyEvent.wRepeatCount = 1;
+            --stored.Event.KeyEvent.wRepeatCount;
         }
-
-        if (performNormalRead)
+        else
         {
-            readEvents.push_back(std::move(_storage.front()));
+            outRecords.push_back(stored);
             _storage.pop_front();
         }
 
         ++virtualReadCount;
         if (!unicode)
         {
-            if (readEvents.back()->EventType() == InputEventType::KeyEvent)
+            const INPUT_RECORD& record = outRecords.back();
+            if (record.EventType == KEY_EVENT &&
+                IsGlyphFullWidth(record.Event.KeyEvent.uChar.UnicodeChar))
             {
-                const KeyEvent* const pKeyEvent = static_cast<const KeyEvent* const>(readEvents.back().get());
-                if (IsGlyphFullWidth(pKeyEvent->GetCharData()))
-                {
-                    ++virtualReadCount;
-                }
+                ++virtualReadCount;
             }
         }
     }
 
     // the amount of events that were actually read
-    eventsRead = readEvents.size();
+    eventsRead = outRecords.size() - firstRead;
 
     // copy the events back if we were supposed to peek
-    if (peek)
+    if (peek && eventsRead != 0)
     {
         if (streamRead)
         {
             // we need to check and see if the event was split from a coalesced key event
             // or if it was unrelated to the current front event in storage
-            if (!readEvents.empty() &&
-                !_storage.empty() &&
-                readEvents.back()->EventType() == InputEventType::KeyEvent &&
-                _storage.front()->EventType() == InputEventType::KeyEvent &&
-                _CanCoalesce(static_cast<const KeyEvent&>(*readEvents.back()),
-                             static_cast<const KeyEvent&>(*_storage.front())))
+            const INPUT_RECORD& record = outRecords.back();
+            if (!_storage.empty() &&
+                record.EventType == KEY_EVENT &&
+                _storage.front().EventType == KEY_EVENT &&
+                _CanCoalesce(record.Event.KeyEvent, _storage.front().Event.KeyEvent))
             {
-                KeyEvent& keyEvent = static_cast<KeyEvent&>(*_storage.front());
-                keyEvent.SetRepeatCount(keyEvent.GetRepeatCount() + 1);
+                ++_storage.front().Event.KeyEvent.wRepeatCount;
             }
             else
             {
-                _storage.push_front(IInputEvent::Create(readEvents.back()->ToInputRecord()));
+                _storage.push_front(record);
             }
         }
         else
         {
-            for (auto it = readEvents.crbegin(); it != readEvents.crend(); ++it)
+            for (size_t i = outRecords.size(); i > firstRead; --i)
             {
-                _storage.push_front(IInputEvent::Create((*it)->ToInputRecord()));
+                _storage.push_front(outRecords.at(i - 1));
             }
         }
     }
 
-    // move events read to proper deque
-    while (!readEvents.empty())
-    {
-        outEvents.push_back(std::move(readEvents.front()));
-        readEvents.pop_front();
-    }
+    _PublishReadyEventCount();
 
     // signal if we emptied the buffer
     if (_storage.empty())
@@ -454,20 +592,23 @@ void InputBuffer::_ReadBuffer(_Out_ std::deque<std::unique_ptr<IInputEvent>>& ou
 }
 
 // Routine Description:
-// -  Writes events to the beginning of the input buffer.
+// -  Writes records to the beginning of the input buffer.
 // Arguments:
-// - inEvents - events to write to buffer.
-// - eventsWritten - The number of events written to the buffer on exit.
+// - inRecords - records to write to buffer.
 // Return Value:
-// S_OK if successful.
+// - The number of events written to the buffer.
 // Note:
 // - The console lock must be held when calling this routine.
-size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+size_t InputBuffer::Prepend(const std::basic_string_view<INPUT_RECORD> inRecords)
 {
+    const AllocationScope allocationScope{ AllocationTag::HostInput };
+
+    auto publish = wil::scope_exit([&]() noexcept { _PublishReadyEventCount(); });
     try
     {
-        _HandleConsoleSuspensionEvents(inEvents);
-        if (inEvents.empty())
+        std::vector<INPUT_RECORD> records{ inRecords.cbegin(), inRecords.cend() };
+        _HandleConsoleSuspensionEvents(records);
+        if (records.empty())
         {
             return STATUS_SUCCESS;
         }
@@ -476,23 +617,30 @@ size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& in
         // this way to handle any coalescing that might occur.
 
         // get all of the existing records, "emptying" the buffer
-        std::deque<std::unique_ptr<IInputEvent>> existingStorage;
+        InputRecordRing existingStorage;
         existingStorage.swap(_storage);
 
+        std::vector<INPUT_RECORD> existingRecords;
+        existingRecords.reserve(existingStorage.size());
+        for (size_t i = 0; i < existingStorage.size(); ++i)
+        {
+            existingRecords.push_back(existingStorage[i]);
+        }
+
         // We will need this variable to pass to _WriteBuffer so it can attempt to determine wait status.
-        // However, because we swapped the storage out from under it with an empty deque, it will always
-        // return true after the first one (as it is filling the newly emptied backing deque.)
+        // However, because we swapped the storage out from under it with an empty ring, it will always
+        // return true after the first one (as it is filling the newly emptied backing ring.)
         // Then after the second one, because we've inserted some input, it will always say false.
         bool unusedWaitStatus = false;
 
         // write the prepend records
         size_t prependEventsWritten;
-        _WriteBuffer(inEvents, prependEventsWritten, unusedWaitStatus);
+        _WriteBuffer(records, prependEventsWritten, unusedWaitStatus);
         FAIL_FAST_IF(!(unusedWaitStatus));
 
         // write all previously existing records
         size_t existingEventsWritten;
-        _WriteBuffer(existingStorage, existingEventsWritten, unusedWaitStatus);
+        _WriteBuffer(existingRecords, existingEventsWritten, unusedWaitStatus);
         FAIL_FAST_IF(!(!unusedWaitStatus));
 
         // We need to set the wait event if there were 0 events in the
@@ -502,7 +650,7 @@ size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& in
         // and instead need to set the event if the original backing
         // buffer (the one we swapped out at the top) was empty
         // when this whole thing started.
-        if (existingStorage.empty())
+        if (existingRecords.empty())
         {
             ServiceLocator::LocateGlobals().hInputEvent.SetEvent();
         }
@@ -517,6 +665,31 @@ size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& in
     }
 }
 
+// Routine Description:
+// -  Writes events to the beginning of the input buffer.
+// Arguments:
+// - inEvents - events to write to buffer. It's empty on exit.
+// Return Value:
+// - The number of events written to the buffer.
+// Note:
+// - The console lock must be held when calling this routine.
+size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+{
+    const AllocationScope allocationScope{ AllocationTag::HostInput };
+
+    try
+    {
+        const auto records = IInputEvent::ToInputRecords(inEvents);
+        inEvents.clear();
+        return Prepend({ records.data(), records.size() });
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return 0;
+    }
+}
+
 // Routine Description:
 // - Writes event to the input buffer. Wakes up any readers that are
 // waiting for additional input events.
@@ -530,11 +703,28 @@ size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& in
 // calling this method.
 size_t InputBuffer::Write(_Inout_ std::unique_ptr<IInputEvent> inEvent)
 {
+    const INPUT_RECORD record = inEvent->ToInputRecord();
+    return Write({ &record, 1 });
+}
+
+// Routine Description:
+// - Writes events to the input buffer. Wakes up any readers that are
+// waiting for additional input events.
+// Arguments:
+// - inEvents - input events to store in the buffer. It's empty on exit.
+// Return Value:
+// - The number of events that were written to input buffer.
+// Note:
+// - The console lock must be held when calling this routine.
+size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+{
+    const AllocationScope allocationScope{ AllocationTag::HostInput };
+
     try
     {
-        std::deque<std::unique_ptr<IInputEvent>> inEvents;
-        inEvents.push_back(std::move(inEvent));
-        return Write(inEvents);
+        const auto records = IInputEvent::ToInputRecords(inEvents);
+        inEvents.clear();
+        return Write({ records.data(), records.size() });
     }
     catch (...)
     {
@@ -544,20 +734,24 @@ size_t InputBuffer::Write(_Inout_ std::unique_ptr<IInputEvent> inEvent)
 }
 
 // Routine Description:
-// - Writes events to the input buffer. Wakes up any readers that are
+// - Writes records to the input buffer. Wakes up any readers that are
 // waiting for additional input events.
 // Arguments:
-// - inEvents - input events to store in the buffer.
+// - inRecords - input records to store in the buffer.
 // Return Value:
 // - The number of events that were written to input buffer.
 // Note:
 // - The console lock must be held when calling this routine.
-size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+size_t InputBuffer::Write(const std::basic_string_view<INPUT_RECORD> inRecords)
 {
+    const AllocationScope allocationScope{ AllocationTag::HostInput };
+
+    auto publish = wil::scope_exit([&]() noexcept { _PublishReadyEventCount(); });
     try
     {
-        _HandleConsoleSuspensionEvents(inEvents);
-        if (inEvents.empty())
+        std::vector<INPUT_RECORD> records{ inRecords.cbegin(), inRecords.cend() };
+        _HandleConsoleSuspensionEvents(records);
+        if (records.empty())
         {
             return 0;
         }
@@ -565,7 +759,7 @@ size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEv
         // Write to buffer.
         size_t EventsWritten;
         bool SetWaitEvent;
-        _WriteBuffer(inEvents, EventsWritten, SetWaitEvent);
+        _WriteBuffer(records, EventsWritten, SetWaitEvent);
 
         if (SetWaitEvent)
         {
@@ -584,9 +778,60 @@ size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEv
 }
 
 // Routine Description:
-// - Coalesces input events and transfers them to storage queue.
+// - Writes text as what TerminalInput turns the keys that type it into: a key down without a
+//   virtual key for each character, and nothing else.
+// - That's all a reader gets of typed text in VT input mode, so text can go in this way there
+//   without a key being made up for each character first. Other modes need those keys; use Write.
+// Arguments:
+// - text - the characters to write
+// Return Value:
+// - The number of records written
+// Note:
+// - The console lock must be held when calling this routine.
+size_t InputBuffer::WriteText(const std::wstring_view text)
+{
+    const AllocationScope allocationScope{ AllocationTag::HostInput };
+
+    auto publish = wil::scope_exit([&]() noexcept { _PublishReadyEventCount(); });
+    try
+    {
+        if (text.empty())
+        {
+            return 0;
+        }
+
+        const bool initiallyEmptyQueue = _storage.empty();
+        _storage.reserve(_storage.size() + text.size());
+
+        INPUT_RECORD record{};
+        record.EventType = KEY_EVENT;
+        record.Event.KeyEvent.bKeyDown = TRUE;
+        record.Event.KeyEvent.wRepeatCount = 1;
+        for (const auto ch : text)
+        {
+            record.Event.KeyEvent.uChar.UnicodeChar = ch;
+            _storage.push_back(record);
+        }
+
+        if (initiallyEmptyQueue)
+        {
+            ServiceLocator::LocateGlobals().hInputEvent.SetEvent();
+        }
+
+        WakeUpReadersWaitingForData();
+        return text.size();
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+        return 0;
+    }
+}
+
+// Routine Description:
+// - Coalesces input records and transfers them to storage queue.
 // Arguments:
-// - inRecords - The events to store.
+// - inRecords - The records to store.
 // - eventsWritten - The number of events written since this function
 // was called.
 // - setWaitEvent - on exit, true if buffer became non-empty.
@@ -595,28 +840,25 @@ size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEv
 // Note:
 // - The console lock must be held when calling this routine.
 // - will throw on failure
-void InputBuffer::_WriteBuffer(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents,
+void InputBuffer::_WriteBuffer(const std::vector<INPUT_RECORD>& inRecords,
                                _Out_ size_t& eventsWritten,
                                _Out_ bool& setWaitEvent)
 {
     eventsWritten = 0;
     setWaitEvent = false;
     const bool initiallyEmptyQueue = _storage.empty();
-    const size_t initialInEventsSize = inEvents.size();
     const bool vtInputMode = IsInVirtualTerminalInputMode();
 
-    while (!inEvents.empty())
+    for (const INPUT_RECORD& record : inRecords)
     {
-        // Pop the next event.
         // If we're in vt mode, try and handle it with the vt input module.
         // If it was handled, do nothing else for it.
         // If there was one event passed in, try coalescing it with the previous event currently in the buffer.
         // If it's not coalesced, append it to the buffer.
-        std::unique_ptr<IInputEvent> inEvent = std::move(inEvents.front());
-        inEvents.pop_front();
-        if (vtInputMode)
+        if (vtInputMode && record.EventType == KEY_EVENT)
         {
-            const bool handled = _termInput.HandleKey(inEvent.get());
+            const KeyEvent keyEvent{ record.Event.KeyEvent };
+            const bool handled = _termInput.HandleKey(&keyEvent);
             if (handled)
             {
                 eventsWritten++;
@@ -628,42 +870,19 @@ void InputBuffer::_WriteBuffer(_Inout_ std::deque<std::unique_ptr<IInputEvent>>&
         // record at a time because this is the original behavior of
         // the input buffer. Changing this behavior may break stuff
         // that was depending on it.
-        if (initialInEventsSize == 1 && !_storage.empty())
+        if (inRecords.size() == 1 && !_storage.empty())
         {
-            // coalescing requires a deque of events, so push it back onto the front.
-            inEvents.push_front(std::move(inEvent));
-
-            bool coalesced = false;
             // this looks kinda weird but we don't want to coalesce a
             // mouse event and then try to coalesce a key event right after.
-            //
-            // we also pass the whole deque to the coalescing methods
-            // even though they only want one event because it should
-            // be their responsibility to maintain the correct state
-            // of the deque if they process any records in it.
-            if (_CoalesceMouseMovedEvents(inEvents))
-            {
-                coalesced = true;
-            }
-            else if (_CoalesceRepeatedKeyPressEvents(inEvents))
-            {
-                coalesced = true;
-            }
-            if (coalesced)
+            if (_CoalesceMouseMovedEvents(record) ||
+                _CoalesceRepeatedKeyPressEvents(record))
             {
                 eventsWritten = 1;
                 return;
             }
-            else
-            {
-                // We didn't coalesce the event. pull it from the queue again,
-                //  to keep the state consistent with the start of this block.
-                inEvent = std::move(inEvents.front());
-                inEvents.pop_front();
-            }
         }
         // At this point, the event was neither coalesced, nor processed by VT.
-        _storage.push_back(std::move(inEvent));
+        _storage.push_back(record);
         ++eventsWritten;
     }
     if (initiallyEmptyQueue && !_storage.empty())
@@ -673,67 +892,53 @@ void InputBuffer::_WriteBuffer(_Inout_ std::deque<std::unique_ptr<IInputEvent>>&
 }
 
 // Routine Description:
-// - Checks if the last saved event and the first event of inRecords are
-// both MOUSE_MOVED events. If they are, the last saved event is
-// updated with the new mouse position and the first event of inRecords is
-// dropped.
+// - Checks if the last saved record and inRecord are both MOUSE_MOVED
+// events. If they are, the last saved record is updated with the new
+// mouse position.
 // Arguments:
-// - inRecords - The incoming records to process.
+// - inRecord - The incoming record to process.
 // Return Value:
 // true if events were coalesced, false if they were not.
 // Note:
-// - The size of inRecords must be 1.
 // - Coalescing here means updating a record that already exists in
 // the buffer with updated values from an incoming event, instead of
 // storing the incoming event (which would make the original one
 // redundant/out of date with the most current state).
-bool InputBuffer::_CoalesceMouseMovedEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+bool InputBuffer::_CoalesceMouseMovedEvents(const INPUT_RECORD& inRecord) noexcept
 {
-    FAIL_FAST_IF(!(inEvents.size() == 1));
     FAIL_FAST_IF(_storage.empty());
-    const IInputEvent* const pFirstInEvent = inEvents.front().get();
-    const IInputEvent* const pLastStoredEvent = _storage.back().get();
-    if (pFirstInEvent->EventType() == InputEventType::MouseEvent &&
-        pLastStoredEvent->EventType() == InputEventType::MouseEvent)
+    INPUT_RECORD& lastRecord = _storage.back();
+    if (inRecord.EventType == MOUSE_EVENT &&
+        lastRecord.EventType == MOUSE_EVENT &&
+        inRecord.Event.MouseEvent.dwEventFlags == MOUSE_MOVED &&
+        lastRecord.Event.MouseEvent.dwEventFlags == MOUSE_MOVED)
     {
-        const MouseEvent* const pInMouseEvent = static_cast<const MouseEvent* const>(pFirstInEvent);
-        const MouseEvent* const pLastMouseEvent = static_cast<const MouseEvent* const>(pLastStoredEvent);
-
-        if (pInMouseEvent->IsMouseMoveEvent() &&
-            pLastMouseEvent->IsMouseMoveEvent())
-        {
-            // update mouse moved position
-            MouseEvent* const pMouseEvent = static_cast<MouseEvent* const>(_storage.back().release());
-            pMouseEvent->SetPosition(pInMouseEvent->GetPosition());
-            std::unique_ptr<IInputEvent> tempPtr(pMouseEvent);
-            tempPtr.swap(_storage.back());
-
-            inEvents.pop_front();
-            return true;
-        }
+        // update mouse moved position
+        lastRecord.Event.MouseEvent.dwMousePosition = inRecord.Event.MouseEvent.dwMousePosition;
+        return true;
     }
     return false;
 }
 
 // Routine Description:
-// - checks two KeyEvents to see if they're similiar enough to be coalesced
+// - checks two key records to see if they're similiar enough to be coalesced
 // Arguments:
-// - a - the first KeyEvent
-// - b - the other KeyEvent
+// - a - the first key record
+// - b - the other key record
 // Return Value:
 // - true if the events could be coalesced, false otherwise
-bool InputBuffer::_CanCoalesce(const KeyEvent& a, const KeyEvent& b) const noexcept
+bool InputBuffer::_CanCoalesce(const KEY_EVENT_RECORD& a, const KEY_EVENT_RECORD& b) const noexcept
 {
-    if (WI_IsFlagSet(a.GetActiveModifierKeys(), NLS_IME_CONVERSION) &&
-        a.GetCharData() == b.GetCharData() &&
-        a.GetActiveModifierKeys() == b.GetActiveModifierKeys())
+    if (WI_IsFlagSet(a.dwControlKeyState, NLS_IME_CONVERSION) &&
+        a.uChar.UnicodeChar == b.uChar.UnicodeChar &&
+        a.dwControlKeyState == b.dwControlKeyState)
     {
         return true;
     }
     // other key events check
-    else if (a.GetVirtualScanCode() == b.GetVirtualScanCode() &&
-             a.GetCharData() == b.GetCharData() &&
-             a.GetActiveModifierKeys() == b.GetActiveModifierKeys())
+    else if (a.wVirtualScanCode == b.wVirtualScanCode &&
+             a.uChar.UnicodeChar == b.uChar.UnicodeChar &&
+             a.dwControlKeyState == b.dwControlKeyState)
     {
         return true;
     }
@@ -741,44 +946,34 @@ bool InputBuffer::_CanCoalesce(const KeyEvent& a, const KeyEvent& b) const noexc
 }
 
 // Routine Description::
-// - If the last input event saved and the first input event in inRecords
-// are both a keypress down event for the same key, update the repeat
-// count of the saved event and drop the first from inRecords.
+// - If the last input record saved and inRecord are both a keypress down
+// event for the same key, update the repeat count of the saved record.
 // Arguments:
-// - inRecords - The incoming records to process.
+// - inRecord - The incoming record to process.
 // Return Value:
 // true if events were coalesced, false if they were not.
 // Note:
-// - The size of inRecords must be 1.
 // - Coalescing here means updating a record that already exists in
 // the buffer with updated values from an incoming event, instead of
 // storing the incoming event (which would make the original one
 // redundant/out of date with the most current state).
-bool InputBuffer::_CoalesceRepeatedKeyPressEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+bool InputBuffer::_CoalesceRepeatedKeyPressEvents(const INPUT_RECORD& inRecord) noexcept
 {
-    FAIL_FAST_IF(!(inEvents.size() == 1));
     FAIL_FAST_IF(_storage.empty());
-    const IInputEvent* const pFirstInEvent = inEvents.front().get();
-    const IInputEvent* const pLastStoredEvent = _storage.back().get();
-    if (pFirstInEvent->EventType() == InputEventType::KeyEvent &&
-        pLastStoredEvent->EventType() == InputEventType::KeyEvent)
-    {
-        const KeyEvent* const pInKeyEvent = static_cast<const KeyEvent* const>(pFirstInEvent);
-        const KeyEvent* const pLastKeyEvent = static_cast<const KeyEvent* const>(pLastStoredEvent);
-
-        if (pInKeyEvent->IsKeyDown() &&
-            pLastKeyEvent->IsKeyDown() &&
-            !IsGlyphFullWidth(pInKeyEvent->GetCharData()) &&
-            _CanCoalesce(*pInKeyEvent, *pLastKeyEvent))
+    INPUT_RECORD& lastRecord = _storage.back();
+    if (inRecord.EventType == KEY_EVENT &&
+        lastRecord.EventType == KEY_EVENT)
+    {
+        const KEY_EVENT_RECORD& inKey = inRecord.Event.KeyEvent;
+        KEY_EVENT_RECORD& lastKey = lastRecord.Event.KeyEvent;
+
+        if (inKey.bKeyDown &&
+            lastKey.bKeyDown &&
+            !IsGlyphFullWidth(inKey.uChar.UnicodeChar) &&
+            _CanCoalesce(inKey, lastKey))
         {
             // increment repeat count
-            KeyEvent* const pKeyEvent = static_cast<KeyEvent* const>(_storage.back().release());
-            WORD repeatCount = pKeyEvent->GetRepeatCount() + pInKeyEvent->GetRepeatCount();
-            pKeyEvent->SetRepeatCount(repeatCount);
-            std::unique_ptr<IInputEvent> tempPtr(pKeyEvent);
-            tempPtr.swap(_storage.back());
-
-            inEvents.pop_front();
+            lastKey.wRepeatCount = lastKey.wRepeatCount + inKey.wRepeatCount;
             return true;
         }
     }
@@ -788,42 +983,42 @@ bool InputBuffer::_CoalesceRepeatedKeyPressEvents(_Inout_ std::deque<std::unique
 // Routine Description:
 // - Handles records that suspend/resume the console.
 // Arguments:
-// - records - records to check for pause/unpause events
+// - records - records to check for pause/unpause events. The ones that are
+//   handled are removed.
 // Return Value:
 // - None
 // Note:
 // - The console lock must be held when calling this routine.
 // - will throw exception on error
-void InputBuffer::_HandleConsoleSuspensionEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+void InputBuffer::_HandleConsoleSuspensionEvents(_Inout_ std::vector<INPUT_RECORD>& records)
 {
     CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
 
-    std::deque<std::unique_ptr<IInputEvent>> outEvents;
-    while (!inEvents.empty())
+    size_t kept = 0;
+    for (size_t i = 0; i < records.size(); ++i)
     {
-        std::unique_ptr<IInputEvent> currEvent = std::move(inEvents.front());
-        inEvents.pop_front();
-        if (currEvent->EventType() == InputEventType::KeyEvent)
+        const INPUT_RECORD record = records.at(i);
+        if (record.EventType == KEY_EVENT && record.Event.KeyEvent.bKeyDown)
         {
-            const KeyEvent* const pKeyEvent = static_cast<const KeyEvent* const>(currEvent.get());
-            if (pKeyEvent->IsKeyDown())
+            const KeyEvent keyEvent{ record.Event.KeyEvent };
+            if (WI_IsFlagSet(gci.Flags, CONSOLE_SUSPENDED) &&
+                !IsSystemKey(keyEvent.GetVirtualKeyCode()))
+            {
+                UnblockWriteConsole(CONSOLE_OUTPUT_SUSPENDED);
+                continue;
+            }
+            else if (WI_IsFlagSet(InputMode, ENABLE_LINE_INPUT) && keyEvent.IsPauseKey())
             {
-                if (WI_IsFlagSet(gci.Flags, CONSOLE_SUSPENDED) &&
-                    !IsSystemKey(pKeyEvent->GetVirtualKeyCode()))
-                {
-                    UnblockWriteConsole(CONSOLE_OUTPUT_SUSPENDED);
-                    continue;
-                }
-                else if (WI_IsFlagSet(InputMode, ENABLE_LINE_INPUT) && pKeyEvent->IsPauseKey())
-                {
-                    WI_SetFlag(gci.Flags, CONSOLE_SUSPENDED);
-                    continue;
-                }
+                // Anything held back by a selection was written before the pause, so it isn't held past it.
+                FlushPendingWrites();
+                WI_SetFlag(gci.Flags, CONSOLE_SUSPENDED);
+                continue;
             }
         }
-        outEvents.push_back(std::move(currEvent));
+        records.at(kept) = record;
+        ++kept;
     }
-    inEvents.swap(outEvents);
+    records.resize(kept);
 }
 
 // Routine Description:
@@ -852,15 +1047,29 @@ void InputBuffer::_HandleTerminalInputCallback(std::deque<std::unique_ptr<IInput
         // add all input events to the storage queue
         while (!inEvents.empty())
         {
-            std::unique_ptr<IInputEvent> inEvent = std::move(inEvents.front());
+            _storage.push_back(inEvents.front()->ToInputRecord());
             inEvents.pop_front();
-            _storage.push_back(std::move(inEvent));
         }
     }
     catch (...)
     {
         LOG_HR(wil::ResultFromCaughtException());
     }
+    _PublishReadyEventCount();
+}
+
+// Routine Description:
+// - Updates the count of events that's read by PeekNumberOfReadyEvents
+//   to match what's in storage now.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+// Note:
+// - The console lock must be held when calling this routine.
+void InputBuffer::_PublishReadyEventCount() noexcept
+{
+    _readyEventCount.store(_storage.size(), std::memory_order_release);
 }
 
 TerminalInput& InputBuffer::GetTerminalInput()
@@ -19,6 +19,7 @@ Revision History:
 #pragma once
 
 #include "inputReadHandleData.h"
+#include "inputRecordRing.hpp"
 #include "readData.hpp"
 #include "../types/inc/IInputEvent.hpp"
 
@@ -26,7 +27,10 @@ Revision History:
 #include "../server/ObjectHeader.h"
 #include "../terminal/input/terminalInput.hpp"
 
+#include <atomic>
 #include <deque>
+#include <string_view>
+#include <vector>
 
 class InputBuffer final : public ConsoleObjectHeader
 {
@@ -50,11 +54,21 @@ public:
 
     void ReinitializeInputBuffer();
     void WakeUpReadersWaitingForData();
+    void DeferWakeUps() noexcept;
+    void ResumeWakeUps();
     void TerminateRead(_In_ WaitTerminationReason Flag);
     size_t GetNumberOfReadyEvents() const noexcept;
+    size_t PeekNumberOfReadyEvents() const noexcept;
     void Flush();
     void FlushAllButKeys();
 
+    [[nodiscard]] NTSTATUS Read(_Inout_ std::vector<INPUT_RECORD>& OutRecords,
+                                const size_t AmountToRead,
+                                const bool Peek,
+                                const bool WaitForData,
+                                const bool Unicode,
+                                const bool Stream);
+
     [[nodiscard]] NTSTATUS Read(_Out_ std::deque<std::unique_ptr<IInputEvent>>& OutEvents,
                                 const size_t AmountToRead,
                                 const bool Peek,
@@ -62,27 +76,49 @@ public:
                                 const bool Unicode,
                                 const bool Stream);
 
+    [[nodiscard]] NTSTATUS Read(_Out_ INPUT_RECORD& outRecord,
+                                _Out_ bool& recordRead,
+                                const bool Peek,
+                                const bool WaitForData,
+                                const bool Unicode,
+                                const bool Stream);
+
     [[nodiscard]] NTSTATUS Read(_Out_ std::unique_ptr<IInputEvent>& inEvent,
                                 const bool Peek,
                                 const bool WaitForData,
                                 const bool Unicode,
                                 const bool Stream);
 
+    size_t Prepend(const std::basic_string_view<INPUT_RECORD> inRecords);
     size_t Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
 
     size_t Write(_Inout_ std::unique_ptr<IInputEvent> inEvent);
     size_t Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
+    size_t Write(const std::basic_string_view<INPUT_RECORD> inRecords);
+    size_t WriteText(const std::wstring_view text);
 
     bool IsInVirtualTerminalInputMode() const;
     Microsoft::Console::VirtualTerminal::TerminalInput& GetTerminalInput();
 
 private:
-    std::deque<std::unique_ptr<IInputEvent>> _storage;
+    InputRecordRing _storage;
+
+    // Reused by the reads that hand back one record or convert to events,
+    // so that they don't allocate once it has grown to fit.
+    std::vector<INPUT_RECORD> _readScratch;
+
+    // Copy of _storage.size() that's kept current by everything that holds the
+    // console lock and changes _storage, so that it can be read without the lock.
+    std::atomic<size_t> _readyEventCount;
+
+    size_t _wakeUpDeferrals;
+    bool _wakeUpPending;
+
     std::unique_ptr<IInputEvent> _readPartialByteSequence;
     std::unique_ptr<IInputEvent> _writePartialByteSequence;
     Microsoft::Console::VirtualTerminal::TerminalInput _termInput;
 
-    void _ReadBuffer(_Out_ std::deque<std::unique_ptr<IInputEvent>>& outEvents,
+    void _ReadBuffer(_Inout_ std::vector<INPUT_RECORD>& outRecords,
                      const size_t readCount,
                      _Out_ size_t& eventsRead,
                      const bool peek,
@@ -90,17 +126,19 @@ private:
                      const bool unicode,
                      const bool streamRead);
 
-    void _WriteBuffer(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inRecords,
+    void _WriteBuffer(const std::vector<INPUT_RECORD>& inRecords,
                       _Out_ size_t& eventsWritten,
                       _Out_ bool& setWaitEvent);
 
-    bool _CanCoalesce(const KeyEvent& a, const KeyEvent& b) const noexcept;
-    bool _CoalesceMouseMovedEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
-    bool _CoalesceRepeatedKeyPressEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
-    void _HandleConsoleSuspensionEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
+    bool _CanCoalesce(const KEY_EVENT_RECORD& a, const KEY_EVENT_RECORD& b) const noexcept;
+    bool _CoalesceMouseMovedEvents(const INPUT_RECORD& inRecord) noexcept;
+    bool _CoalesceRepeatedKeyPressEvents(const INPUT_RECORD& inRecord) noexcept;
+    void _HandleConsoleSuspensionEvents(_Inout_ std::vector<INPUT_RECORD>& records);
 
     void _HandleTerminalInputCallback(_In_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
 
+    void _PublishReadyEventCount() noexcept;
+
 #ifdef UNIT_TESTING
     friend class InputBufferTests;
 #endif
@@ -0,0 +1,161 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- inputRecordRing.hpp
+
+Abstract:
+- queue of input records kept by value in one ring of memory.
+- records can be added and removed at either end. the ring only allocates when it
+  has to grow, so storing an event doesn't cost an allocation of its own.
+--*/
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+class InputRecordRing final
+{
+public:
+    InputRecordRing() noexcept :
+        _records{},
+        _head{ 0 },
+        _size{ 0 }
+    {
+    }
+
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    INPUT_RECORD& operator[](const size_t index) noexcept
+    {
+        return _records[_Physical(index)];
+    }
+
+    const INPUT_RECORD& operator[](const size_t index) const noexcept
+    {
+        return _records[_Physical(index)];
+    }
+
+    INPUT_RECORD& front() noexcept
+    {
+        return (*this)[0];
+    }
+
+    const INPUT_RECORD& front() const noexcept
+    {
+        return (*this)[0];
+    }
+
+    INPUT_RECORD& back() noexcept
+    {
+        return (*this)[_size - 1];
+    }
+
+    const INPUT_RECORD& back() const noexcept
+    {
+        return (*this)[_size - 1];
+    }
+
+    // Routine Description:
+    // - Adds a record after the last one.
+    // Note:
+    // - will throw if the ring needs to grow and can't
+    void push_back(const INPUT_RECORD& record)
+    {
+        reserve(_size + 1);
+        _records[_Physical(_size)] = record;
+        ++_size;
+    }
+
+    // Routine Description:
+    // - Adds a record in front of the first one.
+    // Note:
+    // - will throw if the ring needs to grow and can't
+    void push_front(const INPUT_RECORD& record)
+    {
+        reserve(_size + 1);
+        _head = (_head + _records.size() - 1) % _records.size();
+        _records[_head] = record;
+        ++_size;
+    }
+
+    // Routine Description:
+    // - Makes room for at least capacity records, so that pushing up to that many doesn't grow
+    //   the ring again. It at least doubles when it grows. The records are laid out again from
+    //   the start of the new ring.
+    // Note:
+    // - will throw if the ring can't grow
+    void reserve(const size_t capacity)
+    {
+        if (capacity <= _records.size())
+        {
+            return;
+        }
+
+        std::vector<INPUT_RECORD> grown(std::max({ MinimumCapacity, _records.size() * 2, capacity }));
+        for (size_t i = 0; i < _size; ++i)
+        {
+            grown[i] = (*this)[i];
+        }
+        _records.swap(grown);
+        _head = 0;
+    }
+
+    void pop_front() noexcept
+    {
+        _head = (_head + 1) % _records.size();
+        --_size;
+    }
+
+    void clear() noexcept
+    {
+        _head = 0;
+        _size = 0;
+    }
+
+    // Routine Description:
+    // - Removes every record that the predicate matches, keeping the order of the rest.
+    template<typename Predicate>
+    void remove_if(Predicate&& predicate)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < _size; ++i)
+        {
+            if (!predicate((*this)[i]))
+            {
+                (*this)[kept] = (*this)[i];
+                ++kept;
+            }
+        }
+        _size = kept;
+    }
+
+    void swap(InputRecordRing& other) noexcept
+    {
+        _records.swap(other._records);
+        std::swap(_head, other._head);
+        std::swap(_size, other._size);
+    }
+
+private:
+    std::vector<INPUT_RECORD> _records;
+    size_t _head; // where the first record is in _records
+    size_t _size;
+
+    static constexpr size_t MinimumCapacity = 64;
+
+    size_t _Physical(const size_t index) const noexcept
+    {
+        return (_head + index) % _records.size();
+    }
+};
@@ -59,6 +59,8 @@ void SetConsoleCPInfo(const BOOL fOutput)
         {
             gci.OutputCPInfo.LeadByte[0] = 0;
         }
+
+        gci.OutputCPTable.Reset(gci.OutputCP);
     }
     else
     {
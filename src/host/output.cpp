@@ -75,26 +75,10 @@ static void _CopyRectangle(SCREEN_INFORMATION& screenInfo,
         return;
     }
 
-    // 1. If we're copying entire rows of the buffer and moving them directly up or down,
-    //    then we can send a rotate command to the underlying buffer to just adjust the
-    //    row locations instead of copying or moving anything.
-    {
-        const auto bufferSize = screenInfo.GetBufferSize().Dimensions();
-        const auto sourceFullRows = source.Width() == bufferSize.X;
-        const auto verticalCopyOnly = source.Left() == 0 && targetOrigin.X == 0;
-        if (sourceFullRows && verticalCopyOnly)
-        {
-            const auto delta = targetOrigin.Y - source.Top();
-
-            screenInfo.GetTextBuffer().ScrollRows(source.Top(), source.Height(), gsl::narrow<SHORT>(delta));
-
-            return;
-        }
-    }
-
-    // 2. We can move any other scenario in-place without copying. We just have to carefully
+    // 1. We can move any scenario in-place without copying. We just have to carefully
     //    choose which direction we walk through filling up the target so it doesn't accidentally
     //    erase the source material before it can be copied/moved to the new location.
+    //    (Moves of entire rows don't get here, see _CanRotateRows and _CanSwapRows.)
     {
         const auto target = Viewport::FromDimensions(targetOrigin, source.Dimensions());
         const auto walkDirection = Viewport::DetermineWalkDirection(source, target);
@@ -136,32 +120,39 @@ std::vector<WORD> ReadOutputAttributes(const SCREEN_INFORMATION& screenInfo,
         return {};
     }
 
-    // Get iterator to the position we should start reading at.
-    auto it = screenInfo.GetCellDataAt(coordRead);
-    // Count up the number of cells we've attempted to read.
-    ULONG amountRead = 0;
-    // Prepare the return value string.
-    std::vector<WORD> retVal;
-    // Reserve the number of cells. If we have >U+FFFF, it will auto-grow later and that's OK.
-    retVal.reserve(amountToRead);
+    const auto& buffer = screenInfo.GetTextBuffer();
+    const auto bufferSize = buffer.GetSize();
+    const auto width = gsl::narrow<size_t>(bufferSize.Width());
 
-    // While we haven't read enough cells yet and the iterator is still valid (hasn't reached end of buffer)
-    while (amountRead < amountToRead && it)
+    // Read up to the end of the buffer at most.
+    const auto cellsLeft = width * (bufferSize.BottomExclusive() - coordRead.Y) - coordRead.X;
+    std::vector<WORD> retVal(std::min(amountToRead, cellsLeft));
+
+    // Each row's colors are copied a run at a time, then the lead and trailing byte flags are added on top.
+    size_t amountRead = 0;
+    for (auto pos = coordRead; amountRead < retVal.size(); pos.X = 0, ++pos.Y)
     {
-        // If the first thing we read is trailing, pad with a space.
-        // OR If the last thing we read is leading, pad with a space.
-        if ((amountRead == 0 && it->DbcsAttr().IsTrailing()) ||
-            (amountRead == (amountToRead - 1) && it->DbcsAttr().IsLeading()))
-        {
-            retVal.push_back(it->TextAttr().GetLegacyAttributes());
-        }
-        else
+        const auto& row = buffer.GetRowByOffset(pos.Y);
+        const auto count = std::min(retVal.size() - amountRead, width - pos.X);
+        row.GetAttrRow().CopyLegacyAttrs(pos.X, retVal.data() + amountRead, count);
+
+        const auto& charRow = row.GetCharRow();
+        for (size_t i = 0; i < count; ++i)
         {
-            retVal.push_back(it->TextAttr().GetLegacyAttributes() | it->DbcsAttr().GeneratePublicApiAttributeFormat());
-        }
+            const auto index = amountRead + i;
+            const auto dbcsAttr = charRow.DbcsAttrAt(pos.X + i);
 
-        amountRead++;
-        it++;
+            // If the first thing we read is trailing, pad with a space.
+            // OR If the last thing we read is leading, pad with a space.
+            if ((index == 0 && dbcsAttr.IsTrailing()) ||
+                (index == (amountToRead - 1) && dbcsAttr.IsLeading()))
+            {
+                continue;
+            }
+
+            retVal[index] |= dbcsAttr.GeneratePublicApiAttributeFormat();
+        }
+        amountRead += count;
     }
 
     return retVal;
@@ -259,6 +250,73 @@ void ScreenBufferSizeChange(const COORD coordNewSize)
     }
 }
 
+// Routine Description:
+// - Determines whether a move can be done by rotating whole rows of the buffer around
+//   instead of copying cells. That's what scrolling within the margins (SU/SD, IL/DL,
+//   reverse index, line feeds at the bottom margin) always turns into.
+// Arguments:
+// - screenInfo - The relevant screen buffer
+// - source - The viewport describing the region to move
+// - fill - The viewport describing the area that will be filled in afterwards
+// - target - The viewport describing the region to move it to
+// Return Value:
+// - true if the move can be done with TextBuffer::ScrollRows
+static bool _CanRotateRows(const SCREEN_INFORMATION& screenInfo, const Viewport& source, const Viewport& fill, const Viewport& target)
+{
+    const auto bufferWidth = screenInfo.GetBufferSize().Width();
+    const auto delta = target.Top() - source.Top();
+
+    // Only entire rows moving directly up or down can be rotated.
+    if (source.Left() != 0 || target.Left() != 0 || source.Width() != bufferWidth || delta == 0)
+    {
+        return false;
+    }
+
+    // The rotation covers everything from the source to the target, so there can't be
+    // any rows in between the two that would be moved along with them.
+    if (std::abs(delta) >= source.Height())
+    {
+        return false;
+    }
+
+    // The rows the source uncovers end up holding what used to be at the target,
+    // so they have to be rows that are filled in right after.
+    const auto uncoveredTop = delta < 0 ? source.BottomInclusive() + delta + 1 : source.Top();
+    const auto uncoveredBottom = delta < 0 ? source.BottomInclusive() : source.Top() + delta - 1;
+    return fill.Left() == 0 &&
+           fill.Width() == bufferWidth &&
+           fill.Top() <= uncoveredTop &&
+           uncoveredBottom <= fill.BottomInclusive();
+}
+
+// Routine Description:
+// - Determines whether a move of whole rows farther than their own height can be done by
+//   swapping the rows with the ones at the target instead of copying cells.
+// Arguments:
+// - screenInfo - The relevant screen buffer
+// - source - The viewport describing the region to move
+// - fill - The viewport describing the area that will be filled in afterwards
+// - target - The viewport describing the region to move it to
+// Return Value:
+// - true if the move can be done with TextBuffer::SwapRows
+static bool _CanSwapRows(const SCREEN_INFORMATION& screenInfo, const Viewport& source, const Viewport& fill, const Viewport& target)
+{
+    const auto bufferWidth = screenInfo.GetBufferSize().Width();
+
+    if (source.Left() != 0 || target.Left() != 0 || source.Width() != bufferWidth)
+    {
+        return false;
+    }
+
+    // Whatever used to be at the target ends up in the source rows,
+    // so all of them have to be filled in right after.
+    return std::abs(target.Top() - source.Top()) >= source.Height() &&
+           fill.Left() == 0 &&
+           fill.Width() == bufferWidth &&
+           fill.Top() <= source.Top() &&
+           source.BottomInclusive() <= fill.BottomInclusive();
+}
+
 // Routine Description:
 // - This is simply a notifier method to let accessibility and renderers know that a region of the buffer
 //   has been copied/moved to another location in a block fashion.
@@ -267,7 +325,8 @@ void ScreenBufferSizeChange(const COORD coordNewSize)
 // - source - The viewport describing the region where data was copied from
 // - fill - The viewport describing the area that was filled in with the fill character (uncovered area)
 // - target - The viewport describing the region where data was copied to
-static void _ScrollScreen(SCREEN_INFORMATION& screenInfo, const Viewport& source, const Viewport& fill, const Viewport& target)
+// - rowsRotated - True if the move was done by rotating whole rows (see _CanRotateRows)
+static void _ScrollScreen(SCREEN_INFORMATION& screenInfo, const Viewport& source, const Viewport& fill, const Viewport& target, const bool rowsRotated)
 {
     if (screenInfo.IsActiveScreenBuffer())
     {
@@ -281,8 +340,34 @@ static void _ScrollScreen(SCREEN_INFORMATION& screenInfo, const Viewport& source
     // Get the render target and send it commands.
     // It will figure out whether or not we're active and where the messages need to go.
     auto& render = screenInfo.GetRenderTarget();
-    // Redraw anything in the target area
-    render.TriggerRedraw(target);
+
+    // If every row in view either moved by the same amount or is about to be filled,
+    // the renderers can shift what they already have instead of redrawing all of it.
+    const auto viewport = screenInfo.GetViewport();
+    if (rowsRotated &&
+        std::min(source.Top(), target.Top()) <= viewport.Top() &&
+        std::max(source.BottomInclusive(), target.BottomInclusive()) >= viewport.BottomInclusive())
+    {
+        COORD coordDelta = { 0 };
+        coordDelta.Y = target.Top() - source.Top();
+        render.TriggerScroll(&coordDelta);
+    }
+    else if (rowsRotated)
+    {
+        // Only some of the rows in view moved, like when scrolling within the margins.
+        // The renderers can still shift what they have of those rows.
+        const auto rows = Viewport::FromInclusive({ source.Left(),
+                                                    std::min(source.Top(), target.Top()),
+                                                    source.RightInclusive(),
+                                                    std::max(source.BottomInclusive(), target.BottomInclusive()) });
+        render.TriggerScrollRows(rows, target.Top() - source.Top());
+    }
+    else
+    {
+        // Redraw anything in the target area
+        render.TriggerRedraw(target);
+    }
+
     // Also redraw anything that was filled.
     render.TriggerRedraw(fill);
 }
@@ -392,13 +477,15 @@ void ScrollRegion(SCREEN_INFORMATION& screenInfo,
 
     // Determine the cell we will use to fill in any revealed/uncovered space.
     // We generally use exactly what was given to us.
-    OutputCellIterator fillData(fillCharGiven, fillAttrsGiven);
+    auto fillChar = fillCharGiven;
+    auto fillAttrs = fillAttrsGiven;
 
     // However, if the character is null and we were given a null attribute (represented as legacy 0),
     // then we'll just fill with spaces and whatever the buffer's default colors are.
     if (fillCharGiven == UNICODE_NULL && fillAttrsGiven.IsLegacy() && fillAttrsGiven.GetLegacyAttributes() == 0)
     {
-        fillData = OutputCellIterator(UNICODE_SPACE, screenInfo.GetAttributes());
+        fillChar = UNICODE_SPACE;
+        fillAttrs = screenInfo.GetAttributes();
     }
 
     // ------ 4. PREP TARGET ------
@@ -452,11 +539,26 @@ void ScrollRegion(SCREEN_INFORMATION& screenInfo,
     // If the target region is valid, let's do this.
     if (target.IsValid())
     {
-        // Perform the copy from the source to the target.
-        _CopyRectangle(screenInfo, source, target.Origin());
+        // Perform the copy from the source to the target. Whole rows are just rotated
+        // into place within the buffer, without copying any of their cells.
+        const auto rowsRotated = _CanRotateRows(screenInfo, source, fill, target);
+        if (rowsRotated)
+        {
+            const auto delta = target.Top() - source.Top();
+            screenInfo.GetTextBuffer().ScrollRows(source.Top(), source.Height(), gsl::narrow<SHORT>(delta));
+        }
+        else if (_CanSwapRows(screenInfo, source, fill, target))
+        {
+            // The rows in between didn't move, so this is redrawn like a copy.
+            screenInfo.GetTextBuffer().SwapRows(source.Top(), target.Top(), source.Height());
+        }
+        else
+        {
+            _CopyRectangle(screenInfo, source, target.Origin());
+        }
 
         // Notify the renderer and accessibility as to what moved and where.
-        _ScrollScreen(screenInfo, source, fill, target);
+        _ScrollScreen(screenInfo, source, fill, target, rowsRotated);
     }
 
     // ------ 6. FILL ------
@@ -472,20 +574,87 @@ void ScrollRegion(SCREEN_INFORMATION& screenInfo,
     for (size_t i = 0; i < remaining.size(); i++)
     {
         const auto& view = remaining.at(i);
-        screenInfo.WriteRect(fillData, view);
+        screenInfo.GetTextBuffer().FillRect(view, fillChar, fillAttrs);
     }
 }
 
+// Routine Description:
+// - Redraws only the parts of the viewport of the newly active buffer that look different
+//   from what the previously active buffer was showing in the same place.
+// Arguments:
+// - previous - The buffer that was on the screen until now
+// - screenInfo - The buffer that is now active
+// Return Value:
+// - true if the changed cells were redrawn, false if the viewports can't be compared and
+//   the whole viewport still needs to be written.
+static bool _RedrawChangedCells(const SCREEN_INFORMATION& previous, SCREEN_INFORMATION& screenInfo)
+{
+    const auto previousView = previous.GetViewport();
+    const auto view = screenInfo.GetViewport();
+    if (previousView.Dimensions() != view.Dimensions())
+    {
+        return false;
+    }
+
+    for (SHORT row = 0; row < view.Height(); row++)
+    {
+        const SHORT previousY = gsl::narrow_cast<SHORT>(previousView.Top() + row);
+        const SHORT y = gsl::narrow_cast<SHORT>(view.Top() + row);
+        auto previousIt = previous.GetCellDataAt({ previousView.Left(), previousY }, previousView);
+        auto it = screenInfo.GetCellDataAt({ view.Left(), y }, view);
+
+        // Find the first and last columns that differ, redraw everything between them.
+        SHORT first = -1;
+        SHORT last = -1;
+        for (SHORT col = 0; col < view.Width() && previousIt && it; col++, previousIt++, it++)
+        {
+            if (!(*previousIt == *it))
+            {
+                if (first < 0)
+                {
+                    first = col;
+                }
+                last = col;
+            }
+        }
+
+        if (first >= 0)
+        {
+            const SMALL_RECT changed{ gsl::narrow_cast<SHORT>(view.Left() + first), y, gsl::narrow_cast<SHORT>(view.Left() + last), y };
+            WriteToScreen(screenInfo, Viewport::FromInclusive(changed));
+        }
+    }
+
+    // The cursor of the previous buffer may still be drawn, erase it.
+    const auto previousCursor = previous.GetTextBuffer().GetCursor().GetPosition();
+    if (previousView.IsInBounds(previousCursor))
+    {
+        const COORD cell{ gsl::narrow_cast<SHORT>(previousCursor.X - previousView.Left() + view.Left()),
+                          gsl::narrow_cast<SHORT>(previousCursor.Y - previousView.Top() + view.Top()) };
+        WriteToScreen(screenInfo, Viewport::FromCoord(cell));
+    }
+
+    return true;
+}
+
 void SetActiveScreenBuffer(SCREEN_INFORMATION& screenInfo)
 {
     CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    const SCREEN_INFORMATION* const pPrevious = gci.HasActiveOutputBuffer() ? &gci.GetActiveOutputBuffer() : nullptr;
     gci.pCurrentScreenBuffer = &screenInfo;
 
     // initialize cursor
     screenInfo.GetTextBuffer().GetCursor().SetIsOn(false);
 
     // set font
-    screenInfo.RefreshFontWithRenderer();
+    // A font change makes the renderer repaint everything, so don't ask for one the screen already has.
+    const bool sameFont = pPrevious != nullptr &&
+                          pPrevious->GetDesiredFont() == screenInfo.GetDesiredFont() &&
+                          pPrevious->GetCurrentFont() == screenInfo.GetCurrentFont();
+    if (!sameFont)
+    {
+        screenInfo.RefreshFontWithRenderer();
+    }
 
     // Empty input buffer.
     gci.pInputBuffer->FlushAllButKeys();
@@ -496,7 +665,12 @@ void SetActiveScreenBuffer(SCREEN_INFORMATION& screenInfo)
     gci.ConsoleIme.RefreshAreaAttributes();
 
     // Write data to screen.
-    WriteToScreen(screenInfo, screenInfo.GetViewport());
+    // Coming from another buffer of the same shape with the same font, only the cells that
+    // differ between the two need to be painted again.
+    if (!sameFont || pPrevious == &screenInfo || !_RedrawChangedCells(*pPrevious, screenInfo))
+    {
+        WriteToScreen(screenInfo, screenInfo.GetViewport());
+    }
 }
 
 // TODO: MSFT 9450717 This should join the ProcessList class when CtrlEvents become moved into the server. https://osgvsowi/9450717
@@ -595,6 +595,20 @@ BOOL ConhostInternalGetSet::PrivateEnableAlternateScroll(const bool fEnabled)
     return TRUE;
 }
 
+// Routine Description:
+// - Connects the PrivateEnableSynchronizedUpdate call directly into our Driver Message servicing call inside Conhost.exe
+//   PrivateEnableSynchronizedUpdate is an internal-only "API" call that the vt commands can execute,
+//     but it is not represented as a function call on our public API surface.
+// Arguments:
+// - fEnabled - true to begin a synchronized update, false to end it.
+// Return Value:
+// - TRUE if successful (see DoSrvPrivateEnableSynchronizedUpdate). FALSE otherwise.
+BOOL ConhostInternalGetSet::PrivateEnableSynchronizedUpdate(const bool fEnabled)
+{
+    DoSrvPrivateEnableSynchronizedUpdate(fEnabled);
+    return TRUE;
+}
+
 // Routine Description:
 // - Connects the PrivateEraseAll call directly into our Driver Message servicing call inside Conhost.exe
 //   PrivateEraseAll is an internal-only "API" call that the vt commands can execute,
@@ -608,6 +622,21 @@ BOOL ConhostInternalGetSet::PrivateEraseAll()
     return NT_SUCCESS(DoSrvPrivateEraseAll(_io.GetActiveOutputBuffer()));
 }
 
+// Routine Description:
+// - Connects the PrivateFillRect call directly into our Driver Message servicing call inside Conhost.exe
+//   PrivateFillRect is an internal-only "API" call that the vt commands can execute,
+//     but it is not represented as a function call on our public API surface.
+// Arguments:
+// - psrFill - The rectangle to fill, inclusive.
+// - wch - The character to fill it with.
+// - wAttr - The attributes to fill it with.
+// Return Value:
+// - TRUE if successful (see DoSrvPrivateFillRect). FALSE otherwise.
+BOOL ConhostInternalGetSet::PrivateFillRect(const SMALL_RECT* const psrFill, const WCHAR wch, const WORD wAttr)
+{
+    return SUCCEEDED(DoSrvPrivateFillRect(_io.GetActiveOutputBuffer(), *psrFill, wch, wAttr));
+}
+
 // Routine Description:
 // - Connects the SetCursorStyle call directly into our Driver Message servicing call inside Conhost.exe
 //   SetCursorStyle is an internal-only "API" call that the vt commands can execute,
@@ -634,6 +663,43 @@ BOOL ConhostInternalGetSet::PrivateGetConsoleScreenBufferAttributes(_Out_ WORD*
     return NT_SUCCESS(DoSrvPrivateGetConsoleScreenBufferAttributes(_io.GetActiveOutputBuffer(), pwAttributes));
 }
 
+// Routine Description:
+// - Retrieves the cursor position of the active screen buffer, relative to the whole buffer.
+// - This function is used to optimize cursor movement in lieu of calling GetConsoleScreenBufferInfoEx.
+// Arguments:
+// - pCursorPosition - Pointer to space to receive the cursor position
+// Return Value:
+// - TRUE if successful. FALSE otherwise.
+BOOL ConhostInternalGetSet::PrivateGetCursorPosition(_Out_ COORD* const pCursorPosition) const
+{
+    if (pCursorPosition == nullptr)
+    {
+        return FALSE;
+    }
+
+    *pCursorPosition = _io.GetActiveOutputBuffer().GetActiveBuffer().GetTextBuffer().GetCursor().GetPosition();
+    return TRUE;
+}
+
+// Routine Description:
+// - Retrieves the viewport of the active screen buffer.
+// - This function is used to optimize cursor movement in lieu of calling GetConsoleScreenBufferInfoEx.
+// Arguments:
+// - psrViewport - Pointer to space to receive the viewport. Like the srWindow that
+//      GetConsoleScreenBufferInfoEx returns, it's an exclusive rectangle.
+// Return Value:
+// - TRUE if successful. FALSE otherwise.
+BOOL ConhostInternalGetSet::PrivateGetViewport(_Out_ SMALL_RECT* const psrViewport) const
+{
+    if (psrViewport == nullptr)
+    {
+        return FALSE;
+    }
+
+    *psrViewport = _io.GetActiveOutputBuffer().GetActiveBuffer().GetViewport().ToExclusive();
+    return TRUE;
+}
+
 // Routine Description:
 // - Connects the PrivatePrependConsoleInput API call directly into our Driver Message servicing call inside Conhost.exe
 // Arguments:
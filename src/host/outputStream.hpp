@@ -22,7 +22,7 @@ Author:
 class SCREEN_INFORMATION;
 
 // The WriteBuffer class provides helpers for writing text into the TextBuffer that is backing a particular console screen buffer.
-class WriteBuffer : public Microsoft::Console::VirtualTerminal::AdaptDefaults
+class WriteBuffer final : public Microsoft::Console::VirtualTerminal::AdaptDefaults
 {
 public:
     WriteBuffer(_In_ Microsoft::Console::IIoProvider& io);
@@ -130,9 +130,13 @@ public:
     BOOL PrivateEnableButtonEventMouseMode(const bool fEnabled) override;
     BOOL PrivateEnableAnyEventMouseMode(const bool fEnabled) override;
     BOOL PrivateEnableAlternateScroll(const bool fEnabled) override;
+    BOOL PrivateEnableSynchronizedUpdate(const bool fEnabled) override;
     BOOL PrivateEraseAll() override;
+    BOOL PrivateFillRect(const SMALL_RECT* const psrFill, const WCHAR wch, const WORD wAttr) override;
 
     BOOL PrivateGetConsoleScreenBufferAttributes(_Out_ WORD* const pwAttributes) override;
+    BOOL PrivateGetCursorPosition(_Out_ COORD* const pCursorPosition) const override;
+    BOOL PrivateGetViewport(_Out_ SMALL_RECT* const psrViewport) const override;
 
     BOOL PrivatePrependConsoleInput(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& events,
                                     _Out_ size_t& eventsWritten) override;
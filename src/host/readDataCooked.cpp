@@ -703,33 +703,93 @@ bool COOKED_READ_DATA::ProcessInput(const wchar_t wchOrig,
         {
             COORD CursorPosition;
 
+            // the cursor is on the first character that changed: the one just
+            // stored, or the one after what was just erased.
+            const COORD editPosition = _screenInfo.GetTextBuffer().GetCursor().GetPosition();
+            const size_t editIndex = (wch == UNICODE_BACKSPACE && _processedInput) ? _currentPosition : _currentPosition - 1;
+
             // save cursor position
-            CursorPosition = _screenInfo.GetTextBuffer().GetCursor().GetPosition();
+            CursorPosition = editPosition;
             CursorPosition.X = (SHORT)(CursorPosition.X + NumSpaces);
 
-            // clear the current command line from the screen
-            // clang-format off
-#pragma prefast(suppress: __WARNING_BUFFER_OVERFLOW, "Not sure why prefast doesn't like this call.")
-            // clang-format on
-            DeleteCommandLine(*this, FALSE);
-
-            // write the new command line to the screen
-            NumToWrite = _bytesRead;
+            // Everything in front of the edit is still on the screen as it was, so
+            // only the rest of the line needs to be cleared and written again. That
+            // keeps typing into a very long line from redrawing all of it each time.
+            // At either edge of the screen a wide character may have been moved to
+            // the next row to keep it whole, so the whole line is redrawn there.
+            size_t cellsBeforeEdit = 0;
+            bool redrawFromEdit = false;
+            if (wch != UNICODE_CARRIAGERETURN &&
+                _originalCursorPosition.Y >= 0 &&
+                editPosition.X > 0 &&
+                editPosition.X < sScreenBufferSizeX - 1 &&
+                (editPosition.Y > _originalCursorPosition.Y ||
+                 (editPosition.Y == _originalCursorPosition.Y && editPosition.X >= _originalCursorPosition.X)))
+            {
+                cellsBeforeEdit = gsl::narrow_cast<size_t>((editPosition.Y - _originalCursorPosition.Y) * sScreenBufferSizeX +
+                                                           editPosition.X - _originalCursorPosition.X);
+                redrawFromEdit = cellsBeforeEdit <= _visibleCharCount;
+            }
 
             DWORD dwFlags = WC_DESTRUCTIVE_BACKSPACE | WC_ECHO;
             if (wch == UNICODE_CARRIAGERETURN)
             {
                 dwFlags |= WC_KEEP_CURSOR_VISIBLE;
             }
-            status = WriteCharsLegacy(_screenInfo,
-                                      _backupLimit,
-                                      _backupLimit,
-                                      _backupLimit,
-                                      &NumToWrite,
-                                      &_visibleCharCount,
-                                      _originalCursorPosition.X,
-                                      dwFlags,
-                                      &ScrollY);
+
+            if (redrawFromEdit)
+            {
+                // clear the rest of the command line from the screen
+                size_t CharsToClear = _visibleCharCount - cellsBeforeEdit;
+                if (!CheckBisectStringW(_backupLimit,
+                                        _visibleCharCount,
+                                        sScreenBufferSizeX - _originalCursorPosition.X))
+                {
+                    CharsToClear++;
+                }
+
+                try
+                {
+                    _screenInfo.Write(OutputCellIterator(UNICODE_SPACE, CharsToClear), editPosition);
+                }
+                CATCH_LOG();
+
+                // write the rest of the new command line to the screen
+                NumToWrite = _bytesRead - (editIndex * sizeof(WCHAR));
+
+                size_t cellsFromEdit = 0;
+                status = WriteCharsLegacy(_screenInfo,
+                                          _backupLimit,
+                                          _backupLimit + editIndex,
+                                          _backupLimit + editIndex,
+                                          &NumToWrite,
+                                          &cellsFromEdit,
+                                          _originalCursorPosition.X,
+                                          dwFlags,
+                                          &ScrollY);
+                _visibleCharCount = cellsBeforeEdit + cellsFromEdit;
+            }
+            else
+            {
+                // clear the current command line from the screen
+                // clang-format off
+#pragma prefast(suppress: __WARNING_BUFFER_OVERFLOW, "Not sure why prefast doesn't like this call.")
+                // clang-format on
+                DeleteCommandLine(*this, FALSE);
+
+                // write the new command line to the screen
+                NumToWrite = _bytesRead;
+
+                status = WriteCharsLegacy(_screenInfo,
+                                          _backupLimit,
+                                          _backupLimit,
+                                          _backupLimit,
+                                          &NumToWrite,
+                                          &_visibleCharCount,
+                                          _originalCursorPosition.X,
+                                          dwFlags,
+                                          &ScrollY);
+            }
             if (!NT_SUCCESS(status))
             {
                 RIPMSG1(RIP_WARNING, "WriteCharsLegacy failed 0x%x", status);
@@ -160,23 +160,16 @@ bool RAW_READ_DATA::Notify(const WaitTerminationReason TerminationReason,
             NumBytes += IsGlyphFullWidth(*lpBuffer) ? 2 : 1;
             lpBuffer++;
             *pNumBytes += sizeof(WCHAR);
-            while (*pNumBytes < _BufferSize)
+            if (*pNumBytes < _BufferSize)
             {
-                // This call to GetChar won't block.
-                *pReplyStatus = GetChar(_pInputBuffer,
-                                        lpBuffer,
-                                        false,
-                                        nullptr,
-                                        nullptr,
-                                        nullptr);
-                if (!NT_SUCCESS(*pReplyStatus))
+                // Take the rest of what's available in one go. This won't block.
+                const auto charsRead = GetChars(*_pInputBuffer, { lpBuffer, gsl::narrow_cast<ptrdiff_t>((_BufferSize - *pNumBytes) / sizeof(WCHAR)) });
+                for (size_t i = 0; i < charsRead; ++i)
                 {
-                    *pReplyStatus = STATUS_SUCCESS;
-                    break;
+                    NumBytes += IsGlyphFullWidth(lpBuffer[i]) ? 2 : 1;
                 }
-                NumBytes += IsGlyphFullWidth(*lpBuffer) ? 2 : 1;
-                lpBuffer++;
-                *pNumBytes += sizeof(WCHAR);
+                lpBuffer += charsRead;
+                *pNumBytes += charsRead * sizeof(WCHAR);
             }
         }
     }
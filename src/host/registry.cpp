@@ -125,7 +125,7 @@ void Registry::GetEditKeys(_In_opt_ HKEY hConsoleKey) const
 
 void Registry::_LoadMappedProperties(_In_reads_(cPropertyMappings) const RegistrySerialization::RegPropertyMap* const rgPropertyMappings,
                                      const size_t cPropertyMappings,
-                                     const HKEY hKey)
+                                     const RegistrySerialization::KeyValues& values)
 {
     // Iterate through properties table and load each setting for common property types
     for (UINT iMapping = 0; iMapping < cPropertyMappings; iMapping++)
@@ -142,12 +142,12 @@ void Registry::_LoadMappedProperties(_In_reads_(cPropertyMappings) const Registr
         case RegistrySerialization::_RegPropertyType::Byte:
         case RegistrySerialization::_RegPropertyType::Coordinate:
         {
-            Status = RegistrySerialization::s_LoadRegDword(hKey, pPropMap, _pSettings);
+            Status = RegistrySerialization::s_LoadRegDword(values, pPropMap, _pSettings);
             break;
         }
         case RegistrySerialization::_RegPropertyType::String:
         {
-            Status = RegistrySerialization::s_LoadRegString(hKey, pPropMap, _pSettings);
+            Status = RegistrySerialization::s_LoadRegString(values, pPropMap, _pSettings);
             break;
         }
         }
@@ -174,7 +174,9 @@ void Registry::LoadGlobalsFromRegistry()
 
     if (NT_SUCCESS(status))
     {
-        _LoadMappedProperties(RegistrySerialization::s_GlobalPropMappings, RegistrySerialization::s_GlobalPropMappingsSize, hConsoleKey);
+        RegistrySerialization::KeyValues values;
+        LOG_IF_NTSTATUS_FAILED(values.Load(hConsoleKey));
+        _LoadMappedProperties(RegistrySerialization::s_GlobalPropMappings, RegistrySerialization::s_GlobalPropMappingsSize, values);
 
         RegCloseKey((HKEY)hConsoleKey);
         RegCloseKey((HKEY)hCurrentUserKey);
@@ -245,20 +247,24 @@ void Registry::LoadFromRegistry(_In_ PCWSTR const pwszConsoleTitle)
         return;
     }
 
+    // Read everything under the title key at once. All the properties below are answered from this copy.
+    // If that fails, nothing is found and the settings are left as they were.
+    RegistrySerialization::KeyValues values;
+    LOG_IF_NTSTATUS_FAILED(values.Load(hTitleKey));
+
     // Iterate through properties table and load each setting for common property types
-    _LoadMappedProperties(RegistrySerialization::s_PropertyMappings, RegistrySerialization::s_PropertyMappingsSize, hTitleKey);
+    _LoadMappedProperties(RegistrySerialization::s_PropertyMappings, RegistrySerialization::s_PropertyMappingsSize, values);
 
     // Now load complex properties
     // Some properties shouldn't be filled by the registry if a copy already exists from the process start information.
     DWORD dwValue;
 
     // Window Origin Autopositioning Setting
-    Status = RegistrySerialization::s_QueryValue(hTitleKey,
-                                                 CONSOLE_REGISTRY_WINDOWPOS,
-                                                 sizeof(dwValue),
-                                                 REG_DWORD,
-                                                 (PBYTE)&dwValue,
-                                                 nullptr);
+    Status = values.QueryValue(CONSOLE_REGISTRY_WINDOWPOS,
+                               sizeof(dwValue),
+                               REG_DWORD,
+                               (PBYTE)&dwValue,
+                               nullptr);
 
     if (NT_SUCCESS(Status))
     {
@@ -269,12 +275,11 @@ void Registry::LoadFromRegistry(_In_ PCWSTR const pwszConsoleTitle)
     //      HOWEVER, the defaults might not have been auto-pos, so don't assume that they are.
 
     // Code Page
-    Status = RegistrySerialization::s_QueryValue(hTitleKey,
-                                                 CONSOLE_REGISTRY_CODEPAGE,
-                                                 sizeof(dwValue),
-                                                 REG_DWORD,
-                                                 (PBYTE)&dwValue,
-                                                 nullptr);
+    Status = values.QueryValue(CONSOLE_REGISTRY_CODEPAGE,
+                               sizeof(dwValue),
+                               REG_DWORD,
+                               (PBYTE)&dwValue,
+                               nullptr);
     if (NT_SUCCESS(Status))
     {
         _pSettings->SetCodePage(dwValue);
@@ -302,12 +307,11 @@ void Registry::LoadFromRegistry(_In_ PCWSTR const pwszConsoleTitle)
     {
         WCHAR awchBuffer[64];
         StringCchPrintfW(awchBuffer, ARRAYSIZE(awchBuffer), CONSOLE_REGISTRY_COLORTABLE, i);
-        Status = RegistrySerialization::s_QueryValue(hTitleKey,
-                                                     awchBuffer,
-                                                     sizeof(dwValue),
-                                                     REG_DWORD,
-                                                     (PBYTE)&dwValue,
-                                                     nullptr);
+        Status = values.QueryValue(awchBuffer,
+                                   sizeof(dwValue),
+                                   REG_DWORD,
+                                   (PBYTE)&dwValue,
+                                   nullptr);
         if (NT_SUCCESS(Status))
         {
             _pSettings->SetColorTableEntry(i, dwValue);
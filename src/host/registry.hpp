@@ -35,7 +35,7 @@ public:
 private:
     void _LoadMappedProperties(_In_reads_(cPropertyMappings) const RegistrySerialization::RegPropertyMap* const rgPropertyMappings,
                                const size_t cPropertyMappings,
-                               const HKEY hKey);
+                               const RegistrySerialization::KeyValues& values);
 
     Settings* const _pSettings;
 };
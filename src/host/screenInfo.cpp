@@ -9,6 +9,7 @@
 #include "_output.h"
 #include "misc.h"
 #include "handle.h"
+#include "_stream.h"
 #include "../buffer/out/CharRow.hpp"
 
 #include <math.h>
@@ -52,6 +53,7 @@ SCREEN_INFORMATION::SCREEN_INFORMATION(
     _viewport(Viewport::Empty()),
     _psiAlternateBuffer{ nullptr },
     _psiMainBuffer{ nullptr },
+    _psiSpareAlternateBuffer{ nullptr },
     _rcAltSavedClientNew{ 0 },
     _rcAltSavedClientOld{ 0 },
     _fAltWindowChanged{ false },
@@ -84,7 +86,9 @@ SCREEN_INFORMATION::SCREEN_INFORMATION(
 // - console handle table lock must be held when calling this routine
 SCREEN_INFORMATION::~SCREEN_INFORMATION()
 {
+    DiscardPendingWrites(*this);
     _FreeOutputStateMachine();
+    delete _psiSpareAlternateBuffer;
 }
 
 // Routine Description:
@@ -221,6 +225,34 @@ void SCREEN_INFORMATION::s_InsertScreenBuffer(_In_ SCREEN_INFORMATION* const pSc
 // Note:
 // - The console lock must be held when calling this routine.
 void SCREEN_INFORMATION::s_RemoveScreenBuffer(_In_ SCREEN_INFORMATION* const pScreenInfo)
+{
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    s_UnlinkScreenBuffer(pScreenInfo);
+
+    if (pScreenInfo == gci.pCurrentScreenBuffer &&
+        gci.ScreenBuffers != gci.pCurrentScreenBuffer)
+    {
+        if (gci.ScreenBuffers != nullptr)
+        {
+            SetActiveScreenBuffer(*gci.ScreenBuffers);
+        }
+        else
+        {
+            gci.pCurrentScreenBuffer = nullptr;
+        }
+    }
+
+    delete pScreenInfo;
+}
+
+// Routine Description:
+// - This routine takes the screen buffer pointer out of the console's list of screen buffers, without deleting it.
+// Arguments:
+// - ScreenInfo - Pointer to screen information structure.
+// Return Value:
+// Note:
+// - The console lock must be held when calling this routine.
+void SCREEN_INFORMATION::s_UnlinkScreenBuffer(_In_ SCREEN_INFORMATION* const pScreenInfo)
 {
     CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
     if (pScreenInfo == gci.ScreenBuffers)
@@ -246,20 +278,7 @@ void SCREEN_INFORMATION::s_RemoveScreenBuffer(_In_ SCREEN_INFORMATION* const pSc
         Prev->Next = Cur->Next;
     }
 
-    if (pScreenInfo == gci.pCurrentScreenBuffer &&
-        gci.ScreenBuffers != gci.pCurrentScreenBuffer)
-    {
-        if (gci.ScreenBuffers != nullptr)
-        {
-            SetActiveScreenBuffer(*gci.ScreenBuffers);
-        }
-        else
-        {
-            gci.pCurrentScreenBuffer = nullptr;
-        }
-    }
-
-    delete pScreenInfo;
+    pScreenInfo->Next = nullptr;
 }
 
 #pragma endregion
@@ -578,52 +597,133 @@ void SCREEN_INFORMATION::UpdateFont(const FontInfo* const pfiNewFont)
     }
 }
 
-// NOTE: This method was historically used to notify accessibility apps AND
-// to aggregate drawing metadata to determine whether or not to use PolyTextOut.
-// After the Nov 2015 graphics refactor, the metadata drawing flag calculation is no longer necessary.
-// This now only notifies accessibility apps of a change.
+// Routine Description:
+// - Records that a region of the buffer changed so accessibility apps can be told.
+// - Accessibility apps are told from the window's message loop, like the scroll bars
+//   are updated, so every change made before then goes out as one event for the
+//   region covering all of them. Without a window to defer to, they're told right away.
+// Arguments:
+// - sStartX, sStartY - the first cell that changed
+// - sEndX, sEndY - the last cell that changed
+// Note:
+// - This method was historically used to notify accessibility apps AND
+//   to aggregate drawing metadata to determine whether or not to use PolyTextOut.
+//   After the Nov 2015 graphics refactor, the metadata drawing flag calculation is no longer necessary.
+//   This now only notifies accessibility apps of a change.
 void SCREEN_INFORMATION::NotifyAccessibilityEventing(const short sStartX,
                                                      const short sStartY,
                                                      const short sEndX,
                                                      const short sEndY)
 {
-    const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-
-    // Fire off a winevent to let accessibility apps know what changed.
-    if (IsActiveScreenBuffer())
+    if (!IsActiveScreenBuffer())
     {
-        const COORD coordScreenBufferSize = GetBufferSize().Dimensions();
-        FAIL_FAST_IF(!(sEndX < coordScreenBufferSize.X));
+        return;
+    }
+
+    FAIL_FAST_IF(!(sEndX < GetBufferSize().Width()));
 
-        if (sStartX == sEndX && sStartY == sEndY)
+    const SMALL_RECT region{ sStartX, sStartY, sEndX, sEndY };
+    if (_pendingAccessibilityRegion.has_value())
+    {
+        // Regions run from their start to their end in buffer order, so the union is
+        // from the earliest start to the latest end.
+        auto& pending = _pendingAccessibilityRegion.value();
+        if (std::tie(region.Top, region.Left) < std::tie(pending.Top, pending.Left))
         {
-            try
-            {
-                const auto cellData = GetCellDataAt({ sStartX, sStartY });
-                const LONG charAndAttr = MAKELONG(Utf16ToUcs2(cellData->Chars()),
-                                                  gci.GenerateLegacyAttributes(cellData->TextAttr()));
-                _pAccessibilityNotifier->NotifyConsoleUpdateSimpleEvent(MAKELONG(sStartX, sStartY),
-                                                                        charAndAttr);
-            }
-            catch (...)
-            {
-                LOG_HR(wil::ResultFromCaughtException());
-                return;
-            }
+            pending.Left = region.Left;
+            pending.Top = region.Top;
         }
-        else
+        if (std::tie(region.Bottom, region.Right) > std::tie(pending.Bottom, pending.Right))
         {
-            _pAccessibilityNotifier->NotifyConsoleUpdateRegionEvent(MAKELONG(sStartX, sStartY),
-                                                                    MAKELONG(sEndX, sEndY));
+            pending.Right = region.Right;
+            pending.Bottom = region.Bottom;
         }
-        IConsoleWindow* pConsoleWindow = ServiceLocator::LocateConsoleWindow();
-        if (pConsoleWindow)
+    }
+    else
+    {
+        _pendingAccessibilityRegion = region;
+    }
+
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    if (WI_IsFlagSet(gci.Flags, CONSOLE_UPDATING_ACCESSIBILITY))
+    {
+        return;
+    }
+
+    IConsoleWindow* const pConsoleWindow = ServiceLocator::LocateConsoleWindow();
+    if (pConsoleWindow && pConsoleWindow->PostUpdateAccessibility())
+    {
+        WI_SetFlag(gci.Flags, CONSOLE_UPDATING_ACCESSIBILITY);
+    }
+    else
+    {
+        InternalNotifyAccessibilityEventing();
+    }
+}
+
+// Routine Description:
+// - Tells accessibility apps about the region that changed since they were last told.
+void SCREEN_INFORMATION::InternalNotifyAccessibilityEventing()
+{
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    WI_ClearFlag(gci.Flags, CONSOLE_UPDATING_ACCESSIBILITY);
+
+    if (!IsActiveScreenBuffer() || !_pendingAccessibilityRegion.has_value())
+    {
+        return;
+    }
+
+    auto region = _pendingAccessibilityRegion.value();
+    _pendingAccessibilityRegion.reset();
+
+    // The buffer may have been resized since the change was recorded.
+    const auto bufferSize = GetBufferSize();
+    if (region.Top > bufferSize.BottomInclusive() || region.Left > bufferSize.RightInclusive())
+    {
+        return;
+    }
+    region.Right = std::min(region.Right, bufferSize.RightInclusive());
+    region.Bottom = std::min(region.Bottom, bufferSize.BottomInclusive());
+
+    _NotifyAccessibilityRegion(region);
+}
+
+// Routine Description:
+// - Fires off a winevent to let accessibility apps know what changed.
+// Arguments:
+// - region - the first (Left, Top) and last (Right, Bottom) cells that changed
+void SCREEN_INFORMATION::_NotifyAccessibilityRegion(const SMALL_RECT region)
+{
+    const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+
+    if (region.Left == region.Right && region.Top == region.Bottom)
+    {
+        try
+        {
+            const auto cellData = GetCellDataAt({ region.Left, region.Top });
+            const LONG charAndAttr = MAKELONG(Utf16ToUcs2(cellData->Chars()),
+                                              gci.GenerateLegacyAttributes(cellData->TextAttr()));
+            _pAccessibilityNotifier->NotifyConsoleUpdateSimpleEvent(MAKELONG(region.Left, region.Top),
+                                                                    charAndAttr);
+        }
+        catch (...)
         {
-            LOG_IF_FAILED(pConsoleWindow->SignalUia(UIA_Text_TextChangedEventId));
-            // TODO MSFT 7960168 do we really need this event to not signal?
-            //pConsoleWindow->SignalUia(UIA_LayoutInvalidatedEventId);
+            LOG_HR(wil::ResultFromCaughtException());
+            return;
         }
     }
+    else
+    {
+        _pAccessibilityNotifier->NotifyConsoleUpdateRegionEvent(MAKELONG(region.Left, region.Top),
+                                                                MAKELONG(region.Right, region.Bottom));
+    }
+    IConsoleWindow* pConsoleWindow = ServiceLocator::LocateConsoleWindow();
+    if (pConsoleWindow)
+    {
+        LOG_IF_FAILED(pConsoleWindow->SignalUia(UIA_Text_TextChangedEventId));
+        // TODO MSFT 7960168 do we really need this event to not signal?
+        //pConsoleWindow->SignalUia(UIA_LayoutInvalidatedEventId);
+    }
 }
 
 #pragma endregion
@@ -1424,197 +1524,8 @@ bool SCREEN_INFORMATION::IsMaximizedY() const
     oldCursor.StartDeferDrawing();
     newCursor.StartDeferDrawing();
 
-    // We need to save the old cursor position so that we can
-    // place the new cursor back on the equivalent character in
-    // the new buffer.
-    COORD cOldCursorPos = oldCursor.GetPosition();
-    COORD cOldLastChar = _textBuffer->GetLastNonSpaceCharacter();
-
-    short const cOldRowsTotal = cOldLastChar.Y + 1;
-    short const cOldColsTotal = GetBufferSize().Width();
-
-    COORD cNewCursorPos = { 0 };
-    bool fFoundCursorPos = false;
-
-    NTSTATUS status = STATUS_SUCCESS;
-    // Loop through all the rows of the old buffer and reprint them into the new buffer
-    for (short iOldRow = 0; iOldRow < cOldRowsTotal; iOldRow++)
-    {
-        // Fetch the row and its "right" which is the last printable character.
-        const ROW& Row = _textBuffer->GetRowByOffset(iOldRow);
-        const CharRow& charRow = Row.GetCharRow();
-        short iRight = static_cast<short>(charRow.MeasureRight());
-
-        // There is a special case here. If the row has a "wrap"
-        // flag on it, but the right isn't equal to the width (one
-        // index past the final valid index in the row) then there
-        // were a bunch trailing of spaces in the row.
-        // (But the measuring functions for each row Left/Right do
-        // not count spaces as "displayable" so they're not
-        // included.)
-        // As such, adjust the "right" to be the width of the row
-        // to capture all these spaces
-        if (charRow.WasWrapForced())
-        {
-            iRight = cOldColsTotal;
-
-            // And a combined special case.
-            // If we wrapped off the end of the row by adding a
-            // piece of padding because of a double byte LEADING
-            // character, then remove one from the "right" to
-            // leave this padding out of the copy process.
-            if (charRow.WasDoubleBytePadded())
-            {
-                iRight--;
-            }
-        }
-
-        // Loop through every character in the current row (up to
-        // the "right" boundary, which is one past the final valid
-        // character)
-        for (short iOldCol = 0; iOldCol < iRight; iOldCol++)
-        {
-            if (iOldCol == cOldCursorPos.X && iOldRow == cOldCursorPos.Y)
-            {
-                cNewCursorPos = newCursor.GetPosition();
-                fFoundCursorPos = true;
-            }
-
-            try
-            {
-                // TODO: MSFT: 19446208 - this should just use an iterator and the inserter...
-                const auto glyph = Row.GetCharRow().GlyphAt(iOldCol);
-                const auto dbcsAttr = Row.GetCharRow().DbcsAttrAt(iOldCol);
-                const auto textAttr = Row.GetAttrRow().GetAttrByColumn(iOldCol);
-
-                if (!newTextBuffer->InsertCharacter(glyph, dbcsAttr, textAttr))
-                {
-                    status = STATUS_NO_MEMORY;
-                    break;
-                }
-            }
-            catch (...)
-            {
-                return NTSTATUS_FROM_HRESULT(wil::ResultFromCaughtException());
-            }
-        }
-        if (NT_SUCCESS(status))
-        {
-            // If we didn't have a full row to copy, insert a new
-            // line into the new buffer.
-            // Only do so if we were not forced to wrap. If we did
-            // force a word wrap, then the existing line break was
-            // only because we ran out of space.
-            if (iRight < cOldColsTotal && !charRow.WasWrapForced())
-            {
-                if (iRight == cOldCursorPos.X && iOldRow == cOldCursorPos.Y)
-                {
-                    cNewCursorPos = newCursor.GetPosition();
-                    fFoundCursorPos = true;
-                }
-                // Only do this if it's not the final line in the buffer.
-                // On the final line, we want the cursor to sit
-                // where it is done printing for the cursor
-                // adjustment to follow.
-                if (iOldRow < cOldRowsTotal - 1)
-                {
-                    status = newTextBuffer->NewlineCursor() ? status : STATUS_NO_MEMORY;
-                }
-                else
-                {
-                    // If we are on the final line of the buffer, we have one more check.
-                    // We got into this code path because we are at the right most column of a row in the old buffer
-                    // that had a hard return (no wrap was forced).
-                    // However, as we're inserting, the old row might have just barely fit into the new buffer and
-                    // caused a new soft return (wrap was forced) putting the cursor at x=0 on the line just below.
-                    // We need to preserve the memory of the hard return at this point by inserting one additional
-                    // hard newline, otherwise we've lost that information.
-                    // We only do this when the cursor has just barely poured over onto the next line so the hard return
-                    // isn't covered by the soft one.
-                    // e.g.
-                    // The old line was:
-                    // |aaaaaaaaaaaaaaaaaaa | with no wrap which means there was a newline after that final a.
-                    // The cursor was here ^
-                    // And the new line will be:
-                    // |aaaaaaaaaaaaaaaaaaa| and show a wrap at the end
-                    // |                   |
-                    //  ^ and the cursor is now there.
-                    // If we leave it like this, we've lost the newline information.
-                    // So we insert one more newline so a continued reflow of this buffer by resizing larger will
-                    // continue to look as the original output intended with the newline data.
-                    // After this fix, it looks like this:
-                    // |aaaaaaaaaaaaaaaaaaa| no wrap at the end (preserved hard newline)
-                    // |                   |
-                    //  ^ and the cursor is now here.
-                    const COORD coordNewCursor = newCursor.GetPosition();
-                    if (coordNewCursor.X == 0 && coordNewCursor.Y > 0)
-                    {
-                        if (newTextBuffer->GetRowByOffset(coordNewCursor.Y - 1).GetCharRow().WasWrapForced())
-                        {
-                            status = newTextBuffer->NewlineCursor() ? status : STATUS_NO_MEMORY;
-                        }
-                    }
-                }
-            }
-        }
-    }
-    if (NT_SUCCESS(status))
-    {
-        // Finish copying remaining parameters from the old text buffer to the new one
-        newTextBuffer->CopyProperties(*_textBuffer);
-
-        // If we found where to put the cursor while placing characters into the buffer,
-        //   just put the cursor there. Otherwise we have to advance manually.
-        if (fFoundCursorPos)
-        {
-            newCursor.SetPosition(cNewCursorPos);
-        }
-        else
-        {
-            // Advance the cursor to the same offset as before
-            // get the number of newlines and spaces between the old end of text and the old cursor,
-            //   then advance that many newlines and chars
-            int iNewlines = cOldCursorPos.Y - cOldLastChar.Y;
-            int iIncrements = cOldCursorPos.X - cOldLastChar.X;
-            const COORD cNewLastChar = newTextBuffer->GetLastNonSpaceCharacter();
-
-            // If the last row of the new buffer wrapped, there's going to be one less newline needed,
-            //   because the cursor is already on the next line
-            if (newTextBuffer->GetRowByOffset(cNewLastChar.Y).GetCharRow().WasWrapForced())
-            {
-                iNewlines = std::max(iNewlines - 1, 0);
-            }
-            else
-            {
-                // if this buffer didn't wrap, but the old one DID, then the d(columns) of the
-                //   old buffer will be one more than in this buffer, so new need one LESS.
-                if (_textBuffer->GetRowByOffset(cOldLastChar.Y).GetCharRow().WasWrapForced())
-                {
-                    iNewlines = std::max(iNewlines - 1, 0);
-                }
-            }
-
-            for (int r = 0; r < iNewlines; r++)
-            {
-                if (!newTextBuffer->NewlineCursor())
-                {
-                    status = STATUS_NO_MEMORY;
-                    break;
-                }
-            }
-            if (NT_SUCCESS(status))
-            {
-                for (int c = 0; c < iIncrements - 1; c++)
-                {
-                    if (!newTextBuffer->IncrementCursor())
-                    {
-                        status = STATUS_NO_MEMORY;
-                        break;
-                    }
-                }
-            }
-        }
-    }
+    // Reflow the old buffer's contents into the new one.
+    NTSTATUS status = NTSTATUS_FROM_HRESULT(TextBuffer::Reflow(*_textBuffer, *newTextBuffer));
 
     if (NT_SUCCESS(status))
     {
@@ -2006,13 +1917,29 @@ const SCREEN_INFORMATION& SCREEN_INFORMATION::GetMainBuffer() const
 
     const FontInfo& existingFont = GetCurrentFont();
 
-    NTSTATUS Status = SCREEN_INFORMATION::CreateInstance(WindowSize,
-                                                         existingFont,
-                                                         WindowSize,
-                                                         GetAttributes(),
-                                                         *GetPopupAttributes(),
-                                                         CURSOR_SMALL_SIZE,
-                                                         ppsiNewScreenBuffer);
+    // If the alternate buffer we left last time still fits, start over with it
+    // instead of allocating a whole new buffer. Apps like editors and pagers
+    // switch back and forth all the time.
+    SCREEN_INFORMATION& siMain = GetMainBuffer();
+    std::unique_ptr<SCREEN_INFORMATION> spare{ std::exchange(siMain._psiSpareAlternateBuffer, nullptr) };
+
+    NTSTATUS Status = STATUS_SUCCESS;
+    if (spare && spare->GetBufferSize().Dimensions() == WindowSize && spare->GetCurrentFont() == existingFont)
+    {
+        spare->_ResetAltBuffer(GetAttributes(), *GetPopupAttributes());
+        *ppsiNewScreenBuffer = spare.release();
+    }
+    else
+    {
+        Status = SCREEN_INFORMATION::CreateInstance(WindowSize,
+                                                    existingFont,
+                                                    WindowSize,
+                                                    GetAttributes(),
+                                                    *GetPopupAttributes(),
+                                                    CURSOR_SMALL_SIZE,
+                                                    ppsiNewScreenBuffer);
+    }
+
     if (NT_SUCCESS(Status))
     {
         // Update the alt buffer's cursor style to match our own.
@@ -2023,6 +1950,7 @@ const SCREEN_INFORMATION& SCREEN_INFORMATION::GetMainBuffer() const
         s_InsertScreenBuffer(createdBuffer);
 
         // delete the alt buffer's state machine. We don't want it.
+        // (A buffer we used before already has a main buffer, and so no state machine of its own.)
         createdBuffer->_FreeOutputStateMachine(); // this has to be done before we give it a main buffer
         // we'll attach the GetSet, etc once we successfully make this buffer the active buffer.
 
@@ -2035,6 +1963,40 @@ const SCREEN_INFORMATION& SCREEN_INFORMATION::GetMainBuffer() const
     return Status;
 }
 
+// Routine Description:
+// - Puts an alternate buffer that was used before back into the state a newly
+//   created one starts out in: blank, with the cursor at the origin and no margins.
+// Parameters:
+// - attributes - The attributes to fill the buffer with and to write with from now on.
+// - popupAttributes - The attributes to use for popups.
+// Return value:
+// - <none>
+void SCREEN_INFORMATION::_ResetAltBuffer(const TextAttribute& attributes, const TextAttribute& popupAttributes)
+{
+    const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    OutputMode = ENABLE_PROCESSED_OUTPUT | ENABLE_WRAP_AT_EOL_OUTPUT;
+    if (gci.GetVirtTermLevel() != 0)
+    {
+        OutputMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
+    }
+    WriteConsoleDbcsLeadByte[0] = 0;
+    WriteConsoleDbcsLeadByte[1] = 0;
+    FillOutDbcsLeadChar = 0;
+
+    _scrollMargins = Viewport::FromCoord({ 0 });
+    SetAttributes(attributes);
+    SetPopupAttributes(popupAttributes);
+
+    _textBuffer->Reset();
+
+    auto& cursor = _textBuffer->GetCursor();
+    cursor.SetPosition({ 0 });
+    cursor.ResetDelayEOLWrap();
+    cursor.SetIsVisible(true);
+    cursor.SetIsOn(true);
+    cursor.SetBlinkingAllowed(true);
+}
+
 // Routine Description:
 // - Creates an "alternate" screen buffer for this buffer. In virtual terminals, there exists both a "main"
 //     screen buffer and an alternate. ASBSET creates a new alternate, and switches to it. If there is an already
@@ -2107,10 +2069,14 @@ void SCREEN_INFORMATION::UseMainScreenBuffer()
         // send a _coordScreenBufferSizeChangeEvent for the new Sb viewport
         ScreenBufferSizeChange(psiMain->GetBufferSize().Dimensions());
 
+        // Keep the alt buffer out of the way until the next time it's needed.
+        // It still shares our state machine, but it's no longer in the list of
+        // screen buffers, so nothing will write to it in the meantime.
         SCREEN_INFORMATION* psiAlt = psiMain->_psiAlternateBuffer;
         psiMain->_psiAlternateBuffer = nullptr;
-        s_RemoveScreenBuffer(psiAlt); // this will also delete the alt buffer
-        // deleting the alt buffer will give the GetSet back to its main
+        s_UnlinkScreenBuffer(psiAlt);
+        delete psiMain->_psiSpareAlternateBuffer;
+        psiMain->_psiSpareAlternateBuffer = psiAlt;
 
         // Tell the VT MouseInput handler that we're in the main buffer now
         gci.terminalMouseInput.UseMainScreenBuffer();
@@ -2473,8 +2439,8 @@ void SCREEN_INFORMATION::SetViewport(const Viewport& newViewport,
     RETURN_IF_FAILED(SetCursorPosition(relativeCursor, false));
 
     // Update all the rows in the current viewport with the currently active attributes.
-    OutputCellIterator it(GetAttributes());
-    WriteRect(it, _viewport);
+    // They're all below the last character, so they can be blanked outright.
+    _textBuffer->FillRect(_viewport, UNICODE_SPACE, GetAttributes());
 
     return S_OK;
 }
@@ -2651,28 +2617,23 @@ std::pair<COORD, COORD> SCREEN_INFORMATION::GetWordBoundary(const COORD position
     COORD start{ clampedPosition };
     COORD end{ clampedPosition };
 
-    // find the start of the word
-    auto startIt = GetTextLineDataAt(clampedPosition);
-    while (startIt)
+    // The word is the row's run of non-delimiters at the position. On a delimiter, the
+    // word (if any) that ends right before it is taken as the start instead.
+    const auto& charRow = _textBuffer->GetRowByOffset(clampedPosition.Y).GetCharRow();
+    const auto wordDelims = GetWordDelims();
+    const auto run = charRow.GetWordRunAt(clampedPosition.X, wordDelims);
+    if (!run.isDelimiter)
     {
-        --startIt;
-        if (!startIt || IsWordDelim(*startIt))
-        {
-            break;
-        }
-        --start.X;
+        start.X = gsl::narrow<SHORT>(run.begin);
+        end.X = gsl::narrow<SHORT>(run.end);
     }
-
-    // find the end of the word
-    auto endIt = GetTextLineDataAt(clampedPosition);
-    while (endIt)
+    else if (clampedPosition.X > 0)
     {
-        if (IsWordDelim(*endIt))
+        const auto previousRun = charRow.GetWordRunAt(clampedPosition.X - 1, wordDelims);
+        if (!previousRun.isDelimiter)
         {
-            break;
+            start.X = gsl::narrow<SHORT>(previousRun.begin);
         }
-        ++endIt;
-        ++end.X;
     }
 
     // trim leading zeros if we need to
@@ -2727,6 +2688,29 @@ const TextBuffer& SCREEN_INFORMATION::GetTextBuffer() const noexcept
     return *_textBuffer;
 }
 
+// Routine Description:
+// - Gets how many bytes this screen buffer's text holds, and what for. The alternate
+//   buffer, if there is one, is counted with the main buffer it belongs to.
+// - Walks every row of the buffers, so it's meant for diagnostics.
+// Return Value:
+// - The memory usage of the buffer, and its alternate buffer's added in.
+TextBuffer::MemoryUsage SCREEN_INFORMATION::GetMemoryUsage() const noexcept
+{
+    auto usage = _textBuffer->GetMemoryUsage();
+    if (_psiAlternateBuffer)
+    {
+        const auto alternate = _psiAlternateBuffer->GetMemoryUsage();
+        usage.rows += alternate.rows;
+        usage.cells += alternate.cells;
+        usage.compactedCells += alternate.compactedCells;
+        usage.attributes += alternate.attributes;
+        usage.unicodeStorage += alternate.unicodeStorage;
+        usage.spareStorage += alternate.spareStorage;
+        usage.archiveIndex += alternate.archiveIndex;
+    }
+    return usage;
+}
+
 TextBufferTextIterator SCREEN_INFORMATION::GetTextDataAt(const COORD at) const
 {
     return _textBuffer->GetTextDataAt(at);
@@ -2787,6 +2771,7 @@ void SCREEN_INFORMATION::InitializeCursorRowAttributes()
         const auto& cursor = _textBuffer->GetCursor();
         ROW& row = _textBuffer->GetRowByOffset(cursor.GetPosition().Y);
         row.GetAttrRow().SetAttrToEnd(0, GetAttributes());
+        _textBuffer->MarkRowsChanged(cursor.GetPosition().Y, 1);
     }
 }
 
@@ -92,6 +92,7 @@ public:
     [[nodiscard]] NTSTATUS ResizeScreenBuffer(const COORD coordNewScreenSize, const bool fDoScrollBarUpdate);
 
     void NotifyAccessibilityEventing(const short sStartX, const short sStartY, const short sEndX, const short sEndY);
+    void InternalNotifyAccessibilityEventing();
 
     void UpdateScrollBars();
     void InternalUpdateScrollBars();
@@ -145,6 +146,7 @@ public:
 
     TextBuffer& GetTextBuffer() noexcept;
     const TextBuffer& GetTextBuffer() const noexcept;
+    TextBuffer::MemoryUsage GetMemoryUsage() const noexcept;
 
 #pragma region IIoProvider
     SCREEN_INFORMATION& GetActiveOutputBuffer() override;
@@ -255,6 +257,10 @@ private:
     Microsoft::Console::Interactivity::IWindowMetrics* _pConsoleWindowMetrics;
     Microsoft::Console::Interactivity::IAccessibilityNotifier* _pAccessibilityNotifier;
 
+    // The region changed since accessibility apps were last told, kept until the window gets around to telling them.
+    std::optional<SMALL_RECT> _pendingAccessibilityRegion;
+    void _NotifyAccessibilityRegion(const SMALL_RECT region);
+
     [[nodiscard]] HRESULT _AdjustScreenBufferHelper(const RECT* const prcClientNew,
                                                     const COORD coordBufferOld,
                                                     _Out_ COORD* const pcoordClientNewCharacters);
@@ -276,6 +282,8 @@ private:
     void _FreeOutputStateMachine();
 
     [[nodiscard]] NTSTATUS _CreateAltBuffer(_Out_ SCREEN_INFORMATION** const ppsiNewScreenBuffer);
+    void _ResetAltBuffer(const TextAttribute& attributes, const TextAttribute& popupAttributes);
+    static void s_UnlinkScreenBuffer(_In_ SCREEN_INFORMATION* const pScreenInfo);
 
     bool _IsAltBuffer() const;
     bool _IsInPtyMode() const;
@@ -290,6 +298,7 @@ private:
 
     SCREEN_INFORMATION* _psiAlternateBuffer; // The VT "Alternate" screen buffer.
     SCREEN_INFORMATION* _psiMainBuffer; // A pointer to the main buffer, if this is the alternate buffer.
+    SCREEN_INFORMATION* _psiSpareAlternateBuffer; // The last alternate buffer we left, kept to be used again. Not in the list of screen buffers.
 
     RECT _rcAltSavedClientNew;
     RECT _rcAltSavedClientOld;
@@ -26,7 +26,7 @@ Search::Search(const SCREEN_INFORMATION& screenInfo,
     _direction(direction),
     _sensitivity(sensitivity),
     _screenInfo(screenInfo),
-    _needle(s_CreateNeedleFromString(str)),
+    _needle(s_CreateNeedleFromString(str, sensitivity)),
     _coordAnchor(s_GetInitialAnchor(screenInfo, direction))
 {
     _coordNext = _coordAnchor;
@@ -50,12 +50,45 @@ Search::Search(const SCREEN_INFORMATION& screenInfo,
     _direction(direction),
     _sensitivity(sensitivity),
     _screenInfo(screenInfo),
-    _needle(s_CreateNeedleFromString(str)),
+    _needle(s_CreateNeedleFromString(str, sensitivity)),
     _coordAnchor(anchor)
 {
     _coordNext = _coordAnchor;
 }
 
+// Routine Description:
+// - Constructs a Search object.
+// - Make a Search object then call .FindNext() to locate items.
+// - Once you've found something, you can perfom actions like .Select() or .Color()
+// Arguments:
+// - screenInfo - The screen buffer to search through (the "haystack")
+// - str - The search term you want to find (the "needle")
+// - direction - The direction to search (upward or downward)
+// - sensitivity - Whether or not you care about case
+// - syntax - Whether str is literal text or an ECMAScript regular expression
+// Note:
+// - Throws std::regex_error if str isn't a valid regular expression.
+// - A regular expression is matched against each line of text in the buffer,
+//   with the rows of a line that wrapped joined back together. It isn't
+//   matched across lines, and empty matches are ignored.
+Search::Search(const SCREEN_INFORMATION& screenInfo,
+               const std::wstring& str,
+               const Direction direction,
+               const Sensitivity sensitivity,
+               const Syntax syntax) :
+    Search(screenInfo, str, direction, sensitivity)
+{
+    if (syntax == Syntax::RegularExpression)
+    {
+        auto flags = std::regex_constants::ECMAScript | std::regex_constants::optimize;
+        if (sensitivity == Sensitivity::CaseInsensitive)
+        {
+            flags |= std::regex_constants::icase;
+        }
+        _expression.emplace(str, flags);
+    }
+}
+
 // Routine Description
 // - Locates the next instance of the search term within the screen buffer.
 // Arguments:
@@ -71,6 +104,11 @@ bool Search::FindNext()
         return false;
     }
 
+    if (_expression.has_value())
+    {
+        return _FindNextExpression();
+    }
+
     do
     {
         if (_FindNeedleInHaystackAt(_coordNext, _coordSelStart, _coordSelEnd))
@@ -179,12 +217,15 @@ bool Search::_FindNeedleInHaystackAt(const COORD pos, COORD& start, COORD& end)
     end = { 0 };
 
     COORD bufferPos = pos;
+    const TextBuffer& textBuffer = _screenInfo.GetTextBuffer();
 
     for (const auto& needleCell : _needle)
     {
         // Haystack is the buffer. Needle is the string we were given.
-        const auto hayIter = _screenInfo.GetTextDataAt(bufferPos);
-        const auto hayChars = *hayIter;
+        // The glyph is read straight from its row. A text iterator would also
+        // look up the cell's attributes, which a search doesn't need, and this
+        // is done for every cell of the buffer when the needle isn't there.
+        const std::wstring_view hayChars = textBuffer.GetRowByOffset(bufferPos.Y).GetCharRow().GlyphAt(bufferPos.X);
         const auto needleChars = std::wstring_view(needleCell.data(), needleCell.size());
 
         // If we didn't match at any point of the needle, return false.
@@ -210,8 +251,9 @@ bool Search::_FindNeedleInHaystackAt(const COORD pos, COORD& start, COORD& end)
 // - Provides an abstraction for comparing two spans of text.
 // - Internally handles case sensitivity based on object construction.
 // Arguments:
-// - one - String view representing the first string of text
-// - two - String view representing the second string of text
+// - one - String view representing the text in the buffer
+// - two - String view representing the text of the needle, which had
+//   case sensitivity applied when it was made
 // Return Value:
 // - True if they are the same. False otherwise.
 bool Search::_CompareChars(const std::wstring_view one, const std::wstring_view two) const
@@ -223,7 +265,7 @@ bool Search::_CompareChars(const std::wstring_view one, const std::wstring_view
 
     for (size_t i = 0; i < one.size(); i++)
     {
-        if (_ApplySensitivity(one[i]) != _ApplySensitivity(two[i]))
+        if (_ApplySensitivity(one[i]) != two[i])
         {
             return false;
         }
@@ -289,20 +331,172 @@ void Search::_UpdateNextPosition()
     }
 }
 
+// Routine Description:
+// - Gets how far a position is from the next position to be searched, counting
+//   in the direction of the search and wrapping around the buffer.
+// Arguments:
+// - pos - The position to measure to
+// Return Value:
+// - The number of cells from the next position to pos.
+size_t Search::_DistanceFromNext(const COORD pos) const noexcept
+{
+    const auto bufferSize = _screenInfo.GetBufferSize().Dimensions();
+    const size_t width = bufferSize.X;
+    const size_t cells = width * bufferSize.Y;
+    const size_t at = pos.Y * width + pos.X;
+    const size_t next = _coordNext.Y * width + _coordNext.X;
+    return _direction == Direction::Forward ? (at + cells - next) % cells : (next + cells - at) % cells;
+}
+
+// Routine Description:
+// - Locates the next match of the regular expression within the screen buffer.
+// - Works line by line in the direction of the search, starting with the line
+//   holding the next position to be searched, and stops at the first line that
+//   has a match before the end of the search.
+// Arguments:
+// - <none> - Uses internal state from constructor
+// Return Value:
+// - True if we found another item. False if we've reached the end of the buffer.
+bool Search::_FindNextExpression()
+{
+    const TextBuffer& textBuffer = _screenInfo.GetTextBuffer();
+    const auto bufferSize = _screenInfo.GetBufferSize().Dimensions();
+    const size_t cells = static_cast<size_t>(bufferSize.X) * bufferSize.Y;
+
+    // The search ends when it gets back around to the anchor.
+    size_t limit = _DistanceFromNext(_coordAnchor);
+    if (limit == 0)
+    {
+        limit = cells;
+    }
+
+    // Find the rows that each line starts and ends on.
+    std::vector<std::pair<SHORT, SHORT>> lines;
+    size_t nextLine = 0;
+    for (SHORT row = 0; row < bufferSize.Y; ++row)
+    {
+        if (row == 0 || !textBuffer.GetRowByOffset(row - 1).GetCharRow().WasWrapForced())
+        {
+            lines.emplace_back(row, row);
+        }
+        lines.back().second = row;
+        if (row == _coordNext.Y)
+        {
+            nextLine = lines.size() - 1;
+        }
+    }
+
+    std::wstring text;
+    std::vector<COORD> positions;
+    std::optional<std::pair<COORD, COORD>> best;
+    size_t bestDistance = limit;
+
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        const auto index = _direction == Direction::Forward ? (nextLine + i) % lines.size() :
+                                                             (nextLine + lines.size() - i) % lines.size();
+        const auto [firstRow, lastRow] = lines.at(index);
+
+        // The line holding the next position can have matches at both ends of the
+        // search, so it's read in full first. Lines after it are in order, so once
+        // there's a match that comes before where the next line begins, it's the one.
+        if (i != 0 && best.has_value())
+        {
+            const COORD lineBegin = _direction == Direction::Forward ? COORD{ 0, firstRow } :
+                                                                       COORD{ bufferSize.X - 1, lastRow };
+            if (bestDistance < _DistanceFromNext(lineBegin))
+            {
+                break;
+            }
+        }
+
+        // Join the rows of the line into one string, remembering which cell each character came from.
+        text.clear();
+        positions.clear();
+        for (SHORT row = firstRow; row <= lastRow; ++row)
+        {
+            const auto& charRow = textBuffer.GetRowByOffset(row).GetCharRow();
+            for (SHORT column = 0; column < bufferSize.X; ++column)
+            {
+                if (charRow.DbcsAttrAt(column).IsTrailing())
+                {
+                    continue;
+                }
+                const std::wstring_view glyph = charRow.GlyphAt(column);
+                text.append(glyph);
+                positions.insert(positions.end(), glyph.size(), COORD{ column, row });
+            }
+        }
+        while (!text.empty() && text.back() == UNICODE_SPACE)
+        {
+            text.pop_back();
+            positions.pop_back();
+        }
+        if (text.size() > MaxExpressionLineLength)
+        {
+            text.resize(MaxExpressionLineLength);
+            positions.resize(MaxExpressionLineLength);
+        }
+
+        const std::wsregex_iterator end;
+        for (auto match = std::wsregex_iterator(text.cbegin(), text.cend(), _expression.value()); match != end; ++match)
+        {
+            if (match->length() == 0)
+            {
+                continue;
+            }
+
+            const COORD start = positions.at(match->position());
+            const size_t distance = _DistanceFromNext(start);
+            if (distance < bestDistance)
+            {
+                COORD last = positions.at(match->position() + match->length() - 1);
+                if (textBuffer.GetRowByOffset(last.Y).GetCharRow().DbcsAttrAt(last.X).IsLeading())
+                {
+                    ++last.X;
+                }
+                best.emplace(start, last);
+                bestDistance = distance;
+            }
+        }
+    }
+
+    if (!best.has_value())
+    {
+        return false;
+    }
+
+    _coordSelStart = best->first;
+    _coordSelEnd = best->second;
+    _coordNext = _coordSelStart;
+    _UpdateNextPosition();
+    _reachedEnd = _coordNext == _coordAnchor;
+    return true;
+}
+
 // Routine Description:
 // - Creates a "needle" of the correct format for comparison to the screen buffer text data
 //   that we can use for our search
 // Arguments:
 // - wstr - String that will be our search term
+// - sensitivity - Whether or not the search cares about case. If it doesn't,
+//   the needle is lowercased once here instead of on every comparison.
 // Return Value:
 // - Structured text data for comparison to screen buffer text data.
-std::vector<std::vector<wchar_t>> Search::s_CreateNeedleFromString(const std::wstring& wstr)
+std::vector<std::vector<wchar_t>> Search::s_CreateNeedleFromString(const std::wstring& wstr,
+                                                                   const Sensitivity sensitivity)
 {
-    const auto charData = Utf16Parser::Parse(wstr);
     std::vector<std::vector<wchar_t>> cells;
-    for (const auto chars : charData)
+    for (const auto glyph : Utf16Parser::Glyphs(wstr))
     {
-        if (IsGlyphFullWidth(std::wstring_view{ chars.data(), chars.size() }))
+        const bool fullWidth = IsGlyphFullWidth(glyph);
+        std::vector<wchar_t> chars{ glyph.cbegin(), glyph.cend() };
+        if (sensitivity == Sensitivity::CaseInsensitive)
+        {
+            std::transform(chars.begin(), chars.end(), chars.begin(), ::towlower);
+        }
+
+        if (fullWidth)
         {
             cells.emplace_back(chars);
         }
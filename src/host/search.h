@@ -17,6 +17,8 @@ Revision History:
 
 #pragma once
 
+#include <regex>
+
 // This used to be in find.h.
 #define SEARCH_STRING_LENGTH (80)
 
@@ -35,6 +37,12 @@ public:
         CaseSensitive
     };
 
+    enum class Syntax
+    {
+        Literal,
+        RegularExpression
+    };
+
     Search(const SCREEN_INFORMATION& ScreenInfo,
            const std::wstring& str,
            const Direction dir,
@@ -46,6 +54,12 @@ public:
            const Sensitivity sensitivity,
            const COORD anchor);
 
+    Search(const SCREEN_INFORMATION& ScreenInfo,
+           const std::wstring& str,
+           const Direction dir,
+           const Sensitivity sensitivity,
+           const Syntax syntax);
+
     bool FindNext();
     void Select() const;
     void Color(const TextAttribute attr) const;
@@ -57,12 +71,15 @@ private:
     bool Search::_FindNeedleInHaystackAt(const COORD pos, COORD& start, COORD& end) const;
     bool _CompareChars(const std::wstring_view one, const std::wstring_view two) const;
     void _UpdateNextPosition();
+    bool _FindNextExpression();
+    size_t _DistanceFromNext(const COORD pos) const noexcept;
 
     void _IncrementCoord(COORD& coord) const;
     void _DecrementCoord(COORD& coord) const;
 
     static COORD s_GetInitialAnchor(const SCREEN_INFORMATION& screenInfo, const Direction dir);
-    static std::vector<std::vector<wchar_t>> s_CreateNeedleFromString(const std::wstring& wstr);
+    static std::vector<std::vector<wchar_t>> s_CreateNeedleFromString(const std::wstring& wstr,
+                                                                      const Sensitivity sensitivity);
 
     bool _reachedEnd = false;
     COORD _coordNext = { 0 };
@@ -75,6 +92,13 @@ private:
     const Sensitivity _sensitivity;
     const SCREEN_INFORMATION& _screenInfo;
 
+    // Regular expressions are only matched against this many characters of a line, so that
+    // a long wrapped line can't make std::regex recurse deep enough to run out of stack.
+    static constexpr size_t MaxExpressionLineLength = 4096;
+
+    // Only set when searching for a regular expression rather than literal text.
+    std::optional<std::wregex> _expression;
+
 #ifdef UNIT_TESTING
     friend class SearchTests;
 #endif
@@ -24,6 +24,7 @@ Revision History:
 #include "..\terminal\adapter\MouseInput.hpp"
 #include "VtIo.hpp"
 #include "CursorBlinker.hpp"
+#include "codepageTable.hpp"
 
 #include "..\server\ProcessList.h"
 #include "..\server\WaitQueue.h"
@@ -49,6 +50,7 @@ Revision History:
 
 // unused (CONSOLE_VDM_REGISTERED)      0x00000200
 #define CONSOLE_UPDATING_SCROLL_BARS    0x00000400
+#define CONSOLE_UPDATING_ACCESSIBILITY  0x00001000
 #define CONSOLE_QUICK_EDIT_MODE         0x00000800
 #define CONSOLE_CONNECTED_TO_EMULATOR   0x00002000
 // unused (CONSOLE_FULLSCREEN_NOPAINT)  0x00004000
@@ -91,6 +93,12 @@ public:
     SCREEN_INFORMATION* ScreenBuffers; // singly linked list
     ConsoleWaitQueue OutputQueue;
 
+    // Text written while output was blocked, in the order it was written, and the
+    //      screen buffers it was written to. See DoWriteConsole.
+    std::deque<std::pair<SCREEN_INFORMATION*, std::wstring>> PendingWrites;
+    size_t PendingWritesLength; // total wchar_ts held in PendingWrites
+    bool PendingWritesOverflowed; // a write had to wait because PendingWrites was full
+
     DWORD Flags;
 
     std::atomic<WORD> PopupCount;
@@ -105,11 +113,14 @@ public:
     CPINFO CPInfo;
     CPINFO OutputCPInfo;
 
+    // translates cells to and from OutputCP for the A versions of the cell APIs
+    CodepageTable OutputCPTable;
+
     ConsoleImeInfo ConsoleIme;
 
     Microsoft::Console::VirtualTerminal::MouseInput terminalMouseInput;
 
-    void LockConsole();
+    void LockConsole(const void* const callSite = nullptr);
     bool TryLockConsole();
     void UnlockConsole();
     bool IsConsoleLocked() const;
@@ -117,7 +128,7 @@ public:
 
     Microsoft::Console::VirtualTerminal::VtIo* GetVtIo();
 
-    static void HandleTerminalKeyEventCallback(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& events);
+    static void HandleTerminalMouseEventCallback(const std::wstring_view text);
 
     SCREEN_INFORMATION& GetActiveOutputBuffer() override;
     const SCREEN_INFORMATION& GetActiveOutputBuffer() const override;
@@ -156,6 +167,9 @@ public:
 
 private:
     CRITICAL_SECTION _csConsoleLock; // serialize input and output using this
+    // where the console lock was taken from, and since when, while the LockProfiler measures it. only the owner touches these.
+    const void* _lockCallSite;
+    LONGLONG _lockAcquired;
     std::wstring _Title;
     std::wstring _TitlePrefix; // Eg Select, Mark - things that we manually prepend to the title.
     std::wstring _OriginalTitle;
@@ -165,6 +179,8 @@ private:
 
     Microsoft::Console::VirtualTerminal::VtIo _vtIo;
     Microsoft::Console::CursorBlinker _blinker;
+
+    void _BeginProfiledHold(const void* const callSite, const LONGLONG waitTicks, const bool contended) noexcept;
 };
 
 #define ConsoleLocked() (ServiceLocator::LocateGlobals()->getConsoleInformation()->ConsoleLock.OwningThread == NtCurrentTeb()->ClientId.UniqueThread)
@@ -57,7 +57,8 @@ Settings::Settings() :
     _DefaultForeground(INVALID_COLOR),
     _DefaultBackground(INVALID_COLOR),
     _fUseDx(false),
-    _fCopyColor(false)
+    _fCopyColor(false),
+    _dwUiaTextChangedMaxRate(20)
 {
     _dwScreenBufferSize.X = 80;
     _dwScreenBufferSize.Y = 25;
@@ -944,3 +945,13 @@ bool Settings::GetCopyColor() const noexcept
 {
     return _fCopyColor;
 }
+
+// Routine Description:
+// - Gets the most text changed events per second that accessibility clients are sent.
+//   Changes that come in faster than that are held back and sent together.
+// Return Value:
+// - The events per second. 0 means every change is sent as soon as the window gets to it.
+DWORD Settings::GetUiaTextChangedMaxRate() const noexcept
+{
+    return _dwUiaTextChangedMaxRate;
+}
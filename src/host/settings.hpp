@@ -184,6 +184,7 @@ public:
 
     bool GetUseDx() const noexcept;
     bool GetCopyColor() const noexcept;
+    DWORD GetUiaTextChangedMaxRate() const noexcept;
 
     COLORREF CalculateDefaultForeground() const noexcept;
     COLORREF CalculateDefaultBackground() const noexcept;
@@ -233,6 +234,7 @@ private:
     bool _fRenderGridWorldwide;
     bool _fUseDx;
     bool _fCopyColor;
+    DWORD _dwUiaTextChangedMaxRate; // most text changed events to raise to UIA clients per second. 0 means no limit.
 
     COLORREF _XtermColorTable[XTERM_COLOR_TABLE_SIZE];
 
@@ -34,6 +34,7 @@ const UINT CONSOLE_LPC_PORT_FAILURE_ID = 21791;
 [[nodiscard]] HRESULT ConsoleServerInitialization(_In_ HANDLE Server, const ConsoleArguments* const args)
 {
     Globals& Globals = ServiceLocator::LocateGlobals();
+    const auto trace = Tracing::s_TraceStartupPhase("ServerInitialization");
 
     try
     {
@@ -105,6 +106,8 @@ static bool s_IsOnDesktop()
     // Set to reference of global console information since that's the only place we need to hold the settings.
     CONSOLE_INFORMATION& settings = ServiceLocator::LocateGlobals().getConsoleInformation();
     const auto& launchArgs = ServiceLocator::LocateGlobals().launchArgs;
+    const auto trace = Tracing::s_TraceStartupPhase("SetUpConsole");
+
     // 4b. On Desktop editions, we need to apply a series of Desktop-specific defaults that are better than the
     // ones from the constructor (which are great for OneCore systems.)
     if (s_IsOnDesktop())
@@ -155,7 +158,9 @@ static bool s_IsOnDesktop()
     // Set the process's default dpi awareness context to PMv2 so that new top level windows
     // inherit their WM_DPICHANGED* broadcast mode (and more, like dialog scaling) from the thread.
 
-    IHighDpiApi* pHighDpiApi = ServiceLocator::LocateHighDpiApi();
+    // A headless console never shows a top level window or a dialog, so it has
+    // nothing to scale and can skip loading and calling into the high DPI APIs.
+    IHighDpiApi* pHighDpiApi = launchArgs.IsHeadless() ? nullptr : ServiceLocator::LocateHighDpiApi();
     if (pHighDpiApi)
     {
         // N.B.: There is no high DPI support on OneCore (non-UAP) systems.
@@ -508,6 +513,8 @@ PWSTR TranslateConsoleTitle(_In_ PCWSTR pwszConsoleTitle, const BOOL fUnexpand,
     // No matter what, create a renderer.
     try
     {
+        const auto trace = Tracing::s_TraceStartupPhase("CreateRenderer");
+
         g.pRender = nullptr;
 
         auto renderThread = std::make_unique<RenderThread>();
@@ -536,6 +543,8 @@ PWSTR TranslateConsoleTitle(_In_ PCWSTR pwszConsoleTitle, const BOOL fUnexpand,
 
     if (NT_SUCCESS(Status) && p->WindowVisible)
     {
+        const auto trace = Tracing::s_TraceStartupPhase("StartInputThread");
+
         HANDLE Thread = nullptr;
 
         IConsoleInputThread* pNewThread = nullptr;
@@ -595,6 +604,8 @@ PWSTR TranslateConsoleTitle(_In_ PCWSTR pwszConsoleTitle, const BOOL fUnexpand,
     // We'll need the size of the screen buffer in the vt i/o initialization
     if (NT_SUCCESS(Status))
     {
+        const auto trace = Tracing::s_TraceStartupPhase("StartVtIo");
+
         HRESULT hr = gci.GetVtIo()->CreateIoHandlers();
         if (hr == S_FALSE)
         {
@@ -650,6 +661,13 @@ DWORD WINAPI ConsoleIoThread(LPVOID /*lpParameter*/)
 
         // TODO: 9115192 correct mixed NTSTATUS/HRESULT
         HRESULT hr = ServiceLocator::LocateGlobals().pDeviceComm->ReadIo(ReplyMsg, &ReceiveMsg);
+
+        // The reply has gone out with the read, so whatever it wrote can go too.
+        if (ReplyMsg != nullptr)
+        {
+            ReplyMsg->ReleaseReplyBuffer();
+        }
+
         if (FAILED(hr))
         {
             if (hr == HRESULT_FROM_WIN32(ERROR_PIPE_NOT_CONNECTED))
@@ -664,6 +682,12 @@ DWORD WINAPI ConsoleIoThread(LPVOID /*lpParameter*/)
             continue;
         }
 
+        Tracing::s_TraceDeviceComm(*globals.pDeviceComm);
+
+        // If we've asked the terminal where its cursor is, don't let the client
+        //      touch the buffer before we know.
+        globals.getConsoleInformation().GetVtIo()->WaitForCursorPosition();
+
         IoSorter::ServiceIoOperation(&ReceiveMsg, &ReplyMsg);
     }
 
@@ -21,6 +21,127 @@
 
 using Microsoft::Console::Interactivity::ServiceLocator;
 
+// Routine Description:
+// - Turns a record read out of the input buffer into the character a stream read returns for it, if any.
+// Arguments:
+// - inputBuffer - The InputBuffer the record was read from
+// - record - The record to translate
+// - wch - On return, the char data for the record, if it has any
+// - pCommandLineEditingKeys - see GetChar
+// - pPopupKeys - see GetChar
+// - pdwKeyState - see GetChar
+// Return Value:
+// - true if the record produced a character, false if a stream read skips over it.
+[[nodiscard]] static bool _TranslateStreamRecord(const InputBuffer& inputBuffer,
+                                                 const INPUT_RECORD& record,
+                                                 wchar_t& wch,
+                                                 _Out_opt_ bool* const pCommandLineEditingKeys,
+                                                 _Out_opt_ bool* const pPopupKeys,
+                                                 _Out_opt_ DWORD* const pdwKeyState) noexcept
+{
+    if (record.EventType == KEY_EVENT)
+    {
+        const KeyEvent keyEvent{ record.Event.KeyEvent };
+
+        bool commandLineEditKey = false;
+        if (pCommandLineEditingKeys)
+        {
+            commandLineEditKey = keyEvent.IsCommandLineEditingKey();
+        }
+        else if (pPopupKeys)
+        {
+            commandLineEditKey = keyEvent.IsPopupKey();
+        }
+
+        if (pdwKeyState)
+        {
+            *pdwKeyState = keyEvent.GetActiveModifierKeys();
+        }
+
+        if (keyEvent.GetCharData() != 0 && !commandLineEditKey)
+        {
+            // chars that are generated using alt + numpad
+            if (!keyEvent.IsKeyDown() && keyEvent.GetVirtualKeyCode() == VK_MENU)
+            {
+                if (keyEvent.IsAltNumpadSet())
+                {
+                    if (HIBYTE(keyEvent.GetCharData()))
+                    {
+                        char chT[2] = {
+                            static_cast<char>(HIBYTE(keyEvent.GetCharData())),
+                            static_cast<char>(LOBYTE(keyEvent.GetCharData())),
+                        };
+                        wch = CharToWchar(chT, 2);
+                    }
+                    else
+                    {
+                        // Because USER doesn't know our codepage,
+                        // it gives us the raw OEM char and we
+                        // convert it to a Unicode character.
+                        char chT = LOBYTE(keyEvent.GetCharData());
+                        wch = CharToWchar(&chT, 1);
+                    }
+                }
+                else
+                {
+                    wch = keyEvent.GetCharData();
+                }
+                return true;
+            }
+            // Ignore Escape and Newline chars
+            else if (keyEvent.IsKeyDown() &&
+                     (WI_IsFlagSet(inputBuffer.InputMode, ENABLE_VIRTUAL_TERMINAL_INPUT) ||
+                      (keyEvent.GetVirtualKeyCode() != VK_ESCAPE &&
+                       keyEvent.GetCharData() != UNICODE_LINEFEED)))
+            {
+                wch = keyEvent.GetCharData();
+                return true;
+            }
+        }
+
+        if (keyEvent.IsKeyDown())
+        {
+            if (pCommandLineEditingKeys && commandLineEditKey)
+            {
+                *pCommandLineEditingKeys = true;
+                wch = static_cast<wchar_t>(keyEvent.GetVirtualKeyCode());
+                return true;
+            }
+            else if (pPopupKeys && commandLineEditKey)
+            {
+                *pPopupKeys = true;
+                wch = static_cast<char>(keyEvent.GetVirtualKeyCode());
+                return true;
+            }
+            else
+            {
+                const short zeroVkeyData = ServiceLocator::LocateInputServices()->VkKeyScanW(0);
+                const byte zeroVKey = LOBYTE(zeroVkeyData);
+                const byte zeroControlKeyState = HIBYTE(zeroVkeyData);
+
+                try
+                {
+                    // Convert real Windows NT modifier bit into bizarre Console bits
+                    std::unordered_set<ModifierKeyState> consoleModKeyState = FromVkKeyScan(zeroControlKeyState);
+
+                    if (zeroVKey == keyEvent.GetVirtualKeyCode() &&
+                        keyEvent.DoActiveModifierKeysMatch(consoleModKeyState))
+                    {
+                        // This really is the character 0x0000
+                        wch = keyEvent.GetCharData();
+                        return true;
+                    }
+                }
+                catch (...)
+                {
+                    LOG_HR(wil::ResultFromCaughtException());
+                }
+            }
+        }
+    }
+    return false;
+}
+
 // Routine Description:
 // - This routine is used in stream input.  It gets input and filters it for unicode characters.
 // Arguments:
@@ -60,8 +181,10 @@ using Microsoft::Console::Interactivity::ServiceLocator;
     NTSTATUS Status;
     for (;;)
     {
-        std::unique_ptr<IInputEvent> inputEvent;
-        Status = pInputBuffer->Read(inputEvent,
+        INPUT_RECORD record;
+        bool recordRead;
+        Status = pInputBuffer->Read(record,
+                                    recordRead,
                                     false, // peek
                                     Wait,
                                     true, // unicode
@@ -71,113 +194,69 @@ using Microsoft::Console::Interactivity::ServiceLocator;
         {
             return Status;
         }
-        else if (inputEvent.get() == nullptr)
+        else if (!recordRead)
         {
             FAIL_FAST_IF(Wait);
             return STATUS_UNSUCCESSFUL;
         }
 
-        if (inputEvent->EventType() == InputEventType::KeyEvent)
+        if (_TranslateStreamRecord(*pInputBuffer, record, *pwchOut, pCommandLineEditingKeys, pPopupKeys, pdwKeyState))
         {
-            std::unique_ptr<KeyEvent> keyEvent = std::unique_ptr<KeyEvent>(static_cast<KeyEvent*>(inputEvent.release()));
+            return STATUS_SUCCESS;
+        }
+    }
+}
 
-            bool commandLineEditKey = false;
-            if (pCommandLineEditingKeys)
-            {
-                commandLineEditKey = keyEvent->IsCommandLineEditingKey();
-            }
-            else if (pPopupKeys)
-            {
-                commandLineEditKey = keyEvent->IsPopupKey();
-            }
+// Routine Description:
+// - This routine is used in raw stream input, once the first character has been read. It takes every
+//   character that's available out of the input buffer without waiting, the same ones GetChar would
+//   return one call at a time, but pulls the records out a batch at a time.
+// Arguments:
+// - inputBuffer - The InputBuffer to read from
+// - buffer - Where the characters are stored
+// Return Value:
+// - The number of characters stored in buffer.
+// Note:
+// - The console lock must be held when calling this routine.
+size_t GetChars(InputBuffer& inputBuffer, const gsl::span<wchar_t> buffer) noexcept
+{
+    // Every record turns into one character at most, so a batch as large as the
+    // space that's left can never overfill the buffer.
+    constexpr size_t MaxBatchSize = 256;
 
-            if (pdwKeyState)
-            {
-                *pdwKeyState = keyEvent->GetActiveModifierKeys();
-            }
+    const auto capacity = gsl::narrow_cast<size_t>(buffer.size());
+    size_t charsRead = 0;
+    try
+    {
+        std::vector<INPUT_RECORD> records;
+        records.reserve(std::min(capacity, MaxBatchSize));
 
-            if (keyEvent->GetCharData() != 0 && !commandLineEditKey)
+        while (charsRead < capacity)
+        {
+            records.clear();
+            const auto Status = inputBuffer.Read(records,
+                                                 std::min(capacity - charsRead, MaxBatchSize),
+                                                 false, // peek
+                                                 false, // wait
+                                                 true, // unicode
+                                                 true); // stream
+            if (!NT_SUCCESS(Status) || records.empty())
             {
-                // chars that are generated using alt + numpad
-                if (!keyEvent->IsKeyDown() && keyEvent->GetVirtualKeyCode() == VK_MENU)
-                {
-                    if (keyEvent->IsAltNumpadSet())
-                    {
-                        if (HIBYTE(keyEvent->GetCharData()))
-                        {
-                            char chT[2] = {
-                                static_cast<char>(HIBYTE(keyEvent->GetCharData())),
-                                static_cast<char>(LOBYTE(keyEvent->GetCharData())),
-                            };
-                            *pwchOut = CharToWchar(chT, 2);
-                        }
-                        else
-                        {
-                            // Because USER doesn't know our codepage,
-                            // it gives us the raw OEM char and we
-                            // convert it to a Unicode character.
-                            char chT = LOBYTE(keyEvent->GetCharData());
-                            *pwchOut = CharToWchar(&chT, 1);
-                        }
-                    }
-                    else
-                    {
-                        *pwchOut = keyEvent->GetCharData();
-                    }
-                    return STATUS_SUCCESS;
-                }
-                // Ignore Escape and Newline chars
-                else if (keyEvent->IsKeyDown() &&
-                         (WI_IsFlagSet(pInputBuffer->InputMode, ENABLE_VIRTUAL_TERMINAL_INPUT) ||
-                          (keyEvent->GetVirtualKeyCode() != VK_ESCAPE &&
-                           keyEvent->GetCharData() != UNICODE_LINEFEED)))
-                {
-                    *pwchOut = keyEvent->GetCharData();
-                    return STATUS_SUCCESS;
-                }
+                break;
             }
 
-            if (keyEvent->IsKeyDown())
+            for (const auto& record : records)
             {
-                if (pCommandLineEditingKeys && commandLineEditKey)
-                {
-                    *pCommandLineEditingKeys = true;
-                    *pwchOut = static_cast<wchar_t>(keyEvent->GetVirtualKeyCode());
-                    return STATUS_SUCCESS;
-                }
-                else if (pPopupKeys && commandLineEditKey)
+                if (_TranslateStreamRecord(inputBuffer, record, buffer.at(gsl::narrow_cast<ptrdiff_t>(charsRead)), nullptr, nullptr, nullptr))
                 {
-                    *pPopupKeys = true;
-                    *pwchOut = static_cast<char>(keyEvent->GetVirtualKeyCode());
-                    return STATUS_SUCCESS;
-                }
-                else
-                {
-                    const short zeroVkeyData = ServiceLocator::LocateInputServices()->VkKeyScanW(0);
-                    const byte zeroVKey = LOBYTE(zeroVkeyData);
-                    const byte zeroControlKeyState = HIBYTE(zeroVkeyData);
-
-                    try
-                    {
-                        // Convert real Windows NT modifier bit into bizarre Console bits
-                        std::unordered_set<ModifierKeyState> consoleModKeyState = FromVkKeyScan(zeroControlKeyState);
-
-                        if (zeroVKey == keyEvent->GetVirtualKeyCode() &&
-                            keyEvent->DoActiveModifierKeysMatch(consoleModKeyState))
-                        {
-                            // This really is the character 0x0000
-                            *pwchOut = keyEvent->GetCharData();
-                            return STATUS_SUCCESS;
-                        }
-                    }
-                    catch (...)
-                    {
-                        LOG_HR(wil::ResultFromCaughtException());
-                    }
+                    ++charsRead;
                 }
             }
         }
     }
+    CATCH_LOG();
+
+    return charsRead;
 }
 
 // Routine Description:
@@ -593,21 +672,16 @@ size_t RetrieveNumberOfSpaces(_In_ SHORT sOriginalCursorPositionX,
             pBuffer++;
         }
 
-        while (NumToWrite < static_cast<ULONG>(bufferRemaining))
+        if (NumToWrite < bufferRemaining)
         {
-            Status = GetChar(&inputBuffer,
-                             pBuffer,
-                             false,
-                             nullptr,
-                             nullptr,
-                             nullptr);
-            if (!NT_SUCCESS(Status))
+            // Take the rest of what's available in one go instead of a character at a time.
+            const auto charsRead = GetChars(inputBuffer, { pBuffer, gsl::narrow_cast<ptrdiff_t>((bufferRemaining - NumToWrite) / sizeof(wchar_t)) });
+            for (size_t i = 0; i < charsRead; ++i)
             {
-                break;
+                bytesRead += IsGlyphFullWidth(pBuffer[i]) ? 2 : 1;
             }
-            bytesRead += IsGlyphFullWidth(*pBuffer) ? 2 : 1;
-            NumToWrite += sizeof(wchar_t);
-            pBuffer++;
+            NumToWrite += charsRead * sizeof(wchar_t);
+            pBuffer += charsRead;
         }
 
         // if ansi, translate string.  we allocated the capture buffer large enough to handle the translated string.
@@ -808,6 +882,8 @@ void UnblockWriteConsole(const DWORD dwReason)
     if (WI_AreAllFlagsClear(gci.Flags, (CONSOLE_SUSPENDED | CONSOLE_SELECTING | CONSOLE_SCROLLBAR_TRACKING)))
     {
         // There is no longer any reason to suspend output, so unblock it.
-        gci.OutputQueue.NotifyWaiters(true);
+        // The writes that were taken in while blocked came first, so write those before waking the ones that waited.
+        FlushPendingWrites();
+        gci.OutputQueue.NotifyWaiters(true, ReplyDataType::Write);
     }
 }
@@ -29,6 +29,8 @@ Revision History:
                                _Out_opt_ bool* const pPopupKeys,
                                _Out_opt_ DWORD* const pdwKeyState) noexcept;
 
+size_t GetChars(InputBuffer& inputBuffer, const gsl::span<wchar_t> buffer) noexcept;
+
 // Routine Description:
 // - This routine returns the total number of screen spaces the characters up to the specified character take up.
 size_t RetrieveTotalNumberOfSpaces(const SHORT sOriginalCursorPositionX,
@@ -9,6 +9,7 @@
 #include <time.h>
 
 #include "history.h"
+#include "..\server\ApiStatistics.h"
 
 #include "..\interactivity\inc\ServiceLocator.hpp"
 
@@ -17,6 +18,28 @@ TRACELOGGING_DEFINE_PROVIDER(g_hConhostV2EventTraceProvider,
                              // {fe1ff234-1f09-50a8-d38d-c44fab43e818}
                              (0xfe1ff234, 0x1f09, 0x50a8, 0xd3, 0x8d, 0xc4, 0x4f, 0xab, 0x43, 0xe8, 0x18),
                              TraceLoggingOptionMicrosoftTelemetry());
+
+// Routine Description:
+// - Called by ETW when a trace session changes what it wants from the provider.
+// - Asking for the provider's state (e.g. with a trace session's capture state or
+//   rundown option) writes out the API, allocation and memory statistics, which is how they're
+//   dumped on demand.
+static void NTAPI s_ProviderCallback(LPCGUID /*sourceId*/,
+                                     ULONG isEnabled,
+                                     UCHAR /*level*/,
+                                     ULONGLONG /*matchAnyKeyword*/,
+                                     ULONGLONG /*matchAllKeyword*/,
+                                     PEVENT_FILTER_DESCRIPTOR /*filterData*/,
+                                     PVOID /*callbackContext*/)
+{
+    if (isEnabled == EVENT_CONTROL_CODE_CAPTURE_STATE)
+    {
+        ApiStatistics::Instance().Trace();
+        Tracing::s_TraceAllocationStatistics();
+        Tracing::s_TraceMemoryUsage();
+    }
+}
+
 #pragma warning(push)
 // Disable 4351 so we can initialize the arrays to 0 without a warning.
 #pragma warning(disable : 4351)
@@ -55,7 +78,7 @@ Telemetry::Telemetry() :
     _uiQuickEditPasteRawUsed(0)
 {
     time(&_tStartedAt);
-    TraceLoggingRegister(g_hConhostV2EventTraceProvider);
+    TraceLoggingRegisterEx(g_hConhostV2EventTraceProvider, s_ProviderCallback, nullptr);
     TraceLoggingWriteStart(_activity, "ActivityStart");
     // initialize wil tracelogging
     wil::SetResultLoggingCallback(&Tracing::TraceFailure);
@@ -3,25 +3,12 @@
 
 #include "precomp.h"
 #include "tracing.hpp"
-#include "../interactivity/win32/UiaTextRange.hpp"
-#include "../interactivity/win32/screenInfoUiaProvider.hpp"
-#include "../interactivity/win32/windowUiaProvider.hpp"
+#include "../interactivity/inc/ServiceLocator.hpp"
+#include "history.h"
 
-using namespace Microsoft::Console::Interactivity::Win32;
-
-enum TraceKeywords
-{
-    //Font = 0x001, // _DBGFONTS
-    //Font2 = 0x002, // _DBGFONTS2
-    Chars = 0x004, // _DBGCHARS
-    Output = 0x008, // _DBGOUTPUT
-    General = 0x100,
-    Input = 0x200,
-    API = 0x400,
-    UIA = 0x800,
-    All = 0xFFF
-};
-DEFINE_ENUM_FLAG_OPERATORS(TraceKeywords);
+using Microsoft::Console::Interactivity::ServiceLocator;
+using Microsoft::Console::Types::AllocationTag;
+namespace AllocationTracking = Microsoft::Console::Types::AllocationTracking;
 
 // Routine Description:
 // - Creates a tracing object to assist with automatically firing a stop event
@@ -79,6 +66,38 @@ Tracing Tracing::s_TraceApiCall(const NTSTATUS& result, PCSTR traceName)
     // clang-format on
 }
 
+// Routine Description:
+// - Marks one phase of bringing up the console (server setup, settings,
+//   renderer, input thread, VT I/O) with start/stop period events so the
+//   cost of each can be seen when analyzing launch time.
+// Arguments:
+// - phaseName - The name of the startup phase to list in the trace details
+// Return Value:
+// - An object for the caller to hold until the phase is complete.
+//   Then destroy it to signal that the phase is over so the stop trace can be written.
+Tracing Tracing::s_TraceStartupPhase(PCSTR phaseName)
+{
+    // clang-format off
+    TraceLoggingWrite(
+        g_hConhostV2EventTraceProvider,
+        "StartupPhase",
+        TraceLoggingString(phaseName, "PhaseName"),
+        TraceLoggingOpcode(WINEVENT_OPCODE_START),
+        TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+        TraceLoggingKeyword(TraceKeywords::Startup));
+
+    return Tracing([phaseName] {
+        TraceLoggingWrite(
+            g_hConhostV2EventTraceProvider,
+            "StartupPhase",
+            TraceLoggingString(phaseName, "PhaseName"),
+            TraceLoggingOpcode(WINEVENT_OPCODE_STOP),
+            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+            TraceLoggingKeyword(TraceKeywords::Startup));
+    });
+    // clang-format on
+}
+
 ULONG Tracing::s_ulDebugFlag = 0x0;
 
 void Tracing::s_TraceApi(const NTSTATUS status, const CONSOLE_GETLARGESTWINDOWSIZE_MSG* const a)
@@ -258,6 +277,106 @@ void Tracing::s_TraceWindowViewport(const Microsoft::Console::Types::Viewport& v
         TraceLoggingKeyword(TraceKeywords::General));
 }
 
+void Tracing::s_TraceDeviceComm(const DeviceComm& deviceComm)
+{
+    TraceLoggingWrite(
+        g_hConhostV2EventTraceProvider,
+        "DeviceComm",
+        TraceLoggingUInt64(deviceComm.GetMessageCount(), "Messages"),
+        TraceLoggingUInt64(deviceComm.GetIoctlCount(), "Ioctls"),
+        TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+        TraceLoggingKeyword(TraceKeywords::API));
+}
+
+void Tracing::s_TraceApiStatistics(const ULONG layer, const ULONG api, const ApiStatistics::Entry& entry)
+{
+    const auto lockWait = entry.lockWait.GetBuckets();
+    const auto service = entry.service.GetBuckets();
+    const auto bucketCount = gsl::narrow_cast<UINT16>(Microsoft::Console::Types::Histogram::BucketCount);
+
+    TraceLoggingWrite(
+        g_hConhostV2EventTraceProvider,
+        "ApiStatistics",
+        TraceLoggingString(entry.traceName.load(std::memory_order_relaxed), "ApiName"),
+        TraceLoggingUInt32(layer + 1, "Layer"),
+        TraceLoggingUInt32(api, "Api"),
+        TraceLoggingUInt64(entry.calls.load(std::memory_order_relaxed), "Calls"),
+        TraceLoggingUInt64(entry.bytesIn.load(std::memory_order_relaxed), "BytesIn"),
+        TraceLoggingUInt64(entry.bytesOut.load(std::memory_order_relaxed), "BytesOut"),
+        TraceLoggingUInt64Array(lockWait.data(), bucketCount, "LockWaitUsLog2Buckets"),
+        TraceLoggingUInt64Array(service.data(), bucketCount, "ServiceUsLog2Buckets"),
+        TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+        TraceLoggingKeyword(TraceKeywords::API));
+}
+
+// Routine Description:
+// - Writes how many allocations each subsystem has made so far, and their total size.
+//   Only builds that count allocations write anything; see AllocationTracking.hpp.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Tracing::s_TraceAllocationStatistics()
+{
+    if constexpr (AllocationTracking::IsEnabled)
+    {
+        for (size_t i = 0; i < static_cast<size_t>(AllocationTag::Count); ++i)
+        {
+            const auto tag = static_cast<AllocationTag>(i);
+            const auto counts = AllocationTracking::GetCounts(tag);
+
+            TraceLoggingWrite(
+                g_hConhostV2EventTraceProvider,
+                "AllocationStatistics",
+                TraceLoggingString(AllocationTracking::GetTagName(tag), "Subsystem"),
+                TraceLoggingUInt64(counts.allocations, "Allocations"),
+                TraceLoggingUInt64(counts.bytes, "Bytes"),
+                TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+                TraceLoggingKeyword(TraceKeywords::Allocations));
+        }
+    }
+}
+
+// Routine Description:
+// - Writes out how much memory every screen buffer's text holds, broken down by what
+//   it's for, and how much the command histories hold between them.
+// - Takes the console lock while it walks the buffers.
+void Tracing::s_TraceMemoryUsage()
+{
+    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    gci.LockConsole();
+    auto unlock = wil::scope_exit([&]() { gci.UnlockConsole(); });
+
+    for (auto screenInfo = gci.ScreenBuffers; screenInfo != nullptr; screenInfo = screenInfo->Next)
+    {
+        const auto usage = screenInfo->GetMemoryUsage();
+
+        TraceLoggingWrite(
+            g_hConhostV2EventTraceProvider,
+            "ScreenBufferMemoryUsage",
+            TraceLoggingPointer(screenInfo, "ScreenBuffer"),
+            TraceLoggingBool(screenInfo == gci.pCurrentScreenBuffer, "Active"),
+            TraceLoggingUInt64(usage.Total(), "Total"),
+            TraceLoggingUInt64(usage.rows, "Rows"),
+            TraceLoggingUInt64(usage.cells, "Cells"),
+            TraceLoggingUInt64(usage.compactedCells, "CompactedCells"),
+            TraceLoggingUInt64(usage.attributes, "Attributes"),
+            TraceLoggingUInt64(usage.unicodeStorage, "UnicodeStorage"),
+            TraceLoggingUInt64(usage.spareStorage, "SpareStorage"),
+            TraceLoggingUInt64(usage.archiveIndex, "ArchiveIndex"),
+            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+            TraceLoggingKeyword(TraceKeywords::Memory));
+    }
+
+    TraceLoggingWrite(
+        g_hConhostV2EventTraceProvider,
+        "CommandHistoryMemoryUsage",
+        TraceLoggingUInt64(CommandHistory::s_CountOfHistories(), "Histories"),
+        TraceLoggingUInt64(CommandHistory::s_GetMemoryUsageOfAll(), "Total"),
+        TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+        TraceLoggingKeyword(TraceKeywords::Memory));
+}
+
 void Tracing::s_TraceChars(_In_z_ const char* pszMessage, ...)
 {
     va_list args;
@@ -396,715 +515,3 @@ void __stdcall Tracing::TraceFailure(const wil::FailureInfo& failure) noexcept
         TraceLoggingString(failure.pszCode, "Code"),
         TraceLoggingLevel(WINEVENT_LEVEL_ERROR));
 }
-
-void Tracing::s_TraceUia(const UiaTextRange* const range,
-                         const UiaTextRangeTracing::ApiCall apiCall,
-                         const UiaTextRangeTracing::IApiMsg* const apiMsg)
-{
-    unsigned long long id = 0u;
-    bool degenerate = true;
-    Endpoint start = 0u;
-    Endpoint end = 0u;
-    if (range)
-    {
-        id = range->GetId();
-        degenerate = range->IsDegenerate();
-        start = range->GetStart();
-        end = range->GetEnd();
-    }
-
-    switch (apiCall)
-    {
-    case UiaTextRangeTracing::ApiCall::Constructor:
-    {
-        id = static_cast<const UiaTextRangeTracing::ApiMsgConstructor* const>(apiMsg)->Id;
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::Constructor",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case UiaTextRangeTracing::ApiCall::AddRef:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::AddRef",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case UiaTextRangeTracing::ApiCall::Release:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::Release",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case UiaTextRangeTracing::ApiCall::QueryInterface:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::QueryInterface",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case UiaTextRangeTracing::ApiCall::Clone:
-    {
-        if (apiMsg == nullptr)
-        {
-            return;
-        }
-        auto cloneId = reinterpret_cast<const UiaTextRangeTracing::ApiMsgClone* const>(apiMsg)->CloneId;
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::Clone",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingValue(cloneId, "clone's _id"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case UiaTextRangeTracing::ApiCall::Compare:
-    {
-        const UiaTextRangeTracing::ApiMsgCompare* const msg = static_cast<const UiaTextRangeTracing::ApiMsgCompare* const>(apiMsg);
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::Compare",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingValue(msg->OtherId, "Other's Id"),
-            TraceLoggingValue(msg->Equal, "Equal"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case UiaTextRangeTracing::ApiCall::CompareEndpoints:
-    {
-        const UiaTextRangeTracing::ApiMsgCompareEndpoints* const msg = static_cast<const UiaTextRangeTracing::ApiMsgCompareEndpoints* const>(apiMsg);
-        const wchar_t* const pEndpoint = _textPatternRangeEndpointToString(msg->Endpoint);
-        const wchar_t* const pTargetEndpoint = _textPatternRangeEndpointToString(msg->TargetEndpoint);
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::CompareEndpoints",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingValue(msg->OtherId, "Other's Id"),
-            TraceLoggingValue(pEndpoint, "endpoint"),
-            TraceLoggingValue(pTargetEndpoint, "targetEndpoint"),
-            TraceLoggingValue(msg->Result, "Result"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case UiaTextRangeTracing::ApiCall::ExpandToEnclosingUnit:
-    {
-        const UiaTextRangeTracing::ApiMsgExpandToEnclosingUnit* const msg = static_cast<const UiaTextRangeTracing::ApiMsgExpandToEnclosingUnit* const>(apiMsg);
-        const wchar_t* const pUnitName = _textUnitToString(msg->Unit);
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::ExpandToEnclosingUnit",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingValue(pUnitName, "Unit"),
-            TraceLoggingValue(msg->OriginalStart, "Original Start"),
-            TraceLoggingValue(msg->OriginalEnd, "Original End"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case UiaTextRangeTracing::ApiCall::FindAttribute:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::FindAttribute",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case UiaTextRangeTracing::ApiCall::FindText:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::FindText",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case UiaTextRangeTracing::ApiCall::GetAttributeValue:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::GetAttributeValue",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case UiaTextRangeTracing::ApiCall::GetBoundingRectangles:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::GetBoundingRectangles",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case UiaTextRangeTracing::ApiCall::GetEnclosingElement:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::GetEnclosingElement",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case UiaTextRangeTracing::ApiCall::GetText:
-    {
-        const UiaTextRangeTracing::ApiMsgGetText* const msg = static_cast<const UiaTextRangeTracing::ApiMsgGetText* const>(apiMsg);
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::GetText",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingValue(msg->Text, "Text"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case UiaTextRangeTracing::ApiCall::Move:
-    {
-        const UiaTextRangeTracing::ApiMsgMove* const msg = static_cast<const UiaTextRangeTracing::ApiMsgMove* const>(apiMsg);
-        const wchar_t* const unitStr = _textUnitToString(msg->Unit);
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::Move",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingValue(msg->OriginalStart, "Original Start"),
-            TraceLoggingValue(msg->OriginalEnd, "Original End"),
-            TraceLoggingValue(unitStr, "unit"),
-            TraceLoggingValue(msg->RequestedCount, "Requested Count"),
-            TraceLoggingValue(msg->MovedCount, "Moved Count"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case UiaTextRangeTracing::ApiCall::MoveEndpointByUnit:
-    {
-        const UiaTextRangeTracing::ApiMsgMoveEndpointByUnit* const msg = static_cast<const UiaTextRangeTracing::ApiMsgMoveEndpointByUnit* const>(apiMsg);
-        const wchar_t* const pEndpoint = _textPatternRangeEndpointToString(msg->Endpoint);
-        const wchar_t* const unitStr = _textUnitToString(msg->Unit);
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::MoveEndpointByUnit",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingValue(msg->OriginalStart, "Original Start"),
-            TraceLoggingValue(msg->OriginalEnd, "Original End"),
-            TraceLoggingValue(pEndpoint, "endpoint"),
-            TraceLoggingValue(unitStr, "unit"),
-            TraceLoggingValue(msg->RequestedCount, "Requested Count"),
-            TraceLoggingValue(msg->MovedCount, "Moved Count"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case UiaTextRangeTracing::ApiCall::MoveEndpointByRange:
-    {
-        const UiaTextRangeTracing::ApiMsgMoveEndpointByRange* const msg = static_cast<const UiaTextRangeTracing::ApiMsgMoveEndpointByRange* const>(apiMsg);
-        const wchar_t* const pEndpoint = _textPatternRangeEndpointToString(msg->Endpoint);
-        const wchar_t* const pTargetEndpoint = _textPatternRangeEndpointToString(msg->TargetEndpoint);
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::MoveEndpointByRange",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingValue(msg->OriginalStart, "Original Start"),
-            TraceLoggingValue(msg->OriginalEnd, "Original End"),
-            TraceLoggingValue(pEndpoint, "endpoint"),
-            TraceLoggingValue(pTargetEndpoint, "targetEndpoint"),
-            TraceLoggingValue(msg->OtherId, "Other's _id"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case UiaTextRangeTracing::ApiCall::Select:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::Select",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case UiaTextRangeTracing::ApiCall::AddToSelection:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::AddToSelection",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case UiaTextRangeTracing::ApiCall::RemoveFromSelection:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::RemoveFromSelection",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case UiaTextRangeTracing::ApiCall::ScrollIntoView:
-    {
-        const UiaTextRangeTracing::ApiMsgScrollIntoView* const msg = static_cast<const UiaTextRangeTracing::ApiMsgScrollIntoView* const>(apiMsg);
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::ScrollIntoView",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingValue(msg->AlignToTop, "alignToTop"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case UiaTextRangeTracing::ApiCall::GetChildren:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "UiaTextRange::GetChildren",
-            TraceLoggingValue(id, "_id"),
-            TraceLoggingValue(start, "_start"),
-            TraceLoggingValue(end, "_end"),
-            TraceLoggingValue(degenerate, "_degenerate"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    default:
-        break;
-    }
-}
-
-void Tracing::s_TraceUia(const ScreenInfoUiaProvider* const /*pProvider*/,
-                         const ScreenInfoUiaProviderTracing::ApiCall apiCall,
-                         const ScreenInfoUiaProviderTracing::IApiMsg* const apiMsg)
-{
-    switch (apiCall)
-    {
-    case ScreenInfoUiaProviderTracing::ApiCall::Constructor:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::Constructor",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::Signal:
-    {
-        const ScreenInfoUiaProviderTracing::ApiMsgSignal* const msg = static_cast<const ScreenInfoUiaProviderTracing::ApiMsgSignal* const>(apiMsg);
-        const wchar_t* const signalName = _eventIdToString(msg->Signal);
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::Signal",
-            TraceLoggingValue(msg->Signal),
-            TraceLoggingValue(signalName, "Event Name"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case ScreenInfoUiaProviderTracing::ApiCall::AddRef:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::AddRef",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::Release:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::Release",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::QueryInterface:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::QueryInterface",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::GetProviderOptions:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::GetProviderOptions",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::GetPatternProvider:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::GetPatternProvider",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::GetPropertyValue:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::GetPropertyValue",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::GetHostRawElementProvider:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::GetHostRawElementProvider",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::Navigate:
-    {
-        const ScreenInfoUiaProviderTracing::ApiMsgNavigate* const msg = static_cast<const ScreenInfoUiaProviderTracing::ApiMsgNavigate* const>(apiMsg);
-        const wchar_t* const direction = _directionToString(msg->Direction);
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::Navigate",
-            TraceLoggingValue(direction, "direction"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case ScreenInfoUiaProviderTracing::ApiCall::GetRuntimeId:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::GetRuntimeId",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::GetBoundingRectangle:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::GetBoundingRectangles",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::GetEmbeddedFragmentRoots:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::GetEmbeddedFragmentRoots",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::SetFocus:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::SetFocus",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::GetFragmentRoot:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::GetFragmentRoot",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::GetSelection:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::GetSelection",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::GetVisibleRanges:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::GetVisibleRanges",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::RangeFromChild:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::RangeFromChild",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::RangeFromPoint:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::RangeFromPoint",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::GetDocumentRange:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::GetDocumentRange",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case ScreenInfoUiaProviderTracing::ApiCall::GetSupportedTextSelection:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "ScreenInfoUiaProvider::GetSupportedTextSelection",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    default:
-        break;
-    }
-}
-
-void Tracing::s_TraceUia(const WindowUiaProvider* const /*pProvider*/,
-                         const WindowUiaProviderTracing::ApiCall apiCall,
-                         const WindowUiaProviderTracing::IApiMsg* const apiMsg)
-{
-    switch (apiCall)
-    {
-    case WindowUiaProviderTracing::ApiCall::Create:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::Create",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::Signal:
-    {
-        const WindowUiaProviderTracing::ApiMessageSignal* const msg = static_cast<const WindowUiaProviderTracing::ApiMessageSignal* const>(apiMsg);
-        const wchar_t* const eventName = _eventIdToString(msg->Signal);
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::Signal",
-            TraceLoggingValue(msg->Signal, "Signal"),
-            TraceLoggingValue(eventName, "Signal Name"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case WindowUiaProviderTracing::ApiCall::AddRef:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::AddRef",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::Release:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::Release",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::QueryInterface:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::QueryInterface",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::GetProviderOptions:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::GetProviderOptions",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::GetPatternProvider:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::GetPatternProvider",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::GetPropertyValue:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::GetPropertyValue",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::GetHostRawElementProvider:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::GetHostRawElementProvider",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::Navigate:
-    {
-        const WindowUiaProviderTracing::ApiMsgNavigate* const msg = static_cast<const WindowUiaProviderTracing::ApiMsgNavigate* const>(apiMsg);
-        const wchar_t* const direction = _directionToString(msg->Direction);
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::Navigate",
-            TraceLoggingValue(direction, "direction"),
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    }
-    case WindowUiaProviderTracing::ApiCall::GetRuntimeId:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::GetRuntimeId",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::GetBoundingRectangle:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::GetBoundingRectangle",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::GetEmbeddedFragmentRoots:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::GetEmbeddedFragmentRoots",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::SetFocus:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::SetFocus",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::GetFragmentRoot:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::GetFragmentRoot",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::ElementProviderFromPoint:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::ElementProviderFromPoint",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    case WindowUiaProviderTracing::ApiCall::GetFocus:
-        TraceLoggingWrite(
-            g_hConhostV2EventTraceProvider,
-            "WindowUiaProvider::GetFocus",
-            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
-            TraceLoggingKeyword(TraceKeywords::UIA));
-        break;
-    default:
-        break;
-    }
-}
-
-const wchar_t* const Tracing::_textPatternRangeEndpointToString(int endpoint)
-{
-    switch (endpoint)
-    {
-    case TextPatternRangeEndpoint::TextPatternRangeEndpoint_Start:
-        return L"Start";
-    case TextPatternRangeEndpoint::TextPatternRangeEndpoint_End:
-        return L"End";
-    default:
-        return L"Unknown";
-    }
-}
-
-const wchar_t* const Tracing::_textUnitToString(int unit)
-{
-    switch (unit)
-    {
-    case TextUnit::TextUnit_Character:
-        return L"TextUnit_Character";
-    case TextUnit::TextUnit_Format:
-        return L"TextUnit_Format";
-    case TextUnit::TextUnit_Word:
-        return L"TextUnit_Word";
-    case TextUnit::TextUnit_Line:
-        return L"TextUnit_Line";
-    case TextUnit::TextUnit_Paragraph:
-        return L"TextUnit_Paragraph";
-    case TextUnit::TextUnit_Page:
-        return L"TextUnit_Page";
-    case TextUnit::TextUnit_Document:
-        return L"TextUnit_Document";
-    default:
-        return L"Unknown";
-    }
-}
-
-const wchar_t* const Tracing::_eventIdToString(long eventId)
-{
-    switch (eventId)
-    {
-    case UIA_AutomationFocusChangedEventId:
-        return L"UIA_AutomationFocusChangedEventId";
-    case UIA_Text_TextChangedEventId:
-        return L"UIA_Text_TextChangedEventId";
-    case UIA_Text_TextSelectionChangedEventId:
-        return L"UIA_Text_TextSelectionChangedEventId";
-    default:
-        return L"Unknown";
-    }
-}
-
-const wchar_t* const Tracing::_directionToString(int direction)
-{
-    switch (direction)
-    {
-    case NavigateDirection::NavigateDirection_FirstChild:
-        return L"NavigateDirection_FirstChild";
-    case NavigateDirection::NavigateDirection_LastChild:
-        return L"NavigateDirection_LastChild";
-    case NavigateDirection::NavigateDirection_NextSibling:
-        return L"NavigateDirection_NextSibling";
-    case NavigateDirection::NavigateDirection_Parent:
-        return L"NavigateDirection_Parent";
-    case NavigateDirection::NavigateDirection_PreviousSibling:
-        return L"NavigateDirection_PreviousSibling";
-    default:
-        return L"Unknown";
-    }
-}
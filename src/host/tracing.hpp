@@ -20,6 +20,10 @@ Author(s):
 #include <functional>
 
 #include "../types/inc/Viewport.hpp"
+#include "../types/inc/AllocationTracking.hpp"
+#include "../server/ApiStatistics.h"
+
+class DeviceComm;
 
 namespace Microsoft::Console::Interactivity::Win32
 {
@@ -68,6 +72,7 @@ public:
     ~Tracing();
 
     static Tracing s_TraceApiCall(const NTSTATUS& result, PCSTR traceName);
+    static Tracing s_TraceStartupPhase(PCSTR phaseName);
 
     static void s_TraceApi(const NTSTATUS status, const CONSOLE_GETLARGESTWINDOWSIZE_MSG* const a);
     static void s_TraceApi(const NTSTATUS status, const CONSOLE_SCREENBUFFERINFO_MSG* const a, const bool fSet);
@@ -83,6 +88,11 @@ public:
 
     static void s_TraceWindowViewport(const Microsoft::Console::Types::Viewport& viewport);
 
+    static void s_TraceDeviceComm(const DeviceComm& deviceComm);
+    static void s_TraceApiStatistics(const ULONG layer, const ULONG api, const ApiStatistics::Entry& entry);
+    static void s_TraceAllocationStatistics();
+    static void s_TraceMemoryUsage();
+
     static void s_TraceChars(_In_z_ const char* pszMessage, ...);
     static void s_TraceOutput(_In_z_ const char* pszMessage, ...);
 
@@ -104,6 +114,22 @@ public:
                            const Microsoft::Console::Interactivity::Win32::WindowUiaProviderTracing::IApiMsg* const apiMsg);
 
 private:
+    enum TraceKeywords
+    {
+        //Font = 0x001, // _DBGFONTS
+        //Font2 = 0x002, // _DBGFONTS2
+        Chars = 0x004, // _DBGCHARS
+        Output = 0x008, // _DBGOUTPUT
+        General = 0x100,
+        Input = 0x200,
+        API = 0x400,
+        UIA = 0x800,
+        Startup = 0x1000,
+        Allocations = 0x2000,
+        Memory = 0x4000,
+        All = 0x7FFF
+    };
+
     static ULONG s_ulDebugFlag;
 
     Tracing(std::function<void()> onExit);
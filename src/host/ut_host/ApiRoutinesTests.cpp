@@ -11,6 +11,7 @@
 #include "getset.h"
 #include "dbcs.h"
 #include "misc.h"
+#include "stream.h"
 
 #include "..\interactivity\inc\ServiceLocator.hpp"
 
@@ -389,30 +390,17 @@ class ApiRoutinesTests
             const HRESULT hr = _pApiRoutines->WriteConsoleAImpl(si, { pszTestText + i, cchWriteLength }, cchRead, waiter);
 
             VERIFY_ARE_EQUAL(S_OK, hr, L"Successful result code from writing.");
-            if (!fInduceWait)
-            {
-                VERIFY_IS_NULL(waiter.get(), L"We should have no waiter for this case.");
-                VERIFY_ARE_EQUAL(cchWriteLength, cchRead, L"We should have the same character count back as 'written' that we gave in.");
-            }
-            else
+            // A blocked write is held to be written later, so it completes right away too.
+            VERIFY_IS_NULL(waiter.get(), L"We should have no waiter for this case.");
+            VERIFY_ARE_EQUAL(cchWriteLength, cchRead, L"We should have the same character count back as 'written' that we gave in.");
+
+            if (fInduceWait)
             {
-                VERIFY_IS_NOT_NULL(waiter.get(), L"We should have a waiter for this case.");
-                // The cchRead is irrelevant at this point as it's not going to be returned until we're off the wait.
-
-                Log::Comment(L"Unblocking global output state so the wait can be serviced.");
-                s_AdjustOutputWait(false);
-                Log::Comment(L"Dispatching the wait.");
-                NTSTATUS Status = STATUS_SUCCESS;
-                size_t dwNumBytes = 0;
-                DWORD dwControlKeyState = 0; // unused but matches the pattern for read.
-                void* pOutputData = nullptr; // unused for writes but used for read.
-                const BOOL bNotifyResult = waiter->Notify(WaitTerminationReason::NoReason, FALSE, &Status, &dwNumBytes, &dwControlKeyState, &pOutputData);
-
-                VERIFY_IS_TRUE(!!bNotifyResult, L"Wait completion on notify should be successful.");
-                VERIFY_ARE_EQUAL(STATUS_SUCCESS, Status, L"We should have a successful return code to pass to the caller.");
-
-                const size_t dwBytesExpected = cchWriteLength;
-                VERIFY_ARE_EQUAL(dwBytesExpected, dwNumBytes, L"We should have the byte length of the string we put in as the returned value.");
+                VERIFY_IS_FALSE(gci.PendingWrites.empty(), L"The text should be held until output is unblocked.");
+
+                Log::Comment(L"Unblocking global output state so the held text is written.");
+                UnblockWriteConsole(CONSOLE_SELECTING);
+                VERIFY_IS_TRUE(gci.PendingWrites.empty(), L"The held text should have been written.");
             }
         }
     }
@@ -445,31 +433,108 @@ class ApiRoutinesTests
         const HRESULT hr = _pApiRoutines->WriteConsoleWImpl(si, testText, cchRead, waiter);
 
         VERIFY_ARE_EQUAL(S_OK, hr, L"Successful result code from writing.");
-        if (!fInduceWait)
+        // A blocked write is held to be written later, so it completes right away too.
+        VERIFY_IS_NULL(waiter.get(), L"We should have no waiter for this case.");
+        VERIFY_ARE_EQUAL(testText.size(), cchRead, L"We should have the same character count back as 'written' that we gave in.");
+
+        if (fInduceWait)
         {
-            VERIFY_IS_NULL(waiter.get(), L"We should have no waiter for this case.");
-            VERIFY_ARE_EQUAL(testText.size(), cchRead, L"We should have the same character count back as 'written' that we gave in.");
+            VERIFY_IS_FALSE(gci.PendingWrites.empty(), L"The text should be held until output is unblocked.");
+
+            Log::Comment(L"Unblocking global output state so the held text is written.");
+            UnblockWriteConsole(CONSOLE_SELECTING);
+            VERIFY_IS_TRUE(gci.PendingWrites.empty(), L"The held text should have been written.");
         }
-        else
-        {
-            VERIFY_IS_NOT_NULL(waiter.get(), L"We should have a waiter for this case.");
-            // The cchRead is irrelevant at this point as it's not going to be returned until we're off the wait.
+    }
 
-            Log::Comment(L"Unblocking global output state so the wait can be serviced.");
-            s_AdjustOutputWait(false);
-            Log::Comment(L"Dispatching the wait.");
+    TEST_METHOD(ApiWriteConsoleWaitsWhenPendingWritesAreFull)
+    {
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+
+        gci.LockConsole();
+        auto Unlock = wil::scope_exit([&] { gci.UnlockConsole(); });
+
+        Log::Comment(L"Blocking global output state to induce waits.");
+        s_AdjustOutputWait(true);
+
+        Log::Comment(L"Writing more text than can be held while blocked.");
+        const std::wstring testText(128 * 1024, L'X');
+        size_t cchRead = 0;
+        std::unique_ptr<IWaitRoutine> waiter;
+        VERIFY_ARE_EQUAL(S_OK, _pApiRoutines->WriteConsoleWImpl(si, testText, cchRead, waiter));
+        VERIFY_IS_NOT_NULL(waiter.get(), L"We should have a waiter for this case.");
+
+        Log::Comment(L"A short write after it has to wait too, to stay in order.");
+        std::unique_ptr<IWaitRoutine> secondWaiter;
+        VERIFY_ARE_EQUAL(S_OK, _pApiRoutines->WriteConsoleWImpl(si, L"Test text", cchRead, secondWaiter));
+        VERIFY_IS_NOT_NULL(secondWaiter.get(), L"We should have a waiter for the second write too.");
+
+        Log::Comment(L"Unblocking global output state so the waits can be serviced.");
+        s_AdjustOutputWait(false);
+        for (auto& pending : { waiter.get(), secondWaiter.get() })
+        {
             NTSTATUS Status = STATUS_SUCCESS;
             size_t dwNumBytes = 0;
             DWORD dwControlKeyState = 0; // unused but matches the pattern for read.
             void* pOutputData = nullptr; // unused for writes but used for read.
-            const BOOL bNotifyResult = waiter->Notify(WaitTerminationReason::NoReason, TRUE, &Status, &dwNumBytes, &dwControlKeyState, &pOutputData);
+            const BOOL bNotifyResult = pending->Notify(WaitTerminationReason::NoReason, TRUE, &Status, &dwNumBytes, &dwControlKeyState, &pOutputData);
 
             VERIFY_IS_TRUE(!!bNotifyResult, L"Wait completion on notify should be successful.");
             VERIFY_ARE_EQUAL(STATUS_SUCCESS, Status, L"We should have a successful return code to pass to the caller.");
-
-            const size_t dwBytesExpected = testText.size() * sizeof(wchar_t);
-            VERIFY_ARE_EQUAL(dwBytesExpected, dwNumBytes, L"We should have the byte length of the string we put in as the returned value.");
         }
+        VERIFY_IS_FALSE(gci.PendingWritesOverflowed, L"Writes should be held again the next time output is blocked.");
+    }
+
+    TEST_METHOD(ApiWriteConsoleWaitsWhileSuspended)
+    {
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+
+        gci.LockConsole();
+        auto Unlock = wil::scope_exit([&] { gci.UnlockConsole(); });
+
+        Log::Comment(L"Pausing output, as the Pause key does.");
+        WI_SetFlag(gci.Flags, CONSOLE_SUSPENDED);
+        auto Resume = wil::scope_exit([&] { UnblockWriteConsole(CONSOLE_SUSPENDED); });
+
+        size_t cchRead = 0;
+        std::unique_ptr<IWaitRoutine> waiter;
+        VERIFY_ARE_EQUAL(S_OK, _pApiRoutines->WriteConsoleWImpl(si, L"Test text", cchRead, waiter));
+        VERIFY_IS_NOT_NULL(waiter.get(), L"Pausing has to stop the client, so the write should wait.");
+        VERIFY_IS_TRUE(gci.PendingWrites.empty(), L"Nothing should be held while paused.");
+    }
+
+    TEST_METHOD(ApiSetConsoleTextAttributeWritesHeldTextFirst)
+    {
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+
+        gci.LockConsole();
+        auto Unlock = wil::scope_exit([&] { gci.UnlockConsole(); });
+
+        Log::Comment(L"Blocking global output state so the write is held.");
+        s_AdjustOutputWait(true);
+        const auto attributes = si.GetAttributes();
+        auto Restore = wil::scope_exit([&] {
+            UnblockWriteConsole(CONSOLE_SELECTING);
+            si.SetAttributes(attributes);
+        });
+
+        const auto start = si.GetTextBuffer().GetCursor().GetPosition();
+        size_t cchRead = 0;
+        std::unique_ptr<IWaitRoutine> waiter;
+        VERIFY_ARE_EQUAL(S_OK, _pApiRoutines->WriteConsoleWImpl(si, L"ab", cchRead, waiter));
+        VERIFY_IS_FALSE(gci.PendingWrites.empty(), L"The text should be held until output is unblocked.");
+
+        Log::Comment(L"Changing the attributes writes the held text first, with the attributes it was written with.");
+        VERIFY_SUCCEEDED(_pApiRoutines->SetConsoleTextAttributeImpl(si, FOREGROUND_RED | BACKGROUND_BLUE));
+        VERIFY_IS_TRUE(gci.PendingWrites.empty(), L"The held text should have been written.");
+
+        const auto& row = si.GetTextBuffer().GetRowByOffset(start.Y);
+        VERIFY_ARE_EQUAL(L'a', row.GetCharRow().GlyphAt(start.X).begin()[0]);
+        VERIFY_IS_TRUE(attributes == row.GetAttrRow().GetAttrByColumn(start.X));
+        VERIFY_IS_FALSE(attributes == si.GetAttributes());
     }
 
     void ValidateScreen(SCREEN_INFORMATION& si,
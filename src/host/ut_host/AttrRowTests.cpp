@@ -103,12 +103,12 @@ class AttrRowTests
 
         // Create the chain
         pChain = new ATTR_ROW(_sDefaultLength, _DefaultAttr);
-        pChain->_list.resize(sChainSegmentsNeeded);
+        std::vector<TextAttributeRun> chain(sChainSegmentsNeeded);
 
         // Attach all chain segments that are even multiples of the row length
         for (short iChain = 0; iChain < _sDefaultChainLength; iChain++)
         {
-            TextAttributeRun* pRun = &pChain->_list[iChain];
+            TextAttributeRun* pRun = &chain[iChain];
 
             pRun->SetAttributesFromLegacy(iChain); // Just use the chain position as the value
             pRun->SetLength(sChainSegLength);
@@ -118,12 +118,14 @@ class AttrRowTests
         {
             // If we had a leftover, then this chain is one longer than we expected (the default length)
             // So use it as the index (because indicies start at 0)
-            TextAttributeRun* pRun = &pChain->_list[_sDefaultChainLength];
+            TextAttributeRun* pRun = &chain[_sDefaultChainLength];
 
             pRun->SetAttributes(_DefaultChainAttr);
             pRun->SetLength(sChainLeftover);
         }
 
+        SetRuns(*pChain, chain);
+
         return true;
     }
 
@@ -151,9 +153,9 @@ class AttrRowTests
 
             pUnderTest->Reset(attr);
 
-            VERIFY_ARE_EQUAL(pUnderTest->_list.size(), 1u);
-            VERIFY_ARE_EQUAL(pUnderTest->_list[0].GetAttributes(), attr);
-            VERIFY_ARE_EQUAL(pUnderTest->_list[0].GetLength(), (unsigned int)_sDefaultLength);
+            VERIFY_ARE_EQUAL(GetRuns(*pUnderTest).size(), 1u);
+            VERIFY_ARE_EQUAL(GetRuns(*pUnderTest)[0].GetAttributes(), attr);
+            VERIFY_ARE_EQUAL(GetRuns(*pUnderTest)[0].GetLength(), (unsigned int)_sDefaultLength);
         }
     }
 
@@ -230,13 +232,39 @@ class AttrRowTests
         return HRESULT_FROM_NT(status);
     }
 
-    NoThrowString LogRunElement(_In_ TextAttributeRun& run)
+    // Routine Description:
+    // - Replaces the runs of a row with the given ones.
+    // Arguments:
+    // - row - the row to fill. The runs must cover its whole width.
+    // - runs - the runs to store in the row.
+    void SetRuns(ATTR_ROW& row, const std::vector<TextAttributeRun>& runs)
+    {
+        VERIFY_SUCCEEDED(row.InsertAttrRuns({ runs.data(), runs.size() }, 0, row._cchRowWidth - 1, row._cchRowWidth));
+    }
+
+    // Routine Description:
+    // - Reads the runs of a row back out of its attribute table.
+    // Arguments:
+    // - row - the row to read
+    // Return Value:
+    // - the runs of the row with their attributes looked up
+    std::vector<TextAttributeRun> GetRuns(const ATTR_ROW& row)
+    {
+        std::vector<TextAttributeRun> runs;
+        for (const auto& run : row._list)
+        {
+            runs.emplace_back(run.length, row._table->Get(run.id));
+        }
+        return runs;
+    }
+
+    NoThrowString LogRunElement(_In_ const TextAttributeRun& run)
     {
         return NoThrowString().Format(L"%wc%d", run.GetAttributes().GetLegacyAttributes(), run.GetLength());
     }
 
     void LogChain(_In_ PCWSTR pwszPrefix,
-                  std::vector<TextAttributeRun>& chain)
+                  const std::vector<TextAttributeRun>& chain)
     {
         NoThrowString str(pwszPrefix);
 
@@ -266,16 +294,16 @@ class AttrRowTests
 
         // Set up our "original row" that we are going to try to insert into.
         // This will represent a 10 column run of R3->B5->G2 that we will use for all tests.
-        ATTR_ROW originalRow{ static_cast<UINT>(_sDefaultLength), _DefaultAttr };
-        originalRow._list.resize(3);
-        originalRow._cchRowWidth = 10;
-        originalRow._list[0].SetAttributesFromLegacy('R');
-        originalRow._list[0].SetLength(3);
-        originalRow._list[1].SetAttributesFromLegacy('B');
-        originalRow._list[1].SetLength(5);
-        originalRow._list[2].SetAttributesFromLegacy('G');
-        originalRow._list[2].SetLength(2);
-        LogChain(L"Original: ", originalRow._list);
+        ATTR_ROW originalRow{ 10, _DefaultAttr };
+        std::vector<TextAttributeRun> original(3);
+        original[0].SetAttributesFromLegacy('R');
+        original[0].SetLength(3);
+        original[1].SetAttributesFromLegacy('B');
+        original[1].SetLength(5);
+        original[2].SetAttributesFromLegacy('G');
+        original[2].SetLength(2);
+        SetRuns(originalRow, original);
+        LogChain(L"Original: ", GetRuns(originalRow));
 
         // Set up our "insertion run"
         size_t cInsertRow = 1;
@@ -347,17 +375,17 @@ class AttrRowTests
         VERIFY_SUCCEEDED(originalRow.InsertAttrRuns({ insertRow.data(), insertRow.size() }, uiStartPos, uiEndPos, (UINT)originalRow._cchRowWidth));
 
         // Compare and ensure that the expected and actual match.
-        VERIFY_ARE_EQUAL(cPackedRun, originalRow._list.size(), L"Ensure that number of array elements required for RLE are the same.");
+        VERIFY_ARE_EQUAL(cPackedRun, GetRuns(originalRow).size(), L"Ensure that number of array elements required for RLE are the same.");
 
         std::vector<TextAttributeRun> packedRunExpected;
         std::copy_n(packedRun.get(), cPackedRun, std::back_inserter(packedRunExpected));
 
         LogChain(L"Expected: ", packedRunExpected);
-        LogChain(L"Actual: ", originalRow._list);
+        LogChain(L"Actual: ", GetRuns(originalRow));
 
         for (size_t testIndex = 0; testIndex < cPackedRun; testIndex++)
         {
-            VERIFY_ARE_EQUAL(packedRun[testIndex], originalRow._list[testIndex]);
+            VERIFY_ARE_EQUAL(packedRun[testIndex], GetRuns(originalRow)[testIndex]);
         }
     }
 
@@ -511,35 +539,35 @@ class AttrRowTests
         pSingle->SetAttrToEnd(iTestIndex, TestAttr);
 
         // Was 1 (single), should now have 2 segments
-        VERIFY_ARE_EQUAL(pSingle->_list.size(), 2u);
+        VERIFY_ARE_EQUAL(GetRuns(*pSingle).size(), 2u);
 
-        VERIFY_ARE_EQUAL(pSingle->_list[0].GetAttributes(), _DefaultAttr);
-        VERIFY_ARE_EQUAL(pSingle->_list[0].GetLength(), (unsigned int)(_sDefaultLength - (_sDefaultLength - iTestIndex)));
+        VERIFY_ARE_EQUAL(GetRuns(*pSingle)[0].GetAttributes(), _DefaultAttr);
+        VERIFY_ARE_EQUAL(GetRuns(*pSingle)[0].GetLength(), (unsigned int)(_sDefaultLength - (_sDefaultLength - iTestIndex)));
 
-        VERIFY_ARE_EQUAL(pSingle->_list[1].GetAttributes(), TestAttr);
-        VERIFY_ARE_EQUAL(pSingle->_list[1].GetLength(), (unsigned int)(_sDefaultLength - iTestIndex));
+        VERIFY_ARE_EQUAL(GetRuns(*pSingle)[1].GetAttributes(), TestAttr);
+        VERIFY_ARE_EQUAL(GetRuns(*pSingle)[1].GetLength(), (unsigned int)(_sDefaultLength - iTestIndex));
 
         Log::Comment(L"SetAttrToEnd for existing chain of multiple colors.");
         pChain->SetAttrToEnd(iTestIndex, TestAttr);
 
         // From 7 segments down to 5.
-        VERIFY_ARE_EQUAL(pChain->_list.size(), 5u);
+        VERIFY_ARE_EQUAL(GetRuns(*pChain).size(), 5u);
 
         // Verify chain colors and lengths
-        VERIFY_ARE_EQUAL(TextAttribute(0), pChain->_list[0].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[0].GetLength(), (unsigned int)13);
+        VERIFY_ARE_EQUAL(TextAttribute(0), GetRuns(*pChain)[0].GetAttributes());
+        VERIFY_ARE_EQUAL(GetRuns(*pChain)[0].GetLength(), (unsigned int)13);
 
-        VERIFY_ARE_EQUAL(TextAttribute(1), pChain->_list[1].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[1].GetLength(), (unsigned int)13);
+        VERIFY_ARE_EQUAL(TextAttribute(1), GetRuns(*pChain)[1].GetAttributes());
+        VERIFY_ARE_EQUAL(GetRuns(*pChain)[1].GetLength(), (unsigned int)13);
 
-        VERIFY_ARE_EQUAL(TextAttribute(2), pChain->_list[2].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[2].GetLength(), (unsigned int)13);
+        VERIFY_ARE_EQUAL(TextAttribute(2), GetRuns(*pChain)[2].GetAttributes());
+        VERIFY_ARE_EQUAL(GetRuns(*pChain)[2].GetLength(), (unsigned int)13);
 
-        VERIFY_ARE_EQUAL(TextAttribute(3), pChain->_list[3].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[3].GetLength(), (unsigned int)11);
+        VERIFY_ARE_EQUAL(TextAttribute(3), GetRuns(*pChain)[3].GetAttributes());
+        VERIFY_ARE_EQUAL(GetRuns(*pChain)[3].GetLength(), (unsigned int)11);
 
-        VERIFY_ARE_EQUAL(TestAttr, pChain->_list[4].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[4].GetLength(), (unsigned int)30);
+        VERIFY_ARE_EQUAL(TestAttr, GetRuns(*pChain)[4].GetAttributes());
+        VERIFY_ARE_EQUAL(GetRuns(*pChain)[4].GetLength(), (unsigned int)30);
 
         Log::Comment(L"SECOND: Set index to 0 to test replacing anything with a single");
 
@@ -552,13 +580,13 @@ class AttrRowTests
             pUnderTest->SetAttrToEnd(0, TestAttr);
 
             // should be down to 1 attribute set from beginning to end of string
-            VERIFY_ARE_EQUAL(pUnderTest->_list.size(), 1u);
+            VERIFY_ARE_EQUAL(GetRuns(*pUnderTest).size(), 1u);
 
             // singular pair should contain the color
-            VERIFY_ARE_EQUAL(pUnderTest->_list[0].GetAttributes(), TestAttr);
+            VERIFY_ARE_EQUAL(GetRuns(*pUnderTest)[0].GetAttributes(), TestAttr);
 
             // and its length should be the length of the whole string
-            VERIFY_ARE_EQUAL(pUnderTest->_list[0].GetLength(), (unsigned int)_sDefaultLength);
+            VERIFY_ARE_EQUAL(GetRuns(*pUnderTest)[0].GetLength(), (unsigned int)_sDefaultLength);
         }
     }
 
@@ -603,4 +631,105 @@ class AttrRowTests
         state.CleanupGlobalScreenBuffer();
         state.CleanupGlobalFont();
     }
+
+    TEST_METHOD(TestSharedAttributeTable)
+    {
+        const TextAttribute red{ FOREGROUND_RED };
+        const TextAttribute green{ FOREGROUND_GREEN };
+
+        auto table = std::make_shared<TextAttributeTable>();
+        ATTR_ROW first{ 10, _DefaultAttr, table };
+
+        Log::Comment(L"Rows sharing a table should share an id for the same attribute.");
+        {
+            ATTR_ROW second{ 20, _DefaultAttr, table };
+            VERIFY_ARE_EQUAL(1u, table->size());
+            VERIFY_ARE_EQUAL(first._list[0].id, second._list[0].id);
+
+            VERIFY_IS_TRUE(second.SetAttrToEnd(5, red));
+            VERIFY_ARE_EQUAL(2u, table->size());
+
+            Log::Comment(L"Copies keep their own references.");
+            ATTR_ROW copy{ second };
+            VERIFY_IS_TRUE(second.SetAttrToEnd(0, green));
+            VERIFY_ARE_EQUAL(3u, table->size());
+            VERIFY_ARE_EQUAL(red, copy.GetAttrByColumn(5));
+        }
+
+        Log::Comment(L"Attributes no longer used by any row should leave the table.");
+        VERIFY_ARE_EQUAL(1u, table->size());
+        VERIFY_ARE_EQUAL(TextAttributeTable::InvalidId, table->Find(red));
+        VERIFY_ARE_EQUAL(TextAttributeTable::InvalidId, table->Find(green));
+
+        Log::Comment(L"Replacing an attribute should move every run using it to the new id.");
+        first.ReplaceAttrs(_DefaultAttr, red);
+        VERIFY_ARE_EQUAL(1u, table->size());
+        VERIFY_ARE_EQUAL(table->Find(red), first._list[0].id);
+        VERIFY_ARE_EQUAL(red, first.GetAttrByColumn(9));
+    }
+
+    TEST_METHOD(TestSingleRunStaysInline)
+    {
+        const TextAttribute red{ FOREGROUND_RED };
+
+        Log::Comment(L"A row of one color should hold its run without any heap storage.");
+        ATTR_ROW row{ 10, _DefaultAttr };
+        VERIFY_ARE_EQUAL(1u, row.GetNumberOfRuns());
+        VERIFY_ARE_EQUAL(1u, row._list.capacity());
+
+        size_t applies = 0;
+        VERIFY_ARE_EQUAL(_DefaultAttr, row.GetAttrByColumn(4, &applies));
+        VERIFY_ARE_EQUAL(6u, applies);
+        VERIFY_ARE_EQUAL(std::ptrdiff_t{ 10 }, std::distance(row.begin(), row.end()));
+
+        Log::Comment(L"More colors should move the runs out to the heap.");
+        const TextAttributeRun run{ 2, red };
+        VERIFY_SUCCEEDED(row.InsertAttrRuns({ &run, 1 }, 3, 4, 10));
+        VERIFY_ARE_EQUAL(3u, row.GetNumberOfRuns());
+        VERIFY_IS_GREATER_THAN_OR_EQUAL(row._list.capacity(), 3u);
+        VERIFY_ARE_EQUAL(red, row.GetAttrByColumn(4, &applies));
+        VERIFY_ARE_EQUAL(1u, applies);
+        VERIFY_ARE_EQUAL(std::ptrdiff_t{ 10 }, std::distance(row.begin(), row.end()));
+
+        Log::Comment(L"Going back to one color should keep the heap storage around for next time...");
+        VERIFY_IS_TRUE(row.SetAttrToEnd(0, red));
+        VERIFY_ARE_EQUAL(1u, row.GetNumberOfRuns());
+        VERIFY_IS_GREATER_THAN_OR_EQUAL(row._list.capacity(), 3u);
+        VERIFY_ARE_EQUAL(red, row.GetAttrByColumn(0));
+
+        Log::Comment(L"...until the row is asked to let go of it.");
+        row.ShrinkToFit();
+        VERIFY_ARE_EQUAL(1u, row._list.capacity());
+        VERIFY_ARE_EQUAL(red, row.GetAttrByColumn(9));
+        VERIFY_ARE_EQUAL(std::ptrdiff_t{ 10 }, std::distance(row.begin(), row.end()));
+    }
+
+    TEST_METHOD(TestCopyLegacyAttrs)
+    {
+        const WORD red = FOREGROUND_RED;
+        const WORD blue = FOREGROUND_BLUE | BACKGROUND_GREEN;
+
+        ATTR_ROW row{ 10, TextAttribute{ red } };
+        const TextAttributeRun run{ 3, TextAttribute{ blue } };
+        VERIFY_SUCCEEDED(row.InsertAttrRuns({ &run, 1 }, 4, 6, 10));
+
+        Log::Comment(L"Copying the whole row should give one attribute per column.");
+        std::vector<WORD> attrs(10);
+        row.CopyLegacyAttrs(0, attrs.data(), attrs.size());
+        const WORD expected[]{ red, red, red, red, blue, blue, blue, red, red, red };
+        for (size_t i = 0; i < attrs.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(expected[i], attrs[i]);
+        }
+
+        Log::Comment(L"Copying from partway through should start and stop inside the runs.");
+        std::vector<WORD> middle(4);
+        row.CopyLegacyAttrs(3, middle.data(), middle.size());
+        VERIFY_ARE_EQUAL(red, middle[0]);
+        VERIFY_ARE_EQUAL(blue, middle[1]);
+        VERIFY_ARE_EQUAL(blue, middle[3]);
+
+        Log::Comment(L"Copying past the end of the row should be refused.");
+        VERIFY_THROWS_SPECIFIC(row.CopyLegacyAttrs(8, attrs.data(), 3), wil::ResultException, [](wil::ResultException& e) { return e.GetErrorCode() == E_INVALIDARG; });
+    }
 };
@@ -157,6 +157,122 @@ class ClipboardTests
         VERIFY_IS_NOT_NULL(ptr);
     }
 
+    static size_t _CountOccurrences(const std::string_view haystack, const std::string_view needle)
+    {
+        size_t count = 0;
+        for (auto pos = haystack.find(needle); pos != std::string_view::npos; pos = haystack.find(needle, pos + needle.size()))
+        {
+            ++count;
+        }
+        return count;
+    }
+
+    static size_t _HtmlHeaderOffset(const std::string& html, const std::string_view name)
+    {
+        const auto pos = html.find(name);
+        VERIFY_ARE_NOT_EQUAL(std::string::npos, pos);
+        return std::stoul(html.substr(pos + name.size(), 10));
+    }
+
+    TEST_METHOD(TestRetrieveFormattedText)
+    {
+        // NOTE: This test requires innate knowledge of how the common buffer text is emitted in order to test all cases
+        // Please see CommonState.hpp for information on the buffer state per row, the row contents, etc.
+        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        const auto& screenInfo = gci.GetActiveOutputBuffer();
+
+        std::vector<SMALL_RECT> selection;
+        const auto rows = SetupRetrieveFromBuffers(false, selection);
+        const auto formatted = Clipboard::Instance().RetrieveFormattedText(screenInfo, false, selection, true);
+
+        std::wstring expectedText;
+        for (const auto& row : rows)
+        {
+            expectedText += row;
+        }
+        VERIFY_ARE_EQUAL(String(expectedText.c_str()), String(formatted.text.c_str()));
+
+        // every row has 4 differently colored runs, and the last of one row doesn't match the first of the next
+        const auto& html = formatted.html;
+        VERIFY_ARE_EQUAL(16u, _CountOccurrences(html, R"(<SPAN STYLE="color:)"));
+
+        // the CF_HTML offsets have to point at what they say they do
+        VERIFY_ARE_EQUAL('\0', html.back());
+        VERIFY_ARE_EQUAL(0, html.compare(_HtmlHeaderOffset(html, "StartHTML:"), 10, "<!DOCTYPE>"));
+        VERIFY_ARE_EQUAL(html.size() - 1, _HtmlHeaderOffset(html, "EndHTML:"));
+        VERIFY_ARE_EQUAL(0, html.compare(_HtmlHeaderOffset(html, "StartFragment:"), 21, "<!--StartFragment -->"));
+        VERIFY_ARE_EQUAL(0, html.compare(_HtmlHeaderOffset(html, "EndFragment:"), 14, "</BODY></HTML>"));
+
+        // the text is UTF-8 in the HTML, and \u control words in the RTF (the first wide glyph is U+304B)
+        VERIFY_ARE_NOT_EQUAL(std::string::npos, html.find("\xe3\x81\x8b"));
+        const auto& rtf = formatted.rtf;
+        VERIFY_ARE_EQUAL(0u, rtf.find("{\\rtf1"));
+        VERIFY_ARE_NOT_EQUAL(std::string::npos, rtf.find("\\u12363 "));
+        VERIFY_IS_TRUE(rtf.substr(rtf.size() - 2) == std::string("}\0", 2));
+
+        // 4 runs with a foreground and background each that are all different is 8 colors in the table
+        const auto colorTable = rtf.substr(rtf.find("{\\colortbl"));
+        VERIFY_ARE_EQUAL(8u, _CountOccurrences(colorTable.substr(0, colorTable.find('}')), "\\red"));
+    }
+
+    TEST_METHOD(TestFormattedTextMergesRunsOfTheSameColor)
+    {
+        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        const auto& screenInfo = gci.GetActiveOutputBuffer();
+
+        // "DE" is black on dark green on every row, so it stays in the one span across rows
+        const std::vector<SMALL_RECT> selection{ { 7, 0, 8, 0 }, { 7, 2, 8, 2 } };
+        const auto formatted = Clipboard::Instance().RetrieveFormattedText(screenInfo, false, selection, true);
+
+        VERIFY_ARE_EQUAL(1u, _CountOccurrences(formatted.html, R"(<SPAN STYLE="color:)"));
+        VERIFY_ARE_EQUAL(1u, _CountOccurrences(formatted.rtf, "\\cf"));
+    }
+
+    TEST_METHOD(TestRetrieveFormattedTextWithoutFormats)
+    {
+        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        const auto& screenInfo = gci.GetActiveOutputBuffer();
+
+        std::vector<SMALL_RECT> selection;
+        SetupRetrieveFromBuffers(false, selection);
+        const auto formatted = Clipboard::Instance().RetrieveFormattedText(screenInfo, false, selection, false);
+
+        VERIFY_IS_FALSE(formatted.text.empty());
+        VERIFY_IS_TRUE(formatted.html.empty());
+        VERIFY_IS_TRUE(formatted.rtf.empty());
+    }
+
+    TEST_METHOD(FilterPastedTextKeepsPlainTextAndDropsLinefeedsAfterCarriageReturns)
+    {
+        // long enough that the first part is checked eight characters at a time
+        const std::wstring plain{ L"Get-ChildItem -Recurse | Select-Object -First 10 " };
+        const std::wstring text = plain + L"\r\nline two\r\n\x00e9\r\r\n";
+
+        const auto filtered = Clipboard::Instance().FilterPastedText(text);
+        VERIFY_ARE_EQUAL(String((plain + L"\rline two\r\x00e9\r\r").c_str()), String(filtered.c_str()));
+    }
+
+    TEST_METHOD(FilterPastedTextStopsAtNull)
+    {
+        const std::wstring text{ L"0123456789abcdef\0after the null", 31 };
+
+        const auto filtered = Clipboard::Instance().FilterPastedText(text);
+        VERIFY_ARE_EQUAL(String(L"0123456789abcdef"), String(filtered.c_str()));
+    }
+
+    TEST_METHOD(FindFilteredCharFindsTheFirstCharacterThatIsntPrintableAscii)
+    {
+        const std::wstring text{ L"0123456789abcdefghij\tklm" };
+        VERIFY_ARE_EQUAL(20u, Clipboard::s_FindFilteredChar(text.data(), text.size()));
+        VERIFY_ARE_EQUAL(16u, Clipboard::s_FindFilteredChar(text.data(), 16));
+
+        const std::wstring wide{ L"0123456789\x2014" };
+        VERIFY_ARE_EQUAL(10u, Clipboard::s_FindFilteredChar(wide.data(), wide.size()));
+
+        const std::wstring del{ L"0123456789abcdef\x7f" };
+        VERIFY_ARE_EQUAL(16u, Clipboard::s_FindFilteredChar(del.data(), del.size()));
+    }
+
     TEST_METHOD(CanConvertTextToInputEvents)
     {
         std::wstring wstr = L"hello world";
@@ -25,37 +25,29 @@ static const std::vector<std::tuple<unsigned int, std::wstring, CodepointWidth>>
     { 0x30CA, L"\x30CA", CodepointWidth::Wide }, // U+30CA katakana na
     { 0x72D7, L"\x72D7", CodepointWidth::Wide }, // U+72D7
     { 0x1F47E, L"\xD83D\xDC7E", CodepointWidth::Wide }, // U+1F47E alien monster
-    { 0x1F51C, L"\xD83D\xDD1C", CodepointWidth::Wide } // U+1F51C SOON
+    { 0x1F51C, L"\xD83D\xDD1C", CodepointWidth::Wide }, // U+1F51C SOON
+    { 0xE0000, L"\xDB40\xDC00", CodepointWidth::Invalid } // U+E0000 unassigned
 };
 
 class CodepointWidthDetectorTests
 {
     TEST_CLASS(CodepointWidthDetectorTests);
 
-    TEST_METHOD(CodepointWidthDetectDefersMapPopulation)
-    {
-        CodepointWidthDetector widthDetector;
-        VERIFY_IS_TRUE(widthDetector._map.empty());
-        widthDetector.IsWide(UNICODE_SPACE);
-        VERIFY_IS_TRUE(widthDetector._map.empty());
-        // now force checking
-        widthDetector.GetWidth(emoji);
-        VERIFY_IS_FALSE(widthDetector._map.empty());
-    }
-
     TEST_METHOD(CanLookUpEmoji)
     {
         CodepointWidthDetector widthDetector;
         VERIFY_IS_TRUE(widthDetector.IsWide(emoji));
     }
 
-    TEST_METHOD(TestUnicodeRangeCompare)
+    TEST_METHOD(CanMeasureNarrowRuns)
     {
-        CodepointWidthDetector::UnicodeRangeCompare compare;
-        // test comparing 2 search terms
-        CodepointWidthDetector::UnicodeRange a{ 0x10 };
-        CodepointWidthDetector::UnicodeRange b{ 0x15 };
-        VERIFY_IS_TRUE(static_cast<bool>(compare(a, b)));
+        CodepointWidthDetector widthDetector;
+        VERIFY_ARE_EQUAL(0u, widthDetector.GetNarrowRunLength(L""));
+        VERIFY_ARE_EQUAL(5u, widthDetector.GetNarrowRunLength(L"hello"));
+        VERIFY_ARE_EQUAL(20u, widthDetector.GetNarrowRunLength(L"a longer line\t\r\n\xA0\x1b[m"));
+        VERIFY_ARE_EQUAL(11u, widthDetector.GetNarrowRunLength(L"abcdefghijk\x414lmnop"));
+        VERIFY_ARE_EQUAL(3u, widthDetector.GetNarrowRunLength(L"abc\x306A"));
+        VERIFY_ARE_EQUAL(0u, widthDetector.GetNarrowRunLength(emoji));
     }
 
     TEST_METHOD(CanExtractCodepoint)
@@ -111,7 +103,7 @@ class CodepointWidthDetectorTests
 
         // Cached item should match what we expect
         const auto it = widthDetector._fallbackCache.begin();
-        VERIFY_ARE_EQUAL(ambiguous, it->first);
+        VERIFY_ARE_EQUAL(widthDetector._extractCodepoint(ambiguous), it->first);
         VERIFY_ARE_EQUAL(FallbackMethod(ambiguous), it->second);
 
         // Cache should empty when font changes.
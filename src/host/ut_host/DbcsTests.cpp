@@ -11,6 +11,7 @@
 #include "../buffer/out/textBuffer.hpp"
 
 #include "dbcs.h"
+#include "codepageTable.hpp"
 
 #include "input.h"
 
@@ -87,4 +88,39 @@ class DbcsTests
             }
         }
     }
+
+    TEST_METHOD(TestCodepageTable)
+    {
+        CodepageTable table;
+        table.Reset(CP_JAPANESE);
+        VERIFY_ARE_EQUAL(static_cast<UINT>(CP_JAPANESE), table.GetCodepage());
+
+        Log::Comment(L"Lead bytes should be found just like IsDBCSLeadByteConsole finds them.");
+        CPINFO info;
+        VERIFY_WIN32_BOOL_SUCCEEDED(GetCPInfo(CP_JAPANESE, &info));
+        for (int b = 0; b < 256; ++b)
+        {
+            const auto ch = static_cast<CHAR>(b);
+            VERIFY_ARE_EQUAL(IsDBCSLeadByteConsole(ch, &info), table.IsLeadByte(ch));
+        }
+
+        Log::Comment(L"Single and double bytes should translate to UTF-16.");
+        VERIFY_ARE_EQUAL(L'A', table.ToWide('A'));
+        VERIFY_ARE_EQUAL(L'\x3042', table.ToWide('\x82', '\xa0'));
+
+        Log::Comment(L"And UTF-16 back to as many bytes as it takes.");
+        const auto& narrow = table.ToBytes(L'A');
+        VERIFY_ARE_EQUAL(1, narrow.length);
+        VERIFY_ARE_EQUAL('A', narrow.bytes[0]);
+
+        const auto& wide = table.ToBytes(L'\x3042');
+        VERIFY_ARE_EQUAL(2, wide.length);
+        VERIFY_ARE_EQUAL('\x82', wide.bytes[0]);
+        VERIFY_ARE_EQUAL('\xa0', wide.bytes[1]);
+
+        Log::Comment(L"Switching codepages should forget what was looked up for the last one.");
+        table.Reset(CP_USA);
+        VERIFY_IS_FALSE(table.IsLeadByte('\x82'));
+        VERIFY_ARE_EQUAL(1, table.ToBytes(L'A').length);
+    }
 };
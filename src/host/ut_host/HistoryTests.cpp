@@ -242,6 +242,33 @@ class HistoryTests
         VERIFY_ARE_EQUAL(2ul, history->GetNumberOfCommands());
     }
 
+    TEST_METHOD(AddNoDuplicatesIgnoresCaseAndForgetsDroppedCommands)
+    {
+        auto history = CommandHistory::s_Allocate(_manyApps[0], _MakeHandle(0));
+        VERIFY_IS_NOT_NULL(history);
+
+        // A duplicate that only differs in case is merged with the earlier one.
+        VERIFY_SUCCEEDED(history->Add(L"dir", true));
+        VERIFY_SUCCEEDED(history->Add(L"cd", true));
+        VERIFY_SUCCEEDED(history->Add(L"DIR", true));
+        VERIFY_ARE_EQUAL(2ul, history->GetNumberOfCommands());
+
+        // Push everything out of the history so that "dir" is no longer in it.
+        for (size_t i = 0; i < s_BufferSize; ++i)
+        {
+            VERIFY_SUCCEEDED(history->Add(std::to_wstring(i), true));
+        }
+        VERIFY_ARE_EQUAL(s_BufferSize, history->GetNumberOfCommands());
+
+        SHORT index;
+        VERIFY_IS_FALSE(history->FindMatchingCommand(L"dir", history->LastDisplayed, index, CommandHistory::MatchOptions::ExactMatch));
+
+        // Adding it again doesn't remove anything else in its place.
+        VERIFY_SUCCEEDED(history->Add(L"dir", true));
+        VERIFY_ARE_EQUAL(s_BufferSize, history->GetNumberOfCommands());
+        VERIFY_IS_TRUE(history->GetLastCommand() == L"dir");
+    }
+
 private:
     const std::array<std::wstring, 5> _manyApps = {
         L"foo.exe",
@@ -6,6 +6,8 @@
 #include "..\..\inc\consoletaeftemplates.hpp"
 #include "CommonState.hpp"
 
+#include "stream.h"
+
 #include "..\interactivity\inc\ServiceLocator.hpp"
 #include "..\types\inc\IInputEvent.hpp"
 
@@ -78,7 +80,7 @@ class InputBufferTests
             INPUT_RECORD record;
             record.EventType = MENU_EVENT;
             VERIFY_IS_GREATER_THAN(inputBuffer.Write(IInputEvent::Create(record)), 0u);
-            VERIFY_ARE_EQUAL(record, inputBuffer._storage.back()->ToInputRecord());
+            VERIFY_ARE_EQUAL(record, inputBuffer._storage.back());
         }
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), RECORD_INSERT_COUNT);
     }
@@ -98,7 +100,7 @@ class InputBufferTests
         // verify that the events are the same in storage
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
-            VERIFY_ARE_EQUAL(inputBuffer._storage[i]->ToInputRecord(), record);
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i], record);
         }
     }
 
@@ -121,10 +123,9 @@ class InputBufferTests
         // check that they coalesced
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), 1u);
         // check that the mouse position is being updated correctly
-        const IInputEvent* const pOutEvent = inputBuffer._storage.front().get();
-        const MouseEvent* const pMouseEvent = static_cast<const MouseEvent* const>(pOutEvent);
-        VERIFY_ARE_EQUAL(pMouseEvent->GetPosition().X, static_cast<SHORT>(RECORD_INSERT_COUNT));
-        VERIFY_ARE_EQUAL(pMouseEvent->GetPosition().Y, static_cast<SHORT>(RECORD_INSERT_COUNT * 2));
+        const COORD position = inputBuffer._storage.front().Event.MouseEvent.dwMousePosition;
+        VERIFY_ARE_EQUAL(position.X, static_cast<SHORT>(RECORD_INSERT_COUNT));
+        VERIFY_ARE_EQUAL(position.Y, static_cast<SHORT>(RECORD_INSERT_COUNT * 2));
 
         // add a key event and another mouse event to make sure that
         // an event between two mouse events stopped the coalescing.
@@ -162,10 +163,10 @@ class InputBufferTests
         // no events should have been coalesced
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), RECORD_INSERT_COUNT + 1);
         // check that the events stored match those inserted
-        VERIFY_ARE_EQUAL(inputBuffer._storage.front()->ToInputRecord(), mouseRecords[0]);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front(), mouseRecords[0]);
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
-            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1]->ToInputRecord(), mouseRecords[i]);
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1], mouseRecords[i]);
         }
     }
 
@@ -221,10 +222,10 @@ class InputBufferTests
         // no events should have been coalesced
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), RECORD_INSERT_COUNT + 1);
         // check that the events stored match those inserted
-        VERIFY_ARE_EQUAL(inputBuffer._storage.front()->ToInputRecord(), keyRecords[0]);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front(), keyRecords[0]);
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
-            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1]->ToInputRecord(), keyRecords[i]);
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1], keyRecords[i]);
         }
     }
 
@@ -239,7 +240,7 @@ class InputBufferTests
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
             VERIFY_IS_GREATER_THAN(inputBuffer.Write(IInputEvent::Create(record)), 0u);
-            VERIFY_ARE_EQUAL(inputBuffer._storage.back()->ToInputRecord(), record);
+            VERIFY_ARE_EQUAL(inputBuffer._storage.back(), record);
         }
 
         // The events shouldn't be coalesced
@@ -625,7 +626,7 @@ class InputBufferTests
                                                  true));
         VERIFY_ARE_EQUAL(outEvents.size(), 1u);
         VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 1u);
-        VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*inputBuffer._storage.front()).GetRepeatCount(), repeatCount - 1);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front().Event.KeyEvent.wRepeatCount, repeatCount - 1);
         VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*outEvents.front()).GetRepeatCount(), 1u);
     }
 
@@ -645,7 +646,96 @@ class InputBufferTests
                                                  true));
         VERIFY_ARE_EQUAL(outEvents.size(), 1u);
         VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 1u);
-        VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*inputBuffer._storage.front()).GetRepeatCount(), repeatCount);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front().Event.KeyEvent.wRepeatCount, repeatCount);
         VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*outEvents.front()).GetRepeatCount(), 1u);
     }
+
+    TEST_METHOD(StreamReadingManyDeCoalesces)
+    {
+        InputBuffer inputBuffer;
+        const WORD repeatCount = 5;
+        std::vector<INPUT_RECORD> outRecords;
+
+        VERIFY_ARE_EQUAL(inputBuffer.Write(IInputEvent::Create(MakeKeyEvent(true, repeatCount, L'a', 0, L'a', 0))), 1u);
+        VERIFY_ARE_EQUAL(inputBuffer.Write(IInputEvent::Create(MakeKeyEvent(true, 1, L'b', 0, L'b', 0))), 1u);
+
+        // one short of the coalesced event, so that part of it is left behind
+        VERIFY_SUCCESS_NTSTATUS(inputBuffer.Read(outRecords,
+                                                 repeatCount - 1,
+                                                 false,
+                                                 false,
+                                                 true,
+                                                 true));
+        VERIFY_ARE_EQUAL(outRecords.size(), static_cast<size_t>(repeatCount - 1));
+        for (const auto& record : outRecords)
+        {
+            VERIFY_ARE_EQUAL(record.Event.KeyEvent.uChar.UnicodeChar, L'a');
+            VERIFY_ARE_EQUAL(record.Event.KeyEvent.wRepeatCount, 1u);
+        }
+        VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 2u);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front().Event.KeyEvent.wRepeatCount, 1u);
+
+        outRecords.clear();
+        VERIFY_SUCCESS_NTSTATUS(inputBuffer.Read(outRecords,
+                                                 10,
+                                                 false,
+                                                 false,
+                                                 true,
+                                                 true));
+        VERIFY_ARE_EQUAL(outRecords.size(), 2u);
+        VERIFY_ARE_EQUAL(outRecords.at(0).Event.KeyEvent.uChar.UnicodeChar, L'a');
+        VERIFY_ARE_EQUAL(outRecords.at(1).Event.KeyEvent.uChar.UnicodeChar, L'b');
+        VERIFY_IS_TRUE(inputBuffer._storage.empty());
+    }
+
+    TEST_METHOD(GetCharsTakesEveryAvailableChar)
+    {
+        InputBuffer inputBuffer;
+        inputBuffer.Write(IInputEvent::Create(MakeKeyEvent(true, 3, L'a', 0, L'a', 0)));
+        // key ups don't produce anything for a stream read
+        inputBuffer.Write(IInputEvent::Create(MakeKeyEvent(false, 1, L'a', 0, L'a', 0)));
+        inputBuffer.Write(IInputEvent::Create(MakeKeyEvent(true, 1, L'b', 0, L'b', 0)));
+        inputBuffer.Write(IInputEvent::Create(MakeKeyEvent(true, 1, L'c', 0, L'c', 0)));
+
+        // too small for all of it, the rest is left for the next read
+        wchar_t chars[4]{};
+        VERIFY_ARE_EQUAL(GetChars(inputBuffer, { chars, 4 }), 4u);
+        VERIFY_ARE_EQUAL(std::wstring(L"aaab"), std::wstring(chars, 4));
+        VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), 1u);
+
+        VERIFY_ARE_EQUAL(GetChars(inputBuffer, { chars, 4 }), 1u);
+        VERIFY_ARE_EQUAL(chars[0], L'c');
+
+        VERIFY_ARE_EQUAL(GetChars(inputBuffer, { chars, 4 }), 0u);
+    }
+
+    TEST_METHOD(WriteTextStoresAKeyDownPerCharacter)
+    {
+        InputBuffer inputBuffer;
+        const std::wstring_view text{ L"ab\r\x00e9" };
+
+        // more than the ring starts out with, so that it has to reserve room for all of it
+        std::wstring longText;
+        for (size_t i = 0; i < 100; ++i)
+        {
+            longText.append(text);
+        }
+
+        VERIFY_ARE_EQUAL(longText.size(), inputBuffer.WriteText(longText));
+        VERIFY_ARE_EQUAL(longText.size(), inputBuffer._storage.size());
+        VERIFY_ARE_EQUAL(longText.size(), inputBuffer.GetNumberOfReadyEvents());
+
+        for (size_t i = 0; i < longText.size(); ++i)
+        {
+            const auto& record = inputBuffer._storage[i];
+            VERIFY_ARE_EQUAL(KEY_EVENT, record.EventType);
+            VERIFY_IS_TRUE(!!record.Event.KeyEvent.bKeyDown);
+            VERIFY_ARE_EQUAL(1u, record.Event.KeyEvent.wRepeatCount);
+            VERIFY_ARE_EQUAL(0u, record.Event.KeyEvent.wVirtualKeyCode);
+            VERIFY_ARE_EQUAL(0u, record.Event.KeyEvent.dwControlKeyState);
+            VERIFY_ARE_EQUAL(longText[i], record.Event.KeyEvent.uChar.UnicodeChar);
+        }
+
+        VERIFY_ARE_EQUAL(0u, inputBuffer.WriteText({}));
+    }
 };
@@ -517,4 +517,39 @@ class OutputCellIteratorTests
         VERIFY_ARE_EQUAL(cellsExpected, it.GetCellDistance(original));
         VERIFY_ARE_EQUAL(inputExpected, it.GetInputDistance(original));
     }
+
+    TEST_METHOD(NarrowFillPeekAndAdvance)
+    {
+        const wchar_t wch = L'Q';
+        const TextAttribute attr{ FOREGROUND_RED };
+
+        Log::Comment(L"A limited fill counts up to what's left of it.");
+        OutputCellIterator it(wch, attr, 5);
+        const auto original = it;
+        VERIFY_ARE_EQUAL(3u, it.PeekNarrowFill(3));
+        VERIFY_ARE_EQUAL(5u, it.PeekNarrowFill(10));
+
+        it.AdvanceNarrowFill(3);
+        VERIFY_IS_TRUE(it);
+        VERIFY_ARE_EQUAL(2u, it.PeekNarrowFill(10));
+        VERIFY_ARE_EQUAL(3, it.GetCellDistance(original));
+
+        it.AdvanceNarrowFill(2);
+        VERIFY_IS_FALSE(it);
+        VERIFY_ARE_EQUAL(0u, it.PeekNarrowFill(10));
+
+        Log::Comment(L"An unlimited fill of only a color counts up to the limit it's given.");
+        OutputCellIterator attrIt(attr);
+        VERIFY_ARE_EQUAL(80u, attrIt.PeekNarrowFill(80));
+        attrIt.AdvanceNarrowFill(80);
+        VERIFY_IS_TRUE(attrIt);
+
+        Log::Comment(L"Wide fills and text aren't counted.");
+        const wchar_t wide = L'\x30a2';
+        OutputCellIterator wideIt(wide, 5);
+        VERIFY_ARE_EQUAL(0u, wideIt.PeekNarrowFill(10));
+
+        OutputCellIterator textIt(std::wstring_view{ L"QQQQ" });
+        VERIFY_ARE_EQUAL(0u, textIt.PeekNarrowFill(10));
+    }
 };
@@ -87,6 +87,8 @@ class ScreenBufferTests
 
     TEST_METHOD(MultipleAlternateBuffersFromMainCreationTest);
 
+    TEST_METHOD(AlternateBufferReuseTest);
+
     TEST_METHOD(TestReverseLineFeed);
 
     TEST_METHOD(TestAddTabStop);
@@ -166,6 +168,7 @@ class ScreenBufferTests
     TEST_METHOD(InsertLinesInMargins);
     TEST_METHOD(DeleteLinesInMargins);
     TEST_METHOD(ReverseLineFeedInMargins);
+    TEST_METHOD(ScrollUpFartherThanViewportHeight);
 
     TEST_METHOD(SetOriginMode);
 };
@@ -294,6 +297,44 @@ void ScreenBufferTests::MultipleAlternateBuffersFromMainCreationTest()
     }
 }
 
+void ScreenBufferTests::AlternateBufferReuseTest()
+{
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    gci.LockConsole(); // Lock must be taken to manipulate buffer.
+    auto unlock = wil::scope_exit([&] { gci.UnlockConsole(); });
+
+    Log::Comment(L"Testing that the alternate buffer is used again, as new, the next time it's needed.");
+    SCREEN_INFORMATION* const psiOriginal = &gci.GetActiveOutputBuffer();
+
+    VERIFY_SUCCEEDED(psiOriginal->UseAlternateScreenBuffer());
+    SCREEN_INFORMATION* const psiFirstAlternate = &gci.GetActiveOutputBuffer();
+    VERIFY_ARE_NOT_EQUAL(psiOriginal, psiFirstAlternate);
+
+    Log::Comment(L"Dirty up the alternate buffer before leaving it.");
+    auto& stateMachine = psiFirstAlternate->GetStateMachine();
+    stateMachine.ProcessString(L"\x1b[2;5r\x1b[3;3HX");
+    VERIFY_IS_TRUE(psiFirstAlternate->AreMarginsSet());
+
+    psiFirstAlternate->UseMainScreenBuffer();
+    VERIFY_ARE_EQUAL(psiOriginal, &gci.GetActiveOutputBuffer());
+    VERIFY_IS_NULL(psiOriginal->_psiAlternateBuffer);
+    VERIFY_ARE_EQUAL(psiFirstAlternate, psiOriginal->_psiSpareAlternateBuffer);
+
+    VERIFY_SUCCEEDED(psiOriginal->UseAlternateScreenBuffer());
+    SCREEN_INFORMATION* const psiSecondAlternate = &gci.GetActiveOutputBuffer();
+    VERIFY_ARE_EQUAL(psiFirstAlternate, psiSecondAlternate);
+    VERIFY_ARE_EQUAL(psiSecondAlternate, psiOriginal->_psiAlternateBuffer);
+    VERIFY_IS_NULL(psiOriginal->_psiSpareAlternateBuffer);
+
+    Log::Comment(L"It should look just like a new one.");
+    VERIFY_IS_FALSE(psiSecondAlternate->AreMarginsSet());
+    VERIFY_ARE_EQUAL(COORD({ 0, 0 }), psiSecondAlternate->GetTextBuffer().GetCursor().GetPosition());
+    VERIFY_ARE_EQUAL(L"\x20", psiSecondAlternate->GetTextBuffer().GetCellDataAt({ 2, 2 })->Chars());
+
+    psiSecondAlternate->UseMainScreenBuffer();
+    VERIFY_ARE_EQUAL(psiOriginal, &gci.GetActiveOutputBuffer());
+}
+
 void ScreenBufferTests::TestReverseLineFeed()
 {
     CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
@@ -3449,6 +3490,43 @@ void ScreenBufferTests::ReverseLineFeedInMargins()
     }
 }
 
+void ScreenBufferTests::ScrollUpFartherThanViewportHeight()
+{
+    // Scroll Up moves the contents of the viewport up into the scrollback. When it
+    //      moves them farther than the viewport is tall, the rows in between where
+    //      they were and where they end up must be left alone.
+    auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    auto& si = gci.GetActiveOutputBuffer();
+    auto& tbi = si.GetTextBuffer();
+    auto& stateMachine = si.GetStateMachine();
+
+    const auto height = si.GetViewport().Height();
+    VERIFY_SUCCEEDED(si.SetViewportOrigin(true, { 0, gsl::narrow<SHORT>(height + 5) }, true));
+    const auto view = si.GetViewport();
+    const SHORT top = view.Top();
+    const SHORT firstBetween = top - 3;
+
+    // Mark the top of the viewport, and the three rows between it and where it'll be scrolled to.
+    tbi.Write(OutputCellIterator(L"T"), { 0, top });
+    for (SHORT y = firstBetween; y < top; y++)
+    {
+        tbi.Write(OutputCellIterator(L"G"), { 0, y });
+    }
+
+    stateMachine.ProcessString(L"\x1b[" + std::to_wstring(height + 3) + L"S");
+
+    Log::Comment(NoThrowString().Format(
+        L"viewport=%s", VerifyOutputTraits<SMALL_RECT>::ToString(si.GetViewport().ToInclusive()).GetBuffer()));
+
+    VERIFY_ARE_EQUAL(view.ToInclusive(), si.GetViewport().ToInclusive());
+    VERIFY_ARE_EQUAL(L"T", tbi.GetCellDataAt({ 0, 2 })->Chars());
+    for (SHORT y = firstBetween; y < top; y++)
+    {
+        VERIFY_ARE_EQUAL(L"G", tbi.GetCellDataAt({ 0, y })->Chars());
+    }
+    VERIFY_ARE_EQUAL(L"\x20", tbi.GetCellDataAt({ 0, top })->Chars());
+}
+
 void ScreenBufferTests::SetOriginMode()
 {
     auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
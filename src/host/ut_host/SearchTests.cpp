@@ -164,4 +164,33 @@ class SearchTests
         Search s(outputBuffer, L"\x304b", Search::Direction::Backward, Search::Sensitivity::CaseInsensitive);
         DoFoundChecks(s, coordStartExpected, -1);
     }
+
+    TEST_METHOD(ForwardRegularExpression)
+    {
+        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        const auto& outputBuffer = gci.GetActiveOutputBuffer();
+
+        COORD coordStartExpected = { 0 };
+        Search s(outputBuffer, L"a[b-e]", Search::Direction::Forward, Search::Sensitivity::CaseInsensitive, Search::Syntax::RegularExpression);
+        DoFoundChecks(s, coordStartExpected, 1);
+    }
+
+    TEST_METHOD(BackwardRegularExpression)
+    {
+        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        const auto& outputBuffer = gci.GetActiveOutputBuffer();
+
+        COORD coordStartExpected = { 0, 3 };
+        Search s(outputBuffer, L"A[B-E]", Search::Direction::Backward, Search::Sensitivity::CaseSensitive, Search::Syntax::RegularExpression);
+        DoFoundChecks(s, coordStartExpected, -1);
+    }
+
+    TEST_METHOD(InvalidRegularExpressionThrows)
+    {
+        const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        const auto& outputBuffer = gci.GetActiveOutputBuffer();
+
+        VERIFY_THROWS(Search(outputBuffer, L"A[", Search::Direction::Forward, Search::Sensitivity::CaseSensitive, Search::Syntax::RegularExpression),
+                      std::regex_error);
+    }
 };
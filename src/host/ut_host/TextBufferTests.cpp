@@ -10,6 +10,7 @@
 #include "globals.h"
 #include "../buffer/out/textBuffer.hpp"
 #include "../buffer/out/CharRow.hpp"
+#include "../buffer/out/TextBufferSession.hpp"
 
 #include "input.h"
 #include "_stream.h"
@@ -138,6 +139,46 @@ class TextBufferTests
 
     TEST_METHOD(ResizeTraditionalRotationPreservesHighUnicode);
     TEST_METHOD(ScrollBufferRotationPreservesHighUnicode);
+    TEST_METHOD(ScrollBufferAcrossCircularWrap);
+    TEST_METHOD(SwapRowsAcrossCircularWrap);
+
+    TEST_METHOD(ColdRowsCompactAndExpandOnAccess);
+    TEST_METHOD(NewRowsStartPacked);
+    TEST_METHOD(CopiedRowHasItsOwnGlyphs);
+
+    TEST_METHOD(WriteCellsMixesAsciiRunsAndWideGlyphs);
+
+    TEST_METHOD(ReflowRewrapsLinesAndKeepsAttributes);
+
+    TEST_METHOD(GetChangedRowsReportsScatteredRows);
+    TEST_METHOD(GetChangedRowsReportsForcedWraps);
+
+    TEST_METHOD(ForEachSelectedTextRunVisitsAttributeRuns);
+
+    TEST_METHOD(MeasureRightFollowsWritesAfterMeasuring);
+
+    TEST_METHOD(WordRunsFollowWritesAfterFinding);
+    TEST_METHOD(WordRunsSpanManyCells);
+
+    TEST_METHOD(GlyphsMatchRowText);
+
+    TEST_METHOD(ScrollbackArchiveKeepsCircledRows);
+
+    TEST_METHOD(RowStorageIsReusedWhileCircling);
+
+    TEST_METHOD(TrimToMemoryBudgetPacksThenClearsOldestRows);
+
+    TEST_METHOD(CompactColdRowsPacksWithoutClearing);
+
+    TEST_METHOD(MarksMoveWithReflowAndCircling);
+
+    TEST_METHOD(SessionRoundTripsThroughFile);
+
+    TEST_METHOD(SnapshotSharesUnchangedRows);
+
+    TEST_METHOD(InsertRunWrapsAndPadsWideGlyphs);
+
+    TEST_METHOD(FillRectResetsWholeRowsAndFillsPartialOnes);
 
     TEST_METHOD(ResizeTraditionalHighUnicodeRowRemoval);
     TEST_METHOD(ResizeTraditionalHighUnicodeColumnRemoval);
@@ -1780,7 +1821,7 @@ void TextBufferTests::ResizeTraditionalRotationPreservesHighUnicode()
 
     // Get a position inside the buffer
     const COORD pos{ 2, 1 };
-    auto position = _buffer->_storage[pos.Y].GetCharRow().GlyphAt(pos.X);
+    auto position = _buffer->GetRowByOffset(pos.Y).GetCharRow().GlyphAt(pos.X);
 
     // Fill it up with a sequence that will have to hit the high unicode storage.
     // This is the negative squared latin capital letter B emoji: 🅱
@@ -1822,7 +1863,7 @@ void TextBufferTests::ScrollBufferRotationPreservesHighUnicode()
 
     // Get a position inside the buffer
     const COORD pos{ 2, 1 };
-    auto position = _buffer->_storage[pos.Y].GetCharRow().GlyphAt(pos.X);
+    auto position = _buffer->GetRowByOffset(pos.Y).GetCharRow().GlyphAt(pos.X);
 
     // Fill it up with a sequence that will have to hit the high unicode storage.
     // This is the fire emoji: 🔥
@@ -1850,6 +1891,1010 @@ void TextBufferTests::ScrollBufferRotationPreservesHighUnicode()
     VERIFY_ARE_EQUAL(String(fire), String(shouldBeFireText.data(), gsl::narrow<int>(shouldBeFireText.size())));
 }
 
+// This tests that scrolling a span of rows that wraps around the end of the circular
+// storage moves the rows (and their high unicode) without disturbing the rows outside the span.
+void TextBufferTests::ScrollBufferAcrossCircularWrap()
+{
+    // Set up a text buffer for us
+    const COORD bufferSize{ 80, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    // Put the first row near the end of the storage so that offsets 3+ wrap around to the front.
+    _buffer->_SetFirstRowIndex(7);
+
+    // Tag every row with a letter in the first column so we can track where they end up.
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        _buffer->GetRowByOffset(y).GetCharRow().GlyphAt(0) = std::wstring(1, static_cast<wchar_t>(L'A' + y));
+    }
+
+    // Put an emoji onto the row at offset 2 (the last row before the wrap).
+    const COORD pos{ 2, 2 };
+    const auto fire = L"\xD83D\xDD25";
+    _buffer->GetRowByOffset(pos.Y).GetCharRow().GlyphAt(pos.X) = fire;
+
+    // Move offsets 2 and 3 down by 3 rows. This straddles the wrap point in storage.
+    const SHORT delta = 3;
+    _buffer->ScrollRows(pos.Y, 2, delta);
+
+    // The first row index shouldn't have to move for a scroll.
+    VERIFY_ARE_EQUAL(7, _buffer->GetFirstRowIndex());
+
+    // Expected layout by offset after moving [C, D] down past [E, F, G].
+    const std::wstring expected = L"ABEFGCDHIJ";
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        const auto text = *_buffer->GetTextDataAt({ 0, y });
+        VERIFY_ARE_EQUAL(String(expected.substr(y, 1).c_str()), String(text.data(), gsl::narrow<int>(text.size())));
+
+        // Every row should still be keyed by its storage index.
+        const auto& row = _buffer->GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(row.GetId(), gsl::narrow<SHORT>((7 + y) % bufferSize.Y));
+    }
+
+    // The emoji should have followed its row.
+    const COORD newPos{ pos.X, pos.Y + delta };
+    const auto shouldBeEmptyText = *_buffer->GetTextDataAt(pos);
+    const auto shouldBeFireText = *_buffer->GetTextDataAt(newPos);
+
+    VERIFY_ARE_EQUAL(String(L" "), String(shouldBeEmptyText.data(), gsl::narrow<int>(shouldBeEmptyText.size())));
+    VERIFY_ARE_EQUAL(String(fire), String(shouldBeFireText.data(), gsl::narrow<int>(shouldBeFireText.size())));
+}
+
+// This tests that exchanging two blocks of rows that don't overlap moves them (and their
+// high unicode) past each other without disturbing the rows between or around them.
+void TextBufferTests::SwapRowsAcrossCircularWrap()
+{
+    const COORD bufferSize{ 80, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    // Put the first row near the end of the storage so that offsets 3+ wrap around to the front.
+    _buffer->_SetFirstRowIndex(7);
+
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        _buffer->GetRowByOffset(y).GetCharRow().GlyphAt(0) = std::wstring(1, static_cast<wchar_t>(L'A' + y));
+    }
+
+    const COORD pos{ 2, 1 };
+    const auto fire = L"\xD83D\xDD25";
+    _buffer->GetRowByOffset(pos.Y).GetCharRow().GlyphAt(pos.X) = fire;
+
+    // Exchange offsets 1 and 2 with offsets 6 and 7.
+    _buffer->SwapRows(1, 6, 2);
+
+    VERIFY_ARE_EQUAL(7, _buffer->GetFirstRowIndex());
+
+    const std::wstring expected = L"AGHDEFBCIJ";
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        const auto text = *_buffer->GetTextDataAt({ 0, y });
+        VERIFY_ARE_EQUAL(String(expected.substr(y, 1).c_str()), String(text.data(), gsl::narrow<int>(text.size())));
+
+        const auto& row = _buffer->GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(row.GetId(), gsl::narrow<SHORT>((7 + y) % bufferSize.Y));
+    }
+
+    const COORD newPos{ pos.X, 6 };
+    const auto shouldBeEmptyText = *_buffer->GetTextDataAt(pos);
+    const auto shouldBeFireText = *_buffer->GetTextDataAt(newPos);
+
+    VERIFY_ARE_EQUAL(String(L" "), String(shouldBeEmptyText.data(), gsl::narrow<int>(shouldBeEmptyText.size())));
+    VERIFY_ARE_EQUAL(String(fire), String(shouldBeFireText.data(), gsl::narrow<int>(shouldBeFireText.size())));
+}
+
+// This tests that rows far enough above the cursor get packed down as the cursor moves
+// and that they come back with all their text, DBCS and high unicode data when accessed again.
+void TextBufferTests::ColdRowsCompactAndExpandOnAccess()
+{
+    // Set up a text buffer for us that's taller than the hot area.
+    const COORD bufferSize{ 80, TextBuffer::HotRowCount + 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    // Fill the first row with some text, a double width pair, and an emoji.
+    auto& charRow = _buffer->GetRowByOffset(0).GetCharRow();
+    charRow.GlyphAt(0) = std::wstring_view{ L"a" };
+    charRow.GlyphAt(1) = std::wstring_view{ L"\x30a2" };
+    charRow.DbcsAttrAt(1).SetLeading();
+    charRow.GlyphAt(2) = std::wstring_view{ L"\x30a2" };
+    charRow.DbcsAttrAt(2).SetTrailing();
+    const auto fire = L"\xD83D\xDD25";
+    charRow.GlyphAt(3) = fire;
+    charRow.SetWrapForced(true);
+    const auto expectedText = _buffer->_storage[0].GetText();
+
+    // Walk the cursor down until the first row falls out of the hot area.
+    // The second row is looked at first, so that it's been unpacked like the first.
+    _buffer->GetRowByOffset(1);
+    _buffer->GetCursor().SetYPosition(TextBuffer::HotRowCount - 1);
+    VERIFY_IS_FALSE(_buffer->_storage[0].IsCompacted());
+    VERIFY_IS_TRUE(_buffer->NewlineCursor());
+    VERIFY_IS_TRUE(_buffer->_storage[0].IsCompacted());
+    VERIFY_IS_FALSE(_buffer->_storage[1].IsCompacted());
+
+    // Reading it through a const buffer, as the renderer and the search do, reads the packed form in place.
+    const auto& packedRow = std::as_const(*_buffer).GetRowByOffset(0);
+    VERIFY_ARE_EQUAL(String(expectedText.c_str()), String(packedRow.GetText().c_str()));
+    VERIFY_IS_TRUE(packedRow.GetCharRow().DbcsAttrAt(1).IsLeading());
+    VERIFY_IS_TRUE(packedRow.GetCharRow().DbcsAttrAt(2).IsTrailing());
+    VERIFY_ARE_EQUAL(4u, packedRow.GetCharRow().MeasureRight());
+    VERIFY_IS_TRUE(packedRow.IsCompacted());
+
+    // Getting the row to write to it should unpack it as it was.
+    const auto& row = _buffer->GetRowByOffset(0);
+    VERIFY_IS_FALSE(row.IsCompacted());
+    VERIFY_ARE_EQUAL(static_cast<size_t>(bufferSize.X), row.GetCharRow().size());
+    VERIFY_ARE_EQUAL(String(expectedText.c_str()), String(row.GetText().c_str()));
+    VERIFY_IS_TRUE(row.GetCharRow().WasWrapForced());
+    VERIFY_IS_TRUE(row.GetCharRow().DbcsAttrAt(1).IsLeading());
+    VERIFY_IS_TRUE(row.GetCharRow().DbcsAttrAt(2).IsTrailing());
+
+    const auto fireText = *_buffer->GetTextDataAt({ 3, 0 });
+    VERIFY_ARE_EQUAL(String(fire), String(fireText.data(), gsl::narrow<int>(fireText.size())));
+}
+
+void TextBufferTests::NewRowsStartPacked()
+{
+    // As tall a buffer as the properties dialog lets anyone ask for.
+    const COORD bufferSize{ 300, 9999 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    Log::Comment(L"None of the rows should have any cells until they're used.");
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        VERIFY_IS_TRUE(_buffer->_storage[y].IsCompacted());
+    }
+    VERIFY_ARE_EQUAL(0u, _buffer->GetMemoryUsage().cells);
+
+    Log::Comment(L"Writing to a row unpacks that row alone.");
+    const SHORT y = 5000;
+    _buffer->WriteLine(OutputCellIterator(std::wstring_view{ L"hello" }, attr), { 0, y }, false);
+    VERIFY_IS_FALSE(_buffer->_storage[y].IsCompacted());
+    VERIFY_IS_TRUE(_buffer->_storage[y - 1].IsCompacted());
+    VERIFY_IS_TRUE(_buffer->_storage[y + 1].IsCompacted());
+    VERIFY_ARE_EQUAL(bufferSize.X * sizeof(CharRowCell), _buffer->GetMemoryUsage().cells);
+
+    Log::Comment(L"The rows left alone still read back as blank rows of the full width, without being unpacked.");
+    const auto& row = std::as_const(*_buffer).GetRowByOffset(y + 1);
+    VERIFY_ARE_EQUAL(static_cast<size_t>(bufferSize.X), row.GetCharRow().size());
+    VERIFY_ARE_EQUAL(std::wstring(bufferSize.X, L' '), row.GetText());
+    VERIFY_IS_TRUE(row.IsCompacted());
+    VERIFY_ARE_EQUAL(0u, _buffer->GetRowByOffset(y).GetText().find(L"hello"));
+
+    Log::Comment(L"Rows added by growing the buffer start out packed too.");
+    VERIFY_SUCCEEDED(_buffer->ResizeTraditional({ bufferSize.X, bufferSize.Y + 10 }));
+    VERIFY_IS_TRUE(_buffer->_storage[bufferSize.Y + 5].IsCompacted());
+}
+
+void TextBufferTests::CopiedRowHasItsOwnGlyphs()
+{
+    const COORD bufferSize{ 10, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    const std::wstring_view fire{ L"\xD83D\xDD25" };
+    const std::wstring_view moon{ L"\xD83C\xDF15" };
+    auto& row = _buffer->GetRowByOffset(0);
+    row.GetCharRow().GlyphAt(0) = fire;
+
+    Log::Comment(L"A copy of a row keeps its glyphs under a key of its own.");
+    ROW copy{ row };
+    VERIFY_ARE_NOT_EQUAL(row.GetStorageKey(), copy.GetStorageKey());
+    VERIFY_ARE_EQUAL(String(fire.data(), 2), String(std::wstring_view{ copy.GetCharRow().GlyphAt(0) }.data(), 2));
+
+    Log::Comment(L"So changing the glyph of one of them leaves the other alone.");
+    copy.GetCharRow().GlyphAt(0) = moon;
+    VERIFY_ARE_EQUAL(String(fire.data(), 2), String(std::wstring_view{ row.GetCharRow().GlyphAt(0) }.data(), 2));
+    VERIFY_ARE_EQUAL(String(moon.data(), 2), String(std::wstring_view{ copy.GetCharRow().GlyphAt(0) }.data(), 2));
+}
+
+void TextBufferTests::WriteCellsMixesAsciiRunsAndWideGlyphs()
+{
+    const COORD bufferSize{ 10, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    // Put an emoji where the plain text is about to go so we can see it get replaced.
+    auto& row = _buffer->GetRowByOffset(0);
+    row.GetCharRow().GlyphAt(0) = std::wstring_view{ L"\xD83D\xDD25" };
+    VERIFY_IS_TRUE(row.GetCharRow().DbcsAttrAt(0).IsGlyphStored());
+
+    Log::Comment(L"Write ASCII, then a full width character, then more ASCII than fits in the row.");
+    const TextAttribute writeAttr{ FOREGROUND_RED };
+    const std::wstring_view text{ L"abc\x30a2"
+                                  L"defghij" };
+    const auto it = row.WriteCells(OutputCellIterator(text, writeAttr), 0, true);
+
+    VERIFY_IS_TRUE(it);
+    VERIFY_ARE_EQUAL(L'i', it->Chars().front());
+    VERIFY_ARE_EQUAL(8, it.GetInputDistance(OutputCellIterator(text, writeAttr)));
+    VERIFY_ARE_EQUAL(10, it.GetCellDistance(OutputCellIterator(text, writeAttr)));
+
+    const auto& charRow = row.GetCharRow();
+    VERIFY_ARE_EQUAL(String(L"abc\x30a2"
+                            L"defgh"),
+                     String(row.GetText().c_str()));
+    VERIFY_IS_FALSE(charRow.DbcsAttrAt(0).IsGlyphStored());
+    VERIFY_IS_TRUE(charRow.DbcsAttrAt(0).IsSingle());
+    VERIFY_IS_TRUE(charRow.DbcsAttrAt(3).IsLeading());
+    VERIFY_IS_TRUE(charRow.DbcsAttrAt(4).IsTrailing());
+    VERIFY_IS_TRUE(charRow.DbcsAttrAt(5).IsSingle());
+    VERIFY_IS_TRUE(charRow.WasWrapForced());
+
+    Log::Comment(L"Every cell should have taken the attribute in a single run.");
+    VERIFY_ARE_EQUAL(1u, row.GetAttrRow().GetNumberOfRuns());
+    VERIFY_ARE_EQUAL(writeAttr, row.GetAttrRow().GetAttrByColumn(9));
+}
+
+void TextBufferTests::ReflowRewrapsLinesAndKeepsAttributes()
+{
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute red{ FOREGROUND_RED };
+    TextBuffer oldBuffer({ 10, 5 }, attr, cursorSize, _renderTarget);
+
+    Log::Comment(L"Write a line that wraps once with a full width character in it, then a second short line.");
+    const std::wstring_view first{ L"abcde\x30a2"
+                                   L"hijklm" };
+    for (size_t i = 0; i < first.size(); ++i)
+    {
+        const auto glyphAttr = i < 5 ? red : attr;
+        if (first.at(i) == L'\x30a2')
+        {
+            DbcsAttribute dbcsAttr;
+            dbcsAttr.SetLeading();
+            VERIFY_IS_TRUE(oldBuffer.InsertCharacter(first.at(i), dbcsAttr, glyphAttr));
+            dbcsAttr.SetTrailing();
+            VERIFY_IS_TRUE(oldBuffer.InsertCharacter(first.at(i), dbcsAttr, glyphAttr));
+        }
+        else
+        {
+            VERIFY_IS_TRUE(oldBuffer.InsertCharacter(first.at(i), {}, glyphAttr));
+        }
+    }
+    VERIFY_IS_TRUE(oldBuffer.NewlineCursor());
+    VERIFY_IS_TRUE(oldBuffer.InsertCharacter(L'x', {}, attr));
+    VERIFY_IS_TRUE(oldBuffer.InsertCharacter(L'y', {}, attr));
+    VERIFY_IS_TRUE(oldBuffer.GetRowByOffset(0).GetCharRow().WasWrapForced());
+
+    Log::Comment(L"Reflow narrower. The full width character can't start in the final column, so it moves down.");
+    TextBuffer narrowBuffer({ 6, 5 }, attr, cursorSize, _renderTarget);
+    VERIFY_SUCCEEDED(TextBuffer::Reflow(oldBuffer, narrowBuffer));
+
+    VERIFY_ARE_EQUAL(String(L"abcde "), String(narrowBuffer.GetRowByOffset(0).GetText().c_str()));
+    VERIFY_IS_TRUE(narrowBuffer.GetRowByOffset(0).GetCharRow().WasWrapForced());
+    VERIFY_IS_TRUE(narrowBuffer.GetRowByOffset(0).GetCharRow().WasDoubleBytePadded());
+    VERIFY_ARE_EQUAL(String(L"\x30a2"
+                            L"hijk"),
+                     String(narrowBuffer.GetRowByOffset(1).GetText().c_str()));
+    VERIFY_IS_TRUE(narrowBuffer.GetRowByOffset(1).GetCharRow().DbcsAttrAt(0).IsLeading());
+    VERIFY_IS_TRUE(narrowBuffer.GetRowByOffset(1).GetCharRow().DbcsAttrAt(1).IsTrailing());
+    VERIFY_IS_TRUE(narrowBuffer.GetRowByOffset(1).GetCharRow().WasWrapForced());
+    VERIFY_ARE_EQUAL(String(L"lm    "), String(narrowBuffer.GetRowByOffset(2).GetText().c_str()));
+    VERIFY_IS_FALSE(narrowBuffer.GetRowByOffset(2).GetCharRow().WasWrapForced());
+    VERIFY_ARE_EQUAL(String(L"xy    "), String(narrowBuffer.GetRowByOffset(3).GetText().c_str()));
+
+    VERIFY_ARE_EQUAL(red, narrowBuffer.GetRowByOffset(0).GetAttrRow().GetAttrByColumn(4));
+    VERIFY_ARE_EQUAL(attr, narrowBuffer.GetRowByOffset(1).GetAttrRow().GetAttrByColumn(0));
+    VERIFY_ARE_EQUAL(COORD({ 2, 3 }), narrowBuffer.GetCursor().GetPosition());
+
+    Log::Comment(L"Reflow back out wider. The wrapped line should join back up into one row.");
+    TextBuffer wideBuffer({ 20, 5 }, attr, cursorSize, _renderTarget);
+    VERIFY_SUCCEEDED(TextBuffer::Reflow(narrowBuffer, wideBuffer));
+
+    const std::wstring expected{ L"abcde\x30a2"
+                                 L"hijklm       " };
+    VERIFY_ARE_EQUAL(String(expected.c_str()), String(wideBuffer.GetRowByOffset(0).GetText().c_str()));
+    VERIFY_IS_FALSE(wideBuffer.GetRowByOffset(0).GetCharRow().WasWrapForced());
+    VERIFY_ARE_EQUAL(red, wideBuffer.GetRowByOffset(0).GetAttrRow().GetAttrByColumn(0));
+    VERIFY_ARE_EQUAL(attr, wideBuffer.GetRowByOffset(0).GetAttrRow().GetAttrByColumn(5));
+    VERIFY_ARE_EQUAL(attr, wideBuffer.GetRowByOffset(0).GetAttrRow().GetAttrByColumn(19));
+    VERIFY_ARE_EQUAL(COORD({ 2, 1 }), wideBuffer.GetCursor().GetPosition());
+}
+
+void TextBufferTests::GetChangedRowsReportsScatteredRows()
+{
+    const COORD bufferSize{ 10, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    const auto start = _buffer->GetGeneration();
+    VERIFY_ARE_EQUAL(0u, _buffer->GetChangedRows(start).size());
+
+    Log::Comment(L"Write at the top and the bottom. The rows in between should not be reported.");
+    _buffer->WriteLine(OutputCellIterator(std::wstring_view{ L"top" }, attr), { 0, 0 }, false);
+    _buffer->WriteLine(OutputCellIterator(std::wstring_view{ L"bottom" }, attr), { 2, 9 }, false);
+
+    auto changes = _buffer->GetChangedRows(start);
+    VERIFY_ARE_EQUAL(2u, changes.size());
+    VERIFY_ARE_EQUAL(Viewport::FromDimensions({ 0, 0 }, 10, 1).ToInclusive(), changes.at(0).ToInclusive());
+    VERIFY_ARE_EQUAL(Viewport::FromDimensions({ 0, 9 }, 10, 1).ToInclusive(), changes.at(1).ToInclusive());
+
+    Log::Comment(L"Only changes after the given generation are reported.");
+    const auto afterWrites = _buffer->GetGeneration();
+    VERIFY_ARE_EQUAL(0u, _buffer->GetChangedRows(afterWrites).size());
+
+    _buffer->ScrollRows(3, 2, -1);
+    _buffer->WriteLine(OutputCellIterator(std::wstring_view{ L"x" }, attr), { 0, 4 }, false);
+
+    changes = _buffer->GetChangedRows(afterWrites);
+    VERIFY_ARE_EQUAL(1u, changes.size());
+    VERIFY_ARE_EQUAL(Viewport::FromDimensions({ 0, 2 }, 10, 3).ToInclusive(), changes.at(0).ToInclusive());
+
+    Log::Comment(L"The generation a row changed in follows it as the circular buffer rotates.");
+    const auto beforeCircling = _buffer->GetGeneration();
+    VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+
+    changes = _buffer->GetChangedRows(beforeCircling);
+    VERIFY_ARE_EQUAL(1u, changes.size());
+    VERIFY_ARE_EQUAL(Viewport::FromDimensions({ 0, 9 }, 10, 1).ToInclusive(), changes.at(0).ToInclusive());
+    VERIFY_ARE_EQUAL(afterWrites, _buffer->GetRowByOffset(8).GetGeneration());
+}
+
+void TextBufferTests::GetChangedRowsReportsForcedWraps()
+{
+    const COORD bufferSize{ 10, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    Log::Comment(L"Running the cursor off the end of a row only changes its wrap flag, but that's a change too.");
+    _buffer->GetCursor().SetPosition({ 9, 2 });
+    const auto start = _buffer->GetGeneration();
+    VERIFY_IS_TRUE(_buffer->IncrementCursor());
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(2).GetCharRow().WasWrapForced());
+
+    const auto changes = _buffer->GetChangedRows(start);
+    VERIFY_ARE_EQUAL(1u, changes.size());
+    VERIFY_ARE_EQUAL(Viewport::FromDimensions({ 0, 2 }, 10, 1).ToInclusive(), changes.at(0).ToInclusive());
+}
+
+void TextBufferTests::ForEachSelectedTextRunVisitsAttributeRuns()
+{
+    const COORD bufferSize{ 10, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute red{ FOREGROUND_RED };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    _buffer->WriteLine(OutputCellIterator(std::wstring_view{ L"abc" }, red), { 0, 0 }, false);
+    _buffer->WriteLine(OutputCellIterator(std::wstring_view{ L"de" }, attr), { 3, 0 }, false);
+    _buffer->WriteLine(OutputCellIterator(std::wstring_view{ L"fg" }, attr), { 0, 1 }, false);
+
+    class RecordingSink final : public TextBuffer::ITextRunSink
+    {
+    public:
+        void OnTextRun(const std::wstring_view text, const TextAttribute& runAttr) override
+        {
+            runs.emplace_back(text, runAttr);
+        }
+
+        void OnRowEnd(const bool lineBreak) override
+        {
+            rowEnds.push_back(lineBreak);
+        }
+
+        std::vector<std::pair<std::wstring, TextAttribute>> runs;
+        std::vector<bool> rowEnds;
+    };
+
+    const std::vector<SMALL_RECT> selection{ { 0, 0, 9, 0 }, { 0, 1, 9, 1 } };
+
+    Log::Comment(L"Each attribute run should be handed over once with the trailing spaces trimmed.");
+    RecordingSink sink;
+    _buffer->ForEachSelectedTextRun(true, true, selection, sink);
+
+    VERIFY_ARE_EQUAL(3u, sink.runs.size());
+    VERIFY_ARE_EQUAL(String(L"abc"), String(sink.runs.at(0).first.c_str()));
+    VERIFY_ARE_EQUAL(red, sink.runs.at(0).second);
+    VERIFY_ARE_EQUAL(String(L"de"), String(sink.runs.at(1).first.c_str()));
+    VERIFY_ARE_EQUAL(attr, sink.runs.at(1).second);
+    VERIFY_ARE_EQUAL(String(L"fg"), String(sink.runs.at(2).first.c_str()));
+    VERIFY_ARE_EQUAL(2u, sink.rowEnds.size());
+    VERIFY_IS_TRUE(sink.rowEnds.at(0));
+    VERIFY_IS_FALSE(sink.rowEnds.at(1));
+
+    Log::Comment(L"GetTextForClipboard should present the same runs with their colors looked up.");
+    std::function<COLORREF(TextAttribute&)> getForeground = [](TextAttribute&) { return RGB(1, 1, 1); };
+    std::function<COLORREF(TextAttribute&)> getBackground = [&](TextAttribute& cellAttr) { return cellAttr == red ? RGB(3, 3, 3) : RGB(4, 4, 4); };
+    const auto data = _buffer->GetTextForClipboard(true, true, selection, getForeground, getBackground);
+
+    VERIFY_ARE_EQUAL(2u, data.text.size());
+    VERIFY_ARE_EQUAL(String(L"abcde\r\n"), String(data.text.at(0).c_str()));
+    VERIFY_ARE_EQUAL(String(L"fg"), String(data.text.at(1).c_str()));
+    VERIFY_ARE_EQUAL(data.text.at(0).size(), data.BkAttr.at(0).size());
+    VERIFY_ARE_EQUAL(RGB(3, 3, 3), data.BkAttr.at(0).at(2));
+    VERIFY_ARE_EQUAL(RGB(4, 4, 4), data.BkAttr.at(0).at(3));
+    VERIFY_ARE_EQUAL(RGB(0, 0, 0), data.BkAttr.at(0).at(5));
+}
+
+void TextBufferTests::MeasureRightFollowsWritesAfterMeasuring()
+{
+    const COORD bufferSize{ 10, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    auto& charRow = _buffer->GetRowByOffset(0).GetCharRow();
+    VERIFY_ARE_EQUAL(0u, charRow.MeasureRight());
+    VERIFY_IS_FALSE(charRow.ContainsText());
+
+    Log::Comment(L"Every way of writing to the cells should be reflected the next time the row is measured.");
+    _buffer->WriteLine(OutputCellIterator(std::wstring_view{ L"abc" }, attr), { 0, 0 }, false);
+    VERIFY_ARE_EQUAL(3u, charRow.MeasureRight());
+    VERIFY_IS_TRUE(charRow.ContainsText());
+
+    charRow.GlyphAt(7) = std::wstring_view{ L"\xD83D\xDD25" };
+    VERIFY_ARE_EQUAL(8u, charRow.MeasureRight());
+
+    charRow.ClearGlyph(7);
+    VERIFY_ARE_EQUAL(3u, charRow.MeasureRight());
+
+    charRow.WriteNarrowChars(4, L"xyz");
+    VERIFY_ARE_EQUAL(7u, charRow.MeasureRight());
+
+    charRow.ClearCell(6);
+    VERIFY_ARE_EQUAL(6u, charRow.MeasureRight());
+
+    VERIFY_SUCCEEDED(charRow.Resize(5));
+    VERIFY_ARE_EQUAL(5u, charRow.MeasureRight());
+
+    charRow.Reset();
+    VERIFY_ARE_EQUAL(0u, charRow.MeasureRight());
+}
+
+void TextBufferTests::WordRunsFollowWritesAfterFinding()
+{
+    const COORD bufferSize{ 10, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    auto& charRow = _buffer->GetRowByOffset(0).GetCharRow();
+    _buffer->WriteLine(OutputCellIterator(std::wstring_view{ L"ab cd-ef" }, attr), { 0, 0 }, false);
+
+    auto run = charRow.GetWordRunAt(1, L" ");
+    VERIFY_ARE_EQUAL(0u, run.begin);
+    VERIFY_ARE_EQUAL(2u, run.end);
+    VERIFY_IS_FALSE(run.isDelimiter);
+
+    run = charRow.GetWordRunAt(2, L" ");
+    VERIFY_ARE_EQUAL(2u, run.begin);
+    VERIFY_ARE_EQUAL(3u, run.end);
+    VERIFY_IS_TRUE(run.isDelimiter);
+
+    run = charRow.GetWordRunAt(6, L" ");
+    VERIFY_ARE_EQUAL(3u, run.begin);
+    VERIFY_ARE_EQUAL(8u, run.end);
+
+    Log::Comment(L"Asking with other delimiters should find the runs again.");
+    run = charRow.GetWordRunAt(6, L" -");
+    VERIFY_ARE_EQUAL(6u, run.begin);
+    VERIFY_ARE_EQUAL(8u, run.end);
+
+    Log::Comment(L"Writing to the cells should be reflected the next time a run is found.");
+    charRow.WriteNarrowChars(2, L"x");
+    run = charRow.GetWordRunAt(1, L" -");
+    VERIFY_ARE_EQUAL(0u, run.begin);
+    VERIFY_ARE_EQUAL(5u, run.end);
+
+    run = charRow.GetWordRunAt(9, L" -");
+    VERIFY_ARE_EQUAL(8u, run.begin);
+    VERIFY_ARE_EQUAL(10u, run.end);
+    VERIFY_IS_TRUE(run.isDelimiter);
+}
+
+void TextBufferTests::WordRunsSpanManyCells()
+{
+    const COORD bufferSize{ 200, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    auto& charRow = _buffer->GetRowByOffset(0).GetCharRow();
+    _buffer->WriteLine(OutputCellIterator(std::wstring(130, L'a') + L"-" + std::wstring(9, L'b'), attr), { 0, 0 }, false);
+
+    Log::Comment(L"Runs longer than a word of the bitmap should be found from anywhere in them.");
+    auto run = charRow.GetWordRunAt(100, L" -");
+    VERIFY_ARE_EQUAL(0u, run.begin);
+    VERIFY_ARE_EQUAL(130u, run.end);
+    VERIFY_IS_FALSE(run.isDelimiter);
+
+    run = charRow.GetWordRunAt(135, L" -");
+    VERIFY_ARE_EQUAL(131u, run.begin);
+    VERIFY_ARE_EQUAL(140u, run.end);
+
+    run = charRow.GetWordRunAt(140, L" -");
+    VERIFY_ARE_EQUAL(140u, run.begin);
+    VERIFY_ARE_EQUAL(200u, run.end);
+    VERIFY_IS_TRUE(run.isDelimiter);
+
+    run = charRow.GetWordRunAt(199, L" -");
+    VERIFY_ARE_EQUAL(140u, run.begin);
+    VERIFY_ARE_EQUAL(200u, run.end);
+}
+
+void TextBufferTests::GlyphsMatchRowText()
+{
+    const COORD bufferSize{ 10, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    Log::Comment(L"Write ASCII, a full width character and a glyph that has to go in the UnicodeStorage.");
+    auto& row = _buffer->GetRowByOffset(0);
+    row.WriteCells(OutputCellIterator(std::wstring_view{ L"ab\x30a2" }, attr), 0, false);
+    row.GetCharRow().GlyphAt(4) = std::wstring_view{ L"\xD83D\xDD25" };
+    VERIFY_IS_TRUE(row.GetCharRow().DbcsAttrAt(4).IsGlyphStored());
+
+    std::vector<std::wstring> glyphs;
+    for (const auto glyph : row.Glyphs())
+    {
+        glyphs.emplace_back(glyph);
+    }
+
+    Log::Comment(L"The trailing half of the wide glyph is skipped, like GetText does.");
+    VERIFY_ARE_EQUAL(9u, glyphs.size());
+    VERIFY_ARE_EQUAL(String(L"\x30a2"), String(glyphs.at(2).c_str()));
+    VERIFY_ARE_EQUAL(String(L"\xD83D\xDD25"), String(glyphs.at(3).c_str()));
+
+    std::wstring joined;
+    for (const auto& glyph : glyphs)
+    {
+        joined += glyph;
+    }
+    VERIFY_ARE_EQUAL(String(row.GetText().c_str()), String(joined.c_str()));
+    VERIFY_ARE_EQUAL(row.GetText().size(), row.Glyphs().TextLength());
+}
+
+void TextBufferTests::ScrollbackArchiveKeepsCircledRows()
+{
+    wchar_t tempPath[MAX_PATH];
+    wchar_t archivePath[MAX_PATH];
+    VERIFY_ARE_NOT_EQUAL(0u, GetTempPathW(ARRAYSIZE(tempPath), tempPath));
+    VERIFY_ARE_NOT_EQUAL(0u, GetTempFileNameW(tempPath, L"sba", 0, archivePath));
+    auto deleteArchive = wil::scope_exit([&] { DeleteFileW(archivePath); });
+
+    const COORD bufferSize{ 10, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    TextAttribute rgb{ RGB(0x12, 0x34, 0x56), RGB(0xab, 0xcd, 0xef) };
+    rgb.Embolden();
+    rgb.SetMetaAttributes(COMMON_LVB_UNDERSCORE);
+
+    {
+        TextBuffer buffer(bufferSize, attr, cursorSize, _renderTarget);
+        buffer.SetScrollbackArchive(std::make_shared<ScrollbackArchive>(archivePath));
+
+        Log::Comment(L"Every row that circles off the top of the buffer should end up in the archive.");
+        for (size_t i = 0; i < 20; ++i)
+        {
+            const auto text = L"row" + std::to_wstring(i);
+            buffer.WriteLine(OutputCellIterator(std::wstring_view{ text }, i % 2 ? rgb : attr), { 0, 0 }, false);
+            VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+        }
+
+        VERIFY_ARE_EQUAL(20u, buffer.GetArchivedRowCount());
+        VERIFY_IS_GREATER_THAN(buffer.GetMemoryUsage().archiveIndex, 0u);
+        for (size_t i = 0; i < buffer.GetArchivedRowCount(); ++i)
+        {
+            const auto text = L"row" + std::to_wstring(i);
+            const auto row = buffer.ReadArchivedRow(i);
+            VERIFY_ARE_EQUAL(String(text.c_str()), String(row.text.c_str()));
+            VERIFY_ARE_EQUAL(static_cast<size_t>(bufferSize.X), row.width);
+            VERIFY_IS_FALSE(row.wrapForced);
+
+            if (i % 2)
+            {
+                Log::Comment(L"Every field of an attribute should come back as it was.");
+                VERIFY_ARE_EQUAL(2u, row.attrs.size());
+                VERIFY_ARE_EQUAL(text.size(), row.attrs[0].GetLength());
+                VERIFY_ARE_EQUAL(rgb, row.attrs[0].GetAttributes());
+                VERIFY_ARE_EQUAL(attr, row.attrs[1].GetAttributes());
+            }
+            else
+            {
+                VERIFY_ARE_EQUAL(1u, row.attrs.size());
+                VERIFY_ARE_EQUAL(attr, row.attrs[0].GetAttributes());
+            }
+        }
+    }
+
+    Log::Comment(L"A new buffer given the same archive should page the newest rows back in, in order.");
+    {
+        TextBuffer buffer(bufferSize, attr, cursorSize, _renderTarget);
+        buffer.SetScrollbackArchive(std::make_shared<ScrollbackArchive>(archivePath));
+        VERIFY_ARE_EQUAL(20u, buffer.GetArchivedRowCount());
+
+        VERIFY_ARE_EQUAL(3, buffer.PageInArchivedRows(3));
+        VERIFY_ARE_EQUAL(17u, buffer.GetArchivedRowCount());
+        VERIFY_ARE_EQUAL(String(L"row17     "), String(buffer.GetRowByOffset(0).GetText().c_str()));
+        VERIFY_ARE_EQUAL(String(L"row19     "), String(buffer.GetRowByOffset(2).GetText().c_str()));
+        VERIFY_ARE_EQUAL(rgb, buffer.GetRowByOffset(2).GetAttrRow().GetAttrByColumn(0));
+
+        Log::Comment(L"Rows that were paged in aren't archived again, unless they were written to.");
+        buffer.WriteLine(OutputCellIterator(std::wstring_view{ L"new18" }, attr), { 0, 1 }, false);
+        buffer.MarkRowsChanged(1, 1);
+        for (size_t i = 0; i < 3; ++i)
+        {
+            VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+        }
+        VERIFY_ARE_EQUAL(21u, buffer.GetArchivedRowCount());
+        VERIFY_ARE_EQUAL(String(L"new18"), String(buffer.ReadArchivedRow(20).text.c_str()));
+    }
+
+    Log::Comment(L"Anything that isn't an archive should be refused and left as it is.");
+    {
+        wil::unique_hfile file{ CreateFileW(archivePath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+        VERIFY_IS_TRUE(file.is_valid());
+        const std::string garbage(64, 'x');
+        DWORD written = 0;
+        VERIFY_WIN32_BOOL_SUCCEEDED(WriteFile(file.get(), garbage.data(), gsl::narrow<DWORD>(garbage.size()), &written, nullptr));
+    }
+    VERIFY_THROWS_SPECIFIC(ScrollbackArchive{ archivePath },
+                           wil::ResultException,
+                           [](const wil::ResultException& e) { return e.GetErrorCode() == HRESULT_FROM_WIN32(ERROR_INVALID_DATA); });
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    VERIFY_WIN32_BOOL_SUCCEEDED(GetFileAttributesExW(archivePath, GetFileExInfoStandard, &data));
+    VERIFY_ARE_EQUAL(64u, data.nFileSizeLow);
+}
+
+void TextBufferTests::RowStorageIsReusedWhileCircling()
+{
+    // Set up a text buffer for us that's taller than the hot area, so rows are packed before they circle around.
+    const COORD bufferSize{ 80, TextBuffer::HotRowCount + 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute red{ 0x4c };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    const auto& pool = _buffer->GetRowStoragePool();
+
+    const auto writeLines = [&](const size_t count) {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const std::wstring_view text = i % 2 ? L"odd line \x30a2 here" : L"even line";
+            auto& cursor = _buffer->GetCursor();
+            _buffer->WriteLine(OutputCellIterator(text, i % 2 ? red : attr), cursor.GetPosition(), false);
+            VERIFY_IS_TRUE(_buffer->NewlineCursor());
+        }
+    };
+
+    Log::Comment(L"Output that circles the buffer a few times should warm the pool up.");
+    writeLines(bufferSize.Y * 3);
+    const auto allocations = pool.GetAllocationCount();
+    const auto reuses = pool.GetReuseCount();
+
+    Log::Comment(L"From then on, rows should keep trading the same storage instead of allocating more.");
+    writeLines(bufferSize.Y * 2);
+    VERIFY_ARE_EQUAL(allocations, pool.GetAllocationCount());
+    VERIFY_IS_GREATER_THAN(pool.GetReuseCount(), reuses);
+
+    Log::Comment(L"The rows should still read back as they were written.");
+    for (SHORT y = 0; y < bufferSize.Y - 1; ++y)
+    {
+        const auto text = _buffer->GetRowByOffset(y).GetText();
+        VERIFY_IS_TRUE(text.find(L"even line") == 0 || text.find(L"odd line \x30a2") == 0);
+    }
+}
+
+void TextBufferTests::TrimToMemoryBudgetPacksThenClearsOldestRows()
+{
+    const COORD bufferSize{ 80, 20 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        const auto text = L"row" + std::to_wstring(y);
+        _buffer->WriteLine(OutputCellIterator(std::wstring_view{ text }, attr), { 0, y }, false);
+    }
+
+    const auto usage = _buffer->GetMemoryUsage();
+    VERIFY_ARE_EQUAL(usage.rows + usage.cells + usage.compactedCells + usage.attributes + usage.unicodeStorage + usage.spareStorage + usage.archiveIndex, usage.Total());
+    VERIFY_IS_GREATER_THAN(usage.cells, 0u);
+    VERIFY_ARE_EQUAL(0u, usage.compactedCells);
+
+    Log::Comment(L"A buffer that fits its budget should be left alone.");
+    VERIFY_ARE_EQUAL(0u, _buffer->TrimToMemoryBudget(usage.Total(), bufferSize.Y));
+    VERIFY_ARE_EQUAL(usage.Total(), _buffer->GetMemoryUsage().Total());
+
+    Log::Comment(L"Going just over it should pack the oldest row away and nothing else.");
+    VERIFY_ARE_EQUAL(0u, _buffer->TrimToMemoryBudget(usage.Total() - 1, bufferSize.Y));
+    VERIFY_IS_LESS_THAN(_buffer->GetMemoryUsage().Total(), usage.Total());
+    VERIFY_IS_GREATER_THAN(_buffer->GetMemoryUsage().compactedCells, 0u);
+
+    Log::Comment(L"A budget nothing fits in should clear every row above the kept ones, and only those.");
+    const SHORT firstKeptRow = 15;
+    VERIFY_ARE_EQUAL(static_cast<size_t>(firstKeptRow), _buffer->TrimToMemoryBudget(0, firstKeptRow));
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        const auto text = _buffer->GetRowByOffset(y).GetText();
+        if (y < firstKeptRow)
+        {
+            VERIFY_ARE_EQUAL(std::wstring(bufferSize.X, L' '), text);
+        }
+        else
+        {
+            VERIFY_ARE_EQUAL(0u, text.find(L"row" + std::to_wstring(y)));
+        }
+    }
+}
+
+void TextBufferTests::CompactColdRowsPacksWithoutClearing()
+{
+    const COORD bufferSize{ 80, 20 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        const auto text = L"row" + std::to_wstring(y);
+        _buffer->WriteLine(OutputCellIterator(std::wstring_view{ text }, attr), { 0, y }, false);
+    }
+
+    const SHORT firstKeptRow = 15;
+    const auto before = _buffer->GetMemoryUsage();
+    VERIFY_ARE_EQUAL(static_cast<size_t>(firstKeptRow), _buffer->CompactColdRows(firstKeptRow));
+
+    const auto after = _buffer->GetMemoryUsage();
+    VERIFY_IS_LESS_THAN(after.Total(), before.Total());
+    VERIFY_ARE_EQUAL(0u, after.spareStorage);
+
+    Log::Comment(L"Packing again finds nothing left to pack.");
+    VERIFY_ARE_EQUAL(0u, _buffer->CompactColdRows(firstKeptRow));
+
+    Log::Comment(L"Every row keeps its text.");
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        VERIFY_ARE_EQUAL(0u, _buffer->GetRowByOffset(y).GetText().find(L"row" + std::to_wstring(y)));
+    }
+}
+
+void TextBufferTests::MarksMoveWithReflowAndCircling()
+{
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    TextBuffer oldBuffer({ 10, 4 }, attr, cursorSize, _renderTarget);
+
+    const auto insert = [&](const std::wstring_view text) {
+        for (const auto wch : text)
+        {
+            VERIFY_IS_TRUE(oldBuffer.InsertCharacter(wch, {}, attr));
+        }
+    };
+
+    oldBuffer.AddMark(MarkIndex::Kind::Prompt, oldBuffer.GetCursor().GetPosition());
+    insert(L"$ ");
+    oldBuffer.AddMark(MarkIndex::Kind::Command, oldBuffer.GetCursor().GetPosition());
+    insert(L"ls");
+    VERIFY_IS_TRUE(oldBuffer.NewlineCursor());
+    oldBuffer.AddMark(MarkIndex::Kind::Output, oldBuffer.GetCursor().GetPosition());
+    insert(L"abcdefghijkl");
+    oldBuffer.AddMark(MarkIndex::Kind::CommandEnd, oldBuffer.GetCursor().GetPosition());
+
+    VERIFY_ARE_EQUAL(COORD({ 0, 1 }), oldBuffer.FindPreviousMark({ 0, 2 }).value());
+    VERIFY_ARE_EQUAL(COORD({ 0, 0 }), oldBuffer.FindPreviousMark({ 0, 2 }, MarkIndex::Kind::Prompt).value());
+    VERIFY_ARE_EQUAL(COORD({ 2, 0 }), oldBuffer.FindNextMark({ 0, 0 }).value());
+    VERIFY_ARE_EQUAL(COORD({ 2, 2 }), oldBuffer.FindNextMark({ 0, 1 }, MarkIndex::Kind::CommandEnd).value());
+    VERIFY_IS_FALSE(oldBuffer.FindNextMark({ 0, 0 }, MarkIndex::Kind::Prompt).has_value());
+
+    Log::Comment(L"Reflowing narrower moves each mark along with the text it's on.");
+    TextBuffer newBuffer({ 5, 6 }, attr, cursorSize, _renderTarget);
+    VERIFY_SUCCEEDED(TextBuffer::Reflow(oldBuffer, newBuffer));
+
+    VERIFY_ARE_EQUAL(COORD({ 0, 0 }), newBuffer.FindPreviousMark({ 4, 5 }, MarkIndex::Kind::Prompt).value());
+    VERIFY_ARE_EQUAL(COORD({ 2, 0 }), newBuffer.FindPreviousMark({ 4, 5 }, MarkIndex::Kind::Command).value());
+    VERIFY_ARE_EQUAL(COORD({ 0, 1 }), newBuffer.FindPreviousMark({ 4, 5 }, MarkIndex::Kind::Output).value());
+    VERIFY_ARE_EQUAL(COORD({ 2, 3 }), newBuffer.FindPreviousMark({ 4, 5 }, MarkIndex::Kind::CommandEnd).value());
+
+    Log::Comment(L"Circling drops the marks of the row that circled away and leaves the others on their rows.");
+    VERIFY_IS_TRUE(newBuffer.IncrementCircularBuffer());
+    VERIFY_IS_FALSE(newBuffer.FindPreviousMark({ 4, 5 }, MarkIndex::Kind::Prompt).has_value());
+    VERIFY_ARE_EQUAL(COORD({ 0, 0 }), newBuffer.FindPreviousMark({ 4, 5 }, MarkIndex::Kind::Output).value());
+    VERIFY_ARE_EQUAL(COORD({ 2, 2 }), newBuffer.FindPreviousMark({ 4, 5 }, MarkIndex::Kind::CommandEnd).value());
+}
+
+void TextBufferTests::SessionRoundTripsThroughFile()
+{
+    wchar_t tempPath[MAX_PATH];
+    wchar_t sessionPath[MAX_PATH];
+    VERIFY_ARE_NOT_EQUAL(0u, GetTempPathW(ARRAYSIZE(tempPath), tempPath));
+    VERIFY_ARE_NOT_EQUAL(0u, GetTempFileNameW(tempPath, L"tbs", 0, sessionPath));
+    auto deleteSession = wil::scope_exit([&] { DeleteFileW(sessionPath); });
+
+    const COORD bufferSize{ 10, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute red{ 0x4c };
+    TextAttribute rgb{ RGB(0x12, 0x34, 0x56), RGB(0xab, 0xcd, 0xef) };
+    rgb.Embolden();
+
+    {
+        TextBuffer buffer(bufferSize, attr, cursorSize, _renderTarget);
+        for (SHORT y = 0; y < bufferSize.Y; ++y)
+        {
+            const auto text = L"r" + std::to_wstring(y) + L"\x30a2";
+            buffer.WriteLine(OutputCellIterator(std::wstring_view{ text }, y % 2 ? red : attr), { 0, y }, false);
+        }
+        buffer.WriteLine(OutputCellIterator(std::wstring_view{ L"z" }, rgb), { 9, 3 }, false);
+        buffer.GetRowByOffset(2).GetCharRow().SetWrapForced(true);
+
+        const auto snapshot = buffer.TakeSnapshot(buffer.GetSize());
+        TextBufferSession::Save(sessionPath, *snapshot, { { 3, 2 }, 1 });
+    }
+
+    Log::Comment(L"A buffer as wide as the saved one should get the rows back as they were.");
+    TextBuffer restored(bufferSize, TextAttribute{ 0x1f }, cursorSize, _renderTarget);
+    const auto state = TextBufferSession::Restore(sessionPath, restored);
+    VERIFY_ARE_EQUAL(COORD({ 3, 2 }), state.cursorPosition);
+    VERIFY_ARE_EQUAL(COORD({ 3, 2 }), restored.GetCursor().GetPosition());
+    VERIFY_ARE_EQUAL(1, state.viewportTop);
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        const auto text = L"r" + std::to_wstring(y) + L"\x30a2";
+        const auto& row = restored.GetRowByOffset(y);
+        VERIFY_IS_TRUE(row.GetCharRow().DbcsAttrAt(2).IsLeading());
+        VERIFY_IS_TRUE(row.GetCharRow().DbcsAttrAt(3).IsTrailing());
+        VERIFY_ARE_EQUAL(y % 2 ? red : attr, row.GetAttrRow().GetAttrByColumn(0));
+        if (y != 3)
+        {
+            VERIFY_ARE_EQUAL(String((text + std::wstring(bufferSize.X - text.size() - 1, L' ')).c_str()), String(row.GetText().c_str()));
+            VERIFY_ARE_EQUAL(attr, row.GetAttrRow().GetAttrByColumn(bufferSize.X - 1));
+        }
+        VERIFY_ARE_EQUAL(y == 2, row.GetCharRow().WasWrapForced());
+    }
+    VERIFY_ARE_EQUAL(rgb, restored.GetRowByOffset(3).GetAttrRow().GetAttrByColumn(bufferSize.X - 1));
+    VERIFY_ARE_EQUAL(String(L"r3\x30a2     z"), String(restored.GetRowByOffset(3).GetText().c_str()));
+
+    Log::Comment(L"A narrower buffer should get them reflowed to fit.");
+    TextBuffer narrow({ 5, 8 }, attr, cursorSize, _renderTarget);
+    const auto narrowState = TextBufferSession::Restore(sessionPath, narrow);
+    VERIFY_ARE_EQUAL(narrow.GetCursor().GetPosition(), narrowState.cursorPosition);
+    VERIFY_ARE_EQUAL(String(L"r0\x30a2 "), String(narrow.GetRowByOffset(0).GetText().c_str()));
+    VERIFY_ARE_EQUAL(String(L"r1\x30a2 "), String(narrow.GetRowByOffset(1).GetText().c_str()));
+    VERIFY_ARE_EQUAL(red, narrow.GetRowByOffset(1).GetAttrRow().GetAttrByColumn(0));
+
+    Log::Comment(L"Anything that isn't a saved session should be refused.");
+    {
+        wil::unique_hfile file{ CreateFileW(sessionPath, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr) };
+        VERIFY_IS_TRUE(file.is_valid());
+        const std::string garbage(64, 'x');
+        DWORD written = 0;
+        VERIFY_WIN32_BOOL_SUCCEEDED(WriteFile(file.get(), garbage.data(), gsl::narrow<DWORD>(garbage.size()), &written, nullptr));
+    }
+    VERIFY_THROWS_SPECIFIC(TextBufferSession::Restore(sessionPath, narrow),
+                           wil::ResultException,
+                           [](const wil::ResultException& e) { return e.GetErrorCode() == HRESULT_FROM_WIN32(ERROR_INVALID_DATA); });
+}
+
+void TextBufferTests::SnapshotSharesUnchangedRows()
+{
+    const COORD bufferSize{ 10, 6 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute red{ 0x4c };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        const auto text = L"r" + std::to_wstring(y) + L"\x30a2";
+        _buffer->WriteLine(OutputCellIterator(std::wstring_view{ text }, y % 2 ? red : attr), { 0, y }, false);
+    }
+
+    Log::Comment(L"A snapshot should hold the rows as they were when it was taken.");
+    const auto rows = Viewport::FromDimensions({ 0, 1 }, bufferSize.X, 4);
+    const auto first = _buffer->TakeSnapshot(rows);
+    VERIFY_ARE_EQUAL(rows.ToInclusive(), first->GetRows().ToInclusive());
+    VERIFY_ARE_EQUAL(String(_buffer->GetRowByOffset(1).GetText().c_str()), String(first->GetRow(1).GetText().c_str()));
+    VERIFY_IS_TRUE(first->GetRow(1).DbcsAttrAt(2).IsLeading());
+    VERIFY_IS_TRUE(first->GetRow(1).DbcsAttrAt(3).IsTrailing());
+    VERIFY_ARE_EQUAL(red, first->GetRow(1).GetAttrByColumn(0));
+    VERIFY_ARE_EQUAL(attr, first->GetRow(2).GetAttrByColumn(0));
+
+    _buffer->WriteLine(OutputCellIterator(std::wstring_view{ L"X" }, attr), { 0, 3 }, false);
+    VERIFY_ARE_EQUAL(String(L"r3\x30a2      "), String(first->GetRow(3).GetText().c_str()));
+
+    Log::Comment(L"The next snapshot should only copy the row that changed.");
+    const auto second = _buffer->TakeSnapshot(rows, first.get());
+    VERIFY_IS_TRUE(first->ShareRow(1) == second->ShareRow(1));
+    VERIFY_IS_TRUE(first->ShareRow(2) == second->ShareRow(2));
+    VERIFY_IS_FALSE(first->ShareRow(3) == second->ShareRow(3));
+    VERIFY_IS_TRUE(first->ShareRow(4) == second->ShareRow(4));
+    VERIFY_ARE_EQUAL(String(L"X3\x30a2      "), String(second->GetRow(3).GetText().c_str()));
+
+    Log::Comment(L"Rows that moved up as the buffer circled should still be shared.");
+    VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+    const auto third = _buffer->TakeSnapshot(rows, second.get());
+    VERIFY_IS_TRUE(second->ShareRow(2) == third->ShareRow(1));
+    VERIFY_IS_TRUE(second->ShareRow(3) == third->ShareRow(2));
+    VERIFY_IS_TRUE(second->ShareRow(4) == third->ShareRow(3));
+    VERIFY_ARE_EQUAL(String(L"r5\x30a2      "), String(third->GetRow(4).GetText().c_str()));
+}
+
+void TextBufferTests::InsertRunWrapsAndPadsWideGlyphs()
+{
+    const COORD bufferSize{ 5, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute red{ 0x4c };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    Log::Comment(L"A run longer than the row should carry on at the start of the next one.");
+    VERIFY_IS_TRUE(_buffer->InsertRun(L"abc\x3042\x3044xy", red));
+    VERIFY_ARE_EQUAL(COORD({ 4, 1 }), _buffer->GetCursor().GetPosition());
+    VERIFY_ARE_EQUAL(String(L"abc\x3042"), String(_buffer->GetRowByOffset(0).GetText().c_str()));
+    VERIFY_ARE_EQUAL(String(L"\x3044xy "), String(_buffer->GetRowByOffset(1).GetText().c_str()));
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(0).GetCharRow().WasWrapForced());
+    VERIFY_IS_FALSE(_buffer->GetRowByOffset(1).GetCharRow().WasWrapForced());
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(0).GetCharRow().DbcsAttrAt(3).IsLeading());
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(0).GetCharRow().DbcsAttrAt(4).IsTrailing());
+    for (size_t column = 0; column < static_cast<size_t>(bufferSize.X); ++column)
+    {
+        VERIFY_ARE_EQUAL(red, _buffer->GetRowByOffset(0).GetAttrRow().GetAttrByColumn(column));
+        VERIFY_ARE_EQUAL(red, _buffer->GetRowByOffset(1).GetAttrRow().GetAttrByColumn(column));
+    }
+
+    Log::Comment(L"A wide glyph that doesn't fit in the last column should pad it and move to the next row.");
+    VERIFY_IS_TRUE(_buffer->InsertRun(L"\x3046", attr));
+    VERIFY_ARE_EQUAL(COORD({ 2, 2 }), _buffer->GetCursor().GetPosition());
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(1).GetCharRow().WasDoubleBytePadded());
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(1).GetCharRow().WasWrapForced());
+    VERIFY_ARE_EQUAL(String(L"\x3046   "), String(_buffer->GetRowByOffset(2).GetText().c_str()));
+    VERIFY_ARE_EQUAL(attr, _buffer->GetRowByOffset(2).GetAttrRow().GetAttrByColumn(0));
+}
+
+void TextBufferTests::FillRectResetsWholeRowsAndFillsPartialOnes()
+{
+    const COORD bufferSize{ 6, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute red{ 0x4c };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    for (short row = 0; row < bufferSize.Y; ++row)
+    {
+        _buffer->WriteLine(OutputCellIterator(L"abcdef"), { 0, row }, true);
+    }
+
+    Log::Comment(L"Blanking rows from edge to edge should reset them, wrap flag and all.");
+    _buffer->FillRect(Viewport::FromInclusive({ 0, 1, 5, 2 }), UNICODE_SPACE, red);
+    for (short row = 1; row <= 2; ++row)
+    {
+        VERIFY_ARE_EQUAL(String(L"      "), String(_buffer->GetRowByOffset(row).GetText().c_str()));
+        VERIFY_IS_FALSE(_buffer->GetRowByOffset(row).GetCharRow().WasWrapForced());
+        VERIFY_ARE_EQUAL(1u, _buffer->GetRowByOffset(row).GetAttrRow().GetNumberOfRuns());
+        VERIFY_ARE_EQUAL(red, _buffer->GetRowByOffset(row).GetAttrRow().GetAttrByColumn(0));
+    }
+    VERIFY_ARE_EQUAL(String(L"abcdef"), String(_buffer->GetRowByOffset(0).GetText().c_str()));
+    VERIFY_ARE_EQUAL(String(L"abcdef"), String(_buffer->GetRowByOffset(3).GetText().c_str()));
+
+    Log::Comment(L"Part of a row should be filled in place, and the rest of it left alone.");
+    _buffer->FillRect(Viewport::FromInclusive({ 2, 3, 3, 3 }), L'x', red);
+    VERIFY_ARE_EQUAL(String(L"abxxef"), String(_buffer->GetRowByOffset(3).GetText().c_str()));
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(3).GetCharRow().WasWrapForced());
+    VERIFY_ARE_EQUAL(attr, _buffer->GetRowByOffset(3).GetAttrRow().GetAttrByColumn(1));
+    VERIFY_ARE_EQUAL(red, _buffer->GetRowByOffset(3).GetAttrRow().GetAttrByColumn(2));
+    VERIFY_ARE_EQUAL(red, _buffer->GetRowByOffset(3).GetAttrRow().GetAttrByColumn(3));
+    VERIFY_ARE_EQUAL(attr, _buffer->GetRowByOffset(3).GetAttrRow().GetAttrByColumn(4));
+
+    Log::Comment(L"Anything outside of the buffer should be ignored.");
+    _buffer->FillRect(Viewport::FromInclusive({ 4, -2, 9, 0 }), L'y', red);
+    VERIFY_ARE_EQUAL(String(L"abcdyy"), String(_buffer->GetRowByOffset(0).GetText().c_str()));
+}
+
 // This tests that rows removed from the buffer while resizing traditionally will also drop the high unicode
 // characters from the Unicode Storage buffer
 void TextBufferTests::ResizeTraditionalHighUnicodeRowRemoval()
@@ -1862,7 +2907,7 @@ void TextBufferTests::ResizeTraditionalHighUnicodeRowRemoval()
 
     // Get a position inside the buffer in the bottom row
     const COORD pos{ 0, bufferSize.Y - 1 };
-    auto position = _buffer->_storage[pos.Y].GetCharRow().GlyphAt(pos.X);
+    auto position = _buffer->GetRowByOffset(pos.Y).GetCharRow().GlyphAt(pos.X);
 
     // Fill it up with a sequence that will have to hit the high unicode storage.
     // This is the eggplant emoji: 🍆
@@ -1875,14 +2920,14 @@ void TextBufferTests::ResizeTraditionalHighUnicodeRowRemoval()
     const auto readBackText = *readBack;
     VERIFY_ARE_EQUAL(String(emoji), String(readBackText.data(), gsl::narrow<int>(readBackText.size())));
 
-    VERIFY_ARE_EQUAL(1u, _buffer->GetUnicodeStorage()._map.size(), L"There should be one item in the map.");
+    VERIFY_ARE_EQUAL(1u, _buffer->GetUnicodeStorage().size(), L"There should be one item in the storage.");
 
     // Perform resize to trim off the row of the buffer that included the emoji
     COORD trimmedBufferSize{ bufferSize.X, bufferSize.Y - 1 };
 
     VERIFY_NT_SUCCESS(_buffer->ResizeTraditional(trimmedBufferSize));
 
-    VERIFY_IS_TRUE(_buffer->GetUnicodeStorage()._map.empty(), L"The map should now be empty.");
+    VERIFY_IS_TRUE(_buffer->GetUnicodeStorage().empty(), L"The storage should now be empty.");
 }
 
 // This tests that columns removed from the buffer while resizing traditionally will also drop the high unicode
@@ -1897,7 +2942,7 @@ void TextBufferTests::ResizeTraditionalHighUnicodeColumnRemoval()
 
     // Get a position inside the buffer in the last column
     const COORD pos{ bufferSize.X - 1, 0 };
-    auto position = _buffer->_storage[pos.Y].GetCharRow().GlyphAt(pos.X);
+    auto position = _buffer->GetRowByOffset(pos.Y).GetCharRow().GlyphAt(pos.X);
 
     // Fill it up with a sequence that will have to hit the high unicode storage.
     // This is the peach emoji: 🍑
@@ -1910,14 +2955,14 @@ void TextBufferTests::ResizeTraditionalHighUnicodeColumnRemoval()
     const auto readBackText = *readBack;
     VERIFY_ARE_EQUAL(String(emoji), String(readBackText.data(), gsl::narrow<int>(readBackText.size())));
 
-    VERIFY_ARE_EQUAL(1u, _buffer->GetUnicodeStorage()._map.size(), L"There should be one item in the map.");
+    VERIFY_ARE_EQUAL(1u, _buffer->GetUnicodeStorage().size(), L"There should be one item in the storage.");
 
     // Perform resize to trim off the column of the buffer that included the emoji
     COORD trimmedBufferSize{ bufferSize.X - 1, bufferSize.Y };
 
     VERIFY_NT_SUCCESS(_buffer->ResizeTraditional(trimmedBufferSize));
 
-    VERIFY_IS_TRUE(_buffer->GetUnicodeStorage()._map.empty(), L"The map should now be empty.");
+    VERIFY_IS_TRUE(_buffer->GetUnicodeStorage().empty(), L"The storage should now be empty.");
 }
 
 void TextBufferTests::TestBurrito()
@@ -86,6 +86,31 @@ class Utf16ParserTests
         }
     }
 
+    TEST_METHOD(GlyphsMatchParse)
+    {
+        std::wstring wstr{ LatinChar.at(0) };
+        wstr += SunglassesEmoji.at(1);
+        wstr += SunglassesEmoji.at(0);
+        wstr += SunglassesEmoji.at(0);
+        wstr += SunglassesEmoji.at(1);
+        wstr += HiraganaChar.at(0);
+        wstr += SunglassesEmoji.at(0);
+
+        const auto expected = Utf16Parser::Parse(wstr);
+        VERIFY_ARE_EQUAL(3u, expected.size());
+
+        size_t i = 0;
+        for (const auto glyph : Utf16Parser::Glyphs(wstr))
+        {
+            VERIFY_IS_LESS_THAN(i, expected.size());
+            VERIFY_ARE_EQUAL(std::vector<wchar_t>(glyph.cbegin(), glyph.cend()), expected.at(i));
+            // The glyphs are views into the string itself.
+            VERIFY_IS_TRUE(glyph.data() >= wstr.data() && glyph.data() < wstr.data() + wstr.size());
+            ++i;
+        }
+        VERIFY_ARE_EQUAL(expected.size(), i);
+    }
+
     const std::wstring_view Replacement{ &UNICODE_REPLACEMENT, 1 };
 
     TEST_METHOD(ParseNextLeadOnly)
@@ -14,6 +14,17 @@ using namespace WEX::Logging;
 using namespace WEX::TestExecution;
 
 using Viewport = Microsoft::Console::Types::Viewport;
+using Region = Microsoft::Console::Types::Region;
+
+static int RegionArea(const Region& region)
+{
+    int area = 0;
+    for (const auto& rect : region)
+    {
+        area += rect.Width() * rect.Height();
+    }
+    return area;
+}
 
 class ViewportTests
 {
@@ -1058,4 +1069,64 @@ class ViewportTests
             VERIFY_ARE_EQUAL(exp, act);
         }
     }
+
+    TEST_METHOD(RegionUnionKeepsRectsApart)
+    {
+        Region region{ Viewport::FromInclusive({ 0, 0, 9, 9 }) };
+        region.Union(Viewport::FromInclusive({ 5, 5, 14, 14 }));
+
+        Log::Comment(L"The overlapping cells should only be counted once.");
+        VERIFY_ARE_EQUAL(175, RegionArea(region));
+        VERIFY_ARE_EQUAL(Viewport::FromInclusive({ 0, 0, 14, 14 }), region.BoundingBox());
+        VERIFY_IS_TRUE(region.IsInBounds({ 12, 12 }));
+        VERIFY_IS_FALSE(region.IsInBounds({ 12, 2 }));
+
+        Log::Comment(L"Adding something already covered shouldn't change anything.");
+        region.Union(Viewport::FromInclusive({ 6, 6, 8, 8 }));
+        VERIFY_ARE_EQUAL(175, RegionArea(region));
+    }
+
+    TEST_METHOD(RegionMergesAdjacentCells)
+    {
+        Region region;
+        for (SHORT x = 0; x < 10; x++)
+        {
+            region.Union(Viewport::FromCoord({ x, 3 }));
+        }
+
+        VERIFY_ARE_EQUAL(1u, region.size());
+        VERIFY_ARE_EQUAL(Viewport::FromInclusive({ 0, 3, 9, 3 }), *region.begin());
+    }
+
+    TEST_METHOD(RegionSubtractAndIntersect)
+    {
+        Region region{ Viewport::FromInclusive({ 0, 0, 9, 9 }) };
+        region.Subtract(Viewport::FromInclusive({ 3, 3, 6, 6 }));
+
+        VERIFY_ARE_EQUAL(84, RegionArea(region));
+        VERIFY_IS_FALSE(region.IsInBounds({ 4, 4 }));
+        VERIFY_IS_TRUE(region.IsInBounds({ 2, 4 }));
+
+        region.Intersect(Viewport::FromInclusive({ 0, 0, 4, 9 }));
+        VERIFY_ARE_EQUAL(42, RegionArea(region));
+
+        region.Subtract(Viewport::FromInclusive({ 0, 0, 9, 9 }));
+        VERIFY_IS_TRUE(region.empty());
+    }
+
+    TEST_METHOD(RegionGrowsPastInlineStorage)
+    {
+        Region region;
+        for (SHORT i = 0; i < 10; i++)
+        {
+            region.Union(Viewport::FromCoord({ gsl::narrow_cast<SHORT>(i * 2), gsl::narrow_cast<SHORT>(i * 2) }));
+        }
+        VERIFY_ARE_EQUAL(10u, region.size());
+
+        region.Intersect(Viewport::FromInclusive({ 0, 0, 4, 4 }));
+        VERIFY_ARE_EQUAL(3u, region.size());
+        VERIFY_IS_TRUE(region.IsInBounds({ 0, 0 }));
+        VERIFY_IS_TRUE(region.IsInBounds({ 2, 2 }));
+        VERIFY_IS_TRUE(region.IsInBounds({ 4, 4 }));
+    }
 };
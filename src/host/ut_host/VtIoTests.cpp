@@ -26,6 +26,7 @@ class Microsoft::Console::VirtualTerminal::VtIoTests
     // General Tests:
     TEST_METHOD(NoOpStartTest);
     TEST_METHOD(ModeParsingTest);
+    TEST_METHOD(LateCursorPositionTest);
 
     TEST_METHOD(DtorTestJustEngine);
     TEST_METHOD(DtorTestDeleteVtio);
@@ -88,6 +89,20 @@ void VtIoTests::ModeParsingTest()
     VERIFY_ARE_EQUAL(mode, VtIoMode::INVALID);
 }
 
+void VtIoTests::LateCursorPositionTest()
+{
+    VtIo vtio;
+
+    Log::Comment(L"Without a request for the cursor position, there's nothing to wait for.");
+    vtio.WaitForCursorPosition();
+    VERIFY_ARE_EQUAL(S_OK, vtio.SetCursorPosition({ 1, 1 }));
+
+    Log::Comment(L"Once we've given up on the cursor position, the answer that comes late is ignored, only once.");
+    vtio._ignoreLateCursorPosition = true;
+    VERIFY_ARE_EQUAL(S_FALSE, vtio.SetCursorPosition({ 1, 1 }));
+    VERIFY_ARE_EQUAL(S_OK, vtio.SetCursorPosition({ 1, 1 }));
+}
+
 Viewport SetUpViewport()
 {
     SMALL_RECT view = {};
@@ -408,8 +408,7 @@ void VtRendererTest::Xterm256TestColors()
     Log::Comment(NoThrowString().Format(
         L"Begin by setting some test values - FG,BG = (1,2,3), (4,5,6) to start"
         L"These values were picked for ease of formatting raw COLORREF values."));
-    qExpectedInput.push_back("\x1b[38;2;1;2;3m");
-    qExpectedInput.push_back("\x1b[48;2;5;6;7m");
+    qExpectedInput.push_back("\x1b[38;2;1;2;3;48;2;5;6;7m");
     VERIFY_SUCCEEDED(engine->UpdateDrawingBrushes(0x00030201, 0x00070605, 0, false, false));
 
     TestPaint(*engine, [&]() {
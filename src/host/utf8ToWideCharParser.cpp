@@ -5,6 +5,7 @@
 
 #include "utf8ToWideCharParser.hpp"
 #include <unicode.hpp>
+#include "../types/inc/convert.hpp"
 
 #ifndef WIL_ENABLE_EXCEPTIONS
 #error WIL exception helpers must be enabled
@@ -292,17 +293,18 @@ unsigned int Utf8ToWideCharParser::_Utf8SequenceSize(_In_ byte ch)
 // or 0 if pInputChars cannot be successfully converted.
 unsigned int Utf8ToWideCharParser::_ParseFullRange(_In_reads_(cb) const byte* const pInputChars, const unsigned int cb)
 {
-    int bufferSize = MultiByteToWideChar(_currentCodePage,
-                                         MB_ERR_INVALID_CHARS,
-                                         reinterpret_cast<LPCCH>(pInputChars),
-                                         cb,
-                                         nullptr,
-                                         0);
-    if (bufferSize == 0)
+    // UTF-8 never needs more wide chars than it has bytes, so there's no need to measure first.
+    _convertedWideChars = std::make_unique<wchar_t[]>(cb);
+    size_t written = 0;
+    const HRESULT hr = ConvertUtf8ToW({ reinterpret_cast<const char*>(pInputChars), cb },
+                                      { _convertedWideChars.get(), gsl::narrow_cast<ptrdiff_t>(cb) },
+                                      true,
+                                      written);
+    if (FAILED(hr))
     {
-        DWORD err = GetLastError();
-        LOG_WIN32(err);
-        if (err == ERROR_NO_UNICODE_TRANSLATION)
+        LOG_HR(hr);
+        _convertedWideChars.reset(nullptr);
+        if (hr == HRESULT_FROM_WIN32(ERROR_NO_UNICODE_TRANSLATION))
         {
             _currentState = _State::BeginPartialParse;
         }
@@ -310,27 +312,11 @@ unsigned int Utf8ToWideCharParser::_ParseFullRange(_In_reads_(cb) const byte* co
         {
             _currentState = _State::Error;
         }
+        return 0;
     }
-    else
-    {
-        _convertedWideChars = std::make_unique<wchar_t[]>(bufferSize);
-        bufferSize = MultiByteToWideChar(_currentCodePage,
-                                         0,
-                                         reinterpret_cast<LPCCH>(pInputChars),
-                                         cb,
-                                         _convertedWideChars.get(),
-                                         bufferSize);
-        if (bufferSize == 0)
-        {
-            LOG_LAST_ERROR();
-            _currentState = _State::Error;
-        }
-        else
-        {
-            _currentState = _State::Finished;
-        }
-    }
-    return bufferSize;
+
+    _currentState = _State::Finished;
+    return gsl::narrow_cast<unsigned int>(written);
 }
 
 // Routine Description:
@@ -377,41 +363,28 @@ unsigned int Utf8ToWideCharParser::_InvolvedParse(_In_reads_(cb) const byte* con
         _currentState = _State::AwaitingMoreBytes;
         return 0;
     }
-    int bufferSize = MultiByteToWideChar(_currentCodePage,
-                                         MB_ERR_INVALID_CHARS,
-                                         reinterpret_cast<LPCCH>(validSequence.first.get()),
-                                         validSequence.second,
-                                         nullptr,
-                                         0);
-    if (bufferSize == 0)
+    _convertedWideChars = std::make_unique<wchar_t[]>(validSequence.second);
+    size_t written = 0;
+    const HRESULT convertHr = ConvertUtf8ToW({ reinterpret_cast<const char*>(validSequence.first.get()), validSequence.second },
+                                             { _convertedWideChars.get(), gsl::narrow_cast<ptrdiff_t>(validSequence.second) },
+                                             true,
+                                             written);
+    if (FAILED(convertHr) || written == 0)
     {
-        LOG_LAST_ERROR();
+        LOG_IF_FAILED(convertHr);
+        _convertedWideChars.reset(nullptr);
         _currentState = _State::Error;
+        return 0;
+    }
+    else if (_bytesStored > 0)
+    {
+        _currentState = _State::AwaitingMoreBytes;
     }
     else
     {
-        _convertedWideChars = std::make_unique<wchar_t[]>(bufferSize);
-        bufferSize = MultiByteToWideChar(_currentCodePage,
-                                         0,
-                                         reinterpret_cast<LPCCH>(validSequence.first.get()),
-                                         validSequence.second,
-                                         _convertedWideChars.get(),
-                                         bufferSize);
-        if (bufferSize == 0)
-        {
-            LOG_LAST_ERROR();
-            _currentState = _State::Error;
-        }
-        else if (_bytesStored > 0)
-        {
-            _currentState = _State::AwaitingMoreBytes;
-        }
-        else
-        {
-            _currentState = _State::Finished;
-        }
+        _currentState = _State::Finished;
     }
-    return bufferSize;
+    return gsl::narrow_cast<unsigned int>(written);
 }
 
 // Routine Description:
@@ -15,6 +15,11 @@
 #include "..\onecore\WindowMetrics.hpp"
 #endif
 
+#ifdef BUILD_HEADLESS_INTERACTIVITY
+#include "..\headless\ConsoleInputThread.hpp"
+#include "..\headless\SystemConfigurationProvider.hpp"
+#endif
+
 #include "..\win32\AccessibilityNotifier.hpp"
 #include "..\win32\ConsoleControl.hpp"
 #include "..\win32\ConsoleInputThread.hpp"
@@ -87,7 +92,11 @@ using namespace Microsoft::Console::Interactivity;
             switch (level)
             {
             case ApiLevel::Win32:
+#ifdef BUILD_HEADLESS_INTERACTIVITY
+                newThread = std::make_unique<Microsoft::Console::Interactivity::Headless::ConsoleInputThread>();
+#else
                 newThread = std::make_unique<Microsoft::Console::Interactivity::Win32::ConsoleInputThread>();
+#endif
                 break;
 
 #ifdef BUILD_ONECORE_INTERACTIVITY
@@ -255,7 +264,11 @@ using namespace Microsoft::Console::Interactivity;
             switch (level)
             {
             case ApiLevel::Win32:
+#ifdef BUILD_HEADLESS_INTERACTIVITY
+                NewProvider = std::make_unique<Microsoft::Console::Interactivity::Headless::SystemConfigurationProvider>();
+#else
                 NewProvider = std::make_unique<Microsoft::Console::Interactivity::Win32::SystemConfigurationProvider>();
+#endif
                 break;
 
 #ifdef BUILD_ONECORE_INTERACTIVITY
@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "ConsoleInputThread.hpp"
+
+#include "..\inc\ServiceLocator.hpp"
+#include "..\..\host\init.hpp"
+
+using namespace Microsoft::Console::Interactivity;
+using namespace Microsoft::Console::Interactivity::Headless;
+
+// Routine Description:
+// - The input thread of the headless host. It does what the win32 input thread
+//   does for a pseudoconsole: make the pseudo window, which has to be made on the
+//   thread that pumps its messages, and pump them (vim.exe sends messages to it).
+// - There's no window to show here, so anything that isn't a pseudoconsole fails
+//   to start instead.
+static DWORD WINAPI ConsoleInputThreadProcHeadless(LPVOID /*lpParameter*/)
+{
+    InitEnvironmentVariables();
+
+    LockConsole();
+    NTSTATUS Status = STATUS_SUCCESS;
+
+    if (ServiceLocator::LocateGlobals().launchArgs.IsHeadless())
+    {
+        const auto trace = Tracing::s_TraceStartupPhase("CreatePseudoWindow");
+        ServiceLocator::LocatePseudoWindow();
+    }
+    else
+    {
+        Status = STATUS_NOT_SUPPORTED;
+    }
+
+    UnlockConsole();
+    if (!NT_SUCCESS(Status))
+    {
+        ServiceLocator::LocateGlobals().ntstatusConsoleInputInitStatus = Status;
+        ServiceLocator::LocateGlobals().hConsoleInputInitEvent.SetEvent();
+        return Status;
+    }
+
+    ServiceLocator::LocateGlobals().hConsoleInputInitEvent.SetEvent();
+
+    // The pseudo window never has the focus, so there's no keyboard input to
+    // translate. Everything that arrives is just handed to its window procedure.
+    for (;;)
+    {
+        MSG msg;
+        if (GetMessageW(&msg, nullptr, 0, 0) == 0)
+        {
+            break;
+        }
+
+        DispatchMessageW(&msg);
+    }
+
+    return 0;
+}
+
+// Routine Description:
+// - Starts the headless console input thread.
+HANDLE ConsoleInputThread::Start()
+{
+    HANDLE hThread = nullptr;
+    DWORD dwThreadId = (DWORD)-1;
+
+    hThread = CreateThread(nullptr,
+                           0,
+                           ConsoleInputThreadProcHeadless,
+                           nullptr,
+                           0,
+                           &dwThreadId);
+
+    if (hThread)
+    {
+        _hThread = hThread;
+        _dwThreadId = dwThreadId;
+    }
+
+    return hThread;
+}
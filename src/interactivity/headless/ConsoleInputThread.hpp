@@ -0,0 +1,28 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ConsoleInputThread.hpp
+
+Abstract:
+- Headless implementation of the IConsoleInputThread interface.
+- A pseudoconsole reads its input from the VT input thread, so this thread only
+  creates the pseudo window and pumps its messages. It never creates a window.
+--*/
+
+#pragma once
+
+#include "..\inc\IConsoleInputThread.hpp"
+
+#pragma hdrstop
+
+namespace Microsoft::Console::Interactivity::Headless
+{
+    class ConsoleInputThread final : public IConsoleInputThread
+    {
+    public:
+        ~ConsoleInputThread() = default;
+        HANDLE Start();
+    };
+}
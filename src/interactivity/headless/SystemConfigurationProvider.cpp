@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "SystemConfigurationProvider.hpp"
+
+using namespace Microsoft::Console::Interactivity::Headless;
+
+UINT SystemConfigurationProvider::GetCaretBlinkTime()
+{
+    return ::GetCaretBlinkTime();
+}
+
+bool SystemConfigurationProvider::IsCaretBlinkingEnabled()
+{
+    return GetSystemMetrics(SM_CARETBLINKINGENABLED) ? true : false;
+}
+
+int SystemConfigurationProvider::GetNumberOfMouseButtons()
+{
+    return GetSystemMetrics(SM_CMOUSEBUTTONS);
+}
+
+ULONG SystemConfigurationProvider::GetCursorWidth()
+{
+    ULONG width;
+    if (SystemParametersInfoW(SPI_GETCARETWIDTH, 0, &width, FALSE))
+    {
+        return width;
+    }
+    else
+    {
+        LOG_LAST_ERROR();
+        return s_DefaultCursorWidth;
+    }
+}
+
+ULONG SystemConfigurationProvider::GetNumberOfWheelScrollLines()
+{
+    ULONG lines;
+    SystemParametersInfoW(SPI_GETWHEELSCROLLLINES, 0, &lines, FALSE);
+
+    return lines;
+}
+
+ULONG SystemConfigurationProvider::GetNumberOfWheelScrollCharacters()
+{
+    ULONG characters;
+    SystemParametersInfoW(SPI_GETWHEELSCROLLCHARS, 0, &characters, FALSE);
+
+    return characters;
+}
+
+// Routine Description:
+// - Links are only read outside of ConPTY mode, which the headless host doesn't
+//   start in, so there's never anything to read. Leaving the shell and the icons
+//   out is a good part of what keeps this host small.
+void SystemConfigurationProvider::GetSettingsFromLink(
+    _Inout_ Settings* /*pLinkSettings*/,
+    _Inout_updates_bytes_(*pdwTitleLength) LPWSTR /*pwszTitle*/,
+    _Inout_ PDWORD /*pdwTitleLength*/,
+    _In_ PCWSTR /*pwszCurrDir*/,
+    _In_ PCWSTR /*pwszAppName*/)
+{
+    return;
+}
@@ -0,0 +1,44 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- SystemConfigurationProvider.hpp
+
+Abstract:
+- Headless implementation of the ISystemConfigurationProvider interface.
+- The system settings are read like the win32 ones, but there are never any
+  link settings: a pseudoconsole isn't started from a shortcut.
+--*/
+
+#pragma once
+
+#include "..\inc\ISystemConfigurationProvider.hpp"
+
+#pragma hdrstop
+
+namespace Microsoft::Console::Interactivity::Headless
+{
+    class SystemConfigurationProvider final : public ISystemConfigurationProvider
+    {
+    public:
+        ~SystemConfigurationProvider() = default;
+
+        bool IsCaretBlinkingEnabled();
+
+        UINT GetCaretBlinkTime();
+        int GetNumberOfMouseButtons();
+        ULONG GetCursorWidth() override;
+        ULONG GetNumberOfWheelScrollLines();
+        ULONG GetNumberOfWheelScrollCharacters();
+
+        void GetSettingsFromLink(_Inout_ Settings* pLinkSettings,
+                                 _Inout_updates_bytes_(*pdwTitleLength) LPWSTR pwszTitle,
+                                 _Inout_ PDWORD pdwTitleLength,
+                                 _In_ PCWSTR pwszCurrDir,
+                                 _In_ PCWSTR pwszAppName);
+
+    private:
+        static const ULONG s_DefaultCursorWidth = 1;
+    };
+}
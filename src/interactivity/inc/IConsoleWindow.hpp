@@ -55,8 +55,13 @@ namespace Microsoft::Console::Interactivity
 
         virtual BOOL PostUpdateScrollBars() const = 0;
 
+        virtual BOOL PostUpdateAccessibility() const = 0;
+
         virtual BOOL PostUpdateWindowSize() const = 0;
 
+        virtual BOOL SetCursorBlinkTimer(const UINT uElapse) = 0;
+        virtual BOOL KillCursorBlinkTimer() = 0;
+
         virtual void UpdateWindowSize(const COORD coordSizeInChars) = 0;
         virtual void UpdateWindowText() = 0;
 
@@ -104,11 +104,26 @@ BOOL ConsoleWindow::PostUpdateScrollBars() const
     return FALSE;
 }
 
+BOOL ConsoleWindow::PostUpdateAccessibility() const
+{
+    return FALSE;
+}
+
 BOOL ConsoleWindow::PostUpdateWindowSize() const
 {
     return FALSE;
 }
 
+BOOL ConsoleWindow::SetCursorBlinkTimer(const UINT /*uElapse*/)
+{
+    return FALSE;
+}
+
+BOOL ConsoleWindow::KillCursorBlinkTimer()
+{
+    return FALSE;
+}
+
 void ConsoleWindow::UpdateWindowSize(COORD const /*coordSizeInChars*/)
 {
 }
@@ -46,9 +46,13 @@ namespace Microsoft::Console::Interactivity::OneCore
         BOOL SendNotifyBeep() const;
 
         BOOL PostUpdateScrollBars() const;
+        BOOL PostUpdateAccessibility() const;
         BOOL PostUpdateTitleWithCopy(const PCWSTR pwszNewTitle) const;
         BOOL PostUpdateWindowSize() const;
 
+        BOOL SetCursorBlinkTimer(const UINT uElapse);
+        BOOL KillCursorBlinkTimer();
+
         void UpdateWindowSize(COORD const coordSizeInChars);
         void UpdateWindowText();
 
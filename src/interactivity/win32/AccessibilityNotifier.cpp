@@ -64,7 +64,7 @@ void AccessibilityNotifier::NotifyConsoleCaretEvent(_In_ ConsoleCaretEventFlags
 void AccessibilityNotifier::NotifyConsoleUpdateScrollEvent(_In_ LONG x, _In_ LONG y)
 {
     IConsoleWindow* pWindow = ServiceLocator::LocateConsoleWindow();
-    if (pWindow)
+    if (pWindow && IsWinEventHookInstalled(EVENT_CONSOLE_UPDATE_SCROLL))
     {
         NotifyWinEvent(EVENT_CONSOLE_UPDATE_SCROLL,
                        pWindow->GetWindowHandle(),
@@ -75,8 +75,9 @@ void AccessibilityNotifier::NotifyConsoleUpdateScrollEvent(_In_ LONG x, _In_ LON
 
 void AccessibilityNotifier::NotifyConsoleUpdateSimpleEvent(_In_ LONG start, _In_ LONG charAndAttribute)
 {
+    // These are raised for every change to the buffer, so don't bother when nobody's listening.
     IConsoleWindow* pWindow = ServiceLocator::LocateConsoleWindow();
-    if (pWindow)
+    if (pWindow && IsWinEventHookInstalled(EVENT_CONSOLE_UPDATE_SIMPLE))
     {
         NotifyWinEvent(EVENT_CONSOLE_UPDATE_SIMPLE,
                        pWindow->GetWindowHandle(),
@@ -88,7 +89,7 @@ void AccessibilityNotifier::NotifyConsoleUpdateSimpleEvent(_In_ LONG start, _In_
 void AccessibilityNotifier::NotifyConsoleUpdateRegionEvent(_In_ LONG startXY, _In_ LONG endXY)
 {
     IConsoleWindow* pWindow = ServiceLocator::LocateConsoleWindow();
-    if (pWindow)
+    if (pWindow && IsWinEventHookInstalled(EVENT_CONSOLE_UPDATE_REGION))
     {
         NotifyWinEvent(EVENT_CONSOLE_UPDATE_REGION,
                        pWindow->GetWindowHandle(),
@@ -16,15 +16,366 @@
 #include "..\inc\conint.h"
 #include "..\inc\ServiceLocator.hpp"
 
+#include <array>
+#include <charconv>
+#include <unordered_map>
+
+#if (defined(_M_IX86) || defined(_M_AMD64))
+#include <emmintrin.h>
+#endif
+
 #pragma hdrstop
 
 using namespace Microsoft::Console::Interactivity::Win32;
 using namespace Microsoft::Console::Types;
 
+namespace
+{
+    constexpr char HexDigits[] = "0123456789abcdef";
+
+    // Appends value in decimal, padded with zeros to at least minDigits digits.
+    void _AppendDecimal(std::string& out, const size_t value, const size_t minDigits = 1)
+    {
+        char digits[20];
+        const auto end = std::to_chars(std::begin(digits), std::end(digits), value).ptr;
+        const auto count = static_cast<size_t>(end - std::begin(digits));
+        if (count < minDigits)
+        {
+            out.append(minDigits - count, '0');
+        }
+        out.append(std::begin(digits), end);
+    }
+
+    // Appends a color the way CSS writes it, e.g. #0c0c0c.
+    void _AppendHexColor(std::string& out, const COLORREF color)
+    {
+        const BYTE channels[] = { GetRValue(color), GetGValue(color), GetBValue(color) };
+        out.push_back('#');
+        for (const auto channel : channels)
+        {
+            out.push_back(HexDigits[channel >> 4]);
+            out.push_back(HexDigits[channel & 0xf]);
+        }
+    }
+
+    // Appends text to HTML as UTF-8, escaping what would be taken for markup.
+    void _AppendHtmlText(std::string& out, const std::wstring_view text)
+    {
+        for (size_t i = 0; i < text.size();)
+        {
+            // ASCII goes straight in, everything else a stretch at a time.
+            const auto ch = text[i];
+            if (ch < 0x80)
+            {
+                switch (ch)
+                {
+                case L'<':
+                    out.append("&lt;");
+                    break;
+                case L'>':
+                    out.append("&gt;");
+                    break;
+                case L'&':
+                    out.append("&amp;");
+                    break;
+                default:
+                    out.push_back(static_cast<char>(ch));
+                    break;
+                }
+                ++i;
+                continue;
+            }
+
+            auto end = i + 1;
+            while (end < text.size() && text[end] >= 0x80)
+            {
+                ++end;
+            }
+
+            const auto cch = gsl::narrow<int>(end - i);
+            const auto cb = WideCharToMultiByte(CP_UTF8, 0, text.data() + i, cch, nullptr, 0, nullptr, nullptr);
+            THROW_LAST_ERROR_IF(cb == 0);
+            const auto offset = out.size();
+            out.resize(offset + cb);
+            THROW_LAST_ERROR_IF(WideCharToMultiByte(CP_UTF8, 0, text.data() + i, cch, out.data() + offset, cb, nullptr, nullptr) == 0);
+
+            i = end;
+        }
+    }
+
+    // Appends text to RTF, escaping its control characters. Anything past ASCII is written
+    // as a \u control word, with no fallback character after it since \uc0 is in effect.
+    void _AppendRtfText(std::string& out, const std::wstring_view text)
+    {
+        for (const auto ch : text)
+        {
+            if (ch < 0x80)
+            {
+                if (ch == L'\\' || ch == L'{' || ch == L'}')
+                {
+                    out.push_back('\\');
+                }
+                out.push_back(static_cast<char>(ch));
+            }
+            else
+            {
+                // \u takes a signed 16-bit number.
+                const int value = static_cast<int16_t>(ch);
+                out.append("\\u");
+                if (value < 0)
+                {
+                    out.push_back('-');
+                }
+                _AppendDecimal(out, static_cast<size_t>(value < 0 ? -value : value));
+                out.push_back(' ');
+            }
+        }
+    }
+
+    // Writes out the selected text as plain text and, when asked, as CF_HTML and RTF, all in
+    // the one pass over the buffer. A run in the same colors as the one before it is merged
+    // into it, so that spans only start where the colors change.
+    class FormattedTextSink final : public TextBuffer::ITextRunSink
+    {
+    public:
+        FormattedTextSink(const CONSOLE_INFORMATION& gci,
+                          const size_t expectedChars,
+                          const bool alsoFormats,
+                          const COLORREF background,
+                          const std::wstring_view fontFace,
+                          const int fontHeightPoints) :
+            _gci{ gci },
+            _alsoFormats{ alsoFormats }
+        {
+            _result.text.reserve(expectedChars);
+            if (_alsoFormats)
+            {
+                // Most of the output is the text itself. What's left is room for a fair number of spans.
+                _result.html.reserve(expectedChars + expectedChars / 2 + 1024);
+                _rtfBody.reserve(expectedChars + expectedChars / 2 + 1024);
+                _StartHtml(background, fontFace, fontHeightPoints);
+                _StartRtf(fontFace, fontHeightPoints);
+            }
+        }
+
+        void OnTextRun(const std::wstring_view text, const TextAttribute& attr) override
+        {
+            _result.text.append(text);
+
+            if (_alsoFormats)
+            {
+                const auto fg = _gci.LookupForegroundColor(attr);
+                const auto bg = _gci.LookupBackgroundColor(attr);
+                if (!_colorFound || fg != _fg || bg != _bg)
+                {
+                    _ChangeColors(fg, bg);
+                }
+
+                _AppendHtmlText(_result.html, text);
+                _AppendRtfText(_rtfBody, text);
+            }
+        }
+
+        void OnRowEnd(const bool lineBreak) override
+        {
+            if (lineBreak)
+            {
+                _result.text.append(L"\r\n");
+                if (_alsoFormats)
+                {
+                    // The line breaks go in the current span; there's nothing to see of them anyway.
+                    _result.html.append("\r\n");
+                    _rtfBody.append("\\line ");
+                }
+            }
+        }
+
+        Clipboard::FormattedText Finish()
+        {
+            if (_alsoFormats)
+            {
+                _FinishHtml();
+                _FinishRtf();
+            }
+            return std::move(_result);
+        }
+
+    private:
+        // When it's filled in, there are 157 bytes in the CF_HTML header.
+        static constexpr size_t HtmlClipHeaderSize = 157;
+        static constexpr std::string_view HtmlHeader{ "<!DOCTYPE><HTML><HEAD><TITLE>Windows Console Host</TITLE></HEAD><BODY>" };
+        static constexpr std::string_view HtmlFragmentStart{ "<!--StartFragment -->" };
+        static constexpr std::string_view HtmlFragmentEnd{ "<!--EndFragment -->" };
+        static constexpr std::string_view HtmlFooter{ "</BODY></HTML>" };
+        static constexpr std::string_view HtmlSpanEnd{ "</SPAN>" };
+
+        const CONSOLE_INFORMATION& _gci;
+        const bool _alsoFormats;
+        Clipboard::FormattedText _result;
+
+        bool _colorFound = false;
+        COLORREF _fg = 0;
+        COLORREF _bg = 0;
+
+        // RTF wants its color table before the text that uses it, so the text is kept aside
+        // until every color has been seen. Colors are numbered from 1: 0 is the default color.
+        std::string _rtfHeader;
+        std::string _rtfBody;
+        std::unordered_map<COLORREF, size_t> _rtfColors;
+        std::string _rtfColorTable;
+
+        void _StartHtml(const COLORREF background, const std::wstring_view fontFace, const int fontHeightPoints)
+        {
+            auto& html = _result.html;
+
+            // Space for the header, which is filled in once the offsets are known.
+            html.append(HtmlClipHeaderSize, 'H');
+            html.append(HtmlHeader);
+            html.append(HtmlFragmentStart);
+
+            html.append(R"X(<DIV STYLE="background-color:)X");
+            _AppendHexColor(html, background);
+            html.append(R"X(;white-space:pre;">)X");
+
+            if (!fontFace.empty())
+            {
+                html.append(R"X(<SPAN STYLE="font-family: ')X");
+                _AppendHtmlText(html, fontFace);
+                html.append(R"X(', monospace">)X");
+            }
+            else
+            {
+                html.append(R"X(<SPAN STYLE="font-family: monospace">)X");
+            }
+
+            html.append(R"X(<SPAN STYLE="font-size: )X");
+            _AppendDecimal(html, static_cast<size_t>(fontHeightPoints));
+            html.append(R"X(pt">)X");
+        }
+
+        void _StartRtf(const std::wstring_view fontFace, const int fontHeightPoints)
+        {
+            _rtfHeader.append(R"X({\rtf1\ansi\ansicpg1252\deff0{\fonttbl{\f0\fmodern\fprq1 )X");
+            _AppendRtfText(_rtfHeader, fontFace.empty() ? L"Courier New" : fontFace);
+            _rtfHeader.append(";}}");
+
+            // The size is in half points.
+            _rtfBody.append(R"X(\uc0\f0\fs)X");
+            _AppendDecimal(_rtfBody, static_cast<size_t>(fontHeightPoints) * 2);
+            _rtfBody.push_back(' ');
+        }
+
+        void _ChangeColors(const COLORREF fg, const COLORREF bg)
+        {
+            auto& html = _result.html;
+            if (_colorFound)
+            {
+                html.append(HtmlSpanEnd);
+            }
+            html.append(R"X(<SPAN STYLE="color:)X");
+            _AppendHexColor(html, fg);
+            html.append(";background-color:");
+            _AppendHexColor(html, bg);
+            html.append(R"X(">)X");
+
+            const auto fgIndex = _RtfColorIndex(fg);
+            const auto bgIndex = _RtfColorIndex(bg);
+            _rtfBody.append("\\cf");
+            _AppendDecimal(_rtfBody, fgIndex);
+            _rtfBody.append("\\chshdng0\\chcbpat");
+            _AppendDecimal(_rtfBody, bgIndex);
+            _rtfBody.append("\\cb");
+            _AppendDecimal(_rtfBody, bgIndex);
+            _rtfBody.push_back(' ');
+
+            _colorFound = true;
+            _fg = fg;
+            _bg = bg;
+        }
+
+        size_t _RtfColorIndex(const COLORREF color)
+        {
+            const auto [it, inserted] = _rtfColors.emplace(color, _rtfColors.size() + 1);
+            if (inserted)
+            {
+                _rtfColorTable.append("\\red");
+                _AppendDecimal(_rtfColorTable, GetRValue(color));
+                _rtfColorTable.append("\\green");
+                _AppendDecimal(_rtfColorTable, GetGValue(color));
+                _rtfColorTable.append("\\blue");
+                _AppendDecimal(_rtfColorTable, GetBValue(color));
+                _rtfColorTable.push_back(';');
+            }
+            return it->second;
+        }
+
+        void _FinishHtml()
+        {
+            auto& html = _result.html;
+            if (_colorFound)
+            {
+                html.append(HtmlSpanEnd);
+            }
+
+            // the font size and face spans, then the background
+            html.append(HtmlSpanEnd);
+            html.append(HtmlSpanEnd);
+            html.append("</DIV>");
+
+            html.append(HtmlFragmentEnd);
+            html.append(HtmlFooter);
+
+            const size_t htmlStart = HtmlClipHeaderSize;
+            const size_t htmlEnd = html.size();
+            const size_t fragmentStart = HtmlClipHeaderSize + HtmlHeader.size();
+            const size_t fragmentEnd = htmlEnd - HtmlFooter.size();
+
+            // The header is the same length whatever the offsets, so it's written over the space left for it.
+            std::string header;
+            header.reserve(HtmlClipHeaderSize);
+            header.append("Version:0.9\r\n");
+            const std::pair<std::string_view, size_t> offsets[] = {
+                { "StartHTML:", htmlStart },
+                { "EndHTML:", htmlEnd },
+                { "StartFragment:", fragmentStart },
+                { "EndFragment:", fragmentEnd },
+                { "StartSelection:", fragmentStart },
+                { "EndSelection:", fragmentEnd },
+            };
+            for (const auto& [name, offset] : offsets)
+            {
+                header.append(name);
+                _AppendDecimal(header, offset, 10);
+                header.append("\r\n");
+            }
+            THROW_HR_IF(E_UNEXPECTED, header.size() != HtmlClipHeaderSize);
+            html.replace(0, HtmlClipHeaderSize, header);
+
+            // null terminate the clipboard data
+            html.push_back('\0');
+        }
+
+        void _FinishRtf()
+        {
+            auto& rtf = _result.rtf;
+            rtf.reserve(_rtfHeader.size() + _rtfColorTable.size() + _rtfBody.size() + 32);
+            rtf.append(_rtfHeader);
+            rtf.append("{\\colortbl ;");
+            rtf.append(_rtfColorTable);
+            rtf.append("}");
+            rtf.append(_rtfBody);
+            rtf.append("}");
+            rtf.push_back('\0');
+
+            _rtfBody = {};
+        }
+    };
+}
+
 #pragma region Public Methods
 
 // Arguments:
-// - fAlsoCopyHtml - Place colored HTML text onto the clipboard as well as the usual plain text.
+// - fAlsoCopyHtml - Place colored HTML and RTF text onto the clipboard as well as the usual plain text.
 // Return Value:
 //   <none>
 // NOTE:  if the registry is set to always copy color data then we will even if fAlsoCopyHTML is false
@@ -107,8 +458,19 @@ void Clipboard::StringPaste(_In_reads_(cchData) const wchar_t* const pData,
 
     try
     {
-        std::deque<std::unique_ptr<IInputEvent>> inEvents = TextToKeyEvents(pData, cchData);
-        gci.pInputBuffer->Write(inEvents);
+        const auto text = FilterPastedText({ pData, cchData });
+
+        // In VT input mode, all a reader gets of a typed character is the character, so the text
+        // goes in as it is. Otherwise the keys that would type it have to be made up.
+        if (IsInVirtualTerminalInputMode())
+        {
+            gci.pInputBuffer->WriteText(text);
+        }
+        else
+        {
+            const std::vector<INPUT_RECORD> inRecords = FilteredTextToInputRecords(text);
+            gci.pInputBuffer->Write({ inRecords.data(), inRecords.size() });
+        }
     }
     catch (...)
     {
@@ -133,62 +495,94 @@ void Clipboard::StringPaste(_In_reads_(cchData) const wchar_t* const pData,
 std::deque<std::unique_ptr<IInputEvent>> Clipboard::TextToKeyEvents(_In_reads_(cchData) const wchar_t* const pData,
                                                                     const size_t cchData)
 {
-    THROW_IF_NULL_ALLOC(pData);
-
     std::deque<std::unique_ptr<IInputEvent>> keyEvents;
-
-    for (size_t i = 0; i < cchData; ++i)
+    for (const INPUT_RECORD& record : TextToInputRecords(pData, cchData))
     {
-        wchar_t currentChar = pData[i];
+        keyEvents.push_back(IInputEvent::Create(record));
+    }
+    return keyEvents;
+}
 
-        const bool charAllowed = FilterCharacterOnPaste(&currentChar);
-        // filter out linefeed if it's not the first char and preceded
-        // by a carriage return
-        const bool skipLinefeed = (i != 0 &&
-                                   currentChar == UNICODE_LINEFEED &&
-                                   pData[i - 1] == UNICODE_CARRIAGERETURN);
+// Routine Description:
+// - converts a wchar_t* into the key records that typing it from the
+// keyboard would make
+// Arguments:
+// - pData - the text to convert
+// - cchData - the size of pData, in wchars
+// Return Value:
+// - the records that represent the string passed in
+// Note:
+// - will throw exception on error
+std::vector<INPUT_RECORD> Clipboard::TextToInputRecords(_In_reads_(cchData) const wchar_t* const pData,
+                                                        const size_t cchData)
+{
+    THROW_IF_NULL_ALLOC(pData);
+    return FilteredTextToInputRecords(FilterPastedText({ pData, cchData }));
+}
 
-        if (!charAllowed || skipLinefeed)
-        {
-            continue;
-        }
+// Routine Description:
+// - converts text that FilterPastedText has been through into the key records
+// that typing it from the keyboard would make
+// Arguments:
+// - text - the text to convert
+// Return Value:
+// - the records that represent the text
+// Note:
+// - will throw exception on error
+// - the key events for a character only depend on it, the codepage and the
+// keyboard layout, none of which change during a paste. so each distinct
+// character is only synthesized once and its records are copied after that.
+// ASCII, which most pastes are made of, is looked up in a table rather than the map.
+std::vector<INPUT_RECORD> Clipboard::FilteredTextToInputRecords(const std::wstring_view text)
+{
+    const UINT codepage = ServiceLocator::LocateGlobals().getConsoleInformation().OutputCP;
+    std::array<std::vector<INPUT_RECORD>, 0x80> synthesizedAscii;
+    std::unordered_map<wchar_t, std::vector<INPUT_RECORD>> synthesized;
 
-        if (currentChar == 0)
+    const auto synthesize = [codepage](const wchar_t ch) {
+        std::vector<INPUT_RECORD> charRecords;
+        for (const auto& keyEvent : CharToKeyEvents(ch, codepage))
         {
-            break;
+            charRecords.push_back(keyEvent->ToInputRecord());
         }
+        return charRecords;
+    };
 
-        // MSFT:12123975 / WSL GH#2006
-        // If you paste text with ONLY linefeed line endings (unix style) in wsl,
-        //      then we faithfully pass those along, which the underlying terminal
-        //      interprets as C-j. In nano, C-j is mapped to "Justify text", which
-        //      causes the pasted text to get broken at the width of the terminal.
-        // This behavior doesn't occur in gnome-terminal, and nothing like it occurs
-        //      in vi or emacs.
-        // This change doesn't break pasting text into any of those applications
-        //      with CR/LF (Windows) line endings either. That apparently always
-        //      worked right.
-        if (IsInVirtualTerminalInputMode() && currentChar == UNICODE_LINEFEED)
+    std::vector<INPUT_RECORD> records;
+    // most characters are typed as a key down and a key up
+    records.reserve(text.size() * 2);
+
+    for (const auto ch : text)
+    {
+        const std::vector<INPUT_RECORD>* charRecords;
+        if (ch < synthesizedAscii.size())
         {
-            currentChar = UNICODE_CARRIAGERETURN;
+            auto& cached = synthesizedAscii[ch];
+            if (cached.empty())
+            {
+                cached = synthesize(ch);
+            }
+            charRecords = &cached;
         }
-
-        const UINT codepage = ServiceLocator::LocateGlobals().getConsoleInformation().OutputCP;
-        std::deque<std::unique_ptr<KeyEvent>> convertedEvents = CharToKeyEvents(currentChar, codepage);
-        while (!convertedEvents.empty())
+        else
         {
-            keyEvents.push_back(std::move(convertedEvents.front()));
-            convertedEvents.pop_front();
+            auto found = synthesized.find(ch);
+            if (found == synthesized.end())
+            {
+                found = synthesized.emplace(ch, synthesize(ch)).first;
+            }
+            charRecords = &found->second;
         }
+        records.insert(records.end(), charRecords->cbegin(), charRecords->cend());
     }
-    return keyEvents;
+    return records;
 }
 
 // Routine Description:
 // - Copies the selected area onto the global system clipboard.
 // - NOTE: Throws on allocation and other clipboard failures.
 // Arguments:
-// - fAlsoCopyHtml - This will also place colored HTML text onto the clipboard as well as the usual plain text.
+// - fAlsoCopyHtml - This will also place colored HTML and RTF text onto the clipboard as well as the usual plain text.
 // Return Value:
 //   <none>
 void Clipboard::StoreSelectionToClipboard(bool const fAlsoCopyHtml)
@@ -208,11 +602,12 @@ void Clipboard::StoreSelectionToClipboard(bool const fAlsoCopyHtml)
     const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
     const auto& screenInfo = gci.GetActiveOutputBuffer();
 
-    const auto text = RetrieveTextFromBuffer(screenInfo,
-                                             lineSelection,
-                                             selectionRects);
+    const auto text = RetrieveFormattedText(screenInfo,
+                                            lineSelection,
+                                            selectionRects,
+                                            fAlsoCopyHtml);
 
-    CopyTextToSystemClipboard(text, fAlsoCopyHtml);
+    CopyTextToSystemClipboard(text);
 }
 
 // Routine Description:
@@ -240,261 +635,56 @@ TextBuffer::TextAndColor Clipboard::RetrieveTextFromBuffer(const SCREEN_INFORMAT
 }
 
 // Routine Description:
-// - Generates a CF_HTML compliant structure based on the passed in text and color data
+// - Generates the plain text of the selected region and, if asked, CF_HTML and RTF versions of it in the
+//   same pass over the text buffer. The formats are written straight from the buffer's attribute runs.
 // Arguments:
-// - rows - the text and color data we will format & encapsulate
+// - screenInfo - what is rendered on the screen
+// - lineSelection - true if entire line is being selected. False otherwise (box selection)
+// - selectionRects - the selection regions from which the data will be extracted from the buffer
+// - alsoFormats - true to generate the HTML and RTF as well as the plain text
 // Return Value:
-// - string containing the generated HTML
-std::string Clipboard::GenHTML(const TextBuffer::TextAndColor& rows)
+// - the text, with html and rtf empty unless alsoFormats was given. Both of those are null terminated.
+Clipboard::FormattedText Clipboard::RetrieveFormattedText(const SCREEN_INFORMATION& screenInfo,
+                                                          const bool lineSelection,
+                                                          const std::vector<SMALL_RECT>& selectionRects,
+                                                          const bool alsoFormats)
 {
-    std::string szClipboard; // we will build the data going back in this string buffer
+    const auto& buffer = screenInfo.GetTextBuffer();
+    const bool trimTrailingWhitespace = !WI_IsFlagSet(GetKeyState(VK_SHIFT), KEY_PRESSED);
+    const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
 
-    try
+    // Every selected cell and a line break after each rect, which is at most what comes out
+    // unless glyphs take more than one code unit.
+    size_t expectedChars = 0;
+    for (const auto& rect : selectionRects)
     {
-        std::string const szHtmlClipFormat =
-            "Version:0.9\r\n"
-            "StartHTML:%010d\r\n"
-            "EndHTML:%010d\r\n"
-            "StartFragment:%010d\r\n"
-            "EndFragment:%010d\r\n"
-            "StartSelection:%010d\r\n"
-            "EndSelection:%010d\r\n";
-
-        // measure clip header
-        size_t const cbHeader = 157; // when formats are expanded, there will be 157 bytes in the header.
-
-        std::string const szHtmlHeader =
-            "<!DOCTYPE><HTML><HEAD><TITLE>Windows Console Host</TITLE></HEAD><BODY>";
-        size_t const cbHtmlHeader = szHtmlHeader.size();
-
-        std::string const szHtmlFragStart = "<!--StartFragment -->";
-        std::string const szHtmlFragEnd = "<!--EndFragment -->";
-        std::string const szHtmlFooter = "</BODY></HTML>";
-        size_t const cbHtmlFooter = szHtmlFooter.size();
-
-        std::string const szDivOuterBackgroundPattern = R"X(<DIV STYLE="background-color:#%02x%02x%02x;white-space:pre;">)X";
-
-        size_t const cbDivOuter = 55;
-        std::string szDivOuter;
-        szDivOuter.reserve(cbDivOuter);
-
-        std::string const szSpanFontSizePattern = R"X(<SPAN STYLE="font-size: %dpt">)X";
-
-        const auto& fontData = ServiceLocator::LocateGlobals().getConsoleInformation().GetActiveOutputBuffer().GetCurrentFont();
-        int const iFontHeightPoints = fontData.GetUnscaledSize().Y * 72 / ServiceLocator::LocateGlobals().dpi;
-        size_t const cbSpanFontSize = 28 + (iFontHeightPoints / 10) + 1;
-
-        std::string szSpanFontSize;
-        szSpanFontSize.resize(cbSpanFontSize + 1); // reserve space for null after string for sprintf
-        sprintf_s(szSpanFontSize.data(), cbSpanFontSize + 1, szSpanFontSizePattern.data(), iFontHeightPoints);
-        szSpanFontSize.resize(cbSpanFontSize); //chop off null at end
-
-        std::string const szSpanStartPattern = R"X(<SPAN STYLE="color:#%02x%02x%02x;background-color:#%02x%02x%02x">)X";
-
-        size_t const cbSpanStart = 53; // when format is expanded, there will be 53 bytes per color pattern.
-        std::string szSpanStart;
-        szSpanStart.resize(cbSpanStart + 1); // +1 for null terminator
-
-        std::string const szSpanStartFontPattern = R"X(<SPAN STYLE="font-family: '%s', monospace">)X";
-        size_t const cbSpanStartFontPattern = 41;
-
-        std::string const szSpanStartFontConstant = R"X(<SPAN STYLE="font-family: monospace">)X";
-        size_t const cbSpanStartFontConstant = 37;
-
-        std::string szSpanStartFont;
-        size_t cbSpanStartFont;
-        bool fDeleteSpanStartFont = false;
-
-        std::wstring const wszFontFaceName = fontData.GetFaceName();
-        size_t const cchFontFaceName = wszFontFaceName.size();
-        if (cchFontFaceName > 0)
-        {
-            // measure and create buffer to convert face name to UTF8
-            int const cbNeeded = WideCharToMultiByte(CP_UTF8, 0, wszFontFaceName.data(), static_cast<int>(cchFontFaceName), nullptr, 0, nullptr, nullptr);
-            std::string szBuffer;
-            szBuffer.resize(cbNeeded);
-
-            // do conversion
-            WideCharToMultiByte(CP_UTF8, 0, wszFontFaceName.data(), static_cast<int>(cchFontFaceName), szBuffer.data(), cbNeeded, nullptr, nullptr);
-
-            // format converted font name into pattern
-            std::string const szFinalFontPattern = R"X(<SPAN STYLE="font-family: ')X" + szBuffer + R"X(', monospace\">)X";
-            size_t const cbBytesNeeded = szFinalFontPattern.length();
-
-            fDeleteSpanStartFont = true;
-            szSpanStartFont = szFinalFontPattern;
-            cbSpanStartFont = cbBytesNeeded;
-        }
-        else
-        {
-            szSpanStartFont = szSpanStartFontConstant;
-            cbSpanStartFont = cbSpanStartFontConstant;
-        }
-
-        std::string const szSpanEnd = "</SPAN>";
-        std::string const szDivEnd = "</DIV>";
-
-        // Start building the HTML formated string to return
-        // First we have to add the required header and then
-        // some standard HTML boiler plate required for CF_HTML
-        // as part of the HTML Clipboard format
-        szClipboard.append(cbHeader, 'H'); // reserve space for a header we fill in later
-        szClipboard.append(szHtmlHeader);
-        szClipboard.append(szHtmlFragStart);
-
-        COLORREF iBgColor = rows.BkAttr.at(0).at(0);
-
-        szDivOuter.resize(cbDivOuter + 1);
-        sprintf_s(szDivOuter.data(), cbDivOuter + 1, szDivOuterBackgroundPattern.data(), GetRValue(iBgColor), GetGValue(iBgColor), GetBValue(iBgColor));
-        szDivOuter.resize(cbDivOuter);
-        szClipboard.append(szDivOuter);
-
-        // copy font face start
-        szClipboard.append(szSpanStartFont);
-
-        // copy font size start
-        szClipboard.append(szSpanFontSize);
-
-        bool bColorFound = false;
-
-        // copy all text into the final clipboard data handle. There should be no nulls between rows of
-        // characters, but there should be a \0 at the end.
-        for (UINT iRow = 0; iRow < rows.text.size(); iRow++)
-        {
-            size_t cbStartOffset = 0;
-            size_t cchCharsToPrint = 0;
-
-            COLORREF const Blackness = RGB(0x00, 0x00, 0x00);
-            COLORREF fgColor = Blackness;
-            COLORREF bkColor = Blackness;
-
-            for (UINT iCol = 0; iCol < rows.text.at(iRow).length(); iCol++)
-            {
-                bool fColorDelta = false;
-
-                if (!bColorFound)
-                {
-                    fgColor = rows.FgAttr.at(iRow).at(iCol);
-                    bkColor = rows.BkAttr.at(iRow).at(iCol);
-                    bColorFound = true;
-                    fColorDelta = true;
-                }
-                else if ((rows.FgAttr.at(iRow).at(iCol) != fgColor) || (rows.BkAttr.at(iRow).at(iCol) != bkColor))
-                {
-                    fgColor = rows.FgAttr.at(iRow).at(iCol);
-                    bkColor = rows.BkAttr.at(iRow).at(iCol);
-                    fColorDelta = true;
-                }
-
-                if (fColorDelta)
-                {
-                    if (cchCharsToPrint > 0)
-                    {
-                        // write accumulated characters to stream ....
-                        std::string TempBuff;
-                        int const cbTempCharsNeeded = WideCharToMultiByte(CP_UTF8, 0, rows.text[iRow].data() + cbStartOffset, static_cast<int>(cchCharsToPrint), nullptr, 0, nullptr, nullptr);
-                        TempBuff.resize(cbTempCharsNeeded);
-                        WideCharToMultiByte(CP_UTF8, 0, rows.text[iRow].data() + cbStartOffset, static_cast<int>(cchCharsToPrint), TempBuff.data(), cbTempCharsNeeded, nullptr, nullptr);
-                        szClipboard.append(TempBuff);
-                        cbStartOffset += cchCharsToPrint;
-                        cchCharsToPrint = 0;
-
-                        // close previous span
-                        szClipboard += szSpanEnd;
-                    }
-
-                    // start new span
-
-                    // format with color then copy formatted string
-                    szSpanStart.resize(cbSpanStart + 1); // add room for null
-                    sprintf_s(szSpanStart.data(), cbSpanStart + 1, szSpanStartPattern.data(), GetRValue(fgColor), GetGValue(fgColor), GetBValue(fgColor), GetRValue(bkColor), GetGValue(bkColor), GetBValue(bkColor));
-                    szSpanStart.resize(cbSpanStart); // chop null from sprintf
-                    szClipboard.append(szSpanStart);
-                }
-
-                // accumulate 1 character
-                cchCharsToPrint++;
-            }
-
-            PCWCHAR pwchAccumulateStart = rows.text.at(iRow).data() + cbStartOffset;
-
-            // write accumulated characters to stream
-            std::string CharsConverted;
-            int cbCharsConverted = WideCharToMultiByte(CP_UTF8, 0, pwchAccumulateStart, static_cast<int>(cchCharsToPrint), nullptr, 0, nullptr, nullptr);
-            CharsConverted.resize(cbCharsConverted);
-            WideCharToMultiByte(CP_UTF8, 0, pwchAccumulateStart, static_cast<int>(cchCharsToPrint), CharsConverted.data(), cbCharsConverted, nullptr, nullptr);
-            szClipboard.append(CharsConverted);
-        }
-
-        if (bColorFound)
-        {
-            // copy end span
-            szClipboard.append(szSpanEnd);
-        }
-
-        // after we have copied all text we must wrap up
-        // with a standard set of HTML boilerplate required
-        // by CF_HTML
-
-        // copy end font size span
-        szClipboard.append(szSpanEnd);
-
-        // copy end font face span
-        szClipboard.append(szSpanEnd);
-
-        // copy end background color span
-        szClipboard.append(szDivEnd);
-
-        // copy HTML end fragment
-        szClipboard.append(szHtmlFragEnd);
-
-        // copy HTML footer
-        szClipboard.append(szHtmlFooter);
-
-        // null terminate the clipboard data
-        szClipboard += '\0';
-
-        // we are done generating formating & building HTML for the selection
-        // prepare the header text with the byte counts now that we know them
-        size_t const cbHtmlStart = cbHeader; // bytecount to start of HTML context
-        size_t const cbHtmlEnd = szClipboard.size() - 1; // don't count the null at the end
-        size_t const cbFragStart = cbHeader + cbHtmlHeader; // bytecount to start of selection fragment
-        size_t const cbFragEnd = cbHtmlEnd - cbHtmlFooter;
-
-        // push the values into the required HTML 0.9 header format
-        std::string szHtmlClipHeaderFinal;
-        szHtmlClipHeaderFinal.resize(cbHeader + 1); // add room for a null
-        sprintf_s(szHtmlClipHeaderFinal.data(), cbHeader + 1, szHtmlClipFormat.data(), cbHtmlStart, cbHtmlEnd, cbFragStart, cbFragEnd, cbFragStart, cbFragEnd);
-        szHtmlClipHeaderFinal.resize(cbHeader); // chop off the null
-
-        // overwrite the reserved space with the actual header & offsets we calculated
-        szClipboard.replace(0, cbHeader, szHtmlClipHeaderFinal.data());
+        expectedChars += static_cast<size_t>(rect.Right - rect.Left + 1) + 2;
     }
-    catch (...)
+
+    // The whole fragment sits in a block with the background of the first selected cell.
+    COLORREF background = RGB(0x00, 0x00, 0x00);
+    if (!selectionRects.empty())
     {
-        LOG_HR(wil::ResultFromCaughtException());
-        szClipboard.clear(); // dont return a partial html fragment...
+        const auto& first = selectionRects.front();
+        background = gci.LookupBackgroundColor(buffer.GetRowByOffset(first.Top).GetAttrRow().GetAttrByColumn(first.Left));
     }
 
-    return szClipboard;
+    const auto& fontData = screenInfo.GetCurrentFont();
+    const int fontHeightPoints = fontData.GetUnscaledSize().Y * 72 / ServiceLocator::LocateGlobals().dpi;
+
+    FormattedTextSink sink{ gci, expectedChars, alsoFormats, background, fontData.GetFaceName(), fontHeightPoints };
+    buffer.ForEachSelectedTextRun(lineSelection, trimTrailingWhitespace, selectionRects, sink);
+    return sink.Finish();
 }
 
 // Routine Description:
-// - Copies the text given onto the global system clipboard.
+// - Copies the text given onto the global system clipboard, along with its HTML and RTF if it has them.
 // Arguments:
-// - rows - Rows of text data to copy
-void Clipboard::CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows, bool const fAlsoCopyHtml)
+// - text - the text to copy, as made by RetrieveFormattedText
+void Clipboard::CopyTextToSystemClipboard(const FormattedText& text)
 {
-    std::wstring finalString;
-
-    // Concatenate strings into one giant string to put onto the clipboard.
-    for (const auto& str : rows.text)
-    {
-        finalString += str;
-    }
-
     // allocate the final clipboard data
-    const size_t cchNeeded = finalString.size() + 1;
+    const size_t cchNeeded = text.text.size() + 1;
     const size_t cbNeeded = sizeof(wchar_t) * cchNeeded;
     wil::unique_hglobal globalHandle(GlobalAlloc(GMEM_MOVEABLE | GMEM_DDESHARE, cbNeeded));
     THROW_LAST_ERROR_IF_NULL(globalHandle.get());
@@ -504,7 +694,7 @@ void Clipboard::CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows,
 
     // The pattern gets a bit strange here because there's no good wil built-in for global lock of this type.
     // Try to copy then immediately unlock. Don't throw until after (so the hglobal won't be freed until we unlock).
-    const HRESULT hr = StringCchCopyW(pwszClipboard, cchNeeded, finalString.data());
+    const HRESULT hr = StringCchCopyW(pwszClipboard, cchNeeded, text.text.data());
     GlobalUnlock(globalHandle.get());
     THROW_IF_FAILED(hr);
 
@@ -513,37 +703,46 @@ void Clipboard::CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows,
     THROW_LAST_ERROR_IF(!EmptyClipboard());
     THROW_LAST_ERROR_IF_NULL(SetClipboardData(CF_UNICODETEXT, globalHandle.get()));
 
-    if (fAlsoCopyHtml)
-    {
-        std::string HTMLToPlaceOnClip = GenHTML(rows);
-        const size_t cbNeededHTML = HTMLToPlaceOnClip.size();
-        if (cbNeededHTML)
-        {
-            wil::unique_hglobal globalHandleHTML(GlobalAlloc(GMEM_MOVEABLE | GMEM_DDESHARE, cbNeededHTML));
-            THROW_LAST_ERROR_IF_NULL(globalHandleHTML.get());
+    CopyFormatToSystemClipboard(text.html, L"HTML Format");
+    CopyFormatToSystemClipboard(text.rtf, L"Rich Text Format");
 
-            PSTR pszClipboardHTML = (PSTR)GlobalLock(globalHandleHTML.get());
-            THROW_LAST_ERROR_IF_NULL(pszClipboardHTML);
+    THROW_LAST_ERROR_IF(!CloseClipboard());
 
-            // The pattern gets a bit strange here because there's no good wil built-in for global lock of this type.
-            // Try to copy then immediately unlock. Don't throw until after (so the hglobal won't be freed until we unlock).
-            const HRESULT hr2 = StringCchCopyA(pszClipboardHTML, cbNeededHTML, HTMLToPlaceOnClip.data());
-            GlobalUnlock(globalHandleHTML.get());
-            THROW_IF_FAILED(hr2);
+    // only free if we failed.
+    // the memory has to remain allocated if we successfully placed it on the clipboard.
+    // Releasing the smart pointer will leave it allocated as we exit scope.
+    globalHandle.release();
+}
 
-            UINT const CF_HTML = RegisterClipboardFormatW(L"HTML Format");
-            THROW_LAST_ERROR_IF(0 == CF_HTML);
+// Routine Description:
+// - Places one more format of the text onto the clipboard, which has to be open already.
+// Arguments:
+// - data - the null terminated data of the format. Nothing is placed if it's empty.
+// - formatName - the name the format is registered under
+void Clipboard::CopyFormatToSystemClipboard(const std::string& data, const PCWSTR formatName)
+{
+    const size_t cbNeeded = data.size();
+    if (cbNeeded == 0)
+    {
+        return;
+    }
 
-            THROW_LAST_ERROR_IF_NULL(SetClipboardData(CF_HTML, globalHandleHTML.get()));
+    wil::unique_hglobal globalHandle(GlobalAlloc(GMEM_MOVEABLE | GMEM_DDESHARE, cbNeeded));
+    THROW_LAST_ERROR_IF_NULL(globalHandle.get());
 
-            // only free if we failed.
-            // the memory has to remain allocated if we successfully placed it on the clipboard.
-            // Releasing the smart pointer will leave it allocated as we exit scope.
-            globalHandleHTML.release();
-        }
-    }
+    PSTR pszClipboard = (PSTR)GlobalLock(globalHandle.get());
+    THROW_LAST_ERROR_IF_NULL(pszClipboard);
 
-    THROW_LAST_ERROR_IF(!CloseClipboard());
+    // The pattern gets a bit strange here because there's no good wil built-in for global lock of this type.
+    // Try to copy then immediately unlock. Don't throw until after (so the hglobal won't be freed until we unlock).
+    const HRESULT hr = StringCchCopyA(pszClipboard, cbNeeded, data.data());
+    GlobalUnlock(globalHandle.get());
+    THROW_IF_FAILED(hr);
+
+    UINT const format = RegisterClipboardFormatW(formatName);
+    THROW_LAST_ERROR_IF(0 == format);
+
+    THROW_LAST_ERROR_IF_NULL(SetClipboardData(format, globalHandle.get()));
 
     // only free if we failed.
     // the memory has to remain allocated if we successfully placed it on the clipboard.
@@ -551,52 +750,133 @@ void Clipboard::CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows,
     globalHandle.release();
 }
 
-// Returns true if the character should be emitted to the paste stream
-// -- in some cases, we will change what character should be emitted, as in the case of "smart quotes"
-// Returns false if the character should not be emitted (e.g. <TAB>)
-bool Clipboard::FilterCharacterOnPaste(_Inout_ WCHAR* const pwch)
+// Routine Description:
+// - Finds the first character that the paste filters in FilterPastedText might do something about.
+//   Printable ASCII never is, so everything before it can be copied over as it is.
+// - On x86/x64, eight characters are checked at a time.
+// Arguments:
+// - pwch - The string to search.
+// - cch - The number of characters in the string.
+// Return Value:
+// - The index of the first character that isn't printable ASCII, or cch if there's none.
+size_t Clipboard::s_FindFilteredChar(const wchar_t* const pwch, const size_t cch) noexcept
 {
-    const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-    bool fAllowChar = true;
-    if (gci.GetFilterOnPaste() &&
-        (WI_IsFlagSet(gci.pInputBuffer->InputMode, ENABLE_PROCESSED_INPUT)))
+    size_t i = 0;
+
+#if (defined(_M_IX86) || defined(_M_AMD64))
+    static_assert(sizeof(wchar_t) == sizeof(uint16_t));
+
+    const auto lastControl = _mm_set1_epi16(static_cast<short>(UNICODE_SPACE - 1));
+    const auto lastPrintable = _mm_set1_epi16(static_cast<short>(L'~'));
+    for (; i + 8 <= cch; i += 8)
     {
-        switch (*pwch)
-        {
-            // swallow tabs to prevent inadvertant tab expansion
-        case UNICODE_TAB:
+        const auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pwch + i));
+
+        // A saturating subtract only leaves zero behind for characters at or below what's subtracted.
+        const auto isControl = _mm_cmpeq_epi16(_mm_subs_epu16(chars, lastControl), _mm_setzero_si128());
+        const auto isPrintableOrBelow = _mm_cmpeq_epi16(_mm_subs_epu16(chars, lastPrintable), _mm_setzero_si128());
+        if (_mm_movemask_epi8(isControl) != 0 || _mm_movemask_epi8(isPrintableOrBelow) != 0xFFFF)
         {
-            fAllowChar = false;
+            // One of these eight isn't printable ASCII. The loop below will find which.
             break;
         }
+    }
+#endif
 
-        // Replace Unicode space with standard space
-        case UNICODE_NBSP:
-        case UNICODE_NARROW_NBSP:
+    for (; i < cch; ++i)
+    {
+        if (pwch[i] < UNICODE_SPACE || pwch[i] > L'~')
         {
-            *pwch = UNICODE_SPACE;
-            break;
+            return i;
         }
+    }
+    return cch;
+}
 
-        // Replace "smart quotes" with "dumb ones"
-        case UNICODE_LEFT_SMARTQUOTE:
-        case UNICODE_RIGHT_SMARTQUOTE:
+// Routine Description:
+// - Applies everything that changes pasted text on its way into the input buffer, to the whole text at once:
+//   - if the console filters pastes, tabs are dropped to prevent inadvertent tab expansion, and
+//     Unicode spaces, "smart quotes" and dashes are replaced with their plain ASCII versions.
+//   - a linefeed right after a carriage return is dropped
+//   - the text ends at the first null
+//   - in VT input mode, linefeeds become carriage returns
+// Arguments:
+// - text - the pasted text
+// Return Value:
+// - the text as it should be typed
+std::wstring Clipboard::FilterPastedText(const std::wstring_view text) const
+{
+    const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    const bool filterOnPaste = gci.GetFilterOnPaste() && WI_IsFlagSet(gci.pInputBuffer->InputMode, ENABLE_PROCESSED_INPUT);
+    const bool vtInputMode = IsInVirtualTerminalInputMode();
+
+    std::wstring filtered;
+    filtered.reserve(text.size());
+
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        const auto plain = s_FindFilteredChar(text.data() + i, text.size() - i);
+        filtered.append(text.data() + i, plain);
+        i += plain;
+        if (i == text.size())
         {
-            *pwch = UNICODE_QUOTE;
             break;
         }
 
-        // Replace Unicode dashes with a standard hypen
-        case UNICODE_EM_DASH:
-        case UNICODE_EN_DASH:
+        wchar_t ch = text[i];
+        if (filterOnPaste)
+        {
+            switch (ch)
+            {
+            case UNICODE_TAB:
+                continue;
+
+            case UNICODE_NBSP:
+            case UNICODE_NARROW_NBSP:
+                ch = UNICODE_SPACE;
+                break;
+
+            case UNICODE_LEFT_SMARTQUOTE:
+            case UNICODE_RIGHT_SMARTQUOTE:
+                ch = UNICODE_QUOTE;
+                break;
+
+            case UNICODE_EM_DASH:
+            case UNICODE_EN_DASH:
+                ch = UNICODE_HYPHEN;
+                break;
+            }
+        }
+
+        if (ch == UNICODE_LINEFEED && i != 0 && text[i - 1] == UNICODE_CARRIAGERETURN)
+        {
+            continue;
+        }
+
+        if (ch == UNICODE_NULL)
         {
-            *pwch = UNICODE_HYPHEN;
             break;
         }
+
+        // MSFT:12123975 / WSL GH#2006
+        // If you paste text with ONLY linefeed line endings (unix style) in wsl,
+        //      then we faithfully pass those along, which the underlying terminal
+        //      interprets as C-j. In nano, C-j is mapped to "Justify text", which
+        //      causes the pasted text to get broken at the width of the terminal.
+        // This behavior doesn't occur in gnome-terminal, and nothing like it occurs
+        //      in vi or emacs.
+        // This change doesn't break pasting text into any of those applications
+        //      with CR/LF (Windows) line endings either. That apparently always
+        //      worked right.
+        if (vtInputMode && ch == UNICODE_LINEFEED)
+        {
+            ch = UNICODE_CARRIAGERETURN;
         }
+
+        filtered.push_back(ch);
     }
 
-    return fAllowChar;
+    return filtered;
 }
 
 #pragma endregion
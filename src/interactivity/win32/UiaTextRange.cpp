@@ -22,6 +22,9 @@ using namespace Microsoft::Console::Interactivity;
 
 IdType UiaTextRange::id = 1;
 
+std::unordered_map<UnicodeStorage::row_key_type, UiaTextRange::RowText> UiaTextRange::s_rowTextCache;
+const TextBuffer* UiaTextRange::s_rowTextCacheBuffer = nullptr;
+
 UiaTextRange::MoveState::MoveState(const UiaTextRange& range,
                                    const MovementDirection direction) :
     StartScreenInfoRow{ UiaTextRange::_endpointToScreenInfoRow(range.GetStart()) },
@@ -770,18 +773,23 @@ IFACEMETHODIMP UiaTextRange::GetText(_In_ int maxLength, _Out_ BSTR* pRetVal)
                     // wouldn't be any text to grab.
                     if (startIndex < endIndex)
                     {
-                        wstr += row.GetText().substr(startIndex, endIndex - startIndex);
+                        auto text = _getRowText(textBuffer, row).substr(startIndex, endIndex - startIndex);
+                        if (getPartialText)
+                        {
+                            text = text.substr(0, static_cast<size_t>(maxLength) - wstr.size());
+                        }
+                        wstr += text;
                     }
                 }
 
                 if (currentScreenInfoRow != endScreenInfoRow)
                 {
-                    wstr += L"\r\n";
+                    wstr += std::wstring_view{ L"\r\n" }.substr(0, getPartialText ? static_cast<size_t>(maxLength) - wstr.size() : 2);
                 }
 
-                if (getPartialText && wstr.size() > static_cast<size_t>(maxLength))
+                // there's no need to look at the rest of the rows once we have as much text as was asked for.
+                if (getPartialText && wstr.size() >= static_cast<size_t>(maxLength))
                 {
-                    wstr.resize(maxLength);
                     break;
                 }
             }
@@ -1195,6 +1203,38 @@ IFACEMETHODIMP UiaTextRange::GetChildren(_Outptr_result_maybenull_ SAFEARRAY** p
 
 #pragma endregion
 
+// Routine Description:
+// - Gets the text of a row, reading it out of the buffer only if the row
+//   changed since it was last read.
+// Arguments:
+// - textBuffer - the buffer that the row belongs to
+// - row - the row to get the text of
+// Return Value:
+// - the text of the row. It's valid until the next call.
+std::wstring_view UiaTextRange::_getRowText(const TextBuffer& textBuffer, const ROW& row)
+{
+    // The storage keys only mean something within one buffer (e.g. the alternate buffer has its own).
+    if (&textBuffer != s_rowTextCacheBuffer)
+    {
+        s_rowTextCache.clear();
+        s_rowTextCacheBuffer = &textBuffer;
+    }
+
+    auto& rowText = s_rowTextCache[row.GetStorageKey()];
+    if (rowText.width != row.size() || rowText.generation != row.GetGeneration())
+    {
+        // Refill the text in place, so that a row that's read again reuses what it had.
+        rowText.text.clear();
+        for (const auto glyph : row.Glyphs())
+        {
+            rowText.text.append(glyph);
+        }
+        rowText.width = row.size();
+        rowText.generation = row.GetGeneration();
+    }
+    return rowText.text;
+}
+
 // Routine Description:
 // - Gets the current viewport
 // Arguments:
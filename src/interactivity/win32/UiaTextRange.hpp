@@ -24,6 +24,7 @@ Author(s):
 
 #include <deque>
 #include <tuple>
+#include <unordered_map>
 
 #ifdef UNIT_TESTING
 class UiaTextRangeTests;
@@ -264,6 +265,20 @@ namespace Microsoft::Console::Interactivity::Win32
         // then both endpoints will contain the same value.
         bool _degenerate;
 
+        // The text of the rows that GetText has read, keyed by their storage key (which stays
+        // with a row wherever it moves). A row is read again once its generation moves on.
+        // Only touched with the console locked.
+        struct RowText
+        {
+            std::wstring text;
+            size_t width = 0; // width of the row when its text was read
+            uint64_t generation = 0; // generation of the row when its text was read
+        };
+        static std::unordered_map<UnicodeStorage::row_key_type, RowText> s_rowTextCache;
+        static const TextBuffer* s_rowTextCacheBuffer; // the buffer that the cached rows were read from
+
+        static std::wstring_view _getRowText(const TextBuffer& textBuffer, const ROW& row);
+
         static const Microsoft::Console::Types::Viewport& _getViewport();
         static HWND _getWindowHandle();
         static IConsoleWindow* const _getIConsoleWindow();
@@ -51,15 +51,49 @@ RECT WindowMetrics::GetMinClientRectInPixels()
 // - RECT of client area positions in pixels.
 RECT WindowMetrics::GetMaxClientRectInPixels()
 {
+    unsigned int generation;
+    {
+        std::lock_guard<std::mutex> lock{ _maxClientRectLock };
+        if (_maxClientRectValid)
+        {
+            return _maxClientRect;
+        }
+        generation = _maxClientRectGeneration;
+    }
+
     // This will retrieve the outer window rect. We need the client area to calculate characters.
     RECT rc = GetMaxWindowRectInPixels();
 
     // convert to client rect
     ConvertWindowRectToClientRect(&rc);
 
+    // Don't keep it if something changed while we were working it out.
+    {
+        std::lock_guard<std::mutex> lock{ _maxClientRectLock };
+        if (generation == _maxClientRectGeneration)
+        {
+            _maxClientRect = rc;
+            _maxClientRectValid = true;
+        }
+    }
+
     return rc;
 }
 
+// Routine Description:
+// - Lets go of the max client rect we've kept, so that it's worked out again next time
+//   it's asked for. Called whenever something it depends on may have changed.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void WindowMetrics::InvalidateMaxClientRect()
+{
+    std::lock_guard<std::mutex> lock{ _maxClientRectLock };
+    _maxClientRectValid = false;
+    _maxClientRectGeneration++;
+}
+
 // Routine Description:
 // - Gets the maximum possible window rectangle in pixels. Based on the monitor the window is on or the primary monitor if no window exists yet.
 // Arguments:
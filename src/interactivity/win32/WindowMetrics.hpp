@@ -14,6 +14,8 @@ Author(s):
 
 #include "..\inc\IWindowMetrics.hpp"
 
+#include <mutex>
+
 namespace Microsoft::Console::Interactivity::Win32
 {
     class WindowMetrics final : public IWindowMetrics
@@ -41,7 +43,18 @@ namespace Microsoft::Console::Interactivity::Win32
         void ConvertClientRectToWindowRect(_Inout_ RECT* const prc);
         void ConvertWindowRectToClientRect(_Inout_ RECT* const prc);
 
+        void InvalidateMaxClientRect();
+
     private:
+        // The max client rect is asked for by every GetConsoleScreenBufferInfo call, and
+        // working it out takes several calls into the window manager, so it's kept until
+        // the window moves or the monitor, DPI or fullscreen state changes. It's asked for
+        // on the API thread and invalidated on the window thread, hence the lock.
+        std::mutex _maxClientRectLock;
+        RECT _maxClientRect{};
+        bool _maxClientRectValid{ false };
+        unsigned int _maxClientRectGeneration{ 0 };
+
         enum ConvertRectangle
         {
             CLIENT_TO_WINDOW,
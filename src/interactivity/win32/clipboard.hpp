@@ -34,9 +34,20 @@ namespace Microsoft::Console::Interactivity::Win32
                          const size_t cchData);
         void Paste();
 
+        // The selected text, with the versions of it for the other clipboard formats.
+        struct FormattedText
+        {
+            std::wstring text;
+            std::string html; // CF_HTML
+            std::string rtf;
+        };
+
     private:
         std::deque<std::unique_ptr<IInputEvent>> TextToKeyEvents(_In_reads_(cchData) const wchar_t* const pData,
                                                                  const size_t cchData);
+        std::vector<INPUT_RECORD> TextToInputRecords(_In_reads_(cchData) const wchar_t* const pData,
+                                                     const size_t cchData);
+        std::vector<INPUT_RECORD> FilteredTextToInputRecords(const std::wstring_view text);
 
         void StoreSelectionToClipboard(_In_ bool const fAlsoCopyHtml);
 
@@ -44,11 +55,15 @@ namespace Microsoft::Console::Interactivity::Win32
                                                         const bool lineSelection,
                                                         const std::vector<SMALL_RECT>& selectionRects);
 
-        void CopyHTMLToClipboard(const TextBuffer::TextAndColor& rows);
-        std::string GenHTML(const TextBuffer::TextAndColor& rows);
-        void CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows, _In_ bool const fAlsoCopyHtml);
+        FormattedText RetrieveFormattedText(const SCREEN_INFORMATION& screenInfo,
+                                            const bool lineSelection,
+                                            const std::vector<SMALL_RECT>& selectionRects,
+                                            const bool alsoFormats);
+        void CopyTextToSystemClipboard(const FormattedText& text);
+        void CopyFormatToSystemClipboard(const std::string& data, const PCWSTR formatName);
 
-        bool FilterCharacterOnPaste(_Inout_ WCHAR* const pwch);
+        std::wstring FilterPastedText(const std::wstring_view text) const;
+        static size_t s_FindFilteredChar(const wchar_t* const pwch, const size_t cch) noexcept;
 
 #ifdef UNIT_TESTING
         friend class ClipboardTests;
@@ -44,6 +44,7 @@ INT_PTR CALLBACK FindDialogProc(HWND hWnd, UINT Message, WPARAM wParam, LPARAM l
             }
             bool const IgnoreCase = IsDlgButtonChecked(hWnd, ID_CONSOLE_FINDCASE) == 0;
             bool const Reverse = IsDlgButtonChecked(hWnd, ID_CONSOLE_FINDDOWN) == 0;
+            bool const RegularExpression = IsDlgButtonChecked(hWnd, ID_CONSOLE_FINDREGEX) != 0;
             fFindSearchUp = !!Reverse;
             SCREEN_INFORMATION& ScreenInfo = gci.GetActiveOutputBuffer();
 
@@ -52,22 +53,37 @@ INT_PTR CALLBACK FindDialogProc(HWND hWnd, UINT Message, WPARAM wParam, LPARAM l
             LockConsole();
             auto Unlock = wil::scope_exit([&] { UnlockConsole(); });
 
-            Search search(ScreenInfo,
-                          wstr,
-                          Reverse ? Search::Direction::Backward : Search::Direction::Forward,
-                          IgnoreCase ? Search::Sensitivity::CaseInsensitive : Search::Sensitivity::CaseSensitive);
-
-            if (search.FindNext())
+            bool found = false;
+            try
             {
-                Telemetry::Instance().LogFindDialogNextClicked(StringLength, (Reverse != 0), (IgnoreCase == 0));
-                search.Select();
-                return TRUE;
+                Search search(ScreenInfo,
+                              wstr,
+                              Reverse ? Search::Direction::Backward : Search::Direction::Forward,
+                              IgnoreCase ? Search::Sensitivity::CaseInsensitive : Search::Sensitivity::CaseSensitive,
+                              RegularExpression ? Search::Syntax::RegularExpression : Search::Syntax::Literal);
+                if (search.FindNext())
+                {
+                    Telemetry::Instance().LogFindDialogNextClicked(StringLength, (Reverse != 0), (IgnoreCase == 0));
+                    search.Select();
+                    found = true;
+                }
             }
-            else
+            catch (const std::regex_error&)
             {
-                // The string wasn't found.
-                ScreenInfo.SendNotifyBeep();
+                // The expression didn't compile, or was too complex to match against the text.
             }
+            catch (...)
+            {
+                LOG_CAUGHT_EXCEPTION();
+            }
+
+            if (found)
+            {
+                return TRUE;
+            }
+
+            // The string wasn't found, or couldn't be looked for.
+            ScreenInfo.SendNotifyBeep();
             break;
         }
         case IDCANCEL:
@@ -128,7 +128,9 @@ Window::~Window()
         // Prepare window class structure
         WNDCLASSEX wc = { 0 };
         wc.cbSize = sizeof(WNDCLASSEX);
-        wc.style = CS_HREDRAW | CS_VREDRAW | CS_OWNDC | CS_DBLCLKS;
+        // No CS_HREDRAW or CS_VREDRAW. The contents are anchored to the top left, so on a resize
+        // only the area that's newly exposed needs to be painted, not the whole window.
+        wc.style = CS_OWNDC | CS_DBLCLKS;
         wc.lpfnWndProc = s_ConsoleWindowProc;
         wc.cbClsExtra = 0;
         wc.cbWndExtra = GWL_CONSOLE_WNDALLOC;
@@ -179,6 +181,9 @@ void Window::_UpdateSystemMetrics() const
     const auto sysConfig = ServiceLocator::LocateSystemConfigurationProvider();
 
     g.cursorPixelWidth = sysConfig->GetCursorWidth();
+
+    // The work area, DPI or monitors may have changed along with the metrics.
+    ServiceLocator::LocateWindowMetrics<WindowMetrics>()->InvalidateMaxClientRect();
 }
 
 // Routine Description:
@@ -228,6 +233,7 @@ void Window::_UpdateSystemMetrics() const
         {
             pGdiEngine = new GdiEngine();
             g.pRender->AddRenderEngine(pGdiEngine);
+            _pGdiEngine = pGdiEngine;
         }
     }
     catch (...)
@@ -1097,6 +1103,9 @@ void Window::SetIsFullscreen(const bool fFullscreenEnabled)
     bool fOldIsInFullscreen = _fIsInFullscreen;
     _fIsInFullscreen = fFullscreenEnabled;
 
+    // Fullscreen windows can use the whole monitor, rather than only its work area.
+    ServiceLocator::LocateWindowMetrics<WindowMetrics>()->InvalidateMaxClientRect();
+
     HWND const hWnd = GetWindowHandle();
 
     // First, modify regular window styles as appropriate
@@ -1303,11 +1312,124 @@ IRawElementProviderSimple* Window::_GetUiaProvider()
 {
     if (_pUiaProvider != nullptr)
     {
+        if (id == UIA_Text_TextChangedEventId)
+        {
+            return _SignalUiaTextChanged();
+        }
         return _pUiaProvider->Signal(id);
     }
     return S_FALSE;
 }
 
+// Routine Description:
+// - Tells UIA clients that the text changed, no more often than the settings allow.
+// - A change that comes in too soon after the last event was sent is held back on a
+//   timer. Any other changes before the timer goes off are covered by the same event.
+// Return Value:
+// - S_FALSE if nobody is listening, otherwise the result of sending or holding back the event.
+[[nodiscard]] HRESULT Window::_SignalUiaTextChanged()
+{
+    // Each event makes the clients call back in to read the text, under the console lock.
+    // There's no point in paying for that when there aren't any.
+    if (!UiaClientsAreListening())
+    {
+        return S_FALSE;
+    }
+
+    if (_uiaTextChangedPending)
+    {
+        return S_OK;
+    }
+
+    const ULONGLONG now = GetTickCount64();
+    const DWORD maxRate = _pSettings->GetUiaTextChangedMaxRate();
+    if (maxRate != 0)
+    {
+        const ULONGLONG interval = std::max<ULONGLONG>(1000 / maxRate, 1);
+        const ULONGLONG elapsed = now - _lastUiaTextChanged;
+        if (elapsed < interval &&
+            SetTimer(GetWindowHandle(), s_UiaTextChangedTimerId, gsl::narrow_cast<UINT>(interval - elapsed), nullptr) != 0)
+        {
+            _uiaTextChangedPending = true;
+            return S_OK;
+        }
+    }
+
+    _lastUiaTextChanged = now;
+    return _pUiaProvider->Signal(UIA_Text_TextChangedEventId);
+}
+
+// Routine Description:
+// - Sends the text changed event that was held back by _SignalUiaTextChanged.
+void Window::_UiaTextChangedTimerRoutine()
+{
+    KillTimer(GetWindowHandle(), s_UiaTextChangedTimerId);
+    _uiaTextChangedPending = false;
+    LOG_IF_FAILED(SignalUia(UIA_Text_TextChangedEventId));
+}
+
+// Routine Description:
+// - Starts watching for the window to go idle, now that it's lost focus or been minimized.
+void Window::_StartIdleTrimTimer()
+{
+    _idleTrimGeneration = s_IdleTrimNoGeneration;
+    _idleTrimmed = false;
+    LOG_LAST_ERROR_IF(SetTimer(GetWindowHandle(), s_IdleTrimTimerId, s_IdleTrimIntervalMilliseconds, nullptr) == 0);
+}
+
+// Routine Description:
+// - Stops watching for the window to go idle, now that it's being used again.
+// - Nothing that was trimmed is brought back here. It comes back as it's needed.
+void Window::_StopIdleTrimTimer()
+{
+    KillTimer(GetWindowHandle(), s_IdleTrimTimerId);
+}
+
+// Routine Description:
+// - Trims what the console holds once a whole interval passed without output:
+//   1. the rows of the scrollback are packed and the spare row storage is let go, then
+//   2. if the window is minimized, the GDI engine gives up its memory bitmap, then
+//   3. the process' working set is emptied, so the pages that were freed leave with it.
+void Window::_IdleTrimTimerRoutine()
+{
+    {
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        gci.LockConsole();
+        auto unlock = wil::scope_exit([&] { gci.UnlockConsole(); });
+
+        auto& screenInfo = GetScreenInfo();
+        auto& textBuffer = screenInfo.GetTextBuffer();
+        const auto generation = textBuffer.GetGeneration();
+        if (generation != _idleTrimGeneration)
+        {
+            // There was output since the last tick (or this is the first one). Wait out another interval.
+            _idleTrimGeneration = generation;
+            _idleTrimmed = false;
+            return;
+        }
+
+        if (_idleTrimmed || WI_IsFlagSet(gci.Flags, CONSOLE_HAS_FOCUS))
+        {
+            return;
+        }
+        _idleTrimmed = true;
+
+        try
+        {
+            textBuffer.CompactColdRows(screenInfo.GetViewport().Top());
+        }
+        CATCH_LOG();
+
+        if (_pGdiEngine && IsIconic(GetWindowHandle()))
+        {
+            LOG_IF_FAILED(_pGdiEngine->ReleaseMemorySurface());
+        }
+    }
+
+    // Each conhost serves a single console, so the whole process is ours to trim.
+    LOG_IF_WIN32_BOOL_FALSE(SetProcessWorkingSetSize(GetCurrentProcess(), static_cast<SIZE_T>(-1), static_cast<SIZE_T>(-1)));
+}
+
 [[nodiscard]] HRESULT Window::UiaSetTextAreaFocus()
 {
     if (_pUiaProvider != nullptr)
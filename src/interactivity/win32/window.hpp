@@ -16,6 +16,11 @@ Author(s):
 
 #include "..\inc\IConsoleWindow.hpp"
 
+namespace Microsoft::Console::Render
+{
+    class GdiEngine;
+}
+
 namespace Microsoft::Console::Interactivity::Win32
 {
     class WindowUiaProvider;
@@ -73,9 +78,13 @@ namespace Microsoft::Console::Interactivity::Win32
         BOOL SendNotifyBeep() const;
 
         BOOL PostUpdateScrollBars() const;
+        BOOL PostUpdateAccessibility() const;
         BOOL PostUpdateWindowSize() const;
         BOOL PostUpdateExtendedEditKeys() const;
 
+        BOOL SetCursorBlinkTimer(const UINT uElapse);
+        BOOL KillCursorBlinkTimer();
+
         [[nodiscard]] HRESULT SignalUia(_In_ EVENTID id);
 
         void SetOwner();
@@ -107,6 +116,33 @@ namespace Microsoft::Console::Interactivity::Win32
         HWND _hWnd;
         static Window* s_Instance;
 
+        // Blinks the cursor.
+        static constexpr UINT_PTR s_CursorBlinkTimerId = 1;
+        // Sends the text changed event that was held back to keep under the UIA event rate.
+        static constexpr UINT_PTR s_UiaTextChangedTimerId = 2;
+
+        ULONGLONG _lastUiaTextChanged = 0; // tick count when the last text changed event was sent
+        bool _uiaTextChangedPending = false; // whether s_UiaTextChangedTimerId is running
+
+        [[nodiscard]] HRESULT _SignalUiaTextChanged();
+        void _UiaTextChangedTimerRoutine();
+
+        // Gives back memory while the window is minimized or in the background and no output comes in.
+        // The timer runs for as long as the window doesn't have focus. A trim is made once a whole
+        // interval passed without the buffer changing, and not again until there was more output.
+        static constexpr UINT_PTR s_IdleTrimTimerId = 3;
+        static constexpr UINT s_IdleTrimIntervalMilliseconds = 30000;
+        static constexpr uint64_t s_IdleTrimNoGeneration = std::numeric_limits<uint64_t>::max();
+
+        uint64_t _idleTrimGeneration = s_IdleTrimNoGeneration; // buffer generation at the last tick
+        bool _idleTrimmed = false; // whether the buffer was trimmed at _idleTrimGeneration
+
+        Microsoft::Console::Render::GdiEngine* _pGdiEngine = nullptr; // Non-ownership pointer, null when drawing with DX
+
+        void _StartIdleTrimTimer();
+        void _StopIdleTrimTimer();
+        void _IdleTrimTimerRoutine();
+
         [[nodiscard]] NTSTATUS _InternalSetWindowSize();
         void _UpdateWindowSize(const SIZE sizeNew);
 
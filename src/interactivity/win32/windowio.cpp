@@ -281,6 +281,8 @@ void HandleKeyEvent(const HWND hWnd,
                 return;
             case 'F':
                 // the user is asking to go to the find window
+                // The dialog's keys don't come through here, so readers must not be held off while it's up.
+                EndKeyboardWakeUpDeferral();
                 DoFind();
                 *pfUnlockConsole = FALSE;
                 return;
@@ -449,6 +451,56 @@ void HandleKeyEvent(const HWND hWnd,
     HandleGenericKeyEvent(keyEvent, generateBreak);
 }
 
+// Set while readers aren't woken for each key, because more keyboard messages were queued.
+// Only used on the window thread, with the console lock held.
+static bool s_fKeyboardWakeUpsDeferred = false;
+
+// Routine Description:
+// - Called after a keyboard message was handled. If more keyboard messages are already queued
+//   behind it, like the WM_CHAR that translating a key posts or the keys of a fast typist or of
+//   auto-repeat, readers aren't woken for each of them: they're woken once, after the last one.
+// Arguments:
+// - hWnd - the window the keyboard messages are for
+// Return Value:
+// - <none>
+// Note:
+// - The console lock must be held when calling this routine.
+void DeferWakeUpsWhileKeysAreQueued(const HWND hWnd)
+{
+    // Only posted and input messages are looked at, so that peeking doesn't dispatch sent messages from in here.
+    MSG msg;
+    const bool fKeysQueued = !!PeekMessageW(&msg, hWnd, WM_KEYFIRST, WM_KEYLAST, PM_NOREMOVE | PM_NOYIELD | PM_QS_INPUT | PM_QS_POSTMESSAGE);
+
+    if (fKeysQueued && !s_fKeyboardWakeUpsDeferred)
+    {
+        ServiceLocator::LocateGlobals().getConsoleInformation().pInputBuffer->DeferWakeUps();
+        s_fKeyboardWakeUpsDeferred = true;
+    }
+    else if (!fKeysQueued)
+    {
+        EndKeyboardWakeUpDeferral();
+    }
+}
+
+// Routine Description:
+// - Wakes up the readers that were held off for the keys handled so far, if any were.
+//   Needs to be called before anything that can enter a modal loop, where the rest of the
+//   queued keys might not come through the console's window procedure.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+// Note:
+// - The console lock must be held when calling this routine.
+void EndKeyboardWakeUpDeferral()
+{
+    if (s_fKeyboardWakeUpsDeferred)
+    {
+        s_fKeyboardWakeUpsDeferred = false;
+        ServiceLocator::LocateGlobals().getConsoleInformation().pInputBuffer->ResumeWakeUps();
+    }
+}
+
 // Routine Description:
 // - Returns TRUE if DefWindowProc should be called.
 BOOL HandleSysKeyEvent(const HWND hWnd, const UINT Message, const WPARAM wParam, const LPARAM lParam, _Inout_opt_ PBOOL pfUnlockConsole)
@@ -1001,10 +1053,13 @@ DWORD WINAPI ConsoleInputThreadProcWin32(LPVOID /*lpParameter*/)
     if (!ServiceLocator::LocateGlobals().launchArgs.IsHeadless())
     {
         // If we're not headless, set up the main conhost window.
+        const auto trace = Tracing::s_TraceStartupPhase("CreateWindow");
         Status = InitWindowsSubsystem(&hhook);
     }
     else
     {
+        const auto trace = Tracing::s_TraceStartupPhase("CreatePseudoWindow");
+
         // If we are headless (because we're a pseudo console), we
         // will still need a window handle in the win32 environment
         // in case anyone sends messages at that HWND (vim.exe is an example.)
@@ -14,6 +14,8 @@ void HandleKeyEvent(const HWND hWnd,
                     const WPARAM wParam,
                     const LPARAM lParam,
                     _Inout_opt_ PBOOL pfUnlockConsole);
+void DeferWakeUpsWhileKeysAreQueued(const HWND hWnd);
+void EndKeyboardWakeUpDeferral();
 BOOL HandleSysKeyEvent(const HWND hWnd,
                        const UINT Message,
                        const WPARAM wParam,
@@ -86,6 +86,13 @@ using namespace Microsoft::Console::Types;
         return Status;
     }
 
+    // Readers are only held off while a run of queued keyboard messages is handled. Anything else
+    // might enter a modal loop, so readers are woken for the keys handled so far before it.
+    if (Message != WM_KEYDOWN && Message != WM_KEYUP && Message != WM_CHAR && Message != WM_DEADCHAR)
+    {
+        EndKeyboardWakeUpDeferral();
+    }
+
     switch (Message)
     {
     case WM_CREATE:
@@ -260,6 +267,8 @@ using namespace Microsoft::Console::Types;
 
         gci.Flags |= CONSOLE_HAS_FOCUS;
 
+        _StopIdleTrimTimer();
+
         gci.GetCursorBlinker().FocusStart();
 
         HandleFocusEvent(TRUE);
@@ -288,9 +297,40 @@ using namespace Microsoft::Console::Types;
 
         HandleFocusEvent(FALSE);
 
+        _StartIdleTrimTimer();
+
         break;
     }
 
+    case WM_TIMER:
+    {
+        if (wParam == s_UiaTextChangedTimerId)
+        {
+            _UiaTextChangedTimerRoutine();
+            break;
+        }
+
+        if (wParam == s_IdleTrimTimerId)
+        {
+            _IdleTrimTimerRoutine();
+            break;
+        }
+
+        if (wParam != s_CursorBlinkTimerId)
+        {
+            goto CallDefWin;
+        }
+
+        gci.GetCursorBlinker().TimerRoutine(ScreenInfo);
+        break;
+    }
+
+    case WM_SIZE:
+    {
+        gci.GetCursorBlinker().MinimizedChanged(wParam == SIZE_MINIMIZED);
+        goto CallDefWin;
+    }
+
     case WM_PAINT:
     {
         // Since we handle our own minimized window state, we need to
@@ -464,6 +504,9 @@ using namespace Microsoft::Console::Types;
 
     case WM_WINDOWPOSCHANGED:
     {
+        // The window may have moved onto another monitor.
+        ServiceLocator::LocateWindowMetrics<WindowMetrics>()->InvalidateMaxClientRect();
+
         // Only handle this if the DPI is the same as last time.
         // If the DPI is different, assume we're about to get a DPICHANGED notification
         // which will have a better suggested rectangle than this one.
@@ -524,6 +567,10 @@ using namespace Microsoft::Console::Types;
     case WM_DEADCHAR:
     {
         HandleKeyEvent(hWnd, Message, wParam, lParam, &Unlock);
+        if (Unlock)
+        {
+            DeferWakeUpsWhileKeysAreQueued(hWnd);
+        }
         break;
     }
 
@@ -689,6 +736,12 @@ using namespace Microsoft::Console::Types;
         break;
     }
 
+    case CM_UPDATE_ACCESSIBILITY:
+    {
+        ScreenInfo.InternalNotifyAccessibilityEventing();
+        break;
+    }
+
     case CM_UPDATE_TITLE:
     {
         SetWindowTextW(hWnd, gci.GetTitleAndPrefix().c_str());
@@ -940,9 +993,31 @@ BOOL Window::PostUpdateScrollBars() const
     return PostMessageW(GetWindowHandle(), CM_UPDATE_SCROLL_BARS, (WPARAM)&GetScreenInfo(), 0);
 }
 
+BOOL Window::PostUpdateAccessibility() const
+{
+    return PostMessageW(GetWindowHandle(), CM_UPDATE_ACCESSIBILITY, 0, 0);
+}
+
 BOOL Window::PostUpdateExtendedEditKeys() const
 {
     return PostMessageW(GetWindowHandle(), CM_UPDATE_EDITKEYS, 0, 0);
 }
 
+// Routine Description:
+// - Starts (or restarts) the timer that blinks the cursor. It arrives as a WM_TIMER on
+//   this window's thread, which hands it back to the cursor blinker.
+// Arguments:
+// - uElapse - Time between blinks in milliseconds.
+// Return Value:
+// - TRUE if the timer is running. FALSE otherwise with the last error set.
+BOOL Window::SetCursorBlinkTimer(const UINT uElapse)
+{
+    return SetTimer(GetWindowHandle(), s_CursorBlinkTimerId, uElapse, nullptr) != 0;
+}
+
+BOOL Window::KillCursorBlinkTimer()
+{
+    return KillTimer(GetWindowHandle(), s_CursorBlinkTimerId);
+}
+
 #pragma endregion
@@ -109,6 +109,8 @@ BOOL DoFontEnum(
                                                 _Out_writes_(cchFaceName) PWSTR pszFaceName,
                                                 const size_t cchFaceName);
 
+VOID InvalidateFaceCache(VOID);
+
 bool IsFontSizeCustom(__in PCWSTR pwszFaceName, __in const SHORT sSize);
 void CreateSizeForAllTTFonts(__in const SHORT sSize);
 
@@ -308,6 +308,7 @@ FontDlgProc(
         break;
 
     case WM_FONTCHANGE:
+        InvalidateFaceCache();
         gbEnumerateFaces = TRUE;
         bLB = !TM_IS_TT_FONT(gpStateInfo->FontFamily);
         FontListCreate(hDlg, NULL, TRUE);
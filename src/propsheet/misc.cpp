@@ -21,6 +21,7 @@ Revision History:
 
 #include "precomp.h"
 #include <strsafe.h>
+#include <shlwapi.h>
 #include <ShellScalingAPI.h>
 #pragma hdrstop
 
@@ -36,6 +37,12 @@ ULONG gDebugFlag = 0;
 
 #define TERMINAL_FACENAME L"Terminal"
 
+#define CONSOLE_REGISTRY_FACECACHE (L"FaceCache")
+#define FACECACHE_VERSION 1
+#define FACECACHE_FLAGS (EF_OEMFONT | EF_TTFONT | EF_DBCSFONT)
+
+#define FONTS_REGISTRY_WIN32_PATH (L"Software\\Microsoft\\Windows NT\\CurrentVersion\\Fonts")
+
 /*
  * TTPoints -- Initial font pixel heights for TT fonts
  */
@@ -84,6 +91,34 @@ typedef struct _FONTENUMDATA
     UINT nTTPoints;
 } FONTENUMDATA, *PFONTENUMDATA;
 
+/*
+ * FACECACHE -- the faces that finding faces turned up, kept in the user's
+ * console key so that the next properties dialog, in this console or any
+ * other, doesn't have to go through every font in the system again.
+ *
+ * The header says what the faces were found for. They're only good while
+ * the installed fonts, the console's TrueType font list, and the rules
+ * the faces were picked by stay the same.
+ */
+typedef struct _FACECACHE_HEADER
+{
+    DWORD dwVersion;
+    DWORD dwFilter; // FACECACHE_FILTER_*
+    FILETIME ftSystemFonts; // last write to the fonts installed for everyone
+    FILETIME ftUserFonts; // last write to the fonts installed for this user
+    FILETIME ftTTFontList; // last write to the console's TrueType font list
+    DWORD cFaces;
+} FACECACHE_HEADER, *PFACECACHE_HEADER;
+
+typedef struct _FACECACHE_ENTRY
+{
+    DWORD dwFlag; // FACECACHE_FLAGS of the face
+    WCHAR atch[LF_FACESIZE];
+} FACECACHE_ENTRY, *PFACECACHE_ENTRY;
+
+#define FACECACHE_FILTER_EASTASIAN 0x0001
+#define FACECACHE_FILTER_ALLMONO 0x0002
+
 PFACENODE
 AddFaceNode(
     __in_ecount(LF_FACESIZE) LPCWSTR ptsz)
@@ -119,6 +154,136 @@ AddFaceNode(
     return pNew;
 }
 
+static void GetKeyLastWriteTime(__in HKEY hRoot, __in PCWSTR pszSubKey, __out FILETIME* pft)
+{
+    HKEY hKey;
+
+    RtlZeroMemory(pft, sizeof(*pft));
+    if (RegOpenKeyEx(hRoot, pszSubKey, 0, KEY_QUERY_VALUE, &hKey) == ERROR_SUCCESS)
+    {
+        RegQueryInfoKey(hKey, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, pft);
+        RegCloseKey(hKey);
+    }
+}
+
+// Fills in what the faces found right now would be found for, to tell whether a cache is still good.
+static void GetFaceCacheHeader(__out PFACECACHE_HEADER pHeader)
+{
+    RtlZeroMemory(pHeader, sizeof(*pHeader));
+    pHeader->dwVersion = FACECACHE_VERSION;
+    pHeader->dwFilter = (g_fEastAsianSystem ? FACECACHE_FILTER_EASTASIAN : 0) |
+                        (ShouldAllowAllMonoTTFonts() ? FACECACHE_FILTER_ALLMONO : 0);
+    GetKeyLastWriteTime(HKEY_LOCAL_MACHINE, FONTS_REGISTRY_WIN32_PATH, &pHeader->ftSystemFonts);
+    GetKeyLastWriteTime(HKEY_CURRENT_USER, FONTS_REGISTRY_WIN32_PATH, &pHeader->ftUserFonts);
+    GetKeyLastWriteTime(HKEY_LOCAL_MACHINE, MACHINE_REGISTRY_CONSOLE_TTFONT_WIN32_PATH, &pHeader->ftTTFontList);
+}
+
+/*
+ * Adds the faces in the face cache to gpFaceNames, the same way finding
+ * faces would have. Returns FALSE if there's no cache or it's out of date,
+ * in which case the faces have to be found again.
+ */
+static BOOL LoadFaceCache(VOID)
+{
+    FACECACHE_HEADER Expected;
+    GetFaceCacheHeader(&Expected);
+
+    DWORD dwType;
+    DWORD cb = 0;
+    if (SHGetValue(HKEY_CURRENT_USER, CONSOLE_REGISTRY_STRING, CONSOLE_REGISTRY_FACECACHE, &dwType, NULL, &cb) != ERROR_SUCCESS ||
+        dwType != REG_BINARY ||
+        cb < sizeof(FACECACHE_HEADER))
+    {
+        return FALSE;
+    }
+
+    const auto pb = static_cast<PBYTE>(HeapAlloc(GetProcessHeap(), 0, cb));
+    if (pb == NULL)
+    {
+        return FALSE;
+    }
+
+    BOOL fLoaded = FALSE;
+    const auto pHeader = reinterpret_cast<PFACECACHE_HEADER>(pb);
+    if (SHGetValue(HKEY_CURRENT_USER, CONSOLE_REGISTRY_STRING, CONSOLE_REGISTRY_FACECACHE, &dwType, pb, &cb) == ERROR_SUCCESS &&
+        cb >= sizeof(FACECACHE_HEADER) &&
+        0 == memcmp(pHeader, &Expected, FIELD_OFFSET(FACECACHE_HEADER, cFaces)) &&
+        pHeader->cFaces <= (cb - sizeof(FACECACHE_HEADER)) / sizeof(FACECACHE_ENTRY) &&
+        cb == sizeof(FACECACHE_HEADER) + pHeader->cFaces * sizeof(FACECACHE_ENTRY))
+    {
+        const auto pEntries = reinterpret_cast<PFACECACHE_ENTRY>(pb + sizeof(FACECACHE_HEADER));
+
+        fLoaded = TRUE;
+        for (DWORD i = 0; i < pHeader->cFaces; i++)
+        {
+            pEntries[i].atch[LF_FACESIZE - 1] = L'\0';
+
+            const PFACENODE pFN = AddFaceNode(pEntries[i].atch);
+            if (pFN == NULL)
+            {
+                fLoaded = FALSE;
+                break;
+            }
+
+            DBGFONTS(("CACHED FACE %ls\n", pEntries[i].atch));
+            pFN->dwFlag |= (pEntries[i].dwFlag & FACECACHE_FLAGS) | EF_NEW;
+        }
+    }
+
+    HeapFree(GetProcessHeap(), 0, pb);
+    return fLoaded;
+}
+
+/*
+ * Keeps the faces that finding faces just turned up (the ones marked
+ * EF_NEW in gpFaceNames) in the face cache.
+ */
+static VOID SaveFaceCache(VOID)
+{
+    DWORD cFaces = 0;
+    for (PFACENODE pFN = gpFaceNames; pFN; pFN = pFN->pNext)
+    {
+        if (pFN->dwFlag & EF_NEW)
+        {
+            cFaces++;
+        }
+    }
+
+    const DWORD cb = sizeof(FACECACHE_HEADER) + cFaces * sizeof(FACECACHE_ENTRY);
+    const auto pb = static_cast<PBYTE>(HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, cb));
+    if (pb == NULL)
+    {
+        return;
+    }
+
+    const auto pHeader = reinterpret_cast<PFACECACHE_HEADER>(pb);
+    GetFaceCacheHeader(pHeader);
+    pHeader->cFaces = cFaces;
+
+    auto pEntry = reinterpret_cast<PFACECACHE_ENTRY>(pb + sizeof(FACECACHE_HEADER));
+    for (PFACENODE pFN = gpFaceNames; pFN; pFN = pFN->pNext)
+    {
+        if (pFN->dwFlag & EF_NEW)
+        {
+            pEntry->dwFlag = pFN->dwFlag & FACECACHE_FLAGS;
+            StringCchCopy(pEntry->atch, ARRAYSIZE(pEntry->atch), pFN->atch);
+            pEntry++;
+        }
+    }
+
+    SHSetValue(HKEY_CURRENT_USER, CONSOLE_REGISTRY_STRING, CONSOLE_REGISTRY_FACECACHE, REG_BINARY, pb, cb);
+    HeapFree(GetProcessHeap(), 0, pb);
+}
+
+/*
+ * Throws out the face cache, so that the next time the faces are needed
+ * they're found again. For when we're told the fonts have changed.
+ */
+VOID InvalidateFaceCache(VOID)
+{
+    SHDeleteValue(HKEY_CURRENT_USER, CONSOLE_REGISTRY_STRING, CONSOLE_REGISTRY_FACECACHE);
+}
+
 VOID
     DestroyFaceNodes(
         VOID)
@@ -997,9 +1162,14 @@ EnumerateFonts(
         //
         // Use DoFontEnum to get the names of all the suitable Faces
         // All facenames found will be put in gpFaceNames with
-        // the EF_NEW bit set.
+        // the EF_NEW bit set. That goes through every font in the
+        // system, so what it finds is kept for next time.
         //
-        DoFontEnum(hDC, NULL, TTPoints, 1);
+        if (!LoadFaceCache())
+        {
+            DoFontEnum(hDC, NULL, TTPoints, 1);
+            SaveFaceCache();
+        }
         gbEnumerateFaces = FALSE;
     }
 
@@ -64,7 +64,8 @@ const RegistrySerialization::_RegPropertyMap RegistrySerialization::s_PropertyMa
     { _RegPropertyType::Dword,          CONSOLE_REGISTRY_DEFAULTBACKGROUND,             SET_FIELD_AND_SIZE(_DefaultBackground)           },
     { _RegPropertyType::Boolean,        CONSOLE_REGISTRY_TERMINALSCROLLING,             SET_FIELD_AND_SIZE(_TerminalScrolling)           },
     { _RegPropertyType::Boolean,        CONSOLE_REGISTRY_USEDX,                         SET_FIELD_AND_SIZE(_fUseDx)                      },
-    { _RegPropertyType::Boolean,        CONSOLE_REGISTRY_COPYCOLOR,                     SET_FIELD_AND_SIZE(_fCopyColor)                  }
+    { _RegPropertyType::Boolean,        CONSOLE_REGISTRY_COPYCOLOR,                     SET_FIELD_AND_SIZE(_fCopyColor)                  },
+    { _RegPropertyType::Dword,          CONSOLE_REGISTRY_UIATEXTCHANGEDMAXRATE,         SET_FIELD_AND_SIZE(_dwUiaTextChangedMaxRate)     }
 
 };
 const size_t RegistrySerialization::s_PropertyMappingsSize = ARRAYSIZE(s_PropertyMappings);
@@ -84,12 +85,12 @@ const size_t RegistrySerialization::s_GlobalPropMappingsSize = ARRAYSIZE(s_Globa
 // - Reads number from the registry and applies it to the given property if the value exists
 //   Supports: Dword, Word, Byte, Boolean, and Coordinate
 // Arguments:
-// - hKey - Registry key to read from
+// - values - Values of the registry key to read from
 // - pPropMap - Contains property information to use in looking up/storing value data
 // Return Value:
 // - STATUS_SUCCESSFUL or appropriate NTSTATUS reply for registry operations.
 [[nodiscard]]
-NTSTATUS RegistrySerialization::s_LoadRegDword(const HKEY hKey, const _RegPropertyMap* const pPropMap, _In_ Settings* const pSettings)
+NTSTATUS RegistrySerialization::s_LoadRegDword(const KeyValues& values, const _RegPropertyMap* const pPropMap, _In_ Settings* const pSettings)
 {
     // find offset into destination structure for this numerical value
     PBYTE const pbField = (PBYTE)pSettings + pPropMap->dwFieldOffset;
@@ -97,12 +98,11 @@ NTSTATUS RegistrySerialization::s_LoadRegDword(const HKEY hKey, const _RegProper
     // attempt to load number into this field
     // If we're not successful, it's ok. Just don't fill it.
     DWORD dwValue;
-    NTSTATUS Status = s_QueryValue(hKey,
-                                   pPropMap->pwszValueName,
-                                   sizeof(dwValue),
-                                   ToWin32RegistryType(pPropMap->propertyType),
-                                   (PBYTE)& dwValue,
-                                   nullptr);
+    NTSTATUS Status = values.QueryValue(pPropMap->pwszValueName,
+                                        sizeof(dwValue),
+                                        ToWin32RegistryType(pPropMap->propertyType),
+                                        (PBYTE)& dwValue,
+                                        nullptr);
     if (NT_SUCCESS(Status))
     {
         switch (pPropMap->propertyType)
@@ -145,12 +145,12 @@ NTSTATUS RegistrySerialization::s_LoadRegDword(const HKEY hKey, const _RegProper
 // Routine Description:
 // - Reads string from the registry and applies it to the given property if the value exists
 // Arguments:
-// - hKey - Registry key to read from
+// - values - Values of the registry key to read from
 // - pPropMap - Contains property information to use in looking up/storing value data
 // Return Value:
 // - STATUS_SUCCESSFUL or appropriate NTSTATUS reply for registry operations.
 [[nodiscard]]
-NTSTATUS RegistrySerialization::s_LoadRegString(const HKEY hKey, const _RegPropertyMap* const pPropMap, _In_ Settings* const pSettings)
+NTSTATUS RegistrySerialization::s_LoadRegString(const KeyValues& values, const _RegPropertyMap* const pPropMap, _In_ Settings* const pSettings)
 {
     // find offset into destination structure for this numerical value
     PBYTE const pbField = (PBYTE)pSettings + pPropMap->dwFieldOffset;
@@ -162,12 +162,11 @@ NTSTATUS RegistrySerialization::s_LoadRegString(const HKEY hKey, const _RegPrope
     NTSTATUS Status = NT_TESTNULL(pwchString);
     if (NT_SUCCESS(Status))
     {
-        Status = s_QueryValue(hKey,
-                              pPropMap->pwszValueName,
-                              (DWORD)(cchField) * sizeof(WCHAR),
-                              ToWin32RegistryType(pPropMap->propertyType),
-                              (PBYTE)pwchString,
-                              nullptr);
+        Status = values.QueryValue(pPropMap->pwszValueName,
+                                   (DWORD)(cchField) * sizeof(WCHAR),
+                                   ToWin32RegistryType(pPropMap->propertyType),
+                                   (PBYTE)pwchString,
+                                   nullptr);
         if (NT_SUCCESS(Status))
         {
             // ensure pwchString is null terminated
@@ -182,6 +181,134 @@ NTSTATUS RegistrySerialization::s_LoadRegString(const HKEY hKey, const _RegPrope
     return Status;
 }
 
+// Routine Description:
+// - Reads every value stored directly under the given key, replacing anything loaded before.
+// Arguments:
+// - hKey - Registry key to read from
+// Return Value:
+// - STATUS_SUCCESSFUL or appropriate NTSTATUS reply for registry operations.
+[[nodiscard]]
+NTSTATUS RegistrySerialization::KeyValues::Load(const HKEY hKey)
+{
+    _values.clear();
+
+    DWORD cValues = 0;
+    DWORD cchMaxValueName = 0;
+    DWORD cbMaxValueData = 0;
+    NTSTATUS Status = NTSTATUS_FROM_WIN32(RegQueryInfoKeyW(hKey,
+                                                           nullptr,
+                                                           nullptr,
+                                                           nullptr,
+                                                           nullptr,
+                                                           nullptr,
+                                                           nullptr,
+                                                           &cValues,
+                                                           &cchMaxValueName,
+                                                           &cbMaxValueData,
+                                                           nullptr,
+                                                           nullptr));
+    if (!NT_SUCCESS(Status))
+    {
+        return Status;
+    }
+
+    try
+    {
+        // The longest name doesn't count its terminator.
+        std::wstring name(cchMaxValueName + 1, UNICODE_NULL);
+        std::vector<BYTE> data(cbMaxValueData);
+
+        for (DWORD dwIndex = 0; dwIndex < cValues; dwIndex++)
+        {
+            DWORD cchName = gsl::narrow<DWORD>(name.size());
+            DWORD cbData = gsl::narrow<DWORD>(data.size());
+            DWORD regType = REG_NONE;
+            const LONG Result = RegEnumValueW(hKey,
+                                              dwIndex,
+                                              name.data(),
+                                              &cchName,
+                                              nullptr,
+                                              &regType,
+                                              data.data(),
+                                              &cbData);
+            if (ERROR_NO_MORE_ITEMS == Result)
+            {
+                // Someone removed values since we asked how many there are.
+                break;
+            }
+            else if (ERROR_SUCCESS != Result)
+            {
+                // Skip anything that grew since we measured the key. It will read as missing.
+                LOG_NTSTATUS(NTSTATUS_FROM_WIN32(Result));
+                continue;
+            }
+
+            _values.insert_or_assign(std::wstring(name.data(), cchName),
+                                     Value{ regType, { data.cbegin(), data.cbegin() + cbData } });
+        }
+    }
+    catch (...)
+    {
+        _values.clear();
+        Status = NTSTATUS_FROM_HRESULT(wil::ResultFromCaughtException());
+    }
+
+    return Status;
+}
+
+// Routine Description:
+// - Answers a query for one value the same way s_QueryValue would from the registry key these values were loaded from.
+// Arguments:
+// - pwszValueName - Name of the value to query
+// - cbValueLength - Length of the provided data buffer.
+// - regType - the type of the registry key.
+// - pbData - Pointer to byte stream of data to fill with the registry value data.
+// - pcbDataLength - Number of bytes filled in the given data buffer
+// Return Value:
+// - STATUS_SUCCESSFUL or appropriate NTSTATUS reply for registry operations.
+[[nodiscard]]
+NTSTATUS RegistrySerialization::KeyValues::QueryValue(_In_ PCWSTR const pwszValueName,
+                                                      const DWORD cbValueLength,
+                                                      const DWORD regType,
+                                                      _Out_writes_bytes_(cbValueLength) BYTE* const pbData,
+                                                      _Out_opt_ _Out_range_(0, cbValueLength) DWORD* const pcbDataLength) const
+{
+    const auto found = _values.find(pwszValueName);
+    if (found == _values.cend())
+    {
+        return NTSTATUS_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+    }
+
+    const Value& value = found->second;
+    if (value.regType != regType)
+    {
+        return STATUS_OBJECT_TYPE_MISMATCH;
+    }
+
+    const DWORD cbData = gsl::narrow_cast<DWORD>(value.data.size());
+    if (nullptr != pcbDataLength)
+    {
+        *pcbDataLength = cbData;
+    }
+
+    if (cbData > cbValueLength)
+    {
+        return NTSTATUS_FROM_WIN32(ERROR_MORE_DATA);
+    }
+
+    std::copy(value.data.cbegin(), value.data.cend(), pbData);
+    return STATUS_SUCCESS;
+}
+
+bool RegistrySerialization::KeyValues::NameLess::operator()(const std::wstring& lhs, const std::wstring& rhs) const noexcept
+{
+    return CompareStringOrdinal(lhs.data(),
+                                gsl::narrow_cast<int>(lhs.size()),
+                                rhs.data(),
+                                gsl::narrow_cast<int>(rhs.size()),
+                                TRUE) == CSTR_LESS_THAN;
+}
+
 #pragma region Helpers
 
 // Routine Description:
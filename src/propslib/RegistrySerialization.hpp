@@ -103,6 +103,35 @@ public:
     static const RegPropertyMap s_GlobalPropMappings[];
     static const size_t RegistrySerialization::s_GlobalPropMappingsSize;
 
-    [[nodiscard]] static NTSTATUS s_LoadRegDword(const HKEY hKey, const _RegPropertyMap* const pPropMap, _In_ Settings* const pSettings);
-    [[nodiscard]] static NTSTATUS s_LoadRegString(const HKEY hKey, const _RegPropertyMap* const pPropMap, _In_ Settings* const pSettings);
+    // A copy of all the values stored directly under one key, read in a single pass over the key.
+    // Loading a whole table of properties from it doesn't go back to the registry once per property.
+    class KeyValues
+    {
+    public:
+        [[nodiscard]] NTSTATUS Load(const HKEY hKey);
+
+        [[nodiscard]] NTSTATUS QueryValue(_In_ PCWSTR const pwszValueName,
+                                          const DWORD cbValueLength,
+                                          const DWORD regType,
+                                          _Out_writes_bytes_(cbValueLength) BYTE* const pbData,
+                                          _Out_opt_ _Out_range_(0, cbValueLength) DWORD* const pcbDataLength) const;
+
+    private:
+        struct Value
+        {
+            DWORD regType;
+            std::vector<BYTE> data;
+        };
+
+        // Value names in the registry aren't case sensitive.
+        struct NameLess
+        {
+            bool operator()(const std::wstring& lhs, const std::wstring& rhs) const noexcept;
+        };
+
+        std::map<std::wstring, Value, NameLess> _values;
+    };
+
+    [[nodiscard]] static NTSTATUS s_LoadRegDword(const KeyValues& values, const _RegPropertyMap* const pPropMap, _In_ Settings* const pSettings);
+    [[nodiscard]] static NTSTATUS s_LoadRegString(const KeyValues& values, const _RegPropertyMap* const pPropMap, _In_ Settings* const pSettings);
 };
@@ -0,0 +1,115 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "FrameTracing.hpp"
+
+#pragma hdrstop
+
+TRACELOGGING_DEFINE_PROVIDER(g_hConsoleRendererTraceProvider,
+                             "Microsoft.Windows.Console.Render.Renderer",
+                             // tl:{1c6501c2-0f7b-5e84-d32b-f9e45f9b839a}
+                             (0x1c6501c2, 0x0f7b, 0x5e84, 0xd3, 0x2b, 0xf9, 0xe4, 0x5f, 0x9b, 0x83, 0x9a),
+                             TraceLoggingOptionMicrosoftTelemetry());
+
+using namespace Microsoft::Console::Render;
+
+FrameTracing::FrameTracing() :
+    _llPerformanceFrequency(0)
+{
+    LARGE_INTEGER liFrequency;
+    QueryPerformanceFrequency(&liFrequency);
+    _llPerformanceFrequency = liFrequency.QuadPart;
+
+#ifndef UNIT_TESTING
+    TraceLoggingRegister(g_hConsoleRendererTraceProvider);
+#endif UNIT_TESTING
+}
+
+FrameTracing::~FrameTracing()
+{
+#ifndef UNIT_TESTING
+    TraceLoggingUnregister(g_hConsoleRendererTraceProvider);
+#endif UNIT_TESTING
+}
+
+// Method Description:
+// - Reads the performance counter, to time the steps of a frame with.
+// Arguments:
+// - <none>
+// Return Value:
+// - The current performance counter.
+LONGLONG FrameTracing::Now() const noexcept
+{
+    LARGE_INTEGER liNow;
+    QueryPerformanceCounter(&liNow);
+    return liNow.QuadPart;
+}
+
+// Method Description:
+// - Converts a duration measured with Now into milliseconds.
+// Arguments:
+// - ticks: the duration, in performance counter ticks.
+// Return Value:
+// - The duration in milliseconds.
+double FrameTracing::ToMilliseconds(const LONGLONG ticks) const noexcept
+{
+    return _llPerformanceFrequency > 0 ? (ticks * 1000.0) / _llPerformanceFrequency : 0.0;
+}
+
+uint64_t FrameTracing::_ToMicroseconds(const LONGLONG ticks) const noexcept
+{
+    return _llPerformanceFrequency > 0 && ticks > 0 ? static_cast<uint64_t>((ticks * 1000000) / _llPerformanceFrequency) : 0;
+}
+
+// Method Description:
+// - Records the breakdown of a frame that one engine painted.
+// Arguments:
+// - pEngine: the engine that painted the frame.
+// - stats: what the frame cost.
+// Return Value:
+// - <none>
+void FrameTracing::TraceFrame(const IRenderEngine* const pEngine, const FrameStats& stats) const noexcept
+{
+#ifndef UNIT_TESTING
+    TraceLoggingWrite(g_hConsoleRendererTraceProvider,
+                      "Renderer_TraceFrame",
+                      TraceLoggingPointer(pEngine, "engine"),
+                      TraceLoggingUInt64(_ToMicroseconds(stats.startPaint), "startPaintUs"),
+                      TraceLoggingUInt64(_ToMicroseconds(stats.bufferOutput), "bufferOutputUs"),
+                      TraceLoggingUInt64(_ToMicroseconds(stats.cursor), "cursorUs"),
+                      TraceLoggingUInt64(_ToMicroseconds(stats.endPaint), "endPaintUs"),
+                      TraceLoggingUInt64(_ToMicroseconds(stats.present), "presentUs"),
+                      TraceLoggingUInt64(_ToMicroseconds(stats.total), "totalUs"),
+                      TraceLoggingUInt64(stats.dirtyCells, "dirtyCells"),
+                      TraceLoggingUInt64(stats.coalescedNotifications, "coalescedNotifications"),
+                      TraceLoggingUInt64(stats.framesSkipped, "framesSkipped"),
+                      TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE));
+#else
+    UNREFERENCED_PARAMETER(pEngine);
+    UNREFERENCED_PARAMETER(stats);
+#endif UNIT_TESTING
+}
+
+// Method Description:
+// - Records that an engine woke up for a frame but had nothing to paint.
+// Arguments:
+// - pEngine: the engine that skipped the frame.
+// - stats: the engine's frame, up to the point that it found nothing to paint.
+// Return Value:
+// - <none>
+void FrameTracing::TraceFrameSkipped(const IRenderEngine* const pEngine, const FrameStats& stats) const noexcept
+{
+#ifndef UNIT_TESTING
+    TraceLoggingWrite(g_hConsoleRendererTraceProvider,
+                      "Renderer_TraceFrameSkipped",
+                      TraceLoggingPointer(pEngine, "engine"),
+                      TraceLoggingUInt64(_ToMicroseconds(stats.startPaint), "startPaintUs"),
+                      TraceLoggingUInt64(stats.coalescedNotifications, "coalescedNotifications"),
+                      TraceLoggingUInt64(stats.framesSkipped, "framesSkipped"),
+                      TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE));
+#else
+    UNREFERENCED_PARAMETER(pEngine);
+    UNREFERENCED_PARAMETER(stats);
+#endif UNIT_TESTING
+}
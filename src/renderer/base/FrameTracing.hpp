@@ -0,0 +1,56 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- FrameTracing.hpp
+
+Abstract:
+- This module is used for recording how long each frame took to paint, and
+  where that time went, to the telemetry ETW channel.
+--*/
+
+#pragma once
+#include <windows.h>
+#include <winmeta.h>
+#include <TraceLoggingProvider.h>
+#include <telemetry\ProjectTelemetry.h>
+
+TRACELOGGING_DECLARE_PROVIDER(g_hConsoleRendererTraceProvider);
+
+namespace Microsoft::Console::Render
+{
+    class IRenderEngine;
+
+    // What one engine's frame cost. The times are in performance counter ticks.
+    struct FrameStats
+    {
+        LONGLONG startPaint = 0;
+        LONGLONG bufferOutput = 0; // the text of the buffer, through PaintBufferLine
+        LONGLONG cursor = 0;
+        LONGLONG endPaint = 0;
+        LONGLONG present = 0;
+        LONGLONG total = 0;
+        size_t dirtyCells = 0; // the cells that were repainted
+        uint64_t coalescedNotifications = 0; // paint notifications that were folded into this frame besides the one that woke us
+        uint64_t framesSkipped = 0; // frames so far that turned out to have nothing to paint
+    };
+
+    class FrameTracing final
+    {
+    public:
+        FrameTracing();
+        ~FrameTracing();
+
+        LONGLONG Now() const noexcept;
+        double ToMilliseconds(const LONGLONG ticks) const noexcept;
+
+        void TraceFrame(const IRenderEngine* const pEngine, const FrameStats& stats) const noexcept;
+        void TraceFrameSkipped(const IRenderEngine* const pEngine, const FrameStats& stats) const noexcept;
+
+    private:
+        LONGLONG _llPerformanceFrequency;
+
+        uint64_t _ToMicroseconds(const LONGLONG ticks) const noexcept;
+    };
+}
@@ -23,6 +23,34 @@ HRESULT RenderEngineBase::InvalidateTitle(const std::wstring& proposedTitle) noe
     return S_OK;
 }
 
+// Routine Description:
+// - Notifies the engine that a region of the buffer changed while (at least partly)
+//   out of view. Engines that only keep what's in view get this default, which
+//   doesn't do anything, since they'll read whatever scrolls into view anew.
+// Arguments:
+// - psrRegion - The region of the buffer that changed, in buffer coordinates, inclusive.
+// Return Value:
+// - S_OK
+HRESULT RenderEngineBase::InvalidateOffscreen(const SMALL_RECT* const /*psrRegion*/) noexcept
+{
+    return S_OK;
+}
+
+// Routine Description:
+// - Notifies the engine that the contents of a band of rows within the viewport
+//   moved up or down inside of it, like when text scrolls within the margins.
+//   Engines that can't shift part of what they've drawn get this default, which
+//   repaints the whole band.
+// Arguments:
+// - psrRows - The rows that moved, relative to the viewport, exclusive. They span its width.
+// - delta - How far the contents moved down. Negative for up.
+// Return Value:
+// - S_OK, else an appropriate HRESULT from invalidating the rows.
+HRESULT RenderEngineBase::InvalidateScrollRows(const SMALL_RECT* const psrRows, const SHORT /*delta*/) noexcept
+{
+    return Invalidate(psrRows);
+}
+
 HRESULT RenderEngineBase::UpdateTitle(const std::wstring& newTitle) noexcept
 {
     HRESULT hr = S_FALSE;
@@ -35,3 +63,30 @@ HRESULT RenderEngineBase::UpdateTitle(const std::wstring& newTitle) noexcept
     }
     return hr;
 }
+
+// Routine Description:
+// - Gets the dirty area of the frame as a set of character rectangles, so that
+//   changes far apart from each other don't have to be painted as the whole
+//   area between them. Engines that only track a single rectangle get this
+//   default, which is just that rectangle.
+// Arguments:
+// - <none>
+// Return Value:
+// - The character region that's dirty.
+Microsoft::Console::Types::Region RenderEngineBase::GetDirtyArea()
+{
+    return { Microsoft::Console::Types::Viewport::FromInclusive(GetDirtyRectInChars()) };
+}
+
+// Routine Description:
+// - Blocks until the engine is ready to take another frame. Called by the render
+//   thread before it locks the console to paint, so that the frame is painted from
+//   the freshest state of the buffer it can get. Engines that can paint right away
+//   get this default, which doesn't wait at all.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void RenderEngineBase::WaitUntilCanRender() noexcept
+{
+}
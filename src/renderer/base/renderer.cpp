@@ -4,6 +4,8 @@
 #include "precomp.h"
 
 #include "renderer.hpp"
+#include "../../types/inc/AllocationTracking.hpp"
+#include "../../types/inc/OutputTracing.hpp"
 
 #pragma hdrstop
 
@@ -45,6 +47,12 @@ Renderer::Renderer(IRenderData* pData,
 Renderer::~Renderer()
 {
     _destructing = true;
+
+    // Stop the engines' own threads while the rest of us is still around for them to call.
+    for (auto& engineThread : _engineThreads)
+    {
+        engineThread.reset();
+    }
 }
 
 // Routine Description:
@@ -60,38 +68,100 @@ Renderer::~Renderer()
         return S_FALSE;
     }
 
-    for (IRenderEngine* const pEngine : _rgpEngines)
+    for (IRenderEngine* const pEngine : _GetEngines())
     {
-        LOG_IF_FAILED(_PaintFrameForEngine(pEngine));
+        // Engines with a thread of their own paint their frames there.
+        if (!_HasOwnThread(pEngine))
+        {
+            LOG_IF_FAILED(_PaintFrameForEngine(pEngine));
+        }
     }
 
     return S_OK;
 }
 
+// Routine Description:
+// - Composes a new frame for one engine only. This is what an engine's own
+//      thread calls, so that it paints independently of the other engines.
+// Arguments:
+// - pEngine - The engine to paint the frame for
+// Return Value:
+// - HRESULT S_OK, GDI error, Safe Math error, or state/argument errors.
+[[nodiscard]] HRESULT Renderer::PaintFrame(_In_ IRenderEngine* const pEngine)
+{
+    if (_destructing)
+    {
+        return S_FALSE;
+    }
+
+    return _PaintFrameForEngine(pEngine);
+}
+
 [[nodiscard]] HRESULT Renderer::_PaintFrameForEngine(_In_ IRenderEngine* const pEngine)
 {
+    const AllocationScope allocationScope{ AllocationTag::Renderer };
+
     FAIL_FAST_IF_NULL(pEngine); // This is a programming error. Fail fast.
 
+    // Wait for the engine to be able to take a frame before we lock, so that we
+    // don't hold up the console while waiting, and paint what's freshest.
+    pEngine->WaitUntilCanRender();
+
     _pData->LockConsole();
     auto unlock = wil::scope_exit([&]() {
         _pData->UnlockConsole();
     });
 
+    // The colors may have changed while we weren't holding the lock.
+    _resolvedColors.clear();
+
+    // Keep track of where the time goes, so that slow frames can be explained.
+    auto& engineStats = _frameStats.at(_GetEngineIndex(pEngine));
+    const auto notifications = _paintNotifications.load();
+    const bool showStats = _fDebug && !_HasOwnThread(pEngine);
+
+    FrameStats stats;
+    stats.coalescedNotifications = notifications > engineStats.notificationsSeen ? notifications - engineStats.notificationsSeen - 1 : 0;
+    stats.framesSkipped = engineStats.framesSkipped;
+    engineStats.notificationsSeen = notifications;
+
+    const auto frameStart = _tracing.Now();
+    auto stepStart = frameStart;
+    const auto endStep = [&](LONGLONG& step) {
+        const auto now = _tracing.Now();
+        step = now - stepStart;
+        stepStart = now;
+    };
+
     // Last chance check if anything scrolled without an explicit invalidate notification since the last frame.
     _CheckViewportAndScroll();
 
+    // The frame stats are painted over every frame, so that they stay up to date.
+    if (showStats)
+    {
+        auto statsRect = _GetFrameStatsRect();
+        LOG_IF_FAILED(pEngine->Invalidate(&statsRect));
+    }
+
     // Try to start painting a frame
     HRESULT const hr = pEngine->StartPaint();
     RETURN_IF_FAILED(hr);
+    endStep(stats.startPaint);
 
     // Return early if there's nothing to paint.
     // The renderer itself tracks if there's something to do with the title, the
     //      engine won't know that.
     if (S_FALSE == hr)
     {
+        stats.framesSkipped = ++engineStats.framesSkipped;
+        _tracing.TraceFrameSkipped(pEngine, stats);
         return S_OK;
     }
 
+    // Relate the frame to the output it's the first to show, for tracing from output to present.
+    auto& outputTracing = OutputTracing::Instance();
+    const auto outputFrame = outputTracing.BeginFrame(engineStats.writesSeen);
+
     auto endPaint = wil::scope_exit([&]() {
         LOG_IF_FAILED(pEngine->EndPaint());
     });
@@ -102,11 +172,20 @@ Renderer::~Renderer()
     // B. Perform Scroll Operations
     RETURN_IF_FAILED(_PerformScrolling(pEngine));
 
+    // C. Find the rows that need painting now that scrolling has moved the dirty area
+    RETURN_IF_FAILED(_UpdateDirtyRows(pEngine));
+    for (const auto [left, right] : _dirtyRows)
+    {
+        stats.dirtyCells += right > left ? gsl::narrow_cast<size_t>(right - left) : 0;
+    }
+
     // 1. Paint Background
     RETURN_IF_FAILED(_PaintBackground(pEngine));
 
     // 2. Paint Rows of Text
+    stepStart = _tracing.Now();
     _PaintBufferOutput(pEngine);
+    endStep(stats.bufferOutput);
 
     // 3. Paint overlays that reside above the text buffer
     _PaintOverlays(pEngine);
@@ -115,19 +194,48 @@ Renderer::~Renderer()
     _PaintSelection(pEngine);
 
     // 5. Paint Cursor
+    stepStart = _tracing.Now();
     _PaintCursor(pEngine);
+    endStep(stats.cursor);
 
     // 6. Paint window title
     RETURN_IF_FAILED(_PaintTitle(pEngine));
 
+    // 7. Paint what the last frame cost, if we've been asked to.
+    if (showStats)
+    {
+        try
+        {
+            _PaintFrameStats(pEngine, engineStats.lastFrame);
+        }
+        CATCH_LOG();
+    }
+
     // Force scope exit end paint to finish up collecting information and possibly painting
+    stepStart = _tracing.Now();
     endPaint.reset();
+    endStep(stats.endPaint);
+
+    // Hold on to what the frame cost while we still have the lock, so that the next one can show it.
+    stats.total = stepStart - frameStart;
+    engineStats.lastFrame = stats;
+    outputTracing.TraceFramePainted(outputFrame, stats.dirtyCells);
 
     // Force scope exit unlock to let go of global lock so other threads can run
     unlock.reset();
 
     // Trigger out-of-lock presentation for renderers that can support it
-    RETURN_IF_FAILED(pEngine->Present());
+    const HRESULT hrPresent = pEngine->Present();
+    endStep(stats.present);
+
+    stats.total = stepStart - frameStart;
+    _tracing.TraceFrame(pEngine, stats);
+    _framesPainted.fetch_add(1, std::memory_order_relaxed);
+    _dirtyCellsPainted.fetch_add(stats.dirtyCells, std::memory_order_relaxed);
+    _paintTicks.fetch_add(stats.total, std::memory_order_relaxed);
+    outputTracing.EndFrame(outputFrame, hrPresent);
+
+    RETURN_IF_FAILED(hrPresent);
 
     // As we leave the scope, EndPaint will be called (declared above)
     return S_OK;
@@ -136,7 +244,63 @@ Renderer::~Renderer()
 void Renderer::_NotifyPaintFrame()
 {
     // The thread will provide throttling for us.
+    _paintNotifications++;
     _pThread->NotifyPaint();
+
+    for (const auto& engineThread : _GetEngineThreads())
+    {
+        if (engineThread)
+        {
+            engineThread->NotifyPaint();
+        }
+    }
+}
+
+// Routine Description:
+// - Checks whether an engine paints on a thread of its own.
+// Arguments:
+// - pEngine - The engine to look for
+// Return Value:
+// - true if the engine was added with AddRenderEngineOnOwnThread.
+bool Renderer::_HasOwnThread(const IRenderEngine* const pEngine) const noexcept
+{
+    const auto index = _GetEngineIndex(pEngine);
+    return index < MaxEngines && _engineThreads.at(index) != nullptr;
+}
+
+// Routine Description:
+// - Gets the engines that have been added so far.
+// Arguments:
+// - <none>
+// Return Value:
+// - The engines, in the order they were added. An engine added after this returns isn't in it.
+gsl::span<IRenderEngine* const> Renderer::_GetEngines() const noexcept
+{
+    return { _engines.data(), gsl::narrow_cast<ptrdiff_t>(_engineCount.load(std::memory_order_acquire)) };
+}
+
+// Routine Description:
+// - Gets the threads of the engines that have been added so far, in their engines' slots.
+// Arguments:
+// - <none>
+// Return Value:
+// - A thread for each engine, or nullptr for the engines painted by the renderer's own thread.
+gsl::span<const std::unique_ptr<RenderThread>> Renderer::_GetEngineThreads() const noexcept
+{
+    return { _engineThreads.data(), gsl::narrow_cast<ptrdiff_t>(_engineCount.load(std::memory_order_acquire)) };
+}
+
+// Routine Description:
+// - Finds the slot of an engine.
+// Arguments:
+// - pEngine - The engine to look for
+// Return Value:
+// - The engine's slot, or MaxEngines if it hasn't been added.
+size_t Renderer::_GetEngineIndex(const IRenderEngine* const pEngine) const noexcept
+{
+    const auto engines = _GetEngines();
+    const auto it = std::find(engines.begin(), engines.end(), pEngine);
+    return it != engines.end() ? gsl::narrow_cast<size_t>(it - engines.begin()) : MaxEngines;
 }
 
 // Routine Description:
@@ -147,9 +311,10 @@ void Renderer::_NotifyPaintFrame()
 // - <none>
 void Renderer::TriggerSystemRedraw(const RECT* const prcDirtyClient)
 {
-    std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
+    for (IRenderEngine* const pEngine : _GetEngines())
+    {
         LOG_IF_FAILED(pEngine->InvalidateSystem(prcDirtyClient));
-    });
+    }
 
     _NotifyPaintFrame();
 }
@@ -162,15 +327,29 @@ void Renderer::TriggerSystemRedraw(const RECT* const prcDirtyClient)
 // - <none>
 void Renderer::TriggerRedraw(const Viewport& region)
 {
+    // Whatever changed has to be read from the buffer again, even if it's out of view right now.
+    _InvalidateClusterRows(region);
+
     Viewport view = _pData->GetViewport();
     SMALL_RECT srUpdateRegion = region.ToExclusive();
 
+    // Engines that hold on to rows out of view have to let go of the ones that changed.
+    if (!view.IsInBounds(region))
+    {
+        const SMALL_RECT srChanged = region.ToInclusive();
+        for (IRenderEngine* const pEngine : _GetEngines())
+        {
+            LOG_IF_FAILED(pEngine->InvalidateOffscreen(&srChanged));
+        }
+    }
+
     if (view.TrimToViewport(&srUpdateRegion))
     {
         view.ConvertToOrigin(&srUpdateRegion);
-        std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
+        for (IRenderEngine* const pEngine : _GetEngines())
+        {
             LOG_IF_FAILED(pEngine->Invalidate(&srUpdateRegion));
-        });
+        }
 
         _NotifyPaintFrame();
     }
@@ -204,7 +383,7 @@ void Renderer::TriggerRedrawCursor(const COORD* const pcoord)
     if (view.IsInBounds(updateCoord))
     {
         view.ConvertToOrigin(&updateCoord);
-        for (IRenderEngine* pEngine : _rgpEngines)
+        for (IRenderEngine* const pEngine : _GetEngines())
         {
             LOG_IF_FAILED(pEngine->InvalidateCursor(&updateCoord));
 
@@ -229,9 +408,14 @@ void Renderer::TriggerRedrawCursor(const COORD* const pcoord)
 // - <none>
 void Renderer::TriggerRedrawAll()
 {
-    std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
+    // This can come from outside the lock (e.g. the window resizing), so just
+    // leave a note for the next paint to drop all of the cached rows.
+    _clusterCacheStale = true;
+
+    for (IRenderEngine* const pEngine : _GetEngines())
+    {
         LOG_IF_FAILED(pEngine->InvalidateAll());
-    });
+    }
 
     _NotifyPaintFrame();
 }
@@ -245,11 +429,11 @@ void Renderer::TriggerRedrawAll()
 // - <none>
 void Renderer::TriggerTeardown()
 {
-    // We need to shut down the paint thread on teardown.
-    _pThread->WaitForPaintCompletionAndDisable(INFINITE);
+    // We need to shut down the paint threads on teardown.
+    WaitForPaintCompletionAndDisable(INFINITE);
 
     // Then walk through and do one final paint on the caller's thread.
-    for (IRenderEngine* const pEngine : _rgpEngines)
+    for (IRenderEngine* const pEngine : _GetEngines())
     {
         bool fEngineRequestsRepaint = false;
         HRESULT hr = pEngine->PrepareForTeardown(&fEngineRequestsRepaint);
@@ -264,6 +448,10 @@ void Renderer::TriggerTeardown()
 
 // Routine Description:
 // - Called when the selected area in the console has changed.
+// - Only the cells that went into or out of the selection are invalidated, so dragging
+//   a big selection around doesn't repaint everything under it on every move.
+// - Once the selection's gone, the engines are also given an empty set of rectangles,
+//   so the last set they were given is only empty when there's nothing selected.
 // Arguments:
 // - <none>
 // Return Value:
@@ -273,20 +461,145 @@ void Renderer::TriggerSelection()
     try
     {
         // Get selection rectangles
-        const auto rects = _GetSelectionRects();
+        auto rects = _GetSelectionRects();
+        const auto changed = s_GetChangedSelectionRects(_previousSelection, rects);
+        if (changed.empty())
+        {
+            return;
+        }
 
-        std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
-            LOG_IF_FAILED(pEngine->InvalidateSelection(_previousSelection));
-            LOG_IF_FAILED(pEngine->InvalidateSelection(rects));
-        });
+        for (IRenderEngine* const pEngine : _GetEngines())
+        {
+            LOG_IF_FAILED(pEngine->InvalidateSelection(changed));
+            if (rects.empty())
+            {
+                LOG_IF_FAILED(pEngine->InvalidateSelection(rects));
+            }
+        }
 
-        _previousSelection = rects;
+        _previousSelection = std::move(rects);
 
         _NotifyPaintFrame();
     }
     CATCH_LOG();
 }
 
+// Routine Description:
+// - Finds the parts of the screen that are in one selection but not the other.
+// - Both selections are looked at one row at a time. Where a row's selected columns
+//   overlap, only the columns at either end that moved are given back. Rows with the
+//   same change are given back together.
+// Arguments:
+// - previous - The exclusive selection rectangles that were painted before
+// - current - The exclusive selection rectangles to paint now
+// Return Value:
+// - Exclusive rectangles covering every cell whose selection state changed.
+// Note:
+// - will throw exception if unable to allocate memory for the rectangles
+std::vector<SMALL_RECT> Renderer::s_GetChangedSelectionRects(const std::vector<SMALL_RECT>& previous,
+                                                             const std::vector<SMALL_RECT>& current)
+{
+    std::vector<SMALL_RECT> changed;
+    if (previous == current)
+    {
+        return changed;
+    }
+
+    SHORT top = SHRT_MAX;
+    SHORT bottom = SHRT_MIN;
+    for (const auto& rect : previous)
+    {
+        top = std::min(top, rect.Top);
+        bottom = std::max(bottom, rect.Bottom);
+    }
+    for (const auto& rect : current)
+    {
+        top = std::min(top, rect.Top);
+        bottom = std::max(bottom, rect.Bottom);
+    }
+    if (bottom <= top)
+    {
+        return changed;
+    }
+
+    // The selected columns of each row, as [left, right). A row that more than one
+    // rectangle covers is given back in full, from the leftmost to the rightmost of them.
+    struct RowSpans
+    {
+        SHORT left[2]{ 0, 0 };
+        SHORT right[2]{ 0, 0 };
+        bool overlapped = false;
+    };
+    std::vector<RowSpans> rows(static_cast<size_t>(bottom - top));
+    const auto spread = [&](const std::vector<SMALL_RECT>& rectangles, const size_t which) {
+        for (const auto& rect : rectangles)
+        {
+            if (rect.Right <= rect.Left)
+            {
+                continue;
+            }
+            for (auto row = rect.Top; row < rect.Bottom; ++row)
+            {
+                auto& spans = rows.at(static_cast<size_t>(row - top));
+                if (spans.right[which] > spans.left[which])
+                {
+                    spans.overlapped = true;
+                    spans.left[which] = std::min(spans.left[which], rect.Left);
+                    spans.right[which] = std::max(spans.right[which], rect.Right);
+                }
+                else
+                {
+                    spans.left[which] = rect.Left;
+                    spans.right[which] = rect.Right;
+                }
+            }
+        }
+    };
+    spread(previous, 0);
+    spread(current, 1);
+
+    const auto add = [&](const SHORT row, const SHORT left, const SHORT right) {
+        if (right <= left)
+        {
+            return;
+        }
+        // Grow a rectangle from the row above instead, if it covers the same columns.
+        for (auto it = changed.rbegin(); it != changed.rend() && it->Bottom >= row; ++it)
+        {
+            if (it->Bottom == row && it->Left == left && it->Right == right)
+            {
+                it->Bottom = gsl::narrow_cast<SHORT>(row + 1);
+                return;
+            }
+        }
+        changed.push_back({ left, row, right, gsl::narrow_cast<SHORT>(row + 1) });
+    };
+
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        const auto& spans = rows.at(i);
+        const auto row = gsl::narrow_cast<SHORT>(top + i);
+        const bool hadSelection = spans.right[0] > spans.left[0];
+        const bool hasSelection = spans.right[1] > spans.left[1];
+
+        if (spans.overlapped || !hadSelection || !hasSelection ||
+            spans.right[0] <= spans.left[1] || spans.right[1] <= spans.left[0])
+        {
+            // There's nothing in common to leave out, so both are given back in full.
+            add(row, spans.left[0], spans.right[0]);
+            add(row, spans.left[1], spans.right[1]);
+        }
+        else
+        {
+            // Only the ends of the row's selection moved.
+            add(row, std::min(spans.left[0], spans.left[1]), std::max(spans.left[0], spans.left[1]));
+            add(row, std::min(spans.right[0], spans.right[1]), std::max(spans.right[0], spans.right[1]));
+        }
+    }
+
+    return changed;
+}
+
 // Routine Description:
 // - Called when we want to check if the viewport has moved and scroll accordingly if so.
 // Arguments:
@@ -302,10 +615,11 @@ bool Renderer::_CheckViewportAndScroll()
     coordDelta.X = srOldViewport.Left - srNewViewport.Left;
     coordDelta.Y = srOldViewport.Top - srNewViewport.Top;
 
-    std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
+    for (IRenderEngine* const pEngine : _GetEngines())
+    {
         LOG_IF_FAILED(pEngine->UpdateViewport(srNewViewport));
         LOG_IF_FAILED(pEngine->InvalidateScroll(&coordDelta));
-    });
+    }
     _srViewportPrevious = srNewViewport;
 
     return coordDelta.X != 0 || coordDelta.Y != 0;
@@ -337,13 +651,52 @@ void Renderer::TriggerScroll()
 // - <none>
 void Renderer::TriggerScroll(const COORD* const pcoordDelta)
 {
-    std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
+    for (IRenderEngine* const pEngine : _GetEngines())
+    {
         LOG_IF_FAILED(pEngine->InvalidateScroll(pcoordDelta));
-    });
+    }
 
     _NotifyPaintFrame();
 }
 
+// Routine Description:
+// - Called when the contents of a band of whole rows moved up or down within it,
+//   like when text scrolls within the margins. Engines that can shift what they've
+//   already drawn of it only have to paint the rows that it uncovered.
+// Arguments:
+// - rows - The rows that moved, in buffer coordinates. They span the width of the buffer.
+// - delta - How far the contents moved down. Negative for up.
+// Return Value:
+// - <none>
+void Renderer::TriggerScrollRows(const Viewport& rows, const SHORT delta)
+{
+    // The rows changed, so they have to be read from the buffer again.
+    _InvalidateClusterRows(rows);
+
+    Viewport view = _pData->GetViewport();
+    SMALL_RECT srRows = rows.ToExclusive();
+
+    if (!view.IsInBounds(rows))
+    {
+        const SMALL_RECT srChanged = rows.ToInclusive();
+        for (IRenderEngine* const pEngine : _GetEngines())
+        {
+            LOG_IF_FAILED(pEngine->InvalidateOffscreen(&srChanged));
+        }
+    }
+
+    if (view.TrimToViewport(&srRows))
+    {
+        view.ConvertToOrigin(&srRows);
+        for (IRenderEngine* const pEngine : _GetEngines())
+        {
+            LOG_IF_FAILED(pEngine->InvalidateScrollRows(&srRows, delta));
+        }
+
+        _NotifyPaintFrame();
+    }
+}
+
 // Routine Description:
 // - Called when the text buffer is about to circle its backing buffer.
 //      A renderer might want to get painted before that happens.
@@ -353,7 +706,7 @@ void Renderer::TriggerScroll(const COORD* const pcoordDelta)
 // - <none>
 void Renderer::TriggerCircling()
 {
-    for (IRenderEngine* const pEngine : _rgpEngines)
+    for (IRenderEngine* const pEngine : _GetEngines())
     {
         bool fEngineRequestsRepaint = false;
         HRESULT hr = pEngine->InvalidateCircling(&fEngineRequestsRepaint);
@@ -376,13 +729,53 @@ void Renderer::TriggerCircling()
 void Renderer::TriggerTitleChange()
 {
     const std::wstring newTitle = _pData->GetConsoleTitle();
-    for (IRenderEngine* const pEngine : _rgpEngines)
+    for (IRenderEngine* const pEngine : _GetEngines())
     {
         LOG_IF_FAILED(pEngine->InvalidateTitle(newTitle));
     }
     _NotifyPaintFrame();
 }
 
+// Routine Description:
+// - Called when an app starts a synchronized update (DECSET 2026). Frames are
+//      held back until it ends, so that the whole update shows up at once.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Renderer::BeginSynchronizedUpdate()
+{
+    _pThread->BeginSynchronizedUpdate();
+
+    for (const auto& engineThread : _GetEngineThreads())
+    {
+        if (engineThread)
+        {
+            engineThread->BeginSynchronizedUpdate();
+        }
+    }
+}
+
+// Routine Description:
+// - Called when an app ends a synchronized update (DECRST 2026). Whatever it
+//      drew in the meantime is painted in the next frame.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Renderer::EndSynchronizedUpdate()
+{
+    _pThread->EndSynchronizedUpdate();
+
+    for (const auto& engineThread : _GetEngineThreads())
+    {
+        if (engineThread)
+        {
+            engineThread->EndSynchronizedUpdate();
+        }
+    }
+}
+
 // Routine Description:
 // - Update the title for a particular engine.
 // Arguments:
@@ -405,10 +798,11 @@ HRESULT Renderer::_PaintTitle(IRenderEngine* const pEngine)
 // - <none>
 void Renderer::TriggerFontChange(const int iDpi, const FontInfoDesired& FontInfoDesired, _Out_ FontInfo& FontInfo)
 {
-    std::for_each(_rgpEngines.begin(), _rgpEngines.end(), [&](IRenderEngine* const pEngine) {
+    for (IRenderEngine* const pEngine : _GetEngines())
+    {
         LOG_IF_FAILED(pEngine->UpdateDpi(iDpi));
         LOG_IF_FAILED(pEngine->UpdateFont(FontInfoDesired, FontInfo));
-    });
+    }
 
     _NotifyPaintFrame();
 }
@@ -428,7 +822,8 @@ void Renderer::TriggerFontChange(const int iDpi, const FontInfoDesired& FontInfo
     //      handle this.
     // Currently, the only caller is the WindowProc:WM_GETDPISCALEDSIZE handler.
     //      It will assume that the proposed font is 1x1, regardless of DPI.
-    if (_rgpEngines.size() < 1)
+    const auto engines = _GetEngines();
+    if (engines.size() < 1)
     {
         return E_FAIL;
     }
@@ -437,8 +832,8 @@ void Renderer::TriggerFontChange(const int iDpi, const FontInfoDesired& FontInfo
     //      renderer. We won't know which is which, so iterate over them.
     //      Only return the result of the successful one if it's not S_FALSE (which is the VT renderer)
     // TODO: 14560740 - The Window might be able to get at this info in a more sane manner
-    FAIL_FAST_IF(!(_rgpEngines.size() <= 2));
-    for (IRenderEngine* const pEngine : _rgpEngines)
+    FAIL_FAST_IF(!(engines.size() <= 2));
+    for (IRenderEngine* const pEngine : engines)
     {
         const HRESULT hr = LOG_IF_FAILED(pEngine->GetProposedFont(FontInfoDesired, FontInfo, iDpi));
         // We're looking for specifically S_OK, S_FALSE is not good enough.
@@ -469,8 +864,9 @@ bool Renderer::IsGlyphWideByFont(const std::wstring_view glyph)
     //      renderer. We won't know which is which, so iterate over them.
     //      Only return the result of the successful one if it's not S_FALSE (which is the VT renderer)
     // TODO: 14560740 - The Window might be able to get at this info in a more sane manner
-    FAIL_FAST_IF(!(_rgpEngines.size() <= 2));
-    for (IRenderEngine* const pEngine : _rgpEngines)
+    const auto engines = _GetEngines();
+    FAIL_FAST_IF(!(engines.size() <= 2));
+    for (IRenderEngine* const pEngine : engines)
     {
         const HRESULT hr = LOG_IF_FAILED(pEngine->IsGlyphWideByFont(glyph, &fIsFullWidth));
         // We're looking for specifically S_OK, S_FALSE is not good enough.
@@ -492,6 +888,14 @@ bool Renderer::IsGlyphWideByFont(const std::wstring_view glyph)
 void Renderer::EnablePainting()
 {
     _pThread->EnablePainting();
+
+    for (const auto& engineThread : _GetEngineThreads())
+    {
+        if (engineThread)
+        {
+            engineThread->EnablePainting();
+        }
+    }
 }
 
 // Routine Description:
@@ -505,6 +909,14 @@ void Renderer::EnablePainting()
 void Renderer::WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs)
 {
     _pThread->WaitForPaintCompletionAndDisable(dwTimeoutMs);
+
+    for (const auto& engineThread : _GetEngineThreads())
+    {
+        if (engineThread)
+        {
+            engineThread->WaitForPaintCompletionAndDisable(dwTimeoutMs);
+        }
+    }
 }
 
 // Routine Description:
@@ -533,46 +945,294 @@ void Renderer::_PaintBufferOutput(_In_ IRenderEngine* const pEngine)
     // relative to the entire buffer.
     const auto view = _pData->GetViewport();
 
-    // This is effectively the number of cells on the visible screen that need to be redrawn.
-    // The origin is always 0, 0 because it represents the screen itself, not the underlying buffer.
-    auto dirty = Viewport::FromInclusive(pEngine->GetDirtyRectInChars());
+    // Retrieve the text buffer so we can read information out of it.
+    const auto& buffer = _pData->GetTextBuffer();
+    _clusterCachePaint++;
+
+    // Read everything that changed up front, so that a big repaint can spread the reading out.
+    _ReadDirtyClusterRows(buffer, view);
+
+    // Now walk through each row of the screen, skipping the ones that are clean.
+    // The dirty rows were gathered at the start of the frame, in screen coordinates
+    // (the origin is always 0, 0 because it represents the screen itself, not the underlying buffer).
+    for (size_t screenRow = 0; screenRow < _dirtyRows.size(); screenRow++)
+    {
+        const auto [left, right] = _dirtyRows.at(screenRow);
+        if (right > left)
+        {
+            // Find the row of the buffer to paint from. This requires us to re-map the screen-based origin of
+            // the line onto the buffer-based origin of the line.
+            // For example, the screen might say we need to paint 1,1 because it is dirty but the viewport is actually looking
+            // at 13,26 relative to the buffer.
+            // This means that we need 14,27 out of the backing buffer to fill in the 1,1 cell of the screen.
+            const auto bufferRow = gsl::narrow_cast<SHORT>(view.Top() + screenRow);
+            const auto& row = _GetClusterRow(buffer, bufferRow);
+
+            // Paint the dirty part of the row, shifted to match the underlying buffer.
+            const auto begin = gsl::narrow_cast<size_t>(view.Left() + left);
+            const auto end = std::min(row.cells.size(), gsl::narrow_cast<size_t>(view.Left() + right));
+            _PaintClusterRow(pEngine, row, begin, end, { left, gsl::narrow_cast<SHORT>(screenRow) });
+        }
+    }
+
+    // Let go of rows that were painted a while ago, so that a long scroll through
+    // the history doesn't hold on to all of it. A few screens' worth is plenty.
+    const auto maxCachedRows = 4 * gsl::narrow_cast<size_t>(view.Height());
+    if (_clusterCache.size() > maxCachedRows)
+    {
+        for (auto entry = _clusterCache.begin(); entry != _clusterCache.end();)
+        {
+            entry = entry->second.lastUsed != _clusterCachePaint ? _clusterCache.erase(entry) : std::next(entry);
+        }
+    }
+}
+
+// Routine Description:
+// - Gets the cells of a row of the text buffer, reading them out of the buffer
+//   only if the row changed since they were last read.
+// Arguments:
+// - buffer - The text buffer to paint
+// - bufferRow - The row of the buffer to get the cells of
+// Return Value:
+// - The cells of the row. They're valid until the next call.
+const Renderer::ClusterRow& Renderer::_GetClusterRow(const TextBuffer& buffer, const SHORT bufferRow)
+{
+    _ValidateClusterCache(buffer);
+
+    const auto& bufferLine = buffer.GetRowByOffset(bufferRow);
+    auto& row = _clusterCache[bufferLine.GetStorageKey()];
+    if (row.cells.empty() || row.cells.size() != bufferLine.size() || row.generation != bufferLine.GetGeneration())
+    {
+        s_ReadBufferRow(buffer, { bufferRow, bufferLine.GetGeneration(), &row });
+    }
+
+    row.lastUsed = _clusterCachePaint;
+    return row;
+}
+
+// Routine Description:
+// - Drops all of the cached rows if they were read from another buffer or have to be read again.
+// - The entries that are left stay where they are until the cache is trimmed at the end of a paint.
+// Arguments:
+// - buffer - The text buffer to paint
+// Return Value:
+// - <none>
+void Renderer::_ValidateClusterCache(const TextBuffer& buffer)
+{
+    // The storage keys only mean something within one buffer (e.g. the alternate buffer has its own).
+    // Buffers are told apart by id, since a new one can be made where an old one used to be.
+    if (buffer.GetId() != _clusterCacheBufferId || _clusterCacheStale.exchange(false))
+    {
+        _clusterCache.clear();
+        _clusterCacheBufferId = buffer.GetId();
+    }
+}
+
+// Routine Description:
+// - Reads a row of the text buffer into its ClusterRow.
+// Arguments:
+// - buffer - The text buffer to read from
+// - rowToRead - The row to read and where to read it into
+// Return Value:
+// - <none>
+void Renderer::s_ReadBufferRow(const TextBuffer& buffer, const RowToRead& rowToRead)
+{
+    const auto line = Viewport::FromDimensions({ 0, rowToRead.bufferRow }, { buffer.GetSize().Width(), 1 });
+    s_ReadClusterRow(buffer.GetCellDataAt(line.Origin(), line), *rowToRead.row);
+    rowToRead.row->generation = rowToRead.generation;
+}
+
+// Routine Description:
+// - Reads the dirty rows of the frame that changed since they were last read. When there are
+//   a lot of them, the thread pool helps with the reading and this waits for it to finish.
+// Arguments:
+// - buffer - The text buffer to paint
+// - view - The part of the buffer that's on the screen
+// Return Value:
+// - <none>
+// Note: nothing is unpacked here or by the readers. Compacted rows are read straight out of
+//   their packed form through the const members of the buffer, so the readers share it as is.
+void Renderer::_ReadDirtyClusterRows(const TextBuffer& buffer, const Viewport& view)
+{
+    // Only check once: the cache mustn't be dropped while the readers hold on to its entries.
+    _ValidateClusterCache(buffer);
+
+    _rowsToRead.clear();
+    for (size_t screenRow = 0; screenRow < _dirtyRows.size(); screenRow++)
+    {
+        const auto [left, right] = _dirtyRows.at(screenRow);
+        if (right > left)
+        {
+            const auto bufferRow = gsl::narrow_cast<SHORT>(view.Top() + screenRow);
+            const auto& bufferLine = buffer.GetRowByOffset(bufferRow);
+            auto& row = _clusterCache[bufferLine.GetStorageKey()];
+            if (row.cells.empty() || row.cells.size() != bufferLine.size() || row.generation != bufferLine.GetGeneration())
+            {
+                _rowsToRead.push_back({ bufferRow, bufferLine.GetGeneration(), &row });
+            }
+        }
+    }
+
+    if (_rowsToRead.size() < s_MinRowsToReadInParallel)
+    {
+        for (const auto& rowToRead : _rowsToRead)
+        {
+            s_ReadBufferRow(buffer, rowToRead);
+        }
+        return;
+    }
+
+    if (!_readRowsWork)
+    {
+        _readRowsWork.reset(CreateThreadpoolWork(s_ReadRowsCallback, this, nullptr));
+        THROW_LAST_ERROR_IF_NULL(_readRowsWork);
+    }
+
+    _rowsToReadBuffer = &buffer;
+    _nextRowToRead = 0;
+    _rowsToReadResult = S_OK;
+
+    for (size_t i = 0; i < s_RowReaderHelpers; i++)
+    {
+        SubmitThreadpoolWork(_readRowsWork.get());
+    }
+
+    // Read alongside the helpers rather than just waiting for them.
+    _ReadQueuedRows();
+    WaitForThreadpoolWorkCallbacks(_readRowsWork.get(), FALSE);
+
+    // Some rows may not have been read, so have all of them read again next time.
+    const HRESULT hr = _rowsToReadResult;
+    if (FAILED(hr))
+    {
+        _clusterCacheStale = true;
+        THROW_HR(hr);
+    }
+}
+
+// Routine Description:
+// - Reads the queued rows one after another until there are none left. It runs on this
+//   thread and on the thread pool at the same time, each taking the next row in line.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void Renderer::_ReadQueuedRows() noexcept
+{
+    const AllocationScope allocationScope{ AllocationTag::Renderer };
+
+    for (auto i = _nextRowToRead.fetch_add(1); i < _rowsToRead.size(); i = _nextRowToRead.fetch_add(1))
+    {
+        try
+        {
+            s_ReadBufferRow(*_rowsToReadBuffer, _rowsToRead.at(i));
+        }
+        catch (...)
+        {
+            LOG_CAUGHT_EXCEPTION();
+            auto expected = S_OK;
+            _rowsToReadResult.compare_exchange_strong(expected, wil::ResultFromCaughtException());
+        }
+    }
+}
 
-    // Shift the origin of the dirty region to match the underlying buffer so we can
-    // compare the two regions directly for intersection.
-    dirty = Viewport::Offset(dirty, view.Origin());
+void CALLBACK Renderer::s_ReadRowsCallback(PTP_CALLBACK_INSTANCE /*instance*/, PVOID context, PTP_WORK /*work*/) noexcept
+{
+    static_cast<Renderer*>(context)->_ReadQueuedRows();
+}
 
-    // The intersection between what is dirty on the screen (in need of repaint)
-    // and what is supposed to be visible on the screen (the viewport) is what
-    // we need to walk through line-by-line and repaint onto the screen.
-    const auto redraw = Viewport::Intersect(dirty, view);
+// Routine Description:
+// - Forgets the cells of the rows of the text buffer that a change touched,
+//   so that they're read out of the buffer again the next time they're painted.
+// Arguments:
+// - region - The part of the buffer that changed, in buffer coordinates
+// Return Value:
+// - <none>
+// Note:
+// - if the rows can't be looked up, every cached row is forgotten instead.
+void Renderer::_InvalidateClusterRows(const Viewport& region) noexcept
+{
+    if (_clusterCache.empty())
+    {
+        return;
+    }
 
-    // Shortcut: don't bother redrawing if the width is 0.
-    if (redraw.Width() > 0)
+    try
     {
-        // Retrieve the text buffer so we can read information out of it.
         const auto& buffer = _pData->GetTextBuffer();
+        if (buffer.GetId() != _clusterCacheBufferId)
+        {
+            _clusterCache.clear();
+            return;
+        }
 
-        // Now walk through each row of text that we need to redraw.
-        for (auto row = redraw.Top(); row < redraw.BottomExclusive(); row++)
+        const auto rows = Viewport::Intersect(region, buffer.GetSize());
+        for (auto bufferRow = rows.Top(); rows.IsValid() && bufferRow < rows.BottomExclusive(); bufferRow++)
         {
-            // Calculate the boundaries of a single line. This is from the left to right edge of the dirty
-            // area in width and exactly 1 tall.
-            const auto bufferLine = Viewport::FromDimensions({ redraw.Left(), row }, { redraw.Width(), 1 });
+            _clusterCache.erase(buffer.GetRowByOffset(bufferRow).GetStorageKey());
+        }
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        _clusterCache.clear();
+    }
+}
 
-            // Find where on the screen we should place this line information. This requires us to re-map
-            // the buffer-based origin of the line back onto the screen-based origin of the line
-            // For example, the screen might say we need to paint 1,1 because it is dirty but the viewport is actually looking
-            // at 13,26 relative to the buffer.
-            // This means that we need 14,27 out of the backing buffer to fill in the 1,1 cell of the screen.
-            const auto screenLine = Viewport::Offset(bufferLine, -view.Origin());
+// Routine Description:
+// - Reads the cells that an iterator walks through into a row, one per column.
+// Arguments:
+// - it - The iterator over the cells to read
+// - row - The row to read the cells into. Whatever it held before is replaced.
+// Return Value:
+// - <none>
+void Renderer::s_ReadClusterRow(TextBufferCellIterator it, ClusterRow& row)
+{
+    row.text.clear();
+    row.cells.clear();
 
-            // Retrieve the cell information iterator limited to just this line we want to redraw.
-            auto it = buffer.GetCellDataAt(bufferLine.Origin(), bufferLine);
+    for (; it; ++it)
+    {
+        const auto chars = it->Chars();
+        row.cells.push_back({ row.text.size(), chars.size(), it->Columns(), it->TextAttr() });
+        row.text.append(chars);
+    }
+}
 
-            // Ask the helper to paint through this specific line.
-            _PaintBufferOutputHelper(pEngine, it, screenLine.Origin());
+// Routine Description:
+// - Gathers the engine's dirty area into the span of each row of the screen that
+//   needs painting this frame. Rows between far apart changes stay clean, even
+//   when the rectangle bounding those changes would've covered them.
+// Arguments:
+// - pEngine - The engine whose dirty area we're about to paint
+// Return Value:
+// - S_OK or a memory allocation failure.
+[[nodiscard]] HRESULT Renderer::_UpdateDirtyRows(_In_ IRenderEngine* const pEngine) noexcept
+{
+    try
+    {
+        // The screen itself, always at the origin.
+        const auto screen = Viewport::FromDimensions(_pData->GetViewport().Dimensions());
+
+        _dirtyRows.assign(screen.Height(), { screen.Width(), 0 });
+
+        for (const auto& rect : pEngine->GetDirtyArea())
+        {
+            const auto dirty = Viewport::Intersect(rect, screen);
+            if (dirty.IsValid())
+            {
+                for (auto row = dirty.Top(); row < dirty.BottomExclusive(); row++)
+                {
+                    auto& [left, right] = _dirtyRows.at(row);
+                    left = std::min(left, dirty.Left());
+                    right = std::max(right, dirty.RightExclusive());
+                }
+            }
         }
     }
+    CATCH_RETURN();
+
+    return S_OK;
 }
 
 void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
@@ -582,68 +1242,92 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
     // If we have valid data, let's figure out how to draw it.
     if (it)
     {
-        // TODO: MSFT: 20961091 -  This is a perf issue. Instead of rebuilding this and allocing memory to hold the reinterpretation,
-        // we should have an iterator/view adapter for the rendering.
-        // That would probably also eliminate the RenderData needing to give us the entire TextBuffer as well...
-        // Retrieve the iterator for one line of information.
-        std::vector<Cluster> clusters;
-        size_t cols = 0;
+        ClusterRow row;
+        s_ReadClusterRow(it, row);
+        _PaintClusterRow(pEngine, row, 0, row.cells.size(), target);
+    }
+}
+
+// Routine Description:
+// - Paints a span of the cells of a row, one run of the same color at a time.
+// Arguments:
+// - pEngine - The engine to paint with
+// - row - The cells of the row
+// - begin - The first cell to paint
+// - end - The cell to stop in front of. A wide glyph that starts before it is still painted whole.
+// - target - Where on the screen the first cell goes
+// Return Value:
+// - <none>
+void Renderer::_PaintClusterRow(_In_ IRenderEngine* const pEngine,
+                                const ClusterRow& row,
+                                const size_t begin,
+                                const size_t end,
+                                const COORD target)
+{
+    if (begin >= end)
+    {
+        return;
+    }
 
-        // Retrieve the first color.
-        auto color = it->TextAttr();
+    std::vector<Cluster> clusters;
+    size_t cols = 0;
 
-        // And hold the point where we should start drawing.
-        auto screenPoint = target;
+    // Retrieve the first color.
+    auto cell = begin;
+    auto color = row.cells.at(cell).attr;
 
-        // This outer loop will continue until we reach the end of the text we are trying to draw.
-        while (it)
-        {
-            // Hold onto the current run color right here for the length of the outer loop.
-            // We'll be changing the persistent one as we run through the inner loops to detect
-            // when a run changes, but we will still need to know this color at the bottom
-            // when we go to draw gridlines for the length of the run.
-            const auto currentRunColor = color;
+    // And hold the point where we should start drawing.
+    auto screenPoint = target;
 
-            // Update the drawing brushes with our color.
-            THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, currentRunColor, false));
+    // This outer loop will continue until we reach the end of the text we are trying to draw.
+    while (cell < end)
+    {
+        // Hold onto the current run color right here for the length of the outer loop.
+        // We'll be changing the persistent one as we run through the inner loops to detect
+        // when a run changes, but we will still need to know this color at the bottom
+        // when we go to draw gridlines for the length of the run.
+        const auto currentRunColor = color;
+
+        // Update the drawing brushes with our color.
+        THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, currentRunColor, false));
 
-            // Advance the point by however many columns we've just outputted and reset the accumulator.
-            screenPoint.X += gsl::narrow<SHORT>(cols);
-            cols = 0;
+        // Advance the point by however many columns we've just outputted and reset the accumulator.
+        screenPoint.X += gsl::narrow<SHORT>(cols);
+        cols = 0;
 
-            // Ensure that our cluster vector is clear.
-            clusters.clear();
+        // Ensure that our cluster vector is clear.
+        clusters.clear();
 
-            // This inner loop will accumulate clusters until the color changes.
-            // When the color changes, it will save the new color off and break.
-            do
+        // This inner loop will accumulate clusters until the color changes.
+        // When the color changes, it will save the new color off and break.
+        do
+        {
+            const auto& data = row.cells.at(cell);
+            if (color != data.attr)
             {
-                if (color != it->TextAttr())
-                {
-                    color = it->TextAttr();
-                    break;
-                }
+                color = data.attr;
+                break;
+            }
 
-                // Walk through the text data and turn it into rendering clusters.
-                clusters.emplace_back(it->Chars(), it->Columns());
+            // Turn the cell into a rendering cluster. Its text is still owned by the row.
+            clusters.emplace_back(std::wstring_view{ row.text.data() + data.offset, data.length }, data.columns);
 
-                // Advance the cluster and column counts.
-                const auto columnCount = clusters.back().GetColumns();
-                it += columnCount > 0 ? columnCount : 1; // prevent infinite loop for no visible columns
-                cols += columnCount;
+            // Advance the cell and column counts.
+            const auto columnCount = data.columns;
+            cell += columnCount > 0 ? columnCount : 1; // prevent infinite loop for no visible columns
+            cols += columnCount;
 
-            } while (it);
+        } while (cell < end);
 
-            // Do the painting.
-            // TODO: Calculate when trim left should be TRUE
-            THROW_IF_FAILED(pEngine->PaintBufferLine({ clusters.data(), clusters.size() }, screenPoint, false));
+        // Do the painting.
+        // TODO: Calculate when trim left should be TRUE
+        THROW_IF_FAILED(pEngine->PaintBufferLine({ clusters.data(), clusters.size() }, screenPoint, false));
 
-            // If we're allowed to do grid drawing, draw that now too (since it will be coupled with the color data)
-            if (_pData->IsGridLineDrawingAllowed())
-            {
-                // We're only allowed to draw the grid lines under certain circumstances.
-                _PaintBufferOutputGridLineHelper(pEngine, currentRunColor, cols, screenPoint);
-            }
+        // If we're allowed to do grid drawing, draw that now too (since it will be coupled with the color data)
+        if (_pData->IsGridLineDrawingAllowed())
+        {
+            // We're only allowed to draw the grid lines under certain circumstances.
+            _PaintBufferOutputGridLineHelper(pEngine, currentRunColor, cols, screenPoint);
         }
     }
 }
@@ -765,22 +1449,16 @@ void Renderer::_PaintOverlay(IRenderEngine& engine,
         srCaView.Left += overlay.origin.X;
         srCaView.Right += overlay.origin.X;
 
-        // Set it up in a Viewport helper structure and trim it the IME viewport to be within the full console viewport.
+        // Set it up in a Viewport helper structure so we can trim each of its rows to the dirty part of the screen.
         Viewport viewConv = Viewport::FromInclusive(srCaView);
 
-        SMALL_RECT srDirty = engine.GetDirtyRectInChars();
-
-        // Dirty is an inclusive rectangle, but oddly enough the IME was an exclusive one, so correct it.
-        srDirty.Bottom++;
-        srDirty.Right++;
-
-        if (viewConv.TrimToViewport(&srDirty))
+        for (SHORT iRow = std::max<SHORT>(viewConv.Top(), 0); iRow < viewConv.BottomExclusive() && gsl::narrow_cast<size_t>(iRow) < _dirtyRows.size(); iRow++)
         {
-            Viewport viewDirty = Viewport::FromInclusive(srDirty);
-
-            for (SHORT iRow = viewDirty.Top(); iRow < viewDirty.BottomInclusive(); iRow++)
+            const auto [left, right] = _dirtyRows.at(iRow);
+            const auto dirtyLeft = std::max(left, viewConv.Left());
+            if (std::min(right, viewConv.RightExclusive()) > dirtyLeft)
             {
-                const COORD target{ viewDirty.Left(), iRow };
+                const COORD target{ dirtyLeft, iRow };
                 const auto source = target - overlay.origin;
 
                 auto it = overlay.buffer.GetCellLineDataAt(source);
@@ -824,16 +1502,22 @@ void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
 {
     try
     {
-        SMALL_RECT srDirty = pEngine->GetDirtyRectInChars();
-        Viewport dirtyView = Viewport::FromInclusive(srDirty);
-
         // Get selection rectangles
         const auto rectangles = _GetSelectionRects();
-        for (auto rect : rectangles)
+        for (const auto& rect : rectangles)
         {
-            if (dirtyView.TrimToViewport(&rect))
+            // Paint each row of the selection separately, trimmed to the dirty part of that row,
+            // so that no part of it is painted twice.
+            // The selection rectangles (like what PaintSelection expects) are exclusive.
+            const auto selection = Viewport::FromExclusive(rect);
+            for (auto row = std::max<SHORT>(selection.Top(), 0); row < selection.BottomExclusive() && gsl::narrow_cast<size_t>(row) < _dirtyRows.size(); row++)
             {
-                LOG_IF_FAILED(pEngine->PaintSelection(rect));
+                const auto [left, right] = _dirtyRows.at(row);
+                const SMALL_RECT dirtyRow{ std::max(left, selection.Left()), row, std::min(right, selection.RightExclusive()), gsl::narrow_cast<SHORT>(row + 1) };
+                if (dirtyRow.Right > dirtyRow.Left)
+                {
+                    LOG_IF_FAILED(pEngine->PaintSelection(dirtyRow));
+                }
             }
         }
     }
@@ -853,8 +1537,7 @@ void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
 // - <none>
 [[nodiscard]] HRESULT Renderer::_UpdateDrawingBrushes(_In_ IRenderEngine* const pEngine, const TextAttribute textAttributes, const bool isSettingDefaultBrushes)
 {
-    const COLORREF rgbForeground = _pData->GetForegroundColor(textAttributes);
-    const COLORREF rgbBackground = _pData->GetBackgroundColor(textAttributes);
+    const auto [rgbForeground, rgbBackground] = _ResolveColors(textAttributes);
     const WORD legacyAttributes = textAttributes.GetLegacyAttributes();
     const bool isBold = textAttributes.IsBold();
 
@@ -865,6 +1548,28 @@ void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
     return S_OK;
 }
 
+// Routine Description:
+// - Gets the RGB colors an attribute is painted with, from the colors resolved earlier in this frame if it has been seen already.
+// Arguments:
+// - attr - The attribute to resolve
+// Return Value:
+// - The foreground and background color of the attribute
+std::pair<COLORREF, COLORREF> Renderer::_ResolveColors(const TextAttribute& attr)
+{
+    const auto found = _resolvedColors.find(attr);
+    if (found != _resolvedColors.end())
+    {
+        return found->second;
+    }
+
+    const std::pair<COLORREF, COLORREF> colors{ _pData->GetForegroundColor(attr), _pData->GetBackgroundColor(attr) };
+    if (_resolvedColors.size() < s_MaxResolvedColors)
+    {
+        _resolvedColors.emplace(attr, colors);
+    }
+    return colors;
+}
+
 // Routine Description:
 // - Helper called before a majority of paint operations to scroll most of the previous frame into the appropriate
 //   position before we paint the remaining invalid area.
@@ -882,6 +1587,54 @@ void Renderer::_PaintSelection(_In_ IRenderEngine* const pEngine)
 // - Helper to determine the selected region of the buffer.
 // Return Value:
 // - A vector of rectangles representing the regions to select, line by line.
+// Routine Description:
+// - Gets where the frame stats go on the screen: the right end of the top row.
+// Arguments:
+// - <none>
+// Return Value:
+// - The part of the screen the frame stats are painted in, inclusive.
+SMALL_RECT Renderer::_GetFrameStatsRect() const noexcept
+{
+    const auto width = _pData->GetViewport().Width();
+    const auto left = std::max<SHORT>(0, gsl::narrow_cast<SHORT>(width - s_FrameStatsWidth));
+    return { left, 0, gsl::narrow_cast<SHORT>(width - 1), 0 };
+}
+
+// Routine Description:
+// - Paint helper to show what an engine's last frame cost, on top of everything else.
+// - Only used when _fDebug is set.
+// Arguments:
+// - pEngine - The engine to paint with
+// - stats - The engine's last frame
+// Return Value:
+// - <none>
+void Renderer::_PaintFrameStats(_In_ IRenderEngine* const pEngine, const FrameStats& stats)
+{
+    wchar_t text[s_FrameStatsWidth + 1];
+    const auto written = swprintf_s(text,
+                                    L"%6.2fms %6zu cells %4llu co",
+                                    _tracing.ToMilliseconds(stats.total),
+                                    stats.dirtyCells,
+                                    stats.coalescedNotifications);
+    if (written <= 0)
+    {
+        return;
+    }
+
+    const auto rect = _GetFrameStatsRect();
+    const auto length = std::min(gsl::narrow_cast<size_t>(written), gsl::narrow_cast<size_t>(rect.Right - rect.Left + 1));
+
+    std::vector<Cluster> clusters;
+    clusters.reserve(length);
+    for (size_t i = 0; i < length; i++)
+    {
+        clusters.emplace_back(std::wstring_view{ &text[i], 1 }, 1);
+    }
+
+    THROW_IF_FAILED(_UpdateDrawingBrushes(pEngine, _pData->GetDefaultBrushColors(), false));
+    THROW_IF_FAILED(pEngine->PaintBufferLine({ clusters.data(), clusters.size() }, { rect.Left, rect.Top }, false));
+}
+
 std::vector<SMALL_RECT> Renderer::_GetSelectionRects() const
 {
     auto rects = _pData->GetSelectionRects();
@@ -904,6 +1657,22 @@ std::vector<SMALL_RECT> Renderer::_GetSelectionRects() const
     return result;
 }
 
+// Method Description:
+// - Gets what the frames painted so far have cost. The counts only ever go up, so the
+//   caller works out rates from the difference between two calls. Safe from any thread.
+// Arguments:
+// - <none>
+// Return Value:
+// - The frames painted, the cells they repainted and the time they took.
+Renderer::FrameCounters Renderer::GetFrameCounters() const noexcept
+{
+    FrameCounters counters{};
+    counters.frames = _framesPainted.load(std::memory_order_relaxed);
+    counters.dirtyCells = _dirtyCellsPainted.load(std::memory_order_relaxed);
+    counters.paintMilliseconds = _tracing.ToMilliseconds(_paintTicks.load(std::memory_order_relaxed));
+    return counters;
+}
+
 // Method Description:
 // - Adds another Render engine to this renderer. Future rendering calls will
 //      also be sent to the new renderer.
@@ -916,5 +1685,52 @@ std::vector<SMALL_RECT> Renderer::_GetSelectionRects() const
 void Renderer::AddRenderEngine(_In_ IRenderEngine* const pEngine)
 {
     THROW_IF_NULL_ALLOC(pEngine);
-    _rgpEngines.push_back(pEngine);
+    _AddEngine(pEngine, nullptr);
+}
+
+// Method Description:
+// - Adds another Render engine to this renderer, which paints its frames on a
+//      thread of its own instead of the renderer's. Use this for engines that
+//      can be slow to present a frame (e.g. one that writes to a pipe whose
+//      reader might not keep up), so that the other engines never have to
+//      wait for them. Invalidations are still sent to it like any other engine.
+// - The new thread starts out enabled for painting.
+// Arguments:
+// - pEngine: The new render engine to be added
+// Return Value:
+// - <none>
+// Throws if we ran out of memory or failed to create the thread.
+void Renderer::AddRenderEngineOnOwnThread(_In_ IRenderEngine* const pEngine)
+{
+    THROW_IF_NULL_ALLOC(pEngine);
+
+    auto thread = std::make_unique<RenderThread>();
+    THROW_IF_FAILED(thread->Initialize(this, pEngine));
+
+    // The thread can start painting as soon as it's enabled, so the engine is added first.
+    auto* const pThread = thread.get();
+    _AddEngine(pEngine, std::move(thread));
+    pThread->EnablePainting();
+}
+
+// Routine Description:
+// - Fills in the next free slot with an engine and only then counts it in, so that
+//      anyone walking the engines on another thread sees all of it or none of it.
+// Arguments:
+// - pEngine: The engine to add
+// - thread: The thread the engine paints on, or nullptr if the renderer's own thread paints it
+// Return Value:
+// - <none>
+// Throws if there's no slot left for the engine.
+void Renderer::_AddEngine(IRenderEngine* const pEngine, std::unique_ptr<RenderThread> thread)
+{
+    std::lock_guard<std::mutex> guard{ _addEngineLock };
+
+    const auto index = _engineCount.load(std::memory_order_relaxed);
+    THROW_HR_IF(E_OUTOFMEMORY, index >= MaxEngines);
+
+    _engines.at(index) = pEngine;
+    _engineThreads.at(index) = std::move(thread);
+    _frameStats.at(index) = {};
+    _engineCount.store(index + 1, std::memory_order_release);
 }
@@ -21,6 +21,7 @@ Author(s):
 #include "../inc/IRenderData.hpp"
 
 #include "thread.hpp"
+#include "FrameTracing.hpp"
 
 #include "../../buffer/out/textBuffer.hpp"
 #include "../../buffer/out/CharRow.hpp"
@@ -46,6 +47,7 @@ namespace Microsoft::Console::Render
         virtual ~Renderer() override;
 
         [[nodiscard]] HRESULT PaintFrame();
+        [[nodiscard]] HRESULT PaintFrame(_In_ IRenderEngine* const pEngine) override;
 
         void TriggerSystemRedraw(const RECT* const prcDirtyClient) override;
         void TriggerRedraw(const Microsoft::Console::Types::Viewport& region) override;
@@ -57,10 +59,14 @@ namespace Microsoft::Console::Render
         void TriggerSelection() override;
         void TriggerScroll() override;
         void TriggerScroll(const COORD* const pcoordDelta) override;
+        void TriggerScrollRows(const Microsoft::Console::Types::Viewport& rows, const SHORT delta) override;
 
         void TriggerCircling() override;
         void TriggerTitleChange() override;
 
+        void BeginSynchronizedUpdate() override;
+        void EndSynchronizedUpdate() override;
+
         void TriggerFontChange(const int iDpi,
                                const FontInfoDesired& FontInfoDesired,
                                _Out_ FontInfo& FontInfo) override;
@@ -75,15 +81,40 @@ namespace Microsoft::Console::Render
         void WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs) override;
 
         void AddRenderEngine(_In_ IRenderEngine* const pEngine) override;
+        void AddRenderEngineOnOwnThread(_In_ IRenderEngine* const pEngine) override;
+
+        // What every frame painted so far has cost, summed over all the engines.
+        struct FrameCounters
+        {
+            uint64_t frames;
+            uint64_t dirtyCells;
+            double paintMilliseconds; // from the start of the frame until it was presented
+        };
+        FrameCounters GetFrameCounters() const noexcept;
 
     private:
-        std::deque<IRenderEngine*> _rgpEngines;
+        // The engines, in the order they were added. A slot is filled in before _engineCount takes
+        // it in and isn't changed after that, so the engines can be walked from any thread without
+        // a lock, even while another one is being added. Adding them is serialized by _addEngineLock.
+        static constexpr size_t MaxEngines = 4;
+        std::array<IRenderEngine*, MaxEngines> _engines{};
+        std::atomic<size_t> _engineCount{ 0 };
+        std::mutex _addEngineLock;
+        void _AddEngine(IRenderEngine* const pEngine, std::unique_ptr<RenderThread> thread);
+        gsl::span<IRenderEngine* const> _GetEngines() const noexcept;
+        size_t _GetEngineIndex(const IRenderEngine* const pEngine) const noexcept;
 
         IRenderData* _pData; // Non-ownership pointer
 
         std::unique_ptr<IRenderThread> _pThread;
         bool _destructing = false;
 
+        // The thread of each engine that paints on one of its own instead of _pThread, in the
+        // engine's slot. The slots of the engines that _pThread paints are empty.
+        std::array<std::unique_ptr<RenderThread>, MaxEngines> _engineThreads;
+        bool _HasOwnThread(const IRenderEngine* const pEngine) const noexcept;
+        gsl::span<const std::unique_ptr<RenderThread>> _GetEngineThreads() const noexcept;
+
         void _NotifyPaintFrame();
 
         [[nodiscard]] HRESULT _PaintFrameForEngine(_In_ IRenderEngine* const pEngine);
@@ -98,6 +129,69 @@ namespace Microsoft::Console::Render
                                       TextBufferCellIterator it,
                                       const COORD target);
 
+        // The cells of one row of text, read out of a buffer so that they can be turned into clusters for painting.
+        struct ClusterRow
+        {
+            struct Cell
+            {
+                size_t offset; // where the cell's text starts in text
+                size_t length;
+                size_t columns;
+                TextAttribute attr;
+            };
+
+            std::wstring text; // the text of every cell, back to back
+            std::vector<Cell> cells;
+            uint64_t generation = 0; // generation of the buffer row when the cells were read from it
+            uint64_t lastUsed = 0; // _clusterCachePaint when the row was last painted
+        };
+
+        // The rows of the text buffer that have been read into cells, keyed by their storage key (which
+        // stays with a row wherever it moves), so that rows that haven't changed since they were last read
+        // are painted again without walking the buffer. That's across frames as well as across engines.
+        // A row is read again once its generation moves on, or once it's invalidated through any of the Trigger*s.
+        std::unordered_map<UnicodeStorage::row_key_type, ClusterRow> _clusterCache;
+        uint64_t _clusterCacheBufferId = 0; // the TextBuffer::GetId of the buffer the cached rows were read from
+        std::atomic<bool> _clusterCacheStale{ false }; // set when all of the cached rows have to be read again
+        uint64_t _clusterCachePaint = 0;
+
+        const ClusterRow& _GetClusterRow(const TextBuffer& buffer, const SHORT bufferRow);
+        void _ValidateClusterCache(const TextBuffer& buffer);
+
+        // A row of the buffer that has to be read (again) into its ClusterRow before it's painted.
+        struct RowToRead
+        {
+            SHORT bufferRow;
+            uint64_t generation; // of the buffer row, for the ClusterRow once it's been read
+            ClusterRow* row;
+        };
+        static void s_ReadBufferRow(const TextBuffer& buffer, const RowToRead& rowToRead);
+
+        // The dirty rows of a frame that changed since they were last read. When there are enough of them
+        // (a full repaint of a large screen, after a resize or a switch to the alternate buffer, say), they're
+        // read on the thread pool before any of them is painted, and then painted in order on this thread.
+        // Each row is a separate ClusterRow, and reading doesn't change the buffer, so the readers don't
+        // have to coordinate beyond taking the next row in line.
+        static constexpr size_t s_MinRowsToReadInParallel = 32;
+        static constexpr size_t s_RowReaderHelpers = 3;
+        std::vector<RowToRead> _rowsToRead;
+        const TextBuffer* _rowsToReadBuffer = nullptr;
+        std::atomic<size_t> _nextRowToRead{ 0 };
+        std::atomic<HRESULT> _rowsToReadResult{ S_OK };
+        wil::unique_threadpool_work _readRowsWork;
+
+        void _ReadDirtyClusterRows(const TextBuffer& buffer, const Microsoft::Console::Types::Viewport& view);
+        void _ReadQueuedRows() noexcept;
+        static void CALLBACK s_ReadRowsCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work) noexcept;
+        void _InvalidateClusterRows(const Microsoft::Console::Types::Viewport& region) noexcept;
+        static void s_ReadClusterRow(TextBufferCellIterator it, ClusterRow& row);
+
+        void _PaintClusterRow(_In_ IRenderEngine* const pEngine,
+                              const ClusterRow& row,
+                              const size_t begin,
+                              const size_t end,
+                              const COORD target);
+
         static IRenderEngine::GridLines s_GetGridlines(const TextAttribute& textAttribute) noexcept;
 
         void _PaintBufferOutputGridLineHelper(_In_ IRenderEngine* const pEngine,
@@ -113,17 +207,61 @@ namespace Microsoft::Console::Render
 
         [[nodiscard]] HRESULT _UpdateDrawingBrushes(_In_ IRenderEngine* const pEngine, const TextAttribute attr, const bool isSettingDefaultBrushes);
 
+        // The foreground and background that each attribute painted in the current frame resolved to, so that
+        // every run of an attribute after the first costs one lookup instead of a trip through the render data.
+        // The color table and the default colors only change while the console is unlocked, so this is emptied
+        // at the start of every frame once the lock is held. Past s_MaxResolvedColors (a truecolor gradient,
+        // say) attributes are resolved without being kept, since they're unlikely to come up again.
+        static constexpr size_t s_MaxResolvedColors = 256;
+        std::unordered_map<TextAttribute, std::pair<COLORREF, COLORREF>> _resolvedColors;
+        std::pair<COLORREF, COLORREF> _ResolveColors(const TextAttribute& attr);
+
         [[nodiscard]] HRESULT _PerformScrolling(_In_ IRenderEngine* const pEngine);
 
+        [[nodiscard]] HRESULT _UpdateDirtyRows(_In_ IRenderEngine* const pEngine) noexcept;
+
+        // The columns of each row of the screen that need to be painted in the current frame, as
+        // [left, right). These are gathered from the engine's dirty area, so a row that's covered
+        // by more than one of its rectangles is still only painted once. A row with right <= left is clean.
+        std::vector<std::pair<SHORT, SHORT>> _dirtyRows;
+
         SMALL_RECT _srViewportPrevious;
 
         std::vector<SMALL_RECT> _GetSelectionRects() const;
         std::vector<SMALL_RECT> _previousSelection;
+        static std::vector<SMALL_RECT> s_GetChangedSelectionRects(const std::vector<SMALL_RECT>& previous,
+                                                                  const std::vector<SMALL_RECT>& current);
 
         [[nodiscard]] HRESULT _PaintTitle(IRenderEngine* const pEngine);
 
+        // What the frames of each engine have cost, in the engine's slot. It's reset as the engine
+        // is added, so that painting (which for some engines happens on their own thread) only
+        // updates its own.
+        struct EngineFrameStats
+        {
+            FrameStats lastFrame;
+            uint64_t notificationsSeen = 0; // _paintNotifications when the engine's last frame started
+            uint64_t framesSkipped = 0;
+            uint64_t writesSeen = 0; // the output writes shown by the engine's last frame, for OutputTracing
+        };
+        std::array<EngineFrameStats, MaxEngines> _frameStats{};
+        std::atomic<uint64_t> _paintNotifications{ 0 };
+        FrameTracing _tracing;
+
+        // The sums behind GetFrameCounters. The time is in performance counter ticks.
+        std::atomic<uint64_t> _framesPainted{ 0 };
+        std::atomic<uint64_t> _dirtyCellsPainted{ 0 };
+        std::atomic<LONGLONG> _paintTicks{ 0 };
+
         // Helper functions to diagnose issues with painting and layout.
         // These are only actually effective/on in Debug builds when the flag is set using an attached debugger.
         bool _fDebug = false;
+
+        // With _fDebug set, the engines that paint on the shared thread show what their last frame cost
+        // in the top right corner of the screen. The others are headless (like VT), where the text
+        // would end up in their output.
+        static constexpr SHORT s_FrameStatsWidth = 32;
+        SMALL_RECT _GetFrameStatsRect() const noexcept;
+        void _PaintFrameStats(_In_ IRenderEngine* const pEngine, const FrameStats& stats);
     };
 }
@@ -11,11 +11,18 @@ using namespace Microsoft::Console::Render;
 
 RenderThread::RenderThread() :
     _pRenderer(nullptr),
+    _pEngine(nullptr),
     _hThread(nullptr),
     _hEvent(nullptr),
+    _fPaintPending(false),
     _hPaintCompletedEvent(nullptr),
     _fKeepRunning(true),
-    _hPaintEnabledEvent(nullptr)
+    _hPaintEnabledEvent(nullptr),
+    _hSynchronizedUpdateEndedEvent(nullptr),
+    _ullSynchronizedUpdateDeadline(0),
+    _hDwmApi(),
+    _pfnDwmGetCompositionTimingInfo(nullptr),
+    _llPerformanceFrequency(0)
 {
 }
 
@@ -24,6 +31,7 @@ RenderThread::~RenderThread()
     if (_hThread)
     {
         _fKeepRunning = false; // stop loop after final run
+        SetEvent(_hPaintEnabledEvent); // painting may have been disabled, which would keep the thread from getting there
         SignalObjectAndWait(_hEvent, _hThread, INFINITE, FALSE); // signal final paint and wait for thread to finish.
 
         CloseHandle(_hThread);
@@ -47,6 +55,12 @@ RenderThread::~RenderThread()
         CloseHandle(_hPaintCompletedEvent);
         _hPaintCompletedEvent = nullptr;
     }
+
+    if (_hSynchronizedUpdateEndedEvent)
+    {
+        CloseHandle(_hSynchronizedUpdateEndedEvent);
+        _hSynchronizedUpdateEndedEvent = nullptr;
+    }
 }
 
 // Method Description:
@@ -59,8 +73,27 @@ RenderThread::~RenderThread()
 // - S_OK if we succeeded, else an HRESULT corresponding to a failure to create
 //      an Event or Thread.
 [[nodiscard]] HRESULT RenderThread::Initialize(IRenderer* const pRendererParent) noexcept
+{
+    return Initialize(pRendererParent, nullptr);
+}
+
+// Method Description:
+// - Create all of the Events we'll need, and the actual thread we'll be doing
+//      work on. The thread only paints frames for the given engine, so that
+//      it's never held up by (and never holds up) the renderer's other engines.
+// Arguments:
+// - pRendererParent: the IRenderer that owns this thread, and which we should
+//      trigger frames for.
+// - pEngine: the engine to paint frames for. If this is nullptr, we paint
+//      all of the engines that don't have a thread of their own.
+// Return Value:
+// - S_OK if we succeeded, else an HRESULT corresponding to a failure to create
+//      an Event or Thread.
+[[nodiscard]] HRESULT RenderThread::Initialize(IRenderer* const pRendererParent,
+                                               IRenderEngine* const pEngine) noexcept
 {
     _pRenderer = pRendererParent;
+    _pEngine = pEngine;
 
     HRESULT hr = S_OK;
     // Create event before thread as thread will start immediately.
@@ -116,6 +149,39 @@ RenderThread::~RenderThread()
         }
     }
 
+    if (SUCCEEDED(hr))
+    {
+        HANDLE hSynchronizedUpdateEndedEvent = CreateEventW(nullptr,
+                                                            TRUE, // manual reset event
+                                                            TRUE, // initially signaled
+                                                            nullptr);
+
+        if (hSynchronizedUpdateEndedEvent == nullptr)
+        {
+            hr = HRESULT_FROM_WIN32(GetLastError());
+        }
+        else
+        {
+            _hSynchronizedUpdateEndedEvent = hSynchronizedUpdateEndedEvent;
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        // Frames are paced by a fixed limit instead if DWM or its timing info isn't
+        // around, so this is allowed to fail. It has to be loaded before the thread starts.
+        LARGE_INTEGER liFrequency;
+        QueryPerformanceFrequency(&liFrequency);
+        _llPerformanceFrequency = liFrequency.QuadPart;
+
+        // NOTE: Use LOAD_LIBRARY_SEARCH_SYSTEM32 to avoid unneeded directory traversal.
+        _hDwmApi.reset(LoadLibraryExW(L"dwmapi.dll", nullptr, LOAD_LIBRARY_SEARCH_SYSTEM32));
+        if (_hDwmApi)
+        {
+            _pfnDwmGetCompositionTimingInfo = reinterpret_cast<PfnDwmGetCompositionTimingInfo>(GetProcAddress(_hDwmApi.get(), "DwmGetCompositionTimingInfo"));
+        }
+    }
+
     if (SUCCEEDED(hr))
     {
         HANDLE hThread = CreateThread(nullptr, // non-inheritable security attributes
@@ -160,25 +226,115 @@ DWORD WINAPI RenderThread::_ThreadProc()
         WaitForSingleObject(_hPaintEnabledEvent, INFINITE);
         WaitForSingleObject(_hEvent, INFINITE);
 
+        // Anything that changes from here on needs another frame. What changed
+        // before is picked up by this one, as it's read under the lock.
+        _fPaintPending = false;
+
+        // If the app is partway through a synchronized update, hold the frame
+        // until it's done, so that we don't paint half of it. An app that never
+        // ends its update can only hold us up until the deadline, though.
+        const ULONGLONG ullDeadline = _ullSynchronizedUpdateDeadline;
+        const ULONGLONG ullNow = GetTickCount64();
+        if (ullDeadline > ullNow)
+        {
+            WaitForSingleObject(_hSynchronizedUpdateEndedEvent, static_cast<DWORD>(ullDeadline - ullNow));
+        }
+
+        LARGE_INTEGER liFrameStart;
+        QueryPerformanceCounter(&liFrameStart);
+
         ResetEvent(_hPaintCompletedEvent);
 
-        LOG_IF_FAILED(_pRenderer->PaintFrame());
+        if (_pEngine)
+        {
+            LOG_IF_FAILED(_pRenderer->PaintFrame(_pEngine));
+        }
+        else
+        {
+            LOG_IF_FAILED(_pRenderer->PaintFrame());
+        }
 
         SetEvent(_hPaintCompletedEvent);
 
         // extra check before we sleep since it's a "long" activity, relatively speaking.
+        // Once we're done sleeping, we go back to waiting on _hEvent, so nothing
+        // wakes us up again while there's nothing to paint.
         if (_fKeepRunning)
         {
-            Sleep(s_FrameLimitMilliseconds);
+            const DWORD dwDelay = _GetFrameDelay(liFrameStart.QuadPart);
+            if (dwDelay > 0)
+            {
+                Sleep(dwDelay);
+            }
         }
     }
 
     return S_OK;
 }
 
+// Method Description:
+// - Figures out how long to wait after painting before the next frame may start.
+//      When DWM can tell us when the display refreshes, the next frame starts
+//      on the first vblank that's at least a refresh period after this frame
+//      started, so that we paint at most once per refresh, in step with it.
+//      Otherwise it starts s_FrameLimitMilliseconds after this frame did.
+//      Either way, the time this frame took to paint comes out of the wait.
+// Arguments:
+// - llFrameStart: the performance counter at the start of this frame.
+// Return Value:
+// - the number of milliseconds to wait. 0 if the next frame can start right away.
+DWORD RenderThread::_GetFrameDelay(const LONGLONG llFrameStart) const noexcept
+{
+    LARGE_INTEGER liNow;
+    QueryPerformanceCounter(&liNow);
+    const LONGLONG llNow = liNow.QuadPart;
+
+    if (_llPerformanceFrequency <= 0)
+    {
+        return s_FrameLimitMilliseconds;
+    }
+
+    LONGLONG llNextFrame = llFrameStart + (_llPerformanceFrequency * s_FrameLimitMilliseconds) / 1000;
+
+    if (_pfnDwmGetCompositionTimingInfo)
+    {
+        DWM_TIMING_INFO timingInfo = { 0 };
+        timingInfo.cbSize = sizeof(timingInfo);
+        if (SUCCEEDED(_pfnDwmGetCompositionTimingInfo(nullptr, &timingInfo)) && timingInfo.qpcRefreshPeriod > 0)
+        {
+            const auto llPeriod = static_cast<LONGLONG>(timingInfo.qpcRefreshPeriod);
+            const auto llVBlank = static_cast<LONGLONG>(timingInfo.qpcVBlank);
+
+            // Round up to the first vblank at or after a whole period past the start of the frame.
+            const LONGLONG llEarliest = llFrameStart + llPeriod;
+            const LONGLONG llPeriodsAfterVBlank = std::max(0LL, (llEarliest - llVBlank + llPeriod - 1) / llPeriod);
+            llNextFrame = llVBlank + llPeriodsAfterVBlank * llPeriod;
+        }
+    }
+
+    if (llNextFrame <= llNow)
+    {
+        return 0;
+    }
+
+    const LONGLONG llDelayMilliseconds = ((llNextFrame - llNow) * 1000) / _llPerformanceFrequency;
+    return static_cast<DWORD>(std::min<LONGLONG>(llDelayMilliseconds, s_MaxFrameDelayMilliseconds));
+}
+
+// Method Description:
+// - Lets the thread know there's something to paint. Clients that write a line
+//      or a character at a time cause many of these for every frame we paint,
+//      so only the first one since the thread last woke up signals it.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
 void RenderThread::NotifyPaint()
 {
-    SetEvent(_hEvent);
+    if (!_fPaintPending.exchange(true))
+    {
+        SetEvent(_hEvent);
+    }
 }
 
 void RenderThread::EnablePainting()
@@ -186,6 +342,33 @@ void RenderThread::EnablePainting()
     SetEvent(_hPaintEnabledEvent);
 }
 
+// Method Description:
+// - Holds back frames while an app is in the middle of redrawing, so that its
+//      update is painted in one go instead of at whatever point the thread
+//      happens to wake up. Frames are only held until the timeout runs out.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void RenderThread::BeginSynchronizedUpdate()
+{
+    ResetEvent(_hSynchronizedUpdateEndedEvent);
+    _ullSynchronizedUpdateDeadline = GetTickCount64() + s_SynchronizedUpdateTimeoutMilliseconds;
+}
+
+// Method Description:
+// - Ends a synchronized update. Anything invalidated during the update is
+//      painted right away.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void RenderThread::EndSynchronizedUpdate()
+{
+    _ullSynchronizedUpdateDeadline = 0;
+    SetEvent(_hSynchronizedUpdateEndedEvent);
+}
+
 void RenderThread::WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs)
 {
     // When rendering takes place via DirectX, and a console application
@@ -17,6 +17,8 @@ Author(s):
 #include "..\inc\IRenderer.hpp"
 #include "..\inc\IRenderThread.hpp"
 
+#include <dwmapi.h>
+
 namespace Microsoft::Console::Render
 {
     class RenderThread final : public IRenderThread
@@ -26,25 +28,55 @@ namespace Microsoft::Console::Render
         virtual ~RenderThread() override;
 
         [[nodiscard]] HRESULT Initialize(_In_ IRenderer* const pRendererParent) noexcept;
+        [[nodiscard]] HRESULT Initialize(_In_ IRenderer* const pRendererParent,
+                                         _In_ IRenderEngine* const pEngine) noexcept;
 
         void NotifyPaint() override;
 
         void EnablePainting() override;
         void WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs) override;
+        void BeginSynchronizedUpdate() override;
+        void EndSynchronizedUpdate() override;
 
     private:
         static DWORD WINAPI s_ThreadProc(_In_ LPVOID lpParameter);
         DWORD WINAPI _ThreadProc();
 
+        // The shortest time between the start of two frames when we can't find out how often the display refreshes.
         static DWORD const s_FrameLimitMilliseconds = 8;
 
+        // The longest we ever wait between frames, whatever DWM says the refresh rate is.
+        static DWORD const s_MaxFrameDelayMilliseconds = 50;
+
+        // The longest an app can hold back frames with a synchronized update before we paint anyway.
+        static DWORD const s_SynchronizedUpdateTimeoutMilliseconds = 150;
+
         HANDLE _hThread;
         HANDLE _hEvent;
 
+        // Set from the first NotifyPaint after we wake up until we wake up again, so that
+        // a burst of small writes signals _hEvent once rather than once for each change.
+        std::atomic<bool> _fPaintPending;
+
         HANDLE _hPaintEnabledEvent;
         HANDLE _hPaintCompletedEvent;
 
+        // Signaled whenever there's no synchronized update underway.
+        HANDLE _hSynchronizedUpdateEndedEvent;
+        // Tick count at which the current synchronized update stops holding back frames.
+        std::atomic<ULONGLONG> _ullSynchronizedUpdateDeadline;
+
+        // DWM tells us when the display refreshes, so that frames can be lined up with it.
+        // It's loaded on demand since it isn't available everywhere we run.
+        typedef HRESULT(WINAPI* PfnDwmGetCompositionTimingInfo)(HWND, DWM_TIMING_INFO*);
+        wil::unique_hmodule _hDwmApi;
+        PfnDwmGetCompositionTimingInfo _pfnDwmGetCompositionTimingInfo;
+        LONGLONG _llPerformanceFrequency;
+
+        DWORD _GetFrameDelay(const LONGLONG llFrameStart) const noexcept;
+
         IRenderer* _pRenderer; // Non-ownership pointer
+        IRenderEngine* _pEngine; // Non-ownership pointer. nullptr if we paint all of the renderer's shared engines.
 
         bool _fKeepRunning;
     };
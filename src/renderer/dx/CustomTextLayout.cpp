@@ -4,6 +4,8 @@
 #include "precomp.h"
 
 #include "CustomTextLayout.h"
+#include "ShapedRunCache.h"
+#include "FontFallbackCache.h"
 
 #include <wrl.h>
 #include <wrl/client.h>
@@ -20,12 +22,14 @@ using namespace Microsoft::Console::Render;
 // - font - The DirectWrite font face to use while calculating layout (by default, will fallback if necessary)
 // - clusters - From the backing buffer, the text to be displayed clustered by the columns it should consume.
 // - width - The count of pixels available per column (the expected pixel width of every column)
+// - cache - Optionally, where to look for this text having been laid out before and to keep the results of laying it out.
 CustomTextLayout::CustomTextLayout(IDWriteFactory1* const factory,
                                    IDWriteTextAnalyzer1* const analyzer,
                                    IDWriteTextFormat* const format,
                                    IDWriteFontFace1* const font,
                                    std::basic_string_view<Cluster> const clusters,
-                                   size_t const width) :
+                                   size_t const width,
+                                   ShapedRunCache* const cache) :
     _factory{ factory },
     _analyzer{ analyzer },
     _format{ format },
@@ -36,7 +40,8 @@ CustomTextLayout::CustomTextLayout(IDWriteFactory1* const factory,
     _runs{},
     _breakpoints{},
     _runIndex{ 0 },
-    _width{ width }
+    _width{ width },
+    _cache{ cache }
 {
     // Fetch the locale name out once now from the format
     _localeName.resize(format->GetLocaleNameLength() + 1); // +1 for null
@@ -77,6 +82,8 @@ CustomTextLayout::CustomTextLayout(IDWriteFactory1* const factory,
 //   the context information.
 // - This specific class does the layout calculations and complexity analysis, not the
 //   final drawing. That's the renderer's job (passed in.)
+// - If this layout was given a cache, text that was laid out before is drawn
+//   straight from the cached results, without any analysis or shaping.
 // Arguments:
 // - clientDrawingContext - Optional pointer to information that the renderer might need
 //                          while attempting to graphically place the text onto the screen
@@ -90,10 +97,43 @@ CustomTextLayout::CustomTextLayout(IDWriteFactory1* const factory,
                                                                FLOAT originX,
                                                                FLOAT originY)
 {
-    RETURN_IF_FAILED(_AnalyzeRuns());
-    RETURN_IF_FAILED(_ShapeGlyphRuns());
-    RETURN_IF_FAILED(_CorrectGlyphRuns());
-    RETURN_IF_FAILED(_DrawGlyphRuns(clientDrawingContext, renderer, { originX, originY }));
+    try
+    {
+        const std::basic_string_view<UINT16> columns{ _textClusterColumns.data(), _textClusterColumns.size() };
+
+        if (_cache)
+        {
+            _cache->SetFont(_font.Get(), _format->GetFontSize(), _width);
+
+            if (const auto shaped = _cache->Find(_text, columns))
+            {
+                _runs = shaped->runs;
+                _glyphOffsets = shaped->glyphOffsets;
+                _glyphClusters = shaped->glyphClusters;
+                _glyphIndices = shaped->glyphIndices;
+                _glyphAdvances = shaped->glyphAdvances;
+
+                return _DrawGlyphRuns(clientDrawingContext, renderer, { originX, originY });
+            }
+        }
+
+        RETURN_IF_FAILED(_AnalyzeRuns());
+        RETURN_IF_FAILED(_ShapeGlyphRuns());
+        RETURN_IF_FAILED(_CorrectGlyphRuns());
+
+        if (_cache)
+        {
+            // Failing to remember the layout only costs us doing it again next time.
+            try
+            {
+                _cache->Store(_text, columns, { _runs, _glyphOffsets, _glyphClusters, _glyphIndices, _glyphAdvances });
+            }
+            CATCH_LOG();
+        }
+
+        RETURN_IF_FAILED(_DrawGlyphRuns(clientDrawingContext, renderer, { originX, originY }));
+    }
+    CATCH_RETURN();
 
     return S_OK;
 }
@@ -776,6 +816,9 @@ CustomTextLayout::CustomTextLayout(IDWriteFactory1* const factory,
 #pragma region internal methods for mimicing text analyzer pattern but for font fallback
 // Routine Description:
 // - Mimics an IDWriteTextAnalyser but for font fallback calculations.
+// - What fallback picks for a piece of text only depends on the font it starts from, so
+//   every layout in the process shares its results through the FontFallbackCache.
+//   Only the text that isn't in there (or in our own font) goes through fallback.
 // Arguments:
 // - source - a text analysis source to retrieve substrings of the text to be analyzed
 // - textPosition - the index to start the substring operation
@@ -814,29 +857,120 @@ CustomTextLayout::CustomTextLayout(IDWriteFactory1* const factory,
             factory2->GetSystemFontFallback(&fallback);
         }
 
-        // Walk through and analyze the entire string
-        while (textLength > 0)
+        auto& cache = FontFallbackCache::Instance();
+        const FontFallbackCache::BaseFont baseFont{ familyName.c_str(), _localeName.c_str(), weight, style, stretch };
+
+        // Pieces of text next to each other that use the same font are set as one,
+        // so that they're shaped together.
+        UINT32 pendingPosition = textPosition;
+        UINT32 pendingLength = 0;
+        FontFallbackCache::Mapping pending{};
+        const auto setMappedFont = [&](const UINT32 position, const UINT32 length, const FontFallbackCache::Mapping& mapping) -> HRESULT {
+            if (pendingLength != 0 && pending.fontFace == mapping.fontFace && pending.scale == mapping.scale)
+            {
+                pendingLength += length;
+                return S_OK;
+            }
+
+            if (pendingLength != 0)
+            {
+                RETURN_IF_FAILED(_SetMappedFont(pendingPosition, pendingLength, pending.fontFace.Get(), pending.scale));
+            }
+
+            pendingPosition = position;
+            pendingLength = length;
+            pending = mapping;
+            return S_OK;
+        };
+
+        // Finds what a segment maps to without running fallback: a single codepoint
+        // that our own font has a glyph for stays in it, everything else comes from the cache.
+        const std::wstring_view text{ _text };
+        const auto findMapping = [&](const std::wstring_view segment, FontFallbackCache::Mapping& mapping) -> bool {
+            if (segment.size() == 1)
+            {
+                const UINT32 codepoint = segment.front();
+                UINT16 glyphIndex = 0;
+                if (SUCCEEDED(_font->GetGlyphIndicesW(&codepoint, 1, &glyphIndex)) && glyphIndex != 0)
+                {
+                    mapping = { nullptr, 1.0f };
+                    return true;
+                }
+            }
+            return cache.FindFallback(segment, baseFont, mapping);
+        };
+
+        const auto textEnd = textPosition + textLength;
+        while (textPosition < textEnd)
+        {
+            auto segmentLength = gsl::narrow<UINT32>(FontFallbackCache::SegmentLength(text.substr(textPosition, textEnd - textPosition)));
+
+            FontFallbackCache::Mapping mapping;
+            if (findMapping(text.substr(textPosition, segmentLength), mapping))
+            {
+                RETURN_IF_FAILED(setMappedFont(textPosition, segmentLength, mapping));
+                textPosition += segmentLength;
+                continue;
+            }
+
+            // Gather up the segments up to the next one we know and run fallback on all of them at once.
+            std::vector<std::pair<UINT32, UINT32>> unknown;
+            auto unknownEnd = textPosition;
+            do
+            {
+                unknown.emplace_back(unknownEnd, segmentLength);
+                unknownEnd += segmentLength;
+                segmentLength = gsl::narrow<UINT32>(FontFallbackCache::SegmentLength(text.substr(unknownEnd, textEnd - unknownEnd)));
+            } while (unknownEnd < textEnd && !findMapping(text.substr(unknownEnd, segmentLength), mapping));
+
+            auto nextUnknown = unknown.cbegin();
+            while (textPosition < unknownEnd)
+            {
+                UINT32 mappedLength = 0;
+                ::Microsoft::WRL::ComPtr<IDWriteFont> mappedFont;
+                FLOAT scale = 0.0f;
+
+                RETURN_IF_FAILED(fallback->MapCharacters(source,
+                                                         textPosition,
+                                                         unknownEnd - textPosition,
+                                                         collection.Get(),
+                                                         familyName.data(),
+                                                         weight,
+                                                         style,
+                                                         stretch,
+                                                         &mappedLength,
+                                                         &mappedFont,
+                                                         &scale));
+                RETURN_HR_IF(E_UNEXPECTED, mappedLength == 0);
+
+                FontFallbackCache::Mapping mapped{ nullptr, scale };
+                if (mappedFont)
+                {
+                    // Get font face from font metadata
+                    ::Microsoft::WRL::ComPtr<IDWriteFontFace> face;
+                    RETURN_IF_FAILED(mappedFont->CreateFontFace(&face));
+                    RETURN_IF_FAILED(face.As(&mapped.fontFace));
+                }
+
+                RETURN_IF_FAILED(setMappedFont(textPosition, mappedLength, mapped));
+
+                // Remember what fallback picked for each of the segments it mapped whole.
+                const auto mappedEnd = textPosition + mappedLength;
+                for (; nextUnknown != unknown.cend() && nextUnknown->first + nextUnknown->second <= mappedEnd; ++nextUnknown)
+                {
+                    if (nextUnknown->first >= textPosition)
+                    {
+                        cache.StoreFallback(text.substr(nextUnknown->first, nextUnknown->second), baseFont, mapped);
+                    }
+                }
+
+                textPosition = mappedEnd;
+            }
+        }
+
+        if (pendingLength != 0)
         {
-            UINT32 mappedLength = 0;
-            ::Microsoft::WRL::ComPtr<IDWriteFont> mappedFont;
-            FLOAT scale = 0.0f;
-
-            fallback->MapCharacters(source,
-                                    textPosition,
-                                    textLength,
-                                    collection.Get(),
-                                    familyName.data(),
-                                    weight,
-                                    style,
-                                    stretch,
-                                    &mappedLength,
-                                    &mappedFont,
-                                    &scale);
-
-            RETURN_IF_FAILED(_SetMappedFont(textPosition, mappedLength, mappedFont.Get(), scale));
-
-            textPosition += mappedLength;
-            textLength -= mappedLength;
+            RETURN_IF_FAILED(_SetMappedFont(pendingPosition, pendingLength, pending.fontFace.Get(), pending.scale));
         }
     }
     CATCH_RETURN();
@@ -850,12 +984,12 @@ CustomTextLayout::CustomTextLayout(IDWriteFactory1* const factory,
 // Arguments:
 // - textPosition - the index to start the substring operation
 // - textLength - the length of the substring operation
-// - font - the font that applies to the substring range
+// - fontFace - the font face that applies to the substring range, or null for our own font
 // - scale - the scale of the font to apply
 // - S_OK or appropriate STL/GSL failure code.
 [[nodiscard]] HRESULT STDMETHODCALLTYPE CustomTextLayout::_SetMappedFont(UINT32 textPosition,
                                                                          UINT32 textLength,
-                                                                         _In_ IDWriteFont* const font,
+                                                                         _In_opt_ IDWriteFontFace1* const fontFace,
                                                                          FLOAT const scale)
 {
     try
@@ -866,19 +1000,7 @@ CustomTextLayout::CustomTextLayout(IDWriteFactory1* const factory,
         {
             auto& run = _FetchNextRun(textLength);
 
-            if (font != nullptr)
-            {
-                // Get font face from font metadata
-                ::Microsoft::WRL::ComPtr<IDWriteFontFace> face;
-                RETURN_IF_FAILED(font->CreateFontFace(&face));
-
-                // QI for Face5 interface from base face interface, store into run
-                RETURN_IF_FAILED(face.As(&run.fontFace));
-            }
-            else
-            {
-                run.fontFace = _font;
-            }
+            run.fontFace = fontFace != nullptr ? fontFace : _font.Get();
 
             // Store the font scale as well.
             run.fontScale = scale;
@@ -14,6 +14,8 @@
 
 namespace Microsoft::Console::Render
 {
+    class ShapedRunCache;
+
     class CustomTextLayout : public ::Microsoft::WRL::RuntimeClass<::Microsoft::WRL::RuntimeClassFlags<::Microsoft::WRL::ClassicCom | ::Microsoft::WRL::InhibitFtmBase>, IDWriteTextAnalysisSource, IDWriteTextAnalysisSink>
     {
     public:
@@ -24,7 +26,8 @@ namespace Microsoft::Console::Render
                          IDWriteTextFormat* const format,
                          IDWriteFontFace1* const font,
                          const std::basic_string_view<::Microsoft::Console::Render::Cluster> clusters,
-                         size_t const width);
+                         size_t const width,
+                         ShapedRunCache* const cache = nullptr);
 
         [[nodiscard]] HRESULT STDMETHODCALLTYPE GetColumns(_Out_ UINT32* columns);
 
@@ -116,12 +119,24 @@ namespace Microsoft::Console::Render
             UINT32 nextRunIndex; // index of next run
         };
 
+    public:
+        // Everything that laying out the text produced and drawing it needs, as kept by a ShapedRunCache.
+        struct ShapedText
+        {
+            std::vector<LinkedRun> runs;
+            std::vector<DWRITE_GLYPH_OFFSET> glyphOffsets;
+            std::vector<UINT16> glyphClusters;
+            std::vector<UINT16> glyphIndices;
+            std::vector<float> glyphAdvances;
+        };
+
+    protected:
         [[nodiscard]] LinkedRun& _FetchNextRun(UINT32& textLength);
         void _SetCurrentRun(const UINT32 textPosition);
         void _SplitCurrentRun(const UINT32 splitPosition);
 
         [[nodiscard]] HRESULT STDMETHODCALLTYPE _AnalyzeFontFallback(IDWriteTextAnalysisSource* const source, UINT32 textPosition, UINT32 textLength);
-        [[nodiscard]] HRESULT STDMETHODCALLTYPE _SetMappedFont(UINT32 textPosition, UINT32 textLength, IDWriteFont* const font, FLOAT const scale);
+        [[nodiscard]] HRESULT STDMETHODCALLTYPE _SetMappedFont(UINT32 textPosition, UINT32 textLength, _In_opt_ IDWriteFontFace1* const fontFace, FLOAT const scale);
 
         [[nodiscard]] HRESULT _AnalyzeRuns() noexcept;
         [[nodiscard]] HRESULT _ShapeGlyphRuns() noexcept;
@@ -168,5 +183,8 @@ namespace Microsoft::Console::Render
         std::vector<UINT16> _glyphClusters;
         std::vector<UINT16> _glyphIndices;
         std::vector<float> _glyphAdvances;
+
+        // Where to find and keep the results of laying out lines, if anywhere
+        ShapedRunCache* const _cache;
     };
 }
@@ -255,7 +255,11 @@ void CustomTextRenderer::_FillRectangle(void* clientDrawingContext,
         rect.right += glyphRun->glyphAdvances[i];
     }
 
-    d2dContext->FillRectangle(rect, drawingContext->backgroundBrush);
+    // Without a background brush, the background has already been taken care of.
+    if (drawingContext->backgroundBrush)
+    {
+        d2dContext->FillRectangle(rect, drawingContext->backgroundBrush);
+    }
 
     // Now go onto drawing the text.
 
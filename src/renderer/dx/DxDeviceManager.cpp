@@ -0,0 +1,270 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "DxDeviceManager.h"
+
+using namespace Microsoft::Console::Render;
+
+// Routine Description:
+// - Takes the lock on the shared device context
+// Arguments:
+// - multithread - The lock of the Direct2D factory, which Direct2D takes whenever it uses the context.
+//                 Null if the factory doesn't have one, in which case there's nothing to take.
+DxDeviceManager::ContextLock::ContextLock(ID2D1Multithread* const multithread) noexcept :
+    _multithread{ multithread }
+{
+    if (_multithread)
+    {
+        _multithread->Enter();
+    }
+}
+
+// Routine Description:
+// - Lets go of the lock on the shared device context
+DxDeviceManager::ContextLock::~ContextLock()
+{
+    if (_multithread)
+    {
+        _multithread->Leave();
+    }
+}
+
+// Routine Description:
+// - Gets the manager shared by the whole process
+// Arguments:
+// - <none>
+// Return Value:
+// - The one and only manager
+DxDeviceManager& DxDeviceManager::Instance()
+{
+    static DxDeviceManager instance;
+    return instance;
+}
+
+// Routine Description:
+// - Gets the Direct2D factory every engine creates its render targets with, creating it
+//   the first time. It's multithreaded, since the engines paint on threads of their own.
+// Arguments:
+// - <none>
+// Return Value:
+// - The factory
+// Note: will throw exception if the factory can't be created
+[[nodiscard]] Microsoft::WRL::ComPtr<ID2D1Factory> DxDeviceManager::GetD2DFactory()
+{
+    std::lock_guard<std::mutex> lock{ _lock };
+
+    if (!_d2dFactory)
+    {
+        THROW_IF_FAILED(D2D1CreateFactory(D2D1_FACTORY_TYPE_MULTI_THREADED, IID_PPV_ARGS(&_d2dFactory)));
+
+        // Before Windows 8 (without the platform update), there's no lock to share with Direct2D.
+        LOG_IF_FAILED(_d2dFactory.As(&_multithread));
+    }
+
+    return _d2dFactory;
+}
+
+// Routine Description:
+// - Gets the device every engine draws with, creating it if there isn't one yet.
+//   If a new one is being made after the last was lost, waits for it.
+// Arguments:
+// - device - Filled with the device, its context, the DXGI factory to make swap chains with
+//            and the generation of the device
+// Return Value:
+// - S_OK or relevant DirectX error
+[[nodiscard]] HRESULT DxDeviceManager::GetDevice(_Out_ Device& device) noexcept
+{
+    device = {};
+
+    try
+    {
+        std::unique_lock<std::mutex> lock{ _lock };
+        _deviceReady.wait(lock, [&]() { return !_creating; });
+
+        if (!_device.d3dDevice)
+        {
+            RETURN_IF_FAILED(_CreateDevice());
+        }
+
+        device = _device;
+    }
+    CATCH_RETURN();
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Lets go of a device that was lost and starts making a new one on the thread pool.
+//   Once every engine reports the same device, only the first one does anything.
+// Arguments:
+// - generation - The generation of the device that was lost
+// Return Value:
+// - <none>
+void DxDeviceManager::ReportDeviceLost(const UINT64 generation) noexcept
+{
+    try
+    {
+        std::lock_guard<std::mutex> lock{ _lock };
+
+        if (generation == _generation)
+        {
+            _device = {};
+            ++_generation;
+
+            // If the work can't be queued, the next engine to ask for the device makes it itself.
+            _creating = true;
+            if (!TrySubmitThreadpoolCallback(s_CreateDeviceCallback, this, nullptr))
+            {
+                LOG_LAST_ERROR();
+                _creating = false;
+            }
+        }
+    }
+    CATCH_LOG();
+}
+
+// Routine Description:
+// - Checks whether a device is still the one engines should draw with
+// Arguments:
+// - generation - The generation of the device
+// Return Value:
+// - False once the device has been reported lost.
+[[nodiscard]] bool DxDeviceManager::IsCurrent(const UINT64 generation) const noexcept
+{
+    return generation == _generation;
+}
+
+// Routine Description:
+// - Checks whether asking for the device would return right away, rather than
+//   wait for a new one to be made after the last was lost.
+// Arguments:
+// - <none>
+// Return Value:
+// - False while a new device is being made.
+[[nodiscard]] bool DxDeviceManager::IsDeviceReady() const noexcept
+{
+    return !_creating;
+}
+
+// Routine Description:
+// - Waits for a new device that's being made to be ready, if there is one.
+// Arguments:
+// - timeoutMilliseconds - The longest to wait
+// Return Value:
+// - <none>
+void DxDeviceManager::WaitForDevice(const DWORD timeoutMilliseconds) noexcept
+{
+    try
+    {
+        std::unique_lock<std::mutex> lock{ _lock };
+        _deviceReady.wait_for(lock, std::chrono::milliseconds(timeoutMilliseconds), [&]() { return !_creating; });
+    }
+    CATCH_LOG();
+}
+
+// Routine Description:
+// - Takes the lock on the shared device context. It's needed around anything done with the
+//   context (or a swap chain on the device) other than through Direct2D, which takes it itself.
+// Arguments:
+// - <none>
+// Return Value:
+// - The lock, which is held until it goes away
+[[nodiscard]] DxDeviceManager::ContextLock DxDeviceManager::LockContext() const noexcept
+{
+    return ContextLock{ _multithread.Get() };
+}
+
+// Routine Description:
+// - Creates the device. Must be called with _lock held.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or relevant DirectX error
+[[nodiscard]] HRESULT DxDeviceManager::_CreateDevice() noexcept
+{
+    Device device;
+    RETURN_IF_FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&device.dxgiFactory)));
+
+    // The device is used from every engine's thread, so unlike a device of one engine's own,
+    // it can't be single threaded.
+    // For DX-specific work, D3D11_CREATE_DEVICE_DEBUG can be added to turn on the debug layer.
+    // It causes problems for folks who do not have the whole DirectX SDK installed, so it stays off otherwise.
+    // Find out more about the debug layer here:
+    // https://docs.microsoft.com/en-us/windows/desktop/direct3d11/overviews-direct3d-11-devices-layers
+    // You can find out how to install it here:
+    // https://docs.microsoft.com/en-us/windows/uwp/gaming/use-the-directx-runtime-and-visual-studio-graphics-diagnostic-features
+    const DWORD DeviceFlags = D3D11_CREATE_DEVICE_BGRA_SUPPORT;
+
+    D3D_FEATURE_LEVEL FeatureLevels[] = {
+        D3D_FEATURE_LEVEL_11_1,
+        D3D_FEATURE_LEVEL_11_0,
+        D3D_FEATURE_LEVEL_10_1,
+        D3D_FEATURE_LEVEL_10_0,
+        D3D_FEATURE_LEVEL_9_1,
+    };
+
+    // Trying hardware first for maximum performance, then trying WARP (software) renderer second
+    // in case we're running inside a downlevel VM where hardware passthrough isn't enabled like
+    // for Windows 7 in a VM.
+    const auto hardwareResult = D3D11CreateDevice(NULL,
+                                                  D3D_DRIVER_TYPE_HARDWARE,
+                                                  NULL,
+                                                  DeviceFlags,
+                                                  FeatureLevels,
+                                                  ARRAYSIZE(FeatureLevels),
+                                                  D3D11_SDK_VERSION,
+                                                  &device.d3dDevice,
+                                                  NULL,
+                                                  &device.d3dDeviceContext);
+
+    if (FAILED(hardwareResult))
+    {
+        RETURN_IF_FAILED(D3D11CreateDevice(NULL,
+                                           D3D_DRIVER_TYPE_WARP,
+                                           NULL,
+                                           DeviceFlags,
+                                           FeatureLevels,
+                                           ARRAYSIZE(FeatureLevels),
+                                           D3D11_SDK_VERSION,
+                                           &device.d3dDevice,
+                                           NULL,
+                                           &device.d3dDeviceContext));
+    }
+
+    device.generation = _generation;
+    _device = std::move(device);
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Makes a new device on the thread pool after the last one was lost, and lets
+//   the engines waiting for it know it's ready. If it fails, the next engine to
+//   ask for the device tries again.
+// Arguments:
+// - instance - Unused
+// - context - The manager
+// Return Value:
+// - <none>
+void CALLBACK DxDeviceManager::s_CreateDeviceCallback(PTP_CALLBACK_INSTANCE /*instance*/, PVOID context) noexcept
+{
+    auto& manager = *static_cast<DxDeviceManager*>(context);
+
+    try
+    {
+        std::lock_guard<std::mutex> lock{ manager._lock };
+        if (!manager._device.d3dDevice)
+        {
+            LOG_IF_FAILED(manager._CreateDevice());
+        }
+
+        // This has to change under the lock, or a waiter that just checked it could miss being woken.
+        manager._creating = false;
+    }
+    CATCH_LOG();
+
+    manager._creating = false;
+    manager._deviceReady.notify_all();
+}
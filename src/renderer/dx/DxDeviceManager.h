@@ -0,0 +1,74 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace Microsoft::Console::Render
+{
+    // Hands out the Direct3D device and the Direct2D factory that every engine in the process
+    // draws with, so that each pane only has its own swap chain and what's drawn on it.
+    // The device is made the first time an engine asks for it. If it's lost, whichever engine
+    // finds out first reports it here, and a new one is made on the thread pool, so that no
+    // engine's frame waits on it. Every engine moves over to the new device once it's ready.
+    // The device context is shared by all the engines, which paint on threads of their own, so
+    // anything that uses it outside of Direct2D has to hold LockContext while it does.
+    class DxDeviceManager final
+    {
+    public:
+        struct Device
+        {
+            ::Microsoft::WRL::ComPtr<ID3D11Device> d3dDevice;
+            ::Microsoft::WRL::ComPtr<ID3D11DeviceContext> d3dDeviceContext;
+            ::Microsoft::WRL::ComPtr<IDXGIFactory2> dxgiFactory;
+            UINT64 generation; // tells devices apart after one is lost
+        };
+
+        // Holds the lock on the shared device context for as long as it lives.
+        class ContextLock final
+        {
+        public:
+            explicit ContextLock(ID2D1Multithread* const multithread) noexcept;
+            ~ContextLock();
+
+            ContextLock(const ContextLock&) = delete;
+            ContextLock& operator=(const ContextLock&) = delete;
+
+        private:
+            ID2D1Multithread* const _multithread;
+        };
+
+        static DxDeviceManager& Instance();
+
+        [[nodiscard]] ::Microsoft::WRL::ComPtr<ID2D1Factory> GetD2DFactory();
+
+        [[nodiscard]] HRESULT GetDevice(_Out_ Device& device) noexcept;
+        void ReportDeviceLost(const UINT64 generation) noexcept;
+        [[nodiscard]] bool IsCurrent(const UINT64 generation) const noexcept;
+        [[nodiscard]] bool IsDeviceReady() const noexcept;
+        void WaitForDevice(const DWORD timeoutMilliseconds) noexcept;
+
+        [[nodiscard]] ContextLock LockContext() const noexcept;
+
+    private:
+        DxDeviceManager() = default;
+
+        std::mutex _lock;
+
+        ::Microsoft::WRL::ComPtr<ID2D1Factory> _d2dFactory;
+        ::Microsoft::WRL::ComPtr<ID2D1Multithread> _multithread;
+
+        Device _device;
+        std::atomic<UINT64> _generation{ 1 };
+
+        // Set while a new device is being made on the thread pool. _deviceReady is signaled once it's done.
+        std::atomic<bool> _creating{ false };
+        std::condition_variable _deviceReady;
+
+        [[nodiscard]] HRESULT _CreateDevice() noexcept;
+        static void CALLBACK s_CreateDeviceCallback(PTP_CALLBACK_INSTANCE instance, PVOID context) noexcept;
+    };
+}
@@ -5,6 +5,7 @@
 
 #include "DxRenderer.hpp"
 #include "CustomTextLayout.h"
+#include "FontFallbackCache.h"
 
 #include "../../interactivity/win32/CustomWindowMessages.h"
 #include "../../types/inc/Viewport.hpp"
@@ -29,9 +30,20 @@ DxEngine::DxEngine() :
     _invalidScroll{ 0 },
     _presentParams{ 0 },
     _presentReady{ false },
+    _presentPartial{ false },
     _presentScroll{ 0 },
     _presentDirty{ 0 },
     _presentOffset{ 0 },
+    _firstFrame{ true },
+    _scrollbackTexture{},
+    _scrollbackRows{},
+    _scrollbackRowHeight{ 0 },
+    _scrollbackPending{},
+    _scrollbackRestored{ 0 },
+    _scrollbackSaved{ false },
+    _viewportTop{ 0 },
+    _scrollbackViewportTop{ 0 },
+    _selectionShown{ false },
     _isEnabled{ false },
     _isPainting{ false },
     _displaySizePixels{ 0 },
@@ -39,14 +51,29 @@ DxEngine::DxEngine() :
     _backgroundColor{ 0 },
     _glyphCell{ 0 },
     _haveDeviceResources{ false },
+    _deviceGeneration{ 0 },
     _hwndTarget{ static_cast<HWND>(INVALID_HANDLE_VALUE) },
     _sizeTarget{ 0 },
     _dpi{ USER_DEFAULT_SCREEN_DPI },
     _scale{ 1.0f },
     _chainMode{ SwapChainMode::ForComposition },
-    _customRenderer{ ::Microsoft::WRL::Make<CustomTextRenderer>() }
+    _customRenderer{ ::Microsoft::WRL::Make<CustomTextRenderer>() },
+    _fontVariants{},
+    _fontVariant{ 0 },
+    _glyphAtlasEnabled{ true },
+    _glyphAtlasUsable{ false },
+    _glyphAtlasNextSlot{ 0 },
+    _queuedLines{},
+    _queuedLineCount{ 0 },
+    _queuedBackgrounds{},
+    _queuedGridLines{},
+    _brushCache{},
+    _brushCacheNext{ 0 },
+    _swapChainFrameLatencyWaitableObject{},
+    _swapChainFlags{ 0 }
 {
-    THROW_IF_FAILED(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, IID_PPV_ARGS(&_d2dFactory)));
+    // Like the device, the Direct2D factory is shared with every other engine in the process.
+    _d2dFactory = DxDeviceManager::Instance().GetD2DFactory();
 
     THROW_IF_FAILED(DWriteCreateFactory(
         DWRITE_FACTORY_TYPE_SHARED,
@@ -129,62 +156,20 @@ DxEngine::~DxEngine()
 
     auto freeOnFail = wil::scope_exit([&] { _ReleaseDeviceResources(); });
 
-    RETURN_IF_FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&_dxgiFactory2)));
-
-    const DWORD DeviceFlags = D3D11_CREATE_DEVICE_BGRA_SUPPORT |
-                              // clang-format off
-        // This causes problems for folks who do not have the whole DirectX SDK installed
-        // when they try to run the rest of the project in debug mode.
-        // As such, I'm leaving this flag here for people doing DX-specific work to toggle it
-        // only when they need it and shutting it off otherwise.
-        // Find out more about the debug layer here:
-        // https://docs.microsoft.com/en-us/windows/desktop/direct3d11/overviews-direct3d-11-devices-layers
-        // You can find out how to install it here:
-        // https://docs.microsoft.com/en-us/windows/uwp/gaming/use-the-directx-runtime-and-visual-studio-graphics-diagnostic-features
-                              // clang-format on
-                              // D3D11_CREATE_DEVICE_DEBUG |
-                              D3D11_CREATE_DEVICE_SINGLETHREADED;
-
-    D3D_FEATURE_LEVEL FeatureLevels[] = {
-        D3D_FEATURE_LEVEL_11_1,
-        D3D_FEATURE_LEVEL_11_0,
-        D3D_FEATURE_LEVEL_10_1,
-        D3D_FEATURE_LEVEL_10_0,
-        D3D_FEATURE_LEVEL_9_1,
-    };
-
-    // Trying hardware first for maximum performance, then trying WARP (software) renderer second
-    // in case we're running inside a downlevel VM where hardware passthrough isn't enabled like
-    // for Windows 7 in a VM.
-    const auto hardwareResult = D3D11CreateDevice(NULL,
-                                                  D3D_DRIVER_TYPE_HARDWARE,
-                                                  NULL,
-                                                  DeviceFlags,
-                                                  FeatureLevels,
-                                                  ARRAYSIZE(FeatureLevels),
-                                                  D3D11_SDK_VERSION,
-                                                  &_d3dDevice,
-                                                  NULL,
-                                                  &_d3dDeviceContext);
-
-    if (FAILED(hardwareResult))
-    {
-        RETURN_IF_FAILED(D3D11CreateDevice(NULL,
-                                           D3D_DRIVER_TYPE_WARP,
-                                           NULL,
-                                           DeviceFlags,
-                                           FeatureLevels,
-                                           ARRAYSIZE(FeatureLevels),
-                                           D3D11_SDK_VERSION,
-                                           &_d3dDevice,
-                                           NULL,
-                                           &_d3dDeviceContext));
-    }
+    // The device (and the DXGI factory to make our swap chain with) is shared with every other engine in the process.
+    DxDeviceManager::Device device;
+    RETURN_IF_FAILED(DxDeviceManager::Instance().GetDevice(device));
+    _d3dDevice = std::move(device.d3dDevice);
+    _d3dDeviceContext = std::move(device.d3dDeviceContext);
+    _dxgiFactory2 = std::move(device.dxgiFactory);
+    _deviceGeneration = device.generation;
 
     _displaySizePixels = _GetClientSize();
 
     if (createSwapChain)
     {
+        _firstFrame = true;
+
         DXGI_SWAP_CHAIN_DESC1 SwapChainDesc = { 0 };
         SwapChainDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
         SwapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
@@ -193,6 +178,10 @@ DxEngine::~DxEngine()
         SwapChainDesc.SampleDesc.Count = 1;
         SwapChainDesc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
 
+        // Frame latency waitable objects are only available on Windows 8.1+
+        _swapChainFlags = IsWindows8Point1OrGreater() ? DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT : 0;
+        SwapChainDesc.Flags = _swapChainFlags;
+
         // DXGI_SCALING_NONE is only valid on Windows 8+
         if (IsWindows8OrGreater())
         {
@@ -246,6 +235,16 @@ DxEngine::~DxEngine()
             THROW_HR(E_NOTIMPL);
         }
 
+        // Hold ourselves to a single frame in flight, so that what gets
+        // painted is always as close as we can get to what's on screen next.
+        if (WI_IsFlagSet(_swapChainFlags, DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT))
+        {
+            ::Microsoft::WRL::ComPtr<IDXGISwapChain2> swapChain2;
+            RETURN_IF_FAILED(_dxgiSwapChain.As(&swapChain2));
+            RETURN_IF_FAILED(swapChain2->SetMaximumFrameLatency(1));
+            _swapChainFrameLatencyWaitableObject.reset(swapChain2->GetFrameLatencyWaitableObject());
+        }
+
         // With a new swap chain, mark the entire thing as invalid.
         RETURN_IF_FAILED(InvalidateAll());
 
@@ -272,6 +271,8 @@ DxEngine::~DxEngine()
 
 [[nodiscard]] HRESULT DxEngine::_PrepareRenderTarget() noexcept
 {
+    // The glyph atlas and cached brushes are kept. Resources made by one DXGI surface render
+    // target can be used by another on the same device, which is all a resize changes.
     RETURN_IF_FAILED(_dxgiSwapChain->GetBuffer(0, IID_PPV_ARGS(&_dxgiSurface)));
 
     D2D1_RENDER_TARGET_PROPERTIES props =
@@ -320,6 +321,13 @@ DxEngine::~DxEngine()
 void DxEngine::_ReleaseDeviceResources() noexcept
 {
     _haveDeviceResources = false;
+    _ReleaseGlyphAtlas();
+    _ReleaseScrollback();
+    _brushCache.clear();
+    _brushCacheNext = 0;
+    _queuedLineCount = 0;
+    _queuedBackgrounds.clear();
+    _queuedGridLines.clear();
     _d2dBrushForeground.Reset();
     _d2dBrushBackground.Reset();
 
@@ -331,12 +339,14 @@ void DxEngine::_ReleaseDeviceResources() noexcept
     _d2dRenderTarget.Reset();
 
     _dxgiSurface.Reset();
+    _swapChainFrameLatencyWaitableObject.reset();
     _dxgiSwapChain.Reset();
 
     if (nullptr != _d3dDeviceContext.Get())
     {
         // To ensure the swap chain goes away we must unbind any views from the
         // D3D pipeline
+        const auto contextLock = DxDeviceManager::Instance().LockContext();
         _d3dDeviceContext->OMSetRenderTargets(0, nullptr, nullptr);
     }
     _d3dDeviceContext.Reset();
@@ -346,6 +356,57 @@ void DxEngine::_ReleaseDeviceResources() noexcept
     _dxgiFactory2.Reset();
 }
 
+// Routine Description:
+// - Fills the window with the default background color while there's no device to draw with,
+//   so that what was on the swap chain doesn't linger half drawn. Without a swap chain, the
+//   window shows what's drawn on it with GDI. A composition surface keeps its last frame instead.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void DxEngine::_PaintClearFrame() noexcept
+{
+    if (_chainMode != SwapChainMode::ForHwnd || !_hwndTarget)
+    {
+        return;
+    }
+
+    const auto dc = GetDC(_hwndTarget);
+    if (!dc)
+    {
+        LOG_LAST_ERROR();
+        return;
+    }
+    auto releaseDC = wil::scope_exit([&]() { ReleaseDC(_hwndTarget, dc); });
+
+    RECT rect = { 0 };
+    LOG_IF_WIN32_BOOL_FALSE(GetClientRect(_hwndTarget, &rect));
+
+    const auto color = RGB(static_cast<BYTE>(_defaultBackgroundColor.r * 255.0f),
+                           static_cast<BYTE>(_defaultBackgroundColor.g * 255.0f),
+                           static_cast<BYTE>(_defaultBackgroundColor.b * 255.0f));
+    wil::unique_hbrush brush(CreateSolidBrush(color));
+    if (brush)
+    {
+        FillRect(dc, &rect, brush.get());
+    }
+}
+
+// Routine Description:
+// - Checks whether the device we share with the other engines was lost, and if so, tells
+//   the manager, so that every engine moves over to a new device on its next frame.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void DxEngine::_CheckDeviceLost() noexcept
+{
+    if (_d3dDevice && FAILED(_d3dDevice->GetDeviceRemovedReason()))
+    {
+        DxDeviceManager::Instance().ReportDeviceLost(_deviceGeneration);
+    }
+}
+
 // Routine Description:
 // - Helper to create a DirectWrite text layout object
 //   out of a string.
@@ -396,6 +457,22 @@ void DxEngine::SetCallback(std::function<void()> pfn)
     _pfn = pfn;
 }
 
+// Routine Description:
+// - Sets whether lines of simple text may be painted out of the glyph atlas
+//   instead of being laid out every time.
+// Arguments:
+// - enabled - true to use the atlas where possible, false to always lay out text
+// Return Value:
+// - <none>
+void DxEngine::SetGlyphAtlasEnabled(const bool enabled) noexcept
+{
+    _glyphAtlasEnabled = enabled;
+    if (!enabled)
+    {
+        _ReleaseGlyphAtlas();
+    }
+}
+
 Microsoft::WRL::ComPtr<IDXGISwapChain1> DxEngine::GetSwapChain() noexcept
 {
     if (_dxgiSwapChain.Get() == nullptr)
@@ -414,6 +491,9 @@ Microsoft::WRL::ComPtr<IDXGISwapChain1> DxEngine::GetSwapChain() noexcept
 // - S_OK
 [[nodiscard]] HRESULT DxEngine::Invalidate(const SMALL_RECT* const psrRegion) noexcept
 {
+    // Whatever the scrollback holds for these rows is out of date now.
+    _DropScrollbackRows(_scrollbackViewportTop + psrRegion->Top, _scrollbackViewportTop + psrRegion->Bottom);
+
     _InvalidOr(*psrRegion);
     return S_OK;
 }
@@ -426,8 +506,10 @@ Microsoft::WRL::ComPtr<IDXGISwapChain1> DxEngine::GetSwapChain() noexcept
 // - S_OK
 [[nodiscard]] HRESULT DxEngine::InvalidateCursor(const COORD* const pcoordCursor) noexcept
 {
+    // The scrollback never holds the cursor, so the row it's on stays good there.
     SMALL_RECT sr = Microsoft::Console::Types::Viewport::FromCoord(*pcoordCursor).ToInclusive();
-    return Invalidate(&sr);
+    _InvalidOr(sr);
+    return S_OK;
 }
 
 // Routine Description:
@@ -445,12 +527,17 @@ Microsoft::WRL::ComPtr<IDXGISwapChain1> DxEngine::GetSwapChain() noexcept
 
 // Routine Description:
 // - Invalidates a series of character rectangles
+// - The renderer invalidates where the selection changed, and follows that with no
+//   rectangles at all once the selection's gone, so whether the last call was given
+//   any rectangles tells if there's a selection on screen.
 // Arguments:
 // - rectangles - One or more rectangles describing character positions on the grid
 // Return Value:
 // - S_OK
 [[nodiscard]] HRESULT DxEngine::InvalidateSelection(const std::vector<SMALL_RECT>& rectangles) noexcept
 {
+    _selectionShown = !rectangles.empty();
+
     for (const auto& rect : rectangles)
     {
         RETURN_IF_FAILED(Invalidate(&rect));
@@ -461,6 +548,7 @@ Microsoft::WRL::ComPtr<IDXGISwapChain1> DxEngine::GetSwapChain() noexcept
 // Routine Description:
 // - Scrolls the existing dirty region (if it exists) and
 //   invalidates the area that is uncovered in the window.
+// - Uncovered rows that are still in the scrollback are copied in by ScrollFrame instead.
 // Arguments:
 // - pcoordDelta - The number of characters to move and uncover.
 //               - -Y is up, Y is down, -X is left, X is right.
@@ -468,6 +556,14 @@ Microsoft::WRL::ComPtr<IDXGISwapChain1> DxEngine::GetSwapChain() noexcept
 // - S_OK
 [[nodiscard]] HRESULT DxEngine::InvalidateScroll(const COORD* const pcoordDelta) noexcept
 {
+    // If the viewport didn't move by just as much as we scroll, the buffer moved under it
+    // (or we scroll sideways), and the rows in the scrollback don't line up with the screen anymore.
+    if (pcoordDelta->X != 0 || _viewportTop != _scrollbackViewportTop - pcoordDelta->Y)
+    {
+        _DropScrollback();
+    }
+    _scrollbackViewportTop = _viewportTop;
+
     if (pcoordDelta->X != 0 || pcoordDelta->Y != 0)
     {
         POINT delta = { 0 };
@@ -476,6 +572,14 @@ Microsoft::WRL::ComPtr<IDXGISwapChain1> DxEngine::GetSwapChain() noexcept
 
         _InvalidOffset(delta);
 
+        // Rows that were to be copied in but scrolled right back out don't need to be anymore.
+        const RECT screen = _GetDisplayRect();
+        _scrollbackPending.erase(std::remove_if(_scrollbackPending.begin(), _scrollbackPending.end(), [&](const LONG row) noexcept {
+                                     const auto y = (row - _scrollbackViewportTop) * _glyphCell.cy;
+                                     return y < 0 || y >= screen.bottom;
+                                 }),
+                                 _scrollbackPending.end());
+
         _invalidScroll.cx += delta.x;
         _invalidScroll.cy += delta.y;
 
@@ -501,7 +605,7 @@ Microsoft::WRL::ComPtr<IDXGISwapChain1> DxEngine::GetSwapChain() noexcept
 
         if (!IsRectEmpty(&reveal))
         {
-            _InvalidOr(reveal);
+            _InvalidRevealed(reveal);
         }
     }
 
@@ -516,6 +620,10 @@ Microsoft::WRL::ComPtr<IDXGISwapChain1> DxEngine::GetSwapChain() noexcept
 // - S_OK
 [[nodiscard]] HRESULT DxEngine::InvalidateAll() noexcept
 {
+    // Everything is about to be painted again, and whatever made that necessary
+    // (new colors, for one) probably put the rows in the scrollback out of date too.
+    _DropScrollback();
+
     const RECT screen = _GetDisplayRect();
     _InvalidOr(screen);
 
@@ -523,17 +631,33 @@ Microsoft::WRL::ComPtr<IDXGISwapChain1> DxEngine::GetSwapChain() noexcept
 }
 
 // Routine Description:
-// - This currently has no effect in this renderer.
+// - Lets go of the rows in the scrollback, since circling moves every row of the buffer.
+//   Otherwise this has no effect in this renderer.
 // Arguments:
 // - pForcePaint - Always filled with false
 // Return Value:
-// - S_FALSE because we don't use this.
+// - S_FALSE because we don't need to paint before the buffer circles.
 [[nodiscard]] HRESULT DxEngine::InvalidateCircling(_Out_ bool* const pForcePaint) noexcept
 {
+    _DropScrollback();
+
     *pForcePaint = false;
     return S_FALSE;
 }
 
+// Routine Description:
+// - Lets go of whatever the scrollback holds for rows of the buffer that changed,
+//   so that they get painted again when they're scrolled back into view.
+// Arguments:
+// - psrRegion - The region of the buffer that changed, in buffer coordinates, inclusive.
+// Return Value:
+// - S_OK
+[[nodiscard]] HRESULT DxEngine::InvalidateOffscreen(const SMALL_RECT* const psrRegion) noexcept
+{
+    _DropScrollbackRows(psrRegion->Top, psrRegion->Bottom);
+    return S_OK;
+}
+
 // Routine Description:
 // - Gets the area in pixels of the surface we are targeting
 // Arguments:
@@ -687,14 +811,31 @@ void DxEngine::_InvalidOr(RECT rc) noexcept
 // - Any DirectX error, a memory error, etc.
 [[nodiscard]] HRESULT DxEngine::StartPaint() noexcept
 {
-    FAIL_FAST_IF_FAILED(InvalidateAll());
     RETURN_HR_IF(E_NOT_VALID_STATE, _isPainting); // invalid to start a paint while painting.
 
+    // Only the parts of the frame that were invalidated get painted and presented.
+    // Everything else is still on the surface from the last frame.
+    _presentScroll = { 0 };
+    _presentOffset = { 0 };
+    _scrollbackRestored = { 0 };
+    _scrollbackSaved = false;
+
     if (_isEnabled)
     {
         const auto clientSize = _GetClientSize();
-        if (!_haveDeviceResources)
+        if (!_haveDeviceResources || !DxDeviceManager::Instance().IsCurrent(_deviceGeneration))
         {
+            // A new device is still being made after the last one was lost. Rather than hold
+            // up the frame for it, show a plain one. Nothing's been validated, so the next
+            // frame (once WaitUntilCanRender sees the device is ready) paints it all again.
+            if (!DxDeviceManager::Instance().IsDeviceReady())
+            {
+                _ReleaseDeviceResources();
+                _PaintClearFrame();
+                return S_FALSE;
+            }
+
+            // If another engine found out that the device we share was lost, we move over to the new one too.
             RETURN_IF_FAILED(_CreateDeviceResources(true));
         }
         else if (_displaySizePixels.cy != clientSize.cy ||
@@ -711,7 +852,8 @@ void DxEngine::_InvalidOr(RECT rc) noexcept
             _d2dRenderTarget.Reset();
 
             // Change the buffer size and recreate the render target (and surface)
-            RETURN_IF_FAILED(_dxgiSwapChain->ResizeBuffers(2, clientSize.cx, clientSize.cy, DXGI_FORMAT_B8G8R8A8_UNORM, 0));
+            const auto contextLock = DxDeviceManager::Instance().LockContext();
+            RETURN_IF_FAILED(_dxgiSwapChain->ResizeBuffers(2, clientSize.cx, clientSize.cy, DXGI_FORMAT_B8G8R8A8_UNORM, _swapChainFlags));
             RETURN_IF_FAILED(_PrepareRenderTarget());
 
             // OK we made it past the parts that can cause errors. We can release our failure handler.
@@ -719,6 +861,11 @@ void DxEngine::_InvalidOr(RECT rc) noexcept
 
             // And persist the new size.
             _displaySizePixels = clientSize;
+
+            // Resizing the buffers threw out what was on them, and the rows in the scrollback don't fit anymore.
+            _ReleaseScrollback();
+            RETURN_IF_FAILED(InvalidateAll());
+            _firstFrame = true;
         }
 
         _d2dRenderTarget->BeginDraw();
@@ -742,40 +889,59 @@ void DxEngine::_InvalidOr(RECT rc) noexcept
 
     if (_haveDeviceResources)
     {
+        // Whatever lines are still waiting go on the frame before it's done.
+        LOG_IF_FAILED(_FlushQueuedLines());
+        LOG_IF_FAILED(_SaveScrollbackRows());
+
         _isPainting = false;
 
         hr = _d2dRenderTarget->EndDraw();
 
         if (SUCCEEDED(hr))
         {
-            if (_invalidScroll.cy != 0 || _invalidScroll.cx != 0)
+            _presentDirty = _isInvalidUsed ? _ToSurfaceRect(_invalidRect) : RECT{ 0 };
+
+            // The rows copied in from the scrollback changed too.
+            if (!IsRectEmpty(&_scrollbackRestored))
             {
-                _presentDirty = _invalidRect;
+                UnionRect(&_presentDirty, &_presentDirty, &_scrollbackRestored);
+            }
 
-                RECT display = _GetDisplayRect();
-                SubtractRect(&_presentScroll, &display, &_presentDirty);
-                _presentOffset.x = _invalidScroll.cx;
-                _presentOffset.y = _invalidScroll.cy;
+            // If nothing changed, there's nothing to show.
+            _presentReady = !IsRectEmpty(&_presentDirty) || !IsRectEmpty(&_presentScroll);
 
-                _presentParams.DirtyRectsCount = 1;
-                _presentParams.pDirtyRects = &_presentDirty;
+            // Tell DXGI what changed so only that gets composed again. A dirty area covering the
+            // whole surface gains nothing over presenting it all, which we also have to do if the
+            // swap chain doesn't have a previous frame yet to build on.
+            const RECT display = _GetDisplayRect();
+            _presentPartial = !_firstFrame && !EqualRect(&_presentDirty, &display);
+            if (_presentPartial)
+            {
+                _presentParams.DirtyRectsCount = IsRectEmpty(&_presentDirty) ? 0 : 1;
+                _presentParams.pDirtyRects = IsRectEmpty(&_presentDirty) ? nullptr : &_presentDirty;
 
-                _presentParams.pScrollOffset = &_presentOffset;
-                _presentParams.pScrollRect = &_presentScroll;
+                if (!IsRectEmpty(&_presentScroll))
+                {
+                    _presentParams.pScrollRect = &_presentScroll;
+                    _presentParams.pScrollOffset = &_presentOffset;
+                }
 
-                if (IsRectEmpty(&_presentScroll))
+                // Zero dirty rects would mean the whole surface. A scroll with nothing revealed
+                // still has to say what it changed, so pass the scrolled area as dirty too.
+                if (_presentParams.DirtyRectsCount == 0)
                 {
-                    _presentParams.pScrollRect = nullptr;
-                    _presentParams.pScrollOffset = nullptr;
+                    _presentDirty = _presentScroll;
+                    _presentParams.DirtyRectsCount = 1;
+                    _presentParams.pDirtyRects = &_presentDirty;
                 }
             }
-
-            _presentReady = true;
         }
         else
         {
             _presentReady = false;
+            _CheckDeviceLost();
             _ReleaseDeviceResources();
+            _PaintClearFrame();
         }
     }
 
@@ -792,22 +958,80 @@ void DxEngine::_InvalidOr(RECT rc) noexcept
 //   to the back surface of the swap chain (the one we draw on next)
 //   so we can draw on top of what's already there.
 // Arguments:
-// - <none>
+// - partial - If true, the back surface already holds the frame before the one being
+//             displayed, so only what the last frame changed has to be copied.
 // Return Value:
 // - Any DirectX error, a memory error, etc.
-[[nodiscard]] HRESULT DxEngine::_CopyFrontToBack() noexcept
+[[nodiscard]] HRESULT DxEngine::_CopyFrontToBack(const bool partial) noexcept
 {
+    const auto contextLock = DxDeviceManager::Instance().LockContext();
+
     Microsoft::WRL::ComPtr<ID3D11Resource> backBuffer;
     Microsoft::WRL::ComPtr<ID3D11Resource> frontBuffer;
 
     RETURN_IF_FAILED(_dxgiSwapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer)));
     RETURN_IF_FAILED(_dxgiSwapChain->GetBuffer(1, IID_PPV_ARGS(&frontBuffer)));
 
-    _d3dDeviceContext->CopyResource(backBuffer.Get(), frontBuffer.Get());
+    if (!partial)
+    {
+        _d3dDeviceContext->CopyResource(backBuffer.Get(), frontBuffer.Get());
+        return S_OK;
+    }
+
+    for (const auto& rc : { _presentDirty, _presentScroll })
+    {
+        if (!IsRectEmpty(&rc))
+        {
+            const D3D11_BOX box{ gsl::narrow_cast<UINT>(rc.left),
+                                 gsl::narrow_cast<UINT>(rc.top),
+                                 0,
+                                 gsl::narrow_cast<UINT>(rc.right),
+                                 gsl::narrow_cast<UINT>(rc.bottom),
+                                 1 };
+            _d3dDeviceContext->CopySubresourceRegion(backBuffer.Get(),
+                                                     0,
+                                                     box.left,
+                                                     box.top,
+                                                     0,
+                                                     frontBuffer.Get(),
+                                                     0,
+                                                     &box);
+        }
+    }
 
     return S_OK;
 }
 
+// Routine Description:
+// - Converts a rectangle from the coordinates we draw in to pixels of the swap chain surface.
+//   They only differ when the render target has been given a DPI to scale by.
+// Arguments:
+// - rc - Rectangle in drawing coordinates
+// Return Value:
+// - The smallest rectangle of surface pixels covering it, cut to the surface.
+[[nodiscard]] RECT DxEngine::_ToSurfaceRect(const RECT& rc) const noexcept
+{
+    float dpiX = USER_DEFAULT_SCREEN_DPI;
+    float dpiY = USER_DEFAULT_SCREEN_DPI;
+    if (_d2dRenderTarget)
+    {
+        _d2dRenderTarget->GetDpi(&dpiX, &dpiY);
+    }
+
+    const auto scaleX = dpiX / USER_DEFAULT_SCREEN_DPI;
+    const auto scaleY = dpiY / USER_DEFAULT_SCREEN_DPI;
+
+    RECT surface;
+    surface.left = static_cast<LONG>(floor(rc.left * scaleX));
+    surface.top = static_cast<LONG>(floor(rc.top * scaleY));
+    surface.right = static_cast<LONG>(ceil(rc.right * scaleX));
+    surface.bottom = static_cast<LONG>(ceil(rc.bottom * scaleY));
+
+    const RECT display = _GetDisplayRect();
+    IntersectRect(&surface, &surface, &display);
+    return surface;
+}
+
 // Routine Description:
 // - Takes queued drawing information and presents it to the screen.
 // - This is separated out so it can be done outside the lock as it's expensive.
@@ -819,11 +1043,37 @@ void DxEngine::_InvalidOr(RECT rc) noexcept
 {
     if (_presentReady)
     {
-        FAIL_FAST_IF_FAILED(_dxgiSwapChain->Present(1, 0));
-        /*FAIL_FAST_IF_FAILED(_dxgiSwapChain->Present1(1, 0, &_presentParams));*/
+        // Presenting goes through the device context we share with the other engines.
+        const auto contextLock = DxDeviceManager::Instance().LockContext();
+
+        // Try to only present what changed. If DXGI won't have it, fall back to presenting it all.
+        auto partial = _presentPartial;
+        if (partial)
+        {
+            const auto hr = _dxgiSwapChain->Present1(1, 0, &_presentParams);
+            partial = SUCCEEDED(hr);
+            LOG_IF_FAILED(hr);
+        }
 
-        RETURN_IF_FAILED(_CopyFrontToBack());
+        if (!partial)
+        {
+            // Losing the device isn't fatal. We (and every other engine) make everything again on a new one next frame.
+            const auto hr = _dxgiSwapChain->Present(1, 0);
+            if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET)
+            {
+                _presentReady = false;
+                DxDeviceManager::Instance().ReportDeviceLost(_deviceGeneration);
+                _ReleaseDeviceResources();
+                _PaintClearFrame();
+                return S_OK;
+            }
+            FAIL_FAST_IF_FAILED(hr);
+        }
+        _firstFrame = false;
+
+        RETURN_IF_FAILED(_CopyFrontToBack(partial));
         _presentReady = false;
+        _presentPartial = false;
 
         _presentDirty = { 0 };
         _presentOffset = { 0 };
@@ -835,196 +1085,1065 @@ void DxEngine::_InvalidOr(RECT rc) noexcept
 }
 
 // Routine Description:
-// - This is currently unused.
+// - Moves what's already on the surface by the distance it was scrolled since the last
+//   frame, so that only the part of the screen the scroll revealed has to be painted.
 // Arguments:
 // - <none>
 // Return Value:
-// - S_OK
+// - S_OK or relevant DirectX error
 [[nodiscard]] HRESULT DxEngine::ScrollFrame() noexcept
 {
+    RETURN_HR_IF(S_OK, !_isPainting);
+
+    // Once the last frame has moved, the rows the scroll revealed that are still
+    // in the scrollback go on top of it. That has to happen even if nothing moves.
+    auto restoreRows = wil::scope_exit([&]() noexcept {
+        LOG_IF_FAILED(_RestoreScrollbackRows());
+    });
+
+    // If we don't have any scrolling to do, return early.
+    RETURN_HR_IF(S_OK, 0 == _invalidScroll.cx && 0 == _invalidScroll.cy);
+
+    // Without a last frame to move, everything gets painted anyway.
+    RETURN_HR_IF(S_OK, _firstFrame);
+
+    // The scroll is in drawing coordinates. If that doesn't come out to whole pixels
+    // of the surface, moving them would smear the text, so paint it all again instead.
+    float dpiX;
+    float dpiY;
+    _d2dRenderTarget->GetDpi(&dpiX, &dpiY);
+
+    const auto scrollX = _invalidScroll.cx * dpiX / USER_DEFAULT_SCREEN_DPI;
+    const auto scrollY = _invalidScroll.cy * dpiY / USER_DEFAULT_SCREEN_DPI;
+    if (scrollX != std::round(scrollX) || scrollY != std::round(scrollY))
+    {
+        return InvalidateAll();
+    }
+
+    POINT offset;
+    offset.x = static_cast<LONG>(scrollX);
+    offset.y = static_cast<LONG>(scrollY);
+
+    // Where the last frame's content ends up once it's moved. If none of it stays on screen, there's nothing to move.
+    const RECT display = _GetDisplayRect();
+    RECT scrolled = display;
+    OffsetRect(&scrolled, offset.x, offset.y);
+    IntersectRect(&scrolled, &scrolled, &display);
+    RETURN_HR_IF(S_OK, IsRectEmpty(&scrolled));
+
+    // The back surface still holds the last frame, just like the front one. Copy from the front,
+    // which doesn't overlap with where we copy to, and make sure nothing drawn so far is pending.
+    RETURN_IF_FAILED(_d2dRenderTarget->Flush());
+
+    Microsoft::WRL::ComPtr<ID3D11Resource> backBuffer;
+    Microsoft::WRL::ComPtr<ID3D11Resource> frontBuffer;
+    RETURN_IF_FAILED(_dxgiSwapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer)));
+    RETURN_IF_FAILED(_dxgiSwapChain->GetBuffer(1, IID_PPV_ARGS(&frontBuffer)));
+
+    const D3D11_BOX source{ gsl::narrow_cast<UINT>(scrolled.left - offset.x),
+                            gsl::narrow_cast<UINT>(scrolled.top - offset.y),
+                            0,
+                            gsl::narrow_cast<UINT>(scrolled.right - offset.x),
+                            gsl::narrow_cast<UINT>(scrolled.bottom - offset.y),
+                            1 };
+    const auto contextLock = DxDeviceManager::Instance().LockContext();
+    _d3dDeviceContext->CopySubresourceRegion(backBuffer.Get(),
+                                             0,
+                                             gsl::narrow_cast<UINT>(scrolled.left),
+                                             gsl::narrow_cast<UINT>(scrolled.top),
+                                             0,
+                                             frontBuffer.Get(),
+                                             0,
+                                             &source);
+
+    _presentScroll = scrolled;
+    _presentOffset = offset;
+
     return S_OK;
 }
 
 // Routine Description:
-// - This paints in the back most layer of the frame with the background color.
+// - Finds the slot of the scrollback a row of the buffer goes in
 // Arguments:
-// - <none>
+// - row - Row of the buffer. The scrollback must have slots.
 // Return Value:
-// - S_OK
-[[nodiscard]] HRESULT DxEngine::PaintBackground() noexcept
+// - Index of the slot in _scrollbackRows
+[[nodiscard]] size_t DxEngine::_GetScrollbackSlot(const LONG row) const noexcept
 {
-    /*_d2dRenderTarget->FillRectangle(D2D1::RectF((float)_invalidRect.left,
-                                                  (float)_invalidRect.top,
-                                                  (float)_invalidRect.right,
-                                                  (float)_invalidRect.bottom),
-                                                   _d2dBrushBackground.Get());
-*/
+    const auto slots = gsl::narrow_cast<LONG>(_scrollbackRows.size());
+    return gsl::narrow_cast<size_t>((row % slots + slots) % slots);
+}
 
-    D2D1_COLOR_F nothing = { 0 };
+// Routine Description:
+// - Checks whether the scrollback holds a row of the buffer
+// Arguments:
+// - row - Row of the buffer
+// Return Value:
+// - True if the row can be copied in from the scrollback
+[[nodiscard]] bool DxEngine::_HasScrollbackRow(const LONG row) const noexcept
+{
+    return !_scrollbackRows.empty() && _scrollbackRows.at(_GetScrollbackSlot(row)) == row;
+}
 
-    _d2dRenderTarget->Clear(nothing);
+// Routine Description:
+// - Handles the part of the screen a vertical scroll revealed. The rows of it that are
+//   in the scrollback are left for ScrollFrame to copy in, and the rest gets invalidated.
+// Arguments:
+// - reveal - The revealed rectangle, in the coordinates we draw in. It spans whole rows.
+// Return Value:
+// - <none>
+void DxEngine::_InvalidRevealed(const RECT& reveal) noexcept
+{
+    // With a selection on screen, the rows would have to be copied in with it,
+    // which the scrollback doesn't hold, so paint them instead.
+    if (_scrollbackRows.empty() || _selectionShown || _glyphCell.cy <= 0)
+    {
+        _InvalidOr(reveal);
+        return;
+    }
 
-    return S_OK;
+    try
+    {
+        for (auto y = reveal.top / _glyphCell.cy; y * _glyphCell.cy < reveal.bottom; ++y)
+        {
+            const auto row = _scrollbackViewportTop + y;
+            if (_HasScrollbackRow(row))
+            {
+                _scrollbackPending.push_back(row);
+            }
+            else
+            {
+                RECT rc = reveal;
+                rc.top = std::max(reveal.top, y * _glyphCell.cy);
+                rc.bottom = std::min(reveal.bottom, (y + 1) * _glyphCell.cy);
+                _InvalidOr(rc);
+            }
+        }
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        _InvalidOr(reveal);
+    }
 }
 
 // Routine Description:
-// - Places one line of text onto the screen at the given position
+// - Copies the rows that were revealed by scrolling out of the scrollback onto the surface.
+//   Any that can't be copied are invalidated instead, so they get painted.
 // Arguments:
-// - clusters - Iterable collection of cluster information (text and columns it should consume)
-// - coord - Character coordinate position in the cell grid
-// - fTrimLeft - Whether or not to trim off the left half of a double wide character
+// - <none>
 // Return Value:
 // - S_OK or relevant DirectX error
-[[nodiscard]] HRESULT DxEngine::PaintBufferLine(std::basic_string_view<Cluster> const clusters,
-                                                COORD const coord,
-                                                const bool /*trimLeft*/) noexcept
+[[nodiscard]] HRESULT DxEngine::_RestoreScrollbackRows() noexcept
 {
-    try
-    {
-        // Calculate positioning of our origin.
-        D2D1_POINT_2F origin;
-        origin.x = static_cast<float>(coord.X * _glyphCell.cx);
-        origin.y = static_cast<float>(coord.Y * _glyphCell.cy);
+    RETURN_HR_IF(S_OK, _scrollbackPending.empty());
 
-        // Create the text layout
-        CustomTextLayout layout(_dwriteFactory.Get(),
-                                _dwriteTextAnalyzer.Get(),
-                                _dwriteTextFormat.Get(),
-                                _dwriteFontFace.Get(),
-                                clusters,
-                                _glyphCell.cx);
+    // If they can't be copied, let the whole scrollback go, along with the rows that were waiting.
+    auto paintOnFailure = wil::scope_exit([&]() noexcept {
+        _DropScrollback();
+    });
 
-        // Get the baseline for this font as that's where we draw from
-        DWRITE_LINE_SPACING spacing;
-        RETURN_IF_FAILED(_dwriteTextFormat->GetLineSpacing(&spacing.method, &spacing.height, &spacing.baseline));
+    // A new surface is painted whole anyway.
+    RETURN_HR_IF(S_OK, _firstFrame || !_scrollbackTexture);
 
-        // Assemble the drawing context information
-        DrawingContext context(_d2dRenderTarget.Get(),
-                               _d2dBrushForeground.Get(),
-                               _d2dBrushBackground.Get(),
-                               _dwriteFactory.Get(),
-                               spacing,
-                               D2D1::SizeF(gsl::narrow<FLOAT>(_glyphCell.cx), gsl::narrow<FLOAT>(_glyphCell.cy)),
-                               D2D1_DRAW_TEXT_OPTIONS_ENABLE_COLOR_FONT);
+    // Make sure nothing drawn so far goes on top of the rows after they're copied in.
+    RETURN_IF_FAILED(_d2dRenderTarget->Flush());
 
-        // Layout then render the text
-        RETURN_IF_FAILED(layout.Draw(&context, _customRenderer.Get(), origin.x, origin.y));
+    Microsoft::WRL::ComPtr<ID3D11Resource> backBuffer;
+    RETURN_IF_FAILED(_dxgiSwapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer)));
+
+    const auto contextLock = DxDeviceManager::Instance().LockContext();
+    const RECT display = _GetDisplayRect();
+    for (const auto row : _scrollbackPending)
+    {
+        const auto y = row - _scrollbackViewportTop;
+        const auto top = y * _scrollbackRowHeight;
+        if (y < 0 || top >= display.bottom)
+        {
+            continue;
+        }
+
+        // The row might have changed since it was revealed.
+        if (!_HasScrollbackRow(row))
+        {
+            _InvalidOr(RECT{ 0, y * _glyphCell.cy, display.right, (y + 1) * _glyphCell.cy });
+            continue;
+        }
+
+        const auto bottom = std::min(top + _scrollbackRowHeight, display.bottom);
+        const auto slotTop = gsl::narrow_cast<UINT>(_GetScrollbackSlot(row) * _scrollbackRowHeight);
+        const D3D11_BOX source{ 0,
+                                slotTop,
+                                0,
+                                gsl::narrow_cast<UINT>(display.right),
+                                slotTop + gsl::narrow_cast<UINT>(bottom - top),
+                                1 };
+        _d3dDeviceContext->CopySubresourceRegion(backBuffer.Get(),
+                                                 0,
+                                                 0,
+                                                 gsl::narrow_cast<UINT>(top),
+                                                 0,
+                                                 _scrollbackTexture.Get(),
+                                                 0,
+                                                 &source);
+
+        const RECT restored{ 0, top, display.right, bottom };
+        UnionRect(&_scrollbackRestored, &_scrollbackRestored, &restored);
     }
-    CATCH_RETURN();
+
+    _scrollbackPending.clear();
+    paintOnFailure.release();
 
     return S_OK;
 }
 
 // Routine Description:
-// - Paints lines around cells (draws in pieces of the grid)
+// - Copies the rows that were painted whole in this frame from the surface into the scrollback,
+//   creating it if need be. Must be called before anything but text goes on the frame,
+//   and only does something the first time it's called in a frame.
 // Arguments:
-// - lines - Which grid lines (top, left, bottom, right) to draw
-// - color - The color to use for drawing the lines
-// - cchLine - Length of the line to draw in character cells
-// - coordTarget - The X,Y character position in the grid where we should start drawing
-//               - We will draw rightward (+X) from here
+// - <none>
 // Return Value:
 // - S_OK or relevant DirectX error
-[[nodiscard]] HRESULT DxEngine::PaintBufferGridLines(GridLines const lines,
-                                                     COLORREF const color,
-                                                     size_t const cchLine,
-                                                     COORD const coordTarget) noexcept
+[[nodiscard]] HRESULT DxEngine::_SaveScrollbackRows() noexcept
 {
-    const auto existingColor = _d2dBrushForeground->GetColor();
-    const auto restoreBrushOnExit = wil::scope_exit([&] { _d2dBrushForeground->SetColor(existingColor); });
+    RETURN_HR_IF(S_OK, _scrollbackSaved || !_isInvalidUsed || !_isPainting);
+    _scrollbackSaved = true;
 
-    _d2dBrushForeground->SetColor(D2D1::ColorF(color));
+    RETURN_HR_IF(S_OK, _glyphCell.cx <= 0 || _glyphCell.cy <= 0);
 
-    const auto font = _GetFontSize();
-    D2D_POINT_2F target;
-    target.x = static_cast<float>(coordTarget.X) * font.X;
-    target.y = static_cast<float>(coordTarget.Y) * font.Y;
+    float dpiX;
+    float dpiY;
+    _d2dRenderTarget->GetDpi(&dpiX, &dpiY);
 
-    D2D_POINT_2F start = { 0 };
-    D2D_POINT_2F end = { 0 };
+    // Only rows that were painted in every column hold nothing but their text.
+    const RECT display = _GetDisplayRect();
+    const auto width = static_cast<LONG>(display.right * USER_DEFAULT_SCREEN_DPI / dpiX);
+    RETURN_HR_IF(S_OK, _invalidRect.left > 0 || _invalidRect.right < width - width % _glyphCell.cx);
 
-    for (size_t i = 0; i < cchLine; i++)
-    {
-        start = target;
+    // To be copied around, rows have to come out to whole pixels of the surface.
+    const auto height = _glyphCell.cy * dpiY / USER_DEFAULT_SCREEN_DPI;
+    RETURN_HR_IF(S_OK, height != std::round(height));
+    const auto rowHeight = static_cast<LONG>(height);
 
-        if (lines & GridLines::Top)
+    if (!_scrollbackTexture)
+    {
+        const auto screenRows = display.bottom / rowHeight;
+        RETURN_HR_IF(S_OK, screenRows <= 0 || display.right <= 0);
+
+        // The texture can't be taller than the device allows, and shouldn't take up too much memory either.
+        const auto featureLevel = _d3dDevice->GetFeatureLevel();
+        const UINT64 maxDimension = featureLevel >= D3D_FEATURE_LEVEL_11_0 ? D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION :
+                                    featureLevel >= D3D_FEATURE_LEVEL_10_0 ? D3D10_REQ_TEXTURE2D_U_OR_V_DIMENSION :
+                                                                             D3D_FL9_1_REQ_TEXTURE2D_U_OR_V_DIMENSION;
+        const auto maxRows = std::min(maxDimension, s_ScrollbackMaxPixels / display.right) / rowHeight;
+        const auto slots = std::min<UINT64>(static_cast<UINT64>(screenRows) * s_ScrollbackScreens, maxRows);
+
+        // If it can't hold a screen of rows, it's no use at all.
+        RETURN_HR_IF(S_OK, slots < static_cast<UINT64>(screenRows) || static_cast<UINT64>(display.right) > maxDimension);
+
+        D3D11_TEXTURE2D_DESC desc = { 0 };
+        desc.Width = gsl::narrow_cast<UINT>(display.right);
+        desc.Height = gsl::narrow_cast<UINT>(slots * rowHeight);
+        desc.MipLevels = 1;
+        desc.ArraySize = 1;
+        desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+        desc.SampleDesc.Count = 1;
+        desc.Usage = D3D11_USAGE_DEFAULT;
+        RETURN_IF_FAILED(_d3dDevice->CreateTexture2D(&desc, nullptr, &_scrollbackTexture));
+
+        try
         {
-            end = start;
-            end.x += font.X;
-
-            _d2dRenderTarget->DrawLine(start, end, _d2dBrushForeground.Get());
+            _scrollbackRows.assign(gsl::narrow_cast<size_t>(slots), s_ScrollbackEmpty);
         }
-
-        if (lines & GridLines::Left)
+        catch (...)
         {
-            end = start;
-            end.y += font.Y;
-
-            _d2dRenderTarget->DrawLine(start, end, _d2dBrushForeground.Get());
+            _scrollbackTexture.Reset();
+            return LOG_CAUGHT_EXCEPTION();
         }
 
-        // NOTE: Watch out for inclusive/exclusive rectangles here.
-        // We have to remove 1 from the font size for the bottom and right lines to ensure that the
-        // starting point remains within the clipping rectangle.
-        // For example, if we're drawing a letter at 0,0 and the font size is 8x16....
-        // The bottom left corner inclusive is at 0,15 which is Y (0) + Font Height (16) - 1 = 15.
-        // The top right corner inclusive is at 7,0 which is X (0) + Font Height (8) - 1 = 7.
-
-        start = target;
-        start.y += font.Y - 1;
+        _scrollbackRowHeight = rowHeight;
+    }
 
-        if (lines & GridLines::Bottom)
-        {
-            end = start;
-            end.x += font.X;
+    RETURN_HR_IF(S_OK, rowHeight != _scrollbackRowHeight);
 
-            _d2dRenderTarget->DrawLine(start, end, _d2dBrushForeground.Get());
-        }
+    // Everything drawn so far has to be on the surface before it's copied.
+    RETURN_IF_FAILED(_d2dRenderTarget->Flush());
 
-        start = target;
-        start.x += font.X - 1;
+    Microsoft::WRL::ComPtr<ID3D11Resource> backBuffer;
+    RETURN_IF_FAILED(_dxgiSwapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer)));
 
-        if (lines & GridLines::Right)
+    const auto contextLock = DxDeviceManager::Instance().LockContext();
+    const auto firstRow = (std::max(_invalidRect.top, 0L) + _glyphCell.cy - 1) / _glyphCell.cy;
+    const auto endRow = _invalidRect.bottom / _glyphCell.cy;
+    for (auto y = firstRow; y < endRow; ++y)
+    {
+        // A row cut off by the bottom of the surface wasn't painted whole either.
+        const auto top = y * _scrollbackRowHeight;
+        if (top + _scrollbackRowHeight > display.bottom)
         {
-            end = start;
-            end.y += font.Y;
-
-            _d2dRenderTarget->DrawLine(start, end, _d2dBrushForeground.Get());
+            break;
         }
 
-        // Move to the next character in this run.
-        target.x += font.X;
+        const auto row = _scrollbackViewportTop + y;
+        const auto slot = _GetScrollbackSlot(row);
+        const D3D11_BOX source{ 0,
+                                gsl::narrow_cast<UINT>(top),
+                                0,
+                                gsl::narrow_cast<UINT>(display.right),
+                                gsl::narrow_cast<UINT>(top + _scrollbackRowHeight),
+                                1 };
+        _d3dDeviceContext->CopySubresourceRegion(_scrollbackTexture.Get(),
+                                                 0,
+                                                 0,
+                                                 gsl::narrow_cast<UINT>(slot * _scrollbackRowHeight),
+                                                 0,
+                                                 backBuffer.Get(),
+                                                 0,
+                                                 &source);
+        _scrollbackRows.at(slot) = row;
     }
 
     return S_OK;
 }
 
 // Routine Description:
-// - Paints an overlay highlight on a portion of the frame to represent selected text
+// - Lets go of whatever the scrollback holds for some rows of the buffer
 // Arguments:
-//  - rect - Rectangle to invert or highlight to make the selection area
+// - top - First row of the buffer to let go of
+// - bottom - Last row of the buffer to let go of, inclusive
 // Return Value:
-// - S_OK or relevant DirectX error.
-[[nodiscard]] HRESULT DxEngine::PaintSelection(const SMALL_RECT rect) noexcept
+// - <none>
+void DxEngine::_DropScrollbackRows(const LONG top, const LONG bottom) noexcept
 {
-    const auto existingColor = _d2dBrushForeground->GetColor();
-    const auto selectionColor = D2D1::ColorF(_defaultForegroundColor.r,
-                                             _defaultForegroundColor.g,
-                                             _defaultForegroundColor.b,
-                                             0.5f);
-
-    _d2dBrushForeground->SetColor(selectionColor);
-    const auto resetColorOnExit = wil::scope_exit([&] { _d2dBrushForeground->SetColor(existingColor); });
+    // If there are more rows than slots, every slot has one of them.
+    if (static_cast<LONGLONG>(bottom) - top + 1 >= gsl::narrow_cast<LONGLONG>(_scrollbackRows.size()))
+    {
+        std::fill(_scrollbackRows.begin(), _scrollbackRows.end(), s_ScrollbackEmpty);
+        return;
+    }
 
-    RECT pixels;
-    pixels.left = rect.Left * _glyphCell.cx;
-    pixels.top = rect.Top * _glyphCell.cy;
-    pixels.right = rect.Right * _glyphCell.cx;
-    pixels.bottom = rect.Bottom * _glyphCell.cy;
+    for (auto row = top; row <= bottom; ++row)
+    {
+        auto& slot = _scrollbackRows.at(_GetScrollbackSlot(row));
+        if (slot == row)
+        {
+            slot = s_ScrollbackEmpty;
+        }
+    }
+}
 
-    D2D1_RECT_F draw = { 0 };
-    draw.left = static_cast<float>(pixels.left);
-    draw.top = static_cast<float>(pixels.top);
+// Routine Description:
+// - Lets go of every row in the scrollback. The rows that were waiting to be
+//   copied in from it are invalidated instead, so that they get painted.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void DxEngine::_DropScrollback() noexcept
+{
+    std::fill(_scrollbackRows.begin(), _scrollbackRows.end(), s_ScrollbackEmpty);
+
+    const RECT display = _GetDisplayRect();
+    for (const auto row : _scrollbackPending)
+    {
+        const auto y = row - _scrollbackViewportTop;
+        _InvalidOr(RECT{ 0, y * _glyphCell.cy, display.right, (y + 1) * _glyphCell.cy });
+    }
+    _scrollbackPending.clear();
+}
+
+// Routine Description:
+// - Releases the scrollback texture, along with all of the rows in it.
+//   It's made again the next time rows are painted.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void DxEngine::_ReleaseScrollback() noexcept
+{
+    _DropScrollback();
+    _scrollbackTexture.Reset();
+    _scrollbackRows.clear();
+    _scrollbackRowHeight = 0;
+}
+
+// Routine Description:
+// - This paints in the back most layer of the frame with the background color.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK
+[[nodiscard]] HRESULT DxEngine::PaintBackground() noexcept
+{
+    /*_d2dRenderTarget->FillRectangle(D2D1::RectF((float)_invalidRect.left,
+                                                  (float)_invalidRect.top,
+                                                  (float)_invalidRect.right,
+                                                  (float)_invalidRect.bottom),
+                                                   _d2dBrushBackground.Get());
+*/
+
+    D2D1_COLOR_F nothing = { 0 };
+
+    // Only clear what's going to be painted over. The rest stays as the last frame left it.
+    if (_isInvalidUsed)
+    {
+        const auto rect = D2D1::RectF(static_cast<float>(_invalidRect.left),
+                                      static_cast<float>(_invalidRect.top),
+                                      static_cast<float>(_invalidRect.right),
+                                      static_cast<float>(_invalidRect.bottom));
+        _d2dRenderTarget->PushAxisAlignedClip(rect, D2D1_ANTIALIAS_MODE_ALIASED);
+        _d2dRenderTarget->Clear(nothing);
+        _d2dRenderTarget->PopAxisAlignedClip();
+    }
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Blocks until the swap chain is ready for another frame, so that we don't paint
+//   one that would only sit in a queue behind the last one while the text changes.
+// - Gives up after a while, so that a swap chain that stopped presenting (for instance
+//   while its window is hidden) can't keep us from ever painting again.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void DxEngine::WaitUntilCanRender() noexcept
+{
+    // If the device was lost, a new one is being made on the thread pool. This is the place
+    // to wait for it, before the console is locked, so that output isn't held up meanwhile.
+    if (!_haveDeviceResources || !DxDeviceManager::Instance().IsCurrent(_deviceGeneration))
+    {
+        DxDeviceManager::Instance().WaitForDevice(s_DeviceWaitTimeoutMilliseconds);
+        return;
+    }
+
+    if (_swapChainFrameLatencyWaitableObject)
+    {
+        const auto ret = WaitForSingleObjectEx(_swapChainFrameLatencyWaitableObject.get(),
+                                               s_FrameLatencyTimeoutMilliseconds,
+                                               TRUE);
+        LOG_LAST_ERROR_IF(ret == WAIT_FAILED);
+    }
+}
+
+// Routine Description:
+// - Places one line of text onto the screen at the given position
+// Arguments:
+// - clusters - Iterable collection of cluster information (text and columns it should consume)
+// - coord - Character coordinate position in the cell grid
+// - fTrimLeft - Whether or not to trim off the left half of a double wide character
+// Return Value:
+// - S_OK or relevant DirectX error
+[[nodiscard]] HRESULT DxEngine::PaintBufferLine(std::basic_string_view<Cluster> const clusters,
+                                                COORD const coord,
+                                                const bool /*trimLeft*/) noexcept
+{
+    try
+    {
+        // Calculate positioning of our origin.
+        D2D1_POINT_2F origin;
+        origin.x = static_cast<float>(coord.X * _glyphCell.cx);
+        origin.y = static_cast<float>(coord.Y * _glyphCell.cy);
+
+        // Hold on to the line, reusing what an earlier frame left behind where we can.
+        if (_queuedLineCount == _queuedLines.size())
+        {
+            _queuedLines.emplace_back();
+        }
+        auto& line = _queuedLines.at(_queuedLineCount);
+        line.text.clear();
+        line.clusters.clear();
+        line.origin = origin;
+        line.foreground = _foregroundColor;
+        line.fontVariant = _fontVariant;
+
+        size_t totalColumns = 0;
+        for (const auto& cluster : clusters)
+        {
+            line.text.append(cluster.GetText());
+            line.clusters.emplace_back(cluster.GetText().size(), cluster.GetColumns());
+            totalColumns += cluster.GetColumns();
+        }
+        _queuedLineCount++;
+
+        _QueueBackground(_backgroundColor,
+                         D2D1::RectF(origin.x,
+                                     origin.y,
+                                     origin.x + static_cast<float>(totalColumns * _glyphCell.cx),
+                                     origin.y + static_cast<float>(_glyphCell.cy)));
+    }
+    CATCH_RETURN();
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Adds a rectangle to the backgrounds to fill when the queued lines are drawn.
+//   A rectangle right next to the last one of the same color on the same row just extends it.
+// Arguments:
+// - color - The color to fill the rectangle with
+// - rect - The rectangle to fill
+// Return Value:
+// - <none>
+void DxEngine::_QueueBackground(const D2D1_COLOR_F color, const D2D1_RECT_F rect)
+{
+    auto batch = std::find_if(_queuedBackgrounds.begin(), _queuedBackgrounds.end(), [&](const auto& queued) {
+        return queued.color.r == color.r && queued.color.g == color.g && queued.color.b == color.b && queued.color.a == color.a;
+    });
+    if (batch == _queuedBackgrounds.end())
+    {
+        batch = _queuedBackgrounds.insert(_queuedBackgrounds.end(), { color, {} });
+    }
+
+    auto& rects = batch->rects;
+    if (!rects.empty() && rects.back().top == rect.top && rects.back().bottom == rect.bottom && rects.back().right == rect.left)
+    {
+        rects.back().right = rect.right;
+    }
+    else
+    {
+        rects.push_back(rect);
+    }
+}
+
+// Routine Description:
+// - Draws the lines queued up by PaintBufferLine: first the backgrounds of all of them,
+//   one color at a time, and then all of their text on top.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or relevant DirectX error
+[[nodiscard]] HRESULT DxEngine::_FlushQueuedLines() noexcept
+{
+    // Nothing stays queued, even if drawing fails part way through.
+    auto clearQueue = wil::scope_exit([&]() {
+        _queuedLineCount = 0;
+        _queuedBackgrounds.clear();
+        _queuedGridLines.clear();
+    });
+
+    for (const auto& batch : _queuedBackgrounds)
+    {
+        ID2D1SolidColorBrush* brush;
+        RETURN_IF_FAILED(_GetSolidColorBrush(batch.color, brush));
+        for (const auto& rect : batch.rects)
+        {
+            _d2dRenderTarget->FillRectangle(rect, brush);
+        }
+    }
+
+    const auto existingColor = _d2dBrushForeground->GetColor();
+    const auto restoreBrushOnExit = wil::scope_exit([&] { _d2dBrushForeground->SetColor(existingColor); });
+
+    try
+    {
+        std::vector<Cluster> clusters;
+        for (size_t i = 0; i < _queuedLineCount; i++)
+        {
+            const auto& line = _queuedLines.at(i);
+
+            // Cut the text back up into the clusters it came in. Each cluster starts where the one before ended.
+            clusters.clear();
+            const std::wstring_view text{ line.text };
+            size_t offset = 0;
+            for (const auto [length, columns] : line.clusters)
+            {
+                clusters.emplace_back(text.substr(offset, length), columns);
+                offset += length;
+            }
+
+            _d2dBrushForeground->SetColor(line.foreground);
+            RETURN_IF_FAILED(_DrawLineText({ clusters.data(), clusters.size() }, line.origin, line.fontVariant));
+        }
+    }
+    CATCH_RETURN();
+
+    // Lines in the same color as the one before don't need to look for a brush again.
+    ID2D1SolidColorBrush* gridLineBrush = nullptr;
+    const D2D1_COLOR_F* gridLineColor = nullptr;
+    for (const auto& line : _queuedGridLines)
+    {
+        if (!gridLineColor || gridLineColor->r != line.color.r || gridLineColor->g != line.color.g || gridLineColor->b != line.color.b || gridLineColor->a != line.color.a)
+        {
+            RETURN_IF_FAILED(_GetSolidColorBrush(line.color, gridLineBrush));
+            gridLineColor = &line.color;
+        }
+
+        _d2dRenderTarget->DrawLine(line.start, line.end, gridLineBrush);
+    }
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Queues a grid line to be drawn after the text that's queued. If it carries on
+//   from the last line queued, in the same direction and color, that one's made longer instead.
+// Arguments:
+// - color - The color of the line
+// - start - Where the line starts
+// - end - Where the line ends. Lines are horizontal or vertical and go right or down from start.
+// Return Value:
+// - <none>
+void DxEngine::_QueueGridLine(const D2D1_COLOR_F color, const D2D1_POINT_2F start, const D2D1_POINT_2F end)
+{
+    if (!_queuedGridLines.empty())
+    {
+        auto& last = _queuedGridLines.back();
+        const bool sameColor = last.color.r == color.r && last.color.g == color.g && last.color.b == color.b && last.color.a == color.a;
+        const bool horizontal = start.y == end.y && last.start.y == last.end.y;
+        const bool vertical = start.x == end.x && last.start.x == last.end.x;
+        if (sameColor && last.end.x == start.x && last.end.y == start.y && (horizontal || vertical))
+        {
+            last.end = end;
+            return;
+        }
+    }
+
+    _queuedGridLines.push_back({ color, start, end });
+}
+
+// Routine Description:
+// - Draws the text of one line onto the screen at the given position, leaving
+//   the background behind it alone.
+// Arguments:
+// - clusters - Iterable collection of cluster information (text and columns it should consume)
+// - origin - Where the line starts on the render target
+// - fontVariant - The variant of the font to draw the line in
+// Return Value:
+// - S_OK or relevant DirectX error
+[[nodiscard]] HRESULT DxEngine::_DrawLineText(std::basic_string_view<Cluster> const clusters,
+                                              const D2D1_POINT_2F origin,
+                                              const size_t fontVariant) noexcept
+{
+    try
+    {
+        // Most lines can be copied straight out of the glyph atlas.
+        const auto hrAtlas = _PaintBufferLineFromAtlas(clusters, origin, fontVariant);
+        RETURN_IF_FAILED(hrAtlas);
+        if (hrAtlas == S_OK)
+        {
+            return S_OK;
+        }
+
+        auto& font = _fontVariants.at(fontVariant);
+
+        // Create the text layout
+        CustomTextLayout layout(_dwriteFactory.Get(),
+                                _dwriteTextAnalyzer.Get(),
+                                font.textFormat.Get(),
+                                font.fontFace.Get(),
+                                clusters,
+                                _glyphCell.cx,
+                                &font.shapedRunCache);
+
+        // Get the baseline for this font as that's where we draw from
+        DWRITE_LINE_SPACING spacing;
+        RETURN_IF_FAILED(font.textFormat->GetLineSpacing(&spacing.method, &spacing.height, &spacing.baseline));
+
+        // Assemble the drawing context information. The background was already filled in.
+        DrawingContext context(_d2dRenderTarget.Get(),
+                               _d2dBrushForeground.Get(),
+                               nullptr,
+                               _dwriteFactory.Get(),
+                               spacing,
+                               D2D1::SizeF(gsl::narrow<FLOAT>(_glyphCell.cx), gsl::narrow<FLOAT>(_glyphCell.cy)),
+                               D2D1_DRAW_TEXT_OPTIONS_ENABLE_COLOR_FONT);
+
+        // Layout then render the text
+        RETURN_IF_FAILED(layout.Draw(&context, _customRenderer.Get(), origin.x, origin.y));
+    }
+    CATCH_RETURN();
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Places one line of text onto the screen by copying its glyphs out of the
+//   glyph atlas, drawing any that aren't in there yet first. The background is left alone.
+// - This only works for lines where every glyph comes straight out of our font
+//   face and fills its cells. The rest need the full text layout.
+// Arguments:
+// - clusters - Iterable collection of cluster information (text and columns it should consume)
+// - origin - Where the line starts on the render target
+// - fontVariant - The variant of the font to draw the line in
+// Return Value:
+// - S_OK if the line was painted. S_FALSE if it has to be painted with a text layout
+//   instead, in which case nothing was painted. Otherwise, a relevant DirectX error.
+[[nodiscard]] HRESULT DxEngine::_PaintBufferLineFromAtlas(std::basic_string_view<Cluster> const clusters,
+                                                          const D2D1_POINT_2F origin,
+                                                          const size_t fontVariant) noexcept
+{
+    if (!_glyphAtlasEnabled || !_glyphAtlasUsable || _glyphCell.cx <= 0 || _glyphCell.cy <= 0)
+    {
+        return S_FALSE;
+    }
+
+    try
+    {
+        // Check every cluster before drawing anything, so that we don't leave half a line behind
+        // if it turns out that the line needs the text layout after all.
+        // The same codepoint in another variant of the font is another glyph.
+        const auto variantBits = gsl::narrow_cast<UINT32>(fontVariant) << s_GlyphAtlasVariantShift;
+        const auto& font = _fontVariants.at(fontVariant);
+
+        _glyphAtlasKeys.clear();
+        for (const auto& cluster : clusters)
+        {
+            UINT32 key;
+            if (!s_GetGlyphAtlasKey(cluster, key))
+            {
+                return S_FALSE;
+            }
+            _glyphAtlasKeys.push_back(key == s_GlyphAtlasBlank ? key : key | variantBits);
+        }
+
+        if (!_glyphAtlasTarget)
+        {
+            RETURN_IF_FAILED(_CreateGlyphAtlas());
+        }
+
+        // Draw the glyphs that aren't in the atlas yet, all in one go.
+        bool drawing = false;
+        auto endDraw = wil::scope_exit([&]() {
+            if (drawing)
+            {
+                LOG_IF_FAILED(_glyphAtlasTarget->EndDraw());
+            }
+        });
+
+        for (size_t i = 0; i < _glyphAtlasKeys.size(); i++)
+        {
+            const auto key = _glyphAtlasKeys[i];
+            if (key == s_GlyphAtlasBlank || _glyphAtlasSlots.find(key) != _glyphAtlasSlots.end())
+            {
+                continue;
+            }
+
+            // Anything missing from our font has to go through font fallback in the text layout.
+            const UINT32 codepoint = (key & ((1u << s_GlyphAtlasVariantShift) - 1)) >> 2;
+            UINT16 glyphIndex = 0;
+            RETURN_IF_FAILED(font.fontFace->GetGlyphIndicesW(&codepoint, 1, &glyphIndex));
+            if (glyphIndex == 0)
+            {
+                return S_FALSE;
+            }
+
+            // Once the atlas is full, start over with an empty one. Whatever was already
+            // drawn from it this frame has to go out before its slots are drawn over.
+            if (_glyphAtlasNextSlot >= s_GlyphAtlasSlotsPerRow * s_GlyphAtlasRows)
+            {
+                endDraw.reset();
+                drawing = false;
+                RETURN_IF_FAILED(_d2dRenderTarget->Flush());
+                _glyphAtlasSlots.clear();
+                _glyphAtlasNextSlot = 0;
+                return S_FALSE;
+            }
+
+            const auto columns = gsl::narrow_cast<UINT32>(clusters[i].GetColumns());
+            const auto slotLeft = static_cast<float>((_glyphAtlasNextSlot % s_GlyphAtlasSlotsPerRow) * 2 * _glyphCell.cx);
+            const auto slotTop = static_cast<float>((_glyphAtlasNextSlot / s_GlyphAtlasSlotsPerRow) * _glyphCell.cy);
+            const auto slot = D2D1::RectF(slotLeft,
+                                          slotTop,
+                                          slotLeft + static_cast<float>(columns * _glyphCell.cx),
+                                          slotTop + static_cast<float>(_glyphCell.cy));
+
+            if (!drawing)
+            {
+                _glyphAtlasTarget->BeginDraw();
+                drawing = true;
+            }
+
+            RETURN_IF_FAILED(_DrawGlyphIntoAtlas(font, glyphIndex, columns, slot));
+            _glyphAtlasSlots.emplace(key, slot);
+            _glyphAtlasNextSlot++;
+        }
+
+        // The atlas has to be done drawing before we can copy out of it.
+        if (drawing)
+        {
+            drawing = false;
+            endDraw.release();
+            RETURN_IF_FAILED(_glyphAtlasTarget->EndDraw());
+        }
+
+        // Now copy each glyph onto the line. Opacity masks can only be filled without antialiasing.
+        const auto antialiasMode = _d2dRenderTarget->GetAntialiasMode();
+        _d2dRenderTarget->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+        auto restoreAntialiasMode = wil::scope_exit([&]() {
+            _d2dRenderTarget->SetAntialiasMode(antialiasMode);
+        });
+
+        auto left = origin.x;
+        for (size_t i = 0; i < _glyphAtlasKeys.size(); i++)
+        {
+            const auto width = static_cast<float>(clusters[i].GetColumns() * _glyphCell.cx);
+            const auto key = _glyphAtlasKeys[i];
+            if (key != s_GlyphAtlasBlank)
+            {
+                const auto& source = _glyphAtlasSlots.at(key);
+                const auto destination = D2D1::RectF(left, origin.y, left + width, origin.y + static_cast<float>(_glyphCell.cy));
+                _d2dRenderTarget->FillOpacityMask(_glyphAtlasBitmap.Get(),
+                                                  _d2dBrushForeground.Get(),
+                                                  D2D1_OPACITY_MASK_CONTENT_TEXT_GRAYSCALE,
+                                                  &destination,
+                                                  &source);
+            }
+            left += width;
+        }
+    }
+    CATCH_RETURN();
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Creates an empty glyph atlas for the current font, compatible with our render target.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or relevant DirectX error
+[[nodiscard]] HRESULT DxEngine::_CreateGlyphAtlas() noexcept
+{
+    _ReleaseGlyphAtlas();
+    auto releaseOnFail = wil::scope_exit([&]() { _ReleaseGlyphAtlas(); });
+
+    const auto size = D2D1::SizeF(static_cast<float>(s_GlyphAtlasSlotsPerRow * 2 * _glyphCell.cx),
+                                  static_cast<float>(s_GlyphAtlasRows * _glyphCell.cy));
+    const auto format = D2D1::PixelFormat(DXGI_FORMAT_A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED);
+
+    RETURN_IF_FAILED(_d2dRenderTarget->CreateCompatibleRenderTarget(&size,
+                                                                    nullptr,
+                                                                    &format,
+                                                                    D2D1_COMPATIBLE_RENDER_TARGET_OPTIONS_NONE,
+                                                                    &_glyphAtlasTarget));
+
+    // Match the text antialiasing of the render target, so the glyphs look the same either way.
+    _glyphAtlasTarget->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE);
+
+    RETURN_IF_FAILED(_glyphAtlasTarget->GetBitmap(&_glyphAtlasBitmap));
+    RETURN_IF_FAILED(_glyphAtlasTarget->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White),
+                                                              &_glyphAtlasBrush));
+
+    releaseOnFail.release();
+    return S_OK;
+}
+
+// Routine Description:
+// - Draws a glyph into a slot of the atlas. It's placed the same way the text
+//   layout places it in its cells: centered if it's too narrow for them, and
+//   shrunk down if it's too wide.
+// - The atlas must be between BeginDraw and EndDraw.
+// Arguments:
+// - font - The variant of the font the glyph is in
+// - glyphIndex - The glyph in its font face to draw
+// - columns - How many cells the glyph is to fill
+// - slot - Where in the atlas the glyph goes
+// Return Value:
+// - S_OK or relevant DirectWrite error
+[[nodiscard]] HRESULT DxEngine::_DrawGlyphIntoAtlas(const FontVariant& font, const UINT16 glyphIndex, const UINT32 columns, const D2D1_RECT_F slot) noexcept
+{
+    DWRITE_FONT_METRICS1 metrics;
+    font.fontFace->GetMetrics(&metrics);
+
+    INT32 advanceInDesignUnits = 0;
+    RETURN_IF_FAILED(font.fontFace->GetDesignGlyphAdvances(1, &glyphIndex, &advanceInDesignUnits));
+
+    DWRITE_LINE_SPACING spacing;
+    RETURN_IF_FAILED(font.textFormat->GetLineSpacing(&spacing.method, &spacing.height, &spacing.baseline));
+
+    const auto advanceExpected = static_cast<float>(columns * _glyphCell.cx);
+    const auto widthAdvance = static_cast<float>(advanceInDesignUnits) / metrics.designUnitsPerEm;
+
+    auto fontSize = font.textFormat->GetFontSize();
+    auto offset = 0.0f;
+    const auto advance = widthAdvance * fontSize;
+    if (advanceExpected > advance)
+    {
+        offset = (advanceExpected - advance) / 2;
+    }
+    else if (advanceExpected < advance && widthAdvance > 0)
+    {
+        fontSize = advanceExpected / widthAdvance;
+    }
+
+    DWRITE_GLYPH_RUN glyphRun = { 0 };
+    glyphRun.fontFace = font.fontFace.Get();
+    glyphRun.fontEmSize = fontSize;
+    glyphRun.glyphCount = 1;
+    glyphRun.glyphIndices = &glyphIndex;
+    glyphRun.glyphAdvances = &advanceExpected;
+
+    // Clip to the slot since the glyph might reach out of its cells, just like it would get painted
+    // over by its neighbors' backgrounds on screen. Whatever was left in the slot goes, too.
+    _glyphAtlasTarget->PushAxisAlignedClip(slot, D2D1_ANTIALIAS_MODE_ALIASED);
+    _glyphAtlasTarget->Clear(D2D1::ColorF(0, 0.0f));
+    _glyphAtlasTarget->DrawGlyphRun(D2D1::Point2F(slot.left + offset, slot.top + spacing.baseline),
+                                    &glyphRun,
+                                    _glyphAtlasBrush.Get(),
+                                    DWRITE_MEASURING_MODE_NATURAL);
+    _glyphAtlasTarget->PopAxisAlignedClip();
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Lets go of the glyph atlas, so that it'll be created again the next time it's needed.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void DxEngine::_ReleaseGlyphAtlas() noexcept
+{
+    _glyphAtlasSlots.clear();
+    _glyphAtlasNextSlot = 0;
+    _glyphAtlasBrush.Reset();
+    _glyphAtlasBitmap.Reset();
+    _glyphAtlasTarget.Reset();
+}
+
+// Routine Description:
+// - Works out what a cluster is called in the glyph atlas.
+// Arguments:
+// - cluster - The cluster to look up
+// - key - Receives the key of the cluster: its codepoint with its column count in
+//         the bottom 2 bits, or s_GlyphAtlasBlank for a space, which has nothing to draw.
+// Return Value:
+// - true if the cluster could come out of the atlas. false if it needs the text layout.
+[[nodiscard]] bool DxEngine::s_GetGlyphAtlasKey(const Cluster& cluster, _Out_ UINT32& key) noexcept
+{
+    key = s_GlyphAtlasBlank;
+
+    const auto columns = cluster.GetColumns();
+    if (columns < 1 || columns > 2)
+    {
+        return false;
+    }
+
+    const auto& text = cluster.GetText();
+    UINT32 codepoint = 0;
+    if (text.size() == 1 && !IS_HIGH_SURROGATE(text[0]) && !IS_LOW_SURROGATE(text[0]))
+    {
+        codepoint = text[0];
+    }
+    else if (text.size() == 2 && IS_HIGH_SURROGATE(text[0]) && IS_LOW_SURROGATE(text[1]))
+    {
+        codepoint = 0x10000 + ((text[0] - 0xD800) << 10) + (text[1] - 0xDC00);
+    }
+    else
+    {
+        return false;
+    }
+
+    if (codepoint != UNICODE_SPACE)
+    {
+        key = codepoint << 2 | gsl::narrow_cast<UINT32>(columns);
+    }
+    return true;
+}
+
+// Routine Description:
+// - Paints lines around cells (draws in pieces of the grid)
+// Arguments:
+// - lines - Which grid lines (top, left, bottom, right) to draw
+// - color - The color to use for drawing the lines
+// - cchLine - Length of the line to draw in character cells
+// - coordTarget - The X,Y character position in the grid where we should start drawing
+//               - We will draw rightward (+X) from here
+// Return Value:
+// - S_OK or relevant DirectX error
+[[nodiscard]] HRESULT DxEngine::PaintBufferGridLines(GridLines const lines,
+                                                     COLORREF const color,
+                                                     size_t const cchLine,
+                                                     COORD const coordTarget) noexcept
+{
+    RETURN_HR_IF(S_OK, lines == GridLines::None);
+
+    // The lines are queued to go on over the text that's still queued, rather than
+    // flushing it early, so the backgrounds of the rest of the frame still go in one batch.
+    const auto lineColor = D2D1::ColorF(color);
+
+    const auto font = _GetFontSize();
+    D2D_POINT_2F target;
+    target.x = static_cast<float>(coordTarget.X) * font.X;
+    target.y = static_cast<float>(coordTarget.Y) * font.Y;
+
+    const float runWidth = static_cast<float>(cchLine) * font.X;
+
+    // The top and bottom of every cell in the run line up, so each is queued as one line.
+    if (lines & GridLines::Top)
+    {
+        _QueueGridLine(lineColor, target, { target.x + runWidth, target.y });
+    }
+
+    // NOTE: Watch out for inclusive/exclusive rectangles here.
+    // We have to remove 1 from the font size for the bottom and right lines to ensure that the
+    // starting point remains within the clipping rectangle.
+    // For example, if we're drawing a letter at 0,0 and the font size is 8x16....
+    // The bottom left corner inclusive is at 0,15 which is Y (0) + Font Height (16) - 1 = 15.
+    // The top right corner inclusive is at 7,0 which is X (0) + Font Height (8) - 1 = 7.
+
+    if (lines & GridLines::Bottom)
+    {
+        const float bottom = target.y + font.Y - 1;
+        _QueueGridLine(lineColor, { target.x, bottom }, { target.x + runWidth, bottom });
+    }
+
+    if (lines & (GridLines::Left | GridLines::Right))
+    {
+        for (size_t i = 0; i < cchLine; i++)
+        {
+            if (lines & GridLines::Left)
+            {
+                _QueueGridLine(lineColor, target, { target.x, target.y + font.Y });
+            }
+
+            if (lines & GridLines::Right)
+            {
+                const float right = target.x + font.X - 1;
+                _QueueGridLine(lineColor, { right, target.y }, { right, target.y + font.Y });
+            }
+
+            // Move to the next character in this run.
+            target.x += font.X;
+        }
+    }
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Paints an overlay highlight on a portion of the frame to represent selected text
+// Arguments:
+//  - rect - Rectangle to invert or highlight to make the selection area
+// Return Value:
+// - S_OK or relevant DirectX error.
+[[nodiscard]] HRESULT DxEngine::PaintSelection(const SMALL_RECT rect) noexcept
+{
+    // The selection goes over the text that's still queued, and stays out of the scrollback.
+    RETURN_IF_FAILED(_FlushQueuedLines());
+    LOG_IF_FAILED(_SaveScrollbackRows());
+
+    const auto existingColor = _d2dBrushForeground->GetColor();
+    const auto selectionColor = D2D1::ColorF(_defaultForegroundColor.r,
+                                             _defaultForegroundColor.g,
+                                             _defaultForegroundColor.b,
+                                             0.5f);
+
+    _d2dBrushForeground->SetColor(selectionColor);
+    const auto resetColorOnExit = wil::scope_exit([&] { _d2dBrushForeground->SetColor(existingColor); });
+
+    RECT pixels;
+    pixels.left = rect.Left * _glyphCell.cx;
+    pixels.top = rect.Top * _glyphCell.cy;
+    pixels.right = rect.Right * _glyphCell.cx;
+    pixels.bottom = rect.Bottom * _glyphCell.cy;
+
+    D2D1_RECT_F draw = { 0 };
+    draw.left = static_cast<float>(pixels.left);
+    draw.top = static_cast<float>(pixels.top);
     draw.right = static_cast<float>(pixels.right);
     draw.bottom = static_cast<float>(pixels.bottom);
 
@@ -1054,6 +2173,11 @@ enum class CursorPaintType
     {
         return S_FALSE;
     }
+
+    // The cursor goes over the text that's still queued, and stays out of the scrollback.
+    RETURN_IF_FAILED(_FlushQueuedLines());
+    LOG_IF_FAILED(_SaveScrollbackRows());
+
     // Create rectangular block representing where the cursor can fill.
     D2D1_RECT_F rect = { 0 };
     rect.left = static_cast<float>(options.coordCursor.X * _glyphCell.cx);
@@ -1105,24 +2229,24 @@ enum class CursorPaintType
         return E_NOTIMPL;
     }
 
-    Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> brush = _d2dBrushForeground;
+    ID2D1SolidColorBrush* brush = _d2dBrushForeground.Get();
 
     if (options.fUseColor)
     {
         // Make sure to make the cursor opaque
-        RETURN_IF_FAILED(_d2dRenderTarget->CreateSolidColorBrush(_ColorFFromColorRef(OPACITY_OPAQUE | options.cursorColor), &brush));
+        RETURN_IF_FAILED(_GetSolidColorBrush(_ColorFFromColorRef(OPACITY_OPAQUE | options.cursorColor), brush));
     }
 
     switch (paintType)
     {
     case CursorPaintType::Fill:
     {
-        _d2dRenderTarget->FillRectangle(rect, brush.Get());
+        _d2dRenderTarget->FillRectangle(rect, brush);
         break;
     }
     case CursorPaintType::Outline:
     {
-        _d2dRenderTarget->DrawRectangle(rect, brush.Get());
+        _d2dRenderTarget->DrawRectangle(rect, brush);
         break;
     }
     default:
@@ -1132,25 +2256,72 @@ enum class CursorPaintType
     return S_OK;
 }
 
+// Routine Description:
+// - Gets a brush of the given color out of the cache, creating one if there isn't one
+//   yet. Once the cache is full, the brushes in it get recolored in turn instead.
+// Arguments:
+// - color - The color of the brush
+// - brush - Receives the brush. It belongs to the cache and is only good until the next call.
+// Return Value:
+// - S_OK or relevant DirectX error.
+[[nodiscard]] HRESULT DxEngine::_GetSolidColorBrush(const D2D1_COLOR_F color, _Out_ ID2D1SolidColorBrush*& brush) noexcept
+{
+    brush = nullptr;
+
+    try
+    {
+        const auto found = std::find_if(_brushCache.cbegin(), _brushCache.cend(), [&](const auto& cached) {
+            return cached.first.r == color.r && cached.first.g == color.g && cached.first.b == color.b && cached.first.a == color.a;
+        });
+        if (found != _brushCache.cend())
+        {
+            brush = found->second.Get();
+            return S_OK;
+        }
+
+        if (_brushCache.size() < s_MaxCachedBrushes)
+        {
+            ::Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> created;
+            RETURN_IF_FAILED(_d2dRenderTarget->CreateSolidColorBrush(color, &created));
+            _brushCache.emplace_back(color, created);
+            brush = created.Get();
+            return S_OK;
+        }
+
+        auto& reused = _brushCache.at(_brushCacheNext);
+        _brushCacheNext = (_brushCacheNext + 1) % _brushCache.size();
+        reused.first = color;
+        reused.second->SetColor(color);
+        brush = reused.second.Get();
+    }
+    CATCH_RETURN();
+
+    return S_OK;
+}
+
 // Routine Description:
 // - Updates the default brush colors used for drawing
 // Arguments:
 // - colorForeground - Foreground brush color
 // - colorBackground - Background brush color
 // - legacyColorAttribute - <unused>
-// - isBold - <unused>
+// - isBold - Whether the text that follows is drawn in the bold variant of the font
 // - isSettingDefaultBrushes - Lets us know that these are the default brushes to paint the swapchain background or selection
 // Return Value:
 // - S_OK or relevant DirectX error.
 [[nodiscard]] HRESULT DxEngine::UpdateDrawingBrushes(COLORREF const colorForeground,
                                                      COLORREF const colorBackground,
                                                      const WORD /*legacyColorAttribute*/,
-                                                     const bool /*isBold*/,
+                                                     const bool isBold,
                                                      bool const isSettingDefaultBrushes) noexcept
 {
     _foregroundColor = _ColorFFromColorRef(colorForeground);
     _backgroundColor = _ColorFFromColorRef(colorBackground);
 
+    _fontVariant = _GetFontVariant(isBold ? DWRITE_FONT_WEIGHT_BOLD : DWRITE_FONT_WEIGHT_NORMAL,
+                                   DWRITE_FONT_STYLE_NORMAL,
+                                   DWRITE_FONT_STRETCH_NORMAL);
+
     _d2dBrushForeground->SetColor(_foregroundColor);
     _d2dBrushBackground->SetColor(_backgroundColor);
 
@@ -1172,6 +2343,74 @@ enum class CursorPaintType
     return S_OK;
 }
 
+// Routine Description:
+// - Finds the variant of the current font with the given weight, style and stretch,
+//   creating it the first time that it's asked for.
+// - It's laid out in the same cells as the regular font: it has the same size and
+//   baseline, and glyphs that turn out too wide are shrunk to fit like any others.
+// Arguments:
+// - weight - The weight (bold, light, etc.)
+// - style - Normal, italic, etc.
+// - stretch - The stretch of the font is the spacing between each letter
+// Return Value:
+// - The index of the variant in _fontVariants. If it couldn't be made,
+//   or there are too many already, the regular font's, which is 0.
+[[nodiscard]] size_t DxEngine::_GetFontVariant(const DWRITE_FONT_WEIGHT weight,
+                                               const DWRITE_FONT_STYLE style,
+                                               const DWRITE_FONT_STRETCH stretch) noexcept
+{
+    for (size_t i = 0; i < _fontVariants.size(); ++i)
+    {
+        const auto& variant = _fontVariants[i];
+        if (variant.weight == weight && variant.style == style && variant.stretch == stretch)
+        {
+            return i;
+        }
+    }
+
+    if (_fontVariants.empty() || _fontVariants.size() >= s_MaxFontVariants)
+    {
+        return 0;
+    }
+
+    try
+    {
+        const auto& regular = _fontVariants.front();
+
+        const auto familyNameLength = regular.textFormat->GetFontFamilyNameLength() + 1; // 1 for space for null
+        std::wstring familyName(familyNameLength, L'\0');
+        THROW_IF_FAILED(regular.textFormat->GetFontFamilyName(familyName.data(), familyNameLength));
+        familyName.resize(familyNameLength - 1);
+
+        // Families without this variant give us the closest one they have, which might
+        // be the regular face again. It still gets its own entry, so we don't look again.
+        auto fontFace = _FindFontFace(familyName, weight, stretch, style);
+        THROW_IF_NULL_ALLOC(fontFace);
+
+        Microsoft::WRL::ComPtr<IDWriteTextFormat> textFormat;
+        THROW_IF_FAILED(_dwriteFactory->CreateTextFormat(familyName.c_str(),
+                                                         nullptr,
+                                                         weight,
+                                                         style,
+                                                         stretch,
+                                                         regular.textFormat->GetFontSize(),
+                                                         L"",
+                                                         &textFormat));
+
+        DWRITE_LINE_SPACING spacing;
+        THROW_IF_FAILED(regular.textFormat->GetLineSpacing(&spacing.method, &spacing.height, &spacing.baseline));
+        THROW_IF_FAILED(textFormat->SetLineSpacing(spacing.method, spacing.height, spacing.baseline));
+        THROW_IF_FAILED(textFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR));
+        THROW_IF_FAILED(textFormat->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP));
+
+        _fontVariants.push_back({ weight, style, stretch, std::move(textFormat), std::move(fontFace) });
+        return _fontVariants.size() - 1;
+    }
+    CATCH_LOG();
+
+    return 0;
+}
+
 // Routine Description:
 // - Updates the font used for drawing
 // Arguments:
@@ -1193,6 +2432,41 @@ enum class CursorPaintType
     _glyphCell.cx = size.X;
     _glyphCell.cy = size.Y;
 
+    // The glyphs in the atlas, the cached lines and the rows in the scrollback were laid out with the old font.
+    // So were the other variants of it; they're made again as they're needed.
+    _ReleaseGlyphAtlas();
+    _fontVariants.clear();
+    _fontVariant = 0;
+    _ReleaseScrollback();
+
+    if (SUCCEEDED(hr))
+    {
+        try
+        {
+            // The shaped run caches point into themselves and mustn't be copied,
+            // so the variants are given all the room they can take up front.
+            _fontVariants.reserve(s_MaxFontVariants);
+            _fontVariants.push_back({ DWRITE_FONT_WEIGHT_NORMAL,
+                                      DWRITE_FONT_STYLE_NORMAL,
+                                      DWRITE_FONT_STRETCH_NORMAL,
+                                      _dwriteTextFormat,
+                                      _dwriteFontFace });
+        }
+        CATCH_RETURN();
+    }
+
+    // An alpha-only atlas would lose the colors of color glyphs, so fonts that have them
+    // always go through the text layout.
+    _glyphAtlasUsable = false;
+    if (SUCCEEDED(hr) && _dwriteFontFace)
+    {
+        ::Microsoft::WRL::ComPtr<IDWriteFontFace2> fontFace2;
+        if (SUCCEEDED(_dwriteFontFace.As(&fontFace2)))
+        {
+            _glyphAtlasUsable = !fontFace2->IsColorFont();
+        }
+    }
+
     return hr;
 }
 
@@ -1217,6 +2491,9 @@ enum class CursorPaintType
     // The scale factor may be necessary for composition contexts, so save it once here.
     _scale = _dpi / static_cast<float>(USER_DEFAULT_SCREEN_DPI);
 
+    _ReleaseGlyphAtlas();
+    _ReleaseScrollback();
+
     RETURN_IF_FAILED(InvalidateAll());
 
     return S_OK;
@@ -1235,14 +2512,15 @@ float DxEngine::GetScaling() const noexcept
 }
 
 // Method Description:
-// - This method will update our internal reference for how big the viewport is.
-//      Does nothing for DX.
+// - This method will update our internal reference for where the viewport is.
+//      DX only needs its top, to know which rows of the buffer are on screen.
 // Arguments:
 // - srNewViewport - The bounds of the new viewport.
 // Return Value:
 // - HRESULT S_OK
-[[nodiscard]] HRESULT DxEngine::UpdateViewport(const SMALL_RECT /*srNewViewport*/) noexcept
+[[nodiscard]] HRESULT DxEngine::UpdateViewport(const SMALL_RECT srNewViewport) noexcept
 {
+    _viewportTop = srNewViewport.Top;
     return S_OK;
 }
 
@@ -1360,6 +2638,8 @@ float DxEngine::GetScaling() const noexcept
 // - weight - The weight (bold, light, etc.)
 // - stretch - The stretch of the font is the spacing between each letter
 // - style - Normal, italic, etc.
+// - Faces found are shared with every other engine in the process, so that
+//   the system font collection is only searched the first time.
 // Return Value:
 // - Smart pointer holding interface reference for queryable font data.
 [[nodiscard]] Microsoft::WRL::ComPtr<IDWriteFontFace1> DxEngine::_FindFontFace(const std::wstring& familyName,
@@ -1367,7 +2647,12 @@ float DxEngine::GetScaling() const noexcept
                                                                                DWRITE_FONT_STRETCH stretch,
                                                                                DWRITE_FONT_STYLE style) const
 {
-    Microsoft::WRL::ComPtr<IDWriteFontFace1> fontFace;
+    auto& cache = FontFallbackCache::Instance();
+    Microsoft::WRL::ComPtr<IDWriteFontFace1> fontFace = cache.FindFontFace(familyName, weight, stretch, style);
+    if (fontFace)
+    {
+        return fontFace;
+    }
 
     Microsoft::WRL::ComPtr<IDWriteFontCollection> fontCollection;
     THROW_IF_FAILED(_dwriteFactory->GetSystemFontCollection(&fontCollection, false));
@@ -1388,6 +2673,8 @@ float DxEngine::GetScaling() const noexcept
         THROW_IF_FAILED(font->CreateFontFace(&fontFace0));
 
         THROW_IF_FAILED(fontFace0.As(&fontFace));
+
+        cache.StoreFontFace(familyName, weight, stretch, style, fontFace);
     }
 
     return fontFace;
@@ -22,6 +22,8 @@
 #include <wrl/client.h>
 
 #include "CustomTextRenderer.h"
+#include "ShapedRunCache.h"
+#include "DxDeviceManager.h"
 
 #include "../../types/inc/Viewport.hpp"
 
@@ -45,6 +47,8 @@ namespace Microsoft::Console::Render
 
         void SetCallback(std::function<void()> pfn);
 
+        void SetGlyphAtlasEnabled(const bool enabled) noexcept;
+
         ::Microsoft::WRL::ComPtr<IDXGISwapChain1> GetSwapChain() noexcept;
 
         // IRenderEngine Members
@@ -55,6 +59,7 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT InvalidateScroll(const COORD* const pcoordDelta) noexcept override;
         [[nodiscard]] HRESULT InvalidateAll() noexcept override;
         [[nodiscard]] HRESULT InvalidateCircling(_Out_ bool* const pForcePaint) noexcept override;
+        [[nodiscard]] HRESULT InvalidateOffscreen(const SMALL_RECT* const psrRegion) noexcept override;
         [[nodiscard]] HRESULT PrepareForTeardown(_Out_ bool* const pForcePaint) noexcept override;
 
         [[nodiscard]] HRESULT StartPaint() noexcept override;
@@ -64,6 +69,8 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT ScrollFrame() noexcept override;
 
         [[nodiscard]] HRESULT PaintBackground() noexcept override;
+        void WaitUntilCanRender() noexcept override;
+
         [[nodiscard]] HRESULT PaintBufferLine(std::basic_string_view<Cluster> const clusters,
                                               COORD const coord,
                                               bool const fTrimLeft) noexcept override;
@@ -135,12 +142,48 @@ namespace Microsoft::Console::Render
 
         void _InvalidOffset(POINT pt) noexcept;
 
+        // What changed in the frame, in pixels of the swap chain surface. _presentScroll is where
+        // ScrollFrame moved the last frame's content to, which it moved by _presentOffset.
         bool _presentReady;
+        bool _presentPartial;
         RECT _presentDirty;
         RECT _presentScroll;
         POINT _presentOffset;
         DXGI_PRESENT_PARAMETERS _presentParams;
 
+        // The first frame on a new or resized swap chain has to be presented whole.
+        bool _firstFrame;
+
+        // Rows of text that were painted whole are kept in a texture with a slot for each of the last
+        // few screens of rows, so that scrolling back to them copies them in instead of painting them.
+        // Slots are keyed by the row of the buffer they hold, which is the row on screen plus the top of
+        // the viewport, and a row always goes in the same slot. The texture holds just the text, without
+        // the cursor or selection. It's only good for one font at one size, and goes with the swap chain.
+        ::Microsoft::WRL::ComPtr<ID3D11Texture2D> _scrollbackTexture;
+        std::vector<LONG> _scrollbackRows; // the buffer row in each slot, or s_ScrollbackEmpty
+        LONG _scrollbackRowHeight; // pixels of the surface each row takes
+        std::vector<LONG> _scrollbackPending; // buffer rows the scroll revealed that ScrollFrame copies in
+        RECT _scrollbackRestored; // where ScrollFrame copied rows in, in pixels of the surface
+        bool _scrollbackSaved; // set once the rows painted in the frame went into the texture
+        LONG _viewportTop; // buffer row at the top of the viewport we've been told about
+        LONG _scrollbackViewportTop; // buffer row at the top of what's on the surface
+        bool _selectionShown; // rows with selection on them can't be copied in without it
+
+        static constexpr LONG s_ScrollbackEmpty = LONG_MIN;
+        static constexpr LONG s_ScrollbackScreens = 2;
+        static constexpr UINT64 s_ScrollbackMaxPixels = 4096 * 4096;
+
+        [[nodiscard]] size_t _GetScrollbackSlot(const LONG row) const noexcept;
+        [[nodiscard]] bool _HasScrollbackRow(const LONG row) const noexcept;
+        void _InvalidRevealed(const RECT& reveal) noexcept;
+        [[nodiscard]] HRESULT _RestoreScrollbackRows() noexcept;
+        [[nodiscard]] HRESULT _SaveScrollbackRows() noexcept;
+        void _DropScrollbackRows(const LONG top, const LONG bottom) noexcept;
+        void _DropScrollback() noexcept;
+        void _ReleaseScrollback() noexcept;
+
+        [[nodiscard]] RECT _ToSurfaceRect(const RECT& rc) const noexcept;
+
         static const ULONG s_ulMinCursorHeightPercent = 25;
         static const ULONG s_ulMaxCursorHeightPercent = 100;
 
@@ -152,29 +195,143 @@ namespace Microsoft::Console::Render
         ::Microsoft::WRL::ComPtr<IDWriteTextAnalyzer1> _dwriteTextAnalyzer;
         ::Microsoft::WRL::ComPtr<CustomTextRenderer> _customRenderer;
 
+        // Every weight, style and stretch of the font that lines have been drawn in, each with a text
+        // format and face of its own, so that switching between them from one line to the next is just
+        // picking another entry. Each keeps its own recently shaped lines, too, so that bold lines don't
+        // push regular ones out. The first is always the regular font in _dwriteTextFormat and
+        // _dwriteFontFace. The others are made the first time they're asked for and go with the font.
+        struct FontVariant
+        {
+            DWRITE_FONT_WEIGHT weight;
+            DWRITE_FONT_STYLE style;
+            DWRITE_FONT_STRETCH stretch;
+            ::Microsoft::WRL::ComPtr<IDWriteTextFormat> textFormat;
+            ::Microsoft::WRL::ComPtr<IDWriteFontFace1> fontFace;
+            ShapedRunCache shapedRunCache; // lines of text that were laid out recently, to be drawn again without shaping
+        };
+
+        std::vector<FontVariant> _fontVariants;
+        size_t _fontVariant; // the one the lines painted next are drawn in
+
+        // Glyph atlas keys hold the font variant in their top bits.
+        static constexpr size_t s_MaxFontVariants = 8;
+        static constexpr UINT32 s_GlyphAtlasVariantShift = 24;
+
+        [[nodiscard]] size_t _GetFontVariant(const DWRITE_FONT_WEIGHT weight,
+                                             const DWRITE_FONT_STYLE style,
+                                             const DWRITE_FONT_STRETCH stretch) noexcept;
+
         // Device-Dependent Resources
+        // The device, its context and the DXGI factory come from the DxDeviceManager and are shared
+        // with every other engine in the process. Everything else here is our own.
         bool _haveDeviceResources;
         ::Microsoft::WRL::ComPtr<ID3D11Device> _d3dDevice;
         ::Microsoft::WRL::ComPtr<ID3D11DeviceContext> _d3dDeviceContext;
         ::Microsoft::WRL::ComPtr<IDXGIFactory2> _dxgiFactory2;
+        UINT64 _deviceGeneration; // which of the manager's devices we have, to know once it's been lost
         ::Microsoft::WRL::ComPtr<IDXGISurface> _dxgiSurface;
         ::Microsoft::WRL::ComPtr<ID2D1RenderTarget> _d2dRenderTarget;
         ::Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> _d2dBrushForeground;
         ::Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> _d2dBrushBackground;
         ::Microsoft::WRL::ComPtr<IDXGISwapChain1> _dxgiSwapChain;
 
+        // Signaled when the swap chain can take another frame. With a frame latency of 1, waiting on
+        // it before painting keeps frames from queuing up behind the one that's being displayed.
+        wil::unique_handle _swapChainFrameLatencyWaitableObject;
+        UINT _swapChainFlags;
+
+        static constexpr DWORD s_FrameLatencyTimeoutMilliseconds = 100;
+
+        // The longest a frame waits for a new device to be made after the last one was lost.
+        static constexpr DWORD s_DeviceWaitTimeoutMilliseconds = 500;
+
         [[nodiscard]] HRESULT _CreateDeviceResources(const bool createSwapChain) noexcept;
 
         [[nodiscard]] HRESULT _PrepareRenderTarget() noexcept;
 
         void _ReleaseDeviceResources() noexcept;
+        void _CheckDeviceLost() noexcept;
+        void _PaintClearFrame() noexcept;
+
+        // Glyphs that come straight out of our font face and fill one or two cells are drawn once
+        // into an alpha-only atlas. A line made up only of those is then painted by copying each
+        // cell out of the atlas through the foreground brush, without laying out any text at all.
+        // The atlas is only good for one font at one size, and has to go with the render target.
+        bool _glyphAtlasEnabled;
+        bool _glyphAtlasUsable; // false if the font has color glyphs, which an alpha-only atlas can't hold
+        ::Microsoft::WRL::ComPtr<ID2D1BitmapRenderTarget> _glyphAtlasTarget;
+        ::Microsoft::WRL::ComPtr<ID2D1Bitmap> _glyphAtlasBitmap;
+        ::Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> _glyphAtlasBrush;
+        std::unordered_map<UINT32, D2D1_RECT_F> _glyphAtlasSlots; // keyed by s_GetGlyphAtlasKey, with the font variant on top
+        UINT32 _glyphAtlasNextSlot;
+        std::vector<UINT32> _glyphAtlasKeys; // scratch space for the keys of the line being painted
+
+        // Each slot is two cells wide, so that it can hold wide glyphs too.
+        static constexpr UINT32 s_GlyphAtlasSlotsPerRow = 64;
+        static constexpr UINT32 s_GlyphAtlasRows = 32;
+        static constexpr UINT32 s_GlyphAtlasBlank = 0;
+
+        // The lines of a frame aren't drawn as they come in. Their backgrounds are gathered by color
+        // and filled all at once, and then all of their text is drawn on top. That happens as soon
+        // as anything else needs to be drawn over the text, and at the very latest at EndPaint.
+        struct QueuedLine
+        {
+            std::wstring text;
+            std::vector<std::pair<size_t, size_t>> clusters; // length of the text of each cluster and its columns
+            D2D1_POINT_2F origin;
+            D2D1_COLOR_F foreground;
+            size_t fontVariant; // index into _fontVariants
+        };
+
+        struct QueuedBackground
+        {
+            D2D1_COLOR_F color;
+            std::vector<D2D1_RECT_F> rects;
+        };
+
+        // Grid lines go on after all of the queued text. A line that carries on
+        // from the last one queued in the same color is drawn as part of it.
+        struct QueuedGridLine
+        {
+            D2D1_COLOR_F color;
+            D2D1_POINT_2F start;
+            D2D1_POINT_2F end;
+        };
+
+        std::vector<QueuedLine> _queuedLines;
+        size_t _queuedLineCount; // the rest of _queuedLines are kept around to be reused
+        std::vector<QueuedBackground> _queuedBackgrounds;
+        std::vector<QueuedGridLine> _queuedGridLines;
+
+        // Brushes for colors other than the current foreground and background, such as the cursor's
+        // and the backgrounds of queued lines. Like other device resources, they go with the render target.
+        std::vector<std::pair<D2D1_COLOR_F, ::Microsoft::WRL::ComPtr<ID2D1SolidColorBrush>>> _brushCache;
+        size_t _brushCacheNext; // entry to reuse next once the cache is full
+
+        static constexpr size_t s_MaxCachedBrushes = 16;
+
+        void _QueueBackground(const D2D1_COLOR_F color, const D2D1_RECT_F rect);
+        void _QueueGridLine(const D2D1_COLOR_F color, const D2D1_POINT_2F start, const D2D1_POINT_2F end);
+        [[nodiscard]] HRESULT _FlushQueuedLines() noexcept;
+        [[nodiscard]] HRESULT _DrawLineText(std::basic_string_view<Cluster> const clusters,
+                                            const D2D1_POINT_2F origin,
+                                            const size_t fontVariant) noexcept;
+        [[nodiscard]] HRESULT _GetSolidColorBrush(const D2D1_COLOR_F color, _Out_ ID2D1SolidColorBrush*& brush) noexcept;
+
+        [[nodiscard]] HRESULT _PaintBufferLineFromAtlas(std::basic_string_view<Cluster> const clusters,
+                                                        const D2D1_POINT_2F origin,
+                                                        const size_t fontVariant) noexcept;
+        [[nodiscard]] HRESULT _CreateGlyphAtlas() noexcept;
+        [[nodiscard]] HRESULT _DrawGlyphIntoAtlas(const FontVariant& font, const UINT16 glyphIndex, const UINT32 columns, const D2D1_RECT_F slot) noexcept;
+        void _ReleaseGlyphAtlas() noexcept;
+        [[nodiscard]] static bool s_GetGlyphAtlasKey(const Cluster& cluster, _Out_ UINT32& key) noexcept;
 
         [[nodiscard]] HRESULT _CreateTextLayout(
             _In_reads_(StringLength) PCWCHAR String,
             _In_ size_t StringLength,
             _Out_ IDWriteTextLayout** ppTextLayout) noexcept;
 
-        [[nodiscard]] HRESULT _CopyFrontToBack() noexcept;
+        [[nodiscard]] HRESULT _CopyFrontToBack(const bool partial) noexcept;
 
         [[nodiscard]] HRESULT _EnableDisplayAccess(const bool outputEnabled) noexcept;
 
@@ -0,0 +1,207 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "FontFallbackCache.h"
+
+using namespace Microsoft::Console::Render;
+
+// Routine Description:
+// - Gets the cache shared by the whole process
+// Arguments:
+// - <none>
+// Return Value:
+// - The one and only cache
+FontFallbackCache& FontFallbackCache::Instance()
+{
+    static FontFallbackCache instance;
+    return instance;
+}
+
+// Routine Description:
+// - Looks for the font face that fallback picked for a segment of text before
+// Arguments:
+// - segment - The text of the segment, as split up by SegmentLength
+// - font - The font fallback started from
+// - mapping - Filled with the font face and scale fallback picked, if there's one
+// Return Value:
+// - True if fallback was already done for the segment and font.
+[[nodiscard]] bool FontFallbackCache::FindFallback(const std::wstring_view segment, const BaseFont& font, _Out_ Mapping& mapping) const
+{
+    const auto key = _MakeKey(font.familyName, font.localeName, font.weight, font.style, font.stretch, segment);
+
+    std::shared_lock lock{ _lock };
+    const auto found = _fallbacks.find(key);
+    if (found == _fallbacks.end())
+    {
+        mapping = {};
+        return false;
+    }
+
+    mapping = found->second;
+    return true;
+}
+
+// Routine Description:
+// - Remembers the font face that fallback picked for a segment of text
+// Arguments:
+// - segment - The text of the segment, as split up by SegmentLength
+// - font - The font fallback started from
+// - mapping - The font face and scale fallback picked
+// Return Value:
+// - <none>
+void FontFallbackCache::StoreFallback(const std::wstring_view segment, const BaseFont& font, Mapping mapping)
+{
+    auto key = _MakeKey(font.familyName, font.localeName, font.weight, font.style, font.stretch, segment);
+
+    std::unique_lock lock{ _lock };
+    if (_fallbacks.size() >= MaxFallbackEntries)
+    {
+        _fallbacks.clear();
+    }
+    _fallbacks.insert_or_assign(std::move(key), std::move(mapping));
+}
+
+// Routine Description:
+// - Looks for the font face a font family resolved to before
+// Arguments:
+// - familyName - Name of the font family
+// - weight - Weight of the font
+// - stretch - Stretch of the font
+// - style - Style of the font
+// Return Value:
+// - The font face, or null if it isn't in the cache.
+[[nodiscard]] Microsoft::WRL::ComPtr<IDWriteFontFace1> FontFallbackCache::FindFontFace(const std::wstring_view familyName,
+                                                                                       const DWRITE_FONT_WEIGHT weight,
+                                                                                       const DWRITE_FONT_STRETCH stretch,
+                                                                                       const DWRITE_FONT_STYLE style) const
+{
+    const auto key = _MakeKey(familyName, {}, weight, style, stretch, {});
+
+    std::shared_lock lock{ _lock };
+    const auto found = _fontFaces.find(key);
+    return found == _fontFaces.end() ? nullptr : found->second;
+}
+
+// Routine Description:
+// - Remembers the font face a font family resolved to
+// Arguments:
+// - familyName - Name of the font family
+// - weight - Weight of the font
+// - stretch - Stretch of the font
+// - style - Style of the font
+// - fontFace - The font face it resolved to
+// Return Value:
+// - <none>
+void FontFallbackCache::StoreFontFace(const std::wstring_view familyName,
+                                      const DWRITE_FONT_WEIGHT weight,
+                                      const DWRITE_FONT_STRETCH stretch,
+                                      const DWRITE_FONT_STYLE style,
+                                      ::Microsoft::WRL::ComPtr<IDWriteFontFace1> fontFace)
+{
+    auto key = _MakeKey(familyName, {}, weight, style, stretch, {});
+
+    std::unique_lock lock{ _lock };
+    if (_fontFaces.size() >= MaxFontFaceEntries)
+    {
+        _fontFaces.clear();
+    }
+    _fontFaces.insert_or_assign(std::move(key), std::move(fontFace));
+}
+
+// Routine Description:
+// - Finds where the first segment of some text ends. A segment is a codepoint with
+//   whatever combining marks, joiners and selectors that follow it, all of which
+//   have to come from the same font as what they attach to.
+// Arguments:
+// - text - The text to split up
+// Return Value:
+// - The count of UTF-16 code units in the first segment. 0 only if the text is empty.
+[[nodiscard]] size_t FontFallbackCache::SegmentLength(const std::wstring_view text) noexcept
+{
+    size_t length = 0;
+    bool joined = false; // the previous codepoint was a joiner, so the next one is part of the segment
+    while (length < text.size())
+    {
+        UINT32 codepoint = text.at(length);
+        size_t units = 1;
+        if (IS_HIGH_SURROGATE(text.at(length)) && length + 1 < text.size() && IS_LOW_SURROGATE(text.at(length + 1)))
+        {
+            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (text.at(length + 1) - 0xDC00);
+            units = 2;
+        }
+
+        if (length != 0 && !joined && !_JoinsPrevious(codepoint))
+        {
+            break;
+        }
+
+        joined = codepoint == 0x200D; // ZERO WIDTH JOINER
+        length += units;
+    }
+
+    return length;
+}
+
+// Routine Description:
+// - Builds the key that a mapping is stored with
+// Arguments:
+// - familyName - Name of the font family
+// - localeName - Name of the locale (empty for font faces)
+// - weight - Weight of the font
+// - style - Style of the font
+// - stretch - Stretch of the font
+// - segment - The text of the segment (empty for font faces)
+// Return Value:
+// - The key
+[[nodiscard]] std::wstring FontFallbackCache::_MakeKey(const std::wstring_view familyName,
+                                                       const std::wstring_view localeName,
+                                                       const DWRITE_FONT_WEIGHT weight,
+                                                       const DWRITE_FONT_STYLE style,
+                                                       const DWRITE_FONT_STRETCH stretch,
+                                                       const std::wstring_view segment)
+{
+    // None of the names can have a null in them, so it keeps them apart.
+    std::wstring key;
+    key.reserve(familyName.size() + localeName.size() + segment.size() + 5);
+    key.append(familyName);
+    key.push_back(L'\0');
+    key.append(localeName);
+    key.push_back(L'\0');
+    key.push_back(static_cast<wchar_t>(weight));
+    key.push_back(static_cast<wchar_t>(style));
+    key.push_back(static_cast<wchar_t>(stretch));
+    key.append(segment);
+    return key;
+}
+
+// Routine Description:
+// - Checks whether a codepoint attaches to the one before it, so it has to be drawn in the same font
+// Arguments:
+// - codepoint - The codepoint
+// Return Value:
+// - True for combining marks, joiners, variation selectors, emoji modifiers and tags.
+[[nodiscard]] bool FontFallbackCache::_JoinsPrevious(const UINT32 codepoint) noexcept
+{
+    if (codepoint == 0x200C || codepoint == 0x200D || // ZERO WIDTH NON-JOINER and JOINER
+        (codepoint >= 0xFE00 && codepoint <= 0xFE0F) || // VARIATION SELECTOR-1 to 16
+        (codepoint >= 0x1F3FB && codepoint <= 0x1F3FF) || // EMOJI MODIFIER FITZPATRICK TYPE-1-2 to 6
+        (codepoint >= 0xE0020 && codepoint <= 0xE007F) || // TAG SPACE to CANCEL TAG
+        (codepoint >= 0xE0100 && codepoint <= 0xE01EF)) // VARIATION SELECTOR-17 to 256
+    {
+        return true;
+    }
+
+    if (codepoint <= 0xFFFF)
+    {
+        const auto wch = static_cast<wchar_t>(codepoint);
+        WORD type = 0;
+        if (GetStringTypeW(CT_CTYPE3, &wch, 1, &type))
+        {
+            return WI_IsAnyFlagSet(type, C3_NONSPACING | C3_VOWELMARK);
+        }
+    }
+
+    return false;
+}
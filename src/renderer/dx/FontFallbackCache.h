@@ -0,0 +1,75 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace Microsoft::Console::Render
+{
+    // Remembers which font faces font fallback picked for pieces of text, and which faces
+    // font families resolved to, for every engine in the process. Each pane has its own
+    // engine, and without this every one of them would walk the system font collection
+    // and run fallback for the same text all over again.
+    // Fallback is remembered per segment of text: a single codepoint, along with any
+    // combining marks, joiners and selectors that follow it. It's keyed by the segment
+    // and the font that fallback started from (family, locale, weight, style and stretch).
+    // Everything here can be used from any thread.
+    class FontFallbackCache final
+    {
+    public:
+        // What a segment maps to. A null font face means the font fallback started from.
+        struct Mapping
+        {
+            ::Microsoft::WRL::ComPtr<IDWriteFontFace1> fontFace;
+            FLOAT scale;
+        };
+
+        // The font that fallback starts from.
+        struct BaseFont
+        {
+            std::wstring_view familyName;
+            std::wstring_view localeName;
+            DWRITE_FONT_WEIGHT weight;
+            DWRITE_FONT_STYLE style;
+            DWRITE_FONT_STRETCH stretch;
+        };
+
+        static FontFallbackCache& Instance();
+
+        [[nodiscard]] bool FindFallback(const std::wstring_view segment, const BaseFont& font, _Out_ Mapping& mapping) const;
+        void StoreFallback(const std::wstring_view segment, const BaseFont& font, Mapping mapping);
+
+        [[nodiscard]] ::Microsoft::WRL::ComPtr<IDWriteFontFace1> FindFontFace(const std::wstring_view familyName,
+                                                                              const DWRITE_FONT_WEIGHT weight,
+                                                                              const DWRITE_FONT_STRETCH stretch,
+                                                                              const DWRITE_FONT_STYLE style) const;
+        void StoreFontFace(const std::wstring_view familyName,
+                           const DWRITE_FONT_WEIGHT weight,
+                           const DWRITE_FONT_STRETCH stretch,
+                           const DWRITE_FONT_STYLE style,
+                           ::Microsoft::WRL::ComPtr<IDWriteFontFace1> fontFace);
+
+        [[nodiscard]] static size_t SegmentLength(const std::wstring_view text) noexcept;
+
+        // Far more segments than the text on any few screens would have. Beyond that, start over.
+        static constexpr size_t MaxFallbackEntries = 4096;
+        static constexpr size_t MaxFontFaceEntries = 64;
+
+    private:
+        FontFallbackCache() = default;
+
+        mutable std::shared_mutex _lock;
+        std::unordered_map<std::wstring, Mapping> _fallbacks;
+        std::unordered_map<std::wstring, ::Microsoft::WRL::ComPtr<IDWriteFontFace1>> _fontFaces;
+
+        [[nodiscard]] static std::wstring _MakeKey(const std::wstring_view familyName,
+                                                   const std::wstring_view localeName,
+                                                   const DWRITE_FONT_WEIGHT weight,
+                                                   const DWRITE_FONT_STYLE style,
+                                                   const DWRITE_FONT_STRETCH stretch,
+                                                   const std::wstring_view segment);
+        [[nodiscard]] static bool _JoinsPrevious(const UINT32 codepoint) noexcept;
+    };
+}
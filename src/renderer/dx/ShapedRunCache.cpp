@@ -0,0 +1,134 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "ShapedRunCache.h"
+
+using namespace Microsoft::Console::Render;
+
+ShapedRunCache::ShapedRunCache() noexcept :
+    _entries{},
+    _index{},
+    _font{},
+    _fontSize{ 0.0f },
+    _width{ 0 },
+    _key{}
+{
+}
+
+// Routine Description:
+// - Tells the cache which font the lines looked up or stored next are laid out with.
+//   If that's not the font the cache holds lines for, everything in it is thrown out.
+// Arguments:
+// - font - The font face the lines are laid out with (before any fallback)
+// - fontSize - The em size of the font
+// - width - The count of pixels available per column
+// Return Value:
+// - <none>
+void ShapedRunCache::SetFont(IDWriteFontFace1* const font, const float fontSize, const size_t width) noexcept
+{
+    if (_font.Get() != font || _fontSize != fontSize || _width != width)
+    {
+        Clear();
+        _font = font;
+        _fontSize = fontSize;
+        _width = width;
+    }
+}
+
+// Routine Description:
+// - Looks for the shaped form of a line and marks it as the most recently used one.
+// Arguments:
+// - text - The text of the line
+// - columns - The number of columns each cluster of the line takes
+// Return Value:
+// - The shaped line. It's only valid until the next call that changes the cache.
+//   nullptr if the line isn't in the cache.
+[[nodiscard]] const CustomTextLayout::ShapedText* ShapedRunCache::Find(const std::wstring_view text,
+                                                                        const std::basic_string_view<UINT16> columns)
+{
+    _BuildKey(text, columns);
+
+    const auto found = _index.find(_key);
+    if (found == _index.end())
+    {
+        return nullptr;
+    }
+
+    // Moving the entry within the list doesn't move its key, so the index stays valid.
+    _entries.splice(_entries.begin(), _entries, found->second);
+    return &found->second->second;
+}
+
+// Routine Description:
+// - Remembers the shaped form of a line as the most recently used one,
+//   dropping the least recently used line if the cache is full.
+// Arguments:
+// - text - The text of the line
+// - columns - The number of columns each cluster of the line takes
+// - shaped - The results of laying out the line
+// Return Value:
+// - <none>
+void ShapedRunCache::Store(const std::wstring_view text,
+                           const std::basic_string_view<UINT16> columns,
+                           CustomTextLayout::ShapedText shaped)
+{
+    _BuildKey(text, columns);
+
+    const auto found = _index.find(_key);
+    if (found != _index.end())
+    {
+        found->second->second = std::move(shaped);
+        _entries.splice(_entries.begin(), _entries, found->second);
+        return;
+    }
+
+    if (_entries.size() >= MaxEntries)
+    {
+        _index.erase(_entries.back().first);
+        _entries.pop_back();
+    }
+
+    _entries.emplace_front(_key, std::move(shaped));
+    try
+    {
+        _index.emplace(_entries.front().first, _entries.begin());
+    }
+    catch (...)
+    {
+        _entries.pop_front();
+        throw;
+    }
+}
+
+// Routine Description:
+// - Throws out every line in the cache.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void ShapedRunCache::Clear() noexcept
+{
+    _index.clear();
+    _entries.clear();
+}
+
+// Routine Description:
+// - Builds the key a line is stored under: its text, then a null, then the column count of each of its clusters.
+// Arguments:
+// - text - The text of the line
+// - columns - The number of columns each cluster of the line takes
+// Return Value:
+// - <none> - The key is left in _key
+void ShapedRunCache::_BuildKey(const std::wstring_view text, const std::basic_string_view<UINT16> columns)
+{
+    _key.clear();
+    _key.reserve(text.size() + 1 + columns.size());
+    _key.append(text);
+    _key.push_back(UNICODE_NULL);
+    for (const auto cols : columns)
+    {
+        _key.push_back(static_cast<wchar_t>(cols));
+    }
+}
@@ -0,0 +1,52 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+
+#include "CustomTextLayout.h"
+
+namespace Microsoft::Console::Render
+{
+    // Remembers how recently laid out lines of text were shaped, so that a line
+    // that's painted again with the same text doesn't need to go through script
+    // analysis, font fallback and shaping again.
+    // Lines are keyed by their text and the columns of each of their clusters. Everything
+    // stored is only good for a single font at a single size and cell width, so the cache
+    // empties itself when any of those change.
+    class ShapedRunCache final
+    {
+    public:
+        ShapedRunCache() noexcept;
+
+        void SetFont(IDWriteFontFace1* const font, const float fontSize, const size_t width) noexcept;
+
+        [[nodiscard]] const CustomTextLayout::ShapedText* Find(const std::wstring_view text,
+                                                                const std::basic_string_view<UINT16> columns);
+        void Store(const std::wstring_view text,
+                   const std::basic_string_view<UINT16> columns,
+                   CustomTextLayout::ShapedText shaped);
+
+        void Clear() noexcept;
+
+        // A screen's worth of lines a few times over. Beyond that we'd rather shape again.
+        static constexpr size_t MaxEntries = 256;
+
+    private:
+        using Entry = std::pair<std::wstring, CustomTextLayout::ShapedText>;
+
+        // Most recently used lines first. The map points into the list, keyed by the strings the list holds.
+        std::list<Entry> _entries;
+        std::unordered_map<std::wstring_view, std::list<Entry>::iterator> _index;
+
+        ::Microsoft::WRL::ComPtr<IDWriteFontFace1> _font;
+        float _fontSize;
+        size_t _width;
+
+        std::wstring _key; // scratch space for building the key of the line being looked up
+
+        void _BuildKey(const std::wstring_view text, const std::basic_string_view<UINT16> columns);
+    };
+}
@@ -25,6 +25,7 @@ namespace Microsoft::Console::Render
         ~GdiEngine() override;
 
         [[nodiscard]] HRESULT SetHwnd(const HWND hwnd) noexcept;
+        [[nodiscard]] HRESULT ReleaseMemorySurface() noexcept;
 
         [[nodiscard]] HRESULT InvalidateSelection(const std::vector<SMALL_RECT>& rectangles) noexcept override;
         [[nodiscard]] HRESULT InvalidateScroll(const COORD* const pcoordDelta) noexcept override;
@@ -68,6 +69,7 @@ namespace Microsoft::Console::Render
                                               const int iDpi) noexcept override;
 
         SMALL_RECT GetDirtyRectInChars() override;
+        Microsoft::Console::Types::Region GetDirtyArea() override;
         [[nodiscard]] HRESULT GetFontSize(_Out_ COORD* const pFontSize) noexcept override;
         [[nodiscard]] HRESULT IsGlyphWideByFont(const std::wstring_view glyph, _Out_ bool* const pResult) noexcept override;
 
@@ -90,9 +92,20 @@ namespace Microsoft::Console::Render
         HFONT _hfont;
         TEXTMETRICW _tmFontMetrics;
 
-        static const size_t s_cPolyTextCache = 80;
+        static const size_t s_cPolyTextCache = 256;
         POLYTEXTW _pPolyText[s_cPolyTextCache];
         size_t _cPolyText;
+
+        // The text and widths of every line in _pPolyText are packed one after the other into these,
+        // which only ever grow, so that batching lines doesn't allocate once they're big enough.
+        // The lines only point into them once they're flushed, since growing them moves them.
+        std::vector<wchar_t> _polyTextChars;
+        std::vector<int> _polyTextWidths;
+        size_t _cPolyTextChars;
+
+        // Scratch space for converting lines to the codepage of a raster font and back.
+        std::vector<char> _polyTextConvertBytes;
+        std::vector<wchar_t> _polyTextConvertChars;
         [[nodiscard]] HRESULT _FlushBufferLines() noexcept;
 
         std::vector<RECT> cursorInvertRects;
@@ -102,14 +115,23 @@ namespace Microsoft::Console::Render
 
         static const int s_iBaseDpi = USER_DEFAULT_SCREEN_DPI;
 
+        // The memory surface is the part of the bitmap in use, which matches the client area.
+        // The bitmap is made bigger than that, in steps, so that resizing within it doesn't make a new one.
         SIZE _szMemorySurface;
+        SIZE _szMemoryBitmap;
         HBITMAP _hbitmapMemorySurface;
+        static const LONG s_cMemoryBitmapStep = 256;
         [[nodiscard]] HRESULT _PrepareMemoryBitmap(const HWND hwnd) noexcept;
 
         SIZE _szInvalidScroll;
         RECT _rcInvalid;
         bool _fInvalidRectUsed;
 
+        // The separate pixel regions that make up _rcInvalid. When this is empty while
+        // _fInvalidRectUsed is set, only the bounding rectangle is known (e.g. after a scroll).
+        std::vector<RECT> _rgrcInvalid;
+        static const size_t s_cMaxInvalidRects = 16;
+
         COLORREF _lastFg;
         COLORREF _lastBg;
 
@@ -148,16 +148,38 @@ HRESULT GdiEngine::PrepareForTeardown(_Out_ bool* const pForcePaint) noexcept
 // - S_OK, GDI related failure, or safemath failure.
 HRESULT GdiEngine::_InvalidCombine(const RECT* const prc) noexcept
 {
+    // Only keep the regions separately while every one of them so far has been kept.
+    const bool fKeepSeparate = !_fInvalidRectUsed || (!_rgrcInvalid.empty() && _rgrcInvalid.size() < s_cMaxInvalidRects);
+
     if (!_fInvalidRectUsed)
     {
         _rcInvalid = *prc;
         _fInvalidRectUsed = true;
+        _rgrcInvalid.clear();
     }
     else
     {
         _OrRect(&_rcInvalid, prc);
     }
 
+    // Past that, the frame is painted as the single bounding rectangle.
+    try
+    {
+        if (fKeepSeparate)
+        {
+            _rgrcInvalid.push_back(*prc);
+        }
+        else
+        {
+            _rgrcInvalid.clear();
+        }
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        _rgrcInvalid.clear();
+    }
+
     // Ensure invalid areas remain within bounds of window.
     RETURN_IF_FAILED(_InvalidRestrict());
 
@@ -174,16 +196,32 @@ HRESULT GdiEngine::_InvalidOffset(const POINT* const ppt) noexcept
 {
     if (_fInvalidRectUsed)
     {
-        RECT rcInvalidNew;
-
-        RETURN_IF_FAILED(LongAdd(_rcInvalid.left, ppt->x, &rcInvalidNew.left));
-        RETURN_IF_FAILED(LongAdd(_rcInvalid.right, ppt->x, &rcInvalidNew.right));
-        RETURN_IF_FAILED(LongAdd(_rcInvalid.top, ppt->y, &rcInvalidNew.top));
-        RETURN_IF_FAILED(LongAdd(_rcInvalid.bottom, ppt->y, &rcInvalidNew.bottom));
-
         // Add the scrolled invalid rectangle to what was left behind to get the new invalid area.
         // This is the equivalent of adding in the "update rectangle" that we would get out of ScrollWindowEx/ScrollDC.
-        UnionRect(&_rcInvalid, &_rcInvalid, &rcInvalidNew);
+        const auto offset = [&](RECT& rc) -> HRESULT {
+            RECT rcNew;
+
+            RETURN_IF_FAILED(LongAdd(rc.left, ppt->x, &rcNew.left));
+            RETURN_IF_FAILED(LongAdd(rc.right, ppt->x, &rcNew.right));
+            RETURN_IF_FAILED(LongAdd(rc.top, ppt->y, &rcNew.top));
+            RETURN_IF_FAILED(LongAdd(rc.bottom, ppt->y, &rcNew.bottom));
+
+            UnionRect(&rc, &rc, &rcNew);
+            return S_OK;
+        };
+
+        RETURN_IF_FAILED(offset(_rcInvalid));
+
+        // Move the separate regions along with it, so that a scroll doesn't turn the few lines
+        //      that changed into everything between them.
+        for (auto& rc : _rgrcInvalid)
+        {
+            if (FAILED(offset(rc)))
+            {
+                _rgrcInvalid.clear();
+                break;
+            }
+        }
 
         // Ensure invalid areas remain within bounds of window.
         RETURN_IF_FAILED(_InvalidRestrict());
@@ -206,10 +244,15 @@ HRESULT GdiEngine::_InvalidRestrict() noexcept
     // Do restriction only if retrieving the client rect was successful.
     RETURN_HR_IF(E_FAIL, !(GetClientRect(_hwndTargetWindow, &rcClient)));
 
-    _rcInvalid.left = std::clamp(_rcInvalid.left, rcClient.left, rcClient.right);
-    _rcInvalid.right = std::clamp(_rcInvalid.right, rcClient.left, rcClient.right);
-    _rcInvalid.top = std::clamp(_rcInvalid.top, rcClient.top, rcClient.bottom);
-    _rcInvalid.bottom = std::clamp(_rcInvalid.bottom, rcClient.top, rcClient.bottom);
+    const auto restrict = [&](RECT& rc) {
+        rc.left = std::clamp(rc.left, rcClient.left, rcClient.right);
+        rc.right = std::clamp(rc.right, rcClient.left, rcClient.right);
+        rc.top = std::clamp(rc.top, rcClient.top, rcClient.bottom);
+        rc.bottom = std::clamp(rc.bottom, rcClient.top, rcClient.bottom);
+    };
+
+    restrict(_rcInvalid);
+    std::for_each(_rgrcInvalid.begin(), _rgrcInvalid.end(), restrict);
 
     return S_OK;
 }
@@ -26,6 +26,30 @@ SMALL_RECT GdiEngine::GetDirtyRectInChars()
     return sr;
 }
 
+// Routine Description:
+// - Gets the separate character regions making up the current dirty portion of the frame, so that
+//      changes far apart from each other don't have to be painted as the whole area between them.
+// Arguments:
+// - <none>
+// Return Value:
+// - The character region made up of each part of the dirty area.
+Microsoft::Console::Types::Region GdiEngine::GetDirtyArea()
+{
+    if (_rgrcInvalid.empty())
+    {
+        return { Microsoft::Console::Types::Viewport::FromInclusive(GetDirtyRectInChars()) };
+    }
+
+    Microsoft::Console::Types::Region area;
+    for (const auto& rc : _rgrcInvalid)
+    {
+        SMALL_RECT sr = { 0 };
+        LOG_IF_FAILED(_ScaleByFont(&rc, &sr));
+        area.Union(Microsoft::Console::Types::Viewport::FromInclusive(sr));
+    }
+    return area;
+}
+
 // Routine Description:
 // - Uses the currently selected font to determine how wide the given character will be when renderered.
 // - NOTE: Only supports determining half-width/full-width status for CJK-type languages (e.g. is it 1 character wide or 2. a.k.a. is it a rectangle or square.)
@@ -95,19 +95,32 @@ using namespace Microsoft::Console::Render;
     RETURN_IF_FAILED(LongSub(_szMemorySurface.cy, szGutter.cy, &rcScrollLimit.bottom));
 
     // Scroll real window and memory buffer in-sync.
-    LOG_LAST_ERROR_IF(!ScrollWindowEx(_hwndTargetWindow,
-                                      _szInvalidScroll.cx,
-                                      _szInvalidScroll.cy,
-                                      &rcScrollLimit,
-                                      &rcScrollLimit,
-                                      nullptr,
-                                      nullptr,
-                                      0));
+    // The window moves what it already shows by itself, so only the band that's revealed has to be painted
+    //      and copied over in EndPaint. So does anything the window couldn't move, like parts that were covered.
+    RECT rcWindowUpdate = { 0 };
+    if (ERROR == ScrollWindowEx(_hwndTargetWindow,
+                                _szInvalidScroll.cx,
+                                _szInvalidScroll.cy,
+                                &rcScrollLimit,
+                                &rcScrollLimit,
+                                nullptr,
+                                &rcWindowUpdate,
+                                0))
+    {
+        LOG_LAST_ERROR();
+
+        // If the window couldn't be scrolled, all of it has to be copied over instead.
+        rcWindowUpdate = rcScrollLimit;
+    }
 
     RECT rcUpdate = { 0 };
     LOG_HR_IF(E_FAIL, !(ScrollDC(_hdcMemoryContext, _szInvalidScroll.cx, _szInvalidScroll.cy, &rcScrollLimit, &rcScrollLimit, nullptr, &rcUpdate)));
 
     LOG_IF_FAILED(_InvalidCombine(&rcUpdate));
+    if (!IsRectEmpty(&rcWindowUpdate) && !EqualRect(&rcWindowUpdate, &rcUpdate))
+    {
+        LOG_IF_FAILED(_InvalidCombine(&rcWindowUpdate));
+    }
 
     // update invalid rect for the remainder of paint functions
     _psInvalidData.rcPaint = _rcInvalid;
@@ -115,6 +128,33 @@ using namespace Microsoft::Console::Render;
     return S_OK;
 }
 
+// Routine Description:
+// - Trades the in-memory bitmap for a one pixel one, for a window that won't be looked at for a while.
+// - The next frame makes a bitmap the size of the window again, and paints all of it, since
+//   nothing of the old one is kept.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK if the bitmap was released, S_FALSE if there was nothing to release or we're painting, or GDI errors.
+[[nodiscard]] HRESULT GdiEngine::ReleaseMemorySurface() noexcept
+{
+    RETURN_HR_IF(S_FALSE, _fPaintStarted || nullptr == _hbitmapMemorySurface);
+    RETURN_HR_IF(S_FALSE, _szMemoryBitmap.cx <= 1 && _szMemoryBitmap.cy <= 1);
+
+    // The memory DC always has to hold a bitmap of ours, so swap in the smallest there is.
+    wil::unique_hbitmap hbitmapOnePixel(CreateCompatibleBitmap(_hdcMemoryContext, 1, 1));
+    RETURN_HR_IF_NULL(E_FAIL, hbitmapOnePixel.get());
+
+    wil::unique_hbitmap hbitmapOld(SelectBitmap(_hdcMemoryContext, hbitmapOnePixel.get()));
+    RETURN_HR_IF_NULL(E_FAIL, hbitmapOld.get());
+
+    _hbitmapMemorySurface = hbitmapOnePixel.release(); // the DC is holding it now.
+    _szMemoryBitmap = { 1, 1 };
+    _szMemorySurface = { 1, 1 };
+
+    return InvalidateAll();
+}
+
 // Routine Description:
 // - BeginPaint helper to prepare the in-memory bitmap for double-buffering
 // Arguments:
@@ -132,6 +172,24 @@ using namespace Microsoft::Console::Render;
     // Return quickly if they're the same.
     RETURN_HR_IF(S_OK, _szMemorySurface.cx == szClient.cx && _szMemorySurface.cy == szClient.cy);
 
+    // While the client area fits in the bitmap we have, as it does for most steps of dragging the
+    // window's border, just use more or less of it. What's already there stays where it is, and
+    // the window only invalidates the area it newly exposes. A bitmap that's grown far bigger than
+    // the client area (more than four times the pixels) is traded for a smaller one, though.
+    const bool fitsBitmap = szClient.cx <= _szMemoryBitmap.cx && szClient.cy <= _szMemoryBitmap.cy;
+    const bool bitmapOversized = static_cast<LONGLONG>(szClient.cx) * szClient.cy * 4 < static_cast<LONGLONG>(_szMemoryBitmap.cx) * _szMemoryBitmap.cy;
+    if (nullptr != _hbitmapMemorySurface && fitsBitmap && !bitmapOversized)
+    {
+        _szMemorySurface = szClient;
+        return S_OK;
+    }
+
+    // Round the bitmap up to the next step in each dimension, so that growing the window a bit further still fits.
+    const auto roundUp = [](const LONG value) {
+        return std::max(value, 1L) + s_cMemoryBitmapStep - 1 - (std::max(value, 1L) - 1) % s_cMemoryBitmapStep;
+    };
+    SIZE const szBitmap = { roundUp(szClient.cx), roundUp(szClient.cy) };
+
     wil::unique_hdc hdcRealWindow(GetDC(_hwndTargetWindow));
     RETURN_HR_IF_NULL(E_FAIL, hdcRealWindow.get());
 
@@ -143,7 +201,7 @@ using namespace Microsoft::Console::Render;
         RETURN_HR_IF_NULL(E_FAIL, hdcTemp.get());
 
         // Make the new bitmap we'll use going forward with the new size.
-        wil::unique_hbitmap hbitmapNew(CreateCompatibleBitmap(hdcRealWindow.get(), szClient.cx, szClient.cy));
+        wil::unique_hbitmap hbitmapNew(CreateCompatibleBitmap(hdcRealWindow.get(), szBitmap.cx, szBitmap.cy));
         RETURN_HR_IF_NULL(E_FAIL, hbitmapNew.get());
 
         // Select it into the DC, but hold onto the junky one pixel bitmap (made by default) to give back when we need to Delete.
@@ -168,21 +226,23 @@ using namespace Microsoft::Console::Render;
     }
     else
     {
-        _hbitmapMemorySurface = CreateCompatibleBitmap(hdcRealWindow.get(), szClient.cx, szClient.cy);
+        _hbitmapMemorySurface = CreateCompatibleBitmap(hdcRealWindow.get(), szBitmap.cx, szBitmap.cy);
         RETURN_HR_IF_NULL(E_FAIL, _hbitmapMemorySurface);
 
         wil::unique_hbitmap hOldBitmap(SelectBitmap(_hdcMemoryContext, _hbitmapMemorySurface)); // DC has a default junk bitmap, take it and delete it.
         RETURN_HR_IF_NULL(E_FAIL, hOldBitmap.get());
     }
 
-    // Save the new client size.
+    // Save the new client and bitmap sizes.
     _szMemorySurface = szClient;
+    _szMemoryBitmap = szBitmap;
 
     return S_OK;
 }
 
 // Routine Description:
 // - EndPaint helper to perform the final BitBlt copy from the memory bitmap onto the final window bitmap (double-buffering.) Also cleans up structures used while painting.
+// - Only the dirty regions of the frame are copied. If those were merged into one, it's their bounding rectangle.
 // Arguments:
 // - <none>
 // Return Value:
@@ -194,14 +254,31 @@ using namespace Microsoft::Console::Render;
 
     LOG_IF_FAILED(_FlushBufferLines());
 
-    POINT const pt = _GetInvalidRectPoint();
-    SIZE const sz = _GetInvalidRectSize();
+    if (_rgrcInvalid.empty())
+    {
+        POINT const pt = _GetInvalidRectPoint();
+        SIZE const sz = _GetInvalidRectSize();
 
-    LOG_HR_IF(E_FAIL, !(BitBlt(_psInvalidData.hdc, pt.x, pt.y, sz.cx, sz.cy, _hdcMemoryContext, pt.x, pt.y, SRCCOPY)));
+        LOG_HR_IF(E_FAIL, !(BitBlt(_psInvalidData.hdc, pt.x, pt.y, sz.cx, sz.cy, _hdcMemoryContext, pt.x, pt.y, SRCCOPY)));
+    }
+    else
+    {
+        // Only copy the separate regions that changed, rather than the whole area between them.
+        // Every pixel that's copied counts when the window is shown over a remote session.
+        for (const auto& rc : _rgrcInvalid)
+        {
+            SIZE const sz = _GetRectSize(&rc);
+            if (sz.cx > 0 && sz.cy > 0)
+            {
+                LOG_HR_IF(E_FAIL, !(BitBlt(_psInvalidData.hdc, rc.left, rc.top, sz.cx, sz.cy, _hdcMemoryContext, rc.left, rc.top, SRCCOPY)));
+            }
+        }
+    }
     WHEN_DBG(_DebugBltAll());
 
     _rcInvalid = { 0 };
     _fInvalidRectUsed = false;
+    _rgrcInvalid.clear();
     _szInvalidScroll = { 0 };
 
     LOG_HR_IF(E_FAIL, !(GdiFlush()));
@@ -260,7 +337,18 @@ using namespace Microsoft::Console::Render;
 {
     if (_psInvalidData.fErase)
     {
-        RETURN_IF_FAILED(_PaintBackgroundColor(&_psInvalidData.rcPaint));
+        if (_rgrcInvalid.empty())
+        {
+            RETURN_IF_FAILED(_PaintBackgroundColor(&_psInvalidData.rcPaint));
+        }
+        else
+        {
+            // Leave the area between the separate dirty regions as it was in the last frame.
+            for (const auto& rc : _rgrcInvalid)
+            {
+                RETURN_IF_FAILED(_PaintBackgroundColor(&rc));
+            }
+        }
     }
 
     return S_OK;
@@ -300,13 +388,18 @@ using namespace Microsoft::Console::Render;
 
         const auto pPolyTextLine = &_pPolyText[_cPolyText];
 
-        auto pwsPoly = std::make_unique<wchar_t[]>(cchLine);
-        RETURN_IF_NULL_ALLOC(pwsPoly);
+        // Make room for this line after the others in the batch.
+        const size_t offset = _cPolyTextChars;
+        if (_polyTextChars.size() < offset + cchLine)
+        {
+            _polyTextChars.resize(offset + cchLine);
+            _polyTextWidths.resize(offset + cchLine);
+        }
 
-        COORD const coordFontSize = _GetFontSize();
+        const auto pwsPoly = _polyTextChars.data() + offset;
+        const auto rgdxPoly = _polyTextWidths.data() + offset;
 
-        auto rgdxPoly = std::make_unique<int[]>(cchLine);
-        RETURN_IF_NULL_ALLOC(rgdxPoly);
+        COORD const coordFontSize = _GetFontSize();
 
         // Sum up the total widths the entire line/run is expected to take while
         // copying the pixel widths into a structure to direct GDI how many pixels to use per character.
@@ -330,40 +423,50 @@ using namespace Microsoft::Console::Render;
             // dispatch conversion into our codepage
 
             // Find out the bytes required
-            int const cbRequired = WideCharToMultiByte(_fontCodepage, 0, pwsPoly.get(), (int)cchLine, nullptr, 0, nullptr, nullptr);
+            int const cbRequired = WideCharToMultiByte(_fontCodepage, 0, pwsPoly, (int)cchLine, nullptr, 0, nullptr, nullptr);
 
             if (cbRequired != 0)
             {
-                // Allocate buffer for MultiByte
-                auto psConverted = std::make_unique<char[]>(cbRequired);
+                // Make sure the scratch buffer for MultiByte is big enough
+                if (_polyTextConvertBytes.size() < gsl::narrow_cast<size_t>(cbRequired))
+                {
+                    _polyTextConvertBytes.resize(cbRequired);
+                }
+                const auto psConverted = _polyTextConvertBytes.data();
 
                 // Attempt conversion to current codepage
-                int const cbConverted = WideCharToMultiByte(_fontCodepage, 0, pwsPoly.get(), (int)cchLine, psConverted.get(), cbRequired, nullptr, nullptr);
+                int const cbConverted = WideCharToMultiByte(_fontCodepage, 0, pwsPoly, (int)cchLine, psConverted, cbRequired, nullptr, nullptr);
 
                 // If successful...
                 if (cbConverted != 0)
                 {
                     // Now we have to convert back to Unicode but using the system ANSI codepage. Find buffer size first.
-                    int const cchRequired = MultiByteToWideChar(CP_ACP, 0, psConverted.get(), cbRequired, nullptr, 0);
+                    int const cchRequired = MultiByteToWideChar(CP_ACP, 0, psConverted, cbRequired, nullptr, 0);
 
                     if (cchRequired != 0)
                     {
-                        auto pwsConvert = std::make_unique<wchar_t[]>(cchRequired);
+                        if (_polyTextConvertChars.size() < gsl::narrow_cast<size_t>(cchRequired))
+                        {
+                            _polyTextConvertChars.resize(cchRequired);
+                        }
+                        const auto pwsConvert = _polyTextConvertChars.data();
 
                         // Then do the actual conversion.
-                        int const cchConverted = MultiByteToWideChar(CP_ACP, 0, psConverted.get(), cbRequired, pwsConvert.get(), cchRequired);
+                        int const cchConverted = MultiByteToWideChar(CP_ACP, 0, psConverted, cbRequired, pwsConvert, cchRequired);
 
                         if (cchConverted != 0)
                         {
-                            // If all successful, use this instead.
-                            pwsPoly.swap(pwsConvert);
+                            // If all successful, use this instead. The line keeps the one
+                            // character per cell that its widths were measured for.
+                            std::copy_n(pwsConvert, std::min(gsl::narrow_cast<size_t>(cchConverted), cchLine), pwsPoly);
                         }
                     }
                 }
             }
         }
 
-        pPolyTextLine->lpstr = pwsPoly.release();
+        // The text and widths are pointed at when the batch is flushed.
+        pPolyTextLine->lpstr = nullptr;
         pPolyTextLine->n = gsl::narrow<UINT>(clusters.size());
         pPolyTextLine->x = ptDraw.x;
         pPolyTextLine->y = ptDraw.y;
@@ -372,7 +475,7 @@ using namespace Microsoft::Console::Render;
         pPolyTextLine->rcl.top = pPolyTextLine->y;
         pPolyTextLine->rcl.right = pPolyTextLine->rcl.left + ((SHORT)cchCharWidths * coordFontSize.X);
         pPolyTextLine->rcl.bottom = pPolyTextLine->rcl.top + coordFontSize.Y;
-        pPolyTextLine->pdx = rgdxPoly.release();
+        pPolyTextLine->pdx = nullptr;
 
         if (trimLeft)
         {
@@ -380,6 +483,7 @@ using namespace Microsoft::Console::Render;
         }
 
         _cPolyText++;
+        _cPolyTextChars += cchLine;
 
         if (_cPolyText >= s_cPolyTextCache)
         {
@@ -392,7 +496,7 @@ using namespace Microsoft::Console::Render;
 }
 
 // Routine Description:
-// - Flushes any buffer lines in the PolyTextOut cache by drawing them and freeing the strings.
+// - Flushes any buffer lines in the PolyTextOut cache by drawing them.
 // - See also: PaintBufferLine
 // Arguments:
 // - <none>
@@ -404,27 +508,22 @@ using namespace Microsoft::Console::Render;
 
     if (_cPolyText > 0)
     {
-        if (!PolyTextOutW(_hdcMemoryContext, _pPolyText, (UINT)_cPolyText))
+        // Now that the buffers are done growing for this batch, point each line at its part of them.
+        size_t offset = 0;
+        for (size_t iPoly = 0; iPoly < _cPolyText; iPoly++)
         {
-            hr = E_FAIL;
+            _pPolyText[iPoly].lpstr = _polyTextChars.data() + offset;
+            _pPolyText[iPoly].pdx = _polyTextWidths.data() + offset;
+            offset += _pPolyText[iPoly].n;
         }
 
-        for (size_t iPoly = 0; iPoly < _cPolyText; iPoly++)
+        if (!PolyTextOutW(_hdcMemoryContext, _pPolyText, (UINT)_cPolyText))
         {
-            if (nullptr != _pPolyText[iPoly].lpstr)
-            {
-                delete[] _pPolyText[iPoly].lpstr;
-                _pPolyText[iPoly].lpstr = nullptr;
-            }
-
-            if (nullptr != _pPolyText[iPoly].pdx)
-            {
-                delete[] _pPolyText[iPoly].pdx;
-                _pPolyText[iPoly].pdx = nullptr;
-            }
+            hr = E_FAIL;
         }
 
         _cPolyText = 0;
+        _cPolyTextChars = 0;
     }
 
     RETURN_HR(hr);
@@ -26,6 +26,11 @@ GdiEngine::GdiEngine() :
     _iCurrentDpi(s_iBaseDpi),
     _hbitmapMemorySurface(nullptr),
     _cPolyText(0),
+    _polyTextChars(),
+    _polyTextWidths(),
+    _cPolyTextChars(0),
+    _polyTextConvertBytes(),
+    _polyTextConvertChars(),
     _fInvalidRectUsed(false),
     _lastFg(INVALID_COLOR),
     _lastBg(INVALID_COLOR),
@@ -34,8 +39,10 @@ GdiEngine::GdiEngine() :
 {
     ZeroMemory(_pPolyText, sizeof(POLYTEXTW) * s_cPolyTextCache);
     _rcInvalid = { 0 };
+    _rgrcInvalid.reserve(s_cMaxInvalidRects);
     _szInvalidScroll = { 0 };
     _szMemorySurface = { 0 };
+    _szMemoryBitmap = { 0 };
 
     _hdcMemoryContext = CreateCompatibleDC(nullptr);
     THROW_HR_IF_NULL(E_FAIL, _hdcMemoryContext);
@@ -68,14 +75,6 @@ GdiEngine::GdiEngine() :
 // - <none>
 GdiEngine::~GdiEngine()
 {
-    for (size_t iPoly = 0; iPoly < _cPolyText; iPoly++)
-    {
-        if (_pPolyText[iPoly].lpstr != nullptr)
-        {
-            delete[] _pPolyText[iPoly].lpstr;
-        }
-    }
-
     if (_hbitmapMemorySurface != nullptr)
     {
         LOG_HR_IF(E_FAIL, !(DeleteObject(_hbitmapMemorySurface)));
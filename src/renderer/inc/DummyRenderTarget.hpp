@@ -29,6 +29,9 @@ public:
     void TriggerSelection() override {}
     void TriggerScroll() override {}
     void TriggerScroll(const COORD* const /*pcoordDelta*/) override {}
+    void TriggerScrollRows(const Microsoft::Console::Types::Viewport& /*rows*/, const SHORT /*delta*/) override {}
     void TriggerCircling() override {}
     void TriggerTitleChange() override {}
+    void BeginSynchronizedUpdate() override {}
+    void EndSynchronizedUpdate() override {}
 };
@@ -17,6 +17,7 @@ Author(s):
 #include "../../inc/conattrs.hpp"
 #include "Cluster.hpp"
 #include "FontInfoDesired.hpp"
+#include "../../types/inc/Viewport.hpp"
 
 namespace Microsoft::Console::Render
 {
@@ -77,8 +78,10 @@ namespace Microsoft::Console::Render
         [[nodiscard]] virtual HRESULT InvalidateSystem(const RECT* const prcDirtyClient) noexcept = 0;
         [[nodiscard]] virtual HRESULT InvalidateSelection(const std::vector<SMALL_RECT>& rectangles) noexcept = 0;
         [[nodiscard]] virtual HRESULT InvalidateScroll(const COORD* const pcoordDelta) noexcept = 0;
+        [[nodiscard]] virtual HRESULT InvalidateScrollRows(const SMALL_RECT* const psrRows, const SHORT delta) noexcept = 0;
         [[nodiscard]] virtual HRESULT InvalidateAll() noexcept = 0;
         [[nodiscard]] virtual HRESULT InvalidateCircling(_Out_ bool* const pForcePaint) noexcept = 0;
+        [[nodiscard]] virtual HRESULT InvalidateOffscreen(const SMALL_RECT* const psrRegion) noexcept = 0;
 
         [[nodiscard]] virtual HRESULT InvalidateTitle(const std::wstring& proposedTitle) noexcept = 0;
 
@@ -109,6 +112,8 @@ namespace Microsoft::Console::Render
                                                       const int iDpi) noexcept = 0;
 
         virtual SMALL_RECT GetDirtyRectInChars() = 0;
+        virtual Microsoft::Console::Types::Region GetDirtyArea() = 0;
+        virtual void WaitUntilCanRender() noexcept = 0;
         [[nodiscard]] virtual HRESULT GetFontSize(_Out_ COORD* const pFontSize) noexcept = 0;
         [[nodiscard]] virtual HRESULT IsGlyphWideByFont(const std::wstring_view glyph, _Out_ bool* const pResult) noexcept = 0;
         [[nodiscard]] virtual HRESULT UpdateTitle(const std::wstring& newTitle) noexcept = 0;
@@ -35,8 +35,12 @@ namespace Microsoft::Console::Render
         virtual void TriggerSelection() = 0;
         virtual void TriggerScroll() = 0;
         virtual void TriggerScroll(const COORD* const pcoordDelta) = 0;
+        virtual void TriggerScrollRows(const Microsoft::Console::Types::Viewport& rows, const SHORT delta) = 0;
         virtual void TriggerCircling() = 0;
         virtual void TriggerTitleChange() = 0;
+
+        virtual void BeginSynchronizedUpdate() = 0;
+        virtual void EndSynchronizedUpdate() = 0;
     };
 
     inline Microsoft::Console::Render::IRenderTarget::~IRenderTarget() {}
@@ -22,6 +22,8 @@ namespace Microsoft::Console::Render
         virtual void NotifyPaint() = 0;
         virtual void EnablePainting() = 0;
         virtual void WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs) = 0;
+        virtual void BeginSynchronizedUpdate() = 0;
+        virtual void EndSynchronizedUpdate() = 0;
     };
 
     inline Microsoft::Console::Render::IRenderThread::~IRenderThread(){};
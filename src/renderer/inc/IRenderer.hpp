@@ -27,6 +27,7 @@ namespace Microsoft::Console::Render
         virtual ~IRenderer() = 0;
 
         [[nodiscard]] virtual HRESULT PaintFrame() = 0;
+        [[nodiscard]] virtual HRESULT PaintFrame(_In_ IRenderEngine* const pEngine) = 0;
 
         virtual void TriggerSystemRedraw(const RECT* const prcDirtyClient) = 0;
 
@@ -40,6 +41,7 @@ namespace Microsoft::Console::Render
         virtual void TriggerSelection() = 0;
         virtual void TriggerScroll() = 0;
         virtual void TriggerScroll(const COORD* const pcoordDelta) = 0;
+        virtual void TriggerScrollRows(const Microsoft::Console::Types::Viewport& rows, const SHORT delta) = 0;
         virtual void TriggerCircling() = 0;
         virtual void TriggerTitleChange() = 0;
         virtual void TriggerFontChange(const int iDpi,
@@ -56,6 +58,7 @@ namespace Microsoft::Console::Render
         virtual void WaitForPaintCompletionAndDisable(const DWORD dwTimeoutMs) = 0;
 
         virtual void AddRenderEngine(_In_ IRenderEngine* const pEngine) = 0;
+        virtual void AddRenderEngineOnOwnThread(_In_ IRenderEngine* const pEngine) = 0;
     };
 
     inline Microsoft::Console::Render::IRenderer::~IRenderer() {}
@@ -29,8 +29,16 @@ namespace Microsoft::Console::Render
 
         [[nodiscard]] HRESULT InvalidateTitle(const std::wstring& proposedTitle) noexcept override;
 
+        [[nodiscard]] HRESULT InvalidateOffscreen(const SMALL_RECT* const psrRegion) noexcept override;
+
+        [[nodiscard]] HRESULT InvalidateScrollRows(const SMALL_RECT* const psrRows, const SHORT delta) noexcept override;
+
         [[nodiscard]] HRESULT UpdateTitle(const std::wstring& newTitle) noexcept override;
 
+        Microsoft::Console::Types::Region GetDirtyArea() override;
+
+        void WaitUntilCanRender() noexcept override;
+
     protected:
         [[nodiscard]] virtual HRESULT _DoUpdateTitle(const std::wstring& newTitle) noexcept = 0;
 
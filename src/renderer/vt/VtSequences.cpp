@@ -81,9 +81,7 @@ using namespace Microsoft::Console::Render;
 // - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
 [[nodiscard]] HRESULT VtEngine::_EraseCharacter(const short chars) noexcept
 {
-    static const std::string format = "\x1b[%dX";
-
-    return _WriteFormattedString(&format, chars);
+    return _WriteCsi({ chars }, 'X');
 }
 
 // Method Description:
@@ -94,9 +92,7 @@ using namespace Microsoft::Console::Render;
 // - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
 [[nodiscard]] HRESULT VtEngine::_CursorForward(const short chars) noexcept
 {
-    static const std::string format = "\x1b[%dC";
-
-    return _WriteFormattedString(&format, chars);
+    return _WriteCsi({ chars }, 'C');
 }
 
 // Method Description:
@@ -129,9 +125,7 @@ using namespace Microsoft::Console::Render;
     {
         return _Write(fInsertLine ? "\x1b[L" : "\x1b[M");
     }
-    const std::string format = fInsertLine ? "\x1b[%dL" : "\x1b[%dM";
-
-    return _WriteFormattedString(&format, sLines);
+    return _WriteCsi({ sLines }, fInsertLine ? 'L' : 'M');
 }
 
 // Method Description:
@@ -168,14 +162,12 @@ using namespace Microsoft::Console::Render;
 // - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
 [[nodiscard]] HRESULT VtEngine::_CursorPosition(const COORD coord) noexcept
 {
-    static const std::string cursorFormat = "\x1b[%d;%dH";
-
     // VT coords start at 1,1
     COORD coordVt = coord;
     coordVt.X++;
     coordVt.Y++;
 
-    return _WriteFormattedString(&cursorFormat, coordVt.Y, coordVt.X);
+    return _WriteCsi({ coordVt.Y, coordVt.X }, 'H');
 }
 
 // Method Description:
@@ -222,8 +214,19 @@ using namespace Microsoft::Console::Render;
 [[nodiscard]] HRESULT VtEngine::_SetGraphicsRendition16Color(const WORD wAttr,
                                                              const bool fIsForeground) noexcept
 {
-    static const std::string fmt = "\x1b[%dm";
+    return _WriteCsi({ _16ColorRenditionParameter(wAttr, fIsForeground) }, 'm');
+}
 
+// Method Description:
+// - Gets the SGR parameter that selects one of the 16 table colors.
+// Arguments:
+// - wAttr: Windows color table index to get the VT parameter for
+// - fIsForeground: true for the foreground parameter, false for background
+// Return Value:
+// - the SGR parameter
+int VtEngine::_16ColorRenditionParameter(const WORD wAttr,
+                                         const bool fIsForeground) noexcept
+{
     // Always check using the foreground flags, because the bg flags constants
     //  are a higher byte
     // Foreground sequences are in [30,37] U [90,97]
@@ -243,7 +246,7 @@ using namespace Microsoft::Console::Render;
                         (WI_IsFlagSet(wAttr, FOREGROUND_GREEN) ? 2 : 0) +
                         (WI_IsFlagSet(wAttr, FOREGROUND_BLUE) ? 4 : 0);
 
-    return _WriteFormattedString(&fmt, vtIndex);
+    return vtIndex;
 }
 
 // Method Description:
@@ -257,15 +260,11 @@ using namespace Microsoft::Console::Render;
 [[nodiscard]] HRESULT VtEngine::_SetGraphicsRenditionRGBColor(const COLORREF color,
                                                               const bool fIsForeground) noexcept
 {
-    const std::string fmt = fIsForeground ?
-                                "\x1b[38;2;%d;%d;%dm" :
-                                "\x1b[48;2;%d;%d;%dm";
-
-    DWORD const r = GetRValue(color);
-    DWORD const g = GetGValue(color);
-    DWORD const b = GetBValue(color);
+    const int r = GetRValue(color);
+    const int g = GetGValue(color);
+    const int b = GetBValue(color);
 
-    return _WriteFormattedString(&fmt, r, g, b);
+    return _WriteCsi({ fIsForeground ? 38 : 48, 2, r, g, b }, 'm');
 }
 
 // Method Description:
@@ -291,13 +290,12 @@ using namespace Microsoft::Console::Render;
 // - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
 [[nodiscard]] HRESULT VtEngine::_ResizeWindow(const short sWidth, const short sHeight) noexcept
 {
-    static const std::string resizeFormat = "\x1b[8;%d;%dt";
     if (sWidth < 0 || sHeight < 0)
     {
         return E_INVALIDARG;
     }
 
-    return _WriteFormattedString(&resizeFormat, sHeight, sWidth);
+    return _WriteCsi({ 8, sHeight, sWidth }, 't');
 }
 
 // Method Description:
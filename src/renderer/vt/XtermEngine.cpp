@@ -21,7 +21,11 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
     _fUseAsciiOnly(fUseAsciiOnly),
     _previousLineWrapped(false),
     _usingUnderLine(false),
-    _needToDisableCursor(false)
+    _needToDisableCursor(false),
+    _sentCells{},
+    _sentSize{ 0 },
+    _scrollRows{ 0 },
+    _scrollRowsDelta{ 0 }
 {
     // Set out initial cursor position to -1, -1. This will force our initial
     //      paint to manually move the cursor to 0, 0, not just ignore it.
@@ -52,6 +56,7 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
         //      the screen on the first paint, just to make sure that the
         //      terminal's state is consistent with what we'll be rendering.
         RETURN_IF_FAILED(_ClearScreen());
+        _ForgetSentCells();
         _clearedAllThisFrame = true;
         _firstPaint = false;
     }
@@ -66,6 +71,7 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
             // Unfortunately, not always setting _resized is not a good enough
             // solution, see that work item for a description why.
             RETURN_IF_FAILED(_ClearScreen());
+            _ForgetSentCells();
             _clearedAllThisFrame = true;
         }
     }
@@ -115,6 +121,12 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
         RETURN_IF_FAILED(_ShowCursor());
     }
 
+    // Once the buffer has circled, its rows no longer line up with what we sent.
+    if (_circled)
+    {
+        _ForgetSentCells();
+    }
+
     RETURN_IF_FAILED(VtEngine::EndPaint());
 
     _needToDisableCursor = false;
@@ -275,8 +287,13 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
     if (_scrollDelta.X != 0)
     {
         // No easy way to shift left-right. Everything needs repainting.
+        // (InvalidateAll also forgets what we sent.)
         return InvalidateAll();
     }
+    if (_scrollRowsDelta != 0)
+    {
+        RETURN_IF_FAILED(_ScrollRows());
+    }
     if (_scrollDelta.Y == 0)
     {
         // There's nothing to do here. Do nothing.
@@ -317,6 +334,16 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
         }
     }
 
+    // The terminal moved what we sent along with the text. If we don't know how far it got, forget it all.
+    if (SUCCEEDED(hr))
+    {
+        _ScrollSentCells(0, _sentSize.Y, dy);
+    }
+    else
+    {
+        _ForgetSentCells();
+    }
+
     return hr;
 }
 
@@ -336,6 +363,14 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
 
     if (dx != 0 || dy != 0)
     {
+        // A band that was going to be shifted in the terminal has to be repainted
+        //      instead, since it'll be scrolled along with everything else.
+        if (_scrollRowsDelta != 0)
+        {
+            _scrollRowsDelta = 0;
+            RETURN_IF_FAILED(_InvalidCombine(Viewport::FromExclusive(_scrollRows)));
+        }
+
         // Scroll the current offset
         RETURN_IF_FAILED(_InvalidOffset(pcoordDelta));
 
@@ -363,6 +398,121 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
     return S_OK;
 }
 
+// Routine Description:
+// - Notifies us that the entire viewport needs repainting. Everything gets
+//      sent again, rather than only what differs from what we sent last, in
+//      case what the terminal shows has gone out of step with it.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK, else an appropriate HRESULT for failing to allocate or write.
+[[nodiscard]] HRESULT XtermEngine::InvalidateAll() noexcept
+{
+    _ForgetSentCells();
+    _scrollRowsDelta = 0;
+    return VtEngine::InvalidateAll();
+}
+
+// Routine Description:
+// - Notifies us that the contents of a band of rows moved within it. If it's
+//      the only band that moved this frame, it'll be shifted in the terminal by
+//      scrolling within the margins, and only the rows it uncovers are painted.
+//      Otherwise, it's repainted.
+// Arguments:
+// - psrRows - The rows that moved, relative to the viewport, exclusive.
+// - delta - How far the contents moved down. Negative for up.
+// Return Value:
+// - S_OK, else an appropriate HRESULT for failing to allocate or safemath failure
+[[nodiscard]] HRESULT XtermEngine::InvalidateScrollRows(const SMALL_RECT* const psrRows, const SHORT delta) noexcept
+{
+    const Viewport rows = Viewport::FromExclusive(*psrRows);
+    const bool sameRows = _scrollRowsDelta == 0 ||
+                          (_scrollRows.Top == psrRows->Top && _scrollRows.Bottom == psrRows->Bottom);
+    const bool scrolling = _scrollDelta.X != 0 || _scrollDelta.Y != 0;
+    const auto totalDelta = _scrollRowsDelta + delta;
+    if (delta == 0 || scrolling || !sameRows || abs(totalDelta) >= rows.Height())
+    {
+        return Invalidate(psrRows);
+    }
+
+    // Whatever was already going to be painted in the band moves along with it.
+    if (_fInvalidRectUsed)
+    {
+        SMALL_RECT moved = _invalidRect.ToExclusive();
+        moved.Top = std::max(moved.Top, psrRows->Top);
+        moved.Bottom = std::min(moved.Bottom, psrRows->Bottom);
+        if (moved.Top < moved.Bottom)
+        {
+            moved.Top = std::clamp(gsl::narrow_cast<SHORT>(moved.Top + delta), psrRows->Top, psrRows->Bottom);
+            moved.Bottom = std::clamp(gsl::narrow_cast<SHORT>(moved.Bottom + delta), psrRows->Top, psrRows->Bottom);
+            if (moved.Top < moved.Bottom)
+            {
+                RETURN_IF_FAILED(_InvalidCombine(Viewport::FromExclusive(moved)));
+            }
+        }
+    }
+
+    // The rows the shift uncovers have new contents.
+    SMALL_RECT uncovered = *psrRows;
+    if (delta < 0)
+    {
+        uncovered.Top = psrRows->Bottom + delta;
+    }
+    else
+    {
+        uncovered.Bottom = psrRows->Top + delta;
+    }
+    RETURN_IF_FAILED(_InvalidCombine(Viewport::FromExclusive(uncovered)));
+
+    _scrollRows = *psrRows;
+    _scrollRowsDelta = gsl::narrow_cast<SHORT>(totalDelta);
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Returns true if the next frame has to scroll what the terminal shows,
+//      including a band of rows within the viewport.
+// Arguments:
+// - <none>
+// Return Value:
+// - true if there's a scroll or a circling of the buffer to paint.
+bool XtermEngine::_IsScrollPending() const noexcept
+{
+    return VtEngine::_IsScrollPending() || _scrollRowsDelta != 0;
+}
+
+// Routine Description:
+// - Shifts the band of rows that moved this frame in the terminal, by setting
+//      the margins to it, scrolling them, and resetting the margins afterwards.
+//      Resetting the margins moves the cursor home.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK if we succeeded, else an appropriate HRESULT for failing to allocate or write.
+[[nodiscard]] HRESULT XtermEngine::_ScrollRows() noexcept
+{
+    const short dy = _scrollRowsDelta;
+    const short top = _scrollRows.Top;
+    const short bottom = _scrollRows.Bottom;
+    _scrollRowsDelta = 0;
+
+    // If we don't know how much of it got to the terminal, forget what we sent.
+    auto forgetOnFailure = wil::scope_exit([&]() {
+        _ForgetSentCells();
+    });
+
+    RETURN_IF_FAILED(_WriteCsi({ top + 1, bottom }, 'r'));
+    RETURN_IF_FAILED(_WriteCsi({ abs(dy) }, dy < 0 ? 'S' : 'T'));
+    RETURN_IF_FAILED(_Write("\x1b[r"));
+    _lastText = { 0, 0 };
+
+    forgetOnFailure.release();
+    _ScrollSentCells(top, bottom, dy);
+
+    return S_OK;
+}
+
 // Routine Description:
 // - Draws one line of the buffer to the screen. Writes the characters to the
 //      pipe, encoded in UTF-8 or ASCII only, depending on the VtIoMode.
@@ -381,7 +531,225 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
 {
     return _fUseAsciiOnly ?
                VtEngine::_PaintAsciiBufferLine(clusters, coord) :
-               VtEngine::_PaintUtf8BufferLine(clusters, coord);
+               _PaintChangedCells(clusters, coord);
+}
+
+// Routine Description:
+// - Draws one line of the buffer to the screen, encoded in UTF-8, but only sends
+//      the parts of it that differ from what we last sent the terminal for those
+//      cells. Unchanged cells at either end of the run are left out, and so are
+//      unchanged stretches in the middle that take more to send than moving the
+//      cursor over them does.
+// Arguments:
+// - clusters - text and column widths to be written
+// - coord - character coordinate target to render within viewport
+// Return Value:
+// - S_OK or suitable HRESULT error from writing pipe.
+[[nodiscard]] HRESULT XtermEngine::_PaintChangedCells(std::basic_string_view<Cluster> const clusters,
+                                                      const COORD coord) noexcept
+{
+    // Rows above the virtual top aren't painted at all. See _PaintUtf8BufferLine.
+    if (coord.Y < _virtualTop)
+    {
+        return S_OK;
+    }
+
+    try
+    {
+        const auto size = _lastViewport.Dimensions();
+        if (_sentSize.X != size.X || _sentSize.Y != size.Y)
+        {
+            _sentCells.assign(static_cast<size_t>(size.X) * size.Y, SentCell{});
+            _sentSize = size;
+        }
+    }
+    CATCH_RETURN();
+
+    if (coord.X < 0 || coord.Y < 0 || coord.Y >= _sentSize.Y)
+    {
+        return VtEngine::_PaintUtf8BufferLine(clusters, coord);
+    }
+
+    // If anything goes wrong, we can't say what the terminal shows for this row.
+    auto forgetOnFailure = wil::scope_exit([&]() {
+        _ForgetSentCells();
+    });
+
+    // Walk the run, sending each stretch of changed clusters once we know where it ends.
+    constexpr size_t none = std::numeric_limits<size_t>::max();
+    size_t changedStart = none;
+    COORD changedCoord = coord;
+    size_t unchangedStart = none;
+    size_t unchangedChars = 0;
+    short unchangedColumns = 0;
+
+    short column = coord.X;
+    for (size_t i = 0; i < clusters.size(); i++)
+    {
+        const auto& cluster = clusters.at(i);
+        if (!_WasCellSent(cluster, column, coord.Y))
+        {
+            if (changedStart == none)
+            {
+                changedStart = i;
+                changedCoord.X = column;
+            }
+            else if (unchangedStart != none)
+            {
+                // Skipping the unchanged clusters costs a CUF: ESC [ <columns> C. Each
+                //      of them takes at least one byte to send, so past that it's cheaper.
+                size_t moveLength = 3;
+                for (auto n = unchangedColumns; n >= 10; n /= 10)
+                {
+                    moveLength++;
+                }
+
+                if (unchangedChars > moveLength)
+                {
+                    RETURN_IF_FAILED(VtEngine::_PaintUtf8BufferLine(clusters.substr(changedStart, unchangedStart - changedStart), changedCoord));
+                    changedStart = i;
+                    changedCoord.X = column;
+                }
+            }
+
+            unchangedStart = none;
+            unchangedChars = 0;
+            unchangedColumns = 0;
+        }
+        else if (changedStart != none)
+        {
+            if (unchangedStart == none)
+            {
+                unchangedStart = i;
+            }
+            unchangedChars += cluster.GetText().size();
+            unchangedColumns += gsl::narrow_cast<short>(cluster.GetColumns());
+        }
+
+        column += gsl::narrow_cast<short>(cluster.GetColumns());
+    }
+
+    // Unchanged clusters at the end of the run are never sent.
+    if (changedStart != none)
+    {
+        const size_t changedEnd = unchangedStart != none ? unchangedStart : clusters.size();
+        RETURN_IF_FAILED(VtEngine::_PaintUtf8BufferLine(clusters.substr(changedStart, changedEnd - changedStart), changedCoord));
+    }
+
+    forgetOnFailure.release();
+    _RecordSentCells(clusters, coord);
+
+    return S_OK;
+}
+
+// Routine Description:
+// - Checks whether the terminal already shows a cluster, in the current colors,
+//      at the given position.
+// Arguments:
+// - cluster - the text and width of the cluster
+// - column - the column the cluster starts in
+// - row - the row of the viewport the cluster is in
+// Return Value:
+// - true if we sent the same cluster there, the same way, and nothing has changed it since.
+bool XtermEngine::_WasCellSent(const Cluster& cluster, const short column, const short row) const noexcept
+{
+    const auto text = cluster.GetText();
+    const auto columns = cluster.GetColumns();
+    if (text.empty() || text.size() > ARRAYSIZE(SentCell::text) || columns == 0 || column + columns > _sentSize.X)
+    {
+        return false;
+    }
+
+    const auto& cell = _sentCells.at(static_cast<size_t>(row) * _sentSize.X + column);
+    return cell.length == text.size() &&
+           std::equal(text.begin(), text.end(), cell.text) &&
+           cell.columns == columns &&
+           cell.foreground == _LastFG &&
+           cell.background == _LastBG &&
+           cell.bold == _lastWasBold &&
+           cell.underlined == _usingUnderLine;
+}
+
+// Routine Description:
+// - Remembers that the terminal shows a run of clusters, in the current colors.
+// Arguments:
+// - clusters - the text and widths of the clusters that were painted
+// - coord - where the run starts
+// Return Value:
+// - <none>
+void XtermEngine::_RecordSentCells(std::basic_string_view<Cluster> const clusters, const COORD coord) noexcept
+{
+    const auto rowStart = static_cast<size_t>(coord.Y) * _sentSize.X;
+
+    short column = coord.X;
+    for (const auto& cluster : clusters)
+    {
+        const auto text = cluster.GetText();
+        const auto columns = gsl::narrow_cast<short>(cluster.GetColumns());
+
+        for (short i = 0; i < columns && column + i < _sentSize.X; i++)
+        {
+            auto& cell = _sentCells.at(rowStart + column + i);
+            cell = {};
+            cell.foreground = _LastFG;
+            cell.background = _LastBG;
+            cell.bold = _lastWasBold;
+            cell.underlined = _usingUnderLine;
+
+            // Text we can't keep is left unknown, so that it's always sent.
+            if (text.size() <= ARRAYSIZE(cell.text))
+            {
+                std::copy(text.begin(), text.end(), cell.text);
+                cell.length = gsl::narrow_cast<BYTE>(text.size());
+                cell.columns = i == 0 ? gsl::narrow_cast<BYTE>(columns) : 0;
+            }
+        }
+
+        column += columns;
+    }
+}
+
+// Routine Description:
+// - Moves what we remember sending along with a scroll of the terminal. The
+//      rows that scroll into view are new, so we don't know what they show.
+// Arguments:
+// - top - the first row that moved
+// - bottom - the row after the last one that moved
+// - dy - how far the rows' contents moved down. Negative for up.
+// Return Value:
+// - <none>
+void XtermEngine::_ScrollSentCells(const short top, const short bottom, const short dy) noexcept
+{
+    if (_sentCells.empty() || top < 0 || bottom > _sentSize.Y || top >= bottom)
+    {
+        return;
+    }
+
+    const auto rowSize = static_cast<ptrdiff_t>(_sentSize.X);
+    const auto rows = static_cast<ptrdiff_t>(std::min<short>(static_cast<short>(abs(dy)), bottom - top));
+    const auto first = _sentCells.begin() + top * rowSize;
+    const auto last = _sentCells.begin() + bottom * rowSize;
+    if (dy < 0)
+    {
+        std::move(first + rows * rowSize, last, first);
+        std::fill(last - rows * rowSize, last, SentCell{});
+    }
+    else
+    {
+        std::move_backward(first, last - rows * rowSize, last);
+        std::fill(first, first + rows * rowSize, SentCell{});
+    }
+}
+
+// Routine Description:
+// - Forgets everything we remember sending, so that everything gets sent again.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void XtermEngine::_ForgetSentCells() noexcept
+{
+    std::fill(_sentCells.begin(), _sentCells.end(), SentCell{});
 }
 
 // Method Description:
@@ -393,6 +761,9 @@ XtermEngine::XtermEngine(_In_ wil::unique_hfile hPipe,
 // - S_OK or suitable HRESULT error from either conversion or writing pipe.
 [[nodiscard]] HRESULT XtermEngine::WriteTerminalW(const std::wstring& wstr) noexcept
 {
+    // We can't tell what this does to what the terminal shows.
+    _ForgetSentCells();
+
     return _fUseAsciiOnly ?
                VtEngine::_WriteTerminalAscii(wstr) :
                VtEngine::_WriteTerminalUtf8(wstr);
@@ -50,6 +50,8 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT ScrollFrame() noexcept override;
 
         [[nodiscard]] HRESULT InvalidateScroll(const COORD* const pcoordDelta) noexcept override;
+        [[nodiscard]] HRESULT InvalidateScrollRows(const SMALL_RECT* const psrRows, const SHORT delta) noexcept override;
+        [[nodiscard]] HRESULT InvalidateAll() noexcept override;
 
         [[nodiscard]] HRESULT WriteTerminalW(_In_ const std::wstring& str) noexcept override;
 
@@ -61,7 +63,38 @@ namespace Microsoft::Console::Render
         bool _usingUnderLine;
         bool _needToDisableCursor;
 
+        // What we last sent the terminal for each cell of the viewport, so that painting a
+        // run again only sends the cells of it that changed. Cells are forgotten whenever what
+        // the terminal shows can't be accounted for, like after a clear or text written through to it.
+        struct SentCell
+        {
+            wchar_t text[2];
+            BYTE length; // wchar_ts in text. 0 if we don't know what the terminal shows here.
+            BYTE columns; // 0 for the cells that the left of a wide cluster covers
+            COLORREF foreground;
+            COLORREF background;
+            bool bold;
+            bool underlined;
+        };
+        std::vector<SentCell> _sentCells;
+        COORD _sentSize;
+
+        // A band of rows whose contents moved within it since the last frame, like when
+        //      text scrolls within the margins. Only one band is shifted in the terminal
+        //      per frame. The rest are repainted.
+        SMALL_RECT _scrollRows;
+        SHORT _scrollRowsDelta;
+
         [[nodiscard]] HRESULT _MoveCursor(const COORD coord) noexcept override;
+        [[nodiscard]] HRESULT _ScrollRows() noexcept;
+        bool _IsScrollPending() const noexcept override;
+
+        [[nodiscard]] HRESULT _PaintChangedCells(std::basic_string_view<Cluster> const clusters,
+                                                 const COORD coord) noexcept;
+        bool _WasCellSent(const Cluster& cluster, const short column, const short row) const noexcept;
+        void _RecordSentCells(std::basic_string_view<Cluster> const clusters, const COORD coord) noexcept;
+        void _ScrollSentCells(const short top, const short bottom, const short dy) noexcept;
+        void _ForgetSentCells() noexcept;
 
         [[nodiscard]] HRESULT _UpdateUnderline(const WORD wLegacyAttrs) noexcept;
 
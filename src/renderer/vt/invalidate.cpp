@@ -136,15 +136,21 @@ using namespace Microsoft::Console::Render;
 // - S_OK, else an appropriate HRESULT for failing to allocate or write.
 [[nodiscard]] HRESULT VtEngine::_InvalidCombine(const Viewport invalid) noexcept
 {
-    if (!_fInvalidRectUsed)
+    try
     {
-        _invalidRect = invalid;
-        _fInvalidRectUsed = true;
-    }
-    else
-    {
-        _invalidRect = Viewport::Union(_invalidRect, invalid);
+        if (!_fInvalidRectUsed)
+        {
+            _invalidRect = invalid;
+            _invalidRegion = invalid;
+            _fInvalidRectUsed = true;
+        }
+        else
+        {
+            _invalidRect = Viewport::Union(_invalidRect, invalid);
+            _invalidRegion.Union(invalid);
+        }
     }
+    CATCH_RETURN();
 
     // Ensure invalid areas remain within bounds of window.
     RETURN_IF_FAILED(_InvalidRestrict());
@@ -170,6 +176,7 @@ using namespace Microsoft::Console::Render;
             // Add the scrolled invalid rectangle to what was left behind to get the new invalid area.
             // This is the equivalent of adding in the "update rectangle" that we would get out of ScrollWindowEx/ScrollDC.
             _invalidRect = Viewport::Union(_invalidRect, newInvalid);
+            _invalidRegion = _invalidRect;
 
             // Ensure invalid areas remain within bounds of window.
             RETURN_IF_FAILED(_InvalidRestrict());
@@ -193,6 +200,7 @@ using namespace Microsoft::Console::Render;
     _lastViewport.ToOrigin().TrimToViewport(&oldInvalid);
 
     _invalidRect = Viewport::FromExclusive(oldInvalid);
+    _invalidRegion.Intersect(_lastViewport.ToOrigin());
 
     return S_OK;
 }
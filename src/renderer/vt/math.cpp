@@ -27,6 +27,25 @@ SMALL_RECT VtEngine::GetDirtyRectInChars()
     return dirty;
 }
 
+// Routine Description:
+// - Gets the separate character regions making up the dirty portion of the frame,
+//      so that lines changed far apart from each other don't need everything
+//      between them sent again.
+// Arguments:
+// - <none>
+// Return Value:
+// - The dirty character region, without anything above the virtual top.
+Region VtEngine::GetDirtyArea()
+{
+    auto dirty = _invalidRegion;
+    const auto bounds = dirty.BoundingBox();
+    if (bounds.IsValid() && bounds.Top() < _virtualTop)
+    {
+        dirty.Intersect(Viewport::FromInclusive({ bounds.Left(), _virtualTop, bounds.RightInclusive(), bounds.BottomInclusive() }));
+    }
+    return dirty;
+}
+
 // Routine Description:
 // - Uses the currently selected font to determine how wide the given character will be when renderered.
 // - NOTE: Only supports determining half-width/full-width status for CJK-type languages (e.g. is it 1 character wide or 2. a.k.a. is it a rectangle or square.)
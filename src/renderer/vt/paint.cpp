@@ -7,6 +7,8 @@
 #include "../../inc/conattrs.hpp"
 #include "../../types/inc/convert.hpp"
 
+#include <array>
+
 #pragma hdrstop
 using namespace Microsoft::Console::Render;
 using namespace Microsoft::Console::Types;
@@ -51,6 +53,7 @@ using namespace Microsoft::Console::Types;
     _trace.TraceEndPaint();
 
     _invalidRect = Viewport::Empty();
+    _invalidRegion.Clear();
     _fInvalidRectUsed = false;
     _scrollDelta = { 0 };
     _clearedAllThisFrame = false;
@@ -77,7 +80,8 @@ using namespace Microsoft::Console::Types;
         RETURN_IF_FAILED(_MoveCursor(_deferredCursorPos));
     }
 
-    RETURN_IF_FAILED(_Flush());
+    // Leave the actual write to Present, which is called once we're out of the lock.
+    RETURN_IF_FAILED(_QueueOutput());
 
     return S_OK;
 }
@@ -85,14 +89,14 @@ using namespace Microsoft::Console::Types;
 // Routine Description:
 // - Used to perform longer running presentation steps outside the lock so the
 //      other threads can continue.
-// - Not currently used by VtEngine.
+// - Writes the frame we just painted to the pipe.
 // Arguments:
 // - <none>
 // Return Value:
-// - S_FALSE since we do nothing.
+// - S_OK or suitable HRESULT error from writing pipe.
 [[nodiscard]] HRESULT VtEngine::Present() noexcept
 {
-    return S_FALSE;
+    return _WriteQueuedOutput();
 }
 
 // Routine Description:
@@ -208,44 +212,53 @@ using namespace Microsoft::Console::Types;
     }
     else
     {
-        if (_lastWasBold != isBold)
-        {
-            RETURN_IF_FAILED(_SetGraphicsBoldness(isBold));
-            _lastWasBold = isBold;
-        }
-
-        WORD wFoundColor = 0;
-        if (fgChanged)
-        {
-            if (fgIsDefault)
+        // Everything that changed goes out in a single SGR, rather than one for
+        //      each of boldness, foreground and background.
+        std::array<int, 11> parameters;
+        size_t count = 0;
+
+        // Adds the parameters that select a color: the default, one from the
+        //      table if it's there, or otherwise the color itself.
+        const auto addColor = [&](const COLORREF color, const bool isDefault, const bool fIsForeground) noexcept {
+            WORD wFoundColor = 0;
+            if (isDefault)
             {
-                RETURN_IF_FAILED(_SetGraphicsRenditionDefaultColor(true));
+                parameters.at(count++) = fIsForeground ? 39 : 49;
             }
-            else if (::FindTableIndex(colorForeground, ColorTable, cColorTable, &wFoundColor))
+            else if (::FindTableIndex(color, ColorTable, cColorTable, &wFoundColor))
             {
-                RETURN_IF_FAILED(_SetGraphicsRendition16Color(wFoundColor, true));
+                parameters.at(count++) = _16ColorRenditionParameter(wFoundColor, fIsForeground);
             }
             else
             {
-                RETURN_IF_FAILED(_SetGraphicsRenditionRGBColor(colorForeground, true));
+                parameters.at(count++) = fIsForeground ? 38 : 48;
+                parameters.at(count++) = 2;
+                parameters.at(count++) = GetRValue(color);
+                parameters.at(count++) = GetGValue(color);
+                parameters.at(count++) = GetBValue(color);
             }
-            _LastFG = colorForeground;
+        };
+
+        if (_lastWasBold != isBold)
+        {
+            parameters.at(count++) = isBold ? 1 : 22;
+        }
+
+        if (fgChanged)
+        {
+            addColor(colorForeground, fgIsDefault, true);
         }
 
         if (bgChanged)
         {
-            if (bgIsDefault)
-            {
-                RETURN_IF_FAILED(_SetGraphicsRenditionDefaultColor(false));
-            }
-            else if (::FindTableIndex(colorBackground, ColorTable, cColorTable, &wFoundColor))
-            {
-                RETURN_IF_FAILED(_SetGraphicsRendition16Color(wFoundColor, false));
-            }
-            else
-            {
-                RETURN_IF_FAILED(_SetGraphicsRenditionRGBColor(colorBackground, false));
-            }
+            addColor(colorBackground, bgIsDefault, false);
+        }
+
+        if (count > 0)
+        {
+            RETURN_IF_FAILED(_WriteCsi(gsl::make_span(parameters.data(), count), 'm'));
+            _lastWasBold = isBold;
+            _LastFG = colorForeground;
             _LastBG = colorBackground;
         }
     }
@@ -5,10 +5,10 @@
 #include "vtrenderer.hpp"
 #include "../../inc/conattrs.hpp"
 #include "../../types/inc/convert.hpp"
+#include "../../types/inc/AllocationTracking.hpp"
 
-// For _vcprintf
-#include <conio.h>
-#include <stdarg.h>
+#include <array>
+#include <charconv>
 
 #pragma hdrstop
 
@@ -30,6 +30,8 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
                    const Viewport initialViewport) :
     RenderEngineBase(),
     _hFile(std::move(pipe)),
+    _writingOutput(false),
+    _renderOnDemand(false),
     _colorProvider(colorProvider),
     _LastFG(INVALID_COLOR),
     _LastBG(INVALID_COLOR),
@@ -56,6 +58,10 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
     _deferredCursorPos{ INVALID_COORDS },
     _trace{}
 {
+    _buffer.reserve(s_OutputBufferReserve);
+    _queuedOutput.reserve(s_OutputBufferReserve);
+    _outputBeingWritten.reserve(s_OutputBufferReserve);
+
 #ifndef UNIT_TESTING
     // When unit testing, we can instantiate a VtEngine without a pipe.
     THROW_HR_IF(E_HANDLE, _hFile.get() == INVALID_HANDLE_VALUE);
@@ -75,6 +81,8 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
 // - S_OK or suitable HRESULT error from writing pipe.
 [[nodiscard]] HRESULT VtEngine::_Write(std::string_view const str) noexcept
 {
+    const AllocationScope allocationScope{ AllocationTag::Renderer };
+
     _trace.TraceString(str);
 #ifdef UNIT_TESTING
     if (_usingTestCallback)
@@ -93,24 +101,125 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
     CATCH_RETURN();
 }
 
+// Method Description:
+// - Writes everything we've buffered so far to the pipe, after the output of
+//      any frames that are still waiting for Present.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or suitable HRESULT error from writing pipe.
 [[nodiscard]] HRESULT VtEngine::_Flush() noexcept
 {
+    RETURN_IF_FAILED(_QueueOutput());
+    return _WriteQueuedOutput();
+}
+
+// Method Description:
+// - Moves what we've buffered so far behind the output that's waiting to be
+//      written to the pipe. This is cheap, so it can be done under the console
+//      lock, leaving the write itself for later.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or E_OUTOFMEMORY if we couldn't grow the queue.
+[[nodiscard]] HRESULT VtEngine::_QueueOutput() noexcept
+{
+    try
+    {
+        std::lock_guard<std::mutex> guard{ _outputLock };
+        if (_queuedOutput.empty())
+        {
+            _queuedOutput.swap(_buffer);
+        }
+        else
+        {
+            _queuedOutput.append(_buffer);
+        }
+        _buffer.clear();
+
+        return S_OK;
+    }
+    CATCH_RETURN();
+}
+
+// Method Description:
+// - Writes the queued output to the pipe. Only one thread writes at a time, and
+//      the queue isn't locked during the write itself. Output queued by another
+//      thread meanwhile is written by the same thread once its write is done, so
+//      the others never wait on a slow reader, and everything still goes out in order.
+// - While the render thread waits on the pipe, it doesn't paint, so everything
+//      that changes in the meantime goes out together in the next frame.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or suitable HRESULT error from writing pipe.
+[[nodiscard]] HRESULT VtEngine::_WriteQueuedOutput() noexcept
+{
+    std::unique_lock<std::mutex> guard{ _outputLock, std::defer_lock };
+    try
+    {
+        guard.lock();
+    }
+    CATCH_RETURN();
+
 #ifdef UNIT_TESTING
     if (_hFile.get() == INVALID_HANDLE_VALUE)
     {
         // Do not flush during Unit Testing because we won't have a valid file.
+        _queuedOutput.clear();
         return S_OK;
     }
 #endif
 
-    if (!_pipeBroken)
+    // Whoever is already writing will get to what we queued.
+    if (_writingOutput)
     {
-        bool fSuccess = !!WriteFile(_hFile.get(), _buffer.data(), static_cast<DWORD>(_buffer.size()), nullptr, nullptr);
-        _buffer.clear();
+        return S_OK;
+    }
+    _writingOutput = true;
+
+    while (!_pipeBroken && !_queuedOutput.empty())
+    {
+        _outputBeingWritten.swap(_queuedOutput);
+        guard.unlock();
+
+        bool fSuccess = !!WriteFile(_hFile.get(), _outputBeingWritten.data(), static_cast<DWORD>(_outputBeingWritten.size()), nullptr, nullptr);
+        const DWORD error = fSuccess ? ERROR_SUCCESS : GetLastError();
+        _outputBeingWritten.clear();
+
+        // Don't hold on to all the memory an unusually big frame needed.
+        if (_outputBeingWritten.capacity() > s_OutputBufferHighWaterMark)
+        {
+            _outputBeingWritten.shrink_to_fit();
+            try
+            {
+                _outputBeingWritten.reserve(s_OutputBufferReserve);
+            }
+            CATCH_LOG();
+        }
+
+        // If the lock can't be taken again, give up on writing from here on like we
+        // would for a broken pipe, and let go of the writer's place so nobody waits on it.
+        auto giveUp = wil::scope_exit([&]() noexcept {
+            _pipeBroken = true;
+            _writingOutput = false;
+        });
+        try
+        {
+            guard.lock();
+        }
+        CATCH_RETURN();
+        giveUp.release();
+
         if (!fSuccess)
         {
-            _exitResult = HRESULT_FROM_WIN32(GetLastError());
+            _exitResult = HRESULT_FROM_WIN32(error);
             _pipeBroken = true;
+            _queuedOutput.clear();
+            _writingOutput = false;
+
+            // Closing the output can call back into us, so let go of the queue first.
+            guard.unlock();
             if (_terminalOwner)
             {
                 _terminalOwner->CloseOutput();
@@ -119,9 +228,111 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
         }
     }
 
+    _writingOutput = false;
     return S_OK;
 }
 
+// Method Description:
+// - Returns true if there's output the terminal hasn't read yet: output that's
+//      queued or being written, or that's sitting in the pipe.
+// - The pipe is asked how much room is left in its outbound buffer. It has all of
+//      it once the terminal has read everything (and more while a read is waiting).
+//      If it can't tell us, we can't wait on it, so nothing is pending.
+// Arguments:
+// - <none>
+// Return Value:
+// - true if the terminal is behind on reading what we've written.
+bool VtEngine::_IsOutputPending() noexcept
+{
+    try
+    {
+        std::lock_guard<std::mutex> guard{ _outputLock };
+        if (_writingOutput || !_queuedOutput.empty())
+        {
+            return true;
+        }
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        return false;
+    }
+
+    // FILE_PIPE_LOCAL_INFORMATION and FilePipeLocalInformation, from ntifs.h.
+    struct PipeLocalInformation
+    {
+        ULONG NamedPipeType;
+        ULONG NamedPipeConfiguration;
+        ULONG MaximumInstances;
+        ULONG CurrentInstances;
+        ULONG InboundQuota;
+        ULONG ReadDataAvailable;
+        ULONG OutboundQuota;
+        ULONG WriteQuotaAvailable;
+        ULONG NamedPipeState;
+        ULONG NamedPipeEnd;
+    };
+    struct IoStatusBlock
+    {
+        NTSTATUS Status;
+        ULONG_PTR Information;
+    };
+    static constexpr ULONG FilePipeLocalInformation = 24;
+
+    typedef NTSTATUS(NTAPI * PfnNtQueryInformationFile)(HANDLE, IoStatusBlock*, PVOID, ULONG, ULONG);
+    static const auto pfnNtQueryInformationFile = reinterpret_cast<PfnNtQueryInformationFile>(GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtQueryInformationFile"));
+
+    if (pfnNtQueryInformationFile == nullptr || _hFile.get() == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    IoStatusBlock ioStatus{};
+    PipeLocalInformation info{};
+    if (!NT_SUCCESS(pfnNtQueryInformationFile(_hFile.get(), &ioStatus, &info, sizeof(info), FilePipeLocalInformation)))
+    {
+        return false;
+    }
+
+    return info.WriteQuotaAvailable < info.OutboundQuota;
+}
+
+// Method Description:
+// - Called by the render thread before it locks the console to paint. In
+//      render-on-demand mode, waits for the terminal to read everything we've
+//      written, so that each frame is painted from the buffer as it is once the
+//      terminal can take it. Everything that changes while we wait goes out together
+//      in that one frame, instead of as a backlog of frames the terminal has to
+//      read through before it sees the current screen.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void VtEngine::WaitUntilCanRender() noexcept
+{
+    if (!_renderOnDemand)
+    {
+        return;
+    }
+
+    const auto deadline = GetTickCount64() + s_RenderOnDemandTimeoutMilliseconds;
+    while (!_pipeBroken && _IsOutputPending() && GetTickCount64() < deadline)
+    {
+        Sleep(s_RenderOnDemandPollMilliseconds);
+    }
+}
+
+// Method Description:
+// - Turns render-on-demand mode on or off. See WaitUntilCanRender.
+// Arguments:
+// - renderOnDemand: true to only paint once the terminal has read the last frame.
+// Return Value:
+// - <none>
+void VtEngine::SetRenderOnDemand(const bool renderOnDemand) noexcept
+{
+    _renderOnDemand = renderOnDemand;
+}
+
 // Method Description:
 // - Wrapper for ITerminalOutputConnection. See _Write.
 [[nodiscard]] HRESULT VtEngine::WriteTerminalUtf8(const std::string& str) noexcept
@@ -173,37 +384,54 @@ VtEngine::VtEngine(_In_ wil::unique_hfile pipe,
 }
 
 // Method Description:
-// - Helper for calling _Write with a string for formatting a sequence. Used
-//      extensively by VtSequences.cpp
+// - Writes a control sequence made of CSI, the given numeric parameters separated
+//      by semicolons, and the final character. Used extensively by VtSequences.cpp
+//      The sequence is put together on the stack, so writing one doesn't allocate.
 // Arguments:
-// - pFormat: the pointer to the string to write to the pipe.
-// - ...: a va_list of args to format the string with.
+// - parameters: the numeric parameters of the sequence, in order.
+// - finalChar: the character that ends the sequence.
 // Return Value:
-// - S_OK, E_INVALIDARG for a invalid format string, or suitable HRESULT error
-//      from writing pipe.
-[[nodiscard]] HRESULT VtEngine::_WriteFormattedString(const std::string* const pFormat, ...) noexcept
+// - S_OK, E_INVALIDARG if there are too many parameters to fit, or suitable HRESULT
+//      error from writing pipe.
+[[nodiscard]] HRESULT VtEngine::_WriteCsi(const std::initializer_list<int> parameters, const char finalChar) noexcept
 {
-    HRESULT hr = E_FAIL;
-    va_list argList;
-    va_start(argList, pFormat);
-
-    int cchNeeded = _scprintf(pFormat->c_str(), argList);
-    // -1 is the _scprintf error case https://msdn.microsoft.com/en-us/library/t32cf9tb.aspx
-    if (cchNeeded > -1)
-    {
-        wistd::unique_ptr<char[]> psz = wil::make_unique_nothrow<char[]>(cchNeeded + 1);
-        RETURN_IF_NULL_ALLOC(psz);
+    return _WriteCsi(gsl::make_span(parameters.begin(), parameters.size()), finalChar);
+}
 
-        int cchWritten = _vsnprintf_s(psz.get(), cchNeeded + 1, cchNeeded, pFormat->c_str(), argList);
-        hr = _Write({ psz.get(), gsl::narrow<size_t>(cchWritten) });
-    }
-    else
+// Method Description:
+// - Writes a control sequence made of CSI, the given numeric parameters separated
+//      by semicolons, and the final character. See above. This one is for
+//      sequences whose parameters are worked out as they go.
+// Arguments:
+// - parameters: the numeric parameters of the sequence, in order.
+// - finalChar: the character that ends the sequence.
+// Return Value:
+// - S_OK, E_INVALIDARG if there are too many parameters to fit, or suitable HRESULT
+//      error from writing pipe.
+[[nodiscard]] HRESULT VtEngine::_WriteCsi(const gsl::span<const int> parameters, const char finalChar) noexcept
+{
+    // An int takes 11 characters at most, plus one for the semicolon after it.
+    // Enough for boldness and both colors as RGB in one SGR.
+    static constexpr size_t maxParameters = 12;
+    RETURN_HR_IF(E_INVALIDARG, gsl::narrow_cast<size_t>(parameters.size()) > maxParameters);
+
+    std::array<char, 2 + maxParameters * 12 + 1> sequence;
+    auto out = sequence.data();
+    const auto end = sequence.data() + sequence.size();
+
+    *out++ = '\x1b';
+    *out++ = '[';
+    for (const auto parameter : parameters)
     {
-        hr = E_INVALIDARG;
+        if (out != sequence.data() + 2)
+        {
+            *out++ = ';';
+        }
+        out = std::to_chars(out, end, parameter).ptr;
     }
+    *out++ = finalChar;
 
-    va_end(argList);
-    return hr;
+    return _Write({ sequence.data(), gsl::narrow_cast<size_t>(out - sequence.data()) });
 }
 
 // Method Description:
@@ -398,6 +626,66 @@ bool VtEngine::_AllIsInvalid() const
     return S_OK;
 }
 
+// Method Description:
+// - Returns true if text the client writes could be passed straight through to
+//      the terminal. That's only the case between frames, once everything that
+//      was invalidated has been painted, so that the terminal shows what's in the buffer.
+// Arguments:
+// - <none>
+// Return Value:
+// - true if there's nothing left to paint.
+bool VtEngine::CanPassthrough() const noexcept
+{
+    return !_pipeBroken &&
+           !_firstPaint &&
+           !_resized &&
+           !_fInvalidRectUsed &&
+           !_IsScrollPending();
+}
+
+// Method Description:
+// - Writes text the client wrote straight to the terminal, rather than painting
+//      it from the buffer on the next frame. The caller has already put the text
+//      into the buffer, so everything it invalidated is now on the screen too.
+//   If the text scrolled or resized anything, the terminal can't be trusted to
+//      have followed along, so it's left for the next frame to paint instead.
+// Arguments:
+// - wstr - the text the client wrote, in the form the terminal should get it.
+// - coordCursor - where the cursor is now, relative to the viewport.
+// Return Value:
+// - S_OK if the text was written, S_FALSE if it needs to be painted instead,
+//      else an appropriate HRESULT for failing to allocate or write.
+[[nodiscard]] HRESULT VtEngine::PassthroughString(const std::wstring& wstr, const COORD coordCursor) noexcept
+{
+    if (_pipeBroken || _resized || _IsScrollPending())
+    {
+        return S_FALSE;
+    }
+
+    RETURN_IF_FAILED(WriteTerminalW(wstr));
+
+    _invalidRect = Viewport::Empty();
+    _invalidRegion.Clear();
+    _fInvalidRectUsed = false;
+    _lastText = coordCursor;
+
+    // The text only goes out with a frame, so make sure there is one.
+    _cursorMoved = true;
+
+    return S_OK;
+}
+
+// Method Description:
+// - Returns true if the next frame has to scroll what the terminal shows.
+// Arguments:
+// - <none>
+// Return Value:
+// - true if there's a scroll or a circling of the buffer to paint.
+bool VtEngine::_IsScrollPending() const noexcept
+{
+    return _scrollDelta.X != 0 || _scrollDelta.Y != 0 || _circled;
+}
+
 void VtEngine::SetTerminalOwner(Microsoft::Console::ITerminalOwner* const terminalOwner)
 {
     _terminalOwner = terminalOwner;
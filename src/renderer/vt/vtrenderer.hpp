@@ -51,6 +51,7 @@ namespace Microsoft::Console::Render
         [[nodiscard]] virtual HRESULT StartPaint() noexcept override;
         [[nodiscard]] virtual HRESULT EndPaint() noexcept override;
         [[nodiscard]] virtual HRESULT Present() noexcept override;
+        void WaitUntilCanRender() noexcept override;
 
         [[nodiscard]] virtual HRESULT ScrollFrame() noexcept = 0;
 
@@ -81,6 +82,7 @@ namespace Microsoft::Console::Render
                                               const int iDpi) noexcept override;
 
         SMALL_RECT GetDirtyRectInChars() override;
+        Microsoft::Console::Types::Region GetDirtyArea() override;
         [[nodiscard]] HRESULT GetFontSize(_Out_ COORD* const pFontSize) noexcept override;
         [[nodiscard]] HRESULT IsGlyphWideByFont(const std::wstring_view glyph, _Out_ bool* const pResult) noexcept override;
 
@@ -89,16 +91,43 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT RequestCursor() noexcept;
         [[nodiscard]] HRESULT InheritCursor(const COORD coordCursor) noexcept;
 
+        bool CanPassthrough() const noexcept;
+        [[nodiscard]] HRESULT PassthroughString(const std::wstring& wstr, const COORD coordCursor) noexcept;
+
         [[nodiscard]] HRESULT WriteTerminalUtf8(const std::string& str) noexcept;
 
         [[nodiscard]] virtual HRESULT WriteTerminalW(const std::wstring& str) noexcept = 0;
 
         void SetTerminalOwner(Microsoft::Console::ITerminalOwner* const terminalOwner);
+        void SetRenderOnDemand(const bool renderOnDemand) noexcept;
 
     protected:
         wil::unique_hfile _hFile;
         std::string _buffer;
 
+        // The output buffers keep their capacity from frame to frame, so that a typical frame
+        // doesn't grow them. After an unusually big frame, they're let go back down to this.
+        static constexpr size_t s_OutputBufferReserve = 16 * 1024;
+        static constexpr size_t s_OutputBufferHighWaterMark = 1024 * 1024;
+
+        // Output of finished frames that hasn't been written to the pipe yet.
+        // It's written in Present, outside the console lock, so a slow reader
+        // only holds up the thread that's writing to it.
+        std::string _queuedOutput;
+        std::mutex _outputLock;
+
+        // The output that's being written to the pipe right now, by the one thread
+        // that's writing. It's only touched by that thread, outside the lock.
+        std::string _outputBeingWritten;
+        bool _writingOutput;
+
+        // In render-on-demand mode, a frame is only painted once the terminal has read
+        // everything before it. A terminal that stops reading for longer than the
+        // timeout gets a frame anyway, so that it isn't left without one for good.
+        bool _renderOnDemand;
+        static constexpr DWORD s_RenderOnDemandPollMilliseconds = 2;
+        static constexpr ULONGLONG s_RenderOnDemandTimeoutMilliseconds = 500;
+
         const Microsoft::Console::IDefaultColorProvider& _colorProvider;
 
         COLORREF _LastFG;
@@ -107,6 +136,8 @@ namespace Microsoft::Console::Render
 
         Microsoft::Console::Types::Viewport _lastViewport;
         Microsoft::Console::Types::Viewport _invalidRect;
+        // The cells that are actually invalid. _invalidRect is the box around them.
+        Microsoft::Console::Types::Region _invalidRegion;
 
         bool _fInvalidRectUsed;
         COORD _lastRealCursor;
@@ -134,14 +165,19 @@ namespace Microsoft::Console::Render
         Microsoft::Console::VirtualTerminal::RenderTracing _trace;
 
         [[nodiscard]] HRESULT _Write(std::string_view const str) noexcept;
-        [[nodiscard]] HRESULT _WriteFormattedString(const std::string* const pFormat, ...) noexcept;
+        [[nodiscard]] HRESULT _WriteCsi(const std::initializer_list<int> parameters, const char finalChar) noexcept;
+        [[nodiscard]] HRESULT _WriteCsi(const gsl::span<const int> parameters, const char finalChar) noexcept;
         [[nodiscard]] HRESULT _Flush() noexcept;
+        [[nodiscard]] HRESULT _QueueOutput() noexcept;
+        [[nodiscard]] HRESULT _WriteQueuedOutput() noexcept;
+        bool _IsOutputPending() noexcept;
 
         void _OrRect(_Inout_ SMALL_RECT* const pRectExisting, const SMALL_RECT* const pRectToOr) const;
         [[nodiscard]] HRESULT _InvalidCombine(const Microsoft::Console::Types::Viewport invalid) noexcept;
         [[nodiscard]] HRESULT _InvalidOffset(const COORD* const ppt) noexcept;
         [[nodiscard]] HRESULT _InvalidRestrict() noexcept;
         bool _AllIsInvalid() const;
+        virtual bool _IsScrollPending() const noexcept;
 
         [[nodiscard]] HRESULT _StopCursorBlinking() noexcept;
         [[nodiscard]] HRESULT _StartCursorBlinking() noexcept;
@@ -159,6 +195,7 @@ namespace Microsoft::Console::Render
         [[nodiscard]] HRESULT _ChangeTitle(const std::string& title) noexcept;
         [[nodiscard]] HRESULT _SetGraphicsRendition16Color(const WORD wAttr,
                                                            const bool fIsForeground) noexcept;
+        static int _16ColorRenditionParameter(const WORD wAttr, const bool fIsForeground) noexcept;
         [[nodiscard]] HRESULT _SetGraphicsRenditionRGBColor(const COLORREF color,
                                                             const bool fIsForeground) noexcept;
         [[nodiscard]] HRESULT _SetGraphicsRenditionDefaultColor(const bool fIsForeground) noexcept;
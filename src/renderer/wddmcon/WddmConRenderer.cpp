@@ -26,6 +26,7 @@ WddmConEngine::WddmConEngine() :
     _displayHeight(0),
     _displayWidth(0),
     _displayState(nullptr),
+    _submitAllRows(true),
     _currentLegacyColorAttribute(DEFAULT_COLOR_ATTRIBUTE)
 {
 }
@@ -117,6 +118,7 @@ WddmConEngine::~WddmConEngine()
                     {
                         _displayHeight = DisplaySize.bottom;
                         _displayWidth = DisplaySize.right;
+                        _submitAllRows = true;
                     }
                     else
                     {
@@ -152,6 +154,9 @@ bool WddmConEngine::IsInitialized()
 [[nodiscard]] HRESULT WddmConEngine::Enable() noexcept
 {
     RETURN_IF_HANDLE_INVALID(_hWddmConCtx);
+
+    // Whoever had the display in the meantime drew over what we left on it.
+    _submitAllRows = true;
     return WDDMConEnableDisplayAccess((PHANDLE)_hWddmConCtx, TRUE);
 }
 
@@ -188,6 +193,7 @@ bool WddmConEngine::IsInitialized()
 
 [[nodiscard]] HRESULT WddmConEngine::InvalidateAll() noexcept
 {
+    _submitAllRows = true;
     return S_OK;
 }
 
@@ -212,7 +218,53 @@ bool WddmConEngine::IsInitialized()
 [[nodiscard]] HRESULT WddmConEngine::EndPaint() noexcept
 {
     RETURN_IF_HANDLE_INVALID(_hWddmConCtx);
-    return WDDMConEndUpdateDisplayBatch(_hWddmConCtx);
+
+    const HRESULT hr = _SubmitChangedRows();
+    RETURN_IF_FAILED(WDDMConEndUpdateDisplayBatch(_hWddmConCtx));
+    return hr;
+}
+
+// Routine Description:
+// - Sends the rows of the frame that was just painted which differ from what's on the display,
+//   then records them as being on the display. A script that keeps writing to the same few
+//   lines only costs those lines, rather than a trip to the display for every line painted.
+// - A row that can't be sent is left as it was, so that it's tried again with the next frame.
+// Arguments:
+// - <none>
+// Return Value:
+// - S_OK or the first error from sending a row
+[[nodiscard]] HRESULT WddmConEngine::_SubmitChangedRows() noexcept
+{
+    HRESULT hr = S_OK;
+    const size_t rowSize = _displayWidth * sizeof(CD_IO_CHARACTER);
+
+    for (LONG rowIndex = 0; rowIndex < _displayHeight; rowIndex++)
+    {
+        const auto row = _displayState[rowIndex];
+        if (!_submitAllRows && memcmp(row->New, row->Old, rowSize) == 0)
+        {
+            continue;
+        }
+
+        const HRESULT hrRow = WDDMConUpdateDisplay(_hWddmConCtx, row, _submitAllRows ? TRUE : FALSE);
+        if (FAILED(hrRow))
+        {
+            if (SUCCEEDED(hr))
+            {
+                hr = hrRow;
+            }
+            continue;
+        }
+
+        memcpy(row->Old, row->New, rowSize);
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        _submitAllRows = false;
+    }
+
+    return hr;
 }
 
 // Routine Description:
@@ -237,18 +289,12 @@ bool WddmConEngine::IsInitialized()
 {
     RETURN_IF_HANDLE_INVALID(_hWddmConCtx);
 
-    PCD_IO_CHARACTER OldChar;
-    PCD_IO_CHARACTER NewChar;
-
+    // The frame is built up in New. Old keeps what's on the display to compare it with.
     for (LONG rowIndex = 0; rowIndex < _displayHeight; rowIndex++)
     {
         for (LONG colIndex = 0; colIndex < _displayWidth; colIndex++)
         {
-            OldChar = &_displayState[rowIndex]->Old[colIndex];
-            NewChar = &_displayState[rowIndex]->New[colIndex];
-
-            OldChar->Character = NewChar->Character;
-            OldChar->Atribute = NewChar->Atribute;
+            const PCD_IO_CHARACTER NewChar = &_displayState[rowIndex]->New[colIndex];
 
             NewChar->Character = L' ';
             NewChar->Atribute = 0x0;
@@ -265,23 +311,18 @@ bool WddmConEngine::IsInitialized()
     try
     {
         RETURN_IF_HANDLE_INVALID(_hWddmConCtx);
+        RETURN_HR_IF(E_INVALIDARG, coord.X < 0 || coord.Y < 0 || coord.Y >= _displayHeight);
 
-        PCD_IO_CHARACTER OldChar;
-        PCD_IO_CHARACTER NewChar;
-
-        for (size_t i = 0; i < clusters.size() && i < (size_t)_displayWidth; i++)
+        // The row is only sent once the whole frame is painted. See EndPaint.
+        for (size_t i = 0; i < clusters.size() && coord.X + i < (size_t)_displayWidth; i++)
         {
-            OldChar = &_displayState[coord.Y]->Old[coord.X + i];
-            NewChar = &_displayState[coord.Y]->New[coord.X + i];
-
-            OldChar->Character = NewChar->Character;
-            OldChar->Atribute = NewChar->Atribute;
+            const PCD_IO_CHARACTER NewChar = &_displayState[coord.Y]->New[coord.X + i];
 
             NewChar->Character = clusters.at(i).GetTextAsSingle();
             NewChar->Atribute = _currentLegacyColorAttribute;
         }
 
-        return WDDMConUpdateDisplay(_hWddmConCtx, _displayState[coord.Y], FALSE);
+        return S_OK;
     }
     CATCH_RETURN();
 }
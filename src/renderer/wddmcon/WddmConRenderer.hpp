@@ -72,13 +72,19 @@ namespace Microsoft::Console::Render
 
         // Helpers
         void FreeResources(ULONG displayHeight);
+        [[nodiscard]] HRESULT _SubmitChangedRows() noexcept;
 
         // Variables
         LONG _displayHeight;
         LONG _displayWidth;
 
+        // Each row holds what's on the display (Old) and the frame being painted (New).
+        // Only rows whose frame differs from the display are sent when the frame ends.
         PCD_IO_ROW_INFORMATION* _displayState;
 
+        // Set when the display may no longer show what Old says it does, so every row has to be sent again.
+        bool _submitAllRows;
+
         WORD _currentLegacyColorAttribute;
     };
 }
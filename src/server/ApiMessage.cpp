@@ -103,11 +103,18 @@ ConsoleHandleData* _CONSOLE_API_MSG::GetObjectHandle() const
         ULONG cbWriteSize = Descriptor.OutputSize - State.WriteOffset;
         RETURN_IF_FAILED(ULongMult(cbWriteSize, cbFactor, &cbWriteSize));
 
-        BYTE* pPayload = new (std::nothrow) BYTE[cbWriteSize];
-        RETURN_IF_NULL_ALLOC(pPayload);
-        ZeroMemory(pPayload, sizeof(BYTE) * cbWriteSize);
-
-        State.OutputBuffer = pPayload; // TODO: MSFT: 9565140 - maintain as smart pointer.
+        // Leave room in front of the payload for the API descriptor that's written back along
+        // with it, so that both can go out with the completion. See ReleaseMessageBuffers.
+        const ULONG cbPrefixSize = (_CanCompleteWithOutput() && Complete.Write.Data != nullptr) ? Complete.Write.Size : 0;
+        ULONG cbAllocationSize;
+        RETURN_IF_FAILED(ULongAdd(cbPrefixSize, cbWriteSize, &cbAllocationSize));
+
+        BYTE* pAllocation = new (std::nothrow) BYTE[cbAllocationSize];
+        RETURN_IF_NULL_ALLOC(pAllocation);
+        ZeroMemory(pAllocation, sizeof(BYTE) * cbAllocationSize);
+
+        State.OutputBuffer = pAllocation + cbPrefixSize; // TODO: MSFT: 9565140 - maintain as smart pointer.
+        State.OutputBufferPrefixSize = cbPrefixSize;
         State.OutputBufferSize = cbWriteSize;
     }
 
@@ -138,6 +145,9 @@ ConsoleHandleData* _CONSOLE_API_MSG::GetObjectHandle() const
 //   during the processing of the given message. If the current completion status
 //   of the message indicates success, this routine also writes the output buffer
 //   (if any) to the message.
+// - Where it can, the output buffer is handed to the completion instead, so that it
+//   goes out with the reply rather than costing an ioctl of its own. It's then kept
+//   until ReleaseReplyBuffer is called, once the completion has been sent.
 // Arguments:
 // - <none>
 // Return Value:
@@ -154,6 +164,32 @@ ConsoleHandleData* _CONSOLE_API_MSG::GetObjectHandle() const
 
     if (State.OutputBuffer != nullptr)
     {
+        BYTE* const pAllocation = static_cast<BYTE*>(State.OutputBuffer) - State.OutputBufferPrefixSize;
+        const ULONG cbPrefixSize = Complete.Write.Data != nullptr ? Complete.Write.Size : 0;
+        if (NT_SUCCESS(Complete.IoStatus.Status) &&
+            _CanCompleteWithOutput() &&
+            cbPrefixSize == State.OutputBufferPrefixSize &&
+            Complete.IoStatus.Information <= State.OutputBufferSize)
+        {
+            // The completion writes the API descriptor right before where the output goes,
+            //      so put the two together and have it write both.
+            if (Complete.Write.Data != nullptr)
+            {
+                memcpy(pAllocation, Complete.Write.Data, cbPrefixSize);
+            }
+            else
+            {
+                Complete.Write.Offset = State.WriteOffset;
+            }
+            Complete.Write.Data = pAllocation;
+            Complete.Write.Size = cbPrefixSize + static_cast<ULONG>(Complete.IoStatus.Information);
+
+            State.ReplyBuffer = pAllocation;
+            State.OutputBuffer = nullptr;
+            State.OutputBufferPrefixSize = 0;
+            return hr;
+        }
+
         if (NT_SUCCESS(Complete.IoStatus.Status))
         {
             CD_IO_OPERATION IoOperation;
@@ -165,13 +201,41 @@ ConsoleHandleData* _CONSOLE_API_MSG::GetObjectHandle() const
             LOG_IF_FAILED(_pDeviceComm->WriteOutput(&IoOperation));
         }
 
-        delete[] static_cast<BYTE*>(State.OutputBuffer);
+        delete[] pAllocation;
         State.OutputBuffer = nullptr;
+        State.OutputBufferPrefixSize = 0;
     }
 
     return hr;
 }
 
+// Routine Description:
+// - Frees the output buffer that ReleaseMessageBuffers handed to the completion. Must
+//   be called once the completion has been sent to the driver.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void _CONSOLE_API_MSG::ReleaseReplyBuffer() noexcept
+{
+    delete[] static_cast<BYTE*>(State.ReplyBuffer);
+    State.ReplyBuffer = nullptr;
+}
+
+// Routine Description:
+// - Checks whether the output of this message can be written by its completion. It can
+//   when the completion doesn't write anything else, or when what it writes ends right
+//   where the output starts.
+// Arguments:
+// - <none>
+// Return Value:
+// - true if the output and whatever the completion writes can be written as one.
+bool _CONSOLE_API_MSG::_CanCompleteWithOutput() const noexcept
+{
+    return Complete.Write.Data == nullptr ||
+           Complete.Write.Offset + Complete.Write.Size == State.WriteOffset;
+}
+
 void _CONSOLE_API_MSG::SetReplyStatus(const NTSTATUS Status)
 {
     Complete.IoStatus.Status = Status;
@@ -69,8 +69,12 @@ public:
     [[nodiscard]] HRESULT GetInputBuffer(_Outptr_result_bytebuffer_(*pcbSize) void** const ppvBuffer, _Out_ ULONG* const pcbSize);
 
     [[nodiscard]] HRESULT ReleaseMessageBuffers();
+    void ReleaseReplyBuffer() noexcept;
 
     void SetReplyStatus(const NTSTATUS Status);
     void SetReplyInformation(const ULONG_PTR pInformation);
 
+private:
+    bool _CanCompleteWithOutput() const noexcept;
+
 } CONSOLE_API_MSG, *PCONSOLE_API_MSG, * const PCCONSOLE_API_MSG;
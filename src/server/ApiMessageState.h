@@ -25,4 +25,6 @@ typedef struct _CONSOLE_API_STATE
     ULONG OutputBufferSize;
     PVOID InputBuffer;
     PVOID OutputBuffer;
+    ULONG OutputBufferPrefixSize; // bytes allocated in front of OutputBuffer, see ReleaseMessageBuffers
+    PVOID ReplyBuffer; // output that goes out with the completion, freed by ReleaseReplyBuffer
 } CONSOLE_API_STATE, *PCONSOLE_API_STATE, * const PCCONSOLE_API_STATE;
@@ -6,6 +6,7 @@
 #include "ApiSorter.h"
 
 #include "ApiDispatchers.h"
+#include "ApiStatistics.h"
 
 #include "../host/tracing.hpp"
 
@@ -132,6 +133,12 @@ const CONSOLE_API_LAYER_DESCRIPTOR ConsoleApiLayerTable[] = {
     { ConsoleApiLayer3, RTL_NUMBER_OF(ConsoleApiLayer3) },
 };
 
+// ApiStatistics keeps a fixed slot for every API in every layer.
+static_assert(RTL_NUMBER_OF(ConsoleApiLayerTable) <= ApiStatistics::LayerCount);
+static_assert(RTL_NUMBER_OF(ConsoleApiLayer1) <= ApiStatistics::MaxApisPerLayer);
+static_assert(RTL_NUMBER_OF(ConsoleApiLayer2) <= ApiStatistics::MaxApisPerLayer);
+static_assert(RTL_NUMBER_OF(ConsoleApiLayer3) <= ApiStatistics::MaxApisPerLayer);
+
 // Routine Description:
 // - This routine validates a user IO and dispatches it to the appropriate worker routine.
 // Arguments:
@@ -175,7 +182,18 @@ PCONSOLE_API_MSG ApiSorter::ConsoleDispatchRequest(_Inout_ PCONSOLE_API_MSG Mess
     // alias API.
     {
         const auto trace = Tracing::s_TraceApiCall(Status, Descriptor->TraceName);
+        const auto lockWaitStart = ApiStatistics::s_GetLockWait();
+        const auto serviceStart = ApiStatistics::s_Now();
         Status = (*Descriptor->Routine)(Message, &ReplyPending);
+
+        // Calls that pend are only timed up to here, not until they're completed later.
+        ApiStatistics::Instance().Record(LayerNumber,
+                                         ApiNumber,
+                                         Descriptor->TraceName,
+                                         Message->Descriptor.InputSize,
+                                         Message->Descriptor.OutputSize,
+                                         ApiStatistics::s_GetLockWait() - lockWaitStart,
+                                         ApiStatistics::s_Now() - serviceStart);
     }
     if (Status != STATUS_BUFFER_TOO_SMALL)
     {
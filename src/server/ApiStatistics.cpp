@@ -0,0 +1,122 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "ApiStatistics.h"
+
+#include "../host/tracing.hpp"
+
+// The console lock time waited for by the current thread, in performance counter ticks.
+static thread_local LONGLONG s_lockWaitTicks = 0;
+
+ApiStatistics::ApiStatistics() noexcept :
+    _llPerformanceFrequency(0),
+    _entries{}
+{
+    LARGE_INTEGER liFrequency;
+    QueryPerformanceFrequency(&liFrequency);
+    _llPerformanceFrequency = liFrequency.QuadPart;
+}
+
+ApiStatistics& ApiStatistics::Instance()
+{
+    static ApiStatistics s_Instance;
+    return s_Instance;
+}
+
+// Routine Description:
+// - Reads the performance counter, to time API calls with.
+// Arguments:
+// - <none>
+// Return Value:
+// - The current performance counter.
+LONGLONG ApiStatistics::s_Now() noexcept
+{
+    LARGE_INTEGER liNow;
+    QueryPerformanceCounter(&liNow);
+    return liNow.QuadPart;
+}
+
+// Routine Description:
+// - Adds to the time that the current thread has spent waiting for the console lock.
+// Arguments:
+// - ticks - How long the thread just waited, in performance counter ticks.
+// Return Value:
+// - <none>
+void ApiStatistics::s_AddLockWait(const LONGLONG ticks) noexcept
+{
+    s_lockWaitTicks += ticks;
+}
+
+// Routine Description:
+// - Gets the time that the current thread has spent waiting for the console lock so far.
+//   The difference between two calls is the time waited in between them.
+// Arguments:
+// - <none>
+// Return Value:
+// - The total time waited, in performance counter ticks.
+LONGLONG ApiStatistics::s_GetLockWait() noexcept
+{
+    return s_lockWaitTicks;
+}
+
+// Routine Description:
+// - Records one call to an API.
+// Arguments:
+// - layer - The 0-based layer of the API.
+// - api - The 0-based number of the API within its layer.
+// - traceName - The name of the API, for tracing.
+// - bytesIn - The size of the client's input buffer for the call.
+// - bytesOut - The size of the client's output buffer for the call.
+// - lockWaitTicks - How long the call waited for the console lock.
+// - serviceTicks - How long the call took, including the wait for the lock.
+// Return Value:
+// - <none>
+void ApiStatistics::Record(const ULONG layer,
+                           const ULONG api,
+                           PCSTR traceName,
+                           const ULONG bytesIn,
+                           const ULONG bytesOut,
+                           const LONGLONG lockWaitTicks,
+                           const LONGLONG serviceTicks) noexcept
+{
+    if (layer >= LayerCount || api >= MaxApisPerLayer)
+    {
+        return;
+    }
+
+    auto& entry = _entries.at(layer).at(api);
+    entry.traceName.store(traceName, std::memory_order_relaxed);
+    entry.calls.store(entry.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    entry.bytesIn.store(entry.bytesIn.load(std::memory_order_relaxed) + bytesIn, std::memory_order_relaxed);
+    entry.bytesOut.store(entry.bytesOut.load(std::memory_order_relaxed) + bytesOut, std::memory_order_relaxed);
+    entry.lockWait.Add(_ToMicroseconds(lockWaitTicks));
+    entry.service.Add(_ToMicroseconds(serviceTicks));
+}
+
+// Routine Description:
+// - Writes the statistics of every API that has been called to the trace.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void ApiStatistics::Trace() const noexcept
+{
+    for (ULONG layer = 0; layer < LayerCount; ++layer)
+    {
+        for (ULONG api = 0; api < MaxApisPerLayer; ++api)
+        {
+            const auto& entry = _entries.at(layer).at(api);
+            if (entry.calls.load(std::memory_order_relaxed) != 0)
+            {
+                Tracing::s_TraceApiStatistics(layer, api, entry);
+            }
+        }
+    }
+}
+
+uint64_t ApiStatistics::_ToMicroseconds(const LONGLONG ticks) const noexcept
+{
+    return _llPerformanceFrequency > 0 && ticks > 0 ? static_cast<uint64_t>((ticks * 1000000) / _llPerformanceFrequency) : 0;
+}
@@ -0,0 +1,64 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ApiStatistics.h
+
+Abstract:
+- This file counts the calls made to each console API, the bytes they carried,
+  and how long they waited for the console lock and took to service.
+- Times are kept in histograms with one bucket per power of two microseconds
+  (see Histogram.hpp).
+- Only the thread servicing API calls records statistics. They can be read from
+  any other thread at any time, at the cost of sometimes seeing a call halfway
+  through being recorded.
+--*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include "../types/inc/Histogram.hpp"
+
+class ApiStatistics final
+{
+public:
+    static constexpr ULONG LayerCount = 3;
+    static constexpr ULONG MaxApisPerLayer = 64;
+
+    struct Entry
+    {
+        std::atomic<PCSTR> traceName{ nullptr };
+        std::atomic<uint64_t> calls{ 0 };
+        std::atomic<uint64_t> bytesIn{ 0 };
+        std::atomic<uint64_t> bytesOut{ 0 };
+        Microsoft::Console::Types::Histogram lockWait;
+        Microsoft::Console::Types::Histogram service;
+    };
+
+    static ApiStatistics& Instance();
+
+    static LONGLONG s_Now() noexcept;
+    static void s_AddLockWait(const LONGLONG ticks) noexcept;
+    static LONGLONG s_GetLockWait() noexcept;
+
+    void Record(const ULONG layer,
+                const ULONG api,
+                PCSTR traceName,
+                const ULONG bytesIn,
+                const ULONG bytesOut,
+                const LONGLONG lockWaitTicks,
+                const LONGLONG serviceTicks) noexcept;
+
+    void Trace() const noexcept;
+
+private:
+    ApiStatistics() noexcept;
+
+    LONGLONG _llPerformanceFrequency;
+    std::array<std::array<Entry, MaxApisPerLayer>, LayerCount> _entries;
+
+    uint64_t _ToMicroseconds(const LONGLONG ticks) const noexcept;
+};
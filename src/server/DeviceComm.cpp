@@ -5,7 +5,9 @@
 #include "DeviceComm.h"
 
 DeviceComm::DeviceComm(_In_ HANDLE Server) :
-    _Server(Server)
+    _Server(Server),
+    _messageCount(0),
+    _ioctlCount(0)
 {
     THROW_HR_IF(E_HANDLE, Server == INVALID_HANDLE_VALUE);
 }
@@ -53,6 +55,11 @@ DeviceComm::~DeviceComm()
         hr = S_OK; // TODO: MSFT: 9115192 - ??? This isn't really relevant anymore with a switch from NtDeviceIoControlFile to DeviceIoControl...
     }
 
+    if (SUCCEEDED(hr))
+    {
+        _messageCount++;
+    }
+
     return hr;
 }
 
@@ -119,6 +126,28 @@ DeviceComm::~DeviceComm()
                       0);
 }
 
+// Routine Description:
+// - Gets how many messages have been read from the driver so far.
+// Arguments:
+// - <none>
+// Return Value:
+// - The number of messages read by ReadIo.
+ULONG64 DeviceComm::GetMessageCount() const noexcept
+{
+    return _messageCount;
+}
+
+// Routine Description:
+// - Gets how many ioctls have been sent to the driver so far, including the ones that read messages.
+// Arguments:
+// - <none>
+// Return Value:
+// - The number of ioctls sent.
+ULONG64 DeviceComm::GetIoctlCount() const noexcept
+{
+    return _ioctlCount;
+}
+
 // Routine Description:
 // - For internal use. This function will send the appropriate control code verb and buffers to the driver and return a result.
 // - Usage of the optional buffers depends on which verb is sent and is specific to the particular driver and its protocol.
@@ -139,6 +168,7 @@ DeviceComm::~DeviceComm()
     // See: https://msdn.microsoft.com/en-us/library/windows/desktop/aa363216(v=vs.85).aspx
     // Written is unused but cannot be nullptr because we aren't using overlapped.
     DWORD cbWritten = 0;
+    _ioctlCount++;
     RETURN_IF_WIN32_BOOL_FALSE(DeviceIoControl(_Server.get(),
                                                dwIoControlCode,
                                                pInBuffer,
@@ -36,6 +36,9 @@ public:
 
     [[nodiscard]] HRESULT AllowUIAccess() const;
 
+    ULONG64 GetMessageCount() const noexcept;
+    ULONG64 GetIoctlCount() const noexcept;
+
 private:
     [[nodiscard]] HRESULT _CallIoctl(_In_ DWORD dwIoControlCode,
                                      _In_reads_bytes_opt_(cbInBufferSize) PVOID pInBuffer,
@@ -44,4 +47,8 @@ private:
                                      _In_ DWORD cbOutBufferSize) const;
 
     wil::unique_handle _Server;
+
+    // How many messages we've read and how many ioctls it took to service them, for tracing.
+    mutable std::atomic<ULONG64> _messageCount;
+    mutable std::atomic<ULONG64> _ioctlCount;
 };
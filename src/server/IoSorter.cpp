@@ -15,9 +15,16 @@
 #include "..\host\getset.h"
 #include "..\host\stream.h"
 
+#include "..\types\inc\AllocationTracking.hpp"
+
+using Microsoft::Console::Types::AllocationScope;
+using Microsoft::Console::Types::AllocationTag;
+
 void IoSorter::ServiceIoOperation(_In_ CONSOLE_API_MSG* const pMsg,
                                   _Out_ CONSOLE_API_MSG** ReplyMsg)
 {
+    const AllocationScope allocationScope{ AllocationTag::Server };
+
     NTSTATUS Status;
     HRESULT hr;
     BOOL ReplyPending = FALSE;
@@ -25,6 +25,7 @@ class InputBuffer;
 class SCREEN_INFORMATION;
 
 #include "WaitQueue.h"
+#include "SlabAllocator.h"
 
 class ConsoleHandleData final
 {
@@ -40,6 +41,17 @@ public:
     ConsoleHandleData& operator=(const ConsoleHandleData&) & = delete;
     ConsoleHandleData& operator=(ConsoleHandleData&&) & = delete;
 
+    // Handles are opened and closed with every client that comes and goes, so they're kept in slabs.
+    static void* operator new(const size_t cb)
+    {
+        return SlabAllocator<ConsoleHandleData>::Allocate(cb);
+    }
+
+    static void operator delete(void* const pv, const size_t cb) noexcept
+    {
+        SlabAllocator<ConsoleHandleData>::Free(pv, cb);
+    }
+
     [[nodiscard]] HRESULT GetInputBuffer(const ACCESS_MASK amRequested,
                                          _Outptr_ InputBuffer** const ppInputBuffer) const;
     [[nodiscard]] HRESULT GetScreenBuffer(const ACCESS_MASK amRequested,
@@ -20,6 +20,7 @@ Revision History:
 #include "ObjectHandle.h"
 #include "WaitQueue.h"
 #include "ProcessPolicy.h"
+#include "SlabAllocator.h"
 
 #include <memory>
 #include <wil\resource.h>
@@ -50,6 +51,17 @@ private:
     ConsoleProcessHandle& operator=(const ConsoleProcessHandle&) & = delete;
     ConsoleProcessHandle& operator=(ConsoleProcessHandle&&) & = delete;
 
+    // Records come and go with every client that attaches, so they're kept in slabs.
+    static void* operator new(const size_t cb)
+    {
+        return SlabAllocator<ConsoleProcessHandle>::Allocate(cb);
+    }
+
+    static void operator delete(void* const pv, const size_t cb) noexcept
+    {
+        SlabAllocator<ConsoleProcessHandle>::Free(pv, cb);
+    }
+
     ULONG _ulTerminateCount;
     ULONG const _ulProcessGroupId;
     wil::unique_handle const _hProcess;
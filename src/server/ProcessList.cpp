@@ -61,11 +61,22 @@ using namespace Microsoft::Console::Interactivity;
         pProcessData = new ConsoleProcessHandle(dwProcessId,
                                                 dwThreadId,
                                                 ulProcessGroupId);
+        auto deleteProcessData = wil::scope_exit([&]() {
+            delete pProcessData;
+        });
 
         // Some applications, when reading the process list through the GetConsoleProcessList API, are expecting
         // the returned list of attached process IDs to be from newest to oldest.
         // As such, we have to put the newest process into the head of the list.
         _processes.push_front(pProcessData);
+        auto removeProcessData = wil::scope_exit([&]() {
+            _processes.pop_front();
+        });
+
+        _processesById.emplace(dwProcessId, _processes.begin());
+
+        removeProcessData.release();
+        deleteProcessData.release();
 
         if (nullptr != ppProcessData)
         {
@@ -87,10 +98,12 @@ void ConsoleProcessList::FreeProcessData(_In_ ConsoleProcessHandle* const pProce
 {
     FAIL_FAST_IF(!(ServiceLocator::LocateGlobals().getConsoleInformation().IsConsoleLocked()));
 
-    // Assert that the item exists in the list. If it doesn't exist, the end/last will be returned.
-    FAIL_FAST_IF(!(_processes.cend() != std::find(_processes.cbegin(), _processes.cend(), pProcessData)));
+    // Assert that the item exists in the list.
+    const auto found = _processesById.find(pProcessData->dwProcessId);
+    FAIL_FAST_IF(!(found != _processesById.end() && *found->second == pProcessData));
 
-    _processes.remove(pProcessData);
+    _processes.erase(found->second);
+    _processesById.erase(found);
 
     delete pProcessData;
 }
@@ -104,25 +117,22 @@ void ConsoleProcessList::FreeProcessData(_In_ ConsoleProcessHandle* const pProce
 // - Pointer to the process handle information or nullptr if no match was found.
 ConsoleProcessHandle* ConsoleProcessList::FindProcessInList(const DWORD dwProcessId) const
 {
+    if (ROOT_PROCESS_ID != dwProcessId)
+    {
+        const auto found = _processesById.find(dwProcessId);
+        return found != _processesById.end() ? *found->second : nullptr;
+    }
+
+    // Whichever process is the root can change at any time, so it has to be searched for.
     auto it = _processes.cbegin();
 
     while (it != _processes.cend())
     {
         ConsoleProcessHandle* const pProcessHandleRecord = *it;
 
-        if (ROOT_PROCESS_ID != dwProcessId)
+        if (pProcessHandleRecord->fRootProcess)
         {
-            if (pProcessHandleRecord->dwProcessId == dwProcessId)
-            {
-                return pProcessHandleRecord;
-            }
-        }
-        else
-        {
-            if (pProcessHandleRecord->fRootProcess)
-            {
-                return pProcessHandleRecord;
-            }
+            return pProcessHandleRecord;
         }
 
         it = std::next(it);
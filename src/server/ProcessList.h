@@ -61,5 +61,9 @@ public:
 private:
     std::list<ConsoleProcessHandle*> _processes;
 
+    // Where each process is in _processes, by process ID, so that attaching, detaching and
+    // looking up a process doesn't have to walk the list.
+    std::unordered_map<DWORD, std::list<ConsoleProcessHandle*>::iterator> _processesById;
+
     void _ModifyProcessForegroundRights(const HANDLE hProcess, const bool fForeground) const;
 };
@@ -0,0 +1,88 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- SlabAllocator.h
+
+Abstract:
+- This file hands out memory for objects of one type from slabs of many blocks at a time.
+- Freed blocks go onto a free list and are handed out again, so objects that come and go
+  often (like handles and process records for short lived clients) don't go to the heap each time.
+- Slabs are kept for the life of the process. That way, objects that are freed during
+  teardown never touch memory that's already been released.
+- This is not thread safe. The objects that use it are only made and freed under the console lock.
+--*/
+
+#pragma once
+
+template<typename T, size_t BlocksPerSlab = 64>
+class SlabAllocator final
+{
+public:
+    // Routine Description:
+    // - Gets memory for one object.
+    // Arguments:
+    // - cb - The size of the object. Anything but the size of T goes to the heap.
+    // Return Value:
+    // - The memory for the object. Throws std::bad_alloc if there isn't any.
+    static void* Allocate(const size_t cb)
+    {
+        if (cb != sizeof(T))
+        {
+            return ::operator new(cb);
+        }
+
+        if (s_pFree == nullptr)
+        {
+            // Chain the blocks of a new slab together to make the free list.
+            Block* const pSlab = new Block[BlocksPerSlab];
+            for (size_t i = 0; i < BlocksPerSlab - 1; i++)
+            {
+                pSlab[i].pNext = &pSlab[i + 1];
+            }
+            pSlab[BlocksPerSlab - 1].pNext = nullptr;
+            s_pFree = pSlab;
+        }
+
+        Block* const pBlock = s_pFree;
+        s_pFree = pBlock->pNext;
+        return pBlock;
+    }
+
+    // Routine Description:
+    // - Gives back memory that came from Allocate.
+    // Arguments:
+    // - pv - The memory of the object, or nullptr.
+    // - cb - The size the memory was allocated with.
+    // Return Value:
+    // - <none>
+    static void Free(void* const pv, const size_t cb) noexcept
+    {
+        if (pv == nullptr)
+        {
+            return;
+        }
+
+        if (cb != sizeof(T))
+        {
+            ::operator delete(pv);
+            return;
+        }
+
+        Block* const pBlock = static_cast<Block*>(pv);
+        pBlock->pNext = s_pFree;
+        s_pFree = pBlock;
+    }
+
+private:
+    union Block
+    {
+        Block* pNext;
+        alignas(T) BYTE rgbStorage[sizeof(T)];
+    };
+
+    static_assert(BlocksPerSlab > 0);
+
+    inline static Block* s_pFree = nullptr;
+};
@@ -13,10 +13,12 @@
 
 #include "..\interactivity\inc\ServiceLocator.hpp"
 
+ULONGLONG ConsoleWaitBlock::s_ullNextSequence = 0;
+
 // Routine Description:
 // - Initializes a ConsoleWaitBlock
 // - ConsoleWaitBlocks will self-manage their position in their two queues.
-// - They will push themselves into the tail and store the iterator for constant deletion time later.
+// - They will link themselves onto the tail, so they can unlink themselves in constant time later.
 // Arguments:
 // - pProcessQueue - The queue attached to the client process ID that requested this action
 // - pObjectQueue - The queue attached to the console object that will service the action when data arrives
@@ -27,11 +29,14 @@ ConsoleWaitBlock::ConsoleWaitBlock(_In_ ConsoleWaitQueue* const pProcessQueue,
                                    const CONSOLE_API_MSG* const pWaitReplyMessage,
                                    _In_ IWaitRoutine* const pWaiter) :
     _pProcessQueue(THROW_HR_IF_NULL(E_INVALIDARG, pProcessQueue)),
+    _processQueueLinks{ nullptr, nullptr },
     _pObjectQueue(THROW_HR_IF_NULL(E_INVALIDARG, pObjectQueue)),
+    _objectQueueLinks{ nullptr, nullptr },
+    _ullSequence(s_ullNextSequence++),
     _pWaiter(THROW_HR_IF_NULL(E_INVALIDARG, pWaiter))
 {
-    _itProcessQueue = _pProcessQueue->_blocks.insert(_pProcessQueue->_blocks.end(), this);
-    _itObjectQueue = _pObjectQueue->_blocks.insert(_pObjectQueue->_blocks.end(), this);
+    _pProcessQueue->_Link(this);
+    _pObjectQueue->_Link(this);
 
     _WaitReplyMessage = *pWaitReplyMessage;
 
@@ -44,12 +49,12 @@ ConsoleWaitBlock::ConsoleWaitBlock(_In_ ConsoleWaitQueue* const pProcessQueue,
 
 // Routine Description:
 // - Destroys a ConsolewaitBlock
-// - On deletion, ConsoleWaitBlocks will erase themselves from the process and object queues in
-//   constant time with the iterator acquired on construction.
+// - On deletion, ConsoleWaitBlocks will unlink themselves from the process and object queues in
+//   constant time.
 ConsoleWaitBlock::~ConsoleWaitBlock()
 {
-    _pProcessQueue->_blocks.erase(_itProcessQueue);
-    _pObjectQueue->_blocks.erase(_itObjectQueue);
+    _pProcessQueue->_Unlink(this);
+    _pObjectQueue->_Unlink(this);
 
     if (_pWaiter != nullptr)
     {
@@ -57,6 +62,17 @@ ConsoleWaitBlock::~ConsoleWaitBlock()
     }
 }
 
+// Routine Description:
+// - Gets the links that place this block in the given queue.
+// Arguments:
+// - pQueue - Either the process queue or the object queue of this block
+// Return Value:
+// - The links for that queue.
+ConsoleWaitBlock::QueueLinks& ConsoleWaitBlock::_LinksFor(const ConsoleWaitQueue* const pQueue) noexcept
+{
+    return pQueue == _pProcessQueue ? _processQueueLinks : _objectQueueLinks;
+}
+
 // Routine Description:
 // - Creates and enqueues a new wait for later callback when a routine cannot be serviced at this time.
 // - Will extract the process ID and the target object, enqueuing in both to know when to callback
@@ -212,6 +228,7 @@ bool ConsoleWaitBlock::Notify(const WaitTerminationReason TerminationReason)
         LOG_IF_FAILED(_WaitReplyMessage.ReleaseMessageBuffers());
 
         LOG_IF_FAILED(Microsoft::Console::Interactivity::ServiceLocator::LocateGlobals().pDeviceComm->CompleteIo(&_WaitReplyMessage.Complete));
+        _WaitReplyMessage.ReleaseReplyBuffer();
 
         fRetVal = true;
     }
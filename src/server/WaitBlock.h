@@ -21,8 +21,6 @@ Revision History:
 #include "IWaitRoutine.h"
 #include "WaitTerminationReason.h"
 
-#include <list>
-
 class ConsoleWaitQueue;
 
 class ConsoleWaitBlock
@@ -41,13 +39,28 @@ private:
                      const CONSOLE_API_MSG* const pWaitReplyMessage,
                      _In_ IWaitRoutine* const pWaiter);
 
+    // The block is linked into each of its queues directly, so waiting doesn't allocate list nodes.
+    struct QueueLinks
+    {
+        ConsoleWaitBlock* pPrev;
+        ConsoleWaitBlock* pNext;
+    };
+
     ConsoleWaitQueue* const _pProcessQueue;
-    std::_List_const_iterator<std::_List_val<std::_List_simple_types<ConsoleWaitBlock*>>> _itProcessQueue;
+    QueueLinks _processQueueLinks;
 
     ConsoleWaitQueue* const _pObjectQueue;
-    std::_List_const_iterator<std::_List_val<std::_List_simple_types<ConsoleWaitBlock*>>> _itObjectQueue;
+    QueueLinks _objectQueueLinks;
+
+    // Orders blocks by when they started waiting, across all of a queue's buckets.
+    ULONGLONG const _ullSequence;
+    static ULONGLONG s_ullNextSequence;
 
     CONSOLE_API_MSG _WaitReplyMessage;
 
     IWaitRoutine* const _pWaiter;
+
+    QueueLinks& _LinksFor(const ConsoleWaitQueue* const pQueue) noexcept;
+
+    friend class ConsoleWaitQueue; // Queues walk the links of the blocks that are in them.
 };
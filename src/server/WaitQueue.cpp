@@ -12,7 +12,8 @@
 // Routine Description:
 // - Instantiates a new ConsoleWaitQueue
 ConsoleWaitQueue::ConsoleWaitQueue() :
-    _blocks()
+    _writeWaiters{ nullptr, nullptr },
+    _readWaiters{ nullptr, nullptr }
 {
 }
 
@@ -74,20 +75,63 @@ bool ConsoleWaitQueue::NotifyWaiters(const bool fNotifyAll)
 bool ConsoleWaitQueue::NotifyWaiters(const bool fNotifyAll,
                                      const WaitTerminationReason TerminationReason)
 {
-    bool fResult = false;
-
-    auto it = _blocks.cbegin();
-    while (!_blocks.empty() && it != _blocks.cend())
+    if (!fNotifyAll)
     {
-        ConsoleWaitBlock* const WaitBlock = (*it);
-        if (nullptr == WaitBlock)
+        // Only the block that's been waiting longest is notified, whichever bucket it's in.
+        ConsoleWaitBlock* pOldest = _writeWaiters.pHead;
+        if (pOldest == nullptr ||
+            (_readWaiters.pHead != nullptr && _readWaiters.pHead->_ullSequence < pOldest->_ullSequence))
         {
-            break;
+            pOldest = _readWaiters.pHead;
         }
 
-        auto const nextIt = std::next(it); // we have to capture next before it is potentially erased
+        return pOldest != nullptr && _NotifyBlock(pOldest, TerminationReason);
+    }
+
+    bool fResult = _NotifyBucket(_writeWaiters, true, TerminationReason);
+    if (_NotifyBucket(_readWaiters, true, TerminationReason))
+    {
+        fResult = true;
+    }
+
+    return fResult;
+}
 
-        if (_NotifyBlock(WaitBlock, TerminationReason))
+// Routine Description:
+// - Instructs this queue to attempt to callback the requests waiting to give the given kind of reply
+// - Blocks waiting to give any other kind of reply aren't looked at.
+// Arguments:
+// - fNotifyAll - If true, we will notify all such items in the queue. If false, we will only notify the first one.
+// - WaitType - The kind of reply the event can satisfy.
+// Return Value:
+// - True if any block was successfully notified. False if no blocks were successful.
+bool ConsoleWaitQueue::NotifyWaiters(const bool fNotifyAll,
+                                     const ReplyDataType WaitType)
+{
+    return _NotifyBucket(_BucketFor(WaitType), fNotifyAll, WaitTerminationReason::NoReason);
+}
+
+// Routine Description:
+// - Attempts to callback the requests in one bucket of this queue, oldest first
+// Arguments:
+// - bucket - The bucket of blocks to notify
+// - fNotifyAll - If true, we will notify all items in the bucket. If false, we will only notify the first item.
+// - TerminationReason - A reason/message to pass to each waiter signaling it should terminate appropriately.
+// Return Value:
+// - True if any block was successfully notified. False if no blocks were successful.
+bool ConsoleWaitQueue::_NotifyBucket(const Bucket& bucket,
+                                     const bool fNotifyAll,
+                                     const WaitTerminationReason TerminationReason)
+{
+    bool fResult = false;
+
+    ConsoleWaitBlock* pWaitBlock = bucket.pHead;
+    while (pWaitBlock != nullptr)
+    {
+        // we have to capture next before it is potentially deleted
+        ConsoleWaitBlock* const pNext = pWaitBlock->_LinksFor(this).pNext;
+
+        if (_NotifyBlock(pWaitBlock, TerminationReason))
         {
             fResult = true;
         }
@@ -97,7 +141,7 @@ bool ConsoleWaitQueue::NotifyWaiters(const bool fNotifyAll,
             break;
         }
 
-        it = nextIt;
+        pWaitBlock = pNext;
     }
 
     return fResult;
@@ -124,3 +168,66 @@ bool ConsoleWaitQueue::_NotifyBlock(_In_ ConsoleWaitBlock* pWaitBlock,
 
     return fResult;
 }
+
+// Routine Description:
+// - Links a block onto the tail of the bucket for the kind of reply it's waiting to give
+// Arguments:
+// - pWaitBlock - The block that's starting to wait in this queue
+void ConsoleWaitQueue::_Link(_In_ ConsoleWaitBlock* const pWaitBlock) noexcept
+{
+    Bucket& bucket = _BucketFor(pWaitBlock->_pWaiter->GetReplyType());
+    auto& links = pWaitBlock->_LinksFor(this);
+
+    links.pPrev = bucket.pTail;
+    links.pNext = nullptr;
+    if (bucket.pTail != nullptr)
+    {
+        bucket.pTail->_LinksFor(this).pNext = pWaitBlock;
+    }
+    else
+    {
+        bucket.pHead = pWaitBlock;
+    }
+    bucket.pTail = pWaitBlock;
+}
+
+// Routine Description:
+// - Unlinks a block from this queue
+// Arguments:
+// - pWaitBlock - A block that was linked into this queue
+void ConsoleWaitQueue::_Unlink(_In_ ConsoleWaitBlock* const pWaitBlock) noexcept
+{
+    Bucket& bucket = _BucketFor(pWaitBlock->_pWaiter->GetReplyType());
+    auto& links = pWaitBlock->_LinksFor(this);
+
+    if (links.pPrev != nullptr)
+    {
+        links.pPrev->_LinksFor(this).pNext = links.pNext;
+    }
+    else
+    {
+        bucket.pHead = links.pNext;
+    }
+
+    if (links.pNext != nullptr)
+    {
+        links.pNext->_LinksFor(this).pPrev = links.pPrev;
+    }
+    else
+    {
+        bucket.pTail = links.pPrev;
+    }
+
+    links = { nullptr, nullptr };
+}
+
+// Routine Description:
+// - Gets the bucket of blocks waiting to give the given kind of reply
+// Arguments:
+// - WaitType - The kind of reply
+// Return Value:
+// - The bucket for it.
+ConsoleWaitQueue::Bucket& ConsoleWaitQueue::_BucketFor(const ReplyDataType WaitType) noexcept
+{
+    return WaitType == ReplyDataType::Read ? _readWaiters : _writeWaiters;
+}
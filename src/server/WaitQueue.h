@@ -7,6 +7,8 @@ Module Name:
 
 Abstract:
 - This file manages a queue of wait blocks
+- Blocks are kept in one bucket for each kind of reply they're waiting to give,
+  so that an event only has to go through the waiters it can satisfy.
 
 Author:
 - Michael Niksa (miniksa) 17-Oct-2016
@@ -17,8 +19,6 @@ Revision History:
 
 #pragma once
 
-#include <list>
-
 #include "..\host\conapi.h"
 
 #include "IWaitRoutine.h"
@@ -37,14 +37,33 @@ public:
     bool NotifyWaiters(const bool fNotifyAll,
                        const WaitTerminationReason TerminationReason);
 
+    bool NotifyWaiters(const bool fNotifyAll,
+                       const ReplyDataType WaitType);
+
     [[nodiscard]] static HRESULT s_CreateWait(_Inout_ CONSOLE_API_MSG* const pWaitReplyMessage,
                                               _In_ IWaitRoutine* const pWaiter);
 
 private:
+    struct Bucket
+    {
+        ConsoleWaitBlock* pHead;
+        ConsoleWaitBlock* pTail;
+    };
+
+    bool _NotifyBucket(const Bucket& bucket,
+                       const bool fNotifyAll,
+                       const WaitTerminationReason TerminationReason);
+
     bool _NotifyBlock(_In_ ConsoleWaitBlock* pWaitBlock,
                       const WaitTerminationReason TerminationReason);
 
-    std::list<ConsoleWaitBlock*> _blocks;
+    void _Link(_In_ ConsoleWaitBlock* const pWaitBlock) noexcept;
+    void _Unlink(_In_ ConsoleWaitBlock* const pWaitBlock) noexcept;
+
+    Bucket& _BucketFor(const ReplyDataType WaitType) noexcept;
+
+    Bucket _writeWaiters;
+    Bucket _readWaiters;
 
     friend class ConsoleWaitBlock; // Blocks live in multiple queues so we let them manage the lifetime.
 };
@@ -85,7 +85,8 @@ namespace Microsoft::Console::VirtualTerminal::DispatchTypes
         UTF8_EXTENDED_MODE = 1005,
         SGR_EXTENDED_MODE = 1006,
         ALTERNATE_SCROLL = 1007,
-        ASB_AlternateScreenBuffer = 1049
+        ASB_AlternateScreenBuffer = 1049,
+        SYNCHRONIZED_UPDATE = 2026
     };
 
     enum VTCharacterSets : wchar_t
@@ -118,6 +119,15 @@ namespace Microsoft::Console::VirtualTerminal::DispatchTypes
         SteadyBar = 6
     };
 
+    // The parts of a shell's prompt cycle that shell integration marks with OSC 133.
+    enum class ShellMarkType : unsigned int
+    {
+        PromptStart, // A
+        CommandStart, // B
+        CommandExecuted, // C
+        CommandFinished // D
+    };
+
     constexpr short s_sDECCOLMSetColumns = 132;
     constexpr short s_sDECCOLMResetColumns = 80;
 
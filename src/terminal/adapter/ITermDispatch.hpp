@@ -66,6 +66,7 @@ public:
     virtual bool EnableButtonEventMouseMode(const bool fEnabled) = 0; // ?1002
     virtual bool EnableAnyEventMouseMode(const bool fEnabled) = 0; // ?1003
     virtual bool EnableAlternateScroll(const bool fEnabled) = 0; // ?1007
+    virtual bool EnableSynchronizedUpdate(const bool fEnabled) = 0; // ?2026
     virtual bool SetColorTableEntry(const size_t tableIndex, const DWORD dwColor) = 0; // OSCColorTable
     virtual bool SetDefaultForeground(const DWORD dwColor) = 0; // OSCDefaultForeground
     virtual bool SetDefaultBackground(const DWORD dwColor) = 0; // OSCDefaultBackground
@@ -74,8 +75,7 @@ public:
     virtual bool EraseInLine(const DispatchTypes::EraseType eraseType) = 0; // EL
     virtual bool EraseCharacters(const unsigned int uiNumChars) = 0; // ECH
 
-    virtual bool SetGraphicsRendition(_In_reads_(cOptions) const DispatchTypes::GraphicsOptions* const rgOptions,
-                                      const size_t cOptions) = 0; // SGR
+    virtual bool SetGraphicsRendition(const gsl::span<const DispatchTypes::GraphicsOptions> options) = 0; // SGR
 
     virtual bool SetPrivateModes(_In_reads_(cParams) const DispatchTypes::PrivateModeParams* const rgParams,
                                  const size_t cParams) = 0; // DECSET
@@ -93,6 +93,7 @@ public:
 
     virtual bool SetCursorStyle(const DispatchTypes::CursorStyle cursorStyle) = 0; // DECSCUSR
     virtual bool SetCursorColor(const COLORREF Color) = 0; // OSCSetCursorColor, OSCResetCursorColor
+    virtual bool AddShellMark(const DispatchTypes::ShellMarkType markType) = 0; // OSCShellMark
 
     // DTTERM_WindowManipulation
     virtual bool WindowManipulation(const DispatchTypes::WindowManipulationType uiFunction,
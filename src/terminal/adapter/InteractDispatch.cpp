@@ -171,13 +171,13 @@ bool InteractDispatch::MoveCursor(const unsigned int row, const unsigned int col
     if (fSuccess)
     {
         // First retrieve some information about the buffer
-        CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-        csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
-        fSuccess = !!_pConApi->GetConsoleScreenBufferInfoEx(&csbiex);
+        COORD coordCursor = { 0 };
+        SMALL_RECT srViewport = { 0 };
+        fSuccess = !!(_pConApi->PrivateGetCursorPosition(&coordCursor) &&
+                      _pConApi->PrivateGetViewport(&srViewport));
 
         if (fSuccess)
         {
-            COORD coordCursor = csbiex.dwCursorPosition;
 
             // Safely convert the UINT positions we were given into shorts (which is the size the console deals with)
             fSuccess = SUCCEEDED(UIntToShort(uiRow, &coordCursor.Y)) &&
@@ -186,14 +186,14 @@ bool InteractDispatch::MoveCursor(const unsigned int row, const unsigned int col
             if (fSuccess)
             {
                 // Set the line and column values as offsets from the viewport edge. Use safe math to prevent overflow.
-                fSuccess = SUCCEEDED(ShortAdd(coordCursor.Y, csbiex.srWindow.Top, &coordCursor.Y)) &&
-                           SUCCEEDED(ShortAdd(coordCursor.X, csbiex.srWindow.Left, &coordCursor.X));
+                fSuccess = SUCCEEDED(ShortAdd(coordCursor.Y, srViewport.Top, &coordCursor.Y)) &&
+                           SUCCEEDED(ShortAdd(coordCursor.X, srViewport.Left, &coordCursor.X));
 
                 if (fSuccess)
                 {
                     // Apply boundary tests to ensure the cursor isn't outside the viewport rectangle.
-                    coordCursor.Y = std::clamp(coordCursor.Y, csbiex.srWindow.Top, gsl::narrow<SHORT>(csbiex.srWindow.Bottom - 1));
-                    coordCursor.X = std::clamp(coordCursor.X, csbiex.srWindow.Left, gsl::narrow<SHORT>(csbiex.srWindow.Right - 1));
+                    coordCursor.Y = std::clamp(coordCursor.Y, srViewport.Top, gsl::narrow<SHORT>(srViewport.Bottom - 1));
+                    coordCursor.X = std::clamp(coordCursor.X, srViewport.Left, gsl::narrow<SHORT>(srViewport.Right - 1));
 
                     // Finally, attempt to set the adjusted cursor position back into the console.
                     fSuccess = !!_pConApi->SetConsoleCursorPosition(coordCursor);
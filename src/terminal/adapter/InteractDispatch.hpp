@@ -20,7 +20,7 @@ Author(s):
 
 namespace Microsoft::Console::VirtualTerminal
 {
-    class InteractDispatch : public IInteractDispatch
+    class InteractDispatch final : public IInteractDispatch
     {
     public:
         InteractDispatch(ConGetSet* const pConApi);
@@ -26,11 +26,12 @@ using namespace Microsoft::Console::VirtualTerminal;
 #define CURSOR_DOWN_SEQUENCE (L"\x1b[B")
 #define CCH_CURSOR_SEQUENCES (3)
 
-MouseInput::MouseInput(const WriteInputEvents pfnWriteEvents) :
-    _pfnWriteEvents(pfnWriteEvents),
+MouseInput::MouseInput(const WriteInputText pfnWriteText) :
+    _pfnWriteText(pfnWriteText),
     _coordLastPos{ -1, -1 },
     _lastButton{ 0 }
 {
+    _sequence.reserve(s_cchMaxSequenceLength);
 }
 
 MouseInput::~MouseInput()
@@ -281,8 +282,6 @@ bool MouseInput::HandleMouse(const COORD coordMousePosition,
                        (fIsHover && _TrackingMode == TrackingMode::AnyEvent && !fSameCoord);
             if (fSuccess)
             {
-                wchar_t* pwchSequence = nullptr;
-                size_t cchSequenceLength = 0;
                 switch (_ExtendedMode)
                 {
                 case ExtendedMode::None:
@@ -291,8 +290,7 @@ bool MouseInput::HandleMouse(const COORD coordMousePosition,
                                                         fIsHover,
                                                         sModifierKeystate,
                                                         sWheelDelta,
-                                                        &pwchSequence,
-                                                        &cchSequenceLength);
+                                                        _sequence);
                     break;
                 case ExtendedMode::Utf8:
                     fSuccess = _GenerateUtf8Sequence(coordMousePosition,
@@ -300,8 +298,7 @@ bool MouseInput::HandleMouse(const COORD coordMousePosition,
                                                      fIsHover,
                                                      sModifierKeystate,
                                                      sWheelDelta,
-                                                     &pwchSequence,
-                                                     &cchSequenceLength);
+                                                     _sequence);
                     break;
                 case ExtendedMode::Sgr:
                     // For SGR encoding, if no physical buttons were pressed,
@@ -314,8 +311,7 @@ bool MouseInput::HandleMouse(const COORD coordMousePosition,
                                                     fIsHover,
                                                     sModifierKeystate,
                                                     sWheelDelta,
-                                                    &pwchSequence,
-                                                    &cchSequenceLength);
+                                                    _sequence);
                     break;
                 case ExtendedMode::Urxvt:
                 default:
@@ -324,9 +320,7 @@ bool MouseInput::HandleMouse(const COORD coordMousePosition,
                 }
                 if (fSuccess)
                 {
-                    _SendInputSequence(pwchSequence, cchSequenceLength);
-                    delete[] pwchSequence;
-                    fSuccess = true;
+                    _SendInputSequence(_sequence);
                 }
                 if (_TrackingMode == TrackingMode::ButtonEvent || _TrackingMode == TrackingMode::AnyEvent)
                 {
@@ -349,18 +343,15 @@ bool MouseInput::HandleMouse(const COORD coordMousePosition,
 // - fIsHover - true if the sequence is generated in response to a mouse hover
 // - sModifierKeystate - the modifier keys pressed with this button
 // - sWheelDelta - the amount that the scroll wheel changed (should be 0 unless uiButton is a WM_MOUSE*WHEEL)
-// - ppwchSequence - On success, where to put the pointer to the generated sequence
-// - pcchLength - On success, where to put the length of the generated sequence
+// - sequence - On success, receives the generated sequence
 // Return value:
 // - true if we were able to successfully generate a sequence.
-// On success, caller is responsible for delete[]ing *ppwchSequence.
 bool MouseInput::_GenerateDefaultSequence(const COORD coordMousePosition,
                                           const unsigned int uiButton,
                                           const bool fIsHover,
                                           const short sModifierKeystate,
                                           const short sWheelDelta,
-                                          _Outptr_result_buffer_(*pcchLength) wchar_t** const ppwchSequence,
-                                          _Out_ size_t* const pcchLength) const
+                                          std::wstring& sequence) const
 {
     bool fSuccess = false;
 
@@ -373,17 +364,11 @@ bool MouseInput::_GenerateDefaultSequence(const COORD coordMousePosition,
         const COORD coordVTCoords = s_WinToVTCoord(coordMousePosition);
         const short sEncodedX = s_EncodeDefaultCoordinate(coordVTCoords.X);
         const short sEncodedY = s_EncodeDefaultCoordinate(coordVTCoords.Y);
-        wchar_t* pwchFormat = new (std::nothrow) wchar_t[7]{ L"\x1b[Mbxy" };
-        if (pwchFormat != nullptr)
-        {
-            pwchFormat[3] = ' ' + (short)s_WindowsButtonToXEncoding(uiButton, fIsHover, sModifierKeystate, sWheelDelta);
-            pwchFormat[4] = sEncodedX;
-            pwchFormat[5] = sEncodedY;
-
-            *ppwchSequence = pwchFormat;
-            *pcchLength = 7;
-            fSuccess = true;
-        }
+        sequence.assign(L"\x1b[Mbxy");
+        sequence[3] = ' ' + (short)s_WindowsButtonToXEncoding(uiButton, fIsHover, sModifierKeystate, sWheelDelta);
+        sequence[4] = sEncodedX;
+        sequence[5] = sEncodedY;
+        fSuccess = true;
     }
 
     return fSuccess;
@@ -398,18 +383,15 @@ bool MouseInput::_GenerateDefaultSequence(const COORD coordMousePosition,
 // - fIsHover - true if the sequence is generated in response to a mouse hover
 // - sModifierKeystate - the modifier keys pressed with this button
 // - sWheelDelta - the amount that the scroll wheel changed (should be 0 unless uiButton is a WM_MOUSE*WHEEL)
-// - ppwchSequence - On success, where to put the pointer to the generated sequence
-// - pcchLength - On success, where to put the length of the generated sequence
+// - sequence - On success, receives the generated sequence
 // Return value:
 // - true if we were able to successfully generate a sequence.
-// On success, caller is responsible for delete[]ing *ppwchSequence.
 bool MouseInput::_GenerateUtf8Sequence(const COORD coordMousePosition,
                                        const unsigned int uiButton,
                                        const bool fIsHover,
                                        const short sModifierKeystate,
                                        const short sWheelDelta,
-                                       _Outptr_result_buffer_(*pcchLength) wchar_t** const ppwchSequence,
-                                       _Out_ size_t* const pcchLength) const
+                                       std::wstring& sequence) const
 {
     bool fSuccess = false;
 
@@ -432,18 +414,12 @@ bool MouseInput::_GenerateUtf8Sequence(const COORD coordMousePosition,
         const COORD coordVTCoords = s_WinToVTCoord(coordMousePosition);
         const short sEncodedX = s_EncodeDefaultCoordinate(coordVTCoords.X);
         const short sEncodedY = s_EncodeDefaultCoordinate(coordVTCoords.Y);
-        wchar_t* pwchFormat = new (std::nothrow) wchar_t[7]{ L"\x1b[Mbxy" };
-        if (pwchFormat != nullptr)
-        {
-            // The short cast is safe because we know s_WindowsButtonToXEncoding  never returns more than xff
-            pwchFormat[3] = ' ' + (short)s_WindowsButtonToXEncoding(uiButton, fIsHover, sModifierKeystate, sWheelDelta);
-            pwchFormat[4] = sEncodedX;
-            pwchFormat[5] = sEncodedY;
-
-            *ppwchSequence = pwchFormat;
-            *pcchLength = 7;
-            fSuccess = true;
-        }
+        sequence.assign(L"\x1b[Mbxy");
+        // The short cast is safe because we know s_WindowsButtonToXEncoding  never returns more than xff
+        sequence[3] = ' ' + (short)s_WindowsButtonToXEncoding(uiButton, fIsHover, sModifierKeystate, sWheelDelta);
+        sequence[4] = sEncodedX;
+        sequence[5] = sEncodedY;
+        fSuccess = true;
     }
 
     return fSuccess;
@@ -459,57 +435,34 @@ bool MouseInput::_GenerateUtf8Sequence(const COORD coordMousePosition,
 // - fIsHover - true if the sequence is generated in response to a mouse hover
 // - sModifierKeystate - the modifier keys pressed with this button
 // - sWheelDelta - the amount that the scroll wheel changed (should be 0 unless uiButton is a WM_MOUSE*WHEEL)
-// - ppwchSequence - On success, where to put the pointer to the generated sequence
-// - pcchLength - On success, where to put the length of the generated sequence
+// - sequence - On success, receives the generated sequence
 // Return value:
 // - true if we were able to successfully generate a sequence.
-// On success, caller is responsible for delete[]ing *ppwchSequence.
 bool MouseInput::_GenerateSGRSequence(const COORD coordMousePosition,
                                       const unsigned int uiButton,
                                       const bool isDown,
                                       const bool fIsHover,
                                       const short sModifierKeystate,
                                       const short sWheelDelta,
-                                      _Outptr_result_buffer_(*pcchLength) wchar_t** const ppwchSequence,
-                                      _Out_ size_t* const pcchLength) const
+                                      std::wstring& sequence) const
 {
     // Format for SGR events is:
     // "\x1b[<%d;%d;%d;%c", xButton, x+1, y+1, fButtonDown? 'M' : 'm'
-    bool fSuccess = false;
     const int iXButton = s_WindowsButtonToSGREncoding(uiButton, fIsHover, sModifierKeystate, sWheelDelta);
 
-#pragma warning(push)
-#pragma warning(disable : 4996)
-// Disable 4996 - The _s version of _snprintf doesn't return the cch if the buffer is null, and we need the cch
-#pragma prefast(suppress : 28719, "Using the output of _snwprintf to determine cch. _snwprintf_s used below.")
-    int iNeededChars = _snwprintf(nullptr, 0, L"\x1b[<%d;%d;%d%c", iXButton, coordMousePosition.X + 1, coordMousePosition.Y + 1, isDown ? L'M' : L'm');
-
-#pragma warning(pop)
-
-    iNeededChars += 1; // for null
-
-    wchar_t* pwchFormat = new (std::nothrow) wchar_t[iNeededChars];
-    if (pwchFormat != nullptr)
-    {
-        int iTakenChars = _snwprintf_s(pwchFormat,
-                                       iNeededChars,
-                                       iNeededChars,
-                                       L"\x1b[<%d;%d;%d%c",
-                                       iXButton,
-                                       coordMousePosition.X + 1,
-                                       coordMousePosition.Y + 1,
-                                       isDown ? L'M' : L'm');
-        if (iTakenChars == iNeededChars - 1) // again, adjust for null
-        {
-            *ppwchSequence = pwchFormat;
-            *pcchLength = iTakenChars;
-            fSuccess = true;
-        }
-        else
-        {
-            delete[] pwchFormat;
-        }
-    }
+    // The sequence is formatted straight into its buffer, which already has room for the longest one.
+    sequence.resize(s_cchMaxSequenceLength);
+    const int iTakenChars = _snwprintf_s(sequence.data(),
+                                         sequence.size() + 1,
+                                         _TRUNCATE,
+                                         L"\x1b[<%d;%d;%d%c",
+                                         iXButton,
+                                         coordMousePosition.X + 1,
+                                         coordMousePosition.Y + 1,
+                                         isDown ? L'M' : L'm');
+
+    const bool fSuccess = iTakenChars > 0;
+    sequence.resize(fSuccess ? iTakenChars : 0);
     return fSuccess;
 }
 
@@ -588,29 +541,19 @@ void MouseInput::EnableAnyEventTracking(const bool fEnable)
 }
 
 // Routine Description:
-// - Sends the given sequence into the input callback specified by _pfnWriteEvents.
+// - Sends the given sequence into the input callback specified by _pfnWriteText, all at once.
 //      Typically, this inserts the characters into the input buffer as KeyDown KEY_EVENTs.
 // Parameters:
-// - pwszSequence - sequence to send to _pfnWriteEvents
-// - cchLength - the length of pwszSequence
+// - sequence - sequence to send to _pfnWriteText
 // Return value:
 // <none>
-void MouseInput::_SendInputSequence(_In_reads_(cchLength) const wchar_t* const pwszSequence,
-                                    const size_t cchLength) const
+void MouseInput::_SendInputSequence(const std::wstring_view sequence) const
 {
-    size_t cch = 0;
-    // + 1 to max sequence length for null terminator count which is required by StringCchLengthW
-    if (SUCCEEDED(StringCchLengthW(pwszSequence, cchLength + 1, &cch)) && cch > 0 && cch < DWORD_MAX)
+    if (!sequence.empty())
     {
-        std::deque<std::unique_ptr<IInputEvent>> events;
         try
         {
-            for (size_t i = 0; i < cch; ++i)
-            {
-                events.push_back(std::make_unique<KeyEvent>(true, 1ui16, 0ui16, 0ui16, pwszSequence[i], 0));
-            }
-
-            _pfnWriteEvents(events);
+            _pfnWriteText(sequence);
         }
         catch (...)
         {
@@ -725,7 +668,7 @@ bool MouseInput::_ShouldSendAlternateScroll(_In_ unsigned int uiButton, _In_ sho
 bool MouseInput::_SendAlternateScroll(_In_ short sScrollDelta) const
 {
     const wchar_t* const pwchSequence = sScrollDelta > 0 ? CURSOR_UP_SEQUENCE : CURSOR_DOWN_SEQUENCE;
-    _SendInputSequence(pwchSequence, CCH_CURSOR_SEQUENCES);
+    _SendInputSequence({ pwchSequence, CCH_CURSOR_SEQUENCES });
 
     return true;
 }
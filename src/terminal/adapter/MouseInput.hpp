@@ -16,17 +16,18 @@ Author(s):
 
 #include "../../types/inc/IInputEvent.hpp"
 
-#include <deque>
-#include <memory>
+#include <string>
+#include <string_view>
 
 namespace Microsoft::Console::VirtualTerminal
 {
-    typedef void (*WriteInputEvents)(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& events);
+    // Receives a whole mouse sequence at once, to be written to the input as text.
+    typedef void (*WriteInputText)(const std::wstring_view text);
 
     class MouseInput sealed
     {
     public:
-        MouseInput(const WriteInputEvents pfnWriteEvents);
+        MouseInput(const WriteInputText pfnWriteText);
         ~MouseInput();
 
         bool HandleMouse(const COORD coordMousePosition,
@@ -64,7 +65,13 @@ namespace Microsoft::Console::VirtualTerminal
     private:
         static const int s_MaxDefaultCoordinate = 94;
 
-        WriteInputEvents _pfnWriteEvents;
+        // Long enough for the longest SGR sequence, "\x1b[<bbb;-xxxxx;-yyyyyM".
+        static const size_t s_cchMaxSequenceLength = 32;
+
+        WriteInputText _pfnWriteText;
+
+        // Every sequence is formatted into this, so that sending one doesn't allocate.
+        std::wstring _sequence;
 
         ExtendedMode _ExtendedMode = ExtendedMode::None;
         TrackingMode _TrackingMode = TrackingMode::None;
@@ -75,29 +82,26 @@ namespace Microsoft::Console::VirtualTerminal
         COORD _coordLastPos;
         unsigned int _lastButton;
 
-        void _SendInputSequence(_In_reads_(cchLength) const wchar_t* const pwszSequence, const size_t cchLength) const;
+        void _SendInputSequence(const std::wstring_view sequence) const;
         bool _GenerateDefaultSequence(const COORD coordMousePosition,
                                       const unsigned int uiButton,
                                       const bool fIsHover,
                                       const short sModifierKeystate,
                                       const short sWheelDelta,
-                                      _Outptr_result_buffer_(*pcchLength) wchar_t** const ppwchSequence,
-                                      _Out_ size_t* const pcchLength) const;
+                                      std::wstring& sequence) const;
         bool _GenerateUtf8Sequence(const COORD coordMousePosition,
                                    const unsigned int uiButton,
                                    const bool fIsHover,
                                    const short sModifierKeystate,
                                    const short sWheelDelta,
-                                   _Outptr_result_buffer_(*pcchLength) wchar_t** const ppwchSequence,
-                                   _Out_ size_t* const pcchLength) const;
+                                   std::wstring& sequence) const;
         bool _GenerateSGRSequence(const COORD coordMousePosition,
                                   const unsigned int uiButton,
                                   const bool isDown,
                                   const bool fIsHover,
                                   const short sModifierKeystate,
                                   const short sWheelDelta,
-                                  _Outptr_result_buffer_(*pcchLength) wchar_t** const ppwchSequence,
-                                  _Out_ size_t* const pcchLength) const;
+                                  std::wstring& sequence) const;
 
         bool _ShouldSendAlternateScroll(_In_ unsigned int uiButton, _In_ short sScrollDelta) const;
         bool _SendAlternateScroll(_In_ short sScrollDelta) const;
@@ -89,22 +89,22 @@ void AdaptDispatch::PrintString(const wchar_t* const rgwch, const size_t cch)
 bool AdaptDispatch::_CursorMovement(const CursorDirection dir, _In_ unsigned int const uiDistance) const
 {
     // First retrieve some information about the buffer
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+    COORD coordCursor = { 0 };
+    SMALL_RECT srViewport = { 0 };
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool fSuccess = !!(_conApi->MoveToBottom() && _conApi->GetConsoleScreenBufferInfoEx(&csbiex));
+    bool fSuccess = !!(_conApi->MoveToBottom() &&
+                       _conApi->PrivateGetCursorPosition(&coordCursor) &&
+                       _conApi->PrivateGetViewport(&srViewport));
 
     if (fSuccess)
     {
-        COORD coordCursor = csbiex.dwCursorPosition;
-
         // For next/previous line, we unconditionally need to move the X position to the left edge of the viewport.
         switch (dir)
         {
         case CursorDirection::NextLine:
         case CursorDirection::PrevLine:
-            coordCursor.X = csbiex.srWindow.Left;
+            coordCursor.X = srViewport.Left;
             break;
         }
 
@@ -141,17 +141,17 @@ bool AdaptDispatch::_CursorMovement(const CursorDirection dir, _In_ unsigned int
             {
             case CursorDirection::Up:
             case CursorDirection::PrevLine:
-                sBoundaryVal = csbiex.srWindow.Top;
+                sBoundaryVal = srViewport.Top;
                 break;
             case CursorDirection::Down:
             case CursorDirection::NextLine:
-                sBoundaryVal = csbiex.srWindow.Bottom;
+                sBoundaryVal = srViewport.Bottom;
                 break;
             case CursorDirection::Left:
-                sBoundaryVal = csbiex.srWindow.Left;
+                sBoundaryVal = srViewport.Left;
                 break;
             case CursorDirection::Right:
-                sBoundaryVal = csbiex.srWindow.Right;
+                sBoundaryVal = srViewport.Right;
                 break;
             default:
                 fSuccess = false;
@@ -311,11 +311,13 @@ bool AdaptDispatch::_CursorMovePosition(_In_opt_ const unsigned int* const puiRo
     bool fSuccess = true;
 
     // First retrieve some information about the buffer
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+    COORD coordCursorPosition = { 0 };
+    SMALL_RECT srViewport = { 0 };
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    fSuccess = !!(_conApi->MoveToBottom() && _conApi->GetConsoleScreenBufferInfoEx(&csbiex));
+    fSuccess = !!(_conApi->MoveToBottom() &&
+                  _conApi->PrivateGetCursorPosition(&coordCursorPosition) &&
+                  _conApi->PrivateGetViewport(&srViewport));
 
     if (fSuccess)
     {
@@ -344,7 +346,7 @@ bool AdaptDispatch::_CursorMovePosition(_In_opt_ const unsigned int* const puiRo
         }
         else
         {
-            uiRow = csbiex.dwCursorPosition.Y - csbiex.srWindow.Top; // remember, in VT speak, this is relative to the viewport. not absolute.
+            uiRow = coordCursorPosition.Y - srViewport.Top; // remember, in VT speak, this is relative to the viewport. not absolute.
         }
 
         if (puiCol != nullptr)
@@ -360,12 +362,12 @@ bool AdaptDispatch::_CursorMovePosition(_In_opt_ const unsigned int* const puiRo
         }
         else
         {
-            uiCol = csbiex.dwCursorPosition.X - csbiex.srWindow.Left; // remember, in VT speak, this is relative to the viewport. not absolute.
+            uiCol = coordCursorPosition.X - srViewport.Left; // remember, in VT speak, this is relative to the viewport. not absolute.
         }
 
         if (fSuccess)
         {
-            COORD coordCursor = csbiex.dwCursorPosition;
+            COORD coordCursor = coordCursorPosition;
 
             // Safely convert the UINT positions we were given into shorts (which is the size the console deals with)
             fSuccess = SUCCEEDED(UIntToShort(uiRow, &coordCursor.Y)) && SUCCEEDED(UIntToShort(uiCol, &coordCursor.X));
@@ -373,14 +375,14 @@ bool AdaptDispatch::_CursorMovePosition(_In_opt_ const unsigned int* const puiRo
             if (fSuccess)
             {
                 // Set the line and column values as offsets from the viewport edge. Use safe math to prevent overflow.
-                fSuccess = SUCCEEDED(ShortAdd(coordCursor.Y, csbiex.srWindow.Top, &coordCursor.Y)) &&
-                           SUCCEEDED(ShortAdd(coordCursor.X, csbiex.srWindow.Left, &coordCursor.X));
+                fSuccess = SUCCEEDED(ShortAdd(coordCursor.Y, srViewport.Top, &coordCursor.Y)) &&
+                           SUCCEEDED(ShortAdd(coordCursor.X, srViewport.Left, &coordCursor.X));
 
                 if (fSuccess)
                 {
                     // Apply boundary tests to ensure the cursor isn't outside the viewport rectangle.
-                    coordCursor.Y = std::clamp(coordCursor.Y, csbiex.srWindow.Top, gsl::narrow<SHORT>(csbiex.srWindow.Bottom - 1));
-                    coordCursor.X = std::clamp(coordCursor.X, csbiex.srWindow.Left, gsl::narrow<SHORT>(csbiex.srWindow.Right - 1));
+                    coordCursor.Y = std::clamp(coordCursor.Y, srViewport.Top, gsl::narrow<SHORT>(srViewport.Bottom - 1));
+                    coordCursor.X = std::clamp(coordCursor.X, srViewport.Left, gsl::narrow<SHORT>(srViewport.Right - 1));
 
                     // Finally, attempt to set the adjusted cursor position back into the console.
                     fSuccess = !!_conApi->SetConsoleCursorPosition(coordCursor);
@@ -435,20 +437,18 @@ bool AdaptDispatch::CursorPosition(_In_ unsigned int const uiLine, _In_ unsigned
 bool AdaptDispatch::CursorSavePosition()
 {
     // First retrieve some information about the buffer
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+    COORD coordCursor = { 0 };
+    SMALL_RECT srViewport = { 0 };
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool fSuccess = !!(_conApi->MoveToBottom() && _conApi->GetConsoleScreenBufferInfoEx(&csbiex));
+    bool fSuccess = !!(_conApi->MoveToBottom() &&
+                       _conApi->PrivateGetCursorPosition(&coordCursor) &&
+                       _conApi->PrivateGetViewport(&srViewport));
 
     if (fSuccess)
     {
         // The cursor is given to us by the API as relative to the whole buffer.
         // But in VT speak, the cursor should be relative to the current viewport. Adjust.
-        COORD const coordCursor = csbiex.dwCursorPosition;
-
-        SMALL_RECT const srViewport = csbiex.srWindow;
-
         // VT is also 1 based, not 0 based, so correct by 1.
         _coordSavedCursor.X = coordCursor.X - srViewport.Left + 1;
         _coordSavedCursor.Y = coordCursor.Y - srViewport.Top + 1;
@@ -661,40 +661,39 @@ bool AdaptDispatch::_EraseSingleLineDistanceHelper(const COORD coordStartPositio
 {
     WCHAR const wchSpace = static_cast<WCHAR>(0x20); // space character. use 0x20 instead of literal space because we can't assume the compiler will always turn ' ' into 0x20.
 
-    size_t written = 0;
-    bool fSuccess = !!_conApi->FillConsoleOutputCharacterW(wchSpace, dwLength, coordStartPosition, written);
-
-    if (fSuccess)
-    {
-        fSuccess = !!_conApi->FillConsoleOutputAttribute(wFillColor, dwLength, coordStartPosition, written);
-    }
+    // The erase never goes past the end of the line, so it's a rectangle one row high.
+    SMALL_RECT srFill;
+    srFill.Left = coordStartPosition.X;
+    srFill.Top = coordStartPosition.Y;
+    srFill.Right = gsl::narrow<SHORT>(coordStartPosition.X + static_cast<int>(dwLength) - 1);
+    srFill.Bottom = coordStartPosition.Y;
 
-    return fSuccess;
+    return !!_conApi->PrivateFillRect(&srFill, wchSpace, wFillColor);
 }
 
-bool AdaptDispatch::_EraseAreaHelper(const COORD coordStartPosition, const COORD coordLastPosition, const WORD wFillColor)
+// Routine Description:
+// - Internal helper to erase a rectangular area of the buffer in one operation.
+//     Erased positions are replaced with spaces.
+// Arguments:
+// - coordStartPosition - The top left corner of the area to erase.
+// - coordLastPosition - The bottom right corner of the area to erase, exclusive.
+// - wFillColor - The attributes to apply to the erased positions.
+// Return Value:
+// - True if handled successfully. False otherwise.
+bool AdaptDispatch::_EraseAreaHelper(const COORD coordStartPosition, const COORD coordLastPosition, const WORD wFillColor) const
 {
     WCHAR const wchSpace = static_cast<WCHAR>(0x20); // space character. use 0x20 instead of literal space because we can't assume the compiler will always turn ' ' into 0x20.
 
-    size_t written = 0;
     FAIL_FAST_IF(!(coordStartPosition.X < coordLastPosition.X));
     FAIL_FAST_IF(!(coordStartPosition.Y < coordLastPosition.Y));
-    bool fSuccess = false;
-    for (short y = coordStartPosition.Y; y < coordLastPosition.Y; y++)
-    {
-        const COORD coordLine = { coordStartPosition.X, y };
-        fSuccess = !!_conApi->FillConsoleOutputCharacterW(wchSpace, coordLastPosition.X - coordStartPosition.X, coordLine, written);
-        if (fSuccess)
-        {
-            fSuccess = !!_conApi->FillConsoleOutputAttribute(wFillColor, coordLastPosition.X - coordStartPosition.X, coordLine, written);
-        }
 
-        if (!fSuccess)
-        {
-            break;
-        }
-    }
-    return fSuccess;
+    SMALL_RECT srFill;
+    srFill.Left = coordStartPosition.X;
+    srFill.Top = coordStartPosition.Y;
+    srFill.Right = coordLastPosition.X - 1;
+    srFill.Bottom = coordLastPosition.Y - 1;
+
+    return !!_conApi->PrivateFillRect(&srFill, wchSpace, wFillColor);
 }
 
 // Routine Description:
@@ -820,14 +819,12 @@ bool AdaptDispatch::EraseInDisplay(const DispatchTypes::EraseType eraseType)
         if (eraseType == DispatchTypes::EraseType::FromBeginning)
         {
             // For beginning and all, erase all complete lines before (above vertically) from the cursor position.
-            for (SHORT sStartLine = csbiex.srWindow.Top; sStartLine < csbiex.dwCursorPosition.Y; sStartLine++)
+            // They're erased together as one rectangle.
+            if (csbiex.dwCursorPosition.Y > csbiex.srWindow.Top)
             {
-                fSuccess = _EraseSingleLineHelper(&csbiex, DispatchTypes::EraseType::All, sStartLine, csbiex.wAttributes);
-
-                if (!fSuccess)
-                {
-                    break;
-                }
+                const COORD coordStartPosition = { csbiex.srWindow.Left, csbiex.srWindow.Top };
+                const COORD coordLastPosition = { csbiex.srWindow.Right, csbiex.dwCursorPosition.Y };
+                fSuccess = _EraseAreaHelper(coordStartPosition, coordLastPosition, csbiex.wAttributes);
             }
         }
 
@@ -844,14 +841,13 @@ bool AdaptDispatch::EraseInDisplay(const DispatchTypes::EraseType eraseType)
             {
                 // For beginning and all, erase all complete lines after (below vertically) the cursor position.
                 // Remember that the viewport bottom value is 1 beyond the viewable area of the viewport.
-                for (SHORT sStartLine = csbiex.dwCursorPosition.Y + 1; sStartLine < csbiex.srWindow.Bottom; sStartLine++)
+                // They're erased together as one rectangle.
+                const SHORT sFirstLineAfter = gsl::narrow<SHORT>(csbiex.dwCursorPosition.Y + 1);
+                if (sFirstLineAfter < csbiex.srWindow.Bottom)
                 {
-                    fSuccess = _EraseSingleLineHelper(&csbiex, DispatchTypes::EraseType::All, sStartLine, csbiex.wAttributes);
-
-                    if (!fSuccess)
-                    {
-                        break;
-                    }
+                    const COORD coordStartPosition = { csbiex.srWindow.Left, sFirstLineAfter };
+                    const COORD coordLastPosition = { csbiex.srWindow.Right, csbiex.srWindow.Bottom };
+                    fSuccess = _EraseAreaHelper(coordStartPosition, coordLastPosition, csbiex.wAttributes);
                 }
             }
         }
@@ -924,20 +920,19 @@ bool AdaptDispatch::DeviceAttributes()
 // - True if handled successfully. False otherwise.
 bool AdaptDispatch::_CursorPositionReport() const
 {
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+    COORD coordCursorPos = { 0 };
+    SMALL_RECT srViewport = { 0 };
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool fSuccess = !!(_conApi->MoveToBottom() && _conApi->GetConsoleScreenBufferInfoEx(&csbiex));
+    bool fSuccess = !!(_conApi->MoveToBottom() &&
+                       _conApi->PrivateGetCursorPosition(&coordCursorPos) &&
+                       _conApi->PrivateGetViewport(&srViewport));
 
     if (fSuccess)
     {
-        // First pull the cursor position relative to the entire buffer out of the console.
-        COORD coordCursorPos = csbiex.dwCursorPosition;
-
-        // Now adjust it for its position in respect to the current viewport.
-        coordCursorPos.X -= csbiex.srWindow.Left;
-        coordCursorPos.Y -= csbiex.srWindow.Top;
+        // The cursor position is relative to the entire buffer. Adjust it for its position in respect to the current viewport.
+        coordCursorPos.X -= srViewport.Left;
+        coordCursorPos.Y -= srViewport.Top;
 
         // NOTE: 1,1 is the top-left corner of the viewport in VT-speak, so add 1.
         coordCursorPos.X++;
@@ -1175,6 +1170,9 @@ bool AdaptDispatch::_PrivateModeParamsHelper(_In_ DispatchTypes::PrivateModePara
     case DispatchTypes::PrivateModeParams::ASB_AlternateScreenBuffer:
         fSuccess = fEnable ? UseAlternateScreenBuffer() : UseMainScreenBuffer();
         break;
+    case DispatchTypes::PrivateModeParams::SYNCHRONIZED_UPDATE:
+        fSuccess = EnableSynchronizedUpdate(fEnable);
+        break;
     default:
         // If no functions to call, overall dispatch was a failure.
         fSuccess = false;
@@ -1316,11 +1314,10 @@ bool AdaptDispatch::SetOriginMode(const bool fRelativeMode)
 bool AdaptDispatch::_DoSetTopBottomScrollingMargins(const SHORT sTopMargin,
                                                     const SHORT sBottomMargin)
 {
-    CONSOLE_SCREEN_BUFFER_INFOEX csbiex = { 0 };
-    csbiex.cbSize = sizeof(CONSOLE_SCREEN_BUFFER_INFOEX);
+    SMALL_RECT srViewport = { 0 };
     // Make sure to reset the viewport (with MoveToBottom )to where it was
     //      before the user scrolled the console output
-    bool fSuccess = !!(_conApi->MoveToBottom() && _conApi->GetConsoleScreenBufferInfoEx(&csbiex));
+    bool fSuccess = !!(_conApi->MoveToBottom() && _conApi->PrivateGetViewport(&srViewport));
 
     // so notes time: (input -> state machine out -> adapter out -> conhost internal)
     // having only a top param is legal         ([3;r   -> 3,0   -> 3,h  -> 3,h,true)
@@ -1331,7 +1328,7 @@ bool AdaptDispatch::_DoSetTopBottomScrollingMargins(const SHORT sTopMargin,
     {
         SHORT sActualTop = sTopMargin;
         SHORT sActualBottom = sBottomMargin;
-        SHORT sScreenHeight = csbiex.srWindow.Bottom - csbiex.srWindow.Top;
+        SHORT sScreenHeight = srViewport.Bottom - srViewport.Top;
         // The default top margin is line 1
         if (sActualTop == 0)
         {
@@ -1568,7 +1565,7 @@ bool AdaptDispatch::SoftReset()
     if (fSuccess)
     {
         DispatchTypes::GraphicsOptions opt = DispatchTypes::GraphicsOptions::Off;
-        fSuccess = SetGraphicsRendition(&opt, 1); // Normal rendition.
+        fSuccess = SetGraphicsRendition(gsl::make_span(&opt, 1)); // Normal rendition.
     }
     if (fSuccess)
     {
@@ -1672,10 +1669,11 @@ bool AdaptDispatch::_EraseScrollback()
             // B. to the right of the viewport.
 
             // First clear section A
-            const DWORD dwTotalAreaBelow = csbiex.dwSize.X * (csbiex.dwSize.Y - sHeight);
             const COORD coordBelowStartPosition = { 0, sHeight };
-            // We don't use the _EraseAreaHelper here because _EraseSingleLineDistanceHelper does it all in one operation
-            fSuccess = _EraseSingleLineDistanceHelper(coordBelowStartPosition, dwTotalAreaBelow, csbiex.wAttributes);
+            if (csbiex.dwSize.Y > coordBelowStartPosition.Y)
+            {
+                fSuccess = _EraseAreaHelper(coordBelowStartPosition, csbiex.dwSize, csbiex.wAttributes);
+            }
 
             if (fSuccess)
             {
@@ -1811,6 +1809,19 @@ bool AdaptDispatch::EnableAlternateScroll(const bool fEnabled)
     return !!_conApi->PrivateEnableAlternateScroll(fEnabled);
 }
 
+//Routine Description:
+// Enable Synchronized Update - While enabled, the renderer holds back frames
+//      so that everything the app draws in the meantime shows up at once.
+//      Disabling it paints the result.
+//Arguments:
+// - fEnabled - true to begin the update, false to end it.
+// Return value:
+// True if handled successfully. False otherwise.
+bool AdaptDispatch::EnableSynchronizedUpdate(const bool fEnabled)
+{
+    return !!_conApi->PrivateEnableSynchronizedUpdate(fEnabled);
+}
+
 //Routine Description:
 // Set Cursor Style - Changes the cursor's style to match the given Dispatch
 //      cursor style. Unix styles are a combination of the shape and the blinking state.
@@ -1889,6 +1900,19 @@ bool AdaptDispatch::SetCursorColor(const COLORREF cursorColor)
     return !!_conApi->SetCursorColor(cursorColor);
 }
 
+// Method Description:
+// - Marks where part of a shell's prompt cycle begins. Nothing in the console
+//   navigates by these marks, so they're left for the terminal on the other
+//   end of a pty: not handling the sequence passes it through to it.
+// Arguments:
+// - markType: which part of the cycle begins at the cursor
+// Return Value:
+// - false, always
+bool AdaptDispatch::AddShellMark(const DispatchTypes::ShellMarkType /*markType*/)
+{
+    return false;
+}
+
 // Method Description:
 // - Sets a single entry of the colortable to a new value
 // Arguments:
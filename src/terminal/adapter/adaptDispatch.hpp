@@ -25,7 +25,7 @@ Author(s):
 
 namespace Microsoft::Console::VirtualTerminal
 {
-    class AdaptDispatch : public ITermDispatch
+    class AdaptDispatch final : public ITermDispatch
     {
     public:
         AdaptDispatch(ConGetSet* const pConApi,
@@ -56,8 +56,7 @@ namespace Microsoft::Console::VirtualTerminal
         bool EraseCharacters(_In_ unsigned int const uiNumChars) override; // ECH
         bool InsertCharacter(_In_ unsigned int const uiCount) override; // ICH
         bool DeleteCharacter(_In_ unsigned int const uiCount) override; // DCH
-        bool SetGraphicsRendition(_In_reads_(cOptions) const DispatchTypes::GraphicsOptions* const rgOptions,
-                                  const size_t cOptions) override; // SGR
+        bool SetGraphicsRendition(const gsl::span<const DispatchTypes::GraphicsOptions> options) override; // SGR
         bool DeviceStatusReport(const DispatchTypes::AnsiStatusType statusType) override; // DSR
         bool DeviceAttributes() override; // DA
         bool ScrollUp(_In_ unsigned int const uiDistance) override; // SU
@@ -93,8 +92,10 @@ namespace Microsoft::Console::VirtualTerminal
         bool EnableButtonEventMouseMode(const bool fEnabled) override; // ?1002
         bool EnableAnyEventMouseMode(const bool fEnabled) override; // ?1003
         bool EnableAlternateScroll(const bool fEnabled) override; // ?1007
+        bool EnableSynchronizedUpdate(const bool fEnabled) override; // ?2026
         bool SetCursorStyle(const DispatchTypes::CursorStyle cursorStyle) override; // DECSCUSR
         bool SetCursorColor(const COLORREF cursorColor) override;
+        bool AddShellMark(const DispatchTypes::ShellMarkType markType) override; // OSCShellMark
 
         bool SetColorTableEntry(const size_t tableIndex,
                                 const DWORD dwColor) override; // OscColorTable
@@ -125,7 +126,7 @@ namespace Microsoft::Console::VirtualTerminal
         bool _CursorMovePosition(_In_opt_ const unsigned int* const puiRow, _In_opt_ const unsigned int* const puiCol) const;
         bool _EraseSingleLineHelper(const CONSOLE_SCREEN_BUFFER_INFOEX* const pcsbiex, const DispatchTypes::EraseType eraseType, const SHORT sLineId, const WORD wFillColor) const;
         void _SetGraphicsOptionHelper(const DispatchTypes::GraphicsOptions opt, _Inout_ WORD* const pAttr);
-        bool _EraseAreaHelper(const COORD coordStartPosition, const COORD coordLastPosition, const WORD wFillColor);
+        bool _EraseAreaHelper(const COORD coordStartPosition, const COORD coordLastPosition, const WORD wFillColor) const;
         bool _EraseSingleLineDistanceHelper(const COORD coordStartPosition, const DWORD dwLength, const WORD wFillColor) const;
         bool _EraseScrollback();
         bool _EraseAll();
@@ -170,6 +171,7 @@ namespace Microsoft::Console::VirtualTerminal
 
         bool _SetBoldColorHelper(const DispatchTypes::GraphicsOptions option);
         bool _SetDefaultColorHelper(const DispatchTypes::GraphicsOptions option);
+        bool _CommitLegacyAttributes(const WORD attr);
 
         static bool s_IsXtermColorOption(const DispatchTypes::GraphicsOptions opt);
         static bool s_IsRgbColorOption(const DispatchTypes::GraphicsOptions opt);
@@ -385,15 +385,32 @@ bool AdaptDispatch::_SetDefaultColorHelper(const DispatchTypes::GraphicsOptions
     return success;
 }
 
+// Routine Description:
+// - Writes the legacy attributes that the graphics options have changed so far back to the buffer,
+//   in a single call no matter how many options went into them.
+// Arguments:
+// - attr - The attributes with every pending option applied.
+// Return Value:
+// - True if handled successfully. False otherwise.
+bool AdaptDispatch::_CommitLegacyAttributes(const WORD attr)
+{
+    const bool fSuccess = !!_conApi->PrivateSetLegacyAttributes(attr, _fChangedForeground, _fChangedBackground, _fChangedMetaAttrs);
+
+    _fChangedForeground = false;
+    _fChangedBackground = false;
+    _fChangedMetaAttrs = false;
+
+    return fSuccess;
+}
+
 // Routine Description:
 // - SGR - Modifies the graphical rendering options applied to the next characters written into the buffer.
 //       - Options include colors, invert, underlines, and other "font style" type options.
 // Arguments:
-// - rgOptions - An array of options that will be applied from 0 to N, in order, one at a time by setting or removing flags in the font style properties.
-// - cOptions - The count of options (a.k.a. the N in the above line of comments)
+// - options - The options that will be applied in order, one at a time by setting or removing flags in the font style properties.
 // Return Value:
 // - True if handled successfully. False otherwise.
-bool AdaptDispatch::SetGraphicsRendition(_In_reads_(cOptions) const DispatchTypes::GraphicsOptions* const rgOptions, const size_t cOptions)
+bool AdaptDispatch::SetGraphicsRendition(const gsl::span<const DispatchTypes::GraphicsOptions> options)
 {
     // We use the private function here to get just the default color attributes as a performance optimization.
     // Calling the public GetConsoleScreenBufferInfoEx costs a lot of performance time/power in a tight loop
@@ -404,17 +421,38 @@ bool AdaptDispatch::SetGraphicsRendition(_In_reads_(cOptions) const DispatchType
 
     if (fSuccess)
     {
+        // Options that only change the legacy attributes are gathered up and written
+        //      back together, rather than making a round trip to the buffer for each one.
+        //      Anything else has to see the changes made before it, so they're written
+        //      back first.
+        bool fLegacyPending = false;
+        const size_t cOptions = gsl::narrow_cast<size_t>(options.size());
+
         // Run through the graphics options and apply them
         for (size_t i = 0; i < cOptions; i++)
         {
-            DispatchTypes::GraphicsOptions opt = rgOptions[i];
+            DispatchTypes::GraphicsOptions opt = options[i];
+            const bool fIsLegacyOption = !s_IsDefaultColorOption(opt) && !s_IsBoldColorOption(opt) && !s_IsRgbColorOption(opt);
+            if (fIsLegacyOption)
+            {
+                _SetGraphicsOptionHelper(opt, &attr);
+                fLegacyPending = true;
+                continue;
+            }
+
+            if (fLegacyPending)
+            {
+                fSuccess = _CommitLegacyAttributes(attr);
+                fLegacyPending = false;
+            }
+
             if (s_IsDefaultColorOption(opt))
             {
                 fSuccess = _SetDefaultColorHelper(opt);
             }
             else if (s_IsBoldColorOption(opt))
             {
-                fSuccess = _SetBoldColorHelper(rgOptions[i]);
+                fSuccess = _SetBoldColorHelper(opt);
             }
             else if (s_IsRgbColorOption(opt))
             {
@@ -424,25 +462,15 @@ bool AdaptDispatch::SetGraphicsRendition(_In_reads_(cOptions) const DispatchType
                 size_t cOptionsConsumed = 0;
 
                 // _SetRgbColorsHelper will call the appropriate ConApi function
-                fSuccess = _SetRgbColorsHelper(&(rgOptions[i]), cOptions - i, &rgbColor, &fIsForeground, &cOptionsConsumed);
+                fSuccess = _SetRgbColorsHelper(&(options[i]), cOptions - i, &rgbColor, &fIsForeground, &cOptionsConsumed);
 
                 i += (cOptionsConsumed - 1); // cOptionsConsumed includes the opt we're currently on.
             }
-            else
-            {
-                _SetGraphicsOptionHelper(opt, &attr);
-                fSuccess = !!_conApi->PrivateSetLegacyAttributes(attr, _fChangedForeground, _fChangedBackground, _fChangedMetaAttrs);
-
-                // Make sure we un-bold
-                if (fSuccess && opt == DispatchTypes::GraphicsOptions::Off)
-                {
-                    fSuccess = _SetBoldColorHelper(opt);
-                }
+        }
 
-                _fChangedForeground = false;
-                _fChangedBackground = false;
-                _fChangedMetaAttrs = false;
-            }
+        if (fLegacyPending)
+        {
+            fSuccess = _CommitLegacyAttributes(attr);
         }
     }
 
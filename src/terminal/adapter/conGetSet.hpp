@@ -84,10 +84,14 @@ namespace Microsoft::Console::VirtualTerminal
         virtual BOOL PrivateEnableButtonEventMouseMode(const bool fEnabled) = 0;
         virtual BOOL PrivateEnableAnyEventMouseMode(const bool fEnabled) = 0;
         virtual BOOL PrivateEnableAlternateScroll(const bool fEnabled) = 0;
+        virtual BOOL PrivateEnableSynchronizedUpdate(const bool fEnabled) = 0;
         virtual BOOL PrivateEraseAll() = 0;
+        virtual BOOL PrivateFillRect(const SMALL_RECT* const psrFill, const WCHAR wch, const WORD wAttr) = 0;
         virtual BOOL SetCursorStyle(const CursorType cursorType) = 0;
         virtual BOOL SetCursorColor(const COLORREF cursorColor) = 0;
         virtual BOOL PrivateGetConsoleScreenBufferAttributes(_Out_ WORD* const pwAttributes) = 0;
+        virtual BOOL PrivateGetCursorPosition(_Out_ COORD* const pCursorPosition) const = 0;
+        virtual BOOL PrivateGetViewport(_Out_ SMALL_RECT* const psrViewport) const = 0;
         virtual BOOL PrivatePrependConsoleInput(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& events,
                                                 _Out_ size_t& eventsWritten) = 0;
         virtual BOOL PrivateWriteConsoleControlInput(_In_ KeyEvent key) = 0;
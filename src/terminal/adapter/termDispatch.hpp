@@ -63,6 +63,7 @@ public:
     bool EnableButtonEventMouseMode(const bool /*fEnabled*/) override { return false; } // ?1002
     bool EnableAnyEventMouseMode(const bool /*fEnabled*/) override { return false; } // ?1003
     bool EnableAlternateScroll(const bool /*fEnabled*/) override { return false; } // ?1007
+    bool EnableSynchronizedUpdate(const bool /*fEnabled*/) override { return false; } // ?2026
     bool SetColorTableEntry(const size_t /*tableIndex*/, const DWORD /*dwColor*/) override { return false; } // OSCColorTable
     bool SetDefaultForeground(const DWORD /*dwColor*/) override { return false; } // OSCDefaultForeground
     bool SetDefaultBackground(const DWORD /*dwColor*/) override { return false; } // OSCDefaultBackground
@@ -71,8 +72,7 @@ public:
     bool EraseInLine(const DispatchTypes::EraseType /* eraseType*/) override { return false; } // EL
     bool EraseCharacters(const unsigned int /*uiNumChars*/) override { return false; } // ECH
 
-    bool SetGraphicsRendition(_In_reads_(_Param_(2)) const DispatchTypes::GraphicsOptions* const /*rgOptions*/,
-                              const size_t /*cOptions*/) override { return false; } // SGR
+    bool SetGraphicsRendition(const gsl::span<const DispatchTypes::GraphicsOptions> /*options*/) override { return false; } // SGR
 
     bool SetPrivateModes(_In_reads_(_Param_(2)) const DispatchTypes::PrivateModeParams* const /*rgParams*/,
                          const size_t /*cParams*/) override { return false; } // DECSET
@@ -90,6 +90,7 @@ public:
 
     bool SetCursorStyle(const DispatchTypes::CursorStyle /*cursorStyle*/) override { return false; } // DECSCUSR
     bool SetCursorColor(const COLORREF /*Color*/) override { return false; } // OSCSetCursorColor, OSCResetCursorColor
+    bool AddShellMark(const DispatchTypes::ShellMarkType /*markType*/) override { return false; } // OSCShellMark
 
     // DTTERM_WindowManipulation
     bool WindowManipulation(const DispatchTypes::WindowManipulationType /*uiFunction*/,
@@ -29,6 +29,8 @@ static wchar_t* s_pwszInputExpected;
 
 static wchar_t s_pwszExpectedBuffer[BYTE_MAX]; // big enough for anything
 
+static size_t s_cSequencesSent;
+
 static COORD s_rgTestCoords[] = {
     { 0, 0 },
     { 0, 1 },
@@ -85,22 +87,19 @@ class MouseInputTest
 public:
     TEST_CLASS(MouseInputTest);
 
-    static void s_MouseInputTestCallback(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& events)
+    static void s_MouseInputTestCallback(const std::wstring_view text)
     {
         Log::Comment(L"MouseInput successfully generated a sequence for the input, and sent it.");
+        ++s_cSequencesSent;
 
         size_t cInputExpected = 0;
         VERIFY_SUCCEEDED(StringCchLengthW(s_pwszInputExpected, STRSAFE_MAX_CCH, &cInputExpected));
 
-        if (VERIFY_ARE_EQUAL(cInputExpected, events.size(), L"Verify expected and actual input array lengths matched."))
+        if (VERIFY_ARE_EQUAL(cInputExpected, text.size(), L"Verify expected and actual sequence lengths matched."))
         {
-            Log::Comment(L"We are expecting always key events and always key down. All other properties should not be written by simulated keys.");
-
-            for (size_t i = 0; i < events.size(); ++i)
+            for (size_t i = 0; i < text.size(); ++i)
             {
-                KeyEvent expectedKeyEvent(TRUE, 1, 0, 0, s_pwszInputExpected[i], 0);
-                KeyEvent testKeyEvent = *static_cast<const KeyEvent* const>(events[i].get());
-                VERIFY_ARE_EQUAL(expectedKeyEvent, testKeyEvent, NoThrowString().Format(L"Chars='%c','%c'", s_pwszInputExpected[i], testKeyEvent.GetCharData()));
+                VERIFY_ARE_EQUAL(s_pwszInputExpected[i], text[i], NoThrowString().Format(L"Chars='%c','%c'", s_pwszInputExpected[i], text[i]));
             }
         }
     }
@@ -593,4 +592,31 @@ public:
                              NoThrowString().Format(L"(x,y)=(%d,%d)", Coord.X, Coord.Y));
         }
     }
+
+    TEST_METHOD(HoversInTheSameCellAreSentOnce)
+    {
+        Log::Comment(L"Starting test...");
+
+        MouseInput mouseInput{ s_MouseInputTestCallback };
+        mouseInput.EnableAnyEventTracking(true);
+        mouseInput.SetSGRExtendedMode(true);
+        s_cSequencesSent = 0;
+
+        // A hover without any buttons pressed.
+        s_pwszInputExpected = L"\x1b[<35;6;6m";
+        VERIFY_IS_TRUE(mouseInput.HandleMouse({ 5, 5 }, WM_MOUSEMOVE, 0, 0));
+        VERIFY_ARE_EQUAL(1u, s_cSequencesSent);
+
+        Log::Comment(L"Moving within the same cell doesn't send anything.");
+        VERIFY_IS_FALSE(mouseInput.HandleMouse({ 5, 5 }, WM_MOUSEMOVE, 0, 0));
+        VERIFY_IS_FALSE(mouseInput.HandleMouse({ 5, 5 }, WM_MOUSEMOVE, 0, 0));
+        VERIFY_ARE_EQUAL(1u, s_cSequencesSent);
+
+        Log::Comment(L"Moving to another cell does, and so do longer sequences in the same buffer.");
+        s_pwszInputExpected = L"\x1b[<35;32000;12345m";
+        VERIFY_IS_TRUE(mouseInput.HandleMouse({ 31999, 12344 }, WM_MOUSEMOVE, 0, 0));
+        s_pwszInputExpected = L"\x1b[<35;7;6m";
+        VERIFY_IS_TRUE(mouseInput.HandleMouse({ 6, 5 }, WM_MOUSEMOVE, 0, 0));
+        VERIFY_ARE_EQUAL(3u, s_cSequencesSent);
+    }
 };
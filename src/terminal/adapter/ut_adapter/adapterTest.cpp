@@ -248,6 +248,28 @@ public:
         return _fFillConsoleOutputAttributeResult;
     }
 
+    BOOL PrivateFillRect(const SMALL_RECT* const psrFill, const WCHAR wch, const WORD wAttr) override
+    {
+        Log::Comment(L"PrivateFillRect MOCK called...");
+
+        if (_fPrivateFillRectResult)
+        {
+            Log::Comment(NoThrowString().Format(L"Filling (L: %d, T: %d, R: %d, B: %d) with '%c' and 0x%x attribute...", psrFill->Left, psrFill->Top, psrFill->Right, psrFill->Bottom, wch, wAttr));
+
+            for (short y = psrFill->Top; y <= psrFill->Bottom; y++)
+            {
+                for (short x = psrFill->Left; x <= psrFill->Right; x++)
+                {
+                    CHAR_INFO* pchar = _GetCharAt(y, x);
+                    pchar->Char.UnicodeChar = wch;
+                    pchar->Attributes = wAttr;
+                }
+            }
+        }
+
+        return _fPrivateFillRectResult;
+    }
+
     BOOL SetConsoleTextAttribute(const WORD wAttr) override
     {
         Log::Comment(L"SetConsoleTextAttribute MOCK called...");
@@ -663,6 +685,16 @@ public:
         return _fPrivateEnableAlternateScrollResult;
     }
 
+    BOOL PrivateEnableSynchronizedUpdate(const bool fEnabled) override
+    {
+        Log::Comment(L"PrivateEnableSynchronizedUpdate MOCK called...");
+        if (_fPrivateEnableSynchronizedUpdateResult)
+        {
+            VERIFY_ARE_EQUAL(_fExpectedSynchronizedUpdateEnabled, fEnabled);
+        }
+        return _fPrivateEnableSynchronizedUpdateResult;
+    }
+
     BOOL PrivateEraseAll() override
     {
         Log::Comment(L"PrivateEraseAll MOCK called...");
@@ -701,6 +733,30 @@ public:
         return _fPrivateGetConsoleScreenBufferAttributesResult;
     }
 
+    BOOL PrivateGetCursorPosition(_Out_ COORD* const pCursorPosition) const override
+    {
+        Log::Comment(L"PrivateGetCursorPosition MOCK returning data...");
+
+        if (_fPrivateGetCursorPositionResult)
+        {
+            *pCursorPosition = _coordCursorPos;
+        }
+
+        return _fPrivateGetCursorPositionResult;
+    }
+
+    BOOL PrivateGetViewport(_Out_ SMALL_RECT* const psrViewport) const override
+    {
+        Log::Comment(L"PrivateGetViewport MOCK returning data...");
+
+        if (_fPrivateGetViewportResult)
+        {
+            *psrViewport = _srViewport;
+        }
+
+        return _fPrivateGetViewportResult;
+    }
+
     BOOL PrivateRefreshWindow() override
     {
         Log::Comment(L"PrivateRefreshWindow MOCK called...");
@@ -865,6 +921,7 @@ public:
         _fSetConsoleCursorInfoResult = TRUE;
         _fFillConsoleOutputCharacterWResult = TRUE;
         _fFillConsoleOutputAttributeResult = TRUE;
+        _fPrivateFillRectResult = TRUE;
         _fSetConsoleTextAttributeResult = TRUE;
         _fPrivateWriteConsoleInputWResult = TRUE;
         _fPrivatePrependConsoleInputResult = TRUE;
@@ -872,6 +929,8 @@ public:
         _fScrollConsoleScreenBufferWResult = TRUE;
         _fSetConsoleWindowInfoResult = TRUE;
         _fPrivateGetConsoleScreenBufferAttributesResult = TRUE;
+        _fPrivateGetCursorPositionResult = TRUE;
+        _fPrivateGetViewportResult = TRUE;
         _fMoveToBottomResult = true;
 
         _PrepCharsBuffer(wch, wAttr);
@@ -1352,6 +1411,7 @@ public:
     BOOL _fSetConsoleCursorInfoResult = false;
     BOOL _fFillConsoleOutputCharacterWResult = false;
     BOOL _fFillConsoleOutputAttributeResult = false;
+    BOOL _fPrivateFillRectResult = false;
     BOOL _fSetConsoleTextAttributeResult = false;
     BOOL _fPrivateWriteConsoleInputWResult = false;
     BOOL _fPrivatePrependConsoleInputResult = false;
@@ -1385,16 +1445,20 @@ public:
     bool _fExpectedClearAll = false;
     bool _fExpectedMouseEnabled = false;
     bool _fExpectedAlternateScrollEnabled = false;
+    bool _fExpectedSynchronizedUpdateEnabled = false;
     BOOL _fPrivateEnableVT200MouseModeResult = false;
     BOOL _fPrivateEnableUTF8ExtendedMouseModeResult = false;
     BOOL _fPrivateEnableSGRExtendedMouseModeResult = false;
     BOOL _fPrivateEnableButtonEventMouseModeResult = false;
     BOOL _fPrivateEnableAnyEventMouseModeResult = false;
     BOOL _fPrivateEnableAlternateScrollResult = false;
+    BOOL _fPrivateEnableSynchronizedUpdateResult = false;
     BOOL _fSetConsoleXtermTextAttributeResult = false;
     BOOL _fSetConsoleRGBTextAttributeResult = false;
     BOOL _fPrivateSetLegacyAttributesResult = false;
     BOOL _fPrivateGetConsoleScreenBufferAttributesResult = false;
+    BOOL _fPrivateGetCursorPositionResult = false;
+    BOOL _fPrivateGetViewportResult = false;
     BOOL _fSetCursorStyleResult = false;
     CursorType _ExpectedCursorStyle;
     BOOL _fSetCursorColorResult = false;
@@ -1678,13 +1742,13 @@ public:
         VERIFY_IS_FALSE((_pDispatch->*(moveFunc))(0));
         VERIFY_ARE_EQUAL(_testGetSet->_coordExpectedCursorPos, _testGetSet->_coordCursorPos);
 
-        // GetConsoleScreenBufferInfo throws failure. Parameters are otherwise normal.
-        Log::Comment(L"Test 7: When GetConsoleScreenBufferInfo throws a failure, call fails and cursor doesn't move.");
+        // PrivateGetCursorPosition throws failure. Parameters are otherwise normal.
+        Log::Comment(L"Test 7: When PrivateGetCursorPosition throws a failure, call fails and cursor doesn't move.");
         _testGetSet->PrepData(CursorX::LEFT, CursorY::TOP);
-        _testGetSet->_fGetConsoleScreenBufferInfoExResult = FALSE;
+        _testGetSet->_fPrivateGetCursorPositionResult = FALSE;
         _testGetSet->_fMoveCursorVerticallyResult = true;
         Log::Comment(NoThrowString().Format(
-            L"Cursor Up and Down don't need GetConsoleScreenBufferInfoEx, so they will succeed"));
+            L"Cursor Up and Down don't need PrivateGetCursorPosition, so they will succeed"));
         if (direction == CursorDirection::UP || direction == CursorDirection::DOWN)
         {
             VERIFY_IS_TRUE((_pDispatch->*(moveFunc))(0));
@@ -1743,10 +1807,10 @@ public:
 
         VERIFY_IS_FALSE(_pDispatch->CursorPosition(5, 5));
 
-        Log::Comment(L"Test 6: GetConsoleInfo API returns false. No move, return false.");
+        Log::Comment(L"Test 6: GetCursorPosition API returns false. No move, return false.");
         _testGetSet->PrepData(CursorX::LEFT, CursorY::TOP);
 
-        _testGetSet->_fGetConsoleScreenBufferInfoExResult = FALSE;
+        _testGetSet->_fPrivateGetCursorPositionResult = FALSE;
 
         VERIFY_IS_FALSE(_pDispatch->CursorPosition(1, 1));
 
@@ -1850,10 +1914,10 @@ public:
 
         VERIFY_IS_FALSE((_pDispatch->*(moveFunc))(sVal));
 
-        Log::Comment(L"Test 6: GetConsoleInfo API returns false. No move, return false.");
+        Log::Comment(L"Test 6: GetCursorPosition API returns false. No move, return false.");
         _testGetSet->PrepData(CursorX::LEFT, CursorY::TOP);
 
-        _testGetSet->_fGetConsoleScreenBufferInfoExResult = FALSE;
+        _testGetSet->_fPrivateGetCursorPositionResult = FALSE;
 
         sVal = 1;
 
@@ -2307,7 +2371,7 @@ public:
 
         Log::Comment(L"Test 3: Gracefully fail when filling the rectangle fails.");
         _testGetSet->PrepData();
-        _testGetSet->_fFillConsoleOutputCharacterWResult = false;
+        _testGetSet->_fPrivateFillRectResult = false;
 
         VERIFY_IS_FALSE(_pDispatch->EraseInDisplay(DispatchTypes::EraseType::Scrollback));
     }
@@ -2477,7 +2541,7 @@ public:
 
         Log::Comment(L"Test 3: Gracefully fail when filling the rectangle fails.");
         _testGetSet->PrepData();
-        _testGetSet->_fFillConsoleOutputCharacterWResult = false;
+        _testGetSet->_fPrivateFillRectResult = false;
 
         if (!fEraseScreen)
         {
@@ -2500,14 +2564,14 @@ public:
         DispatchTypes::GraphicsOptions rgOptions[16];
         size_t cOptions = 0;
 
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
 
         Log::Comment(L"Test 2: Gracefully fail when getting buffer information fails.");
 
         _testGetSet->PrepData();
         _testGetSet->_fPrivateGetConsoleScreenBufferAttributesResult = FALSE;
 
-        VERIFY_IS_FALSE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_FALSE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
 
         Log::Comment(L"Test 3: Gracefully fail when setting attribute data fails.");
 
@@ -2516,7 +2580,7 @@ public:
         // Need at least one option in order for the call to be able to fail.
         rgOptions[0] = (DispatchTypes::GraphicsOptions)0;
         cOptions = 1;
-        VERIFY_IS_FALSE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_FALSE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
     }
 
     TEST_METHOD(GraphicsSingleTests)
@@ -2803,7 +2867,45 @@ public:
             break;
         }
 
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
+    }
+
+    TEST_METHOD(GraphicsCombinedLegacyOptionsTests)
+    {
+        Log::Comment(L"Starting test...");
+
+        _testGetSet->PrepData();
+        _testGetSet->_fPrivateSetLegacyAttributesResult = TRUE;
+
+        DispatchTypes::GraphicsOptions rgOptions[16];
+        size_t cOptions = 3;
+
+        Log::Comment(L"Test 1: Several legacy options are written back in a single call");
+        // The mock clears what it expects after each call, so a second call would fail to match.
+        rgOptions[0] = DispatchTypes::GraphicsOptions::Underline;
+        rgOptions[1] = DispatchTypes::GraphicsOptions::ForegroundBlue;
+        rgOptions[2] = DispatchTypes::GraphicsOptions::BackgroundRed;
+        _testGetSet->_wAttribute = FOREGROUND_RED | BACKGROUND_BLUE;
+        _testGetSet->_wExpectedAttribute = COMMON_LVB_UNDERSCORE | FOREGROUND_BLUE | BACKGROUND_RED;
+        _testGetSet->_fExpectedForeground = true;
+        _testGetSet->_fExpectedBackground = true;
+        _testGetSet->_fExpectedMeta = true;
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
+        VERIFY_ARE_EQUAL(_testGetSet->_wExpectedAttribute, _testGetSet->_wAttribute);
+        VERIFY_IS_FALSE(_testGetSet->_fExpectedForeground);
+
+        Log::Comment(L"Test 2: Legacy options are written back before an option that isn't legacy");
+        cOptions = 2;
+        rgOptions[0] = DispatchTypes::GraphicsOptions::ForegroundGreen;
+        rgOptions[1] = DispatchTypes::GraphicsOptions::BoldBright;
+        _testGetSet->_wAttribute = FOREGROUND_RED;
+        _testGetSet->_wExpectedAttribute = FOREGROUND_GREEN;
+        _testGetSet->_fExpectedForeground = true;
+        _testGetSet->_fPrivateBoldTextResult = true;
+        _testGetSet->_fExpectedIsBold = true;
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
+        VERIFY_IS_TRUE(WI_IsFlagSet(_testGetSet->_wAttribute, FOREGROUND_GREEN));
+        VERIFY_IS_TRUE(_testGetSet->_fIsBold);
     }
 
     TEST_METHOD(GraphicsPersistBrightnessTests)
@@ -2827,13 +2929,13 @@ public:
         _testGetSet->_fExpectedMeta = true;
         _testGetSet->_fPrivateBoldTextResult = true;
         _testGetSet->_fExpectedIsBold = false;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
 
         Log::Comment(L"Testing graphics 'Foreground Color Blue'");
         rgOptions[0] = DispatchTypes::GraphicsOptions::ForegroundBlue;
         _testGetSet->_wExpectedAttribute = FOREGROUND_BLUE;
         _testGetSet->_fExpectedForeground = true;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
 
         Log::Comment(L"Enabling brightness");
         rgOptions[0] = DispatchTypes::GraphicsOptions::BoldBright;
@@ -2841,14 +2943,14 @@ public:
         _testGetSet->_fExpectedForeground = true;
         _testGetSet->_fPrivateBoldTextResult = true;
         _testGetSet->_fExpectedIsBold = true;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
         VERIFY_IS_TRUE(_testGetSet->_fIsBold);
 
         Log::Comment(L"Testing graphics 'Foreground Color Green, with brightness'");
         rgOptions[0] = DispatchTypes::GraphicsOptions::ForegroundGreen;
         _testGetSet->_wExpectedAttribute = FOREGROUND_GREEN;
         _testGetSet->_fExpectedForeground = true;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
         VERIFY_IS_TRUE(WI_IsFlagSet(_testGetSet->_wAttribute, FOREGROUND_GREEN));
         VERIFY_IS_TRUE(_testGetSet->_fIsBold);
 
@@ -2862,7 +2964,7 @@ public:
         _testGetSet->_fExpectedMeta = true;
         _testGetSet->_fPrivateBoldTextResult = true;
         _testGetSet->_fExpectedIsBold = false;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
         VERIFY_IS_TRUE(WI_IsFlagClear(_testGetSet->_wAttribute, FOREGROUND_INTENSITY));
         VERIFY_IS_FALSE(_testGetSet->_fIsBold);
 
@@ -2870,14 +2972,14 @@ public:
         rgOptions[0] = DispatchTypes::GraphicsOptions::BrightForegroundBlue;
         _testGetSet->_wExpectedAttribute = FOREGROUND_BLUE | FOREGROUND_INTENSITY;
         _testGetSet->_fExpectedForeground = true;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
         VERIFY_IS_FALSE(_testGetSet->_fIsBold);
 
         Log::Comment(L"Testing graphics 'Foreground Color Blue', brightness of 9x series doesn't persist");
         rgOptions[0] = DispatchTypes::GraphicsOptions::ForegroundBlue;
         _testGetSet->_wExpectedAttribute = FOREGROUND_BLUE;
         _testGetSet->_fExpectedForeground = true;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
         VERIFY_IS_FALSE(_testGetSet->_fIsBold);
 
         Log::Comment(L"Test 3: Enable brightness, use a bright color, brightness persists to next normal call");
@@ -2890,42 +2992,42 @@ public:
         _testGetSet->_fExpectedMeta = true;
         _testGetSet->_fPrivateBoldTextResult = true;
         _testGetSet->_fExpectedIsBold = false;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
         VERIFY_IS_FALSE(_testGetSet->_fIsBold);
 
         Log::Comment(L"Testing graphics 'Foreground Color Blue'");
         rgOptions[0] = DispatchTypes::GraphicsOptions::ForegroundBlue;
         _testGetSet->_wExpectedAttribute = FOREGROUND_BLUE;
         _testGetSet->_fExpectedForeground = true;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
         VERIFY_IS_FALSE(_testGetSet->_fIsBold);
 
         Log::Comment(L"Enabling brightness");
         rgOptions[0] = DispatchTypes::GraphicsOptions::BoldBright;
         _testGetSet->_fPrivateBoldTextResult = true;
         _testGetSet->_fExpectedIsBold = true;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
         VERIFY_IS_TRUE(_testGetSet->_fIsBold);
 
         Log::Comment(L"Testing graphics 'Foreground Color Bright Blue'");
         rgOptions[0] = DispatchTypes::GraphicsOptions::BrightForegroundBlue;
         _testGetSet->_wExpectedAttribute = FOREGROUND_BLUE | FOREGROUND_INTENSITY;
         _testGetSet->_fExpectedForeground = true;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
         VERIFY_IS_TRUE(_testGetSet->_fIsBold);
 
         Log::Comment(L"Testing graphics 'Foreground Color Blue, with brightness', brightness of 9x series doesn't affect brightness");
         rgOptions[0] = DispatchTypes::GraphicsOptions::ForegroundBlue;
         _testGetSet->_wExpectedAttribute = FOREGROUND_BLUE;
         _testGetSet->_fExpectedForeground = true;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
         VERIFY_IS_TRUE(_testGetSet->_fIsBold);
 
         Log::Comment(L"Testing graphics 'Foreground Color Green, with brightness'");
         rgOptions[0] = DispatchTypes::GraphicsOptions::ForegroundGreen;
         _testGetSet->_wExpectedAttribute = FOREGROUND_GREEN;
         _testGetSet->_fExpectedForeground = true;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
         VERIFY_IS_TRUE(_testGetSet->_fIsBold);
     }
 
@@ -3172,7 +3274,7 @@ public:
         SMALL_RECT srTestMargins = { 0 };
         _testGetSet->_srViewport.Right = 8;
         _testGetSet->_srViewport.Bottom = 8;
-        _testGetSet->_fGetConsoleScreenBufferInfoExResult = TRUE;
+        _testGetSet->_fPrivateGetViewportResult = TRUE;
         SHORT sScreenHeight = _testGetSet->_srViewport.Bottom - _testGetSet->_srViewport.Top;
 
         Log::Comment(L"Test 1: Verify having both values is valid.");
@@ -3348,6 +3450,26 @@ public:
         VERIFY_IS_TRUE(_pDispatch->EnableAlternateScroll(false));
     }
 
+    TEST_METHOD(SynchronizedUpdateTest)
+    {
+        Log::Comment(L"Starting test...");
+
+        const DispatchTypes::PrivateModeParams param = DispatchTypes::PrivateModeParams::SYNCHRONIZED_UPDATE;
+
+        Log::Comment(L"Test 1: DECSET 2026 begins the update");
+        _testGetSet->_fPrivateEnableSynchronizedUpdateResult = TRUE;
+        _testGetSet->_fExpectedSynchronizedUpdateEnabled = true;
+        VERIFY_IS_TRUE(_pDispatch->SetPrivateModes(&param, 1));
+
+        Log::Comment(L"Test 2: DECRST 2026 ends the update");
+        _testGetSet->_fExpectedSynchronizedUpdateEnabled = false;
+        VERIFY_IS_TRUE(_pDispatch->ResetPrivateModes(&param, 1));
+
+        Log::Comment(L"Test 3: Gracefully fail when the update can't be changed");
+        _testGetSet->_fPrivateEnableSynchronizedUpdateResult = FALSE;
+        VERIFY_IS_FALSE(_pDispatch->SetPrivateModes(&param, 1));
+    }
+
     TEST_METHOD(Xterm256ColorTest)
     {
         Log::Comment(L"Starting test...");
@@ -3367,7 +3489,7 @@ public:
         _testGetSet->_iExpectedXtermTableEntry = 2;
         _testGetSet->_fExpectedIsForeground = true;
         _testGetSet->_fUsingRgbColor = false;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
 
         Log::Comment(L"Test 2: Change Background");
         rgOptions[0] = DispatchTypes::GraphicsOptions::BackgroundExtended;
@@ -3377,7 +3499,7 @@ public:
         _testGetSet->_iExpectedXtermTableEntry = 9;
         _testGetSet->_fExpectedIsForeground = false;
         _testGetSet->_fUsingRgbColor = false;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
 
         Log::Comment(L"Test 3: Change Foreground to RGB color");
         rgOptions[0] = DispatchTypes::GraphicsOptions::ForegroundExtended;
@@ -3386,7 +3508,7 @@ public:
         _testGetSet->_iExpectedXtermTableEntry = 42;
         _testGetSet->_fExpectedIsForeground = true;
         _testGetSet->_fUsingRgbColor = true;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
 
         Log::Comment(L"Test 4: Change Background to RGB color");
         rgOptions[0] = DispatchTypes::GraphicsOptions::BackgroundExtended;
@@ -3395,7 +3517,7 @@ public:
         _testGetSet->_iExpectedXtermTableEntry = 142;
         _testGetSet->_fExpectedIsForeground = false;
         _testGetSet->_fUsingRgbColor = true;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
 
         Log::Comment(L"Test 5: Change Foreground to Legacy Attr while BG is RGB color");
         // Unfortunately this test isn't all that good, because the adapterTest adapter isn't smart enough
@@ -3408,7 +3530,7 @@ public:
         _testGetSet->_iExpectedXtermTableEntry = 9;
         _testGetSet->_fExpectedIsForeground = true;
         _testGetSet->_fUsingRgbColor = false;
-        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(rgOptions, cOptions));
+        VERIFY_IS_TRUE(_pDispatch->SetGraphicsRendition(gsl::make_span(rgOptions, cOptions)));
     }
 
     TEST_METHOD(HardReset)
@@ -3449,6 +3571,7 @@ public:
         _testGetSet->_fPrivateSetCursorKeysModeResult = true;
         _testGetSet->_fPrivateSetKeypadModeResult = true;
         _testGetSet->_fGetConsoleScreenBufferInfoExResult = true;
+        _testGetSet->_fPrivateGetViewportResult = true;
         _testGetSet->_fPrivateSetScrollingRegionResult = true;
 
         VERIFY_IS_TRUE(_pDispatch->HardReset());
@@ -3463,7 +3586,7 @@ public:
 
         Log::Comment(L"Test 3: Gracefully fail when filling the rectangle fails.");
         _testGetSet->PrepData();
-        _testGetSet->_fFillConsoleOutputCharacterWResult = false;
+        _testGetSet->_fPrivateFillRectResult = false;
 
         VERIFY_IS_FALSE(_pDispatch->HardReset());
 
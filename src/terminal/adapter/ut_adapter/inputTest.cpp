@@ -45,6 +45,7 @@ public:
     TEST_METHOD(TerminalInputModifierKeyTests);
     TEST_METHOD(TerminalInputNullKeyTests);
     TEST_METHOD(DifferentModifiersTest);
+    TEST_METHOD(ApplicationModesTest);
 
     wchar_t GetModifierChar(const bool fShift, const bool fAlt, const bool fCtrl)
     {
@@ -685,3 +686,44 @@ void InputTest::DifferentModifiersTest()
     uiKeystate = RIGHT_ALT_PRESSED;
     TestKey(pInput, uiKeystate, vkey, L'/');
 }
+
+void InputTest::ApplicationModesTest()
+{
+    Log::Comment(L"Starting test...");
+
+    TerminalInput input{ s_TerminalInputTestCallback };
+
+    Log::Comment(L"Cursor keys use the application mapping only when it's turned on.");
+    s_pwszInputExpected = L"\x1b[A";
+    TestKey(&input, 0, VK_UP);
+
+    input.ChangeCursorKeysMode(true);
+    s_pwszInputExpected = L"\x1bOA";
+    TestKey(&input, 0, VK_UP);
+    s_pwszInputExpected = L"\x1bOF";
+    TestKey(&input, 0, VK_END);
+
+    Log::Comment(L"Modified cursor keys don't depend on the mode.");
+    s_pwszInputExpected = L"\x1b[1;5A";
+    TestKey(&input, LEFT_CTRL_PRESSED, VK_UP);
+
+    input.ChangeCursorKeysMode(false);
+    s_pwszInputExpected = L"\x1b[F";
+    TestKey(&input, 0, VK_END);
+
+    Log::Comment(L"The keypad keys map the same way in both keypad modes.");
+    input.ChangeKeypadMode(true);
+    s_pwszInputExpected = L"\x1b[24~";
+    TestKey(&input, 0, VK_F12);
+    s_pwszInputExpected = L"\x1b[2;2~";
+    TestKey(&input, SHIFT_PRESSED, VK_INSERT);
+
+    Log::Comment(L"Keys without a mapping aren't handled.");
+    INPUT_RECORD irTest = { 0 };
+    irTest.EventType = KEY_EVENT;
+    irTest.Event.KeyEvent.wRepeatCount = 1;
+    irTest.Event.KeyEvent.wVirtualKeyCode = VK_NUMPAD5;
+    irTest.Event.KeyEvent.bKeyDown = TRUE;
+    auto inputEvent = IInputEvent::Create(irTest);
+    VERIFY_ARE_EQUAL(false, input.HandleKey(inputEvent.get()));
+}
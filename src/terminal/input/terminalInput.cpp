@@ -29,7 +29,7 @@ TerminalInput::TerminalInput(_In_ std::function<void(std::deque<std::unique_ptr<
 //    For the source for these tables.
 // Also refer to the values in terminfo for kcub1, kcud1, kcuf1, kcuu1, kend, khome.
 //   the 'xterm' setting lists the application mode versions of these sequences.
-const TerminalInput::_TermKeyMap TerminalInput::s_rgCursorKeysNormalMapping[]{
+constexpr TerminalInput::_TermKeyMap TerminalInput::s_rgCursorKeysNormalMapping[]{
     { VK_UP, L"\x1b[A" },
     { VK_DOWN, L"\x1b[B" },
     { VK_RIGHT, L"\x1b[C" },
@@ -38,7 +38,7 @@ const TerminalInput::_TermKeyMap TerminalInput::s_rgCursorKeysNormalMapping[]{
     { VK_END, L"\x1b[F" },
 };
 
-const TerminalInput::_TermKeyMap TerminalInput::s_rgCursorKeysApplicationMapping[]{
+constexpr TerminalInput::_TermKeyMap TerminalInput::s_rgCursorKeysApplicationMapping[]{
     { VK_UP, L"\x1bOA" },
     { VK_DOWN, L"\x1bOB" },
     { VK_RIGHT, L"\x1bOC" },
@@ -47,7 +47,7 @@ const TerminalInput::_TermKeyMap TerminalInput::s_rgCursorKeysApplicationMapping
     { VK_END, L"\x1bOF" },
 };
 
-const TerminalInput::_TermKeyMap TerminalInput::s_rgKeypadNumericMapping[]{
+constexpr TerminalInput::_TermKeyMap TerminalInput::s_rgKeypadNumericMapping[]{
     // HEY YOU. UPDATE THE MAX LENGTH DEF WHEN YOU MAKE CHANGES HERE.
     { VK_TAB, L"\x09" },
     { VK_BACK, L"\x7f" },
@@ -80,7 +80,7 @@ const TerminalInput::_TermKeyMap TerminalInput::s_rgKeypadNumericMapping[]{
 //It seems to me as though this was used for early numpad implementations, where presently numlock would enable
 //  "numeric" mode, outputting the numbers on the keys, while "application" mode does things like pgup/down, arrow keys, etc.
 //These keys aren't translated at all in numeric mode, so I figured I'd leave them out of the numeric table.
-const TerminalInput::_TermKeyMap TerminalInput::s_rgKeypadApplicationMapping[]{
+constexpr TerminalInput::_TermKeyMap TerminalInput::s_rgKeypadApplicationMapping[]{
     // HEY YOU. UPDATE THE MAX LENGTH DEF WHEN YOU MAKE CHANGES HERE.
     { VK_TAB, L"\x09" },
     { VK_BACK, L"\x7f" },
@@ -134,7 +134,7 @@ const TerminalInput::_TermKeyMap TerminalInput::s_rgKeypadApplicationMapping[]{
 // Sequences to send when a modifier is pressed with any of these keys
 // Basically, the 'm' will be replaced with a character indicating which
 //      modifier keys are pressed.
-const TerminalInput::_TermKeyMap TerminalInput::s_rgModifierKeyMapping[]{
+constexpr TerminalInput::_TermKeyMap TerminalInput::s_rgModifierKeyMapping[]{
     // HEY YOU. UPDATE THE MAX LENGTH DEF WHEN YOU MAKE CHANGES HERE.
     { VK_UP, L"\x1b[1;mA" },
     { VK_DOWN, L"\x1b[1;mB" },
@@ -167,7 +167,7 @@ const TerminalInput::_TermKeyMap TerminalInput::s_rgModifierKeyMapping[]{
 // These sequences are not later updated to encode the modifier state in the
 //      sequence itself, they are just weird exceptional cases to the general
 //      rules above.
-const TerminalInput::_TermKeyMap TerminalInput::s_rgSimpleModifedKeyMapping[]{
+constexpr TerminalInput::_TermKeyMap TerminalInput::s_rgSimpleModifedKeyMapping[]{
     // HEY YOU. UPDATE THE MAX LENGTH DEF WHEN YOU MAKE CHANGES HERE.
     { VK_BACK, CTRL_PRESSED, L"\x8" },
     { VK_BACK, ALT_PRESSED, L"\x1b\x7f" },
@@ -182,16 +182,36 @@ const TerminalInput::_TermKeyMap TerminalInput::s_rgSimpleModifedKeyMapping[]{
 
 const wchar_t* const CTRL_SLASH_SEQUENCE = L"\x1f";
 
-// Do NOT include the null terminator in the count.
-const size_t TerminalInput::_TermKeyMap::s_cchMaxSequenceLength = 7; // UPDATE THIS DEF WHEN THE LONGEST MAPPED STRING CHANGES
-
-const size_t TerminalInput::s_cCursorKeysNormalMapping = ARRAYSIZE(s_rgCursorKeysNormalMapping);
-const size_t TerminalInput::s_cCursorKeysApplicationMapping = ARRAYSIZE(s_rgCursorKeysApplicationMapping);
-const size_t TerminalInput::s_cKeypadNumericMapping = ARRAYSIZE(s_rgKeypadNumericMapping);
-const size_t TerminalInput::s_cKeypadApplicationMapping = ARRAYSIZE(s_rgKeypadApplicationMapping);
-const size_t TerminalInput::s_cModifierKeyMapping = ARRAYSIZE(s_rgModifierKeyMapping);
 const size_t TerminalInput::s_cSimpleModifedKeyMapping = ARRAYSIZE(s_rgSimpleModifedKeyMapping);
 
+// Routine Description:
+// - Builds, at compile time, the table that finds a key's entry in keyMapping by its
+//      virtual key, so that translating a key doesn't have to search for it.
+// Arguments:
+// - keyMapping - Array of key mappings that don't depend on the modifiers
+// Return Value:
+// - The table, with null for the keys that aren't in keyMapping
+template<size_t N>
+constexpr TerminalInput::_TermKeyMapTable TerminalInput::_MakeKeyMapTable(const _TermKeyMap (&keyMapping)[N]) noexcept
+{
+    _TermKeyMapTable table{};
+    for (const auto& map : keyMapping)
+    {
+        // The first entry for a key wins, as it would have when the array was searched.
+        if (table[map.wVirtualKey] == nullptr)
+        {
+            table[map.wVirtualKey] = &map;
+        }
+    }
+    return table;
+}
+
+constexpr TerminalInput::_TermKeyMapTable TerminalInput::s_CursorKeysNormalTable = _MakeKeyMapTable(s_rgCursorKeysNormalMapping);
+constexpr TerminalInput::_TermKeyMapTable TerminalInput::s_CursorKeysApplicationTable = _MakeKeyMapTable(s_rgCursorKeysApplicationMapping);
+constexpr TerminalInput::_TermKeyMapTable TerminalInput::s_KeypadNumericTable = _MakeKeyMapTable(s_rgKeypadNumericMapping);
+constexpr TerminalInput::_TermKeyMapTable TerminalInput::s_KeypadApplicationTable = _MakeKeyMapTable(s_rgKeypadApplicationMapping);
+constexpr TerminalInput::_TermKeyMapTable TerminalInput::s_ModifierKeyTable = _MakeKeyMapTable(s_rgModifierKeyMapping);
+
 void TerminalInput::ChangeKeypadMode(const bool fApplicationMode)
 {
     _fKeypadApplicationMode = fApplicationMode;
@@ -202,24 +222,27 @@ void TerminalInput::ChangeCursorKeysMode(const bool fApplicationMode)
     _fCursorApplicationMode = fApplicationMode;
 }
 
-const size_t TerminalInput::GetKeyMappingLength(const KeyEvent& keyEvent) const
+const TerminalInput::_TermKeyMapTable& TerminalInput::GetKeyMapping(const KeyEvent& keyEvent) const noexcept
 {
     if (keyEvent.IsCursorKey())
     {
-        return (_fCursorApplicationMode) ? s_cCursorKeysApplicationMapping : s_cCursorKeysNormalMapping;
+        return (_fCursorApplicationMode) ? s_CursorKeysApplicationTable : s_CursorKeysNormalTable;
     }
 
-    return (_fKeypadApplicationMode) ? s_cKeypadApplicationMapping : s_cKeypadNumericMapping;
+    return (_fKeypadApplicationMode) ? s_KeypadApplicationTable : s_KeypadNumericTable;
 }
 
-const TerminalInput::_TermKeyMap* TerminalInput::GetKeyMapping(const KeyEvent& keyEvent) const
+// Routine Description:
+// - Finds the entry for this key event's virtual key in one of the lookup tables.
+// Arguments:
+// - table - Lookup table to find the key in
+// - keyEvent - Key event to translate
+// Return Value:
+// - The matching mapping, or null if the key isn't in the table
+const TerminalInput::_TermKeyMap* TerminalInput::_LookupKeyMapping(const _TermKeyMapTable& table, const KeyEvent& keyEvent) noexcept
 {
-    if (keyEvent.IsCursorKey())
-    {
-        return (_fCursorApplicationMode) ? s_rgCursorKeysApplicationMapping : s_rgCursorKeysNormalMapping;
-    }
-
-    return (_fKeypadApplicationMode) ? s_rgKeypadApplicationMapping : s_rgKeypadNumericMapping;
+    const auto vkey = keyEvent.GetVirtualKeyCode();
+    return vkey < table.size() ? table[vkey] : nullptr;
 }
 
 // Routine Description:
@@ -232,30 +255,22 @@ const TerminalInput::_TermKeyMap* TerminalInput::GetKeyMapping(const KeyEvent& k
 // - True if there was a match to a key translation, and we successfully modified and sent it to the input
 bool TerminalInput::_SearchWithModifier(const KeyEvent& keyEvent) const
 {
-    const TerminalInput::_TermKeyMap* pMatchingMapping;
-    bool fSuccess = _SearchKeyMapping(keyEvent,
-                                      s_rgModifierKeyMapping,
-                                      s_cModifierKeyMapping,
-                                      &pMatchingMapping);
+    const TerminalInput::_TermKeyMap* pMatchingMapping = _LookupKeyMapping(s_ModifierKeyTable, keyEvent);
+    bool fSuccess = pMatchingMapping != nullptr;
     if (fSuccess)
     {
-        size_t cch = 0;
-        if (SUCCEEDED(StringCchLengthW(pMatchingMapping->pwszSequence, _TermKeyMap::s_cchMaxSequenceLength + 1, &cch)) &&
-            cch > 0)
+        // The modified sequence is built on the stack; these are never longer than the max.
+        const std::wstring_view sequence{ pMatchingMapping->pwszSequence };
+        wchar_t rgwchModifiedSequence[_TermKeyMap::s_cchMaxSequenceLength];
+        fSuccess = sequence.size() >= 2 && sequence.size() <= ARRAYSIZE(rgwchModifiedSequence);
+        if (fSuccess)
         {
-            wchar_t* rwchModifiedSequence = new (std::nothrow) wchar_t[cch + 1];
-            if (rwchModifiedSequence != nullptr)
-            {
-                memcpy(rwchModifiedSequence, pMatchingMapping->pwszSequence, cch * sizeof(wchar_t));
-                const bool fShift = keyEvent.IsShiftPressed();
-                const bool fAlt = keyEvent.IsAltPressed();
-                const bool fCtrl = keyEvent.IsCtrlPressed();
-                rwchModifiedSequence[cch - 2] = L'1' + (fShift ? 1 : 0) + (fAlt ? 2 : 0) + (fCtrl ? 4 : 0);
-                rwchModifiedSequence[cch] = 0;
-                _SendInputSequence(rwchModifiedSequence);
-                fSuccess = true;
-                delete[] rwchModifiedSequence;
-            }
+            std::copy(sequence.begin(), sequence.end(), rgwchModifiedSequence);
+            const bool fShift = keyEvent.IsShiftPressed();
+            const bool fAlt = keyEvent.IsAltPressed();
+            const bool fCtrl = keyEvent.IsCtrlPressed();
+            rgwchModifiedSequence[sequence.size() - 2] = L'1' + (fShift ? 1 : 0) + (fAlt ? 2 : 0) + (fCtrl ? 4 : 0);
+            _SendInputSequence({ rgwchModifiedSequence, sequence.size() });
         }
     }
     else
@@ -341,24 +356,20 @@ bool TerminalInput::_SearchKeyMapping(const KeyEvent& keyEvent,
 }
 
 // Routine Description:
-// - Searches the input array of mappings, and sends it to the input if a match was found.
+// - Looks the key up in the mappings for the current cursor and keypad modes, and sends
+//      it to the input if a match was found.
 // Arguments:
 // - keyEvent - Key event to translate
-// - keyMapping - Array of key mappings to search
-// - cKeyMapping - number of entries in keyMapping
 // Return Value:
 // - True if there was a match to a key translation, and we successfully sent it to the input
-bool TerminalInput::_TranslateDefaultMapping(const KeyEvent& keyEvent,
-                                             _In_reads_(cKeyMapping) const TerminalInput::_TermKeyMap* keyMapping,
-                                             const size_t cKeyMapping) const
+bool TerminalInput::_TranslateDefaultMapping(const KeyEvent& keyEvent) const
 {
-    const TerminalInput::_TermKeyMap* pMatchingMapping;
-    const bool fSuccess = _SearchKeyMapping(keyEvent, keyMapping, cKeyMapping, &pMatchingMapping);
-    if (fSuccess)
+    const auto pMatchingMapping = _LookupKeyMapping(GetKeyMapping(keyEvent), keyEvent);
+    if (pMatchingMapping != nullptr)
     {
         _SendInputSequence(pMatchingMapping->pwszSequence);
     }
-    return fSuccess;
+    return pMatchingMapping != nullptr;
 }
 
 bool TerminalInput::HandleKey(const IInputEvent* const pInEvent) const
@@ -449,14 +460,16 @@ bool TerminalInput::HandleKey(const IInputEvent* const pInEvent) const
                 if ((keyEvent.GetVirtualKeyCode() < '0' || keyEvent.GetVirtualKeyCode() > 'Z') &&
                     keyEvent.GetVirtualKeyCode() != VK_CANCEL)
                 {
-                    fKeyHandled = _TranslateDefaultMapping(keyEvent, GetKeyMapping(keyEvent), GetKeyMappingLength(keyEvent));
+                    fKeyHandled = _TranslateDefaultMapping(keyEvent);
                 }
                 else
                 {
-                    WCHAR rgwchSequence[2];
-                    rgwchSequence[0] = keyEvent.GetCharData();
-                    rgwchSequence[1] = UNICODE_NULL;
-                    _SendInputSequence(rgwchSequence);
+                    const auto wch = keyEvent.GetCharData();
+                    // A null character sends nothing, as it always has.
+                    if (wch != UNICODE_NULL)
+                    {
+                        _SendInputSequence({ &wch, 1 });
+                    }
                     fKeyHandled = true;
                 }
             }
@@ -475,17 +488,8 @@ bool TerminalInput::HandleKey(const IInputEvent* const pInEvent) const
 // - None
 void TerminalInput::_SendEscapedInputSequence(const wchar_t wch) const
 {
-    try
-    {
-        std::deque<std::unique_ptr<IInputEvent>> inputEvents;
-        inputEvents.push_back(std::make_unique<KeyEvent>(true, 1ui16, 0ui16, 0ui16, L'\x1b', 0));
-        inputEvents.push_back(std::make_unique<KeyEvent>(true, 1ui16, 0ui16, 0ui16, wch, 0));
-        _pfnWriteEvents(inputEvents);
-    }
-    catch (...)
-    {
-        LOG_HR(wil::ResultFromCaughtException());
-    }
+    const wchar_t rgwchSequence[]{ L'\x1b', wch };
+    _SendInputSequence({ rgwchSequence, ARRAYSIZE(rgwchSequence) });
 }
 
 void TerminalInput::_SendNullInputSequence(const DWORD dwControlKeyState) const
@@ -507,18 +511,22 @@ void TerminalInput::_SendNullInputSequence(const DWORD dwControlKeyState) const
     }
 }
 
-void TerminalInput::_SendInputSequence(_In_ PCWSTR const pwszSequence) const
+// Routine Description:
+// - Sends the whole sequence to the input in one batch, as a key down for each character.
+// Arguments:
+// - sequence - The characters to send. Never longer than the longest mapped sequence.
+// Return Value:
+// - None
+void TerminalInput::_SendInputSequence(const std::wstring_view sequence) const
 {
-    size_t cch = 0;
-    // + 1 to max sequence length for null terminator count which is required by StringCchLengthW
-    if (SUCCEEDED(StringCchLengthW(pwszSequence, _TermKeyMap::s_cchMaxSequenceLength + 1, &cch)) && cch > 0)
+    if (!sequence.empty() && sequence.size() <= _TermKeyMap::s_cchMaxSequenceLength)
     {
         try
         {
             std::deque<std::unique_ptr<IInputEvent>> inputEvents;
-            for (size_t i = 0; i < cch; i++)
+            for (const auto wch : sequence)
             {
-                inputEvents.push_back(std::make_unique<KeyEvent>(true, 1ui16, 0ui16, 0ui16, pwszSequence[i], 0));
+                inputEvents.push_back(std::make_unique<KeyEvent>(true, 1ui16, 0ui16, 0ui16, wch, 0));
             }
             _pfnWriteEvents(inputEvents);
         }
@@ -13,6 +13,7 @@ Author(s):
 - Michael Niksa (MiNiksa) 30-Oct-2015
 --*/
 
+#include <array>
 #include <functional>
 #include "../../types/inc/IInputEvent.hpp"
 #pragma once
@@ -43,7 +44,7 @@ namespace Microsoft::Console::VirtualTerminal
         bool _fCursorApplicationMode = false;
 
         void _SendNullInputSequence(const DWORD dwControlKeyState) const;
-        void _SendInputSequence(_In_ PCWSTR const pwszSequence) const;
+        void _SendInputSequence(const std::wstring_view sequence) const;
         void _SendEscapedInputSequence(const wchar_t wch) const;
 
         struct _TermKeyMap
@@ -52,14 +53,15 @@ namespace Microsoft::Console::VirtualTerminal
             PCWSTR const pwszSequence;
             DWORD const dwModifiers;
 
-            static const size_t s_cchMaxSequenceLength;
+            // Do NOT include the null terminator in the count.
+            static constexpr size_t s_cchMaxSequenceLength = 7; // UPDATE THIS DEF WHEN THE LONGEST MAPPED STRING CHANGES
 
-            _TermKeyMap(const WORD wVirtualKey, _In_ PCWSTR const pwszSequence) :
+            constexpr _TermKeyMap(const WORD wVirtualKey, _In_ PCWSTR const pwszSequence) :
                 wVirtualKey(wVirtualKey),
                 pwszSequence(pwszSequence),
                 dwModifiers(0){};
 
-            _TermKeyMap(const WORD wVirtualKey, const DWORD dwModifiers, _In_ PCWSTR const pwszSequence) :
+            constexpr _TermKeyMap(const WORD wVirtualKey, const DWORD dwModifiers, _In_ PCWSTR const pwszSequence) :
                 wVirtualKey(wVirtualKey),
                 pwszSequence(pwszSequence),
                 dwModifiers(dwModifiers){};
@@ -84,25 +86,32 @@ namespace Microsoft::Console::VirtualTerminal
         static const _TermKeyMap s_rgModifierKeyMapping[];
         static const _TermKeyMap s_rgSimpleModifedKeyMapping[];
 
-        static const size_t s_cCursorKeysNormalMapping;
-        static const size_t s_cCursorKeysApplicationMapping;
-        static const size_t s_cKeypadNumericMapping;
-        static const size_t s_cKeypadApplicationMapping;
-        static const size_t s_cModifierKeyMapping;
         static const size_t s_cSimpleModifedKeyMapping;
 
+        // The mappings above that don't care about the modifiers, indexed by virtual key.
+        // Keys without a mapping are null.
+        using _TermKeyMapTable = std::array<const _TermKeyMap*, 256>;
+
+        template<size_t N>
+        static constexpr _TermKeyMapTable _MakeKeyMapTable(const _TermKeyMap (&keyMapping)[N]) noexcept;
+
+        static const _TermKeyMapTable s_CursorKeysNormalTable;
+        static const _TermKeyMapTable s_CursorKeysApplicationTable;
+        static const _TermKeyMapTable s_KeypadNumericTable;
+        static const _TermKeyMapTable s_KeypadApplicationTable;
+        static const _TermKeyMapTable s_ModifierKeyTable;
+
+        static const _TermKeyMap* _LookupKeyMapping(const _TermKeyMapTable& table, const KeyEvent& keyEvent) noexcept;
+
         bool _SearchKeyMapping(const KeyEvent& keyEvent,
                                _In_reads_(cKeyMapping) const TerminalInput::_TermKeyMap* keyMapping,
                                const size_t cKeyMapping,
                                _Out_ const TerminalInput::_TermKeyMap** pMatchingMapping) const;
 
-        bool _TranslateDefaultMapping(const KeyEvent& keyEvent,
-                                      _In_reads_(cKeyMapping) const TerminalInput::_TermKeyMap* keyMapping,
-                                      const size_t cKeyMapping) const;
+        bool _TranslateDefaultMapping(const KeyEvent& keyEvent) const;
 
         bool _SearchWithModifier(const KeyEvent& keyEvent) const;
 
-        const size_t GetKeyMappingLength(const KeyEvent& keyEvent) const;
-        const _TermKeyMap* GetKeyMapping(const KeyEvent& keyEvent) const;
+        const _TermKeyMapTable& GetKeyMapping(const KeyEvent& keyEvent) const noexcept;
     };
 }
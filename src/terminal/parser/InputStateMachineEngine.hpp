@@ -23,7 +23,7 @@ Author(s):
 
 namespace Microsoft::Console::VirtualTerminal
 {
-    class InputStateMachineEngine : public IStateMachineEngine
+    class InputStateMachineEngine final : public IStateMachineEngine
     {
     public:
         InputStateMachineEngine(IInteractDispatch* const pDispatch);
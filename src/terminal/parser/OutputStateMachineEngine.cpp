@@ -264,6 +264,20 @@ bool OutputStateMachineEngine::ActionCsiDispatch(const wchar_t wch,
                                                  const unsigned short cParams)
 {
     bool fSuccess = false;
+
+    // The sequences sent most often are dispatched before any of the general handling below.
+    if (cIntermediate == 0 && _TryDispatchCommonCsi(wch, rgusParams, cParams, &fSuccess))
+    {
+        if (_pfnFlushToTerminal != nullptr && !fSuccess)
+        {
+            fSuccess = _pfnFlushToTerminal();
+        }
+
+        _ClearLastChar();
+
+        return fSuccess;
+    }
+
     unsigned int uiDistance = 0;
     unsigned int uiLine = 0;
     unsigned int uiColumn = 0;
@@ -413,7 +427,7 @@ bool OutputStateMachineEngine::ActionCsiDispatch(const wchar_t wch,
                 TermTelemetry::Instance().Log(TermTelemetry::Codes::EL);
                 break;
             case VTActionCodes::SGR_SetGraphicsRendition:
-                fSuccess = _dispatch->SetGraphicsRendition(rgGraphicsOptions, cOptions);
+                fSuccess = _dispatch->SetGraphicsRendition(gsl::make_span(rgGraphicsOptions, cOptions));
                 TermTelemetry::Instance().Log(TermTelemetry::Codes::SGR);
                 break;
             case VTActionCodes::DSR_DeviceStatusReport:
@@ -476,10 +490,18 @@ bool OutputStateMachineEngine::ActionCsiDispatch(const wchar_t wch,
                 // implementation would effectively be the same, calling only
                 // functions that are already part of the interface.
                 // Print the last graphical character a number of times.
+                // The run is printed a chunk at a time out of a small buffer,
+                // so even the largest count doesn't need an allocation.
                 if (_lastPrintedChar != AsciiChars::NUL)
                 {
-                    std::wstring wstr(repeatCount, _lastPrintedChar);
-                    _dispatch->PrintString(wstr.c_str(), wstr.length());
+                    wchar_t rgwch[s_cRepeatChunkMax];
+                    std::fill_n(rgwch, std::min<size_t>(repeatCount, s_cRepeatChunkMax), _lastPrintedChar);
+                    for (size_t cchRemaining = repeatCount; cchRemaining > 0;)
+                    {
+                        const size_t cch = std::min(cchRemaining, s_cRepeatChunkMax);
+                        _dispatch->PrintString(rgwch, cch);
+                        cchRemaining -= cch;
+                    }
                 }
                 fSuccess = true;
                 TermTelemetry::Instance().Log(TermTelemetry::Codes::REP);
@@ -522,6 +544,81 @@ bool OutputStateMachineEngine::ActionCsiDispatch(const wchar_t wch,
     return fSuccess;
 }
 
+// Routine Description:
+// - Dispatches the control sequences that cursor-addressed output (progress bars,
+//      full screen apps) sends most often, without filling in the parameters for
+//      every other sequence first. These are CUP with up to two parameters, SGR 0,
+//      EL 0 or 2, and CUF/CUB with up to one parameter. Anything else, including
+//      other parameters for these same sequences, is left for ActionCsiDispatch.
+// Arguments:
+// - wch - Character to dispatch.
+// - rgusParams - set of numeric parameters collected while pasring the sequence.
+// - cParams - number of parameters found.
+// - pfSuccess - receives whether the dispatch succeeded, if the sequence was handled here.
+// Return Value:
+// - true iff the sequence was one of the ones handled here.
+bool OutputStateMachineEngine::_TryDispatchCommonCsi(const wchar_t wch,
+                                                     _In_reads_(cParams) const unsigned short* const rgusParams,
+                                                     const unsigned short cParams,
+                                                     _Out_ bool* const pfSuccess)
+{
+    switch (wch)
+    {
+    case VTActionCodes::CUP_CursorPosition:
+        if (cParams <= 2)
+        {
+            // Missing and zero parameters both mean the first line or column.
+            const unsigned int uiLine = (cParams >= 1 && rgusParams[0] != 0) ? rgusParams[0] : s_uiDefaultLine;
+            const unsigned int uiColumn = (cParams == 2 && rgusParams[1] != 0) ? rgusParams[1] : s_uiDefaultColumn;
+            *pfSuccess = _dispatch->CursorPosition(uiLine, uiColumn);
+            TermTelemetry::Instance().Log(TermTelemetry::Codes::CUP);
+            return true;
+        }
+        break;
+    case VTActionCodes::SGR_SetGraphicsRendition:
+        if (cParams == 0 || (cParams == 1 && rgusParams[0] == 0))
+        {
+            const DispatchTypes::GraphicsOptions option = s_defaultGraphicsOption;
+            *pfSuccess = _dispatch->SetGraphicsRendition(gsl::make_span(&option, 1));
+            TermTelemetry::Instance().Log(TermTelemetry::Codes::SGR);
+            return true;
+        }
+        break;
+    case VTActionCodes::EL_EraseLine:
+        if (cParams == 0 || (cParams == 1 && (rgusParams[0] == 0 || rgusParams[0] == 2)))
+        {
+            const DispatchTypes::EraseType eraseType = cParams == 0 ? s_defaultEraseType : static_cast<DispatchTypes::EraseType>(rgusParams[0]);
+            *pfSuccess = _dispatch->EraseInLine(eraseType);
+            TermTelemetry::Instance().Log(TermTelemetry::Codes::EL);
+            return true;
+        }
+        break;
+    case VTActionCodes::CUF_CursorForward:
+    case VTActionCodes::CUB_CursorBackward:
+        if (cParams <= 1)
+        {
+            // Distances of 0 mean 1, same as a missing distance.
+            const unsigned int uiDistance = (cParams == 1 && rgusParams[0] != 0) ? rgusParams[0] : s_uiDefaultCursorDistance;
+            if (wch == VTActionCodes::CUF_CursorForward)
+            {
+                *pfSuccess = _dispatch->CursorForward(uiDistance);
+                TermTelemetry::Instance().Log(TermTelemetry::Codes::CUF);
+            }
+            else
+            {
+                *pfSuccess = _dispatch->CursorBackward(uiDistance);
+                TermTelemetry::Instance().Log(TermTelemetry::Codes::CUB);
+            }
+            return true;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return false;
+}
+
 // Routine Description:
 // - Handles actions that have postfix params on an intermediate '?', such as DECTCEM, DECCOLM, ATT610
 // Arguments:
@@ -685,6 +782,7 @@ bool OutputStateMachineEngine::ActionOscDispatch(const wchar_t /*wch*/,
     unsigned short sCchTitleLength = 0;
     size_t tableIndex = 0;
     DWORD dwColor = 0;
+    DispatchTypes::ShellMarkType markType = DispatchTypes::ShellMarkType::PromptStart;
 
     switch (sOscParam)
     {
@@ -706,6 +804,9 @@ bool OutputStateMachineEngine::ActionOscDispatch(const wchar_t /*wch*/,
         dwColor = 0xffffffff;
         fSuccess = true;
         break;
+    case OscActionCodes::ShellMark:
+        fSuccess = _GetOscShellMark(pwchOscStringBuffer, cchOscString, &markType);
+        break;
     default:
         // If no functions to call, overall dispatch was a failure.
         fSuccess = false;
@@ -741,6 +842,10 @@ bool OutputStateMachineEngine::ActionOscDispatch(const wchar_t /*wch*/,
             fSuccess = _dispatch->SetCursorColor(dwColor);
             TermTelemetry::Instance().Log(TermTelemetry::Codes::OSCRCC);
             break;
+        case OscActionCodes::ShellMark:
+            fSuccess = _dispatch->AddShellMark(markType);
+            TermTelemetry::Instance().Log(TermTelemetry::Codes::OSCSM);
+            break;
         default:
             // If no functions to call, overall dispatch was a failure.
             fSuccess = false;
@@ -1607,6 +1712,50 @@ bool OutputStateMachineEngine::_GetOscSetColor(_In_reads_(cchOscString) const wc
     return fSuccess;
 }
 
+// Routine Description:
+// - Parses the part of a shell's prompt cycle out of a shell integration string.
+//   These are OSC 133's, "A" through "D", which some marks follow with
+//   parameters of their own (like "D;0" for the exit code). Those are ignored.
+// Arguments:
+// - pwchOscStringBuffer - a pointer to the Osc String to parse
+// - cchOscString - the length of the Osc String
+// - pMarkType - a pointer that recieves which part of the cycle was marked
+// Return Value:
+// - True if the string held a mark we know. False otherwise.
+_Success_(return ) bool OutputStateMachineEngine::_GetOscShellMark(_In_reads_(cchOscString) const wchar_t* const pwchOscStringBuffer,
+                                                                   const size_t cchOscString,
+                                                                   _Out_ DispatchTypes::ShellMarkType* const pMarkType) const
+{
+    *pMarkType = DispatchTypes::ShellMarkType::PromptStart;
+
+    if (pwchOscStringBuffer == nullptr || cchOscString == 0 || (cchOscString > 1 && pwchOscStringBuffer[1] != L';'))
+    {
+        return false;
+    }
+
+    bool fSuccess = true;
+    switch (pwchOscStringBuffer[0])
+    {
+    case L'A':
+        *pMarkType = DispatchTypes::ShellMarkType::PromptStart;
+        break;
+    case L'B':
+        *pMarkType = DispatchTypes::ShellMarkType::CommandStart;
+        break;
+    case L'C':
+        *pMarkType = DispatchTypes::ShellMarkType::CommandExecuted;
+        break;
+    case L'D':
+        *pMarkType = DispatchTypes::ShellMarkType::CommandFinished;
+        break;
+    default:
+        fSuccess = false;
+        break;
+    }
+
+    return fSuccess;
+}
+
 // Method Description:
 // - Retrieves the type of window manipulation operation from the parameter pool
 //      stored during Param actions.
@@ -19,7 +19,7 @@ Abstract:
 
 namespace Microsoft::Console::VirtualTerminal
 {
-    class OutputStateMachineEngine : public IStateMachineEngine
+    class OutputStateMachineEngine final : public IStateMachineEngine
     {
     public:
         OutputStateMachineEngine(ITermDispatch* const pDispatch);
@@ -142,6 +142,7 @@ namespace Microsoft::Console::VirtualTerminal
             ResetForegroundColor = 110, // Not implemented
             ResetBackgroundColor = 111, // Not implemented
             ResetCursorColor = 112,
+            ShellMark = 133,
         };
 
         enum class DesignateCharsetTypes
@@ -247,6 +248,10 @@ namespace Microsoft::Console::VirtualTerminal
                              const size_t cchOscString,
                              _Out_ DWORD* const pRgb) const;
 
+        _Success_(return ) bool _GetOscShellMark(_In_reads_(cchOscString) const wchar_t* const pwchOscStringBuffer,
+                                                 const size_t cchOscString,
+                                                 _Out_ DispatchTypes::ShellMarkType* const pMarkType) const;
+
         static const DispatchTypes::CursorStyle s_defaultCursorStyle = DispatchTypes::CursorStyle::BlinkingBlockDefault;
         _Success_(return ) bool _GetCursorStyle(_In_reads_(cParams) const unsigned short* const rgusParams,
                                                 const unsigned short cParams,
@@ -256,6 +261,12 @@ namespace Microsoft::Console::VirtualTerminal
         _Success_(return ) bool _GetRepeatCount(_In_reads_(cParams) const unsigned short* const rgusParams,
                                                 const unsigned short cParams,
                                                 _Out_ unsigned int* const puiRepeatCount) const noexcept;
+        static const size_t s_cRepeatChunkMax = 128;
+
+        bool _TryDispatchCommonCsi(const wchar_t wch,
+                                   _In_reads_(cParams) const unsigned short* const rgusParams,
+                                   const unsigned short cParams,
+                                   _Out_ bool* const pfSuccess);
 
         void _ClearLastChar() noexcept;
     };
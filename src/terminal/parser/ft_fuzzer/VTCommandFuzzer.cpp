@@ -38,6 +38,7 @@ static std::string GenerateOscTitleToken();
 static std::string GenerateHardResetToken();
 static std::string GenerateSoftResetToken();
 static std::string GenerateOscColorTableToken();
+static std::string GeneratePathologicalToken();
 
 const fuzz::_fuzz_type_entry<BYTE> g_repeatMap[] = {
     { 4, [](BYTE) { return CFuzzChance::GetRandom<BYTE>(2, 0xF); } },
@@ -80,7 +81,8 @@ std::string GenerateToken()
         { 50, [](std::string) { return GenerateTextToken(); } },
         { 40, [&](std::string) { return CFuzzChance::SelectOne(g_tokenGenerators, ARRAYSIZE(g_tokenGenerators))(); } },
         { 1, [](std::string) { return GenerateInvalidToken(); } },
-        { 3, [](std::string) { return GenerateWhiteSpaceToken(); } }
+        { 3, [](std::string) { return GenerateWhiteSpaceToken(); } },
+        { 1, [](std::string) { return GeneratePathologicalToken(); } }
     };
     CFuzzType<std::string> ft(FUZZ_MAP(tokenGeneratorMap), std::string(""));
 
@@ -505,6 +507,63 @@ std::string GenerateOscColorTableToken()
     return GenerateFuzzedOscToken(FUZZ_MAP(map), tokens, ARRAYSIZE(tokens));
 }
 
+// Input that's slow to parse rather than wrong: sequences far longer than anything real,
+// the kind that shows off anything quadratic in the parser. These are what the fuzz
+// wrapper's -slowest mode is looking for.
+std::string GeneratePathologicalToken()
+{
+    const _fuzz_type_entry<std::string> map[] = {
+        // A very long OSC string, terminated or not.
+        { 25, [](std::string) {
+              std::string s(OSC);
+              s.append("2;");
+              s.append(CFuzzChance::GetRandom<USHORT>(0x1000, 0xFFFF), 'x');
+              if (CFuzzChance::GetRandom<BOOL>())
+              {
+                  s.append("\x7");
+              }
+              return s;
+          } },
+        // A huge list of parameters, some of them empty.
+        { 25, [](std::string) {
+              std::string s(CSI);
+              const USHORT count = CFuzzChance::GetRandom<USHORT>(0x100, 0x4000);
+              for (USHORT i = 0; i < count; i++)
+              {
+                  if (CFuzzChance::GetRandom<BYTE>(0, 9) != 0)
+                  {
+                      AppendFormat(s, "%d", CFuzzChance::GetRandom<USHORT>());
+                  }
+                  s.append(";");
+              }
+              s.append("m");
+              return s;
+          } },
+        // A parameter with far too many digits.
+        { 15, [](std::string) {
+              std::string s(CSI);
+              s.append(CFuzzChance::GetRandom<USHORT>(0x100, 0x4000), '9');
+              s.append("H");
+              return s;
+          } },
+        // The same request for a report, over and over.
+        { 35, [](std::string) {
+              const LPSTR requests[] = { "\x1b[6n", "\x1b[5n", "\x1b[c", "\x1b[0c" };
+              const auto request = CFuzzChance::SelectOne(requests, ARRAYSIZE(requests));
+              std::string s;
+              const USHORT count = CFuzzChance::GetRandom<USHORT>(0x100, 0x1000);
+              for (USHORT i = 0; i < count; i++)
+              {
+                  s.append(request);
+              }
+              return s;
+          } }
+    };
+    CFuzzType<std::string> ft(FUZZ_MAP(map), std::string(""));
+
+    return (std::string)ft;
+}
+
 int __cdecl wmain(int argc, WCHAR* argv[])
 {
     if (argc != 3)
@@ -4,15 +4,128 @@
 #include "precomp.h"
 
 #include "echoDispatch.hpp"
+#include "nullDispatch.hpp"
 #include "..\stateMachine.hpp"
 #include "..\OutputStateMachineEngine.hpp"
 
+#include <chrono>
+
 using namespace Microsoft::Console::VirtualTerminal;
 
 void PrintUsage()
 {
     wprintf(L"Usage: conterm.parser.fuzzwrapper.exe <input file name> <codepage>\r\n");
     wprintf(L"Use codepage 1200 for Unicode. 437 for US English. 0 for reading straight as ASCII.\r\n");
+    wprintf(L"\r\n");
+    wprintf(L"       conterm.parser.fuzzwrapper.exe -slowest <fuzzer output directory> <corpus directory> [<count>]\r\n");
+    wprintf(L"Times every file the fuzzer wrote through the parser, and copies the <count> (20) slowest per character into the corpus.\r\n");
+    wprintf(L"\r\n");
+    wprintf(L"       conterm.parser.fuzzwrapper.exe -bench <corpus directory> [<limit in ns per character>]\r\n");
+    wprintf(L"Times every file of the corpus through the parser. Fails if any of them is slower than the limit.\r\n");
+}
+
+struct Timing
+{
+    std::filesystem::path path;
+    size_t cch;
+    double nsPerChar;
+};
+
+// Reads a file the way the fuzzer writes them, one character per byte.
+std::wstring ReadFuzzFile(const std::filesystem::path& path)
+{
+    std::ifstream file{ path, std::ios::binary };
+    const std::string bytes{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+
+    std::wstring text;
+    text.reserve(bytes.size());
+    for (const auto ch : bytes)
+    {
+        text.push_back(static_cast<wchar_t>(static_cast<unsigned char>(ch)));
+    }
+    return text;
+}
+
+// Times a file through StateMachine::ProcessString with a dispatch that does nothing.
+// The best of a few runs is taken, so that a hiccup doesn't make a file look slow.
+Timing TimeFile(const std::filesystem::path& path)
+{
+    constexpr int Runs = 3;
+
+    const auto text = ReadFuzzFile(path);
+    double best = 0;
+    for (int run = 0; run < Runs; ++run)
+    {
+        StateMachine machine(new OutputStateMachineEngine(new NullDispatch));
+
+        const auto start = std::chrono::steady_clock::now();
+        machine.ProcessString(text.data(), text.size());
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        best = run == 0 ? elapsed : std::min(best, elapsed);
+    }
+
+    return { path, text.size(), text.empty() ? 0 : best / text.size() };
+}
+
+// Times every file in a directory, slowest per character first.
+std::vector<Timing> TimeDirectory(const std::filesystem::path& directory)
+{
+    std::vector<Timing> timings;
+    for (const auto& entry : std::filesystem::directory_iterator(directory))
+    {
+        if (entry.is_regular_file())
+        {
+            timings.push_back(TimeFile(entry.path()));
+        }
+    }
+
+    std::sort(timings.begin(), timings.end(), [](const Timing& a, const Timing& b) {
+        return a.nsPerChar > b.nsPerChar;
+    });
+    return timings;
+}
+
+int KeepSlowest(const std::filesystem::path& fuzzDirectory, const std::filesystem::path& corpusDirectory, const size_t count)
+{
+    const auto timings = TimeDirectory(fuzzDirectory);
+    std::filesystem::create_directories(corpusDirectory);
+
+    for (size_t i = 0; i < timings.size() && i < count; ++i)
+    {
+        const auto& timing = timings.at(i);
+        std::filesystem::copy_file(timing.path, corpusDirectory / timing.path.filename(), std::filesystem::copy_options::overwrite_existing);
+        wprintf(L"%10.2f ns/char %10zu chars  %s\r\n", timing.nsPerChar, timing.cch, timing.path.filename().c_str());
+    }
+
+    wprintf(L"Kept the %zu slowest of %zu files.\r\n", std::min(count, timings.size()), timings.size());
+    return 0;
+}
+
+int Bench(const std::filesystem::path& corpusDirectory, const double limit)
+{
+    const auto timings = TimeDirectory(corpusDirectory);
+
+    size_t totalChars = 0;
+    double totalNs = 0;
+    size_t overLimit = 0;
+    for (const auto& timing : timings)
+    {
+        totalChars += timing.cch;
+        totalNs += timing.nsPerChar * timing.cch;
+
+        const bool slow = limit > 0 && timing.nsPerChar > limit;
+        overLimit += slow ? 1 : 0;
+        wprintf(L"%10.2f ns/char %10zu chars  %s%s\r\n", timing.nsPerChar, timing.cch, timing.path.filename().c_str(), slow ? L"  OVER LIMIT" : L"");
+    }
+
+    wprintf(L"%zu files, %zu chars, %.2f ns/char overall.\r\n", timings.size(), totalChars, totalChars > 0 ? totalNs / totalChars : 0.0);
+    if (overLimit > 0)
+    {
+        wprintf(L"%zu files are slower than %.2f ns/char.\r\n", overLimit, limit);
+        return 1;
+    }
+    return 0;
 }
 
 UINT const UNICODE_CP = 1200;
@@ -46,6 +159,16 @@ int __cdecl wmain(int argc, wchar_t* argv[])
 {
     int ret = 0;
 
+    if (argc >= 4 && argc <= 5 && wcscmp(argv[1], L"-slowest") == 0)
+    {
+        return KeepSlowest(argv[2], argv[3], argc == 5 ? _wtoi(argv[4]) : 20);
+    }
+
+    if (argc >= 3 && argc <= 4 && wcscmp(argv[1], L"-bench") == 0)
+    {
+        return Bench(argv[2], argc == 4 ? _wtof(argv[3]) : 0);
+    }
+
     if (argc != 3)
     {
         PrintUsage();
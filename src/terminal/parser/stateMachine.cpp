@@ -6,8 +6,17 @@
 #include "stateMachine.hpp"
 
 #include "ascii.hpp"
+#include "../../types/inc/AllocationTracking.hpp"
+#include "../../types/inc/OutputTracing.hpp"
+
+#if (defined(_M_IX86) || defined(_M_AMD64))
+#include <emmintrin.h>
+#endif
 
 using namespace Microsoft::Console::VirtualTerminal;
+using Microsoft::Console::Types::AllocationScope;
+using Microsoft::Console::Types::AllocationTag;
+using Microsoft::Console::Types::OutputTracing;
 
 //Takes ownership of the pEngine.
 StateMachine::StateMachine(IStateMachineEngine* const pEngine) :
@@ -25,10 +34,13 @@ StateMachine::StateMachine(IStateMachineEngine* const pEngine) :
     // rgusParams Initialized below
     _sOscNextChar(0),
     _sOscParam(0),
-    _currRunLength(0)
+    _currRunLength(0),
+    _cchUtf8Partial(0),
+    _rgwchUtf8Chunk(nullptr)
 {
     ZeroMemory(_pwchOscStringBuffer, sizeof(_pwchOscStringBuffer));
     ZeroMemory(_rgusParams, sizeof(_rgusParams));
+    ZeroMemory(_rgchUtf8Partial, sizeof(_rgchUtf8Partial));
     _ActionClear();
 }
 
@@ -54,6 +66,51 @@ bool StateMachine::s_IsActionableFromGround(const wchar_t wch)
     return (wch <= AsciiChars::US) || s_IsC1Csi(wch) || s_IsDelete(wch);
 }
 
+// Routine Description:
+// - Finds the first character in a string that s_IsActionableFromGround.
+//   Everything before it can be printed as one run.
+// - On x86/x64, eight characters are checked at a time.
+// Arguments:
+// - pwch - The string to search.
+// - cch - The number of characters in the string.
+// Return Value:
+// - The index of the first actionable character, or cch if there's none.
+size_t StateMachine::s_FindActionableFromGround(const wchar_t* const pwch, const size_t cch) noexcept
+{
+    size_t i = 0;
+
+#if (defined(_M_IX86) || defined(_M_AMD64))
+    static_assert(sizeof(wchar_t) == sizeof(uint16_t));
+
+    const auto lastC0 = _mm_set1_epi16(static_cast<short>(AsciiChars::US));
+    const auto del = _mm_set1_epi16(static_cast<short>(AsciiChars::DEL));
+    const auto c1Csi = _mm_set1_epi16(static_cast<short>(L'\x9b'));
+    for (; i + 8 <= cch; i += 8)
+    {
+        const auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pwch + i));
+
+        // A saturating subtract only leaves zero behind for characters at or below the last C0 code.
+        const auto isC0 = _mm_cmpeq_epi16(_mm_subs_epu16(chars, lastC0), _mm_setzero_si128());
+        const auto isDel = _mm_cmpeq_epi16(chars, del);
+        const auto isC1Csi = _mm_cmpeq_epi16(chars, c1Csi);
+        if (_mm_movemask_epi8(_mm_or_si128(isC0, _mm_or_si128(isDel, isC1Csi))) != 0)
+        {
+            // One of these eight is actionable. The loop below will find which.
+            break;
+        }
+    }
+#endif
+
+    for (; i < cch; ++i)
+    {
+        if (s_IsActionableFromGround(pwch[i]))
+        {
+            return i;
+        }
+    }
+    return cch;
+}
+
 // Routine Description:
 // - Determines if a character belongs to the C0 escape range.
 //   This is character sequences less than a space character (null, backspace, new line, etc.)
@@ -62,7 +119,7 @@ bool StateMachine::s_IsActionableFromGround(const wchar_t wch)
 // - wch - Character to check.
 // Return Value:
 // - True if it is. False if it isn't.
-bool StateMachine::s_IsC0Code(const wchar_t wch)
+constexpr bool StateMachine::s_IsC0Code(const wchar_t wch) noexcept
 {
     return (wch >= AsciiChars::NUL && wch <= AsciiChars::ETB) ||
            wch == AsciiChars::EM ||
@@ -88,7 +145,7 @@ bool StateMachine::s_IsC0Code(const wchar_t wch)
 // - wch - Character to check.
 // Return Value:
 // - True if it is. False if it isn't.
-bool StateMachine::s_IsC1Csi(const wchar_t wch)
+constexpr bool StateMachine::s_IsC1Csi(const wchar_t wch) noexcept
 {
     return wch == L'\x9b';
 }
@@ -102,7 +159,7 @@ bool StateMachine::s_IsC1Csi(const wchar_t wch)
 // - wch - Character to check.
 // Return Value:
 // - True if it is. False if it isn't.
-bool StateMachine::s_IsIntermediate(const wchar_t wch)
+constexpr bool StateMachine::s_IsIntermediate(const wchar_t wch) noexcept
 {
     return wch >= L' ' && wch <= L'/'; // 0x20 - 0x2F
 }
@@ -113,7 +170,7 @@ bool StateMachine::s_IsIntermediate(const wchar_t wch)
 // - wch - Character to check.
 // Return Value:
 // - True if it is. False if it isn't.
-bool StateMachine::s_IsDelete(const wchar_t wch)
+constexpr bool StateMachine::s_IsDelete(const wchar_t wch) noexcept
 {
     return wch == AsciiChars::DEL;
 }
@@ -125,7 +182,7 @@ bool StateMachine::s_IsDelete(const wchar_t wch)
 // - wch - Character to check.
 // Return Value:
 // - True if it is. False if it isn't.
-bool StateMachine::s_IsEscape(const wchar_t wch)
+constexpr bool StateMachine::s_IsEscape(const wchar_t wch) noexcept
 {
     return wch == AsciiChars::ESC;
 }
@@ -137,7 +194,7 @@ bool StateMachine::s_IsEscape(const wchar_t wch)
 // - wch - Character to check.
 // Return Value:
 // - True if it is. False if it isn't.
-bool StateMachine::s_IsCsiIndicator(const wchar_t wch)
+constexpr bool StateMachine::s_IsCsiIndicator(const wchar_t wch) noexcept
 {
     return wch == L'['; // 0x5B
 }
@@ -150,23 +207,11 @@ bool StateMachine::s_IsCsiIndicator(const wchar_t wch)
 // - wch - Character to check.
 // Return Value:
 // - True if it is. False if it isn't.
-bool StateMachine::s_IsCsiDelimiter(const wchar_t wch)
+constexpr bool StateMachine::s_IsCsiDelimiter(const wchar_t wch) noexcept
 {
     return wch == L';'; // 0x3B
 }
 
-// Routine Description:
-// - Determines if a character is a valid parameter value
-//   Parameters must be numerical digits.
-// Arguments:
-// - wch - Character to check.
-// Return Value:
-// - True if it is. False if it isn't.
-bool StateMachine::s_IsCsiParamValue(const wchar_t wch)
-{
-    return wch >= L'0' && wch <= L'9'; // 0x30 - 0x39
-}
-
 // Routine Description:
 // - Determines if a character is a private range marker for a control sequence.
 //   Private range markers indicate vendor-specific behavior.
@@ -174,7 +219,7 @@ bool StateMachine::s_IsCsiParamValue(const wchar_t wch)
 // - wch - Character to check.
 // Return Value:
 // - True if it is. False if it isn't.
-bool StateMachine::s_IsCsiPrivateMarker(const wchar_t wch)
+constexpr bool StateMachine::s_IsCsiPrivateMarker(const wchar_t wch) noexcept
 {
     return wch == L'<' || wch == L'=' || wch == L'>' || wch == L'?'; // 0x3C - 0x3F
 }
@@ -185,7 +230,7 @@ bool StateMachine::s_IsCsiPrivateMarker(const wchar_t wch)
 // - wch - Character to check.
 // Return Value:
 // - True if it is. False if it isn't.
-bool StateMachine::s_IsCsiInvalid(const wchar_t wch)
+constexpr bool StateMachine::s_IsCsiInvalid(const wchar_t wch) noexcept
 {
     return wch == L':'; // 0x3A
 }
@@ -199,7 +244,7 @@ bool StateMachine::s_IsCsiInvalid(const wchar_t wch)
 // - wch - Character to check.
 // Return Value:
 // - True if it is. False if it isn't.
-bool StateMachine::s_IsSs3Indicator(const wchar_t wch)
+constexpr bool StateMachine::s_IsSs3Indicator(const wchar_t wch) noexcept
 {
     return wch == L'O'; // 0x4F
 }
@@ -211,61 +256,11 @@ bool StateMachine::s_IsSs3Indicator(const wchar_t wch)
 // - wch - Character to check.
 // Return Value:
 // - True if it is. False if it isn't.
-bool StateMachine::s_IsOscIndicator(const wchar_t wch)
+constexpr bool StateMachine::s_IsOscIndicator(const wchar_t wch) noexcept
 {
     return wch == L']'; // 0x5D
 }
 
-// Routine Description:
-// - Determines if a character is a delimiter between two parameters in a "operating system control sequence"
-//   This occurs in the middle of a control sequence after escape and OscIndicator have been recognized,
-//   after the paramater indicating which OSC action to take.
-// Arguments:
-// - wch - Character to check.
-// Return Value:
-// - True if it is. False if it isn't.
-bool StateMachine::s_IsOscDelimiter(const wchar_t wch)
-{
-    return wch == L';'; // 0x3B
-}
-
-// Routine Description:
-// - Determines if a character is a valid parameter value for an OSC String,
-//     that is, the indicator of which OSC action to take.
-//   Parameters must be numerical digits.
-// Arguments:
-// - wch - Character to check.
-// Return Value:
-// - True if it is. False if it isn't.
-bool StateMachine::s_IsOscParamValue(const wchar_t wch)
-{
-    return s_IsNumber(wch); // 0x30 - 0x39
-}
-
-// Routine Description:
-// - Determines if a character should be initiate the end of an OSC sequence.
-// Arguments:
-// - wch - Character to check.
-// Return Value:
-// - True if it is. False if it isn't.
-bool StateMachine::s_IsOscTerminationInitiator(const wchar_t wch)
-{
-    return wch == AsciiChars::ESC;
-}
-
-// Routine Description:
-// - Determines if a character should be ignored in a operating system control sequence
-// Arguments:
-// - wch - Character to check.
-// Return Value:
-// - True if it is. False if it isn't.
-bool StateMachine::s_IsOscInvalid(const wchar_t wch)
-{
-    return wch <= L'\x17' ||
-           wch == L'\x19' ||
-           (wch >= L'\x1c' && wch <= L'\x1f');
-}
-
 // Routine Description:
 // - Determines if a character is "operating system control string" termination indicator.
 //   This signals the end of an OSC string collection.
@@ -273,7 +268,7 @@ bool StateMachine::s_IsOscInvalid(const wchar_t wch)
 // - wch - Character to check.
 // Return Value:
 // - True if it is. False if it isn't.
-bool StateMachine::s_IsOscTerminator(const wchar_t wch)
+constexpr bool StateMachine::s_IsOscTerminator(const wchar_t wch) noexcept
 {
     return wch == L'\x7' || wch == L'\x9C'; // Bell character or C1 terminator
 }
@@ -284,7 +279,7 @@ bool StateMachine::s_IsOscTerminator(const wchar_t wch)
 // - wch - Character to check.
 // Return Value:
 // - True if it is. False if it isn't.
-bool StateMachine::s_IsNumber(const wchar_t wch)
+constexpr bool StateMachine::s_IsNumber(const wchar_t wch) noexcept
 {
     return wch >= L'0' && wch <= L'9'; // 0x30 - 0x39
 }
@@ -794,459 +789,404 @@ void StateMachine::_EnterSs3Param()
 }
 
 // Routine Description:
-// - Processes a character event into an Action that occurs while in the Ground state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Handle a C1 Control Sequence Introducer
-//   3. Print all other characters
+// - Sorts every character the class table covers into the class that decides how it acts.
+//   Where a character would fit in more than one class, the first check that matches wins,
+//   in the same order the states used to test for them.
 // Arguments:
-// - wch - Character that triggered the event
-// Return Value:
 // - <none>
-void StateMachine::_EventGround(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"Ground");
-    if (s_IsC0Code(wch) || s_IsDelete(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (s_IsC1Csi(wch))
-    {
-        _EnterCsiEntry();
-    }
-    else
-    {
-        _ActionPrint(wch);
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the Escape state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Enter Control Sequence state
-//   5. Dispatch an Escape action.
-// Arguments:
-// - wch - Character that triggered the event
 // Return Value:
-// - <none>
-void StateMachine::_EventEscape(const wchar_t wch)
+// - The class of each character below s_cClassifiedChars.
+constexpr StateMachine::CharClassTable StateMachine::s_BuildCharClasses() noexcept
 {
-    _trace.TraceOnEvent(L"Escape");
-    if (s_IsC0Code(wch))
+    CharClassTable classes{};
+    for (size_t i = 0; i < classes.size(); i++)
     {
-        if (_pEngine->DispatchControlCharsFromEscape())
+        const auto wch = static_cast<wchar_t>(i);
+        auto charClass = CharClasses::Other;
+        if (wch == AsciiChars::CAN || wch == AsciiChars::SUB)
         {
-            _ActionExecuteFromEscape(wch);
-            _EnterGround();
+            charClass = CharClasses::CancelOrSubstitute;
         }
-        else
+        else if (s_IsEscape(wch))
         {
-            _ActionExecute(wch);
+            charClass = CharClasses::Escape;
         }
-    }
-    else if (s_IsDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (s_IsIntermediate(wch))
-    {
-        if (_pEngine->DispatchIntermediatesFromEscape())
+        else if (wch == AsciiChars::BEL)
         {
-            _ActionEscDispatch(wch);
-            _EnterGround();
+            // BEL is a C0 code, but it also terminates OSC strings.
+            charClass = CharClasses::Bell;
         }
-        else
+        else if (s_IsC0Code(wch))
         {
-            _ActionCollect(wch);
-            _EnterEscapeIntermediate();
+            charClass = CharClasses::C0Code;
         }
+        else if (s_IsIntermediate(wch))
+        {
+            charClass = CharClasses::Intermediate;
+        }
+        else if (s_IsNumber(wch))
+        {
+            charClass = CharClasses::Number;
+        }
+        else if (s_IsCsiInvalid(wch))
+        {
+            charClass = CharClasses::CsiInvalid;
+        }
+        else if (s_IsCsiDelimiter(wch))
+        {
+            charClass = CharClasses::Delimiter;
+        }
+        else if (s_IsCsiPrivateMarker(wch))
+        {
+            charClass = CharClasses::CsiPrivateMarker;
+        }
+        else if (s_IsCsiIndicator(wch))
+        {
+            charClass = CharClasses::CsiIndicator;
+        }
+        else if (s_IsOscIndicator(wch))
+        {
+            charClass = CharClasses::OscIndicator;
+        }
+        else if (s_IsSs3Indicator(wch))
+        {
+            charClass = CharClasses::Ss3Indicator;
+        }
+        else if (s_IsDelete(wch))
+        {
+            charClass = CharClasses::Delete;
+        }
+        else if (s_IsC1Csi(wch))
+        {
+            charClass = CharClasses::C1Csi;
+        }
+        else if (s_IsOscTerminator(wch))
+        {
+            charClass = CharClasses::C1StringTerminator;
+        }
+        classes[i] = charClass;
     }
-    else if (s_IsCsiIndicator(wch))
-    {
-        _EnterCsiEntry();
-    }
-    else if (s_IsOscIndicator(wch))
-    {
-        _EnterOscParam();
-    }
-    else if (s_IsSs3Indicator(wch))
-    {
-        _EnterSs3Entry();
-    }
-    else
-    {
-        _ActionEscDispatch(wch);
-        _EnterGround();
-    }
+    return classes;
 }
 
 // Routine Description:
-// - Processes a character event into an Action that occurs while in the EscapeIntermediate state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Dispatch an Escape action.
+// - Builds the table of what each class of character does in each state: the action
+//   to take for it, and the state to enter after the action, if any.
+//   Rows start out with what most characters do in that state, and then the classes
+//   that act differently are filled in over it.
+//   The states are based on http://vt100.net/emu/dec_ansi_parser
 // Arguments:
-// - wch - Character that triggered the event
-// Return Value:
 // - <none>
-void StateMachine::_EventEscapeIntermediate(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"EscapeIntermediate");
-    if (s_IsC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (s_IsIntermediate(wch))
-    {
-        _ActionCollect(wch);
-    }
-    else if (s_IsDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else
-    {
-        _ActionEscDispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiEntry state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Store parameter data
-//   6. Collect Control Sequence Private markers
-//   7. Dispatch a control sequence with parameters for action
-// Arguments:
-// - wch - Character that triggered the event
 // Return Value:
-// - <none>
-void StateMachine::_EventCsiEntry(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"CsiEntry");
-    if (s_IsC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (s_IsDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (s_IsIntermediate(wch))
-    {
-        _ActionCollect(wch);
-        _EnterCsiIntermediate();
-    }
-    else if (s_IsCsiInvalid(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else if (s_IsCsiParamValue(wch) || s_IsCsiDelimiter(wch))
-    {
-        _ActionParam(wch);
-        _EnterCsiParam();
-    }
-    else if (s_IsCsiPrivateMarker(wch))
-    {
-        _ActionCollect(wch);
-        _EnterCsiParam();
-    }
-    else
-    {
-        _ActionCsiDispatch(wch);
-        _EnterGround();
-    }
-}
-
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiIntermediate state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Dispatch a control sequence with parameters for action
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventCsiIntermediate(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"CsiIntermediate");
-    if (s_IsC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (s_IsIntermediate(wch))
-    {
-        _ActionCollect(wch);
-    }
-    else if (s_IsDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (s_IsCsiParamValue(wch) || s_IsCsiInvalid(wch) || s_IsCsiDelimiter(wch) || s_IsCsiPrivateMarker(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else
-    {
-        _ActionCsiDispatch(wch);
-        _EnterGround();
-    }
-}
+// - The transition for every state and character class.
+constexpr StateMachine::TransitionTable StateMachine::s_BuildTransitions() noexcept
+{
+    TransitionTable table{};
+
+    const auto stay = [](const Actions action) constexpr {
+        return Transition{ action, false, VTStates::Ground };
+    };
+    const auto enter = [](const Actions action, const VTStates state) constexpr {
+        return Transition{ action, true, state };
+    };
+
+    // The C0 codes are executed in most states, and DEL is ignored in most states.
+    const auto setControls = [&](auto& row) constexpr {
+        row[static_cast<size_t>(CharClasses::C0Code)] = stay(Actions::Execute);
+        row[static_cast<size_t>(CharClasses::Bell)] = stay(Actions::Execute);
+        row[static_cast<size_t>(CharClasses::Delete)] = stay(Actions::Ignore);
+    };
+
+    for (size_t state = 0; state < table.size(); state++)
+    {
+        auto& row = table[state];
+        const auto fill = [&row](const Transition transition) constexpr {
+            for (auto& cell : row)
+            {
+                cell = transition;
+            }
+        };
+        const auto set = [&row](const CharClasses charClass, const Transition transition) constexpr {
+            row[static_cast<size_t>(charClass)] = transition;
+        };
 
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiIgnore state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Return to Ground
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventCsiIgnore(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"CsiIgnore");
-    if (s_IsC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (s_IsDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (s_IsIntermediate(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (s_IsCsiParamValue(wch) || s_IsCsiInvalid(wch) || s_IsCsiDelimiter(wch) || s_IsCsiPrivateMarker(wch))
-    {
-        _ActionIgnore();
-    }
-    else
-    {
-        _EnterGround();
-    }
-}
+        switch (static_cast<VTStates>(state))
+        {
+        case VTStates::Ground:
+            // 1. Execute C0 control characters
+            // 2. Handle a C1 Control Sequence Introducer
+            // 3. Print all other characters
+            fill(stay(Actions::Print));
+            setControls(row);
+            set(CharClasses::Delete, stay(Actions::Execute));
+            set(CharClasses::C1Csi, enter(Actions::None, VTStates::CsiEntry));
+            break;
+        case VTStates::Escape:
+            // 1. Execute C0 control characters
+            // 2. Ignore Delete characters
+            // 3. Collect Intermediate characters
+            // 4. Enter Control Sequence state
+            // 5. Dispatch an Escape action.
+            fill(enter(Actions::EscDispatch, VTStates::Ground));
+            setControls(row);
+            set(CharClasses::C0Code, stay(Actions::ExecuteFromEscape));
+            set(CharClasses::Bell, stay(Actions::ExecuteFromEscape));
+            set(CharClasses::Intermediate, stay(Actions::CollectFromEscape));
+            set(CharClasses::CsiIndicator, enter(Actions::None, VTStates::CsiEntry));
+            set(CharClasses::OscIndicator, enter(Actions::None, VTStates::OscParam));
+            set(CharClasses::Ss3Indicator, enter(Actions::None, VTStates::Ss3Entry));
+            break;
+        case VTStates::EscapeIntermediate:
+            // 1. Execute C0 control characters
+            // 2. Ignore Delete characters
+            // 3. Collect Intermediate characters
+            // 4. Dispatch an Escape action.
+            fill(enter(Actions::EscDispatch, VTStates::Ground));
+            setControls(row);
+            set(CharClasses::Intermediate, stay(Actions::Collect));
+            break;
+        case VTStates::CsiEntry:
+            // 1. Execute C0 control characters
+            // 2. Ignore Delete characters
+            // 3. Collect Intermediate characters
+            // 4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
+            // 5. Store parameter data
+            // 6. Collect Control Sequence Private markers
+            // 7. Dispatch a control sequence with parameters for action
+            fill(enter(Actions::CsiDispatch, VTStates::Ground));
+            setControls(row);
+            set(CharClasses::Intermediate, enter(Actions::Collect, VTStates::CsiIntermediate));
+            set(CharClasses::CsiInvalid, enter(Actions::None, VTStates::CsiIgnore));
+            set(CharClasses::Number, enter(Actions::Param, VTStates::CsiParam));
+            set(CharClasses::Delimiter, enter(Actions::Param, VTStates::CsiParam));
+            set(CharClasses::CsiPrivateMarker, enter(Actions::Collect, VTStates::CsiParam));
+            break;
+        case VTStates::CsiIntermediate:
+            // 1. Execute C0 control characters
+            // 2. Ignore Delete characters
+            // 3. Collect Intermediate characters
+            // 4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
+            // 5. Dispatch a control sequence with parameters for action
+            fill(enter(Actions::CsiDispatch, VTStates::Ground));
+            setControls(row);
+            set(CharClasses::Intermediate, stay(Actions::Collect));
+            set(CharClasses::Number, enter(Actions::None, VTStates::CsiIgnore));
+            set(CharClasses::CsiInvalid, enter(Actions::None, VTStates::CsiIgnore));
+            set(CharClasses::Delimiter, enter(Actions::None, VTStates::CsiIgnore));
+            set(CharClasses::CsiPrivateMarker, enter(Actions::None, VTStates::CsiIgnore));
+            break;
+        case VTStates::CsiIgnore:
+            // 1. Execute C0 control characters
+            // 2. Ignore Delete characters
+            // 3. Ignore Intermediate characters and parameter data
+            // 4. Return to Ground on anything else
+            fill(enter(Actions::None, VTStates::Ground));
+            setControls(row);
+            set(CharClasses::Intermediate, stay(Actions::Ignore));
+            set(CharClasses::Number, stay(Actions::Ignore));
+            set(CharClasses::CsiInvalid, stay(Actions::Ignore));
+            set(CharClasses::Delimiter, stay(Actions::Ignore));
+            set(CharClasses::CsiPrivateMarker, stay(Actions::Ignore));
+            break;
+        case VTStates::CsiParam:
+            // 1. Execute C0 control characters
+            // 2. Ignore Delete characters
+            // 3. Collect Intermediate characters
+            // 4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
+            // 5. Store parameter data
+            // 6. Dispatch a control sequence with parameters for action
+            fill(enter(Actions::CsiDispatch, VTStates::Ground));
+            setControls(row);
+            set(CharClasses::Number, stay(Actions::Param));
+            set(CharClasses::Delimiter, stay(Actions::Param));
+            set(CharClasses::Intermediate, enter(Actions::Collect, VTStates::CsiIntermediate));
+            set(CharClasses::CsiInvalid, enter(Actions::None, VTStates::CsiIgnore));
+            set(CharClasses::CsiPrivateMarker, enter(Actions::None, VTStates::CsiIgnore));
+            break;
+        case VTStates::OscParam:
+            // 1. Collect numeric values into an Osc Param
+            // 2. Move to the OscString state on a delimiter
+            // 3. Return to Ground on an OscTerminator
+            // 4. Ignore everything else.
+            fill(stay(Actions::Ignore));
+            set(CharClasses::Bell, enter(Actions::None, VTStates::Ground));
+            set(CharClasses::C1StringTerminator, enter(Actions::None, VTStates::Ground));
+            set(CharClasses::Number, stay(Actions::OscParam));
+            set(CharClasses::Delimiter, enter(Actions::None, VTStates::OscString));
+            break;
+        case VTStates::OscString:
+            // 1. Trigger the OSC action associated with the param on an OscTerminator
+            // 2. If we see a ESC, enter the OscTermination state. We'll wait for one
+            //    more character before we dispatch the string.
+            // 3. Ignore C0 control characters.
+            // 4. Collect everything else into the OscString
+            fill(stay(Actions::OscPut));
+            set(CharClasses::Bell, enter(Actions::OscDispatch, VTStates::Ground));
+            set(CharClasses::C1StringTerminator, enter(Actions::OscDispatch, VTStates::Ground));
+            set(CharClasses::C0Code, stay(Actions::Ignore));
+            break;
+        case VTStates::OscTermination:
+            // 1. Trigger the OSC action associated with the param on any character
+            fill(enter(Actions::OscDispatch, VTStates::Ground));
+            break;
+        case VTStates::Ss3Entry:
+            // 1. Execute C0 control characters
+            // 2. Ignore Delete characters
+            // 3. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
+            // 4. Store parameter data
+            // 5. Dispatch a control sequence with parameters for action
+            //  SS3 sequences are structurally the same as CSI sequences, just with a
+            //      different initiation, and they ignore characters the same way.
+            fill(enter(Actions::Ss3Dispatch, VTStates::Ground));
+            setControls(row);
+            set(CharClasses::CsiInvalid, enter(Actions::None, VTStates::CsiIgnore));
+            set(CharClasses::Number, enter(Actions::Param, VTStates::Ss3Param));
+            set(CharClasses::Delimiter, enter(Actions::Param, VTStates::Ss3Param));
+            break;
+        case VTStates::Ss3Param:
+            // 1. Execute C0 control characters
+            // 2. Ignore Delete characters
+            // 3. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
+            // 4. Store parameter data
+            // 5. Dispatch a control sequence with parameters for action
+            fill(enter(Actions::Ss3Dispatch, VTStates::Ground));
+            setControls(row);
+            set(CharClasses::Number, stay(Actions::Param));
+            set(CharClasses::Delimiter, stay(Actions::Param));
+            set(CharClasses::CsiInvalid, enter(Actions::None, VTStates::CsiIgnore));
+            set(CharClasses::CsiPrivateMarker, enter(Actions::None, VTStates::CsiIgnore));
+            break;
+        }
 
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiParam state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Collect Intermediate characters
-//   4. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   5. Store parameter data
-//   6. Dispatch a control sequence with parameters for action
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventCsiParam(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"CsiParam");
-    if (s_IsC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (s_IsDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (s_IsCsiParamValue(wch) || s_IsCsiDelimiter(wch))
-    {
-        _ActionParam(wch);
-    }
-    else if (s_IsIntermediate(wch))
-    {
-        _ActionCollect(wch);
-        _EnterCsiIntermediate();
-    }
-    else if (s_IsCsiInvalid(wch) || s_IsCsiPrivateMarker(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else
-    {
-        _ActionCsiDispatch(wch);
-        _EnterGround();
+        // Then the "from anywhere" events, which act the same in every state.
+        set(CharClasses::CancelOrSubstitute, enter(Actions::Execute, VTStates::Ground));
+        // Don't go to escape from the OSC string state - ESC can be used to
+        //      terminate OSC strings.
+        if (static_cast<VTStates>(state) == VTStates::OscString)
+        {
+            set(CharClasses::Escape, enter(Actions::None, VTStates::OscTermination));
+        }
+        else
+        {
+            set(CharClasses::Escape, enter(Actions::None, VTStates::Escape));
+        }
     }
-}
 
-// Routine Description:
-// - Processes a character event into an Action that occurs while in the OscParam state.
-//   Events in this state will:
-//   1. Collect numeric values into an Osc Param
-//   2. Move to the OscString state on a delimiter
-//   3. Ignore everything else.
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventOscParam(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"OscParam");
-    if (s_IsOscTerminator(wch))
-    {
-        _EnterGround();
-    }
-    else if (s_IsOscParamValue(wch))
-    {
-        _ActionOscParam(wch);
-    }
-    else if (s_IsOscDelimiter(wch))
-    {
-        _EnterOscString();
-    }
-    else
-    {
-        _ActionIgnore();
-    }
+    return table;
 }
 
-// Routine Description:
-// - Processes a character event into a Action that occurs while in the OscParam state.
-//   Events in this state will:
-//   1. Trigger the OSC action associated with the param on an OscTerminator
-//   2. If we see a ESC, enter the OscTermination state. We'll wait for one
-//      more character before we dispatch the string.
-//   3. Ignore OscInvalid characters.
-//   4. Collect everything else into the OscString
-// Arguments:
-// - wch - Character that triggered the event
-// Return Value:
-// - <none>
-void StateMachine::_EventOscString(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"OscString");
-    if (s_IsOscTerminator(wch))
-    {
-        _ActionOscDispatch(wch);
-        _EnterGround();
-    }
-    else if (s_IsOscTerminationInitiator(wch))
-    {
-        _EnterOscTermination();
-    }
-    else if (s_IsOscInvalid(wch))
-    {
-        _ActionIgnore();
-    }
-    else
-    {
-        // add this character to our OSC string
-        _ActionOscPut(wch);
-    }
-}
+constexpr StateMachine::CharClassTable StateMachine::s_charClasses = StateMachine::s_BuildCharClasses();
+constexpr StateMachine::TransitionTable StateMachine::s_transitions = StateMachine::s_BuildTransitions();
 
 // Routine Description:
-// - Handle the two-character termination of a OSC sequence.
-//   Events in this state will:
-//   1. Trigger the OSC action associated with the param on an OscTerminator
+// - Looks up the class of a character.
 // Arguments:
-// - wch - Character that triggered the event
+// - wch - Character to classify.
 // Return Value:
-// - <none>
-void StateMachine::_EventOscTermination(const wchar_t wch)
+// - The class that decides what the character does in each state.
+constexpr StateMachine::CharClasses StateMachine::s_ClassifyCharacter(const wchar_t wch) noexcept
 {
-    _trace.TraceOnEvent(L"OscTermination");
-
-    _ActionOscDispatch(wch);
-    _EnterGround();
+    return static_cast<size_t>(wch) < s_charClasses.size() ? s_charClasses[static_cast<size_t>(wch)] : CharClasses::Other;
 }
 
 // Routine Description:
-// - Processes a character event into an Action that occurs while in the Ss3Entry state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   4. Store parameter data
-//   5. Dispatch a control sequence with parameters for action
-//  SS3 sequences are structurally the same as CSI sequences, just with a
-//      different initiation. It's safe to reuse CSI's functions for
-//      determining if a character is a parameter, delimiter, or invalid.
+// - Moves the state machine into the given state.
 // Arguments:
-// - wch - Character that triggered the event
+// - state - The state to enter.
 // Return Value:
 // - <none>
-void StateMachine::_EventSs3Entry(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"Ss3Entry");
-    if (s_IsC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (s_IsDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (s_IsCsiInvalid(wch))
-    {
-        // It's safe for us to go into the CSI ignore here, because both SS3 and
-        //      CSI sequences ignore characters the same way.
-        _EnterCsiIgnore();
-    }
-    else if (s_IsCsiParamValue(wch) || s_IsCsiDelimiter(wch))
-    {
-        _ActionParam(wch);
-        _EnterSs3Param();
-    }
-    else
-    {
-        _ActionSs3Dispatch(wch);
-        _EnterGround();
+void StateMachine::_EnterState(const VTStates state)
+{
+    switch (state)
+    {
+    case VTStates::Ground:
+        return _EnterGround();
+    case VTStates::Escape:
+        return _EnterEscape();
+    case VTStates::EscapeIntermediate:
+        return _EnterEscapeIntermediate();
+    case VTStates::CsiEntry:
+        return _EnterCsiEntry();
+    case VTStates::CsiIntermediate:
+        return _EnterCsiIntermediate();
+    case VTStates::CsiIgnore:
+        return _EnterCsiIgnore();
+    case VTStates::CsiParam:
+        return _EnterCsiParam();
+    case VTStates::OscParam:
+        return _EnterOscParam();
+    case VTStates::OscString:
+        return _EnterOscString();
+    case VTStates::OscTermination:
+        return _EnterOscTermination();
+    case VTStates::Ss3Entry:
+        return _EnterSs3Entry();
+    case VTStates::Ss3Param:
+        return _EnterSs3Param();
+    default:
+        return;
     }
 }
 
 // Routine Description:
-// - Processes a character event into an Action that occurs while in the CsiParam state.
-//   Events in this state will:
-//   1. Execute C0 control characters
-//   2. Ignore Delete characters
-//   3. Begin to ignore all remaining parameters when an invalid character is detected (CsiIgnore)
-//   4. Store parameter data
-//   5. Dispatch a control sequence with parameters for action
+// - Takes the action a transition calls for on a character.
 // Arguments:
-// - wch - Character that triggered the event
+// - action - The action to take.
+// - wch - Character that triggered the transition.
 // Return Value:
 // - <none>
-void StateMachine::_EventSs3Param(const wchar_t wch)
-{
-    _trace.TraceOnEvent(L"Ss3Param");
-    if (s_IsC0Code(wch))
-    {
-        _ActionExecute(wch);
-    }
-    else if (s_IsDelete(wch))
-    {
-        _ActionIgnore();
-    }
-    else if (s_IsCsiParamValue(wch) || s_IsCsiDelimiter(wch))
-    {
-        _ActionParam(wch);
-    }
-    else if (s_IsCsiInvalid(wch) || s_IsCsiPrivateMarker(wch))
-    {
-        _EnterCsiIgnore();
-    }
-    else
-    {
-        _ActionSs3Dispatch(wch);
-        _EnterGround();
+void StateMachine::_PerformAction(const Actions action, const wchar_t wch)
+{
+    switch (action)
+    {
+    case Actions::Execute:
+        return _ActionExecute(wch);
+    case Actions::Print:
+        return _ActionPrint(wch);
+    case Actions::EscDispatch:
+        return _ActionEscDispatch(wch);
+    case Actions::Collect:
+        return _ActionCollect(wch);
+    case Actions::Param:
+        return _ActionParam(wch);
+    case Actions::CsiDispatch:
+        return _ActionCsiDispatch(wch);
+    case Actions::OscParam:
+        return _ActionOscParam(wch);
+    case Actions::OscPut:
+        return _ActionOscPut(wch);
+    case Actions::OscDispatch:
+        return _ActionOscDispatch(wch);
+    case Actions::Ss3Dispatch:
+        return _ActionSs3Dispatch(wch);
+    case Actions::Ignore:
+        return _ActionIgnore();
+    case Actions::ExecuteFromEscape:
+        if (_pEngine->DispatchControlCharsFromEscape())
+        {
+            _ActionExecuteFromEscape(wch);
+            _EnterGround();
+        }
+        else
+        {
+            _ActionExecute(wch);
+        }
+        return;
+    case Actions::CollectFromEscape:
+        if (_pEngine->DispatchIntermediatesFromEscape())
+        {
+            _ActionEscDispatch(wch);
+            _EnterGround();
+        }
+        else
+        {
+            _ActionCollect(wch);
+            _EnterEscapeIntermediate();
+        }
+        return;
+    case Actions::None:
+    default:
+        return;
     }
 }
 
@@ -1260,51 +1200,31 @@ void StateMachine::ProcessCharacter(const wchar_t wch)
 {
     _trace.TraceCharInput(wch);
 
-    // Process "from anywhere" events first.
-    if (wch == AsciiChars::CAN ||
-        wch == AsciiChars::SUB)
-    {
-        _ActionExecute(wch);
-        _EnterGround();
-    }
-    else if (s_IsEscape(wch) && _state != VTStates::OscString)
-    {
-        // Don't go to escape from the OSC string state - ESC can be used to
-        //      terminate OSC strings.
-        _EnterEscape();
-    }
-    else
-    {
-        // Then pass to the current state as an event
-        switch (_state)
-        {
-        case VTStates::Ground:
-            return _EventGround(wch);
-        case VTStates::Escape:
-            return _EventEscape(wch);
-        case VTStates::EscapeIntermediate:
-            return _EventEscapeIntermediate(wch);
-        case VTStates::CsiEntry:
-            return _EventCsiEntry(wch);
-        case VTStates::CsiIntermediate:
-            return _EventCsiIntermediate(wch);
-        case VTStates::CsiIgnore:
-            return _EventCsiIgnore(wch);
-        case VTStates::CsiParam:
-            return _EventCsiParam(wch);
-        case VTStates::OscParam:
-            return _EventOscParam(wch);
-        case VTStates::OscString:
-            return _EventOscString(wch);
-        case VTStates::OscTermination:
-            return _EventOscTermination(wch);
-        case VTStates::Ss3Entry:
-            return _EventSs3Entry(wch);
-        case VTStates::Ss3Param:
-            return _EventSs3Param(wch);
-        default:
-            return;
-        }
+    static constexpr std::array<PCWSTR, s_cStates> s_stateNames{
+        L"Ground",
+        L"Escape",
+        L"EscapeIntermediate",
+        L"CsiEntry",
+        L"CsiIntermediate",
+        L"CsiIgnore",
+        L"CsiParam",
+        L"OscParam",
+        L"OscString",
+        L"OscTermination",
+        L"Ss3Entry",
+        L"Ss3Param"
+    };
+
+    // Look up what this character does in the current state, take that
+    // action, and then move on to the next state if there is one.
+    const auto state = static_cast<size_t>(_state);
+    const auto& transition = s_transitions[state][static_cast<size_t>(s_ClassifyCharacter(wch))];
+    _trace.TraceOnEvent(s_stateNames[state]);
+
+    _PerformAction(transition.action, wch);
+    if (transition.fEnter)
+    {
+        _EnterState(transition.nextState);
     }
 }
 // Method Description:
@@ -1314,8 +1234,8 @@ void StateMachine::ProcessCharacter(const wchar_t wch)
 //      get handed to the OutputStateMachineEngine, so that it can write strings
 //      it doesn't understand to the tty.
 //  This does not modify the state of the state machine. Callers should be in
-//      the Action*Dispatch state, and upon completion, the state's handler (eg
-//      _EventCsiParam) should move us into the ground state.
+//      the Action*Dispatch state, and upon completion, the transition that called for
+//      the dispatch should move us into the ground state.
 // Arguments:
 // - <none>
 // Return Value:
@@ -1342,6 +1262,9 @@ bool StateMachine::FlushToTerminal()
 // - <none>
 void StateMachine::ProcessString(const wchar_t* const rgwch, const size_t cch)
 {
+    const AllocationScope allocationScope{ AllocationTag::Parser };
+    const OutputTracing::ParseScope parseTracing{ cch };
+
     _pwchCurr = rgwch;
     _pwchSequenceStart = rgwch;
     _currRunLength = 0;
@@ -1350,13 +1273,15 @@ void StateMachine::ProcessString(const wchar_t* const rgwch, const size_t cch)
     //   we want the partial sequence state to persist.
     static bool s_fProcessIndividually = false;
 
-    for (size_t cchCharsRemaining = cch; cchCharsRemaining > 0; cchCharsRemaining--)
+    size_t cchCharsRemaining = cch;
+    while (cchCharsRemaining > 0)
     {
         if (s_fProcessIndividually)
         {
             // If we're processing characters individually, send it to the state machine.
             ProcessCharacter(*_pwchCurr);
             _pwchCurr++;
+            cchCharsRemaining--;
             if (_state == VTStates::Ground) // Then check if we're back at ground. If we are, the next character (pwchCurr)
             { //   is the start of the next run of characters that might be printable.
                 s_fProcessIndividually = false;
@@ -1366,7 +1291,13 @@ void StateMachine::ProcessString(const wchar_t* const rgwch, const size_t cch)
         }
         else
         {
-            if (s_IsActionableFromGround(*_pwchCurr)) // If the current char is the start of an escape sequence, or should be executed in ground state...
+            // Skip over all of the printable chars in one go and add them to the current run to be printed.
+            const size_t cchPrintable = s_FindActionableFromGround(_pwchCurr, cchCharsRemaining);
+            _currRunLength += cchPrintable;
+            _pwchCurr += cchPrintable;
+            cchCharsRemaining -= cchPrintable;
+
+            if (cchCharsRemaining > 0) // If we stopped at the start of an escape sequence, or a char that should be executed in ground state...
             {
                 FAIL_FAST_IF(!(_pwchSequenceStart + _currRunLength <= rgwch + cch));
                 _pEngine->ActionPrintString(_pwchSequenceStart, _currRunLength); // ... print all the chars leading up to it as part of the run...
@@ -1381,12 +1312,9 @@ void StateMachine::ProcessString(const wchar_t* const rgwch, const size_t cch)
                     _pwchSequenceStart = _pwchCurr + 1;
                     _currRunLength = 0;
                 }
+                _pwchCurr++;
+                cchCharsRemaining--;
             }
-            else
-            {
-                _currRunLength++; // Otherwise, add this char to the current run to be printed.
-            }
-            _pwchCurr++;
         }
     }
 
@@ -1441,6 +1369,151 @@ void StateMachine::ProcessString(const std::wstring& wstr)
     return ProcessString(wstr.c_str(), wstr.length());
 }
 
+// Routine Description:
+// - Helper for entry to the state machine with UTF-8 text. The bytes are decoded
+//     and parsed a chunk at a time, so the decoded text never has to be held
+//     all at once and stays in cache between the two steps. ASCII, which is
+//     every byte of a VT sequence, is widened without going through the decoder.
+// - A character that's cut off at the end of the string is kept until the rest
+//     of its bytes arrive with the next string.
+// Arguments:
+// - utf8 - The UTF-8 encoded text to operate upon
+// Return Value:
+// - <none>
+void StateMachine::ProcessUtf8String(const std::string_view utf8)
+{
+    const char* pch = utf8.data();
+    size_t cch = utf8.size();
+
+    // Finish off the character left over from the last string first.
+    if (_cchUtf8Partial > 0)
+    {
+        const size_t cchNeeded = s_Utf8SequenceLength(_rgchUtf8Partial[0]);
+        while (_cchUtf8Partial < cchNeeded && cch > 0 && (*pch & 0xC0) == 0x80)
+        {
+            _rgchUtf8Partial[_cchUtf8Partial++] = *pch++;
+            cch--;
+        }
+
+        if (_cchUtf8Partial < cchNeeded && cch == 0)
+        {
+            return;
+        }
+
+        // If the character was never finished, this decodes it as a replacement character.
+        const size_t cchPartial = _cchUtf8Partial;
+        _cchUtf8Partial = 0;
+        _ProcessUtf8Chunk(_rgchUtf8Partial, cchPartial);
+    }
+
+    while (cch > 0)
+    {
+        const bool fLastChunk = cch <= s_cUtf8ChunkMax;
+        const size_t cchChunk = s_FindUtf8SplitPoint(pch, fLastChunk ? cch : s_cUtf8ChunkMax);
+        if (cchChunk > 0)
+        {
+            _ProcessUtf8Chunk(pch, cchChunk);
+            pch += cchChunk;
+            cch -= cchChunk;
+        }
+
+        if (fLastChunk)
+        {
+            std::copy(pch, pch + cch, _rgchUtf8Partial);
+            _cchUtf8Partial = cch;
+            break;
+        }
+    }
+}
+
+// Routine Description:
+// - Decodes a chunk of UTF-8 text and feeds it to the state machine.
+// Arguments:
+// - pch - The UTF-8 text. It must not end partway through a character.
+// - cch - Count of bytes in the text. No more than s_cUtf8ChunkMax.
+// Return Value:
+// - <none>
+void StateMachine::_ProcessUtf8Chunk(const char* const pch, const size_t cch)
+{
+    if (!_rgwchUtf8Chunk)
+    {
+        _rgwchUtf8Chunk = std::make_unique<wchar_t[]>(s_cUtf8ChunkMax);
+    }
+    wchar_t* const pwch = _rgwchUtf8Chunk.get();
+
+    // No byte ever decodes to more than one UTF-16 code unit, so the chunk always fits.
+    size_t cwch = 0;
+    while (cwch < cch && static_cast<unsigned char>(pch[cwch]) < 0x80)
+    {
+        pwch[cwch] = static_cast<wchar_t>(pch[cwch]);
+        cwch++;
+    }
+
+    if (cwch < cch)
+    {
+        const int cwchDecoded = MultiByteToWideChar(CP_UTF8,
+                                                    0,
+                                                    pch + cwch,
+                                                    gsl::narrow<int>(cch - cwch),
+                                                    pwch + cwch,
+                                                    gsl::narrow<int>(s_cUtf8ChunkMax - cwch));
+        THROW_LAST_ERROR_IF(cwchDecoded == 0);
+        cwch += cwchDecoded;
+    }
+
+    ProcessString(pwch, cwch);
+}
+
+// Routine Description:
+// - Determines how many bytes make up the UTF-8 character starting with the given byte.
+// Arguments:
+// - chLead - The first byte of the character
+// Return Value:
+// - The length of the character in bytes. Bytes that can't start a character count as one.
+constexpr size_t StateMachine::s_Utf8SequenceLength(const char chLead) noexcept
+{
+    const auto byte = static_cast<unsigned char>(chLead);
+    if (byte >= 0xF8)
+    {
+        return 1;
+    }
+    else if (byte >= 0xF0)
+    {
+        return 4;
+    }
+    else if (byte >= 0xE0)
+    {
+        return 3;
+    }
+    else if (byte >= 0xC0)
+    {
+        return 2;
+    }
+    return 1;
+}
+
+// Routine Description:
+// - Finds where UTF-8 text can be cut without splitting a character.
+// Arguments:
+// - pch - The UTF-8 text
+// - cch - Count of bytes in the text
+// Return Value:
+// - The number of bytes at the start of the text that are whole characters.
+size_t StateMachine::s_FindUtf8SplitPoint(const char* const pch, const size_t cch) noexcept
+{
+    // Characters are at most four bytes, so the last character starts in the last four bytes.
+    const size_t cchLookBack = std::min<size_t>(cch, 4);
+    for (size_t i = 1; i <= cchLookBack; i++)
+    {
+        const char ch = pch[cch - i];
+        if ((ch & 0xC0) != 0x80)
+        {
+            return s_Utf8SequenceLength(ch) > i ? cch - i : cch;
+        }
+    }
+    return cch;
+}
+
 // Routine Description:
 // - Wherever the state machine is, whatever it's going, go back to ground.
 //     This is used by conhost to "jiggle the handle" - when VT support is
@@ -1451,5 +1524,6 @@ void StateMachine::ProcessString(const std::wstring& wstr)
 // - <none>
 void StateMachine::ResetState()
 {
+    _cchUtf8Partial = 0;
     _EnterGround();
 }
@@ -17,6 +17,7 @@ Abstract:
 #include "IStateMachineEngine.hpp"
 #include "telemetry.hpp"
 #include "tracing.hpp"
+#include <array>
 #include <memory>
 
 namespace Microsoft::Console::VirtualTerminal
@@ -34,6 +35,7 @@ namespace Microsoft::Console::VirtualTerminal
         void ProcessCharacter(const wchar_t wch);
         void ProcessString(const wchar_t* const rgwch, const size_t cch);
         void ProcessString(const std::wstring& wstr);
+        void ProcessUtf8String(const std::string_view utf8);
 
         void ResetState();
 
@@ -45,29 +47,107 @@ namespace Microsoft::Console::VirtualTerminal
         static const short s_cIntermediateMax = 1;
         static const short s_cParamsMax = 16;
         static const short s_cOscStringMaxLength = 256;
+        static const size_t s_cUtf8ChunkMax = 4096;
 
     private:
+        enum class VTStates
+        {
+            Ground,
+            Escape,
+            EscapeIntermediate,
+            CsiEntry,
+            CsiIntermediate,
+            CsiIgnore,
+            CsiParam,
+            OscParam,
+            OscString,
+            OscTermination,
+            Ss3Entry,
+            Ss3Param
+        };
+        static constexpr size_t s_cStates = static_cast<size_t>(VTStates::Ss3Param) + 1;
+
+        // Every character is sorted into one of these classes. All of the
+        // characters in a class act the same way in every state.
+        enum class CharClasses : unsigned char
+        {
+            Other,
+            C0Code,
+            Bell,
+            CancelOrSubstitute,
+            Escape,
+            Intermediate,
+            Number,
+            CsiInvalid,
+            Delimiter,
+            CsiPrivateMarker,
+            CsiIndicator,
+            OscIndicator,
+            Ss3Indicator,
+            Delete,
+            C1Csi,
+            C1StringTerminator
+        };
+        static constexpr size_t s_cCharClasses = static_cast<size_t>(CharClasses::C1StringTerminator) + 1;
+
+        // Characters past the end of the class table are all CharClasses::Other.
+        static constexpr size_t s_cClassifiedChars = 0xA0;
+
+        enum class Actions : unsigned char
+        {
+            None,
+            Execute,
+            Print,
+            EscDispatch,
+            Collect,
+            Param,
+            CsiDispatch,
+            OscParam,
+            OscPut,
+            OscDispatch,
+            Ss3Dispatch,
+            Ignore,
+            // The engine decides what these do, so they pick the next state themselves.
+            ExecuteFromEscape,
+            CollectFromEscape
+        };
+
+        struct Transition
+        {
+            Actions action;
+            bool fEnter; // whether to enter nextState after the action, rather than staying in the current state.
+            VTStates nextState;
+        };
+
+        using CharClassTable = std::array<CharClasses, s_cClassifiedChars>;
+        using TransitionTable = std::array<std::array<Transition, s_cCharClasses>, s_cStates>;
+
+        static const CharClassTable s_charClasses;
+        static const TransitionTable s_transitions;
+
+        static constexpr CharClassTable s_BuildCharClasses() noexcept;
+        static constexpr TransitionTable s_BuildTransitions() noexcept;
+        static constexpr CharClasses s_ClassifyCharacter(const wchar_t wch) noexcept;
+
         static bool s_IsActionableFromGround(const wchar_t wch);
-        static bool s_IsC0Code(const wchar_t wch);
-        static bool s_IsC1Csi(const wchar_t wch);
-        static bool s_IsIntermediate(const wchar_t wch);
-        static bool s_IsDelete(const wchar_t wch);
-        static bool s_IsEscape(const wchar_t wch);
-        static bool s_IsCsiIndicator(const wchar_t wch);
-        static bool s_IsCsiDelimiter(const wchar_t wch);
-        static bool s_IsCsiParamValue(const wchar_t wch);
-        static bool s_IsCsiPrivateMarker(const wchar_t wch);
-        static bool s_IsCsiInvalid(const wchar_t wch);
-        static bool s_IsOscIndicator(const wchar_t wch);
-        static bool s_IsOscDelimiter(const wchar_t wch);
-        static bool s_IsOscParamValue(const wchar_t wch);
-        static bool s_IsOscInvalid(const wchar_t wch);
-        static bool s_IsOscTerminator(const wchar_t wch);
-        static bool s_IsOscTerminationInitiator(const wchar_t wch);
-        static bool s_IsDesignateCharsetIndicator(const wchar_t wch);
-        static bool s_IsCharsetCode(const wchar_t wch);
-        static bool s_IsNumber(const wchar_t wch);
-        static bool s_IsSs3Indicator(const wchar_t wch);
+        static size_t s_FindActionableFromGround(const wchar_t* const pwch, const size_t cch) noexcept;
+        static constexpr bool s_IsC0Code(const wchar_t wch) noexcept;
+        static constexpr bool s_IsC1Csi(const wchar_t wch) noexcept;
+        static constexpr bool s_IsIntermediate(const wchar_t wch) noexcept;
+        static constexpr bool s_IsDelete(const wchar_t wch) noexcept;
+        static constexpr bool s_IsEscape(const wchar_t wch) noexcept;
+        static constexpr bool s_IsCsiIndicator(const wchar_t wch) noexcept;
+        static constexpr bool s_IsCsiDelimiter(const wchar_t wch) noexcept;
+        static constexpr bool s_IsCsiPrivateMarker(const wchar_t wch) noexcept;
+        static constexpr bool s_IsCsiInvalid(const wchar_t wch) noexcept;
+        static constexpr bool s_IsOscIndicator(const wchar_t wch) noexcept;
+        static constexpr bool s_IsOscTerminator(const wchar_t wch) noexcept;
+        static constexpr bool s_IsNumber(const wchar_t wch) noexcept;
+        static constexpr bool s_IsSs3Indicator(const wchar_t wch) noexcept;
+        static constexpr size_t s_Utf8SequenceLength(const char chLead) noexcept;
+        static size_t s_FindUtf8SplitPoint(const char* const pch, const size_t cch) noexcept;
+
+        void _ProcessUtf8Chunk(const char* const pch, const size_t cch);
 
         void _ActionExecute(const wchar_t wch);
         void _ActionExecuteFromEscape(const wchar_t wch);
@@ -96,35 +176,9 @@ namespace Microsoft::Console::VirtualTerminal
         void _EnterOscTermination();
         void _EnterSs3Entry();
         void _EnterSs3Param();
+        void _EnterState(const VTStates state);
 
-        void _EventGround(const wchar_t wch);
-        void _EventEscape(const wchar_t wch);
-        void _EventEscapeIntermediate(const wchar_t wch);
-        void _EventCsiEntry(const wchar_t wch);
-        void _EventCsiIntermediate(const wchar_t wch);
-        void _EventCsiIgnore(const wchar_t wch);
-        void _EventCsiParam(const wchar_t wch);
-        void _EventOscParam(const wchar_t wch);
-        void _EventOscString(const wchar_t wch);
-        void _EventOscTermination(const wchar_t wch);
-        void _EventSs3Entry(const wchar_t wch);
-        void _EventSs3Param(const wchar_t wch);
-
-        enum class VTStates
-        {
-            Ground,
-            Escape,
-            EscapeIntermediate,
-            CsiEntry,
-            CsiIntermediate,
-            CsiIgnore,
-            CsiParam,
-            OscParam,
-            OscString,
-            OscTermination,
-            Ss3Entry,
-            Ss3Param
-        };
+        void _PerformAction(const Actions action, const wchar_t wch);
 
         Microsoft::Console::VirtualTerminal::ParserTracing _trace;
 
@@ -144,6 +198,13 @@ namespace Microsoft::Console::VirtualTerminal
         unsigned short _sOscNextChar;
         wchar_t _pwchOscStringBuffer[s_cOscStringMaxLength];
 
+        // The bytes of a UTF-8 character that was cut off at the end of the last
+        // string given to ProcessUtf8String, and the buffer each chunk of such a
+        // string is decoded into. The buffer is only allocated once it's needed.
+        char _rgchUtf8Partial[4];
+        size_t _cchUtf8Partial;
+        std::unique_ptr<wchar_t[]> _rgwchUtf8Chunk;
+
         // These members track out state in the parsing of a single string.
         // FlushToTerminal uses these, so that an engine can force a string
         // we're parsing to go straight through to the engine's ActionPassThroughString
@@ -12,16 +12,12 @@ TRACELOGGING_DEFINE_PROVIDER(g_hConsoleVirtTermParserEventTraceProvider,
 
 using namespace Microsoft::Console::VirtualTerminal;
 
-#pragma warning(push)
-// Disable 4351 so we can initialize the arrays to 0 without a warning.
-#pragma warning(disable : 4351)
+thread_local TermTelemetry::Counters* TermTelemetry::s_pThreadCounters = nullptr;
+
 TermTelemetry::TermTelemetry() :
-    _uiTimesUsedCurrent(0),
-    _uiTimesFailedCurrent(0),
-    _uiTimesFailedOutsideRangeCurrent(0),
-    _uiTimesUsed(),
-    _uiTimesFailed(),
-    _uiTimesFailedOutsideRange(0),
+    _uiTimesUsedReported(0),
+    _uiTimesFailedReported(0),
+    _uiTimesFailedOutsideRangeReported(0),
     _activityId(),
     _fShouldWriteFinalLog(false)
 {
@@ -30,7 +26,6 @@ TermTelemetry::TermTelemetry() :
     // Create a random activityId just in case it doesn't get set later in SetActivityId().
     EventActivityIdControl(EVENT_ACTIVITY_CTRL_CREATE_ID, &_activityId);
 }
-#pragma warning(pop)
 
 TermTelemetry::~TermTelemetry()
 {
@@ -45,6 +40,7 @@ TermTelemetry::~TermTelemetry()
 // - code - VT100 code.
 // Return Value:
 // - <none>
+#ifndef DISABLE_VT_PARSER_TELEMETRY
 void TermTelemetry::Log(const Codes code)
 {
     // Initially we wanted to pass over a string (ex. "CUU") and use a dictionary data type to hold the counts.
@@ -52,8 +48,7 @@ void TermTelemetry::Log(const Codes code)
     // to use an array which has very quick access times.
     // The downside is we have to create an enum type, and then convert them to strings when we finally
     // send out the telemetry, but the upside is we should have very good performance.
-    _uiTimesUsed[code]++;
-    _uiTimesUsedCurrent++;
+    _GetThreadCounters().uiTimesUsed[code]++;
 }
 
 // Routine Description:
@@ -65,17 +60,67 @@ void TermTelemetry::Log(const Codes code)
 // - <none>
 void TermTelemetry::LogFailed(const wchar_t wch)
 {
+    Counters& counters = _GetThreadCounters();
     if (wch > CHAR_MAX)
     {
-        _uiTimesFailedOutsideRange++;
-        _uiTimesFailedOutsideRangeCurrent++;
+        counters.uiTimesFailedOutsideRange++;
     }
     else
     {
         // Even though we pass over a wide character, we only care about the ASCII single byte character.
-        _uiTimesFailed[wch]++;
-        _uiTimesFailedCurrent++;
+        counters.uiTimesFailed[wch]++;
+    }
+}
+
+// Routine Description:
+// - Gets the block of counts the calling thread logs into, making one the first time.
+//
+// Arguments:
+// - <none>
+// Return Value:
+// - The calling thread's counts.
+TermTelemetry::Counters& TermTelemetry::_GetThreadCounters()
+{
+    if (s_pThreadCounters == nullptr)
+    {
+        // The block is kept after the thread is gone, so that its counts still make it into the final log.
+        auto counters = std::make_unique<Counters>();
+
+        std::lock_guard<std::mutex> guard{ _countersLock };
+        _counters.push_back(std::move(counters));
+        s_pThreadCounters = _counters.back().get();
+    }
+
+    return *s_pThreadCounters;
+}
+#endif
+
+// Routine Description:
+// - Adds up the counts of every thread that's logged anything.
+//
+// Arguments:
+// - <none>
+// Return Value:
+// - The counts of all the threads together.
+TermTelemetry::Counters TermTelemetry::_SumCounters() const
+{
+    Counters sum{};
+
+    std::lock_guard<std::mutex> guard{ _countersLock };
+    for (const auto& counters : _counters)
+    {
+        for (size_t n = 0; n < ARRAYSIZE(sum.uiTimesUsed); n++)
+        {
+            sum.uiTimesUsed[n] += counters->uiTimesUsed[n];
+        }
+        for (size_t n = 0; n < ARRAYSIZE(sum.uiTimesFailed); n++)
+        {
+            sum.uiTimesFailed[n] += counters->uiTimesFailed[n];
+        }
+        sum.uiTimesFailedOutsideRange += counters->uiTimesFailedOutsideRange;
     }
+
+    return sum;
 }
 
 // Routine Description:
@@ -87,9 +132,15 @@ void TermTelemetry::LogFailed(const wchar_t wch)
 // - total number.
 unsigned int TermTelemetry::GetAndResetTimesUsedCurrent()
 {
-    unsigned int uiTemp = _uiTimesUsedCurrent;
-    _uiTimesUsedCurrent = 0;
-    return uiTemp;
+    const Counters sum = _SumCounters();
+
+    unsigned int uiTotal = 0;
+    for (const auto uiTimesUsed : sum.uiTimesUsed)
+    {
+        uiTotal += uiTimesUsed;
+    }
+
+    return uiTotal - std::exchange(_uiTimesUsedReported, uiTotal);
 }
 
 // Routine Description:
@@ -101,9 +152,15 @@ unsigned int TermTelemetry::GetAndResetTimesUsedCurrent()
 // - total number.
 unsigned int TermTelemetry::GetAndResetTimesFailedCurrent()
 {
-    unsigned int uiTemp = _uiTimesFailedCurrent;
-    _uiTimesFailedCurrent = 0;
-    return uiTemp;
+    const Counters sum = _SumCounters();
+
+    unsigned int uiTotal = 0;
+    for (const auto uiTimesFailed : sum.uiTimesFailed)
+    {
+        uiTotal += uiTimesFailed;
+    }
+
+    return uiTotal - std::exchange(_uiTimesFailedReported, uiTotal);
 }
 
 // Routine Description:
@@ -115,9 +172,8 @@ unsigned int TermTelemetry::GetAndResetTimesFailedCurrent()
 // - total number.
 unsigned int TermTelemetry::GetAndResetTimesFailedOutsideRangeCurrent()
 {
-    unsigned int uiTemp = _uiTimesFailedOutsideRangeCurrent;
-    _uiTimesFailedOutsideRangeCurrent = 0;
-    return uiTemp;
+    const unsigned int uiTotal = _SumCounters().uiTimesFailedOutsideRange;
+    return uiTotal - std::exchange(_uiTimesFailedOutsideRangeReported, uiTotal);
 }
 
 // Routine Description:
@@ -157,14 +213,16 @@ void TermTelemetry::WriteFinalTraceLog() const
 {
     if (_fShouldWriteFinalLog)
     {
+        const Counters sum = _SumCounters();
+
         // Determine if we've logged any VT100 sequences at all.
-        bool fLoggedSequence = (_uiTimesFailedOutsideRange > 0);
+        bool fLoggedSequence = (sum.uiTimesFailedOutsideRange > 0);
 
         if (!fLoggedSequence)
         {
-            for (int n = 0; n < ARRAYSIZE(_uiTimesUsed); n++)
+            for (int n = 0; n < ARRAYSIZE(sum.uiTimesUsed); n++)
             {
-                if (_uiTimesUsed[n] > 0)
+                if (sum.uiTimesUsed[n] > 0)
                 {
                     fLoggedSequence = true;
                     break;
@@ -174,9 +232,9 @@ void TermTelemetry::WriteFinalTraceLog() const
 
         if (!fLoggedSequence)
         {
-            for (int n = 0; n < ARRAYSIZE(_uiTimesFailed); n++)
+            for (int n = 0; n < ARRAYSIZE(sum.uiTimesFailed); n++)
             {
-                if (_uiTimesFailed[n] > 0)
+                if (sum.uiTimesFailed[n] > 0)
                 {
                     fLoggedSequence = true;
                     break;
@@ -195,59 +253,60 @@ void TermTelemetry::WriteFinalTraceLog() const
                                       "ControlCodesUsed",
                                       &_activityId,
                                       NULL,
-                                      TraceLoggingUInt32(_uiTimesUsed[CUU], "CUU"),
-                                      TraceLoggingUInt32(_uiTimesUsed[CUD], "CUD"),
-                                      TraceLoggingUInt32(_uiTimesUsed[CUF], "CUF"),
-                                      TraceLoggingUInt32(_uiTimesUsed[CUB], "CUB"),
-                                      TraceLoggingUInt32(_uiTimesUsed[CNL], "CNL"),
-                                      TraceLoggingUInt32(_uiTimesUsed[CPL], "CPL"),
-                                      TraceLoggingUInt32(_uiTimesUsed[CHA], "CHA"),
-                                      TraceLoggingUInt32(_uiTimesUsed[CUP], "CUP"),
-                                      TraceLoggingUInt32(_uiTimesUsed[ED], "ED"),
-                                      TraceLoggingUInt32(_uiTimesUsed[EL], "EL"),
-                                      TraceLoggingUInt32(_uiTimesUsed[SGR], "SGR"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DECSC], "DECSC"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DECRC], "DECRC"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DECSET], "DECSET"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DECRST], "DECRST"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DECKPAM], "DECKPAM"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DECKPNM], "DECKPNM"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DSR], "DSR"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DA], "DA"),
-                                      TraceLoggingUInt32(_uiTimesUsed[VPA], "VPA"),
-                                      TraceLoggingUInt32(_uiTimesUsed[ICH], "ICH"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DCH], "DCH"),
-                                      TraceLoggingUInt32(_uiTimesUsed[IL], "IL"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DL], "DL"),
-                                      TraceLoggingUInt32(_uiTimesUsed[SU], "SU"),
-                                      TraceLoggingUInt32(_uiTimesUsed[SD], "SD"),
-                                      TraceLoggingUInt32(_uiTimesUsed[ANSISYSSC], "ANSISYSSC"),
-                                      TraceLoggingUInt32(_uiTimesUsed[ANSISYSRC], "ANSISYSRC"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DECSTBM], "DECSTBM"),
-                                      TraceLoggingUInt32(_uiTimesUsed[RI], "RI"),
-                                      TraceLoggingUInt32(_uiTimesUsed[OSCWT], "OscWindowTitle"),
-                                      TraceLoggingUInt32(_uiTimesUsed[HTS], "HTS"),
-                                      TraceLoggingUInt32(_uiTimesUsed[CHT], "CHT"),
-                                      TraceLoggingUInt32(_uiTimesUsed[CBT], "CBT"),
-                                      TraceLoggingUInt32(_uiTimesUsed[TBC], "TBC"),
-                                      TraceLoggingUInt32(_uiTimesUsed[ECH], "ECH"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DesignateG0], "DesignateG0"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DesignateG1], "DesignateG1"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DesignateG2], "DesignateG2"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DesignateG3], "DesignateG3"),
-                                      TraceLoggingUInt32(_uiTimesUsed[HVP], "HVP"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DECSTR], "DECSTR"),
-                                      TraceLoggingUInt32(_uiTimesUsed[RIS], "RIS"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DECSCUSR], "DECSCUSR"),
-                                      TraceLoggingUInt32(_uiTimesUsed[DTTERM_WM], "DTTERM_WM"),
-                                      TraceLoggingUInt32(_uiTimesUsed[OSCCT], "OscColorTable"),
-                                      TraceLoggingUInt32(_uiTimesUsed[OSCSCC], "OscSetCursorColor"),
-                                      TraceLoggingUInt32(_uiTimesUsed[OSCRCC], "OscResetCursorColor"),
-                                      TraceLoggingUInt32(_uiTimesUsed[OSCFG], "OscForegroundColor"),
-                                      TraceLoggingUInt32(_uiTimesUsed[OSCBG], "OscBackgroundColor"),
-                                      TraceLoggingUInt32(_uiTimesUsed[REP], "REP"),
-                                      TraceLoggingUInt32Array(_uiTimesFailed, ARRAYSIZE(_uiTimesFailed), "Failed"),
-                                      TraceLoggingUInt32(_uiTimesFailedOutsideRange, "FailedOutsideRange"));
+                                      TraceLoggingUInt32(sum.uiTimesUsed[CUU], "CUU"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[CUD], "CUD"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[CUF], "CUF"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[CUB], "CUB"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[CNL], "CNL"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[CPL], "CPL"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[CHA], "CHA"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[CUP], "CUP"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[ED], "ED"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[EL], "EL"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[SGR], "SGR"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DECSC], "DECSC"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DECRC], "DECRC"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DECSET], "DECSET"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DECRST], "DECRST"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DECKPAM], "DECKPAM"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DECKPNM], "DECKPNM"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DSR], "DSR"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DA], "DA"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[VPA], "VPA"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[ICH], "ICH"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DCH], "DCH"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[IL], "IL"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DL], "DL"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[SU], "SU"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[SD], "SD"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[ANSISYSSC], "ANSISYSSC"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[ANSISYSRC], "ANSISYSRC"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DECSTBM], "DECSTBM"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[RI], "RI"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[OSCWT], "OscWindowTitle"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[HTS], "HTS"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[CHT], "CHT"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[CBT], "CBT"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[TBC], "TBC"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[ECH], "ECH"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DesignateG0], "DesignateG0"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DesignateG1], "DesignateG1"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DesignateG2], "DesignateG2"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DesignateG3], "DesignateG3"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[HVP], "HVP"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DECSTR], "DECSTR"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[RIS], "RIS"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DECSCUSR], "DECSCUSR"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[DTTERM_WM], "DTTERM_WM"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[OSCCT], "OscColorTable"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[OSCSCC], "OscSetCursorColor"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[OSCRCC], "OscResetCursorColor"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[OSCFG], "OscForegroundColor"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[OSCBG], "OscBackgroundColor"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[OSCSM], "OscShellMark"),
+                                      TraceLoggingUInt32(sum.uiTimesUsed[REP], "REP"),
+                                      TraceLoggingUInt32Array(sum.uiTimesFailed, ARRAYSIZE(sum.uiTimesFailed), "Failed"),
+                                      TraceLoggingUInt32(sum.uiTimesFailedOutsideRange, "FailedOutsideRange"));
         }
     }
 }
@@ -16,6 +16,10 @@ Abstract:
 #include <TraceLoggingProvider.h>
 #include "limits.h"
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 TRACELOGGING_DECLARE_PROVIDER(g_hConsoleVirtTermParserEventTraceProvider);
 
 namespace Microsoft::Console::VirtualTerminal
@@ -84,11 +88,18 @@ namespace Microsoft::Console::VirtualTerminal
             REP,
             OSCFG,
             OSCBG,
+            OSCSM,
             // Only use this last enum as a count of the number of codes.
             NUMBER_OF_CODES
         };
+        // Building with DISABLE_VT_PARSER_TELEMETRY leaves the counting out of the parser altogether.
+#ifdef DISABLE_VT_PARSER_TELEMETRY
+        void Log(const Codes /*code*/) noexcept {}
+        void LogFailed(const wchar_t /*wch*/) noexcept {}
+#else
         void Log(const Codes code);
         void LogFailed(const wchar_t wch);
+#endif
         void SetShouldWriteFinalLog(const bool writeLog);
         void SetActivityId(const GUID* activityId);
         unsigned int GetAndResetTimesUsedCurrent();
@@ -104,12 +115,28 @@ namespace Microsoft::Console::VirtualTerminal
 
         void WriteFinalTraceLog() const;
 
-        unsigned int _uiTimesUsedCurrent;
-        unsigned int _uiTimesFailedCurrent;
-        unsigned int _uiTimesFailedOutsideRangeCurrent;
-        unsigned int _uiTimesUsed[NUMBER_OF_CODES];
-        unsigned int _uiTimesFailed[CHAR_MAX + 1];
-        unsigned int _uiTimesFailedOutsideRange;
+        // Every thread that parses counts into a block of its own, so that parsers on
+        // different threads don't keep taking the same cache lines from each other.
+        // The blocks are only added up when the counts are read.
+        struct alignas(64) Counters
+        {
+            unsigned int uiTimesUsed[NUMBER_OF_CODES];
+            unsigned int uiTimesFailed[CHAR_MAX + 1];
+            unsigned int uiTimesFailedOutsideRange;
+        };
+
+        Counters& _GetThreadCounters();
+        Counters _SumCounters() const;
+
+        static thread_local Counters* s_pThreadCounters;
+        mutable std::mutex _countersLock;
+        std::vector<std::unique_ptr<Counters>> _counters;
+
+        // What GetAndReset*Current has handed out so far. The blocks themselves are
+        // only ever written by their own thread.
+        unsigned int _uiTimesUsedReported;
+        unsigned int _uiTimesFailedReported;
+        unsigned int _uiTimesFailedOutsideRangeReported;
         GUID _activityId;
 
         bool _fShouldWriteFinalLog;
@@ -201,6 +201,28 @@ class Microsoft::Console::VirtualTerminal::OutputEngineTest final
         VERIFY_ARE_EQUAL(mach._state, StateMachine::VTStates::Ground);
     }
 
+    TEST_METHOD(TestFindActionableFromGround)
+    {
+        // Put an actionable character at every offset of a long printable run,
+        // so that it's found both by the wide scan and by the tail after it.
+        const std::wstring actionable{ L"\x1b\x00\r\x1f\x7f\x9b", 6 };
+        for (const auto wch : actionable)
+        {
+            for (size_t offset = 0; offset < 40; offset++)
+            {
+                std::wstring run(40, L'a');
+                run.at(offset) = wch;
+                VERIFY_ARE_EQUAL(offset, StateMachine::s_FindActionableFromGround(run.data(), run.size()));
+                VERIFY_ARE_EQUAL(std::min<size_t>(offset, 17), StateMachine::s_FindActionableFromGround(run.data(), 17));
+            }
+        }
+
+        Log::Comment(L"Characters next to the actionable ones are printable.");
+        const std::wstring printable{ L" ~\x80\x9a\x9c\xffff" };
+        VERIFY_ARE_EQUAL(printable.size(), StateMachine::s_FindActionableFromGround(printable.data(), printable.size()));
+        VERIFY_ARE_EQUAL(0u, StateMachine::s_FindActionableFromGround(printable.data(), 0));
+    }
+
     TEST_METHOD(TestCsiEntry)
     {
         StateMachine mach(new OutputStateMachineEngine(new DummyDispatch));
@@ -604,12 +626,14 @@ public:
     {
     }
 
-    virtual void Print(const wchar_t /*wchPrintable*/) override
+    virtual void Print(const wchar_t wchPrintable) override
     {
+        _wstrPrinted.push_back(wchPrintable);
     }
 
-    virtual void PrintString(const wchar_t* const /*rgwch*/, const size_t /*cch*/) override
+    virtual void PrintString(const wchar_t* const rgwch, const size_t cch) override
     {
+        _wstrPrinted.append(rgwch, cch);
     }
 
     StatefulDispatch() :
@@ -643,7 +667,9 @@ public:
         _fCursorBlinking{ true },
         _fIsOriginModeRelative{ false },
         _fIsDECCOLMAllowed{ false },
-        _uiWindowWidth{ 80 }
+        _uiWindowWidth{ 80 },
+        _fShellMark{ false },
+        _shellMarkType{ (DispatchTypes::ShellMarkType)-1 }
     {
         memset(_rgOptions, s_uiGraphicsCleared, sizeof(_rgOptions));
     }
@@ -764,12 +790,11 @@ public:
         return true;
     }
 
-    bool SetGraphicsRendition(_In_reads_(cOptions) const DispatchTypes::GraphicsOptions* const rgOptions,
-                              const size_t cOptions) override
+    bool SetGraphicsRendition(const gsl::span<const DispatchTypes::GraphicsOptions> options) override
     {
-        size_t cCopyLength = std::min(cOptions, s_cMaxOptions); // whichever is smaller, our buffer size or the number given
+        size_t cCopyLength = std::min(static_cast<size_t>(options.size()), s_cMaxOptions); // whichever is smaller, our buffer size or the number given
         _cOptions = cCopyLength;
-        memcpy(_rgOptions, rgOptions, _cOptions * sizeof(DispatchTypes::GraphicsOptions));
+        memcpy(_rgOptions, options.data(), _cOptions * sizeof(DispatchTypes::GraphicsOptions));
 
         _fSetGraphics = true;
 
@@ -893,6 +918,14 @@ public:
         return true;
     }
 
+    bool AddShellMark(const DispatchTypes::ShellMarkType markType) override
+    {
+        _fShellMark = true;
+        _shellMarkType = markType;
+        return true;
+    }
+
+    std::wstring _wstrPrinted;
     unsigned int _uiCursorDistance;
     unsigned int _uiLine;
     unsigned int _uiColumn;
@@ -923,6 +956,8 @@ public:
     bool _fIsOriginModeRelative;
     bool _fIsDECCOLMAllowed;
     unsigned int _uiWindowWidth;
+    bool _fShellMark;
+    DispatchTypes::ShellMarkType _shellMarkType;
 
     static const size_t s_cMaxOptions = 16;
     static const unsigned int s_uiGraphicsCleared = UINT_MAX;
@@ -1763,4 +1798,105 @@ class StateMachineExternalTest final
 
         pDispatch->ClearState();
     }
+
+    TEST_METHOD(TestShellMarks)
+    {
+        StatefulDispatch* pDispatch = new StatefulDispatch;
+        VERIFY_IS_NOT_NULL(pDispatch);
+        StateMachine mach(new OutputStateMachineEngine(pDispatch));
+
+        mach.ProcessString(L"\x1b]133;A\x07");
+        VERIFY_IS_TRUE(pDispatch->_fShellMark);
+        VERIFY_ARE_EQUAL(DispatchTypes::ShellMarkType::PromptStart, pDispatch->_shellMarkType);
+        pDispatch->ClearState();
+
+        mach.ProcessString(L"\x1b]133;B\x1b\\");
+        VERIFY_ARE_EQUAL(DispatchTypes::ShellMarkType::CommandStart, pDispatch->_shellMarkType);
+        pDispatch->ClearState();
+
+        mach.ProcessString(L"\x1b]133;C\x07");
+        VERIFY_ARE_EQUAL(DispatchTypes::ShellMarkType::CommandExecuted, pDispatch->_shellMarkType);
+        pDispatch->ClearState();
+
+        Log::Comment(L"The exit code after a command finishes is ignored.");
+        mach.ProcessString(L"\x1b]133;D;1\x07");
+        VERIFY_IS_TRUE(pDispatch->_fShellMark);
+        VERIFY_ARE_EQUAL(DispatchTypes::ShellMarkType::CommandFinished, pDispatch->_shellMarkType);
+        pDispatch->ClearState();
+
+        Log::Comment(L"Marks we don't know aren't dispatched.");
+        mach.ProcessString(L"\x1b]133;E\x07");
+        VERIFY_IS_FALSE(pDispatch->_fShellMark);
+        mach.ProcessString(L"\x1b]133;AB\x07");
+        VERIFY_IS_FALSE(pDispatch->_fShellMark);
+        mach.ProcessString(L"\x1b]133;\x07");
+        VERIFY_IS_FALSE(pDispatch->_fShellMark);
+    }
+
+    TEST_METHOD(TestRepeatCharacter)
+    {
+        StatefulDispatch* pDispatch = new StatefulDispatch;
+        VERIFY_IS_NOT_NULL(pDispatch);
+        StateMachine mach(new OutputStateMachineEngine(pDispatch));
+
+        Log::Comment(L"Test 1: Repeat the last character more times than fit in one chunk.");
+        mach.ProcessString(L"ab\x1b[300b");
+        VERIFY_ARE_EQUAL(String((L"a" + std::wstring(301, L'b')).c_str()), String(pDispatch->_wstrPrinted.c_str()));
+
+        Log::Comment(L"Test 2: Nothing is repeated right after another sequence.");
+        mach.ProcessString(L"\x1b[5b");
+        VERIFY_ARE_EQUAL(String((L"a" + std::wstring(301, L'b')).c_str()), String(pDispatch->_wstrPrinted.c_str()));
+
+        pDispatch->ClearState();
+    }
+
+    TEST_METHOD(TestUtf8Strings)
+    {
+        StatefulDispatch* pDispatch = new StatefulDispatch;
+        VERIFY_IS_NOT_NULL(pDispatch);
+        StateMachine mach(new OutputStateMachineEngine(pDispatch));
+
+        ///////////////////////////////////////////////////////////////////////
+
+        Log::Comment(L"Test 1: Multibyte characters around a sequence.");
+        mach.ProcessUtf8String("a\xC3\xA9\x1b[2J\xE4\xB8\xAD");
+
+        VERIFY_ARE_EQUAL(String(L"a\x00e9\x4e2d"), String(pDispatch->_wstrPrinted.c_str()));
+        VERIFY_IS_TRUE(pDispatch->_fEraseDisplay);
+        VERIFY_ARE_EQUAL(DispatchTypes::EraseType::All, pDispatch->_eraseType);
+
+        pDispatch->ClearState();
+
+        ///////////////////////////////////////////////////////////////////////
+
+        Log::Comment(L"Test 2: A character split across strings is held until it's finished.");
+        mach.ProcessUtf8String("b\xF0\x9F");
+        VERIFY_ARE_EQUAL(String(L"b"), String(pDispatch->_wstrPrinted.c_str()));
+        mach.ProcessUtf8String("\x98");
+        VERIFY_ARE_EQUAL(String(L"b"), String(pDispatch->_wstrPrinted.c_str()));
+        mach.ProcessUtf8String("\x80" "c");
+        VERIFY_ARE_EQUAL(String(L"b\xD83D\xDE00" L"c"), String(pDispatch->_wstrPrinted.c_str()));
+
+        pDispatch->ClearState();
+
+        ///////////////////////////////////////////////////////////////////////
+
+        Log::Comment(L"Test 3: A character that's never finished is replaced.");
+        mach.ProcessUtf8String("\xE4\xB8");
+        mach.ProcessUtf8String("d");
+        VERIFY_ARE_EQUAL(String(L"\xFFFD" L"d"), String(pDispatch->_wstrPrinted.c_str()));
+
+        pDispatch->ClearState();
+
+        ///////////////////////////////////////////////////////////////////////
+
+        Log::Comment(L"Test 4: An encoded C1 CSI starts a sequence.");
+        mach.ProcessUtf8String("\xC2\x9B" "1J");
+
+        VERIFY_IS_TRUE(pDispatch->_fEraseDisplay);
+        VERIFY_ARE_EQUAL(DispatchTypes::EraseType::FromBeginning, pDispatch->_eraseType);
+        VERIFY_IS_TRUE(pDispatch->_wstrPrinted.empty());
+
+        pDispatch->ClearState();
+    }
 };
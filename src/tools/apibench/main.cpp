@@ -0,0 +1,218 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+//
+// ApiBench times console APIs one call at a time against the console it's attached to.
+// Run it under the host to measure, e.g. `OpenConsole.exe ApiBench.exe`.
+//
+// Each API is called over and over on a screen buffer of ApiBench's own, so the buffer
+// that was active before is left as it was. Afterwards it prints, for every API, how many
+// calls per second it made and the P50, P99 and worst latency of a single call.
+//
+// Usage:
+//   ApiBench.exe [-n <calls per API>]
+
+#include <windows.h>
+#include <wil\Common.h>
+#include <wil\result.h>
+#include <wil\resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using clock = std::chrono::steady_clock;
+
+    struct Api
+    {
+        std::wstring name;
+        // Runs before every call and isn't timed, for APIs that need something to work on.
+        std::function<void()> prepare;
+        std::function<void()> call;
+    };
+
+    struct Result
+    {
+        std::wstring name;
+        double callsPerSecond;
+        double p50;
+        double p99;
+        double max;
+    };
+
+    std::vector<Api> _MakeApis(const HANDLE hOut, const HANDLE hIn, const COORD screenSize)
+    {
+        std::vector<Api> apis;
+
+        for (const auto cch : { 1u, 80u, 4096u })
+        {
+            // Lines that wrap and scroll, like a program's output does.
+            std::wstring text(cch, L'x');
+            for (size_t i = 60; i < text.size(); i += 61)
+            {
+                text[i] = L'\n';
+            }
+
+            apis.push_back({ L"WriteConsoleW (" + std::to_wstring(cch) + L" chars)", nullptr, [=]() {
+                                DWORD written = 0;
+                                THROW_IF_WIN32_BOOL_FALSE(WriteConsoleW(hOut, text.data(), static_cast<DWORD>(text.size()), &written, nullptr));
+                            } });
+        }
+
+        for (const SHORT width : { 1, 80 })
+        {
+            const COORD size{ width, static_cast<SHORT>(width == 1 ? 1 : 25) };
+            std::vector<CHAR_INFO> cells(size.X * size.Y);
+            for (size_t i = 0; i < cells.size(); ++i)
+            {
+                cells[i].Char.UnicodeChar = static_cast<wchar_t>(L'A' + i % 26);
+                cells[i].Attributes = static_cast<WORD>(i % 16);
+            }
+
+            apis.push_back({ L"WriteConsoleOutputW (" + std::to_wstring(size.X) + L"x" + std::to_wstring(size.Y) + L")", nullptr, [=]() {
+                                auto region = SMALL_RECT{ 0, 0, static_cast<SHORT>(size.X - 1), static_cast<SHORT>(size.Y - 1) };
+                                THROW_IF_WIN32_BOOL_FALSE(WriteConsoleOutputW(hOut, cells.data(), size, { 0, 0 }, &region));
+                            } });
+        }
+
+        apis.push_back({ L"ReadConsoleInputW (1 event)",
+                         [=]() {
+                             INPUT_RECORD record{};
+                             record.EventType = KEY_EVENT;
+                             record.Event.KeyEvent.bKeyDown = TRUE;
+                             record.Event.KeyEvent.wRepeatCount = 1;
+                             record.Event.KeyEvent.uChar.UnicodeChar = L'a';
+                             DWORD written = 0;
+                             THROW_IF_WIN32_BOOL_FALSE(WriteConsoleInputW(hIn, &record, 1, &written));
+                         },
+                         [=]() {
+                             INPUT_RECORD record;
+                             DWORD read = 0;
+                             THROW_IF_WIN32_BOOL_FALSE(ReadConsoleInputW(hIn, &record, 1, &read));
+                         } });
+
+        apis.push_back({ L"GetConsoleScreenBufferInfoEx", nullptr, [=]() {
+                            CONSOLE_SCREEN_BUFFER_INFOEX info{};
+                            info.cbSize = sizeof(info);
+                            THROW_IF_WIN32_BOOL_FALSE(GetConsoleScreenBufferInfoEx(hOut, &info));
+                        } });
+
+        apis.push_back({ L"ScrollConsoleScreenBufferW (1 line)", nullptr, [=]() {
+                            const SMALL_RECT scroll{ 0, 1, static_cast<SHORT>(screenSize.X - 1), static_cast<SHORT>(screenSize.Y - 1) };
+                            CHAR_INFO fill{};
+                            fill.Char.UnicodeChar = L' ';
+                            fill.Attributes = FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE;
+                            THROW_IF_WIN32_BOOL_FALSE(ScrollConsoleScreenBufferW(hOut, &scroll, nullptr, { 0, 0 }, &fill));
+                        } });
+
+        apis.push_back({ L"FillConsoleOutputCharacterW (screen)", nullptr, [=]() {
+                            DWORD written = 0;
+                            THROW_IF_WIN32_BOOL_FALSE(FillConsoleOutputCharacterW(hOut, L'#', screenSize.X * screenSize.Y, { 0, 0 }, &written));
+                        } });
+
+        return apis;
+    }
+
+    double _Percentile(const std::vector<double>& sorted, const size_t percent)
+    {
+        return sorted.at(std::min(sorted.size() - 1, sorted.size() * percent / 100));
+    }
+
+    Result _Measure(const Api& api, const size_t calls)
+    {
+        std::vector<double> latencies;
+        latencies.reserve(calls);
+        double total = 0;
+
+        for (size_t i = 0; i < calls; ++i)
+        {
+            if (api.prepare)
+            {
+                api.prepare();
+            }
+
+            const auto start = clock::now();
+            api.call();
+            const auto latency = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+
+            latencies.push_back(latency);
+            total += latency;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        return { api.name, total > 0 ? calls / (total / 1e6) : 0.0, _Percentile(latencies, 50), _Percentile(latencies, 99), latencies.back() };
+    }
+
+    void _PrintUsage()
+    {
+        wprintf(L"Usage: ApiBench.exe [-n <calls per API>]\n");
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+try
+{
+    size_t calls = 10000;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::wstring_view arg{ argv[i] };
+        if (arg == L"-n" && i + 1 < argc)
+        {
+            calls = wcstoul(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            _PrintUsage();
+            return arg == L"-?" || arg == L"-h" ? 0 : 1;
+        }
+    }
+
+    if (calls == 0)
+    {
+        _PrintUsage();
+        return 1;
+    }
+
+    const auto hIn = GetStdHandle(STD_INPUT_HANDLE);
+    const auto hOriginalOut = GetStdHandle(STD_OUTPUT_HANDLE);
+
+    THROW_IF_WIN32_BOOL_FALSE(FlushConsoleInputBuffer(hIn));
+
+    wil::unique_handle hOut{ CreateConsoleScreenBuffer(GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, CONSOLE_TEXTMODE_BUFFER, nullptr) };
+    THROW_LAST_ERROR_IF(!hOut || hOut.get() == INVALID_HANDLE_VALUE);
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    THROW_IF_WIN32_BOOL_FALSE(GetConsoleScreenBufferInfo(hOut.get(), &info));
+    THROW_IF_WIN32_BOOL_FALSE(SetConsoleActiveScreenBuffer(hOut.get()));
+
+    // The APIs that work on a rectangle work on what's on the screen, not the whole scrollback.
+    const COORD screenSize{ static_cast<SHORT>(info.srWindow.Right - info.srWindow.Left + 1),
+                            static_cast<SHORT>(info.srWindow.Bottom - info.srWindow.Top + 1) };
+
+    std::vector<Result> results;
+    {
+        auto restoreBuffer = wil::scope_exit([&]() { SetConsoleActiveScreenBuffer(hOriginalOut); });
+        for (const auto& api : _MakeApis(hOut.get(), hIn, screenSize))
+        {
+            results.push_back(_Measure(api, calls));
+        }
+    }
+
+    wprintf(L"%zu calls per API\n", calls);
+    wprintf(L"%-40s %12s %10s %10s %10s\n", L"API", L"calls/s", L"P50 us", L"P99 us", L"max us");
+    for (const auto& result : results)
+    {
+        wprintf(L"%-40s %12.0f %10.2f %10.2f %10.2f\n", result.name.c_str(), result.callsPerSecond, result.p50, result.p99, result.max);
+    }
+
+    return 0;
+}
+catch (...)
+{
+    const auto hr = wil::ResultFromCaughtException();
+    fwprintf(stderr, L"ApiBench failed: 0x%08x\n", hr);
+    return hr;
+}
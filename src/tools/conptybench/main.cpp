@@ -0,0 +1,497 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+//
+// ConPtyBench measures a headless conhost from the outside, the way a terminal sees it.
+// It starts the host in pty mode like CreateConPty does (see conpty.h), with a copy of
+// itself as the client, and measures:
+// - echo latency: the time from writing a key to the input pipe until the host has
+//   rendered the client's echo of it to the output pipe. That covers the VtInputThread,
+//   the client's ReadConsole and WriteConsole, and the VT renderer's next frame.
+// - throughput: how fast the output of a client that writes as fast as it can makes it
+//   through VtIo and the XtermEngine, and how many bytes the host writes to the output
+//   pipe for every byte the client wrote (the amplification).
+//
+// The results are printed to stdout as JSON.
+//
+// Usage:
+//   ConPtyBench.exe [-c <host>] [-n <keystrokes>] [-b <MB written by the client>]
+//
+// The host defaults to the OpenConsole.exe next to ConPtyBench.exe, or conhost.exe if
+// there isn't one.
+
+#include <windows.h>
+#include <wil\Common.h>
+#include <wil\result.h>
+#include <wil\resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+    constexpr unsigned short PtyWidth = 120;
+    constexpr unsigned short PtyHeight = 30;
+
+    // The keys sent for the echo test are lowercase Greek letters. Their UTF-8 never
+    // shows up in a VT sequence, so finding one in the output means the echo arrived.
+    constexpr wchar_t FirstProbe = 0x03B1;
+    constexpr wchar_t LastProbe = 0x03C9;
+
+    // The client writes this once it's written everything else, for the same reason.
+    constexpr wchar_t FloodSentinel = 0x03A9;
+
+    // Tells a client to quit. Probes are never ASCII, so it can't be mistaken for one.
+    constexpr char QuitKey = 'q';
+
+    constexpr auto Timeout = 30s;
+
+    using clock = std::chrono::steady_clock;
+
+    std::string _ToUtf8(const wchar_t ch)
+    {
+        char bytes[4];
+        const auto cb = WideCharToMultiByte(CP_UTF8, 0, &ch, 1, bytes, ARRAYSIZE(bytes), nullptr, nullptr);
+        THROW_LAST_ERROR_IF(cb == 0);
+        return { bytes, static_cast<size_t>(cb) };
+    }
+
+#pragma region Client
+    // The client side runs inside the pty. Input comes in without line editing or echo,
+    // so that every key reaches the client as soon as the host has read it.
+    void _SetRawInput()
+    {
+        THROW_IF_WIN32_BOOL_FALSE(SetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), 0));
+    }
+
+    wchar_t _ReadKey()
+    {
+        wchar_t ch = 0;
+        DWORD read = 0;
+        THROW_IF_WIN32_BOOL_FALSE(ReadConsoleW(GetStdHandle(STD_INPUT_HANDLE), &ch, 1, &read, nullptr));
+        return read ? ch : QuitKey;
+    }
+
+    void _Write(const std::wstring_view text)
+    {
+        DWORD written = 0;
+        THROW_IF_WIN32_BOOL_FALSE(WriteConsoleW(GetStdHandle(STD_OUTPUT_HANDLE), text.data(), static_cast<DWORD>(text.size()), &written, nullptr));
+    }
+
+    // Writes every key it reads back out, like a shell echoing what's typed at its prompt.
+    int _RunEchoClient()
+    {
+        _SetRawInput();
+        for (auto ch = _ReadKey(); ch != QuitKey; ch = _ReadKey())
+        {
+            _Write({ &ch, 1 });
+        }
+        return 0;
+    }
+
+    // Waits for a key, then writes the given number of bytes of colored log lines as fast
+    // as it can, followed by the sentinel. It stays until it's told to quit, so that the
+    // host has the chance to render everything.
+    int _RunFloodClient(const size_t bytes)
+    {
+        _SetRawInput();
+        THROW_IF_WIN32_BOOL_FALSE(SetConsoleMode(GetStdHandle(STD_OUTPUT_HANDLE),
+                                                 ENABLE_PROCESSED_OUTPUT | ENABLE_WRAP_AT_EOL_OUTPUT | ENABLE_VIRTUAL_TERMINAL_PROCESSING));
+        _ReadKey();
+
+        std::string chunk;
+        for (size_t i = 0; chunk.size() < 64 * 1024; ++i)
+        {
+            chunk += "\x1b[32m[info]\x1b[0m request ";
+            chunk += std::to_string(i);
+            chunk += " served in \x1b[1m";
+            chunk += std::to_string(i % 97);
+            chunk += "ms\x1b[0m\r\n";
+        }
+
+        const auto hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+        for (size_t total = 0; total < bytes;)
+        {
+            const auto cb = static_cast<DWORD>(std::min(chunk.size(), bytes - total));
+            DWORD written = 0;
+            THROW_IF_WIN32_BOOL_FALSE(WriteConsoleA(hOut, chunk.data(), cb, &written, nullptr));
+            total += cb;
+        }
+
+        const wchar_t sentinel[] = { L'\r', L'\n', FloodSentinel };
+        _Write({ sentinel, ARRAYSIZE(sentinel) });
+
+        while (_ReadKey() != QuitKey)
+        {
+        }
+        return 0;
+    }
+#pragma endregion
+
+#pragma region Host
+    // Reads the output of the pty on a thread of its own, counting the bytes and looking
+    // for whatever the benchmark is waiting for.
+    class OutputReader
+    {
+    public:
+        explicit OutputReader(const HANDLE output) :
+            _output{ output },
+            _thread{ [this]() { _Read(); } }
+        {
+        }
+
+        ~OutputReader()
+        {
+            // The read can only be cancelled while it's blocked, so keep at it until the thread is gone.
+            _stopping = true;
+            while (WaitForSingleObject(_thread.native_handle(), 0) == WAIT_TIMEOUT)
+            {
+                CancelSynchronousIo(_thread.native_handle());
+                WaitForSingleObject(_thread.native_handle(), 100);
+            }
+            _thread.join();
+        }
+
+        // Starts looking for needle in the output that comes after this call.
+        void Expect(std::string needle)
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
+            _needle = std::move(needle);
+            _carry.clear();
+            _found = false;
+        }
+
+        // Waits for what Expect is looking for. Returns when it showed up in the output.
+        clock::time_point Wait()
+        {
+            std::unique_lock<std::mutex> lock{ _mutex };
+            THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_TIMEOUT), !_changed.wait_for(lock, Timeout, [this]() { return _found || _closed; }));
+            THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_BROKEN_PIPE), !_found);
+            return _foundAt;
+        }
+
+        // Waits until the host has been quiet for a moment, e.g. after it painted its first frame.
+        void WaitForQuiet()
+        {
+            auto last = BytesRead();
+            for (;;)
+            {
+                std::this_thread::sleep_for(250ms);
+                const auto now = BytesRead();
+                if (now == last)
+                {
+                    return;
+                }
+                last = now;
+            }
+        }
+
+        uint64_t BytesRead()
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
+            return _bytesRead;
+        }
+
+    private:
+        HANDLE _output;
+        std::mutex _mutex;
+        std::condition_variable _changed;
+        uint64_t _bytesRead = 0;
+        std::string _needle;
+        std::string _carry;
+        bool _found = false;
+        bool _closed = false;
+        std::atomic<bool> _stopping{ false };
+        clock::time_point _foundAt;
+        std::thread _thread;
+
+        void _Read()
+        {
+            std::vector<char> buffer(64 * 1024);
+            DWORD read = 0;
+            while (!_stopping && ReadFile(_output, buffer.data(), static_cast<DWORD>(buffer.size()), &read, nullptr) && read > 0)
+            {
+                const auto now = clock::now();
+
+                std::lock_guard<std::mutex> lock{ _mutex };
+                _bytesRead += read;
+
+                if (!_needle.empty() && !_found)
+                {
+                    // The needle can be split across reads, so the end of the last read is searched again.
+                    _carry.append(buffer.data(), read);
+                    if (_carry.find(_needle) != std::string::npos)
+                    {
+                        _found = true;
+                        _foundAt = now;
+                        _changed.notify_all();
+                    }
+                    else if (_carry.size() >= _needle.size())
+                    {
+                        _carry.erase(0, _carry.size() - _needle.size() + 1);
+                    }
+                }
+            }
+
+            std::lock_guard<std::mutex> lock{ _mutex };
+            _closed = true;
+            _changed.notify_all();
+        }
+    };
+
+    // A headless host with a copy of this benchmark attached to it as the client.
+    class Pty
+    {
+    public:
+        Pty(const std::wstring& host, const std::wstring& clientArgs)
+        {
+            // As in CreateConPty, the pipes are made uninheritable and only the host's ends
+            // are marked inheritable, so that the host doesn't get our ends as well.
+            wil::unique_hfile inPipeHostSide;
+            wil::unique_hfile outPipeHostSide;
+
+            SECURITY_ATTRIBUTES sa{};
+            sa.nLength = sizeof(sa);
+            sa.bInheritHandle = FALSE;
+
+            THROW_IF_WIN32_BOOL_FALSE(CreatePipe(&inPipeHostSide, &_input, &sa, 0));
+            THROW_IF_WIN32_BOOL_FALSE(CreatePipe(&_output, &outPipeHostSide, &sa, 0));
+            THROW_IF_WIN32_BOOL_FALSE(SetHandleInformation(inPipeHostSide.get(), HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT));
+            THROW_IF_WIN32_BOOL_FALSE(SetHandleInformation(outPipeHostSide.get(), HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT));
+
+            wchar_t self[MAX_PATH];
+            THROW_LAST_ERROR_IF(GetModuleFileNameW(nullptr, self, ARRAYSIZE(self)) == 0);
+
+            auto cmdline = L"\"" + host + L"\" --headless";
+            cmdline += L" --width " + std::to_wstring(PtyWidth);
+            cmdline += L" --height " + std::to_wstring(PtyHeight);
+            cmdline += L" -- \"";
+            cmdline += self;
+            cmdline += L"\" " + clientArgs;
+
+            STARTUPINFOW si{};
+            si.cb = sizeof(si);
+            si.hStdInput = inPipeHostSide.get();
+            si.hStdOutput = outPipeHostSide.get();
+            si.hStdError = outPipeHostSide.get();
+            si.dwFlags = STARTF_USESTDHANDLES;
+
+            THROW_IF_WIN32_BOOL_FALSE(CreateProcessW(nullptr,
+                                                     cmdline.data(),
+                                                     nullptr, // lpProcessAttributes
+                                                     nullptr, // lpThreadAttributes
+                                                     TRUE, // bInheritHandles
+                                                     0, // dwCreationFlags
+                                                     nullptr, // lpEnvironment
+                                                     nullptr, // lpCurrentDirectory
+                                                     &si,
+                                                     &_host));
+        }
+
+        ~Pty()
+        {
+            // Closing the input ends the client; if the host doesn't follow, it's stopped.
+            _input.reset();
+            if (WaitForSingleObject(_host.hProcess, 5000) != WAIT_OBJECT_0)
+            {
+                TerminateProcess(_host.hProcess, 1);
+            }
+        }
+
+        void Write(const std::string_view bytes)
+        {
+            DWORD written = 0;
+            THROW_IF_WIN32_BOOL_FALSE(WriteFile(_input.get(), bytes.data(), static_cast<DWORD>(bytes.size()), &written, nullptr));
+        }
+
+        HANDLE Output() const noexcept
+        {
+            return _output.get();
+        }
+
+    private:
+        wil::unique_hfile _input;
+        wil::unique_hfile _output;
+        wil::unique_process_information _host;
+    };
+
+    double _Percentile(const std::vector<double>& sorted, const size_t percent)
+    {
+        return sorted.at(std::min(sorted.size() - 1, sorted.size() * percent / 100));
+    }
+
+    void _MeasureEcho(const std::wstring& host, const size_t keystrokes)
+    {
+        Pty pty{ host, L"--client echo" };
+        OutputReader reader{ pty.Output() };
+        reader.WaitForQuiet();
+
+        std::vector<double> latencies;
+        latencies.reserve(keystrokes);
+
+        for (size_t i = 0; i < keystrokes; ++i)
+        {
+            const auto probe = _ToUtf8(static_cast<wchar_t>(FirstProbe + i % (LastProbe - FirstProbe + 1)));
+            reader.Expect(probe);
+
+            const auto sent = clock::now();
+            pty.Write(probe);
+            const auto echoed = reader.Wait();
+
+            latencies.push_back(std::chrono::duration<double, std::milli>(echoed - sent).count());
+        }
+
+        pty.Write({ &QuitKey, 1 });
+
+        double total = 0;
+        for (const auto latency : latencies)
+        {
+            total += latency;
+        }
+        std::sort(latencies.begin(), latencies.end());
+
+        wprintf(L"  \"echo\": { \"keystrokes\": %zu, \"mean_ms\": %.3f, \"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f },\n",
+                latencies.size(),
+                total / latencies.size(),
+                _Percentile(latencies, 50),
+                _Percentile(latencies, 90),
+                _Percentile(latencies, 99),
+                latencies.back());
+    }
+
+    void _MeasureThroughput(const std::wstring& host, const size_t clientBytes)
+    {
+        Pty pty{ host, L"--client flood " + std::to_wstring(clientBytes) };
+        OutputReader reader{ pty.Output() };
+        reader.WaitForQuiet();
+
+        const auto bytesBefore = reader.BytesRead();
+        reader.Expect(_ToUtf8(FloodSentinel));
+
+        const auto start = clock::now();
+        pty.Write("g");
+        const auto end = reader.Wait();
+
+        // Let the host finish the frame the sentinel came in, so that all of it is counted.
+        reader.WaitForQuiet();
+        const auto outputBytes = reader.BytesRead() - bytesBefore;
+
+        pty.Write({ &QuitKey, 1 });
+
+        const auto seconds = std::chrono::duration<double>(end - start).count();
+        wprintf(L"  \"throughput\": { \"client_bytes\": %zu, \"output_bytes\": %llu, \"seconds\": %.3f, \"mb_per_s\": %.3f, \"amplification\": %.3f }\n",
+                clientBytes,
+                outputBytes,
+                seconds,
+                seconds > 0 ? clientBytes / (1024.0 * 1024.0) / seconds : 0.0,
+                static_cast<double>(outputBytes) / clientBytes);
+    }
+
+    std::wstring _DefaultHost()
+    {
+        wchar_t path[MAX_PATH];
+        THROW_LAST_ERROR_IF(GetModuleFileNameW(nullptr, path, ARRAYSIZE(path)) == 0);
+
+        std::wstring host{ path };
+        host.resize(host.find_last_of(L'\\') + 1);
+        host += L"OpenConsole.exe";
+
+        return GetFileAttributesW(host.c_str()) != INVALID_FILE_ATTRIBUTES ? host : L"conhost.exe";
+    }
+
+    // Writes out a string as a JSON string, escaping what needs it.
+    std::wstring _JsonString(const std::wstring_view text)
+    {
+        std::wstring json{ L"\"" };
+        for (const auto ch : text)
+        {
+            if (ch == L'"' || ch == L'\\')
+            {
+                json += L'\\';
+            }
+            json += ch;
+        }
+        json += L'"';
+        return json;
+    }
+#pragma endregion
+
+    void _PrintUsage()
+    {
+        fwprintf(stderr, L"Usage: ConPtyBench.exe [-c <host>] [-n <keystrokes>] [-b <MB written by the client>]\n");
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+try
+{
+    if (argc >= 3 && std::wstring_view{ argv[1] } == L"--client")
+    {
+        const std::wstring_view mode{ argv[2] };
+        if (mode == L"echo")
+        {
+            return _RunEchoClient();
+        }
+        else if (mode == L"flood" && argc >= 4)
+        {
+            return _RunFloodClient(wcstoull(argv[3], nullptr, 10));
+        }
+        return 1;
+    }
+
+    std::wstring host;
+    size_t keystrokes = 200;
+    size_t clientMB = 16;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::wstring_view arg{ argv[i] };
+        if (arg == L"-c" && i + 1 < argc)
+        {
+            host = argv[++i];
+        }
+        else if ((arg == L"-n" || arg == L"-b") && i + 1 < argc)
+        {
+            const auto value = wcstoul(argv[++i], nullptr, 10);
+            if (value == 0)
+            {
+                _PrintUsage();
+                return 1;
+            }
+            (arg == L"-n" ? keystrokes : clientMB) = value;
+        }
+        else
+        {
+            _PrintUsage();
+            return arg == L"-?" || arg == L"-h" ? 0 : 1;
+        }
+    }
+
+    if (host.empty())
+    {
+        host = _DefaultHost();
+    }
+
+    wprintf(L"{\n");
+    wprintf(L"  \"host\": %s,\n", _JsonString(host).c_str());
+    wprintf(L"  \"width\": %u,\n", PtyWidth);
+    wprintf(L"  \"height\": %u,\n", PtyHeight);
+    _MeasureEcho(host, keystrokes);
+    _MeasureThroughput(host, clientMB * 1024 * 1024);
+    wprintf(L"}\n");
+
+    return 0;
+}
+catch (...)
+{
+    const auto hr = wil::ResultFromCaughtException();
+    fwprintf(stderr, L"ConPtyBench failed: 0x%08x\n", hr);
+    return hr;
+}
@@ -0,0 +1,314 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+//
+// RenderBench measures what it costs to paint a frame, apart from everything else.
+// A Renderer draws a headless Terminal with a screen full of colored text into one
+// engine at a time:
+// - DxEngine, onto a composition swap chain that isn't attached to any visual, the kind
+//   a TermControl gets before XAML takes it.
+// - GdiEngine, which composes every frame in its memory DC and copies it out to a small
+//   window of its own, since it paints nothing while it has no visible window.
+//
+// Frames are painted on this thread, one per step of a scenario, without a render thread
+// in between, so the timings are of PaintFrame alone. For each scenario it prints:
+// - the mean CPU time this thread spent per frame,
+// - the P50 and P99 of the wall clock time per frame.
+//
+// Both engines wait for the frame to be presented, so the wall clock time covers the time
+// the GPU (or GDI) took to put it on the screen. Neither hands out its device, so there's
+// no separate measure of GPU time.
+//
+// Usage:
+//   RenderBench.exe [-e dx|gdi] [-f <frames per scenario>]
+
+#include "precomp.h"
+
+#include "../../cascadia/TerminalCore/Terminal.hpp"
+#include "../../renderer/base/renderer.hpp"
+#include "../../renderer/dx/DxRenderer.hpp"
+#include "../../renderer/gdi/gdirenderer.hpp"
+
+#include <chrono>
+
+using namespace Microsoft::Console::Render;
+using namespace Microsoft::Terminal::Core;
+
+namespace
+{
+    constexpr COORD TerminalSize{ 120, 30 };
+
+    // The renderer wants a thread to poke when there's something to paint. Frames are
+    // painted right here instead, so there's nothing to poke.
+    class SynchronousRenderThread final : public IRenderThread
+    {
+    public:
+        void NotifyPaint() override {}
+        void EnablePainting() override {}
+        void WaitForPaintCompletionAndDisable(const DWORD /*dwTimeoutMs*/) override {}
+        void BeginSynchronizedUpdate() override {}
+        void EndSynchronizedUpdate() override {}
+    };
+
+    struct Scenario
+    {
+        std::wstring name;
+        std::function<void(Terminal&, Renderer&, const size_t frame)> step;
+    };
+
+    std::vector<Scenario> _MakeScenarios()
+    {
+        return {
+            { L"full repaint",
+              [](Terminal&, Renderer& renderer, const size_t) {
+                  renderer.TriggerRedrawAll();
+              } },
+            { L"single line update",
+              [](Terminal& terminal, Renderer&, const size_t frame) {
+                  wchar_t line[128];
+                  swprintf_s(line, L"\x1b[15;1H\x1b[38;5;%zum%zu lines changed, %zu insertions(+)\x1b[0m\x1b[K", frame % 256, frame, frame * 3);
+                  terminal.Write(line);
+              } },
+            { L"scroll by 1",
+              [](Terminal& terminal, Renderer&, const size_t frame) {
+                  wchar_t line[128];
+                  swprintf_s(line, L"\x1b[%d;1H\r\n\x1b[1;34m%zu\x1b[0m a line scrolled in at the bottom", TerminalSize.Y, frame);
+                  terminal.Write(line);
+              } },
+            { L"cursor blink",
+              [](Terminal& terminal, Renderer& renderer, const size_t frame) {
+                  terminal.SetCursorVisible(frame % 2 != 0);
+                  auto cursor = static_cast<const IRenderData&>(terminal).GetCursorPosition();
+                  renderer.TriggerRedrawCursor(&cursor);
+              } },
+            { L"selection drag",
+              [](Terminal& terminal, Renderer& renderer, const size_t frame) {
+                  if (frame == 0)
+                  {
+                      terminal.SetSelectionAnchor({ 4, 2 });
+                  }
+                  const auto cells = frame % (TerminalSize.X * (TerminalSize.Y - 4));
+                  terminal.SetEndSelectionPosition({ gsl::narrow_cast<SHORT>(cells % TerminalSize.X),
+                                                     gsl::narrow_cast<SHORT>(2 + cells / TerminalSize.X) });
+                  renderer.TriggerSelection();
+              } },
+        };
+    }
+
+    // Fills the screen with the sort of thing a terminal shows: colored prompts,
+    // compiler output, and a status line in reverse video.
+    void _FillScreen(Terminal& terminal)
+    {
+        terminal.Write(L"\x1b[H\x1b[2J");
+        for (SHORT row = 0; row < TerminalSize.Y - 1; ++row)
+        {
+            wchar_t line[256];
+            swprintf_s(line,
+                       L"\x1b[1;32muser@host\x1b[0m:\x1b[1;34m~/src/%d\x1b[0m$ \x1b[1msrc/renderer/base/renderer.cpp:%d:9: \x1b[1;35mwarning:\x1b[0m unused variable 'width'\r\n",
+                       row,
+                       100 + row);
+            terminal.Write(line);
+        }
+        terminal.Write(L"\x1b[7m -- NORMAL --  renderer.cpp  [+]\x1b[0m");
+    }
+
+    ULONGLONG _ThreadCpuTime()
+    {
+        FILETIME creation, exit, kernel, user;
+        THROW_IF_WIN32_BOOL_FALSE(GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user));
+
+        const ULARGE_INTEGER k{ kernel.dwLowDateTime, kernel.dwHighDateTime };
+        const ULARGE_INTEGER u{ user.dwLowDateTime, user.dwHighDateTime };
+        return k.QuadPart + u.QuadPart;
+    }
+
+    void _PumpMessages()
+    {
+        MSG msg;
+        while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE))
+        {
+            TranslateMessage(&msg);
+            DispatchMessageW(&msg);
+        }
+    }
+
+    double _Percentile(const std::vector<double>& sorted, const size_t percent)
+    {
+        return sorted.at(std::min(sorted.size() - 1, sorted.size() * percent / 100));
+    }
+
+    // Paints the given number of frames of every scenario with the given engine. prepare gets
+    // the engine ready to paint once the font is known, given the size of the screen in pixels.
+    void _Run(const PCWSTR engineName,
+              IRenderEngine& engine,
+              const std::function<void(const SIZE)>& prepare,
+              const size_t frames)
+    {
+        Terminal terminal;
+        IRenderEngine* engines[] = { &engine };
+        Renderer renderer{ &terminal, engines, ARRAYSIZE(engines), std::make_unique<SynchronousRenderThread>() };
+        terminal.Create(TerminalSize, 0, renderer);
+
+        FontInfoDesired desiredFont{ L"Consolas", 0, FW_NORMAL, { 0, 16 }, CP_UTF8 };
+        FontInfo actualFont{ L"Consolas", 0, FW_NORMAL, { 0, 16 }, CP_UTF8, false };
+        renderer.TriggerFontChange(USER_DEFAULT_SCREEN_DPI, desiredFont, actualFont);
+
+        COORD fontSize{};
+        THROW_IF_FAILED(engine.GetFontSize(&fontSize));
+        prepare({ TerminalSize.X * fontSize.X, TerminalSize.Y * fontSize.Y });
+
+        for (const auto& scenario : _MakeScenarios())
+        {
+            _FillScreen(terminal);
+            terminal.ClearSelection();
+            renderer.TriggerRedrawAll();
+            THROW_IF_FAILED(renderer.PaintFrame());
+
+            std::vector<double> frameTimes;
+            frameTimes.reserve(frames);
+            ULONGLONG cpuTime = 0;
+
+            for (size_t frame = 0; frame < frames; ++frame)
+            {
+                scenario.step(terminal, renderer, frame);
+
+                const auto cpuBefore = _ThreadCpuTime();
+                const auto start = std::chrono::steady_clock::now();
+
+                THROW_IF_FAILED(renderer.PaintFrame());
+
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                cpuTime += _ThreadCpuTime() - cpuBefore;
+                frameTimes.push_back(std::chrono::duration<double, std::milli>(elapsed).count());
+
+                _PumpMessages();
+            }
+
+            std::sort(frameTimes.begin(), frameTimes.end());
+
+            // GetThreadTimes counts in 100ns units.
+            wprintf(L"%-4s %-20s %8.3f ms CPU/frame %8.3f ms P50 %8.3f ms P99\n",
+                    engineName,
+                    scenario.name.c_str(),
+                    cpuTime / 10000.0 / frames,
+                    _Percentile(frameTimes, 50),
+                    _Percentile(frameTimes, 99));
+        }
+    }
+
+    void _RunDx(const size_t frames)
+    {
+        DxEngine engine;
+        const auto prepare = [&](const SIZE pixels) {
+            THROW_IF_FAILED(engine.SetWindowSize(pixels));
+            THROW_IF_FAILED(engine.Enable());
+        };
+
+        _Run(L"dx", engine, prepare, frames);
+    }
+
+    void _RunGdi(const size_t frames)
+    {
+        WNDCLASSEXW windowClass{};
+        windowClass.cbSize = sizeof(windowClass);
+        windowClass.lpfnWndProc = DefWindowProcW;
+        windowClass.hInstance = GetModuleHandleW(nullptr);
+        windowClass.hCursor = LoadCursorW(nullptr, IDC_ARROW);
+        windowClass.lpszClassName = L"RenderBenchWindow";
+        RegisterClassExW(&windowClass);
+
+        wil::unique_hwnd window{ CreateWindowExW(WS_EX_NOACTIVATE,
+                                                 windowClass.lpszClassName,
+                                                 L"RenderBench",
+                                                 WS_OVERLAPPEDWINDOW,
+                                                 CW_USEDEFAULT,
+                                                 CW_USEDEFAULT,
+                                                 CW_USEDEFAULT,
+                                                 CW_USEDEFAULT,
+                                                 nullptr,
+                                                 nullptr,
+                                                 windowClass.hInstance,
+                                                 nullptr) };
+        THROW_LAST_ERROR_IF_NULL(window);
+
+        GdiEngine engine;
+        THROW_IF_FAILED(engine.SetHwnd(window.get()));
+
+        const auto prepare = [&](const SIZE pixels) {
+            RECT rc{ 0, 0, pixels.cx, pixels.cy };
+            THROW_IF_WIN32_BOOL_FALSE(AdjustWindowRectEx(&rc, WS_OVERLAPPEDWINDOW, FALSE, WS_EX_NOACTIVATE));
+            THROW_IF_WIN32_BOOL_FALSE(SetWindowPos(window.get(), nullptr, 0, 0, rc.right - rc.left, rc.bottom - rc.top, SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE));
+            ShowWindow(window.get(), SW_SHOWNOACTIVATE);
+            _PumpMessages();
+        };
+
+        _Run(L"gdi", engine, prepare, frames);
+    }
+
+    void _PrintUsage()
+    {
+        wprintf(L"Usage: RenderBench.exe [-e dx|gdi] [-f <frames per scenario>]\n");
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+try
+{
+    size_t frames = 300;
+    bool runDx = true;
+    bool runGdi = true;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::wstring_view arg{ argv[i] };
+        if (arg == L"-?" || arg == L"-h")
+        {
+            _PrintUsage();
+            return 0;
+        }
+        else if (arg == L"-e" && i + 1 < argc)
+        {
+            const std::wstring_view engine{ argv[++i] };
+            runDx = engine == L"dx";
+            runGdi = engine == L"gdi";
+            if (!runDx && !runGdi)
+            {
+                _PrintUsage();
+                return 1;
+            }
+        }
+        else if (arg == L"-f" && i + 1 < argc)
+        {
+            frames = wcstoul(argv[++i], nullptr, 10);
+            if (frames == 0)
+            {
+                _PrintUsage();
+                return 1;
+            }
+        }
+        else
+        {
+            _PrintUsage();
+            return 1;
+        }
+    }
+
+    wprintf(L"%zu frames per scenario, %dx%d terminal\n", frames, TerminalSize.X, TerminalSize.Y);
+
+    if (runDx)
+    {
+        _RunDx(frames);
+    }
+
+    if (runGdi)
+    {
+        _RunGdi(frames);
+    }
+
+    return 0;
+}
+catch (...)
+{
+    const auto hr = wil::ResultFromCaughtException();
+    fwprintf(stderr, L"RenderBench failed: 0x%08x\n", hr);
+    return hr;
+}
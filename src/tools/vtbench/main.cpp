@@ -0,0 +1,359 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+//
+// VtBench replays VT output through the same path a TermControl feeds it through:
+// Terminal::Write hands it to a StateMachine with an OutputStateMachineEngine, which
+// dispatches it to TerminalDispatch and into the Terminal's buffer. Nothing is drawn;
+// the terminal renders into a DummyRenderTarget.
+//
+// For each corpus it prints the throughput in MB/s, the time spent per byte, and how
+// many allocations were made per MB. Sizes are of the corpus as UTF-8, which is what
+// a connection would have read off the wire.
+//
+// Usage:
+//   VtBench.exe [-i <iterations>] [-s <MB per built-in corpus>] [<recorded output>...]
+//
+// Without any files, the built-in corpora are replayed. Files are read as UTF-8 and
+// replayed as they are, e.g. a log recorded with `script` or from a ConPTY.
+
+#include "precomp.h"
+
+#include "../../cascadia/TerminalCore/Terminal.hpp"
+#include "../../renderer/inc/DummyRenderTarget.hpp"
+#include "../../types/inc/AllocationTracking.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+
+using namespace Microsoft::Terminal::Core;
+
+#pragma region Allocation counting
+#ifndef CON_TRACK_ALLOCATIONS
+// Every allocation of the process goes through these, so the number made while a
+// corpus is replayed is exactly what the parser and the buffer asked for.
+// Builds that track allocations already replace them in AllocationTracking.cpp,
+// so those read the counts from there instead.
+static std::atomic<size_t> g_allocations{ 0 };
+
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (size == 0)
+    {
+        size = 1;
+    }
+
+    for (;;)
+    {
+        if (const auto p = malloc(size))
+        {
+            return p;
+        }
+
+        const auto handler = std::get_new_handler();
+        if (!handler)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    operator delete(p);
+}
+#endif
+
+// Returns how many allocations the process has made so far.
+static size_t _GetAllocationCount() noexcept
+{
+#ifdef CON_TRACK_ALLOCATIONS
+    using namespace Microsoft::Console::Types;
+    uint64_t allocations = 0;
+    for (size_t tag = 0; tag < static_cast<size_t>(AllocationTag::Count); ++tag)
+    {
+        allocations += AllocationTracking::GetCounts(static_cast<AllocationTag>(tag)).allocations;
+    }
+    return gsl::narrow_cast<size_t>(allocations);
+#else
+    return g_allocations.load(std::memory_order_relaxed);
+#endif
+}
+#pragma endregion
+
+namespace
+{
+    constexpr COORD TerminalSize{ 120, 30 };
+    constexpr SHORT ScrollbackLines = 9001;
+    constexpr double BytesPerMB = 1024.0 * 1024.0;
+
+    struct Corpus
+    {
+        std::wstring name;
+        std::wstring text;
+    };
+
+    // Repeats the lines made by makeLine until there's at least targetSize characters.
+    template<typename TMakeLine>
+    std::wstring _Repeat(const size_t targetSize, TMakeLine&& makeLine)
+    {
+        std::wstring text;
+        text.reserve(targetSize + 1024);
+
+        for (size_t i = 0; text.size() < targetSize; ++i)
+        {
+            makeLine(text, i);
+        }
+
+        return text;
+    }
+
+    // Plain text logs, the kind `type` or `cat` dump: no sequences at all, just lines.
+    std::wstring _MakePlainLog(const size_t targetSize)
+    {
+        return _Repeat(targetSize, [](std::wstring& text, const size_t i) {
+            wchar_t line[128];
+            swprintf_s(line,
+                       L"2019-08-14 12:%02zu:%02zu.%03zu [info] worker %zu served request %zu in %zums\r\n",
+                       (i / 60) % 60,
+                       i % 60,
+                       (i * 7) % 1000,
+                       i % 16,
+                       i,
+                       (i * 13) % 500);
+            text.append(line);
+        });
+    }
+
+    // Compiler diagnostics: bold file names, colored severities, and a caret line
+    // under the source, with a reset after each.
+    std::wstring _MakeCompilerOutput(const size_t targetSize)
+    {
+        return _Repeat(targetSize, [](std::wstring& text, const size_t i) {
+            wchar_t line[512];
+            swprintf_s(line,
+                       L"\x1b[1msrc/renderer/base/renderer.cpp:%zu:%zu: \x1b[0m\x1b[1;31merror: \x1b[0m\x1b[1muse of undeclared identifier 'clusters%zu'\x1b[0m\r\n"
+                       L"        const auto width = clusters%zu.size();\r\n"
+                       L"\x1b[0;1;32m                           ^\x1b[0m\r\n"
+                       L"\x1b[1msrc/renderer/base/renderer.cpp:%zu:9: \x1b[0m\x1b[1;35mwarning: \x1b[0m\x1b[1munused variable 'width'\x1b[0m [-Wunused-variable]\r\n",
+                       100 + i % 900,
+                       1 + i % 80,
+                       i % 10,
+                       i % 10,
+                       100 + i % 900);
+            text.append(line);
+        });
+    }
+
+    // Full screen redraws like htop or vim make: each row is addressed with a cursor
+    // position, painted with 256 colors, and the middle of the screen is scrolled with
+    // margins and inserted and deleted lines.
+    std::wstring _MakeFullScreenSession(const size_t targetSize)
+    {
+        return _Repeat(targetSize, [](std::wstring& text, const size_t frame) {
+            wchar_t cell[128];
+
+            text.append(L"\x1b[?25l\x1b[H");
+            for (SHORT row = 1; row <= TerminalSize.Y; ++row)
+            {
+                swprintf_s(cell, L"\x1b[%d;1H\x1b[38;5;%zum\x1b[48;5;%zum", row, (frame + row) % 256, (frame * 3 + row) % 256);
+                text.append(cell);
+
+                swprintf_s(cell, L"%5zu root      20   0  %6dM %5dM S%5.1f  0.%d  1:%02d.%02zu ", frame + row, 100 + row * 7, row * 3, (frame % 1000) / 10.0, row % 10, row % 60, frame % 100);
+                text.append(cell);
+                text.append(L"\x1b[0m/usr/bin/OpenConsole.exe --headless --vtmode xterm-256color\x1b[K");
+            }
+
+            text.append(L"\x1b[3;28r\x1b[3;1H\x1b[2L\x1b[10;1H\x1b[3M\x1b[r");
+            text.append(L"\x1b[30;1H\x1b[7m-- INSERT --\x1b[27m\x1b[?25h");
+        });
+    }
+
+    // East Asian text and emoji: wide glyphs, and characters outside the BMP that take
+    // two code units each.
+    std::wstring _MakeCjkAndEmoji(const size_t targetSize)
+    {
+        return _Repeat(targetSize, [](std::wstring& text, const size_t i) {
+            text.append(L"\x6f22\x5b57\x3068\x304b\x306a\x3068\x30ab\x30ca\x3002\xd55c\xae00\xacfc \x4e2d\x6587\x5b57\x7b26\x3002 ");
+            text.append(L"\xd83d\xde00\xd83d\xde80\xd83c\xdf89\x2764\xfe0f\xd83d\xdc4d\xd83c\xdffd ");
+            text.append(std::to_wstring(i));
+            text.append(L"\r\n");
+        });
+    }
+
+    // 24-bit color gradients: a new foreground and background for every cell.
+    std::wstring _MakeTruecolorGradient(const size_t targetSize)
+    {
+        return _Repeat(targetSize, [](std::wstring& text, const size_t i) {
+            wchar_t cell[64];
+            for (SHORT column = 0; column < TerminalSize.X; ++column)
+            {
+                const auto r = (column * 255) / TerminalSize.X;
+                const auto g = (i * 4) % 256;
+                const auto b = 255 - r;
+                swprintf_s(cell, L"\x1b[38;2;%d;%zu;%dm\x1b[48;2;%d;%d;%zum%c", r, g, b, b, r, g, L'A' + (column % 26));
+                text.append(cell);
+            }
+            text.append(L"\x1b[0m\r\n");
+        });
+    }
+
+    std::wstring _ReadUtf8File(const std::wstring& path)
+    {
+        std::ifstream file{ path, std::ios::binary };
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND), !file);
+
+        const std::string bytes{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+        if (bytes.empty())
+        {
+            return {};
+        }
+
+        const auto cch = MultiByteToWideChar(CP_UTF8, 0, bytes.data(), gsl::narrow<int>(bytes.size()), nullptr, 0);
+        THROW_LAST_ERROR_IF(cch == 0);
+
+        std::wstring text(cch, L'\0');
+        THROW_LAST_ERROR_IF(MultiByteToWideChar(CP_UTF8, 0, bytes.data(), gsl::narrow<int>(bytes.size()), text.data(), cch) == 0);
+        return text;
+    }
+
+    size_t _Utf8Size(const std::wstring_view text)
+    {
+        if (text.empty())
+        {
+            return 0;
+        }
+
+        const auto cb = WideCharToMultiByte(CP_UTF8, 0, text.data(), gsl::narrow<int>(text.size()), nullptr, 0, nullptr, nullptr);
+        THROW_LAST_ERROR_IF(cb == 0);
+        return cb;
+    }
+
+    // Replays a corpus into a new terminal the given number of times, once first to warm
+    // up, and prints what it measured.
+    void _Run(const Corpus& corpus, const size_t iterations)
+    {
+        DummyRenderTarget renderTarget;
+        Terminal terminal;
+        terminal.Create(TerminalSize, ScrollbackLines, renderTarget);
+
+        // The first pass fills the scrollback, so that the measured ones see the
+        // buffer in the state it settles in.
+        terminal.Write(corpus.text);
+
+        const auto allocationsBefore = _GetAllocationCount();
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            terminal.Write(corpus.text);
+        }
+
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const auto allocations = _GetAllocationCount() - allocationsBefore;
+
+        const double bytes = static_cast<double>(_Utf8Size(corpus.text)) * iterations;
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        const double megabytes = bytes / BytesPerMB;
+
+        wprintf(L"%-24s %10.2f MB %10.2f MB/s %10.2f ns/byte %12.1f allocs/MB\n",
+                corpus.name.c_str(),
+                megabytes,
+                seconds > 0 ? megabytes / seconds : 0.0,
+                bytes > 0 ? (seconds * 1e9) / bytes : 0.0,
+                megabytes > 0 ? allocations / megabytes : 0.0);
+    }
+
+    void _PrintUsage()
+    {
+        wprintf(L"Usage: VtBench.exe [-i <iterations>] [-s <MB per built-in corpus>] [<recorded output>...]\n");
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+try
+{
+    size_t iterations = 5;
+    size_t corpusMB = 4;
+    std::vector<std::wstring> files;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::wstring_view arg{ argv[i] };
+        if (arg == L"-?" || arg == L"-h")
+        {
+            _PrintUsage();
+            return 0;
+        }
+        else if ((arg == L"-i" || arg == L"-s") && i + 1 < argc)
+        {
+            const auto value = wcstoul(argv[++i], nullptr, 10);
+            if (value == 0)
+            {
+                _PrintUsage();
+                return 1;
+            }
+            (arg == L"-i" ? iterations : corpusMB) = value;
+        }
+        else if (!arg.empty() && arg.front() == L'-')
+        {
+            _PrintUsage();
+            return 1;
+        }
+        else
+        {
+            files.emplace_back(arg);
+        }
+    }
+
+    std::vector<Corpus> corpora;
+    if (files.empty())
+    {
+        // Characters, not bytes, but close enough for sizing: most of these are ASCII.
+        const auto targetSize = corpusMB * 1024 * 1024;
+        corpora.push_back({ L"plain log", _MakePlainLog(targetSize) });
+        corpora.push_back({ L"compiler output", _MakeCompilerOutput(targetSize) });
+        corpora.push_back({ L"full screen session", _MakeFullScreenSession(targetSize) });
+        corpora.push_back({ L"cjk and emoji", _MakeCjkAndEmoji(targetSize) });
+        corpora.push_back({ L"truecolor gradient", _MakeTruecolorGradient(targetSize) });
+    }
+    else
+    {
+        for (const auto& file : files)
+        {
+            corpora.push_back({ file, _ReadUtf8File(file) });
+        }
+    }
+
+    wprintf(L"%zu iterations, %dx%d terminal with %d lines of scrollback\n",
+            iterations,
+            TerminalSize.X,
+            TerminalSize.Y,
+            ScrollbackLines);
+
+    for (const auto& corpus : corpora)
+    {
+        _Run(corpus, iterations);
+    }
+
+    return 0;
+}
+catch (...)
+{
+    const auto hr = wil::ResultFromCaughtException();
+    fwprintf(stderr, L"VtBench failed: 0x%08x\n", hr);
+    return hr;
+}
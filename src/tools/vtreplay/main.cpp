@@ -0,0 +1,698 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+//
+// VtReplay records the output of a console session along with when each chunk of it
+// arrived, and plays it back later without the programs or the machine it came from.
+//
+// To record, it starts a headless host the way a ConptyConnection does and runs a command
+// line in it. What's typed is passed through to the pty, and the host's output is shown
+// in this console and saved. The output is read with the same UTF8OutPipeReader that a
+// ConptyConnection reads it with, so the chunks are the ones a TermControl would have got.
+//
+// To play, the chunks are written, at the times they were recorded or as fast as they can
+// be, into one of:
+// - terminal: a Terminal drawn by a Renderer on a RenderThread of its own, into a DxEngine
+//   on a composition swap chain that isn't attached to any visual, like a TermControl.
+// - conhost: a headless host, with a copy of VtReplay as the client writing the chunks
+//   with WriteConsoleA and VT processing on. They make their way through the host's
+//   state machine and back out of VtIo, where they're read and thrown away.
+//
+// Afterwards it prints the throughput, the time it took, the peak working set of the process
+// that did the work, and how many frames were painted. conhost doesn't count its frames, so
+// for it the number of reads that got something out of the output pipe stands in.
+//
+// Usage:
+//   VtReplay.exe record <file> [-c <host>] -- <command line>
+//   VtReplay.exe play <file> [-max] [-t terminal|conhost] [-c <host>]
+//
+// The host defaults to the OpenConsole.exe next to VtReplay.exe, or conhost.exe if there
+// isn't one.
+
+#include "precomp.h"
+
+#include "../../cascadia/TerminalCore/Terminal.hpp"
+#include "../../renderer/base/renderer.hpp"
+#include "../../renderer/base/thread.hpp"
+#include "../../renderer/dx/DxRenderer.hpp"
+#include "../../types/inc/convert.hpp"
+#include "../../types/inc/UTF8OutPipeReader.hpp"
+
+#include <psapi.h>
+
+#include <chrono>
+#include <condition_variable>
+
+using namespace std::chrono_literals;
+using namespace Microsoft::Console::Render;
+using namespace Microsoft::Terminal::Core;
+
+namespace
+{
+    // A recording is a FileHeader followed by chunks, each of them a ChunkHeader and
+    // then the bytes of the chunk. Everything is little endian.
+    constexpr uint32_t RecordingMagic = 0x50525456; // "VTRP", as it's laid out in the file
+    constexpr uint32_t RecordingVersion = 1;
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint16_t width;
+        uint16_t height;
+    };
+
+    struct ChunkHeader
+    {
+        uint64_t microseconds; // since the recording started
+        uint32_t size;
+    };
+
+    struct Chunk
+    {
+        std::chrono::microseconds time;
+        std::string bytes;
+    };
+
+    struct Recording
+    {
+        COORD size;
+        std::vector<Chunk> chunks;
+        size_t bytes;
+    };
+
+    // The client writes this once it's written everything else. It's a private use
+    // character from the last plane, which no font in a recorded session should be using.
+    constexpr std::string_view Sentinel{ "\xf4\x8f\xbf\xbd" };
+
+    // Tells a client to quit.
+    constexpr char QuitKey = 'q';
+
+    constexpr SHORT ScrollbackLines = 9001;
+    constexpr double BytesPerMB = 1024.0 * 1024.0;
+    constexpr auto Timeout = 30s;
+
+    using clock = std::chrono::steady_clock;
+
+    void _WriteField(std::ofstream& file, const void* const data, const size_t size)
+    {
+        file.write(static_cast<const char*>(data), size);
+        THROW_HR_IF(E_FAIL, !file);
+    }
+
+    void _ReadField(std::ifstream& file, void* const data, const size_t size)
+    {
+        file.read(static_cast<char*>(data), size);
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_HANDLE_EOF), !file);
+    }
+
+    Recording _ReadRecording(const std::wstring& path)
+    {
+        std::ifstream file{ path, std::ios::binary };
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND), !file);
+
+        FileHeader header;
+        _ReadField(file, &header.magic, sizeof(header.magic));
+        _ReadField(file, &header.version, sizeof(header.version));
+        _ReadField(file, &header.width, sizeof(header.width));
+        _ReadField(file, &header.height, sizeof(header.height));
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_BAD_FORMAT), header.magic != RecordingMagic || header.version != RecordingVersion);
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_BAD_FORMAT), header.width == 0 || header.height == 0);
+
+        Recording recording{ { gsl::narrow<SHORT>(header.width), gsl::narrow<SHORT>(header.height) }, {}, 0 };
+        for (;;)
+        {
+            ChunkHeader chunk;
+            if (!file.read(reinterpret_cast<char*>(&chunk.microseconds), sizeof(chunk.microseconds)))
+            {
+                break;
+            }
+            _ReadField(file, &chunk.size, sizeof(chunk.size));
+
+            std::string bytes(chunk.size, '\0');
+            _ReadField(file, bytes.data(), bytes.size());
+
+            recording.bytes += bytes.size();
+            recording.chunks.push_back({ std::chrono::microseconds{ chunk.microseconds }, std::move(bytes) });
+        }
+
+        return recording;
+    }
+
+    size_t _PeakWorkingSet(const HANDLE process)
+    {
+        PROCESS_MEMORY_COUNTERS counters{};
+        counters.cb = sizeof(counters);
+        THROW_IF_WIN32_BOOL_FALSE(GetProcessMemoryInfo(process, &counters, sizeof(counters)));
+        return counters.PeakWorkingSetSize;
+    }
+
+    // Waits until it's time for the given chunk, unless the chunks go as fast as they can.
+    void _WaitFor(const Chunk& chunk, const clock::time_point start, const bool maxSpeed)
+    {
+        if (!maxSpeed)
+        {
+            std::this_thread::sleep_until(start + chunk.time);
+        }
+    }
+
+    void _PrintResults(const Recording& recording, const std::chrono::duration<double> elapsed, const size_t peakWorkingSet, const uint64_t frames)
+    {
+        const auto seconds = elapsed.count();
+        const auto recorded = recording.chunks.empty() ? 0.0 : std::chrono::duration<double>(recording.chunks.back().time).count();
+        wprintf(L"%zu chunks, %.2f MB, %dx%d, recorded over %.3f s\n",
+                recording.chunks.size(),
+                recording.bytes / BytesPerMB,
+                recording.size.X,
+                recording.size.Y,
+                recorded);
+        wprintf(L"played in %.3f s, %.2f MB/s, peak working set %.2f MB, %llu frames\n",
+                seconds,
+                seconds > 0 ? recording.bytes / BytesPerMB / seconds : 0.0,
+                peakWorkingSet / BytesPerMB,
+                frames);
+    }
+
+    // A headless host, started like CreateConPty starts it, running the given command line.
+    class Pty
+    {
+    public:
+        Pty(const std::wstring& host, const COORD size, const std::wstring& commandLine)
+        {
+            // As in CreateConPty, the pipes are made uninheritable and only the host's ends
+            // are marked inheritable, so that the host doesn't get our ends as well.
+            wil::unique_hfile inPipeHostSide;
+            wil::unique_hfile outPipeHostSide;
+
+            SECURITY_ATTRIBUTES sa{};
+            sa.nLength = sizeof(sa);
+            sa.bInheritHandle = FALSE;
+
+            THROW_IF_WIN32_BOOL_FALSE(CreatePipe(&inPipeHostSide, &_input, &sa, 0));
+            THROW_IF_WIN32_BOOL_FALSE(CreatePipe(&_output, &outPipeHostSide, &sa, 0));
+            THROW_IF_WIN32_BOOL_FALSE(SetHandleInformation(inPipeHostSide.get(), HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT));
+            THROW_IF_WIN32_BOOL_FALSE(SetHandleInformation(outPipeHostSide.get(), HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT));
+
+            auto cmdline = L"\"" + host + L"\" --headless";
+            cmdline += L" --width " + std::to_wstring(size.X);
+            cmdline += L" --height " + std::to_wstring(size.Y);
+            cmdline += L" -- " + commandLine;
+
+            STARTUPINFOW si{};
+            si.cb = sizeof(si);
+            si.hStdInput = inPipeHostSide.get();
+            si.hStdOutput = outPipeHostSide.get();
+            si.hStdError = outPipeHostSide.get();
+            si.dwFlags = STARTF_USESTDHANDLES;
+
+            THROW_IF_WIN32_BOOL_FALSE(CreateProcessW(nullptr,
+                                                     cmdline.data(),
+                                                     nullptr, // lpProcessAttributes
+                                                     nullptr, // lpThreadAttributes
+                                                     TRUE, // bInheritHandles
+                                                     0, // dwCreationFlags
+                                                     nullptr, // lpEnvironment
+                                                     nullptr, // lpCurrentDirectory
+                                                     &si,
+                                                     &_host));
+        }
+
+        ~Pty()
+        {
+            // Closing the input ends the client; if the host doesn't follow, it's stopped.
+            _input.reset();
+            if (WaitForSingleObject(_host.hProcess, 5000) != WAIT_OBJECT_0)
+            {
+                TerminateProcess(_host.hProcess, 1);
+            }
+        }
+
+        void Write(const std::string_view bytes)
+        {
+            DWORD written = 0;
+            THROW_IF_WIN32_BOOL_FALSE(WriteFile(_input.get(), bytes.data(), static_cast<DWORD>(bytes.size()), &written, nullptr));
+        }
+
+        HANDLE Input() const noexcept
+        {
+            return _input.get();
+        }
+
+        HANDLE Output() const noexcept
+        {
+            return _output.get();
+        }
+
+        HANDLE Process() const noexcept
+        {
+            return _host.hProcess;
+        }
+
+    private:
+        wil::unique_hfile _input;
+        wil::unique_hfile _output;
+        wil::unique_process_information _host;
+    };
+
+    std::wstring _DefaultHost()
+    {
+        wchar_t path[MAX_PATH];
+        THROW_LAST_ERROR_IF(GetModuleFileNameW(nullptr, path, ARRAYSIZE(path)) == 0);
+
+        std::wstring host{ path };
+        host.resize(host.find_last_of(L'\\') + 1);
+        host += L"OpenConsole.exe";
+
+        return GetFileAttributesW(host.c_str()) != INVALID_FILE_ATTRIBUTES ? host : L"conhost.exe";
+    }
+
+    std::wstring _Self()
+    {
+        wchar_t self[MAX_PATH];
+        THROW_LAST_ERROR_IF(GetModuleFileNameW(nullptr, self, ARRAYSIZE(self)) == 0);
+        return self;
+    }
+
+#pragma region Record
+    int _Record(const std::wstring& path, const std::wstring& host, const std::wstring& commandLine)
+    {
+        const auto hIn = GetStdHandle(STD_INPUT_HANDLE);
+        const auto hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+
+        // The session gets the size of this console, so that it looks the same while it's recorded.
+        COORD size{ 120, 30 };
+        CONSOLE_SCREEN_BUFFER_INFO info;
+        if (GetConsoleScreenBufferInfo(hOut, &info))
+        {
+            size = { static_cast<SHORT>(info.srWindow.Right - info.srWindow.Left + 1),
+                     static_cast<SHORT>(info.srWindow.Bottom - info.srWindow.Top + 1) };
+        }
+
+        // Keys are read as VT and handed to the pty as they are, and its output is shown
+        // as it is, like a terminal would.
+        DWORD inMode = 0;
+        DWORD outMode = 0;
+        THROW_IF_WIN32_BOOL_FALSE(GetConsoleMode(hIn, &inMode));
+        THROW_IF_WIN32_BOOL_FALSE(GetConsoleMode(hOut, &outMode));
+        auto restoreModes = wil::scope_exit([&]() {
+            SetConsoleMode(hIn, inMode);
+            SetConsoleMode(hOut, outMode);
+        });
+        THROW_IF_WIN32_BOOL_FALSE(SetConsoleMode(hIn, ENABLE_VIRTUAL_TERMINAL_INPUT));
+        THROW_IF_WIN32_BOOL_FALSE(SetConsoleMode(hOut, outMode | ENABLE_VIRTUAL_TERMINAL_PROCESSING | DISABLE_NEWLINE_AUTO_RETURN));
+
+        std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+        THROW_HR_IF(E_ACCESSDENIED, !file);
+
+        const FileHeader header{ RecordingMagic, RecordingVersion, gsl::narrow<uint16_t>(size.X), gsl::narrow<uint16_t>(size.Y) };
+        _WriteField(file, &header.magic, sizeof(header.magic));
+        _WriteField(file, &header.version, sizeof(header.version));
+        _WriteField(file, &header.width, sizeof(header.width));
+        _WriteField(file, &header.height, sizeof(header.height));
+
+        Pty pty{ host, size, commandLine };
+        const auto start = clock::now();
+
+        // The input thread spends its life blocked reading the console, and there's no
+        // reliable way to wake it, so it's left to end with the process. It gets a pipe
+        // handle of its own, which it can go on writing to once the host is gone.
+        wil::unique_hfile input;
+        THROW_IF_WIN32_BOOL_FALSE(DuplicateHandle(GetCurrentProcess(), pty.Input(), GetCurrentProcess(), &input, 0, FALSE, DUPLICATE_SAME_ACCESS));
+        std::thread{ [input = std::move(input), hIn]() {
+            char buffer[256];
+            DWORD read = 0;
+            DWORD written = 0;
+            while (ReadFile(hIn, buffer, ARRAYSIZE(buffer), &read, nullptr) && read > 0 &&
+                   WriteFile(input.get(), buffer, read, &written, nullptr))
+            {
+            }
+        } }.detach();
+
+        UTF8OutPipeReader reader{ pty.Output() };
+        size_t chunks = 0;
+        size_t bytes = 0;
+        for (;;)
+        {
+            std::string_view chunk;
+            if (FAILED(reader.Read(chunk)) || chunk.empty())
+            {
+                break;
+            }
+
+            const ChunkHeader chunkHeader{ gsl::narrow_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count()),
+                                           gsl::narrow<uint32_t>(chunk.size()) };
+            _WriteField(file, &chunkHeader.microseconds, sizeof(chunkHeader.microseconds));
+            _WriteField(file, &chunkHeader.size, sizeof(chunkHeader.size));
+            _WriteField(file, chunk.data(), chunk.size());
+
+            DWORD written = 0;
+            WriteFile(hOut, chunk.data(), static_cast<DWORD>(chunk.size()), &written, nullptr);
+
+            ++chunks;
+            bytes += chunk.size();
+        }
+
+        file.flush();
+        THROW_HR_IF(E_FAIL, !file);
+
+        restoreModes.reset();
+        fwprintf(stderr, L"\nRecorded %zu chunks, %.2f MB to %s\n", chunks, bytes / BytesPerMB, path.c_str());
+        return 0;
+    }
+#pragma endregion
+
+#pragma region Play into a Terminal
+    void _PlayIntoTerminal(const Recording& recording, const bool maxSpeed)
+    {
+        // Declared in the order a TermControl tears them down in: the renderer goes
+        // first, then its engine, then the terminal it drew.
+        Terminal terminal;
+        DxEngine engine;
+
+        auto renderThread = std::make_unique<RenderThread>();
+        auto* const localPointerToThread = renderThread.get();
+        Renderer renderer{ &terminal, nullptr, 0, std::move(renderThread) };
+        THROW_IF_FAILED(localPointerToThread->Initialize(&renderer));
+        renderer.AddRenderEngine(&engine);
+        auto teardown = wil::scope_exit([&]() { renderer.TriggerTeardown(); });
+
+        terminal.Create(recording.size, ScrollbackLines, renderer);
+
+        FontInfoDesired desiredFont{ L"Consolas", 0, FW_NORMAL, { 0, 16 }, CP_UTF8 };
+        FontInfo actualFont{ L"Consolas", 0, FW_NORMAL, { 0, 16 }, CP_UTF8, false };
+        renderer.TriggerFontChange(USER_DEFAULT_SCREEN_DPI, desiredFont, actualFont);
+
+        COORD fontSize{};
+        THROW_IF_FAILED(engine.GetFontSize(&fontSize));
+        THROW_IF_FAILED(engine.SetWindowSize({ recording.size.X * fontSize.X, recording.size.Y * fontSize.Y }));
+        THROW_IF_FAILED(engine.Enable());
+        renderer.EnablePainting();
+
+        // UTF-8 never needs more UTF-16 units than it has bytes, so one buffer as long as
+        // the longest chunk does for all of them, as in ConptyConnection.
+        std::wstring text;
+        const auto framesBefore = renderer.GetFrameCounters().frames;
+        const auto start = clock::now();
+
+        for (const auto& chunk : recording.chunks)
+        {
+            _WaitFor(chunk, start, maxSpeed);
+
+            if (text.size() < chunk.bytes.size())
+            {
+                text.resize(chunk.bytes.size());
+            }
+            size_t written;
+            THROW_IF_FAILED(ConvertUtf8ToW(chunk.bytes, { text.data(), gsl::narrow_cast<ptrdiff_t>(text.size()) }, false, written));
+            terminal.Write({ text.data(), written });
+        }
+
+        const auto elapsed = clock::now() - start;
+
+        // Let the render thread catch up with the last of it, so that its frames count too.
+        for (auto frames = renderer.GetFrameCounters().frames;;)
+        {
+            std::this_thread::sleep_for(100ms);
+            const auto now = renderer.GetFrameCounters().frames;
+            if (now == frames)
+            {
+                break;
+            }
+            frames = now;
+        }
+        renderer.WaitForPaintCompletionAndDisable(INFINITE);
+
+        _PrintResults(recording, elapsed, _PeakWorkingSet(GetCurrentProcess()), renderer.GetFrameCounters().frames - framesBefore);
+    }
+#pragma endregion
+
+#pragma region Play into conhost
+    // The client runs inside the pty. It waits for a key to start, writes the recording,
+    // then the sentinel, and stays until it's told to quit, so that the host has the
+    // chance to render everything and its memory can still be looked at.
+    int _RunClient(const std::wstring& path, const bool maxSpeed)
+    {
+        const auto recording = _ReadRecording(path);
+
+        const auto hIn = GetStdHandle(STD_INPUT_HANDLE);
+        const auto hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+        THROW_IF_WIN32_BOOL_FALSE(SetConsoleMode(hIn, 0));
+        THROW_IF_WIN32_BOOL_FALSE(SetConsoleOutputCP(CP_UTF8));
+        // What was recorded is a renderer's output, which moves the cursor itself.
+        THROW_IF_WIN32_BOOL_FALSE(SetConsoleMode(hOut,
+                                                 ENABLE_PROCESSED_OUTPUT | ENABLE_WRAP_AT_EOL_OUTPUT | ENABLE_VIRTUAL_TERMINAL_PROCESSING | DISABLE_NEWLINE_AUTO_RETURN));
+
+        const auto readKey = [hIn]() {
+            wchar_t ch = 0;
+            DWORD read = 0;
+            THROW_IF_WIN32_BOOL_FALSE(ReadConsoleW(hIn, &ch, 1, &read, nullptr));
+            return read ? ch : QuitKey;
+        };
+
+        readKey();
+        const auto start = clock::now();
+
+        for (const auto& chunk : recording.chunks)
+        {
+            _WaitFor(chunk, start, maxSpeed);
+
+            DWORD written = 0;
+            THROW_IF_WIN32_BOOL_FALSE(WriteConsoleA(hOut, chunk.bytes.data(), static_cast<DWORD>(chunk.bytes.size()), &written, nullptr));
+        }
+
+        const std::string end = std::string{ "\x1b[0m\r\n" } + std::string{ Sentinel };
+        DWORD written = 0;
+        THROW_IF_WIN32_BOOL_FALSE(WriteConsoleA(hOut, end.data(), static_cast<DWORD>(end.size()), &written, nullptr));
+
+        while (readKey() != QuitKey)
+        {
+        }
+        return 0;
+    }
+
+    // Reads the output of the pty on a thread of its own until the sentinel shows up,
+    // counting the reads that got something.
+    class OutputDrain
+    {
+    public:
+        explicit OutputDrain(const HANDLE output) :
+            _output{ output },
+            _thread{ [this]() { _Read(); } }
+        {
+        }
+
+        ~OutputDrain()
+        {
+            // The read can only be cancelled while it's blocked, so keep at it until the thread is gone.
+            _stopping = true;
+            while (WaitForSingleObject(_thread.native_handle(), 0) == WAIT_TIMEOUT)
+            {
+                CancelSynchronousIo(_thread.native_handle());
+                WaitForSingleObject(_thread.native_handle(), 100);
+            }
+            _thread.join();
+        }
+
+        // Throws away whatever came before, e.g. the host's first frame.
+        void Reset()
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
+            _reads = 0;
+            _carry.clear();
+            _found = false;
+        }
+
+        // Returns when the sentinel showed up in the output. A recording can take as long as
+        // it likes, so this only times out once the output has stopped coming.
+        clock::time_point Wait()
+        {
+            std::unique_lock<std::mutex> lock{ _mutex };
+            for (auto reads = _reads;; reads = _reads)
+            {
+                if (_changed.wait_for(lock, Timeout, [this]() { return _found || _closed; }))
+                {
+                    break;
+                }
+                THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_TIMEOUT), _reads == reads);
+            }
+            THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_BROKEN_PIPE), !_found);
+            return _foundAt;
+        }
+
+        uint64_t Reads()
+        {
+            std::lock_guard<std::mutex> lock{ _mutex };
+            return _reads;
+        }
+
+    private:
+        HANDLE _output;
+        std::mutex _mutex;
+        std::condition_variable _changed;
+        uint64_t _reads = 0;
+        std::string _carry;
+        bool _found = false;
+        bool _closed = false;
+        std::atomic<bool> _stopping{ false };
+        clock::time_point _foundAt;
+        std::thread _thread;
+
+        void _Read()
+        {
+            std::vector<char> buffer(64 * 1024);
+            DWORD read = 0;
+            while (!_stopping && ReadFile(_output, buffer.data(), static_cast<DWORD>(buffer.size()), &read, nullptr) && read > 0)
+            {
+                const auto now = clock::now();
+
+                std::lock_guard<std::mutex> lock{ _mutex };
+                ++_reads;
+
+                if (!_found)
+                {
+                    // The sentinel can be split across reads, so the end of the last read is searched again.
+                    _carry.append(buffer.data(), read);
+                    if (_carry.find(Sentinel) != std::string::npos)
+                    {
+                        _found = true;
+                        _foundAt = now;
+                        _changed.notify_all();
+                    }
+                    else if (_carry.size() >= Sentinel.size())
+                    {
+                        _carry.erase(0, _carry.size() - Sentinel.size() + 1);
+                    }
+                }
+            }
+
+            std::lock_guard<std::mutex> lock{ _mutex };
+            _closed = true;
+            _changed.notify_all();
+        }
+    };
+
+    void _PlayIntoConhost(const std::wstring& path, const Recording& recording, const std::wstring& host, const bool maxSpeed)
+    {
+        auto client = L"\"" + _Self() + L"\" --client \"" + path + L"\"";
+        if (maxSpeed)
+        {
+            client += L" -max";
+        }
+
+        Pty pty{ host, recording.size, client };
+        OutputDrain drain{ pty.Output() };
+
+        // Give the host and the client the time to start and paint their first frame.
+        std::this_thread::sleep_for(500ms);
+        drain.Reset();
+
+        const auto start = clock::now();
+        pty.Write("g");
+        const auto end = drain.Wait();
+
+        const auto peakWorkingSet = _PeakWorkingSet(pty.Process());
+        const auto reads = drain.Reads();
+        pty.Write({ &QuitKey, 1 });
+
+        _PrintResults(recording, end - start, peakWorkingSet, reads);
+    }
+#pragma endregion
+
+    void _PrintUsage()
+    {
+        fwprintf(stderr,
+                 L"Usage:\n"
+                 L"  VtReplay.exe record <file> [-c <host>] -- <command line>\n"
+                 L"  VtReplay.exe play <file> [-max] [-t terminal|conhost] [-c <host>]\n");
+    }
+}
+
+int __cdecl wmain(int argc, wchar_t* argv[])
+try
+{
+    if (argc >= 3 && std::wstring_view{ argv[1] } == L"--client")
+    {
+        return _RunClient(argv[2], argc >= 4 && std::wstring_view{ argv[3] } == L"-max");
+    }
+
+    if (argc < 3)
+    {
+        _PrintUsage();
+        return argc == 2 && (std::wstring_view{ argv[1] } == L"-?" || std::wstring_view{ argv[1] } == L"-h") ? 0 : 1;
+    }
+
+    const std::wstring_view verb{ argv[1] };
+    const std::wstring path{ argv[2] };
+    std::wstring host;
+    std::wstring commandLine;
+    bool maxSpeed = false;
+    bool intoTerminal = true;
+
+    for (int i = 3; i < argc; ++i)
+    {
+        const std::wstring_view arg{ argv[i] };
+        if (arg == L"-c" && i + 1 < argc)
+        {
+            host = argv[++i];
+        }
+        else if (verb == L"play" && arg == L"-max")
+        {
+            maxSpeed = true;
+        }
+        else if (verb == L"play" && arg == L"-t" && i + 1 < argc)
+        {
+            const std::wstring_view target{ argv[++i] };
+            if (target != L"terminal" && target != L"conhost")
+            {
+                _PrintUsage();
+                return 1;
+            }
+            intoTerminal = target == L"terminal";
+        }
+        else if (verb == L"record" && arg == L"--")
+        {
+            // The rest is the command line, quoted again the way it came in.
+            while (++i < argc)
+            {
+                commandLine += commandLine.empty() ? L"" : L" ";
+                commandLine += std::wstring_view{ argv[i] }.find(L' ') != std::wstring_view::npos ? L"\"" + std::wstring{ argv[i] } + L"\"" : std::wstring{ argv[i] };
+            }
+        }
+        else
+        {
+            _PrintUsage();
+            return 1;
+        }
+    }
+
+    if (host.empty())
+    {
+        host = _DefaultHost();
+    }
+
+    if (verb == L"record" && !commandLine.empty())
+    {
+        return _Record(path, host, commandLine);
+    }
+    else if (verb == L"play")
+    {
+        const auto recording = _ReadRecording(path);
+        if (intoTerminal)
+        {
+            _PlayIntoTerminal(recording, maxSpeed);
+        }
+        else
+        {
+            _PlayIntoConhost(path, recording, host, maxSpeed);
+        }
+        return 0;
+    }
+
+    _PrintUsage();
+    return 1;
+}
+catch (...)
+{
+    const auto hr = wil::ResultFromCaughtException();
+    fwprintf(stderr, L"VtReplay failed: 0x%08x\n", hr);
+    return hr;
+}
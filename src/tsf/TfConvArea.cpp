@@ -42,25 +42,106 @@ Notes:
                                                                  DEFAULT_COMP_INPUT_ERROR,
                                                                  DEFAULT_COMP_INPUT_ERROR };
 
-    const auto encodedAttributes = _DisplayAttributesToEncodedAttributes(DisplayAttributes,
-                                                                         CompCursorPos);
+    auto encodedAttributes = _DisplayAttributesToEncodedAttributes(DisplayAttributes,
+                                                                   CompCursorPos);
+
+    // Edit sessions run for every change to the document, including ones that leave the
+    // composition as it was (e.g. a reconversion of the same clause). The console keeps
+    // the last composition and repaints it by itself, so there's nothing to send then.
+    if (CompStr == _lastCompStr && encodedAttributes == _lastEncodedAttributes)
+    {
+        return S_OK;
+    }
 
     std::basic_string_view<BYTE> attributes(encodedAttributes.data(), encodedAttributes.size());
     std::basic_string_view<WORD> colorArray(colors.data(), colors.size());
 
-    return ImeComposeData(CompStr, attributes, colorArray);
+    RETURN_IF_FAILED(ImeComposeData(CompStr, attributes, colorArray));
+
+    try
+    {
+        _lastCompStr = CompStr;
+        _lastEncodedAttributes = std::move(encodedAttributes);
+    }
+    catch (...)
+    {
+        LOG_CAUGHT_EXCEPTION();
+        _ResetComposition();
+    }
+
+    return S_OK;
 }
 
 [[nodiscard]] HRESULT CConversionArea::ClearComposition()
 {
+    _ResetComposition();
     return ImeClearComposeData();
 }
 
 [[nodiscard]] HRESULT CConversionArea::DrawResult(const std::wstring_view ResultStr)
 {
+    _ResetComposition();
     return ImeComposeResult(ResultStr);
 }
 
+//+---------------------------------------------------------------------------
+//
+// CConversionArea::GetDisplayAttributes
+//
+// Looks up the display attribute of every character of the composition. Each
+// GUID atom is only resolved through the managers the first time it's seen in
+// the composition; after that it comes from _displayAttributes.
+//
+//----------------------------------------------------------------------------
+
+[[nodiscard]] std::vector<TF_DISPLAYATTRIBUTE> CConversionArea::GetDisplayAttributes(ITfCategoryMgr* cat,
+                                                                                     ITfDisplayAttributeMgr* dam,
+                                                                                     const std::vector<TfGuidAtom>& CompGuid)
+{
+    std::vector<TF_DISPLAYATTRIBUTE> DisplayAttributes;
+    DisplayAttributes.reserve(CompGuid.size());
+
+    for (const auto guidatom : CompGuid)
+    {
+        const auto it = _displayAttributes.find(guidatom);
+        if (it != _displayAttributes.end())
+        {
+            DisplayAttributes.emplace_back(it->second);
+            continue;
+        }
+
+        TF_DISPLAYATTRIBUTE da;
+        ZeroMemory(&da, sizeof(da));
+        da.bAttr = TF_ATTR_OTHER;
+
+        GUID guid;
+        if (SUCCEEDED(cat->GetGUID(guidatom, &guid)))
+        {
+            CLSID clsid;
+            wil::com_ptr_nothrow<ITfDisplayAttributeInfo> dai;
+            if (SUCCEEDED(dam->GetDisplayAttributeInfo(guid, &dai, &clsid)))
+            {
+                dai->GetAttributeInfo(&da);
+            }
+        }
+
+        _displayAttributes.emplace(guidatom, da);
+        DisplayAttributes.emplace_back(da);
+    }
+
+    return DisplayAttributes;
+}
+
+// A composition that has ended takes its attributes with it: the next one may
+// come from another text service, which is free to hand out the same GUID atoms
+// with a different look.
+void CConversionArea::_ResetComposition() noexcept
+{
+    _displayAttributes.clear();
+    _lastCompStr.clear();
+    _lastEncodedAttributes.clear();
+}
+
 [[nodiscard]] std::vector<BYTE> CConversionArea::_DisplayAttributesToEncodedAttributes(const std::vector<TF_DISPLAYATTRIBUTE>& DisplayAttributes,
                                                                                        const DWORD CompCursorPos)
 {
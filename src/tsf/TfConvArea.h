@@ -38,7 +38,22 @@ public:
 
     [[nodiscard]] HRESULT DrawResult(const std::wstring_view ResultStr);
 
+    [[nodiscard]] std::vector<TF_DISPLAYATTRIBUTE> GetDisplayAttributes(ITfCategoryMgr* cat,
+                                                                        ITfDisplayAttributeMgr* dam,
+                                                                        const std::vector<TfGuidAtom>& CompGuid);
+
 private:
     [[nodiscard]] std::vector<BYTE> _DisplayAttributesToEncodedAttributes(const std::vector<TF_DISPLAYATTRIBUTE>& DisplayAttributes,
                                                                           const DWORD CompCursorPos);
+
+    void _ResetComposition() noexcept;
+
+    // The display attribute of each GUID atom seen during the current composition. The
+    // category and display attribute managers are made anew for every edit session, so
+    // without this every keystroke would look up every character of the composition again.
+    std::unordered_map<TfGuidAtom, TF_DISPLAYATTRIBUTE> _displayAttributes;
+
+    // The composition last handed to the console, so that it isn't sent again unchanged.
+    std::wstring _lastCompStr;
+    std::vector<BYTE> _lastEncodedAttributes;
 };
@@ -961,29 +961,7 @@ CEditSessionObject::Release()
         }
         if (!CompStr.empty())
         {
-            const size_t cchDisplayAttribute = CompGuid.size();
-            std::vector<TF_DISPLAYATTRIBUTE> DisplayAttributes;
-            DisplayAttributes.reserve(cchDisplayAttribute);
-
-            for (size_t i = 0; i < cchDisplayAttribute; i++)
-            {
-                TF_DISPLAYATTRIBUTE da;
-                ZeroMemory(&da, sizeof(da));
-                da.bAttr = TF_ATTR_OTHER;
-
-                GUID guid;
-                if (SUCCEEDED(cat->GetGUID(CompGuid.at(i), &guid)))
-                {
-                    CLSID clsid;
-                    wil::com_ptr_nothrow<ITfDisplayAttributeInfo> dai;
-                    if (SUCCEEDED(dam->GetDisplayAttributeInfo(guid, &dai, &clsid)))
-                    {
-                        dai->GetAttributeInfo(&da);
-                    }
-                }
-
-                DisplayAttributes.emplace_back(da);
-            }
+            const auto DisplayAttributes = conv_area->GetDisplayAttributes(cat, dam, CompGuid);
 
             return conv_area->DrawComposition(CompStr, // composition string
                                               DisplayAttributes, // display attributes
@@ -1077,28 +1055,7 @@ CEditSessionObject::Release()
 
         if (!CompStr.empty())
         {
-            const size_t cchDisplayAttribute = CompGuid.size();
-            std::vector<TF_DISPLAYATTRIBUTE> DisplayAttributes;
-            DisplayAttributes.reserve(cchDisplayAttribute);
-
-            for (size_t i = 0; i < cchDisplayAttribute; i++)
-            {
-                TF_DISPLAYATTRIBUTE da;
-                ZeroMemory(&da, sizeof(da));
-                da.bAttr = TF_ATTR_OTHER;
-                GUID guid;
-                if (SUCCEEDED(cat->GetGUID(CompGuid.at(i), &guid)))
-                {
-                    CLSID clsid;
-                    wil::com_ptr_nothrow<ITfDisplayAttributeInfo> dai;
-                    if (SUCCEEDED(dam->GetDisplayAttributeInfo(guid, &dai, &clsid)))
-                    {
-                        dai->GetAttributeInfo(&da);
-                    }
-                }
-
-                DisplayAttributes.emplace_back(da);
-            }
+            const auto DisplayAttributes = conv_area->GetDisplayAttributes(cat, dam, CompGuid);
 
             return conv_area->DrawComposition(CompStr, // composition string (Interim string)
                                               DisplayAttributes); // display attributes
@@ -0,0 +1,154 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "inc/AllocationTracking.hpp"
+
+using namespace Microsoft::Console::Types;
+
+namespace
+{
+    constexpr size_t TagCount = static_cast<size_t>(AllocationTag::Count);
+
+    constexpr const char* TagNames[TagCount] = {
+        "Untagged",
+        "BufferOut",
+        "Parser",
+        "Renderer",
+        "Server",
+        "HostInput",
+    };
+
+#ifdef CON_TRACK_ALLOCATIONS
+    // Allocations are made on every thread, so these have to be interlocked.
+    std::atomic<uint64_t> s_allocations[TagCount];
+    std::atomic<uint64_t> s_bytes[TagCount];
+
+    thread_local AllocationTag s_currentTag = AllocationTag::Untagged;
+
+    void _Record(const size_t size) noexcept
+    {
+        const auto index = static_cast<size_t>(s_currentTag);
+        s_allocations[index].fetch_add(1, std::memory_order_relaxed);
+        s_bytes[index].fetch_add(size, std::memory_order_relaxed);
+    }
+#endif
+}
+
+// Routine Description:
+// - Gets how many allocations have been charged to a subsystem so far, and their total size.
+// Arguments:
+// - tag - The subsystem.
+// Return Value:
+// - The counts, or zeros if this build doesn't count allocations.
+AllocationCounts AllocationTracking::GetCounts(const AllocationTag tag) noexcept
+{
+    AllocationCounts counts;
+#ifdef CON_TRACK_ALLOCATIONS
+    if (tag < AllocationTag::Count)
+    {
+        const auto index = static_cast<size_t>(tag);
+        counts.allocations = s_allocations[index].load(std::memory_order_relaxed);
+        counts.bytes = s_bytes[index].load(std::memory_order_relaxed);
+    }
+#else
+    UNREFERENCED_PARAMETER(tag);
+#endif
+    return counts;
+}
+
+// Routine Description:
+// - Gets the name of a subsystem, for tracing.
+// Arguments:
+// - tag - The subsystem.
+// Return Value:
+// - The name of the subsystem.
+const char* AllocationTracking::GetTagName(const AllocationTag tag) noexcept
+{
+    return tag < AllocationTag::Count ? TagNames[static_cast<size_t>(tag)] : "Unknown";
+}
+
+#ifdef CON_TRACK_ALLOCATIONS
+AllocationScope::AllocationScope(const AllocationTag tag) noexcept :
+    _previousTag(s_currentTag)
+{
+    s_currentTag = tag;
+}
+
+AllocationScope::~AllocationScope()
+{
+    s_currentTag = _previousTag;
+}
+
+#pragma region Allocation counting
+// These replace the operators from the CRT for the whole process. They're in the same
+// object as AllocationScope, so they're linked in by anything that tags an allocation.
+void* operator new(size_t size)
+{
+    _Record(size);
+
+    if (size == 0)
+    {
+        size = 1;
+    }
+
+    for (;;)
+    {
+        if (const auto p = malloc(size))
+        {
+            return p;
+        }
+
+        const auto handler = std::get_new_handler();
+        if (!handler)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+#pragma endregion
+#endif
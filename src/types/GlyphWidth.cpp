@@ -23,6 +23,15 @@ bool IsGlyphFullWidth(const wchar_t wch)
     return widthDetector.IsWide(wch);
 }
 
+// Function Description:
+// - counts how many units at the start of the text are each a narrow glyph, so
+//      callers can skip asking about them one at a time.
+//      See CodepointWidthDetector::GetNarrowRunLength
+size_t GetNarrowGlyphRunLength(const std::wstring_view text) noexcept
+{
+    return widthDetector.GetNarrowRunLength(text);
+}
+
 // Function Description:
 // - Sets a function that should be used by the global CodepointWidthDetector
 //      as the fallback mechanism for determining a particular glyph's width,
@@ -0,0 +1,41 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "inc/Histogram.hpp"
+
+using namespace Microsoft::Console::Types;
+
+// Routine Description:
+// - Counts a time into the bucket for its power of two.
+// Arguments:
+// - microseconds - The time to count.
+// Return Value:
+// - <none>
+void Histogram::Add(const uint64_t microseconds) noexcept
+{
+    size_t bucket = 0;
+    for (auto remaining = microseconds; remaining != 0 && bucket < BucketCount - 1; remaining >>= 1)
+    {
+        ++bucket;
+    }
+
+    _buckets.at(bucket).fetch_add(1, std::memory_order_relaxed);
+}
+
+// Routine Description:
+// - Copies out the number of times counted into each bucket.
+// Arguments:
+// - <none>
+// Return Value:
+// - The count of each bucket, shortest times first.
+std::array<uint64_t, Histogram::BucketCount> Histogram::GetBuckets() const noexcept
+{
+    std::array<uint64_t, BucketCount> buckets;
+    for (size_t i = 0; i < BucketCount; ++i)
+    {
+        buckets.at(i) = _buckets.at(i).load(std::memory_order_relaxed);
+    }
+    return buckets;
+}
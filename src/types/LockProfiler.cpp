@@ -0,0 +1,470 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "inc/LockProfiler.hpp"
+
+#include <intrin.h>
+
+TRACELOGGING_DEFINE_PROVIDER(g_hConsoleLockTraceProvider,
+                             "Microsoft.Windows.Console.Locks",
+                             // tl:{865ac348-8eb5-5e5f-17bb-cdb40fda5aff}
+                             (0x865ac348, 0x8eb5, 0x5e5f, 0x17, 0xbb, 0xcd, 0xb4, 0x0f, 0xda, 0x5a, 0xff),
+                             TraceLoggingOptionMicrosoftTelemetry());
+
+using namespace Microsoft::Console::Types;
+
+namespace
+{
+    constexpr size_t LockCount = static_cast<size_t>(LockProfiler::Lock::Count);
+
+    constexpr const char* LockNames[LockCount] = {
+        "Console",
+        "Terminal",
+    };
+
+    // The shared hold of a ProfiledSharedMutex the current thread is measuring, if any.
+    // Only one is measured at a time: a shared hold taken while another one is measured
+    // on the same thread is left out.
+    struct SharedHold
+    {
+        const ProfiledSharedMutex* mutex = nullptr;
+        const void* callSite = nullptr;
+        LONGLONG acquired = 0;
+    };
+
+    thread_local SharedHold s_sharedHold;
+}
+
+LockProfiler::LockProfiler() :
+    _llPerformanceFrequency(0),
+    _longHoldMicroseconds(DefaultLongHoldMicroseconds),
+    _enabledCount(0),
+    _locks{}
+{
+    LARGE_INTEGER liFrequency;
+    QueryPerformanceFrequency(&liFrequency);
+    _llPerformanceFrequency = liFrequency.QuadPart;
+
+#ifndef UNIT_TESTING
+    TraceLoggingRegisterEx(g_hConsoleLockTraceProvider, s_ProviderCallback, this);
+#endif UNIT_TESTING
+}
+
+LockProfiler::~LockProfiler()
+{
+#ifndef UNIT_TESTING
+    TraceLoggingUnregister(g_hConsoleLockTraceProvider);
+#endif UNIT_TESTING
+}
+
+LockProfiler& LockProfiler::Instance()
+{
+    static LockProfiler s_Instance;
+    return s_Instance;
+}
+
+// Routine Description:
+// - Reads the performance counter, to time the locks with.
+// Arguments:
+// - <none>
+// Return Value:
+// - The current performance counter.
+LONGLONG LockProfiler::s_Now() noexcept
+{
+    LARGE_INTEGER liNow;
+    QueryPerformanceCounter(&liNow);
+    return liNow.QuadPart;
+}
+
+// Routine Description:
+// - Checks whether the locks should be measured, because a trace session is listening
+//   or somebody asked for the counters.
+// Arguments:
+// - <none>
+// Return Value:
+// - true if the locks should be measured.
+bool LockProfiler::IsEnabled() const noexcept
+{
+    // A session that only wants the long holds needs the locks measured too.
+    return _enabledCount.load(std::memory_order_relaxed) != 0 ||
+           TraceLoggingProviderEnabled(g_hConsoleLockTraceProvider, WINEVENT_LEVEL_WARNING, 0);
+}
+
+// Routine Description:
+// - Asks for the locks to be measured, or takes back an earlier ask, e.g. while a
+//   performance overlay is shown. They're measured as long as anybody is still asking.
+// Arguments:
+// - enabled - true to ask, false to take back an ask made before.
+// Return Value:
+// - <none>
+void LockProfiler::SetEnabled(const bool enabled) noexcept
+{
+    if (enabled)
+    {
+        _enabledCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        _enabledCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+// Routine Description:
+// - Changes how long a lock has to be held for the hold to count as a long one.
+// Arguments:
+// - microseconds - The shortest hold that's long.
+// Return Value:
+// - <none>
+void LockProfiler::SetLongHoldThreshold(const uint64_t microseconds) noexcept
+{
+    _longHoldMicroseconds.store(microseconds, std::memory_order_relaxed);
+}
+
+// Routine Description:
+// - Records that a lock was taken.
+// - Called by the thread that took it, while it holds it.
+// Arguments:
+// - lock - The lock that was taken.
+// - callSite - Where it was taken from.
+// - waitTicks - How long it was waited for, in performance counter ticks.
+// - contended - Whether somebody else had it, so that it had to be waited for.
+// Return Value:
+// - <none>
+void LockProfiler::RecordAcquire(const Lock lock, const void* const callSite, const LONGLONG waitTicks, const bool contended) noexcept
+{
+    if (lock >= Lock::Count)
+    {
+        return;
+    }
+
+    auto& entry = _locks.at(static_cast<size_t>(lock));
+    auto& site = _FindCallSite(entry, callSite);
+
+    entry.acquisitions.fetch_add(1, std::memory_order_relaxed);
+    site.acquisitions.fetch_add(1, std::memory_order_relaxed);
+    if (contended)
+    {
+        entry.contended.fetch_add(1, std::memory_order_relaxed);
+        site.contended.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    entry.waitTicks.fetch_add(waitTicks > 0 ? waitTicks : 0, std::memory_order_relaxed);
+    site.wait.Add(_ToMicroseconds(waitTicks));
+}
+
+// Routine Description:
+// - Records that a lock was let go of, and writes an event if it was held for long.
+// - Called by the thread that held it, before it lets go.
+// Arguments:
+// - lock - The lock that was held.
+// - callSite - Where it was taken from.
+// - holdTicks - How long it was held, in performance counter ticks.
+// Return Value:
+// - <none>
+void LockProfiler::RecordRelease(const Lock lock, const void* const callSite, const LONGLONG holdTicks) noexcept
+{
+    if (lock >= Lock::Count)
+    {
+        return;
+    }
+
+    auto& entry = _locks.at(static_cast<size_t>(lock));
+    const auto holdMicroseconds = _ToMicroseconds(holdTicks);
+
+    entry.holdTicks.fetch_add(holdTicks > 0 ? holdTicks : 0, std::memory_order_relaxed);
+    _FindCallSite(entry, callSite).hold.Add(holdMicroseconds);
+
+    if (holdMicroseconds >= _longHoldMicroseconds.load(std::memory_order_relaxed))
+    {
+        entry.longHolds.fetch_add(1, std::memory_order_relaxed);
+        _TraceLongHold(lock, callSite, holdMicroseconds);
+    }
+}
+
+// Routine Description:
+// - Adds up what a lock has done while it was measured.
+// Arguments:
+// - lock - The lock.
+// Return Value:
+// - The totals over every place it was taken from. The counts only ever go up, so the
+//   caller works out rates from the difference between two calls.
+LockProfiler::Totals LockProfiler::GetTotals(const Lock lock) const noexcept
+{
+    Totals totals;
+    if (lock < Lock::Count)
+    {
+        const auto& entry = _locks.at(static_cast<size_t>(lock));
+        totals.acquisitions = entry.acquisitions.load(std::memory_order_relaxed);
+        totals.contended = entry.contended.load(std::memory_order_relaxed);
+        totals.longHolds = entry.longHolds.load(std::memory_order_relaxed);
+        totals.waitMilliseconds = _ToMicroseconds(entry.waitTicks.load(std::memory_order_relaxed)) / 1000.0;
+        totals.holdMilliseconds = _ToMicroseconds(entry.holdTicks.load(std::memory_order_relaxed)) / 1000.0;
+    }
+    return totals;
+}
+
+// Routine Description:
+// - Writes the statistics of every place each lock has been taken from to the trace.
+// Arguments:
+// - <none>
+// Return Value:
+// - <none>
+void LockProfiler::Trace() const noexcept
+{
+    const auto bucketCount = gsl::narrow_cast<UINT16>(Histogram::BucketCount);
+
+    for (size_t lock = 0; lock < LockCount; ++lock)
+    {
+        for (const auto& site : _locks.at(lock).callSites)
+        {
+            const auto acquisitions = site.acquisitions.load(std::memory_order_relaxed);
+            if (acquisitions == 0)
+            {
+                continue;
+            }
+
+            const auto wait = site.wait.GetBuckets();
+            const auto hold = site.hold.GetBuckets();
+
+            TraceLoggingWrite(g_hConsoleLockTraceProvider,
+                              "LockStatistics",
+                              TraceLoggingString(LockNames[lock], "Lock"),
+                              TraceLoggingPointer(site.address.load(std::memory_order_relaxed), "CallSite"),
+                              TraceLoggingUInt64(acquisitions, "Acquisitions"),
+                              TraceLoggingUInt64(site.contended.load(std::memory_order_relaxed), "Contended"),
+                              TraceLoggingUInt64Array(wait.data(), bucketCount, "WaitUsLog2Buckets"),
+                              TraceLoggingUInt64Array(hold.data(), bucketCount, "HoldUsLog2Buckets"),
+                              TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE));
+        }
+    }
+}
+
+// Routine Description:
+// - Called by ETW when a trace session changes what it wants from the provider.
+//   Asking for the provider's state writes out the statistics of every lock.
+void NTAPI LockProfiler::s_ProviderCallback(LPCGUID /*sourceId*/,
+                                            ULONG isEnabled,
+                                            UCHAR /*level*/,
+                                            ULONGLONG /*matchAnyKeyword*/,
+                                            ULONGLONG /*matchAllKeyword*/,
+                                            PEVENT_FILTER_DESCRIPTOR /*filterData*/,
+                                            PVOID callbackContext)
+{
+    if (isEnabled == EVENT_CONTROL_CODE_CAPTURE_STATE && callbackContext)
+    {
+        static_cast<const LockProfiler*>(callbackContext)->Trace();
+    }
+}
+
+// Routine Description:
+// - Finds the statistics of a place a lock is taken from, and makes room for them if it's new.
+// Arguments:
+// - entry - The lock's statistics.
+// - address - Where the lock was taken from.
+// Return Value:
+// - The place's statistics. Once every entry has been handed out, the last one is shared by the rest.
+LockProfiler::CallSite& LockProfiler::_FindCallSite(LockEntry& entry, const void* const address) noexcept
+{
+    auto& sites = entry.callSites;
+    if (address == nullptr)
+    {
+        return sites.back();
+    }
+
+    // The low bits of a return address don't say much, so they're dropped from the hash.
+    constexpr size_t HashedSites = MaxCallSites - 1;
+    const auto hash = reinterpret_cast<uintptr_t>(address) >> 4;
+    for (size_t probe = 0; probe < HashedSites; ++probe)
+    {
+        auto& site = sites.at((hash + probe) % HashedSites);
+        const void* current = site.address.load(std::memory_order_acquire);
+        if (current == nullptr && site.address.compare_exchange_strong(current, address, std::memory_order_acq_rel))
+        {
+            return site;
+        }
+        if (current == address)
+        {
+            return site;
+        }
+    }
+
+    return sites.back();
+}
+
+// Routine Description:
+// - Writes an event for a hold that was long, with the stack of the thread that held the lock.
+// - That's the thread letting go of it, whose stack usually still has the frame that took it.
+// Arguments:
+// - lock - The lock that was held.
+// - callSite - Where it was taken from.
+// - holdMicroseconds - How long it was held.
+// Return Value:
+// - <none>
+void LockProfiler::_TraceLongHold(const Lock lock, const void* const callSite, const uint64_t holdMicroseconds) const noexcept
+{
+    if (!TraceLoggingProviderEnabled(g_hConsoleLockTraceProvider, WINEVENT_LEVEL_WARNING, 0))
+    {
+        return;
+    }
+
+    // Skip this frame and RecordRelease, which are the same for every hold.
+    std::array<PVOID, LongHoldStackDepth> frames;
+    const auto frameCount = RtlCaptureStackBackTrace(2, gsl::narrow_cast<DWORD>(frames.size()), frames.data(), nullptr);
+
+    TraceLoggingWrite(g_hConsoleLockTraceProvider,
+                      "LongLockHold",
+                      TraceLoggingString(LockNames[static_cast<size_t>(lock)], "Lock"),
+                      TraceLoggingPointer(callSite, "CallSite"),
+                      TraceLoggingUInt64(holdMicroseconds, "HoldUs"),
+                      TraceLoggingPointerArray(frames.data(), frameCount, "Stack"),
+                      TraceLoggingLevel(WINEVENT_LEVEL_WARNING));
+}
+
+uint64_t LockProfiler::_ToMicroseconds(const LONGLONG ticks) const noexcept
+{
+    return _llPerformanceFrequency > 0 && ticks > 0 ? static_cast<uint64_t>((ticks * 1000000) / _llPerformanceFrequency) : 0;
+}
+
+ProfiledSharedMutex::ProfiledSharedMutex(const LockProfiler::Lock lock) noexcept :
+    _mutex{},
+    _lock{ lock },
+    _callSite{ nullptr },
+    _acquired{ 0 }
+{
+}
+
+// Routine Description:
+// - Takes the lock exclusively, counted as taken from the caller.
+void ProfiledSharedMutex::lock()
+{
+    lock(_ReturnAddress());
+}
+
+// Routine Description:
+// - Takes the lock exclusively.
+// Arguments:
+// - callSite - Where to count the lock as taken from.
+void ProfiledSharedMutex::lock(const void* const callSite)
+{
+    auto& profiler = LockProfiler::Instance();
+    if (!profiler.IsEnabled())
+    {
+        _mutex.lock();
+        return;
+    }
+
+    // Only time the wait when there is one, so that taking a free lock stays cheap.
+    LONGLONG waitTicks = 0;
+    const bool contended = !_mutex.try_lock();
+    if (contended)
+    {
+        const auto start = LockProfiler::s_Now();
+        _mutex.lock();
+        waitTicks = LockProfiler::s_Now() - start;
+    }
+
+    _callSite = callSite;
+    _acquired = LockProfiler::s_Now();
+    profiler.RecordAcquire(_lock, _callSite, waitTicks, contended);
+}
+
+// Routine Description:
+// - Takes the lock exclusively if nobody has it, counted as taken from the caller.
+// Return Value:
+// - true if the lock was taken.
+bool ProfiledSharedMutex::try_lock()
+{
+    if (!_mutex.try_lock())
+    {
+        return false;
+    }
+
+    auto& profiler = LockProfiler::Instance();
+    if (profiler.IsEnabled())
+    {
+        _callSite = _ReturnAddress();
+        _acquired = LockProfiler::s_Now();
+        profiler.RecordAcquire(_lock, _callSite, 0, false);
+    }
+    return true;
+}
+
+// Routine Description:
+// - Lets go of the lock held exclusively.
+void ProfiledSharedMutex::unlock()
+{
+    if (_acquired != 0)
+    {
+        const auto holdTicks = LockProfiler::s_Now() - _acquired;
+        _acquired = 0;
+        LockProfiler::Instance().RecordRelease(_lock, _callSite, holdTicks);
+    }
+    _mutex.unlock();
+}
+
+// Routine Description:
+// - Takes the lock shared, counted as taken from the caller.
+void ProfiledSharedMutex::lock_shared()
+{
+    lock_shared(_ReturnAddress());
+}
+
+// Routine Description:
+// - Takes the lock shared.
+// Arguments:
+// - callSite - Where to count the lock as taken from.
+void ProfiledSharedMutex::lock_shared(const void* const callSite)
+{
+    auto& profiler = LockProfiler::Instance();
+    if (s_sharedHold.mutex != nullptr || !profiler.IsEnabled())
+    {
+        _mutex.lock_shared();
+        return;
+    }
+
+    LONGLONG waitTicks = 0;
+    const bool contended = !_mutex.try_lock_shared();
+    if (contended)
+    {
+        const auto start = LockProfiler::s_Now();
+        _mutex.lock_shared();
+        waitTicks = LockProfiler::s_Now() - start;
+    }
+
+    s_sharedHold = { this, callSite, LockProfiler::s_Now() };
+    profiler.RecordAcquire(_lock, callSite, waitTicks, contended);
+}
+
+// Routine Description:
+// - Takes the lock shared if nobody has it exclusively, counted as taken from the caller.
+// Return Value:
+// - true if the lock was taken.
+bool ProfiledSharedMutex::try_lock_shared()
+{
+    if (!_mutex.try_lock_shared())
+    {
+        return false;
+    }
+
+    auto& profiler = LockProfiler::Instance();
+    if (s_sharedHold.mutex == nullptr && profiler.IsEnabled())
+    {
+        s_sharedHold = { this, _ReturnAddress(), LockProfiler::s_Now() };
+        profiler.RecordAcquire(_lock, s_sharedHold.callSite, 0, false);
+    }
+    return true;
+}
+
+// Routine Description:
+// - Lets go of the lock held shared.
+void ProfiledSharedMutex::unlock_shared()
+{
+    if (s_sharedHold.mutex == this)
+    {
+        const auto hold = std::exchange(s_sharedHold, SharedHold{});
+        LockProfiler::Instance().RecordRelease(_lock, hold.callSite, LockProfiler::s_Now() - hold.acquired);
+    }
+    _mutex.unlock_shared();
+}
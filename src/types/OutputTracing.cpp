@@ -0,0 +1,242 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "inc/OutputTracing.hpp"
+
+TRACELOGGING_DEFINE_PROVIDER(g_hConsoleOutputTraceProvider,
+                             "Microsoft.Windows.Console.Output",
+                             // tl:{34e59741-add0-5485-bec0-c614425407c6}
+                             (0x34e59741, 0xadd0, 0x5485, 0xbe, 0xc0, 0xc6, 0x14, 0x42, 0x54, 0x07, 0xc6),
+                             TraceLoggingOptionMicrosoftTelemetry());
+
+using namespace Microsoft::Console::Types;
+
+// The write activity that the parser's events on this thread belong to, if any.
+static thread_local const GUID* s_currentWrite = nullptr;
+
+OutputTracing::OutputTracing() :
+    _llPerformanceFrequency(0),
+    _writes{},
+    _writeSequence(0)
+{
+    LARGE_INTEGER liFrequency;
+    QueryPerformanceFrequency(&liFrequency);
+    _llPerformanceFrequency = liFrequency.QuadPart;
+
+#ifndef UNIT_TESTING
+    TraceLoggingRegister(g_hConsoleOutputTraceProvider);
+#endif UNIT_TESTING
+}
+
+OutputTracing::~OutputTracing()
+{
+#ifndef UNIT_TESTING
+    TraceLoggingUnregister(g_hConsoleOutputTraceProvider);
+#endif UNIT_TESTING
+}
+
+OutputTracing& OutputTracing::Instance()
+{
+    static OutputTracing s_Instance;
+    return s_Instance;
+}
+
+// Routine Description:
+// - Checks whether a trace session wants the output's events.
+// Arguments:
+// - <none>
+// Return Value:
+// - true if the events should be measured and written.
+bool OutputTracing::IsEnabled() const noexcept
+{
+    return TraceLoggingProviderEnabled(g_hConsoleOutputTraceProvider, WINEVENT_LEVEL_VERBOSE, 0);
+}
+
+// Routine Description:
+// - Starts the activity of a write, and makes it the one the parser's events on this thread belong to.
+// Arguments:
+// - cch - The number of characters written.
+OutputTracing::WriteActivity::WriteActivity(const size_t cch) noexcept :
+    _active(false),
+    _id{},
+    _previous(s_currentWrite),
+    _start(0),
+    _cch(cch)
+{
+    auto& tracing = OutputTracing::Instance();
+    if (tracing.IsEnabled() && EventActivityIdControl(EVENT_ACTIVITY_CTRL_CREATE_ID, &_id) == ERROR_SUCCESS)
+    {
+        _active = true;
+        _start = _Now();
+        s_currentWrite = &_id;
+        tracing._AddWrite(_id, _start);
+
+        TraceLoggingWriteActivity(g_hConsoleOutputTraceProvider,
+                                  "OutputWrite",
+                                  &_id,
+                                  nullptr,
+                                  TraceLoggingUInt64(_cch, "Chars"),
+                                  TraceLoggingOpcode(WINEVENT_OPCODE_START),
+                                  TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE));
+    }
+}
+
+// Routine Description:
+// - Ends the activity of a write, once it's all been consumed.
+OutputTracing::WriteActivity::~WriteActivity()
+{
+    if (_active)
+    {
+        const auto& tracing = OutputTracing::Instance();
+        TraceLoggingWriteActivity(g_hConsoleOutputTraceProvider,
+                                  "OutputWrite",
+                                  &_id,
+                                  nullptr,
+                                  TraceLoggingUInt64(_cch, "Chars"),
+                                  TraceLoggingUInt64(tracing._ToMicroseconds(_Now() - _start), "DurationUs"),
+                                  TraceLoggingOpcode(WINEVENT_OPCODE_STOP),
+                                  TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE));
+
+        s_currentWrite = _previous;
+    }
+}
+
+// Routine Description:
+// - Starts timing a call into the parser.
+// Arguments:
+// - cch - The number of characters to parse.
+OutputTracing::ParseScope::ParseScope(const size_t cch) noexcept :
+    _active(OutputTracing::Instance().IsEnabled()),
+    _start(_active ? _Now() : 0),
+    _cch(cch)
+{
+}
+
+// Routine Description:
+// - Writes how long the parser took, as part of the write it was parsing.
+OutputTracing::ParseScope::~ParseScope()
+{
+    if (_active)
+    {
+        const auto& tracing = OutputTracing::Instance();
+        TraceLoggingWriteActivity(g_hConsoleOutputTraceProvider,
+                                  "OutputParsed",
+                                  s_currentWrite,
+                                  nullptr,
+                                  TraceLoggingUInt64(_cch, "Chars"),
+                                  TraceLoggingUInt64(tracing._ToMicroseconds(_Now() - _start), "DurationUs"),
+                                  TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE));
+    }
+}
+
+// Routine Description:
+// - Starts the activity of a frame, and relates it to the oldest write it's the first to show.
+// Arguments:
+// - writesSeen - The writes that were shown by the engine's last frame. Updated to the
+//   writes this frame shows.
+// Return Value:
+// - The frame, to pass to the other frame events. It's inactive if no one is tracing.
+OutputTracing::Frame OutputTracing::BeginFrame(uint64_t& writesSeen) noexcept
+{
+    Frame frame;
+    if (!IsEnabled() || EventActivityIdControl(EVENT_ACTIVITY_CTRL_CREATE_ID, &frame.id) != ERROR_SUCCESS)
+    {
+        return frame;
+    }
+
+    frame.active = true;
+    frame.start = _Now();
+
+    uint64_t newWrites = 0;
+    LONGLONG oldestWrite = frame.start;
+    {
+        std::lock_guard<std::mutex> guard{ _writesLock };
+        newWrites = _writeSequence - writesSeen;
+
+        // If more writes came in than we remember, the oldest we still know of will do.
+        const auto first = std::max(writesSeen + 1, _writeSequence >= PendingWriteCount ? _writeSequence - PendingWriteCount + 1 : 1);
+        if (newWrites != 0)
+        {
+            const auto& write = _writes.at(first % PendingWriteCount);
+            frame.relatedWrite = write.id;
+            oldestWrite = write.start;
+        }
+        writesSeen = _writeSequence;
+    }
+
+    TraceLoggingWriteActivity(g_hConsoleOutputTraceProvider,
+                              "Frame",
+                              &frame.id,
+                              newWrites != 0 ? &frame.relatedWrite : nullptr,
+                              TraceLoggingUInt64(newWrites, "Writes"),
+                              TraceLoggingUInt64(_ToMicroseconds(frame.start - oldestWrite), "OldestWriteAgeUs"),
+                              TraceLoggingOpcode(WINEVENT_OPCODE_START),
+                              TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE));
+    return frame;
+}
+
+// Routine Description:
+// - Writes that a frame has been painted, and is about to be presented.
+// Arguments:
+// - frame - The frame from BeginFrame.
+// - dirtyCells - The number of cells that were repainted.
+// Return Value:
+// - <none>
+void OutputTracing::TraceFramePainted(const Frame& frame, const size_t dirtyCells) const noexcept
+{
+    if (frame.active)
+    {
+        TraceLoggingWriteActivity(g_hConsoleOutputTraceProvider,
+                                  "FramePainted",
+                                  &frame.id,
+                                  nullptr,
+                                  TraceLoggingUInt64(dirtyCells, "DirtyCells"),
+                                  TraceLoggingUInt64(_ToMicroseconds(_Now() - frame.start), "DurationUs"),
+                                  TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE));
+    }
+}
+
+// Routine Description:
+// - Ends the activity of a frame, once it's been presented.
+// Arguments:
+// - frame - The frame from BeginFrame.
+// - hrPresent - What the engine's Present returned.
+// Return Value:
+// - <none>
+void OutputTracing::EndFrame(const Frame& frame, const HRESULT hrPresent) const noexcept
+{
+    if (frame.active)
+    {
+        TraceLoggingWriteActivity(g_hConsoleOutputTraceProvider,
+                                  "Frame",
+                                  &frame.id,
+                                  nullptr,
+                                  TraceLoggingHResult(hrPresent, "PresentResult"),
+                                  TraceLoggingUInt64(_ToMicroseconds(_Now() - frame.start), "DurationUs"),
+                                  TraceLoggingOpcode(WINEVENT_OPCODE_STOP),
+                                  TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE));
+    }
+}
+
+void OutputTracing::_AddWrite(const GUID& id, const LONGLONG start) noexcept
+{
+    std::lock_guard<std::mutex> guard{ _writesLock };
+    ++_writeSequence;
+    auto& write = _writes.at(_writeSequence % PendingWriteCount);
+    write.id = id;
+    write.start = start;
+}
+
+uint64_t OutputTracing::_ToMicroseconds(const LONGLONG ticks) const noexcept
+{
+    return _llPerformanceFrequency > 0 && ticks > 0 ? static_cast<uint64_t>((ticks * 1000000) / _llPerformanceFrequency) : 0;
+}
+
+LONGLONG OutputTracing::_Now() noexcept
+{
+    LARGE_INTEGER liNow;
+    QueryPerformanceCounter(&liNow);
+    return liNow.QuadPart;
+}
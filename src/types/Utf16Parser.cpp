@@ -4,8 +4,12 @@
 #include "precomp.h"
 
 #include "inc/Utf16Parser.hpp"
+#include "inc/AllocationTracking.hpp"
 #include "unicode.hpp"
 
+using Microsoft::Console::Types::AllocationScope;
+using Microsoft::Console::Types::AllocationTag;
+
 // Routine Description:
 // - Finds the next single collection for the codepoint out of the given UTF-16 string information.
 // - In simpler terms, it will group UTF-16 surrogate pairs into a single unit or give you a valid single-item UTF-16 character.
@@ -57,6 +61,7 @@ std::wstring_view Utf16Parser::ParseNext(std::wstring_view wstr)
 // - formats a utf16 encoded wstring and splits the codepoints into individual collections.
 // - will drop badly formatted leading/trailing char sequences.
 // - does not validate utf16 input beyond proper leading/trailing char sequences.
+// - callers that only need to look at each glyph should walk Glyphs instead, which doesn't allocate.
 // Arguments:
 // - wstr - the string to parse
 // Return Value:
@@ -64,28 +69,68 @@ std::wstring_view Utf16Parser::ParseNext(std::wstring_view wstr)
 // together in a vector and codepoints that use only one wchar will be in a vector by themselves.
 std::vector<std::vector<wchar_t>> Utf16Parser::Parse(std::wstring_view wstr)
 {
+    const AllocationScope allocationScope{ AllocationTag::Parser };
+
     std::vector<std::vector<wchar_t>> result;
-    std::vector<wchar_t> sequence;
-    for (const auto wch : wstr)
+    for (const auto glyph : Glyphs(wstr))
+    {
+        result.emplace_back(glyph.cbegin(), glyph.cend());
+    }
+    return result;
+}
+
+// Routine Description:
+// - creates an iterator positioned on the first well formed glyph of the string.
+// Arguments:
+// - wstr - the string to walk. It must outlive the iterator.
+Utf16Parser::GlyphIterator::GlyphIterator(const std::wstring_view wstr) noexcept :
+    _remaining{ wstr }
+{
+    operator++();
+}
+
+// Routine Description:
+// - moves to the next well formed glyph, skipping any leading surrogate that isn't directly followed
+//   by a trailing one and any trailing surrogate on its own. Past the last glyph, this is the end.
+// Return Value:
+// - reference to self after advancement.
+Utf16Parser::GlyphIterator& Utf16Parser::GlyphIterator::operator++() noexcept
+{
+    while (!_remaining.empty())
     {
+        const auto wch = _remaining.front();
+        size_t length = 1;
         if (IsLeadingSurrogate(wch))
         {
-            sequence.clear();
-            sequence.push_back(wch);
-        }
-        else if (IsTrailingSurrogate(wch))
-        {
-            if (!sequence.empty())
+            if (_remaining.size() < 2 || !IsTrailingSurrogate(_remaining[1]))
             {
-                sequence.push_back(wch);
-                result.push_back(sequence);
-                sequence.clear();
+                _remaining.remove_prefix(1);
+                continue;
             }
+            length = 2;
         }
-        else
+        else if (IsTrailingSurrogate(wch))
         {
-            result.push_back({ wch });
+            _remaining.remove_prefix(1);
+            continue;
         }
+
+        _glyph = _remaining.substr(0, length);
+        _remaining.remove_prefix(length);
+        return *this;
     }
-    return result;
+
+    _glyph = {};
+    return *this;
+}
+
+// Routine Description:
+// - moves to the next well formed glyph.
+// Return Value:
+// - a copy of the iterator from before advancement.
+Utf16Parser::GlyphIterator Utf16Parser::GlyphIterator::operator++(int) noexcept
+{
+    auto temp{ *this };
+    operator++();
+    return temp;
 }
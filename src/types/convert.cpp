@@ -6,6 +6,10 @@
 
 #include "../inc/unicode.hpp"
 
+#if (defined(_M_IX86) || defined(_M_AMD64))
+#include <emmintrin.h>
+#endif
+
 #ifdef BUILD_ONECORE_INTERACTIVITY
 #include "../../interactivity/inc/VtApiRedirection.hpp"
 #endif
@@ -17,9 +21,62 @@
 static const WORD altScanCode = 0x38;
 static const WORD leftShiftScanCode = 0x2A;
 
+// Routine Description:
+// - Determines whether a codepage maps every 7-bit byte to the UTF-16 code unit of the same value.
+//   Text in these codepages that's entirely 7-bit can be converted by widening or narrowing each unit.
+// - This only lists the codepages legacy clients commonly use, since they're the ones worth the shortcut.
+// Arguments:
+// - codepage - Windows Code Page to check
+// Return Value:
+// - true if 7-bit text converts one to one in this codepage
+static bool _IsAsciiCompatible(const UINT codepage) noexcept
+{
+    return codepage == CP_USA || codepage == 1252 || codepage == CP_UTF8;
+}
+
+// Routine Description:
+// - Determines whether every unit of a string is 7-bit.
+// - On x86/x64, sixteen bytes are checked at a time.
+// Arguments:
+// - pch - The units to check.
+// - cch - The number of units.
+// Return Value:
+// - true if there's no unit above 0x7F.
+template<typename T>
+static bool _IsAscii(const T* const pch, const size_t cch) noexcept
+{
+    size_t i = 0;
+
+#if (defined(_M_IX86) || defined(_M_AMD64))
+    // The top bit of any byte in the block is the top bit of an 8-bit unit, or part of a 16-bit unit above 0x7F.
+    // Those are the bits 0x8080 and 0xFF80 of each 16-bit lane, written as the signed values they are.
+    constexpr int16_t nonAsciiByteBits = -0x7F80; // 0x8080
+    constexpr int16_t nonAsciiUnitBits = -0x80; // 0xFF80
+    const auto nonAsciiBits = _mm_set1_epi16(sizeof(T) == 1 ? nonAsciiByteBits : nonAsciiUnitBits);
+    constexpr size_t unitsPerBlock = sizeof(__m128i) / sizeof(T);
+    for (; i + unitsPerBlock <= cch; i += unitsPerBlock)
+    {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pch + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(block, nonAsciiBits), _mm_setzero_si128())) != 0xFFFF)
+        {
+            return false;
+        }
+    }
+#endif
+
+    for (; i < cch; ++i)
+    {
+        if (static_cast<std::make_unsigned_t<T>>(pch[i]) > 0x7F)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 // Routine Description:
 // - Takes a multibyte string, allocates the appropriate amount of memory for the conversion, performs the conversion,
-//   and returns the Unicode UTF-16 result in the smart pointer (and the length).
+//   and returns the Unicode UTF-16 result.
 // Arguments:
 // - codepage - Windows Code Page representing the multibyte source text
 // - source - View of multibyte characters of source text
@@ -34,6 +91,26 @@ static const WORD leftShiftScanCode = 0x2A;
         return {};
     }
 
+    // UTF-8 never needs more UTF-16 units than it has bytes, so it can be converted in one pass.
+    if (codePage == CP_UTF8)
+    {
+        std::wstring out(source.size(), UNICODE_NULL);
+        size_t written;
+        THROW_IF_FAILED(ConvertUtf8ToW(source, { out.data(), gsl::narrow_cast<ptrdiff_t>(out.size()) }, false, written));
+        out.resize(written);
+        return out;
+    }
+
+    // 7-bit text in the common codepages is the same text in UTF-16.
+    if (_IsAsciiCompatible(codePage) && _IsAscii(source.data(), source.size()))
+    {
+        std::wstring out(source.size(), UNICODE_NULL);
+        std::transform(source.cbegin(), source.cend(), out.begin(), [](const char ch) noexcept {
+            return static_cast<wchar_t>(ch);
+        });
+        return out;
+    }
+
     int iSource; // convert to int because Mb2Wc requires it.
     THROW_IF_FAILED(SizeTToInt(source.size(), &iSource));
 
@@ -44,15 +121,73 @@ static const WORD leftShiftScanCode = 0x2A;
     size_t cchNeeded;
     THROW_IF_FAILED(IntToSizeT(iTarget, &cchNeeded));
 
-    // Allocate ourselves space in a smart pointer.
-    std::unique_ptr<wchar_t[]> pwsOut = std::make_unique<wchar_t[]>(cchNeeded);
-    THROW_IF_NULL_ALLOC(pwsOut);
+    // Allocate the string we return and convert straight into it.
+    std::wstring out(cchNeeded, UNICODE_NULL);
 
     // Attempt conversion for real.
-    THROW_LAST_ERROR_IF(0 == MultiByteToWideChar(codePage, 0, source.data(), iSource, pwsOut.get(), iTarget));
+    THROW_LAST_ERROR_IF(0 == MultiByteToWideChar(codePage, 0, source.data(), iSource, out.data(), iTarget));
+
+    return out;
+}
+
+// Routine Description:
+// - Converts UTF-8 text straight into a buffer the caller owns, without measuring it first.
+//   UTF-8 never needs more UTF-16 units than it has bytes, so one unit per byte is always enough room.
+// - Leading 7-bit text is widened here, sixteen bytes at a time on x86/x64.
+//   Whatever follows goes to MultiByteToWideChar in a single call.
+// Arguments:
+// - source - The UTF-8 text. Sequences cut off at the end are the caller's to hold back.
+// - target - Where to write the UTF-16 text. It must have room for at least source.size() units.
+// - rejectInvalid - Fail with ERROR_NO_UNICODE_TRANSLATION on an invalid sequence instead of writing U+FFFD for it.
+// - written - The number of units written to target.
+// Return Value:
+// - S_OK, E_NOT_SUFFICIENT_BUFFER if target is too small, or the failure from MultiByteToWideChar.
+[[nodiscard]] HRESULT ConvertUtf8ToW(const std::string_view source,
+                                     const gsl::span<wchar_t> target,
+                                     const bool rejectInvalid,
+                                     _Out_ size_t& written) noexcept
+{
+    written = 0;
+    RETURN_HR_IF(E_NOT_SUFFICIENT_BUFFER, static_cast<size_t>(target.size()) < source.size());
+
+    const auto pch = source.data();
+    const auto pwch = target.data();
+    size_t i = 0;
+
+#if (defined(_M_IX86) || defined(_M_AMD64))
+    const auto zero = _mm_setzero_si128();
+    for (; i + sizeof(__m128i) <= source.size(); i += sizeof(__m128i))
+    {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pch + i));
+        if (_mm_movemask_epi8(block) != 0)
+        {
+            break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pwch + i), _mm_unpacklo_epi8(block, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pwch + i + sizeof(__m128i) / 2), _mm_unpackhi_epi8(block, zero));
+    }
+#endif
+
+    for (; i < source.size() && static_cast<unsigned char>(pch[i]) <= 0x7F; ++i)
+    {
+        pwch[i] = static_cast<wchar_t>(pch[i]);
+    }
+
+    size_t converted = 0;
+    if (i < source.size())
+    {
+        int iSource; // convert to int because Mb2Wc requires it.
+        RETURN_IF_FAILED(SizeTToInt(source.size() - i, &iSource));
+        int iTarget;
+        RETURN_IF_FAILED(SizeTToInt(static_cast<size_t>(target.size()) - i, &iTarget));
+
+        const int result = MultiByteToWideChar(CP_UTF8, rejectInvalid ? MB_ERR_INVALID_CHARS : 0, pch + i, iSource, pwch + i, iTarget);
+        RETURN_LAST_ERROR_IF(0 == result);
+        converted = static_cast<size_t>(result);
+    }
 
-    // Return as a string
-    return std::wstring(pwsOut.get(), cchNeeded);
+    written = i + converted;
+    return S_OK;
 }
 
 // Routine Description:
@@ -72,6 +207,16 @@ static const WORD leftShiftScanCode = 0x2A;
         return {};
     }
 
+    // 7-bit text is encoded the same way in the common codepages.
+    if (_IsAsciiCompatible(codepage) && _IsAscii(source.data(), source.size()))
+    {
+        std::string out(source.size(), '\0');
+        std::transform(source.cbegin(), source.cend(), out.begin(), [](const wchar_t wch) noexcept {
+            return static_cast<char>(wch);
+        });
+        return out;
+    }
+
     int iSource; // convert to int because Wc2Mb requires it.
     THROW_IF_FAILED(SizeTToInt(source.size(), &iSource));
 
@@ -85,18 +230,16 @@ static const WORD leftShiftScanCode = 0x2A;
     size_t cchNeeded;
     THROW_IF_FAILED(IntToSizeT(iTarget, &cchNeeded));
 
-    // Allocate ourselves space in a smart pointer
-    std::unique_ptr<char[]> psOut = std::make_unique<char[]>(cchNeeded);
-    THROW_IF_NULL_ALLOC(psOut.get());
+    // Allocate the string we return and convert straight into it.
+    std::string out(cchNeeded, '\0');
 
     // Attempt conversion for real.
     // clang-format off
 #pragma prefast(suppress: __WARNING_W2A_BEST_FIT, "WC_NO_BEST_FIT_CHARS doesn't work in many codepages. Retain old behavior.")
     // clang-format on
-    THROW_LAST_ERROR_IF(0 == WideCharToMultiByte(codepage, 0, source.data(), iSource, psOut.get(), iTarget, nullptr, nullptr));
+    THROW_LAST_ERROR_IF(0 == WideCharToMultiByte(codepage, 0, source.data(), iSource, out.data(), iTarget, nullptr, nullptr));
 
-    // Return as a string
-    return std::string(psOut.get(), cchNeeded);
+    return out;
 }
 
 // Routine Description:
@@ -115,6 +258,12 @@ static const WORD leftShiftScanCode = 0x2A;
         return 0;
     }
 
+    // 7-bit text takes one byte per character in the common codepages.
+    if (_IsAsciiCompatible(codepage) && _IsAscii(source.data(), source.size()))
+    {
+        return source.size();
+    }
+
     int iSource; // convert to int because Wc2Mb requires it
     THROW_IF_FAILED(SizeTToInt(source.size(), &iSource));
 
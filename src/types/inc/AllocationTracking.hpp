@@ -0,0 +1,74 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- AllocationTracking.hpp
+
+Abstract:
+- Counts the heap allocations made by each subsystem, to find out which hot paths
+  allocate and how much.
+- It only counts in builds made with CON_TRACK_ALLOCATIONS (msbuild /p:TrackAllocations=true).
+  Those replace the global operator new, and charge every allocation to the subsystem
+  named by the innermost AllocationScope on the allocating thread. In every other build,
+  AllocationScope compiles to nothing and the counts stay at zero.
+--*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace Microsoft::Console::Types
+{
+    // The subsystems allocations are charged to. Anything allocated outside of a scope is Untagged.
+    enum class AllocationTag : size_t
+    {
+        Untagged,
+        BufferOut,
+        Parser,
+        Renderer,
+        Server,
+        HostInput,
+        Count
+    };
+
+    struct AllocationCounts
+    {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    namespace AllocationTracking
+    {
+#ifdef CON_TRACK_ALLOCATIONS
+        constexpr bool IsEnabled = true;
+#else
+        constexpr bool IsEnabled = false;
+#endif
+
+        AllocationCounts GetCounts(const AllocationTag tag) noexcept;
+        const char* GetTagName(const AllocationTag tag) noexcept;
+    }
+
+    // Charges the allocations made on this thread to the given subsystem while it's in scope.
+    class AllocationScope final
+    {
+    public:
+#ifdef CON_TRACK_ALLOCATIONS
+        explicit AllocationScope(const AllocationTag tag) noexcept;
+        ~AllocationScope();
+#else
+        explicit constexpr AllocationScope(const AllocationTag /*tag*/) noexcept
+        {
+        }
+#endif
+
+        AllocationScope(const AllocationScope&) = delete;
+        AllocationScope& operator=(const AllocationScope&) = delete;
+
+#ifdef CON_TRACK_ALLOCATIONS
+    private:
+        AllocationTag _previousTag;
+#endif
+    };
+}
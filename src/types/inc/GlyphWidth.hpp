@@ -14,5 +14,6 @@ Abstract:
 
 bool IsGlyphFullWidth(const std::wstring_view glyph);
 bool IsGlyphFullWidth(const wchar_t wch);
+size_t GetNarrowGlyphRunLength(const std::wstring_view text) noexcept;
 void SetGlyphWidthFallback(std::function<bool(std::wstring_view)> pfnFallback);
 void NotifyGlyphWidthFontChanged();
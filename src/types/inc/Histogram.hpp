@@ -0,0 +1,34 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- Histogram.hpp
+
+Abstract:
+- Counts times into buckets with one bucket per power of two microseconds, for the
+  API statistics and the lock profiler to report how long things took.
+- Any number of threads can count into one at once, and it can be read from any
+  other thread at any time.
+--*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+namespace Microsoft::Console::Types
+{
+    class Histogram final
+    {
+    public:
+        // bucket N holds times of less than 2^N microseconds, the last bucket holds anything longer.
+        static constexpr size_t BucketCount = 24;
+
+        void Add(const uint64_t microseconds) noexcept;
+        std::array<uint64_t, BucketCount> GetBuckets() const noexcept;
+
+    private:
+        std::array<std::atomic<uint64_t>, BucketCount> _buckets{};
+    };
+}
@@ -0,0 +1,156 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- LockProfiler.hpp
+
+Abstract:
+- Measures the locks that everything else waits on: the console lock in conhost and
+  the read/write lock of a Terminal.
+- For each place a lock is taken from, it counts how often it was taken and had to be
+  waited for, and keeps histograms of how long it was waited for and held, with one
+  bucket per power of two microseconds. A place is told apart by the return address of
+  the call that took the lock, which a trace can resolve against the module's symbols.
+- Holds longer than a threshold are counted, and while a trace session is listening,
+  written as an event with the stack of the thread letting go of the lock.
+- Nothing is measured while no trace session has the provider enabled and nobody has
+  asked for the counters (see SetEnabled). A trace session asking for the provider's
+  state (its capture state or rundown option) gets the histograms of every place.
+--*/
+
+#pragma once
+
+#include <windows.h>
+#include <winmeta.h>
+#include <TraceLoggingProvider.h>
+#include <telemetry\ProjectTelemetry.h>
+
+#include "Histogram.hpp"
+
+#include <array>
+#include <atomic>
+#include <shared_mutex>
+
+TRACELOGGING_DECLARE_PROVIDER(g_hConsoleLockTraceProvider);
+
+namespace Microsoft::Console::Types
+{
+    class LockProfiler final
+    {
+    public:
+        enum class Lock : size_t
+        {
+            Console,
+            Terminal,
+            Count
+        };
+
+        // The places each lock is told apart for. Any more than that are counted together.
+        static constexpr size_t MaxCallSites = 64;
+
+        // The frames of the stack written with a long hold.
+        static constexpr size_t LongHoldStackDepth = 32;
+
+        // Holds longer than a frame at 60Hz are long enough to show up as a stutter.
+        static constexpr uint64_t DefaultLongHoldMicroseconds = 16000;
+
+        struct CallSite
+        {
+            std::atomic<const void*> address{ nullptr };
+            std::atomic<uint64_t> acquisitions{ 0 };
+            std::atomic<uint64_t> contended{ 0 };
+            Histogram wait;
+            Histogram hold;
+        };
+
+        // What a lock has done while it was measured, over every place it was taken from.
+        struct Totals
+        {
+            uint64_t acquisitions = 0;
+            uint64_t contended = 0;
+            uint64_t longHolds = 0;
+            double waitMilliseconds = 0;
+            double holdMilliseconds = 0;
+        };
+
+        static LockProfiler& Instance();
+
+        static LONGLONG s_Now() noexcept;
+
+        bool IsEnabled() const noexcept;
+        void SetEnabled(const bool enabled) noexcept;
+        void SetLongHoldThreshold(const uint64_t microseconds) noexcept;
+
+        void RecordAcquire(const Lock lock, const void* const callSite, const LONGLONG waitTicks, const bool contended) noexcept;
+        void RecordRelease(const Lock lock, const void* const callSite, const LONGLONG holdTicks) noexcept;
+
+        Totals GetTotals(const Lock lock) const noexcept;
+        void Trace() const noexcept;
+
+    private:
+        LockProfiler();
+        ~LockProfiler();
+
+        struct LockEntry
+        {
+            std::array<CallSite, MaxCallSites> callSites;
+            std::atomic<uint64_t> acquisitions{ 0 };
+            std::atomic<uint64_t> contended{ 0 };
+            std::atomic<uint64_t> longHolds{ 0 };
+            std::atomic<uint64_t> waitTicks{ 0 };
+            std::atomic<uint64_t> holdTicks{ 0 };
+        };
+
+        static void NTAPI s_ProviderCallback(LPCGUID sourceId,
+                                             ULONG isEnabled,
+                                             UCHAR level,
+                                             ULONGLONG matchAnyKeyword,
+                                             ULONGLONG matchAllKeyword,
+                                             PEVENT_FILTER_DESCRIPTOR filterData,
+                                             PVOID callbackContext);
+
+        static const char* _GetLockName(const Lock lock) noexcept;
+        CallSite& _FindCallSite(LockEntry& entry, const void* const address) noexcept;
+        void _TraceLongHold(const Lock lock, const void* const callSite, const uint64_t holdMicroseconds) const noexcept;
+        uint64_t _ToMicroseconds(const LONGLONG ticks) const noexcept;
+
+        LONGLONG _llPerformanceFrequency;
+        std::atomic<uint64_t> _longHoldMicroseconds;
+        // how many have asked for the counters with SetEnabled, as opposed to a trace session
+        std::atomic<size_t> _enabledCount;
+        std::array<LockEntry, static_cast<size_t>(Lock::Count)> _locks;
+    };
+
+    // A std::shared_mutex that tells the LockProfiler how long it's waited for and held.
+    // It can stand in for one anywhere std::unique_lock and std::shared_lock are used,
+    // and counts those as taken from wherever called them. Callers that hand out locks
+    // to others can say where they were called from instead.
+    class ProfiledSharedMutex final
+    {
+    public:
+        explicit ProfiledSharedMutex(const LockProfiler::Lock lock) noexcept;
+
+        ProfiledSharedMutex(const ProfiledSharedMutex&) = delete;
+        ProfiledSharedMutex& operator=(const ProfiledSharedMutex&) = delete;
+
+        void lock();
+        void lock(const void* const callSite);
+        bool try_lock();
+        void unlock();
+
+        void lock_shared();
+        void lock_shared(const void* const callSite);
+        bool try_lock_shared();
+        void unlock_shared();
+
+    private:
+        std::shared_mutex _mutex;
+        const LockProfiler::Lock _lock;
+
+        // Where the lock is held exclusively from, and since when. Only the owner touches these.
+        // _acquired is 0 if the hold isn't being measured.
+        const void* _callSite;
+        LONGLONG _acquired;
+    };
+}
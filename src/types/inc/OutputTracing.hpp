@@ -0,0 +1,109 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- OutputTracing.hpp
+
+Abstract:
+- Traces output on its way to the screen, from the write that brought it in, through
+  the parser that consumed it, to the frame that painted it and its presentation.
+- Each write and each frame is an ETW activity. A frame's events name the oldest write
+  it's the first to show as their related activity, so WPA can line a frame up with the
+  output it paints and tell how long that output waited.
+- Nothing is measured while no trace session has the provider enabled.
+--*/
+
+#pragma once
+
+#include <windows.h>
+#include <winmeta.h>
+#include <TraceLoggingProvider.h>
+#include <telemetry\ProjectTelemetry.h>
+
+#include <array>
+#include <mutex>
+
+TRACELOGGING_DECLARE_PROVIDER(g_hConsoleOutputTraceProvider);
+
+namespace Microsoft::Console::Types
+{
+    class OutputTracing final
+    {
+    public:
+        static OutputTracing& Instance();
+
+        bool IsEnabled() const noexcept;
+
+        // Output written by a client, from when it arrives until it has been consumed.
+        // The parser's events on this thread are part of its activity while it's in scope.
+        class WriteActivity final
+        {
+        public:
+            explicit WriteActivity(const size_t cch) noexcept;
+            ~WriteActivity();
+
+            WriteActivity(const WriteActivity&) = delete;
+            WriteActivity& operator=(const WriteActivity&) = delete;
+
+        private:
+            bool _active;
+            GUID _id;
+            const GUID* _previous;
+            LONGLONG _start;
+            size_t _cch;
+        };
+
+        // One call into the parser, traced as part of the current write.
+        class ParseScope final
+        {
+        public:
+            explicit ParseScope(const size_t cch) noexcept;
+            ~ParseScope();
+
+            ParseScope(const ParseScope&) = delete;
+            ParseScope& operator=(const ParseScope&) = delete;
+
+        private:
+            bool _active;
+            LONGLONG _start;
+            size_t _cch;
+        };
+
+        // One frame of one render engine.
+        struct Frame
+        {
+            bool active = false;
+            GUID id{};
+            GUID relatedWrite{};
+            LONGLONG start = 0;
+        };
+
+        Frame BeginFrame(uint64_t& writesSeen) noexcept;
+        void TraceFramePainted(const Frame& frame, const size_t dirtyCells) const noexcept;
+        void EndFrame(const Frame& frame, const HRESULT hrPresent) const noexcept;
+
+    private:
+        OutputTracing();
+        ~OutputTracing();
+
+        struct PendingWrite
+        {
+            GUID id{};
+            LONGLONG start = 0;
+        };
+
+        // The last writes, for frames to find the oldest one they're the first to show.
+        static constexpr size_t PendingWriteCount = 64;
+
+        void _AddWrite(const GUID& id, const LONGLONG start) noexcept;
+        uint64_t _ToMicroseconds(const LONGLONG ticks) const noexcept;
+        static LONGLONG _Now() noexcept;
+
+        LONGLONG _llPerformanceFrequency;
+
+        std::mutex _writesLock;
+        std::array<PendingWrite, PendingWriteCount> _writes;
+        uint64_t _writeSequence;
+    };
+}
@@ -62,7 +62,7 @@ private:
     };
 
     HANDLE _outPipe; // non-owning reference to a pipe.
-    BYTE _buffer[4096]{ 0 }; // buffer for the chunk read
+    BYTE _buffer[65536]{ 0 }; // buffer for the chunk read
     BYTE _utf8Partials[4]{ 0 }; // buffer for code units of a partial UTF-8 code point that have to be cached
     DWORD _dwPartialsLen{}; // number of cached UTF-8 code units
 };
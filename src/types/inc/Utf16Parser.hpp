@@ -17,6 +17,8 @@ Author(s):
 #include <vector>
 #include <optional>
 #include <bitset>
+#include <iterator>
+#include <string_view>
 
 class Utf16Parser final
 {
@@ -27,6 +29,45 @@ private:
     static constexpr std::bitset<IndicatorBitCount> TrailingSurrogateMask = { 55 }; // 110 111 indicates a trailing surrogate
 
 public:
+    // Walks the glyphs of a utf16 encoded string in place, without copying them.
+    // Badly formatted leading/trailing char sequences are skipped, the same as Parse drops them.
+    class GlyphIterator final
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::wstring_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::wstring_view*;
+        using reference = const std::wstring_view&;
+
+        GlyphIterator() noexcept = default;
+        explicit GlyphIterator(const std::wstring_view wstr) noexcept;
+
+        reference operator*() const noexcept { return _glyph; }
+        pointer operator->() const noexcept { return &_glyph; }
+
+        GlyphIterator& operator++() noexcept;
+        GlyphIterator operator++(int) noexcept;
+
+        bool operator==(const GlyphIterator& other) const noexcept { return _glyph.data() == other._glyph.data(); }
+        bool operator!=(const GlyphIterator& other) const noexcept { return !(*this == other); }
+
+    private:
+        std::wstring_view _glyph;
+        std::wstring_view _remaining;
+    };
+
+    // The glyphs of a string, for use with range-based for.
+    struct GlyphRange final
+    {
+        std::wstring_view wstr;
+
+        GlyphIterator begin() const noexcept { return GlyphIterator{ wstr }; }
+        GlyphIterator end() const noexcept { return {}; }
+    };
+
+    static GlyphRange Glyphs(const std::wstring_view wstr) noexcept { return { wstr }; }
+
     static std::vector<std::vector<wchar_t>> Parse(std::wstring_view wstr);
     static std::wstring_view ParseNext(std::wstring_view wstr);
 
@@ -31,6 +31,11 @@ enum class CodepointWidth : BYTE
 [[nodiscard]] std::wstring ConvertToW(const UINT codepage,
                                       const std::string_view source);
 
+[[nodiscard]] HRESULT ConvertUtf8ToW(const std::string_view source,
+                                     const gsl::span<wchar_t> target,
+                                     const bool rejectInvalid,
+                                     _Out_ size_t& written) noexcept;
+
 [[nodiscard]] std::string ConvertToA(const UINT codepage,
                                      const std::wstring_view source);
 
@@ -147,6 +147,45 @@ namespace Microsoft::Console::Types
             return viewports.at(index);
         }
     };
+
+    // A set of cells made up of any number of rectangles, such as everything that changed in a frame.
+    // It's kept as rectangles that don't overlap, so walking them visits each cell once.
+    // The first few rectangles are stored in the region itself, so the common cases
+    // of one or a handful of separate changes don't allocate.
+    class Region final
+    {
+    public:
+        Region() noexcept = default;
+        Region(const Viewport& rect) noexcept;
+
+        bool empty() const noexcept { return _count == 0; }
+        size_t size() const noexcept { return _count; }
+        const Viewport* begin() const noexcept;
+        const Viewport* end() const noexcept;
+
+        [[nodiscard]] Viewport BoundingBox() const noexcept;
+        bool IsInBounds(const COORD& pos) const noexcept;
+
+        void Clear() noexcept;
+        void Union(const Viewport& rect);
+        void Union(const Region& other);
+        void Intersect(const Viewport& rect) noexcept;
+        void Subtract(const Viewport& rect);
+        void Subtract(const Region& other);
+
+    private:
+        static constexpr size_t InlineCapacity = 4;
+
+        // Holds the rectangles while there are no more than InlineCapacity of them. After that, _overflow holds them all.
+        std::array<Viewport, InlineCapacity> _inline{ Viewport::Empty(), Viewport::Empty(), Viewport::Empty(), Viewport::Empty() };
+        std::vector<Viewport> _overflow;
+        size_t _count{ 0 };
+
+        Viewport* _data() noexcept;
+        void _Append(const Viewport& rect);
+        void _AppendMerged(Viewport rect);
+        void _RemoveAt(const size_t index) noexcept;
+    };
 }
 
 inline COORD operator-(const COORD& a, const COORD& b) noexcept
@@ -0,0 +1,118 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "..\..\inc\consoletaeftemplates.hpp"
+
+#include "..\inc\LockProfiler.hpp"
+
+#include <thread>
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+using namespace Microsoft::Console::Types;
+
+class LockProfilerTests
+{
+    TEST_CLASS(LockProfilerTests);
+
+    TEST_METHOD(CountsContendedExclusiveHolds)
+    {
+        auto& profiler = LockProfiler::Instance();
+        profiler.SetEnabled(true);
+        auto disable = wil::scope_exit([&]() { profiler.SetEnabled(false); });
+
+        ProfiledSharedMutex mutex{ LockProfiler::Lock::Terminal };
+        const auto before = profiler.GetTotals(LockProfiler::Lock::Terminal);
+
+        Log::Comment(L"Hold the lock while another thread waits for it.");
+        std::unique_lock<ProfiledSharedMutex> held{ mutex };
+        std::atomic<bool> started{ false };
+        std::thread waiter{ [&]() {
+            started = true;
+            std::unique_lock<ProfiledSharedMutex> lock{ mutex };
+        } };
+        while (!started)
+        {
+            Sleep(1);
+        }
+        Sleep(20);
+        held.unlock();
+        waiter.join();
+
+        const auto after = profiler.GetTotals(LockProfiler::Lock::Terminal);
+        VERIFY_ARE_EQUAL(before.acquisitions + 2, after.acquisitions);
+        VERIFY_ARE_EQUAL(before.contended + 1, after.contended);
+        VERIFY_IS_GREATER_THAN(after.waitMilliseconds, before.waitMilliseconds);
+        VERIFY_IS_GREATER_THAN_OR_EQUAL(after.holdMilliseconds - before.holdMilliseconds, 10.0);
+    }
+
+    TEST_METHOD(SharedHoldsDontContendWithEachOther)
+    {
+        auto& profiler = LockProfiler::Instance();
+        profiler.SetEnabled(true);
+        auto disable = wil::scope_exit([&]() { profiler.SetEnabled(false); });
+
+        ProfiledSharedMutex mutex{ LockProfiler::Lock::Terminal };
+        const auto before = profiler.GetTotals(LockProfiler::Lock::Terminal);
+
+        std::shared_lock<ProfiledSharedMutex> held{ mutex };
+        std::thread reader{ [&]() {
+            std::shared_lock<ProfiledSharedMutex> lock{ mutex };
+        } };
+        reader.join();
+        held.unlock();
+
+        const auto after = profiler.GetTotals(LockProfiler::Lock::Terminal);
+        VERIFY_ARE_EQUAL(before.acquisitions + 2, after.acquisitions);
+        VERIFY_ARE_EQUAL(before.contended, after.contended);
+    }
+
+    TEST_METHOD(CountsHoldsOverTheThreshold)
+    {
+        auto& profiler = LockProfiler::Instance();
+        profiler.SetEnabled(true);
+        profiler.SetLongHoldThreshold(5000);
+        auto restore = wil::scope_exit([&]() {
+            profiler.SetLongHoldThreshold(LockProfiler::DefaultLongHoldMicroseconds);
+            profiler.SetEnabled(false);
+        });
+
+        ProfiledSharedMutex mutex{ LockProfiler::Lock::Console };
+        const auto before = profiler.GetTotals(LockProfiler::Lock::Console);
+
+        Log::Comment(L"A hold longer than the threshold is a long one.");
+        mutex.lock();
+        Sleep(20);
+        mutex.unlock();
+        VERIFY_ARE_EQUAL(before.longHolds + 1, profiler.GetTotals(LockProfiler::Lock::Console).longHolds);
+
+        Log::Comment(L"One that lets go right away isn't.");
+        mutex.lock();
+        mutex.unlock();
+        VERIFY_ARE_EQUAL(before.longHolds + 1, profiler.GetTotals(LockProfiler::Lock::Console).longHolds);
+    }
+
+    TEST_METHOD(NothingIsMeasuredWhileDisabled)
+    {
+        auto& profiler = LockProfiler::Instance();
+        if (profiler.IsEnabled())
+        {
+            Log::Result(TestResults::Skipped, L"A trace session has the lock provider enabled.");
+            return;
+        }
+
+        ProfiledSharedMutex mutex{ LockProfiler::Lock::Terminal };
+        const auto before = profiler.GetTotals(LockProfiler::Lock::Terminal);
+
+        mutex.lock();
+        mutex.unlock();
+        mutex.lock_shared();
+        mutex.unlock_shared();
+
+        VERIFY_ARE_EQUAL(before.acquisitions, profiler.GetTotals(LockProfiler::Lock::Terminal).acquisitions);
+    }
+};
@@ -25,8 +25,8 @@ class UTF8OutPipeReaderTests
         //   1    2    3    4
         // 0xF0 0x90 0x8D 0x88
         //
-        // For the test a std::string is filled with 4104 '.' characters to make sure it exceeds the
-        //  buffer size of 4096 bytes in UTF8OutPipeReader.
+        // For the test a std::string is filled with 65544 '.' characters to make sure it exceeds the
+        //  buffer size of 65536 bytes in UTF8OutPipeReader.
         //
         // This figure shows how the string is getting changed for the 7 sub-tests. The digits 1 to 4
         //  represent the four bytes of the 'Hwair' letter. The vertical bar represents the buffer boundary.
@@ -49,7 +49,7 @@ class UTF8OutPipeReaderTests
         //  sure it would be corrupted if we get UTF-8 partials.
         // The test is positive if both hstrings are equal.
 
-        const size_t bufferSize{ 4096 }; // NOTE: This has to match the buffer size in UTF8OutPipeReader!
+        const size_t bufferSize{ 65536 }; // NOTE: This has to match the buffer size in UTF8OutPipeReader!
         std::string utf8TestString(bufferSize + 8, '.'); // create a test string with the required size
 
         // Test 1:
@@ -1038,3 +1038,259 @@ bool Viewport::IsValid() const noexcept
 {
     return Height() > 0 && Width() > 0;
 }
+
+// Routine Description:
+// - Creates a region covering a single rectangle.
+// Arguments:
+// - rect - The rectangle. If it has no area, the region is empty.
+Region::Region(const Viewport& rect) noexcept
+{
+    if (rect.IsValid())
+    {
+        _inline.at(0) = rect;
+        _count = 1;
+    }
+}
+
+// Routine Description:
+// - Gets the first of the rectangles making up the region, in no particular order.
+const Viewport* Region::begin() const noexcept
+{
+    return _count > InlineCapacity ? _overflow.data() : _inline.data();
+}
+
+// Routine Description:
+// - Gets the end of the rectangles making up the region.
+const Viewport* Region::end() const noexcept
+{
+    return begin() + _count;
+}
+
+Viewport* Region::_data() noexcept
+{
+    return _count > InlineCapacity ? _overflow.data() : _inline.data();
+}
+
+// Routine Description:
+// - Gets the smallest rectangle that covers the whole region.
+// Return Value:
+// - The covering rectangle, or an empty viewport if the region is empty.
+[[nodiscard]] Viewport Region::BoundingBox() const noexcept
+{
+    auto result = Viewport::Empty();
+    for (const auto& rect : *this)
+    {
+        result = Viewport::Union(result, rect);
+    }
+    return result;
+}
+
+// Routine Description:
+// - Determines whether the given cell is part of the region.
+// Arguments:
+// - pos - The cell to check.
+// Return Value:
+// - True if one of the region's rectangles contains it.
+bool Region::IsInBounds(const COORD& pos) const noexcept
+{
+    return std::any_of(begin(), end(), [&](const Viewport& rect) { return rect.IsInBounds(pos); });
+}
+
+// Routine Description:
+// - Empties the region. Memory it had to allocate is kept for reuse.
+void Region::Clear() noexcept
+{
+    _overflow.clear();
+    _count = 0;
+}
+
+// Routine Description:
+// - Adds a rectangle to the region.
+// - Rectangles already in the region that it covers are dropped, and only the parts of it
+//   that aren't covered yet are added. Parts that line up with a neighbor along a whole edge
+//   are merged into it, so repeatedly adding adjacent cells doesn't splinter the region.
+// Arguments:
+// - rect - The rectangle to add. Nothing happens if it has no area.
+void Region::Union(const Viewport& rect)
+{
+    if (!rect.IsValid())
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < _count;)
+    {
+        if (rect.IsInBounds(_data()[i]))
+        {
+            _RemoveAt(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    Region pieces{ rect };
+    for (const auto& existing : *this)
+    {
+        pieces.Subtract(existing);
+        if (pieces.empty())
+        {
+            return;
+        }
+    }
+
+    for (const auto& piece : pieces)
+    {
+        _AppendMerged(piece);
+    }
+}
+
+// Routine Description:
+// - Adds all of another region to this one.
+// Arguments:
+// - other - The region to add.
+void Region::Union(const Region& other)
+{
+    for (const auto& rect : other)
+    {
+        Union(rect);
+    }
+}
+
+// Routine Description:
+// - Trims the region down to the part that lies within the given rectangle.
+// Arguments:
+// - rect - The rectangle to keep.
+void Region::Intersect(const Viewport& rect) noexcept
+{
+    for (size_t i = 0; i < _count;)
+    {
+        const auto clipped = Viewport::Intersect(_data()[i], rect);
+        if (clipped.IsValid())
+        {
+            _data()[i] = clipped;
+            ++i;
+        }
+        else
+        {
+            _RemoveAt(i);
+        }
+    }
+}
+
+// Routine Description:
+// - Takes a rectangle out of the region. Each rectangle it overlaps is split into the
+//   up to four pieces left around the overlap.
+// Arguments:
+// - rect - The rectangle to remove.
+void Region::Subtract(const Viewport& rect)
+{
+    if (!rect.IsValid())
+    {
+        return;
+    }
+
+    Region result;
+    for (const auto& existing : *this)
+    {
+        const auto remaining = Viewport::Subtract(existing, rect);
+        for (size_t i = 0; i < remaining.size(); ++i)
+        {
+            if (remaining.at(i).IsValid())
+            {
+                result._Append(remaining.at(i));
+            }
+        }
+    }
+    *this = std::move(result);
+}
+
+// Routine Description:
+// - Takes all of another region out of this one.
+// Arguments:
+// - other - The region to remove.
+void Region::Subtract(const Region& other)
+{
+    for (const auto& rect : other)
+    {
+        Subtract(rect);
+        if (empty())
+        {
+            return;
+        }
+    }
+}
+
+// Routine Description:
+// - Adds a rectangle that doesn't overlap any in the region, moving everything
+//   to the heap once there are more than fit inline.
+// Arguments:
+// - rect - The rectangle to add.
+void Region::_Append(const Viewport& rect)
+{
+    if (_count < InlineCapacity)
+    {
+        _inline.at(_count) = rect;
+    }
+    else
+    {
+        if (_count == InlineCapacity)
+        {
+            _overflow.assign(_inline.cbegin(), _inline.cend());
+        }
+        _overflow.push_back(rect);
+    }
+    ++_count;
+}
+
+// Routine Description:
+// - Adds a rectangle that doesn't overlap any in the region, first merging it with any
+//   rectangle it shares a whole edge with.
+// Arguments:
+// - rect - The rectangle to add.
+void Region::_AppendMerged(Viewport rect)
+{
+    for (size_t i = 0; i < _count;)
+    {
+        const auto& existing = _data()[i];
+        const bool sameRows = existing.Top() == rect.Top() && existing.BottomInclusive() == rect.BottomInclusive();
+        const bool sameColumns = existing.Left() == rect.Left() && existing.RightInclusive() == rect.RightInclusive();
+        const bool besideEachOther = existing.RightExclusive() == rect.Left() || rect.RightExclusive() == existing.Left();
+        const bool aboveEachOther = existing.BottomExclusive() == rect.Top() || rect.BottomExclusive() == existing.Top();
+        if ((sameRows && besideEachOther) || (sameColumns && aboveEachOther))
+        {
+            // The merged rectangle might line up with another one now, so start over.
+            rect = Viewport::Union(existing, rect);
+            _RemoveAt(i);
+            i = 0;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    _Append(rect);
+}
+
+// Routine Description:
+// - Removes a rectangle from the region by moving the last one into its place.
+//   Once few enough are left, they move back inline.
+// Arguments:
+// - index - The rectangle to remove.
+void Region::_RemoveAt(const size_t index) noexcept
+{
+    auto data = _data();
+    data[index] = data[_count - 1];
+    --_count;
+
+    if (_count == InlineCapacity)
+    {
+        std::copy_n(_overflow.cbegin(), InlineCapacity, _inline.begin());
+        _overflow.clear();
+    }
+    else if (_count > InlineCapacity)
+    {
+        _overflow.pop_back();
+    }
+}